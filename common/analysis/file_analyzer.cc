@@ -17,6 +17,9 @@
 #include "common/analysis/file_analyzer.h"
 
 #include <algorithm>
+#include <cstddef>
+#include <functional>
+#include <memory>
 #include <sstream>  // IWYU pragma: keep  // for ostringstream
 #include <string>
 #include <vector>
@@ -28,10 +31,14 @@
 #include "common/parser/parse.h"
 #include "common/strings/line_column_map.h"
 #include "common/text/concrete_syntax_tree.h"
+#include "common/text/syntax_tree_arena.h"
+#include "common/text/syntax_tree_binary.h"
 #include "common/text/text_structure.h"
 #include "common/text/token_info.h"
 #include "common/text/token_stream_view.h"
+#include "common/util/memory_stats.h"
 #include "common/util/spacer.h"
+#include "common/util/status_macros.h"
 
 namespace verible {
 
@@ -71,20 +78,38 @@ std::ostream& operator<<(std::ostream& stream, const RejectedToken& r) {
 
 // Grab tokens until EOF, and initialize a stream view with all tokens.
 absl::Status FileAnalyzer::Tokenize(Lexer* lexer) {
-  const auto buffer = Data().Contents();
-  TokenSequence& tokens = MutableData().MutableTokenStream();
+  RETURN_IF_ERROR(MakeTokenSequence(lexer, Data().Contents(),
+                                    &MutableData().MutableTokenStream(),
+                                    LexErrorHandler()));
+  FinishTokenize();
+  return absl::OkStatus();
+}
+
+absl::Status FileAnalyzer::Tokenize(
+    const std::function<std::unique_ptr<Lexer>()>& make_lexer,
+    size_t min_part_size, int threads) {
+  RETURN_IF_ERROR(MakeTokenSequenceInParallel(
+      make_lexer, Data().Contents(), min_part_size, threads,
+      &MutableData().MutableTokenStream(), LexErrorHandler()));
+  FinishTokenize();
+  return absl::OkStatus();
+}
+
+std::function<void(const TokenInfo&)> FileAnalyzer::LexErrorHandler() {
+  return [this](const TokenInfo& error_token) {
+    VLOG(1) << "Lexical error with token: " << error_token;
+    // Save error details in rejected_tokens_.
+    rejected_tokens_.push_back(RejectedToken{error_token,
+                                             AnalysisPhase::kLexPhase,
+                                             "" /* no detailed explanation */});
+  };
+}
 
-  if (auto lex_status = MakeTokenSequence(
-          lexer, buffer, &tokens,
-          [&](const TokenInfo& error_token) {
-            VLOG(1) << "Lexical error with token: " << error_token;
-            // Save error details in rejected_tokens_.
-            rejected_tokens_.push_back(
-                RejectedToken{error_token, AnalysisPhase::kLexPhase,
-                              "" /* no detailed explanation */});
-          });
-      !lex_status.ok()) {
-    return lex_status;
+void FileAnalyzer::FinishTokenize() {
+  TokenSequence& tokens = MutableData().MutableTokenStream();
+  if (SubsystemMemory().Enabled()) {
+    SubsystemMemory().Allocate("lexer tokens",
+                               tokens.capacity() * sizeof(TokenInfo));
   }
 
   // Partition token stream into line-by-line slices.
@@ -92,12 +117,18 @@ absl::Status FileAnalyzer::Tokenize(Lexer* lexer) {
 
   // Initialize filtered view of token stream.
   InitTokenStreamView(tokens, &MutableData().MutableTokenStreamView());
-  return absl::OkStatus();
 }
 
 // Runs the parser on the current TokenStreamView.
 absl::Status FileAnalyzer::Parse(Parser* parser) {
-  absl::Status status = parser->Parse();
+  // The syntax tree is allocated in bulk, and released with the text
+  // structure (unless parts of it are moved elsewhere).
+  absl::Status status;
+  {
+    const SyntaxTreeArena::Scope arena_scope(
+        &ABSL_DIE_IF_NULL(text_structure_)->syntax_tree_arena_);
+    status = parser->Parse();
+  }
   // Transfer syntax tree root, even if there were (recovered) syntax errors,
   // because the partial tree can still be useful to analyze.
   MutableData().MutableSyntaxTree() = parser->TakeRoot();
@@ -113,6 +144,20 @@ absl::Status FileAnalyzer::Parse(Parser* parser) {
   return status;
 }
 
+absl::Status FileAnalyzer::Restore(const SyntaxTreeBinaryView& view) {
+  const SyntaxTreeArena::Scope arena_scope(
+      &ABSL_DIE_IF_NULL(text_structure_)->syntax_tree_arena_);
+  return RestoreSyntaxTreeBinary(view, &MutableData());
+}
+
+void FileAnalyzer::CompactSyntaxTree() {
+  // The compact tree is allocated in the same arena as the original one, and
+  // the blocks of the original are released as it is destroyed.
+  const SyntaxTreeArena::Scope arena_scope(
+      &ABSL_DIE_IF_NULL(text_structure_)->syntax_tree_arena_);
+  MutableData().CompactSyntaxTree();
+}
+
 // Reports human-readable token error.
 std::string FileAnalyzer::TokenErrorMessage(
     const TokenInfo& error_token) const {
@@ -140,12 +185,14 @@ std::vector<std::string> FileAnalyzer::TokenErrorMessages() const {
 void FileAnalyzer::ExtractLinterTokenErrorDetail(
     const RejectedToken& error_token,
     const ReportLinterErrorFunction& error_report) const {
-  const LineColumnRange range = Data().GetRangeForToken(error_token.token_info);
+  LineColumnRange range = Data().GetRangeForToken(error_token.token_info);
   absl::string_view context_line = "";
   const auto& lines = Data().Lines();
   if (range.start.line < static_cast<int>(lines.size())) {
     context_line = lines[range.start.line];
   }
+  range.start.line += line_offset_;
+  range.end.line += line_offset_;
   // TODO(b/63893567): Explain syntax errors by inspecting state stack.
   error_report(
       filename_, range, error_token.severity, error_token.phase,
@@ -39,14 +39,17 @@
 #ifndef VERIBLE_COMMON_ANALYSIS_FILE_ANALYZER_H_
 #define VERIBLE_COMMON_ANALYSIS_FILE_ANALYZER_H_
 
+#include <cstddef>
 #include <functional>
 #include <iosfwd>
+#include <memory>
 #include <string>
 #include <vector>
 
 #include "absl/status/status.h"
 #include "common/lexer/lexer.h"
 #include "common/parser/parse.h"
+#include "common/text/syntax_tree_binary.h"
 #include "common/text/text_structure.h"
 #include "common/text/token_info.h"
 #include "common/util/logging.h"
@@ -102,9 +105,23 @@ class FileAnalyzer {
   // Break file contents (string) into tokens.
   absl::Status Tokenize(Lexer* lexer);
 
+  // Like Tokenize(Lexer*), with lexers of 'make_lexer' on up to 'threads'
+  // threads, see MakeTokenSequenceInParallel().
+  absl::Status Tokenize(
+      const std::function<std::unique_ptr<Lexer>()>& make_lexer,
+      size_t min_part_size, int threads);
+
   // Construct ConcreteSyntaxTree from TokenStreamView.
   absl::Status Parse(Parser* parser);
 
+  // Rebuilds the syntax tree with leaves that refer to the token stream,
+  // see TextStructureView::CompactSyntaxTree().
+  void CompactSyntaxTree();
+
+  // Takes tokens and syntax tree from a binary export of the same text,
+  // instead of calling Tokenize() and Parse(), see RestoreSyntaxTreeBinary().
+  absl::Status Restore(const SyntaxTreeBinaryView& view);
+
   // Diagnostic message for one rejected token.
   std::string TokenErrorMessage(const TokenInfo&) const;
 
@@ -150,6 +167,11 @@ class FileAnalyzer {
     return rejected_tokens_;
   }
 
+  // When the analyzed text is an excerpt of a file, that starts at its line
+  // 'line_offset' (0-based), the lines of reported diagnostics are moved by
+  // that many lines.
+  void SetLineOffset(int line_offset) { line_offset_ = line_offset; }
+
   // Convenience methods to access text structure view.
   const ConcreteSyntaxTree& SyntaxTree() const {
     return ABSL_DIE_IF_NULL(text_structure_)->SyntaxTree();
@@ -176,6 +198,16 @@ class FileAnalyzer {
 
   // Locations of syntax-rejected tokens.
   std::vector<RejectedToken> rejected_tokens_;
+
+  // Line of the file at which the analyzed text starts.
+  int line_offset_ = 0;
+
+ private:
+  // Records lexical errors in rejected_tokens_.
+  std::function<void(const TokenInfo&)> LexErrorHandler();
+
+  // Indexes lines of the token stream after Tokenize(), and filters it.
+  void FinishTokenize();
 };
 
 }  // namespace verible
@@ -128,6 +128,23 @@ TEST(FileAnalyzerTest, TokenErrorMessageSameLineWithContext) {
   }
 }
 
+// Verify that diagnostics of an excerpt are reported at lines of its file.
+TEST(FileAnalyzerTest, TokenErrorMessageWithLineOffset) {
+  const std::string text("hello, world\nbye w0rld\n");
+  FakeFileAnalyzer analyzer(text, "hello.txt");
+  analyzer.SetLineOffset(40);
+  const TokenInfo error_token(1, analyzer.Data().Contents().substr(17, 5));
+  constexpr bool with_diagnostic_context = true;
+  const auto message = analyzer.LinterTokenErrorMessage(
+      {error_token, AnalysisPhase::kParsePhase}, with_diagnostic_context);
+  EXPECT_TRUE(
+      absl::StrContains(message,
+                        "hello.txt:42:5-9: syntax error at token \"w0rld\"\n"
+                        "bye w0rld\n"
+                        "    ^"))
+      << message;
+}
+
 // Verify that an error token on one character is reported correctly.
 TEST(FileAnalyzerTest, TokenErrorMessageOneChar) {
   const std::string text("hello, world\nbye w0rld\n");
@@ -0,0 +1,35 @@
+// Copyright 2017-2023 The Verible Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "common/analysis/line_lint_rule.h"
+
+#include <cstddef>
+
+#include "absl/strings/ascii.h"
+#include "absl/strings/string_view.h"
+#include "absl/strings/strip.h"
+
+namespace verible {
+
+LineScan::LineScan(absl::string_view line) : first_tab(line.find('\t')) {
+  absl::ConsumeSuffix(&line, "\r");
+  content_length = line.length();
+  // Only the trailing whitespace is read backwards, so with the search for
+  // tabs, each character is read about once.
+  size_t end = content_length;
+  while (end > 0 && absl::ascii_isspace(line[end - 1])) --end;
+  trailing_space_begin = end;
+}
+
+}  // namespace verible
@@ -26,6 +26,23 @@
 
 namespace verible {
 
+// What several line rules look for in a line, found once by the LineLinter
+// for all of them.
+struct LineScan {
+  // Scans "line", without its '\n'.
+  explicit LineScan(absl::string_view line);
+
+  // Offset of the first tab, or absl::string_view::npos.
+  size_t first_tab;
+
+  // Length of the line without the '\r' of a "\r\n" line ending.
+  size_t content_length;
+
+  // Offset of the whitespace at the end of the content, equal to
+  // content_length if there is none.
+  size_t trailing_space_begin;
+};
+
 class LineLintRule : public LintRule {
  public:
   ~LineLintRule() override = default;
@@ -33,6 +50,12 @@ class LineLintRule : public LintRule {
   // Scans a single line during analysis.
   virtual void HandleLine(absl::string_view line) = 0;
 
+  // Scans a single line, that the LineLinter has already scanned for what
+  // rules commonly look for.  Rules that look for that override this.
+  virtual void HandleScannedLine(absl::string_view line, const LineScan& scan) {
+    HandleLine(line);
+  }
+
   // Analyze the final state of the rule, after the last line has been read.
   virtual void Finalize() {}
 };
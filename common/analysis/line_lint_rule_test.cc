@@ -0,0 +1,67 @@
+// Copyright 2017-2023 The Verible Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "common/analysis/line_lint_rule.h"
+
+#include "absl/strings/string_view.h"
+#include "gtest/gtest.h"
+
+namespace verible {
+namespace {
+
+constexpr size_t npos = absl::string_view::npos;
+
+TEST(LineScanTest, Empty) {
+  const LineScan scan("");
+  EXPECT_EQ(scan.first_tab, npos);
+  EXPECT_EQ(scan.content_length, 0);
+  EXPECT_EQ(scan.trailing_space_begin, 0);
+}
+
+TEST(LineScanTest, NoTabsNorTrailingSpaces) {
+  const LineScan scan("  wire w;");
+  EXPECT_EQ(scan.first_tab, npos);
+  EXPECT_EQ(scan.content_length, 9);
+  EXPECT_EQ(scan.trailing_space_begin, 9);
+}
+
+TEST(LineScanTest, FirstTab) {
+  EXPECT_EQ(LineScan("a\tb\t").first_tab, 1);
+  EXPECT_EQ(LineScan("\t").first_tab, 0);
+}
+
+TEST(LineScanTest, TrailingSpaces) {
+  const LineScan scan("wire w; \t ");
+  EXPECT_EQ(scan.content_length, 10);
+  EXPECT_EQ(scan.trailing_space_begin, 7);
+  EXPECT_EQ(LineScan("   ").trailing_space_begin, 0);
+}
+
+TEST(LineScanTest, CarriageReturn) {
+  const LineScan dos_line("wire w;\r");
+  EXPECT_EQ(dos_line.content_length, 7);
+  EXPECT_EQ(dos_line.trailing_space_begin, 7);
+
+  const LineScan spaces("wire w;  \r");
+  EXPECT_EQ(spaces.content_length, 9);
+  EXPECT_EQ(spaces.trailing_space_begin, 7);
+
+  // Only the last '\r' belongs to the line ending.
+  const LineScan extra("wire w;\r\r");
+  EXPECT_EQ(extra.content_length, 8);
+  EXPECT_EQ(extra.trailing_space_begin, 7);
+}
+
+}  // namespace
+}  // namespace verible
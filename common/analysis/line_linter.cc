@@ -26,14 +26,20 @@ namespace verible {
 
 void LineLinter::Lint(const std::vector<absl::string_view>& lines) {
   VLOG(1) << "LineLinter analyzing lines with " << rules_.size() << " rules.";
+  profiles_.Start();
   for (const auto& line : lines) {
+    // Each line is scanned once, not by every rule.
+    const LineScan scan(line);
     for (const auto& rule : rules_) {
-      ABSL_DIE_IF_NULL(rule)->HandleLine(line);
+      const ScopedLintRuleCall call(profiles_.Of(rule.get()));
+      ABSL_DIE_IF_NULL(rule)->HandleScannedLine(line, scan);
     }
   }
   for (const auto& rule : rules_) {
+    const ScopedLintRuleCall call(profiles_.Of(rule.get()));
     rule->Finalize();
   }
+  profiles_.Finish(rules_);
 }
 
 std::vector<LintRuleStatus> LineLinter::ReportStatus() const {
@@ -25,6 +25,7 @@
 
 #include "absl/strings/string_view.h"
 #include "common/analysis/line_lint_rule.h"
+#include "common/analysis/lint_rule_profile.h"
 #include "common/analysis/lint_rule_status.h"
 
 namespace verible {
@@ -39,6 +40,9 @@ class LineLinter {
     rules_.emplace_back(std::move(rule));
   }
 
+  // Returns true if no rule was added.
+  bool empty() const { return rules_.empty(); }
+
   // Aggregates results of each held LintRule
   std::vector<LintRuleStatus> ReportStatus() const;
 
@@ -46,6 +50,9 @@ class LineLinter {
   // List of rules that the linter is using. Rules are responsible for tracking
   // their own internal state.
   std::vector<std::unique_ptr<LineLintRule>> rules_;
+
+  // Cost of the rules during a run, when profiling.
+  LintRuleCallProfiles profiles_;
 };
 
 }  // namespace verible
@@ -0,0 +1,101 @@
+// Copyright 2017-2023 The Verible Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "common/analysis/lint_rule_profile.h"
+
+#include <algorithm>
+#include <cstdlib>
+#include <iostream>
+#include <map>
+#include <mutex>
+#include <ostream>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "absl/strings/str_format.h"
+#include "absl/strings/string_view.h"
+#include "absl/time/time.h"
+#include "common/util/json_writer.h"
+
+namespace verible {
+
+void LintRuleProfiler::Add(absl::string_view rule_name,
+                           const LintRuleProfile& profile) {
+  const std::lock_guard<std::mutex> l(lock_);
+  profiles_[std::string(rule_name)] += profile;
+}
+
+std::map<std::string, LintRuleProfile> LintRuleProfiler::Profiles() const {
+  const std::lock_guard<std::mutex> l(lock_);
+  return profiles_;
+}
+
+// Returns the profiles, the most costly first.
+static std::vector<std::pair<std::string, LintRuleProfile>> ByCost(
+    std::map<std::string, LintRuleProfile> profiles) {
+  std::vector<std::pair<std::string, LintRuleProfile>> by_cost(
+      std::make_move_iterator(profiles.begin()),
+      std::make_move_iterator(profiles.end()));
+  std::stable_sort(by_cost.begin(), by_cost.end(),
+                   [](const auto& a, const auto& b) {
+                     return a.second.time > b.second.time;
+                   });
+  return by_cost;
+}
+
+void LintRuleProfiler::PrintTable(std::ostream* out) const {
+  *out << absl::StreamFormat("%-40s %12s %12s %10s\n", "rule", "time (ms)",
+                             "calls", "violations");
+  for (const auto& [name, profile] : ByCost(Profiles())) {
+    *out << absl::StreamFormat("%-40s %12.3f %12d %10d\n", name,
+                               absl::ToDoubleMilliseconds(profile.time),
+                               profile.calls, profile.violations);
+  }
+}
+
+void LintRuleProfiler::WriteJson(std::ostream* out) const {
+  JsonWriter writer(out);
+  writer.BeginArray();
+  for (const auto& [name, profile] : ByCost(Profiles())) {
+    writer.BeginObject()
+        .Key("rule")
+        .Value(name)
+        .Key("time_us")
+        .Value(absl::ToInt64Microseconds(profile.time))
+        .Key("calls")
+        .Value(profile.calls)
+        .Key("violations")
+        .Value(profile.violations)
+        .EndObject();
+  }
+  writer.EndArray();
+  *out << std::endl;
+}
+
+LintRuleProfiler& LintProfile() {
+  static LintRuleProfiler* const profiler = new LintRuleProfiler();
+  return *profiler;
+}
+
+void EnableLintRuleProfileOutput(bool json) {
+  LintProfile().Enable();
+  if (json) {
+    std::atexit([]() { LintProfile().WriteJson(&std::cerr); });
+  } else {
+    std::atexit([]() { LintProfile().PrintTable(&std::cerr); });
+  }
+}
+
+}  // namespace verible
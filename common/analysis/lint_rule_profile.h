@@ -0,0 +1,150 @@
+// Copyright 2017-2023 The Verible Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// Profiling of lint rules: the time each rule takes, how often the linters
+// call it, and how many violations it finds, summed over all files linted,
+// to tell which rules are worth their cost where.
+
+#ifndef VERIBLE_COMMON_ANALYSIS_LINT_RULE_PROFILE_H_
+#define VERIBLE_COMMON_ANALYSIS_LINT_RULE_PROFILE_H_
+
+#include <atomic>
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <ostream>
+#include <string>
+#include <vector>
+
+#include "absl/container/flat_hash_map.h"
+#include "absl/strings/string_view.h"
+#include "absl/time/clock.h"
+#include "absl/time/time.h"
+#include "common/analysis/lint_rule.h"
+
+namespace verible {
+
+// Cost of a lint rule, e.g. on one file, or summed over many.
+struct LintRuleProfile {
+  // Time spent in the calls to the rule.
+  absl::Duration time;
+  // Number of times a linter called the rule, e.g. once per token, line or
+  // syntax tree node that it handles, or once per file.
+  int64_t calls = 0;
+  // Number of violations found, before waivers.
+  int64_t violations = 0;
+
+  LintRuleProfile& operator+=(const LintRuleProfile& other) {
+    time += other.time;
+    calls += other.calls;
+    violations += other.violations;
+    return *this;
+  }
+};
+
+// Profiles of lint rules by rule name, summed over all linter runs.
+// Profiling is opt-in: nothing is measured until Enable() is called, and
+// disabled profiling costs a branch per call to a rule.  Thread-safe.
+class LintRuleProfiler {
+ public:
+  void Enable() { enabled_.store(true, std::memory_order_release); }
+  bool Enabled() const { return enabled_.load(std::memory_order_acquire); }
+
+  void Add(absl::string_view rule_name, const LintRuleProfile& profile);
+
+  // Copy of the profiles so far.
+  std::map<std::string, LintRuleProfile> Profiles() const;
+
+  // Prints a table of the profiles, the most costly rules first.
+  void PrintTable(std::ostream* out) const;
+
+  // Writes the profiles as a JSON array of objects, the most costly rules
+  // first, with times in microseconds.
+  void WriteJson(std::ostream* out) const;
+
+ private:
+  std::atomic<bool> enabled_{false};
+  mutable std::mutex lock_;
+  std::map<std::string, LintRuleProfile> profiles_;
+};
+
+// Profiles of the rules of all linters.  Tools enable it with
+// --profile_rules.
+LintRuleProfiler& LintProfile();
+
+// Enables LintProfile(), and prints it to stderr when the process exits, as
+// a table, or with 'json', as JSON, for --profile_rules.
+void EnableLintRuleProfileOutput(bool json);
+
+// Measures the calls of one linter to its rules, during one run, for
+// LintProfile().  Not thread-safe: each linter has its own.
+class LintRuleCallProfiles {
+ public:
+  // Starts measuring the calls of a run, if LintProfile() is enabled.
+  void Start() {
+    enabled_ = LintProfile().Enabled();
+    by_rule_.clear();
+  }
+
+  // Returns where to add the cost of a call to 'rule', or nullptr if not
+  // measuring.
+  LintRuleProfile* Of(const LintRule* rule) {
+    return enabled_ ? &by_rule_[rule] : nullptr;
+  }
+
+  // Adds the profiles of the run of 'rules', with the number of violations
+  // they report, to LintProfile().
+  template <typename Rule>
+  void Finish(const std::vector<std::unique_ptr<Rule>>& rules) {
+    if (!enabled_) return;
+    for (const auto& rule : rules) {
+      LintRuleProfile profile = by_rule_[rule.get()];
+      const LintRuleStatus status = rule->Report();
+      profile.violations = status.violations.size();
+      LintProfile().Add(status.lint_rule_name, profile);
+    }
+    enabled_ = false;
+  }
+
+ private:
+  bool enabled_ = false;
+  absl::flat_hash_map<const LintRule*, LintRuleProfile> by_rule_;
+};
+
+// Adds the time of its scope, as one call, to 'profile', unless nullptr.
+class ScopedLintRuleCall {
+ public:
+  explicit ScopedLintRuleCall(LintRuleProfile* profile)
+      : profile_(profile),
+        start_(profile != nullptr ? absl::Now() : absl::InfinitePast()) {}
+
+  ScopedLintRuleCall(const ScopedLintRuleCall&) = delete;
+  ScopedLintRuleCall& operator=(const ScopedLintRuleCall&) = delete;
+
+  ~ScopedLintRuleCall() {
+    if (profile_ != nullptr) {
+      profile_->time += absl::Now() - start_;
+      ++profile_->calls;
+    }
+  }
+
+ private:
+  LintRuleProfile* const profile_;
+  const absl::Time start_;
+};
+
+}  // namespace verible
+
+#endif  // VERIBLE_COMMON_ANALYSIS_LINT_RULE_PROFILE_H_
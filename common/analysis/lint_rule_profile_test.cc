@@ -0,0 +1,116 @@
+// Copyright 2017-2023 The Verible Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "common/analysis/lint_rule_profile.h"
+
+#include <memory>
+#include <set>
+#include <sstream>
+#include <vector>
+
+#include "absl/strings/string_view.h"
+#include "absl/time/time.h"
+#include "common/analysis/line_lint_rule.h"
+#include "common/analysis/line_linter.h"
+#include "common/analysis/lint_rule_status.h"
+#include "common/text/token_info.h"
+#include "gtest/gtest.h"
+
+namespace verible {
+namespace {
+
+TEST(LintRuleProfilerTest, SumsByRule) {
+  LintRuleProfiler profiler;
+  profiler.Add("a", {absl::Milliseconds(2), 3, 1});
+  profiler.Add("b", {absl::Milliseconds(5), 1, 0});
+  profiler.Add("a", {absl::Milliseconds(4), 2, 2});
+
+  const auto profiles = profiler.Profiles();
+  ASSERT_EQ(profiles.size(), 2);
+  EXPECT_EQ(profiles.at("a").time, absl::Milliseconds(6));
+  EXPECT_EQ(profiles.at("a").calls, 5);
+  EXPECT_EQ(profiles.at("a").violations, 3);
+  EXPECT_EQ(profiles.at("b").calls, 1);
+
+  std::ostringstream json;
+  profiler.WriteJson(&json);
+  EXPECT_EQ(json.str(), R"([
+  {
+    "rule": "a",
+    "time_us": 6000,
+    "calls": 5,
+    "violations": 3
+  },
+  {
+    "rule": "b",
+    "time_us": 5000,
+    "calls": 1,
+    "violations": 0
+  }
+]
+)");
+
+  std::ostringstream table;
+  profiler.PrintTable(&table);
+  // Header, then the most costly rule first.
+  const std::string text = table.str();
+  EXPECT_LT(text.find("rule"), text.find("a "));
+  EXPECT_LT(text.find("a "), text.find("b "));
+}
+
+// Finds lines that are empty.
+class BlankLineRule : public LineLintRule {
+ public:
+  void HandleLine(absl::string_view line) final {
+    if (line.empty()) {
+      violations_.insert(LintViolation(TokenInfo(0, line), "blank"));
+    }
+  }
+
+  LintRuleStatus Report() const final {
+    return LintRuleStatus(violations_, "blank-line", "");
+  }
+
+ private:
+  std::set<LintViolation> violations_;
+};
+
+TEST(LintRuleProfilerTest, ProfilesLinterRuns) {
+  constexpr absl::string_view text = "a\n\nb\n\n";
+  const std::vector<absl::string_view> lines = {
+      text.substr(0, 1), text.substr(2, 0), text.substr(3, 1),
+      text.substr(5, 0)};
+  {
+    // Nothing is measured before profiling is enabled.
+    LineLinter linter;
+    linter.AddRule(std::make_unique<BlankLineRule>());
+    linter.Lint(lines);
+    EXPECT_TRUE(LintProfile().Profiles().empty());
+  }
+  LintProfile().Enable();
+  for (int i = 0; i < 2; ++i) {
+    LineLinter linter;
+    linter.AddRule(std::make_unique<BlankLineRule>());
+    linter.Lint(lines);
+  }
+  const auto profiles = LintProfile().Profiles();
+  ASSERT_EQ(profiles.size(), 1);
+  const LintRuleProfile& profile = profiles.at("blank-line");
+  // Each line, and the finalization.
+  EXPECT_EQ(profile.calls, 2 * (4 + 1));
+  EXPECT_EQ(profile.violations, 2 * 2);
+}
+
+}  // namespace
+}  // namespace verible
@@ -15,6 +15,7 @@
 #include "common/analysis/lint_rule_status.h"
 
 #include <algorithm>
+#include <cstddef>
 #include <functional>
 #include <iostream>
 #include <iterator>
@@ -36,6 +37,7 @@ namespace verible {
 
 std::string AutoFix::Apply(absl::string_view base) const {
   std::string result;
+  result.reserve(base.size());
   auto prev_start = base.cbegin();
   for (const auto& edit : edits_) {
     CHECK_LE(base.cbegin(), edit.fragment.cbegin());
@@ -49,7 +51,8 @@ std::string AutoFix::Apply(absl::string_view base) const {
   }
   const absl::string_view text_after(prev_start,
                                      std::distance(prev_start, base.cend()));
-  return absl::StrCat(result, text_after);
+  absl::StrAppend(&result, text_after);
+  return result;
 }
 
 bool AutoFix::AddEdits(const std::set<ReplacementEdit>& new_edits) {
@@ -81,13 +84,74 @@ LintViolation::LintViolation(const Symbol& root, absl::string_view reason,
       context(context),
       autofixes(autofixes) {}
 
+std::vector<LintViolation> SortedByLocation(
+    std::vector<LintViolation> violations) {
+  // Rules mostly find violations in order, e.g. line by line.
+  if (!std::is_sorted(violations.begin(), violations.end())) {
+    // Stable, so that the first violation found at a location is kept.
+    std::stable_sort(violations.begin(), violations.end());
+  }
+  violations.erase(
+      std::unique(violations.begin(), violations.end(),
+                  [](const LintViolation& l, const LintViolation& r) {
+                    return l.token.text().data() == r.token.text().data();
+                  }),
+      violations.end());
+  return violations;
+}
+
+std::vector<LintViolationWithStatus> MergeSortedViolations(
+    const std::vector<LintRuleStatus>& statuses) {
+  // The next violation of a status.
+  struct Cursor {
+    const char* location;
+    size_t status;
+    size_t index;
+  };
+  // Orders the heap by location, then by status, with the first on top.
+  const auto later = [](const Cursor& l, const Cursor& r) {
+    if (l.location != r.location) return l.location > r.location;
+    return l.status > r.status;
+  };
+  std::vector<Cursor> heap;
+  size_t total_violations = 0;
+  for (size_t i = 0; i < statuses.size(); ++i) {
+    const std::vector<LintViolation>& violations = statuses[i].violations;
+    if (violations.empty()) continue;
+    heap.push_back({violations.front().token.text().data(), i, 0});
+    total_violations += violations.size();
+  }
+  std::make_heap(heap.begin(), heap.end(), later);
+
+  std::vector<LintViolationWithStatus> merged;
+  merged.reserve(total_violations);
+  while (!heap.empty()) {
+    std::pop_heap(heap.begin(), heap.end(), later);
+    Cursor& next = heap.back();
+    const LintRuleStatus& status = statuses[next.status];
+    if (merged.empty() ||
+        merged.back().violation->token.text().data() != next.location) {
+      merged.emplace_back(&status.violations[next.index], &status);
+    }
+    if (++next.index < status.violations.size()) {
+      next.location = status.violations[next.index].token.text().data();
+      std::push_heap(heap.begin(), heap.end(), later);
+    } else {
+      heap.pop_back();
+    }
+  }
+  return merged;
+}
+
 void LintStatusFormatter::FormatLintRuleStatus(std::ostream* stream,
                                                const LintRuleStatus& status,
                                                absl::string_view base,
                                                absl::string_view path) const {
+  // Violations are ordered by location.
+  LineColumnCursor cursor(line_column_map_);
   for (const auto& violation : status.violations) {
-    FormatViolation(stream, violation, base, path, status.url,
-                    status.lint_rule_name);
+    FormatViolationAt(stream, violation, GetRange(&cursor, violation, base),
+                      path, status.url, status.lint_rule_name);
     (*stream) << std::endl;
   }
 }
@@ -96,27 +160,20 @@ void LintStatusFormatter::FormatLintRuleStatuses(
     std::ostream* stream, const std::vector<LintRuleStatus>& statuses,
     absl::string_view base, absl::string_view path,
     const std::vector<absl::string_view>& lines) const {
-  std::set<LintViolationWithStatus> violations;
-
-  // TODO(fangism): rewrite as a linear time merge of pre-ordered sub-sequences
-  for (const auto& status : statuses) {
-    for (const auto& violation : status.violations) {
-      violations.insert(LintViolationWithStatus(&violation, &status));
-    }
-  }
-
-  for (auto violation : violations) {
-    FormatViolation(stream, *violation.violation, base, path,
-                    violation.status->url, violation.status->lint_rule_name);
+  // Violations are ordered by location.
+  LineColumnCursor cursor(line_column_map_);
+  for (const auto& violation : MergeSortedViolations(statuses)) {
+    const LineColumnRange range =
+        GetRange(&cursor, *violation.violation, base);
+    FormatViolationAt(stream, *violation.violation, range, path,
+                      violation.status->url, violation.status->lint_rule_name);
     if (!violation.violation->autofixes.empty()) {
       *stream << " (autofix available)";
     }
     *stream << std::endl;
-    auto cursor = line_column_map_.GetLineColAtOffset(
-        base, violation.violation->token.left(base));
-    if (cursor.line < static_cast<int>(lines.size())) {
-      *stream << lines[cursor.line] << std::endl;
-      *stream << verible::Spacer(cursor.column) << "^" << std::endl;
+    if (range.start.line < static_cast<int>(lines.size())) {
+      *stream << lines[range.start.line] << std::endl;
+      *stream << verible::Spacer(range.start.column) << "^" << std::endl;
     }
   }
 }
@@ -129,12 +186,26 @@ void LintStatusFormatter::FormatViolation(std::ostream* stream,
                                           absl::string_view path,
                                           absl::string_view url,
                                           absl::string_view rule_name) const {
+  LineColumnCursor cursor(line_column_map_);
+  FormatViolationAt(stream, violation, GetRange(&cursor, violation, base), path,
+                    url, rule_name);
+}
+
+LineColumnRange LintStatusFormatter::GetRange(LineColumnCursor* cursor,
+                                              const LintViolation& violation,
+                                              absl::string_view base) {
+  return {cursor->GetLineColAtOffset(base, violation.token.left(base)),
+          cursor->GetLineColAtOffset(base, violation.token.right(base))};
+}
+
+void LintStatusFormatter::FormatViolationAt(std::ostream* stream,
+                                            const LintViolation& violation,
+                                            const LineColumnRange& range,
+                                            absl::string_view path,
+                                            absl::string_view url,
+                                            absl::string_view rule_name) {
   // TODO(fangism): Use the context member to print which named construct or
   // design element the violation appears in (or full stack thereof).
-  const verible::LineColumnRange range{
-      line_column_map_.GetLineColAtOffset(base, violation.token.left(base)),
-      line_column_map_.GetLineColAtOffset(base, violation.token.right(base))};
-
   (*stream) << path << ':' << range << ' ' << violation.reason << ' ' << url
             << " [" << rule_name << ']';
 }
@@ -156,12 +227,9 @@ void LintStatusFormatter::FormatViolationWaiver(
 
 void LintRuleStatus::WaiveViolations(
     std::function<bool(const LintViolation&)>&& is_waived) {
-  std::set<LintViolation> filtered_violations;
-  std::remove_copy_if(
-      violations.begin(), violations.end(),
-      std::inserter(filtered_violations, filtered_violations.begin()),
-      is_waived);
-  violations.swap(filtered_violations);
+  violations.erase(
+      std::remove_if(violations.begin(), violations.end(), is_waived),
+      violations.end());
 }
 
 }  // namespace verible
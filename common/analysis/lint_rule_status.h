@@ -22,6 +22,7 @@
 #include <iosfwd>
 #include <set>
 #include <string>
+#include <utility>
 #include <vector>
 
 #include "absl/strings/string_view.h"
@@ -116,16 +117,16 @@ struct LintViolation {
   const Symbol* root = nullptr;
 
   // The token at which the error occurs, which includes location information.
-  const TokenInfo token;
+  TokenInfo token;
 
   // The reason why the violation occurs.
   std::string reason;
 
   // The context (list of ancestors) of the offending token.
   // For non-syntax-tree analyses, leave this blank.
-  const SyntaxTreeContext context;
+  SyntaxTreeContext context;
 
-  const std::vector<AutoFix> autofixes;
+  std::vector<AutoFix> autofixes;
 
   bool operator<(const LintViolation& r) const {
     // compares addresses of violations, which correspond to substring
@@ -134,13 +135,44 @@ struct LintViolation {
   }
 };
 
+// Violations found by a lint rule, in the order in which they were found.
+// Unlike a std::set, this does not allocate a node per violation: they are
+// sorted by location only once, when they are reported in a LintRuleStatus.
+class LintViolationList {
+ public:
+  void insert(LintViolation&& violation) {
+    violations_.push_back(std::move(violation));
+  }
+  void insert(const LintViolation& violation) {
+    violations_.push_back(violation);
+  }
+
+  bool empty() const { return violations_.empty(); }
+
+  const std::vector<LintViolation>& Violations() const { return violations_; }
+
+ private:
+  std::vector<LintViolation> violations_;
+};
+
+// Returns 'violations' ordered by location, keeping only the first one found
+// at each location, like insertion into a std::set<LintViolation> would.
+std::vector<LintViolation> SortedByLocation(
+    std::vector<LintViolation> violations);
+
 // LintRuleStatus represents the result of running a single lint rule.
 struct LintRuleStatus {
   LintRuleStatus() = default;
 
   LintRuleStatus(const std::set<LintViolation>& vs, absl::string_view rule_name,
                  const std::string& url)
-      : lint_rule_name(rule_name), url(url), violations(vs) {}
+      : lint_rule_name(rule_name), url(url), violations(vs.begin(), vs.end()) {}
+
+  LintRuleStatus(const LintViolationList& vs, absl::string_view rule_name,
+                 const std::string& url)
+      : lint_rule_name(rule_name),
+        url(url),
+        violations(SortedByLocation(vs.Violations())) {}
 
   // TODO(hzeller): the LintRuleDescriptor is in verilog/analysis namespace,
   // don't want to move that to common in first step. So making this a
@@ -150,9 +182,19 @@ struct LintRuleStatus {
                  const Descriptor& descriptor)
       : lint_rule_name(descriptor.name),
         url(GetStyleGuideCitation(descriptor.topic)),
-        violations(vs) {}
+        violations(vs.begin(), vs.end()) {}
 
-  explicit LintRuleStatus(const std::set<LintViolation>& vs) : violations(vs) {}
+  template <typename Descriptor>
+  LintRuleStatus(const LintViolationList& vs, const Descriptor& descriptor)
+      : lint_rule_name(descriptor.name),
+        url(GetStyleGuideCitation(descriptor.topic)),
+        violations(SortedByLocation(vs.Violations())) {}
+
+  explicit LintRuleStatus(const std::set<LintViolation>& vs)
+      : violations(vs.begin(), vs.end()) {}
+
+  explicit LintRuleStatus(const LintViolationList& vs)
+      : violations(SortedByLocation(vs.Violations())) {}
 
   bool isOk() const { return violations.empty(); }
 
@@ -166,8 +208,9 @@ struct LintRuleStatus {
   // Hold link to engdoc summary of violated rule
   std::string url;
 
-  // Contains all violations of the LintRule
-  std::set<LintViolation> violations;
+  // Contains all violations of the LintRule, ordered by location, at most one
+  // per location.
+  std::vector<LintViolation> violations;
 };
 
 struct LintViolationWithStatus {
@@ -183,6 +226,13 @@ struct LintViolationWithStatus {
   }
 };
 
+// Returns the violations of all 'statuses' ordered by location.  Of the
+// violations at the same location, only the one of the earliest status is
+// kept.  This is a k-way merge of the already sorted violations of each
+// status.
+std::vector<LintViolationWithStatus> MergeSortedViolations(
+    const std::vector<LintRuleStatus>& statuses);
+
 // LintStatusFormatter is a class for printing LintRuleStatus's and
 // LintViolations to an output stream
 // Usage:
@@ -240,6 +290,18 @@ class LintStatusFormatter {
                              absl::string_view rule_name) const;
 
  private:
+  // Returns the range of the violation's token, looked up with 'cursor'.
+  static LineColumnRange GetRange(LineColumnCursor* cursor,
+                                  const LintViolation& violation,
+                                  absl::string_view base);
+
+  // Formats and outputs violation on stream, located at 'range'.
+  static void FormatViolationAt(std::ostream* stream,
+                                const LintViolation& violation,
+                                const LineColumnRange& range,
+                                absl::string_view path, absl::string_view url,
+                                absl::string_view rule_name);
+
   // Translates byte offsets, which are supplied by LintViolations via
   // locations field, to line:column
   LineColumnMap line_column_map_;
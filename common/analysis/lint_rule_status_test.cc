@@ -18,6 +18,7 @@
 #include <string>
 #include <vector>
 
+#include "absl/strings/str_cat.h"
 #include "absl/strings/str_split.h"
 #include "absl/strings/string_view.h"
 #include "common/text/concrete_syntax_tree.h"
@@ -64,6 +65,49 @@ TEST(LintRuleStatusTest, WaiveViolations) {
   EXPECT_TRUE(status.isOk());
 }
 
+// Tests that violations found out of order are reported by location, once.
+TEST(LintRuleStatusTest, ConstructWithViolationList) {
+  constexpr absl::string_view kText = "abcdef";
+  LintViolationList violations;
+  EXPECT_TRUE(violations.empty());
+  violations.insert(LintViolation(TokenInfo(1, kText.substr(4, 2)), "second"));
+  violations.insert(LintViolation(TokenInfo(1, kText.substr(0, 2)), "first"));
+  violations.insert(LintViolation(TokenInfo(1, kText.substr(4, 1)), "again"));
+  EXPECT_FALSE(violations.empty());
+  const LintRuleStatus status(violations, "RULE_NAME", "http://example.com");
+  ASSERT_EQ(status.violations.size(), 2);
+  EXPECT_EQ(status.violations[0].reason, "first");
+  EXPECT_EQ(status.violations[1].reason, "second");
+}
+
+// Tests that the violations of several statuses are merged by location.
+TEST(MergeSortedViolationsTest, OrderedByLocation) {
+  constexpr absl::string_view kText = "abcdefgh";
+  std::vector<LintRuleStatus> statuses(3);
+  for (const int offset : {0, 3, 6}) {
+    statuses[0].violations.emplace_back(TokenInfo(1, kText.substr(offset, 1)),
+                                        "rule0");
+  }
+  for (const int offset : {1, 3, 7}) {
+    statuses[1].violations.emplace_back(TokenInfo(1, kText.substr(offset, 1)),
+                                        "rule1");
+  }
+  // statuses[2] has no violations.
+  const std::vector<LintViolationWithStatus> merged =
+      MergeSortedViolations(statuses);
+  std::vector<std::string> found;
+  for (const auto& violation : merged) {
+    EXPECT_EQ(violation.status, violation.violation->reason == "rule0"
+                                    ? &statuses[0]
+                                    : &statuses[1]);
+    found.push_back(absl::StrCat(violation.violation->token.text(), ":",
+                                 violation.violation->reason));
+  }
+  // Of the violations at the same location, the first status' is kept.
+  EXPECT_EQ(found, (std::vector<std::string>{"a:rule0", "b:rule1", "d:rule0",
+                                             "g:rule0", "h:rule1"}));
+}
+
 // Struct for checking expected formatting of a single Lint Violation
 // Note that the filename produced by formatter is provided by LintStatusTest,
 // which contains this struct.
@@ -92,7 +136,7 @@ void RunLintStatusTest(const LintStatusTest& test) {
   status.url = test.url;
   status.lint_rule_name = test.rule_name;
   for (const auto& violation_test : test.violations) {
-    status.violations.insert(
+    status.violations.push_back(
         LintViolation(violation_test.token, violation_test.reason));
   }
 
@@ -161,10 +205,10 @@ void RunLintStatusesTest(const LintStatusTest& test, bool show_context) {
   ASSERT_EQ(test.violations.size(), 2);
 
   // Insert the violations in the wrong order
-  status0.violations.insert(
+  status0.violations.push_back(
       LintViolation(test.violations[1].token, test.violations[1].reason));
 
-  status1.violations.insert(
+  status1.violations.push_back(
       LintViolation(test.violations[0].token, test.violations[0].reason));
 
   statuses.push_back(status0);
@@ -20,11 +20,16 @@
 #include <functional>
 #include <iterator>
 #include <map>
-#include <regex>  // NOLINT
+#include <memory>
 #include <set>
+#include <string>
 #include <utility>
 #include <vector>
 
+#include "absl/status/status.h"
+#include "absl/status/statusor.h"
+#include "absl/strings/numbers.h"
+#include "absl/strings/str_cat.h"
 #include "absl/strings/str_split.h"
 #include "absl/strings/string_view.h"
 #include "common/analysis/command_file_lexer.h"
@@ -37,9 +42,112 @@
 #include "common/util/file_util.h"
 #include "common/util/iterator_range.h"
 #include "common/util/logging.h"
+#include "re2/re2.h"
+#include "re2/set.h"
 
 namespace verible {
 
+static RE2::Options WaiverRegexOptions() {
+  RE2::Options options;
+  options.set_log_errors(false);
+  return options;
+}
+
+static re2::StringPiece ToStringPiece(absl::string_view s) {
+  return {s.data(), s.size()};
+}
+
+absl::StatusOr<int> RegexWaivers::Add(absl::string_view rule_name,
+                                      absl::string_view regex) {
+  auto found = regex_index_.find(regex);
+  if (found == regex_index_.end()) {
+    auto re = std::make_unique<RE2>(ToStringPiece(regex), WaiverRegexOptions());
+    if (!re->ok()) return absl::InvalidArgumentError(re->error());
+    found = regex_index_.emplace(std::string(regex), regexes_.size()).first;
+    regexes_.push_back(std::move(re));
+    waivers_by_regex_.emplace_back();
+  }
+  waivers_by_regex_[found->second].push_back(waivers_.size());
+  waivers_.push_back({rule_name, found->second});
+  return waivers_.size() - 1;
+}
+
+// Returns a set of all of 'regexes', or nullptr if it can't be compiled, in
+// which case each of them has to be matched on its own.
+static std::unique_ptr<RE2::Set> CompileRegexSet(
+    const std::vector<std::unique_ptr<RE2>>& regexes) {
+  RE2::Options options = WaiverRegexOptions();
+  // Waiver files can have thousands of expressions.
+  options.set_max_mem(int64_t{64} << 20);
+  auto regex_set = std::make_unique<RE2::Set>(options, RE2::UNANCHORED);
+  for (const auto& re : regexes) {
+    // Each expression compiled on its own, so it can be added to the set.
+    const int index = regex_set->Add(re->pattern(), nullptr);
+    CHECK_GE(index, 0) << re->pattern();
+  }
+  if (!regex_set->Compile()) return nullptr;  // Out of memory.
+  return regex_set;
+}
+
+// Returns the indices of the 'regexes' that match 'text' somewhere, in one
+// pass with their 'regex_set' if there is one, else one by one.
+static std::vector<int> MatchRegexSet(
+    const std::vector<std::unique_ptr<RE2>>& regexes,
+    const RE2::Set* regex_set, re2::StringPiece text) {
+  std::vector<int> matching;
+  RE2::Set::ErrorInfo error_info;
+  if (regex_set != nullptr &&
+      (regex_set->Match(text, &matching, &error_info) ||
+       error_info.kind == RE2::Set::kNoError)) {
+    return matching;
+  }
+  // The set ran out of memory.
+  matching.clear();
+  for (size_t i = 0; i < regexes.size(); ++i) {
+    if (RE2::PartialMatch(text, *regexes[i])) matching.push_back(i);
+  }
+  return matching;
+}
+
+void RegexWaivers::Compile() { regex_set_ = CompileRegexSet(regexes_); }
+
+void RegexWaivers::WaiveMatchingLines(absl::string_view contents,
+                                      const LineColumnMap& line_map,
+                                      const std::vector<bool>& enabled,
+                                      LintWaiver* waiver) const {
+  if (regexes_.empty()) return;
+  const re2::StringPiece text = ToStringPiece(contents);
+
+  // Find the expressions that match anywhere, in one pass.
+  const std::vector<int> matching =
+      MatchRegexSet(regexes_, regex_set_.get(), text);
+
+  std::vector<absl::string_view> rules;  // Re-use in loop.
+  for (const int regex : matching) {
+    rules.clear();
+    for (const int i : waivers_by_regex_[regex]) {
+      if (enabled.empty() || enabled[i]) rules.push_back(waivers_[i].rule_name);
+    }
+    if (rules.empty()) continue;
+
+    // Matches are found in order.
+    const RE2& re = *regexes_[regex];
+    LineColumnCursor cursor(line_map);
+    re2::StringPiece match;
+    size_t pos = 0;
+    while (pos <= text.size() &&
+           re.Match(text, pos, text.size(), RE2::UNANCHORED, &match, 1)) {
+      const size_t start = match.data() - text.data();
+      const int line = cursor.LineAtOffset(start);
+      for (const auto rule : rules) {
+        waiver->WaiveOneLine(rule, line);
+      }
+      // Continue after the match, or after an empty match.
+      pos = start + std::max<size_t>(match.size(), 1);
+    }
+  }
+}
+
 void LintWaiver::WaiveOneLine(absl::string_view rule_name, int line_number) {
   WaiveLineRange(rule_name, line_number, line_number + 1);
 }
@@ -50,28 +158,24 @@ void LintWaiver::WaiveLineRange(absl::string_view rule_name, int line_begin,
   line_set.Add({line_begin, line_end});
 }
 
-void LintWaiver::WaiveWithRegex(absl::string_view rule_name,
-                                const std::string& regex_str) {
-  RegexVector& regex_vector = waiver_re_map_[rule_name];
-  auto regex_iter = regex_cache_.find(regex_str);
-
-  if (regex_iter == regex_cache_.end()) {
-    regex_cache_[regex_str] = std::regex(regex_str);
-  }
+absl::Status LintWaiver::WaiveWithRegex(absl::string_view rule_name,
+                                        absl::string_view regex) {
+  return regex_waivers_.Add(rule_name, regex).status();
+}
 
-  regex_vector.push_back(&regex_cache_[regex_str]);
+void LintWaiver::WaiveWithRegexes(std::shared_ptr<const RegexWaivers> regexes,
+                                  std::vector<bool> enabled) {
+  shared_regex_waivers_.emplace_back(std::move(regexes), std::move(enabled));
 }
 
 void LintWaiver::RegexToLines(absl::string_view contents,
                               const LineColumnMap& line_map) {
-  for (const auto& rule : waiver_re_map_) {
-    for (const auto* re : rule.second) {
-      for (std::cregex_iterator i(contents.begin(), contents.end(), *re);
-           i != std::cregex_iterator(); i++) {
-        const std::cmatch& match = *i;
-        WaiveOneLine(rule.first, line_map.LineAtOffset(match.position()));
-      }
-    }
+  if (regex_waivers_.size() > 0) {
+    regex_waivers_.Compile();
+    regex_waivers_.WaiveMatchingLines(contents, line_map, {}, this);
+  }
+  for (const auto& shared : shared_regex_waivers_) {
+    shared.first->WaiveMatchingLines(contents, line_map, shared.second, this);
   }
 }
 
@@ -229,11 +333,12 @@ static absl::Status WaiveCommandError(LineColumn pos,
       WaiveCommandErrorFmt(pos, filename, msg, args...));
 }
 
-static absl::Status WaiveCommandHandler(
-    const TokenRange& tokens, absl::string_view waive_file,
-    absl::string_view waive_content, absl::string_view lintee_filename,
-    const LineColumnMap& line_map, LintWaiver* waiver,
+absl::Status ExternalLintWaivers::ParseWaiveCommand(
+    const TokenRange& tokens, absl::string_view waive_content,
+    const LineColumnMap& line_map,
     const std::set<absl::string_view>& active_rules) {
+  const absl::string_view waive_file = waiver_filename_;
+  Command command;
   absl::string_view rule;
 
   absl::string_view option;
@@ -241,11 +346,10 @@ static absl::Status WaiveCommandHandler(
 
   int line_start = -1;
   int line_end = -1;
-  std::string regex;
+  absl::string_view regex;
 
   bool can_use_regex = false;
   bool can_use_lineno = false;
-  bool location_match = true;
 
   LineColumn token_pos;
   LineColumn regex_token_pos = {};
@@ -323,7 +427,7 @@ static absl::Status WaiveCommandHandler(
         }
 
         if (option == "regex") {
-          regex = std::string(val);
+          regex = val;
           can_use_regex = true;
 
           // Save a copy to token pos in case the regex is invalid
@@ -332,15 +436,12 @@ static absl::Status WaiveCommandHandler(
         }
 
         if (option == "location") {
-          const std::string file_match_regex(val);
-          try {
-            const std::regex file_matcher(file_match_regex);
-            location_match =
-                std::regex_search(std::string(lintee_filename), file_matcher);
-          } catch (const std::regex_error& e) {
+          auto location_or = AddLocation(val);
+          if (!location_or.ok()) {
             return WaiveCommandError(token_pos, waive_file,
                                      "--location regex is invalid");
           }
+          command.location = *location_or;
           continue;
         }
 
@@ -348,48 +449,32 @@ static absl::Status WaiveCommandHandler(
                                  "Unsupported flag: ", option);
 
       case CommandFileLexer::ConfigToken::kNewline:
-        if (!location_match) return absl::OkStatus();
+        command.rule_name = rule;
+        command.pos = token_pos;
 
         // Check if everything required has been set
         if (rule.empty()) {
-          return WaiveCommandError(token_pos, waive_file,
-                                   "Insufficient waiver configuration");
-        }
-
-        if (can_use_regex && can_use_lineno) {
-          return WaiveCommandError(
+          command.error = WaiveCommandError(
+              token_pos, waive_file, "Insufficient waiver configuration");
+        } else if (can_use_regex && can_use_lineno) {
+          command.error = WaiveCommandError(
               token_pos, waive_file,
               "Regex and line flags are mutually exclusive");
-        }
-
-        if (can_use_regex) {
-          try {
-            waiver->WaiveWithRegex(rule, regex);
-          } catch (const std::regex_error& e) {
-            const char* reason = e.what();
-
-            return WaiveCommandError(regex_token_pos, waive_file,
-                                     "Invalid regex: ", reason);
-          }
-        }
-
-        if (can_use_lineno) {
-          waiver->WaiveLineRange(rule, line_start - 1, line_end);
-        }
-
-        if (!can_use_regex && !can_use_lineno) {
-          absl::StatusOr<std::string> content_or =
-              verible::file::GetContentAsString(lintee_filename);
-          if (!content_or.ok()) {
-            return WaiveCommandError(token_pos, waive_file,
-                                     content_or.status().ToString());
+        } else if (can_use_regex) {
+          auto index_or = regex_waivers_->Add(rule, regex);
+          if (index_or.ok()) {
+            command.regex_waiver = *index_or;
+          } else {
+            command.error =
+                WaiveCommandError(regex_token_pos, waive_file,
+                                  "Invalid regex: ", index_or.status().message());
           }
-
-          const size_t number_of_lines =
-              std::count(content_or->begin(), content_or->end(), '\n');
-          waiver->WaiveLineRange(rule, 1, number_of_lines);
+        } else if (can_use_lineno) {
+          command.line_begin = line_start - 1;
+          command.line_end = line_end;
         }
 
+        commands_.push_back(std::move(command));
         return absl::OkStatus();
       case CommandFileLexer::ConfigToken::kComment:
         /* Ignore comments */
@@ -402,33 +487,19 @@ static absl::Status WaiveCommandHandler(
   return absl::OkStatus();
 }
 
-using HandlerFun = std::function<absl::Status(
-    const TokenRange&, absl::string_view waive_file,
-    absl::string_view waive_content, absl::string_view lintee_filename,
-    const LineColumnMap&, LintWaiver*, const std::set<absl::string_view>&)>;
-static const std::map<absl::string_view, HandlerFun>& GetCommandHandlers() {
-  // allocated once, never freed
-  static const auto* handlers = new std::map<absl::string_view, HandlerFun>{
-      // Right now, we only have one handler
-      {"waive", WaiveCommandHandler},
-  };
-  return *handlers;
-}
-
-absl::Status LintWaiverBuilder::ApplyExternalWaivers(
+absl::Status ExternalLintWaivers::Parse(
     const std::set<absl::string_view>& active_rules,
-    absl::string_view lintee_filename, absl::string_view waiver_filename,
+    absl::string_view waiver_filename,
     absl::string_view waivers_config_content) {
   if (waivers_config_content.empty()) {
     return {absl::StatusCode::kInternal, "Broken waiver config handle"};
   }
+  waiver_filename_ = std::string(waiver_filename);
 
   CommandFileLexer lexer(waivers_config_content);
   const LineColumnMap line_map(waivers_config_content);
   LineColumn command_pos;
 
-  const auto& handlers = GetCommandHandlers();
-
   std::vector<TokenRange> commands = lexer.GetCommandsTokenRanges();
 
   bool all_commands_ok = true;
@@ -451,9 +522,8 @@ absl::Status LintWaiverBuilder::ApplyExternalWaivers(
       continue;
     }
 
-    // Check if command is supported
-    auto handler_iter = handlers.find(command[0].text());
-    if (handler_iter == handlers.end()) {
+    // Check if command is supported.  Right now, we only have one.
+    if (command[0].text() != "waive") {
       LOG(ERROR) << WaiveCommandErrorFmt(
           command_pos, waiver_filename,
           "Command not supported: ", command[0].text());
@@ -461,9 +531,8 @@ absl::Status LintWaiverBuilder::ApplyExternalWaivers(
       continue;
     }
 
-    auto status = handler_iter->second(command, waiver_filename,
-                                       waivers_config_content, lintee_filename,
-                                       line_map, &lint_waiver_, active_rules);
+    auto status = ParseWaiveCommand(command, waivers_config_content, line_map,
+                                    active_rules);
     if (!status.ok()) {
       // Mark the return value to be false, but continue parsing the config
       // file anyway
@@ -471,6 +540,75 @@ absl::Status LintWaiverBuilder::ApplyExternalWaivers(
       LOG(ERROR) << status.message();
     }
   }
+  regex_waivers_->Compile();
+  location_set_ = CompileRegexSet(locations_);
+
+  if (all_commands_ok) {
+    return absl::OkStatus();
+  }
+  return absl::InvalidArgumentError("Errors applying external waivers.");
+}
+
+absl::StatusOr<int> ExternalLintWaivers::AddLocation(
+    absl::string_view regex) {
+  auto found = location_index_.find(regex);
+  if (found != location_index_.end()) return found->second;
+  auto re = std::make_unique<RE2>(ToStringPiece(regex), WaiverRegexOptions());
+  if (!re->ok()) return absl::InvalidArgumentError(re->error());
+  location_index_.emplace(std::string(regex), locations_.size());
+  locations_.push_back(std::move(re));
+  return locations_.size() - 1;
+}
+
+std::vector<bool> ExternalLintWaivers::MatchLocations(
+    absl::string_view lintee_filename) const {
+  std::vector<bool> matches(locations_.size());
+  for (const int location : MatchRegexSet(locations_, location_set_.get(),
+                                          ToStringPiece(lintee_filename))) {
+    matches[location] = true;
+  }
+  return matches;
+}
+
+absl::Status ExternalLintWaivers::Apply(absl::string_view lintee_filename,
+                                        LintWaiver* waiver) const {
+  const std::vector<bool> location_matches = MatchLocations(lintee_filename);
+  std::vector<bool> enabled_regexes;
+  bool all_commands_ok = true;
+  for (const Command& command : commands_) {
+    if (command.location >= 0 && !location_matches[command.location]) {
+      continue;
+    }
+    if (!command.error.ok()) {
+      all_commands_ok = false;
+      LOG(ERROR) << command.error.message();
+      continue;
+    }
+
+    if (command.regex_waiver >= 0) {
+      enabled_regexes.resize(regex_waivers_->size());
+      enabled_regexes[command.regex_waiver] = true;
+    } else if (command.line_begin >= 0) {
+      waiver->WaiveLineRange(command.rule_name, command.line_begin,
+                             command.line_end);
+    } else {
+      absl::StatusOr<std::string> content_or =
+          verible::file::GetContentAsString(lintee_filename);
+      if (!content_or.ok()) {
+        all_commands_ok = false;
+        LOG(ERROR) << WaiveCommandErrorFmt(command.pos, waiver_filename_,
+                                           content_or.status().ToString());
+        continue;
+      }
+
+      const size_t number_of_lines =
+          std::count(content_or->begin(), content_or->end(), '\n');
+      waiver->WaiveLineRange(command.rule_name, 1, number_of_lines);
+    }
+  }
+  if (!enabled_regexes.empty()) {
+    waiver->WaiveWithRegexes(regex_waivers_, std::move(enabled_regexes));
+  }
 
   if (all_commands_ok) {
     return absl::OkStatus();
@@ -478,4 +616,15 @@ absl::Status LintWaiverBuilder::ApplyExternalWaivers(
   return absl::InvalidArgumentError("Errors applying external waivers.");
 }
 
+absl::Status LintWaiverBuilder::ApplyExternalWaivers(
+    const std::set<absl::string_view>& active_rules,
+    absl::string_view lintee_filename, absl::string_view waiver_filename,
+    absl::string_view waivers_config_content) {
+  ExternalLintWaivers waivers;
+  absl::Status status =
+      waivers.Parse(active_rules, waiver_filename, waivers_config_content);
+  status.Update(ApplyExternalWaivers(waivers, lintee_filename));
+  return status;
+}
+
 }  // namespace verible
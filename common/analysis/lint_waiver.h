@@ -16,25 +16,77 @@
 #define VERIBLE_COMMON_ANALYSIS_LINT_WAIVER_H_
 
 #include <cstddef>
+#include <functional>
 #include <map>
-#include <regex>  // NOLINT
+#include <memory>
 #include <set>
+#include <string>
+#include <utility>
 #include <vector>
 
+#include "absl/status/status.h"
+#include "absl/status/statusor.h"
 #include "absl/strings/string_view.h"
+#include "common/strings/line_column_map.h"
 #include "common/strings/position.h"
 #include "common/text/text_structure.h"
 #include "common/text/token_stream_view.h"
 #include "common/util/container_util.h"
 #include "common/util/interval_set.h"
+#include "re2/re2.h"
+#include "re2/set.h"
 
 namespace verible {
 
+class LintWaiver;
+
+// RegexWaivers holds waivers that apply to the lines on which matches of
+// regular expressions start.  All expressions are matched against a file in
+// a single pass, and only those that match at all are searched for their
+// individual matches.
+class RegexWaivers {
+ public:
+  RegexWaivers() = default;
+
+  // Adds a waiver of 'rule_name' for the lines matched by 'regex'.
+  // Returns the index of the new waiver, or an error if 'regex' is invalid.
+  absl::StatusOr<int> Add(absl::string_view rule_name, absl::string_view regex);
+
+  // Number of waivers added.
+  int size() const { return waivers_.size(); }
+
+  // Compiles all expressions added so far for WaiveMatchingLines().
+  void Compile();
+
+  // Waives the lines of 'contents' matched by the waivers for which 'enabled'
+  // is true (indexed by waiver index), or by all waivers if 'enabled' is
+  // empty.  Compile() must have been called after the last Add().
+  void WaiveMatchingLines(absl::string_view contents,
+                          const LineColumnMap& line_map,
+                          const std::vector<bool>& enabled,
+                          LintWaiver* waiver) const;
+
+ private:
+  struct Waiver {
+    absl::string_view rule_name;
+    int regex;  // index into regexes_
+  };
+
+  std::vector<Waiver> waivers_;
+
+  // Distinct expressions, their indices by pattern, and the waivers that
+  // use each.
+  std::vector<std::unique_ptr<RE2>> regexes_;
+  std::map<std::string, int, std::less<>> regex_index_;
+  std::vector<std::vector<int>> waivers_by_regex_;
+
+  // All of regexes_, to find those that match in one pass.
+  std::unique_ptr<RE2::Set> regex_set_;
+};
+
 // LintWaiver maintains a set of line ranges per lint rule that should be
 // exempt from each rule.
 class LintWaiver {
-  using RegexVector = std::vector<const std::regex*>;
-
  public:
   LintWaiver() = default;
 
@@ -56,7 +108,15 @@ class LintWaiver {
                       int line_end);
 
   // Adds a regular expression which will be used to apply a waiver.
-  void WaiveWithRegex(absl::string_view rule_name, const std::string& regex);
+  // Returns an error if 'regex' is invalid.
+  absl::Status WaiveWithRegex(absl::string_view rule_name,
+                              absl::string_view regex);
+
+  // Adds the waivers of the compiled 'regexes' for which 'enabled' is true,
+  // or all of them if 'enabled' is empty.  'regexes' can be shared by many
+  // LintWaivers.
+  void WaiveWithRegexes(std::shared_ptr<const RegexWaivers> regexes,
+                        std::vector<bool> enabled);
 
   // Converts the prepared regular expressions to line numbers and applies the
   // waivers.
@@ -83,11 +143,78 @@ class LintWaiver {
   // Keys in the maps below are the names of the waived rules. They can be
   // string_view because the static strings for each lint rule class exist,
   // and will outlive all LintWaiver objects. This applies to both waiver_map_
-  // and waiver_re_map_.
+  // and the regular expression waivers.
   std::map<absl::string_view, LineNumberSet> waiver_map_;
-  std::map<absl::string_view, RegexVector> waiver_re_map_;
 
-  std::map<std::string, std::regex> regex_cache_;
+  // Expressions added with WaiveWithRegex().
+  RegexWaivers regex_waivers_;
+
+  // Expressions added with WaiveWithRegexes(), with their enabled waivers.
+  std::vector<std::pair<std::shared_ptr<const RegexWaivers>, std::vector<bool>>>
+      shared_regex_waivers_;
+};
+
+// ExternalLintWaivers holds the commands of an external waiver file, parsed
+// once, so that they can be applied to any number of linted files.
+class ExternalLintWaivers {
+ public:
+  ExternalLintWaivers() = default;
+
+  // Parses the commands in 'waivers_config_content' of 'waiver_filename'.
+  // Rules must be in 'active_rules', whose elements need to outlive this
+  // object.  Invalid commands are logged and skipped; returns an error if there
+  // were any.
+  absl::Status Parse(const std::set<absl::string_view>& active_rules,
+                     absl::string_view waiver_filename,
+                     absl::string_view waivers_config_content);
+
+  // Applies to 'waiver' those waivers whose --location matches
+  // 'lintee_filename'.  Returns an error if any of them is invalid.
+  absl::Status Apply(absl::string_view lintee_filename,
+                     LintWaiver* waiver) const;
+
+ private:
+  struct Command {
+    absl::string_view rule_name;
+    // Index into locations_ of the files to which this applies, or -1 for all
+    // files.
+    int location = -1;
+    // Range [line_begin, line_end) of waived lines, if line_begin >= 0.
+    int line_begin = -1;
+    int line_end = -1;
+    // Index into regex_waivers_, if >= 0.
+    int regex_waiver = -1;
+    // Error reported only for files that match the location.
+    absl::Status error;
+    // End of the command, for error messages.
+    LineColumn pos;
+  };
+
+  // Parses one "waive" command.  Errors that don't depend on the location
+  // are returned, the others are kept in Command::error.
+  absl::Status ParseWaiveCommand(
+      const TokenRange& tokens, absl::string_view waivers_config_content,
+      const LineColumnMap& line_map,
+      const std::set<absl::string_view>& active_rules);
+
+  // Returns the index of the distinct --location 'regex', or an error if it
+  // is invalid.
+  absl::StatusOr<int> AddLocation(absl::string_view regex);
+
+  // Returns whether each of locations_ matches 'lintee_filename'.
+  std::vector<bool> MatchLocations(absl::string_view lintee_filename) const;
+
+  std::string waiver_filename_;
+  std::vector<Command> commands_;
+
+  // Distinct --location expressions, compiled once, and all of them in a set
+  // to match them against a linted file in one pass.
+  std::vector<std::unique_ptr<RE2>> locations_;
+  std::map<std::string, int, std::less<>> location_index_;
+  std::unique_ptr<RE2::Set> location_set_;
+
+  std::shared_ptr<RegexWaivers> regex_waivers_ =
+      std::make_shared<RegexWaivers>();
 };
 
 // LintWaiverBuilder is a language-agnostic helper class for constructing
@@ -143,6 +270,13 @@ class LintWaiverBuilder {
       absl::string_view lintee_filename, absl::string_view waiver_filename,
       absl::string_view waivers_config_content);
 
+  // Applies the waivers of an already parsed waiver file that match
+  // lintee_filename.
+  absl::Status ApplyExternalWaivers(const ExternalLintWaivers& waivers,
+                                    absl::string_view lintee_filename) {
+    return waivers.Apply(lintee_filename, &lint_waiver_);
+  }
+
   const LintWaiver& GetLintWaiver() const { return lint_waiver_; }
 
  protected:
@@ -15,6 +15,7 @@
 #include "common/analysis/lint_waiver.h"
 
 #include <cstddef>
+#include <set>
 #include <vector>
 
 #include "common/strings/line_column_map.h"
@@ -821,5 +822,85 @@ TEST_F(LintWaiverBuilderTest, RegexToLinesMultipleMatches) {
   EXPECT_TRUE(lint_waiver_.RuleIsWaivedOnLine("rule-1", 2));
 }
 
+TEST(RegexWaiversTest, MatchesAllExpressionsInOnePass) {
+  RegexWaivers regexes;
+  EXPECT_EQ(*regexes.Add("rule-1", "[0-9]"), 0);
+  EXPECT_EQ(*regexes.Add("rule-2", "def"), 1);
+  EXPECT_EQ(*regexes.Add("rule-3", "[0-9]"), 2);  // shares the expression
+  EXPECT_EQ(*regexes.Add("rule-4", "nowhere"), 3);
+  EXPECT_FALSE(regexes.Add("rule-5", "(").ok());
+  EXPECT_EQ(regexes.size(), 4);
+  regexes.Compile();
+
+  const absl::string_view file = "abc1\ndef\ng2hi\n";
+  const LineColumnMap line_map(file);
+  LintWaiver waiver;
+  regexes.WaiveMatchingLines(file, line_map, {true, true, false, true},
+                             &waiver);
+  EXPECT_TRUE(waiver.RuleIsWaivedOnLine("rule-1", 0));
+  EXPECT_FALSE(waiver.RuleIsWaivedOnLine("rule-1", 1));
+  EXPECT_TRUE(waiver.RuleIsWaivedOnLine("rule-1", 2));
+  EXPECT_FALSE(waiver.RuleIsWaivedOnLine("rule-2", 0));
+  EXPECT_TRUE(waiver.RuleIsWaivedOnLine("rule-2", 1));
+  EXPECT_FALSE(waiver.RuleIsWaivedOnLine("rule-3", 0));  // not enabled
+  EXPECT_EQ(waiver.LookupLineNumberSet("rule-4"), nullptr);
+}
+
+TEST(ExternalLintWaiversTest, ParsedOnceAppliedToManyFiles) {
+  const std::set<absl::string_view> active_rules{"rule-1", "rule-2"};
+  ExternalLintWaivers waivers;
+  EXPECT_OK(waivers.Parse(active_rules, "waive_file.config", R"(
+    waive --rule=rule-1 --line=2
+    waive --rule=rule-1 --regex="abc" --location="foo"
+    waive --rule=rule-2 --regex="ghi"
+    waive --rule=rule-2 --regex="(" --location="bar"
+)"));
+
+  const absl::string_view file = "abc\ndef\nghi\n";
+  const LineColumnMap line_map(file);
+
+  LintWaiver foo_waiver;
+  EXPECT_OK(waivers.Apply("foo.sv", &foo_waiver));
+  foo_waiver.RegexToLines(file, line_map);
+  EXPECT_TRUE(foo_waiver.RuleIsWaivedOnLine("rule-1", 0));
+  EXPECT_TRUE(foo_waiver.RuleIsWaivedOnLine("rule-1", 1));
+  EXPECT_FALSE(foo_waiver.RuleIsWaivedOnLine("rule-1", 2));
+  EXPECT_FALSE(foo_waiver.RuleIsWaivedOnLine("rule-2", 1));
+  EXPECT_TRUE(foo_waiver.RuleIsWaivedOnLine("rule-2", 2));
+
+  LintWaiver other_waiver;
+  EXPECT_OK(waivers.Apply("other.sv", &other_waiver));
+  other_waiver.RegexToLines(file, line_map);
+  EXPECT_FALSE(other_waiver.RuleIsWaivedOnLine("rule-1", 0));
+  EXPECT_TRUE(other_waiver.RuleIsWaivedOnLine("rule-1", 1));
+  EXPECT_TRUE(other_waiver.RuleIsWaivedOnLine("rule-2", 2));
+
+  // The invalid regex is only reported for the files it applies to.
+  LintWaiver bar_waiver;
+  EXPECT_NOK(waivers.Apply("bar.sv", &bar_waiver));
+}
+
+TEST(ExternalLintWaiversTest, LocationsSharedByCommands) {
+  const std::set<absl::string_view> active_rules{"rule-1", "rule-2"};
+  ExternalLintWaivers waivers;
+  EXPECT_NOK(waivers.Parse(active_rules, "waive_file.config", R"(
+    waive --rule=rule-1 --line=1 --location="_gen\.sv$"
+    waive --rule=rule-2 --line=2 --location="_gen\.sv$"
+    waive --rule=rule-2 --line=3 --location="^ip/"
+    waive --rule=rule-1 --line=4 --location="("
+)"));
+
+  LintWaiver gen_waiver;
+  EXPECT_OK(waivers.Apply("ip/a_gen.sv", &gen_waiver));
+  EXPECT_TRUE(gen_waiver.RuleIsWaivedOnLine("rule-1", 0));
+  EXPECT_TRUE(gen_waiver.RuleIsWaivedOnLine("rule-2", 1));
+  EXPECT_TRUE(gen_waiver.RuleIsWaivedOnLine("rule-2", 2));
+  EXPECT_FALSE(gen_waiver.RuleIsWaivedOnLine("rule-1", 3));  // invalid
+
+  LintWaiver other_waiver;
+  EXPECT_OK(waivers.Apply("rtl/a_gen.svh", &other_waiver));
+  EXPECT_TRUE(other_waiver.Empty());
+}
+
 }  // namespace
 }  // namespace verible
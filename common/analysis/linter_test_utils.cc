@@ -50,7 +50,7 @@ static int CompareViolation(const LintViolation& lhs, const TokenInfo& rhs) {
 
 // TODO(b/151371397): refactor this for re-use for multi-findings style tests.
 bool LintTestCase::ExactMatchFindings(
-    const std::set<LintViolation>& found_violations, absl::string_view base,
+    const std::vector<LintViolation>& found_violations, absl::string_view base,
     std::ostream* diffstream) const {
   // Due to the order in which violations are visited, we can assert that
   // the reported violations are thus ordered.
@@ -19,7 +19,7 @@
 #include <initializer_list>
 #include <iosfwd>
 #include <memory>
-#include <set>
+#include <vector>
 #include <sstream>
 
 #include "absl/status/status.h"
@@ -50,7 +50,7 @@ struct LintTestCase : public TokenInfoTestData {
   // Returns true if every element is an exact match to the expected set.
   // TODO(b/141875806): Take a symbol translator function to produce a
   // human-readable, language-specific enum name.
-  bool ExactMatchFindings(const std::set<LintViolation>& found_violations,
+  bool ExactMatchFindings(const std::vector<LintViolation>& found_violations,
                           absl::string_view base,
                           std::ostream* diffstream) const;
 };
@@ -0,0 +1,275 @@
+// Copyright 2017-2023 The Verible Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "common/analysis/matcher/compiled_matcher.h"
+
+#include <algorithm>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "common/analysis/matcher/bound_symbol_manager.h"
+#include "common/analysis/matcher/inner_match_handlers.h"
+#include "common/analysis/matcher/matcher.h"
+#include "common/text/concrete_syntax_tree.h"
+#include "common/text/symbol.h"
+#include "common/util/casts.h"
+#include "common/util/logging.h"
+
+namespace verible {
+namespace matcher {
+
+using InnerMatchFunction = bool (*)(const Symbol&, const std::vector<Matcher>&,
+                                    BoundSymbolManager*);
+
+CompiledMatcher::CompiledMatcher(const Matcher& matcher) : matcher_(matcher) {
+  Compile(matcher_);
+  matches_any_tag_ = !CollectTags(0, &root_tags_);
+  if (matches_any_tag_) {
+    root_tags_.clear();
+  } else {
+    for (auto iter = root_tags_.begin(); iter != root_tags_.end(); ++iter) {
+      root_tags_.erase(std::remove(iter + 1, root_tags_.end(), *iter),
+                       root_tags_.end());
+    }
+  }
+}
+
+int CompiledMatcher::Compile(const Matcher& matcher) {
+  const int index = program_.size();
+  program_.push_back({&matcher, InnerMatch::kCustom});
+
+  const auto* handler =
+      matcher.inner_match_handler_.target<InnerMatchFunction>();
+  InnerMatch inner_match = InnerMatch::kCustom;
+  if (handler != nullptr) {
+    if (*handler == InnerMatchAll) inner_match = InnerMatch::kAll;
+    if (*handler == InnerMatchAny) inner_match = InnerMatch::kAny;
+    if (*handler == InnerMatchEachOf) inner_match = InnerMatch::kEachOf;
+    if (*handler == InnerMatchUnless) {
+      CHECK_EQ(matcher.inner_matchers_.size(), 1);
+      inner_match = InnerMatch::kUnless;
+    }
+  }
+
+  // Custom handlers get the original inner matchers.
+  std::vector<int> children;
+  if (inner_match != InnerMatch::kCustom) {
+    for (const auto& inner : matcher.inner_matchers_) {
+      children.push_back(Compile(inner));
+    }
+  }
+
+  Instruction& instruction = program_[index];
+  instruction.inner_match = inner_match;
+  instruction.children_begin = children_.size();
+  children_.insert(children_.end(), children.begin(), children.end());
+  instruction.children_end = children_.size();
+  instruction.path_begin = paths_.size();
+  if (matcher.transformer_form_ == Matcher::TransformerForm::kPath) {
+    paths_.insert(paths_.end(), matcher.transformer_path_.begin(),
+                  matcher.transformer_path_.end());
+  }
+  instruction.path_end = paths_.size();
+  return index;
+}
+
+bool CompiledMatcher::CollectTags(int index,
+                                  std::vector<SymbolTag>* tags) const {
+  const Instruction& instruction = program_[index];
+  const Matcher& source = *instruction.source;
+  if (source.predicate_form_ == Matcher::PredicateForm::kTag) {
+    tags->push_back(source.predicate_tag_);
+    return true;
+  }
+  // Otherwise, only inner matchers on the symbol itself constrain its tag.
+  if (source.transformer_form_ != Matcher::TransformerForm::kIdentity) {
+    return false;
+  }
+  const int children_size =
+      instruction.children_end - instruction.children_begin;
+  switch (instruction.inner_match) {
+    case InnerMatch::kAll:
+      // All inner matchers need to match, so the tags of any will do.
+      for (int i = instruction.children_begin; i < instruction.children_end;
+           ++i) {
+        if (CollectTags(children_[i], tags)) return true;
+      }
+      return false;
+    case InnerMatch::kAny:
+    case InnerMatch::kEachOf:
+      // Some inner matcher needs to match.
+      if (children_size == 0) return false;
+      for (int i = instruction.children_begin; i < instruction.children_end;
+           ++i) {
+        if (!CollectTags(children_[i], tags)) return false;
+      }
+      return true;
+    default:
+      return false;
+  }
+}
+
+bool CompiledMatcher::MayMatchTag(SymbolTag tag) const {
+  return matches_any_tag_ ||
+         std::find(root_tags_.begin(), root_tags_.end(), tag) !=
+             root_tags_.end();
+}
+
+bool CompiledMatcher::Matches(const Symbol& symbol,
+                              BoundSymbolManager* manager) const {
+  if (!MayMatchTag(symbol.Tag())) return false;
+  MatchState state;
+  if (!Evaluate(0, symbol, &state)) return false;
+  if (manager != nullptr) {
+    for (const auto& binding : state.bindings) {
+      manager->BindSymbol(*binding.first, binding.second);
+    }
+  }
+  return true;
+}
+
+// Calls 'f' on the descendants of 'symbol' along [path, path_end), in the
+// order of GetAllDescendantsFromPath(), without collecting them.
+template <typename F>
+static void ForEachDescendantOnPath(const Symbol& symbol,
+                                    const SymbolTag* path,
+                                    const SymbolTag* path_end, F& f) {
+  if (path == path_end) return;
+  if (path + 1 == path_end) {
+    if (symbol.Tag() == *path) f(symbol);
+    return;
+  }
+  if (symbol.Kind() != SymbolKind::kNode || symbol.Tag() != *path) return;
+  const auto* node = down_cast<const SyntaxTreeNode*>(&symbol);
+  for (const auto& child : node->children()) {
+    if (child) ForEachDescendantOnPath(*child, path + 1, path_end, f);
+  }
+}
+
+bool CompiledMatcher::Evaluate(int index, const Symbol& symbol,
+                               MatchState* state) const {
+  const Instruction& instruction = program_[index];
+  const Matcher& source = *instruction.source;
+
+  switch (source.predicate_form_) {
+    case Matcher::PredicateForm::kAnySymbol:
+      break;
+    case Matcher::PredicateForm::kTag:
+      if (symbol.Tag() != source.predicate_tag_) return false;
+      break;
+    case Matcher::PredicateForm::kCustom:
+      if (!source.predicate_(symbol)) return false;
+      break;
+  }
+
+  // If any target matches, this is set to true.
+  bool any_target_matches = false;
+  switch (source.transformer_form_) {
+    case Matcher::TransformerForm::kIdentity:
+      return MatchTarget(instruction, symbol, state);
+    case Matcher::TransformerForm::kPath: {
+      if (symbol.Kind() != SymbolKind::kNode) return false;
+      auto match_target = [&](const Symbol& target) {
+        any_target_matches |= MatchTarget(instruction, target, state);
+      };
+      const SymbolTag* path = paths_.data() + instruction.path_begin;
+      const SymbolTag* path_end = paths_.data() + instruction.path_end;
+      const auto* node = down_cast<const SyntaxTreeNode*>(&symbol);
+      for (const auto& child : node->children()) {
+        if (child) {
+          ForEachDescendantOnPath(*child, path, path_end, match_target);
+        }
+      }
+      return any_target_matches;
+    }
+    case Matcher::TransformerForm::kCustom:
+      for (const Symbol* target : source.transformer_(symbol)) {
+        if (!target) continue;
+        any_target_matches |= MatchTarget(instruction, *target, state);
+      }
+      return any_target_matches;
+  }
+  return false;
+}
+
+bool CompiledMatcher::MatchTarget(const Instruction& instruction,
+                                  const Symbol& target,
+                                  MatchState* state) const {
+  // Failed inner matches are backtracked by dropping their bindings.
+  Bindings& bindings = state->bindings;
+  const size_t checkpoint = bindings.size();
+  const int* const children_begin =
+      children_.data() + instruction.children_begin;
+  const int* const children_end = children_.data() + instruction.children_end;
+
+  bool matched = false;
+  switch (instruction.inner_match) {
+    case InnerMatch::kAll:
+      matched = true;
+      for (const int* child = children_begin; child != children_end; ++child) {
+        if (!Evaluate(*child, target, state)) {
+          bindings.resize(checkpoint);
+          matched = false;
+          break;
+        }
+      }
+      break;
+    case InnerMatch::kAny:
+      for (const int* child = children_begin; child != children_end; ++child) {
+        if (Evaluate(*child, target, state)) {
+          matched = true;
+          break;
+        }
+        bindings.resize(checkpoint);
+      }
+      break;
+    case InnerMatch::kEachOf:
+      for (const int* child = children_begin; child != children_end; ++child) {
+        const size_t backup = bindings.size();
+        if (Evaluate(*child, target, state)) {
+          matched = true;
+        } else {
+          bindings.resize(backup);
+        }
+      }
+      break;
+    case InnerMatch::kUnless:
+      // Binds of the inner matcher are discarded.
+      matched = !Evaluate(*children_begin, target, state);
+      bindings.resize(checkpoint);
+      break;
+    case InnerMatch::kCustom: {
+      const Matcher& source = *instruction.source;
+      auto manager = std::make_unique<BoundSymbolManager>();
+      matched = source.inner_match_handler_(target, source.inner_matchers_,
+                                            manager.get());
+      if (matched) {
+        for (const auto& bound : manager->GetBoundMap()) {
+          bindings.emplace_back(&bound.first, bound.second);
+        }
+        state->custom_managers.push_back(std::move(manager));
+      }
+      break;
+    }
+  }
+
+  if (matched && instruction.source->bind_id_) {
+    bindings.emplace_back(&*instruction.source->bind_id_, &target);
+  }
+  return matched;
+}
+
+}  // namespace matcher
+}  // namespace verible
@@ -0,0 +1,121 @@
+// Copyright 2017-2023 The Verible Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef VERIBLE_COMMON_ANALYSIS_MATCHER_COMPILED_MATCHER_H_
+#define VERIBLE_COMMON_ANALYSIS_MATCHER_COMPILED_MATCHER_H_
+
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "absl/container/inlined_vector.h"
+#include "common/analysis/matcher/bound_symbol_manager.h"
+#include "common/analysis/matcher/matcher.h"
+#include "common/text/symbol.h"
+
+namespace verible {
+namespace matcher {
+
+// CompiledMatcher is a Matcher turned into a flat program, for matchers that
+// are tried on many symbols, like those of lint rules.
+//
+// Tag predicates, descent paths and the inner match handlers of AllOf(),
+// AnyOf(), EachOf() and Unless() are evaluated directly instead of through
+// std::function.  Bound symbols are kept on a stack that is only copied into
+// the BoundSymbolManager when the whole match succeeds, so a failing match
+// does not allocate (unless it binds more than a few symbols on the way).
+// Symbols whose tag can't match are rejected before evaluating anything.
+// Custom predicates, transformers and handlers still work, through their
+// std::function.
+//
+// Matches() has the same results and bindings as Matcher::Matches().
+//
+// Usage:
+//   static const CompiledMatcher& FooMatcher() {
+//     static const CompiledMatcher matcher(NodekFoo(...));
+//     return matcher;
+//   }
+//
+class CompiledMatcher {
+ public:
+  explicit CompiledMatcher(const Matcher& matcher);
+
+  // The program refers to parts of matcher_.
+  CompiledMatcher(const CompiledMatcher&) = delete;
+  CompiledMatcher& operator=(const CompiledMatcher&) = delete;
+
+  // Same as Matcher::Matches().
+  bool Matches(const Symbol& symbol, BoundSymbolManager* manager) const;
+
+  // Returns false if no symbol tagged 'tag' can match.
+  bool MayMatchTag(SymbolTag tag) const;
+
+  // Returns true if symbols of any tag may match.  Otherwise, only symbols
+  // with one of the distinct RootTags() can match.
+  bool MayMatchAnyTag() const { return matches_any_tag_; }
+  const std::vector<SymbolTag>& RootTags() const { return root_tags_; }
+
+ private:
+  enum class InnerMatch { kCustom, kAll, kAny, kEachOf, kUnless };
+
+  struct Instruction {
+    // Matcher this was compiled from, for bind id and custom functions.
+    const Matcher* source;
+    InnerMatch inner_match;
+    // Range of inner matchers' instructions in children_.
+    int children_begin = 0;
+    int children_end = 0;
+    // Range of the descent path in paths_.
+    int path_begin = 0;
+    int path_end = 0;
+  };
+
+  // Bound symbols, in order of binding, like BoundSymbolManager::BindSymbol()
+  // calls.
+  using Bindings =
+      absl::InlinedVector<std::pair<const std::string*, const Symbol*>, 8>;
+
+  struct MatchState {
+    Bindings bindings;
+    // Managers of custom inner match handlers, which own their bind ids.
+    std::vector<std::unique_ptr<BoundSymbolManager>> custom_managers;
+  };
+
+  // Appends 'matcher' and its inner matchers to the program, and returns the
+  // index of its instruction.
+  int Compile(const Matcher& matcher);
+
+  // Adds to 'tags' the tags that instruction can match on.  Returns false
+  // if it can match on any tag.
+  bool CollectTags(int instruction, std::vector<SymbolTag>* tags) const;
+
+  bool Evaluate(int instruction, const Symbol& symbol, MatchState* state) const;
+  bool MatchTarget(const Instruction& instruction, const Symbol& target,
+                   MatchState* state) const;
+
+  const Matcher matcher_;
+  std::vector<Instruction> program_;
+  std::vector<int> children_;
+  std::vector<SymbolTag> paths_;
+
+  // Tags that the root can match on, unless it can match on any tag.
+  bool matches_any_tag_ = true;
+  std::vector<SymbolTag> root_tags_;
+};
+
+}  // namespace matcher
+}  // namespace verible
+
+#endif  // VERIBLE_COMMON_ANALYSIS_MATCHER_COMPILED_MATCHER_H_
@@ -0,0 +1,126 @@
+// Copyright 2017-2023 The Verible Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "common/analysis/matcher/compiled_matcher.h"
+
+#include <vector>
+
+#include "common/analysis/matcher/bound_symbol_manager.h"
+#include "common/analysis/matcher/core_matchers.h"
+#include "common/analysis/matcher/inner_match_handlers.h"
+#include "common/analysis/matcher/matcher.h"
+#include "common/analysis/matcher/matcher_builders.h"
+#include "common/text/symbol.h"
+#include "common/text/tree_builder_test_util.h"
+#include "gtest/gtest.h"
+
+namespace verible {
+namespace matcher {
+namespace {
+
+constexpr TagMatchBuilder<SymbolKind::kNode, int, 1> Node1;
+constexpr TagMatchBuilder<SymbolKind::kNode, int, 2> Node2;
+constexpr TagMatchBuilder<SymbolKind::kLeaf, int, 1> Leaf1;
+
+constexpr auto PathNode1 = MakePathMatcher(NodeTag(1));
+constexpr auto PathNode1Leaf1 = MakePathMatcher(NodeTag(1), LeafTag(1));
+
+TEST(CompiledMatcherTest, MayMatchTag) {
+  EXPECT_TRUE(CompiledMatcher(Node1()).MayMatchTag(NodeTag(1)));
+  EXPECT_FALSE(CompiledMatcher(Node1()).MayMatchTag(NodeTag(2)));
+  EXPECT_FALSE(CompiledMatcher(Node1()).MayMatchTag(LeafTag(1)));
+
+  const CompiledMatcher any_of(AnyOf(Node1(), Leaf1()));
+  EXPECT_TRUE(any_of.MayMatchTag(NodeTag(1)));
+  EXPECT_TRUE(any_of.MayMatchTag(LeafTag(1)));
+  EXPECT_FALSE(any_of.MayMatchTag(NodeTag(2)));
+
+  EXPECT_FALSE(CompiledMatcher(AllOf(Node2(), Unless(Node1())))
+                   .MayMatchTag(NodeTag(1)));
+
+  // The root of a path can have any tag.
+  EXPECT_TRUE(CompiledMatcher(PathNode1()).MayMatchTag(NodeTag(7)));
+  EXPECT_TRUE(CompiledMatcher(Unless(Node1())).MayMatchTag(NodeTag(7)));
+}
+
+TEST(CompiledMatcherTest, BindsAllPathDescendants) {
+  const CompiledMatcher matcher(Node2(PathNode1Leaf1().Bind("leaf")));
+  const auto tree = TNode(2, TNode(1, XLeaf(2)), TNode(1, XLeaf(2), XLeaf(1)));
+  BoundSymbolManager manager;
+  EXPECT_TRUE(matcher.Matches(*tree, &manager));
+  const Symbol* leaf = manager.FindSymbol("leaf");
+  ASSERT_NE(leaf, nullptr);
+  EXPECT_EQ(leaf->Tag(), LeafTag(1));
+
+  const auto no_match = TNode(2, TNode(1, XLeaf(2)), TNode(3, XLeaf(1)));
+  manager.Clear();
+  EXPECT_FALSE(matcher.Matches(*no_match, &manager));
+  EXPECT_EQ(manager.Size(), 0);
+}
+
+TEST(CompiledMatcherTest, FailedInnerMatchesDropTheirBindings) {
+  const CompiledMatcher matcher(
+      Node2(AnyOf(AllOf(PathNode1().Bind("first"), Leaf1()),
+                  PathNode1().Bind("second"))));
+  const auto tree = TNode(2, TNode(1));
+  BoundSymbolManager manager;
+  EXPECT_TRUE(matcher.Matches(*tree, &manager));
+  EXPECT_FALSE(manager.ContainsSymbol("first"));
+  EXPECT_TRUE(manager.ContainsSymbol("second"));
+}
+
+TEST(CompiledMatcherTest, KeepsExistingBindings) {
+  const auto tree = TNode(1);
+  BoundSymbolManager manager;
+  manager.BindSymbol("old", tree.get());
+  EXPECT_FALSE(CompiledMatcher(Node2().Bind("new")).Matches(*tree, &manager));
+  EXPECT_TRUE(CompiledMatcher(Node1().Bind("new")).Matches(*tree, &manager));
+  EXPECT_EQ(manager.Size(), 2);
+}
+
+// Handler that matches if the symbol has as many children as inner matchers.
+bool InnerMatchChildCount(const Symbol& symbol,
+                          const std::vector<Matcher>& inner_matchers,
+                          BoundSymbolManager* manager) {
+  if (symbol.Kind() != SymbolKind::kNode) return false;
+  const auto& node = down_cast<const SyntaxTreeNode&>(symbol);
+  if (node.children().size() != inner_matchers.size()) return false;
+  for (size_t i = 0; i < inner_matchers.size(); ++i) {
+    if (!inner_matchers[i].Matches(*node.children()[i], manager)) return false;
+  }
+  return true;
+}
+
+TEST(CompiledMatcherTest, CustomFunctions) {
+  BindableMatcher children(
+      [](const Symbol& symbol) { return symbol.Tag().tag < 3; },
+      InnerMatchChildCount);
+  children.AddMatchers(Node1().Bind("child"), Leaf1());
+  const CompiledMatcher matcher(AllOf(children.Bind("parent")));
+
+  const auto tree = TNode(2, TNode(1), XLeaf(1));
+  BoundSymbolManager manager;
+  EXPECT_TRUE(matcher.Matches(*tree, &manager));
+  EXPECT_EQ(manager.FindSymbol("parent"), tree.get());
+  EXPECT_TRUE(manager.ContainsSymbol("child"));
+
+  manager.Clear();
+  EXPECT_FALSE(matcher.Matches(*TNode(3, TNode(1), XLeaf(1)), &manager));
+  EXPECT_FALSE(matcher.Matches(*TNode(2, TNode(1)), &manager));
+  EXPECT_EQ(manager.Size(), 0);
+}
+
+}  // namespace
+}  // namespace matcher
+}  // namespace verible
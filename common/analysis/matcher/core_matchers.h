@@ -56,6 +56,7 @@ Matcher AllOf(Args&&... args) {
   auto predicate = [](const Symbol& symbol) { return true; };
 
   Matcher matcher(predicate, InnerMatchAll);
+  matcher.DescribePredicateAsAnySymbol();
 
   matcher.AddMatchers(std::forward<Args>(args)...);
 
@@ -96,6 +97,7 @@ Matcher AnyOf(Args&&... args) {
   auto predicate = [](const Symbol& symbol) { return true; };
 
   Matcher matcher(predicate, InnerMatchAny);
+  matcher.DescribePredicateAsAnySymbol();
 
   matcher.AddMatchers(std::forward<Args>(args)...);
 
@@ -135,6 +137,7 @@ Matcher EachOf(Args&&... args) {
   auto predicate = [](const Symbol& symbol) { return true; };
 
   Matcher matcher(predicate, InnerMatchEachOf);
+  matcher.DescribePredicateAsAnySymbol();
 
   matcher.AddMatchers(std::forward<Args>(args)...);
 
@@ -163,6 +166,7 @@ Matcher Unless(const Matcher& inner_matcher) {
   auto predicate = [](const Symbol& symbol) { return true; };
 
   Matcher matcher(predicate, InnerMatchUnless);
+  matcher.DescribePredicateAsAnySymbol();
 
   matcher.AddMatchers(inner_matcher);
 
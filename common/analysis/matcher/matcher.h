@@ -22,6 +22,7 @@
 
 #include "absl/types/optional.h"
 #include "common/analysis/matcher/bound_symbol_manager.h"
+#include "common/analysis/matcher/descent_path.h"
 #include "common/text/symbol.h"
 
 namespace verible {
@@ -29,6 +30,7 @@ namespace matcher {
 
 // Forward declaration of Matcher class
 class Matcher;
+class CompiledMatcher;
 
 using SymbolPredicate = std::function<bool(const Symbol&)>;
 using SymbolTransformer =
@@ -55,7 +57,9 @@ using InnerMatchHandler = std::function<bool(
 class Matcher {
  public:
   Matcher(const SymbolPredicate& p, const InnerMatchHandler& handler)
-      : predicate_(p), inner_match_handler_(handler) {}
+      : predicate_(p),
+        inner_match_handler_(handler),
+        transformer_form_(TransformerForm::kIdentity) {}
 
   Matcher(const SymbolPredicate& p, const InnerMatchHandler& handler,
           const SymbolTransformer& t)
@@ -78,10 +82,39 @@ class Matcher {
     AddMatchers(std::forward<Args>(args)...);
   }
 
+  // Records that the predicate accepts any symbol, or only symbols tagged
+  // 'tag', and that the transformer is GetAllDescendantsFromPath(path).
+  // This lets CompiledMatcher evaluate them without calling them.  The
+  // builders in core_matchers.h and matcher_builders.h describe their
+  // matchers; descriptions must agree with the functions passed to the
+  // constructor.
+  void DescribePredicateAsAnySymbol() {
+    predicate_form_ = PredicateForm::kAnySymbol;
+  }
+  void DescribePredicateAsTag(SymbolTag tag) {
+    predicate_form_ = PredicateForm::kTag;
+    predicate_tag_ = tag;
+  }
+  void DescribeTransformerAsPath(const DescentPath& path) {
+    transformer_form_ = TransformerForm::kPath;
+    transformer_path_ = path;
+  }
+
  private:
+  friend class CompiledMatcher;
+
+  enum class PredicateForm { kCustom, kAnySymbol, kTag };
+  enum class TransformerForm { kCustom, kIdentity, kPath };
+
   // Contains all inner matchers.
   std::vector<Matcher> inner_matchers_;
 
+  // Descriptions of predicate_ and transformer_ (see above).
+  PredicateForm predicate_form_ = PredicateForm::kCustom;
+  SymbolTag predicate_tag_ = {SymbolKind::kNode, 0};
+  TransformerForm transformer_form_ = TransformerForm::kCustom;
+  DescentPath transformer_path_;
+
  protected:
   // Determines whether or not this matches against a given symbol.
   SymbolPredicate predicate_;
@@ -97,6 +97,8 @@ class PathMatchBuilder {
     };
 
     BindableMatcher matcher(predicate, InnerMatchAll, transformer);
+    matcher.DescribePredicateAsAnySymbol();
+    matcher.DescribeTransformerAsPath(local_path);
     matcher.AddMatchers(std::forward<Args>(args)...);
     return matcher;
   }
@@ -153,6 +155,7 @@ class TagMatchBuilder {
   BindableMatcher operator()(Args... args) const {
     BindableMatcher matcher(EqualTagPredicate<Kind, EnumType, Tag>,
                             InnerMatchAll);
+    matcher.DescribePredicateAsTag({Kind, static_cast<int>(Tag)});
     matcher.AddMatchers(std::forward<Args>(args)...);
     return matcher;
   }
@@ -185,6 +188,7 @@ class DynamicTagMatchBuilder {
   BindableMatcher operator()(Args... args) const {
     BindableMatcher matcher([this](const Symbol& s) { return s.Tag() == tag_; },
                             InnerMatchAll);
+    matcher.DescribePredicateAsTag(tag_);
     matcher.AddMatchers(std::forward<Args>(args)...);
     return matcher;
   }
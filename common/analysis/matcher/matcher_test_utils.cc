@@ -19,6 +19,7 @@
 
 #include "absl/strings/string_view.h"
 #include "common/analysis/matcher/bound_symbol_manager.h"
+#include "common/analysis/matcher/compiled_matcher.h"
 #include "common/analysis/matcher/matcher.h"
 #include "common/text/concrete_syntax_leaf.h"
 #include "common/text/concrete_syntax_tree.h"
@@ -53,11 +54,18 @@ void RunMatcherTestCase(const MatcherTestCase& test) {
     // If test failed, then it should not report any bound symbols
     EXPECT_EQ(bound_symbol_manager.Size(), 0);
   }
+
+  // The compiled matcher should behave the same.
+  const CompiledMatcher compiled(test.matcher);
+  BoundSymbolManager compiled_manager;
+  EXPECT_EQ(compiled.Matches(*test.root, &compiled_manager), result);
+  EXPECT_EQ(compiled_manager.GetBoundMap(), bound_symbol_manager.GetBoundMap());
 }
 
 class MatchCounter : public TreeVisitorRecursive {
  public:
-  explicit MatchCounter(const Matcher& matcher) : matcher_(matcher) {}
+  explicit MatchCounter(const Matcher& matcher)
+      : matcher_(matcher), compiled_(matcher) {}
 
   int Count(const Symbol& symbol) {
     num_matches_ = 0;
@@ -70,12 +78,18 @@ class MatchCounter : public TreeVisitorRecursive {
 
  private:
   const Matcher matcher_;
+  const CompiledMatcher compiled_;
   int num_matches_ = 0;
 
   void TestSymbol(const Symbol& symbol) {
     BoundSymbolManager manager;
     bool found_match = matcher_.Matches(symbol, &manager);
 
+    // The compiled matcher should behave the same.
+    BoundSymbolManager compiled_manager;
+    EXPECT_EQ(compiled_.Matches(symbol, &compiled_manager), found_match);
+    EXPECT_EQ(compiled_manager.GetBoundMap(), manager.GetBoundMap());
+
     if (found_match) {
       num_matches_++;
     }
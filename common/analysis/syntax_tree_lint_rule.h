@@ -15,6 +15,8 @@
 #ifndef VERIBLE_COMMON_ANALYSIS_SYNTAX_TREE_LINT_RULE_H_
 #define VERIBLE_COMMON_ANALYSIS_SYNTAX_TREE_LINT_RULE_H_
 
+#include <vector>
+
 #include "common/analysis/lint_rule.h"
 #include "common/text/concrete_syntax_leaf.h"
 #include "common/text/concrete_syntax_tree.h"
@@ -46,6 +48,12 @@ class SyntaxTreeLintRule : public LintRule {
                           const SyntaxTreeContext& context) {}
   virtual void HandleSymbol(const Symbol& node,
                             const SyntaxTreeContext& context) {}
+
+  // Returns the tags of the leaves and nodes that this rule handles.  Linters
+  // only call the Handle* methods for symbols with one of these tags, saving
+  // the calls for all other symbols.  The default, an empty list, means every
+  // symbol; keep it for rules that track state across symbols.
+  virtual std::vector<SymbolTag> HandledTags() const { return {}; }
 };
 
 }  // namespace verible
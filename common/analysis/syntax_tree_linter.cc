@@ -15,22 +15,98 @@
 #include "common/analysis/syntax_tree_linter.h"
 
 #include <memory>
+#include <utility>
 #include <vector>
 
+#include "absl/strings/string_view.h"
 #include "common/analysis/lint_rule_status.h"
 #include "common/analysis/syntax_tree_lint_rule.h"
+#include "common/strings/position.h"
 #include "common/text/concrete_syntax_leaf.h"
 #include "common/text/concrete_syntax_tree.h"
+#include "common/text/flat_syntax_tree.h"
 #include "common/text/symbol.h"
 #include "common/text/syntax_tree_context.h"
+#include "common/text/tree_utils.h"
 #include "common/util/logging.h"
 
 namespace verible {
 
+void SyntaxTreeLinter::DispatchTable::AddForAllTags(SyntaxTreeLintRule* rule) {
+  all_tags_.push_back(rule);
+  for (auto& rules : by_tag_) rules.push_back(rule);
+}
+
+void SyntaxTreeLinter::DispatchTable::AddForTag(SyntaxTreeLintRule* rule,
+                                                int tag) {
+  CHECK_GE(tag, 0);
+  if (static_cast<size_t>(tag) >= by_tag_.size()) {
+    // Until now, these tags were only handled by the rules for all tags.
+    by_tag_.resize(tag + 1, all_tags_);
+  }
+  std::vector<SyntaxTreeLintRule*>& rules = by_tag_[tag];
+  if (rules.empty() || rules.back() != rule) rules.push_back(rule);
+}
+
+void SyntaxTreeLinter::AddRule(std::unique_ptr<SyntaxTreeLintRule> rule) {
+  const std::vector<SymbolTag> tags = ABSL_DIE_IF_NULL(rule)->HandledTags();
+  if (tags.empty()) {
+    leaf_rules_.AddForAllTags(rule.get());
+    node_rules_.AddForAllTags(rule.get());
+  }
+  for (const SymbolTag& tag : tags) {
+    DispatchTable& table =
+        tag.kind == SymbolKind::kLeaf ? leaf_rules_ : node_rules_;
+    table.AddForTag(rule.get(), tag.tag);
+  }
+  rules_.emplace_back(std::move(rule));
+}
+
 void SyntaxTreeLinter::Lint(const Symbol& root) {
   VLOG(1) << "SyntaxTreeLinter analyzing syntax tree with " << rules_.size()
           << " rules.";
+  profiles_.Start();
   root.Accept(this);
+  profiles_.Finish(rules_);
+}
+
+void SyntaxTreeLinter::Lint(const FlatSyntaxTree& tree) {
+  VLOG(1) << "SyntaxTreeLinter analyzing flat syntax tree with "
+          << rules_.size() << " rules.";
+  profiles_.Start();
+  tree.ForEachSymbol(
+      [this](const Symbol& symbol, const SyntaxTreeContext& context) {
+        if (symbol.Kind() == SymbolKind::kLeaf) {
+          HandleLeaf(SymbolCastToLeaf(symbol), context);
+        } else {
+          HandleNode(SymbolCastToNode(symbol), context);
+        }
+      });
+  profiles_.Finish(rules_);
+}
+
+void SyntaxTreeLinter::Lint(const FlatSyntaxTree& tree, absl::string_view base,
+                            const ByteOffsetSet& byte_ranges) {
+  VLOG(1) << "SyntaxTreeLinter analyzing flat syntax tree with "
+          << rules_.size() << " rules in byte ranges " << byte_ranges;
+  profiles_.Start();
+  tree.ForEachSymbolIf(
+      [&](size_t index) {
+        const absl::string_view span = tree.StringSpan(index);
+        if (span.empty()) return true;  // cheap either way
+        const int begin = span.data() - base.data();
+        const auto range = byte_ranges.LowerBound(begin);
+        return range != byte_ranges.end() &&
+               range->first < begin + static_cast<int>(span.size());
+      },
+      [this](const Symbol& symbol, const SyntaxTreeContext& context) {
+        if (symbol.Kind() == SymbolKind::kLeaf) {
+          HandleLeaf(SymbolCastToLeaf(symbol), context);
+        } else {
+          HandleNode(SymbolCastToNode(symbol), context);
+        }
+      });
+  profiles_.Finish(rules_);
 }
 
 std::vector<LintRuleStatus> SyntaxTreeLinter::ReportStatus() const {
@@ -42,24 +118,36 @@ std::vector<LintRuleStatus> SyntaxTreeLinter::ReportStatus() const {
   return status;
 }
 
-// Visits a leaf. Every held rule handles that leaf.
-void SyntaxTreeLinter::Visit(const SyntaxTreeLeaf& leaf) {
-  for (const auto& rule : rules_) {
+void SyntaxTreeLinter::HandleLeaf(const SyntaxTreeLeaf& leaf,
+                                  const SyntaxTreeContext& context) {
+  for (SyntaxTreeLintRule* rule : leaf_rules_.RulesFor(leaf.Tag().tag)) {
     // Have rule handle the leaf as both a leaf and a symbol.
-    ABSL_DIE_IF_NULL(rule)->HandleLeaf(leaf, Context());
-    rule->HandleSymbol(leaf, Context());
+    const ScopedLintRuleCall call(profiles_.Of(rule));
+    rule->HandleLeaf(leaf, context);
+    rule->HandleSymbol(leaf, context);
+  }
+}
+
+void SyntaxTreeLinter::HandleNode(const SyntaxTreeNode& node,
+                                  const SyntaxTreeContext& context) {
+  for (SyntaxTreeLintRule* rule : node_rules_.RulesFor(node.Tag().tag)) {
+    // Have rule handle the node as both a node and a symbol.
+    const ScopedLintRuleCall call(profiles_.Of(rule));
+    rule->HandleNode(node, context);
+    rule->HandleSymbol(node, context);
   }
 }
 
+// Visits a leaf. Every held rule for its tag handles that leaf.
+void SyntaxTreeLinter::Visit(const SyntaxTreeLeaf& leaf) {
+  HandleLeaf(leaf, Context());
+}
+
 // Visits a node. First, linter has every rule handle that node
 // Second, linter recurses on every non-null child of that node in order
 // to visit the entire tree
 void SyntaxTreeLinter::Visit(const SyntaxTreeNode& node) {
-  for (const auto& rule : rules_) {
-    // Have rule handle the node as both a node and a symbol.
-    ABSL_DIE_IF_NULL(rule)->HandleNode(node, Context());
-    rule->HandleSymbol(node, Context());
-  }
+  HandleNode(node, Context());
 
   // Visit subtree children.
   TreeContextVisitor::Visit(node);
@@ -19,14 +19,18 @@
 #ifndef VERIBLE_COMMON_ANALYSIS_SYNTAX_TREE_LINTER_H_
 #define VERIBLE_COMMON_ANALYSIS_SYNTAX_TREE_LINTER_H_
 
+#include <cstddef>
 #include <memory>
-#include <utility>
 #include <vector>
 
+#include "absl/strings/string_view.h"
+#include "common/analysis/lint_rule_profile.h"
 #include "common/analysis/lint_rule_status.h"
 #include "common/analysis/syntax_tree_lint_rule.h"
+#include "common/strings/position.h"
 #include "common/text/concrete_syntax_leaf.h"
 #include "common/text/concrete_syntax_tree.h"
+#include "common/text/flat_syntax_tree.h"
 #include "common/text/symbol.h"
 #include "common/text/syntax_tree_context.h"
 #include "common/text/tree_context_visitor.h"
@@ -55,9 +59,7 @@ class SyntaxTreeLinter : public TreeContextVisitor {
   void Visit(const SyntaxTreeNode& node) final;
 
   // Transfers ownership of rule into Linter
-  void AddRule(std::unique_ptr<SyntaxTreeLintRule> rule) {
-    rules_.emplace_back(std::move(rule));
-  }
+  void AddRule(std::unique_ptr<SyntaxTreeLintRule> rule);
 
   // Aggregates results of each held LintRule
   std::vector<LintRuleStatus> ReportStatus() const;
@@ -65,10 +67,54 @@ class SyntaxTreeLinter : public TreeContextVisitor {
   // Performs lint analysis on root
   void Lint(const Symbol& root);
 
+  // Performs the same lint analysis, in one linear pass over the flattened
+  // tree.
+  void Lint(const FlatSyntaxTree& tree);
+
+  // Like Lint(tree), but skips the subtrees whose text lies entirely outside
+  // of 'byte_ranges', which are offsets into 'base', e.g. to only lint
+  // changed lines.  Rules don't see the symbols of skipped subtrees at all,
+  // so rules that relate distant parts of the text may miss violations.
+  void Lint(const FlatSyntaxTree& tree, absl::string_view base,
+            const ByteOffsetSet& byte_ranges);
+
  private:
+  // Has every rule handle the leaf/node in its context.
+  void HandleLeaf(const SyntaxTreeLeaf& leaf, const SyntaxTreeContext& context);
+  void HandleNode(const SyntaxTreeNode& node, const SyntaxTreeContext& context);
+
+  // Rules to call for the leaves or the nodes, by tag, in the order in which
+  // they were added.
+  class DispatchTable {
+   public:
+    // Adds a rule that handles all tags.
+    void AddForAllTags(SyntaxTreeLintRule* rule);
+
+    // Adds a rule that handles 'tag'.
+    void AddForTag(SyntaxTreeLintRule* rule, int tag);
+
+    const std::vector<SyntaxTreeLintRule*>& RulesFor(int tag) const {
+      return (tag >= 0 && static_cast<size_t>(tag) < by_tag_.size())
+                 ? by_tag_[tag]
+                 : all_tags_;
+    }
+
+   private:
+    // Rules for tags that no rule was added for specifically.
+    std::vector<SyntaxTreeLintRule*> all_tags_;
+    std::vector<std::vector<SyntaxTreeLintRule*>> by_tag_;
+  };
+
   // List of rules that the linter is using. Rules are responsible for tracking
   // their own internal state.
   std::vector<std::unique_ptr<SyntaxTreeLintRule>> rules_;
+
+  // Cost of the rules during a run, when profiling.
+  LintRuleCallProfiles profiles_;
+
+  // Rules of rules_, by the tags they handle.
+  DispatchTable leaf_rules_;
+  DispatchTable node_rules_;
 };
 
 }  // namespace verible
@@ -15,21 +15,31 @@
 #include "common/analysis/syntax_tree_linter.h"
 
 #include <memory>
+#include <string>
+#include <utility>
 #include <vector>
 
+#include "absl/strings/str_cat.h"
+#include "absl/strings/string_view.h"
+
 #include "common/analysis/lint_rule_status.h"
 #include "common/analysis/syntax_tree_lint_rule.h"
+#include "common/strings/position.h"
 #include "common/text/concrete_syntax_leaf.h"
 #include "common/text/concrete_syntax_tree.h"
+#include "common/text/flat_syntax_tree.h"
 #include "common/text/symbol.h"
 #include "common/text/syntax_tree_context.h"
 #include "common/text/token_info.h"
 #include "common/text/tree_builder_test_util.h"
+#include "gmock/gmock.h"
 #include "gtest/gtest.h"
 
 namespace verible {
 namespace {
 
+using ::testing::ElementsAre;
+
 // Simple rule for testing that verifies that all leafs contained in tree
 // are tagged as a certain value. This value is passed in via the constructor
 class AllLeavesMustBeN : public SyntaxTreeLintRule {
@@ -275,5 +285,127 @@ TEST(SyntaxTreeLinterTest, DepthSuccess) {
   EXPECT_EQ(statuses[0].violations.size(), 0);
 }
 
+TEST(SyntaxTreeLinterTest, FlatTreeDepthFails) {
+  constexpr absl::string_view text("abcde");
+  SymbolPtr root =
+      Node(Leaf(1, text.substr(0, 1)), Leaf(4, text.substr(1, 1)),
+           Node(Leaf(210, text.substr(2, 1)), Leaf(10, text.substr(3, 1))),
+           Leaf(1, text.substr(4, 1)));
+  SyntaxTreeLinter linter;
+  linter.AddRule(MakeDepth());
+  ASSERT_NE(root.get(), nullptr);
+  linter.Lint(FlatSyntaxTree(*root));
+
+  std::vector<LintRuleStatus> statuses = linter.ReportStatus();
+  EXPECT_EQ(statuses.size(), 1);
+  EXPECT_FALSE(statuses[0].isOk());
+  EXPECT_EQ(statuses[0].violations.size(), 3);
+}
+
+TEST(SyntaxTreeLinterTest, FlatTreeDepthSuccess) {
+  constexpr absl::string_view text("abcde");
+  SymbolPtr root =
+      Node(Leaf(1, text.substr(0, 1)), nullptr, Leaf(1, text.substr(1, 1)),
+           Node(Leaf(2, text.substr(2, 1)), Leaf(2, text.substr(3, 1))),
+           Leaf(1, text.substr(4, 1)));
+  SyntaxTreeLinter linter;
+  linter.AddRule(MakeDepth());
+  ASSERT_NE(root.get(), nullptr);
+  linter.Lint(FlatSyntaxTree(*root));
+
+  std::vector<LintRuleStatus> statuses = linter.ReportStatus();
+  EXPECT_EQ(statuses.size(), 1);
+  EXPECT_TRUE(statuses[0].isOk());
+  EXPECT_EQ(statuses[0].violations.size(), 0);
+}
+
+// Testing rule that logs the symbols that it handles, as "<name>:<tag>" for
+// leaves and "<name>:[<tag>]" for nodes.
+class LogHandledSymbols : public SyntaxTreeLintRule {
+ public:
+  LogHandledSymbols(std::string name, std::vector<SymbolTag> tags,
+                    std::vector<std::string>* log)
+      : name_(std::move(name)), tags_(std::move(tags)), log_(log) {}
+
+  void HandleSymbol(const Symbol& symbol,
+                    const SyntaxTreeContext& context) final {
+    const int tag = symbol.Tag().tag;
+    log_->push_back(symbol.Kind() == SymbolKind::kLeaf
+                        ? absl::StrCat(name_, ":", tag)
+                        : absl::StrCat(name_, ":[", tag, "]"));
+  }
+
+  std::vector<SymbolTag> HandledTags() const final { return tags_; }
+
+  LintRuleStatus Report() const final { return LintRuleStatus(); }
+
+ private:
+  const std::string name_;
+  const std::vector<SymbolTag> tags_;
+  std::vector<std::string>* const log_;
+};
+
+TEST(SyntaxTreeLinterTest, RulesOnlyHandleTheirTags) {
+  constexpr absl::string_view text("abc");
+  SymbolPtr root = TNode(5, Leaf(2, text.substr(0, 1)),
+                         Leaf(3, text.substr(1, 1)),
+                         TNode(6, Leaf(2, text.substr(2, 1))), TNode(5));
+  std::vector<std::string> log;
+  SyntaxTreeLinter linter;
+  linter.AddRule(std::make_unique<LogHandledSymbols>(
+      "all", std::vector<SymbolTag>(), &log));
+  linter.AddRule(std::make_unique<LogHandledSymbols>(
+      "some", std::vector<SymbolTag>{LeafTag(2), NodeTag(5), LeafTag(2)},
+      &log));
+  linter.AddRule(std::make_unique<LogHandledSymbols>(
+      "node6", std::vector<SymbolTag>{NodeTag(6)}, &log));
+  linter.AddRule(std::make_unique<LogHandledSymbols>(
+      "later", std::vector<SymbolTag>(), &log));
+
+  ASSERT_NE(root, nullptr);
+  for (const bool flat : {false, true}) {
+    log.clear();
+    if (flat) {
+      linter.Lint(FlatSyntaxTree(*root));
+    } else {
+      linter.Lint(*root);
+    }
+    // Rules for a symbol are called in the order in which they were added.
+    EXPECT_THAT(log,
+                ElementsAre("all:[5]", "some:[5]", "later:[5]",       //
+                            "all:2", "some:2", "later:2",             //
+                            "all:3", "later:3",                       //
+                            "all:[6]", "node6:[6]", "later:[6]",      //
+                            "all:2", "some:2", "later:2",             //
+                            "all:[5]", "some:[5]", "later:[5]"))
+        << "flat: " << flat;
+  }
+  EXPECT_EQ(linter.ReportStatus().size(), 4);
+}
+
+TEST(SyntaxTreeLinterTest, FlatTreeByteRangesSkipSubtrees) {
+  constexpr absl::string_view text("abcdef");
+  SymbolPtr root = TNode(5, Leaf(2, text.substr(0, 1)),
+                         TNode(6, Leaf(3, text.substr(1, 1)),
+                               Leaf(4, text.substr(2, 1))),
+                         TNode(7, Leaf(3, text.substr(4, 2))), TNode(8));
+  std::vector<std::string> log;
+  SyntaxTreeLinter linter;
+  linter.AddRule(std::make_unique<LogHandledSymbols>(
+      "all", std::vector<SymbolTag>(), &log));
+  ASSERT_NE(root, nullptr);
+  const FlatSyntaxTree flat(*root);
+
+  // Node 6 (bytes [1, 3)) is skipped, node 7 (bytes [4, 6)) overlaps [5, 6).
+  // Nodes without text are always visited.
+  linter.Lint(flat, text, ByteOffsetSet{{0, 1}, {5, 6}});
+  EXPECT_THAT(log, ElementsAre("all:[5]", "all:2", "all:[7]", "all:3",
+                               "all:[8]"));
+
+  log.clear();
+  linter.Lint(flat, text, ByteOffsetSet{{3, 4}});
+  EXPECT_THAT(log, ElementsAre("all:[5]", "all:[8]"));
+}
+
 }  // namespace
 }  // namespace verible
@@ -14,22 +14,29 @@
 
 #include "common/analysis/syntax_tree_search.h"
 
+#include <algorithm>
+#include <cstddef>
 #include <functional>
 #include <memory>
+#include <utility>
 #include <vector>
 
 #include "common/analysis/matcher/bound_symbol_manager.h"
+#include "common/analysis/matcher/compiled_matcher.h"
 #include "common/analysis/matcher/matcher.h"
 #include "common/text/concrete_syntax_leaf.h"
 #include "common/text/concrete_syntax_tree.h"
+#include "common/text/flat_syntax_tree.h"
 #include "common/text/symbol.h"
 #include "common/text/syntax_tree_context.h"
+#include "common/text/syntax_tree_index.h"
 #include "common/text/tree_context_visitor.h"
 
 namespace verible {
 namespace {
 
 using matcher::BoundSymbolManager;
+using matcher::CompiledMatcher;
 
 // SyntaxTreeSearcher collects node that match specified criteria
 // from a syntax tree.  Prefer to use the SearchSyntaxTree() function
@@ -37,7 +44,7 @@ using matcher::BoundSymbolManager;
 class SyntaxTreeSearcher : public TreeContextVisitor {
  public:
   SyntaxTreeSearcher(
-      const matcher::Matcher& m,
+      const CompiledMatcher& m,
       const std::function<bool(const SyntaxTreeContext&)>& context_predicate)
       : matcher_(m), context_predicate_(context_predicate) {}
 
@@ -51,10 +58,10 @@ class SyntaxTreeSearcher : public TreeContextVisitor {
   void Visit(const SyntaxTreeNode& node) final;
 
   // Main matcher that finds a particular type of tree node.
-  const verible::matcher::Matcher matcher_;
+  const CompiledMatcher& matcher_;
 
   // Predicate that further qualifies the matches of interest.
-  const std::function<bool(const SyntaxTreeContext&)> context_predicate_;
+  const std::function<bool(const SyntaxTreeContext&)>& context_predicate_;
 
   // Accumulated set of matches.
   std::vector<TreeSearchMatch> matches_;
@@ -84,10 +91,48 @@ void SyntaxTreeSearcher::Visit(const SyntaxTreeNode& node) {
 
 }  // namespace
 
+// Searches the subtree of entry 'root' of 'index', only looking at the
+// symbols whose tag can match.
+static std::vector<TreeSearchMatch> SearchSyntaxTreeIndex(
+    const SyntaxTreeIndex& index, int root, const CompiledMatcher& matcher,
+    const std::function<bool(const SyntaxTreeContext&)>& context_predicate) {
+  std::vector<int> candidates;
+  for (const SymbolTag tag : matcher.RootTags()) {
+    const auto entries = index.EntriesWithTag(tag, root);
+    candidates.insert(candidates.end(), entries.begin(), entries.end());
+  }
+  // Keep the order of a traversal.
+  if (matcher.RootTags().size() > 1) {
+    std::sort(candidates.begin(), candidates.end());
+  }
+
+  std::vector<TreeSearchMatch> matches;
+  const FlatSyntaxTree& tree = index.Tree();
+  for (const int candidate : candidates) {
+    const Symbol& symbol = *tree.Entries()[candidate].symbol;
+    BoundSymbolManager manager;
+    if (!matcher.Matches(symbol, &manager)) continue;
+    SyntaxTreeContext context(tree.ContextOf(candidate, root));
+    if (context_predicate(context)) {
+      matches.push_back(TreeSearchMatch{&symbol, std::move(context)});
+    }
+  }
+  return matches;
+}
+
 std::vector<TreeSearchMatch> SearchSyntaxTree(
     const Symbol& root, const verible::matcher::Matcher& matcher,
     const std::function<bool(const SyntaxTreeContext&)>& context_predicate) {
-  SyntaxTreeSearcher searcher(matcher, context_predicate);
+  const CompiledMatcher compiled(matcher);
+  if (!compiled.MayMatchAnyTag()) {
+    const SyntaxTreeIndex* index = SyntaxTreeIndex::Current();
+    const int root_entry = index != nullptr ? index->EntryOf(root) : -1;
+    if (root_entry >= 0) {
+      return SearchSyntaxTreeIndex(*index, root_entry, compiled,
+                                   context_predicate);
+    }
+  }
+  SyntaxTreeSearcher searcher(compiled, context_predicate);
   searcher.Search(root);
   return searcher.Matches();
 }
@@ -98,4 +143,28 @@ std::vector<TreeSearchMatch> SearchSyntaxTree(
                           [](const SyntaxTreeContext&) { return true; });
 }
 
+std::vector<TreeSearchMatch> SearchSyntaxTree(
+    const FlatSyntaxTree& tree, const verible::matcher::Matcher& matcher,
+    const std::function<bool(const SyntaxTreeContext&)>& context_predicate) {
+  std::vector<TreeSearchMatch> matches;
+  const CompiledMatcher compiled(matcher);
+  const auto& entries = tree.Entries();
+  for (size_t i = 0; i < entries.size(); ++i) {
+    if (!compiled.MayMatchTag(entries[i].symbol->Tag())) continue;
+    BoundSymbolManager manager;
+    if (!compiled.Matches(*entries[i].symbol, &manager)) continue;
+    SyntaxTreeContext context(tree.ContextOf(i));
+    if (context_predicate(context)) {
+      matches.push_back(TreeSearchMatch{entries[i].symbol, std::move(context)});
+    }
+  }
+  return matches;
+}
+
+std::vector<TreeSearchMatch> SearchSyntaxTree(
+    const FlatSyntaxTree& tree, const verible::matcher::Matcher& matcher) {
+  return SearchSyntaxTree(tree, matcher,
+                          [](const SyntaxTreeContext&) { return true; });
+}
+
 }  // namespace verible
@@ -19,6 +19,7 @@
 #include <vector>
 
 #include "common/analysis/matcher/matcher.h"
+#include "common/text/flat_syntax_tree.h"
 #include "common/text/symbol.h"
 #include "common/text/syntax_tree_context.h"
 
@@ -43,6 +44,10 @@ struct TreeSearchMatch {
 // SearchSyntaxTree collects nodes that match the specified criteria into a
 // vector.  This is useful for analyses that need to look at a collection
 // of related nodes together, rather than as each one is encountered.
+//
+// If 'root' is part of the tree of the SyntaxTreeIndex that is active in the
+// current thread, and the matcher only matches symbols of some tags, only
+// symbols of those tags are looked at.  See syntax_tree_index.h.
 std::vector<TreeSearchMatch> SearchSyntaxTree(
     const Symbol& root, const verible::matcher::Matcher& matcher,
     const std::function<bool(const SyntaxTreeContext&)>& context_predicate);
@@ -51,6 +56,16 @@ std::vector<TreeSearchMatch> SearchSyntaxTree(
 std::vector<TreeSearchMatch> SearchSyntaxTree(
     const Symbol& root, const verible::matcher::Matcher& matcher);
 
+// Same as above, over the flattened syntax tree: symbols are checked in one
+// linear pass, and the context is only collected for matching symbols.
+// Matches are the same, in the same order.
+std::vector<TreeSearchMatch> SearchSyntaxTree(
+    const FlatSyntaxTree& tree, const verible::matcher::Matcher& matcher,
+    const std::function<bool(const SyntaxTreeContext&)>& context_predicate);
+
+std::vector<TreeSearchMatch> SearchSyntaxTree(
+    const FlatSyntaxTree& tree, const verible::matcher::Matcher& matcher);
+
 }  // namespace verible
 
 #endif  // VERIBLE_COMMON_ANALYSIS_SYNTAX_TREE_SEARCH_H_
@@ -14,13 +14,17 @@
 
 #include "common/analysis/syntax_tree_search.h"
 
+#include <algorithm>
 #include <memory>
 #include <vector>
 
+#include "common/analysis/matcher/core_matchers.h"
 #include "common/analysis/matcher/matcher.h"
 #include "common/analysis/matcher/matcher_builders.h"
+#include "common/text/flat_syntax_tree.h"
 #include "common/text/symbol.h"
 #include "common/text/syntax_tree_context.h"
+#include "common/text/syntax_tree_index.h"
 #include "common/text/tree_builder_test_util.h"
 #include "common/text/tree_utils.h"
 #include "gtest/gtest.h"
@@ -134,5 +138,83 @@ TEST(SearchSyntaxTreeTest, RootOnlyNodeMatchTruePredicate) {
   EXPECT_EQ(&SymbolCastToNode(*matches.front().match), tree.get());
 }
 
+// Tests that searching the flattened tree finds the same matches.
+TEST(SearchSyntaxTreeTest, FlatTreeNestedNodeMatch) {
+  auto tree = Node(TNode(1, TNode(3), nullptr, TNode(1)),
+                   Node(XLeaf(4), TNode(3)));
+  auto matcher_builder = NodeMatcher<1>();
+  auto matcher = matcher_builder();
+  auto matches = SearchSyntaxTree(FlatSyntaxTree(*tree), matcher);
+  ASSERT_EQ(matches.size(), 2);
+  EXPECT_EQ(matches.front().match, DescendPath(*tree, {0}));
+  EXPECT_EQ(matches.front().context.size(), 1);
+  EXPECT_EQ(matches.back().match, DescendPath(*tree, {0, 2}));
+  ASSERT_EQ(matches.back().context.size(), 2);
+  EXPECT_TRUE(matches.back().context.DirectParentIs(1));
+}
+
+// Tests that the predicate sees the context of flattened tree matches.
+TEST(SearchSyntaxTreeTest, FlatTreeContextPredicate) {
+  auto tree = Node(TNode(1, TNode(3), TNode(2, TNode(3))), TNode(3));
+  auto matcher_builder = NodeMatcher<3>();
+  auto matcher = matcher_builder();
+  auto matches = SearchSyntaxTree(
+      FlatSyntaxTree(*tree), matcher,
+      [](const SyntaxTreeContext& context) { return context.IsInside(1); });
+  ASSERT_EQ(matches.size(), 2);
+  EXPECT_EQ(matches.front().match, DescendPath(*tree, {0, 0}));
+  EXPECT_EQ(matches.back().match, DescendPath(*tree, {0, 1, 0}));
+  EXPECT_TRUE(matches.back().context.DirectParentsAre({2, 1}));
+}
+
+// Tests that searches with an active index find the same matches, with the
+// same context, in the whole tree and in subtrees.
+TEST(SearchSyntaxTreeTest, IndexedSearch) {
+  auto tree = Node(TNode(1, TNode(3), TNode(2, TNode(3), XLeaf(3))),
+                   TNode(3, TNode(2)));
+  const std::vector<matcher::Matcher> matchers = {
+      NodeMatcher<3>()(),
+      NodeMatcher<2>()(),
+      matcher::AnyOf(NodeMatcher<2>()(), LeafMatcher<3>()()),
+      matcher::AllOf(NodeMatcher<1>()(), NodeMatcher<2>()()),
+      matcher::Unless(NodeMatcher<3>()()),  // can match any tag
+  };
+  const std::vector<const Symbol*> roots = {
+      tree.get(), DescendPath(*tree, {0}), DescendPath(*tree, {0, 1}),
+      DescendPath(*tree, {1})};
+  const auto in_2 = [](const SyntaxTreeContext& context) {
+    return context.IsInside(2);
+  };
+  for (const auto& matcher : matchers) {
+    for (const Symbol* root : roots) {
+      const auto expected = SearchSyntaxTree(*root, matcher);
+      const auto expected_in_2 = SearchSyntaxTree(*root, matcher, in_2);
+
+      const SyntaxTreeIndex index(*tree);
+      const SyntaxTreeIndex::Scope scope(&index);
+      const auto matches = SearchSyntaxTree(*root, matcher);
+      ASSERT_EQ(matches.size(), expected.size());
+      for (size_t i = 0; i < matches.size(); ++i) {
+        EXPECT_EQ(matches[i].match, expected[i].match);
+        EXPECT_TRUE(std::equal(matches[i].context.begin(),
+                               matches[i].context.end(),
+                               expected[i].context.begin(),
+                               expected[i].context.end()));
+      }
+      EXPECT_EQ(SearchSyntaxTree(*root, matcher, in_2).size(),
+                expected_in_2.size());
+    }
+  }
+}
+
+// Tests that searches outside of the indexed tree still work.
+TEST(SearchSyntaxTreeTest, IndexOfOtherTree) {
+  auto tree = Node(TNode(3));
+  auto other_tree = Node(TNode(3), TNode(3));
+  const SyntaxTreeIndex index(*tree);
+  const SyntaxTreeIndex::Scope scope(&index);
+  EXPECT_EQ(SearchSyntaxTree(*other_tree, NodeMatcher<3>()()).size(), 2);
+}
+
 }  // namespace
 }  // namespace verible
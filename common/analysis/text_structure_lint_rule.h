@@ -43,6 +43,10 @@ class TextStructureLintRule : public LintRule {
   // Analyze text structure for violations.
   virtual void Lint(const TextStructureView& text_structure,
                     absl::string_view filename) = 0;
+
+  // Returns false if Lint() only looks at lines and tokens, so that it can
+  // run on a TextStructureView that was only lexed, without a syntax tree.
+  virtual bool UsesSyntaxTree() const { return true; }
 };
 
 }  // namespace verible
@@ -28,9 +28,12 @@ void TextStructureLinter::Lint(const TextStructureView& text_structure,
                                absl::string_view filename) {
   VLOG(1) << "TextStructureLinter analyzing text with " << rules_.size()
           << " rules.";
+  profiles_.Start();
   for (const auto& rule : rules_) {
+    const ScopedLintRuleCall call(profiles_.Of(rule.get()));
     ABSL_DIE_IF_NULL(rule)->Lint(text_structure, filename);
   }
+  profiles_.Finish(rules_);
 }
 
 std::vector<LintRuleStatus> TextStructureLinter::ReportStatus() const {
@@ -24,6 +24,7 @@
 #include <vector>
 
 #include "absl/strings/string_view.h"
+#include "common/analysis/lint_rule_profile.h"
 #include "common/analysis/lint_rule_status.h"
 #include "common/analysis/text_structure_lint_rule.h"
 #include "common/text/text_structure.h"
@@ -40,6 +41,9 @@ class TextStructureLinter {
     rules_.emplace_back(std::move(rule));
   }
 
+  // Returns true if no rule was added.
+  bool empty() const { return rules_.empty(); }
+
   // Aggregates results of each held LintRule
   std::vector<LintRuleStatus> ReportStatus() const;
 
@@ -47,6 +51,9 @@ class TextStructureLinter {
   // List of rules that the linter is using. Rules are responsible for tracking
   // their own internal state.
   std::vector<std::unique_ptr<TextStructureLintRule>> rules_;
+
+  // Cost of the rules during a run, when profiling.
+  LintRuleCallProfiles profiles_;
 };
 
 }  // namespace verible
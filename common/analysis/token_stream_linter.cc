@@ -26,11 +26,14 @@ namespace verible {
 void TokenStreamLinter::Lint(const TokenSequence& tokens) {
   VLOG(1) << "TokenStreamLinter analyzing tokens with " << rules_.size()
           << " rules.";
+  profiles_.Start();
   for (const auto& token : tokens) {
     for (const auto& rule : rules_) {
+      const ScopedLintRuleCall call(profiles_.Of(rule.get()));
       ABSL_DIE_IF_NULL(rule)->HandleToken(token);
     }
   }
+  profiles_.Finish(rules_);
 }
 
 std::vector<LintRuleStatus> TokenStreamLinter::ReportStatus() const {
@@ -23,6 +23,7 @@
 #include <utility>
 #include <vector>
 
+#include "common/analysis/lint_rule_profile.h"
 #include "common/analysis/lint_rule_status.h"
 #include "common/analysis/token_stream_lint_rule.h"
 #include "common/text/token_stream_view.h"
@@ -39,6 +40,9 @@ class TokenStreamLinter {
     rules_.emplace_back(std::move(rule));
   }
 
+  // Returns true if no rule was added.
+  bool empty() const { return rules_.empty(); }
+
   // Aggregates results of each held LintRule
   std::vector<LintRuleStatus> ReportStatus() const;
 
@@ -46,6 +50,9 @@ class TokenStreamLinter {
   // List of rules that the linter is using. Rules are responsible for tracking
   // their own internal state.
   std::vector<std::unique_ptr<TokenStreamLintRule>> rules_;
+
+  // Cost of the rules during a run, when profiling.
+  LintRuleCallProfiles profiles_;
 };
 
 }  // namespace verible
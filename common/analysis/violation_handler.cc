@@ -16,7 +16,9 @@
 
 #include "absl/status/status.h"
 #include "common/strings/diff.h"
+#include "common/strings/line_column_map.h"
 #include "common/util/file_util.h"
+#include "common/util/json_writer.h"
 #include "common/util/user_interaction.h"
 
 namespace verible {
@@ -48,8 +50,8 @@ void PrintFixAlternatives(std::ostream& stream, absl::string_view text,
 }  // namespace
 
 void ViolationPrinter::HandleViolations(
-    const std::set<LintViolationWithStatus>& violations, absl::string_view base,
-    absl::string_view path) {
+    const std::vector<LintViolationWithStatus>& violations,
+    absl::string_view base, absl::string_view path) {
   verible::LintStatusFormatter formatter(base);
   for (auto violation : violations) {
     formatter.FormatViolation(stream_, *violation.violation, base, path,
@@ -59,9 +61,39 @@ void ViolationPrinter::HandleViolations(
   }
 }
 
+void ViolationJsonLinesPrinter::HandleViolations(
+    const std::vector<LintViolationWithStatus>& violations,
+    absl::string_view base, absl::string_view path) {
+  if (violations.empty()) return;
+  const verible::LineColumnMap line_column_map(base);
+  // Violations are ordered by location.
+  verible::LineColumnCursor cursor(line_column_map);
+  for (const auto& violation : violations) {
+    const verible::TokenInfo& token = violation.violation->token;
+    const verible::LineColumn start =
+        cursor.GetLineColAtOffset(base, token.left(base));
+    const verible::LineColumn end =
+        cursor.GetLineColAtOffset(base, token.right(base));
+    verible::JsonWriter writer(stream_, -1);
+    writer.BeginObject();
+    writer.Key("file").Value(path);
+    writer.Key("line").Value(start.line + 1);
+    writer.Key("column").Value(start.column + 1);
+    writer.Key("end_line").Value(end.line + 1);
+    writer.Key("end_column").Value(end.column + 1);
+    writer.Key("rule").Value(violation.status->lint_rule_name);
+    writer.Key("reason").Value(violation.violation->reason);
+    writer.Key("url").Value(violation.status->url);
+    writer.Key("autofix").Value(!violation.violation->autofixes.empty());
+    writer.EndObject();
+    (*stream_) << '\n';
+  }
+  stream_->flush();
+}
+
 void ViolationWaiverPrinter::HandleViolations(
-    const std::set<LintViolationWithStatus>& violations, absl::string_view base,
-    absl::string_view path) {
+    const std::vector<LintViolationWithStatus>& violations,
+    absl::string_view base, absl::string_view path) {
   verible::LintStatusFormatter formatter(base);
   for (auto violation : violations) {
     formatter.FormatViolation(message_stream_, *violation.violation, base, path,
@@ -75,14 +107,12 @@ void ViolationWaiverPrinter::HandleViolations(
   }
 }
 
-void ViolationFixer::CommitFixes(absl::string_view source_content,
-                                 absl::string_view source_path,
-                                 const verible::AutoFix& fix) const {
-  if (fix.Edits().empty()) {
+void ViolationFixer::CommitFixedContent(absl::string_view source_content,
+                                        absl::string_view source_path,
+                                        absl::string_view fixed_content) const {
+  if (fixed_content == source_content) {
     return;
   }
-  std::string fixed_content = fix.Apply(source_content);
-
   if (patch_stream_) {
     verible::LineDiffs diff(source_content, fixed_content);
     verible::LineDiffsToUnifiedDiff(*patch_stream_, diff, 1, source_path);
@@ -98,16 +128,22 @@ void ViolationFixer::CommitFixes(absl::string_view source_content,
 }
 
 void ViolationFixer::HandleViolations(
-    const std::set<LintViolationWithStatus>& violations, absl::string_view base,
-    absl::string_view path) {
+    const std::vector<LintViolationWithStatus>& violations,
+    absl::string_view base, absl::string_view path) {
+  CommitFixedContent(base, path, FixViolations(violations, base, path));
+}
+
+std::string ViolationFixer::FixViolations(
+    const std::vector<LintViolationWithStatus>& violations,
+    absl::string_view base, absl::string_view path) {
+  // All chosen edits are merged, and applied in one pass over 'base'.
   verible::AutoFix fix;
   verible::LintStatusFormatter formatter(base);
   for (auto violation : violations) {
     HandleViolation(*violation.violation, base, path, violation.status->url,
                     violation.status->lint_rule_name, formatter, &fix);
   }
-
-  CommitFixes(base, path, fix);
+  return fix.Apply(base);
 }
 
 void ViolationFixer::HandleViolation(
@@ -18,7 +18,8 @@
 #include <functional>
 #include <map>
 #include <ostream>
-#include <set>
+#include <string>
+#include <vector>
 
 #include "absl/strings/string_view.h"
 #include "common/analysis/lint_rule_status.h"
@@ -38,7 +39,7 @@ class ViolationHandler {
   // located at `path`. It can be called multiple times with statuses generated
   // from different files. `base` contains source code from the file.
   virtual void HandleViolations(
-      const std::set<verible::LintViolationWithStatus>& violations,
+      const std::vector<verible::LintViolationWithStatus>& violations,
       absl::string_view base, absl::string_view path) = 0;
 };
 
@@ -49,7 +50,7 @@ class ViolationPrinter : public ViolationHandler {
   explicit ViolationPrinter(std::ostream* stream) : stream_(stream) {}
 
   void HandleViolations(
-      const std::set<verible::LintViolationWithStatus>& violations,
+      const std::vector<verible::LintViolationWithStatus>& violations,
       absl::string_view base, absl::string_view path) override;
 
  protected:
@@ -57,6 +58,26 @@ class ViolationPrinter : public ViolationHandler {
   verible::LintStatusFormatter* formatter_ = nullptr;
 };
 
+// ViolationHandler that writes each violation as one compact JSON object per
+// line (JSON Lines), for tools that collect the results of many files
+// without parsing the messages.  Lines and columns are 1-based, like in
+// the messages of ViolationPrinter, and the end is exclusive:
+//   {"file":"a.sv","line":3,"column":5,"end_line":3,"end_column":9,
+//    "rule":"no-tabs","reason":"...","url":"...","autofix":false}
+// Nothing is kept between calls, so any number of files can be handled in
+// constant memory.
+class ViolationJsonLinesPrinter : public ViolationHandler {
+ public:
+  explicit ViolationJsonLinesPrinter(std::ostream* stream) : stream_(stream) {}
+
+  void HandleViolations(
+      const std::vector<verible::LintViolationWithStatus>& violations,
+      absl::string_view base, absl::string_view path) override;
+
+ private:
+  std::ostream* const stream_;
+};
+
 // ViolationHandler that prints all violations in a format required by
 // --waiver_files flag
 class ViolationWaiverPrinter : public ViolationHandler {
@@ -66,7 +87,7 @@ class ViolationWaiverPrinter : public ViolationHandler {
       : message_stream_(message_stream_), waiver_stream_(waiver_stream_) {}
 
   void HandleViolations(
-      const std::set<verible::LintViolationWithStatus>& violations,
+      const std::vector<verible::LintViolationWithStatus>& violations,
       absl::string_view base, absl::string_view path) override;
 
  protected:
@@ -129,9 +150,22 @@ class ViolationFixer : public verible::ViolationHandler {
                        true) {}
 
   void HandleViolations(
-      const std::set<verible::LintViolationWithStatus>& violations,
+      const std::vector<verible::LintViolationWithStatus>& violations,
       absl::string_view base, absl::string_view path) final;
 
+  // Like HandleViolations(), but returns 'base' with the chosen fixes
+  // applied instead of writing it, e.g. to look for follow-on fixes before
+  // CommitFixedContent().
+  std::string FixViolations(
+      const std::vector<verible::LintViolationWithStatus>& violations,
+      absl::string_view base, absl::string_view path);
+
+  // Writes the 'fixed_content' of the file at 'source_path', whose original
+  // content is 'source_content', as a patch or to the file.
+  void CommitFixedContent(absl::string_view source_content,
+                          absl::string_view source_path,
+                          absl::string_view fixed_content) const;
+
  private:
   ViolationFixer(std::ostream* message_stream, std::ostream* patch_stream,
                  const AnswerChooser& answer_chooser, bool is_interactive)
@@ -150,10 +184,6 @@ class ViolationFixer : public verible::ViolationHandler {
   static Answer InteractiveAnswerChooser(
       const verible::LintViolation& violation, absl::string_view rule_name);
 
-  void CommitFixes(absl::string_view source_content,
-                   absl::string_view source_path,
-                   const verible::AutoFix& fix) const;
-
   std::ostream* const message_stream_;
   std::ostream* const patch_stream_;
   const AnswerChooser answer_chooser_;
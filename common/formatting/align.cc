@@ -19,6 +19,7 @@
 #include <iostream>
 #include <iterator>
 #include <map>
+#include <mutex>
 #include <numeric>
 #include <vector>
 
@@ -38,6 +39,7 @@
 #include "common/util/enum_flags.h"
 #include "common/util/iterator_range.h"
 #include "common/util/logging.h"
+#include "common/util/range.h"
 #include "common/util/tree_operations.h"
 #include "common/util/vector_tree.h"
 #include "common/util/vector_tree_iterators.h"
@@ -94,6 +96,14 @@ static int EffectiveLeftBorderWidth(const FormatTokenRange& tokens) {
 
 using ColumnsTreePath = SyntaxTreePath;
 
+// Location of a column in the columns tree.
+struct ColumnLocation {
+  ColumnsTreePath path;
+  // Position of the column in a pre-order traversal of the columns tree,
+  // where the root is 0.
+  int index = 0;
+};
+
 struct AlignmentCell {
   // Slice of format tokens in this cell (may be empty range).
   FormatTokenRange tokens;
@@ -338,6 +348,73 @@ struct AlignedColumnConfiguration {
   return &parent_column->Children().back();
 }
 
+// Appends the shape of the syntax tree 'symbol' (the kinds and tags of its
+// nodes and leaves, including null children) to 'shape', and its leaves in
+// order to 'leaves'.
+static void AppendSyntaxTreeShape(const Symbol* symbol, std::vector<int>* shape,
+                                  std::vector<const SyntaxTreeLeaf*>* leaves) {
+  enum ShapeMarker { kNull, kLeaf, kNode };
+  if (symbol == nullptr) {
+    shape->push_back(kNull);
+    return;
+  }
+  if (symbol->Kind() == SymbolKind::kLeaf) {
+    shape->insert(shape->end(), {kLeaf, symbol->Tag().tag});
+    leaves->push_back(&SymbolCastToLeaf(*symbol));
+    return;
+  }
+  const auto& children = SymbolCastToNode(*symbol).children();
+  shape->insert(shape->end(), {kNode, symbol->Tag().tag,
+                               static_cast<int>(children.size())});
+  for (const auto& child : children) {
+    AppendSyntaxTreeShape(child.get(), shape, leaves);
+  }
+}
+
+ColumnPositionTree ColumnSchemaCache::FindOrScan(
+    const Symbol& origin, const std::function<ColumnPositionTree()>& scan) {
+  std::vector<int> shape;
+  std::vector<const SyntaxTreeLeaf*> leaves;
+  AppendSyntaxTreeShape(&origin, &shape, &leaves);
+  {
+    const std::lock_guard<std::mutex> l(lock_);
+    const auto found = entries_.find(shape);
+    if (found != entries_.end()) {
+      ColumnPositionTree columns(found->second.columns);
+      auto starting_leaf = found->second.starting_leaves.begin();
+      for (auto& column : columns.Children()) {
+        ApplyPreOrder(column, [&](ColumnPositionEntry& entry) {
+          entry.starting_token = leaves[*starting_leaf++]->get();
+        });
+      }
+      return columns;
+    }
+  }
+
+  ColumnPositionTree columns = scan();
+  CachedColumns cached{columns, {}};
+  bool all_found = true;
+  for (const auto& column : columns.Children()) {
+    ApplyPreOrder(column, [&](const ColumnPositionEntry& entry) {
+      const auto leaf = std::find_if(
+          leaves.begin(), leaves.end(), [&entry](const SyntaxTreeLeaf* leaf) {
+            // Unlike TokenInfo::operator==, this also tells EOF tokens apart.
+            return leaf->get().token_enum() ==
+                       entry.starting_token.token_enum() &&
+                   BoundsEqual(leaf->get().text(), entry.starting_token.text());
+          });
+      all_found &= leaf != leaves.end();
+      cached.starting_leaves.push_back(std::distance(leaves.begin(), leaf));
+    });
+  }
+  // Columns that start outside of the origin tree can't be re-bound.
+  if (all_found) {
+    const std::lock_guard<std::mutex> l(lock_);
+    entries_.emplace(std::move(shape), std::move(cached));
+  }
+  return columns;
+}
+
 struct AggregateColumnData {
   AggregateColumnData() = default;
 
@@ -372,13 +449,16 @@ class ColumnSchemaAggregator {
   void Finalize() {
     syntax_to_columns_map_.clear();
 
+    int index = 0;
     for (auto& node : VectorTreePreOrderTraversal(columns_)) {
       if (node.Parent()) {
         // Index the column
         auto it = syntax_to_columns_map_.emplace_hint(
-            syntax_to_columns_map_.end(), node.Value().path, ColumnsTreePath{});
-        verible::Path(node, it->second);
+            syntax_to_columns_map_.end(), node.Value().path, ColumnLocation{});
+        verible::Path(node, it->second.path);
+        it->second.index = index;
       }
+      ++index;
       if (!is_leaf(node)) {
         // Sort subcolumns. This puts negative paths (leading non-tree token
         // columns) before empty, zero, and positive ones.
@@ -395,7 +475,7 @@ class ColumnSchemaAggregator {
     }
   }
 
-  const std::map<SyntaxTreePath, ColumnsTreePath>& SyntaxToColumnsMap() const {
+  const std::map<SyntaxTreePath, ColumnLocation>& SyntaxToColumnsMap() const {
     return syntax_to_columns_map_;
   }
 
@@ -420,14 +500,14 @@ class ColumnSchemaAggregator {
         aggregate_column->Children().emplace_back();
         aggregate_subcolumn = &aggregate_column->Children().back();
         // Put aggregate column node's path in created index entry
-        verible::Path(*aggregate_subcolumn, index_entry->second);
+        verible::Path(*aggregate_subcolumn, index_entry->second.path);
       } else {
         // Fact: existing aggregate_subcolumn is a direct child of
         // aggregate_column
         CHECK_GT(static_cast<int>(aggregate_column->Children().size()),
-                 index_entry->second.back());
+                 index_entry->second.path.back());
         aggregate_subcolumn =
-            &aggregate_column->Children()[index_entry->second.back()];
+            &aggregate_column->Children()[index_entry->second.path.back()];
       }
       aggregate_subcolumn->Value().Import(subcolumn.Value());
       CollectColumnsTree(subcolumn, aggregate_subcolumn);
@@ -438,8 +518,8 @@ class ColumnSchemaAggregator {
   // The nodes are sets of starting tokens, from which token ranges will be
   // computed per cell.
   VectorTree<AggregateColumnData> columns_;
-  // 1:1 map between syntax tree's path and columns tree's path
-  std::map<SyntaxTreePath, ColumnsTreePath> syntax_to_columns_map_;
+  // 1:1 map between syntax tree's path and columns tree's location
+  std::map<SyntaxTreePath, ColumnLocation> syntax_to_columns_map_;
 };
 
 // CellLabelGetterFunc which creates a label with column's path relative to
@@ -527,61 +607,96 @@ struct AlignmentRowData {
   ColumnPositionTree sparse_columns;
 };
 
-static void FillAlignmentRow(
-    const AlignmentRowData& row_data,
-    const std::map<SyntaxTreePath, ColumnsTreePath>& columns_map,
-    AlignmentRow* row) {
-  const auto& sparse_columns(row_data.sparse_columns);
-  FormatTokenRange remaining_tokens_range(row_data.ftoken_range);
-
-  FormatTokenRange* prev_cell_tokens = nullptr;
-  if (!is_leaf(sparse_columns)) {
-    for (const auto& col : VectorTreeLeavesTraversal(sparse_columns)) {
-      const auto column_loc_iter = columns_map.find(col.Value().path);
-      CHECK(column_loc_iter != columns_map.end());
+// A cell of an alignment row that corresponds to one of the row's sparse
+// columns.  Only these cells can span tokens; all other cells of the row
+// remain empty and have zero width.
+struct UsedAlignmentCell {
+  AlignmentRow* cell;
+  // Pre-order index of the cell's column in the columns tree.
+  int column_index;
+  // Index of the parent cell among the row's used cells, or -1 for the row.
+  int parent;
+};
 
+// Used cells of a row, in pre-order, starting with the row itself.
+using UsedAlignmentCells = std::vector<UsedAlignmentCell>;
+
+static void FillAlignmentRowCells(
+    const ColumnPositionTree& sparse_column,
+    const std::map<SyntaxTreePath, ColumnLocation>& columns_map, int parent,
+    FormatTokenRange* remaining_tokens_range,
+    FormatTokenRange** prev_cell_tokens, UsedAlignmentCells* used_cells) {
+  for (const auto& col : sparse_column.Children()) {
+    const auto column_loc_iter = columns_map.find(col.Value().path);
+    CHECK(column_loc_iter != columns_map.end());
+    // The columns tree is the union of all rows' sparse columns, so the
+    // column of a subcolumn is a subcolumn of its parent's column.
+    AlignmentRow& row_cell =
+        (*used_cells)[parent]
+            .cell->Children()[column_loc_iter->second.path.back()];
+    used_cells->push_back({&row_cell, column_loc_iter->second.index, parent});
+
+    if (is_leaf(col)) {
       const auto token_iter = std::find_if(
-          remaining_tokens_range.begin(), remaining_tokens_range.end(),
+          remaining_tokens_range->begin(), remaining_tokens_range->end(),
           [=](const PreFormatToken& ftoken) {
             return BoundsEqual(ftoken.Text(),
                                col.Value().starting_token.text());
           });
-      CHECK(token_iter != remaining_tokens_range.end());
-      remaining_tokens_range.set_begin(token_iter);
+      CHECK(token_iter != remaining_tokens_range->end());
+      remaining_tokens_range->set_begin(token_iter);
 
-      if (prev_cell_tokens != nullptr) prev_cell_tokens->set_end(token_iter);
+      if (*prev_cell_tokens != nullptr) {
+        (*prev_cell_tokens)->set_end(token_iter);
+      }
 
-      AlignmentRow& row_cell = verible::DescendPath(
-          *row, column_loc_iter->second.begin(), column_loc_iter->second.end());
-      row_cell.Value().tokens = remaining_tokens_range;
-      prev_cell_tokens = &row_cell.Value().tokens;
+      row_cell.Value().tokens = *remaining_tokens_range;
+      *prev_cell_tokens = &row_cell.Value().tokens;
+    } else {
+      FillAlignmentRowCells(col, columns_map, used_cells->size() - 1,
+                            remaining_tokens_range, prev_cell_tokens,
+                            used_cells);
     }
   }
 }
 
-// Recursively calculates widths of each cell's subcells and, if needed, updates
-// cell's width to fit all subcells.
-static void UpdateAndPropagateRowCellWidths(AlignmentRow* node) {
-  node->Value().UpdateWidths();
-
-  if (is_leaf(*node)) return;
-
-  int total_width = 0;
-  for (auto& child : node->Children()) {
-    UpdateAndPropagateRowCellWidths(&child);
-    total_width += child.Value().TotalWidth();
-  }
-
-  if (node->Value().tokens.empty()) {
-    node->Value().left_border_width =
-        node->Children().front().Value().left_border_width;
-    node->Value().compact_width = total_width - node->Value().left_border_width;
-  }
+// Assigns token ranges to the cells of 'row' that correspond to the sparse
+// columns of 'row_data', and returns these cells.  This only walks the row's
+// sparse columns, not the whole columns tree.
+static UsedAlignmentCells FillAlignmentRow(
+    const AlignmentRowData& row_data,
+    const std::map<SyntaxTreePath, ColumnLocation>& columns_map,
+    AlignmentRow* row) {
+  UsedAlignmentCells used_cells;
+  used_cells.push_back({row, 0, -1});
+  FormatTokenRange remaining_tokens_range(row_data.ftoken_range);
+  FormatTokenRange* prev_cell_tokens = nullptr;
+  FillAlignmentRowCells(row_data.sparse_columns, columns_map, 0,
+                        &remaining_tokens_range, &prev_cell_tokens,
+                        &used_cells);
+  return used_cells;
 }
 
-static void ComputeRowCellWidths(AlignmentRow* row) {
+// Calculates widths of each used cell and, if needed, updates a cell's width
+// to fit all its subcells.  Unused cells keep their zero widths.
+static void ComputeRowCellWidths(AlignmentRow* row,
+                                 const UsedAlignmentCells& used_cells) {
   VLOG(2) << __FUNCTION__;
-  UpdateAndPropagateRowCellWidths(row);
+  // Subcells precede their parent cell in reverse pre-order.
+  std::vector<int> subcells_width(used_cells.size(), 0);
+  for (int i = used_cells.size() - 1; i >= 0; --i) {
+    AlignmentRow& node = *used_cells[i].cell;
+    node.Value().UpdateWidths();
+    if (!is_leaf(node) && node.Value().tokens.empty()) {
+      node.Value().left_border_width =
+          node.Children().front().Value().left_border_width;
+      node.Value().compact_width =
+          subcells_width[i] - node.Value().left_border_width;
+    }
+    if (used_cells[i].parent >= 0) {
+      subcells_width[used_cells[i].parent] += node.Value().TotalWidth();
+    }
+  }
 
   // Force leftmost table border to be 0 because these cells start new lines
   // and thus should not factor into alignment calculation.
@@ -596,59 +711,68 @@ static void ComputeRowCellWidths(AlignmentRow* row) {
 
 using AlignedFormattingColumnSchema = VectorTree<AlignedColumnConfiguration>;
 
+// Computes max widths per column from the used cells of all rows.  Unused
+// cells have zero width and do not affect column widths, so this takes time
+// proportional to the number of used cells, not rows times columns.
 static AlignedFormattingColumnSchema ComputeColumnWidths(
-    const AlignmentMatrix& matrix,
+    const std::vector<UsedAlignmentCells>& used_cells,
     const VectorTree<AlignmentColumnProperties>& column_properties) {
   VLOG(2) << __FUNCTION__;
 
   AlignedFormattingColumnSchema column_configs =
       Transform<AlignedFormattingColumnSchema>(
-          matrix.front(),
-          [](const AlignmentRow&) { return AlignedColumnConfiguration{}; });
+          column_properties, [](const VectorTree<AlignmentColumnProperties>&) {
+            return AlignedColumnConfiguration{};
+          });
+
+  // Columns in pre-order, indexed like UsedAlignmentCell::column_index.
+  std::vector<AlignedColumnConfiguration*> columns;
+  for (auto& node : VectorTreePreOrderTraversal(column_configs)) {
+    columns.push_back(&node.Value());
+  }
+  std::vector<const AlignmentColumnProperties*> properties;
+  for (const auto& node : VectorTreePreOrderTraversal(column_properties)) {
+    properties.push_back(&node.Value());
+  }
 
   // Check which cell before delimiter is the longest
   // If this cell is in the last row, the sizes of column with delimiter
   // must be set to 0
+  int column_before_delimiter = -1;
+  for (size_t i = 1; i < properties.size(); ++i) {
+    if (properties[i]->contains_delimiter) {
+      column_before_delimiter = i - 1;
+      break;
+    }
+  }
   int longest_cell_before_delimiter = 0;
   bool align_to_last_row = false;
-  for (const AlignmentRow& row : matrix) {
-    auto column_prop_iter =
-        VectorTreePreOrderTraversal(column_properties).begin();
-    const auto column_prop_end =
-        VectorTreePreOrderTraversal(column_properties).end();
-    for (const auto& node : VectorTreePreOrderTraversal(row)) {
-      const auto next_prop = std::next(column_prop_iter, 1);
-      if (next_prop != column_prop_end &&
-          next_prop->Value().contains_delimiter) {
-        if (longest_cell_before_delimiter < node.Value().TotalWidth()) {
-          longest_cell_before_delimiter = node.Value().TotalWidth();
-          if (&row == &matrix.back()) align_to_last_row = true;
+  if (column_before_delimiter >= 0) {
+    for (const auto& row_cells : used_cells) {
+      for (const auto& used : row_cells) {
+        if (used.column_index != column_before_delimiter) continue;
+        const int width = used.cell->Value().TotalWidth();
+        if (longest_cell_before_delimiter < width) {
+          longest_cell_before_delimiter = width;
+          if (&row_cells == &used_cells.back()) align_to_last_row = true;
         }
         break;
       }
-      ++column_prop_iter;
     }
   }
 
-  for (const AlignmentRow& row : matrix) {
-    auto column_iter = VectorTreePreOrderTraversal(column_configs).begin();
-    auto column_prop_iter =
-        VectorTreePreOrderTraversal(column_properties).begin();
-
-    for (const auto& node : VectorTreePreOrderTraversal(row)) {
-      if (column_prop_iter->Value().contains_delimiter && align_to_last_row) {
-        column_iter->Value().width = 0;
-        column_iter->Value().left_border = 0;
-      } else {
-        column_iter->Value().UpdateFromCell(node.Value());
-        if (column_prop_iter->Value().left_border_override !=
-            verible::AlignmentColumnProperties::kNoBorderOverride) {
-          column_iter->Value().left_border =
-              column_prop_iter->Value().left_border_override;
-        }
-      }
-      ++column_iter;
-      ++column_prop_iter;
+  for (const auto& row_cells : used_cells) {
+    for (const auto& used : row_cells) {
+      columns[used.column_index]->UpdateFromCell(used.cell->Value());
+    }
+  }
+  for (size_t i = 0; i < columns.size(); ++i) {
+    if (properties[i]->contains_delimiter && align_to_last_row) {
+      columns[i]->width = 0;
+      columns[i]->left_border = 0;
+    } else if (properties[i]->left_border_override !=
+               verible::AlignmentColumnProperties::kNoBorderOverride) {
+      columns[i]->left_border = properties[i]->left_border_override;
     }
   }
 
@@ -889,11 +1013,10 @@ AlignablePartitionGroup::CalculateAlignmentSpacings(
         [](const auto& a, const auto& b) {
           return CompareSyntaxTreePath(a.Value().path, b.Value().path) < 0;
         });
-    const AlignmentRowData row_data{
+    alignment_row_data.push_back(AlignmentRowData{
         // Extract the range of format tokens whose spacings should be adjusted.
-        unwrapped_line.TokensRange(), std::move(sparse_columns)};
-
-    alignment_row_data.emplace_back(row_data);
+        unwrapped_line.TokensRange(), std::move(sparse_columns)});
+    const AlignmentRowData& row_data = alignment_row_data.back();
     VLOG(2) << "Row sparse columns:\n" << row_data.sparse_columns;
 
     // Aggregate union of all column keys (syntax tree paths).
@@ -908,7 +1031,12 @@ AlignablePartitionGroup::CalculateAlignmentSpacings(
   // effectively width 0.
   VLOG(2) << "Filling dense matrix from sparse representation";
   result.matrix.resize(rows.size());
+  std::vector<UsedAlignmentCells> used_cells;
+  used_cells.reserve(rows.size());
   {
+    const AlignmentRow empty_row = Transform<AlignmentRow>(
+        column_schema.Columns(),
+        [](const VectorTree<AggregateColumnData>&) { return AlignmentCell{}; });
     auto row_data_iter = alignment_row_data.cbegin();
     for (auto& row : result.matrix) {
       VLOG(3) << "Row tokens: "
@@ -916,14 +1044,10 @@ AlignablePartitionGroup::CalculateAlignmentSpacings(
                      FormatTokenRange(row_data_iter->ftoken_range.begin(),
                                       row_data_iter->ftoken_range.end()));
 
-      row = Transform<AlignmentRow>(column_schema.Columns(),
-                                    [](const VectorTree<AggregateColumnData>&) {
-                                      return AlignmentCell{};
-                                    });
-
-      FillAlignmentRow(*row_data_iter, column_schema.SyntaxToColumnsMap(),
-                       &row);
-      ComputeRowCellWidths(&row);
+      row = empty_row;
+      used_cells.push_back(FillAlignmentRow(
+          *row_data_iter, column_schema.SyntaxToColumnsMap(), &row));
+      ComputeRowCellWidths(&row, used_cells.back());
       VLOG(2) << "Filled row:\n" << row;
 
       ++row_data_iter;
@@ -935,7 +1059,7 @@ AlignablePartitionGroup::CalculateAlignmentSpacings(
 
   // Compute max widths per column.
   VectorTree<AlignedColumnConfiguration> column_configs(
-      ComputeColumnWidths(result.matrix, column_properties));
+      ComputeColumnWidths(used_cells, column_properties));
 
   VLOG(2) << "Column widths:\n" << column_configs;
 
@@ -980,7 +1104,7 @@ AlignablePartitionGroup::CalculateAlignmentSpacings(
 
 // This applies pre-calculated alignment spacings to aligned groups of format
 // tokens.
-void AlignablePartitionGroup::ApplyAlignment(
+void AlignablePartitionGroup::ApplyAlignmentActions(
     const GroupAlignmentData& align_data) const {
   auto row = alignable_rows_.begin();
   for (const auto& align_actions : align_data.align_actions_2D) {
@@ -1217,33 +1341,43 @@ void FormatUsingOriginalSpacing(TokenPartitionRange partition_range) {
 }
 
 void AlignablePartitionGroup::Align(int column_limit) const {
+  GroupAlignmentData align_data;
+  const AlignmentPolicy policy = CalculateAlignment(column_limit, &align_data);
+  ApplyAlignment(policy, align_data);
+}
+
+AlignmentPolicy AlignablePartitionGroup::CalculateAlignment(
+    int column_limit, GroupAlignmentData* align_data) const {
   // Compute dry-run of alignment spacings if it is needed.
   AlignmentPolicy policy = alignment_policy_;
   VLOG(2) << "AlignmentPolicy: " << policy;
-  GroupAlignmentData align_data;
   switch (policy) {
     case AlignmentPolicy::kAlign:
     case AlignmentPolicy::kInferUserIntent:
-      align_data = CalculateAlignmentSpacings(
+      *align_data = CalculateAlignmentSpacings(
           alignable_rows_, alignment_cell_scanner_, column_limit);
       break;
     default:
       break;
   }
 
-  const TokenPartitionRange partition_range(Range());
   // If enabled, try to decide automatically based on heurstics.
   if (policy == AlignmentPolicy::kInferUserIntent) {
-    policy = align_data.InferUserIntendedAlignmentPolicy(partition_range);
+    policy = align_data->InferUserIntendedAlignmentPolicy(Range());
     VLOG(2) << "AlignmentPolicy (automatic): " << policy;
   }
+  return policy;
+}
 
+void AlignablePartitionGroup::ApplyAlignment(
+    AlignmentPolicy policy, const GroupAlignmentData& align_data) const {
+  const TokenPartitionRange partition_range(Range());
   // Align or not, depending on user-elected or inferred policy.
   switch (policy) {
     case AlignmentPolicy::kAlign: {
       if (!align_data.align_actions_2D.empty()) {
         // This modifies format tokens' spacing values.
-        ApplyAlignment(align_data);
+        ApplyAlignmentActions(align_data);
       }
       break;
     }
@@ -1268,6 +1402,31 @@ void TabularAlignTokens(
     const ExtractAlignmentGroupsFunction& extract_alignment_groups,
     TokenPartitionTree* partition_ptr) {
   VLOG(1) << __FUNCTION__;
+  ApplyTabularAlignment(CalculateTabularAlignment(
+      column_limit, full_text, disabled_byte_ranges, extract_alignment_groups,
+      partition_ptr));
+  VLOG(1) << "end of " << __FUNCTION__;
+}
+
+struct TabularAlignment::Group {
+  AlignablePartitionGroup partitions;
+  AlignmentPolicy policy;
+  AlignablePartitionGroup::GroupAlignmentData align_data;
+};
+
+TabularAlignment::TabularAlignment() = default;
+TabularAlignment::~TabularAlignment() = default;
+TabularAlignment::TabularAlignment(TabularAlignment&&) noexcept = default;
+TabularAlignment& TabularAlignment::operator=(TabularAlignment&&) noexcept =
+    default;
+
+TabularAlignment CalculateTabularAlignment(
+    int column_limit, absl::string_view full_text,
+    const ByteOffsetSet& disabled_byte_ranges,
+    const ExtractAlignmentGroupsFunction& extract_alignment_groups,
+    TokenPartitionTree* partition_ptr) {
+  VLOG(1) << __FUNCTION__;
+  TabularAlignment result;
   // Each subpartition is presumed to correspond to a list element or
   // possibly some other ignored element like comments.
 
@@ -1276,20 +1435,25 @@ void TabularAlignTokens(
   // Identify groups of partitions to align, separated by blank lines.
   const TokenPartitionRange subpartitions_range(subpartitions.begin(),
                                                 subpartitions.end());
-  if (subpartitions_range.empty()) return;
+  if (subpartitions_range.empty()) return result;
   VLOG(2) << "extracting alignment partition groups...";
-  const std::vector<AlignablePartitionGroup> alignment_groups(
+  std::vector<AlignablePartitionGroup> alignment_groups(
       extract_alignment_groups(subpartitions_range));
-  for (const auto& alignment_group : alignment_groups) {
+  result.groups_.reserve(alignment_groups.size());
+  for (auto& alignment_group : alignment_groups) {
     const TokenPartitionRange partition_range(alignment_group.Range());
     if (partition_range.empty()) continue;
+    result.groups_.push_back({std::move(alignment_group),
+                              AlignmentPolicy::kPreserve,
+                              AlignablePartitionGroup::GroupAlignmentData()});
+    auto& group = result.groups_.back();
     if (AnyPartitionSubRangeIsDisabled(partition_range, full_text,
                                        disabled_byte_ranges)) {
       // Within an aligned group, if the group is partially disabled
       // due to incremental formatting, then leave the new lines
       // unformatted rather than falling back to compact-left formatting.
       // However, allow the first token to be correctly indented.
-      FormatUsingOriginalSpacing(partition_range);
+      // (Preserving is done by FormatUsingOriginalSpacing().)
       continue;
 
       // TODO(fangism): instead of disabling the whole range, sub-partition
@@ -1300,10 +1464,18 @@ void TabularAlignTokens(
       // TODO(b/159824483): attempt to detect and re-use pre-existing alignment
     }
 
-    // Calculate alignment and possibly apply it depending on alignment policy.
-    alignment_group.Align(column_limit);
+    // Calculate alignment, to be applied depending on alignment policy.
+    group.policy =
+        group.partitions.CalculateAlignment(column_limit, &group.align_data);
   }
   VLOG(1) << "end of " << __FUNCTION__;
+  return result;
+}
+
+void ApplyTabularAlignment(const TabularAlignment& alignment) {
+  for (const auto& group : alignment.groups_) {
+    group.partitions.ApplyAlignment(group.policy, group.align_data);
+  }
 }
 
 std::vector<TaggedTokenPartitionRange>
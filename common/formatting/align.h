@@ -16,8 +16,11 @@
 #define VERIBLE_COMMON_FORMATTING_ALIGN_H_
 
 #include <functional>
+#include <memory>
+#include <mutex>
 #include <vector>
 
+#include "absl/container/flat_hash_map.h"
 #include "absl/strings/string_view.h"
 #include "common/formatting/format_token.h"
 #include "common/formatting/token_partition_tree.h"
@@ -135,6 +138,36 @@ class ColumnSchemaScanner : public TreeContextPathVisitor {
   ColumnPositionTree sparse_columns_;
 };
 
+// Caches the columns that ColumnSchemaScanners find in rows, keyed by the
+// shape of the rows' Origin() syntax trees: the tags of all of their nodes and
+// leaves.  Generated code often repeats the same row shape many times, e.g.
+// port connections that differ only in their identifiers; of those, only the
+// first row is scanned, the others get a copy of its columns with the starting
+// tokens re-bound to their own leaves.
+// This requires that scanners decide columns only from the syntax tree shape
+// (not from token text), like ColumnSchemaScanner subclasses do, and that all
+// rows in one cache are scanned by the same kind of scanner.
+// Thread-safe.
+class ColumnSchemaCache {
+ public:
+  // Returns the columns of a row with syntax tree 'origin': a copy of the
+  // cached columns of its shape, or else the result of 'scan', which is then
+  // cached.
+  ColumnPositionTree FindOrScan(
+      const Symbol& origin, const std::function<ColumnPositionTree()>& scan);
+
+ private:
+  struct CachedColumns {
+    ColumnPositionTree columns;
+    // Indices of the starting tokens of 'columns' (in pre-order, excluding the
+    // root) among the leaves of the origin tree.
+    std::vector<int> starting_leaves;
+  };
+
+  std::mutex lock_;
+  absl::flat_hash_map<std::vector<int>, CachedColumns> entries_;
+};
+
 // This enum signals to the GetPartitionAlignmentSubranges() function
 // how a token partition should be included or excluded in partition groups.
 enum class AlignmentGroupAction {
@@ -269,15 +302,29 @@ class AlignablePartitionGroup {
 
   // This executes alignment, depending on the alignment_policy.
   // 'column_limit' is the maximum text width allowed post-alignment.
+  // This is CalculateAlignment() followed by ApplyAlignment().
   void Align(int column_limit) const;
 
- private:
+  // Alignment spacings, calculated by CalculateAlignment().
   struct GroupAlignmentData;
+
+  // Calculates alignment spacings into 'align_data', and returns the policy
+  // to apply them with (never kInferUserIntent).  This only reads the rows,
+  // so groups with different rows can be calculated concurrently.
+  AlignmentPolicy CalculateAlignment(int column_limit,
+                                     GroupAlignmentData* align_data) const;
+
+  // Modifies the rows according to 'policy' and 'align_data' returned by
+  // CalculateAlignment().
+  void ApplyAlignment(AlignmentPolicy policy,
+                      const GroupAlignmentData& align_data) const;
+
+ private:
   static GroupAlignmentData CalculateAlignmentSpacings(
       const std::vector<TokenPartitionIterator>& rows,
       const AlignmentCellScannerFunction& cell_scanner_gen, int column_limit);
 
-  void ApplyAlignment(const GroupAlignmentData& align_data) const;
+  void ApplyAlignmentActions(const GroupAlignmentData& align_data) const;
 
  private:
   // The set of partitions to treat as rows for tabular alignment.
@@ -349,6 +396,22 @@ ColumnPositionTree ScanPartitionForAlignmentCells(
       row, [] { return ScannerType(); });
 }
 
+// Same as above, but reuses the columns of earlier rows with the same syntax
+// tree shape from 'cache' (if not null).
+template <class ScannerType>
+ColumnPositionTree ScanPartitionForAlignmentCells(
+    const TokenPartitionTree& row,
+    const std::function<ScannerType(void)>& scanner_factory,
+    ColumnSchemaCache* cache) {
+  const Symbol* origin = row.Value().Origin();
+  if (cache == nullptr || origin == nullptr) {
+    return ScanPartitionForAlignmentCells<ScannerType>(row, scanner_factory);
+  }
+  return cache->FindOrScan(*origin, [&row, &scanner_factory] {
+    return ScanPartitionForAlignmentCells<ScannerType>(row, scanner_factory);
+  });
+}
+
 using NonTreeTokensScannerFunction = std::function<void(
     FormatTokenRange, FormatTokenRange, ColumnPositionTree*)>;
 
@@ -365,14 +428,17 @@ using NonTreeTokensScannerFunction = std::function<void(
 // Returns a concatenated sequence of column entries for tokens from SyntaxTree
 // and TokenPartitionTree that will be uniquified and ordered for alignment
 // purposes.
+// If 'cache' is not null, the columns from the SyntaxTree are reused from
+// earlier rows of the same shape.
 template <class ScannerType>
 ColumnPositionTree ScanPartitionForAlignmentCells_WithNonTreeTokens(
     const TokenPartitionTree& row,
     const std::function<ScannerType(void)>& scanner_factory,
-    const NonTreeTokensScannerFunction& non_tree_column_scanner) {
+    const NonTreeTokensScannerFunction& non_tree_column_scanner,
+    ColumnSchemaCache* cache = nullptr) {
   // re-use existing scanner
   ColumnPositionTree column_entries =
-      ScanPartitionForAlignmentCells<ScannerType>(row, scanner_factory);
+      ScanPartitionForAlignmentCells<ScannerType>(row, scanner_factory, cache);
 
   const UnwrappedLine& unwrapped_line = row.Value();
   const auto ftokens = unwrapped_line.TokensRange();
@@ -455,11 +521,16 @@ AlignmentCellScannerFunction AlignmentCellScannerGenerator() {
   };
 }
 
+// The scanners returned by the following overloads, which take a
+// 'scanner_factory', reuse the columns of rows with the same syntax tree shape
+// (see ColumnSchemaCache), as long as they live.
 template <class ScannerType>
 AlignmentCellScannerFunction AlignmentCellScannerGenerator(
     const std::function<ScannerType(void)>& scanner_factory) {
-  return [scanner_factory](const TokenPartitionTree& row) {
-    return ScanPartitionForAlignmentCells<ScannerType>(row, scanner_factory);
+  auto cache = std::make_shared<ColumnSchemaCache>();
+  return [scanner_factory, cache](const TokenPartitionTree& row) {
+    return ScanPartitionForAlignmentCells<ScannerType>(row, scanner_factory,
+                                                       cache.get());
   };
 }
 
@@ -479,10 +550,11 @@ template <class ScannerType>
 AlignmentCellScannerFunction AlignmentCellScannerGenerator(
     const std::function<ScannerType(void)> scanner_factory,
     const NonTreeTokensScannerFunction& non_tree_column_scanner) {
-  return [scanner_factory,
-          non_tree_column_scanner](const TokenPartitionTree& row) {
+  auto cache = std::make_shared<ColumnSchemaCache>();
+  return [scanner_factory, non_tree_column_scanner,
+          cache](const TokenPartitionTree& row) {
     return ScanPartitionForAlignmentCells_WithNonTreeTokens<ScannerType>(
-        row, scanner_factory, non_tree_column_scanner);
+        row, scanner_factory, non_tree_column_scanner, cache.get());
   };
 }
 
@@ -538,6 +610,42 @@ void TabularAlignTokens(
     const ExtractAlignmentGroupsFunction& extract_alignment_groups,
     TokenPartitionTree* partition_ptr);
 
+// Alignment of the groups of one partition, calculated by
+// CalculateTabularAlignment() and applied by ApplyTabularAlignment().
+class TabularAlignment {
+ public:
+  TabularAlignment();
+  ~TabularAlignment();
+
+  TabularAlignment(TabularAlignment&&) noexcept;
+  TabularAlignment& operator=(TabularAlignment&&) noexcept;
+
+ private:
+  friend TabularAlignment CalculateTabularAlignment(
+      int, absl::string_view, const ByteOffsetSet&,
+      const ExtractAlignmentGroupsFunction&, TokenPartitionTree*);
+  friend void ApplyTabularAlignment(const TabularAlignment&);
+
+  struct Group;
+  std::vector<Group> groups_;
+};
+
+// First step of TabularAlignTokens(), with the same parameters: calculates
+// the alignment of 'partition_ptr', without modifying the partition or its
+// tokens.  Calculations of partitions that don't contain one another can run
+// concurrently.
+// The result refers to subpartitions of 'partition_ptr', so the partition must
+// not be modified until the result is applied.
+TabularAlignment CalculateTabularAlignment(
+    int column_limit, absl::string_view full_text,
+    const ByteOffsetSet& disabled_byte_ranges,
+    const ExtractAlignmentGroupsFunction& extract_alignment_groups,
+    TokenPartitionTree* partition_ptr);
+
+// Second step of TabularAlignTokens(): modifies the partition 'alignment'
+// was calculated for.
+void ApplyTabularAlignment(const TabularAlignment& alignment);
+
 }  // namespace verible
 
 #endif  // VERIBLE_COMMON_FORMATTING_ALIGN_H_
@@ -27,6 +27,7 @@
 #include "common/text/tree_builder_test_util.h"
 #include "common/util/range.h"
 #include "common/util/spacer.h"
+#include "common/util/tree_operations.h"
 #include "common/util/value_saver.h"
 #include "gmock/gmock.h"
 #include "gtest/gtest.h"
@@ -245,6 +246,22 @@ TEST_F(Sparse3x3MatrixAlignmentTest, ZeroInterTokenPadding) {
             "five six\n");
 }
 
+TEST_F(Sparse3x3MatrixAlignmentTest, CalculateThenApplyAlignment) {
+  const TabularAlignment alignment = CalculateTabularAlignment(
+      40, sample_, ByteOffsetSet(), kDefaultAlignmentHandler, &partition_);
+  // Calculation doesn't modify the partitions.
+  for (const auto& child : partition_.Children()) {
+    EXPECT_NE(child.Value().PartitionPolicy(),
+              PartitionPolicyEnum::kAlreadyFormatted);
+    EXPECT_TRUE(child.Children().empty());
+  }
+  ApplyTabularAlignment(alignment);
+  EXPECT_EQ(Render(),  //
+            "     onetwo\n"
+            "three   four\n"
+            "five six\n");
+}
+
 TEST_F(Sparse3x3MatrixAlignmentTest, AlignmentPolicyFlushLeft) {
   TabularAlignTokens(40, sample_, ByteOffsetSet(), kFlushLeftAlignmentHandler,
                      &partition_);
@@ -527,6 +544,50 @@ TEST_F(Sparse3x3MatrixAlignmentTest, DisabledByColumnLimitIndented) {
             "five six\n");
 }
 
+// Each row uses a different column, so most cells of the matrix are unused.
+class DiagonalMatrixAlignmentTest : public MatrixTreeAlignmentTestFixture {
+ public:
+  DiagonalMatrixAlignmentTest() : MatrixTreeAlignmentTestFixture("a bb c dd") {
+    //   | a |    |   |    |
+    //   |   | bb |   |    |
+    //   |   |    | c |    |
+    //   |   |    |   | dd |
+    syntax_tree_ = TNode(1,                                      //
+                         TNode(2, Leaf(1, tokens_[0])),          //
+                         TNode(2, nullptr, Leaf(1, tokens_[1])),  //
+                         TNode(2, nullptr, nullptr, Leaf(1, tokens_[2])),
+                         TNode(2, nullptr, nullptr, nullptr,  //
+                               Leaf(1, tokens_[3])));
+    const auto begin = pre_format_tokens_.begin();
+    UnwrappedLine all(0, begin);
+    all.SpanUpToToken(pre_format_tokens_.end());
+    all.SetOrigin(&*syntax_tree_);
+    partition_ = TokenPartitionTree{all};
+    for (size_t i = 0; i < 4; ++i) {
+      UnwrappedLine child(0, begin + i);
+      child.SpanUpToToken(begin + i + 1);
+      child.SetOrigin(DescendPath(*syntax_tree_, {i}));
+      partition_.Children().emplace_back(child);
+    }
+  }
+};
+
+TEST_F(DiagonalMatrixAlignmentTest, OneInterTokenPadding) {
+  // Require 1 space between tokens.
+  for (auto& ftoken : pre_format_tokens_) {
+    ftoken.before.spaces_required = 1;
+  }
+
+  TabularAlignTokens(40, sample_, ByteOffsetSet(), kDefaultAlignmentHandler,
+                     &partition_);
+
+  EXPECT_EQ(Render(),  //
+            "a\n"
+            "  bb\n"
+            "     c\n"
+            "       dd\n");
+}
+
 class MultiAlignmentGroupTest : public AlignmentTestFixture {
  public:
   MultiAlignmentGroupTest()
@@ -1371,6 +1432,51 @@ TEST_F(SubcolumnsTreeWithDelimitersTest, ContainsDelimiterTest) {
             "(Five Six   )\n");
 }
 
+class ColumnSchemaCacheTest : public SubcolumnsTreeAlignmentTest {
+ public:
+  ColumnSchemaCacheTest()
+      : SubcolumnsTreeAlignmentTest(
+            "( one two )\n"
+            "( three four )\n"
+            "( five ( six ) )\n") {}
+};
+
+// Returns the paths and starting token texts of all 'columns'.
+static std::vector<std::pair<SyntaxTreePath, const char*>> ColumnStarts(
+    const ColumnPositionTree& columns) {
+  std::vector<std::pair<SyntaxTreePath, const char*>> starts;
+  for (const auto& column : columns.Children()) {
+    ApplyPreOrder(column, [&starts](const ColumnPositionEntry& entry) {
+      starts.emplace_back(entry.path, entry.starting_token.text().data());
+    });
+  }
+  return starts;
+}
+
+TEST_F(ColumnSchemaCacheTest, ReusesColumnsOfSameSyntaxTreeShape) {
+  using Scanner = SyntaxTreeColumnizer<FlushLeft>;
+  int scans = 0;
+  const std::function<Scanner()> scanner_factory = [&scans] {
+    ++scans;
+    return Scanner();
+  };
+  ColumnSchemaCache cache;
+  const auto& rows = partition_.Children();
+  std::vector<ColumnPositionTree> cached_columns;
+  for (const auto& row : rows) {
+    cached_columns.push_back(ScanPartitionForAlignmentCells<Scanner>(
+        row, scanner_factory, &cache));
+  }
+  // The second row has the same shape as the first one.
+  EXPECT_EQ(scans, 2);
+
+  for (size_t i = 0; i < rows.size(); ++i) {
+    const ColumnPositionTree columns =
+        ScanPartitionForAlignmentCells<Scanner>(rows[i], scanner_factory);
+    EXPECT_EQ(ColumnStarts(cached_columns[i]), ColumnStarts(columns)) << i;
+  }
+}
+
 template <class Tree>
 struct ColumnsTreeFormatterTestCase {
   Tree input;
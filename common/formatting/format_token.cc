@@ -25,7 +25,6 @@
 #include "common/text/token_info.h"
 #include "common/util/iterator_adaptors.h"
 #include "common/util/logging.h"
-#include "common/util/spacer.h"
 
 namespace verible {
 
@@ -153,28 +152,63 @@ absl::string_view FormattedToken::OriginalLeadingSpaces() const {
 }
 
 std::ostream& FormattedToken::FormattedText(std::ostream& stream) const {
+  return FormattedLeadingSpaces(stream) << token->text();
+}
+
+std::ostream& FormattedToken::FormattedLeadingSpaces(
+    std::ostream& stream) const {
+  std::string spaces;
+  AppendFormattedLeadingSpaces(&spaces);
+  return stream << spaces;
+}
+
+void FormattedToken::AppendFormattedText(std::string* output) const {
+  AppendFormattedLeadingSpaces(output);
+  output->append(token->text().data(), token->text().length());
+}
+
+void FormattedToken::AppendFormattedLeadingSpaces(std::string* output) const {
   switch (before.action) {
     case SpacingDecision::kPreserve: {
       if (before.preserved_space_start != nullptr) {
         // Calculate string_view range of pre-existing spaces, and print that.
-        stream << OriginalLeadingSpaces();
+        const absl::string_view spaces = OriginalLeadingSpaces();
+        output->append(spaces.data(), spaces.length());
       } else {
         // During testing, we are less interested in Preserve mode due to lack
         // of "original spacing", so fall-back to safe behavior.
-        stream << Spacer(before.spaces);
+        output->append(before.spaces, ' ');
       }
       break;
     }
     case SpacingDecision::kWrap:
       // Never print spaces before a newline.
-      stream << '\n';
+      output->push_back('\n');
+      ABSL_FALLTHROUGH_INTENDED;
+    case SpacingDecision::kAlign:
+    case SpacingDecision::kAppend:
+      output->append(before.spaces, ' ');
+      break;
+  }
+}
+
+size_t FormattedToken::FormattedTextLength() const {
+  size_t length = token->text().length();
+  switch (before.action) {
+    case SpacingDecision::kPreserve:
+      length += before.preserved_space_start != nullptr
+                    ? OriginalLeadingSpaces().length()
+                    : before.spaces;
+      break;
+    case SpacingDecision::kWrap:
+      ++length;  // newline
       ABSL_FALLTHROUGH_INTENDED;
     case SpacingDecision::kAlign:
     case SpacingDecision::kAppend:
-      stream << Spacer(before.spaces);
+      length += before.spaces;
       break;
   }
-  return stream << token->text();
+  return length;
 }
 
 std::ostream& operator<<(std::ostream& stream, const FormattedToken& token) {
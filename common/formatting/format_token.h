@@ -16,6 +16,7 @@
 #define VERIBLE_COMMON_FORMATTING_FORMAT_TOKEN_H_
 
 #include <algorithm>
+#include <cstddef>
 #include <iosfwd>
 #include <string>
 #include <vector>
@@ -223,6 +224,16 @@ struct FormattedToken {
   // Print out formatted result after formatting decision optimization.
   std::ostream& FormattedText(std::ostream&) const;
 
+  // Prints only the spaces that FormattedText() prints before the token.
+  std::ostream& FormattedLeadingSpaces(std::ostream&) const;
+
+  // Same as above, but appending to a string.
+  void AppendFormattedText(std::string* output) const;
+  void AppendFormattedLeadingSpaces(std::string* output) const;
+
+  // Returns the number of characters that FormattedText() prints.
+  size_t FormattedTextLength() const;
+
   // The token this PreFormatToken holds. TokenInfo must outlive this object.
   const TokenInfo* token = nullptr;
 
@@ -0,0 +1,49 @@
+// Copyright 2017-2023 The Verible Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "common/formatting/format_token_arrays.h"
+
+#include "absl/strings/string_view.h"
+#include "common/formatting/format_token.h"
+
+namespace verible {
+
+FormatTokenArrays::FormatTokenArrays(FormatTokenRange tokens)
+    : begin_(tokens.begin()) {
+  const size_t size = tokens.size();
+  lengths_.reserve(size);
+  first_line_lengths_.reserve(size);
+  last_line_lengths_.reserve(size);
+  spaces_required_.reserve(size);
+  break_penalties_.reserve(size);
+  break_decisions_.reserve(size);
+  for (const PreFormatToken& token : tokens) {
+    const absl::string_view text = token.Text();
+    lengths_.push_back(text.length());
+    const size_t first_newline = text.find_first_of('\n');
+    if (first_newline == absl::string_view::npos) {
+      first_line_lengths_.push_back(-1);
+      last_line_lengths_.push_back(-1);
+    } else {
+      first_line_lengths_.push_back(first_newline);
+      last_line_lengths_.push_back(text.length() - text.find_last_of('\n') -
+                                   1);
+    }
+    spaces_required_.push_back(token.before.spaces_required);
+    break_penalties_.push_back(token.before.break_penalty);
+    break_decisions_.push_back(token.before.break_decision);
+  }
+}
+
+}  // namespace verible
@@ -0,0 +1,74 @@
+// Copyright 2017-2023 The Verible Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef VERIBLE_COMMON_FORMATTING_FORMAT_TOKEN_ARRAYS_H_
+#define VERIBLE_COMMON_FORMATTING_FORMAT_TOKEN_ARRAYS_H_
+
+#include <cstddef>
+#include <vector>
+
+#include "common/formatting/format_token.h"
+
+namespace verible {
+
+// FormatTokenArrays holds the properties of a range of PreFormatTokens that
+// line wrap searches read for every search state, as parallel arrays
+// ("structure of arrays"), indexed by the position of the token in the range.
+// Reading them does not go through the PreFormatToken and its TokenInfo, and
+// multi-line token text is scanned for newlines only once.
+// The arrays are a snapshot: later changes to the tokens are not reflected.
+class FormatTokenArrays {
+ public:
+  explicit FormatTokenArrays(FormatTokenRange tokens);
+
+  size_t size() const { return lengths_.size(); }
+
+  // Returns the index of 'token', which must be in the range.
+  size_t Index(FormatTokenRange::const_iterator token) const {
+    return token - begin_;
+  }
+
+  // Length of the token text.
+  int Length(size_t index) const { return lengths_[index]; }
+
+  // Length of the token text before its first newline, or -1 if it has none.
+  int FirstLineLength(size_t index) const { return first_line_lengths_[index]; }
+
+  // Length of the token text after its last newline, or -1 if it has none.
+  int LastLineLength(size_t index) const { return last_line_lengths_[index]; }
+
+  bool IsMultiLine(size_t index) const {
+    return first_line_lengths_[index] >= 0;
+  }
+
+  // Copies of the InterTokenInfo ('before') of each token.
+  int SpacesRequired(size_t index) const { return spaces_required_[index]; }
+  int BreakPenalty(size_t index) const { return break_penalties_[index]; }
+  SpacingOptions BreakDecision(size_t index) const {
+    return break_decisions_[index];
+  }
+
+ private:
+  FormatTokenRange::const_iterator begin_;
+  std::vector<int> lengths_;
+  std::vector<int> first_line_lengths_;
+  std::vector<int> last_line_lengths_;
+  std::vector<int> spaces_required_;
+  std::vector<int> break_penalties_;
+  std::vector<SpacingOptions> break_decisions_;
+};
+
+}  // namespace verible
+
+#endif  // VERIBLE_COMMON_FORMATTING_FORMAT_TOKEN_ARRAYS_H_
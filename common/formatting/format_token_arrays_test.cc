@@ -0,0 +1,74 @@
+// Copyright 2017-2023 The Verible Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "common/formatting/format_token_arrays.h"
+
+#include <vector>
+
+#include "common/formatting/format_token.h"
+#include "common/formatting/unwrapped_line.h"
+#include "common/formatting/unwrapped_line_test_utils.h"
+#include "common/text/token_info.h"
+#include "gtest/gtest.h"
+
+namespace verible {
+namespace {
+
+class FormatTokenArraysTest : public UnwrappedLineMemoryHandler,
+                              public ::testing::Test {};
+
+TEST_F(FormatTokenArraysTest, Empty) {
+  const std::vector<PreFormatToken> tokens;
+  const FormatTokenArrays arrays(
+      FormatTokenRange(tokens.begin(), tokens.end()));
+  EXPECT_EQ(arrays.size(), 0);
+}
+
+TEST_F(FormatTokenArraysTest, CopiesTokenProperties) {
+  CreateTokenInfos({TokenInfo(1, "module"), TokenInfo(2, "/* a\nbc\ndef */"),
+                    TokenInfo(3, "m"), TokenInfo(4, "\n")});
+  UnwrappedLine uwline(0, pre_format_tokens_.begin());
+  AddFormatTokens(&uwline);
+  pre_format_tokens_[1].before.spaces_required = 1;
+  pre_format_tokens_[1].before.break_penalty = 5;
+  pre_format_tokens_[2].before.break_decision = SpacingOptions::kMustWrap;
+  pre_format_tokens_[3].before.break_decision = SpacingOptions::kPreserve;
+
+  const FormatTokenRange range = uwline.TokensRange();
+  const FormatTokenArrays arrays(range);
+  ASSERT_EQ(arrays.size(), 4);
+  for (auto iter = range.begin(); iter != range.end(); ++iter) {
+    const size_t i = arrays.Index(iter);
+    EXPECT_EQ(i, iter - range.begin());
+    EXPECT_EQ(arrays.Length(i), iter->Length()) << i;
+    EXPECT_EQ(arrays.SpacesRequired(i), iter->before.spaces_required) << i;
+    EXPECT_EQ(arrays.BreakPenalty(i), iter->before.break_penalty) << i;
+    EXPECT_EQ(arrays.BreakDecision(i), iter->before.break_decision) << i;
+  }
+
+  EXPECT_FALSE(arrays.IsMultiLine(0));
+  EXPECT_EQ(arrays.FirstLineLength(0), -1);
+  EXPECT_EQ(arrays.LastLineLength(0), -1);
+
+  EXPECT_TRUE(arrays.IsMultiLine(1));
+  EXPECT_EQ(arrays.FirstLineLength(1), 4);  // "/* a"
+  EXPECT_EQ(arrays.LastLineLength(1), 6);   // "def */"
+
+  EXPECT_TRUE(arrays.IsMultiLine(3));
+  EXPECT_EQ(arrays.FirstLineLength(3), 0);
+  EXPECT_EQ(arrays.LastLineLength(3), 0);
+}
+
+}  // namespace
+}  // namespace verible
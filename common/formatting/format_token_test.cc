@@ -522,6 +522,17 @@ TEST(FormattedTokenTest, FormattedText) {
   }
 }
 
+TEST(FormattedTokenTest, FormattedLeadingSpaces) {
+  TokenInfo token(0, "roobar");
+  PreFormatToken ptoken(&token);
+  FormattedToken ftoken(ptoken);
+  ftoken.before.action = SpacingDecision::kWrap;
+  ftoken.before.spaces = 2;
+  std::ostringstream stream;
+  ftoken.FormattedLeadingSpaces(stream);
+  EXPECT_EQ("\n  ", stream.str());
+}
+
 TEST(FormattedTokenTest, OriginalLeadingSpaces) {
   const absl::string_view text("abcdefgh");
   const TokenInfo tok1(1, text.substr(1, 3)), tok2(2, text.substr(5, 2));
@@ -21,7 +21,12 @@
 
 #include <algorithm>
 #include <iomanip>
+#include <iterator>
+#include <memory>
+#include <mutex>
 #include <ostream>
+#include <utility>
+#include <vector>
 
 #include "absl/container/fixed_array.h"
 #include "common/formatting/basic_format_style.h"
@@ -36,13 +41,23 @@
 
 namespace verible {
 
+LayoutFunctionCache::LayoutFunctionCache()
+    : entries_(std::make_unique<Entries>()) {}
+
+LayoutFunctionCache::~LayoutFunctionCache() = default;
+
+int LayoutFunctionCache::size() const { return entries_->layouts.size(); }
+
 void OptimizeTokenPartitionTree(const BasicFormatStyle& style,
-                                TokenPartitionTree* node) {
+                                TokenPartitionTree* node,
+                                LayoutFunctionCache* cache,
+                                LayoutOptimizerStats* stats, ThreadPool* pool) {
   CHECK_NOTNULL(node);
   VLOG(4) << __FUNCTION__ << ", before:\n"
           << verible::TokenPartitionTreePrinter(*node);
 
-  const auto optimizer = TokenPartitionsLayoutOptimizer(style);
+  const auto optimizer =
+      TokenPartitionsLayoutOptimizer(style, cache, stats, pool);
   const auto indentation = node->Value().IndentationSpaces();
   optimizer.Optimize(indentation, node);
 
@@ -107,6 +122,13 @@ int AlreadyFormattedPartitionLength(const TokenPartitionTree& partition) {
 // Largest possible column value, used as infinity.
 constexpr int kInfinity = std::numeric_limits<int>::max();
 
+// Returns number of columns used by 'token' in LayoutItem::Length().
+int TokenLineLength(const PreFormatToken& token) {
+  const auto line_break_pos = token.Text().find('\n');
+  if (line_break_pos != absl::string_view::npos) return line_break_pos;
+  return token.Length();
+}
+
 }  // namespace
 
 std::ostream& operator<<(std::ostream& stream, LayoutType type) {
@@ -274,7 +296,7 @@ LayoutFunction LayoutFunctionFactory::Juxtaposition(
                << "\n*** Please file a bug. ***";
     // Do not crash, fallback to stack layout. Set huge penalty to let the
     // layout be dropped in Choice() operator if it ends up in one.
-    auto result = Stack({left, right});
+    auto result = Stack(left, right);
     for (auto& segment : result) segment.intercept += 2e6;
     return result;
   }
@@ -344,6 +366,15 @@ LayoutFunction LayoutFunctionFactory::Juxtaposition(
   return result;
 }
 
+LayoutFunction LayoutFunctionFactory::Stack(
+    const LayoutFunction& upper, const LayoutFunction& lower) const {
+  CHECK(!upper.empty());
+  CHECK(!lower.empty());
+  absl::FixedArray<LayoutFunction::const_iterator> segments = {upper.begin(),
+                                                               lower.begin()};
+  return Stack(&segments);
+}
+
 LayoutFunction LayoutFunctionFactory::Stack(
     absl::FixedArray<LayoutFunction::const_iterator>* segments) const {
   CHECK(!segments->empty());
@@ -471,6 +502,7 @@ void TokenPartitionsLayoutOptimizer::Optimize(int indentation,
   CHECK_GE(indentation, 0);
 
   const LayoutFunction layout_function = CalculateOptimalLayout(*node);
+  if (stats_ != nullptr) stats_->segments = layout_function.size();
 
   CHECK(!layout_function.empty());
   VLOG(4) << __FUNCTION__ << ", layout function:\n" << layout_function;
@@ -486,6 +518,103 @@ void TokenPartitionsLayoutOptimizer::Optimize(int indentation,
 
 LayoutFunction TokenPartitionsLayoutOptimizer::CalculateOptimalLayout(
     const TokenPartitionTree& node) const {
+  subtree_ids_.clear();
+  AssignSubtreeIds(node);
+  LayoutFunction layout_function = CachedOptimalLayout(node);
+  subtree_ids_.clear();
+  return layout_function;
+}
+
+int TokenPartitionsLayoutOptimizer::AssignSubtreeIds(
+    const TokenPartitionTree& node) const {
+  const auto& uwline = node.Value();
+  const auto tokens = uwline.TokensRange();
+  std::vector<int> key = {
+      static_cast<int>(uwline.PartitionPolicy()),
+      uwline.IndentationSpaces(),
+      static_cast<int>(tokens.size()),
+      static_cast<int>(node.Children().size()),
+  };
+  if (is_leaf(node)) {
+    for (const auto& token : tokens) {
+      key.insert(key.end(), {token.before.spaces_required,
+                             token.before.break_penalty,
+                             static_cast<int>(token.before.break_decision),
+                             TokenLineLength(token)});
+    }
+  } else {
+    for (const auto& child : node.Children()) {
+      key.push_back(
+          std::distance(tokens.begin(), child.Value().TokensRange().begin()));
+      key.push_back(AssignSubtreeIds(child));
+    }
+  }
+
+  const auto [iter, inserted] =
+      cache_.subtree_ids.try_emplace(std::move(key), cache_.layouts.size());
+  if (inserted) cache_.layouts.emplace_back();
+  subtree_ids_[&node] = iter->second;
+  return iter->second;
+}
+
+LayoutFunction TokenPartitionsLayoutOptimizer::CachedOptimalLayout(
+    const TokenPartitionTree& node) const {
+  const auto id_iter = subtree_ids_.find(&node);
+  CHECK(id_iter != subtree_ids_.end());
+  const auto tokens_begin = node.Value().TokensRange().begin();
+
+  // No new entries are added while calculating, so the reference stays valid.
+  // An entry is set only once, so it is read without the lock once it is.
+  auto& cached = cache_.layouts[id_iter->second];
+  bool is_cached;
+  {
+    const std::lock_guard<std::mutex> l(lock_);
+    is_cached = cached.has_value();
+    if (is_cached && stats_ != nullptr) ++stats_->cached_layouts;
+  }
+  if (!is_cached) {
+    // Equal subtrees laid out concurrently may both get here; either result
+    // is kept.
+    auto layout_function = CalculateLayout(node);
+    const std::lock_guard<std::mutex> l(lock_);
+    if (stats_ != nullptr) {
+      ++stats_->calculated_layouts;
+      stats_->calculated_segments += layout_function.size();
+    }
+    if (!cached.has_value()) cached = {tokens_begin, layout_function};
+    return layout_function;
+  }
+
+  // Move layouts to the tokens of 'node'.
+  LayoutFunction layout_function = cached->layout_function;
+  const int offset = std::distance(cached->tokens_begin, tokens_begin);
+  if (offset != 0) {
+    for (int i = 0; i < layout_function.size(); ++i) {
+      ApplyPreOrder(layout_function[i].layout, [offset](LayoutItem& item) {
+        if (item.Type() == LayoutType::kLine) item.ShiftTokensRange(offset);
+      });
+    }
+  }
+  return layout_function;
+}
+
+template <class F>
+void TokenPartitionsLayoutOptimizer::ForEachChildLayout(
+    const TokenPartitionTree& node, absl::FixedArray<LayoutFunction>* layouts,
+    const F& f) const {
+  const auto& children = node.Children();
+  if (pool_ != nullptr && children.size() > 1 &&
+      node.Value().TokensRange().size() >= kParallelTokensMin) {
+    // Children are independent; they only share the cache.
+    pool_->ParallelFor(children.size(),
+                       [&](size_t i) { (*layouts)[i] = f(children[i]); });
+    return;
+  }
+  std::transform(children.begin(), children.end(), layouts->begin(), f);
+}
+
+LayoutFunction TokenPartitionsLayoutOptimizer::CalculateLayout(
+    const TokenPartitionTree& node) const {
   if (is_leaf(node)) {
     // Wrapping complexity is n*(n+1)/2.
     constexpr int kWrapTokensLimit = 25;
@@ -509,10 +638,9 @@ LayoutFunction TokenPartitionsLayoutOptimizer::CalculateOptimalLayout(
     case PartitionPolicyEnum::kFitOnLineElseExpand:
     case PartitionPolicyEnum::kAppendFittingSubPartitions:
     case PartitionPolicyEnum::kJuxtapositionOrIndentedStack: {
-      std::transform(node.Children().begin(), node.Children().end(),
-                     layouts.begin(), [this](const TokenPartitionTree& n) {
-                       return this->CalculateOptimalLayout(n);
-                     });
+      ForEachChildLayout(node, &layouts, [this](const TokenPartitionTree& n) {
+        return this->CachedOptimalLayout(n);
+      });
       break;
     }
 
@@ -520,8 +648,8 @@ LayoutFunction TokenPartitionsLayoutOptimizer::CalculateOptimalLayout(
     case PartitionPolicyEnum::kAlwaysExpand:
     case PartitionPolicyEnum::kTabularAlignment: {
       const int indentation = node.Value().IndentationSpaces();
-      std::transform(
-          node.Children().begin(), node.Children().end(), layouts.begin(),
+      ForEachChildLayout(
+          node, &layouts,
           [this, &node, indentation](const TokenPartitionTree& n) {
             const int relative_indentation =
                 n.Value().IndentationSpaces() - indentation;
@@ -534,10 +662,10 @@ LayoutFunction TokenPartitionsLayoutOptimizer::CalculateOptimalLayout(
             LayoutFunction lf;
 
             if (relative_indentation > 0) {
-              lf = factory_.Indent(this->CalculateOptimalLayout(n),
+              lf = factory_.Indent(this->CachedOptimalLayout(n),
                                    relative_indentation);
             } else {
-              lf = this->CalculateOptimalLayout(n);
+              lf = this->CachedOptimalLayout(n);
             }
             return lf;
           });
@@ -22,6 +22,7 @@
 
 #include <algorithm>
 #include <iterator>
+#include <memory>
 #include <ostream>
 #include <type_traits>
 #include <vector>
@@ -32,13 +33,60 @@
 #include "common/formatting/basic_format_style.h"
 #include "common/formatting/token_partition_tree.h"
 #include "common/formatting/unwrapped_line.h"
+#include "common/util/thread_pool.h"
 #include "common/util/vector_tree.h"
 
 namespace verible {
 
+// Layout functions computed by OptimizeTokenPartitionTree(), shared by all
+// partition subtrees with the same structure, indentation and token spacing.
+// Repeated code, like generated instance port lists, is then only laid out
+// once.
+// The cache refers to the tokens of the optimized partitions, so it should be
+// used only with partitions of a single token array, and must not outlive it.
+class LayoutFunctionCache {
+ public:
+  LayoutFunctionCache();
+  ~LayoutFunctionCache();
+
+  LayoutFunctionCache(const LayoutFunctionCache&) = delete;
+  LayoutFunctionCache& operator=(const LayoutFunctionCache&) = delete;
+
+  // Number of distinct subtrees seen so far.
+  int size() const;
+
+ private:
+  friend class TokenPartitionsLayoutOptimizer;
+
+  // Defined in layout_optimizer_internal.h.
+  struct Entries;
+  std::unique_ptr<Entries> entries_;
+};
+
+// Statistics of an OptimizeTokenPartitionTree() call, for profiling.
+struct LayoutOptimizerStats {
+  // Number of subtrees whose layout functions were calculated, and the total
+  // number of segments of these layout functions.
+  int calculated_layouts = 0;
+  int calculated_segments = 0;
+  // Number of subtrees whose layout functions were taken from the cache.
+  int cached_layouts = 0;
+  // Number of segments of the layout function of the optimized partition.
+  int segments = 0;
+};
+
 // Handles formatting of `node` using LayoutOptimizer.
+// If 'cache' is not null, layout functions of subtrees are looked up in and
+// added to it.
+// If 'stats' is not null, the effort spent on the layout is added there.
+// If 'pool' is not null, the layout functions of the children of large
+// subtrees, which are independent of each other, are calculated on its
+// threads, e.g. the ports of a big instance.  The result is the same.
 void OptimizeTokenPartitionTree(const BasicFormatStyle& style,
-                                TokenPartitionTree* node);
+                                TokenPartitionTree* node,
+                                LayoutFunctionCache* cache = nullptr,
+                                LayoutOptimizerStats* stats = nullptr,
+                                ThreadPool* pool = nullptr);
 
 }  // namespace verible
 
@@ -19,16 +19,22 @@
 
 #include <algorithm>
 #include <iterator>
+#include <mutex>
+#include <optional>
 #include <ostream>
 #include <type_traits>
 #include <vector>
 
 #include "absl/container/fixed_array.h"
+#include "absl/container/flat_hash_map.h"
+#include "absl/container/inlined_vector.h"
 #include "absl/strings/str_cat.h"
 #include "absl/strings/str_join.h"
 #include "common/formatting/basic_format_style.h"
+#include "common/formatting/layout_optimizer.h"
 #include "common/formatting/token_partition_tree.h"
 #include "common/formatting/unwrapped_line.h"
+#include "common/util/thread_pool.h"
 #include "common/util/tree_operations.h"
 #include "common/util/vector_tree.h"
 
@@ -157,6 +163,14 @@ class LayoutItem {
     return tokens_;
   }
 
+  // Moves tokens range spanned by the Line item by 'offset' tokens.
+  // Can be called only on Line items.
+  void ShiftTokensRange(int offset) {
+    CHECK_EQ(type_, LayoutType::kLine);
+    tokens_ = FormatTokenRange(tokens_.begin() + offset,
+                               tokens_.end() + offset);
+  }
+
   friend bool operator==(const LayoutItem& lhs, const LayoutItem& rhs) {
     return (lhs.type_ == rhs.type_ && lhs.indentation_ == rhs.indentation_ &&
             lhs.tokens_ == rhs.tokens_ &&
@@ -270,7 +284,7 @@ class LayoutFunction {
     } else {
       CHECK_EQ(segment.column, 0);
     }
-    segments_.push_back(segment);
+    segments_.push_back(std::move(segment));
   }
 
   bool empty() const { return segments_.empty(); }
@@ -339,7 +353,9 @@ class LayoutFunction {
   // std::set would be more appropriate generally, but due to really
   // small amount of elements the container has to hold and ordered inserts, it
   // probably wouldn't help in anything.
-  std::vector<LayoutFunctionSegment> segments_;
+  // Most functions have only a few segments (a Line has one or two), so they
+  // are stored inline to avoid a heap allocation per function.
+  absl::InlinedVector<LayoutFunctionSegment, 4> segments_;
 };
 
 template <bool IsConst, typename T>
@@ -586,7 +602,9 @@ class LayoutFunctionFactory {
     if (lfs_container.empty()) return {};
     if (lfs_container.size() == 1) return lfs_container.front();
 
-    LayoutFunction incremental = lfs_container.front();
+    LayoutFunction incremental =
+        Juxtaposition(lfs_container[0], lfs_container[1]);
+    lfs_container.pop_front();
     lfs_container.pop_front();
     for (auto& lf : lfs_container) {
       incremental = Juxtaposition(incremental, lf);
@@ -664,11 +682,11 @@ class LayoutFunctionFactory {
       absl::FixedArray<LayoutFunction> results_i(size - i);
       LayoutFunction incremental = lfs[i];
       for (int j = i; j < size - 1; ++j) {
-        results_i[j - i] = Stack({
-            incremental,
-            (i == 0) ? Indent(results[j + 1], hanging_indentation)
-                     : results[j + 1],
-        });
+        results_i[j - i] =
+            (i == 0)
+                ? Stack(incremental,
+                        Indent(results[j + 1], hanging_indentation))
+                : Stack(incremental, results[j + 1]);
 
         const auto& next_element = lfs[j + 1];
         if (use_tokens_break_penalty) {
@@ -687,14 +705,12 @@ class LayoutFunctionFactory {
         }
 
         if (next_element.MustWrap()) {
-          incremental = Stack({
-              std::move(incremental),
-              Indent(next_element, hanging_indentation),
-          });
+          incremental =
+              Stack(incremental, Indent(next_element, hanging_indentation));
         } else {
           // TODO(mglb): use Stack for invervals where lfs[j] is multiline (i.e.
           // has any stack sublayouts)
-          incremental = Juxtaposition({std::move(incremental), next_element});
+          incremental = Juxtaposition(incremental, next_element);
         }
       }
       results_i.back() = std::move(incremental);
@@ -707,9 +723,14 @@ class LayoutFunctionFactory {
   }
 
  private:
+  // Two-element variants of Juxtaposition() and Stack(), which don't copy
+  // their arguments.
   LayoutFunction Juxtaposition(const LayoutFunction& left,
                                const LayoutFunction& right) const;
 
+  LayoutFunction Stack(const LayoutFunction& upper,
+                       const LayoutFunction& lower) const;
+
   LayoutFunction Stack(
       absl::FixedArray<LayoutFunction::const_iterator>* segments) const;
 
@@ -719,10 +740,39 @@ class LayoutFunctionFactory {
   const BasicFormatStyle& style_;
 };
 
+struct LayoutFunctionCache::Entries {
+  // Layout function calculated for a subtree, with the first token of that
+  // subtree.
+  struct SubtreeLayout {
+    FormatTokenRange::const_iterator tokens_begin;
+    LayoutFunction layout_function;
+  };
+
+  // Ids of distinct subtree keys. A key consists of the partition policy,
+  // indentation and token range size of the subtree's root, followed by
+  // either the spacing and length of each token (for leaves), or the
+  // position and id of each child.
+  absl::flat_hash_map<std::vector<int>, int> subtree_ids;
+
+  // Layout functions, indexed by subtree id.
+  std::vector<std::optional<SubtreeLayout>> layouts;
+};
+
 class TokenPartitionsLayoutOptimizer {
  public:
-  explicit TokenPartitionsLayoutOptimizer(const BasicFormatStyle& style)
-      : factory_(style) {}
+  // 'cache' is used for layout functions of subtrees. When null, layout
+  // functions are cached only for the lifetime of this object.
+  // If 'stats' is not null, the effort spent on layouts is added there.
+  // If 'pool' is not null, children of subtrees with at least
+  // kParallelTokensMin tokens are laid out on its threads.
+  explicit TokenPartitionsLayoutOptimizer(const BasicFormatStyle& style,
+                                          LayoutFunctionCache* cache = nullptr,
+                                          LayoutOptimizerStats* stats = nullptr,
+                                          ThreadPool* pool = nullptr)
+      : factory_(style),
+        cache_(cache != nullptr ? *cache->entries_ : *own_cache_.entries_),
+        stats_(stats),
+        pool_(pool) {}
 
   TokenPartitionsLayoutOptimizer(const TokenPartitionsLayoutOptimizer&) =
       delete;
@@ -736,8 +786,41 @@ class TokenPartitionsLayoutOptimizer {
 
   LayoutFunction CalculateOptimalLayout(const TokenPartitionTree& node) const;
 
+  // Smaller subtrees are not worth distributing over threads.
+  static constexpr int kParallelTokensMin = 64;
+
  private:
+  // Assigns ids to 'node' and its descendants. Returns id of 'node'.
+  int AssignSubtreeIds(const TokenPartitionTree& node) const;
+
+  // Returns layout function of 'node' from the cache, calculating it when
+  // needed. Requires ids assigned by AssignSubtreeIds().
+  LayoutFunction CachedOptimalLayout(const TokenPartitionTree& node) const;
+
+  LayoutFunction CalculateLayout(const TokenPartitionTree& node) const;
+
+  // Sets each of 'layouts' to 'f' of the corresponding child of 'node',
+  // concurrently if 'node' is large enough.
+  template <class F>
+  void ForEachChildLayout(const TokenPartitionTree& node,
+                          absl::FixedArray<LayoutFunction>* layouts,
+                          const F& f) const;
+
   const LayoutFunctionFactory factory_;
+
+  LayoutFunctionCache own_cache_;
+  LayoutFunctionCache::Entries& cache_;
+
+  LayoutOptimizerStats* const stats_;
+
+  ThreadPool* const pool_;
+
+  // Guards whether entries of cache_.layouts are set, which happens once, and
+  // stats_, while children are laid out concurrently.
+  mutable std::mutex lock_;
+
+  // Subtree ids of nodes of the tree being optimized.
+  mutable absl::flat_hash_map<const TokenPartitionTree*, int> subtree_ids_;
 };
 
 class TreeReconstructor {
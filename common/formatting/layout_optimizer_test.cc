@@ -30,6 +30,7 @@
 #include "common/formatting/unwrapped_line_test_utils.h"
 #include "common/strings/split.h"
 #include "common/util/spacer.h"
+#include "common/util/thread_pool.h"
 #include "gtest/gtest.h"
 
 namespace verible {
@@ -2586,5 +2587,164 @@ TEST_F(TokenPartitionsLayoutOptimizerTest, CalculateOptimalLayout) {
   }
 }
 
+class TokenPartitionsLayoutOptimizerCacheTest
+    : public ::testing::Test,
+      public UnwrappedLineMemoryHandler {
+ public:
+  TokenPartitionsLayoutOptimizerCacheTest()
+      : sample_("first second third\n"
+                "first second third\n"),
+        tokens_(
+            absl::StrSplit(sample_, absl::ByAnyChar(" \n"), absl::SkipEmpty())),
+        style_(CreateStyle()),
+        factory_(LayoutFunctionFactory(style_)) {
+    for (const auto token : tokens_) {
+      ftokens_.emplace_back(1, token);
+    }
+    CreateTokenInfosExternalStringBuffer(ftokens_);
+    for (auto& token : pre_format_tokens_) {
+      token.before.spaces_required = 1;
+    }
+  }
+
+ protected:
+  const std::string sample_;
+  const std::vector<absl::string_view> tokens_;
+  std::vector<TokenInfo> ftokens_;
+  const BasicFormatStyle style_;
+  const LayoutFunctionFactory factory_;
+};
+
+TEST_F(TokenPartitionsLayoutOptimizerCacheTest, EqualSubtreesShareLayouts) {
+  using TPT = TokenPartitionTreeBuilder;
+  using PP = PartitionPolicyEnum;
+
+  LayoutFunctionCache cache;
+  {
+    const auto optimizer = TokenPartitionsLayoutOptimizer(style_, &cache);
+    const auto tree = TPT(PP::kAlwaysExpand,
+                          {
+                              TPT(0, {0, 3}, PP::kWrap),
+                              TPT(0, {3, 6}, PP::kWrap),
+                          })
+                          .build(pre_format_tokens_);
+
+    const LayoutFunction lf = optimizer.CalculateOptimalLayout(tree);
+    // The root and one layout shared by both children.
+    EXPECT_EQ(cache.size(), 2);
+
+    const auto expected_lf =
+        factory_.Stack({factory_.WrappedLine(tree.Children()[0].Value()),
+                        factory_.WrappedLine(tree.Children()[1].Value())});
+    ExpectLayoutFunctionsEqual(lf, expected_lf, __LINE__);
+  }
+  {
+    const auto optimizer = TokenPartitionsLayoutOptimizer(style_, &cache);
+    const auto tree = TPT(0, {3, 6}, PP::kWrap).build(pre_format_tokens_);
+
+    const LayoutFunction lf = optimizer.CalculateOptimalLayout(tree);
+    EXPECT_EQ(cache.size(), 2);
+    ExpectLayoutFunctionsEqual(lf, factory_.WrappedLine(tree.Value()),
+                               __LINE__);
+  }
+  {
+    // Different spacing doesn't use cached layouts.
+    pre_format_tokens_[4].before.spaces_required = 2;
+    LayoutOptimizerStats stats;
+    const auto optimizer =
+        TokenPartitionsLayoutOptimizer(style_, &cache, &stats);
+    const auto tree = TPT(0, {3, 6}, PP::kWrap).build(pre_format_tokens_);
+
+    const LayoutFunction lf = optimizer.CalculateOptimalLayout(tree);
+    EXPECT_EQ(cache.size(), 3);
+    ExpectLayoutFunctionsEqual(lf, factory_.WrappedLine(tree.Value()),
+                               __LINE__);
+    EXPECT_EQ(stats.calculated_layouts, 1);
+    EXPECT_EQ(stats.calculated_segments, lf.size());
+    EXPECT_EQ(stats.cached_layouts, 0);
+  }
+}
+
+TEST_F(TokenPartitionsLayoutOptimizerCacheTest, Stats) {
+  using TPT = TokenPartitionTreeBuilder;
+  using PP = PartitionPolicyEnum;
+
+  auto tree = TPT(PP::kAlwaysExpand,
+                  {
+                      TPT(0, {0, 3}, PP::kWrap),
+                      TPT(0, {3, 6}, PP::kWrap),
+                  })
+                  .build(pre_format_tokens_);
+  LayoutOptimizerStats stats;
+  OptimizeTokenPartitionTree(style_, &tree, nullptr, &stats);
+  // The second child gets the layout function of the first one.
+  EXPECT_EQ(stats.calculated_layouts, 2);
+  EXPECT_EQ(stats.cached_layouts, 1);
+  EXPECT_GT(stats.segments, 0);
+  // Including the layout function of the root.
+  EXPECT_GE(stats.calculated_segments, stats.segments);
+}
+
+class TokenPartitionsLayoutOptimizerThreadsTest
+    : public ::testing::Test,
+      public UnwrappedLineMemoryHandler {
+ public:
+  static constexpr int kLines = 40;
+
+  TokenPartitionsLayoutOptimizerThreadsTest()
+      : tokens_(kLines * 3, "token"), style_(CreateStyle()) {
+    for (const auto token : tokens_) {
+      ftokens_.emplace_back(1, token);
+    }
+    CreateTokenInfosExternalStringBuffer(ftokens_);
+    for (size_t i = 0; i < pre_format_tokens_.size(); ++i) {
+      // A few distinct lines, so that some layouts are shared.
+      pre_format_tokens_[i].before.spaces_required = 1 + (i / 3) % 4;
+    }
+  }
+
+ protected:
+  // Stack of kLines lines of three tokens each.
+  TokenPartitionTree BuildTree() const {
+    using TPT = TokenPartitionTreeBuilder;
+    using PP = PartitionPolicyEnum;
+
+    auto tree =
+        TPT(0, {0, kLines * 3}, PP::kAlwaysExpand).build(pre_format_tokens_);
+    for (int i = 0; i < kLines; ++i) {
+      tree.Children().push_back(
+          TPT(0, {i * 3, i * 3 + 3}, PP::kWrap).build(pre_format_tokens_));
+    }
+    return tree;
+  }
+
+  const std::vector<absl::string_view> tokens_;
+  std::vector<TokenInfo> ftokens_;
+  const BasicFormatStyle style_;
+};
+
+TEST_F(TokenPartitionsLayoutOptimizerThreadsTest, SameLayoutsAsSerial) {
+  static_assert(kLines * 3 >=
+                TokenPartitionsLayoutOptimizer::kParallelTokensMin);
+  ThreadPool pool(4);
+  const auto tree = BuildTree();
+
+  const auto serial = TokenPartitionsLayoutOptimizer(style_);
+  const auto parallel =
+      TokenPartitionsLayoutOptimizer(style_, nullptr, nullptr, &pool);
+  ExpectLayoutFunctionsEqual(parallel.CalculateOptimalLayout(tree),
+                             serial.CalculateOptimalLayout(tree), __LINE__);
+
+  auto serial_tree = BuildTree();
+  OptimizeTokenPartitionTree(style_, &serial_tree);
+  auto parallel_tree = BuildTree();
+  LayoutOptimizerStats stats;
+  OptimizeTokenPartitionTree(style_, &parallel_tree, nullptr, &stats, &pool);
+  EXPECT_PRED_FORMAT2(TokenPartitionTreesEqualPredFormat, parallel_tree,
+                      serial_tree);
+  // Every child is either calculated or taken from the cache.
+  EXPECT_EQ(stats.calculated_layouts + stats.cached_layouts, kLines + 1);
+}
+
 }  // namespace
 }  // namespace verible
@@ -14,13 +14,24 @@
 
 #include "common/formatting/line_wrap_searcher.h"
 
-#include <memory>
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <limits>
+#include <optional>
 #include <queue>
+#include <utility>
 #include <vector>
 
+#include "absl/container/flat_hash_map.h"
+#include "absl/hash/hash.h"
 #include "absl/strings/string_view.h"
+#include "absl/time/clock.h"
+#include "absl/time/time.h"
 #include "common/formatting/basic_format_style.h"
 #include "common/formatting/format_token.h"
+#include "common/formatting/format_token_arrays.h"
 #include "common/formatting/state_node.h"
 #include "common/formatting/unwrapped_line.h"
 #include "common/text/token_info.h"
@@ -32,23 +43,184 @@ namespace {
 
 // Wrapped class around StateNode for the sake of adapting to a
 // std::priority_queue interface.
-// TODO(fangism): if performance of memory allocations is an issue,
-// use some sort of pool-allocator.
+// The StateNodes are owned by the StateNodeArena of the search.
 struct SearchState {
-  std::shared_ptr<const StateNode> state;
+  const StateNode* state;
 
-  explicit SearchState(const std::shared_ptr<const StateNode>& s) : state(s) {}
+  // Lower bound of the cost of any completion of 'state': its cost so far,
+  // plus a lower bound of the cost still to come.
+  int min_total_cost;
+
+  SearchState(const StateNode* s, int min_remaining_cost)
+      : state(s), min_total_cost(s->cumulative_cost + min_remaining_cost) {}
+
+  // Like StateNode::operator<, but by min_total_cost.
+  bool Precedes(const SearchState& r) const {
+    return min_total_cost < r.min_total_cost ||
+           (min_total_cost == r.min_total_cost &&
+            state->current_column < r.state->current_column);
+  }
 
   // Inverted to min-heap: *lowest* penalty has the highest search priority.
-  bool operator<(const SearchState& r) const { return *r.state < *state; }
+  bool operator<(const SearchState& r) const { return r.Precedes(*this); }
+};
+
+// Admissible estimate of the cost still to come from a search state, which
+// turns the uniform-cost search into an A* search: forced line breaks cost
+// their break penalty, and every run of tokens between points where the
+// column is reset (forced breaks, preserved spacing, multi-line tokens) that
+// does not fit on the rest of its line costs at least as many line breaks
+// within the run as it takes to fit, or going over the column limit.
+class RemainingCostBound {
+ public:
+  RemainingCostBound(const FormatTokenArrays& tokens,
+                     const BasicFormatStyle& style)
+      : column_limit_(style.column_limit),
+        over_column_limit_cost_(style.over_column_limit_penalty + 1) {
+    const size_t size = tokens.size();
+    runs_.resize(size + 1);
+    runs_[size] = Run{0, 0, 0, kNoBreak, size, 0};
+    for (size_t i = size; i-- > 0;) {
+      const SpacingOptions decision = tokens.BreakDecision(i);
+      Run& run = runs_[i];
+      if (decision == SpacingOptions::kMustWrap ||
+          decision == SpacingOptions::kPreserve || tokens.IsMultiLine(i)) {
+        // The column after this token is at least its length, or the length
+        // of its last line.
+        const int column = tokens.IsMultiLine(i) ? tokens.LastLineLength(i)
+                                                 : tokens.Length(i);
+        run = Run{0, 0, 0, kNoBreak, i,
+                  (decision == SpacingOptions::kMustWrap
+                       ? tokens.BreakPenalty(i)
+                       : 0) +
+                      Bound(column, i + 1)};
+      } else {
+        const Run& next = runs_[i + 1];
+        const int width = tokens.SpacesRequired(i) + tokens.Length(i);
+        run = Run{
+            next.width + width,
+            std::max(next.max_spaces, tokens.SpacesRequired(i)),
+            std::max(next.max_token_width, width),
+            decision == SpacingOptions::kMustAppend
+                ? next.min_break_penalty
+                : std::min(next.min_break_penalty, tokens.BreakPenalty(i)),
+            next.end, 0};
+      }
+    }
+  }
+
+  int operator()(const StateNode& state) const {
+    if (state.Done()) return 0;
+    return Bound(state.current_column, state.NextTokenIndex());
+  }
+
+ private:
+  static constexpr int kNoBreak = std::numeric_limits<int>::max();
+
+  // The tokens from an index up to the next point where the column is reset.
+  struct Run {
+    // Sum of the spaces before and lengths of the tokens.
+    int width;
+    // Most spaces before one of the tokens, which a line break removes.
+    int max_spaces;
+    // Most spaces before and length of one of the tokens.  A token that is
+    // wrapped onto its own line may exceed the column limit without penalty.
+    int max_token_width;
+    // Lowest penalty of breaking before one of the tokens.
+    int min_break_penalty;
+    // Index of the token after the last one.
+    size_t end;
+    // Lower bound of the cost from token 'end' on, if this run is empty.
+    int end_cost;
+  };
+
+  // Returns a lower bound of the cost from the token at 'index' on, if the
+  // previous token ends at 'column'.
+  int Bound(int column, size_t index) const {
+    const Run& run = runs_[index];
+    int cost = runs_[run.end].end_cost;
+    // Every line break fits at most another line's worth of the run.
+    // Columns past the limit are left out, so that the bound never drops by
+    // more than one line break's worth when one is taken.
+    const int excess =
+        std::min(column, column_limit_) + run.width - column_limit_;
+    if (run.width > 0 && excess > 0) {
+      const int line_width = std::max(
+          {column_limit_ + run.max_spaces, run.max_token_width, 1});
+      const int64_t breaks = (excess + line_width - 1) / line_width;
+      cost += static_cast<int>(std::min<int64_t>(
+          breaks * run.min_break_penalty, over_column_limit_cost_));
+    }
+    return cost;
+  }
+
+  int column_limit_;
+  int over_column_limit_cost_;
+  std::vector<Run> runs_;
+};
+
+// Identifies the parts of a StateNode that determine all of its possible
+// continuations: the next token to decide, the current column, the spacing
+// decision of the current token (affects group balancing of the next token),
+// and the stack of wrap column positions.
+// Two states with equal keys can only differ by their cumulative cost, and
+// every continuation of one adds the same cost as the same continuation of
+// the other.
+struct SearchStateKey {
+  const PreFormatToken* next_token;
+  int current_column;
+  SpacingDecision spacing_choice;
+  const std::vector<int>* wrap_column_positions;  // owned by the StateNode
+
+  explicit SearchStateKey(const StateNode& s)
+      : next_token(&s.GetNextToken()),
+        current_column(s.current_column),
+        spacing_choice(s.spacing_choice),
+        wrap_column_positions(&s.wrap_column_positions.Positions()) {}
+
+  bool operator==(const SearchStateKey& r) const {
+    return next_token == r.next_token && current_column == r.current_column &&
+           spacing_choice == r.spacing_choice &&
+           *wrap_column_positions == *r.wrap_column_positions;
+  }
+
+  template <typename H>
+  friend H AbslHashValue(H h, const SearchStateKey& k) {
+    return H::combine(std::move(h), k.next_token, k.current_column,
+                      k.spacing_choice, *k.wrap_column_positions);
+  }
 };
 }  // namespace
 
-std::vector<FormattedExcerpt> SearchLineWraps(const UnwrappedLine& uwline,
-                                              const BasicFormatStyle& style,
-                                              int max_search_states) {
-  // Dijkstra's algorithm for now: prioritize searching minimum penalty path
-  // until destination is reached.
+// Number of search states between checks for cancellation.
+static constexpr int kCancellationPollStates = 1024;
+
+// Number of the cheapest unexplored states that are completed greedily when
+// a search runs out of time.
+static constexpr int kOutOfTimeCandidates = 8;
+
+// Returns the cheapest greedy completion of 'cheapest' and the next cheapest
+// states of 'worklist', which are removed from it.
+static const StateNode* FinishCheapestStates(
+    const StateNode* cheapest, std::priority_queue<SearchState>* worklist,
+    const BasicFormatStyle& style, StateNodeArena* arena) {
+  const StateNode* best = StateNode::QuickFinish(cheapest, style, arena);
+  for (int i = 1; i < kOutOfTimeCandidates && !worklist->empty(); ++i) {
+    const StateNode* finished =
+        StateNode::QuickFinish(worklist->top().state, style, arena);
+    worklist->pop();
+    if (*finished < *best) best = finished;
+  }
+  return best;
+}
+
+std::vector<FormattedExcerpt> SearchLineWraps(
+    const UnwrappedLine& uwline, const BasicFormatStyle& style,
+    int max_search_states, LineWrapSearchStats* stats,
+    const std::function<bool()>& is_cancelled, absl::Time deadline,
+    bool estimate_remaining_cost, bool prune_dominated_states) {
+  // Dijkstra's algorithm, or A* with estimate_remaining_cost: prioritize
+  // searching minimum penalty path until destination is reached.
 
   VLOG(2) << "SearchLineWraps on: " << uwline;
   if (uwline.TokensRange().empty()) {
@@ -62,19 +234,55 @@ std::vector<FormattedExcerpt> SearchLineWraps(const UnwrappedLine& uwline,
   // important, consider switching to a std::map.
   std::priority_queue<SearchState> worklist;
 
+  // All search states live until the end of the search, and are freed in
+  // bulk, which avoids per-state heap allocation and reference counting.
+  StateNodeArena arena;
+
   // Seed worklist with a NodeState that should have 0 penalty.
-  SearchState seed(std::make_shared<StateNode>(uwline, style));
+  const StateNode* root = arena.New(uwline, style);
+
+  std::optional<RemainingCostBound> remaining_cost_bound;
+  if (estimate_remaining_cost) {
+    remaining_cost_bound.emplace(*root->token_arrays, style);
+  }
+  const auto make_search_state = [&](const StateNode* state) {
+    return SearchState(
+        state, remaining_cost_bound ? (*remaining_cost_bound)(*state) : 0);
+  };
+
+  SearchState seed(make_search_state(root));
   worklist.push(seed);
 
+  // Keys of the states that have already been expanded, and their cost.
+  // States are visited in order of increasing cost (plus the estimate of the
+  // remaining cost, which is the same for equivalent states), so a state
+  // that is equivalent to one that was already expanded costs at least as
+  // much.  If it costs more, it is dominated: any completion of it costs more
+  // than the same completion of the other, so it can be dropped without
+  // losing any optimal solution.  Equivalent states of equal cost are all
+  // expanded, as they may lead to equally optimal solutions.
+  absl::flat_hash_map<SearchStateKey, int> expanded_states;
+  int pruned_count = 0;
+
   bool aborted_search = false;
-  std::vector<std::shared_ptr<const StateNode>> winning_paths;
+  bool out_of_time = false;
+  std::vector<const StateNode*> winning_paths;
   int state_count = 0;
   while (!worklist.empty()) {
-    ++state_count;
-
     SearchState next(worklist.top());
     worklist.pop();
 
+    if (prune_dominated_states && !next.state->Done()) {
+      const auto [expanded, inserted] = expanded_states.emplace(
+          SearchStateKey(*next.state), next.state->cumulative_cost);
+      if (!inserted && next.state->cumulative_cost > expanded->second) {
+        // Dominated states do not count against max_search_states.
+        ++pruned_count;
+        continue;
+      }
+    }
+    ++state_count;
+
     VLOG(4) << "\n---- line wrapping search state " << state_count << " ----"
             << "\ncurrent cost: " << next.state->cumulative_cost
             << "\ncurrent column: " << next.state->current_column;
@@ -84,7 +292,12 @@ std::vector<FormattedExcerpt> SearchLineWraps(const UnwrappedLine& uwline,
       // As soon as the current cost exceeds the optimal (by 1 or tie-breaker),
       // then stop.
       // This guarantees that we've collected all equally optimal solutions.
-      if (*winning_paths.front() < *next.state) {
+      // The estimate of the remaining cost does not cover the final column,
+      // so with it, all states that may still reach the optimal cost are
+      // explored, and the solutions are sorted by column below.
+      const SearchState best(winning_paths.front(), 0);
+      if (remaining_cost_bound ? best.min_total_cost < next.min_total_cost
+                               : best.Precedes(next)) {
         break;
       }
     }
@@ -101,53 +314,85 @@ std::vector<FormattedExcerpt> SearchLineWraps(const UnwrappedLine& uwline,
       continue;
     }
 
-    if (state_count >= max_search_states) {
-      // Search limit exceeded, abandon search.
+    // Cancellation and the deadline are only polled every so often (starting
+    // with the first state), as that may be costly, e.g. reading the clock.
+    const bool poll = state_count % kCancellationPollStates == 1;
+    if (state_count >= max_search_states ||
+        (is_cancelled && poll && is_cancelled())) {
+      // Search limit exceeded or cancelled, abandon search.
       // Greedily finish formatting this partition, and return it.
-      winning_paths.push_back(StateNode::QuickFinish(next.state, style));
+      winning_paths.push_back(
+          StateNode::QuickFinish(next.state, style, &arena));
       aborted_search = true;
       break;
     }
+    if (poll && deadline != absl::InfiniteFuture() && absl::Now() >= deadline) {
+      // Out of time: settle for the best greedy completion at hand, unless
+      // an optimal solution was already found.
+      if (winning_paths.empty()) {
+        winning_paths.push_back(
+            FinishCheapestStates(next.state, &worklist, style, &arena));
+      }
+      out_of_time = true;
+      break;
+    }
 
     // Consider the new penalties incurred for the next decision:
     // break, or no break.  Calculate new penalties.
     // Push one or both branches into the worklist.
     const auto& token = next.state->GetNextToken();
-    if (token.before.break_decision == SpacingOptions::kPreserve) {
+    const SpacingOptions break_decision = next.state->NextTokenBreakDecision();
+    if (break_decision == SpacingOptions::kPreserve) {
       VLOG(4) << "preserving spaces before \'" << token.token->text() << '\'';
-      SearchState preserved(std::make_shared<StateNode>(
-          next.state, style, SpacingDecision::kPreserve));
+      SearchState preserved = make_search_state(
+          arena.New(next.state, style, SpacingDecision::kPreserve));
       worklist.push(preserved);
     } else {
       // Remaining options are: Undecided, MustWrap, MustAppend
       // Explore one or both: SpacingDecision::Wrap/Append
-      if (token.before.break_decision != SpacingOptions::kMustWrap) {
+      if (break_decision != SpacingOptions::kMustWrap) {
         VLOG(4) << "considering appending \'" << token.token->text() << '\'';
         // Consider cost of appending token to current line.
-        SearchState appended(std::make_shared<StateNode>(
-            next.state, style, SpacingDecision::kAppend));
+        SearchState appended = make_search_state(
+            arena.New(next.state, style, SpacingDecision::kAppend));
         worklist.push(appended);
         VLOG(4) << "  cost: " << appended.state->cumulative_cost;
         VLOG(4) << "  column: " << appended.state->current_column;
       }
-      if (token.before.break_decision != SpacingOptions::kMustAppend) {
+      if (break_decision != SpacingOptions::kMustAppend) {
         VLOG(4) << "considering wrapping \'" << token.token->text() << '\'';
         // Consider cost of line wrapping here.
-        SearchState wrapped(std::make_shared<StateNode>(
-            next.state, style, SpacingDecision::kWrap));
+        SearchState wrapped = make_search_state(
+            arena.New(next.state, style, SpacingDecision::kWrap));
         worklist.push(wrapped);
         VLOG(4) << "  cost: " << wrapped.state->cumulative_cost;
         VLOG(4) << "  column: " << wrapped.state->current_column;
       }
     }
-
-    // TODO(fangism): Use an admissibility heuristic to prune search space from
-    // paths whose best-case outcome is worse than a conservatively achievable
-    // goal.  Without a heuristic, this is just Dijkstra.
-    // With heuristic pruning, this is A* (A-star).
   }  // while (!worklist.empty())
 
   CHECK_GE(winning_paths.size(), 1);
+  if (remaining_cost_bound && !aborted_search) {
+    // Keep the solutions of the lowest cost and column, as above.
+    std::stable_sort(
+        winning_paths.begin(), winning_paths.end(),
+        [](const StateNode* l, const StateNode* r) { return *l < *r; });
+    const StateNode* best = winning_paths.front();
+    winning_paths.erase(
+        std::find_if(winning_paths.begin(), winning_paths.end(),
+                     [best](const StateNode* path) { return *best < *path; }),
+        winning_paths.end());
+  }
+  VLOG(2) << "SearchLineWraps explored " << state_count
+          << " states, pruned " << pruned_count << " dominated states"
+          << (aborted_search ? " (search aborted)" : "")
+          << (out_of_time ? " (out of time)" : "");
+  if (stats != nullptr) {
+    stats->explored_states = state_count;
+    stats->pruned_states = pruned_count;
+    stats->aborted = aborted_search;
+    stats->out_of_time = out_of_time;
+  }
 
   // Reconstruct the unwrapped_line to reflect the decisions made to reach the
   // winning_paths.  Return a modified copy of the original UnwrappedLine.
@@ -189,7 +434,8 @@ FitResult FitsOnLine(const UnwrappedLine& uwline,
 
   // Initialize on first token.
   // This accounts for space consumed by left-indentation.
-  auto state = std::make_shared<const StateNode>(uwline, style);
+  StateNodeArena arena;
+  const StateNode* state = arena.New(uwline, style);
 
   while (!state->Done()) {
     const auto& token = state->GetNextToken();
@@ -199,7 +445,7 @@ FitResult FitsOnLine(const UnwrappedLine& uwline,
     }
 
     // Append token onto same line while it fits.
-    state = std::make_shared<StateNode>(state, style, SpacingDecision::kAppend);
+    state = arena.New(state, style, SpacingDecision::kAppend);
     if (state->current_column > style.column_limit) {
       return {false, state->current_column};
     }
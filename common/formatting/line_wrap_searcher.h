@@ -15,14 +15,30 @@
 #ifndef VERIBLE_COMMON_FORMATTING_LINE_WRAP_SEARCHER_H_
 #define VERIBLE_COMMON_FORMATTING_LINE_WRAP_SEARCHER_H_
 
+#include <functional>
 #include <iosfwd>
 #include <vector>
 
+#include "absl/time/time.h"
 #include "common/formatting/basic_format_style.h"
 #include "common/formatting/unwrapped_line.h"
 
 namespace verible {
 
+// Statistics of a SearchLineWraps() call, for profiling.
+struct LineWrapSearchStats {
+  // Number of search states that were expanded.
+  int explored_states = 0;
+  // Number of search states that were dropped, being equivalent to
+  // already expanded ones.
+  int pruned_states = 0;
+  // True if the search stopped at max_search_states, or was cancelled.
+  bool aborted = false;
+  // True if the search stopped at its deadline, with a greedily completed
+  // (not necessarily optimal) result.
+  bool out_of_time = false;
+};
+
 // SearchLineWraps takes an UnwrappedLine with formatting annotations,
 // and a style structure, and returns equally-good FormattedExcerpts with
 // formatting decisions (wraps, spaces) committed.
@@ -33,9 +49,27 @@ namespace verible {
 // returning a greedily formatted result (which can still be rendered)
 // that will be marked as !CompletedFormatting().
 // This is guaranteed to return at least one result.
-std::vector<FormattedExcerpt> SearchLineWraps(const UnwrappedLine& uwline,
-                                              const BasicFormatStyle& style,
-                                              int max_search_states);
+// If 'stats' is not null, the effort spent on the search is stored there.
+// If 'is_cancelled' is set, it is polled every so many states, and the search
+// is aborted the same way as on max_search_states once it returns true.
+// The 'deadline' is checked as often.  Once it has passed, the search returns
+// the best of the greedy completions of the cheapest states it was about to
+// explore.  That result is not necessarily optimal, but it is complete (not
+// marked as !CompletedFormatting()), so that callers with a time budget get a
+// usable formatting in predictable time.
+// With 'estimate_remaining_cost', states are explored in order of their cost
+// plus a lower bound of the cost still to come (an A* search), which finds
+// solutions of the same optimal cost while exploring fewer states.  Of
+// equally optimal solutions, fewer may be found, and the first may differ.
+// With 'prune_dominated_states', a state is dropped when an equivalent one
+// (same next token, column and wrap positions) of lower cost was expanded
+// already; this doesn't change the solutions found.
+std::vector<FormattedExcerpt> SearchLineWraps(
+    const UnwrappedLine& uwline, const BasicFormatStyle& style,
+    int max_search_states, LineWrapSearchStats* stats = nullptr,
+    const std::function<bool()>& is_cancelled = {},
+    absl::Time deadline = absl::InfiniteFuture(),
+    bool estimate_remaining_cost = false, bool prune_dominated_states = true);
 
 // Diagnostic helper for displaying when multiple optimal wrappings are found
 // by SearchLineWraps.  This aids in development around wrap penalty tuning.
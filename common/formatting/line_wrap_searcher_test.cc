@@ -17,6 +17,7 @@
 #include <vector>
 
 #include "absl/strings/match.h"
+#include "absl/time/time.h"
 #include "common/formatting/basic_format_style.h"
 #include "common/formatting/format_token.h"
 #include "common/formatting/unwrapped_line.h"
@@ -417,13 +418,175 @@ TEST_F(SearchLineWrapsTestFixture, AbortedSearch) {
   ftokens_in[2].before.break_penalty = 1;
   ftokens_in[2].before.spaces_required = 1;
   // Intentionally limit search space to a small count to force early abort.
-  const auto formatted_lines = verible::SearchLineWraps(uwline_in, style_, 2);
+  LineWrapSearchStats stats;
+  const auto formatted_lines =
+      verible::SearchLineWraps(uwline_in, style_, 2, &stats);
   const FormattedExcerpt& formatted_line = formatted_lines.front();
   EXPECT_EQ(formatted_line.Tokens().size(), tokens.size());
   EXPECT_FALSE(formatted_line.CompletedFormatting());
+  EXPECT_TRUE(stats.aborted);
+  EXPECT_EQ(stats.explored_states, 2);
   // The resulting state is unpredictable, because the search terminated early.
   // So we don't check any other properties of the formatted_line.
 }
 
+// Test that a cancelled search is aborted like one that ran out of states.
+TEST_F(SearchLineWrapsTestFixture, CancelledSearch) {
+  const std::vector<TokenInfo> tokens(24, TokenInfo(0, "ab"));
+  CreateTokenInfos(tokens);
+  UnwrappedLine uwline_in(LevelsToSpaces(0), pre_format_tokens_.begin());
+  AddFormatTokens(&uwline_in);
+  for (auto& ftoken : pre_format_tokens_) {
+    ftoken.before.break_penalty = 1;
+    ftoken.before.spaces_required = 1;
+  }
+  int polls = 0;
+  LineWrapSearchStats stats;
+  const auto cancelled_lines = verible::SearchLineWraps(
+      uwline_in, style_, 100000, &stats, [&polls]() {
+        ++polls;
+        return true;
+      });
+  EXPECT_EQ(polls, 1);
+  EXPECT_TRUE(stats.aborted);
+  EXPECT_EQ(stats.explored_states, 1);
+  const FormattedExcerpt& cancelled_line = cancelled_lines.front();
+  EXPECT_EQ(cancelled_line.Tokens().size(), tokens.size());
+  EXPECT_FALSE(cancelled_line.CompletedFormatting());
+
+  // Searches that are not cancelled are not affected.
+  const auto formatted_lines = verible::SearchLineWraps(
+      uwline_in, style_, 100000, &stats, []() { return false; });
+  EXPECT_FALSE(stats.aborted);
+  EXPECT_TRUE(formatted_lines.front().CompletedFormatting());
+}
+
+// Test that a search past its deadline returns a complete, greedily wrapped
+// result.
+TEST_F(SearchLineWrapsTestFixture, OutOfTimeSearch) {
+  const std::vector<TokenInfo> tokens(24, TokenInfo(0, "ab"));
+  CreateTokenInfos(tokens);
+  UnwrappedLine uwline_in(LevelsToSpaces(0), pre_format_tokens_.begin());
+  AddFormatTokens(&uwline_in);
+  for (auto& ftoken : pre_format_tokens_) {
+    ftoken.before.break_penalty = 1;
+    ftoken.before.spaces_required = 1;
+  }
+  LineWrapSearchStats stats;
+  const auto formatted_lines = verible::SearchLineWraps(
+      uwline_in, style_, 100000, &stats, {}, absl::InfinitePast());
+  ASSERT_EQ(formatted_lines.size(), 1);
+  const FormattedExcerpt& formatted_line = formatted_lines.front();
+  EXPECT_TRUE(formatted_line.CompletedFormatting());
+  EXPECT_TRUE(stats.out_of_time);
+  EXPECT_FALSE(stats.aborted);
+  EXPECT_EQ(stats.explored_states, 1);
+  // Greedy wrapping happens to be optimal here.
+  EXPECT_EQ(formatted_line.Render(),
+            "ab ab ab ab ab ab ab\n"
+            "      ab ab ab ab ab\n"
+            "      ab ab ab ab ab\n"
+            "      ab ab ab ab ab\n"
+            "      ab ab");
+
+  // Searches that finish in time are not affected.
+  verible::SearchLineWraps(uwline_in, style_, 100000, &stats, {},
+                           absl::InfiniteFuture());
+  EXPECT_FALSE(stats.out_of_time);
+}
+
+// Test that estimating the remaining cost finds an optimal solution with
+// fewer explored states.
+TEST_F(SearchLineWrapsTestFixture, EstimateRemainingCost) {
+  const std::vector<TokenInfo> tokens(24, TokenInfo(0, "ab"));
+  CreateTokenInfos(tokens);
+  UnwrappedLine uwline_in(LevelsToSpaces(0), pre_format_tokens_.begin());
+  AddFormatTokens(&uwline_in);
+  for (size_t i = 0; i < pre_format_tokens_.size(); ++i) {
+    pre_format_tokens_[i].before.break_penalty = 1 + i % 5;
+    pre_format_tokens_[i].before.spaces_required = 1;
+  }
+  pre_format_tokens_[8].before.break_decision = SpacingOptions::kMustAppend;
+  LineWrapSearchStats uniform_cost_stats;
+  const auto uniform_cost_lines = verible::SearchLineWraps(
+      uwline_in, style_, 100000, &uniform_cost_stats);
+
+  LineWrapSearchStats estimated_cost_stats;
+  const auto estimated_cost_lines =
+      verible::SearchLineWraps(uwline_in, style_, 100000, &estimated_cost_stats,
+                               {}, absl::InfiniteFuture(), true);
+  ASSERT_EQ(estimated_cost_lines.size(), 1);
+  ASSERT_EQ(uniform_cost_lines.size(), 1);
+  EXPECT_TRUE(estimated_cost_lines.front().CompletedFormatting());
+  EXPECT_EQ(estimated_cost_lines.front().Render(),
+            uniform_cost_lines.front().Render());
+  // Partial solutions that can not be completed within the optimal cost are
+  // not expanded.
+  EXPECT_LT(estimated_cost_stats.explored_states,
+            uniform_cost_stats.explored_states);
+}
+
+// Test that equivalent search states are only expanded once, which keeps
+// the search of long lines of similar tokens within a small budget.
+TEST_F(SearchLineWrapsTestFixture, DominatedStatesArePruned) {
+  const std::vector<TokenInfo> tokens(24, TokenInfo(0, "ab"));
+  CreateTokenInfos(tokens);
+  UnwrappedLine uwline_in(LevelsToSpaces(0), pre_format_tokens_.begin());
+  AddFormatTokens(&uwline_in);
+  for (auto& ftoken : pre_format_tokens_) {
+    ftoken.before.break_penalty = 1;
+    ftoken.before.spaces_required = 1;
+  }
+  // Without pruning, the number of states below the optimal cost grows
+  // exponentially with the number of tokens.
+  LineWrapSearchStats stats;
+  const auto formatted_lines =
+      verible::SearchLineWraps(uwline_in, style_, 500, &stats);
+  const FormattedExcerpt& formatted_line = formatted_lines.front();
+  EXPECT_TRUE(formatted_line.CompletedFormatting());
+  EXPECT_FALSE(stats.aborted);
+  EXPECT_LT(stats.explored_states, 500);
+  EXPECT_GT(stats.pruned_states, 0);
+  // 7 tokens fit per line: 7 * 2 + 6 = 20
+  EXPECT_EQ(formatted_line.Render(),
+            "ab ab ab ab ab ab ab\n"
+            "      ab ab ab ab ab\n"
+            "      ab ab ab ab ab\n"
+            "      ab ab ab ab ab\n"
+            "      ab ab");
+}
+
+// Test that pruning keeps all equally optimal solutions, when different
+// decisions lead to equivalent states of equal cost.
+TEST_F(SearchLineWrapsTestFixture, PruningKeepsEquallyOptimalSolutions) {
+  const std::vector<TokenInfo> tokens = {
+      {0, "aaaa"},
+      {0, "bbbb"},
+      {0, "cccc"},
+      {0, "dddd"},
+  };
+  CreateTokenInfos(tokens);
+  UnwrappedLine uwline_in(LevelsToSpaces(0), pre_format_tokens_.begin());
+  AddFormatTokens(&uwline_in);
+  for (auto& ftoken : pre_format_tokens_) {
+    ftoken.before.break_penalty = 2;
+    ftoken.before.spaces_required = 1;
+  }
+  // Wrapping before token[1] is free, and token[2] starts a new line either
+  // way, so both choices before token[1] lead to the same state.
+  pre_format_tokens_[1].before.break_penalty = 0;
+  pre_format_tokens_[2].before.break_decision = SpacingOptions::kMustWrap;
+
+  const auto pruned = verible::SearchLineWraps(uwline_in, style_, 1000);
+  const auto unpruned =
+      verible::SearchLineWraps(uwline_in, style_, 1000, nullptr, {},
+                               absl::InfiniteFuture(), false, false);
+  ASSERT_EQ(unpruned.size(), 2);
+  ASSERT_EQ(pruned.size(), unpruned.size());
+  for (size_t i = 0; i < pruned.size(); ++i) {
+    EXPECT_EQ(pruned[i].Render(), unpruned[i].Render()) << i;
+  }
+}
+
 }  // namespace
 }  // namespace verible
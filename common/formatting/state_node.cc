@@ -54,6 +54,7 @@ static SpacingDecision FrontTokenSpacing(const FormatTokenRange range) {
 
 StateNode::StateNode(const UnwrappedLine& uwline, const BasicFormatStyle& style)
     : prev_state(nullptr),
+      token_arrays(nullptr),
       undecided_path(uwline.TokensRange().begin(), uwline.TokensRange().end()),
       spacing_choice(FrontTokenSpacing(uwline.TokensRange())),
       // Kludge: This leaks into the resulting FormattedExcerpt, which means
@@ -61,6 +62,9 @@ StateNode::StateNode(const UnwrappedLine& uwline, const BasicFormatStyle& style)
       // between formatted token partitions.
       current_column(uwline.IndentationSpaces()) {
   // The starting column is relative to the current indentation level.
+  token_arrays_owner =
+      std::make_shared<const FormatTokenArrays>(uwline.TokensRange());
+  token_arrays = token_arrays_owner.get();
   VLOG(4) << "initial column position: " << current_column;
   wrap_column_positions.push(current_column + style.wrap_spaces);
   if (!uwline.TokensRange().empty()) {
@@ -78,7 +82,14 @@ StateNode::StateNode(const UnwrappedLine& uwline, const BasicFormatStyle& style)
 StateNode::StateNode(const std::shared_ptr<const StateNode>& parent,
                      const BasicFormatStyle& style,
                      SpacingDecision spacing_choice)
+    : StateNode(parent.get(), style, spacing_choice) {
+  prev_state_owner = parent;
+}
+
+StateNode::StateNode(const StateNode* parent, const BasicFormatStyle& style,
+                     SpacingDecision spacing_choice)
     : prev_state(ABSL_DIE_IF_NULL(parent)),
+      token_arrays(prev_state->token_arrays),
       undecided_path(prev_state->undecided_path.begin() + 1,  // pop_front()
                      prev_state->undecided_path.end()),
       spacing_choice(spacing_choice),
@@ -137,20 +148,18 @@ const PreFormatToken& StateNode::GetPreviousToken() const {
 // current_column for multi-line tokens.
 int StateNode::UpdateColumnPosition() {
   VLOG(4) << __FUNCTION__ << " spacing decision: " << spacing_choice;
-  const PreFormatToken& current_format_token(GetCurrentToken());
-  const int token_length = current_format_token.Length();
+  const size_t index = CurrentTokenIndex();
+  const int token_length = token_arrays->Length(index);
 
   {
     // Special handling for multi-line tokens.
     // Account for the length of text *before* the first newline that might
     // overflow the previous line (and should be penalized accordingly).
-    const auto text = current_format_token.Text();
-    const auto last_newline_pos = text.find_last_of('\n');
-    if (last_newline_pos != absl::string_view::npos) {
+    if (token_arrays->IsMultiLine(index)) {
       // There was a newline, it doesn't matter what the wrapping decision was.
       // The position is the length of the text after the last newline.
-      current_column = text.length() - last_newline_pos - 1;
-      const auto first_newline_pos = text.find_first_of('\n');
+      current_column = token_arrays->LastLineLength(index);
+      const int first_newline_pos = token_arrays->FirstLineLength(index);
       if (spacing_choice == SpacingDecision::kWrap) {
         // Record the number of spaces preceding this format token because
         // it cannot be simply inferred based on current column and
@@ -163,8 +172,8 @@ int StateNode::UpdateColumnPosition() {
       if (IsRootState()) {
         return first_newline_pos;
       }
-      return prev_state->current_column +
-             current_format_token.before.spaces_required + first_newline_pos;
+      return prev_state->current_column + token_arrays->SpacesRequired(index) +
+             first_newline_pos;
     }
   }
 
@@ -185,8 +194,7 @@ int StateNode::UpdateColumnPosition() {
       if (!IsRootState()) {
         VLOG(4) << " previous column position: " << prev_state->current_column;
         current_column = prev_state->current_column +
-                         current_format_token.before.spaces_required +
-                         token_length;
+                         token_arrays->SpacesRequired(index) + token_length;
       } else {
         VLOG(4) << " old column position: " << current_column;
         // current_column was already initialized, so just add token length.
@@ -195,7 +203,7 @@ int StateNode::UpdateColumnPosition() {
       break;
     case SpacingDecision::kPreserve: {
       const absl::string_view original_spacing_text =
-          current_format_token.OriginalLeadingSpaces();
+          GetCurrentToken().OriginalLeadingSpaces();
       // prev_state is null when the first token of the unwrapped line was
       // marked as SpacingOptions::Preserve, which indicates that formatting
       // was disabled in this range.  In this case, we don't really care about
@@ -222,12 +230,11 @@ void StateNode::UpdateCumulativeCost(const BasicFormatStyle& style,
   if (!IsRootState()) {
     CHECK_EQ(cumulative_cost, prev_state->cumulative_cost);
   }
-  const PreFormatToken& current_format_token(GetCurrentToken());
   if (spacing_choice == SpacingDecision::kWrap) {
     // Only incur the penalty for breaking before this token.
     // Newly wrapped, so don't bother checking line length and suppress
     // penalty if the first token on a line happens to exceed column limit.
-    cumulative_cost += current_format_token.before.break_penalty;
+    cumulative_cost += token_arrays->BreakPenalty(CurrentTokenIndex());
   } else if (spacing_choice == SpacingDecision::kAppend) {
     // Check for line length violation of column_for_penalty, and penalize
     // more for each column over the limit.
@@ -318,7 +325,6 @@ std::shared_ptr<const StateNode> StateNode::AppendIfItFits(
     const std::shared_ptr<const StateNode>& current_state,
     const verible::BasicFormatStyle& style) {
   if (current_state->Done()) return current_state;
-  const auto& token = current_state->GetNextToken();
   // It seems little wasteful to always create both states when only one is
   // returned, but compiler optimization should be able to leverage this.
   // In any case, this is not a critical path operation, so we're not going to
@@ -327,7 +333,8 @@ std::shared_ptr<const StateNode> StateNode::AppendIfItFits(
       std::make_shared<StateNode>(current_state, style, SpacingDecision::kWrap);
   const auto appended = std::make_shared<StateNode>(current_state, style,
                                                     SpacingDecision::kAppend);
-  return (token.before.break_decision == SpacingOptions::kMustWrap ||
+  return (current_state->NextTokenBreakDecision() ==
+              SpacingOptions::kMustWrap ||
           appended->current_column > style.column_limit)
              ? wrapped
              : appended;
@@ -345,6 +352,33 @@ std::shared_ptr<const StateNode> StateNode::QuickFinish(
   return latest;
 }
 
+const StateNode* StateNode::AppendIfItFits(const StateNode* current_state,
+                                           const BasicFormatStyle& style,
+                                           TypedArena<StateNode>* arena) {
+  if (current_state->Done()) return current_state;
+  if (current_state->NextTokenBreakDecision() == SpacingOptions::kMustWrap) {
+    return arena->New(current_state, style, SpacingDecision::kWrap);
+  }
+  // Unlike the reference-counted variant, only construct the wrapped state
+  // when it is needed, because arena nodes are not freed early.
+  const StateNode* appended =
+      arena->New(current_state, style, SpacingDecision::kAppend);
+  if (appended->current_column > style.column_limit) {
+    return arena->New(current_state, style, SpacingDecision::kWrap);
+  }
+  return appended;
+}
+
+const StateNode* StateNode::QuickFinish(const StateNode* current_state,
+                                        const BasicFormatStyle& style,
+                                        TypedArena<StateNode>* arena) {
+  const StateNode* latest = current_state;
+  while (!latest->Done()) {
+    latest = AppendIfItFits(latest, style, arena);
+  }
+  return latest;
+}
+
 void StateNode::ReconstructFormatDecisions(FormattedExcerpt* result) const {
   // Find all wrap decisions from the greatest ancestor state to this state.
 
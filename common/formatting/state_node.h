@@ -23,9 +23,11 @@
 #include <vector>
 
 #include "common/formatting/basic_format_style.h"
+#include "common/formatting/format_token_arrays.h"
 #include "common/formatting/format_token.h"
 #include "common/formatting/unwrapped_line.h"
 #include "common/util/container_iterator_range.h"
+#include "common/util/typed_arena.h"
 
 namespace verible {
 
@@ -35,13 +37,25 @@ namespace verible {
 // to its parent state, which is used for backtracking once a solution
 // is reached.  StateNode is language-agnostic.
 // StateNode is purely an implementation detail of line_wrap_searcher.cc.
+//
+// StateNodes can either be reference-counted through std::shared_ptr, where
+// each node keeps its ancestors alive, or be allocated in a StateNodeArena,
+// where all nodes of a search share the lifetime of the arena.
 struct StateNode {
   using path_type = std::vector<PreFormatToken>;
   using range_type = container_iterator_range<path_type::const_iterator>;
 
   // The StateNode that has an edge to this StateNode, to backtrack once a final
   // state is reached.
-  std::shared_ptr<const StateNode> prev_state;
+  const StateNode* prev_state = nullptr;
+
+  // Owns prev_state, only for nodes constructed with a std::shared_ptr parent.
+  // This is nullptr for nodes allocated in a StateNodeArena.
+  std::shared_ptr<const StateNode> prev_state_owner;
+
+  // Properties of the tokens of the UnwrappedLine, which are read from here
+  // instead of from the PreFormatTokens.  Owned by the root node.
+  const FormatTokenArrays* token_arrays = nullptr;
 
   // Iterator range marking the unexplored decisions beyond the current token.
   // TODO(fangism): make the iterator type a template parameter.  Might help
@@ -76,7 +90,13 @@ struct StateNode {
   // delimiter.
   // TODO(b/135730018): re-implement to minimize copying of stacks.
   // For example, use pointer or iterator to previous stack update.
-  std::stack<int> wrap_column_positions;
+  // Backed by a vector, which is much cheaper to copy than a deque.
+  class WrapColumnStack : public std::stack<int, std::vector<int>> {
+   public:
+    // Read-only access to all positions, bottom of stack first.
+    const std::vector<int>& Positions() const { return c; }
+  };
+  WrapColumnStack wrap_column_positions;
 
   // Constructor for the root node of the search path, with no parent.
   // This automatically places the first token at the beginning of a new line
@@ -91,6 +111,11 @@ struct StateNode {
   StateNode(const std::shared_ptr<const StateNode>& parent,
             const BasicFormatStyle& style, SpacingDecision spacing_choice);
 
+  // Same as above, but does not take ownership of 'parent', which must
+  // outlive this node, e.g. by being allocated in the same StateNodeArena.
+  StateNode(const StateNode* parent, const BasicFormatStyle& style,
+            SpacingDecision spacing_choice);
+
   // Returns true when the undecided_path is empty.
   // The search is over when there are no more decisions to explore.
   bool Done() const { return undecided_path.begin() == undecided_path.end(); }
@@ -108,9 +133,19 @@ struct StateNode {
     return *undecided_path.begin();
   }
 
+  // Returns the index of the next token in token_arrays.
+  size_t NextTokenIndex() const {
+    return token_arrays->Index(undecided_path.begin());
+  }
+
+  // Returns the break decision of the next token.
+  SpacingOptions NextTokenBreakDecision() const {
+    return token_arrays->BreakDecision(NextTokenIndex());
+  }
+
   // Returns pointer to previous state before this decision node.
   // This functions as a forward-iterator going up the state ancestry chain.
-  const StateNode* next() const { return prev_state.get(); }
+  const StateNode* next() const { return prev_state; }
 
   // Returns true if this state was initialized with an unwrapped line and
   // has no parent state.
@@ -123,7 +158,7 @@ struct StateNode {
     const auto* iter = this;
     while (!iter->IsRootState()) {
       ++depth;
-      iter = iter->prev_state.get();
+      iter = iter->prev_state;
     }
     return depth;
   }
@@ -140,6 +175,14 @@ struct StateNode {
       const std::shared_ptr<const StateNode>& current_state,
       const BasicFormatStyle& style);
 
+  // Variants of the above for nodes allocated in 'arena'.
+  static const StateNode* AppendIfItFits(const StateNode* current_state,
+                                         const BasicFormatStyle& style,
+                                         TypedArena<StateNode>* arena);
+  static const StateNode* QuickFinish(const StateNode* current_state,
+                                      const BasicFormatStyle& style,
+                                      TypedArena<StateNode>* arena);
+
   // Comparator provides an ordering of which paths should be explored
   // when maintained in a priority queue.  For Dijsktra-style algorithms,
   // we want to explore the min-cost paths first.
@@ -164,12 +207,21 @@ struct StateNode {
  private:
   const PreFormatToken& GetPreviousToken() const;
 
+  // Returns the index of the current token in token_arrays.
+  size_t CurrentTokenIndex() const { return NextTokenIndex() - 1; }
+
   int UpdateColumnPosition();
   void UpdateCumulativeCost(const BasicFormatStyle&, int column_for_penalty);
   void OpenGroupBalance(const BasicFormatStyle&);
   void CloseGroupBalance();
+
+  // Set for the root node only.
+  std::shared_ptr<const FormatTokenArrays> token_arrays_owner;
 };
 
+// Arena that owns all StateNodes of one search.
+using StateNodeArena = TypedArena<StateNode>;
+
 // Human-readable representation for debugging only.
 std::ostream& operator<<(std::ostream&, const StateNode&);
 
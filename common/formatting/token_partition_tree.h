@@ -25,6 +25,7 @@
 #include "common/formatting/unwrapped_line.h"
 #include "common/strings/position.h"  // for ByteOffsetSet
 #include "common/util/container_iterator_range.h"
+#include "common/util/pool_allocator.h"
 #include "common/util/vector_tree.h"
 
 namespace verible {
@@ -35,9 +36,12 @@ namespace verible {
 //      equal to that of its children.
 //   2) Adjacent siblings begin/end iterators are equal (continuity).
 //
+// The children arrays of nodes are recycled through a PoolAllocator, as the
+// formatter reshapes partitions many times.
+//
 // TODO(fangism): Promote this to a class that privately inherits the base.
 // Methods on this class will preserve invariants.
-using TokenPartitionTree = VectorTree<UnwrappedLine>;
+using TokenPartitionTree = VectorTree<UnwrappedLine, PoolAllocator>;
 using TokenPartitionIterator = TokenPartitionTree::subnodes_type::iterator;
 using TokenPartitionRange = container_iterator_range<TokenPartitionIterator>;
 
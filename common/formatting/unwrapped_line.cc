@@ -116,11 +116,19 @@ FormattedExcerpt::FormattedExcerpt(const UnwrappedLine& uwline)
 std::ostream& FormattedExcerpt::FormattedText(
     std::ostream& stream, bool indent,
     const std::function<bool(const TokenInfo&)>& include_token_p) const {
-  if (tokens_.empty()) return stream;
+  std::string text;
+  AppendFormattedText(&text, indent, include_token_p);
+  return stream << text;
+}
+
+void FormattedExcerpt::AppendFormattedText(
+    std::string* output, bool indent,
+    const std::function<bool(const TokenInfo&)>& include_token_p) const {
+  if (tokens_.empty()) return;
   // Let caller print the preceding/trailing newline.
   if (indent) {
     if (tokens_.front().before.action != SpacingDecision::kPreserve) {
-      stream << Spacer(IndentationSpaces());
+      output->append(IndentationSpaces(), ' ');
     }
   }
   // We do not want the indentation before the first token, if it was
@@ -128,20 +136,38 @@ std::ostream& FormattedExcerpt::FormattedText(
   const auto& front = tokens_.front();
   if (include_token_p(*front.token)) {
     VLOG(2) << "action: " << front.before.action;
-    switch (front.before.action) {
-      case SpacingDecision::kAlign:
-        // When aligning tokens, the first token might be further indented.
-        stream << Spacer(front.before.spaces) << front.token->text();
-        break;
-      default:
-        stream << front.token->text();
+    if (front.before.action == SpacingDecision::kAlign) {
+      // When aligning tokens, the first token might be further indented.
+      output->append(front.before.spaces, ' ');
     }
+    output->append(front.token->text().data(), front.token->text().length());
   }
   for (const auto& ftoken :
        verible::make_range(tokens_.begin() + 1, tokens_.end())) {
-    if (include_token_p(*ftoken.token)) stream << ftoken;
+    if (include_token_p(*ftoken.token)) ftoken.AppendFormattedText(output);
   }
-  return stream;
+}
+
+size_t FormattedExcerpt::FormattedTextLength(
+    bool indent,
+    const std::function<bool(const TokenInfo&)>& include_token_p) const {
+  if (tokens_.empty()) return 0;
+  size_t length = 0;
+  if (indent && tokens_.front().before.action != SpacingDecision::kPreserve) {
+    length += IndentationSpaces();
+  }
+  const auto& front = tokens_.front();
+  if (include_token_p(*front.token)) {
+    if (front.before.action == SpacingDecision::kAlign) {
+      length += front.before.spaces;
+    }
+    length += front.token->text().length();
+  }
+  for (const auto& ftoken :
+       verible::make_range(tokens_.begin() + 1, tokens_.end())) {
+    if (include_token_p(*ftoken.token)) length += ftoken.FormattedTextLength();
+  }
+  return length;
 }
 
 std::ostream& operator<<(std::ostream& stream,
@@ -150,9 +176,10 @@ std::ostream& operator<<(std::ostream& stream,
 }
 
 std::string FormattedExcerpt::Render() const {
-  std::ostringstream stream;
-  FormattedText(stream, true);
-  return stream.str();
+  std::string text;
+  text.reserve(FormattedTextLength(true));
+  AppendFormattedText(&text, true);
+  return text;
 }
 
 }  // namespace verible
@@ -15,6 +15,7 @@
 #ifndef VERIBLE_COMMON_FORMATTING_UNWRAPPED_LINE_H_
 #define VERIBLE_COMMON_FORMATTING_UNWRAPPED_LINE_H_
 
+#include <cstddef>
 #include <functional>
 #include <iosfwd>
 #include <string>
@@ -231,6 +232,19 @@ class FormattedExcerpt {
       const std::function<bool(const TokenInfo&)>& include_token_p =
           [](const TokenInfo&) { return true; }) const;
 
+  // Same as above, but appending to 'output'.
+  void AppendFormattedText(
+      std::string* output, bool indent,
+      const std::function<bool(const TokenInfo&)>& include_token_p =
+          [](const TokenInfo&) { return true; }) const;
+
+  // Returns the number of characters that FormattedText() prints, to size
+  // the output in advance.
+  size_t FormattedTextLength(
+      bool indent,
+      const std::function<bool(const TokenInfo&)>& include_token_p =
+          [](const TokenInfo&) { return true; }) const;
+
   // Returns formatted code as a string.
   std::string Render() const;
 
@@ -16,6 +16,7 @@
 
 #include <iterator>
 #include <sstream>
+#include <string>
 #include <vector>
 
 #include "common/formatting/format_token.h"
@@ -451,6 +452,43 @@ TEST_F(UnwrappedLineTest, FormattedTextPreserveNewlinesDropSpaces) {
   }
 }
 
+// Testing that AppendFormattedText() appends what FormattedText() prints,
+// of the length that FormattedTextLength() returns, for all spacing actions.
+TEST_F(UnwrappedLineTest, AppendFormattedTextMatchesStream) {
+  const absl::string_view text("  aaa \n bbb   cc dd ee");
+  const std::vector<TokenInfo> tokens = {
+      {0, text.substr(2, 3)},  {1, text.substr(8, 3)},
+      {2, text.substr(14, 2)}, {3, text.substr(17, 2)},
+      {4, text.substr(20, 2)}};
+  CreateTokenInfosExternalStringBuffer(tokens);  // use 'text' buffer
+  UnwrappedLine uwline(4, pre_format_tokens_.begin());
+  AddFormatTokens(&uwline);
+  pre_format_tokens_[1].before.preserved_space_start = text.begin() + 5;
+  FormattedExcerpt output(uwline);
+  auto& ftokens = output.MutableTokens();
+  ftokens[0].before.action = SpacingDecision::kAlign;
+  ftokens[0].before.spaces = 2;
+  ftokens[1].before.action = SpacingDecision::kPreserve;
+  ftokens[2].before.action = SpacingDecision::kWrap;
+  ftokens[2].before.spaces = 6;
+  ftokens[3].before.action = SpacingDecision::kAppend;
+  ftokens[3].before.spaces = 1;
+  ftokens[4].before.action = SpacingDecision::kAlign;
+  ftokens[4].before.spaces = 3;
+  const auto skip_dd = [](const TokenInfo& t) { return t.text() != "dd"; };
+  for (const bool indent : {false, true}) {
+    std::ostringstream stream;
+    output.FormattedText(stream, indent, skip_dd);
+    std::string appended("prefix");
+    output.AppendFormattedText(&appended, indent, skip_dd);
+    EXPECT_EQ(appended, "prefix" + stream.str());
+    EXPECT_EQ(output.FormattedTextLength(indent, skip_dd),
+              stream.str().length());
+  }
+  EXPECT_EQ(output.Render(), "      aaa \n bbb\n      cc dd   ee");
+  EXPECT_EQ(output.FormattedTextLength(true), output.Render().length());
+}
+
 // Testing AsCode() with no tokens and no indentation
 TEST_F(UnwrappedLineTest, AsCodeEmptyNoIndent) {
   const std::vector<TokenInfo> tokens;
@@ -0,0 +1,112 @@
+// Copyright 2017-2023 The Verible Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "common/lexer/bulk_scan.h"
+
+#include <cstddef>
+
+#include "absl/numeric/bits.h"
+#include "absl/strings/string_view.h"
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#elif defined(__aarch64__) && defined(__ARM_NEON)
+#include <arm_neon.h>
+
+#include <cstdint>
+#endif
+
+namespace verible {
+namespace internal {
+
+static bool Contains(absl::string_view set, char c) {
+  return set.find(c) != absl::string_view::npos;
+}
+
+size_t ScalarSpanOfBytesIn(absl::string_view text, absl::string_view set) {
+  size_t i = 0;
+  while (i < text.size() && Contains(set, text[i])) ++i;
+  return i;
+}
+
+size_t ScalarSpanOfBytesNotIn(absl::string_view text, absl::string_view set) {
+  size_t i = 0;
+  while (i < text.size() && !Contains(set, text[i])) ++i;
+  return i;
+}
+
+}  // namespace internal
+
+namespace {
+constexpr size_t kBlockSize = 16;
+
+#if defined(__SSE2__)
+// Returns a bit mask of the bytes of the 16-byte block at 'block' that are in
+// 'set': bit i is set when block[i] is.
+unsigned BlockMaskInSet(const char* block, absl::string_view set) {
+  const __m128i bytes =
+      _mm_loadu_si128(reinterpret_cast<const __m128i*>(block));
+  __m128i match = _mm_setzero_si128();
+  for (const char c : set) {
+    match = _mm_or_si128(match, _mm_cmpeq_epi8(bytes, _mm_set1_epi8(c)));
+  }
+  return static_cast<unsigned>(_mm_movemask_epi8(match));
+}
+
+// Returns the length of the prefix of all whole blocks of 'text' whose bytes
+// are in 'set' (or, if !in_set, not in 'set'), up to the first byte that is
+// not.  The remainder is left to the scalar loop.
+size_t BlockSpan(absl::string_view text, absl::string_view set, bool in_set) {
+  size_t i = 0;
+  for (; i + kBlockSize <= text.size(); i += kBlockSize) {
+    unsigned mask = BlockMaskInSet(text.data() + i, set);
+    if (in_set) mask = ~mask & 0xFFFF;
+    if (mask != 0) return i + absl::countr_zero(mask);
+  }
+  return i;
+}
+#elif defined(__aarch64__) && defined(__ARM_NEON)
+// Same as the SSE2 variant above, but without a movemask.  A block that
+// contains a stopping byte is left to the scalar loop.
+size_t BlockSpan(absl::string_view text, absl::string_view set, bool in_set) {
+  size_t i = 0;
+  for (; i + kBlockSize <= text.size(); i += kBlockSize) {
+    const uint8x16_t bytes =
+        vld1q_u8(reinterpret_cast<const uint8_t*>(text.data() + i));
+    uint8x16_t match = vdupq_n_u8(0);
+    for (const char c : set) {
+      match = vorrq_u8(match,
+                       vceqq_u8(bytes, vdupq_n_u8(static_cast<uint8_t>(c))));
+    }
+    if (!in_set) match = vmvnq_u8(match);
+    if (vminvq_u8(match) == 0) break;  // a stopping byte is in this block
+  }
+  return i;
+}
+#else
+size_t BlockSpan(absl::string_view, absl::string_view, bool) { return 0; }
+#endif
+}  // namespace
+
+size_t SpanOfBytesIn(absl::string_view text, absl::string_view set) {
+  const size_t i = BlockSpan(text, set, true);
+  return i + internal::ScalarSpanOfBytesIn(text.substr(i), set);
+}
+
+size_t SpanOfBytesNotIn(absl::string_view text, absl::string_view set) {
+  const size_t i = BlockSpan(text, set, false);
+  return i + internal::ScalarSpanOfBytesNotIn(text.substr(i), set);
+}
+
+}  // namespace verible
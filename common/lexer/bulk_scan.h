@@ -0,0 +1,45 @@
+// Copyright 2017-2023 The Verible Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// Bulk scanning of byte runs, for lexers to consume long runs of a few
+// character classes (spaces, comment bodies) faster than a byte-at-a-time
+// state machine does.  Uses SSE2 on x86-64 and NEON on AArch64, and a scalar
+// loop elsewhere.
+
+#ifndef VERIBLE_COMMON_LEXER_BULK_SCAN_H_
+#define VERIBLE_COMMON_LEXER_BULK_SCAN_H_
+
+#include <cstddef>
+
+#include "absl/strings/string_view.h"
+
+namespace verible {
+
+// Returns the length of the longest prefix of 'text' that consists only of
+// bytes in 'set', like strspn().
+size_t SpanOfBytesIn(absl::string_view text, absl::string_view set);
+
+// Returns the length of the longest prefix of 'text' that contains no bytes
+// in 'set', like strcspn(), except that NUL is an ordinary byte.
+size_t SpanOfBytesNotIn(absl::string_view text, absl::string_view set);
+
+namespace internal {
+// Scalar implementations, exposed for testing against the vectorized ones.
+size_t ScalarSpanOfBytesIn(absl::string_view text, absl::string_view set);
+size_t ScalarSpanOfBytesNotIn(absl::string_view text, absl::string_view set);
+}  // namespace internal
+
+}  // namespace verible
+
+#endif  // VERIBLE_COMMON_LEXER_BULK_SCAN_H_
@@ -0,0 +1,88 @@
+// Copyright 2017-2023 The Verible Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "common/lexer/bulk_scan.h"
+
+#include <cstddef>
+#include <string>
+
+#include "absl/strings/string_view.h"
+#include "gtest/gtest.h"
+
+namespace verible {
+namespace {
+
+constexpr absl::string_view kSpaces(" \t\f\b");
+
+TEST(SpanOfBytesInTest, Empty) {
+  EXPECT_EQ(SpanOfBytesIn("", kSpaces), 0);
+  EXPECT_EQ(SpanOfBytesIn("abc", ""), 0);
+}
+
+TEST(SpanOfBytesInTest, Short) {
+  EXPECT_EQ(SpanOfBytesIn(" \t x", kSpaces), 3);
+  EXPECT_EQ(SpanOfBytesIn("x ", kSpaces), 0);
+  EXPECT_EQ(SpanOfBytesIn("  ", kSpaces), 2);
+}
+
+TEST(SpanOfBytesNotInTest, Empty) {
+  EXPECT_EQ(SpanOfBytesNotIn("", "\n"), 0);
+  EXPECT_EQ(SpanOfBytesNotIn("abc", ""), 3);
+}
+
+TEST(SpanOfBytesNotInTest, Short) {
+  EXPECT_EQ(SpanOfBytesNotIn("abc\ndef", "\r\n"), 3);
+  EXPECT_EQ(SpanOfBytesNotIn("\nabc", "\r\n"), 0);
+  EXPECT_EQ(SpanOfBytesNotIn("abc", "\r\n"), 3);
+}
+
+TEST(SpanOfBytesNotInTest, NulIsOrdinary) {
+  constexpr absl::string_view text("ab\0cd\n", 6);
+  EXPECT_EQ(SpanOfBytesNotIn(text, "\n"), 5);
+  EXPECT_EQ(SpanOfBytesNotIn(text, absl::string_view("\0", 1)), 2);
+}
+
+// Compares against the scalar implementation for every stop position and
+// length, across block boundaries.
+TEST(SpanOfBytesTest, MatchesScalar) {
+  constexpr absl::string_view kStops("\\r\n");
+  for (size_t length = 0; length < 70; ++length) {
+    for (size_t stop = 0; stop <= length; ++stop) {
+      std::string spaces(length, ' ');
+      std::string comment(length, 'c');
+      if (stop < length) {
+        spaces[stop] = 'x';
+        comment[stop] = '\n';
+      }
+      EXPECT_EQ(SpanOfBytesIn(spaces, kSpaces),
+                internal::ScalarSpanOfBytesIn(spaces, kSpaces))
+          << length << ' ' << stop;
+      EXPECT_EQ(SpanOfBytesIn(spaces, kSpaces), stop);
+      EXPECT_EQ(SpanOfBytesNotIn(comment, kStops),
+                internal::ScalarSpanOfBytesNotIn(comment, kStops))
+          << length << ' ' << stop;
+      EXPECT_EQ(SpanOfBytesNotIn(comment, kStops), stop);
+    }
+  }
+}
+
+TEST(SpanOfBytesTest, HighBytes) {
+  const std::string text(40, '\xC3');
+  EXPECT_EQ(SpanOfBytesIn(text, "\xC3"), 40);
+  EXPECT_EQ(SpanOfBytesNotIn(text, "\n"), 40);
+  EXPECT_EQ(SpanOfBytesNotIn(text, "\xC3"), 0);
+}
+
+}  // namespace
+}  // namespace verible
@@ -32,7 +32,10 @@
 #ifndef VERIBLE_COMMON_LEXER_FLEX_LEXER_ADAPTER_H_
 #define VERIBLE_COMMON_LEXER_FLEX_LEXER_ADAPTER_H_
 
+#include <algorithm>
+#include <cstddef>
 #include <cstdlib>
+#include <cstring>
 #include <iostream>
 #include <sstream>  // IWYU pragma: keep  // for ostringstream
 #include <string>
@@ -51,12 +54,9 @@ namespace verible {
 // ordered before "L" in FlexLexerAdaptor's base classes.
 class CodeStreamHolder {
  protected:
-  // The stream object conforms to the FlexLexer input interface.
-  // Even though scanning is done on the stream's internal copy of the input
-  // string, the byte offsets being tracked can be used to construct
-  // string_views based on the original string's start address.
-  // Using the standard istream interface also lets us switch buffers, e.g.
-  // during preprocessing.
+  // The stream object conforms to the FlexLexer input interface, but stays
+  // empty: FlexLexerAdapter::LexerInput() reads the input text directly from
+  // the original memory, instead of from a copy in the stream.
   std::istringstream code_stream_;
 };
 
@@ -68,14 +68,16 @@ class FlexLexerAdapter : private CodeStreamHolder, protected L, public Lexer {
       : L(&code_stream_),
         code_(code),
         // last_token_ points to the beginning of the code_ buffer
-        last_token_(0 /* enum doesn't matter */, code_.substr(0, 0)) {
-    code_stream_.str(std::string(code));
-    // istringstream copies text into its own internal buffer.
-  }
+        last_token_(0 /* enum doesn't matter */, code_.substr(0, 0)) {}
 
   // Returns the token associated with the last UpdateLocation() call.
   const TokenInfo& GetLastToken() const final { return last_token_; }
 
+  // True outside of all start conditions (BEGIN, yy_push_state()).
+  bool InInitialState() const override {
+    return L::yy_start == 1 && L::yy_start_stack_ptr == 0;
+  }
+
   // Returns next token and updates its location.
   const TokenInfo& DoNextToken() override {
     if (at_eof_) {
@@ -111,7 +113,7 @@ class FlexLexerAdapter : private CodeStreamHolder, protected L, public Lexer {
   void Restart(absl::string_view code) override {
     at_eof_ = false;
     code_ = code;
-    code_stream_.str(std::string(code_));
+    input_offset_ = 0;
     last_token_ = TokenInfo(0, code_.substr(0, 0));
 
     // Reset buffer stack.
@@ -126,6 +128,22 @@ class FlexLexerAdapter : private CodeStreamHolder, protected L, public Lexer {
     while (L::yy_start_stack_ptr > 1) {  // Keep INITIAL state.
       L::yy_pop_state();
     }
+    // The previous input may have ended in any start condition, e.g. when
+    // the caller stopped before EOF, so that a reused lexer would otherwise
+    // resume in it.
+    L::yy_start_stack_ptr = 0;
+    L::yy_start = 1;  // BEGIN(INITIAL)
+  }
+
+  // Overrides yyFlexLexer's implementation to read the next chunk of input
+  // straight from code_.  This is the C++ scanner's equivalent of YY_INPUT.
+  int LexerInput(char* buf, int max_size) final {
+    const size_t size =
+        std::min(static_cast<size_t>(max_size), code_.size() - input_offset_);
+    if (size == 0) return 0;  // end of input
+    std::memcpy(buf, code_.data() + input_offset_, size);
+    input_offset_ += size;
+    return static_cast<int>(size);
   }
 
   // Overrides yyFlexLexer's implementation to handle unrecognized chars.
@@ -152,6 +170,10 @@ class FlexLexerAdapter : private CodeStreamHolder, protected L, public Lexer {
   // A read-only view of the entire text to be scanned.
   absl::string_view code_;
 
+  // Offset of the part of code_ that LexerInput() has not yet passed to the
+  // scanner.
+  size_t input_offset_ = 0;
+
   // Contains the enumeration and the substring slice of the last lexed token.
   TokenInfo last_token_;
 
@@ -41,6 +41,12 @@ class Lexer {
   // Return true if token is a lexical error.
   virtual bool TokenIsError(const TokenInfo&) const = 0;
 
+  // Returns true if the lexer is in the state it starts in, so that lexing
+  // the rest of the input after Restart()-ing on it would give the same
+  // tokens, as long as the last token ended a line.  Lexers that can't tell
+  // return false.
+  virtual bool InInitialState() const { return false; }
+
  protected:
   Lexer() = default;
 };
@@ -14,10 +14,19 @@
 
 #include "common/lexer/token_stream_adapter.h"
 
+#include <algorithm>
+#include <cstddef>
+#include <functional>
+#include <memory>
+#include <utility>
+#include <vector>
+
 #include "absl/status/status.h"
+#include "absl/strings/string_view.h"
 #include "common/lexer/lexer.h"
 #include "common/lexer/token_generator.h"
 #include "common/text/token_info.h"
+#include "common/util/thread_pool.h"
 
 namespace verible {
 
@@ -47,4 +56,98 @@ absl::Status MakeTokenSequence(
   return absl::OkStatus();
 }
 
+namespace {
+// Tokens of 'text' from 'begin' up to the first point at or after 'stop_at'
+// where lexing can be resumed from the initial state, or up to the end.
+struct LexedPart {
+  TokenSequence tokens;
+  size_t end = 0;
+  bool at_eof = false;
+  bool has_error = false;
+};
+}  // namespace
+
+static LexedPart LexPart(Lexer* lexer, absl::string_view text, size_t begin,
+                         size_t stop_at) {
+  LexedPart part;
+  lexer->Restart(text.substr(begin));
+  for (;;) {
+    const TokenInfo& token = lexer->DoNextToken();
+    if (token.isEOF()) {
+      part.end = text.size();
+      part.at_eof = true;
+      return part;
+    }
+    if (lexer->TokenIsError(token)) {
+      part.has_error = true;
+      return part;
+    }
+    part.tokens.push_back(token);
+    const size_t end = token.text().end() - text.begin();
+    if (end >= stop_at && end < text.size() && text[end - 1] == '\n' &&
+        lexer->InInitialState()) {
+      part.end = end;
+      return part;
+    }
+  }
+}
+
+absl::Status MakeTokenSequenceInParallel(
+    const std::function<std::unique_ptr<Lexer>()>& make_lexer,
+    absl::string_view text, size_t min_part_size, int threads,
+    TokenSequence* tokens,
+    const std::function<void(const TokenInfo&)>& error_token_handler) {
+  const auto lex_serially = [&]() {
+    return MakeTokenSequence(make_lexer().get(), text, tokens,
+                             error_token_handler);
+  };
+  // Parts start after the first newline that is at least min_part_size bytes
+  // after the start of the previous one.
+  min_part_size = std::max<size_t>(min_part_size, 1);
+  std::vector<size_t> starts = {0};
+  while (threads > 1 && text.size() - starts.back() >= 2 * min_part_size) {
+    const size_t newline = text.find('\n', starts.back() + min_part_size - 1);
+    if (newline == absl::string_view::npos ||
+        text.size() - (newline + 1) < min_part_size) {
+      break;
+    }
+    starts.push_back(newline + 1);
+  }
+  if (starts.size() == 1) return lex_serially();
+
+  std::vector<LexedPart> parts(starts.size());
+  ThreadPool pool(std::min<int>(threads, parts.size()) - 1);
+  pool.ParallelFor(parts.size(), [&](size_t i) {
+    const size_t stop_at = i + 1 < starts.size() ? starts[i + 1] : text.size();
+    parts[i] = LexPart(make_lexer().get(), text, starts[i], stop_at);
+  });
+
+  // Each part ends where lexing can be resumed from the initial state; the
+  // part that starts there is right, otherwise lex again from there.
+  const size_t tokens_before = tokens->size();
+  size_t next_part = 0;
+  for (size_t position = 0;;) {
+    while (next_part < starts.size() && starts[next_part] < position) {
+      ++next_part;
+    }
+    LexedPart part;
+    if (next_part < starts.size() && starts[next_part] == position) {
+      part = std::move(parts[next_part++]);
+    } else {
+      part = LexPart(make_lexer().get(), text, position,
+                     next_part < starts.size() ? starts[next_part]
+                                               : text.size());
+    }
+    if (part.has_error) {
+      tokens->erase(tokens->begin() + tokens_before, tokens->end());
+      return lex_serially();
+    }
+    tokens->insert(tokens->end(), part.tokens.begin(), part.tokens.end());
+    if (part.at_eof) break;
+    position = part.end;
+  }
+  tokens->push_back(TokenInfo::EOFToken(text));
+  return absl::OkStatus();
+}
+
 }  // namespace verible
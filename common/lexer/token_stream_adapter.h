@@ -17,8 +17,10 @@
 #ifndef VERIBLE_COMMON_LEXER_TOKEN_STREAM_ADAPTER_H_
 #define VERIBLE_COMMON_LEXER_TOKEN_STREAM_ADAPTER_H_
 
+#include <cstddef>
 #include <functional>
 #include <iterator>
+#include <memory>
 #include <type_traits>
 
 #include "absl/status/status.h"
@@ -38,6 +40,21 @@ absl::Status MakeTokenSequence(
     Lexer* lexer, absl::string_view text, TokenSequence* tokens,
     const std::function<void(const TokenInfo&)>& error_token_handler);
 
+// Like MakeTokenSequence(), with the same result, but lexes parts of 'text'
+// of at least 'min_part_size' bytes on up to 'threads' threads, each with a
+// new lexer of 'make_lexer' (which must be thread-safe).
+// Parts start after a newline, and are lexed as if the lexer was in its
+// initial state there.  Where that turns out to be wrong, because at the end
+// of the previous part, the lexer is not in its initial state
+// (Lexer::InInitialState()) after a token that ends a line, e.g. in a block
+// comment, lexing continues from the end of the previous part instead.
+// Lexical errors are reported by lexing all of 'text' again in one thread.
+absl::Status MakeTokenSequenceInParallel(
+    const std::function<std::unique_ptr<Lexer>()>& make_lexer,
+    absl::string_view text, size_t min_part_size, int threads,
+    TokenSequence* tokens,
+    const std::function<void(const TokenInfo&)>& error_token_handler);
+
 // Generic container-to-iterator-generator adapter.
 // Once the end is reached, keep returning the end iterator.
 template <class Container>
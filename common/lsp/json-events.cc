@@ -0,0 +1,212 @@
+// Copyright 2023 The Verible Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "common/lsp/json-events.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "absl/strings/string_view.h"
+#include "nlohmann/json.hpp"
+
+namespace verible {
+namespace lsp {
+namespace {
+using Type = JsonEvent::Type;
+
+// Records the events of nlohmann::json::sax_parse().
+class EventRecorder {
+ public:
+  explicit EventRecorder(std::vector<JsonEvent> *events) : events_(events) {}
+
+  bool null() { return Add(Type::kNull) != nullptr; }
+  bool boolean(bool value) {
+    Add(Type::kBoolean)->boolean = value;
+    return true;
+  }
+  bool number_integer(int64_t value) {
+    Add(Type::kInteger)->integer = value;
+    return true;
+  }
+  bool number_unsigned(uint64_t value) {
+    Add(Type::kUnsigned)->unsigned_integer = value;
+    return true;
+  }
+  bool number_float(double value, const std::string &) {
+    Add(Type::kFloat)->floating = value;
+    return true;
+  }
+  bool string(std::string &value) {
+    Add(Type::kString)->text = std::move(value);
+    return true;
+  }
+  bool binary(nlohmann::json::binary_t &) { return false; }  // Not JSON text.
+  bool start_object(size_t) { return Add(Type::kStartObject) != nullptr; }
+  bool key(std::string &value) {
+    Add(Type::kKey)->text = std::move(value);
+    return true;
+  }
+  bool end_object() { return Add(Type::kEndObject) != nullptr; }
+  bool start_array(size_t) { return Add(Type::kStartArray) != nullptr; }
+  bool end_array() { return Add(Type::kEndArray) != nullptr; }
+  bool parse_error(size_t, const std::string &,
+                   const nlohmann::json::exception &e) {
+    error_ = e.what();
+    return false;
+  }
+
+  const std::string &error() const { return error_; }
+
+ private:
+  JsonEvent *Add(Type type) {
+    JsonEvent &event = events_->emplace_back();
+    event.type = type;
+    return &event;
+  }
+
+  std::vector<JsonEvent> *const events_;
+  std::string error_;
+};
+}  // namespace
+
+bool JsonEvents::Parse(absl::string_view json, std::string *error) {
+  events_.clear();
+  EventRecorder recorder(&events_);
+  if (nlohmann::json::sax_parse(json.data(), json.data() + json.size(),
+                                &recorder)) {
+    return true;
+  }
+  *error = recorder.error().empty() ? "Invalid JSON." : recorder.error();
+  return false;
+}
+
+bool JsonEventReader::Consume(Type type) {
+  if (next_ == end_ || next_->type != type) return false;
+  ++next_;
+  return true;
+}
+
+bool JsonEventReader::ReadNull() { return Consume(Type::kNull); }
+
+bool JsonEventReader::Read(bool *value) {
+  if (next_ == end_ || next_->type != Type::kBoolean) return false;
+  *value = next_++->boolean;
+  return true;
+}
+
+bool JsonEventReader::Read(int *value) {
+  if (next_ == end_) return false;
+  switch (next_->type) {
+    case Type::kInteger:
+      *value = static_cast<int>(next_->integer);
+      break;
+    case Type::kUnsigned:
+      *value = static_cast<int>(next_->unsigned_integer);
+      break;
+    case Type::kFloat:
+      *value = static_cast<int>(next_->floating);
+      break;
+    default:
+      return false;
+  }
+  ++next_;
+  return true;
+}
+
+bool JsonEventReader::Read(std::string *value) {
+  if (next_ == end_ || next_->type != Type::kString) return false;
+  *value = std::move(next_++->text);
+  return true;
+}
+
+bool JsonEventReader::Read(nlohmann::json *value) {
+  if (next_ == end_) return false;
+  JsonEvent &event = *next_++;
+  switch (event.type) {
+    case Type::kNull:
+      *value = nullptr;
+      return true;
+    case Type::kBoolean:
+      *value = event.boolean;
+      return true;
+    case Type::kInteger:
+      *value = event.integer;
+      return true;
+    case Type::kUnsigned:
+      *value = event.unsigned_integer;
+      return true;
+    case Type::kFloat:
+      *value = event.floating;
+      return true;
+    case Type::kString:
+      *value = std::move(event.text);
+      return true;
+    case Type::kStartObject: {
+      *value = nlohmann::json::object();
+      absl::string_view key;
+      while (NextKey(&key)) {
+        if (!Read(&(*value)[std::string(key)])) return false;
+      }
+      return !failed_;
+    }
+    case Type::kStartArray:
+      *value = nlohmann::json::array();
+      while (!Consume(Type::kEndArray)) {
+        if (!Read(&value->emplace_back())) return false;
+      }
+      return true;
+    default:
+      --next_;
+      return false;
+  }
+}
+
+bool JsonEventReader::NextKey(absl::string_view *key) {
+  if (Consume(Type::kEndObject)) return false;
+  if (next_ == end_ || next_->type != Type::kKey) {
+    failed_ = true;
+    return false;
+  }
+  *key = next_++->text;
+  return true;
+}
+
+bool JsonEventReader::Skip() {
+  int depth = 0;
+  do {
+    if (next_ == end_) return false;
+    switch (next_++->type) {
+      case Type::kStartObject:
+      case Type::kStartArray:
+        ++depth;
+        break;
+      case Type::kEndObject:
+      case Type::kEndArray:
+        if (--depth < 0) return false;
+        break;
+      case Type::kKey:
+        if (depth == 0) return false;  // Not a value.
+        break;
+      default:
+        break;
+    }
+  } while (depth > 0);
+  return true;
+}
+
+}  // namespace lsp
+}  // namespace verible
@@ -0,0 +1,158 @@
+// Copyright 2023 The Verible Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// Reading JSON without building a nlohmann::json DOM, for the streaming
+// (de)serializers that jcxxgen generates with --streaming_header:
+//
+//   struct Foo {
+//     void SerializeTo(JsonWriter *out) const;
+//     bool DeserializeFrom(JsonEventReader *in);
+//   };
+//
+// Parsing records the events of the nlohmann::json SAX parser in a flat
+// vector, from which values are read front to back.  Only json properties of
+// type "object" are turned into a DOM.  Writing is left to JsonWriter.
+
+#ifndef VERIBLE_COMMON_LSP_JSON_EVENTS_H
+#define VERIBLE_COMMON_LSP_JSON_EVENTS_H
+
+#include <cstdint>
+#include <string>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "absl/strings/string_view.h"
+#include "common/util/json_writer.h"
+#include "nlohmann/json.hpp"
+
+namespace verible {
+namespace lsp {
+
+// One event of the SAX parser.
+struct JsonEvent {
+  enum class Type : uint8_t {
+    kNull,
+    kBoolean,
+    kInteger,
+    kUnsigned,
+    kFloat,
+    kString,
+    kKey,
+    kStartObject,
+    kEndObject,
+    kStartArray,
+    kEndArray,
+  };
+
+  Type type;
+  union {
+    bool boolean;
+    int64_t integer = 0;
+    uint64_t unsigned_integer;
+    double floating;
+  };
+  std::string text;  // of kString and kKey
+};
+
+// The events of parsing one JSON text.
+class JsonEvents {
+ public:
+  // Parses 'json': true on success, otherwise 'error' tells why,
+  // e.g. "[json.exception.parse_error.101] parse error at line 1, ...".
+  bool Parse(absl::string_view json, std::string *error);
+
+  std::vector<JsonEvent> &events() { return events_; }
+  const std::vector<JsonEvent> &events() const { return events_; }
+
+ private:
+  std::vector<JsonEvent> events_;
+};
+
+// Reads values from events, front to back.  Reading a value of one type
+// fails when the next value is of an incompatible type; as with
+// nlohmann::json, numbers convert to each other.  Strings are moved out of
+// the events.
+class JsonEventReader {
+ public:
+  // Reads events [begin, end).
+  JsonEventReader(JsonEvent *begin, JsonEvent *end) : next_(begin), end_(end) {}
+  explicit JsonEventReader(JsonEvents *events)
+      : JsonEventReader(events->events().data(),
+                        events->events().data() + events->events().size()) {}
+
+  // Returns true if all events are read.
+  bool AtEnd() const { return next_ == end_; }
+
+  // The next event to read.
+  JsonEvent *position() const { return next_; }
+
+  // Reads a null value, if that is next.
+  bool ReadNull();
+
+  bool Read(bool *value);
+  bool Read(int *value);
+  bool Read(std::string *value);
+  // Reads any value.
+  bool Read(nlohmann::json *value);
+
+  template <typename T>
+  bool Read(std::vector<T> *values) {
+    if (!Consume(JsonEvent::Type::kStartArray)) return false;
+    values->clear();
+    while (!Consume(JsonEvent::Type::kEndArray)) {
+      if (!Read(&values->emplace_back())) return false;
+    }
+    return true;
+  }
+
+  // Reads structs that deserialize themselves, like those of jcxxgen.
+  template <typename T>
+  auto Read(T *value) -> decltype(value->DeserializeFrom(this)) {
+    return value->DeserializeFrom(this);
+  }
+
+  // Reads the start of an object.
+  bool BeginObject() { return Consume(JsonEvent::Type::kStartObject); }
+
+  // Reads the key of the next property of an object, which the value
+  // follows, or the end of the object, then returning false.  Check
+  // Failed() to tell apart a malformed object.
+  bool NextKey(absl::string_view *key);
+
+  // Skips the next value.
+  bool Skip();
+
+  // Returns true if events ended unexpectedly, e.g. in NextKey().
+  bool Failed() const { return failed_; }
+
+ private:
+  bool Consume(JsonEvent::Type type);
+
+  JsonEvent *next_;
+  JsonEvent *const end_;
+  bool failed_ = false;
+};
+
+// True for structs that write themselves with SerializeTo(JsonWriter *).
+template <typename T, typename = void>
+struct IsJsonWriterSerializable : std::false_type {};
+template <typename T>
+struct IsJsonWriterSerializable<
+    T, std::void_t<decltype(std::declval<const T &>().SerializeTo(
+           std::declval<JsonWriter *>()))>> : std::true_type {};
+
+}  // namespace lsp
+}  // namespace verible
+#endif  // VERIBLE_COMMON_LSP_JSON_EVENTS_H
@@ -0,0 +1,123 @@
+// Copyright 2023 The Verible Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "common/lsp/json-events.h"
+
+#include <string>
+#include <vector>
+
+#include "absl/strings/string_view.h"
+#include "gtest/gtest.h"
+#include "nlohmann/json.hpp"
+
+namespace verible {
+namespace lsp {
+namespace {
+
+TEST(JsonEventsTest, ParseErrorIsReported) {
+  JsonEvents events;
+  std::string error;
+  EXPECT_FALSE(events.Parse("{\"a\": ", &error));
+  EXPECT_NE(error.find("parse_error"), std::string::npos) << error;
+}
+
+TEST(JsonEventsTest, ReadValues) {
+  JsonEvents events;
+  std::string error;
+  ASSERT_TRUE(events.Parse(R"([true, 42, 7.0, "foo\n", null, [1, 2]])",
+                           &error))
+      << error;
+  // Reading a struct that way from the events of an array fails.
+  JsonEventReader wrong_reader(&events);
+  absl::string_view key;
+  EXPECT_FALSE(wrong_reader.BeginObject());
+  EXPECT_FALSE(wrong_reader.NextKey(&key));
+  EXPECT_TRUE(wrong_reader.Failed());
+
+  std::vector<nlohmann::json> values;
+  JsonEventReader reader(&events);
+  ASSERT_TRUE(reader.Read(&values));
+  EXPECT_TRUE(reader.AtEnd());
+  EXPECT_EQ(nlohmann::json(values),
+            nlohmann::json::parse(R"([true, 42, 7.0, "foo\n", null, [1, 2]])"));
+}
+
+TEST(JsonEventsTest, ReadObject) {
+  JsonEvents events;
+  std::string error;
+  ASSERT_TRUE(events.Parse(R"({"b": true, "i": 42, "f": 7.0, "s": "foo\n",
+                               "skip": {"x": [1, {"y": 2}]}, "v": [1, 2],
+                               "n": null, "j": {"k": [null, "z"]}})",
+                           &error))
+      << error;
+  JsonEventReader reader(&events);
+  ASSERT_TRUE(reader.BeginObject());
+  bool b = false;
+  int i = 0;
+  int f = 0;
+  std::string s;
+  std::vector<int> v = {5};
+  nlohmann::json j;
+  bool is_null = false;
+  absl::string_view key;
+  while (reader.NextKey(&key)) {
+    if (key == "b") {
+      EXPECT_FALSE(reader.Read(&s));  // Type mismatch.
+      EXPECT_TRUE(reader.Read(&b));
+    } else if (key == "i") {
+      EXPECT_TRUE(reader.Read(&i));
+    } else if (key == "f") {
+      EXPECT_TRUE(reader.Read(&f));
+    } else if (key == "s") {
+      EXPECT_TRUE(reader.Read(&s));
+    } else if (key == "v") {
+      EXPECT_TRUE(reader.Read(&v));
+    } else if (key == "n") {
+      is_null = reader.ReadNull();
+    } else if (key == "j") {
+      EXPECT_TRUE(reader.Read(&j));
+    } else {
+      EXPECT_EQ(key, "skip");
+      EXPECT_TRUE(reader.Skip());
+    }
+  }
+  EXPECT_FALSE(reader.Failed());
+  EXPECT_TRUE(reader.AtEnd());
+  EXPECT_TRUE(b);
+  EXPECT_EQ(i, 42);
+  EXPECT_EQ(f, 7);
+  EXPECT_EQ(s, "foo\n");
+  EXPECT_EQ(v, (std::vector<int>{1, 2}));
+  EXPECT_TRUE(is_null);
+  EXPECT_EQ(j, nlohmann::json::parse(R"({"k": [null, "z"]})"));
+}
+
+TEST(JsonEventsTest, MalformedObjectFails) {
+  JsonEvents events;
+  std::string error;
+  ASSERT_TRUE(events.Parse(R"([{"a": 1}])", &error)) << error;
+  // Reading only part of the events.
+  JsonEventReader reader(events.events().data() + 1,
+                         events.events().data() + 4);
+  ASSERT_TRUE(reader.BeginObject());
+  absl::string_view key;
+  ASSERT_TRUE(reader.NextKey(&key));
+  EXPECT_TRUE(reader.Skip());
+  EXPECT_FALSE(reader.NextKey(&key));
+  EXPECT_TRUE(reader.Failed());
+}
+
+}  // namespace
+}  // namespace lsp
+}  // namespace verible
@@ -14,28 +14,95 @@
 
 #include "common/lsp/json-rpc-dispatcher.h"
 
+#include <memory>
+#include <mutex>
+#include <string>
+#include <utility>
+
+#include "common/lsp/json-events.h"
 #include "common/util/logging.h"
+#include "common/util/thread_pool.h"
 
 namespace verible {
 namespace lsp {
+JsonRpcDispatcher::~JsonRpcDispatcher() { WaitForPendingRequests(); }
+
+void JsonRpcDispatcher::ProcessRequestsConcurrently(int threads) {
+  CHECK(!workers_) << "Concurrent request processing already enabled.";
+  if (threads > 0) workers_ = std::make_unique<ThreadPool>(threads);
+}
+
+void JsonRpcDispatcher::WriteInBackground(MessageWriter::FlushFun flush) {
+  CHECK(!writer_) << "Writing in background already enabled.";
+  writer_ = std::make_unique<MessageWriter>(write_fun_, std::move(flush));
+}
+
+void JsonRpcDispatcher::WaitForPendingRequests() {
+  {
+    std::unique_lock<std::mutex> l(pending_lock_);
+    pending_done_.wait(l, [this]() { return pending_requests_ == 0; });
+  }
+  if (writer_) writer_->Flush();
+}
+
+const nlohmann::json &JsonRpcDispatcher::MessageParams::Json() {
+  if (!has_json_) {
+    has_json_ = true;
+    json_ = nlohmann::json::object();
+    JsonEventReader reader(begin_, end_);
+    if (begin_ != end_ && !reader.Read(&json_)) json_ = nullptr;
+  }
+  return json_;
+}
+
+// Reads the top-level properties of a request into "request", except for the
+// params, whose events are returned in [params_begin, params_end).
+static void ReadRequest(JsonEvents *events, nlohmann::json *request,
+                        JsonEvent **params_begin, JsonEvent **params_end) {
+  JsonEvent *const begin = events->events().data();
+  JsonEvent *const end = begin + events->events().size();
+  *params_begin = *params_end = end;
+  JsonEventReader reader(begin, end);
+  if (!reader.BeginObject()) {  // Not a request, but json nonetheless.
+    JsonEventReader(begin, end).Read(request);
+    return;
+  }
+  *request = nlohmann::json::object();
+  absl::string_view key;
+  while (reader.NextKey(&key)) {
+    if (key == "params") {
+      *params_begin = reader.position();
+      reader.Skip();
+      *params_end = reader.position();
+      continue;
+    }
+    reader.Read(&(*request)[std::string(key)]);
+  }
+}
+
 void JsonRpcDispatcher::DispatchMessage(absl::string_view data) {
-  nlohmann::json request;
-  try {
-    request = nlohmann::json::parse(data);
-  } catch (const std::exception &e) {
-    ++statistic_counters_[e.what()];
-    ++exception_count_;
-    SendReply(CreateError(request, kParseError, e.what()));
+  JsonEvents events;
+  std::string error;
+  if (!latencies_.Time("json decode",
+                       [&]() { return events.Parse(data, &error); })) {
+    CountException(error);
+    SendReply(CreateError(nlohmann::json(), kParseError, error));
     return;
   }
+  nlohmann::json request;
+  JsonEvent *params_begin;
+  JsonEvent *params_end;
+  ReadRequest(&events, &request, &params_begin, &params_end);
+  MessageParams params(params_begin, params_end);
 
-  if (request.find("method") == request.end()) {
+  const auto found_method = request.find("method");
+  if (found_method == request.end() || !found_method->is_string()) {
     SendReply(
         CreateError(request, kMethodNotFound, "Method required in request"));
-    ++statistic_counters_["Request without method"];
+    CountStat("Request without method");
     return;
   }
-  const std::string &method = request["method"];
+  const std::string &method = found_method->get_ref<const std::string &>();
 
   // Direct dispatch, later maybe send to an executor that returns futures ?
   const bool is_notification = (request.find("id") == request.end());
@@ -43,12 +110,14 @@ void JsonRpcDispatcher::DispatchMessage(absl::string_view data) {
           << " '" << method << "'; req-size: " << data.size();
   bool handled = false;
   if (is_notification) {
-    handled = CallNotification(request, method);
+    handled = CallNotification(method, &params);
   } else {
+    // The request handlers get the params as part of the request.
+    if (params_begin != params_end) request["params"] = params.Json();
     handled = CallRequestHandler(request, method);
   }
-  ++statistic_counters_[method + (handled ? "" : " (unhandled)") +
-                        (is_notification ? "  ev" : " RPC")];
+  CountStat(method + (handled ? "" : " (unhandled)") +
+            (is_notification ? "  ev" : " RPC"));
 }
 
 // Methods/Notifications without parameters can also send nothing for "params".
@@ -59,8 +128,11 @@ static const nlohmann::json &ExtractParams(const nlohmann::json &request) {
   return found != request.end() ? *found : empty_params;
 }
 
-bool JsonRpcDispatcher::CallNotification(const nlohmann::json &req,
-                                         const std::string &method) {
+bool JsonRpcDispatcher::CallNotification(const std::string &method,
+                                         MessageParams *params) {
+  if (method == "$/cancelRequest" && !notifications_.count(method)) {
+    return CancelRequest(params->Json());
+  }
   const auto &found = notifications_.find(method);
   if (found == notifications_.end()) {
     LOG(INFO) << "Ignoring notification '" << method << "'";
@@ -68,11 +140,10 @@ bool JsonRpcDispatcher::CallNotification(const nlohmann::json &req,
   }
   const auto &fun_to_call = found->second;
   try {
-    fun_to_call(ExtractParams(req));
+    latencies_.Time(method, [&]() { fun_to_call(params); });
     return true;
   } catch (const std::exception &e) {
-    ++exception_count_;
-    ++statistic_counters_[method + " : " + e.what()];
+    CountException(method + " : " + e.what());
     LOG(ERROR) << "Notification error for '" << method << "' :" << e.what();
   }
   return false;
@@ -80,6 +151,10 @@ bool JsonRpcDispatcher::CallNotification(const nlohmann::json &req,
 
 bool JsonRpcDispatcher::CallRequestHandler(const nlohmann::json &req,
                                            const std::string &method) {
+  const auto &found_async = async_handlers_.find(method);
+  if (found_async != async_handlers_.end()) {
+    return CallAsyncRequestHandler(req, method, found_async->second);
+  }
   const auto &found = handlers_.find(method);
   if (found == handlers_.end()) {
     SendReply(CreateError(req, kMethodNotFound,
@@ -88,24 +163,132 @@ bool JsonRpcDispatcher::CallRequestHandler(const nlohmann::json &req,
     return false;
   }
   const auto &fun_to_call = found->second;
+  return Respond(req, method,
+                 [&]() { return fun_to_call(ExtractParams(req)); });
+}
+
+bool JsonRpcDispatcher::CallAsyncRequestHandler(
+    const nlohmann::json &req, const std::string &method,
+    const RPCAsyncCallHandler &fun) {
+  // The snapshot is taken in order with all other messages.
+  std::function<Result(const IsCancelled &)> compute_response;
   try {
-    SendReply(MakeResponse(req, fun_to_call(ExtractParams(req))));
+    compute_response = fun(ExtractParams(req));
+  } catch (const std::exception &e) {
+    CountException(method + " : " + e.what());
+    SendReply(CreateError(req, kInternalError, e.what()));
+    LOG(ERROR) << "Method error for '" << method << "' :" << e.what();
+    return false;
+  }
+  if (!workers_) {
+    return Respond(req, method,
+                   [&]() { return compute_response([]() { return false; }); });
+  }
+
+  const std::string id = req["id"].dump();
+  auto request = std::make_shared<InFlightRequest>();
+  {
+    const std::lock_guard<std::mutex> l(pending_lock_);
+    in_flight_requests_[id] = request;
+    ++pending_requests_;
+  }
+  workers_->ExecAsync<bool>([this, req, method, compute_response, id,
+                             request]() {
+    bool cancelled;
+    {
+      const std::lock_guard<std::mutex> l(pending_lock_);
+      // Requests cancelled before they started have already been answered.
+      cancelled = request->cancelled;
+      request->started = true;
+    }
+    const IsCancelled is_cancelled = [&request]() {
+      return request->cancelled.load();
+    };
+    const bool handled =
+        !cancelled &&
+        Respond(
+            req, method, [&]() { return compute_response(is_cancelled); },
+            &request->cancelled);
+    // Notify while holding the lock: once a waiter sees no pending requests,
+    // the dispatcher might be gone.
+    const std::lock_guard<std::mutex> l(pending_lock_);
+    const auto found = in_flight_requests_.find(id);
+    if (found != in_flight_requests_.end() && found->second == request) {
+      in_flight_requests_.erase(found);
+    }
+    --pending_requests_;
+    pending_done_.notify_all();
+    return handled;
+  });
+  return true;
+}
+
+bool JsonRpcDispatcher::Respond(const nlohmann::json &req,
+                                const std::string &method,
+                                const std::function<Result()> &fun,
+                                const std::atomic<bool> *cancelled) {
+  try {
+    const Result result = latencies_.Time(method, fun);
+    if (cancelled != nullptr && *cancelled) {
+      SendReply(CreateError(req, kRequestCancelled, "Request cancelled"));
+      return false;
+    }
+    if (result.is_serialized()) {
+      std::string response;
+      latencies_.Time("json encode", [&]() {
+        response = MakeSerializedResponse(req, result.serialized());
+      });
+      SendSerializedReply(response);
+    } else {
+      SendReply(MakeResponse(req, result.json()));
+    }
     return true;
+  } catch (const Error &e) {
+    CountStat(method + " : " + e.what());
+    SendReply(CreateError(req, e.code(), e.what()));
   } catch (const std::exception &e) {
-    ++exception_count_;
-    ++statistic_counters_[method + " : " + e.what()];
+    CountException(method + " : " + e.what());
     SendReply(CreateError(req, kInternalError, e.what()));
     LOG(ERROR) << "Method error for '" << method << "' :" << e.what();
   }
   return false;
 }
 
+bool JsonRpcDispatcher::CancelRequest(const nlohmann::json &params) {
+  const auto found_id = params.find("id");
+  if (found_id == params.end()) return false;
+  {
+    const std::lock_guard<std::mutex> l(pending_lock_);
+    const auto found = in_flight_requests_.find(found_id->dump());
+    if (found == in_flight_requests_.end()) return false;  // Already answered.
+    found->second->cancelled = true;
+    // Requests in progress are answered once they are done.
+    if (found->second->started) return true;
+    in_flight_requests_.erase(found);
+  }
+  nlohmann::json request = {{"id", *found_id}};
+  SendReply(CreateError(request, kRequestCancelled, "Request cancelled"));
+  return true;
+}
+
+void JsonRpcDispatcher::CountStat(const std::string &counter) {
+  const std::lock_guard<std::mutex> l(stats_lock_);
+  ++statistic_counters_[counter];
+}
+
+void JsonRpcDispatcher::CountException(const std::string &counter) {
+  const std::lock_guard<std::mutex> l(stats_lock_);
+  ++exception_count_;
+  ++statistic_counters_[counter];
+}
+
 void JsonRpcDispatcher::SendNotification(const std::string &method,
-                                         const nlohmann::json &notification) {
+                                         const nlohmann::json &notification,
+                                         absl::string_view replaces_key) {
   nlohmann::json result = {{"jsonrpc", "2.0"}};
   result["method"] = method;
   result["params"] = notification;
-  SendReply(result);
+  SendReply(result, NotificationKey(method, replaces_key));
 }
 
 /*static*/ nlohmann::json JsonRpcDispatcher::CreateError(
@@ -135,10 +318,28 @@ void JsonRpcDispatcher::SendNotification(const std::string &method,
   return result;
 }
 
-void JsonRpcDispatcher::SendReply(const nlohmann::json &response) {
+/*static*/ std::string JsonRpcDispatcher::MakeSerializedResponse(
+    const nlohmann::json &request, absl::string_view call_result) {
+  // Same order of properties as the json object of MakeResponse().
+  return absl::StrCat(R"({"id":)", request["id"].dump(),
+                      R"(,"jsonrpc":"2.0","result":)", call_result, "}\n");
+}
+
+void JsonRpcDispatcher::SendReply(const nlohmann::json &response,
+                                  absl::string_view key) {
   std::stringstream out_bytes;
-  out_bytes << response << "\n";
-  write_fun_(out_bytes.str());
+  latencies_.Time("json encode", [&]() { out_bytes << response << "\n"; });
+  SendSerializedReply(out_bytes.str(), key);
+}
+
+void JsonRpcDispatcher::SendSerializedReply(absl::string_view response,
+                                            absl::string_view key) {
+  if (writer_) {
+    writer_->Write(std::string(response), key);
+    return;
+  }
+  const std::lock_guard<std::mutex> l(write_lock_);
+  write_fun_(response);
 }
 }  // namespace lsp
 }  // namespace verible
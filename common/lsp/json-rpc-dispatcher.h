@@ -15,14 +15,26 @@
 #ifndef VERIBLE_COMMON_LSP_JSON_RPC_DISPATCHER_H
 #define VERIBLE_COMMON_LSP_JSON_RPC_DISPATCHER_H
 
+#include <atomic>
+#include <condition_variable>
 #include <functional>
 #include <map>
+#include <memory>
+#include <mutex>
 #include <sstream>
+#include <stdexcept>
 #include <string>
+#include <type_traits>
 #include <unordered_map>
+#include <utility>
 
 #include "absl/strings/str_cat.h"
 #include "absl/strings/string_view.h"
+#include "common/lsp/json-events.h"
+#include "common/lsp/message-writer.h"
+#include "common/util/json_writer.h"
+#include "common/util/latency_stats.h"
+#include "common/util/thread_pool.h"
 #include "nlohmann/json.hpp"
 
 namespace verible {
@@ -50,6 +62,21 @@ namespace lsp {
 //                               return doSomething(p);
 //                             });
 //
+// Messages are parsed without building a nlohmann::json DOM of their
+// parameters if the handler doesn't need one: notification handlers for
+// structs that jcxxgen generated with streaming support can be registered
+// with AddNotificationHandler<Params>(), and asynchronous requests can
+// return a Result::Of() such structs, that is serialized directly.  The same
+// goes for sending notifications of such structs.  These are the messages
+// that are frequent or big in a language server (text changes, diagnostics,
+// semantic tokens).
+//
+// Requests that only read state can be registered with
+// AddAsyncRequestHandler() instead. Once ProcessRequestsConcurrently() is
+// enabled, their responses are computed on worker threads, so that slow
+// requests don't hold up the messages following them. Notifications and all
+// other requests are still handled one after the other in the order received.
+//
 // [1]: https://www.jsonrpc.org/specification
 // [2]: https://github.com/hzeller/jcxxgen
 class JsonRpcDispatcher {
@@ -58,15 +85,80 @@ class JsonRpcDispatcher {
   static constexpr int kParseError = -32700;
   static constexpr int kMethodNotFound = -32601;
   static constexpr int kInternalError = -32603;
+  // Defined in the language server protocol: in response to $/cancelRequest,
+  // and if a change of state invalidated the result of a request.
+  static constexpr int kRequestCancelled = -32800;
+  static constexpr int kContentModified = -32801;
+  // Defined in the language server protocol: the request was valid, but could
+  // not be carried out, e.g. a rename to a name that is taken.
+  static constexpr int kRequestFailed = -32803;
+
+  // Handlers can throw this to respond with an error of the given code.
+  class Error : public std::runtime_error {
+   public:
+    Error(int code, const std::string &message)
+        : std::runtime_error(message), code_(code) {}
+    int code() const { return code_; }
+
+   private:
+    int code_;
+  };
 
   // A notification receives a request, but does not return anything
   using RPCNotification = std::function<void(const nlohmann::json &r)>;
 
+  // The result of a request: a json object, or a value serialized without
+  // one.
+  class Result {
+   public:
+    Result(nlohmann::json json)  // NOLINT: implicit like the json it holds.
+        : json_(std::move(json)) {}
+
+    // Returns the result "value", serialized right away if it writes itself
+    // to a JsonWriter like structs generated by jcxxgen with streaming
+    // support, otherwise converted to json.
+    template <typename T>
+    static Result Of(const T &value) {
+      if constexpr (IsJsonWriterSerializable<T>::value) {
+        std::ostringstream serialized;
+        JsonWriter writer(&serialized, -1);
+        value.SerializeTo(&writer);
+        Result result{nlohmann::json()};
+        result.serialized_ = serialized.str();
+        result.is_serialized_ = true;
+        return result;
+      } else {
+        return Result(nlohmann::json(value));
+      }
+    }
+    static Result Of(Result result) { return result; }
+
+    bool is_serialized() const { return is_serialized_; }
+    const nlohmann::json &json() const { return json_; }
+    const std::string &serialized() const { return serialized_; }
+
+   private:
+    nlohmann::json json_;
+    std::string serialized_;
+    bool is_serialized_ = false;
+  };
+
   // A RPC call receives a request and returns a response.
   // If we ever have a meaningful set of error conditions to convey, maybe
   // change this to absl::StatusOr<nlohmann::json> as return value.
   using RPCCallHandler = std::function<nlohmann::json(const nlohmann::json &)>;
 
+  // Returns true once the request being computed was cancelled; its result
+  // is not sent anymore, so long computations can stop early.
+  using IsCancelled = std::function<bool()>;
+
+  // A RPC call that is handled in two steps. The handler is called in order
+  // with all other messages, and takes a snapshot of all state it needs.
+  // It returns a function that computes the response from that snapshot,
+  // which might be called later on some other thread.
+  using RPCAsyncCallHandler = std::function<std::function<Result(
+      const IsCancelled &)>(const nlohmann::json &)>;
+
   // A function of type WriteFun is called by the dispatcher to send the
   // string-formatted json response. The user of the JsonRpcDispatcher then
   // can wire that to the underlying transport.
@@ -79,56 +171,228 @@ class JsonRpcDispatcher {
   explicit JsonRpcDispatcher(WriteFun out) : write_fun_(std::move(out)) {}
   JsonRpcDispatcher(const JsonRpcDispatcher &) = delete;
 
+  // Waits for requests in progress on worker threads.
+  ~JsonRpcDispatcher();
+
   // Add a request handler for RPC calls that receive data and send a response.
   // Returns successful registration, false if that name is already registered.
   bool AddRequestHandler(const std::string &method_name,
                          const RPCCallHandler &fun) {
+    if (async_handlers_.count(method_name)) return false;
     return handlers_.insert({method_name, fun}).second;
   }
 
+  // Add a request handler for RPC calls whose response can be computed
+  // concurrently with handling later messages (see RPCAsyncCallHandler).
+  // Returns successful registration, false if that name is already registered.
+  bool AddAsyncRequestHandler(const std::string &method_name,
+                              const RPCAsyncCallHandler &fun) {
+    if (handlers_.count(method_name)) return false;
+    return async_handlers_.insert({method_name, fun}).second;
+  }
+
   // Add a request handler for RPC Notifications, that are receive-only events.
   // Returns successful registration, false if that name is already registered.
   bool AddNotificationHandler(const std::string &method_name,
                               const RPCNotification &fun) {
-    return notifications_.insert({method_name, fun}).second;
+    return notifications_
+        .insert({method_name,
+                 [fun](MessageParams *params) { fun(params->Json()); }})
+        .second;
+  }
+
+  // Add a notification handler whose parameters are read straight from the
+  // message into a struct with DeserializeFrom(), like those generated by
+  // jcxxgen with streaming support. Invalid parameters are reported as
+  // exception, like those of handlers taking json.
+  // Returns successful registration, false if that name is already registered.
+  template <typename Params>
+  bool AddNotificationHandler(const std::string &method_name,
+                              const std::function<void(const Params &)> &fun) {
+    return notifications_
+        .insert({method_name,
+                 [fun, method_name](MessageParams *params) {
+                   Params p;
+                   if (!params->Read(&p)) {
+                     throw std::runtime_error("Invalid params of " +
+                                              method_name);
+                   }
+                   fun(p);
+                 }})
+        .second;
   }
 
   // Dispatch incoming message, a string view with json data.
   // Call this with the content of exactly one message.
-  // If this is an RPC call, response will call WriteFun.
+  // If this is an RPC call, response will call WriteFun; possibly later from
+  // a worker thread, if it is handled asynchronously.
+  // A "$/cancelRequest" notification answers an asynchronous request that is
+  // still waiting for a worker with a kRequestCancelled error, and drops it.
+  // Requests in progress are answered with that error once done, and see
+  // they were cancelled in their IsCancelled function.
   void DispatchMessage(absl::string_view data);
 
+  // Compute responses of asynchronous request handlers on "threads" worker
+  // threads. Without this, they are computed right away in DispatchMessage().
+  void ProcessRequestsConcurrently(int threads);
+
+  // Call the WriteFun on a thread of its own (see MessageWriter), so that
+  // sending messages doesn't wait for the other side to read them. Messages
+  // sent meanwhile are written as one batch, followed by a call to "flush".
+  void WriteInBackground(MessageWriter::FlushFun flush);
+
+  // Wait until all asynchronous requests received so far are answered, and
+  // all messages sent so far are written.
+  void WaitForPendingRequests();
+
   // Send a notification to the client side. Parameters will be wrapped
   // in a JSON-RPC message and pushed out to the WriteFun
+  // If "replaces_key" is not empty, this replaces a notification of the
+  // same method and key that is not written yet (see WriteInBackground()),
+  // e.g. diagnostics of the same document.
   void SendNotification(const std::string &method,
-                        const nlohmann::json &notification_params);
+                        const nlohmann::json &notification_params,
+                        absl::string_view replaces_key = "");
+
+  // Send a notification with parameters that write themselves to a
+  // JsonWriter, like structs generated by jcxxgen with streaming support.
+  template <typename T, std::enable_if_t<IsJsonWriterSerializable<T>::value,
+                                         bool> = true>
+  void SendNotification(const std::string &method,
+                        const T &notification_params,
+                        absl::string_view replaces_key = "") {
+    std::ostringstream message;
+    latencies_.Time("json encode", [&]() {
+      // Same order of properties as the serialized json object.
+      JsonWriter writer(&message, -1);
+      writer.BeginObject();
+      writer.Key("jsonrpc").Value("2.0");
+      writer.Key("method").Value(method);
+      writer.Key("params");
+      notification_params.SerializeTo(&writer);
+      writer.EndObject();
+      message << "\n";
+    });
+    SendSerializedReply(message.str(), NotificationKey(method, replaces_key));
+  }
 
   // Get some human-readable statistical counters of methods called
   // and exception messages encountered.
-  const StatsMap &GetStatCounters() const { return statistic_counters_; }
+  StatsMap GetStatCounters() const {
+    const std::lock_guard<std::mutex> l(stats_lock_);
+    return statistic_counters_;
+  }
+
+  // Time spent in the handler of each method, and on decoding incoming
+  // ("json decode") and encoding outgoing ("json encode") messages.
+  const LatencyStats &latencies() const { return latencies_; }
 
   // Number of exceptions that have been dealt with and turned into error
   // messages or ignored depending on the context.
   // The counters returned by GetStatsCounters() will report counts by
   // exception message.
-  int exception_count() const { return exception_count_; }
+  int exception_count() const {
+    const std::lock_guard<std::mutex> l(stats_lock_);
+    return exception_count_;
+  }
 
  private:
-  bool CallNotification(const nlohmann::json &req, const std::string &method);
+  // The parameters of a received message, which are only turned into json
+  // if a handler needs that.
+  class MessageParams {
+   public:
+    // Events [begin, end) of the parameters. Without, parameters are an
+    // empty object.
+    MessageParams(JsonEvent *begin, JsonEvent *end)
+        : begin_(begin), end_(end) {}
+
+    const nlohmann::json &Json();
+
+    template <typename T>
+    bool Read(T *value) {
+      if (begin_ == end_) {
+        JsonEvent empty_object[2];
+        empty_object[0].type = JsonEvent::Type::kStartObject;
+        empty_object[1].type = JsonEvent::Type::kEndObject;
+        JsonEventReader reader(empty_object, empty_object + 2);
+        return reader.Read(value);
+      }
+      JsonEventReader reader(begin_, end_);
+      return reader.Read(value) && reader.AtEnd();
+    }
+
+   private:
+    JsonEvent *const begin_;
+    JsonEvent *const end_;
+    bool has_json_ = false;
+    nlohmann::json json_;
+  };
+
+  using NotificationHandler = std::function<void(MessageParams *)>;
+
+  bool CallNotification(const std::string &method, MessageParams *params);
   bool CallRequestHandler(const nlohmann::json &req, const std::string &method);
-  void SendReply(const nlohmann::json &response);
+  bool CallAsyncRequestHandler(const nlohmann::json &req,
+                               const std::string &method,
+                               const RPCAsyncCallHandler &fun);
+  // Compute the response with "fun" and send it, or an error. If "cancelled"
+  // is set by then, send a kRequestCancelled error instead.
+  bool Respond(const nlohmann::json &req, const std::string &method,
+               const std::function<Result()> &fun,
+               const std::atomic<bool> *cancelled = nullptr);
+  bool CancelRequest(const nlohmann::json &params);
+
+  void CountStat(const std::string &counter);
+  void CountException(const std::string &counter);
+  void SendReply(const nlohmann::json &response, absl::string_view key = "");
+  // Send the JSON text of a response, ending in a newline. If "key" is not
+  // empty, replace a message sent with the same key that is not written yet.
+  void SendSerializedReply(absl::string_view response,
+                           absl::string_view key = "");
+
+  static std::string NotificationKey(absl::string_view method,
+                                     absl::string_view replaces_key) {
+    if (replaces_key.empty()) return "";
+    return absl::StrCat(method, " ", replaces_key);
+  }
 
   static nlohmann::json CreateError(const nlohmann::json &request, int code,
                                     absl::string_view message);
   static nlohmann::json MakeResponse(const nlohmann::json &request,
                                      const nlohmann::json &call_result);
+  static std::string MakeSerializedResponse(const nlohmann::json &request,
+                                            absl::string_view call_result);
 
   const WriteFun write_fun_;
+  std::mutex write_lock_;  // Replies might be sent from worker threads.
+  // Writes messages with write_fun_ in the background, if enabled.
+  std::unique_ptr<MessageWriter> writer_;
 
   std::unordered_map<std::string, RPCCallHandler> handlers_;
-  std::unordered_map<std::string, RPCNotification> notifications_;
+  std::unordered_map<std::string, RPCAsyncCallHandler> async_handlers_;
+  std::unordered_map<std::string, NotificationHandler> notifications_;
+
+  mutable std::mutex stats_lock_;  // Guards the following.
   int exception_count_ = 0;
   StatsMap statistic_counters_;
+
+  LatencyStats latencies_;
+
+  // An asynchronous request, waiting for a worker or in progress.
+  struct InFlightRequest {
+    bool started = false;  // Guarded by pending_lock_.
+    std::atomic<bool> cancelled{false};
+  };
+
+  std::mutex pending_lock_;  // Guards the following.
+  std::condition_variable pending_done_;
+  // Asynchronous requests by serialized id.
+  std::unordered_map<std::string, std::shared_ptr<InFlightRequest>>
+      in_flight_requests_;
+  int pending_requests_ = 0;  // Waiting or in progress.
+
+  // Declared last: its workers use all of the above.
+  std::unique_ptr<ThreadPool> workers_;
 };
 }  // namespace lsp
 }  // namespace verible
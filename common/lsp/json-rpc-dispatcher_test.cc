@@ -16,9 +16,16 @@
 
 #include <algorithm>
 #include <exception>
+#include <future>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
 
 #include "absl/status/status.h"
 #include "absl/strings/string_view.h"
+#include "common/lsp/json-events.h"
+#include "common/util/json_writer.h"
 #include "gmock/gmock.h"
 #include "gtest/gtest.h"
 
@@ -176,6 +183,22 @@ TEST(JsonRpcDispatcherTest, CallRpcHandler) {
   EXPECT_EQ(dispatcher.exception_count(), 0);
 }
 
+TEST(JsonRpcDispatcherTest, RecordsLatencies) {
+  JsonRpcDispatcher dispatcher([](absl::string_view) {});
+  dispatcher.AddRequestHandler("foo", [](const json &) -> json { return 1; });
+  dispatcher.AddNotificationHandler("bar", [](const json &) {});
+
+  dispatcher.DispatchMessage(R"({"jsonrpc":"2.0","id":1,"method":"foo"})");
+  dispatcher.DispatchMessage(R"({"jsonrpc":"2.0","id":2,"method":"foo"})");
+  dispatcher.DispatchMessage(R"({"jsonrpc":"2.0","method":"bar"})");
+
+  const auto latencies = dispatcher.latencies().Histograms();
+  EXPECT_EQ(latencies.at("foo").count(), 2);
+  EXPECT_EQ(latencies.at("bar").count(), 1);
+  EXPECT_EQ(latencies.at("json decode").count(), 3);
+  EXPECT_EQ(latencies.at("json encode").count(), 2);
+}
+
 TEST(JsonRpcDispatcherTest, CallRpcHandler_WithoutParamsShouldBeBenign) {
   int write_fun_called = 0;
   int rpc_fun_called = 0;
@@ -257,5 +280,310 @@ TEST(JsonRpcDispatcherTest, SendNotificationToClient) {
   dispatcher.SendNotification("greeting_method", params);
   EXPECT_EQ(1, write_fun_called);
 }
+
+TEST(JsonRpcDispatcherTest, WriteInBackgroundReplacesNotifications) {
+  std::promise<void> first_written;
+  std::promise<void> continue_writing;
+  std::future<void> may_continue = continue_writing.get_future();
+  std::vector<json> written;
+  int flushes = 0;
+  JsonRpcDispatcher dispatcher([&](absl::string_view s) {
+    written.push_back(json::parse(s));
+    if (written.size() == 1) {
+      first_written.set_value();
+      may_continue.wait();
+    }
+  });
+  dispatcher.WriteInBackground([&]() { ++flushes; });
+
+  dispatcher.SendNotification("diagnostics", "first", "a.sv");
+  first_written.get_future().wait();
+  dispatcher.SendNotification("diagnostics", "old", "a.sv");
+  dispatcher.SendNotification("other", "same key", "a.sv");
+  dispatcher.SendNotification("diagnostics", "b", "b.sv");
+  dispatcher.SendNotification("diagnostics", "new", "a.sv");
+  continue_writing.set_value();
+  dispatcher.WaitForPendingRequests();
+
+  std::vector<json> params;
+  for (const json &j : written) params.push_back(j["params"]);
+  EXPECT_EQ(params, std::vector<json>({"first", "same key", "b", "new"}));
+  EXPECT_EQ(flushes, 2);
+}
+
+using IsCancelled = JsonRpcDispatcher::IsCancelled;
+using ComputeResponse = std::function<json(const IsCancelled &)>;
+
+TEST(JsonRpcDispatcherTest, AsyncCallHandlerWithoutWorkers) {
+  int write_fun_called = 0;
+  JsonRpcDispatcher dispatcher([&](absl::string_view s) {
+    const json j = json::parse(s);
+    EXPECT_EQ(j["id"], 1);
+    EXPECT_EQ(j["result"], "world");
+    ++write_fun_called;
+  });
+  EXPECT_TRUE(dispatcher.AddAsyncRequestHandler(
+      "foo", [](const json &j) -> ComputeResponse {
+        const std::string value = j["hello"];
+        return [value](const IsCancelled &) -> json {
+          return value;
+        };
+      }));
+  // A method is registered either as synchronous or asynchronous.
+  EXPECT_FALSE(dispatcher.AddRequestHandler(
+      "foo", [](const json &j) -> json { return nullptr; }));
+
+  dispatcher.DispatchMessage(
+      R"({"jsonrpc":"2.0","id":1,"method":"foo","params":{"hello":"world"}})");
+  EXPECT_EQ(write_fun_called, 1);  // Answered right away.
+}
+
+// Collects replies of the dispatcher, which might come from worker threads.
+class Replies {
+ public:
+  JsonRpcDispatcher::WriteFun WriteFun() {
+    return [this](absl::string_view s) {
+      const std::lock_guard<std::mutex> l(lock_);
+      replies_.push_back(json::parse(s));
+    };
+  }
+  std::vector<json> Get() {
+    const std::lock_guard<std::mutex> l(lock_);
+    return replies_;
+  }
+
+ private:
+  std::mutex lock_;
+  std::vector<json> replies_;
+};
+
+TEST(JsonRpcDispatcherTest, AsyncCallDoesNotBlockLaterMessages) {
+  Replies replies;
+  JsonRpcDispatcher dispatcher(replies.WriteFun());
+  dispatcher.ProcessRequestsConcurrently(2);
+
+  std::promise<void> release;
+  std::shared_future<void> released = release.get_future().share();
+  int snapshot = 0;
+  int state = 1;
+  dispatcher.AddAsyncRequestHandler(
+      "slow", [&](const json &) -> ComputeResponse {
+        snapshot = state;  // Taken in order with other messages.
+        return [&, value = state](const IsCancelled &)
+                   -> json {
+          released.wait();
+          return value;
+        };
+      });
+  dispatcher.AddNotificationHandler("change", [&](const json &) { ++state; });
+  dispatcher.AddRequestHandler("fast",
+                               [&](const json &) -> json { return state; });
+
+  dispatcher.DispatchMessage(R"({"jsonrpc":"2.0","id":1,"method":"slow"})");
+  dispatcher.DispatchMessage(R"({"jsonrpc":"2.0","method":"change"})");
+  dispatcher.DispatchMessage(R"({"jsonrpc":"2.0","id":2,"method":"fast"})");
+  EXPECT_EQ(snapshot, 1);
+
+  // The slow request is still in progress.
+  std::vector<json> seen = replies.Get();
+  ASSERT_EQ(seen.size(), 1);
+  EXPECT_EQ(seen[0]["id"], 2);
+  EXPECT_EQ(seen[0]["result"], 2);
+
+  release.set_value();
+  dispatcher.WaitForPendingRequests();
+  seen = replies.Get();
+  ASSERT_EQ(seen.size(), 2);
+  EXPECT_EQ(seen[1]["id"], 1);
+  EXPECT_EQ(seen[1]["result"], 1);  // From the snapshot.
+}
+
+TEST(JsonRpcDispatcherTest, CancelsWaitingAsyncCall) {
+  Replies replies;
+  JsonRpcDispatcher dispatcher(replies.WriteFun());
+  dispatcher.ProcessRequestsConcurrently(1);
+
+  std::promise<void> started;
+  std::promise<void> release;
+  std::shared_future<void> released = release.get_future().share();
+  int computed = 0;
+  dispatcher.AddAsyncRequestHandler(
+      "block", [&](const json &) -> ComputeResponse {
+        return [&](const IsCancelled &) -> json {
+          started.set_value();
+          released.wait();
+          return "done";
+        };
+      });
+  dispatcher.AddAsyncRequestHandler(
+      "foo", [&](const json &) -> ComputeResponse {
+        return [&](const IsCancelled &) -> json {
+          return ++computed;
+        };
+      });
+
+  dispatcher.DispatchMessage(R"({"jsonrpc":"2.0","id":1,"method":"block"})");
+  started.get_future().wait();  // The only worker is busy now.
+  dispatcher.DispatchMessage(R"({"jsonrpc":"2.0","id":"x","method":"foo"})");
+
+  // Requests that are still waiting for a worker are answered right away.
+  dispatcher.DispatchMessage(
+      R"({"jsonrpc":"2.0","method":"$/cancelRequest","params":{"id":"x"}})");
+  std::vector<json> seen = replies.Get();
+  ASSERT_EQ(seen.size(), 1);
+  EXPECT_EQ(seen[0]["id"], "x");
+  EXPECT_EQ(seen[0]["error"]["code"], JsonRpcDispatcher::kRequestCancelled);
+
+  release.set_value();
+  dispatcher.WaitForPendingRequests();
+  seen = replies.Get();
+  ASSERT_EQ(seen.size(), 2);
+  EXPECT_EQ(seen[1]["id"], 1);
+  EXPECT_EQ(seen[1]["result"], "done");
+  EXPECT_EQ(computed, 0);
+  EXPECT_EQ(dispatcher.exception_count(), 0);
+}
+
+TEST(JsonRpcDispatcherTest, CancelsAsyncCallInProgress) {
+  Replies replies;
+  JsonRpcDispatcher dispatcher(replies.WriteFun());
+  dispatcher.ProcessRequestsConcurrently(1);
+
+  std::promise<void> started;
+  dispatcher.AddAsyncRequestHandler(
+      "foo", [&](const json &) -> ComputeResponse {
+        return [&](const IsCancelled &cancelled) -> json {
+          started.set_value();
+          while (!cancelled()) std::this_thread::yield();
+          return "partial";
+        };
+      });
+
+  dispatcher.DispatchMessage(R"({"jsonrpc":"2.0","id":1,"method":"foo"})");
+  started.get_future().wait();
+  dispatcher.DispatchMessage(
+      R"({"jsonrpc":"2.0","method":"$/cancelRequest","params":{"id":1}})");
+  dispatcher.WaitForPendingRequests();
+
+  const std::vector<json> seen = replies.Get();
+  ASSERT_EQ(seen.size(), 1);
+  EXPECT_EQ(seen[0]["id"], 1);
+  EXPECT_EQ(seen[0]["error"]["code"], JsonRpcDispatcher::kRequestCancelled);
+
+  // Once answered, requests can't be cancelled anymore.
+  dispatcher.DispatchMessage(
+      R"({"jsonrpc":"2.0","method":"$/cancelRequest","params":{"id":1}})");
+  EXPECT_EQ(replies.Get().size(), 1);
+  EXPECT_EQ(dispatcher.GetStatCounters().at("$/cancelRequest  ev"), 1);
+  EXPECT_EQ(dispatcher.GetStatCounters().at("$/cancelRequest (unhandled)  ev"),
+            1);
+}
+
+TEST(JsonRpcDispatcherTest, CallReportsErrorCode) {
+  int write_fun_called = 0;
+  JsonRpcDispatcher dispatcher([&](absl::string_view s) {
+    const json j = json::parse(s);
+    EXPECT_EQ(j["error"]["code"], JsonRpcDispatcher::kContentModified) << s;
+    ++write_fun_called;
+  });
+  dispatcher.AddRequestHandler("foo", [](const json &) -> json {
+    throw JsonRpcDispatcher::Error(JsonRpcDispatcher::kContentModified,
+                                   "changed");
+  });
+
+  dispatcher.DispatchMessage(R"({"jsonrpc":"2.0","id":1,"method":"foo"})");
+  EXPECT_EQ(write_fun_called, 1);
+  EXPECT_EQ(dispatcher.exception_count(), 0);  // Not an internal error.
+}
+
+// Like structs generated by jcxxgen with streaming support.
+struct Greeting {
+  std::string hello;
+
+  void SerializeTo(JsonWriter *out) const {
+    out->BeginObject();
+    out->Key("hello").Value(hello);
+    out->EndObject();
+  }
+  bool DeserializeFrom(JsonEventReader *in) {
+    if (!in->BeginObject()) return false;
+    bool seen_hello = false;
+    absl::string_view key;
+    while (in->NextKey(&key)) {
+      if (key == "hello") {
+        if (!in->Read(&hello)) return false;
+        seen_hello = true;
+      } else if (!in->Skip()) {
+        return false;
+      }
+    }
+    return !in->Failed() && seen_hello;
+  }
+};
+
+TEST(JsonRpcDispatcherTest, CallStreamingNotification) {
+  int write_fun_called = 0;
+  int notification_fun_called = 0;
+
+  JsonRpcDispatcher dispatcher([&](absl::string_view) { ++write_fun_called; });
+  const bool registered = dispatcher.AddNotificationHandler<Greeting>(
+      "foo", [&](const Greeting &p) {
+        EXPECT_EQ(p.hello, "world");
+        ++notification_fun_called;
+      });
+  EXPECT_TRUE(registered);
+
+  dispatcher.DispatchMessage(
+      R"({"jsonrpc":"2.0","method":"foo","params":{"hello":"world"}})");
+  EXPECT_EQ(notification_fun_called, 1);
+  EXPECT_EQ(dispatcher.exception_count(), 0);
+
+  // Invalid parameters are reported as exception, not to the client.
+  dispatcher.DispatchMessage(
+      R"({"jsonrpc":"2.0","method":"foo","params":{"hello":42}})");
+  dispatcher.DispatchMessage(R"({"jsonrpc":"2.0","method":"foo"})");
+  EXPECT_EQ(notification_fun_called, 1);
+  EXPECT_EQ(dispatcher.exception_count(), 2);
+  EXPECT_EQ(write_fun_called, 0);
+}
+
+TEST(JsonRpcDispatcherTest, SendStreamingNotificationToClient) {
+  std::string written;
+  JsonRpcDispatcher dispatcher(
+      [&](absl::string_view s) { written = std::string(s); });
+  dispatcher.SendNotification("greeting_method", Greeting{"y'all \"\n"});
+
+  // Same as the notification of the equivalent json.
+  std::string expected;
+  JsonRpcDispatcher json_dispatcher(
+      [&](absl::string_view s) { expected = std::string(s); });
+  json_dispatcher.SendNotification("greeting_method",
+                                   json{{"hello", "y'all \"\n"}});
+  EXPECT_EQ(written, expected);
+}
+
+TEST(JsonRpcDispatcherTest, AsyncCallWithSerializedResult) {
+  std::vector<std::string> written;
+  JsonRpcDispatcher dispatcher(
+      [&](absl::string_view s) { written.emplace_back(s); });
+  dispatcher.AddAsyncRequestHandler("greet", [](const json &j) {
+    const std::string hello = j["hello"];
+    return [hello](const IsCancelled &) {
+      return JsonRpcDispatcher::Result::Of(Greeting{hello});
+    };
+  });
+  dispatcher.AddRequestHandler("greet_json", [](const json &j) -> json {
+    return {{"hello", j["hello"]}};
+  });
+
+  dispatcher.DispatchMessage(
+      R"({"jsonrpc":"2.0","id":7,"method":"greet","params":{"hello":"a"}})");
+  dispatcher.DispatchMessage(
+      R"({"jsonrpc":"2.0","id":7,"method":"greet_json",)"
+      R"("params":{"hello":"a"}})");
+  ASSERT_EQ(written.size(), 2);
+  EXPECT_EQ(written[0], written[1]);
+  EXPECT_EQ(json::parse(written[0])["result"]["hello"], "a");
+}
 }  // namespace lsp
 }  // namespace verible
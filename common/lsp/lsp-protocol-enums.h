@@ -63,6 +63,28 @@ enum SymbolKind {
   kOperator = 25,
   kTypeParameter = 26,
 };
+
+// Kinds of textDocument/completion items, as far as they are used. Unlike
+// those of SymbolKind, the names have a prefix, as many are the same.
+enum CompletionItemKind {
+  kCompletionFunction = 3,
+  kCompletionVariable = 6,
+  kCompletionClass = 7,
+  kCompletionInterface = 8,
+  kCompletionModule = 9,  // SV module and package
+  kCompletionEnum = 13,
+  kCompletionEnumMember = 20,
+  kCompletionConstant = 21,
+  kCompletionStruct = 22,
+  kCompletionTypeParameter = 25,
+};
+
+// Kinds of changes in workspace/didChangeWatchedFiles notifications.
+enum FileChangeType {
+  kCreated = 1,
+  kChanged = 2,
+  kDeleted = 3,
+};
 }  // namespace lsp
 }  // namespace verible
 #endif  // COMMON_LSP_LSP_PROTOCOL_ENUMS_H
@@ -14,11 +14,19 @@
 
 #include "common/lsp/lsp-text-buffer.h"
 
-#include "common/strings/utf8.h"
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "absl/strings/string_view.h"
+#include "common/strings/line_column_map.h"
 
 namespace verible {
 namespace lsp {
-EditTextBuffer::EditTextBuffer(absl::string_view initial_text) {
+EditTextBuffer::EditTextBuffer(absl::string_view initial_text)
+    : content_(std::make_shared<std::string>()) {
   ReplaceDocument(initial_text);
 }
 
@@ -33,106 +41,126 @@ bool EditTextBuffer::ApplyChange(const TextDocumentContentChangeEvent &c) {
     return true;
   }
 
-  if (c.range.end.line >= static_cast<int>(lines_.size())) {
-    lines_.emplace_back(new std::string(""));
+  if (c.range.end.line >= static_cast<int>(line_starts_.size())) {
+    line_starts_.push_back(content_->length());  // Empty line at the end.
   }
 
   if (c.range.start.line == c.range.end.line &&
       c.text.find_first_of('\n') == std::string::npos) {
-    return LineEdit(c, lines_[c.range.start.line].get());  // simple case.
+    return LineEdit(c);  // simple case.
   }
   return MultiLineEdit(c);
 }
 
-/*static*/ EditTextBuffer::LineVector EditTextBuffer::GenerateLines(
-    absl::string_view content) {
-  LineVector result;
-  for (const absl::string_view s : absl::StrSplit(content, '\n')) {
-    result.emplace_back(new std::string(s));
-    result.back()->append("\n");
-  }
-
-  // Files that do or do not have a newline file-ending: represent correctly.
-  if (!content.empty() && content.back() == '\n') {
-    result.pop_back();
-  } else {
-    result.back()->pop_back();
+/*static*/ void EditTextBuffer::AppendLineStarts(absl::string_view text,
+                                                 int64_t offset,
+                                                 std::vector<int64_t> *starts) {
+  starts->push_back(offset);
+  for (size_t pos = text.find('\n'); pos != absl::string_view::npos &&
+                                      pos + 1 < text.length();
+       pos = text.find('\n', pos + 1)) {
+    starts->push_back(offset + pos + 1);
   }
+}
 
-  return result;
+absl::string_view EditTextBuffer::Line(int line) const {
+  const int64_t begin = line_starts_[line];
+  const int64_t end = line + 1 < static_cast<int>(line_starts_.size())
+                          ? line_starts_[line + 1]
+                          : content_->length();
+  return absl::string_view(*content_).substr(begin, end - begin);
 }
 
 void EditTextBuffer::ReplaceDocument(absl::string_view content) {
-  document_length_ = content.length();
+  content_ = std::make_shared<std::string>(content);
+  line_starts_.clear();
   if (content.empty()) return;
-  lines_ = GenerateLines(content);
+  AppendLineStarts(content, 0, &line_starts_);
+}
+
+// Returns the byte offset of UTF-16 column 'character' of 'line', or of its
+// end (before the newline) if the line is shorter.
+static int ByteColumn(absl::string_view line, int character) {
+  return Utf16ColumnMap(line).OffsetAtLineCol({0, character});
 }
 
 // Return success (might not if input out of range)
-bool EditTextBuffer::LineEdit(const TextDocumentContentChangeEvent &c,
-                              std::string *str) {
+bool EditTextBuffer::LineEdit(const TextDocumentContentChangeEvent &c) {
+  const absl::string_view str = Line(c.range.start.line);
+  const Utf16ColumnMap columns(str);
   int end_char = c.range.end.character;
 
-  int str_end = utf8_len(*str);
-  if (!str->empty() && str->back() == '\n') --str_end;
+  const int str_end = columns.Utf16Column(
+      0, !str.empty() && str.back() == '\n' ? str.length() - 1 : str.length());
 
   if (c.range.start.character > str_end) return false;
   if (end_char > str_end) end_char = str_end;
   if (end_char < c.range.start.character) return false;
 
-  document_length_ -= str->length();
-  const absl::string_view assembly = *str;
-  const auto before = utf8_substr(assembly, 0, c.range.start.character);
-  const auto after = utf8_substr(assembly, end_char);
-  *str = absl::StrCat(before, c.text, after);
-  document_length_ += str->length();
+  const int64_t line_start = line_starts_[c.range.start.line];
+  Replace(line_start + columns.OffsetAtLineCol({0, c.range.start.character}),
+          line_start + columns.OffsetAtLineCol({0, end_char}), c.text,
+          c.range.start.line, c.range.start.line);
   return true;
 }
 
 // Returns success (always succeeds);
 bool EditTextBuffer::MultiLineEdit(const TextDocumentContentChangeEvent &c) {
-  const absl::string_view start_line = *lines_[c.range.start.line];
-  const auto before = utf8_substr(start_line, 0, c.range.start.character);
-
-  const absl::string_view end_line = *lines_[c.range.end.line];
-  const auto after = utf8_substr(end_line, c.range.end.character);
-
-  // Assemble the full content to replace the range of lines with including
-  // the parts that come from the first and last line to be edited.
-  const std::string new_content = absl::StrCat(before, c.text, after);
-
-  // Content length update: substract all the bytes that were in the old
-  // content and add all in the new content.
-  const auto before_begin = lines_.begin() + c.range.start.line;
-  const auto before_end = lines_.begin() + c.range.end.line + 1;
-  document_length_ -=
-      std::accumulate(before_begin, before_end, 0,
-                      [](int sum, const LineVector::value_type &line) {
-                        return sum + line->length();
-                      });
-  document_length_ += new_content.length();
-
-  // The new content might include newlines, yielding multiple single lines.
-  LineVector regenerated_lines = GenerateLines(new_content);
-
-  // Update the affected lines. Probably not the most optimal but good enough
-  lines_.erase(before_begin, before_end);
-  lines_.insert(lines_.begin() + c.range.start.line, regenerated_lines.begin(),
-                regenerated_lines.end());
+  const absl::string_view start_line = Line(c.range.start.line);
+  const absl::string_view end_line = Line(c.range.end.line);
+  Replace(line_starts_[c.range.start.line] +
+              ByteColumn(start_line, c.range.start.character),
+          line_starts_[c.range.end.line] +
+              ByteColumn(end_line, c.range.end.character),
+          c.text, c.range.start.line, c.range.end.line);
   return true;
 }
 
+void EditTextBuffer::Replace(int64_t begin, int64_t end,
+                             absl::string_view text, int first_line,
+                             int last_line) {
+  const int64_t first_line_start = line_starts_[first_line];
+  const bool is_last_line =
+      last_line + 1 == static_cast<int>(line_starts_.size());
+  const int64_t old_lines_end =
+      is_last_line ? content_->length() : line_starts_[last_line + 1];
+  const int64_t delta = text.length() - (end - begin);
+
+  // Snapshots handed out before keep the previous content.
+  if (content_.use_count() > 1) {
+    content_ = std::make_shared<std::string>(*content_);
+  } else {
+    // Snapshots might have been released by other threads, which must be
+    // done reading before we write.
+    std::atomic_thread_fence(std::memory_order_acquire);
+  }
+  content_->replace(begin, end - begin, text.data(), text.length());
+
+  // The replaced lines might have become more or fewer lines; all lines
+  // after them just moved.
+  std::vector<int64_t> new_starts;
+  const absl::string_view new_lines = absl::string_view(*content_).substr(
+      first_line_start, old_lines_end + delta - first_line_start);
+  AppendLineStarts(new_lines, first_line_start, &new_starts);
+  const auto replaced_begin = line_starts_.begin() + first_line;
+  const auto replaced_end = line_starts_.begin() + last_line + 1;
+  for (auto it = replaced_end; it != line_starts_.end(); ++it) *it += delta;
+  const auto inserted = line_starts_.erase(replaced_begin, replaced_end);
+  line_starts_.insert(inserted, new_starts.begin(), new_starts.end());
+}
+
 BufferCollection::BufferCollection(JsonRpcDispatcher *dispatcher) {
   // Route notification events from the dispatcher to the buffer collection
   // for them to keep track of what buffers are open and all of their edits
   // they receive.
-  dispatcher->AddNotificationHandler(
+  // Their parameters, which contain whole texts, are read without a json DOM.
+  dispatcher->AddNotificationHandler<DidOpenTextDocumentParams>(
       "textDocument/didOpen",
       [this](const DidOpenTextDocumentParams &p) { didOpenEvent(p); });
-  dispatcher->AddNotificationHandler(
+  dispatcher->AddNotificationHandler<DidCloseTextDocumentParams>(
       "textDocument/didClose",
       [this](const DidCloseTextDocumentParams &p) { didCloseEvent(p); });
-  dispatcher->AddNotificationHandler(
+  dispatcher->AddNotificationHandler<DidChangeTextDocumentParams>(
       "textDocument/didChange",
       [this](const DidChangeTextDocumentParams &p) { didChangeEvent(p); });
 }
@@ -167,18 +195,15 @@ void BufferCollection::didChangeEvent(const DidChangeTextDocumentParams &o) {
 }
 
 void EditTextBuffer::RequestContent(const ContentProcessFun &processor) const {
-  std::string flat_view;
-  flat_view.reserve(document_length_);
-  for (const auto &l : lines_) flat_view.append(*l);
-  processor(flat_view);
+  processor(*content_);
 }
 
 void EditTextBuffer::RequestLine(int line,
                                  const ContentProcessFun &processor) const {
-  if (line < 0 || line >= static_cast<int>(lines_.size())) {
+  if (line < 0 || line >= static_cast<int>(line_starts_.size())) {
     processor("");
   } else {
-    processor(*lines_[line]);
+    processor(Line(line));
   }
 }
 }  // namespace lsp
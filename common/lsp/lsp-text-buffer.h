@@ -15,8 +15,10 @@
 #ifndef VERIBLE_COMMON_LSP_LSP_TEXT_BUFFER_H
 #define VERIBLE_COMMON_LSP_LSP_TEXT_BUFFER_H
 
+#include <cstdint>
 #include <functional>
 #include <memory>
+#include <string>
 #include <vector>
 
 #include "absl/container/flat_hash_map.h"
@@ -33,6 +35,12 @@ namespace lsp {
 // change events to keep in sync.
 // It provides ways to pass the current content to a requestor that needs to
 // process it.
+//
+// The content is kept in one contiguous string, with the byte offsets of
+// the line starts on the side, so handing it to a parser does not require
+// assembling it first. An edit replaces its byte range in place and only
+// adjusts the line offsets; the string is only copied if a snapshot of it
+// is still in use.
 class EditTextBuffer {
  public:
   using ContentProcessFun = std::function<void(absl::string_view)>;
@@ -41,11 +49,16 @@ class EditTextBuffer {
   EditTextBuffer(const EditTextBuffer &) = delete;
   EditTextBuffer(EditTextBuffer &&) = delete;
 
-  // Requst to flatten the content call and call function "processor" that
-  // gets a string_view of the current state that is valid for the duration
-  // of the call.
+  // Call function "processor" that gets a string_view of the current state
+  // that is valid for the duration of the call.
   void RequestContent(const ContentProcessFun &processor) const;
 
+  // Returns the current content, that stays valid and unchanged after
+  // subsequent edits. Cheap: edits copy the content while it is shared.
+  std::shared_ptr<const std::string> ContentSnapshot() const {
+    return content_;
+  }
+
   // Same as RequestContent() for a specific line.
   void RequestLine(int line, const ContentProcessFun &processor) const;
 
@@ -56,10 +69,10 @@ class EditTextBuffer {
   void ApplyChanges(const std::vector<TextDocumentContentChangeEvent> &cc);
 
   // Lines in this document.
-  size_t lines() const { return lines_.size(); }
+  size_t lines() const { return line_starts_.size(); }
 
   // Length of document in bytes.
-  int64_t document_length() const { return document_length_; }
+  int64_t document_length() const { return content_->length(); }
 
   // Last global version number this buffer has edited from.
   int64_t last_global_version() const { return last_global_version_; }
@@ -68,18 +81,27 @@ class EditTextBuffer {
   void set_last_global_version(int64_t v) { last_global_version_ = v; }
 
  private:
-  // TODO: this should be unique_ptr, but assignment in the insert() command
-  // will not work. Needs to be formulated with something something std::move ?
-  using LineVector = std::vector<std::shared_ptr<std::string>>;
+  // Appends to "starts" the offsets of the lines in "text", which starts
+  // at "offset" in the document. A newline at the end of "text" does not
+  // start another line.
+  static void AppendLineStarts(absl::string_view text, int64_t offset,
+                               std::vector<int64_t> *starts);
+
+  // Content of "line", including its newline.
+  absl::string_view Line(int line) const;
 
-  static LineVector GenerateLines(absl::string_view content);
   void ReplaceDocument(absl::string_view content);
-  bool LineEdit(const TextDocumentContentChangeEvent &c, std::string *str);
+  bool LineEdit(const TextDocumentContentChangeEvent &c);
   bool MultiLineEdit(const TextDocumentContentChangeEvent &c);
 
+  // Replace the bytes [begin, end) that are in lines "first_line" to
+  // "last_line" with "text".
+  void Replace(int64_t begin, int64_t end, absl::string_view text,
+               int first_line, int last_line);
+
   int64_t last_global_version_ = 0;
-  int64_t document_length_ = 0;
-  LineVector lines_;
+  std::shared_ptr<std::string> content_;
+  std::vector<int64_t> line_starts_;  // Byte offset of each line.
 };
 
 // A buffer collection keeps track of various open text buffers on the
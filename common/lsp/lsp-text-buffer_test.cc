@@ -173,6 +173,24 @@ TEST(TextBufferTest, ChangeApplySingleLineWihtUTF8Characters_Replace) {
   });
 }
 
+// Columns count UTF-16 code units, two for characters beyond the BMP.
+TEST(TextBufferTest, ChangeApplySingleLineWithSurrogatePairs_Replace) {
+  EditTextBuffer buffer("a😀b😀c\n");
+  const TextDocumentContentChangeEvent change = {
+      .range =
+          {
+              .start = {0, 3},
+              .end = {0, 6},
+          },
+      .has_range = true,
+      .text = "x",
+  };
+  EXPECT_TRUE(buffer.ApplyChange(change));
+  buffer.RequestContent([&](absl::string_view s) {
+    EXPECT_EQ("a😀xc\n", std::string(s));
+  });
+}
+
 TEST(TextBufferTest, ChangeApplySingleLine_ReplaceNotFirstLine) {
   // Make sure we properly access the right line.
   EditTextBuffer buffer("Hello World\nFoo\n");
@@ -333,6 +351,27 @@ TEST(TextBufferTest, ChangeApplyMultiLine_RemoveLines) {
   EXPECT_EQ(buffer.document_length(), 8);
 }
 
+TEST(TextBufferTest, ContentSnapshotUnaffectedByEdits) {
+  EditTextBuffer buffer("Foo\nBar\n");
+  const auto snapshot = buffer.ContentSnapshot();
+  const TextDocumentContentChangeEvent change = {
+      .range =
+          {
+              .start = {0, 3},
+              .end = {1, 0},
+          },
+      .has_range = true,
+      .text = "d\nBaz\nQuux ",
+  };
+  EXPECT_TRUE(buffer.ApplyChange(change));
+  EXPECT_EQ(*snapshot, "Foo\nBar\n");
+  EXPECT_EQ(*buffer.ContentSnapshot(), "Food\nBaz\nQuux Bar\n");
+  ASSERT_EQ(buffer.lines(), 3);
+  buffer.RequestLine(2, [](absl::string_view s) {  //
+    EXPECT_EQ(std::string(s), "Quux Bar\n");
+  });
+}
+
 TEST(BufferCollection, SimulateDocumentLifecycleThroughRPC) {
   // Let's walk a BufferCollection through the lifecycle of a document
   // by sending it the JSON RPC notifications for open, change and close.
@@ -14,6 +14,9 @@
 
 #include "common/lsp/message-stream-splitter.h"
 
+#include <algorithm>
+#include <cstring>
+
 #include "common/util/status_macros.h"
 
 namespace verible {
@@ -77,9 +80,13 @@ absl::Status MessageStreamSplitter::ProcessContainedMessages(
           absl::StrCat("No `Content-Length:` header. '", limited_view, "...'"));
     }
 
+    if (body_offset == kIncompleteHeader) {
+      pending_message_size_ = 0;
+      return absl::OkStatus();  // Need more data to see the full header.
+    }
     const int message_size = body_offset + body_size;
-    if (body_offset == kIncompleteHeader ||
-        message_size > static_cast<int>(data->size())) {
+    if (message_size > static_cast<int>(data->size())) {
+      pending_message_size_ = message_size;
       return absl::OkStatus();  // Only insufficient partial buffer available.
     }
 
@@ -94,43 +101,58 @@ absl::Status MessageStreamSplitter::ProcessContainedMessages(
   return absl::OkStatus();
 }
 
-// Read from "read_fun", fill internal buffer and call all available
-// complete messages in it.
-absl::Status MessageStreamSplitter::ReadInput(const ReadFun &read_fun) {
-  size_t write_offset = 0;
+void MessageStreamSplitter::MakeRoomForRead() {
+  const size_t pending_size = pending_end_ - pending_begin_;
+  // If we know how large the message is, make room for all of it, so that
+  // it does not have to be moved again. Otherwise, read at least a chunk
+  // worth half the buffer.
+  const size_t chunk = std::max<size_t>(read_buffer_.size() / 2, 1);
+  const size_t required = std::max(pending_message_size_, pending_size + chunk);
+  if (pending_begin_ + required <= read_buffer_.size()) return;
 
   // Move all we had left from last time to the beginning of the buffer.
   // This is in the same buffer, so we need to memmove()
-  if (!pending_data_.empty()) {
-    memmove(read_buffer_.data(), pending_data_.data(), pending_data_.size());
-    write_offset = pending_data_.size();
+  if (pending_size > 0 && pending_begin_ > 0) {
+    memmove(read_buffer_.data(), read_buffer_.data() + pending_begin_,
+            pending_size);
   }
-
-  if (write_offset == read_buffer_.size()) {
-    read_buffer_.resize(2 * read_buffer_.size());
+  pending_begin_ = 0;
+  pending_end_ = pending_size;
+  if (required > read_buffer_.size()) {
+    read_buffer_.resize(std::max(required, 2 * read_buffer_.size()));
   }
+}
+
+// Read from "read_fun", fill internal buffer and call all available
+// complete messages in it.
+absl::Status MessageStreamSplitter::ReadInput(const ReadFun &read_fun) {
+  MakeRoomForRead();
 
-  const int free_space = read_buffer_.size() - write_offset;
-  int bytes_read = read_fun(read_buffer_.data() + write_offset, free_space);
+  const int free_space = read_buffer_.size() - pending_end_;
+  int bytes_read = read_fun(read_buffer_.data() + pending_end_, free_space);
   if (bytes_read <= 0) {
     // Got EOF.
     // If we still have data pending, regard this as data loss situation, as
     // we were never able to fully read the last message and send to process.
     // Otherwise, report 'Unavailable' to indicate EOF (meh, this should
     // be a better message).
-    if (!pending_data_.empty()) {
+    if (pending_end_ > pending_begin_) {
       return absl::DataLossError(
           absl::StrCat("Got EOF, but still have incomplete message with ",
-                       pending_data_.size(), " bytes read so far."));
+                       pending_end_ - pending_begin_, " bytes read so far."));
     }
     return absl::UnavailableError(absl::StrCat("read() returned ", bytes_read));
   }
   stats_total_bytes_read_ += bytes_read;
 
-  absl::string_view data(read_buffer_.data(), write_offset + bytes_read);
+  pending_end_ += bytes_read;
+  absl::string_view data(read_buffer_.data() + pending_begin_,
+                         pending_end_ - pending_begin_);
   RETURN_IF_ERROR(ProcessContainedMessages(&data));
 
-  pending_data_ = data;  // Remember for next round.
+  // Remember for next round.
+  pending_begin_ = data.data() - read_buffer_.data();
+  if (data.empty()) pending_begin_ = pending_end_ = 0;
 
   return absl::OkStatus();
 }
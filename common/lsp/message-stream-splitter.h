@@ -18,6 +18,7 @@
 #include <functional>
 #include <memory>
 #include <string>
+#include <vector>
 
 #include "absl/status/status.h"
 #include "absl/strings/numbers.h"
@@ -56,6 +57,10 @@ class MessageStreamSplitter {
 
   // Optional parameters are "initial_read_buffer_size" for the initial
   // internal buffer size (will be realloc'ed when needed).
+  // Messages are handed to the processor from where they were read into
+  // that buffer. Partially read data is only moved to make room for the
+  // rest of its message, which is at most once per message after its header
+  // has been read.
   // If "strict_crlf_header_separation" is false, also allows for simple
   // newline as separation character in the header. Useful for manually
   // speaking the protocol.
@@ -99,6 +104,10 @@ class MessageStreamSplitter {
   absl::Status ProcessContainedMessages(absl::string_view *data);
   absl::Status ReadInput(const ReadFun &read_fun);
 
+  // Make room to read after the pending data, moving or growing the buffer
+  // as needed.
+  void MakeRoomForRead();
+
   std::vector<char> read_buffer_;
   const bool lenient_lf_separation_;
 
@@ -106,7 +115,12 @@ class MessageStreamSplitter {
 
   size_t stats_largest_body_ = 0;
   size_t stats_total_bytes_read_ = 0;
-  absl::string_view pending_data_;
+
+  // Data of incomplete messages is in read_buffer_ [pending_begin_,
+  // pending_end_). Size of the first of them, if its header is complete.
+  size_t pending_begin_ = 0;
+  size_t pending_end_ = 0;
+  size_t pending_message_size_ = 0;
 };
 }  // namespace lsp
 }  // namespace verible
@@ -15,12 +15,16 @@
 #include "common/lsp/message-stream-splitter.h"
 
 #include <algorithm>
+#include <string>
+#include <vector>
 
 #include "absl/status/status.h"
+#include "absl/strings/str_cat.h"
 #include "absl/strings/string_view.h"
 #include "gmock/gmock.h"
 #include "gtest/gtest.h"
 
+using ::testing::ElementsAre;
 using ::testing::HasSubstr;
 
 namespace verible {
@@ -210,6 +214,36 @@ TEST(MessageStreamSplitterTest, CompleteReadMultipleMessagesShortRead) {
   EXPECT_EQ(processor_call_count, 2);
 }
 
+TEST(MessageStreamSplitterTest, LargeMessagesBetweenSmallShortReads) {
+  const std::string kLargeBody(10000, 'x');
+  const std::string large_message =
+      absl::StrCat("Content-Length: ", kLargeBody.size(), "\r\n\r\n",
+                   kLargeBody);
+  static constexpr absl::string_view kSmallMessage =
+      "Content-Length: 3\r\n\r\nfoo";
+  static constexpr int kTrickleReadSize = 7;
+
+  DataStreamSimulator stream(absl::StrCat(kSmallMessage, large_message,
+                                          kSmallMessage, large_message,
+                                          kSmallMessage),
+                             kTrickleReadSize);
+  MessageStreamSplitter s(16);
+  std::vector<std::string> bodies;
+  s.SetMessageProcessor([&](absl::string_view header, absl::string_view body) {
+    bodies.emplace_back(body);
+  });
+
+  absl::Status status = absl::OkStatus();
+  while (status.ok()) {
+    status =
+        s.PullFrom([&](char *buf, int size) { return stream.read(buf, size); });
+  }
+
+  EXPECT_EQ(status.code(), absl::StatusCode::kUnavailable);  // EOF
+  EXPECT_THAT(bodies, ElementsAre("foo", kLargeBody, "foo", kLargeBody, "foo"));
+  EXPECT_EQ(s.StatLargestBodySeen(), kLargeBody.size());
+}
+
 TEST(MessageStreamSplitterTest, NotAvailableContentHeaderReadError) {
   static constexpr absl::string_view kHeader = "not-content-length: 3\r\n\r\n";
   static constexpr absl::string_view kBody = "foo";
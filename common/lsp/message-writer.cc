@@ -0,0 +1,93 @@
+// Copyright 2023 The Verible Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "common/lsp/message-writer.h"
+
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "absl/strings/string_view.h"
+
+namespace verible {
+namespace lsp {
+
+MessageWriter::MessageWriter(WriteFun write, FlushFun flush)
+    : write_fun_(std::move(write)),
+      flush_fun_(std::move(flush)),
+      writer_thread_([this]() { WriteLoop(); }) {}
+
+MessageWriter::~MessageWriter() {
+  {
+    const std::lock_guard<std::mutex> l(lock_);
+    stopping_ = true;
+  }
+  queued_.notify_one();
+  writer_thread_.join();
+}
+
+void MessageWriter::Write(std::string message, absl::string_view key) {
+  {
+    const std::lock_guard<std::mutex> l(lock_);
+    if (!key.empty()) {
+      const auto [found, inserted] =
+          queued_by_key_.emplace(std::string(key), queue_.size());
+      if (!inserted) {
+        Queued &replaced = queue_[found->second];
+        replaced.replaced = true;
+        replaced.message.clear();
+        ++replaced_count_;
+        found->second = queue_.size();
+      }
+    }
+    queue_.push_back({std::move(message)});
+  }
+  queued_.notify_one();
+}
+
+void MessageWriter::Flush() {
+  std::unique_lock<std::mutex> l(lock_);
+  written_.wait(l, [this]() { return queue_.empty() && !writing_; });
+}
+
+int64_t MessageWriter::replaced_count() const {
+  const std::lock_guard<std::mutex> l(lock_);
+  return replaced_count_;
+}
+
+void MessageWriter::WriteLoop() {
+  std::vector<Queued> batch;
+  std::unique_lock<std::mutex> l(lock_);
+  for (;;) {
+    queued_.wait(l, [this]() { return !queue_.empty() || stopping_; });
+    if (queue_.empty()) return;  // Stopping, and all is written.
+    batch.swap(queue_);
+    queued_by_key_.clear();
+    writing_ = true;
+    l.unlock();
+    for (const Queued &queued : batch) {
+      if (!queued.replaced) write_fun_(queued.message);
+    }
+    flush_fun_();
+    batch.clear();
+    l.lock();
+    writing_ = false;
+    if (queue_.empty()) written_.notify_all();
+  }
+}
+
+}  // namespace lsp
+}  // namespace verible
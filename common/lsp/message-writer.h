@@ -0,0 +1,86 @@
+// Copyright 2023 The Verible Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef VERIBLE_COMMON_LSP_MESSAGE_WRITER_H
+#define VERIBLE_COMMON_LSP_MESSAGE_WRITER_H
+
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+#include "absl/strings/string_view.h"
+
+namespace verible {
+namespace lsp {
+// Writes messages on a thread of its own, so that whoever sends them doesn't
+// wait until the other side read them.
+//
+// All messages queued while the previous ones are written are written as one
+// batch: each with the write function, then the flush function once.
+// A message queued with a key replaces a message with the same key that is
+// still queued, e.g. the diagnostics of a document that are outdated by then.
+// It is written after everything queued before it.
+class MessageWriter {
+ public:
+  using WriteFun = std::function<void(absl::string_view message)>;
+  using FlushFun = std::function<void()>;
+
+  MessageWriter(WriteFun write, FlushFun flush);
+  MessageWriter(const MessageWriter &) = delete;
+
+  // Writes all queued messages before returning.
+  ~MessageWriter();
+
+  // Queue "message" to be written. If "key" is not empty, a message queued
+  // with the same key that is not written yet is dropped.
+  void Write(std::string message, absl::string_view key = "");
+
+  // Wait until all messages queued so far are written.
+  void Flush();
+
+  // Number of messages that were dropped as they were replaced.
+  int64_t replaced_count() const;
+
+ private:
+  struct Queued {
+    std::string message;
+    bool replaced = false;
+  };
+
+  void WriteLoop();
+
+  const WriteFun write_fun_;
+  const FlushFun flush_fun_;
+
+  mutable std::mutex lock_;  // Guards the following.
+  std::condition_variable queued_;
+  std::condition_variable written_;
+  std::vector<Queued> queue_;
+  // Index in queue_ of the message queued with each key.
+  std::unordered_map<std::string, size_t> queued_by_key_;
+  bool writing_ = false;  // A batch taken from the queue is being written.
+  bool stopping_ = false;
+  int64_t replaced_count_ = 0;
+
+  // Declared last: it uses all of the above.
+  std::thread writer_thread_;
+};
+}  // namespace lsp
+}  // namespace verible
+#endif  // VERIBLE_COMMON_LSP_MESSAGE_WRITER_H
@@ -0,0 +1,81 @@
+// Copyright 2023 The Verible Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "common/lsp/message-writer.h"
+
+#include <future>
+#include <string>
+#include <vector>
+
+#include "absl/strings/string_view.h"
+#include "gtest/gtest.h"
+
+namespace verible {
+namespace lsp {
+namespace {
+
+TEST(MessageWriterTest, WritesAllInOrder) {
+  std::vector<std::string> written;
+  int flushes = 0;
+  {
+    MessageWriter writer(
+        [&](absl::string_view message) { written.emplace_back(message); },
+        [&]() { ++flushes; });
+    writer.Write("a");
+    writer.Write("b");
+    writer.Flush();
+    EXPECT_EQ(written, std::vector<std::string>({"a", "b"}));
+    writer.Write("c");
+  }  // Writes the rest on destruction.
+  EXPECT_EQ(written, std::vector<std::string>({"a", "b", "c"}));
+  EXPECT_GE(flushes, 2);
+}
+
+TEST(MessageWriterTest, BatchesAndReplacesQueuedMessages) {
+  std::promise<void> first_written;
+  std::promise<void> continue_writing;
+  std::future<void> may_continue = continue_writing.get_future();
+  std::vector<std::string> written;
+  std::vector<int> batch_sizes = {0};
+  MessageWriter writer(
+      [&](absl::string_view message) {
+        written.emplace_back(message);
+        ++batch_sizes.back();
+        if (message == "first") {
+          first_written.set_value();
+          may_continue.wait();
+        }
+      },
+      [&]() { batch_sizes.push_back(0); });
+
+  writer.Write("first", "doc-a");
+  first_written.get_future().wait();
+  // Queued while "first" is written; it is not replaced anymore.
+  writer.Write("a1", "doc-a");
+  writer.Write("b1", "doc-b");
+  writer.Write("response");
+  writer.Write("a2", "doc-a");
+  writer.Write("other response");
+  continue_writing.set_value();
+  writer.Flush();
+
+  EXPECT_EQ(written, std::vector<std::string>(
+                         {"first", "b1", "response", "a2", "other response"}));
+  EXPECT_EQ(batch_sizes, std::vector<int>({1, 4, 0}));
+  EXPECT_EQ(writer.replaced_count(), 1);
+}
+
+}  // namespace
+}  // namespace lsp
+}  // namespace verible
@@ -25,6 +25,7 @@
 #define VERIBLE_COMMON_PARSER_BISON_PARSER_ADAPTER_H_
 
 #include <cstddef>  // for size_t
+#include <utility>
 #include <vector>
 
 #include "absl/status/status.h"
@@ -68,6 +69,14 @@ class BisonParserAdapter : public Parser {
 
   size_t MaxUsedStackSize() const { return param_.MaxUsedStackSize(); }
 
+  // See ParserParam::SetErrorRecoveryLimit().  Must be called before Parse().
+  void SetErrorRecoveryLimit(ErrorRecoveryLimit limit) {
+    param_.SetErrorRecoveryLimit(std::move(limit));
+  }
+
+  // See ParserParam::DroppedTokens().
+  size_t DroppedTokens() const { return param_.DroppedTokens(); }
+
  private:
   // Holds the state of the parser stacks, resulting tree, and rejected tokens.
   ParserParam param_;
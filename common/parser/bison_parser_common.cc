@@ -30,7 +30,7 @@ namespace verible {
 // $2, ... in the yacc grammar semantic actions.
 int LexAdapter(SymbolPtr* value, ParserParam* param) {
   const auto& last_token = param->FetchToken();
-  value->reset(new SyntaxTreeLeaf(last_token));
+  value->reset(new OwnedTokenLeaf(last_token));
   return last_token.token_enum();
 }
 
@@ -16,7 +16,9 @@
 
 #include "common/parser/bison_parser_common.h"
 
+#include <cstdint>
 #include <memory>
+#include <vector>
 
 #include "absl/strings/string_view.h"
 #include "common/lexer/lexer.h"
@@ -67,5 +69,121 @@ TEST(BisonParserCommonTest, LexTest) {
   EXPECT_EQ(tref.text(), "foo");
 }
 
+// Test that stacks keep their contents when resized, and are resized to the
+// size previous parses needed at once.
+TEST(BisonParserCommonTest, ResizeStacks) {
+  constexpr int kInitialSize = 4;
+  MockLexer lexer;
+  auto generator = MakeTokenGenerator(&lexer);
+  int64_t grown_size;
+  {
+    ParserParam parser_param(&generator, "<file>");
+    bison_state_int_type initial_states[kInitialSize] = {1, 2, 3, 4};
+    SymbolPtr initial_values[kInitialSize];
+    initial_values[2] = MakeNode();
+    const Symbol* const value = initial_values[2].get();
+    bison_state_int_type* states = initial_states;
+    SymbolPtr* values = initial_values;
+    int64_t size = kInitialSize;
+    for (int i = 0; i < 6; ++i) {
+      const int64_t old_size = size;
+      parser_param.ResizeStacks(&states, &values, &size);
+      EXPECT_GE(size, 2 * old_size);
+    }
+    EXPECT_EQ(parser_param.MaxUsedStackSize(), size);
+    EXPECT_EQ(states[3], 4);
+    EXPECT_EQ(values[2].get(), value);
+    grown_size = size;
+  }
+
+  ParserParam parser_param(&generator, "<file>");
+  bison_state_int_type initial_states[kInitialSize] = {};
+  SymbolPtr initial_values[kInitialSize];
+  bison_state_int_type* states = initial_states;
+  SymbolPtr* values = initial_values;
+  int64_t size = kInitialSize;
+  parser_param.ResizeStacks(&states, &values, &size);
+  EXPECT_GE(size, grown_size);
+}
+
+// Tokens of "a b ; c ; module d", where "module" is the synchronization token.
+constexpr int kIdentifier = 1;
+constexpr int kSemicolon = 2;
+constexpr int kModule = 3;
+
+std::vector<TokenInfo> RecoveryTestTokens(absl::string_view text) {
+  return {{kIdentifier, text.substr(0, 1)}, {kIdentifier, text.substr(2, 1)},
+          {kSemicolon, text.substr(4, 1)},  {kIdentifier, text.substr(6, 1)},
+          {kSemicolon, text.substr(8, 1)},  {kModule, text.substr(10, 6)},
+          {kIdentifier, text.substr(17, 1)}};
+}
+
+ErrorRecoveryLimit RecoveryTestLimit(int max_discarded_tokens) {
+  return {max_discarded_tokens,
+          [](const TokenInfo& token) { return token.token_enum() == kModule; },
+          kSemicolon};
+}
+
+TEST(ParserParamTest, UnlimitedErrorRecovery) {
+  constexpr absl::string_view kText = "a b ; c ; module d";
+  const std::vector<TokenInfo> tokens = RecoveryTestTokens(kText);
+  auto generator = MakeTokenStreamer(tokens);
+  ParserParam parser_param(&generator, "<file>");
+  for (const TokenInfo& token : tokens) {
+    EXPECT_EQ(parser_param.FetchToken(), token);
+    parser_param.RecordDiscardedToken();
+  }
+  EXPECT_TRUE(parser_param.FetchToken().isEOF());
+  EXPECT_EQ(parser_param.DroppedTokens(), tokens.size());
+}
+
+TEST(ParserParamTest, ErrorRecoverySkipsToSyncToken) {
+  constexpr absl::string_view kText = "a b ; c ; module d";
+  const std::vector<TokenInfo> tokens = RecoveryTestTokens(kText);
+  auto generator = MakeTokenStreamer(tokens);
+  ParserParam parser_param(&generator, "<file>");
+  parser_param.SetErrorRecoveryLimit(RecoveryTestLimit(2));
+  EXPECT_EQ(parser_param.FetchToken(), tokens[0]);
+  parser_param.RecordDiscardedToken();
+  EXPECT_EQ(parser_param.FetchToken(), tokens[1]);
+  parser_param.RecordDiscardedToken();
+  // Out of budget: "; c ;" are skipped, and a terminator is inserted.
+  const TokenInfo& terminator = parser_param.FetchToken();
+  EXPECT_EQ(terminator.token_enum(), kSemicolon);
+  EXPECT_TRUE(terminator.text().empty());
+  EXPECT_EQ(terminator.left(kText), tokens[5].left(kText));
+  EXPECT_EQ(parser_param.FetchToken(), tokens[5]);
+  EXPECT_EQ(parser_param.FetchToken(), tokens[6]);
+  EXPECT_TRUE(parser_param.FetchToken().isEOF());
+  EXPECT_EQ(parser_param.DroppedTokens(), 5);
+}
+
+TEST(ParserParamTest, ErrorRecoveryBudgetIsPerError) {
+  constexpr absl::string_view kText = "a b ; c ; module d";
+  const std::vector<TokenInfo> tokens = RecoveryTestTokens(kText);
+  auto generator = MakeTokenStreamer(tokens);
+  ParserParam parser_param(&generator, "<file>");
+  parser_param.SetErrorRecoveryLimit(RecoveryTestLimit(2));
+  // Discarded tokens that are not in a row don't use up the budget.
+  for (int i = 0; i < 5; ++i) {
+    EXPECT_EQ(parser_param.FetchToken(), tokens[i]);
+    if (i % 2 == 0) parser_param.RecordDiscardedToken();
+  }
+  EXPECT_EQ(parser_param.DroppedTokens(), 3);
+}
+
+TEST(ParserParamTest, ErrorRecoverySkipsToEnd) {
+  constexpr absl::string_view kText = "a b ; c ; module d";
+  std::vector<TokenInfo> tokens = RecoveryTestTokens(kText);
+  tokens.erase(tokens.begin() + 5, tokens.end());  // without "module d"
+  auto generator = MakeTokenStreamer(tokens);
+  ParserParam parser_param(&generator, "<file>");
+  parser_param.SetErrorRecoveryLimit(RecoveryTestLimit(1));
+  EXPECT_EQ(parser_param.FetchToken(), tokens[0]);
+  parser_param.RecordDiscardedToken();
+  EXPECT_TRUE(parser_param.FetchToken().isEOF());
+  EXPECT_EQ(parser_param.DroppedTokens(), 5);
+}
+
 }  // namespace
 }  // namespace verible
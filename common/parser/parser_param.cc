@@ -16,7 +16,10 @@
 
 #include "common/parser/parser_param.h"
 
+#include <algorithm>
+#include <atomic>
 #include <cstddef>
+#include <cstdint>
 #include <functional>
 #include <utility>
 #include <vector>
@@ -39,10 +42,38 @@ ParserParam::ParserParam(TokenGenerator* token_stream,
 ParserParam::~ParserParam() = default;
 
 const TokenInfo& ParserParam::FetchToken() {
+  if (!last_token_discarded_) discarded_in_a_row_ = 0;
+  last_token_discarded_ = false;
+  if (pending_sync_token_.has_value()) {
+    last_token_ = *pending_sync_token_;
+    pending_sync_token_.reset();
+    return last_token_;
+  }
   last_token_ = (*token_stream_)();
+  const int max_discarded = recovery_limit_.max_discarded_tokens;
+  if (max_discarded <= 0 || discarded_in_a_row_ < max_discarded) {
+    return last_token_;
+  }
+  // Out of patience: skip to where parsing likely resumes.  If even the
+  // synchronization token is discarded, this repeats at the next one.
+  while (!last_token_.isEOF() && !recovery_limit_.is_sync_token(last_token_)) {
+    ++skipped_tokens_;
+    last_token_ = (*token_stream_)();
+  }
+  if (last_token_.isEOF()) return last_token_;
+  VLOG(1) << filename_ << ": error recovery resumes at " << last_token_;
+  pending_sync_token_ = last_token_;
+  last_token_ = TokenInfo(recovery_limit_.terminator_token_enum,
+                          last_token_.text().substr(0, 0));
   return last_token_;
 }
 
+void ParserParam::RecordDiscardedToken() {
+  last_token_discarded_ = true;
+  ++discarded_in_a_row_;
+  ++discarded_tokens_;
+}
+
 void ParserParam::RecordSyntaxError(const SymbolPtr& symbol_ptr) {
   const auto* leaf = down_cast<const SyntaxTreeLeaf*>(symbol_ptr.get());
   const auto token = leaf->get();
@@ -57,15 +88,24 @@ static void move_stack(T** raw_stack, const int64_t* size,
   std::move(*raw_stack, *raw_stack + *size, stack->begin());
 }
 
+// Largest stack size of any parse so far, see ResizeStacks().
+static std::atomic<int64_t> stack_size_hint{0};
+
 // See bison_parser_common.h for use of this (yyoverflow).
 void ParserParam::ResizeStacksInternal(bison_state_int_type** state_stack,
                                        SymbolPtr** value_stack, int64_t* size) {
+  int64_t new_size = *size * 2;
   if (state_stack_.empty()) {
     // This is the first reallocation case.
     move_stack(state_stack, size, &state_stack_);
     move_stack(value_stack, size, &value_stack_);
+    new_size = std::max(new_size, stack_size_hint.load());
+  }
+  *size = new_size;
+  int64_t hint = stack_size_hint.load();
+  while (hint < new_size &&
+         !stack_size_hint.compare_exchange_weak(hint, new_size)) {
   }
-  (*size) *= 2;
   state_stack_.resize(*size);
   value_stack_.resize(*size);
   *state_stack = state_stack_.data();
@@ -19,10 +19,15 @@
 #ifndef VERIBLE_COMMON_PARSER_PARSER_PARAM_H_
 #define VERIBLE_COMMON_PARSER_PARSER_PARAM_H_
 
+#include <cstddef>
 #include <cstdint>
+#include <functional>
+#include <optional>
+#include <string>
 #include <utility>
 #include <vector>
 
+#include "absl/strings/string_view.h"
 #include "common/lexer/token_generator.h"
 #include "common/text/concrete_syntax_tree.h"
 #include "common/text/token_info.h"
@@ -34,6 +39,25 @@ namespace verible {
 // check it in the .yc (yacc) grammar file.
 using bison_state_int_type = int16_t;
 
+// Bounds the work of bison's error recovery on badly broken input, where it
+// may discard long stretches of tokens one by one, and cascade into more
+// errors.  See ParserParam::SetErrorRecoveryLimit().
+struct ErrorRecoveryLimit {
+  // Number of tokens that may be discarded in a row while recovering from a
+  // syntax error, before the rest is skipped up to the next synchronization
+  // token.  0: no limit.
+  int max_discarded_tokens = 0;
+
+  // Returns true for tokens at which parsing likely gets going again, e.g.
+  // keywords that start or end top-level declarations.
+  std::function<bool(const TokenInfo&)> is_sync_token;
+
+  // A token that completes most error rules of the grammar (e.g. ';' for
+  // "error ';'"), which is inserted with empty text before the
+  // synchronization token, so that the parser resumes there.
+  int terminator_token_enum = 0;
+};
+
 // TODO(hzeller): Naming. Very generic name; unclear what this class does from
 // the name alone (naming derived because it is passed as %param to bison).
 class ParserParam {
@@ -55,6 +79,20 @@ class ParserParam {
   // discards it.
   void RecordSyntaxError(const SymbolPtr& symbol_ptr);
 
+  // Called (by patched parser code) when bison's error recovery discards the
+  // last fetched token.
+  void RecordDiscardedToken();
+
+  // Limits the tokens that error recovery discards, see ErrorRecoveryLimit.
+  // Must be called before parsing.
+  void SetErrorRecoveryLimit(ErrorRecoveryLimit limit) {
+    recovery_limit_ = std::move(limit);
+  }
+
+  // Number of tokens that were discarded or skipped by error recovery,
+  // i.e. that are missing from the syntax tree.
+  size_t DroppedTokens() const { return discarded_tokens_ + skipped_tokens_; }
+
   // Filename being processed, if known.
   absl::string_view filename() const { return filename_; }
 
@@ -66,6 +104,10 @@ class ParserParam {
   // to the new (larger) ones and stack pointers are updated.
   // All stacks must be of the same size which is updated too.
   // Method updates the *size ptr with the new size.
+  // The first resize grows stacks to at least the largest size of previous
+  // parses (of this process), so that deeply nested inputs, which tend to
+  // come in batches, have their stacks reallocated once rather than
+  // doubled again and again.
   //
   // New bison (at least 3.5) define the size type to be ptrdiff_t, while old
   // bisons use size_t. Be compatible with any reasonable long-ish type.
@@ -103,6 +145,15 @@ class ParserParam {
   TokenInfo last_token_;
   ConcreteSyntaxTree root_;
 
+  ErrorRecoveryLimit recovery_limit_;
+  // Tokens discarded in a row, up to the last fetched token.
+  int discarded_in_a_row_ = 0;
+  bool last_token_discarded_ = false;
+  // Synchronization token to fetch after an inserted terminator token.
+  std::optional<TokenInfo> pending_sync_token_;
+  size_t discarded_tokens_ = 0;
+  size_t skipped_tokens_ = 0;
+
   // Overflow storage for parser's internal symbol and value stack.
   StateStack state_stack_;
   ValueStack value_stack_;
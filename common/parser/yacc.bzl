@@ -41,6 +41,9 @@ def std_move_parser_symbols(name, src, out):
 def record_recovered_syntax_errors(name, src, out):
     """Save syntax error tokens prior to error recovery.
 
+    Also counts the tokens that error recovery discards, see
+    ParserParam::RecordDiscardedToken().
+
     Args:
       name: name of this label.
       src: a yacc/bison-generated .tab.cc source file.
@@ -54,6 +57,8 @@ def record_recovered_syntax_errors(name, src, out):
           // Automatically patched by >>record_recovered_syntax_errors<< rule:\
           param->RecordSyntaxError(yylval);\
           // end of automatic patch\
+          ' -e '/Error: discarding/i\
+          param->RecordDiscardedToken();  // record_recovered_syntax_errors\
           ' < $< > $@",
     )
 
@@ -14,10 +14,13 @@
 
 #include "common/strings/diff.h"
 
+#include <cstdint>
 #include <iostream>
 #include <vector>
 
+#include "absl/container/flat_hash_map.h"
 #include "absl/strings/str_split.h"
+#include "common/strings/histogram_diff.h"
 #include "common/strings/split.h"
 #include "common/util/iterator_range.h"
 #include "external_libs/editscript.h"
@@ -41,13 +44,33 @@ static char EditOperationToLineMarker(Operation op) {
   }
 }
 
-LineDiffs::LineDiffs(absl::string_view before, absl::string_view after)
+// Diffs lines as integers, equal for equal lines, which are cheaper to
+// compare and to hash.
+static Edits GetLineDiffs(const std::vector<absl::string_view>& before_lines,
+                          const std::vector<absl::string_view>& after_lines,
+                          int threads) {
+  absl::flat_hash_map<absl::string_view, uint32_t> line_ids;
+  line_ids.reserve(before_lines.size() + after_lines.size());
+  const auto to_ids = [&line_ids](const std::vector<absl::string_view>& lines) {
+    std::vector<uint32_t> ids;
+    ids.reserve(lines.size());
+    for (absl::string_view line : lines) {
+      ids.push_back(line_ids.emplace(line, line_ids.size()).first->second);
+    }
+    return ids;
+  };
+  const std::vector<uint32_t> before_ids = to_ids(before_lines);
+  const std::vector<uint32_t> after_ids = to_ids(after_lines);
+  return HistogramTokenDiffs(before_ids, after_ids, threads);
+}
+
+LineDiffs::LineDiffs(absl::string_view before, absl::string_view after,
+                     int threads)
     : before_text(before),
       after_text(after),
       before_lines(SplitLinesKeepLineTerminator(before_text)),
       after_lines(SplitLinesKeepLineTerminator(after_text)),
-      edits(diff::GetTokenDiffs(before_lines.begin(), before_lines.end(),
-                                after_lines.begin(), after_lines.end())) {}
+      edits(GetLineDiffs(before_lines, after_lines, threads)) {}
 
 template <typename Iter>
 static std::ostream& PrintLineRange(std::ostream& stream, char op, Iter start,
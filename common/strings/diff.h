@@ -39,8 +39,11 @@ struct LineDiffs {
   const std::vector<absl::string_view> after_lines;   // lines
   const diff::Edits edits;  // line difference/edit-sequence between texts.
 
-  // Computes the line-difference between before_text and after_text.
-  LineDiffs(absl::string_view before_text, absl::string_view after_text);
+  // Computes the line-difference between before_text and after_text, with
+  // the histogram diff algorithm (see HistogramTokenDiffs()), on up to
+  // "threads" threads.
+  LineDiffs(absl::string_view before_text, absl::string_view after_text,
+            int threads = 1);
 
   std::ostream& PrintEdit(std::ostream&, const diff::Edit&) const;
 };
@@ -718,9 +718,9 @@ TEST(LineDiffsToUnifiedDiffTest, Various) {
           " b\n"
           "@@ -6,2 +6,3 @@\n"
           " f\n"
-          "+g\n"
           "-h\n"
           "\\ No newline at end of file\n"
+          "+g\n"
           "+h\n",
       },
       // Missing \n in the last line of "after" text
@@ -738,8 +738,8 @@ TEST(LineDiffsToUnifiedDiffTest, Various) {
           " b\n"
           "@@ -6,2 +6,3 @@\n"
           " f\n"
-          "+g\n"
           "-h\n"
+          "+g\n"
           "+h\n"
           "\\ No newline at end of file\n",
       },
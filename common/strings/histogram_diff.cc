@@ -0,0 +1,236 @@
+// Copyright 2017-2023 The Verible Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "common/strings/histogram_diff.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <iterator>
+#include <optional>
+#include <thread>  // NOLINT
+#include <vector>
+
+#include "absl/container/flat_hash_map.h"
+#include "external_libs/editscript.h"
+
+namespace verible {
+namespace {
+
+using diff::Edit;
+using diff::Edits;
+using diff::Operation;
+using diff::diff_impl::AppendEdit;
+
+// Tokens occurring more often than this in a region are not matched on.
+constexpr int64_t kMaxOccurrences = 64;
+
+// Regions are only split across threads if both halves have at least this
+// many tokens.
+constexpr int64_t kMinParallelTokens = 1 << 14;
+
+// Tokens [b1, e1) of tokens1 and [b2, e2) of tokens2.
+struct Region {
+  int64_t b1, e1, b2, e2;
+
+  int64_t Size() const { return (e1 - b1) + (e2 - b2); }
+};
+
+// Tokens [b1, b1 + length) of tokens1, equal to [b2, b2 + length) of tokens2.
+struct Match {
+  int64_t b1, b2, length;
+};
+
+class HistogramDiffer {
+ public:
+  HistogramDiffer(const std::vector<uint32_t>& tokens1,
+                  const std::vector<uint32_t>& tokens2)
+      : tokens1_(tokens1), tokens2_(tokens2) {}
+
+  // Appends the edits of "region" to "edits", diffing on up to "threads"
+  // threads.
+  void Diff(const Region& region, int threads, Edits* edits) const;
+
+ private:
+  // Returns the longest match around the rarest token of "region" (without
+  // common prefix or suffix) that both sides have, or nullopt if there is
+  // none that occurs at most kMaxOccurrences times.
+  std::optional<Match> FindMatch(const Region& region) const;
+
+  void MyersDiff(const Region& region, Edits* edits) const;
+
+  const std::vector<uint32_t>& tokens1_;
+  const std::vector<uint32_t>& tokens2_;
+};
+
+void HistogramDiffer::Diff(const Region& region, int threads,
+                           Edits* edits) const {
+  // Regions left to diff and matches between them, the next one last.
+  // Iterative rather than recursive: there may be about as many levels as
+  // there are tokens.
+  struct Task {
+    Region region;
+    bool is_match;
+  };
+  std::vector<Task> tasks = {{region, false}};
+  while (!tasks.empty()) {
+    auto [b1, e1, b2, e2] = tasks.back().region;
+    const bool is_match = tasks.back().is_match;
+    tasks.pop_back();
+    if (is_match) {
+      AppendEdit(Operation::EQUALS, b1, e1, edits);
+      continue;
+    }
+
+    // Peel off the common prefix and suffix.
+    const auto tokens1 = tokens1_.begin();
+    const auto tokens2 = tokens2_.begin();
+    const int64_t prefix =
+        std::mismatch(tokens1 + b1, tokens1 + e1, tokens2 + b2, tokens2 + e2)
+            .first -
+        (tokens1 + b1);
+    if (prefix != 0) {
+      AppendEdit(Operation::EQUALS, b1, b1 + prefix, edits);
+      b1 += prefix;
+      b2 += prefix;
+    }
+    const int64_t suffix =
+        std::mismatch(std::make_reverse_iterator(tokens1 + e1),
+                      std::make_reverse_iterator(tokens1 + b1),
+                      std::make_reverse_iterator(tokens2 + e2),
+                      std::make_reverse_iterator(tokens2 + b2))
+            .first -
+        std::make_reverse_iterator(tokens1 + e1);
+    if (suffix != 0) {
+      tasks.push_back({{e1 - suffix, e1, e2 - suffix, e2}, true});
+      e1 -= suffix;
+      e2 -= suffix;
+    }
+
+    if (b1 == e1 || b2 == e2) {
+      if (b1 != e1) AppendEdit(Operation::DELETE, b1, e1, edits);
+      if (b2 != e2) AppendEdit(Operation::INSERT, b2, e2, edits);
+      continue;
+    }
+    const Region middle = {b1, e1, b2, e2};
+    const std::optional<Match> match = FindMatch(middle);
+    if (!match) {
+      MyersDiff(middle, edits);
+      continue;
+    }
+
+    const Region before = {b1, match->b1, b2, match->b2};
+    const Region matched = {match->b1, match->b1 + match->length, match->b2,
+                            match->b2 + match->length};
+    const Region after = {matched.e1, e1, matched.e2, e2};
+    if (threads > 1 &&
+        std::min(before.Size(), after.Size()) >= kMinParallelTokens) {
+      Edits before_edits;
+      std::thread before_thread(
+          [&]() { Diff(before, threads / 2, &before_edits); });
+      Edits after_edits;
+      Diff(after, threads - threads / 2, &after_edits);
+      before_thread.join();
+      for (const Edit& edit : before_edits) {
+        AppendEdit(edit.operation, edit.start, edit.end, edits);
+      }
+      AppendEdit(Operation::EQUALS, matched.b1, matched.e1, edits);
+      for (const Edit& edit : after_edits) {
+        AppendEdit(edit.operation, edit.start, edit.end, edits);
+      }
+      continue;
+    }
+    tasks.push_back({after, false});
+    tasks.push_back({matched, true});
+    tasks.push_back({before, false});
+  }
+}
+
+std::optional<Match> HistogramDiffer::FindMatch(const Region& region) const {
+  // Occurrences of each token on the first side, chained from the last.
+  struct Occurrences {
+    int64_t count = 0;
+    int64_t last = -1;
+  };
+  absl::flat_hash_map<uint32_t, Occurrences> occurrences;
+  occurrences.reserve(region.e1 - region.b1);
+  std::vector<int64_t> previous(region.e1 - region.b1);
+  for (int64_t i = region.b1; i < region.e1; ++i) {
+    Occurrences& token = occurrences[tokens1_[i]];
+    previous[i - region.b1] = token.last;
+    token.last = i;
+    ++token.count;
+  }
+
+  std::optional<Match> best;
+  int64_t best_count = kMaxOccurrences;
+  for (int64_t j = region.b2; j < region.e2;) {
+    const auto found = occurrences.find(tokens2_[j]);
+    if (found == occurrences.end() || found->second.count > best_count) {
+      ++j;
+      continue;
+    }
+    int64_t next_j = j + 1;
+    for (int64_t i = found->second.last; i >= 0;
+         i = previous[i - region.b1]) {
+      // Extend the match in both directions.
+      int64_t b1 = i, b2 = j, e1 = i + 1, e2 = j + 1;
+      while (b1 > region.b1 && b2 > region.b2 &&
+             tokens1_[b1 - 1] == tokens2_[b2 - 1]) {
+        --b1;
+        --b2;
+      }
+      while (e1 < region.e1 && e2 < region.e2 &&
+             tokens1_[e1] == tokens2_[e2]) {
+        ++e1;
+        ++e2;
+      }
+      const int64_t count = found->second.count;
+      if (!best || count < best_count ||
+          (count == best_count && e1 - b1 > best->length)) {
+        best = Match{b1, b2, e1 - b1};
+        best_count = count;
+      }
+      // Tokens matched already are not worth trying again.
+      next_j = std::max(next_j, e2);
+    }
+    j = next_j;
+  }
+  return best;
+}
+
+void HistogramDiffer::MyersDiff(const Region& region, Edits* edits) const {
+  const Edits region_edits = diff::GetTokenDiffs(
+      tokens1_.begin() + region.b1, tokens1_.begin() + region.e1,
+      tokens2_.begin() + region.b2, tokens2_.begin() + region.e2);
+  for (const Edit& edit : region_edits) {
+    const int64_t offset =
+        edit.operation == Operation::INSERT ? region.b2 : region.b1;
+    AppendEdit(edit.operation, edit.start + offset, edit.end + offset, edits);
+  }
+}
+
+}  // namespace
+
+diff::Edits HistogramTokenDiffs(const std::vector<uint32_t>& tokens1,
+                                const std::vector<uint32_t>& tokens2,
+                                int threads) {
+  Edits edits;
+  HistogramDiffer(tokens1, tokens2)
+      .Diff({0, static_cast<int64_t>(tokens1.size()), 0,
+             static_cast<int64_t>(tokens2.size())},
+            std::max(threads, 1), &edits);
+  return edits;
+}
+
+}  // namespace verible
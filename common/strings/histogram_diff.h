@@ -0,0 +1,44 @@
+// Copyright 2017-2023 The Verible Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef VERIBLE_COMMON_STRINGS_HISTOGRAM_DIFF_H_
+#define VERIBLE_COMMON_STRINGS_HISTOGRAM_DIFF_H_
+
+#include <cstdint>
+#include <vector>
+
+#include "external_libs/editscript.h"
+
+namespace verible {
+
+// Finds the edits to transform "tokens1" into "tokens2", in the same form as
+// diff::GetTokenDiffs(), with the histogram diff algorithm (as in git): the
+// tokens are matched around the rarest token common to both sides, then
+// what comes before and after is diffed the same way.  Regions without
+// tokens rare enough to be worth matching on fall back to Myers' algorithm.
+//
+// The result is not always the shortest edit sequence, but it tends to read
+// better, and large inputs with many changes take about linear time instead
+// of the quadratic time of Myers' algorithm.
+//
+// Tokens are integers, e.g. lines mapped to the same integer when equal.
+// Up to "threads" threads diff large regions concurrently; the result does
+// not depend on it.
+diff::Edits HistogramTokenDiffs(const std::vector<uint32_t>& tokens1,
+                                const std::vector<uint32_t>& tokens2,
+                                int threads = 1);
+
+}  // namespace verible
+
+#endif  // VERIBLE_COMMON_STRINGS_HISTOGRAM_DIFF_H_
@@ -0,0 +1,154 @@
+// Copyright 2017-2023 The Verible Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "common/strings/histogram_diff.h"
+
+#include <cstdint>
+#include <random>
+#include <vector>
+
+#include "external_libs/editscript.h"
+#include "gtest/gtest.h"
+
+namespace verible {
+namespace {
+
+using diff::Edit;
+using diff::Edits;
+using diff::Operation;
+
+// Checks that "edits" transform "tokens1" into "tokens2", and returns the
+// number of tokens deleted or inserted.
+int64_t VerifyEdits(const std::vector<uint32_t>& tokens1,
+                    const std::vector<uint32_t>& tokens2, const Edits& edits) {
+  int64_t i1 = 0, i2 = 0, changed = 0;
+  for (const Edit& edit : edits) {
+    EXPECT_LT(edit.start, edit.end);
+    switch (edit.operation) {
+      case Operation::EQUALS:
+        EXPECT_EQ(edit.start, i1);
+        for (int64_t i = edit.start; i < edit.end; ++i, ++i2) {
+          EXPECT_EQ(tokens1[i], tokens2[i2]) << i << " " << i2;
+        }
+        i1 = edit.end;
+        break;
+      case Operation::DELETE:
+        EXPECT_EQ(edit.start, i1);
+        changed += edit.end - edit.start;
+        i1 = edit.end;
+        break;
+      case Operation::INSERT:
+        EXPECT_EQ(edit.start, i2);
+        changed += edit.end - edit.start;
+        i2 = edit.end;
+        break;
+    }
+  }
+  EXPECT_EQ(i1, tokens1.size());
+  EXPECT_EQ(i2, tokens2.size());
+  return changed;
+}
+
+TEST(HistogramTokenDiffsTest, Trivial) {
+  EXPECT_TRUE(HistogramTokenDiffs({}, {}).empty());
+  EXPECT_EQ(HistogramTokenDiffs({1, 2}, {}),
+            (Edits{{Operation::DELETE, 0, 2}}));
+  EXPECT_EQ(HistogramTokenDiffs({}, {1, 2}),
+            (Edits{{Operation::INSERT, 0, 2}}));
+  EXPECT_EQ(HistogramTokenDiffs({1, 2}, {1, 2}),
+            (Edits{{Operation::EQUALS, 0, 2}}));
+  EXPECT_EQ(HistogramTokenDiffs({1, 2, 3}, {1, 4, 3}),
+            (Edits{{Operation::EQUALS, 0, 1},
+                   {Operation::DELETE, 1, 2},
+                   {Operation::INSERT, 1, 2},
+                   {Operation::EQUALS, 2, 3}}));
+}
+
+TEST(HistogramTokenDiffsTest, MatchesOnRareTokens) {
+  // Think of a function (1, 2) moved after another one (3, 4), with
+  // frequent (0) lines in between: one function is kept whole, rather than
+  // the frequent lines.
+  const std::vector<uint32_t> tokens1 = {1, 0, 2, 0, 3, 0, 4, 0};
+  const std::vector<uint32_t> tokens2 = {3, 0, 4, 0, 1, 0, 2, 0};
+  const Edits edits = HistogramTokenDiffs(tokens1, tokens2);
+  VerifyEdits(tokens1, tokens2, edits);
+  EXPECT_EQ(edits, (Edits{{Operation::DELETE, 0, 4},
+                          {Operation::EQUALS, 4, 7},
+                          {Operation::INSERT, 3, 7},
+                          {Operation::EQUALS, 7, 8}}));
+}
+
+TEST(HistogramTokenDiffsTest, FallsBackToMyersWithoutRareTokens) {
+  // Only tokens that occur too often to be matched on.
+  std::vector<uint32_t> tokens1, tokens2;
+  for (int i = 0; i < 200; ++i) {
+    tokens1.push_back(i % 2);
+    tokens2.push_back(i % 3 == 0);
+  }
+  const Edits edits = HistogramTokenDiffs(tokens1, tokens2);
+  EXPECT_EQ(VerifyEdits(tokens1, tokens2, edits),
+            VerifyEdits(tokens1, tokens2,
+                        diff::GetTokenDiffs(tokens1.begin(), tokens1.end(),
+                                            tokens2.begin(), tokens2.end())));
+}
+
+TEST(HistogramTokenDiffsTest, RandomEdits) {
+  std::mt19937 random(42);
+  for (int round = 0; round < 50; ++round) {
+    std::vector<uint32_t> tokens1(random() % 300);
+    for (uint32_t& token : tokens1) token = random() % 50;
+    std::vector<uint32_t> tokens2;
+    for (uint32_t token : tokens1) {
+      switch (random() % 8) {
+        case 0:  // deleted
+          break;
+        case 1:  // inserted
+          tokens2.push_back(random() % 50);
+          tokens2.push_back(token);
+          break;
+        case 2:  // changed
+          tokens2.push_back(random() % 50);
+          break;
+        default:
+          tokens2.push_back(token);
+      }
+    }
+    VerifyEdits(tokens1, tokens2, HistogramTokenDiffs(tokens1, tokens2));
+  }
+}
+
+TEST(HistogramTokenDiffsTest, LargeInputsSameOnThreads) {
+  // Mostly unique "lines", with many changes all over the place.
+  std::mt19937 random(1);
+  std::vector<uint32_t> tokens1, tokens2;
+  for (uint32_t i = 0; i < 200000; ++i) {
+    const uint32_t token = i % 10 == 0 ? 0 : i;
+    tokens1.push_back(token);
+    switch (random() % 20) {
+      case 0:
+        break;
+      case 1:
+        tokens2.push_back(1000000 + i);
+        break;
+      default:
+        tokens2.push_back(token);
+    }
+  }
+  const Edits edits = HistogramTokenDiffs(tokens1, tokens2);
+  VerifyEdits(tokens1, tokens2, edits);
+  EXPECT_EQ(HistogramTokenDiffs(tokens1, tokens2, 4), edits);
+}
+
+}  // namespace
+}  // namespace verible
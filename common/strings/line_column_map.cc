@@ -21,9 +21,18 @@
 #include <iterator>
 #include <vector>
 
+#include "absl/numeric/bits.h"
 #include "absl/strings/string_view.h"
 #include "common/strings/utf8.h"
 
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#elif defined(__aarch64__) && defined(__ARM_NEON)
+#include <arm_neon.h>
+
+#include <cstdint>
+#endif
+
 namespace verible {
 
 // Print to the user as 1-based index because that is how lines
@@ -97,4 +106,145 @@ int LineColumnMap::LineAtOffset(int bytes_offset) const {
   const auto line_at_offset = std::upper_bound(begin, end, bytes_offset) - 1;
   return std::distance(begin, line_at_offset);
 }
+
+// Returns the length of the longest prefix of 'text' that is ASCII, checking
+// 16 bytes at a time with SSE2 or NEON where available.
+static size_t AsciiPrefixLength(absl::string_view text) {
+  size_t i = 0;
+#if defined(__SSE2__)
+  for (; i + 16 <= text.size(); i += 16) {
+    const __m128i bytes =
+        _mm_loadu_si128(reinterpret_cast<const __m128i*>(text.data() + i));
+    const unsigned non_ascii = static_cast<unsigned>(_mm_movemask_epi8(bytes));
+    if (non_ascii != 0) return i + absl::countr_zero(non_ascii);
+  }
+#elif defined(__aarch64__) && defined(__ARM_NEON)
+  for (; i + 16 <= text.size(); i += 16) {
+    const uint8x16_t bytes =
+        vld1q_u8(reinterpret_cast<const uint8_t*>(text.data() + i));
+    if (vmaxvq_u8(bytes) >= 0x80) break;  // Left to the scalar loop.
+  }
+#endif
+  while (i < text.size() && static_cast<unsigned char>(text[i]) < 0x80) ++i;
+  return i;
+}
+
+Utf16ColumnMap::Utf16ColumnMap(absl::string_view text)
+    : text_length_(text.length()) {
+  size_t line_start = 0;
+  for (;;) {
+    line_starts_.push_back(line_start);
+    first_character_.push_back(characters_.size());
+    const size_t newline = text.find('\n', line_start);
+    const size_t line_end =
+        newline == absl::string_view::npos ? text.size() : newline;
+    const absl::string_view line =
+        text.substr(line_start, line_end - line_start);
+    int utf16_column = 0;
+    size_t column = 0;
+    for (;;) {
+      const size_t ascii = AsciiPrefixLength(line.substr(column));
+      utf16_column += ascii;
+      column += ascii;
+      if (column == line.size()) break;
+      // Like utf8_len(), a character is a byte that doesn't continue one,
+      // with the bytes that continue it.
+      size_t end = column + 1;
+      while (end < line.size() && end - column < 4 &&
+             (line[end] & 0xc0) == 0x80) {
+        ++end;
+      }
+      const Character character{static_cast<int>(column),
+                                static_cast<int>(end), utf16_column};
+      characters_.push_back(character);
+      utf16_column = character.utf16_end();
+      column = end;
+    }
+    if (newline == absl::string_view::npos) break;
+    line_start = newline + 1;
+  }
+  first_character_.push_back(characters_.size());
+}
+
+int Utf16ColumnMap::LineLength(int line) const {
+  const int end =
+      line + 1 < lines() ? line_starts_[line + 1] - 1 : text_length_;
+  return end - line_starts_[line];
+}
+
+LineColumn Utf16ColumnMap::GetLineColAtOffset(int bytes_offset) const {
+  const int line = std::upper_bound(line_starts_.begin(), line_starts_.end(),
+                                    bytes_offset) -
+                   line_starts_.begin() - 1;
+  return {line, Utf16Column(line, bytes_offset - line_starts_[line])};
+}
+
+int Utf16ColumnMap::Utf16Column(int line, int byte_column) const {
+  const auto begin = characters_.begin() + first_character_[line];
+  const auto end = characters_.begin() + first_character_[line + 1];
+  // The first character that ends after the column.
+  const auto found = std::partition_point(
+      begin, end, [byte_column](const Character& c) {
+        return c.end <= byte_column;
+      });
+  if (found != end && found->begin <= byte_column) return found->utf16_column;
+  if (found == begin) return byte_column;  // Only ASCII before.
+  const Character& before = *std::prev(found);
+  return before.utf16_end() + (byte_column - before.end);
+}
+
+int Utf16ColumnMap::OffsetAtLineCol(const LineColumn& pos) const {
+  if (pos.line < 0 || pos.line >= lines()) return -1;
+  const auto begin = characters_.begin() + first_character_[pos.line];
+  const auto end = characters_.begin() + first_character_[pos.line + 1];
+  const int column = std::max(pos.column, 0);
+  // The first character that ends after the column.
+  const auto found =
+      std::partition_point(begin, end, [column](const Character& c) {
+        return c.utf16_end() <= column;
+      });
+  int byte_column;
+  if (found != end && found->utf16_column <= column) {
+    byte_column = found->begin;
+  } else if (found == begin) {
+    byte_column = column;
+  } else {
+    const Character& before = *std::prev(found);
+    byte_column = before.end + (column - before.utf16_end());
+  }
+  return line_starts_[pos.line] + std::min(byte_column, LineLength(pos.line));
+}
+
+int LineColumnCursor::LineAtOffset(int bytes_offset) {
+  const std::vector<int>& offsets = map_.GetBeginningOfLineOffsets();
+  if (offsets.empty() || bytes_offset < offsets[line_]) {
+    // Moved backwards.
+    const int line = map_.LineAtOffset(bytes_offset);
+    line_ = std::max(line, 0);
+    return line;
+  }
+  // Consecutive lookups are usually on the same or one of the next few lines.
+  constexpr int kMaxSteps = 8;
+  const int last_line = static_cast<int>(offsets.size()) - 1;
+  for (int steps = 0; steps < kMaxSteps; ++steps) {
+    if (line_ == last_line || bytes_offset < offsets[line_ + 1]) return line_;
+    ++line_;
+  }
+  // Far ahead: search the rest.
+  const auto line_at_offset =
+      std::upper_bound(offsets.begin() + line_ + 1, offsets.end(),
+                       bytes_offset) -
+      1;
+  line_ = std::distance(offsets.begin(), line_at_offset);
+  return line_;
+}
+
+LineColumn LineColumnCursor::GetLineColAtOffset(absl::string_view base,
+                                                int bytes_offset) {
+  const int line_number = LineAtOffset(bytes_offset);
+  const int line_offset = map_.GetBeginningOfLineOffsets()[line_number];
+  absl::string_view line =
+      base.substr(line_offset, bytes_offset - line_offset);
+  return LineColumn{line_number, utf8_len(line)};
+}
 }  // namespace verible
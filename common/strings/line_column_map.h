@@ -119,6 +119,85 @@ class LineColumnMap {
   std::vector<int> beginning_of_line_offsets_;
 };
 
+// Translates between byte offsets and the line/columns of the language server
+// protocol, whose columns count UTF-16 code units: characters beyond the
+// basic multilingual plane count twice.  Columns of lines with only ASCII
+// characters are translated in O(1), others with a binary search over their
+// non-ASCII characters.  Lines are found with a binary search.
+//
+// Lines are the same as those of LineColumnMap(text).
+class Utf16ColumnMap {
+ public:
+  // Indexes 'text', which doesn't need to outlive this object.
+  explicit Utf16ColumnMap(absl::string_view text);
+
+  // Returns the line and UTF-16 column at 'bytes_offset'.  Offsets within a
+  // multi-byte character give its column.
+  LineColumn GetLineColAtOffset(int bytes_offset) const;
+
+  // Returns the UTF-16 column of byte column 'byte_column' of 'line'.
+  int Utf16Column(int line, int byte_column) const;
+
+  // Returns the byte offset of the UTF-16 line and column 'pos'.  Columns
+  // beyond the end of the line give the offset of its end (before the
+  // newline), columns between the two code units of a surrogate pair give
+  // the offset of its character.  Returns -1 if there is no such line.
+  int OffsetAtLineCol(const LineColumn& pos) const;
+
+  // Returns the number of lines.
+  int lines() const { return line_starts_.size(); }
+
+ private:
+  // A non-ASCII character: its byte columns and the UTF-16 column it starts.
+  struct Character {
+    int begin;
+    int end;
+    int utf16_column;
+
+    int utf16_end() const { return utf16_column + (end - begin == 4 ? 2 : 1); }
+  };
+
+  // Returns the byte length of 'line', without its newline.
+  int LineLength(int line) const;
+
+  // Index: line number, Value: byte offset that starts the line.
+  std::vector<int> line_starts_;
+  int text_length_ = 0;
+  // Index: line number, Value: index of its first character in characters_.
+  // The last value is the number of characters.
+  std::vector<int> first_character_;
+  std::vector<Character> characters_;
+};
+
+// Looks up offsets in a LineColumnMap, starting from the line of the previous
+// lookup.  For callers that visit offsets in order, such as tokens or sorted
+// violations, this makes every lookup amortized O(1) instead of a binary
+// search.  Out-of-order lookups are still correct, but fall back to a search.
+// The results are the same as those of the LineColumnMap.
+//
+// usage:
+// LineColumnCursor cursor(lcmap);
+// for (const auto& token : tokens) {
+//   const LineColumn location = cursor.GetLineColAtOffset(base, ...);
+// }
+class LineColumnCursor {
+ public:
+  // 'map' must outlive this object.
+  explicit LineColumnCursor(const LineColumnMap& map) : map_(map) {}
+
+  // Same as LineColumnMap::LineAtOffset().
+  int LineAtOffset(int bytes_offset);
+
+  // Same as LineColumnMap::GetLineColAtOffset().
+  LineColumn GetLineColAtOffset(absl::string_view base, int bytes_offset);
+
+ private:
+  const LineColumnMap& map_;
+
+  // Line of the last lookup.
+  int line_ = 0;
+};
+
 }  // namespace verible
 
 #endif  // VERIBLE_COMMON_STRINGS_LINE_COLUMN_MAP_H_
@@ -17,6 +17,7 @@
 #include "common/strings/line_column_map.h"
 
 #include <sstream>  // IWYU pragma: keep  // for ostringstream
+#include <string>
 #include <vector>
 
 #include "absl/strings/str_split.h"
@@ -173,6 +174,45 @@ TEST(LineColumnMapTest, Lookup) {
   }
 }
 
+// The cursor translates the same as the map, for in-order queries.
+TEST(LineColumnCursorTest, Lookup) {
+  for (const auto& test_case : map_test_data) {
+    const LineColumnMap line_map(test_case.text);
+    LineColumnCursor cursor(line_map);
+    for (const auto& q : test_case.queries) {
+      EXPECT_EQ(q.line_col, cursor.GetLineColAtOffset(test_case.text, q.offset))
+          << "Text: \"" << test_case.text << "\"\n"
+          << "Failed testing offset " << q.offset;
+    }
+  }
+}
+
+// Every offset, forwards, backwards and jumping around, with lines farther
+// apart than the cursor steps.
+TEST(LineColumnCursorTest, AnyOrder) {
+  std::string text;
+  for (int i = 0; i < 100; ++i) {
+    text += std::string(i % 7, 'x') + "\n";
+  }
+  const LineColumnMap line_map(text);
+  const int size = static_cast<int>(text.size());
+  std::vector<int> queries;
+  for (int offset = 0; offset <= size; ++offset) queries.push_back(offset);
+  for (int offset = size; offset >= 0; --offset) queries.push_back(offset);
+  for (int offset = 0; offset <= size; offset += 37) {
+    queries.push_back(offset);
+    queries.push_back(size - offset);
+  }
+  LineColumnCursor cursor(line_map);
+  for (const int offset : queries) {
+    EXPECT_EQ(cursor.LineAtOffset(offset), line_map.LineAtOffset(offset))
+        << offset;
+    EXPECT_EQ(cursor.GetLineColAtOffset(text, offset),
+              line_map.GetLineColAtOffset(text, offset))
+        << offset;
+  }
+}
+
 TEST(LineColumnTest, LineColumnComparison) {
   constexpr LineColumn before_line{.line = 41, .column = 1};
   constexpr LineColumn before_col{.line = 42, .column = 1};
@@ -200,5 +240,66 @@ TEST(LineColumnTest, LineColumnRangeComparison) {
   EXPECT_TRUE(range.PositionInRange(inside_end));
   EXPECT_FALSE(range.PositionInRange(outside_after_end));
 }
+
+// Returns the UTF-16 column at "offset" of "text", counted from the start of
+// its line.
+static LineColumn Utf16LineColumnOf(absl::string_view text, int offset) {
+  LineColumn result{0, 0};
+  for (int i = 0; i < offset; ++i) {
+    const unsigned char c = text[i];
+    if (c == '\n') {
+      result = {result.line + 1, 0};
+    } else if ((c & 0xc0) != 0x80) {
+      result.column += (c & 0xf8) == 0xf0 ? 2 : 1;
+    }
+  }
+  return result;
+}
+
+TEST(Utf16ColumnMapTest, AsciiColumnsAreByteColumns) {
+  const absl::string_view text =
+      "module a_module_with_a_long_name;\n"
+      "\n"
+      "endmodule";
+  const Utf16ColumnMap map(text);
+  EXPECT_EQ(map.lines(), 3);
+  for (int offset = 0; offset <= static_cast<int>(text.size()); ++offset) {
+    EXPECT_EQ(map.GetLineColAtOffset(offset), Utf16LineColumnOf(text, offset))
+        << offset;
+  }
+  EXPECT_EQ(map.OffsetAtLineCol({0, 7}), 7);
+  EXPECT_EQ(map.OffsetAtLineCol({0, 100}), 33);  // End of line.
+  EXPECT_EQ(map.OffsetAtLineCol({1, 0}), 34);
+  EXPECT_EQ(map.OffsetAtLineCol({2, 9}), 44);
+  EXPECT_EQ(map.OffsetAtLineCol({3, 0}), -1);
+}
+
+TEST(Utf16ColumnMapTest, NonAsciiColumns) {
+  // A long ASCII prefix, then characters of two, three and four bytes.
+  const absl::string_view text =
+      "// A comment with a long ASCII prefix \xc3\xa4 \xe2\x82\xac "
+      "\xf0\x9f\x98\x80 end\n"
+      "\xf0\x9f\x98\x80\xf0\x9f\x98\x80x\n";
+  const Utf16ColumnMap map(text);
+  for (int offset = 0; offset <= static_cast<int>(text.size()); ++offset) {
+    if (offset < static_cast<int>(text.size()) &&
+        (text[offset] & 0xc0) == 0x80) {
+      continue;  // Within a character.
+    }
+    const LineColumn pos = Utf16LineColumnOf(text, offset);
+    EXPECT_EQ(map.GetLineColAtOffset(offset), pos) << offset;
+    EXPECT_EQ(map.OffsetAtLineCol(pos), offset) << offset;
+  }
+  // ä starts at byte 38, € at byte 41, the emoji at byte 45.
+  EXPECT_EQ(map.Utf16Column(0, 38), 38);
+  EXPECT_EQ(map.Utf16Column(0, 39), 38);  // Within ä.
+  EXPECT_EQ(map.Utf16Column(0, 41), 40);
+  EXPECT_EQ(map.Utf16Column(0, 45), 42);
+  EXPECT_EQ(map.Utf16Column(0, 49), 44);  // Emoji counts twice.
+  EXPECT_EQ(map.OffsetAtLineCol({0, 43}), 45);  // Within the surrogate pair.
+  EXPECT_EQ(map.OffsetAtLineCol({0, 100}), 53);
+  EXPECT_EQ(map.GetLineColAtOffset(62), (LineColumn{1, 4}));
+  EXPECT_EQ(map.OffsetAtLineCol({1, 2}), 58);
+}
 }  // namespace
 }  // namespace verible
@@ -65,4 +65,27 @@ bool IsLowerSnakeCaseWithDigits(absl::string_view text) {
   });
 }
 
+uint32_t NamingConventions(absl::string_view text) {
+  if (text.empty()) {
+    return kLowerSnakeCaseWithDigits | kUpperCamelCaseWithDigits |
+           kNameAllCapsUnderscoresDigits;
+  }
+  bool lower_snake_case = absl::ascii_islower(text[0]);
+  bool upper_camel_case = absl::ascii_isupper(text[0]);
+  bool all_caps = true;
+  for (absl::string_view::size_type i = 0; i < text.length(); ++i) {
+    const char c = text[i];
+    const bool digit_or_underscore = absl::ascii_isdigit(c) || c == '_';
+    lower_snake_case &= absl::ascii_islower(c) || digit_or_underscore;
+    all_caps &= absl::ascii_isupper(c) || digit_or_underscore;
+    if (c == '_' &&
+        (i + 1 == text.length() || !absl::ascii_isdigit(text[i + 1]))) {
+      upper_camel_case = false;
+    }
+  }
+  return (lower_snake_case ? kLowerSnakeCaseWithDigits : 0) |
+         (upper_camel_case ? kUpperCamelCaseWithDigits : 0) |
+         (all_caps ? kNameAllCapsUnderscoresDigits : 0);
+}
+
 }  // namespace verible
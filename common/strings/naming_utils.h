@@ -15,6 +15,8 @@
 #ifndef VERIBLE_COMMON_STRINGS_NAMING_UTILS_H_
 #define VERIBLE_COMMON_STRINGS_NAMING_UTILS_H_
 
+#include <cstdint>
+
 #include "absl/strings/string_view.h"
 
 namespace verible {
@@ -33,6 +35,18 @@ bool IsUpperCamelCaseWithDigits(absl::string_view);
 // Returns true if the string follows lower_snake_case naming convention.
 bool IsLowerSnakeCaseWithDigits(absl::string_view);
 
+// Naming conventions, as bits of the result of NamingConventions().
+enum NamingConvention : uint32_t {
+  kLowerSnakeCaseWithDigits = 1 << 0,
+  kUpperCamelCaseWithDigits = 1 << 1,
+  kNameAllCapsUnderscoresDigits = 1 << 2,
+};
+
+// Returns the naming conventions that the string follows, the same as the
+// Is...() functions above, in one pass over it, for rules that accept one of
+// several conventions.
+uint32_t NamingConventions(absl::string_view text);
+
 }  // namespace verible
 
 #endif  // VERIBLE_COMMON_STRINGS_NAMING_UTILS_H_
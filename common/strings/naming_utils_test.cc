@@ -121,5 +121,29 @@ TEST(IsLowerSnakeCaseWithDigitsTest, RejectTests) {
   }
 }
 
+// Tests that the conventions found in one pass are those of the functions for
+// each convention.
+TEST(NamingConventionsTest, SameAsEachConvention) {
+  static const char* test_cases[] = {
+      "",       "_1",          "__hello",      "hello_world", "hello_1",
+      "hello_", "Hello_world", "HelloWorld",   "Hello_1",     "Hello_1_2",
+      "Hello_", "Hello_1World", "HELLO",       "HELLO_1",     "HELLO_",
+      "H",      "h",           "1",            "_",           "helLo1_",
+      "HELLO_WORLD", "Hello$", "hello$",
+  };
+  for (const auto data : test_cases) {
+    const uint32_t conventions = NamingConventions(data);
+    EXPECT_EQ((conventions & kLowerSnakeCaseWithDigits) != 0,
+              IsLowerSnakeCaseWithDigits(data))
+        << data;
+    EXPECT_EQ((conventions & kUpperCamelCaseWithDigits) != 0,
+              IsUpperCamelCaseWithDigits(data))
+        << data;
+    EXPECT_EQ((conventions & kNameAllCapsUnderscoresDigits) != 0,
+              IsNameAllCapsUnderscoresDigits(data))
+        << data;
+  }
+}
+
 }  // namespace
 }  // namespace verible
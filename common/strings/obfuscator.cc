@@ -23,15 +23,18 @@
 #include "absl/strings/str_split.h"
 #include "absl/strings/string_view.h"
 #include "absl/strings/strip.h"
+#include "absl/synchronization/mutex.h"
 #include "common/util/logging.h"
 
 namespace verible {
 
 bool Obfuscator::encode(absl::string_view key, absl::string_view value) {
+  const absl::MutexLock lock(&mutex_);
   return translator_.insert(std::string(key), std::string(value));
 }
 
 absl::string_view Obfuscator::operator()(absl::string_view input) {
+  const absl::MutexLock lock(&mutex_);
   if (decode_mode_) {
     const auto* p = translator_.find_reverse(input);
     return (p != nullptr) ? *p : input;
@@ -45,6 +48,7 @@ constexpr char kPairSeparator = ' ';
 
 std::string Obfuscator::save() const {
   std::ostringstream stream;
+  const absl::MutexLock lock(&mutex_);
   for (const auto& pair : translator_.forward_view()) {
     stream << pair.first << kPairSeparator << *pair.second << "\n";
   }
@@ -20,6 +20,7 @@
 
 #include "absl/status/status.h"
 #include "absl/strings/string_view.h"
+#include "absl/synchronization/mutex.h"
 #include "common/strings/compare.h"
 #include "common/util/bijective_map.h"
 
@@ -38,6 +39,11 @@ namespace verible {
 //
 // The save() and load() functions can be used to re-apply previously used
 // substitutions written/read from a text file.
+//
+// Translation, encode(), load() and save() may be called concurrently, e.g.
+// to obfuscate many files consistently.  The generator is only ever called by
+// one thread at a time.  set_decode_mode() and GetTranslator() are not
+// synchronized: use them before or after sharing the Obfuscator.
 class Obfuscator {
  public:
   using generator_type = std::function<std::string(absl::string_view)>;
@@ -76,7 +82,11 @@ class Obfuscator {
   // Generates a random substitution string, for obfuscation.
   generator_type generator_;
 
+  // Guards translator_ (and generator_, which may not be thread-safe).
+  mutable absl::Mutex mutex_;
+
   // Keeps track of transformations done on seen strings.
+  // Entries are never removed, so returned translations stay valid.
   translator_type translator_;
 
   // If true, apply reverse translation of identifiers, and do not generate any
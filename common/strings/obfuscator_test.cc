@@ -14,6 +14,12 @@
 
 #include "common/strings/obfuscator.h"
 
+#include <string>
+#include <thread>  // NOLINT
+#include <vector>
+
+#include "absl/strings/str_cat.h"
+#include "absl/strings/string_view.h"
 #include "common/strings/random.h"
 #include "common/util/bijective_map.h"
 #include "common/util/logging.h"
@@ -212,5 +218,36 @@ TEST(IdentifierObfuscatorTest, EncodeValidTransform) {
   }
 }
 
+TEST(IdentifierObfuscatorTest, ConcurrentTranslation) {
+  IdentifierObfuscator ob(RandomEqualLengthIdentifier);
+  ob.encode("cat", "cow");
+  // Threads see overlapping sets of words, as files of a project would.
+  constexpr int kThreads = 8;
+  constexpr int kWords = 1000;
+  std::vector<std::vector<std::string>> translations(kThreads);
+  std::vector<std::thread> threads;
+  for (int t = 0; t < kThreads; ++t) {
+    threads.emplace_back([&ob, &translations, t]() {
+      for (int i = 0; i < kWords; ++i) {
+        translations[t].emplace_back(ob(absl::StrCat("w", (i + t * 10))));
+      }
+      EXPECT_EQ(ob("cat"), "cow");
+    });
+  }
+  for (std::thread& thread : threads) thread.join();
+
+  const auto& tran = ob.GetTranslator();
+  EXPECT_EQ(tran.size(), kWords + (kThreads - 1) * 10 + 1);
+  for (int t = 0; t < kThreads; ++t) {
+    for (int i = 0; i < kWords; ++i) {
+      const std::string word = absl::StrCat("w", (i + t * 10));
+      EXPECT_EQ(*ABSL_DIE_IF_NULL(tran.find_forward(word)),
+                translations[t][i]);
+      EXPECT_EQ(*ABSL_DIE_IF_NULL(tran.find_reverse(translations[t][i])),
+                word);
+    }
+  }
+}
+
 }  // namespace
 }  // namespace verible
@@ -17,6 +17,9 @@
 #include <deque>
 #include <iostream>
 #include <iterator>
+#include <memory>
+#include <utility>
+#include <vector>
 
 #include "absl/base/macros.h"
 #include "absl/status/status.h"
@@ -74,7 +77,7 @@ absl::Status MarkedLine::Parse(absl::string_view text) {
     return absl::InvalidArgumentError(absl::StrCat(
         "MarkedLine must begin with one of [ -+], but got: \"", text, "\"."));
   }
-  line.assign(text.begin(), text.end());  // copy
+  line = text;
   return absl::OkStatus();
 }
 
@@ -581,6 +584,14 @@ static bool LineBelongsToPreviousSection(absl::string_view line) {
 }
 
 absl::Status PatchSet::Parse(absl::string_view patch_contents) {
+  return Parse(std::make_shared<StringMemBlock>(patch_contents));
+}
+
+absl::Status PatchSet::Parse(std::shared_ptr<MemBlock> patch_block,
+                             ThreadPool* pool) {
+  const absl::string_view patch_contents = patch_block->AsStringView();
+  contents_.push_back(std::move(patch_block));
+
   // Split lines.  The resulting lines will not include the \n delimiters.
   std::vector<absl::string_view> lines(
       absl::StrSplit(patch_contents, absl::ByChar('\n')));
@@ -624,10 +635,17 @@ absl::Status PatchSet::Parse(absl::string_view patch_contents) {
   const std::vector<internal::LineRange> file_patch_ranges(
       internal::IteratorsToRanges<internal::LineRange>(file_patch_begins));
   file_patches_.resize(file_patch_ranges.size());
-  auto iter = file_patches_.begin();
-  for (const auto& range : file_patch_ranges) {
-    RETURN_IF_ERROR(iter->Parse(range));
-    ++iter;
+  std::vector<absl::Status> statuses(file_patch_ranges.size());
+  const auto parse_file_patch = [&](size_t i) {
+    statuses[i] = file_patches_[i].Parse(file_patch_ranges[i]);
+  };
+  if (pool != nullptr) {
+    pool->ParallelFor(file_patch_ranges.size(), parse_file_patch);
+  } else {
+    for (size_t i = 0; i < file_patch_ranges.size(); ++i) parse_file_patch(i);
+  }
+  for (const absl::Status& status : statuses) {
+    RETURN_IF_ERROR(status);
   }
 
   // TODO(fangism): pass around line numbers to include in diagnostics
@@ -645,16 +663,26 @@ std::ostream& PatchSet::Render(std::ostream& stream) const {
   return stream;
 }
 
-FileLineNumbersMap PatchSet::AddedLinesMap(bool new_file_ranges) const {
+FileLineNumbersMap PatchSet::AddedLinesMap(bool new_file_ranges,
+                                           ThreadPool* pool) const {
+  std::vector<LineNumberSet> added_lines(file_patches_.size());
+  const auto collect_added_lines = [&](size_t i) {
+    const internal::FilePatch& file_patch = file_patches_[i];
+    if (file_patch.IsDeletedFile()) return;
+    if (file_patch.IsNewFile() && !new_file_ranges) return;
+    added_lines[i] = file_patch.AddedLines();
+  };
+  if (pool != nullptr) {
+    pool->ParallelFor(file_patches_.size(), collect_added_lines);
+  } else {
+    for (size_t i = 0; i < file_patches_.size(); ++i) collect_added_lines(i);
+  }
+
   FileLineNumbersMap result;
-  for (const internal::FilePatch& file_patch : file_patches_) {
+  for (size_t i = 0; i < file_patches_.size(); ++i) {
+    const internal::FilePatch& file_patch = file_patches_[i];
     if (file_patch.IsDeletedFile()) continue;
-    LineNumberSet& entry = result[file_patch.NewFileInfo().path];
-    if (file_patch.IsNewFile() && !new_file_ranges) {
-      entry.clear();
-    } else {
-      entry = file_patch.AddedLines();
-    }
+    result[file_patch.NewFileInfo().path] = std::move(added_lines[i]);
   }
   return result;
 }
@@ -18,6 +18,7 @@
 #include <functional>
 #include <iosfwd>
 #include <map>
+#include <memory>
 #include <string>
 #include <vector>
 
@@ -25,9 +26,11 @@
 #include "absl/status/statusor.h"
 #include "absl/strings/string_view.h"
 #include "common/strings/compare.h"
+#include "common/strings/mem_block.h"
 #include "common/strings/position.h"
 #include "common/util/container_iterator_range.h"
 #include "common/util/logging.h"
+#include "common/util/thread_pool.h"
 
 namespace verible {
 namespace internal {
@@ -47,16 +50,23 @@ using FileLineNumbersMap =
     std::map<std::string, LineNumberSet, StringViewCompare>;
 
 // Collection of file changes.
-// Recursively inside these structs, we chose to copy std::string (owned memory)
-// instead of string_views into file contents memory kept separately.
-// This lets one safely modify patch structures.
+// The lines of hunks refer to the text of the patch, which the PatchSet keeps
+// alive, instead of each being a copy: patches can be hundreds of MB.
+// Paths and metadata are copies.
 class PatchSet {
  public:
   PatchSet() = default;
 
   // Parse a unified-diff patch file into internal representation.
+  // The patch is copied once, into memory of its own.
   absl::Status Parse(absl::string_view patch_contents);
 
+  // Ditto, but without a copy of the patch, e.g. a memory-mapped patch file,
+  // which is kept alive with this PatchSet.  If "pool" is not nullptr, the
+  // files of the patch are parsed in parallel on it.
+  absl::Status Parse(std::shared_ptr<MemBlock> patch_contents,
+                     ThreadPool* pool = nullptr);
+
   // Prints a unified-diff formatted output.
   std::ostream& Render(std::ostream& stream) const;
 
@@ -66,7 +76,10 @@ class PatchSet {
   // while deleted files will not.
   // If `new_file_ranges` is true, provide the full range of lines for new
   // files, otherwise leave their corresponding LineNumberSets empty.
-  FileLineNumbersMap AddedLinesMap(bool new_file_ranges) const;
+  // If "pool" is not nullptr, the lines of the files are collected in
+  // parallel on it.
+  FileLineNumbersMap AddedLinesMap(bool new_file_ranges,
+                                   ThreadPool* pool = nullptr) const;
 
   // Interactively prompt user to select hunks to apply in-place.
   // 'ins' is the stream from which user-input is read,
@@ -80,6 +93,9 @@ class PatchSet {
                          const internal::FileWriterFunction& file_writer) const;
 
  private:
+  // Texts of the patches parsed, which the hunks refer to.
+  std::vector<std::shared_ptr<MemBlock>> contents_;
+
   // Non-patch plain text that could describe the origins of the diff/patch,
   // e.g. from git-format-patch.
   std::vector<std::string> metadata_;
@@ -98,15 +114,16 @@ namespace internal {
 using LineIterator = std::vector<absl::string_view>::const_iterator;
 using LineRange = container_iterator_range<LineIterator>;
 
-// A single line of a patch hunk.
+// A single line of a patch hunk.  Refers to the text it was parsed from,
+// which must outlive it.
 struct MarkedLine {
-  std::string line;
+  absl::string_view line;
 
   MarkedLine() = default;
 
   // only used in manual test case construction
   // so ok to use CHECK here.
-  explicit MarkedLine(absl::string_view text) : line(text.begin(), text.end()) {
+  explicit MarkedLine(absl::string_view text) : line(text) {
     CHECK(!line.empty()) << "MarkedLine must start with a marker in [ -+].";
     CHECK(Valid()) << "Unexpected marker '" << Marker() << "'.";
   }
@@ -126,7 +143,7 @@ struct MarkedLine {
   bool IsAdded() const { return Marker() == '+'; }
   bool IsDeleted() const { return Marker() == '-'; }
 
-  absl::string_view Text() const { return {&line[1], line.length() - 1}; }
+  absl::string_view Text() const { return line.substr(1); }
 
   // default equality operator
   bool operator==(const MarkedLine& other) const { return line == other.line; }
@@ -15,7 +15,10 @@
 #include "common/strings/patch.h"
 
 #include <initializer_list>
+#include <memory>
 #include <sstream>
+#include <string>
+#include <utility>
 #include <vector>
 
 #include "absl/status/status.h"
@@ -24,6 +27,8 @@
 #include "absl/strings/str_cat.h"
 #include "absl/strings/str_join.h"
 #include "absl/strings/string_view.h"
+#include "common/strings/mem_block.h"
+#include "common/util/thread_pool.h"
 #include "gmock/gmock.h"
 #include "gtest/gtest.h"
 
@@ -2197,6 +2202,35 @@ TEST(PatchSetAddedLinesMapTest, NewAndExistingFile) {
   // Neither case should include deleted files like file3.txt
 }
 
+TEST(PatchSetParseTest, MemBlockInParallel) {
+  std::string patch_contents;
+  for (int i = 0; i < 20; ++i) {
+    absl::StrAppend(&patch_contents,                                  //
+                    "--- /path/to/file", i, ".txt\t2020-03-30\n",     //
+                    "+++ /path/to/file", i, ".txt\t2020-03-30\n",     //
+                    "@@ -", i + 1, ",2 +", i + 1, ",3 @@\n",          //
+                    " no change here\n",                              //
+                    "+add me\n",                                      //
+                    " no change here\n");
+  }
+  PatchSet serial;
+  ASSERT_TRUE(serial.Parse(patch_contents).ok());
+
+  ThreadPool pool(4);
+  PatchSet parallel;
+  {
+    // The patch set keeps the contents alive.
+    auto block = std::make_shared<StringMemBlock>(patch_contents);
+    ASSERT_TRUE(parallel.Parse(std::move(block), &pool).ok());
+  }
+  std::ostringstream stream;
+  stream << parallel;
+  EXPECT_EQ(stream.str(), patch_contents);
+  EXPECT_EQ(parallel.AddedLinesMap(false, &pool), serial.AddedLinesMap(false));
+  EXPECT_EQ(serial.AddedLinesMap(false).at("/path/to/file7.txt"),
+            LineNumberSet({{9, 10}}));
+}
+
 class PatchSetPickApplyTest : public PatchSet, public ::testing::Test {};
 
 TEST_F(PatchSetPickApplyTest, EmptyFilePatchHunks) {
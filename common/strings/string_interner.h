@@ -0,0 +1,75 @@
+// Copyright 2017-2023 The Verible Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef VERIBLE_COMMON_STRINGS_STRING_INTERNER_H_
+#define VERIBLE_COMMON_STRINGS_STRING_INTERNER_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <optional>
+#include <string>
+
+#include "absl/container/flat_hash_map.h"
+#include "absl/strings/string_view.h"
+
+namespace verible {
+
+// StringInterner maps strings (e.g. identifiers) to small, dense integer ids,
+// so that maps and sets that would be keyed on strings can be keyed on ids
+// instead: comparing and hashing an id is cheaper than doing so for a string,
+// and each distinct string is stored only once.
+//
+// Ids are assigned in order of first insertion, starting at 0.
+// The texts returned by Text() remain valid for the lifetime of the interner.
+// StringInterner is not thread-safe.
+class StringInterner {
+ public:
+  using Id = uint32_t;
+
+  StringInterner() = default;
+
+  // Owned texts are referenced by the map, so copies would dangle.
+  StringInterner(const StringInterner&) = delete;
+  StringInterner& operator=(const StringInterner&) = delete;
+  StringInterner(StringInterner&&) = default;
+  StringInterner& operator=(StringInterner&&) = default;
+
+  // Returns the id of 'text', assigning a new one if 'text' was not seen
+  // before.
+  Id Intern(absl::string_view text);
+
+  // Returns the id of 'text', or nullopt if 'text' was never interned.
+  std::optional<Id> Find(absl::string_view text) const;
+
+  // Returns the text of a previously returned 'id'.
+  absl::string_view Text(Id id) const { return texts_[id]; }
+
+  // Returns the number of distinct strings interned.
+  size_t size() const { return texts_.size(); }
+
+  bool empty() const { return texts_.empty(); }
+
+ private:
+  // Owned copies of the interned strings, indexed by id.
+  // A deque never relocates its elements, so views into them remain valid.
+  std::deque<std::string> texts_;
+
+  // Views into texts_, mapped to their index.
+  absl::flat_hash_map<absl::string_view, Id> ids_;
+};
+
+}  // namespace verible
+
+#endif  // VERIBLE_COMMON_STRINGS_STRING_INTERNER_H_
@@ -0,0 +1,94 @@
+// Copyright 2017-2023 The Verible Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "common/strings/string_interner.h"
+
+#include <string>
+#include <utility>
+
+#include "absl/strings/str_cat.h"
+#include "gtest/gtest.h"
+
+namespace verible {
+namespace {
+
+TEST(StringInternerTest, Empty) {
+  const StringInterner interner;
+  EXPECT_TRUE(interner.empty());
+  EXPECT_EQ(interner.size(), 0);
+  EXPECT_FALSE(interner.Find("foo").has_value());
+  EXPECT_FALSE(interner.Find("").has_value());
+}
+
+TEST(StringInternerTest, DenseIdsInInsertionOrder) {
+  StringInterner interner;
+  EXPECT_EQ(interner.Intern("foo"), 0);
+  EXPECT_EQ(interner.Intern("bar"), 1);
+  EXPECT_EQ(interner.Intern(""), 2);
+  EXPECT_EQ(interner.size(), 3);
+  EXPECT_EQ(interner.Text(0), "foo");
+  EXPECT_EQ(interner.Text(1), "bar");
+  EXPECT_EQ(interner.Text(2), "");
+}
+
+TEST(StringInternerTest, SameTextSameId) {
+  StringInterner interner;
+  const std::string foo("foo");
+  const StringInterner::Id id = interner.Intern(foo);
+  // A different buffer with the same contents.
+  const std::string foo_again = absl::StrCat("fo", "o");
+  EXPECT_EQ(interner.Intern(foo_again), id);
+  EXPECT_EQ(interner.Find(foo_again), id);
+  EXPECT_EQ(interner.size(), 1);
+}
+
+TEST(StringInternerTest, OwnsTexts) {
+  StringInterner interner;
+  StringInterner::Id id;
+  {
+    std::string temporary("temporary");
+    id = interner.Intern(temporary);
+    temporary.assign("overwritten");
+  }
+  EXPECT_EQ(interner.Text(id), "temporary");
+  EXPECT_EQ(interner.Find("temporary"), id);
+  EXPECT_FALSE(interner.Find("overwritten").has_value());
+}
+
+TEST(StringInternerTest, TextsRemainValidWhileGrowing) {
+  StringInterner interner;
+  const absl::string_view first = interner.Text(interner.Intern("first"));
+  for (int i = 0; i < 10000; ++i) {
+    interner.Intern(absl::StrCat("name_", i));
+  }
+  EXPECT_EQ(interner.size(), 10001);
+  EXPECT_EQ(first, "first");
+  EXPECT_EQ(first.data(), interner.Text(0).data());
+  for (int i = 0; i < 10000; ++i) {
+    const std::string name = absl::StrCat("name_", i);
+    EXPECT_EQ(interner.Find(name), i + 1);
+    EXPECT_EQ(interner.Text(i + 1), name);
+  }
+}
+
+TEST(StringInternerTest, Move) {
+  StringInterner interner;
+  const StringInterner::Id id = interner.Intern("foo");
+  const StringInterner moved(std::move(interner));
+  EXPECT_EQ(moved.Find("foo"), id);
+  EXPECT_EQ(moved.Text(id), "foo");
+}
+
+}  // namespace
+}  // namespace verible
@@ -0,0 +1,106 @@
+// Copyright 2017-2023 The Verible Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "common/text/compact_token_sequence.h"
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <limits>
+
+#include "absl/status/status.h"
+#include "absl/status/statusor.h"
+#include "absl/strings/str_cat.h"
+#include "absl/strings/string_view.h"
+#include "common/text/token_info.h"
+#include "common/text/token_stream_view.h"
+
+namespace verible {
+
+absl::StatusOr<CompactTokenSequence> CompactTokenSequence::Create(
+    absl::string_view text, const TokenSequence& tokens) {
+  if (text.size() >= std::numeric_limits<uint32_t>::max()) {
+    return absl::InvalidArgumentError(
+        absl::StrCat("Text of ", text.size(), " bytes is too large."));
+  }
+  CompactTokenSequence result(text);
+  result.reserve(tokens.size());
+  for (const TokenInfo& token : tokens) {
+    if (!result.push_back(token)) {
+      return absl::InvalidArgumentError(absl::StrCat(
+          "Token ", result.size(), " with enum ", token.token_enum(),
+          " can not be represented compactly."));
+    }
+  }
+  return result;
+}
+
+bool CompactTokenSequence::push_back(const TokenInfo& token) {
+  if (token.token_enum() < 0 ||
+      token.token_enum() > std::numeric_limits<uint16_t>::max()) {
+    return false;
+  }
+  const absl::string_view token_text = token.text();
+  // Compare pointers with std::less, as they may point to different objects.
+  const std::less<const char*> less;
+  if (less(token_text.begin(), text_.begin()) ||
+      less(text_.end(), token_text.end()) ||
+      text_.size() >= std::numeric_limits<uint32_t>::max()) {
+    return false;
+  }
+  enums_.push_back(static_cast<uint16_t>(token.token_enum()));
+  offsets_.push_back(static_cast<uint32_t>(token_text.begin() - text_.begin()));
+  lengths_.push_back(static_cast<uint32_t>(token_text.size()));
+  return true;
+}
+
+void CompactTokenSequence::reserve(size_t n) {
+  enums_.reserve(n);
+  offsets_.reserve(n);
+  lengths_.reserve(n);
+}
+
+size_t CompactTokenSequence::Find(int token_enum, size_t from) const {
+  if (token_enum < 0 || token_enum > std::numeric_limits<uint16_t>::max() ||
+      from >= enums_.size()) {
+    return enums_.size();
+  }
+  return std::find(enums_.begin() + from, enums_.end(),
+                   static_cast<uint16_t>(token_enum)) -
+         enums_.begin();
+}
+
+size_t CompactTokenSequence::Count(int token_enum) const {
+  if (token_enum < 0 || token_enum > std::numeric_limits<uint16_t>::max()) {
+    return 0;
+  }
+  return std::count(enums_.begin(), enums_.end(),
+                    static_cast<uint16_t>(token_enum));
+}
+
+TokenSequence CompactTokenSequence::ToTokenSequence() const {
+  TokenSequence tokens;
+  tokens.reserve(size());
+  for (size_t i = 0; i < size(); ++i) tokens.push_back((*this)[i]);
+  return tokens;
+}
+
+size_t CompactTokenSequence::MemoryBytes() const {
+  return enums_.capacity() * sizeof(uint16_t) +
+         offsets_.capacity() * sizeof(uint32_t) +
+         lengths_.capacity() * sizeof(uint32_t);
+}
+
+}  // namespace verible
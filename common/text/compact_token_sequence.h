@@ -0,0 +1,162 @@
+// Copyright 2017-2023 The Verible Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef VERIBLE_COMMON_TEXT_COMPACT_TOKEN_SEQUENCE_H_
+#define VERIBLE_COMMON_TEXT_COMPACT_TOKEN_SEQUENCE_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <iterator>
+#include <vector>
+
+#include "absl/status/statusor.h"
+#include "absl/strings/string_view.h"
+#include "absl/types/span.h"
+#include "common/text/token_info.h"
+#include "common/text/token_stream_view.h"
+
+namespace verible {
+
+// CompactTokenSequence holds the tokens of a TokenSequence over one text as
+// parallel arrays ("structure of arrays"): a uint16 enum, and a uint32 offset
+// into the text and a uint32 length per token.  That is 10 bytes per token,
+// instead of sizeof(TokenInfo) (24 bytes on 64-bit platforms), and scans
+// over the enums read contiguous memory, which compilers can vectorize.
+//
+// TokenInfos are made on demand, see operator[] and begin()/end().
+// The text must outlive this object.
+class CompactTokenSequence {
+ public:
+  // Iterates over the tokens as TokenInfo values.
+  class const_iterator {
+   public:
+    using iterator_category = std::input_iterator_tag;
+    using value_type = TokenInfo;
+    using difference_type = std::ptrdiff_t;
+    using pointer = void;
+    using reference = TokenInfo;
+
+    const_iterator(const CompactTokenSequence* tokens, size_t index)
+        : tokens_(tokens), index_(index) {}
+
+    TokenInfo operator*() const { return (*tokens_)[index_]; }
+
+    const_iterator& operator++() {
+      ++index_;
+      return *this;
+    }
+    const_iterator operator++(int) {
+      const_iterator copy(*this);
+      ++index_;
+      return copy;
+    }
+
+    bool operator==(const const_iterator& other) const {
+      return index_ == other.index_;
+    }
+    bool operator!=(const const_iterator& other) const {
+      return index_ != other.index_;
+    }
+
+    // Index of the token in the sequence.
+    size_t index() const { return index_; }
+
+   private:
+    const CompactTokenSequence* tokens_;
+    size_t index_;
+  };
+
+  // Empty sequence over an empty text.
+  CompactTokenSequence() = default;
+
+  explicit CompactTokenSequence(absl::string_view text) : text_(text) {}
+
+  // Returns the compact form of 'tokens', which must all be part of 'text'
+  // (including EOF tokens, see TokenInfo::EOFToken(absl::string_view)).
+  // Fails if a token is not, if a token enum is outside of [0, 0xffff], or
+  // if the text is 4GB or larger.
+  static absl::StatusOr<CompactTokenSequence> Create(
+      absl::string_view text, const TokenSequence& tokens);
+
+  // Appends 'token', and returns true, if it can be represented, as in
+  // Create(); otherwise returns false, and leaves this sequence unchanged.
+  bool push_back(const TokenInfo& token);
+
+  absl::string_view Text() const { return text_; }
+
+  size_t size() const { return enums_.size(); }
+  bool empty() const { return enums_.empty(); }
+
+  void reserve(size_t n);
+
+  // Returns the 'index'th token.
+  TokenInfo operator[](size_t index) const {
+    return TokenInfo(enums_[index], TokenText(index));
+  }
+
+  int TokenEnum(size_t index) const { return enums_[index]; }
+  absl::string_view TokenText(size_t index) const {
+    return text_.substr(offsets_[index], lengths_[index]);
+  }
+
+  const_iterator begin() const { return const_iterator(this, 0); }
+  const_iterator end() const { return const_iterator(this, size()); }
+
+  // The parallel arrays.
+  absl::Span<const uint16_t> Enums() const { return enums_; }
+  absl::Span<const uint32_t> Offsets() const { return offsets_; }
+  absl::Span<const uint32_t> Lengths() const { return lengths_; }
+
+  // Returns the index of the first token at or after 'from' with enum
+  // 'token_enum', or size() if there is none.
+  size_t Find(int token_enum, size_t from = 0) const;
+
+  // Returns the number of tokens with enum 'token_enum'.
+  size_t Count(int token_enum) const;
+
+  // Returns the indices of the tokens whose enum 'keep' returns true for,
+  // e.g. to filter out comments and whitespace like InitTokenStreamView()
+  // does for a TokenSequence.  'keep' is called once per distinct enum.
+  template <typename Predicate>
+  std::vector<uint32_t> IndicesIf(Predicate&& keep) const;
+
+  // Returns the tokens as a TokenSequence.
+  TokenSequence ToTokenSequence() const;
+
+  // Returns the number of bytes held by the arrays.
+  size_t MemoryBytes() const;
+
+ private:
+  absl::string_view text_;
+  std::vector<uint16_t> enums_;
+  std::vector<uint32_t> offsets_;
+  std::vector<uint32_t> lengths_;
+};
+
+template <typename Predicate>
+std::vector<uint32_t> CompactTokenSequence::IndicesIf(Predicate&& keep) const {
+  // Evaluate 'keep' once per enum that occurs, then scan the enums only.
+  std::vector<int8_t> kept(1 << 16, -1);
+  std::vector<uint32_t> indices;
+  for (size_t i = 0; i < enums_.size(); ++i) {
+    int8_t& k = kept[enums_[i]];
+    if (k < 0) k = keep(static_cast<int>(enums_[i])) ? 1 : 0;
+    if (k) indices.push_back(static_cast<uint32_t>(i));
+  }
+  return indices;
+}
+
+}  // namespace verible
+
+#endif  // VERIBLE_COMMON_TEXT_COMPACT_TOKEN_SEQUENCE_H_
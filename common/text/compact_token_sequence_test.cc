@@ -0,0 +1,121 @@
+// Copyright 2017-2023 The Verible Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "common/text/compact_token_sequence.h"
+
+#include <cstdint>
+#include <vector>
+
+#include "absl/strings/string_view.h"
+#include "common/text/constants.h"
+#include "common/text/token_info.h"
+#include "common/text/token_stream_view.h"
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+
+namespace verible {
+namespace {
+
+using ::testing::ElementsAre;
+
+constexpr absl::string_view kText("module m; // c\nendmodule");
+
+TokenSequence TextTokens() {
+  return {
+      TokenInfo(1, kText.substr(0, 6)),    // module
+      TokenInfo(2, kText.substr(6, 1)),    // ' '
+      TokenInfo(3, kText.substr(7, 1)),    // m
+      TokenInfo(';', kText.substr(8, 1)),  // ;
+      TokenInfo(2, kText.substr(9, 1)),    // ' '
+      TokenInfo(4, kText.substr(10, 4)),   // // c
+      TokenInfo(5, kText.substr(14, 1)),   // \n
+      TokenInfo(6, kText.substr(15)),      // endmodule
+      TokenInfo::EOFToken(kText),
+  };
+}
+
+TEST(CompactTokenSequenceTest, Empty) {
+  const CompactTokenSequence tokens;
+  EXPECT_TRUE(tokens.empty());
+  EXPECT_EQ(tokens.size(), 0);
+  EXPECT_EQ(tokens.begin(), tokens.end());
+  EXPECT_TRUE(tokens.ToTokenSequence().empty());
+}
+
+TEST(CompactTokenSequenceTest, RoundTrip) {
+  const TokenSequence expected = TextTokens();
+  const auto tokens = CompactTokenSequence::Create(kText, expected);
+  ASSERT_TRUE(tokens.ok()) << tokens.status();
+  EXPECT_EQ(tokens->Text(), kText);
+  ASSERT_EQ(tokens->size(), expected.size());
+  for (size_t i = 0; i < expected.size(); ++i) {
+    EXPECT_EQ((*tokens)[i], expected[i]) << i;
+    // The same range of the text, not a copy.
+    EXPECT_EQ((*tokens)[i].text().data(), expected[i].text().data()) << i;
+  }
+  EXPECT_EQ(tokens->ToTokenSequence(), expected);
+  EXPECT_EQ(TokenSequence(tokens->begin(), tokens->end()), expected);
+  EXPECT_TRUE((*tokens)[tokens->size() - 1].isEOF());
+}
+
+TEST(CompactTokenSequenceTest, Arrays) {
+  const auto tokens = CompactTokenSequence::Create(kText, TextTokens());
+  ASSERT_TRUE(tokens.ok()) << tokens.status();
+  EXPECT_THAT(tokens->Enums(), ElementsAre(1, 2, 3, ';', 2, 4, 5, 6, TK_EOF));
+  EXPECT_THAT(tokens->Offsets(), ElementsAre(0, 6, 7, 8, 9, 10, 14, 15, 24));
+  EXPECT_THAT(tokens->Lengths(), ElementsAre(6, 1, 1, 1, 1, 4, 1, 9, 0));
+  EXPECT_LT(tokens->MemoryBytes(), TextTokens().size() * sizeof(TokenInfo));
+}
+
+TEST(CompactTokenSequenceTest, Scans) {
+  const auto tokens = CompactTokenSequence::Create(kText, TextTokens());
+  ASSERT_TRUE(tokens.ok()) << tokens.status();
+  EXPECT_EQ(tokens->Find(2), 1);
+  EXPECT_EQ(tokens->Find(2, 2), 4);
+  EXPECT_EQ(tokens->Find(2, 5), tokens->size());
+  EXPECT_EQ(tokens->Find(-1), tokens->size());
+  EXPECT_EQ(tokens->Find(1 << 16), tokens->size());
+  EXPECT_EQ(tokens->Count(2), 2);
+  EXPECT_EQ(tokens->Count(7), 0);
+  EXPECT_EQ(tokens->Count(-1), 0);
+
+  int calls = 0;
+  const std::vector<uint32_t> kept = tokens->IndicesIf([&calls](int e) {
+    ++calls;
+    return e != 2 && e != 4 && e != 5;
+  });
+  EXPECT_THAT(kept, ElementsAre(0, 2, 3, 7, 8));
+  EXPECT_EQ(calls, 8);  // once per distinct enum
+}
+
+TEST(CompactTokenSequenceTest, Unrepresentable) {
+  constexpr absl::string_view kOther("other");
+  EXPECT_FALSE(
+      CompactTokenSequence::Create(kText, {TokenInfo(1, kOther)}).ok());
+  EXPECT_FALSE(CompactTokenSequence::Create(
+                   kText, {TokenInfo(1 << 16, kText.substr(0, 1))})
+                   .ok());
+  EXPECT_FALSE(
+      CompactTokenSequence::Create(kText, {TokenInfo(-1, kText.substr(0, 1))})
+          .ok());
+
+  CompactTokenSequence tokens(kText);
+  EXPECT_TRUE(tokens.push_back(TokenInfo(1, kText.substr(0, 6))));
+  EXPECT_FALSE(tokens.push_back(TokenInfo(1, kOther)));
+  EXPECT_EQ(tokens.size(), 1);
+  EXPECT_THAT(tokens.Offsets(), ElementsAre(0));
+}
+
+}  // namespace
+}  // namespace verible
@@ -18,30 +18,38 @@
 #ifndef VERIBLE_COMMON_TEXT_CONCRETE_SYNTAX_LEAF_H_
 #define VERIBLE_COMMON_TEXT_CONCRETE_SYNTAX_LEAF_H_
 
+#include <cstddef>
 #include <iosfwd>
 #include <utility>
 
 #include "common/text/symbol.h"
+#include "common/text/syntax_tree_arena.h"
 #include "common/text/token_info.h"
 #include "common/text/tree_compare.h"
 #include "common/text/visitors.h"
 
 namespace verible {
 
-class SyntaxTreeLeaf final : public Symbol {
+// SyntaxTreeLeaf is the interface of all leaves: it gives access to one token.
+// Leaves either hold a copy of their token (OwnedTokenLeaf), or refer to a
+// token that is stored elsewhere, usually in a TokenSequence
+// (TokenReferenceLeaf), which makes them half the size.
+class SyntaxTreeLeaf : public Symbol {
  public:
-  SyntaxTreeLeaf() = delete;
+  // Leaves are allocated from the active SyntaxTreeArena, if any.
+  static void* operator new(size_t size) {
+    return SyntaxTreeArena::Allocate(size);
+  }
+  static void operator delete(void* storage) {
+    SyntaxTreeArena::Deallocate(storage);
+  }
 
-  explicit SyntaxTreeLeaf(const TokenInfo& token) : token_(token) {}
+  virtual const TokenInfo& get() const = 0;
 
-  // All passed arguments will be forwarded to T's constructor
-  template <typename... Args>
-  explicit SyntaxTreeLeaf(Args&&... args)
-      : token_(std::forward<Args>(args)...) {}
+  virtual TokenInfo* get_mutable() = 0;
 
-  const TokenInfo& get() const { return token_; }
-
-  TokenInfo* get_mutable() { return &token_; }
+  // Returns true if the token is not held by this leaf.
+  virtual bool IsTokenReference() const = 0;
 
   // Compares this to an arbitrary symbol using compare_tokens
   bool equals(const Symbol* symbol,
@@ -62,10 +70,49 @@ class SyntaxTreeLeaf final : public Symbol {
   SymbolKind Kind() const final { return SymbolKind::kLeaf; }
   SymbolTag Tag() const final { return LeafTag(get().token_enum()); }
 
+ protected:
+  SyntaxTreeLeaf() = default;
+};
+
+// OwnedTokenLeaf holds its own copy of a token.
+class OwnedTokenLeaf final : public SyntaxTreeLeaf {
+ public:
+  OwnedTokenLeaf() = delete;
+
+  explicit OwnedTokenLeaf(const TokenInfo& token) : token_(token) {}
+
+  // All passed arguments will be forwarded to T's constructor
+  template <typename... Args>
+  explicit OwnedTokenLeaf(Args&&... args)
+      : token_(std::forward<Args>(args)...) {}
+
+  const TokenInfo& get() const final { return token_; }
+
+  TokenInfo* get_mutable() final { return &token_; }
+
+  bool IsTokenReference() const final { return false; }
+
  private:
   TokenInfo token_;
 };
 
+// TokenReferenceLeaf refers to a token that must outlive it, and whose
+// address must remain stable, e.g. an element of a TokenSequence that is no
+// longer resized.  Changes to that token are visible through this leaf.
+class TokenReferenceLeaf final : public SyntaxTreeLeaf {
+ public:
+  explicit TokenReferenceLeaf(TokenInfo* token) : token_(token) {}
+
+  const TokenInfo& get() const final { return *token_; }
+
+  TokenInfo* get_mutable() final { return token_; }
+
+  bool IsTokenReference() const final { return true; }
+
+ private:
+  TokenInfo* const token_;
+};
+
 std::ostream& operator<<(std::ostream& os, const SyntaxTreeLeaf& l);
 
 }  // namespace verible
@@ -25,7 +25,7 @@ namespace {
 
 TEST(ValueSymbolTest, EqualityArity1Args) {
   constexpr absl::string_view text("foo");
-  SyntaxTreeLeaf value1(10, text);
+  OwnedTokenLeaf value1(10, text);
   TokenInfo info1(10, text);
   auto info2 = value1.get();
   EXPECT_EQ(info1, info2);
@@ -38,10 +38,20 @@ TEST(ValueSymbolTest, InequalityDifferentStringLocations) {
   constexpr absl::string_view first = longtext.substr(0, 3);
   constexpr absl::string_view second = longtext.substr(3);
 
-  SyntaxTreeLeaf value1(10, first);
+  OwnedTokenLeaf value1(10, first);
   TokenInfo info1(10, second);
   auto info2 = value1.get();
   EXPECT_NE(info1, info2);
 }
+
+TEST(ValueSymbolTest, TokenReference) {
+  TokenInfo token(10, "foo");
+  TokenReferenceLeaf leaf(&token);
+  EXPECT_TRUE(leaf.IsTokenReference());
+  EXPECT_EQ(&leaf.get(), &token);
+  token.set_token_enum(11);
+  EXPECT_EQ(leaf.Tag(), LeafTag(11));
+}
+
 }  // namespace
 }  // namespace verible
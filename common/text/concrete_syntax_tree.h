@@ -44,6 +44,7 @@
 
 #include "common/text/constants.h"
 #include "common/text/symbol.h"
+#include "common/text/syntax_tree_arena.h"
 #include "common/text/tree_compare.h"
 #include "common/text/visitors.h"
 #include "common/util/casts.h"
@@ -72,6 +73,14 @@ class SyntaxTreeNode final : public Symbol {
  public:
   explicit SyntaxTreeNode(const int tag = kUntagged) : tag_(tag) {}
 
+  // Nodes are allocated from the active SyntaxTreeArena, if any.
+  static void* operator new(size_t size) {
+    return SyntaxTreeArena::Allocate(size);
+  }
+  static void operator delete(void* storage) {
+    SyntaxTreeArena::Deallocate(storage);
+  }
+
   const std::vector<SymbolPtr>& children() const { return children_; }
   std::vector<SymbolPtr>& mutable_children() { return children_; }
 
@@ -98,6 +107,13 @@ class SyntaxTreeNode final : public Symbol {
     node->children_.clear();
   }
 
+  // Reserves room for the children that Append(args...) would add, so that
+  // nodes made with all their children at once have them allocated once.
+  template <typename... Args>
+  void ReserveChildren(const Args&... args) {
+    children_.reserve(children_.size() + (ChildCount(args) + ... + 0));
+  }
+
   // This no-op case is the base case for the variadic Append.
   void Append() const {}
 
@@ -177,6 +193,18 @@ class SyntaxTreeNode final : public Symbol {
   // Decision: Keep this a generic int.
   int tag_;
 
+  // Number of children that appending "child" adds.
+  template <typename T>
+  static size_t ChildCount(const T&) {
+    return 1;
+  }
+  static size_t ChildCount(const ForwardChildren& forwarded_children) {
+    const Symbol* node = forwarded_children.node.get();
+    if (node == nullptr) return 0;
+    if (node->Kind() != SymbolKind::kNode) return 1;
+    return down_cast<const SyntaxTreeNode*>(node)->children_.size();
+  }
+
   // Sequence of pointers to subtrees and nodes.
   std::vector<SymbolPtr> children_;
 };
@@ -190,6 +218,7 @@ class SyntaxTreeNode final : public Symbol {
 template <typename... Args>
 SymbolPtr MakeNode(Args&&... args) {
   auto* const node_pointer = new SyntaxTreeNode();
+  node_pointer->ReserveChildren(args...);
   node_pointer->Append(std::forward<Args>(args)...);
   return SymbolPtr(node_pointer);
 }
@@ -202,11 +231,15 @@ SymbolPtr MakeNode(Args&&... args) {
 template <typename Enum, typename... Args>
 SymbolPtr MakeTaggedNode(const Enum tag, Args&&... args) {
   auto* const node_pointer = new SyntaxTreeNode(static_cast<int>(tag));
+  node_pointer->ReserveChildren(args...);
   node_pointer->Append(std::forward<Args>(args)...);
   return SymbolPtr(node_pointer);
 }
 
 // Extend the children of an existing node.
+// Unlike the functions above, this does not reserve room for exactly the new
+// children: lists are extended one element at a time, and would then be
+// reallocated every time.
 // Equivalent to: $$ = std::move(ExtendNode($1, $2, $3));
 // Ownership of all args is transferred, and consumed by the existing node.
 // $1 is transferred to $$.
@@ -171,6 +171,18 @@ TEST(MakeNodeTest, MultiChild) {
   EXPECT_THAT(CheckTree(parent)->children(), SizeIs(3));
 }
 
+// Test that nodes are allocated room for exactly their children.
+TEST(MakeNodeTest, ExactChildrenCapacity) {
+  auto seq = MakeNode(MakeNode(), MakeNode(), MakeNode());
+  EXPECT_EQ(CheckTree(seq)->children().capacity(), 3);
+  auto leaf = XLeaf(1);
+  auto empty = MakeNode();
+  auto parent = MakeTaggedNode(1, MakeNode(), ForwardChildren(seq), nullptr,
+                               ForwardChildren(leaf), ForwardChildren(empty));
+  EXPECT_THAT(CheckTree(parent)->children(), SizeIs(6));
+  EXPECT_EQ(CheckTree(parent)->children().capacity(), 6);
+}
+
 // Test ExtendNode with nothing to extend (base case).
 TEST(ExtendNodeTest, ExtendNone) {
   auto seq = MakeNode();
@@ -247,7 +259,7 @@ TEST(SyntaxTreeNodeAppend, AdoptChildrenNone) {
 
 // Test forwarding empty set of children to new node.
 TEST(SyntaxTreeNodeAppend, AdoptLeaf) {
-  SymbolPtr leaf(new SyntaxTreeLeaf(0, "abc"));
+  SymbolPtr leaf(new OwnedTokenLeaf(0, "abc"));
   auto parent = MakeNode(ForwardChildren(leaf));
   EXPECT_THAT(leaf, IsNull());
   EXPECT_THAT(CheckTree(parent)->children(), SizeIs(1));
@@ -0,0 +1,81 @@
+// Copyright 2017-2023 The Verible Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "common/text/flat_syntax_tree.h"
+
+#include <algorithm>
+#include <cstddef>
+#include <vector>
+
+#include "absl/strings/string_view.h"
+#include "common/strings/range.h"
+#include "common/text/concrete_syntax_leaf.h"
+#include "common/text/concrete_syntax_tree.h"
+#include "common/text/symbol.h"
+#include "common/text/syntax_tree_context.h"
+#include "common/util/casts.h"
+
+namespace verible {
+
+FlatSyntaxTree::FlatSyntaxTree(const Symbol& root) { Append(root, -1, 0); }
+
+void FlatSyntaxTree::Append(const Symbol& symbol, int parent, size_t depth) {
+  max_depth_ = std::max(max_depth_, depth);
+  const int index = static_cast<int>(entries_.size());
+  const int first_leaf = static_cast<int>(leaves_.size());
+  entries_.push_back(Entry{&symbol, symbol.Tag(), parent, 1, first_leaf,
+                           first_leaf});
+  if (symbol.Kind() == SymbolKind::kLeaf) {
+    leaves_.push_back(down_cast<const SyntaxTreeLeaf*>(&symbol));
+  } else {
+    const auto& node = down_cast<const SyntaxTreeNode&>(symbol);
+    for (const auto& child : node.children()) {
+      if (child) Append(*child, index, depth + 1);
+    }
+  }
+  // entries_ may have been reallocated.
+  Entry& entry = entries_[index];
+  entry.subtree_size = static_cast<int>(entries_.size()) - index;
+  entry.end_leaf = static_cast<int>(leaves_.size());
+}
+
+absl::string_view FlatSyntaxTree::StringSpan(size_t index) const {
+  const Entry& entry = entries_[index];
+  if (entry.first_leaf == entry.end_leaf) return "";
+  const absl::string_view first = leaves_[entry.first_leaf]->get().text();
+  const absl::string_view last = leaves_[entry.end_leaf - 1]->get().text();
+  return make_string_view_range(first.begin(), last.end());
+}
+
+SyntaxTreeContext FlatSyntaxTree::ContextOf(size_t index) const {
+  return ContextOf(index, 0);
+}
+
+SyntaxTreeContext FlatSyntaxTree::ContextOf(size_t index,
+                                            size_t ancestor) const {
+  std::vector<const SyntaxTreeNode*> ancestors;
+  for (size_t entry = index; entry != ancestor;) {
+    entry = entries_[entry].parent;
+    ancestors.push_back(
+        down_cast<const SyntaxTreeNode*>(entries_[entry].symbol));
+  }
+  FlatContext context;
+  context.reserve(ancestors.size());
+  for (auto iter = ancestors.rbegin(); iter != ancestors.rend(); ++iter) {
+    context.Push(*iter);
+  }
+  return context;
+}
+
+}  // namespace verible
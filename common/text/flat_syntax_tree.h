@@ -0,0 +1,140 @@
+// Copyright 2017-2023 The Verible Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef VERIBLE_COMMON_TEXT_FLAT_SYNTAX_TREE_H_
+#define VERIBLE_COMMON_TEXT_FLAT_SYNTAX_TREE_H_
+
+#include <cstddef>
+#include <vector>
+
+#include "absl/strings/string_view.h"
+#include "common/text/concrete_syntax_leaf.h"
+#include "common/text/concrete_syntax_tree.h"
+#include "common/text/symbol.h"
+#include "common/text/syntax_tree_context.h"
+#include "common/util/casts.h"
+
+namespace verible {
+
+// FlatSyntaxTree is a read-only view of a syntax tree as an array of its
+// symbols in preorder, i.e. the order in which visitors encounter them.
+// Every subtree is a contiguous range of the array, so that traversals and
+// searches run linearly over memory, without virtual dispatch and recursion.
+// Null children are omitted.
+//
+// The viewed tree must outlive this object, and must not be modified.
+class FlatSyntaxTree {
+ public:
+  struct Entry {
+    const Symbol* symbol;
+    SymbolTag tag;
+
+    // Index of the parent node's entry, or -1 for the root.
+    int parent;
+
+    // Number of entries of the subtree rooted at this one, including itself.
+    // The entries of the subtree are [index, index + subtree_size).
+    int subtree_size;
+
+    // Range of the subtree's leaves (tokens): [first_leaf, end_leaf) of
+    // Leaves().
+    int first_leaf;
+    int end_leaf;
+  };
+
+  explicit FlatSyntaxTree(const Symbol& root);
+
+  const std::vector<Entry>& Entries() const { return entries_; }
+
+  // Largest number of ancestors of any symbol, i.e. the size of the deepest
+  // context.
+  size_t MaxDepth() const { return max_depth_; }
+
+  // All leaves of the tree, in order.
+  const std::vector<const SyntaxTreeLeaf*>& Leaves() const { return leaves_; }
+
+  // Returns the range of text spanned by the leaves of entry 'index', like
+  // StringSpanOfSymbol().
+  absl::string_view StringSpan(size_t index) const;
+
+  // Calls 'visitor' with every symbol in preorder, along with the context of
+  // its ancestors, like a TreeContextVisitor does.
+  // 'visitor' is called as visitor(const Symbol&, const SyntaxTreeContext&).
+  template <typename Visitor>
+  void ForEachSymbol(Visitor&& visitor) const;
+
+  // Like ForEachSymbol(), but skips the subtrees of the entries for which
+  // visit_subtree(index) returns false.
+  template <typename Filter, typename Visitor>
+  void ForEachSymbolIf(Filter&& visit_subtree, Visitor&& visitor) const;
+
+  // Returns the context of ancestors of entry 'index'.
+  SyntaxTreeContext ContextOf(size_t index) const;
+
+  // Returns the context of ancestors of entry 'index' within the subtree of
+  // entry 'ancestor', as seen by a visitor that starts at 'ancestor'.
+  // 'index' must be in the subtree of 'ancestor'.
+  SyntaxTreeContext ContextOf(size_t index, size_t ancestor) const;
+
+ private:
+  // SyntaxTreeContext that can be modified without AutoPop scopes.
+  class FlatContext : public SyntaxTreeContext {
+   public:
+    using SyntaxTreeContext::Pop;
+    using SyntaxTreeContext::Push;
+  };
+
+  void Append(const Symbol& symbol, int parent, size_t depth);
+
+  std::vector<Entry> entries_;
+  std::vector<const SyntaxTreeLeaf*> leaves_;
+  size_t max_depth_ = 0;
+};
+
+template <typename Visitor>
+void FlatSyntaxTree::ForEachSymbol(Visitor&& visitor) const {
+  ForEachSymbolIf([](size_t) { return true; }, visitor);
+}
+
+template <typename Filter, typename Visitor>
+void FlatSyntaxTree::ForEachSymbolIf(Filter&& visit_subtree,
+                                     Visitor&& visitor) const {
+  // Sized for the deepest context, so that the walk doesn't allocate.
+  FlatContext context;
+  context.reserve(max_depth_);
+  // Indices of the entries of the nodes in context.
+  std::vector<int> context_indices;
+  context_indices.reserve(max_depth_);
+  for (size_t i = 0; i < entries_.size();) {
+    const Entry& entry = entries_[i];
+    while (!context_indices.empty() && context_indices.back() != entry.parent) {
+      context.Pop();
+      context_indices.pop_back();
+    }
+    if (!visit_subtree(i)) {
+      i += entry.subtree_size;
+      continue;
+    }
+    visitor(*entry.symbol, static_cast<const SyntaxTreeContext&>(context));
+    if (entry.tag.kind == SymbolKind::kNode) {
+      context.Push(down_cast<const SyntaxTreeNode*>(entry.symbol));
+      context_indices.push_back(static_cast<int>(i));
+    }
+    ++i;
+  }
+}
+
+}  // namespace verible
+
+#endif  // VERIBLE_COMMON_TEXT_FLAT_SYNTAX_TREE_H_
@@ -0,0 +1,199 @@
+// Copyright 2017-2023 The Verible Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "common/text/flat_syntax_tree.h"
+
+#include <iterator>
+#include <utility>
+#include <vector>
+
+#include "absl/strings/string_view.h"
+#include "common/text/concrete_syntax_leaf.h"
+#include "common/text/concrete_syntax_tree.h"
+#include "common/text/symbol.h"
+#include "common/text/syntax_tree_context.h"
+#include "common/text/tree_builder_test_util.h"
+#include "common/text/tree_context_visitor.h"
+#include "common/text/tree_utils.h"
+#include "gtest/gtest.h"
+
+namespace verible {
+namespace {
+
+using Visited = std::vector<std::pair<const Symbol*, SyntaxTreeContext>>;
+
+// Records the symbols in the order of visitation, with their contexts.
+class RecordingVisitor : public TreeContextVisitor {
+ public:
+  void Visit(const SyntaxTreeLeaf& leaf) final {
+    visited_.emplace_back(&leaf, Context());
+  }
+  void Visit(const SyntaxTreeNode& node) final {
+    visited_.emplace_back(&node, Context());
+    TreeContextVisitor::Visit(node);
+  }
+
+  const Visited& visited() const { return visited_; }
+
+ private:
+  Visited visited_;
+};
+
+void ExpectSameContext(const SyntaxTreeContext& left,
+                       const SyntaxTreeContext& right) {
+  ASSERT_EQ(left.size(), right.size());
+  for (auto l = left.begin(), r = right.begin(); l != left.end(); ++l, ++r) {
+    EXPECT_EQ(*l, *r);
+  }
+}
+
+constexpr absl::string_view kText("abcdef");
+
+SymbolPtr MakeTestTree() {
+  return TNode(1, Leaf(10, kText.substr(0, 1)),
+               TNode(2, nullptr, TNode(3), Leaf(11, kText.substr(1, 2))),
+               TNode(4, TNode(5, Leaf(12, kText.substr(3, 1))), nullptr),
+               Leaf(13, kText.substr(5, 1)));
+}
+
+TEST(FlatSyntaxTreeTest, Leaf) {
+  const SymbolPtr tree = Leaf(10, kText);
+  const FlatSyntaxTree flat(*tree);
+  ASSERT_EQ(flat.Entries().size(), 1);
+  const auto& entry = flat.Entries()[0];
+  EXPECT_EQ(entry.symbol, tree.get());
+  EXPECT_EQ(entry.tag, LeafTag(10));
+  EXPECT_EQ(entry.parent, -1);
+  EXPECT_EQ(entry.subtree_size, 1);
+  EXPECT_EQ(entry.first_leaf, 0);
+  EXPECT_EQ(entry.end_leaf, 1);
+  ASSERT_EQ(flat.Leaves().size(), 1);
+  EXPECT_EQ(flat.Leaves()[0], tree.get());
+  EXPECT_EQ(flat.StringSpan(0), kText);
+}
+
+TEST(FlatSyntaxTreeTest, Entries) {
+  const SymbolPtr tree = MakeTestTree();
+  const FlatSyntaxTree flat(*tree);
+  const auto& entries = flat.Entries();
+  ASSERT_EQ(entries.size(), 9);
+  const struct {
+    SymbolTag tag;
+    int parent;
+    int subtree_size;
+    int first_leaf;
+    int end_leaf;
+  } kExpected[] = {
+      {NodeTag(1), -1, 9, 0, 4},  //
+      {LeafTag(10), 0, 1, 0, 1},  //
+      {NodeTag(2), 0, 3, 1, 2},   //
+      {NodeTag(3), 2, 1, 1, 1},   //
+      {LeafTag(11), 2, 1, 1, 2},  //
+      {NodeTag(4), 0, 3, 2, 3},   //
+      {NodeTag(5), 5, 2, 2, 3},   //
+      {LeafTag(12), 6, 1, 2, 3},  //
+      {LeafTag(13), 0, 1, 3, 4},  //
+  };
+  for (size_t i = 0; i < entries.size(); ++i) {
+    EXPECT_EQ(entries[i].tag, kExpected[i].tag) << i;
+    EXPECT_EQ(entries[i].symbol->Tag(), kExpected[i].tag) << i;
+    EXPECT_EQ(entries[i].parent, kExpected[i].parent) << i;
+    EXPECT_EQ(entries[i].subtree_size, kExpected[i].subtree_size) << i;
+    EXPECT_EQ(entries[i].first_leaf, kExpected[i].first_leaf) << i;
+    EXPECT_EQ(entries[i].end_leaf, kExpected[i].end_leaf) << i;
+  }
+  EXPECT_EQ(flat.Leaves()[1], DescendPath(*tree, {1, 2}));
+}
+
+TEST(FlatSyntaxTreeTest, MaxDepth) {
+  EXPECT_EQ(FlatSyntaxTree(*Leaf(10, kText)).MaxDepth(), 0);
+  // The deepest symbol is the leaf below TNode(1), TNode(4), TNode(5).
+  EXPECT_EQ(FlatSyntaxTree(*MakeTestTree()).MaxDepth(), 3);
+}
+
+TEST(FlatSyntaxTreeTest, StringSpan) {
+  const SymbolPtr tree = MakeTestTree();
+  const FlatSyntaxTree flat(*tree);
+  for (size_t i = 0; i < flat.Entries().size(); ++i) {
+    const absl::string_view expected =
+        StringSpanOfSymbol(*flat.Entries()[i].symbol);
+    const absl::string_view span = flat.StringSpan(i);
+    EXPECT_EQ(span, expected) << i;
+    if (!expected.empty()) EXPECT_EQ(span.data(), expected.data()) << i;
+  }
+}
+
+TEST(FlatSyntaxTreeTest, SameOrderAndContextAsTreeContextVisitor) {
+  const SymbolPtr tree = MakeTestTree();
+  RecordingVisitor visitor;
+  tree->Accept(&visitor);
+
+  const FlatSyntaxTree flat(*tree);
+  Visited visited;
+  flat.ForEachSymbol(
+      [&visited](const Symbol& symbol, const SyntaxTreeContext& context) {
+        visited.emplace_back(&symbol, context);
+      });
+
+  ASSERT_EQ(visited.size(), visitor.visited().size());
+  for (size_t i = 0; i < visited.size(); ++i) {
+    EXPECT_EQ(visited[i].first, visitor.visited()[i].first) << i;
+    ExpectSameContext(visited[i].second, visitor.visited()[i].second);
+    ExpectSameContext(flat.ContextOf(i), visitor.visited()[i].second);
+  }
+}
+
+TEST(FlatSyntaxTreeTest, ForEachSymbolIfSkipsSubtrees) {
+  const SymbolPtr tree = MakeTestTree();
+  const FlatSyntaxTree flat(*tree);
+  std::vector<size_t> filtered;
+  Visited visited;
+  flat.ForEachSymbolIf(
+      [&](size_t index) {
+        filtered.push_back(index);
+        return flat.Entries()[index].tag != NodeTag(2);
+      },
+      [&visited](const Symbol& symbol, const SyntaxTreeContext& context) {
+        visited.emplace_back(&symbol, context);
+      });
+
+  // Node 2 is skipped with its children, node 3 and leaf 11, which are not
+  // even filtered.
+  EXPECT_EQ(filtered, (std::vector<size_t>{0, 1, 2, 5, 6, 7, 8}));
+  const size_t kVisited[] = {0, 1, 5, 6, 7, 8};
+  ASSERT_EQ(visited.size(), std::size(kVisited));
+  for (size_t i = 0; i < visited.size(); ++i) {
+    EXPECT_EQ(visited[i].first, flat.Entries()[kVisited[i]].symbol) << i;
+    ExpectSameContext(visited[i].second, flat.ContextOf(kVisited[i]));
+  }
+}
+
+TEST(FlatSyntaxTreeTest, ContextWithinSubtree) {
+  const SymbolPtr tree = MakeTestTree();
+  const FlatSyntaxTree flat(*tree);
+  for (size_t root = 0; root < flat.Entries().size(); ++root) {
+    RecordingVisitor visitor;
+    flat.Entries()[root].symbol->Accept(&visitor);
+    ASSERT_EQ(visitor.visited().size(),
+              static_cast<size_t>(flat.Entries()[root].subtree_size));
+    for (size_t i = 0; i < visitor.visited().size(); ++i) {
+      EXPECT_EQ(flat.Entries()[root + i].symbol, visitor.visited()[i].first);
+      ExpectSameContext(flat.ContextOf(root + i, root),
+                        visitor.visited()[i].second);
+    }
+  }
+}
+
+}  // namespace
+}  // namespace verible
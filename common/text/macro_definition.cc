@@ -40,6 +40,11 @@ bool MacroDefinition::AppendParameter(const MacroParameterInfo& param_info) {
   return inserted;
 }
 
+int MacroDefinition::ParameterPosition(absl::string_view name) const {
+  const auto found = parameter_positions_.find(name);
+  return found == parameter_positions_.end() ? -1 : found->second;
+}
+
 absl::Status MacroDefinition::PopulateSubstitutionMap(
     const std::vector<TokenInfo>& macro_call_args,
     substitution_map_type* arg_map) const {
@@ -94,6 +99,34 @@ absl::Status MacroDefinition::PopulateSubstitutionMap(
   return absl::OkStatus();
 }
 
+absl::Status MacroDefinition::PopulateSubstitutionArray(
+    const std::vector<DefaultTokenInfo>& macro_call_args,
+    substitution_array_type* arg_array) const {
+  if (macro_call_args.size() != parameter_info_array_.size()) {
+    return absl::InvalidArgumentError(
+        absl::StrCat("Error calling macro ", name_.text(), " with ",
+                     macro_call_args.size(), " arguments, but definition has ",
+                     parameter_info_array_.size(), " formal parameters."));
+  }
+  arg_array->assign(parameter_info_array_.size(), DefaultTokenInfo());
+  auto actuals_iter = macro_call_args.begin();
+  const auto actuals_end = macro_call_args.end();
+  auto formals_iter = parameter_info_array_.begin();
+  auto replacements_iter = arg_array->begin();
+  for (; actuals_iter != actuals_end;
+       ++actuals_iter, ++formals_iter, ++replacements_iter) {
+    if (!actuals_iter->text().empty()) {
+      // Actual text is provided.
+      *replacements_iter = *actuals_iter;
+    } else if (!formals_iter->default_value.text().empty()) {
+      // Use default parameter value.
+      *replacements_iter = formals_iter->default_value;
+    }
+    // else leave blank as empty string.
+  }
+  return absl::OkStatus();
+}
+
 const TokenInfo& MacroDefinition::SubstituteText(
     const substitution_map_type& substitution_map, const TokenInfo& token_info,
     int actual_token_enum) {
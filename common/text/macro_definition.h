@@ -23,6 +23,7 @@
 #include <string>
 #include <vector>
 
+#include "absl/container/flat_hash_map.h"
 #include "absl/status/status.h"
 #include "absl/strings/string_view.h"
 #include "common/text/token_info.h"
@@ -100,6 +101,10 @@ class MacroDefinition {
     return parameter_info_array_;
   }
 
+  // Returns the position in Parameters() of the formal parameter 'name',
+  // or -1 if there is none.
+  int ParameterPosition(absl::string_view name) const;
+
   using substitution_map_type = std::map<absl::string_view, DefaultTokenInfo>;
 
   // Create a text substitution map to be used for macro expansion.
@@ -108,6 +113,16 @@ class MacroDefinition {
   absl::Status PopulateSubstitutionMap(const std::vector<DefaultTokenInfo>&,
                                        substitution_map_type*) const;
 
+  // Replacement texts of the formal parameters, by position in Parameters().
+  using substitution_array_type = std::vector<DefaultTokenInfo>;
+
+  // Like PopulateSubstitutionMap(), but places the replacement of each formal
+  // parameter at its position, so that references to parameters whose
+  // positions were resolved once (with ParameterPosition()) are substituted
+  // without looking up their names for every call.
+  absl::Status PopulateSubstitutionArray(const std::vector<DefaultTokenInfo>&,
+                                         substitution_array_type*) const;
+
   // Replace formal parameter references with actuals.
   static const TokenInfo& SubstituteText(const substitution_map_type&,
                                          const TokenInfo&,
@@ -125,7 +140,7 @@ class MacroDefinition {
 
   // These form an ordered dictionary on macro parameters.
   std::vector<MacroParameterInfo> parameter_info_array_;
-  std::map<std::string, size_t> parameter_positions_;
+  absl::flat_hash_map<std::string, size_t> parameter_positions_;
 
   // un-tokenized text
   DefaultTokenInfo definition_text_;
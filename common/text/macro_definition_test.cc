@@ -309,5 +309,44 @@ TEST(MacroDefinitionTest, PopulateSubstitutionMapOneParamDefault) {
   EXPECT_EQ(*expect_param, param_default);
 }
 
+// Tests creating a positional substitution array with a 2-parameter macro.
+TEST(MacroDefinitionTest, PopulateSubstitutionArrayTwoParams) {
+  const TokenInfo def_header(FakeDefineEnum, "`define");
+  const TokenInfo macro_name(FakeIdEnum, "FF");
+  MacroDefinition macro(def_header, macro_name);
+  const TokenInfo param_default(FakeIdEnum, "ticker");
+  {
+    const TokenInfo param_name(FakeIdEnum, "clk");
+    const MacroParameterInfo param{param_name};
+    const bool appended = macro.AppendParameter(param);
+    EXPECT_TRUE(appended);
+  }
+  {
+    const TokenInfo param_name(FakeIdEnum, "rstn");
+    const MacroParameterInfo param{param_name, param_default};
+    const bool appended = macro.AppendParameter(param);
+    EXPECT_TRUE(appended);
+  }
+  EXPECT_EQ(macro.ParameterPosition("clk"), 0);
+  EXPECT_EQ(macro.ParameterPosition("rstn"), 1);
+  EXPECT_EQ(macro.ParameterPosition("dock"), -1);
+
+  std::vector<DefaultTokenInfo> call_args;
+  const TokenInfo actual1(FakeIntEnum, "99");
+  const TokenInfo actual2(FakeIdEnum, "");  // blank argument
+  call_args.emplace_back(actual1);
+  call_args.emplace_back(actual2);
+  MacroDefinition::substitution_array_type substitutions;
+  const auto status =
+      macro.PopulateSubstitutionArray(call_args, &substitutions);
+  EXPECT_TRUE(status.ok());
+  ASSERT_EQ(substitutions.size(), 2);
+  EXPECT_EQ(substitutions[0], actual1);
+  EXPECT_EQ(substitutions[1], param_default);
+
+  call_args.pop_back();
+  EXPECT_FALSE(macro.PopulateSubstitutionArray(call_args, &substitutions).ok());
+}
+
 }  // namespace
 }  // namespace verible
@@ -21,6 +21,7 @@
 #include <functional>
 #include <iosfwd>
 #include <memory>
+#include <utility>
 
 #include "common/text/symbol_ptr.h"
 #include "common/text/token_info.h"
@@ -47,6 +48,11 @@ struct SymbolTag {
   bool operator!=(const SymbolTag &symbol_tag) const {
     return !(*this == symbol_tag);
   }
+
+  template <typename H>
+  friend H AbslHashValue(H h, const SymbolTag &symbol_tag) {
+    return H::combine(std::move(h), symbol_tag.kind, symbol_tag.tag);
+  }
 };
 
 // Pair of inline helper functions for building SymbolTag
@@ -0,0 +1,124 @@
+// Copyright 2017-2023 The Verible Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "common/text/syntax_tree_arena.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <new>
+
+#include "absl/strings/string_view.h"
+#include "common/util/memory_stats.h"
+
+namespace verible {
+
+// Name of the blocks in SubsystemMemory().
+static constexpr absl::string_view kMemoryName = "syntax tree arena";
+
+// Every object is preceded by a pointer to the block it was allocated in, or
+// nullptr if it was allocated on the heap.
+static constexpr size_t kHeaderSize = sizeof(void*);
+
+static size_t RoundUpToPointer(size_t size) {
+  return (size + alignof(void*) - 1) & ~(alignof(void*) - 1);
+}
+
+// The block's storage directly follows this header.
+struct SyntaxTreeArena::Block {
+  explicit Block(size_t size)
+      : next(reinterpret_cast<char*>(this + 1)),
+        end(next + size),
+        accounted(SubsystemMemory().Enabled()) {}
+
+  // Number of live objects, plus one while the arena allocates from it.
+  std::atomic<size_t> references{1};
+  char* next;
+  char* const end;
+  // Whether the block was counted in SubsystemMemory().
+  const bool accounted;
+
+  static Block* New(size_t size) {
+    Block* block = new (::operator new(sizeof(Block) + size)) Block(size);
+    if (block->accounted) {
+      SubsystemMemory().Allocate(kMemoryName, sizeof(Block) + size);
+    }
+    return block;
+  }
+
+  void Unref() {
+    if (references.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+      if (accounted) {
+        SubsystemMemory().Release(
+            kMemoryName, end - reinterpret_cast<char*>(this));
+      }
+      this->~Block();
+      ::operator delete(this);
+    }
+  }
+};
+
+// The arena that syntax tree nodes are allocated from in this thread.
+static thread_local SyntaxTreeArena* current_arena = nullptr;
+
+SyntaxTreeArena::~SyntaxTreeArena() {
+  if (current_ != nullptr) current_->Unref();
+}
+
+SyntaxTreeArena::Scope::Scope(SyntaxTreeArena* arena)
+    : previous_(current_arena) {
+  current_arena = arena;
+}
+
+SyntaxTreeArena::Scope::~Scope() { current_arena = previous_; }
+
+void* SyntaxTreeArena::AllocateInBlock(size_t size) {
+  const size_t chunk_size = kHeaderSize + RoundUpToPointer(size);
+  if (current_ == nullptr ||
+      static_cast<size_t>(current_->end - current_->next) < chunk_size) {
+    if (chunk_size > kMaxBlockSize) return nullptr;
+    const size_t block_size = std::max(next_block_size_, chunk_size);
+    next_block_size_ = std::min(2 * next_block_size_, kMaxBlockSize);
+    if (current_ != nullptr) current_->Unref();
+    current_ = Block::New(block_size);
+    bytes_allocated_ += block_size;
+  }
+  Block** header = reinterpret_cast<Block**>(current_->next);
+  current_->next += chunk_size;
+  current_->references.fetch_add(1, std::memory_order_relaxed);
+  *header = current_;
+  return header + 1;
+}
+
+void* SyntaxTreeArena::Allocate(size_t size) {
+  if (current_arena != nullptr) {
+    if (void* storage = current_arena->AllocateInBlock(size)) return storage;
+  }
+  const size_t chunk_size = kHeaderSize + RoundUpToPointer(size);
+  Block** header = static_cast<Block**>(::operator new(chunk_size));
+  *header = nullptr;
+  return header + 1;
+}
+
+void SyntaxTreeArena::Deallocate(void* storage) {
+  if (storage == nullptr) return;
+  Block** header = static_cast<Block**>(storage) - 1;
+  if (*header == nullptr) {
+    ::operator delete(header);
+  } else {
+    (*header)->Unref();
+  }
+}
+
+}  // namespace verible
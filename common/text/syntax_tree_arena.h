@@ -0,0 +1,100 @@
+// Copyright 2017-2023 The Verible Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef VERIBLE_COMMON_TEXT_SYNTAX_TREE_ARENA_H_
+#define VERIBLE_COMMON_TEXT_SYNTAX_TREE_ARENA_H_
+
+#include <cstddef>
+
+namespace verible {
+
+// SyntaxTreeArena provides the storage of syntax tree nodes and leaves
+// (SyntaxTreeNode, SyntaxTreeLeaf) that are created while one of its Scopes
+// is active in the current thread, e.g. during parsing.  Instead of one heap
+// allocation per node, nodes are carved out of large blocks, which makes
+// building a large tree cheaper.
+//
+// Nodes remain owned by their SymbolPtr as usual: they can be moved between
+// trees, outlive the arena and be destroyed in any thread.  Destroying a node
+// only decrements the count of live nodes of its block; a block is freed once
+// it has no live nodes left and the arena no longer allocates from it.
+// Nodes that are created while no arena is active are heap-allocated.
+//
+// Tearing down a tree stays O(nodes): every node still runs its (virtual)
+// destructor through its owning SymbolPtr, which also releases the children
+// vector of a SyntaxTreeNode.  The arena only replaces the per-node free()
+// with a counter decrement; the blocks cannot be dropped wholesale because
+// nodes are neither trivially destructible nor owned by the arena.
+//
+// Allocating from an arena is not thread-safe, but several arenas can be
+// active at the same time in different threads.
+class SyntaxTreeArena {
+ public:
+  SyntaxTreeArena() = default;
+
+  SyntaxTreeArena(const SyntaxTreeArena&) = delete;
+  SyntaxTreeArena(SyntaxTreeArena&&) = delete;
+  SyntaxTreeArena& operator=(const SyntaxTreeArena&) = delete;
+  SyntaxTreeArena& operator=(SyntaxTreeArena&&) = delete;
+
+  ~SyntaxTreeArena();
+
+  // Makes 'arena' the one that syntax tree nodes are allocated from in the
+  // current thread, for the lifetime of this object.  Scopes can be nested.
+  class Scope {
+   public:
+    explicit Scope(SyntaxTreeArena* arena);
+
+    Scope(const Scope&) = delete;
+    Scope& operator=(const Scope&) = delete;
+
+    ~Scope();
+
+   private:
+    SyntaxTreeArena* const previous_;
+  };
+
+  // Returns storage for an object of 'size' bytes, from the arena that is
+  // active in the current thread, or from the heap if there is none.
+  // The storage is suitably aligned for any object with an alignment of up to
+  // alignof(void*), which is sufficient for syntax tree nodes and leaves.
+  static void* Allocate(size_t size);
+
+  // Releases storage that was returned by Allocate().
+  static void Deallocate(void* storage);
+
+  // Returns the total size of the blocks allocated by this arena so far.
+  size_t BytesAllocated() const { return bytes_allocated_; }
+
+ private:
+  struct Block;
+
+  static constexpr size_t kMinBlockSize = 4 << 10;
+  static constexpr size_t kMaxBlockSize = 1 << 20;
+
+  void* AllocateInBlock(size_t size);
+
+  // The block that objects are currently allocated from, or nullptr.
+  Block* current_ = nullptr;
+
+  // Size of the next block. Blocks grow geometrically, so that small trees
+  // do not need large blocks, and large trees do not need many.
+  size_t next_block_size_ = kMinBlockSize;
+
+  size_t bytes_allocated_ = 0;
+};
+
+}  // namespace verible
+
+#endif  // VERIBLE_COMMON_TEXT_SYNTAX_TREE_ARENA_H_
@@ -0,0 +1,187 @@
+// Copyright 2017-2023 The Verible Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "common/text/syntax_tree_arena.h"
+
+#include <cstdint>
+#include <memory>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include "common/text/concrete_syntax_leaf.h"
+#include "common/text/concrete_syntax_tree.h"
+#include "common/text/symbol.h"
+#include "common/text/token_info.h"
+#include "common/text/tree_builder_test_util.h"
+#include "common/text/tree_utils.h"
+#include "common/util/memory_stats.h"
+#include "gtest/gtest.h"
+
+namespace verible {
+namespace {
+
+// Returns a node with 'width' leaves.
+SymbolPtr MakeFlatTree(int width) {
+  SymbolPtr node = MakeTaggedNode(1);
+  for (int i = 0; i < width; ++i) {
+    node = ExtendNode(node, Leaf(i, "leaf"));
+  }
+  return node;
+}
+
+void ExpectFlatTree(const Symbol& tree, int width) {
+  ASSERT_EQ(tree.Kind(), SymbolKind::kNode);
+  const auto& children = SymbolCastToNode(tree).children();
+  ASSERT_EQ(children.size(), width);
+  for (int i = 0; i < width; ++i) {
+    ASSERT_NE(children[i], nullptr);
+    EXPECT_EQ(children[i]->Tag(), LeafTag(i));
+    EXPECT_EQ(SymbolCastToLeaf(*children[i]).get().text(), "leaf");
+  }
+}
+
+TEST(SyntaxTreeArenaTest, NoAllocationOutsideOfScope) {
+  SyntaxTreeArena arena;
+  const SymbolPtr tree = MakeFlatTree(10);
+  EXPECT_EQ(arena.BytesAllocated(), 0);
+  ExpectFlatTree(*tree, 10);
+}
+
+TEST(SyntaxTreeArenaTest, AllocationInScope) {
+  SyntaxTreeArena arena;
+  SymbolPtr tree;
+  {
+    const SyntaxTreeArena::Scope scope(&arena);
+    tree = MakeFlatTree(10);
+  }
+  const size_t allocated = arena.BytesAllocated();
+  EXPECT_GT(allocated, 0);
+  ExpectFlatTree(*tree, 10);
+  tree.reset();
+  // Nodes created after leaving the scope are not allocated in the arena.
+  tree = MakeFlatTree(10);
+  EXPECT_EQ(arena.BytesAllocated(), allocated);
+}
+
+TEST(SyntaxTreeArenaTest, BlocksGrow) {
+  SyntaxTreeArena arena;
+  const SyntaxTreeArena::Scope scope(&arena);
+  const SymbolPtr small_tree = MakeFlatTree(1);
+  const size_t small_size = arena.BytesAllocated();
+  const SymbolPtr large_tree = MakeFlatTree(100000);
+  // Far less blocks than nodes.
+  EXPECT_GT(arena.BytesAllocated(), 100000 * sizeof(OwnedTokenLeaf));
+  EXPECT_LT(small_size * 100, arena.BytesAllocated());
+  ExpectFlatTree(*small_tree, 1);
+  ExpectFlatTree(*large_tree, 100000);
+}
+
+TEST(SyntaxTreeArenaTest, MemoryAccounting) {
+  MemoryStats& stats = SubsystemMemory();
+  stats.Enable();
+  const MemoryCounter before = stats.Counters()["syntax tree arena"];
+  SymbolPtr tree;
+  {
+    SyntaxTreeArena arena;
+    const SyntaxTreeArena::Scope scope(&arena);
+    tree = MakeFlatTree(1000);
+    const MemoryCounter during = stats.Counters()["syntax tree arena"];
+    EXPECT_GE(during.allocated - before.allocated,
+              static_cast<int64_t>(arena.BytesAllocated()));
+    EXPECT_EQ(during.live - before.live, during.allocated - before.allocated);
+  }
+  // Blocks are released with the last of their nodes.
+  EXPECT_GT(stats.Counters()["syntax tree arena"].live, before.live);
+  tree.reset();
+  EXPECT_EQ(stats.Counters()["syntax tree arena"].live, before.live);
+}
+
+TEST(SyntaxTreeArenaTest, NestedScopes) {
+  SyntaxTreeArena outer_arena;
+  SyntaxTreeArena inner_arena;
+  const SyntaxTreeArena::Scope outer_scope(&outer_arena);
+  SymbolPtr outer_tree = MakeFlatTree(5);
+  const size_t outer_allocated = outer_arena.BytesAllocated();
+  {
+    const SyntaxTreeArena::Scope inner_scope(&inner_arena);
+    const SymbolPtr inner_tree = MakeFlatTree(5);
+    EXPECT_GT(inner_arena.BytesAllocated(), 0);
+  }
+  EXPECT_EQ(outer_arena.BytesAllocated(), outer_allocated);
+  // Allocation continues in the outer arena.
+  outer_tree = ExtendNode(outer_tree, Leaf(5, "leaf"));
+  ExpectFlatTree(*outer_tree, 6);
+}
+
+TEST(SyntaxTreeArenaTest, TreeOutlivesArena) {
+  SymbolPtr tree;
+  {
+    SyntaxTreeArena arena;
+    const SyntaxTreeArena::Scope scope(&arena);
+    tree = MakeFlatTree(1000);
+  }
+  ExpectFlatTree(*tree, 1000);
+  // Partially destroyed.
+  SymbolCastToNode(*tree).mutable_children().resize(10);
+  ExpectFlatTree(*tree, 10);
+}
+
+TEST(SyntaxTreeArenaTest, MixedTree) {
+  SyntaxTreeArena arena;
+  SymbolPtr tree = MakeFlatTree(10);
+  {
+    const SyntaxTreeArena::Scope scope(&arena);
+    tree = ExtendNode(tree, Leaf(10, "leaf"));
+    tree = MakeNode(std::move(tree));
+  }
+  tree = ExtendNode(tree, Leaf(11, "leaf"));
+  const auto& children = SymbolCastToNode(*tree).children();
+  ASSERT_EQ(children.size(), 2);
+  ExpectFlatTree(*children[0], 11);
+}
+
+TEST(SyntaxTreeArenaTest, DestroyInOtherThreads) {
+  std::vector<SymbolPtr> trees;
+  {
+    SyntaxTreeArena arena;
+    const SyntaxTreeArena::Scope scope(&arena);
+    for (int i = 0; i < 8; ++i) trees.push_back(MakeFlatTree(1000));
+  }
+  std::vector<std::thread> threads;
+  for (auto& tree : trees) {
+    threads.emplace_back([&tree] {
+      ExpectFlatTree(*tree, 1000);
+      tree.reset();
+    });
+  }
+  for (auto& thread : threads) thread.join();
+}
+
+TEST(SyntaxTreeArenaTest, ArenasInOtherThreads) {
+  std::vector<SymbolPtr> trees(8);
+  std::vector<std::thread> threads;
+  for (auto& tree : trees) {
+    threads.emplace_back([&tree] {
+      SyntaxTreeArena arena;
+      const SyntaxTreeArena::Scope scope(&arena);
+      tree = MakeFlatTree(1000);
+    });
+  }
+  for (auto& thread : threads) thread.join();
+  for (const auto& tree : trees) ExpectFlatTree(*tree, 1000);
+}
+
+}  // namespace
+}  // namespace verible
@@ -0,0 +1,435 @@
+// Copyright 2017-2023 The Verible Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "common/text/syntax_tree_binary.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <ostream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "absl/status/status.h"
+#include "absl/status/statusor.h"
+#include "absl/strings/match.h"
+#include "absl/strings/str_cat.h"
+#include "absl/strings/string_view.h"
+#include "common/text/concrete_syntax_leaf.h"
+#include "common/text/concrete_syntax_tree.h"
+#include "common/text/symbol.h"
+#include "common/text/text_structure.h"
+#include "common/text/token_info.h"
+#include "common/text/token_stream_view.h"
+#include "common/util/casts.h"
+#include "common/util/range.h"
+
+namespace verible {
+
+static constexpr char kMagic[4] = {'V', 'C', 'S', 'T'};
+static constexpr int kNumSections =
+    static_cast<int>(SyntaxTreeBinarySection::kNumSections);
+// Magic, version, number of sections, reserved; then the section table.
+static constexpr size_t kHeaderSize = 16 + 16 * kNumSections;
+
+// Size of the elements of each section.
+static constexpr size_t kElementSizes[kNumSections] = {
+    1,  // kText
+    4,  // kTokenTag
+    4,  // kTokenStart
+    4,  // kTokenEnd
+    4,  // kFilteredTokens
+    1,  // kTreeKind
+    4,  // kTreeTag
+    4,  // kTreeSubtreeSize
+    4,  // kTreeStart
+    4,  // kTreeEnd
+    1,  // kTokenNames
+    1,  // kNodeNames
+};
+
+static size_t AlignUp(size_t offset) { return (offset + 7) & ~size_t{7}; }
+
+namespace {
+// Columns of the syntax tree, in preorder.
+struct TreeColumns {
+  std::vector<SyntaxTreeBinaryKind> kind;
+  std::vector<int32_t> tag;
+  std::vector<uint32_t> subtree_size;
+  std::vector<uint32_t> start;
+  std::vector<uint32_t> end;
+
+  int max_token_enum = -1;
+  int max_node_enum = -1;
+};
+}  // namespace
+
+static void TokenOffsets(const TokenInfo& token, absl::string_view base,
+                         uint32_t* start, uint32_t* end) {
+  if (IsSubRange(token.text(), base)) {
+    *start = token.left(base);
+    *end = token.right(base);
+  } else {
+    *start = kSyntaxTreeBinaryNoOffset;
+    *end = kSyntaxTreeBinaryNoOffset;
+  }
+}
+
+static void AppendSymbol(const Symbol* symbol, absl::string_view base,
+                         TreeColumns* columns) {
+  const size_t index = columns->kind.size();
+  uint32_t start = kSyntaxTreeBinaryNoOffset;
+  uint32_t end = kSyntaxTreeBinaryNoOffset;
+  if (symbol == nullptr) {
+    columns->kind.push_back(SyntaxTreeBinaryKind::kNull);
+    columns->tag.push_back(0);
+  } else if (symbol->Kind() == SymbolKind::kLeaf) {
+    const TokenInfo& token = down_cast<const SyntaxTreeLeaf*>(symbol)->get();
+    columns->kind.push_back(SyntaxTreeBinaryKind::kLeaf);
+    columns->tag.push_back(token.token_enum());
+    columns->max_token_enum =
+        std::max(columns->max_token_enum, token.token_enum());
+    TokenOffsets(token, base, &start, &end);
+  } else {
+    columns->kind.push_back(SyntaxTreeBinaryKind::kNode);
+    columns->tag.push_back(symbol->Tag().tag);
+    columns->max_node_enum =
+        std::max(columns->max_node_enum, symbol->Tag().tag);
+  }
+  columns->subtree_size.push_back(1);
+  columns->start.push_back(start);
+  columns->end.push_back(end);
+  if (columns->kind[index] != SyntaxTreeBinaryKind::kNode) return;
+
+  const auto& node = down_cast<const SyntaxTreeNode&>(*symbol);
+  for (const auto& child : node.children()) {
+    const size_t child_index = columns->kind.size();
+    AppendSymbol(child.get(), base, columns);
+    if (columns->start[child_index] == kSyntaxTreeBinaryNoOffset) continue;
+    if (start == kSyntaxTreeBinaryNoOffset) start = columns->start[child_index];
+    end = columns->end[child_index];
+  }
+  columns->subtree_size[index] = columns->kind.size() - index;
+  columns->start[index] = start;
+  columns->end[index] = end;
+}
+
+// Returns the NUL-terminated names of enums [0, max_enum].
+static std::string EnumNames(const EnumNamePrinter& printer, int max_enum) {
+  std::ostringstream stream;
+  for (int e = 0; e <= max_enum; ++e) {
+    printer(stream, e);
+    stream << '\0';
+  }
+  return stream.str();
+}
+
+template <typename T>
+static absl::string_view Bytes(const std::vector<T>& column) {
+  return {reinterpret_cast<const char*>(column.data()),
+          column.size() * sizeof(T)};
+}
+
+template <typename T>
+static void WriteInteger(T value, std::ostream* stream) {
+  stream->write(reinterpret_cast<const char*>(&value), sizeof(value));
+}
+
+void WriteSyntaxTreeBinary(const TextStructureView& data,
+                           const EnumNamePrinter& token_names,
+                           const EnumNamePrinter& node_names,
+                           std::ostream* stream) {
+  const absl::string_view base = data.Contents();
+
+  const TokenSequence& tokens = data.TokenStream();
+  std::vector<int32_t> token_tags;
+  std::vector<uint32_t> token_starts;
+  std::vector<uint32_t> token_ends;
+  token_tags.reserve(tokens.size());
+  token_starts.reserve(tokens.size());
+  token_ends.reserve(tokens.size());
+  TreeColumns tree;
+  for (const TokenInfo& token : tokens) {
+    uint32_t start, end;
+    TokenOffsets(token, base, &start, &end);
+    token_tags.push_back(token.token_enum());
+    token_starts.push_back(start);
+    token_ends.push_back(end);
+    tree.max_token_enum = std::max(tree.max_token_enum, token.token_enum());
+  }
+
+  std::vector<uint32_t> filtered_tokens;
+  filtered_tokens.reserve(data.GetTokenStreamView().size());
+  for (const auto& iter : data.GetTokenStreamView()) {
+    filtered_tokens.push_back(std::distance(tokens.begin(), iter));
+  }
+
+  if (data.SyntaxTree() != nullptr) {
+    AppendSymbol(data.SyntaxTree().get(), base, &tree);
+  }
+
+  const std::string token_name_table =
+      EnumNames(token_names, tree.max_token_enum);
+  const std::string node_name_table = EnumNames(node_names, tree.max_node_enum);
+
+  const absl::string_view sections[kNumSections] = {
+      base,
+      Bytes(token_tags),
+      Bytes(token_starts),
+      Bytes(token_ends),
+      Bytes(filtered_tokens),
+      Bytes(tree.kind),
+      Bytes(tree.tag),
+      Bytes(tree.subtree_size),
+      Bytes(tree.start),
+      Bytes(tree.end),
+      token_name_table,
+      node_name_table,
+  };
+
+  stream->write(kMagic, sizeof(kMagic));
+  WriteInteger<uint32_t>(kSyntaxTreeBinaryVersion, stream);
+  WriteInteger<uint32_t>(kNumSections, stream);
+  WriteInteger<uint32_t>(0, stream);
+  size_t offset = kHeaderSize;
+  for (const absl::string_view section : sections) {
+    offset = AlignUp(offset);
+    WriteInteger<uint64_t>(offset, stream);
+    WriteInteger<uint64_t>(section.size(), stream);
+    offset += section.size();
+  }
+
+  offset = kHeaderSize;
+  for (const absl::string_view section : sections) {
+    static constexpr char kPadding[8] = {};
+    const size_t aligned = AlignUp(offset);
+    stream->write(kPadding, aligned - offset);
+    stream->write(section.data(), section.size());
+    offset = aligned + section.size();
+  }
+}
+
+template <typename T>
+static T ReadInteger(absl::string_view bytes, size_t offset) {
+  T value;
+  std::memcpy(&value, bytes.data() + offset, sizeof(value));
+  return value;
+}
+
+static std::vector<absl::string_view> SplitNames(absl::string_view table) {
+  std::vector<absl::string_view> names;
+  while (!table.empty()) {
+    const size_t end = table.find('\0');
+    names.push_back(table.substr(0, end));
+    table.remove_prefix(end + 1);
+  }
+  return names;
+}
+
+absl::StatusOr<SyntaxTreeBinaryView> SyntaxTreeBinaryView::Create(
+    absl::string_view bytes) {
+  if (bytes.size() < 16 || !absl::StartsWith(bytes, {kMagic, 4})) {
+    return absl::InvalidArgumentError("Not a syntax tree binary export.");
+  }
+  if (reinterpret_cast<uintptr_t>(bytes.data()) % 8 != 0) {
+    return absl::InvalidArgumentError(
+        "Syntax tree binary export is not aligned to 8 bytes.");
+  }
+  const uint32_t version = ReadInteger<uint32_t>(bytes, 4);
+  if (version != kSyntaxTreeBinaryVersion) {
+    return absl::InvalidArgumentError(
+        absl::StrCat("Unsupported syntax tree binary export version ", version,
+                     ", expected ", kSyntaxTreeBinaryVersion, "."));
+  }
+  const uint32_t num_sections = ReadInteger<uint32_t>(bytes, 8);
+  if (num_sections < kNumSections ||
+      bytes.size() < 16 + 16 * uint64_t{num_sections}) {
+    return absl::InvalidArgumentError(
+        "Truncated syntax tree binary export header.");
+  }
+
+  SyntaxTreeBinaryView view;
+  for (int i = 0; i < kNumSections; ++i) {
+    const uint64_t offset = ReadInteger<uint64_t>(bytes, 16 + 16 * i);
+    const uint64_t size = ReadInteger<uint64_t>(bytes, 24 + 16 * i);
+    if (offset > bytes.size() || size > bytes.size() - offset ||
+        offset % 8 != 0 || size % kElementSizes[i] != 0) {
+      return absl::InvalidArgumentError(
+          absl::StrCat("Invalid section ", i,
+                       " in syntax tree binary export."));
+    }
+    view.sections_[i] = bytes.substr(offset, size);
+  }
+
+  if (view.TokenStarts().size() != view.TokenTags().size() ||
+      view.TokenEnds().size() != view.TokenTags().size()) {
+    return absl::InvalidArgumentError(
+        "Inconsistent token columns in syntax tree binary export.");
+  }
+  const size_t tree_size = view.TreeKinds().size();
+  if (view.TreeTags().size() != tree_size ||
+      view.TreeSubtreeSizes().size() != tree_size ||
+      view.TreeStarts().size() != tree_size ||
+      view.TreeEnds().size() != tree_size) {
+    return absl::InvalidArgumentError(
+        "Inconsistent tree columns in syntax tree binary export.");
+  }
+  for (const auto section :
+       {SyntaxTreeBinarySection::kTokenNames,
+        SyntaxTreeBinarySection::kNodeNames}) {
+    const absl::string_view table = view.Section(section);
+    if (!table.empty() && table.back() != '\0') {
+      return absl::InvalidArgumentError(
+          "Unterminated name table in syntax tree binary export.");
+    }
+  }
+  view.token_names_ =
+      SplitNames(view.Section(SyntaxTreeBinarySection::kTokenNames));
+  view.node_names_ =
+      SplitNames(view.Section(SyntaxTreeBinarySection::kNodeNames));
+  return view;
+}
+
+bool SyntaxTreeBinaryView::AllTokensInText() const {
+  const auto starts = TokenStarts();
+  if (std::find(starts.begin(), starts.end(), kSyntaxTreeBinaryNoOffset) !=
+      starts.end()) {
+    return false;
+  }
+  const auto kinds = TreeKinds();
+  const auto tree_starts = TreeStarts();
+  for (size_t i = 0; i < kinds.size(); ++i) {
+    if (kinds[i] == SyntaxTreeBinaryKind::kLeaf &&
+        tree_starts[i] == kSyntaxTreeBinaryNoOffset) {
+      return false;
+    }
+  }
+  return true;
+}
+
+namespace {
+// Rebuilds the syntax tree of a SyntaxTreeBinaryView.
+class TreeRestorer {
+ public:
+  TreeRestorer(const SyntaxTreeBinaryView& view, absl::string_view base)
+      : view_(view), base_(base) {}
+
+  // Returns the subtree at entry 'index', and advances 'index' past it.
+  // Sets 'ok' to false on malformed input.
+  SymbolPtr Restore(size_t* index, size_t end);
+
+  bool ok() const { return ok_; }
+
+ private:
+  const SyntaxTreeBinaryView& view_;
+  const absl::string_view base_;
+  bool ok_ = true;
+};
+}  // namespace
+
+SymbolPtr TreeRestorer::Restore(size_t* index, size_t end) {
+  const size_t i = *index;
+  const uint32_t size = view_.TreeSubtreeSizes()[i];
+  if (size == 0 || size > end - i) {
+    ok_ = false;
+    *index = end;
+    return nullptr;
+  }
+  *index = i + size;
+  switch (view_.TreeKinds()[i]) {
+    case SyntaxTreeBinaryKind::kNull:
+      return nullptr;
+    case SyntaxTreeBinaryKind::kLeaf: {
+      const uint32_t start = view_.TreeStarts()[i];
+      const uint32_t leaf_end = view_.TreeEnds()[i];
+      if (start > leaf_end || leaf_end > base_.size()) {
+        ok_ = false;
+        return nullptr;
+      }
+      return std::make_unique<OwnedTokenLeaf>(
+          view_.TreeTags()[i], base_.substr(start, leaf_end - start));
+    }
+    case SyntaxTreeBinaryKind::kNode: {
+      auto node = std::make_unique<SyntaxTreeNode>(view_.TreeTags()[i]);
+      size_t child = i + 1;
+      while (child < i + size && ok_) {
+        node->AppendChild(Restore(&child, i + size));
+      }
+      return node;
+    }
+  }
+  ok_ = false;
+  return nullptr;
+}
+
+absl::Status RestoreSyntaxTreeBinary(const SyntaxTreeBinaryView& view,
+                                     TextStructureView* data) {
+  const absl::string_view base = data->Contents();
+  if (view.Text() != base) {
+    return absl::InvalidArgumentError(
+        "Syntax tree binary export is of a different text.");
+  }
+  if (!view.AllTokensInText()) {
+    return absl::InvalidArgumentError(
+        "Syntax tree binary export has tokens that are not part of its text.");
+  }
+
+  const auto tags = view.TokenTags();
+  const auto starts = view.TokenStarts();
+  const auto ends = view.TokenEnds();
+  TokenSequence tokens;
+  tokens.reserve(tags.size());
+  for (size_t i = 0; i < tags.size(); ++i) {
+    if (starts[i] > ends[i] || ends[i] > base.size()) {
+      return absl::InvalidArgumentError(
+          "Invalid token range in syntax tree binary export.");
+    }
+    tokens.emplace_back(tags[i], base.substr(starts[i], ends[i] - starts[i]));
+  }
+
+  for (const uint32_t index : view.FilteredTokens()) {
+    if (index >= tokens.size()) {
+      return absl::InvalidArgumentError(
+          "Invalid filtered token in syntax tree binary export.");
+    }
+  }
+
+  SymbolPtr tree;
+  const size_t tree_size = view.TreeKinds().size();
+  if (tree_size > 0) {
+    TreeRestorer restorer(view, base);
+    size_t index = 0;
+    tree = restorer.Restore(&index, tree_size);
+    if (!restorer.ok() || index != tree_size) {
+      return absl::InvalidArgumentError(
+          "Invalid syntax tree in syntax tree binary export.");
+    }
+  }
+
+  // Everything is valid; only now replace the contents of 'data'.
+  data->MutableSyntaxTree() = std::move(tree);
+  TokenSequence& data_tokens = data->MutableTokenStream();
+  data_tokens = std::move(tokens);
+  TokenStreamView& view_tokens = data->MutableTokenStreamView();
+  view_tokens.clear();
+  view_tokens.reserve(view.FilteredTokens().size());
+  for (const uint32_t index : view.FilteredTokens()) {
+    view_tokens.push_back(data_tokens.begin() + index);
+  }
+  data->CalculateFirstTokensPerLine();
+  return absl::OkStatus();
+}
+
+}  // namespace verible
@@ -0,0 +1,190 @@
+// Copyright 2017-2023 The Verible Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// Compact binary export of a TextStructureView (text, tokens and syntax
+// tree), laid out so that readers can use it directly from a memory-mapped
+// file, without any decoding.
+//
+// Format (version 1), all integers little-endian:
+//
+//   Header:
+//     char[4]  magic "VCST"
+//     uint32   version (1)
+//     uint32   number of sections
+//     uint32   reserved (0)
+//     Section table, one entry per section, in SyntaxTreeBinarySection order:
+//       uint64 byte offset from the start of the file (a multiple of 8)
+//       uint64 byte size
+//
+//   Sections, each an array of one column:
+//     kText             char[]    the analyzed text
+//     kTokenTag         int32[T]  token enums of all lexed tokens
+//     kTokenStart       uint32[T] byte offsets of tokens into kText
+//     kTokenEnd         uint32[T]
+//     kFilteredTokens   uint32[F] indices (into the above) of the tokens
+//                                 that remained after filtering
+//     kTreeKind         uint8[N]  syntax tree in preorder: SyntaxTreeBinaryKind
+//     kTreeTag          int32[N]  node enum, or token enum of a leaf
+//     kTreeSubtreeSize  uint32[N] entries [i, i + size) are the subtree of i
+//     kTreeStart        uint32[N] range of text spanned by the subtree
+//     kTreeEnd          uint32[N]
+//     kTokenNames       char[]    NUL-terminated names of token enums 0, 1, ...
+//     kNodeNames        char[]    NUL-terminated names of node enums 0, 1, ...
+//
+// Null children of nodes are kept as entries of kind kNull (subtree size 1),
+// so that children keep their positions, like in JSON exports.
+// Tokens whose text is not part of kText (e.g. from macro expansions) have
+// start and end offsets kSyntaxTreeBinaryNoOffset; so do subtrees without
+// tokens from kText.
+// Writers may append sections without changing the version; readers ignore
+// those they don't know.
+
+#ifndef VERIBLE_COMMON_TEXT_SYNTAX_TREE_BINARY_H_
+#define VERIBLE_COMMON_TEXT_SYNTAX_TREE_BINARY_H_
+
+#include <cstdint>
+#include <functional>
+#include <iosfwd>
+#include <vector>
+
+#include "absl/status/status.h"
+#include "absl/status/statusor.h"
+#include "absl/strings/string_view.h"
+#include "absl/types/span.h"
+#include "common/text/text_structure.h"
+
+namespace verible {
+
+enum class SyntaxTreeBinarySection {
+  kText,
+  kTokenTag,
+  kTokenStart,
+  kTokenEnd,
+  kFilteredTokens,
+  kTreeKind,
+  kTreeTag,
+  kTreeSubtreeSize,
+  kTreeStart,
+  kTreeEnd,
+  kTokenNames,
+  kNodeNames,
+  kNumSections,
+};
+
+enum class SyntaxTreeBinaryKind : uint8_t {
+  kNull = 0,
+  kLeaf = 1,
+  kNode = 2,
+};
+
+inline constexpr uint32_t kSyntaxTreeBinaryVersion = 1;
+inline constexpr uint32_t kSyntaxTreeBinaryNoOffset = 0xffffffff;
+
+// Prints the name of a token or node enum.
+using EnumNamePrinter = std::function<void(std::ostream&, int)>;
+
+// Writes 'data' in the format above to 'stream'.  The text is limited to
+// 4GB.  Stream errors are left to the caller to check.
+void WriteSyntaxTreeBinary(const TextStructureView& data,
+                           const EnumNamePrinter& token_names,
+                           const EnumNamePrinter& node_names,
+                           std::ostream* stream);
+
+class SyntaxTreeBinaryView;
+
+// Replaces the tokens, filtered tokens and syntax tree of 'data' with those of
+// 'view', which must be an export of the same text (data->Contents()).
+// Fails if the texts differ, if tokens or leaves are not part of the text
+// (see SyntaxTreeBinaryView::AllTokensInText()) or if the export is malformed.
+// Tree nodes are allocated from the active SyntaxTreeArena, if any.
+absl::Status RestoreSyntaxTreeBinary(const SyntaxTreeBinaryView& view,
+                                     TextStructureView* data);
+
+// Read-only view of an export in the above format.  The viewed bytes must
+// outlive this object, and must be aligned to 8 bytes, like memory-mapped
+// files are.
+class SyntaxTreeBinaryView {
+ public:
+  // Checks the header and section bounds of 'bytes'; does not look at the
+  // contents of sections.
+  static absl::StatusOr<SyntaxTreeBinaryView> Create(absl::string_view bytes);
+
+  absl::string_view Text() const {
+    return Section(SyntaxTreeBinarySection::kText);
+  }
+
+  absl::Span<const int32_t> TokenTags() const {
+    return Column<int32_t>(SyntaxTreeBinarySection::kTokenTag);
+  }
+  absl::Span<const uint32_t> TokenStarts() const {
+    return Column<uint32_t>(SyntaxTreeBinarySection::kTokenStart);
+  }
+  absl::Span<const uint32_t> TokenEnds() const {
+    return Column<uint32_t>(SyntaxTreeBinarySection::kTokenEnd);
+  }
+  absl::Span<const uint32_t> FilteredTokens() const {
+    return Column<uint32_t>(SyntaxTreeBinarySection::kFilteredTokens);
+  }
+
+  absl::Span<const SyntaxTreeBinaryKind> TreeKinds() const {
+    return Column<SyntaxTreeBinaryKind>(SyntaxTreeBinarySection::kTreeKind);
+  }
+  absl::Span<const int32_t> TreeTags() const {
+    return Column<int32_t>(SyntaxTreeBinarySection::kTreeTag);
+  }
+  absl::Span<const uint32_t> TreeSubtreeSizes() const {
+    return Column<uint32_t>(SyntaxTreeBinarySection::kTreeSubtreeSize);
+  }
+  absl::Span<const uint32_t> TreeStarts() const {
+    return Column<uint32_t>(SyntaxTreeBinarySection::kTreeStart);
+  }
+  absl::Span<const uint32_t> TreeEnds() const {
+    return Column<uint32_t>(SyntaxTreeBinarySection::kTreeEnd);
+  }
+
+  // Returns true if all tokens and leaves are part of Text(), i.e. none has
+  // kSyntaxTreeBinaryNoOffset offsets, so that they can be restored.
+  bool AllTokensInText() const;
+
+  // Names of token and node enums, indexed by enum value.
+  const std::vector<absl::string_view>& TokenNames() const {
+    return token_names_;
+  }
+  const std::vector<absl::string_view>& NodeNames() const {
+    return node_names_;
+  }
+
+ private:
+  SyntaxTreeBinaryView() = default;
+
+  absl::string_view Section(SyntaxTreeBinarySection section) const {
+    return sections_[static_cast<int>(section)];
+  }
+
+  template <typename T>
+  absl::Span<const T> Column(SyntaxTreeBinarySection section) const {
+    const absl::string_view bytes = Section(section);
+    return absl::MakeConstSpan(reinterpret_cast<const T*>(bytes.data()),
+                               bytes.size() / sizeof(T));
+  }
+
+  absl::string_view
+      sections_[static_cast<int>(SyntaxTreeBinarySection::kNumSections)];
+  std::vector<absl::string_view> token_names_;
+  std::vector<absl::string_view> node_names_;
+};
+
+}  // namespace verible
+
+#endif  // VERIBLE_COMMON_TEXT_SYNTAX_TREE_BINARY_H_
@@ -0,0 +1,224 @@
+// Copyright 2017-2023 The Verible Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "common/text/syntax_tree_binary.h"
+
+#include <cstring>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "absl/strings/string_view.h"
+#include "common/text/concrete_syntax_tree.h"
+#include "common/text/text_structure.h"
+#include "common/text/token_info.h"
+#include "common/text/tree_builder_test_util.h"
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+
+namespace verible {
+namespace {
+
+using testing::ElementsAre;
+using testing::HasSubstr;
+
+constexpr uint32_t kNo = kSyntaxTreeBinaryNoOffset;
+constexpr auto kNull = SyntaxTreeBinaryKind::kNull;
+constexpr auto kLeaf = SyntaxTreeBinaryKind::kLeaf;
+constexpr auto kNode = SyntaxTreeBinaryKind::kNode;
+
+void PrintTokenName(std::ostream& stream, int e) { stream << "token" << e; }
+void PrintNodeName(std::ostream& stream, int e) { stream << "node" << e; }
+
+// Returns the export of 'data' in 8-byte aligned memory.
+std::vector<uint64_t> Export(const TextStructureView& data) {
+  std::ostringstream stream;
+  WriteSyntaxTreeBinary(data, PrintTokenName, PrintNodeName, &stream);
+  const std::string bytes = stream.str();
+  std::vector<uint64_t> aligned((bytes.size() + 7) / 8);
+  std::memcpy(aligned.data(), bytes.data(), bytes.size());
+  aligned.push_back(bytes.size());  // keep the size at the end
+  return aligned;
+}
+
+absl::string_view AsBytes(const std::vector<uint64_t>& exported) {
+  return {reinterpret_cast<const char*>(exported.data()),
+          static_cast<size_t>(exported.back())};
+}
+
+class SyntaxTreeBinaryTest : public testing::Test {
+ protected:
+  SyntaxTreeBinaryTest() : data_("hello, world") {
+    const absl::string_view text = data_.Contents();
+    TokenSequence& tokens = data_.MutableTokenStream();
+    tokens.push_back(TokenInfo(1, text.substr(0, 5)));  // "hello"
+    tokens.push_back(TokenInfo(2, text.substr(5, 1)));  // ","
+    tokens.push_back(TokenInfo(3, text.substr(6, 1)));  // " "
+    tokens.push_back(TokenInfo(4, text.substr(7, 5)));  // "world"
+    TokenStreamView& view = data_.MutableTokenStreamView();
+    view.push_back(tokens.begin());
+    view.push_back(tokens.begin() + 1);
+    view.push_back(tokens.begin() + 3);
+    data_.MutableSyntaxTree() =
+        TNode(7, Leaf(tokens[0]), nullptr, TNode(6, Leaf(2, kExpansion)),
+              TNode(5, Leaf(2, kExpansion), TNode(6), Leaf(tokens[3])));
+  }
+
+  static constexpr absl::string_view kExpansion = "macro";
+  TextStructureView data_;
+};
+
+TEST_F(SyntaxTreeBinaryTest, RoundTrip) {
+  const auto exported = Export(data_);
+  const auto view_or = SyntaxTreeBinaryView::Create(AsBytes(exported));
+  ASSERT_TRUE(view_or.ok()) << view_or.status().message();
+  const SyntaxTreeBinaryView& view = *view_or;
+
+  EXPECT_EQ(view.Text(), "hello, world");
+  EXPECT_THAT(view.TokenTags(), ElementsAre(1, 2, 3, 4));
+  EXPECT_THAT(view.TokenStarts(), ElementsAre(0, 5, 6, 7));
+  EXPECT_THAT(view.TokenEnds(), ElementsAre(5, 6, 7, 12));
+  EXPECT_THAT(view.FilteredTokens(), ElementsAre(0, 1, 3));
+
+  EXPECT_THAT(view.TreeKinds(), ElementsAre(kNode, kLeaf, kNull, kNode, kLeaf,
+                                            kNode, kLeaf, kNode, kLeaf));
+  EXPECT_THAT(view.TreeTags(), ElementsAre(7, 1, 0, 6, 2, 5, 2, 6, 4));
+  EXPECT_THAT(view.TreeSubtreeSizes(),
+              ElementsAre(9, 1, 1, 2, 1, 4, 1, 1, 1));
+  EXPECT_THAT(view.TreeStarts(),
+              ElementsAre(0, 0, kNo, kNo, kNo, 7, kNo, kNo, 7));
+  EXPECT_THAT(view.TreeEnds(),
+              ElementsAre(12, 5, kNo, kNo, kNo, 12, kNo, kNo, 12));
+
+  EXPECT_THAT(view.TokenNames(),
+              ElementsAre("token0", "token1", "token2", "token3", "token4"));
+  EXPECT_THAT(view.NodeNames(), ElementsAre("node0", "node1", "node2",
+                                            "node3", "node4", "node5",
+                                            "node6", "node7"));
+}
+
+TEST(SyntaxTreeBinaryEmptyTest, EmptyTextStructure) {
+  const TextStructureView data("");
+  const auto exported = Export(data);
+  const auto view_or = SyntaxTreeBinaryView::Create(AsBytes(exported));
+  ASSERT_TRUE(view_or.ok()) << view_or.status().message();
+  EXPECT_TRUE(view_or->Text().empty());
+  EXPECT_TRUE(view_or->TokenTags().empty());
+  EXPECT_TRUE(view_or->TreeKinds().empty());
+  EXPECT_TRUE(view_or->TokenNames().empty());
+  EXPECT_TRUE(view_or->NodeNames().empty());
+}
+
+TEST_F(SyntaxTreeBinaryTest, SectionsAreAligned) {
+  const auto exported = Export(data_);
+  const auto view_or = SyntaxTreeBinaryView::Create(AsBytes(exported));
+  ASSERT_TRUE(view_or.ok());
+  for (const void* column :
+       {static_cast<const void*>(view_or->TokenTags().data()),
+        static_cast<const void*>(view_or->TreeKinds().data()),
+        static_cast<const void*>(view_or->TreeEnds().data())}) {
+    EXPECT_EQ(reinterpret_cast<uintptr_t>(column) % 8, 0);
+  }
+}
+
+TEST_F(SyntaxTreeBinaryTest, RejectsInvalidInput) {
+  auto exported = Export(data_);
+  const absl::string_view bytes = AsBytes(exported);
+
+  EXPECT_THAT(SyntaxTreeBinaryView::Create("VCS").status().message(),
+              HasSubstr("Not a syntax tree"));
+  EXPECT_THAT(SyntaxTreeBinaryView::Create(bytes.substr(0, 20))
+                  .status()
+                  .message(),
+              HasSubstr("Truncated"));
+  EXPECT_THAT(SyntaxTreeBinaryView::Create(bytes.substr(0, bytes.size() - 1))
+                  .status()
+                  .message(),
+              HasSubstr("Invalid section"));
+
+  // Unknown version.
+  std::string copy(bytes);
+  copy[4] = 2;
+  std::vector<uint64_t> aligned(copy.size() / 8 + 1);
+  std::memcpy(aligned.data(), copy.data(), copy.size());
+  EXPECT_THAT(
+      SyntaxTreeBinaryView::Create(
+          {reinterpret_cast<const char*>(aligned.data()), copy.size()})
+          .status()
+          .message(),
+      HasSubstr("version 2"));
+
+  // Misaligned.
+  std::vector<uint64_t> shifted(aligned.size() + 1);
+  char* const shifted_bytes = reinterpret_cast<char*>(shifted.data()) + 1;
+  std::memcpy(shifted_bytes, bytes.data(), bytes.size());
+  EXPECT_THAT(SyntaxTreeBinaryView::Create({shifted_bytes, bytes.size()})
+                  .status()
+                  .message(),
+              HasSubstr("aligned"));
+}
+
+TEST(SyntaxTreeBinaryRestoreTest, RoundTrip) {
+  TextStructureView data("hello, world");
+  const absl::string_view text = data.Contents();
+  TokenSequence& tokens = data.MutableTokenStream();
+  tokens.push_back(TokenInfo(1, text.substr(0, 5)));  // "hello"
+  tokens.push_back(TokenInfo(2, text.substr(5, 1)));  // ","
+  tokens.push_back(TokenInfo(3, text.substr(6, 1)));  // " "
+  tokens.push_back(TokenInfo(4, text.substr(7, 5)));  // "world"
+  data.MutableTokenStreamView().push_back(tokens.begin());
+  data.MutableTokenStreamView().push_back(tokens.begin() + 3);
+  data.MutableSyntaxTree() =
+      TNode(7, Leaf(tokens[0]), nullptr, TNode(6),
+            TNode(5, Leaf(tokens[1]), Leaf(tokens[3])));
+  const auto exported = Export(data);
+  const auto view_or = SyntaxTreeBinaryView::Create(AsBytes(exported));
+  ASSERT_TRUE(view_or.ok()) << view_or.status().message();
+  EXPECT_TRUE(view_or->AllTokensInText());
+
+  TextStructureView restored("hello, world");
+  ASSERT_TRUE(RestoreSyntaxTreeBinary(*view_or, &restored).ok());
+  EXPECT_EQ(restored.TokenStream(), data.TokenStream());
+  ASSERT_EQ(restored.GetTokenStreamView().size(), 2);
+  EXPECT_EQ(restored.GetTokenStreamView()[0], restored.TokenStream().begin());
+  EXPECT_EQ(restored.GetTokenStreamView()[1],
+            restored.TokenStream().begin() + 3);
+  // Tokens and leaves refer to the restored text.
+  EXPECT_EQ(restored.TokenStream()[3].text().data(),
+            restored.Contents().data() + 7);
+  const auto exported_again = Export(restored);
+  EXPECT_EQ(AsBytes(exported_again), AsBytes(exported));
+}
+
+TEST_F(SyntaxTreeBinaryTest, RestoreRejectsInvalidInput) {
+  const auto exported = Export(data_);
+  const auto view_or = SyntaxTreeBinaryView::Create(AsBytes(exported));
+  ASSERT_TRUE(view_or.ok());
+  // Leaves from macro expansions are not part of the text.
+  EXPECT_FALSE(view_or->AllTokensInText());
+  {
+    TextStructureView restored("hello, world");
+    EXPECT_THAT(RestoreSyntaxTreeBinary(*view_or, &restored).message(),
+                HasSubstr("not part of its text"));
+  }
+  {
+    TextStructureView restored("hello, earth");
+    EXPECT_THAT(RestoreSyntaxTreeBinary(*view_or, &restored).message(),
+                HasSubstr("different text"));
+  }
+}
+
+}  // namespace
+}  // namespace verible
@@ -0,0 +1,65 @@
+// Copyright 2017-2023 The Verible Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "common/text/syntax_tree_index.h"
+
+#include <algorithm>
+#include <vector>
+
+#include "absl/types/span.h"
+#include "common/text/flat_syntax_tree.h"
+#include "common/text/symbol.h"
+
+namespace verible {
+
+// The index that searches use in this thread.
+static thread_local const SyntaxTreeIndex* current_index = nullptr;
+
+SyntaxTreeIndex::SyntaxTreeIndex(const Symbol& root) : tree_(root) {
+  const auto& entries = tree_.Entries();
+  entry_of_symbol_.reserve(entries.size());
+  for (size_t i = 0; i < entries.size(); ++i) {
+    entry_of_symbol_.emplace(entries[i].symbol, i);
+    entries_by_tag_[entries[i].tag].push_back(i);
+  }
+}
+
+int SyntaxTreeIndex::EntryOf(const Symbol& symbol) const {
+  const auto found = entry_of_symbol_.find(&symbol);
+  return found == entry_of_symbol_.end() ? -1 : found->second;
+}
+
+absl::Span<const int> SyntaxTreeIndex::EntriesWithTag(SymbolTag tag,
+                                                      int root) const {
+  const auto found = entries_by_tag_.find(tag);
+  if (found == entries_by_tag_.end()) return {};
+  const std::vector<int>& entries = found->second;
+  // The subtree's entries are [root, root + subtree_size).
+  const int end = root + tree_.Entries()[root].subtree_size;
+  const auto first = std::lower_bound(entries.begin(), entries.end(), root);
+  const auto last = std::lower_bound(first, entries.end(), end);
+  return absl::MakeConstSpan(entries.data() + (first - entries.begin()),
+                             last - first);
+}
+
+SyntaxTreeIndex::Scope::Scope(const SyntaxTreeIndex* index)
+    : previous_(current_index) {
+  current_index = index;
+}
+
+SyntaxTreeIndex::Scope::~Scope() { current_index = previous_; }
+
+const SyntaxTreeIndex* SyntaxTreeIndex::Current() { return current_index; }
+
+}  // namespace verible
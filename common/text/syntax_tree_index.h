@@ -0,0 +1,85 @@
+// Copyright 2017-2023 The Verible Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef VERIBLE_COMMON_TEXT_SYNTAX_TREE_INDEX_H_
+#define VERIBLE_COMMON_TEXT_SYNTAX_TREE_INDEX_H_
+
+#include <vector>
+
+#include "absl/container/flat_hash_map.h"
+#include "absl/types/span.h"
+#include "common/text/flat_syntax_tree.h"
+#include "common/text/symbol.h"
+
+namespace verible {
+
+// SyntaxTreeIndex maps the tags of a syntax tree's symbols to where they
+// occur, so that searches for symbols of a given tag, in the whole tree or
+// in any of its subtrees, take time proportional to the number of matches
+// instead of the size of the (sub)tree.
+//
+// Build it once per tree, for code that searches the same tree many times,
+// like the symbol table builder and the Kythe facts extractor.  While a Scope
+// is active, SearchSyntaxTree() (and so the FindAll*() functions built on it)
+// answers queries within the indexed tree from the index.
+//
+// The indexed tree must outlive this object, and must not be modified.
+class SyntaxTreeIndex {
+ public:
+  explicit SyntaxTreeIndex(const Symbol& root);
+
+  SyntaxTreeIndex(const SyntaxTreeIndex&) = delete;
+  SyntaxTreeIndex& operator=(const SyntaxTreeIndex&) = delete;
+
+  const FlatSyntaxTree& Tree() const { return tree_; }
+
+  // Returns the index of the entry of 'symbol' in Tree().Entries(), or -1 if
+  // it is not part of the indexed tree.
+  int EntryOf(const Symbol& symbol) const;
+
+  // Returns the indices of the entries tagged 'tag' in the subtree of entry
+  // 'root' (including itself), in preorder.
+  absl::Span<const int> EntriesWithTag(SymbolTag tag, int root = 0) const;
+
+  // Makes 'index' the one that is used for searches in the current thread,
+  // for the lifetime of this object.  Scopes can be nested.
+  class Scope {
+   public:
+    explicit Scope(const SyntaxTreeIndex* index);
+
+    Scope(const Scope&) = delete;
+    Scope& operator=(const Scope&) = delete;
+
+    ~Scope();
+
+   private:
+    const SyntaxTreeIndex* const previous_;
+  };
+
+  // Returns the index that is active in the current thread, or nullptr.
+  static const SyntaxTreeIndex* Current();
+
+ private:
+  const FlatSyntaxTree tree_;
+
+  // Indices of entries, by symbol.
+  absl::flat_hash_map<const Symbol*, int> entry_of_symbol_;
+
+  // Indices of entries in preorder, by tag.
+  absl::flat_hash_map<SymbolTag, std::vector<int>> entries_by_tag_;
+};
+
+}  // namespace verible
+
+#endif  // VERIBLE_COMMON_TEXT_SYNTAX_TREE_INDEX_H_
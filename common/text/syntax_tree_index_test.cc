@@ -0,0 +1,93 @@
+// Copyright 2017-2023 The Verible Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "common/text/syntax_tree_index.h"
+
+#include <vector>
+
+#include "common/text/symbol.h"
+#include "common/text/tree_builder_test_util.h"
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+
+namespace verible {
+namespace {
+
+using testing::ElementsAre;
+using testing::IsEmpty;
+
+// Entries in preorder:
+// 0: node 1
+// 1:   node 3
+// 2:   node 2
+// 3:     node 3
+// 4:     leaf 3
+// 5:   node 3
+// 6:     node 2
+SymbolPtr MakeTestTree() {
+  return TNode(1, TNode(3), TNode(2, TNode(3), nullptr, XLeaf(3)),
+               TNode(3, TNode(2)));
+}
+
+TEST(SyntaxTreeIndexTest, EntryOf) {
+  const SymbolPtr tree = MakeTestTree();
+  const SyntaxTreeIndex index(*tree);
+  for (size_t i = 0; i < index.Tree().Entries().size(); ++i) {
+    EXPECT_EQ(index.EntryOf(*index.Tree().Entries()[i].symbol),
+              static_cast<int>(i));
+  }
+  const SymbolPtr other_tree = TNode(1);
+  EXPECT_EQ(index.EntryOf(*other_tree), -1);
+}
+
+TEST(SyntaxTreeIndexTest, EntriesWithTag) {
+  const SymbolPtr tree = MakeTestTree();
+  const SyntaxTreeIndex index(*tree);
+  EXPECT_THAT(index.EntriesWithTag(NodeTag(3)), ElementsAre(1, 3, 5));
+  EXPECT_THAT(index.EntriesWithTag(NodeTag(2)), ElementsAre(2, 6));
+  EXPECT_THAT(index.EntriesWithTag(LeafTag(3)), ElementsAre(4));
+  EXPECT_THAT(index.EntriesWithTag(NodeTag(1)), ElementsAre(0));
+  EXPECT_THAT(index.EntriesWithTag(NodeTag(4)), IsEmpty());
+}
+
+TEST(SyntaxTreeIndexTest, EntriesWithTagInSubtree) {
+  const SymbolPtr tree = MakeTestTree();
+  const SyntaxTreeIndex index(*tree);
+  EXPECT_THAT(index.EntriesWithTag(NodeTag(3), 2), ElementsAre(3));
+  EXPECT_THAT(index.EntriesWithTag(NodeTag(2), 2), ElementsAre(2));
+  EXPECT_THAT(index.EntriesWithTag(NodeTag(3), 5), ElementsAre(5));
+  EXPECT_THAT(index.EntriesWithTag(NodeTag(2), 5), ElementsAre(6));
+  EXPECT_THAT(index.EntriesWithTag(NodeTag(3), 3), ElementsAre(3));
+  EXPECT_THAT(index.EntriesWithTag(NodeTag(3), 4), IsEmpty());
+}
+
+TEST(SyntaxTreeIndexTest, Scopes) {
+  const SymbolPtr tree = MakeTestTree();
+  const SyntaxTreeIndex index(*tree);
+  const SyntaxTreeIndex other_index(*tree);
+  EXPECT_EQ(SyntaxTreeIndex::Current(), nullptr);
+  {
+    const SyntaxTreeIndex::Scope scope(&index);
+    EXPECT_EQ(SyntaxTreeIndex::Current(), &index);
+    {
+      const SyntaxTreeIndex::Scope inner_scope(&other_index);
+      EXPECT_EQ(SyntaxTreeIndex::Current(), &other_index);
+    }
+    EXPECT_EQ(SyntaxTreeIndex::Current(), &index);
+  }
+  EXPECT_EQ(SyntaxTreeIndex::Current(), nullptr);
+}
+
+}  // namespace
+}  // namespace verible
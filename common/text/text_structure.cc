@@ -18,8 +18,10 @@
 
 #include <algorithm>
 #include <cstddef>
+#include <functional>
 #include <iterator>
 #include <memory>
+#include <mutex>
 #include <sstream>  // IWYU pragma: keep  // for ostringstream
 #include <string>
 #include <utility>
@@ -27,7 +29,6 @@
 
 #include "absl/status/status.h"
 #include "absl/strings/str_cat.h"
-#include "absl/strings/str_split.h"
 #include "absl/strings/string_view.h"
 #include "common/strings/line_column_map.h"
 #include "common/text/concrete_syntax_leaf.h"
@@ -63,7 +64,9 @@ TextStructureView::~TextStructureView() {
 
 void TextStructureView::Clear() {
   syntax_tree_ = nullptr;
-  lazy_lines_info_.valid = false;
+  has_token_references_ = false;
+  lazy_lines_info_.Clear();
+  lazy_utf16_column_map_.reset();
   lazy_line_token_map_.clear();
   tokens_view_.clear();
   tokens_.clear();
@@ -91,6 +94,7 @@ std::vector<typename V::iterator> CopyWriteableIterators(
 }
 
 TokenStreamReferenceView TextStructureView::MakeTokenStreamReferenceView() {
+  OwnReferencedTokens();
   return CopyWriteableIterators(tokens_, tokens_view_);
 }
 
@@ -131,18 +135,54 @@ TokenRange TextStructureView::TokenRangeSpanningOffsets(size_t lower,
 
 LineColumnRange TextStructureView::GetRangeForToken(
     const TokenInfo& token) const {
+  LineColumnCursor cursor(GetLineColumnMap());
+  return GetRangeForToken(token, &cursor);
+}
+
+LineColumnRange TextStructureView::GetRangeForToken(
+    const TokenInfo& token, LineColumnCursor* cursor) const {
   if (token.isEOF()) {
     // In particular some unit tests pass in an artificial EOF token, not a
     // EOF token generated from this view. So handle this directly.
-    const LineColumn eofPos = GetLineColAtOffset(Contents().length());
+    const LineColumn eofPos =
+        cursor->GetLineColAtOffset(Contents(), Contents().length());
     return {eofPos, eofPos};
   }
   // TODO(hzeller): This should simply be GetRangeForText(token.text()),
   // but the more thorough error checking in GetRangeForText()
   // exposes a token overrun in verilog_analyzer_test.cc
   // Defer to fix in separate change.
-  return {GetLineColAtOffset(token.left(Contents())),
-          GetLineColAtOffset(token.right(Contents()))};
+  return {cursor->GetLineColAtOffset(Contents(), token.left(Contents())),
+          cursor->GetLineColAtOffset(Contents(), token.right(Contents()))};
+}
+
+const Utf16ColumnMap& TextStructureView::GetUtf16ColumnMap() const {
+  const std::lock_guard<std::mutex> l(utf16_column_map_lock_);
+  if (!lazy_utf16_column_map_) {
+    lazy_utf16_column_map_ = std::make_unique<Utf16ColumnMap>(contents_);
+  }
+  return *lazy_utf16_column_map_;
+}
+
+LineColumnRange TextStructureView::GetUtf16RangeForToken(
+    const TokenInfo& token) const {
+  const Utf16ColumnMap& map = GetUtf16ColumnMap();
+  if (token.isEOF()) {  // As in GetRangeForToken().
+    const LineColumn eofPos = map.GetLineColAtOffset(Contents().length());
+    return {eofPos, eofPos};
+  }
+  return {map.GetLineColAtOffset(token.left(Contents())),
+          map.GetLineColAtOffset(token.right(Contents()))};
+}
+
+LineColumnRange TextStructureView::GetUtf16RangeForText(
+    absl::string_view text) const {
+  const int from = std::distance(Contents().begin(), text.begin());
+  const int to = std::distance(Contents().begin(), text.end());
+  CHECK_GE(from, 0) << '"' << text << '"';
+  CHECK_LE(to, static_cast<int>(Contents().length())) << '"' << text << '"';
+  const Utf16ColumnMap& map = GetUtf16ColumnMap();
+  return {map.GetLineColAtOffset(from), map.GetLineColAtOffset(to)};
 }
 
 LineColumnRange TextStructureView::GetRangeForText(
@@ -165,8 +205,9 @@ TokenRange TextStructureView::TokenRangeOnLine(size_t lineno) const {
 TokenInfo TextStructureView::FindTokenAt(const LineColumn& pos) const {
   if (pos.line < 0 || pos.column < 0) return EOFToken();
   // Maybe do binary search here if we have a huge amount tokens per line.
+  LineColumnCursor cursor(GetLineColumnMap());
   for (const TokenInfo& token : TokenRangeOnLine(pos.line)) {
-    if (GetRangeForToken(token).PositionInRange(pos)) return token;
+    if (GetRangeForToken(token, &cursor).PositionInRange(pos)) return token;
   }
   return EOFToken();
 }
@@ -191,6 +232,7 @@ static void TerminateTokenStream(TokenSequence* tokens) {
 void TextStructureView::FocusOnSubtreeSpanningSubstring(int left_offset,
                                                         int length) {
   VLOG(2) << __FUNCTION__ << " at " << left_offset << " +" << length;
+  OwnReferencedTokens();
   const int right_offset = left_offset + length;
   TrimSyntaxTree(left_offset, right_offset);
 
@@ -202,7 +244,8 @@ void TextStructureView::FocusOnSubtreeSpanningSubstring(int left_offset,
   }
   TrimTokensToSubstring(left_offset, right_offset);
   TrimContents(left_offset, length);
-  lazy_lines_info_.valid = false;
+  lazy_lines_info_.Clear();
+  lazy_utf16_column_map_.reset();
   CalculateFirstTokensPerLine();
   const absl::Status status = InternalConsistencyCheck();
   CHECK(status.ok())
@@ -284,15 +327,34 @@ void TextStructureView::TrimContents(int left_offset, int length) {
   contents_ = contents_.substr(left_offset, length);
 }
 
-const TextStructureView::LinesInfo& TextStructureView::LinesInfo::Get(
+const LineColumnMap& TextStructureView::LinesInfo::GetLineColumnMap(
     absl::string_view contents) {
-  if (valid) return *this;
+  if (line_column_map == nullptr) {
+    line_column_map = std::make_unique<LineColumnMap>(contents);
+  }
+  return *line_column_map;
+}
 
-  lines = absl::StrSplit(contents, '\n');
-  line_column_map.reset(new LineColumnMap(lines));
-  valid = true;
+const std::vector<absl::string_view>& TextStructureView::LinesInfo::GetLines(
+    absl::string_view contents) {
+  if (lines_valid) return lines;
+  // Same as splitting on '\n', without searching the text again.
+  const std::vector<int>& offsets =
+      GetLineColumnMap(contents).GetBeginningOfLineOffsets();
+  lines.reserve(offsets.size());
+  for (size_t i = 0; i < offsets.size(); ++i) {
+    const size_t end =
+        i + 1 < offsets.size() ? offsets[i + 1] - 1 : contents.length();
+    lines.push_back(contents.substr(offsets[i], end - offsets[i]));
+  }
+  lines_valid = true;
+  return lines;
+}
 
-  return *this;
+void TextStructureView::LinesInfo::Clear() {
+  line_column_map.reset();
+  lines_valid = false;
+  std::vector<absl::string_view>().swap(lines);
 }
 
 void TextStructureView::RebaseTokensToSuperstring(absl::string_view superstring,
@@ -305,7 +367,8 @@ void TextStructureView::RebaseTokensToSuperstring(absl::string_view superstring,
   });
   // Assigning superstring for the sake of maintaining range invariants.
   contents_ = superstring;
-  lazy_lines_info_.valid = false;
+  lazy_lines_info_.Clear();
+  lazy_utf16_column_map_.reset();
 }
 
 void TextStructureView::MutateTokens(const LeafMutator& mutator) {
@@ -314,11 +377,103 @@ void TextStructureView::MutateTokens(const LeafMutator& mutator) {
   }
   // No need to touch tokens_view_, all transformations are in-place.
 
-  if (syntax_tree_ != nullptr) {
+  if (syntax_tree_ == nullptr) return;
+  if (!has_token_references_) {
     // The tokens at the leaves of the tree are their own copies, and thus
     // need to re-apply the same transformation.
     MutateLeaves(&syntax_tree_, mutator);
+    return;
+  }
+  // Leaves that refer to tokens_ are up to date already.
+  const std::less<const TokenInfo*> less;
+  const TokenInfo* const begin = tokens_.data();
+  const TokenInfo* const end = begin + tokens_.size();
+  MutateLeaves(&syntax_tree_, [&](TokenInfo* token) {
+    if (less(token, begin) || !less(token, end)) mutator(token);
+  });
+}
+
+// Returns true if both tokens have the same enum and the same range of text.
+static bool IdenticalTokens(const TokenInfo& left, const TokenInfo& right) {
+  return left.token_enum() == right.token_enum() &&
+         left.text().data() == right.text().data() &&
+         left.text().length() == right.text().length();
+}
+
+// Returns the element of 'tokens' that is identical to 'token', or nullptr.
+// Tokens are sorted by location, and mostly looked up in that order, so
+// 'hint' is checked first, and afterwards points past the found token.
+static TokenInfo* FindIdenticalToken(const TokenInfo& token,
+                                     TokenSequence* tokens,
+                                     TokenSequence::iterator* hint) {
+  auto iter = *hint;
+  if (iter == tokens->end() || !IdenticalTokens(*iter, token)) {
+    const char* const offset = token.text().begin();
+    iter = std::lower_bound(tokens->begin(), tokens->end(), offset,
+                            TokenLocationLess);
+    // Empty tokens can start at the same location as the following one.
+    while (iter != tokens->end() && iter->text().begin() == offset &&
+           !IdenticalTokens(*iter, token)) {
+      ++iter;
+    }
+    if (iter == tokens->end() || !IdenticalTokens(*iter, token)) {
+      return nullptr;
+    }
+  }
+  *hint = iter + 1;
+  return &*iter;
+}
+
+// Returns a copy of 'symbol' whose leaves refer to the identical elements of
+// 'tokens' where possible.
+static SymbolPtr CopyWithTokenReferences(const Symbol* symbol,
+                                         TokenSequence* tokens,
+                                         TokenSequence::iterator* hint) {
+  if (symbol == nullptr) return nullptr;
+  if (symbol->Kind() == SymbolKind::kLeaf) {
+    const TokenInfo& token = SymbolCastToLeaf(*symbol).get();
+    if (TokenInfo* referenced = FindIdenticalToken(token, tokens, hint)) {
+      return std::make_unique<TokenReferenceLeaf>(referenced);
+    }
+    return std::make_unique<OwnedTokenLeaf>(token);
   }
+  const SyntaxTreeNode& node = SymbolCastToNode(*symbol);
+  auto copy = std::make_unique<SyntaxTreeNode>(node.Tag().tag);
+  copy->mutable_children().reserve(node.children().size());
+  for (const auto& child : node.children()) {
+    copy->AppendChild(CopyWithTokenReferences(child.get(), tokens, hint));
+  }
+  return copy;
+}
+
+void TextStructureView::CompactSyntaxTree() {
+  if (syntax_tree_ == nullptr) return;
+  // The whole tree is copied, rather than replacing the leaves in place, so
+  // that the memory of the original tree can be released altogether.
+  auto hint = tokens_.begin();
+  syntax_tree_ = CopyWithTokenReferences(syntax_tree_.get(), &tokens_, &hint);
+  has_token_references_ = true;
+}
+
+// Replaces the leaves under 'symbol' that refer to tokens by copies.
+static void OwnReferencedTokensInTree(SymbolPtr* symbol) {
+  if (*symbol == nullptr) return;
+  if ((*symbol)->Kind() == SymbolKind::kLeaf) {
+    const auto& leaf = SymbolCastToLeaf(**symbol);
+    if (leaf.IsTokenReference()) {
+      *symbol = std::make_unique<OwnedTokenLeaf>(leaf.get());
+    }
+    return;
+  }
+  for (auto& child : SymbolCastToNode(**symbol).mutable_children()) {
+    OwnReferencedTokensInTree(&child);
+  }
+}
+
+void TextStructureView::OwnReferencedTokens() {
+  if (!has_token_references_) return;
+  has_token_references_ = false;
+  OwnReferencedTokensInTree(&syntax_tree_);
 }
 
 // Find the last non-EOF token.  Usually searches at most 2 tokens.
@@ -386,7 +541,10 @@ absl::Status TextStructureView::FastTokenRangeConsistencyCheck() const {
 
 absl::Status TextStructureView::FastLineRangeConsistencyCheck() const {
   VLOG(2) << __FUNCTION__;
-  const auto& lines = Lines();
+  // Lines are only checked if they were split already: splitting them here
+  // would do so for every TextStructureView, whether it needs them or not.
+  if (!lazy_lines_info_.lines_valid) return absl::OkStatus();
+  const auto& lines = lazy_lines_info_.lines;
   if (!lines.empty()) {
     if (lines.front().cbegin() != contents_.cbegin()) {
       return absl::InternalError(
@@ -481,6 +639,7 @@ void TextStructureView::ConsumeDeferredExpansion(
   // into the original text (contents_).
   std::unique_ptr<TextStructure>& subanalysis = expansion->subanalysis;
   TextStructureView& sub_data = ABSL_DIE_IF_NULL(subanalysis)->MutableData();
+  sub_data.OwnReferencedTokens();
   const absl::string_view sub_data_text(sub_data.Contents());
   CHECK(!IsSubRange(sub_data_text, contents_));
   CHECK_EQ(sub_data_text, absl::string_view(offset, sub_data_text.length()));
@@ -522,6 +681,7 @@ TextStructure::~TextStructure() {
 }
 
 void TextStructureView::ExpandSubtrees(NodeExpansionMap* expansions) {
+  OwnReferencedTokens();
   TokenSequence combined_tokens;
   // Gather indices and reconstruct iterators after there are no more
   // reallocations due to growing combined_tokens.
@@ -29,6 +29,7 @@
 #include <cstddef>
 #include <map>
 #include <memory>
+#include <mutex>
 #include <string>
 #include <vector>
 
@@ -38,6 +39,7 @@
 #include "common/strings/mem_block.h"
 #include "common/text/concrete_syntax_tree.h"
 #include "common/text/symbol.h"
+#include "common/text/syntax_tree_arena.h"
 #include "common/text/token_stream_view.h"
 #include "common/text/tree_utils.h"
 
@@ -83,17 +85,26 @@ class TextStructureView {
 
   absl::string_view Contents() const { return contents_; }
 
+  // Line-by-line view of Contents(), split on first use.  Only what needs
+  // the lines as text should ask for them: line numbers and offsets come
+  // from GetLineColumnMap(), which is much smaller.
   const std::vector<absl::string_view>& Lines() const {
-    return lazy_lines_info_.Get(contents_).lines;
+    return lazy_lines_info_.GetLines(contents_);
   }
 
   const ConcreteSyntaxTree& SyntaxTree() const { return syntax_tree_; }
 
-  ConcreteSyntaxTree& MutableSyntaxTree() { return syntax_tree_; }
+  ConcreteSyntaxTree& MutableSyntaxTree() {
+    OwnReferencedTokens();
+    return syntax_tree_;
+  }
 
   const TokenSequence& TokenStream() const { return tokens_; }
 
-  TokenSequence& MutableTokenStream() { return tokens_; }
+  TokenSequence& MutableTokenStream() {
+    OwnReferencedTokens();
+    return tokens_;
+  }
 
   const TokenStreamView& GetTokenStreamView() const { return tokens_view_; }
 
@@ -104,7 +115,7 @@ class TextStructureView {
   TokenStreamReferenceView MakeTokenStreamReferenceView();
 
   const LineColumnMap& GetLineColumnMap() const {
-    return *lazy_lines_info_.Get(contents_).line_column_map;
+    return lazy_lines_info_.GetLineColumnMap(contents_);
   }
 
   // Given a byte offset, return the line/column
@@ -115,10 +126,26 @@ class TextStructureView {
   // Convenience function: Given the token, return the range it covers.
   LineColumnRange GetRangeForToken(const TokenInfo& token) const;
 
+  // Same, but looked up with 'cursor', which must be a cursor over
+  // GetLineColumnMap().  Callers that visit many tokens in order should use
+  // one cursor for all of them.
+  LineColumnRange GetRangeForToken(const TokenInfo& token,
+                                   LineColumnCursor* cursor) const;
+
   // Convenience function: Given a text snippet, that needs to be a substring
   // of Contents(), return the range it covers.
   LineColumnRange GetRangeForText(absl::string_view text) const;
 
+  // Translates byte offsets into the line/columns of the language server
+  // protocol, whose columns count UTF-16 code units, and back.  Unlike the
+  // other lazily created maps, it can be requested from several threads.
+  const Utf16ColumnMap& GetUtf16ColumnMap() const;
+
+  // Same as GetRangeForToken() and GetRangeForText(), but columns count
+  // UTF-16 code units (see GetUtf16ColumnMap()).
+  LineColumnRange GetUtf16RangeForToken(const TokenInfo& token) const;
+  LineColumnRange GetUtf16RangeForText(absl::string_view text) const;
+
   const std::vector<TokenSequence::const_iterator>& GetLineTokenMap() const;
 
   // Given line/column, find token that is available there. If this is out of
@@ -149,6 +176,15 @@ class TextStructureView {
   // that were copied into the syntax tree.
   void MutateTokens(const LeafMutator& mutator);
 
+  // Rebuilds the syntax tree with leaves that refer to the tokens in
+  // TokenStream() instead of holding copies of them, which halves their size.
+  // Leaves whose token is not in TokenStream() keep their copy.  This is
+  // meant for structures that are kept around but no longer modified: the
+  // leaves get copies of their tokens again before the tree or the tokens can
+  // be modified (MutableSyntaxTree(), MutableTokenStream(), etc.).
+  // The new tree is allocated from the active SyntaxTreeArena, if any.
+  void CompactSyntaxTree();
+
   // Update tokens to point their text into new (superstring) owner.
   // This is done to prepare for transfer of ownership of syntax_tree_
   // to a new owner.
@@ -180,20 +216,27 @@ class TextStructureView {
 
   // TODO(hzeller): These lazily generated elements are good candidates
   // for breaking out into their own abstraction.
+  // Both are created independently, as most users only need the offsets.
   struct LinesInfo {
-    bool valid = false;
+    // Map to translate byte-offsets to line and column for diagnostics.
+    std::unique_ptr<LineColumnMap> line_column_map;
 
-    // Line-by-line view of contents_.
+    // Line-by-line view of contents_, derived from line_column_map.
+    bool lines_valid = false;
     std::vector<absl::string_view> lines;
 
-    // Map to translate byte-offsets to line and column for diagnostics.
-    std::unique_ptr<LineColumnMap> line_column_map;
+    const LineColumnMap& GetLineColumnMap(absl::string_view contents);
+    const std::vector<absl::string_view>& GetLines(absl::string_view contents);
 
-    const LinesInfo& Get(absl::string_view contents);
+    // Releases both, to be created again for new contents.
+    void Clear();
   };
   // Mutable as we fill it lazily on request; conceptually the data is const.
   mutable LinesInfo lazy_lines_info_;
 
+  mutable std::mutex utf16_column_map_lock_;  // Guards the following.
+  mutable std::unique_ptr<Utf16ColumnMap> lazy_utf16_column_map_;
+
   // Tokens that constitute the original file (contents_).
   // This should always be terminated with a sentinel EOF token.
   TokenSequence tokens_;
@@ -208,6 +251,13 @@ class TextStructureView {
   // Tree representation of file contents.
   ConcreteSyntaxTree syntax_tree_;
 
+  // True if leaves of syntax_tree_ refer to elements of tokens_.
+  bool has_token_references_ = false;
+
+  // Gives all leaves that refer to elements of tokens_ their own copy, before
+  // tokens_ or syntax_tree_ are modified.
+  void OwnReferencedTokens();
+
   void TrimSyntaxTree(int first_token_offset, int last_token_offset);
 
   void TrimTokensToSubstring(int left_offset, int right_offset);
@@ -228,8 +278,8 @@ class TextStructureView {
   // contents_ string view.
   absl::Status FastTokenRangeConsistencyCheck() const;
 
-  // Verify that line-based view of contents_ is consistent with the
-  // contents_ text itself.
+  // Verify that line-based view of contents_, if it was split already, is
+  // consistent with the contents_ text itself.
   absl::Status FastLineRangeConsistencyCheck() const;
 
   // Verify that the string views in the syntax tree are contained within
@@ -298,6 +348,9 @@ class TextStructure {
   // the details. https://github.com/chipsalliance/verible/issues/1502 )
   std::shared_ptr<MemBlock> contents_;
 
+  // Storage of the syntax tree nodes created by parsing the contents.
+  SyntaxTreeArena syntax_tree_arena_;
+
   // The data_ object's string_views are owned by owned_contents_.
   TextStructureView data_;
 };
@@ -15,6 +15,7 @@
 #include "common/text/text_structure.h"
 
 #include <cstddef>
+#include <initializer_list>
 #include <iterator>
 #include <map>
 #include <memory>
@@ -24,8 +25,10 @@
 
 #include "absl/memory/memory.h"
 #include "absl/status/status.h"
+#include "absl/strings/str_split.h"
 #include "absl/strings/string_view.h"
 #include "common/strings/line_column_map.h"
+#include "common/text/concrete_syntax_leaf.h"
 #include "common/text/concrete_syntax_tree.h"
 #include "common/text/symbol.h"
 #include "common/text/text_structure_test_utils.h"
@@ -33,6 +36,7 @@
 #include "common/text/token_stream_view.h"
 #include "common/text/tree_builder_test_util.h"
 #include "common/text/tree_compare.h"
+#include "common/text/tree_utils.h"
 #include "common/util/iterator_range.h"
 #include "common/util/logging.h"
 #include "common/util/range.h"
@@ -45,6 +49,7 @@
 
 namespace verible {
 
+using ::testing::ElementsAre;
 using ::testing::IsEmpty;
 using ::testing::IsNull;
 using ::testing::SizeIs;
@@ -123,6 +128,63 @@ TEST(MutateTokensTest, EmptyTokensNoOp) {
   EXPECT_THAT(test_view.SyntaxTree(), IsNull());
 }
 
+// Create a syntax tree over the tokens of MultiTokenTextStructureViewNoTree(),
+// with one additional leaf whose token is not in the token stream.
+void MultiTokenTextStructureViewWithTree(TextStructureView* view) {
+  MultiTokenTextStructureViewNoTree(view);
+  const auto& stream = view->TokenStream();
+  view->MutableSyntaxTree() =
+      Node(Leaf(stream[0]), Node(Leaf(stream[1]), nullptr, Leaf(stream[3])),
+           Leaf(9, view->Contents().substr(2, 2)));
+}
+
+const SyntaxTreeLeaf& LeafAt(const TextStructureView& view,
+                             std::initializer_list<size_t> path) {
+  return SymbolCastToLeaf(*DescendPath(*view.SyntaxTree(), path));
+}
+
+TEST(CompactSyntaxTreeTest, LeavesReferToTokens) {
+  TextStructureView test_view("hello");
+  MultiTokenTextStructureViewWithTree(&test_view);
+  const SymbolPtr expected =
+      Node(Leaf(1, "h"), Node(Leaf(2, "e"), nullptr, Leaf(4, "l")),
+           Leaf(9, "ll"));
+  test_view.CompactSyntaxTree();
+  EXPECT_TRUE(EqualTreesByEnumString(test_view.SyntaxTree().get(),
+                                     expected.get()));
+  const auto& stream = test_view.TokenStream();
+  EXPECT_EQ(&LeafAt(test_view, {0}).get(), &stream[0]);
+  EXPECT_EQ(&LeafAt(test_view, {1, 0}).get(), &stream[1]);
+  EXPECT_EQ(&LeafAt(test_view, {1, 2}).get(), &stream[3]);
+  EXPECT_FALSE(LeafAt(test_view, {2}).IsTokenReference());
+  EXPECT_OK(test_view.InternalConsistencyCheck());
+}
+
+TEST(CompactSyntaxTreeTest, MutateTokensOnce) {
+  TextStructureView test_view("hello");
+  MultiTokenTextStructureViewWithTree(&test_view);
+  test_view.CompactSyntaxTree();
+  test_view.MutateTokens(
+      [](TokenInfo* token) { token->set_token_enum(token->token_enum() + 10); });
+  EXPECT_EQ(LeafAt(test_view, {0}).get().token_enum(), 11);
+  EXPECT_EQ(LeafAt(test_view, {1, 2}).get().token_enum(), 14);
+  EXPECT_EQ(LeafAt(test_view, {2}).get().token_enum(), 19);
+}
+
+TEST(CompactSyntaxTreeTest, MutableAccessCopiesTokens) {
+  TextStructureView test_view("hello");
+  MultiTokenTextStructureViewWithTree(&test_view);
+  test_view.CompactSyntaxTree();
+  EXPECT_TRUE(LeafAt(test_view, {0}).IsTokenReference());
+  test_view.MutableSyntaxTree();
+  EXPECT_FALSE(LeafAt(test_view, {0}).IsTokenReference());
+  EXPECT_FALSE(LeafAt(test_view, {1, 0}).IsTokenReference());
+  EXPECT_EQ(LeafAt(test_view, {1, 0}).get(), test_view.TokenStream()[1]);
+  // Tokens can be changed without affecting the tree.
+  test_view.MutableTokenStream()[1].set_token_enum(7);
+  EXPECT_EQ(LeafAt(test_view, {1, 0}).get().token_enum(), 2);
+}
+
 // Test that a copy of writeable iterators to tokens matches const iterators.
 TEST(TokenStreamReferenceViewTest, ShiftRight) {
   TextStructureView test_view("hello");
@@ -245,6 +307,42 @@ TEST_F(TokenRangeTest, GetRangeForTokenOrText) {
   }
 }
 
+TEST_F(TokenRangeTest, GetUtf16RangeForAsciiIsByteRange) {
+  for (const TokenInfo& token : data_.TokenStream()) {
+    EXPECT_EQ(data_.GetUtf16RangeForToken(token),
+              data_.GetRangeForToken(token));
+  }
+  EXPECT_EQ(data_.GetUtf16RangeForToken(TokenInfo::EOFToken()),
+            data_.GetRangeForToken(TokenInfo::EOFToken()));
+  EXPECT_EQ(data_.GetUtf16RangeForText(data_.Contents()),
+            data_.GetRangeForText(data_.Contents()));
+}
+
+// Columns count UTF-16 code units: two for characters beyond the BMP.
+class Utf16TokenRangeTest : public ::testing::Test,
+                            public TextStructureTokenized {
+ public:
+  Utf16TokenRangeTest()
+      : TextStructureTokenized({{TokenInfo(3, "\xc3\xa4"), TokenInfo(2, " "),
+                                 TokenInfo(3, "\xf0\x9f\x98\x80"),
+                                 TokenInfo(3, "x"), TokenInfo(4, "\n")}}) {}
+};
+
+TEST_F(Utf16TokenRangeTest, GetUtf16RangeForToken) {
+  const auto& tokens = data_.TokenStream();
+  EXPECT_EQ(data_.GetUtf16RangeForToken(tokens[0]),
+            (LineColumnRange{{0, 0}, {0, 1}}));
+  EXPECT_EQ(data_.GetUtf16RangeForToken(tokens[2]),
+            (LineColumnRange{{0, 2}, {0, 4}}));
+  EXPECT_EQ(data_.GetUtf16RangeForText(tokens[3].text()),
+            (LineColumnRange{{0, 4}, {0, 5}}));
+  EXPECT_EQ(data_.GetUtf16RangeForToken(data_.EOFToken()),
+            (LineColumnRange{{1, 0}, {1, 0}}));
+  // Columns of GetRangeForToken() count code points.
+  EXPECT_EQ(data_.GetRangeForToken(tokens[3]),
+            (LineColumnRange{{0, 3}, {0, 4}}));
+}
+
 TEST_F(TokenRangeTest, FindTokenAtPosition) {
   EXPECT_EQ(data_.FindTokenAt({0, 0}).text(), "hello");
   EXPECT_EQ(data_.FindTokenAt({0, 4}).text(), "hello");
@@ -548,6 +646,30 @@ TEST_F(TextStructureViewPublicTest, ExpandSubtreesMultipleLeaves) {
   EXPECT_TRUE(EqualTrees(syntax_tree_.get(), expect_tree.get()));
 }
 
+// Test that lines are only split when requested.
+TEST_F(TextStructureViewInternalsTest, LinesSplitOnRequest) {
+  EXPECT_FALSE(lazy_lines_info_.lines_valid);
+  EXPECT_FALSE(GetLineColumnMap().empty());
+  EXPECT_FALSE(lazy_lines_info_.lines_valid);
+  EXPECT_THAT(Lines(), ElementsAre("hello, world"));
+  EXPECT_TRUE(lazy_lines_info_.lines_valid);
+}
+
+// Test that lines are the same as split on newlines.
+TEST(TextStructureViewLinesTest, SameAsSplitOnNewlines) {
+  for (const absl::string_view text :
+       {"", "\n", "a", "a\n", "a\nbc", "a\n\nbc\n", "\n\n"}) {
+    const TextStructureView view(text);
+    const std::vector<absl::string_view> expected = absl::StrSplit(text, '\n');
+    ASSERT_EQ(view.Lines().size(), expected.size()) << '"' << text << '"';
+    for (size_t i = 0; i < expected.size(); ++i) {
+      EXPECT_EQ(view.Lines()[i], expected[i]) << '"' << text << "\" " << i;
+      // Views into the contents, not copies.
+      EXPECT_EQ(view.Lines()[i].data(), expected[i].data());
+    }
+  }
+}
+
 // The following tests intentionally cause internal violations to
 // make sure the consistency checks work as intended.
 // The mutated fields are restored so that the consistency checks
@@ -555,6 +677,7 @@ TEST_F(TextStructureViewPublicTest, ExpandSubtreesMultipleLeaves) {
 
 // Test that FastLineRangeConsistencyCheck catches text mismatch at first line.
 TEST_F(TextStructureViewInternalsTest, LineConsistencyFailsBeginning) {
+  ASSERT_FALSE(Lines().empty());
   const ValueSaver<absl::string_view> save_contents(&contents_);
   contents_ = contents_.substr(1);
   EXPECT_FALSE(FastLineRangeConsistencyCheck().ok());
@@ -563,6 +686,7 @@ TEST_F(TextStructureViewInternalsTest, LineConsistencyFailsBeginning) {
 
 // Test that FastLineRangeConsistencyCheck catches text mismatch at last line.
 TEST_F(TextStructureViewInternalsTest, LineConsistencyFailsEnd) {
+  ASSERT_FALSE(Lines().empty());
   const ValueSaver<absl::string_view> save_contents(&contents_);
   contents_ = contents_.substr(0, contents_.length() - 1);
   EXPECT_FALSE(FastLineRangeConsistencyCheck().ok());
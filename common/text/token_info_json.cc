@@ -17,6 +17,7 @@
 #include <sstream>
 
 #include "common/text/token_info.h"
+#include "common/util/json_writer.h"
 
 namespace verible {
 
@@ -36,4 +37,17 @@ nlohmann::json ToJson(const TokenInfo& token_info,
   return json;
 }
 
+void WriteJson(const TokenInfo& token_info, const TokenInfo::Context& context,
+               bool include_text, JsonWriter* writer) {
+  std::ostringstream stream;
+  context.token_enum_translator(stream, token_info.token_enum());
+  // Same member order as nlohmann::json.
+  writer->BeginObject();
+  writer->Key("end").Value(token_info.right(context.base));
+  writer->Key("start").Value(token_info.left(context.base));
+  writer->Key("tag").Value(stream.str());
+  if (include_text) writer->Key("text").Value(token_info.text());
+  writer->EndObject();
+}
+
 }  // namespace verible
@@ -16,6 +16,7 @@
 #define VERIBLE_COMMON_TEXT_TOKEN_INFO_JSON_H_
 
 #include "common/text/token_info.h"
+#include "common/util/json_writer.h"
 #include "nlohmann/json.hpp"
 
 namespace verible {
@@ -25,6 +26,10 @@ nlohmann::json ToJson(const TokenInfo& token_info,
                       const TokenInfo::Context& context,
                       bool include_text = false);
 
+// Writes the same JSON object as ToJson() to 'writer', without building it.
+void WriteJson(const TokenInfo& token_info, const TokenInfo::Context& context,
+               bool include_text, JsonWriter* writer);
+
 }  // namespace verible
 
 #endif  // VERIBLE_COMMON_TEXT_TOKEN_INFO_JSON_H_
@@ -15,10 +15,12 @@
 #include "common/text/token_info_json.h"
 
 #include <memory>
+#include <sstream>
 
 #include "absl/strings/string_view.h"
 #include "common/text/constants.h"
 #include "common/text/token_info.h"
+#include "common/util/json_writer.h"
 #include "gtest/gtest.h"
 
 namespace verible {
@@ -83,5 +85,19 @@ TEST(TokenInfoToJsonTest, ToJsonWithTokenEnumTranslator) {
   })"));
 }
 
+TEST(TokenInfoToJsonTest, WriteJsonSameAsToJson) {
+  constexpr absl::string_view base("basement \"cat\"\n");
+  const TokenInfo::Context context(
+      base, [](std::ostream& stream, int e) { stream << "token enum " << e; });
+  const TokenInfo token_info(7, base.substr(9, 6));
+
+  for (const bool include_text : {false, true}) {
+    std::ostringstream stream;
+    JsonWriter writer(&stream);
+    WriteJson(token_info, context, include_text, &writer);
+    EXPECT_EQ(stream.str(), ToJson(token_info, context, include_text).dump(2));
+  }
+}
+
 }  // namespace
 }  // namespace verible
@@ -34,6 +34,19 @@ void InitTokenStreamView(const TokenSequence& tokens, TokenStreamView* view) {
   }
 }
 
+void InitTokenStreamView(const TokenSequence& tokens,
+                         const TokenFilterPredicate& keep,
+                         TokenStreamView* view) {
+  view->clear();
+  // Count first, to allocate exactly once.
+  size_t kept = 0;
+  for (const auto& token : tokens) kept += keep(token);
+  view->reserve(kept);
+  for (auto iter = tokens.begin(); iter != tokens.end(); ++iter) {
+    if (keep(*iter)) view->push_back(iter);
+  }
+}
+
 void FilterTokenStreamView(const TokenFilterPredicate& keep,
                            const TokenStreamView& src, TokenStreamView* dest) {
   dest->clear();
@@ -47,9 +60,11 @@ void FilterTokenStreamView(const TokenFilterPredicate& keep,
 
 void FilterTokenStreamViewInPlace(const TokenFilterPredicate& keep,
                                   TokenStreamView* view) {
-  TokenStreamView temp;
-  FilterTokenStreamView(keep, *view, &temp);
-  view->swap(temp);  // old stream view deleted at end-of-scope
+  view->erase(std::remove_if(view->begin(), view->end(),
+                             [&keep](TokenSequence::const_iterator iter) {
+                               return !keep(*iter);
+                             }),
+              view->end());
 }
 
 static bool TokenLocationLess(const TokenSequence::const_iterator& token_iter,
@@ -51,11 +51,19 @@ using TokenFilterPredicate = std::function<bool(const TokenInfo&)>;
 // Populates a TokenStreamView with every iterator of a TokenSequence.
 void InitTokenStreamView(const TokenSequence&, TokenStreamView*);
 
+// Populates a TokenStreamView with the iterators of the tokens that 'keep'
+// accepts.  This is equivalent to InitTokenStreamView() followed by
+// FilterTokenStreamViewInPlace(), without first allocating a view of the whole
+// sequence.
+void InitTokenStreamView(const TokenSequence&, const TokenFilterPredicate& keep,
+                         TokenStreamView*);
+
 // Create a new TokenStreamView with tokens conditionally omitted.
 void FilterTokenStreamView(const TokenFilterPredicate& keep,
                            const TokenStreamView& src, TokenStreamView* dest);
 
 // Remove tokens from a TokenStreamView according to a predicate.
+// This doesn't allocate; the capacity of the view is kept.
 void FilterTokenStreamViewInPlace(const TokenFilterPredicate& keep,
                                   TokenStreamView*);
 
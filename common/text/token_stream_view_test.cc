@@ -68,6 +68,26 @@ TEST_F(TokenStreamViewTest, FilterInPlace) {
   EXPECT_EQ(0, view.back()->token_enum());
 }
 
+TEST_F(TokenStreamViewTest, InitFiltered) {
+  TokenStreamView view;
+  InitTokenStreamView(tokens_, KeepEvenTokens, &view);
+  EXPECT_EQ(6, view.size());
+  EXPECT_EQ(6, view.capacity());
+  EXPECT_EQ(2, view.front()->token_enum());
+  EXPECT_EQ(0, view.back()->token_enum());
+}
+
+TEST_F(TokenStreamViewTest, FilterInPlaceKeepsStorage) {
+  TokenStreamView view;
+  InitTokenStreamView(tokens_, &view);
+  const auto* const storage = view.data();
+  FilterTokenStreamViewInPlace(KeepEvenTokens, &view);
+  EXPECT_EQ(view.data(), storage);
+  for (size_t i = 1; i < view.size(); ++i) {
+    EXPECT_LT(view[i - 1], view[i]);  // order is preserved
+  }
+}
+
 // Helper class for testing Token range methods.
 class TokenViewRangeTest : public ::testing::Test,
                            public TextStructureTokenized {
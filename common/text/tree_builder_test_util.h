@@ -36,7 +36,7 @@ SymbolPtr TNode(Enum e, Args... args) {
 
 template <typename... Args>
 SymbolPtr Leaf(Args&&... args) {
-  return SymbolPtr(new SyntaxTreeLeaf(std::forward<Args>(args)...));
+  return SymbolPtr(new OwnedTokenLeaf(std::forward<Args>(args)...));
 }
 
 // Use this for constructing leaves where you don't care about the token text.
@@ -15,17 +15,24 @@
 #ifndef VERIBLE_COMMON_TEXT_TREE_CONTEXT_VISITOR_H_
 #define VERIBLE_COMMON_TEXT_TREE_CONTEXT_VISITOR_H_
 
+#include <cstddef>
+
+#include "absl/container/inlined_vector.h"
 #include "common/strings/display_utils.h"
 #include "common/text/syntax_tree_context.h"
 #include "common/text/visitors.h"
 
 namespace verible {
 
+// Depth of trees up to which visitors track context and paths without
+// allocating.  Deeper trees are fine, the stacks grow then.
+inline constexpr size_t kReservedSyntaxTreeDepth = 64;
+
 // This visitor traverses a tree and maintains a stack of context
 // that points to all ancestors at any given node.
 class TreeContextVisitor : public SymbolVisitor {
  public:
-  TreeContextVisitor() = default;
+  TreeContextVisitor() { current_context_.reserve(kReservedSyntaxTreeDepth); }
 
  protected:
   void Visit(const SyntaxTreeLeaf& leaf) override {}
@@ -57,11 +64,12 @@ int CompareSyntaxTreePath(const SyntaxTreePath& a, const SyntaxTreePath& b);
 // Negative values are always less than empty and non-negative values, e.g.
 // [-1] < [] < [0].
 //
-// TODO(fangism): consider replacing with hybrid "small" vector to
-// minimize heap allocations, because these are expected to be small.
-class SyntaxTreePath : public std::vector<int> {
+// Paths of up to 12 elements are stored inline, so that the many copies of
+// short paths, e.g. by the alignment scanners, don't allocate.
+class SyntaxTreePath : public absl::InlinedVector<int, 12> {
  public:
-  using std::vector<int>::vector;  // Import base class constructors
+  using base_type = absl::InlinedVector<int, 12>;
+  using base_type::base_type;  // Import base class constructors
 
   bool operator==(const SyntaxTreePath& rhs) const {
     return CompareSyntaxTreePath(*this, rhs) == 0;
@@ -84,7 +92,7 @@ class SyntaxTreePath : public std::vector<int> {
 // within the tree are meaningful.
 class TreeContextPathVisitor : public TreeContextVisitor {
  public:
-  TreeContextPathVisitor() = default;
+  TreeContextPathVisitor() { current_path_.reserve(kReservedSyntaxTreeDepth); }
 
  protected:
   void Visit(const SyntaxTreeNode& node) override;
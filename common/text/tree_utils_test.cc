@@ -1320,17 +1320,17 @@ TEST(SymbolCastToNodeTest, BasicTestMutable) {
 }
 
 TEST(SymbolCastToNodeTest, InvalidInputLeaf) {
-  const SyntaxTreeLeaf leaf_symbol(3, "foo");
+  const OwnedTokenLeaf leaf_symbol(3, "foo");
   EXPECT_DEATH(SymbolCastToNode(leaf_symbol), "");
 }
 
 TEST(SymbolCastToNodeTest, InvalidInputLeafMutable) {
-  SyntaxTreeLeaf leaf_symbol(3, "foo");
+  OwnedTokenLeaf leaf_symbol(3, "foo");
   EXPECT_DEATH(SymbolCastToNode(leaf_symbol), "");
 }
 
 TEST(SymbolCastToLeafTest, BasicTest) {
-  SyntaxTreeLeaf leaf_symbol(3, "foo");
+  OwnedTokenLeaf leaf_symbol(3, "foo");
   const auto& leaf = SymbolCastToLeaf(leaf_symbol);
   CHECK_EQ(leaf.Kind(), SymbolKind::kLeaf);
 }
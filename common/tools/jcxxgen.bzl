@@ -17,7 +17,7 @@
 Rule to generate json-serializable simple structs
 """
 
-def jcxxgen(name, src, out, namespace = ""):
+def jcxxgen(name, src, out, namespace = "", streaming = False):
     """Generate C/C++ language source from a jcxxgen schema file.
 
     Args:
@@ -25,21 +25,32 @@ def jcxxgen(name, src, out, namespace = ""):
       src:  The schema yaml input file.
       out:  Name of the generated header file.
       namespace: Optional name of the C++ namespace for generated structs.
+      streaming: If true, structs can also be written and read without a
+                 nlohmann::json DOM, using //common/lsp:json-events.
     """
     tool = "//common/tools:jcxxgen"
     json_header = '"nlohmann/json.hpp"'
+    streaming_flag = ""
+    streaming_deps = []
+    if streaming:
+        streaming_flag = "--streaming_header='\"common/lsp/json-events.h\"' "
+        streaming_deps = [
+            "//common/lsp:json-events",
+            "//common/util:json_writer",
+            "@com_google_absl//absl/strings",
+        ]
 
     native.genrule(
         name = name + "_gen",
         srcs = [src],
         outs = [out],
         cmd = ("$(location //common/tools:jcxxgen) --json_header='" +
-               json_header + "' --class_namespace " +
+               json_header + "' " + streaming_flag + "--class_namespace " +
                namespace + " --output $@ $<"),
         tools = [tool],
     )
     native.cc_library(
         name = name,
         hdrs = [out],
-        deps = ["@jsonhpp"],
+        deps = ["@jsonhpp"] + streaming_deps,
     )
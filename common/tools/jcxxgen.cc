@@ -13,7 +13,8 @@
 // limitations under the License.
 
 // A simple code generator taking a yaml file and generating nlohmann/json
-// serializable structs.
+// serializable structs.  With --streaming_header, structs are also written
+// and read without a nlohmann::json DOM (see common/lsp/json-events.h).
 
 #include <cstdio>
 #include <fstream>
@@ -36,6 +37,11 @@ ABSL_FLAG(std::string, class_namespace, "",
 ABSL_FLAG(std::string, json_header, "<nlohmann/json.hpp>",
           "Include path to json.hpp including brackets <> or quotes \"\" "
           "around.");
+ABSL_FLAG(std::string, streaming_header, "",
+          "If set, include path to common/lsp/json-events.h, including "
+          "brackets <> or quotes \"\" around. Structs then also get "
+          "SerializeTo() and DeserializeFrom() methods, which write and read "
+          "JSON without going through a nlohmann::json DOM.");
 
 // Interface. Currently private, but could be moved to a header if needed.
 struct Location {
@@ -226,8 +232,90 @@ std::unique_ptr<ObjectTypeVector> LoadObjectTypes(const std::string &filename) {
   return result;
 }
 
+// Appends the properties of "obj" and of all its superclasses, the latter
+// first, to "properties".
+static void CollectAllProperties(const ObjectType &obj,
+                                 std::vector<const Property *> *properties) {
+  for (const ObjectType *s : obj.superclasses) {
+    CollectAllProperties(*s, properties);
+  }
+  for (const auto &p : obj.properties) properties->push_back(&p);
+}
+
+// Generate SerializeTo() and DeserializeFrom(), that write with a JsonWriter
+// and read events of common/lsp/json-events.h.  Properties are written in
+// order of declaration, superclasses first.  As with Deserialize(), unknown
+// properties are ignored and optional properties that are null count as
+// absent.
+static void GenerateStreamingCode(const ObjectType &obj, FILE *out) {
+  std::vector<const Property *> properties;
+  CollectAllProperties(obj, &properties);
+
+  fprintf(out, "  void SerializeTo(::verible::JsonWriter *out) const {\n");
+  fprintf(out, "    out->BeginObject();\n");
+  for (const Property *p : properties) {
+    int indent = 4;
+    if (p->is_optional) {
+      fprintf(out, "%*sif (has_%s) {\n", indent, "", p->name.c_str());
+      indent += 2;
+    }
+    fprintf(out, "%*sout->Key(\"%s\");\n", indent, "", p->name.c_str());
+    std::string value = p->name;
+    if (p->is_array) {
+      fprintf(out, "%*sout->BeginArray();\n", indent, "");
+      fprintf(out, "%*sfor (const auto &e : %s) ", indent, "", p->name.c_str());
+      value = "e";
+    } else {
+      fprintf(out, "%*s", indent, "");
+    }
+    if (p->object_type) {
+      fprintf(out, "%s.SerializeTo(out);\n", value.c_str());
+    } else {
+      fprintf(out, "out->Value(%s);\n", value.c_str());
+    }
+    if (p->is_array) fprintf(out, "%*sout->EndArray();\n", indent, "");
+    if (p->is_optional) fprintf(out, "    }\n");
+  }
+  fprintf(out, "    out->EndObject();\n");
+  fprintf(out, "  }\n");
+
+  fprintf(out,
+          "  bool DeserializeFrom(::verible::lsp::JsonEventReader *in) {\n");
+  fprintf(out, "    if (!in->BeginObject()) return false;\n");
+  for (const Property *p : properties) {
+    if (!p->is_optional) {
+      fprintf(out, "    bool seen_%s = false;\n", p->name.c_str());
+    }
+  }
+  fprintf(out, "    absl::string_view key;\n");
+  fprintf(out, "    while (in->NextKey(&key)) {\n");
+  fprintf(out, "      ");
+  for (const Property *p : properties) {
+    fprintf(out, "if (key == \"%s\") {\n", p->name.c_str());
+    if (p->is_optional) {
+      fprintf(out, "        if (in->ReadNull()) continue;\n");
+    }
+    fprintf(out, "        if (!in->Read(&%s)) return false;\n",
+            p->name.c_str());
+    fprintf(out, "        %s_%s = true;\n", p->is_optional ? "has" : "seen",
+            p->name.c_str());
+    fprintf(out, "      } else ");
+  }
+  fprintf(out, "if (!in->Skip()) {\n");
+  fprintf(out, "        return false;\n");
+  fprintf(out, "      }\n");
+  fprintf(out, "    }\n");
+  fprintf(out, "    return !in->Failed()");
+  for (const Property *p : properties) {
+    if (!p->is_optional) fprintf(out, " && seen_%s", p->name.c_str());
+  }
+  fprintf(out, ";\n");
+  fprintf(out, "  }\n");
+}
+
 void GenerateCode(const std::string &filename,
                   const std::string &nlohmann_json_include,
+                  const std::string &streaming_include,
                   const std::string &gen_namespace,
                   const ObjectTypeVector &objects, FILE *out) {
   fprintf(out, "// Don't modify. Generated from %s\n", filename.c_str());
@@ -235,7 +323,12 @@ void GenerateCode(const std::string &filename,
           "#pragma once\n"
           "#include <string>\n"
           "#include <vector>\n");
-  fprintf(out, "#include %s\n\n", nlohmann_json_include.c_str());
+  fprintf(out, "#include %s\n", nlohmann_json_include.c_str());
+  if (!streaming_include.empty()) {
+    fprintf(out, "#include \"absl/strings/string_view.h\"\n");
+    fprintf(out, "#include %s\n", streaming_include.c_str());
+  }
+  fprintf(out, "\n");
 
   if (!gen_namespace.empty()) {
     fprintf(out, "namespace %s {\n", gen_namespace.c_str());
@@ -337,6 +430,8 @@ void GenerateCode(const std::string &filename,
     }
     fprintf(out, "  }\n");
 
+    if (!streaming_include.empty()) GenerateStreamingCode(*obj, out);
+
     fprintf(out, "};\n");  // End of struct
 
     // functions that are picked up by the nlohmann::json serializer
@@ -385,5 +480,6 @@ int main(int argc, char *argv[]) {
   }
 
   GenerateCode(schema_filename, absl::GetFlag(FLAGS_json_header),
+               absl::GetFlag(FLAGS_streaming_header),
                absl::GetFlag(FLAGS_class_namespace), *objects, out);
 }
@@ -12,8 +12,13 @@
 // See the License for the specific language governing permissions and
 // limitations under the License.
 
+#include <sstream>
+#include <string>
+
 #include "absl/strings/match.h"
+#include "common/lsp/json-events.h"
 #include "common/tools/jcxxgen_testfile.h"
+#include "common/util/json_writer.h"
 #include "gtest/gtest.h"
 
 namespace verible {
@@ -113,4 +118,85 @@ TEST(jcxxgen_test, SerializeToJson) {
   EXPECT_EQ(obj.integer_value, obj_copy.integer_value);
   EXPECT_EQ(obj.struct_value.a, obj_copy.struct_value.a);
 }
+
+// Reads "json" with DeserializeFrom().
+static bool DeserializeFromText(const std::string &json,
+                                verible::test::DerivedObject *obj) {
+  lsp::JsonEvents events;
+  std::string error;
+  if (!events.Parse(json, &error)) return false;
+  lsp::JsonEventReader reader(&events);
+  return obj->DeserializeFrom(&reader) && reader.AtEnd();
+}
+
+TEST(jcxxgen_test, StreamingSerializationLikeJson) {
+  verible::test::DerivedObject obj;
+  obj.string_value = "quote \" newline \n control \x01 UTF-8 \xc3\xa4";
+  obj.has_integer_value_optional = true;
+  obj.integer_value_optional = -5;
+  obj.has_generic_object = true;
+  obj.generic_object = {{"x", {1, nullptr, "y"}}};
+  obj.additional_integer_value = 17;
+
+  std::ostringstream stream;
+  JsonWriter writer(&stream, -1);
+  obj.SerializeTo(&writer);
+  const std::string text = stream.str();
+  EXPECT_EQ(nlohmann::json::parse(text), nlohmann::json(obj)) << text;
+
+  // Roundtrip back with streaming deserialization.
+  verible::test::DerivedObject obj_copy;
+  ASSERT_TRUE(DeserializeFromText(text, &obj_copy)) << text;
+  EXPECT_EQ(nlohmann::json(obj_copy), nlohmann::json(obj));
+  EXPECT_FALSE(obj_copy.has_string_value_optional);
+  EXPECT_TRUE(obj_copy.has_integer_value_optional);
+}
+
+TEST(jcxxgen_test, StreamingDeserializationLikeJson) {
+  const std::string json = R"({
+      "string_value": "abc",
+      "string_value_optional": null,
+      "unknown": {"ignored": [1, 2, {"a": 3}]},
+      "string_value_with_default": "ghi",
+      "integer_value": 987,
+      "integer_value_optional": null,
+      "integer_value_with_default": 654.0,
+      "bool_value": true,
+      "struct_value": {"a": 321, "b": "bar"},
+      "additional_integer_value": 999
+  })";
+  verible::test::DerivedObject obj;
+  ASSERT_TRUE(DeserializeFromText(json, &obj));
+  const verible::test::DerivedObject expected = nlohmann::json::parse(json);
+  EXPECT_EQ(nlohmann::json(obj), nlohmann::json(expected));
+  EXPECT_FALSE(obj.has_string_value_optional);
+  EXPECT_FALSE(obj.has_integer_value_optional);
+  EXPECT_EQ(obj.integer_value_with_default, 654);
+  EXPECT_EQ(obj.struct_value.b, "bar");
+}
+
+TEST(jcxxgen_test, StreamingDeserializationFailsWithoutRequiredFields) {
+  verible::test::DerivedObject obj;
+  // integer_value is missing.
+  EXPECT_FALSE(DeserializeFromText(R"({
+      "string_value": "abc",
+      "string_value_with_default": "ghi",
+      "integer_value_with_default": 654,
+      "bool_value": true,
+      "struct_value": {"a": 321, "b": "bar"},
+      "additional_integer_value": 999
+  })",
+                                   &obj));
+  // Wrong type of bool_value.
+  EXPECT_FALSE(DeserializeFromText(R"({
+      "string_value": "abc",
+      "string_value_with_default": "ghi",
+      "integer_value": 987,
+      "integer_value_with_default": 654,
+      "bool_value": "true",
+      "struct_value": {"a": 321, "b": "bar"},
+      "additional_integer_value": 999
+  })",
+                                   &obj));
+}
 }  // namespace verible
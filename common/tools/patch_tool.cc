@@ -12,10 +12,14 @@
 // See the License for the specific language governing permissions and
 // limitations under the License.
 
+#include <algorithm>
 #include <functional>
 #include <iostream>
+#include <memory>
 #include <string>
+#include <utility>
 
+#include "absl/flags/flag.h"
 #include "absl/flags/usage.h"
 #include "absl/status/status.h"
 #include "absl/strings/str_cat.h"
@@ -25,8 +29,13 @@
 #include "common/util/init_command_line.h"
 #include "common/util/status_macros.h"
 #include "common/util/subcommand.h"
+#include "common/util/thread_pool.h"
 #include "common/util/user_interaction.h"
 
+ABSL_FLAG(int, jobs, 0,
+          "Number of threads on which the files of a patch are processed "
+          "(changed-lines). 0 uses all available cores.");
+
 using verible::SubcommandArgsRange;
 using verible::SubcommandEntry;
 
@@ -38,14 +47,17 @@ static absl::Status ChangedLines(const SubcommandArgsRange& args,
         "Missing patchfile argument.  Use '-' for stdin.");
   }
   const absl::string_view patchfile = args[0];
-  auto patch_content_or = verible::file::GetContentAsString(patchfile);
+  // Memory-mapped if possible: patches can be large.
+  auto patch_content_or = verible::file::GetContentAsMemBlock(patchfile);
   if (!patch_content_or.ok()) return patch_content_or.status();
 
+  const int jobs = verible::JobsOrAllCores(absl::GetFlag(FLAGS_jobs));
+  verible::ThreadPool pool(jobs > 1 ? jobs : 0);
   verible::PatchSet patch_set;
-  RETURN_IF_ERROR(patch_set.Parse(*patch_content_or));
+  RETURN_IF_ERROR(patch_set.Parse(std::move(*patch_content_or), &pool));
 
   const verible::FileLineNumbersMap changed_lines(
-      patch_set.AddedLinesMap(false));
+      patch_set.AddedLinesMap(false, &pool));
   for (const auto& file_lines : changed_lines) {
     outs << file_lines.first;
     if (!file_lines.second.empty()) {
@@ -63,12 +75,11 @@ static absl::Status ApplyPick(const SubcommandArgsRange& args,
     return absl::InvalidArgumentError("Missing patchfile argument.");
   }
   const absl::string_view patchfile = args[0];
-  absl::StatusOr<std::string> patch_contents_or;
-  patch_contents_or = verible::file::GetContentAsString(patchfile);
+  auto patch_contents_or = verible::file::GetContentAsMemBlock(patchfile);
   if (!patch_contents_or.ok()) return patch_contents_or.status();
 
   verible::PatchSet patch_set;
-  RETURN_IF_ERROR(patch_set.Parse(*patch_contents_or));
+  RETURN_IF_ERROR(patch_set.Parse(std::move(*patch_contents_or)));
 
   return patch_set.PickApplyInPlace(ins, outs);
 }
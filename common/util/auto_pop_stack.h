@@ -72,6 +72,11 @@ class AutoPopStack {
   // returns true if the stack is empty
   bool empty() const { return stack_.empty(); }
 
+  // Preallocates room for 'depth' values, so that pushing up to that many
+  // doesn't allocate.
+  void reserve(size_t depth) { stack_.reserve(depth); }
+  size_t capacity() const { return stack_.capacity(); }
+
   // returns the top value_type of the stack
   const_reference top() const {
     CHECK(!stack_.empty());
@@ -45,6 +45,20 @@ TEST(AutoPopStackTest, PushPopTest) {
   EXPECT_EQ(const_context.top(), 2);
 }
 
+TEST(IntStackTest, ReservedDepthDoesNotGrow) {
+  IntStack context;
+  context.reserve(3);
+  const size_t capacity = context.capacity();
+  EXPECT_GE(capacity, 3);
+  {
+    IntStack::AutoPop p1(&context, 1);
+    IntStack::AutoPop p2(&context, 2);
+    IntStack::AutoPop p3(&context, 3);
+    EXPECT_EQ(context.capacity(), capacity);
+  }
+  EXPECT_TRUE(context.empty());
+}
+
 // Test that forward/reverse iterators correctly look down/up the stack.
 TEST(IntStackTest, IteratorsTest) {
   IntStack context;
@@ -0,0 +1,86 @@
+// Copyright 2017-2023 The Verible Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "common/util/deferred_deleter.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <utility>
+#include <vector>
+
+namespace verible {
+
+DeferredDeleter::DeferredDeleter(size_t max_queued)
+    : max_queued_(max_queued), deleter_thread_([this]() { DeleteLoop(); }) {}
+
+DeferredDeleter::~DeferredDeleter() {
+  {
+    const std::lock_guard<std::mutex> l(lock_);
+    stopping_ = true;
+  }
+  queued_.notify_one();
+  deleter_thread_.join();
+}
+
+DeferredDeleter &DeferredDeleter::Global() {
+  // Not destroyed at exit: objects might still be retired by then.
+  static DeferredDeleter *const global = new DeferredDeleter();
+  return *global;
+}
+
+void DeferredDeleter::Delete(std::shared_ptr<const void> object) {
+  if (!object) return;
+  bool queued = false;
+  {
+    const std::lock_guard<std::mutex> l(lock_);
+    if (queue_.size() < max_queued_) {
+      queue_.push_back(std::move(object));
+      queued = true;
+    }
+  }
+  if (!queued) return;  // The queue is full: "object" is destroyed here.
+  queued_.notify_one();
+}
+
+void DeferredDeleter::Flush() {
+  std::unique_lock<std::mutex> l(lock_);
+  deleted_.wait(l, [this]() { return queue_.empty() && !deleting_; });
+}
+
+int64_t DeferredDeleter::deleted_count() const {
+  const std::lock_guard<std::mutex> l(lock_);
+  return deleted_count_;
+}
+
+void DeferredDeleter::DeleteLoop() {
+  std::vector<std::shared_ptr<const void>> batch;
+  std::unique_lock<std::mutex> l(lock_);
+  for (;;) {
+    queued_.wait(l, [this]() { return !queue_.empty() || stopping_; });
+    if (queue_.empty()) return;  // Stopping, and all is destroyed.
+    batch.swap(queue_);
+    deleting_ = true;
+    l.unlock();
+    for (auto &object : batch) object.reset();
+    l.lock();
+    deleting_ = false;
+    deleted_count_ += batch.size();
+    batch.clear();
+    if (queue_.empty()) deleted_.notify_all();
+  }
+}
+
+}  // namespace verible
@@ -0,0 +1,89 @@
+// Copyright 2017-2023 The Verible Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef VERIBLE_COMMON_UTIL_DEFERRED_DELETER_H_
+#define VERIBLE_COMMON_UTIL_DEFERRED_DELETER_H_
+
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace verible {
+
+// Destroys objects on a thread of its own, so that whoever retires a large
+// structure, e.g. the syntax tree of an outdated version of a file, does not
+// wait for its destruction.
+//
+// Objects are destroyed in the order they are queued.  If too many are queued
+// already, Delete() destroys the object itself rather than letting the
+// memory pile up.
+class DeferredDeleter {
+ public:
+  // At most "max_queued" objects wait for destruction.
+  explicit DeferredDeleter(size_t max_queued = kDefaultMaxQueued);
+  DeferredDeleter(const DeferredDeleter &) = delete;
+
+  // Destroys all queued objects before returning.
+  ~DeferredDeleter();
+
+  // Process-wide instance, never destroyed.
+  static DeferredDeleter &Global();
+
+  // Drop the reference "object" on the background thread: if it is the
+  // last one, the object is destroyed there.  Also accepts a std::unique_ptr.
+  void Delete(std::shared_ptr<const void> object);
+
+  // Wait until all objects queued so far are destroyed.
+  void Flush();
+
+  // Number of objects destroyed on the background thread so far.
+  int64_t deleted_count() const;
+
+  static constexpr size_t kDefaultMaxQueued = 16;
+
+ private:
+  void DeleteLoop();
+
+  const size_t max_queued_;
+
+  mutable std::mutex lock_;  // Guards the following.
+  std::condition_variable queued_;
+  std::condition_variable deleted_;
+  std::vector<std::shared_ptr<const void>> queue_;
+  bool deleting_ = false;  // A batch taken from the queue is being destroyed.
+  bool stopping_ = false;
+  int64_t deleted_count_ = 0;
+
+  // Declared last: it uses all of the above.
+  std::thread deleter_thread_;
+};
+
+// Deleter for std::unique_ptr and std::shared_ptr that destroys the object
+// with DeferredDeleter::Global(), e.g.
+//
+//   std::shared_ptr<const Foo> foo(new Foo(), DeferredDelete<const Foo>());
+template <class T>
+struct DeferredDelete {
+  void operator()(T *object) const {
+    DeferredDeleter::Global().Delete(std::unique_ptr<T>(object));
+  }
+};
+
+}  // namespace verible
+
+#endif  // VERIBLE_COMMON_UTIL_DEFERRED_DELETER_H_
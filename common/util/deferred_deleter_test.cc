@@ -0,0 +1,127 @@
+// Copyright 2017-2023 The Verible Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "common/util/deferred_deleter.h"
+
+#include <future>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "gtest/gtest.h"
+
+namespace verible {
+namespace {
+
+// Records the thread and order of its destruction.
+class Recorder {
+ public:
+  Recorder(int id, std::vector<int> *order, std::mutex *lock,
+           std::thread::id *thread = nullptr)
+      : id_(id), order_(order), lock_(lock), thread_(thread) {}
+  ~Recorder() {
+    const std::lock_guard<std::mutex> l(*lock_);
+    order_->push_back(id_);
+    if (thread_ != nullptr) *thread_ = std::this_thread::get_id();
+  }
+
+ private:
+  const int id_;
+  std::vector<int> *const order_;
+  std::mutex *const lock_;
+  std::thread::id *const thread_;
+};
+
+TEST(DeferredDeleterTest, DestroysInOrderOnOtherThread) {
+  std::vector<int> order;
+  std::mutex lock;
+  std::thread::id thread;
+  {
+    DeferredDeleter deleter;
+    deleter.Delete(std::make_unique<Recorder>(1, &order, &lock, &thread));
+    deleter.Delete(std::make_shared<const Recorder>(2, &order, &lock));
+    deleter.Delete(nullptr);
+    deleter.Flush();
+    EXPECT_EQ(deleter.deleted_count(), 2);
+    {
+      const std::lock_guard<std::mutex> l(lock);
+      EXPECT_EQ(order, std::vector<int>({1, 2}));
+      EXPECT_NE(thread, std::this_thread::get_id());
+    }
+    deleter.Delete(std::make_unique<Recorder>(3, &order, &lock));
+  }  // Destroys the rest on destruction.
+  EXPECT_EQ(order, std::vector<int>({1, 2, 3}));
+}
+
+TEST(DeferredDeleterTest, SharedObjectsOnlyOnceUnreferenced) {
+  std::vector<int> order;
+  std::mutex lock;
+  DeferredDeleter deleter;
+  auto shared = std::make_shared<const Recorder>(1, &order, &lock);
+  deleter.Delete(shared);
+  deleter.Flush();
+  EXPECT_TRUE(order.empty());
+  deleter.Delete(std::move(shared));
+  deleter.Flush();
+  EXPECT_EQ(order, std::vector<int>({1}));
+}
+
+TEST(DeferredDeleterTest, DestroysItselfWhenQueueIsFull) {
+  std::vector<int> order;
+  std::mutex lock;
+  std::promise<void> deleting;
+  std::promise<void> continue_deleting;
+  std::shared_future<void> may_continue = continue_deleting.get_future();
+  DeferredDeleter deleter(/*max_queued=*/1);
+
+  // Blocks the background thread while destroyed.
+  struct Blocker {
+    std::promise<void> *deleting;
+    std::shared_future<void> may_continue;
+    ~Blocker() {
+      deleting->set_value();
+      may_continue.wait();
+    }
+  };
+  deleter.Delete(
+      std::unique_ptr<Blocker>(new Blocker{&deleting, may_continue}));
+  deleting.get_future().wait();
+
+  std::thread::id thread;
+  deleter.Delete(std::make_unique<Recorder>(1, &order, &lock));
+  deleter.Delete(std::make_unique<Recorder>(2, &order, &lock, &thread));
+  {
+    const std::lock_guard<std::mutex> l(lock);
+    EXPECT_EQ(order, std::vector<int>({2}));
+    EXPECT_EQ(thread, std::this_thread::get_id());
+  }
+  continue_deleting.set_value();
+  deleter.Flush();
+  EXPECT_EQ(order, std::vector<int>({2, 1}));
+}
+
+TEST(DeferredDeleteTest, DeletesWithGlobalDeleter) {
+  std::vector<int> order;
+  std::mutex lock;
+  {
+    std::shared_ptr<const Recorder> recorder(
+        new Recorder(1, &order, &lock), DeferredDelete<const Recorder>());
+  }
+  DeferredDeleter::Global().Flush();
+  EXPECT_EQ(order, std::vector<int>({1}));
+}
+
+}  // namespace
+}  // namespace verible
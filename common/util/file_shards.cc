@@ -0,0 +1,160 @@
+// Copyright 2017-2023 The Verible Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "common/util/file_shards.h"
+
+#include <algorithm>
+#include <cstddef>
+#include <filesystem>
+#include <numeric>
+#include <string>
+#include <system_error>
+#include <utility>
+#include <vector>
+
+#include "absl/flags/flag.h"
+#include "absl/status/status.h"
+#include "absl/status/statusor.h"
+#include "absl/strings/ascii.h"
+#include "absl/strings/numbers.h"
+#include "absl/strings/str_cat.h"
+#include "absl/strings/str_split.h"
+#include "absl/strings/string_view.h"
+#include "absl/time/time.h"
+#include "common/util/file_util.h"
+
+ABSL_FLAG(int, shard_count, 1,
+          "Split the files into this many shards, and only process those of "
+          "--shard_index, e.g. to spread the files over several machines. "
+          "Every invocation must be given the same files.");
+ABSL_FLAG(int, shard_index, 0, "Shard to process, 0 to --shard_count - 1.");
+ABSL_FLAG(std::string, shard_costs, "",
+          "File with the time each file took to process in an earlier run, "
+          "from --shard_costs_output, to balance the shards by. Shards are "
+          "otherwise balanced by file size.");
+ABSL_FLAG(std::string, shard_costs_output, "",
+          "If not empty, write the time each file took to process to this "
+          "file. The files written by all shards can be concatenated for "
+          "--shard_costs.");
+
+namespace verible {
+
+absl::StatusOr<FileCosts> ParseFileCosts(absl::string_view text) {
+  FileCosts costs;
+  int line_number = 0;
+  for (absl::string_view line : absl::StrSplit(text, '\n')) {
+    ++line_number;
+    line = absl::StripAsciiWhitespace(line);
+    if (line.empty() || line[0] == '#') continue;
+    const std::vector<absl::string_view> fields =
+        absl::StrSplit(line, absl::MaxSplits(' ', 1));
+    double cost;
+    if (fields.size() != 2 || !absl::SimpleAtod(fields[0], &cost) ||
+        cost < 0 || absl::StripAsciiWhitespace(fields[1]).empty()) {
+      return absl::InvalidArgumentError(
+          absl::StrCat("line ", line_number, ": expected \"<cost> <file>\""));
+    }
+    costs[std::string(absl::StripAsciiWhitespace(fields[1]))] = cost;
+  }
+  return costs;
+}
+
+std::string FileCostLine(absl::string_view filename, absl::Duration time) {
+  return absl::StrCat(absl::ToDoubleSeconds(time), " ", filename, "\n");
+}
+
+std::vector<int> AssignShards(const std::vector<double>& costs,
+                              int shard_count) {
+  std::vector<size_t> order(costs.size());
+  std::iota(order.begin(), order.end(), 0);
+  std::stable_sort(order.begin(), order.end(), [&costs](size_t a, size_t b) {
+    return costs[a] > costs[b];
+  });
+  std::vector<double> totals(std::max(shard_count, 1), 0.0);
+  std::vector<int> shards(costs.size());
+  for (const size_t item : order) {
+    // The first of the least loaded shards.
+    const int shard =
+        std::min_element(totals.begin(), totals.end()) - totals.begin();
+    shards[item] = shard;
+    totals[shard] += costs[item];
+  }
+  return shards;
+}
+
+absl::StatusOr<std::vector<absl::string_view>> FilesOfShard(
+    const std::vector<absl::string_view>& filenames, int shard_index,
+    int shard_count, const FileCosts& recorded) {
+  if (shard_count < 1 || shard_index < 0 || shard_index >= shard_count) {
+    return absl::InvalidArgumentError(
+        absl::StrCat("Shard ", shard_index, " of ", shard_count,
+                     " does not exist: the index must be at least 0 and "
+                     "less than the count."));
+  }
+  std::vector<double> sizes(filenames.size(), 0.0);
+  std::vector<const double*> recorded_costs(filenames.size(), nullptr);
+  double recorded_cost = 0;
+  double recorded_size = 0;
+  for (size_t i = 0; i < filenames.size(); ++i) {
+    std::error_code error;
+    const auto size = std::filesystem::file_size(
+        std::filesystem::path(std::string(filenames[i])), error);
+    // Files that can't be read are reported when they are processed.
+    if (!error) sizes[i] = static_cast<double>(size);
+    const auto found = recorded.find(filenames[i]);
+    if (found == recorded.end()) continue;
+    recorded_costs[i] = &found->second;
+    recorded_cost += found->second;
+    recorded_size += sizes[i];
+  }
+  // Without recordings, costs are sizes.
+  const double cost_per_byte =
+      recorded_size > 0 ? recorded_cost / recorded_size : 1.0;
+  std::vector<double> costs(filenames.size());
+  for (size_t i = 0; i < filenames.size(); ++i) {
+    costs[i] = recorded_costs[i] != nullptr ? *recorded_costs[i]
+                                            : sizes[i] * cost_per_byte;
+  }
+
+  const std::vector<int> shards = AssignShards(costs, shard_count);
+  std::vector<absl::string_view> result;
+  for (size_t i = 0; i < filenames.size(); ++i) {
+    if (shards[i] == shard_index) result.push_back(filenames[i]);
+  }
+  return result;
+}
+
+absl::StatusOr<std::vector<absl::string_view>> FilesOfShardFromFlags(
+    const std::vector<absl::string_view>& filenames) {
+  FileCosts recorded;
+  if (const std::string costs_file = absl::GetFlag(FLAGS_shard_costs);
+      !costs_file.empty()) {
+    const absl::StatusOr<std::string> content =
+        file::GetContentAsString(costs_file);
+    if (!content.ok()) return content.status();
+    absl::StatusOr<FileCosts> costs = ParseFileCosts(*content);
+    if (!costs.ok()) return costs.status();
+    recorded = *std::move(costs);
+  }
+  return FilesOfShard(filenames, absl::GetFlag(FLAGS_shard_index),
+                      absl::GetFlag(FLAGS_shard_count), recorded);
+}
+
+absl::Status WriteShardCostsFromFlags(absl::string_view cost_lines) {
+  const std::string costs_output = absl::GetFlag(FLAGS_shard_costs_output);
+  if (costs_output.empty()) return absl::OkStatus();
+  return file::SetContents(costs_output, cost_lines);
+}
+
+}  // namespace verible
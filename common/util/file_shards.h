@@ -0,0 +1,80 @@
+// Copyright 2017-2023 The Verible Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// Splitting the files of one invocation of a tool into shards, that separate
+// invocations (e.g. on several CI machines) process with the same list of
+// files, so that every file is processed by exactly one of them.  Tools that
+// shard their files get the --shard_* flags of this library.
+
+#ifndef VERIBLE_COMMON_UTIL_FILE_SHARDS_H_
+#define VERIBLE_COMMON_UTIL_FILE_SHARDS_H_
+
+#include <functional>
+#include <map>
+#include <string>
+#include <vector>
+
+#include "absl/flags/declare.h"
+#include "absl/status/status.h"
+#include "absl/status/statusor.h"
+#include "absl/strings/string_view.h"
+#include "absl/time/time.h"
+
+// Flags are declared for testing purposes.
+ABSL_DECLARE_FLAG(int, shard_count);
+ABSL_DECLARE_FLAG(int, shard_index);
+ABSL_DECLARE_FLAG(std::string, shard_costs);
+ABSL_DECLARE_FLAG(std::string, shard_costs_output);
+
+namespace verible {
+
+// Recorded cost of processing files, e.g. seconds, by file name.
+using FileCosts = std::map<std::string, double, std::less<>>;
+
+// Parses recorded file costs, one "<cost> <file>" per line.  Empty lines and
+// lines starting with '#' are ignored.  Of several lines for the same file,
+// the last one counts, so that the recordings of several shards or runs are
+// merged by concatenating them.
+absl::StatusOr<FileCosts> ParseFileCosts(absl::string_view text);
+
+// Returns the line of a file costs recording for processing 'filename' in
+// 'time'.
+std::string FileCostLine(absl::string_view filename, absl::Duration time);
+
+// Returns the shard (0 to shard_count - 1) of each item with the given
+// 'costs', so that the shards have about the same total cost: from the most
+// to the least costly, each item goes to the shard with the lowest total so
+// far.  The result only depends on the arguments.
+std::vector<int> AssignShards(const std::vector<double>& costs,
+                              int shard_count);
+
+// Returns those of 'filenames' that belong to shard 'shard_index' of
+// 'shard_count', in their original order.  Files are balanced by their
+// 'recorded' costs, and the others by their size, scaled by the cost per byte
+// of the recorded files.  Fails if the shard is out of range.
+absl::StatusOr<std::vector<absl::string_view>> FilesOfShard(
+    const std::vector<absl::string_view>& filenames, int shard_index,
+    int shard_count, const FileCosts& recorded);
+
+// Returns the files of 'filenames' in the shard selected by --shard_index and
+// --shard_count, balanced by the costs of --shard_costs, if any.
+absl::StatusOr<std::vector<absl::string_view>> FilesOfShardFromFlags(
+    const std::vector<absl::string_view>& filenames);
+
+// Writes 'cost_lines' (see FileCostLine()) to --shard_costs_output, if set.
+absl::Status WriteShardCostsFromFlags(absl::string_view cost_lines);
+
+}  // namespace verible
+
+#endif  // VERIBLE_COMMON_UTIL_FILE_SHARDS_H_
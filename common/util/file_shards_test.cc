@@ -0,0 +1,147 @@
+// Copyright 2017-2023 The Verible Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "common/util/file_shards.h"
+
+#include <string>
+#include <vector>
+
+#include "absl/flags/flag.h"
+#include "absl/strings/string_view.h"
+#include "absl/time/time.h"
+#include "common/util/file_util.h"
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+
+namespace verible {
+namespace {
+
+using file::testing::ScopedTestFile;
+using testing::ElementsAre;
+using testing::Pair;
+
+TEST(ParseFileCostsTest, LastLineOfFileCounts) {
+  const auto costs = ParseFileCosts(
+      "# recorded\n"
+      "1.5 a.sv\n"
+      "\n"
+      "2 dir/b c.sv\n"
+      "0.25 a.sv\n");
+  ASSERT_TRUE(costs.ok()) << costs.status();
+  EXPECT_THAT(*costs, ElementsAre(Pair("a.sv", 0.25), Pair("dir/b c.sv", 2)));
+}
+
+TEST(ParseFileCostsTest, InvalidLine) {
+  EXPECT_FALSE(ParseFileCosts("a.sv 1.5\n").ok());
+  EXPECT_FALSE(ParseFileCosts("-1 a.sv\n").ok());
+  EXPECT_FALSE(ParseFileCosts("1.5\n").ok());
+}
+
+TEST(ParseFileCostsTest, ParsesFileCostLine) {
+  const auto costs = ParseFileCosts(
+      FileCostLine("a.sv", absl::Milliseconds(1500)) +
+      FileCostLine("b.sv", absl::ZeroDuration()));
+  ASSERT_TRUE(costs.ok()) << costs.status();
+  EXPECT_THAT(*costs, ElementsAre(Pair("a.sv", 1.5), Pair("b.sv", 0)));
+}
+
+TEST(AssignShardsTest, BalancesCosts) {
+  // Shard totals: 8 + 1 = 9, 5 + 3 = 8, 4 + 3 + 2 = 9.
+  EXPECT_THAT(AssignShards({3, 8, 5, 1, 4, 3, 2}, 3),
+              ElementsAre(2, 0, 1, 0, 2, 1, 2));
+}
+
+TEST(AssignShardsTest, SameCostsInOrder) {
+  EXPECT_THAT(AssignShards({1, 1, 1, 1, 1}, 2), ElementsAre(0, 1, 0, 1, 0));
+}
+
+TEST(AssignShardsTest, MoreShardsThanItems) {
+  EXPECT_THAT(AssignShards({1, 2}, 4), ElementsAre(1, 0));
+}
+
+TEST(FilesOfShardTest, InvalidShard) {
+  const std::vector<absl::string_view> files = {"a.sv"};
+  EXPECT_FALSE(FilesOfShard(files, 0, 0, {}).ok());
+  EXPECT_FALSE(FilesOfShard(files, -1, 2, {}).ok());
+  EXPECT_FALSE(FilesOfShard(files, 2, 2, {}).ok());
+}
+
+TEST(FilesOfShardTest, AllFilesInOneOfTheShards) {
+  const std::vector<absl::string_view> files = {"a.sv", "b.sv", "c.sv"};
+  std::vector<absl::string_view> all;
+  for (int shard = 0; shard < 2; ++shard) {
+    const auto shard_files = FilesOfShard(files, shard, 2, {});
+    ASSERT_TRUE(shard_files.ok()) << shard_files.status();
+    all.insert(all.end(), shard_files->begin(), shard_files->end());
+  }
+  EXPECT_THAT(all, testing::UnorderedElementsAre("a.sv", "b.sv", "c.sv"));
+}
+
+TEST(FilesOfShardTest, BalancedBySizeAndRecordedCost) {
+  const std::string dir = ::testing::TempDir();
+  const ScopedTestFile large(dir, std::string(1000, ' '));
+  const ScopedTestFile small1(dir, std::string(400, ' '));
+  const ScopedTestFile small2(dir, std::string(500, ' '));
+  const std::vector<absl::string_view> files = {
+      small1.filename(), large.filename(), small2.filename()};
+
+  // By size: 1000 against 500 + 400.
+  auto shard = FilesOfShard(files, 0, 2, {});
+  ASSERT_TRUE(shard.ok()) << shard.status();
+  EXPECT_THAT(*shard, ElementsAre(large.filename()));
+
+  // The large file is fast and the first small one slow.  The other one is
+  // estimated at their average cost per byte: 1 against 0.39 + 0.1.
+  const FileCosts recorded = {{std::string(large.filename()), 0.1},
+                              {std::string(small1.filename()), 1.0}};
+  shard = FilesOfShard(files, 0, 2, recorded);
+  ASSERT_TRUE(shard.ok()) << shard.status();
+  EXPECT_THAT(*shard, ElementsAre(small1.filename()));
+}
+
+TEST(FilesOfShardFromFlagsTest, CostsOfEarlierRun) {
+  const std::string dir = ::testing::TempDir();
+  const ScopedTestFile large(dir, std::string(1000, ' '));
+  const ScopedTestFile small(dir, std::string(400, ' '));
+  const std::vector<absl::string_view> files = {small.filename(),
+                                                large.filename()};
+  absl::SetFlag(&FLAGS_shard_count, 2);
+  absl::SetFlag(&FLAGS_shard_index, 0);
+
+  // By size, without recorded costs.
+  auto shard = FilesOfShardFromFlags(files);
+  ASSERT_TRUE(shard.ok()) << shard.status();
+  EXPECT_THAT(*shard, ElementsAre(large.filename()));
+
+  const std::string costs_file = file::JoinPath(dir, "costs");
+  absl::SetFlag(&FLAGS_shard_costs_output, costs_file);
+  ASSERT_TRUE(WriteShardCostsFromFlags(
+                  FileCostLine(large.filename(), absl::Milliseconds(100)) +
+                  FileCostLine(small.filename(), absl::Seconds(1)))
+                  .ok());
+  absl::SetFlag(&FLAGS_shard_costs, costs_file);
+  shard = FilesOfShardFromFlags(files);
+  ASSERT_TRUE(shard.ok()) << shard.status();
+  EXPECT_THAT(*shard, ElementsAre(small.filename()));
+
+  absl::SetFlag(&FLAGS_shard_costs, file::JoinPath(dir, "no-costs"));
+  EXPECT_FALSE(FilesOfShardFromFlags(files).ok());
+
+  absl::SetFlag(&FLAGS_shard_costs, "");
+  absl::SetFlag(&FLAGS_shard_costs_output, "");
+  absl::SetFlag(&FLAGS_shard_count, 1);
+}
+
+}  // namespace
+}  // namespace verible
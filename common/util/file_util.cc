@@ -20,10 +20,12 @@
 #include <cstring>
 #include <filesystem>
 #include <fstream>
+#include <functional>
 #include <iostream>
 #include <streambuf>
 #include <string>
 #include <system_error>
+#include <thread>  // NOLINT
 
 #include "absl/status/status.h"
 #include "absl/status/statusor.h"
@@ -31,12 +33,18 @@
 #include "absl/strings/str_join.h"
 #include "absl/strings/str_split.h"
 #include "absl/strings/string_view.h"
+#include "absl/strings/strip.h"
 #include "common/util/logging.h"
+#include "common/util/thread_pool.h"
 
 #ifndef _WIN32
 #include <fcntl.h>
 #include <sys/mman.h>
 #include <sys/stat.h>
+#include <unistd.h>
+#else
+#include <process.h>
+#define getpid _getpid
 #endif
 
 namespace fs = std::filesystem;
@@ -226,9 +234,13 @@ static absl::StatusOr<std::unique_ptr<MemBlock>> AttemptMemMapFile(
 
 absl::StatusOr<std::unique_ptr<MemBlock>> GetContentAsMemBlock(
     absl::string_view filename) {
-  auto mmap_result = AttemptMemMapFile(filename);
-  if (mmap_result.status().ok()) {
-    return mmap_result;
+  // Standard input is read like any other stream, even if there is a file
+  // of that name.
+  if (!IsStdin(filename)) {
+    auto mmap_result = AttemptMemMapFile(filename);
+    if (mmap_result.status().ok()) {
+      return mmap_result;
+    }
   }
 
   // Still here ? Well, let's try the traditional way
@@ -237,6 +249,16 @@ absl::StatusOr<std::unique_ptr<MemBlock>> GetContentAsMemBlock(
   return std::make_unique<StringMemBlock>(std::move(*content_or));
 }
 
+void GetContentsAsMemBlocks(const std::vector<std::string>& filenames,
+                            int jobs, const ContentFun& done) {
+  // The calling thread reads files as well.
+  const int helpers = std::min<int>(jobs, filenames.size()) - 1;
+  ThreadPool pool(std::max(helpers, 0));
+  pool.ParallelFor(filenames.size(), [&filenames, &done](size_t i) {
+    done(i, GetContentAsMemBlock(filenames[i]));
+  });
+}
+
 absl::Status SetContents(absl::string_view filename,
                          absl::string_view content) {
   VLOG(1) << __FUNCTION__ << ": Writing file: " << filename;
@@ -248,11 +270,36 @@ absl::Status SetContents(absl::string_view filename,
   return absl::OkStatus();
 }
 
+absl::Status SetContentsAtomically(absl::string_view filename,
+                                   absl::string_view content) {
+  // Unique among the threads and processes that might write it.
+  const std::string temp_path = absl::StrCat(
+      filename, ".", getpid(), "-",
+      std::hash<std::thread::id>()(std::this_thread::get_id()), ".tmp");
+  if (absl::Status status = SetContents(temp_path, content); !status.ok()) {
+    return status;
+  }
+  std::error_code err;
+  fs::rename(temp_path, std::string(filename), err);
+  if (err) {
+    fs::remove(temp_path, err);
+    return absl::UnavailableError(
+        absl::StrCat(filename, ": can't replace with ", temp_path, "."));
+  }
+  return absl::OkStatus();
+}
+
 std::string JoinPath(absl::string_view base, absl::string_view name) {
   fs::path p = fs::path(std::string(base)) / fs::path(std::string(name));
   return p.lexically_normal().string();
 }
 
+std::string JoinPathUnder(absl::string_view dir, absl::string_view name) {
+  while (absl::ConsumePrefix(&name, "/")) {
+  }
+  return JoinPath(dir, name);
+}
+
 absl::Status CreateDir(absl::string_view dir) {
   const std::string path(dir);
   std::error_code err;
@@ -262,6 +309,15 @@ absl::Status CreateDir(absl::string_view dir) {
   return CreateErrorStatusFromErr(dir, err, "can't create directory");
 }
 
+absl::Status CreateDirs(absl::string_view dir) {
+  const std::string path(dir);
+  std::error_code err;
+  if (fs::create_directories(path, err) || err.value() == 0) {
+    return absl::OkStatus();
+  }
+  return CreateErrorStatusFromErr(dir, err, "can't create directory");
+}
+
 absl::StatusOr<Directory> ListDir(absl::string_view dir) {
   std::error_code err;
   Directory d;
@@ -17,6 +17,9 @@
 #ifndef VERIBLE_COMMON_UTIL_FILE_UTIL_H_
 #define VERIBLE_COMMON_UTIL_FILE_UTIL_H_
 
+#include <cstddef>
+#include <functional>
+#include <memory>
 #include <string>
 #include <vector>
 
@@ -82,9 +85,27 @@ absl::StatusOr<std::string> GetContentAsString(absl::string_view filename);
 absl::StatusOr<std::unique_ptr<MemBlock>> GetContentAsMemBlock(
     absl::string_view filename);
 
+// Reads the files "filenames" like GetContentAsMemBlock(), on up to "jobs"
+// threads: the latency of opening files often dominates reading them, e.g.
+// on network file systems.  Calls "done" with the index of each file in
+// "filenames" and its content as soon as it is read, on the thread that read
+// it, so that processing the content overlaps with reading other files.
+// Returns once "done" was called for all files.
+using ContentFun = std::function<void(
+    size_t index, absl::StatusOr<std::unique_ptr<MemBlock>> content)>;
+void GetContentsAsMemBlocks(const std::vector<std::string>& filenames,
+                            int jobs, const ContentFun& done);
+
 // Create file "filename" and store given content in it.
 absl::Status SetContents(absl::string_view filename, absl::string_view content);
 
+// Same as SetContents(), but readers of "filename", also in other processes,
+// only ever see a complete content: it is written to a temporary file next to
+// it first, which then replaces it.  Several threads or processes may write
+// the same file at the same time; one of them wins.
+absl::Status SetContentsAtomically(absl::string_view filename,
+                                   absl::string_view content);
+
 // Join directory + filename and lightly canonicalize.
 // The canonicalization step unifies ./ and ../ path elements lexically
 // without looking at the underlying file-system.
@@ -92,9 +113,17 @@ absl::Status SetContents(absl::string_view filename, absl::string_view content);
 // If "filename" is already absolute, "base" is not prepended.
 std::string JoinPath(absl::string_view base, absl::string_view name);
 
+// Returns where "name" goes when files are mirrored under "dir", e.g. by
+// tools writing their output for each input file: "name" is joined to "dir"
+// without its leading slashes, so that absolute paths end up under it too.
+std::string JoinPathUnder(absl::string_view dir, absl::string_view name);
+
 // Create directory with given name, return success.
 absl::Status CreateDir(absl::string_view dir);
 
+// Same as CreateDir(), but also creates the missing parent directories.
+absl::Status CreateDirs(absl::string_view dir);
+
 // Returns the content of the directory. POSIX only. Ignores symlinks and
 // unknown nodes which it fails to resolve to a file or a directory. Returns an
 // error status on any read error (doesn't allow partial results) except
@@ -16,11 +16,14 @@
 
 #include <algorithm>
 #include <filesystem>
+#include <iterator>
 #include <string>
 #include <vector>
 
 #include "absl/status/status.h"
+#include "absl/status/statusor.h"
 #include "absl/strings/match.h"
+#include "absl/strings/str_cat.h"
 #include "absl/strings/string_view.h"
 #include "gmock/gmock.h"
 #include "gtest/gtest.h"
@@ -92,6 +95,53 @@ TEST(FileUtil, GetContentAsMemBlock) {
   EXPECT_EQ(block->AsStringView(), test_content);
 }
 
+TEST(FileUtil, SetContentsAtomically) {
+  const std::string dir = file::JoinPath(::testing::TempDir(), "atomic");
+  ASSERT_OK(file::CreateDir(dir));
+  const std::string path = file::JoinPath(dir, "entry");
+  ASSERT_OK(file::SetContentsAtomically(path, "old"));
+  ASSERT_OK(file::SetContentsAtomically(path, "new"));
+  const absl::StatusOr<std::string> content = file::GetContentAsString(path);
+  ASSERT_OK(content.status());
+  EXPECT_EQ(*content, "new");
+  // No temporary file is left behind.
+  EXPECT_EQ(std::distance(std::filesystem::directory_iterator(dir),
+                          std::filesystem::directory_iterator()),
+            1);
+
+  EXPECT_FALSE(
+      file::SetContentsAtomically(file::JoinPath(dir, "no/such/dir"), "x")
+          .ok());
+}
+
+TEST(FileUtil, GetContentsAsMemBlocks) {
+  const std::string dir = file::JoinPath(testing::TempDir(), "blockfiles");
+  ASSERT_OK(file::CreateDir(dir));
+  std::vector<std::string> filenames;
+  for (int i = 0; i < 10; ++i) {
+    filenames.push_back(file::JoinPath(dir, absl::StrCat("file", i)));
+    EXPECT_OK(file::SetContents(filenames.back(), absl::StrCat("content", i)));
+  }
+  filenames.emplace_back("non-existing-file");
+
+  for (int jobs : {0, 1, 4}) {
+    std::vector<std::string> contents(filenames.size());
+    std::vector<int> calls(filenames.size());
+    file::GetContentsAsMemBlocks(
+        filenames, jobs,
+        [&](size_t i, absl::StatusOr<std::unique_ptr<MemBlock>> content) {
+          ++calls[i];
+          contents[i] = content.ok() ? std::string((*content)->AsStringView())
+                                     : "error";
+        });
+    for (size_t i = 0; i < filenames.size(); ++i) {
+      EXPECT_EQ(calls[i], 1) << "jobs: " << jobs;
+      EXPECT_EQ(contents[i], i < 10 ? absl::StrCat("content", i) : "error")
+          << "jobs: " << jobs;
+    }
+  }
+}
+
 TEST(FileUtil, JoinPath) {
   EXPECT_EQ(file::JoinPath("foo", ""), PlatformPath("foo/"));
   EXPECT_EQ(file::JoinPath("", "bar"), "bar");
@@ -129,6 +179,14 @@ TEST(FileUtil, JoinPath) {
 #endif
 }
 
+TEST(FileUtil, JoinPathUnder) {
+  EXPECT_EQ(file::JoinPathUnder("out", "a/b.sv"), PlatformPath("out/a/b.sv"));
+  // Absolute paths go under "dir" too.
+  EXPECT_EQ(file::JoinPathUnder("out", "/a/b.sv"), PlatformPath("out/a/b.sv"));
+  EXPECT_EQ(file::JoinPathUnder("out/", "//a.sv"), PlatformPath("out/a.sv"));
+  EXPECT_EQ(file::JoinPathUnder("/out", "a.sv"), PlatformPath("/out/a.sv"));
+}
+
 TEST(FileUtil, CreateDir) {
   const std::string test_dir = file::JoinPath(testing::TempDir(), "test_dir");
   const std::string test_file = file::JoinPath(test_dir, "foo");
@@ -144,6 +202,19 @@ TEST(FileUtil, CreateDir) {
   EXPECT_EQ(test_content, *read_back_content_or);
 }
 
+TEST(FileUtil, CreateDirs) {
+  const std::string test_dir =
+      file::JoinPath(testing::TempDir(), "test_dirs/nested/dir");
+  EXPECT_OK(file::CreateDirs(test_dir));
+  EXPECT_OK(file::CreateDirs(test_dir));  // Creating twice should succeed
+  EXPECT_OK(file::SetContents(file::JoinPath(test_dir, "foo"), "created"));
+
+  // Not under a file.
+  EXPECT_FALSE(
+      file::CreateDirs(file::JoinPath(file::JoinPath(test_dir, "foo"), "bar"))
+          .ok());
+}
+
 TEST(FileUtil, StatusErrorReporting) {
   absl::StatusOr<std::string> content_or;
 
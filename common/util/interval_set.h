@@ -15,11 +15,14 @@
 #ifndef VERIBLE_COMMON_UTIL_INTERVAL_SET_H_
 #define VERIBLE_COMMON_UTIL_INTERVAL_SET_H_
 
+#include <algorithm>
 #include <initializer_list>
 #include <iostream>
+#include <iterator>
 #include <map>
 #include <sstream>
 #include <utility>
+#include <vector>
 
 #include "absl/random/random.h"
 #include "absl/strings/numbers.h"
@@ -560,6 +563,183 @@ bool ParseInclusiveRanges(IntervalSet<T>* iset, Iter begin, Iter end,
   return true;
 }
 
+//------------------------------------------------------------------------------
+// FlatIntervalSet
+//------------------------------------------------------------------------------
+
+// FlatIntervalSet is a read-only IntervalSet, for sets that are built once and
+// then queried many times, e.g. waived lines or format-disabled byte ranges.
+// The intervals are kept in a sorted vector, so lookups are binary searches
+// over contiguous memory rather than walks down the nodes of a std::map.
+// Sets are copied from an IntervalSet, or made with a Builder.
+// Type T must be std::less-comparable and support value + 1.
+template <typename T>
+class FlatIntervalSet {
+  using impl_type = std::vector<Interval<T>>;
+
+ public:
+  using value_type = Interval<T>;
+  using const_iterator = typename impl_type::const_iterator;
+  using size_type = typename impl_type::size_type;
+
+  // Collects intervals in any order, which may overlap, and fuses them into a
+  // FlatIntervalSet at once.  This is cheaper than adding them to an
+  // IntervalSet one by one.
+  class Builder {
+   public:
+    void Add(const Interval<T>& interval) {
+      CHECK(interval.valid());
+      if (!interval.empty()) intervals_.push_back(interval);
+    }
+
+    void Add(const T& value) { Add({value, value + 1}); }
+
+    // Returns the union of the added intervals, leaving this empty.
+    FlatIntervalSet<T> Build() {
+      std::sort(intervals_.begin(), intervals_.end(),
+                [](const Interval<T>& left, const Interval<T>& right) {
+                  return left.min < right.min;
+                });
+      FlatIntervalSet<T> result;
+      for (const Interval<T>& interval : intervals_) {
+        // Overlapping and abutting intervals are fused.
+        if (!result.intervals_.empty() &&
+            !(result.intervals_.back().max < interval.min)) {
+          Interval<T>& last = result.intervals_.back();
+          if (last.max < interval.max) last.max = interval.max;
+          continue;
+        }
+        result.intervals_.push_back(interval);
+      }
+      intervals_.clear();
+      return result;
+    }
+
+   private:
+    std::vector<Interval<T>> intervals_;
+  };
+
+  // Answers Contains() queries of values in non-decreasing order, e.g. of
+  // violations visited in order of location, by galloping forward from the
+  // interval of the previous query: queries cost O(log(distance)) instead of
+  // O(log(size)).  Queries out of order are still correct.
+  // The set must outlive the cursor.
+  class Cursor {
+   public:
+    explicit Cursor(const FlatIntervalSet<T>& set)
+        : set_(set), position_(set.begin()) {}
+
+    bool Contains(const T& value) {
+      const const_iterator begin = set_.begin();
+      const const_iterator end = set_.end();
+      // All intervals before position_ end at or before 'value', unless the
+      // queries went backwards.
+      if (position_ != begin && value < std::prev(position_)->max) {
+        position_ = begin;
+      }
+      const_iterator bound = position_;
+      for (typename impl_type::difference_type step = 1;
+           bound != end && !(value < bound->max); step *= 2) {
+        position_ = std::next(bound);
+        bound = end - position_ > step ? position_ + step : end;
+      }
+      // The first interval that ends after 'value' is in [position_, bound].
+      position_ = std::partition_point(
+          position_, bound,
+          [&value](const Interval<T>& interval) {
+            return !(value < interval.max);
+          });
+      return position_ != end && !(value < position_->min);
+    }
+
+   private:
+    const FlatIntervalSet<T>& set_;
+    const_iterator position_;
+  };
+
+ public:
+  FlatIntervalSet() = default;
+
+  explicit FlatIntervalSet(const IntervalSet<T>& iset) {
+    intervals_.reserve(iset.size());
+    for (const auto& interval : iset) {
+      intervals_.push_back(AsInterval(interval));
+    }
+  }
+
+  FlatIntervalSet(std::initializer_list<Interval<T>> ranges) {
+    Builder builder;
+    for (const auto& range : ranges) builder.Add(range);
+    *this = builder.Build();
+  }
+
+  const_iterator begin() const { return intervals_.begin(); }
+
+  const_iterator end() const { return intervals_.end(); }
+
+  // Returns the number of disjoint intervals that compose this set.
+  size_type size() const { return intervals_.size(); }
+
+  // Returns true if the set contains no intervals/values.
+  bool empty() const { return intervals_.empty(); }
+
+  bool operator==(const FlatIntervalSet<T>& other) const {
+    return intervals_ == other.intervals_;
+  }
+
+  bool operator!=(const FlatIntervalSet<T>& other) const {
+    return !(*this == other);
+  }
+
+  // Returns true if value is a member of an interval in the set.
+  bool Contains(const T& value) const { return Find(value) != end(); }
+
+  // Returns true if interval is entirely contained by an interval in the set.
+  // If interval is empty, return false.
+  bool Contains(const Interval<T>& interval) const {
+    return Find(interval) != end();
+  }
+
+  // Returns the first interval that spans or follows 'value'.
+  const_iterator LowerBound(const T& value) const {
+    return std::partition_point(begin(), end(),
+                                [&value](const Interval<T>& interval) {
+                                  return !(value < interval.max);
+                                });
+  }
+
+  // Returns an iterator to the interval that contains 'value',
+  // or the end iterator if no such interval exists.
+  const_iterator Find(const T& value) const {
+    const const_iterator found = LowerBound(value);
+    if (found == end() || value < found->min) return end();
+    return found;
+  }
+
+  // Returns an iterator to the interval that entirely contains [min,max),
+  // or the end iterator if no such interval exists, or the input is empty.
+  const_iterator Find(const Interval<T>& interval) const {
+    if (interval.empty()) return end();
+    const const_iterator found = LowerBound(interval.min);
+    if (found == end() || interval.min < found->min ||
+        found->max < interval.max) {
+      return end();
+    }
+    return found;
+  }
+
+ private:
+  // Invariants: all intervals are non-empty, non-overlapping, non-abutting,
+  // and ordered.
+  impl_type intervals_;
+};
+
+template <typename T>
+std::ostream& operator<<(std::ostream& stream,
+                         const FlatIntervalSet<T>& iset) {
+  return FormatIntervals(stream, iset.begin(), iset.end());
+}
+
 //------------------------------------------------------------------------------
 // DisjointIntervalSet
 //------------------------------------------------------------------------------
@@ -966,6 +966,87 @@ static void DisjointIntervalConsistencyCheck(const M& iset) {
   }
 }
 
+TEST(FlatIntervalSetTest, Empty) {
+  const FlatIntervalSet<int> iset;
+  EXPECT_TRUE(iset.empty());
+  EXPECT_EQ(iset.size(), 0);
+  EXPECT_FALSE(iset.Contains(0));
+  EXPECT_FALSE(iset.Contains(interval_type{0, 1}));
+  FlatIntervalSet<int>::Cursor cursor(iset);
+  EXPECT_FALSE(cursor.Contains(0));
+}
+
+TEST(FlatIntervalSetTest, CopiedFromIntervalSet) {
+  const interval_set_type iset{{1, 3}, {5, 8}, {10, 11}};
+  const FlatIntervalSet<int> flat(iset);
+  EXPECT_THAT(flat, ElementsAre(interval_type{1, 3}, interval_type{5, 8},
+                                interval_type{10, 11}));
+  for (int value = -1; value < 13; ++value) {
+    EXPECT_EQ(flat.Contains(value), iset.Contains(value)) << value;
+    for (int max = value; max < 13; ++max) {
+      EXPECT_EQ(flat.Contains(interval_type{value, max}),
+                iset.Contains(interval_type{value, max}))
+          << value << ", " << max;
+    }
+  }
+}
+
+TEST(FlatIntervalSetTest, BuilderFusesIntervals) {
+  FlatIntervalSet<int>::Builder builder;
+  builder.Add({10, 12});
+  builder.Add({1, 3});
+  builder.Add({4, 4});  // empty
+  builder.Add({2, 5});
+  builder.Add(12);      // abutting
+  builder.Add({20, 30});
+  builder.Add({22, 25});  // contained
+  const FlatIntervalSet<int> iset = builder.Build();
+  EXPECT_THAT(iset, ElementsAre(interval_type{1, 5}, interval_type{10, 13},
+                                interval_type{20, 30}));
+  // The builder is left empty.
+  EXPECT_TRUE(builder.Build().empty());
+
+  EXPECT_EQ(iset, (FlatIntervalSet<int>{{20, 30}, {1, 5}, {10, 13}}));
+  EXPECT_NE(iset, (FlatIntervalSet<int>{{1, 5}, {10, 13}}));
+  std::ostringstream stream;
+  stream << iset;
+  EXPECT_EQ(stream.str(), "[1, 5), [10, 13), [20, 30)");
+}
+
+TEST(FlatIntervalSetTest, FindAndLowerBound) {
+  const FlatIntervalSet<int> iset{{1, 3}, {5, 8}};
+  EXPECT_EQ(iset.LowerBound(0), iset.begin());
+  EXPECT_EQ(iset.LowerBound(2), iset.begin());
+  EXPECT_EQ(iset.LowerBound(3), iset.begin() + 1);
+  EXPECT_EQ(iset.LowerBound(8), iset.end());
+  EXPECT_EQ(iset.Find(4), iset.end());
+  EXPECT_EQ(iset.Find(7), iset.begin() + 1);
+  EXPECT_EQ(iset.Find(interval_type{5, 8}), iset.begin() + 1);
+  EXPECT_EQ(iset.Find(interval_type{2, 6}), iset.end());
+  EXPECT_EQ(iset.Find(interval_type{6, 6}), iset.end());  // empty
+}
+
+TEST(FlatIntervalSetTest, CursorSameAsContains) {
+  FlatIntervalSet<int>::Builder builder;
+  for (int i = 0; i < 200; ++i) builder.Add({i * 10, i * 10 + 1 + i % 7});
+  const FlatIntervalSet<int> iset = builder.Build();
+  // Queries in order, with gaps of different sizes.
+  for (int stride : {1, 3, 17, 500}) {
+    FlatIntervalSet<int>::Cursor cursor(iset);
+    for (int value = -5; value < 2100; value += stride) {
+      EXPECT_EQ(cursor.Contains(value), iset.Contains(value))
+          << value << ", stride " << stride;
+      // Repeated queries are the same.
+      EXPECT_EQ(cursor.Contains(value), iset.Contains(value)) << value;
+    }
+  }
+  // Queries out of order.
+  FlatIntervalSet<int>::Cursor cursor(iset);
+  for (int value : {1500, 3, 1994, 1991, 0, 2000, 995}) {
+    EXPECT_EQ(cursor.Contains(value), iset.Contains(value)) << value;
+  }
+}
+
 TEST(DisjointIntervalSetTest, DefaultCtor) {
   const IntIntervalSet iset;
   EXPECT_TRUE(iset.empty());
@@ -0,0 +1,186 @@
+// Copyright 2017-2023 The Verible Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "common/util/json_writer.h"
+
+#include <cstdint>
+#include <ostream>
+
+#include "absl/strings/string_view.h"
+#include "common/util/logging.h"
+#include "common/util/spacer.h"
+#include "nlohmann/json.hpp"
+
+namespace verible {
+
+// Escapes like nlohmann::json does without ensure_ascii.
+static void WriteQuoted(std::ostream& stream, absl::string_view text) {
+  static constexpr char kHex[] = "0123456789abcdef";
+  stream << '"';
+  auto unescaped_begin = text.begin();
+  for (auto iter = text.begin(); iter != text.end(); ++iter) {
+    const unsigned char c = *iter;
+    if (c >= 0x20 && c != '"' && c != '\\') continue;
+    stream.write(unescaped_begin, iter - unescaped_begin);
+    unescaped_begin = iter + 1;
+    switch (c) {
+      case '"':
+        stream << "\\\"";
+        break;
+      case '\\':
+        stream << "\\\\";
+        break;
+      case '\b':
+        stream << "\\b";
+        break;
+      case '\f':
+        stream << "\\f";
+        break;
+      case '\n':
+        stream << "\\n";
+        break;
+      case '\r':
+        stream << "\\r";
+        break;
+      case '\t':
+        stream << "\\t";
+        break;
+      default:
+        stream << "\\u00" << kHex[c >> 4] << kHex[c & 0xf];
+    }
+  }
+  stream.write(unescaped_begin, text.end() - unescaped_begin);
+  stream << '"';
+}
+
+void JsonWriter::NewLine(size_t depth) {
+  if (indent_ < 0) return;
+  stream_ << '\n' << Spacer(depth * indent_);
+}
+
+void JsonWriter::BeginValue() {
+  if (after_key_) {
+    after_key_ = false;
+    return;
+  }
+  if (scopes_.empty()) return;
+  Scope& scope = scopes_.back();
+  CHECK(!scope.is_object) << "JSON object member without key.";
+  if (scope.size++ > 0) stream_ << ',';
+  NewLine(scopes_.size());
+}
+
+JsonWriter& JsonWriter::Begin(bool is_object, char open) {
+  BeginValue();
+  stream_ << open;
+  scopes_.push_back(Scope{is_object, 0});
+  return *this;
+}
+
+JsonWriter& JsonWriter::End(char close) {
+  CHECK(!scopes_.empty() && !after_key_);
+  const bool empty = scopes_.back().size == 0;
+  scopes_.pop_back();
+  if (!empty) NewLine(scopes_.size());
+  stream_ << close;
+  return *this;
+}
+
+JsonWriter& JsonWriter::BeginObject() { return Begin(true, '{'); }
+
+JsonWriter& JsonWriter::EndObject() {
+  CHECK(!scopes_.empty() && scopes_.back().is_object);
+  return End('}');
+}
+
+JsonWriter& JsonWriter::BeginArray() { return Begin(false, '['); }
+
+JsonWriter& JsonWriter::EndArray() {
+  CHECK(!scopes_.empty() && !scopes_.back().is_object);
+  return End(']');
+}
+
+JsonWriter& JsonWriter::Key(absl::string_view key) {
+  CHECK(!scopes_.empty() && scopes_.back().is_object && !after_key_);
+  Scope& scope = scopes_.back();
+  if (scope.size++ > 0) stream_ << ',';
+  NewLine(scopes_.size());
+  WriteQuoted(stream_, key);
+  stream_ << (indent_ < 0 ? ":" : ": ");
+  after_key_ = true;
+  return *this;
+}
+
+JsonWriter& JsonWriter::Value(absl::string_view value) {
+  BeginValue();
+  WriteQuoted(stream_, value);
+  return *this;
+}
+
+JsonWriter& JsonWriter::Value(bool value) {
+  BeginValue();
+  stream_ << (value ? "true" : "false");
+  return *this;
+}
+
+JsonWriter& JsonWriter::WriteInteger(int64_t value) {
+  BeginValue();
+  stream_ << value;
+  return *this;
+}
+
+JsonWriter& JsonWriter::WriteUnsigned(uint64_t value) {
+  BeginValue();
+  stream_ << value;
+  return *this;
+}
+
+JsonWriter& JsonWriter::Value(const nlohmann::json& value) {
+  if (value.is_object()) {
+    BeginObject();
+    for (const auto& item : value.items()) {
+      Key(item.key());
+      Value(item.value());
+    }
+    return EndObject();
+  }
+  if (value.is_array()) {
+    BeginArray();
+    for (const auto& element : value) Value(element);
+    return EndArray();
+  }
+  BeginValue();
+  stream_ << value.dump();
+  return *this;
+}
+
+JsonWriter& JsonWriter::Null() {
+  BeginValue();
+  stream_ << "null";
+  return *this;
+}
+
+JsonWriter& JsonWriter::RawValue(absl::string_view json) {
+  BeginValue();
+  // Strings have their newlines escaped, so all newlines are indentation.
+  for (size_t newline; (newline = json.find('\n')) != json.npos;) {
+    stream_.write(json.data(), newline);
+    NewLine(scopes_.size());
+    json.remove_prefix(newline + 1);
+  }
+  stream_.write(json.data(), json.size());
+  return *this;
+}
+
+}  // namespace verible
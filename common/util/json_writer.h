@@ -0,0 +1,121 @@
+// Copyright 2017-2023 The Verible Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef VERIBLE_COMMON_UTIL_JSON_WRITER_H_
+#define VERIBLE_COMMON_UTIL_JSON_WRITER_H_
+
+#include <cstdint>
+#include <iosfwd>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+#include "absl/strings/string_view.h"
+#include "nlohmann/json.hpp"
+
+namespace verible {
+
+// JsonWriter writes a JSON document to a stream element by element, without
+// building it in memory first, so that huge documents can be written in
+// constant memory (apart from the nesting depth).
+//
+// Indented output is formatted exactly like nlohmann::json with
+// std::setw(indent), so the two are interchangeable.
+//
+// Example:
+//   JsonWriter writer(&std::cout);
+//   writer.BeginObject();
+//   writer.Key("numbers").BeginArray().Value(1).Value(2).EndArray();
+//   writer.EndObject();
+//
+// Keys are written in the order given; within an object, values must follow
+// their Key().  Strings are expected to be UTF-8 and written without
+// validation.
+class JsonWriter {
+ public:
+  // 'indent' is the number of spaces per nesting level; with a negative
+  // value, everything is written as compact as possible on one line.
+  explicit JsonWriter(std::ostream* stream, int indent = 2)
+      : stream_(*stream), indent_(indent) {}
+
+  JsonWriter(const JsonWriter&) = delete;
+  JsonWriter& operator=(const JsonWriter&) = delete;
+
+  JsonWriter& BeginObject();
+  JsonWriter& EndObject();
+  JsonWriter& BeginArray();
+  JsonWriter& EndArray();
+
+  // Starts a member of the current object; the value must follow.
+  JsonWriter& Key(absl::string_view key);
+
+  JsonWriter& Value(absl::string_view value);
+  JsonWriter& Value(const char* value) {
+    return Value(absl::string_view(value));
+  }
+  JsonWriter& Value(const std::string& value) {
+    return Value(absl::string_view(value));
+  }
+  JsonWriter& Value(bool value);
+  template <typename T, std::enable_if_t<std::is_integral_v<T> &&
+                                             !std::is_same_v<T, bool>,
+                                         bool> = true>
+  JsonWriter& Value(T value) {
+    if constexpr (std::is_signed_v<T>) {
+      return WriteInteger(static_cast<int64_t>(value));
+    } else {
+      return WriteUnsigned(static_cast<uint64_t>(value));
+    }
+  }
+
+  // Writes an already built JSON value, e.g. a small part of a bigger
+  // document.  Object members are written in nlohmann::json's (sorted) order.
+  JsonWriter& Value(const nlohmann::json& value);
+
+  JsonWriter& Null();
+
+  // Writes 'json', a complete value written by another JsonWriter with the
+  // same indent from nesting depth 0, re-indented to the current depth.
+  // This lets parts of a document be written concurrently, e.g. one per
+  // file, and then be assembled in order.
+  JsonWriter& RawValue(absl::string_view json);
+
+  // Returns true when every object and array has been closed.
+  bool Done() const { return scopes_.empty(); }
+
+ private:
+  struct Scope {
+    bool is_object;
+    int size;  // number of values written so far
+  };
+
+  JsonWriter& WriteInteger(int64_t value);
+  JsonWriter& WriteUnsigned(uint64_t value);
+
+  // Writes the separator and indentation that precede a value.
+  void BeginValue();
+  void NewLine(size_t depth);
+  JsonWriter& Begin(bool is_object, char open);
+  JsonWriter& End(char close);
+
+  std::ostream& stream_;
+  const int indent_;
+  std::vector<Scope> scopes_;
+  // True right after Key(), when the value needs no separator.
+  bool after_key_ = false;
+};
+
+}  // namespace verible
+
+#endif  // VERIBLE_COMMON_UTIL_JSON_WRITER_H_
@@ -0,0 +1,143 @@
+// Copyright 2017-2023 The Verible Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "common/util/json_writer.h"
+
+#include <iomanip>
+#include <sstream>
+#include <string>
+
+#include "gtest/gtest.h"
+#include "nlohmann/json.hpp"
+
+namespace verible {
+namespace {
+
+using nlohmann::json;
+
+std::string Dump(const json& value, int indent) {
+  return indent < 0 ? value.dump() : value.dump(indent);
+}
+
+TEST(JsonWriterTest, Scalars) {
+  std::ostringstream stream;
+  JsonWriter writer(&stream);
+  writer.BeginArray();
+  writer.Value(1).Value(-2).Value(3u).Value(true).Value(false).Null();
+  writer.Value("text").Value(std::string("string"));
+  writer.EndArray();
+  EXPECT_TRUE(writer.Done());
+  EXPECT_EQ(stream.str(),
+            Dump(json::array({1, -2, 3u, true, false, nullptr, "text",
+                              "string"}),
+                 2));
+}
+
+TEST(JsonWriterTest, EmptyContainers) {
+  for (const int indent : {-1, 0, 2, 4}) {
+    std::ostringstream stream;
+    JsonWriter writer(&stream, indent);
+    writer.BeginObject();
+    writer.Key("a").BeginArray().EndArray();
+    writer.Key("b").BeginObject().EndObject();
+    writer.EndObject();
+    EXPECT_EQ(stream.str(),
+              Dump(json{{"a", json::array()}, {"b", json::object()}}, indent))
+        << indent;
+  }
+}
+
+TEST(JsonWriterTest, NestedLikeNlohmann) {
+  const json expected = json::parse(R"({
+    "children": [
+      {"end": 6, "start": 0, "tag": "module"},
+      null,
+      {"children": [], "tag": "kModuleItemList"},
+      [[1, 2], []]
+    ],
+    "tag": "kDescriptionList"
+  })");
+  for (const int indent : {-1, 0, 2, 4}) {
+    std::ostringstream stream;
+    JsonWriter writer(&stream, indent);
+    writer.BeginObject();
+    writer.Key("children").BeginArray();
+    writer.BeginObject();
+    writer.Key("end").Value(6).Key("start").Value(0).Key("tag").Value("module");
+    writer.EndObject();
+    writer.Null();
+    writer.BeginObject();
+    writer.Key("children").BeginArray().EndArray();
+    writer.Key("tag").Value("kModuleItemList");
+    writer.EndObject();
+    writer.BeginArray();
+    writer.BeginArray().Value(1).Value(2).EndArray();
+    writer.BeginArray().EndArray();
+    writer.EndArray();
+    writer.EndArray();
+    writer.Key("tag").Value("kDescriptionList");
+    writer.EndObject();
+    EXPECT_TRUE(writer.Done());
+    EXPECT_EQ(stream.str(), Dump(expected, indent)) << indent;
+  }
+}
+
+TEST(JsonWriterTest, Escaping) {
+  const std::string text(
+      "quote\" backslash\\ slash/ \b\f\n\r\t \x01\x1f\x7f ü");
+  std::ostringstream stream;
+  JsonWriter writer(&stream);
+  writer.BeginObject().Key(text).Value(text).EndObject();
+  EXPECT_EQ(stream.str(), Dump(json{{text, text}}, 2));
+  EXPECT_EQ(json::parse(stream.str()).begin().value(), text);
+}
+
+TEST(JsonWriterTest, JsonValue) {
+  const json value = json::parse(R"({
+    "errors": [{"column": 4, "line": 0, "phase": "parse", "text": "x"}],
+    "stats": {"bytes": 12, "nested": {"empty": {}}}
+  })");
+  for (const int indent : {-1, 2}) {
+    std::ostringstream stream;
+    JsonWriter writer(&stream, indent);
+    writer.BeginArray().Value(value).Value(json(7)).EndArray();
+    EXPECT_EQ(stream.str(), Dump(json::array({value, 7}), indent)) << indent;
+  }
+}
+
+TEST(JsonWriterTest, RawValue) {
+  const json value = json::parse(R"({"a": [1, {"b": "x\ny"}], "c": {}})");
+  for (const int indent : {-1, 2}) {
+    std::ostringstream part;
+    JsonWriter(&part, indent).Value(value);
+    std::ostringstream stream;
+    JsonWriter writer(&stream, indent);
+    writer.BeginObject().Key("k").BeginArray().RawValue(part.str());
+    writer.RawValue("3").EndArray().EndObject();
+    EXPECT_EQ(stream.str(), Dump(json{{"k", json::array({value, 3})}}, indent))
+        << indent;
+  }
+}
+
+TEST(JsonWriterTest, MatchesSetwStreaming) {
+  const json value = json::parse(R"({"a": [1, {"b": null}], "c": "d"})");
+  std::ostringstream expected;
+  expected << std::setw(2) << value;
+  std::ostringstream stream;
+  JsonWriter(&stream).Value(value);
+  EXPECT_EQ(stream.str(), expected.str());
+}
+
+}  // namespace
+}  // namespace verible
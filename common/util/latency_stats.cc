@@ -0,0 +1,98 @@
+// Copyright 2017-2023 The Verible Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "common/util/latency_stats.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <map>
+#include <mutex>
+#include <ostream>
+#include <string>
+
+#include "absl/strings/str_format.h"
+#include "absl/strings/string_view.h"
+#include "absl/time/time.h"
+
+namespace verible {
+
+int LatencyHistogram::BucketOf(absl::Duration duration) {
+  const int64_t nanos = absl::ToInt64Nanoseconds(duration);
+  if (nanos <= 1) return 0;
+  const int bucket =
+      std::log2(static_cast<double>(nanos)) * kBucketsPerDoubling;
+  return std::min(bucket, kBuckets - 1);
+}
+
+void LatencyHistogram::Record(absl::Duration duration) {
+  duration = std::max(duration, absl::ZeroDuration());
+  ++count_;
+  total_ += duration;
+  min_ = std::min(min_, duration);
+  max_ = std::max(max_, duration);
+  ++buckets_[BucketOf(duration)];
+}
+
+absl::Duration LatencyHistogram::Percentile(double fraction) const {
+  if (count_ == 0) return absl::ZeroDuration();
+  const int64_t rank = std::max<int64_t>(
+      1, std::ceil(std::clamp(fraction, 0.0, 1.0) * count_));
+  if (rank == 1) return min_;
+  if (rank == count_) return max_;
+  int64_t seen = 0;
+  int bucket = 0;
+  for (; bucket < kBuckets - 1; ++bucket) {
+    seen += buckets_[bucket];
+    if (seen >= rank) break;
+  }
+  // The upper end of the bucket.
+  const absl::Duration estimate = absl::Nanoseconds(
+      std::exp2(static_cast<double>(bucket + 1) / kBucketsPerDoubling));
+  return std::clamp(estimate, min_, max_);
+}
+
+void LatencyStats::Record(absl::string_view name, absl::Duration duration) {
+  const std::lock_guard<std::mutex> l(lock_);
+  auto found = histograms_.find(name);
+  if (found == histograms_.end()) {
+    found = histograms_.emplace(std::string(name), LatencyHistogram()).first;
+  }
+  found->second.Record(duration);
+}
+
+std::map<std::string, LatencyHistogram> LatencyStats::Histograms() const {
+  const std::lock_guard<std::mutex> l(lock_);
+  return {histograms_.begin(), histograms_.end()};
+}
+
+void LatencyStats::Print(std::ostream *out) const {
+  *out << absl::StrFormat("%40s %9s %11s %9s %9s %9s\n", "", "count",
+                          "total ms", "p50 ms", "p99 ms", "max ms");
+  for (const auto &[name, histogram] : Histograms()) {
+    *out << absl::StrFormat(
+        "%40s %9d %11.1f %9.2f %9.2f %9.2f\n", name, histogram.count(),
+        absl::ToDoubleMilliseconds(histogram.total()),
+        absl::ToDoubleMilliseconds(histogram.Percentile(0.5)),
+        absl::ToDoubleMilliseconds(histogram.Percentile(0.99)),
+        absl::ToDoubleMilliseconds(histogram.max()));
+  }
+}
+
+LatencyStats &PhaseLatencies() {
+  static LatencyStats *const stats = new LatencyStats();
+  return *stats;
+}
+
+}  // namespace verible
@@ -0,0 +1,105 @@
+// Copyright 2017-2023 The Verible Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef VERIBLE_COMMON_UTIL_LATENCY_STATS_H
+#define VERIBLE_COMMON_UTIL_LATENCY_STATS_H
+
+#include <array>
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <mutex>
+#include <ostream>
+#include <string>
+#include <vector>
+
+#include "absl/strings/string_view.h"
+#include "absl/time/clock.h"
+#include "absl/time/time.h"
+#include "common/util/trace_events.h"
+
+namespace verible {
+
+// Distribution of durations, in buckets that grow geometrically, so that
+// percentiles can be estimated in constant space: within about 20% of the
+// actual value, and never outside of the recorded minimum and maximum.
+class LatencyHistogram {
+ public:
+  void Record(absl::Duration duration);
+
+  int64_t count() const { return count_; }
+  absl::Duration total() const { return total_; }
+  absl::Duration min() const { return min_; }
+  absl::Duration max() const { return max_; }
+
+  // Estimated duration that a "fraction" (0..1) of the recorded durations
+  // did not exceed, e.g. 0.99 for the 99th percentile. Zero if empty.
+  absl::Duration Percentile(double fraction) const;
+
+ private:
+  // Four buckets per doubling of nanoseconds, up to about 18 hours.
+  static constexpr int kBucketsPerDoubling = 4;
+  static constexpr int kBuckets = 46 * kBucketsPerDoubling;
+
+  static int BucketOf(absl::Duration duration);
+
+  int64_t count_ = 0;
+  absl::Duration total_;
+  absl::Duration min_ = absl::InfiniteDuration();
+  absl::Duration max_;
+  std::array<int64_t, kBuckets> buckets_ = {};
+};
+
+// Latency histograms by name, e.g. of each method of a server, or of each
+// phase of processing. Thread-safe.
+class LatencyStats {
+ public:
+  void Record(absl::string_view name, absl::Duration duration);
+
+  // Records the duration of "fun" under "name", and returns its result.
+  // It is also traced in PipelineTrace(), if enabled.
+  template <typename Fun>
+  auto Time(absl::string_view name, const Fun &fun) -> decltype(fun()) {
+    struct Recorder {
+      ~Recorder() {
+        const absl::Time end = absl::Now();
+        PipelineTrace().Record("latency", name, start, end);
+        stats->Record(name, end - start);
+      }
+      LatencyStats *stats;
+      absl::string_view name;
+      absl::Time start;
+    } recorder{this, name, absl::Now()};
+    return fun();
+  }
+
+  // Copy of the histograms, by name.
+  std::map<std::string, LatencyHistogram> Histograms() const;
+
+  // Prints a line per name with count, total, median, 99th percentile
+  // and maximum, in milliseconds.
+  void Print(std::ostream *out) const;
+
+ private:
+  mutable std::mutex lock_;
+  std::map<std::string, LatencyHistogram, std::less<>> histograms_;
+};
+
+// Latencies of the phases of processing, like parsing or linting, which
+// happen all over the place. For all of them to end up in the same
+// statistics of the process, they are recorded here.
+LatencyStats &PhaseLatencies();
+
+}  // namespace verible
+#endif  // VERIBLE_COMMON_UTIL_LATENCY_STATS_H
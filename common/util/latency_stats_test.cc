@@ -0,0 +1,99 @@
+// Copyright 2017-2023 The Verible Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "common/util/latency_stats.h"
+
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "absl/strings/match.h"
+#include "absl/time/time.h"
+#include "gtest/gtest.h"
+
+namespace verible {
+namespace {
+
+TEST(LatencyHistogramTest, Empty) {
+  const LatencyHistogram histogram;
+  EXPECT_EQ(histogram.count(), 0);
+  EXPECT_EQ(histogram.total(), absl::ZeroDuration());
+  EXPECT_EQ(histogram.Percentile(0.5), absl::ZeroDuration());
+}
+
+TEST(LatencyHistogramTest, SameDurationsAreExact) {
+  LatencyHistogram histogram;
+  for (int i = 0; i < 10; ++i) histogram.Record(absl::Milliseconds(3));
+  EXPECT_EQ(histogram.count(), 10);
+  EXPECT_EQ(histogram.total(), absl::Milliseconds(30));
+  EXPECT_EQ(histogram.Percentile(0.5), absl::Milliseconds(3));
+  EXPECT_EQ(histogram.Percentile(0.99), absl::Milliseconds(3));
+}
+
+TEST(LatencyHistogramTest, PercentilesAreClose) {
+  LatencyHistogram histogram;
+  for (int i = 1; i <= 1000; ++i) histogram.Record(absl::Microseconds(i));
+  EXPECT_EQ(histogram.min(), absl::Microseconds(1));
+  EXPECT_EQ(histogram.max(), absl::Microseconds(1000));
+  const absl::Duration p50 = histogram.Percentile(0.5);
+  EXPECT_GE(p50, absl::Microseconds(500));
+  EXPECT_LE(p50, absl::Microseconds(600));
+  const absl::Duration p99 = histogram.Percentile(0.99);
+  EXPECT_GE(p99, absl::Microseconds(990));
+  EXPECT_LE(p99, absl::Microseconds(1000));
+  EXPECT_EQ(histogram.Percentile(0), absl::Microseconds(1));
+  EXPECT_EQ(histogram.Percentile(1), absl::Microseconds(1000));
+}
+
+TEST(LatencyHistogramTest, ExtremeDurations) {
+  LatencyHistogram histogram;
+  histogram.Record(absl::ZeroDuration());
+  histogram.Record(absl::Hours(100));
+  EXPECT_EQ(histogram.Percentile(0.5), absl::ZeroDuration());
+  EXPECT_EQ(histogram.Percentile(1), absl::Hours(100));
+}
+
+TEST(LatencyStatsTest, RecordsByName) {
+  LatencyStats stats;
+  stats.Record("b", absl::Milliseconds(2));
+  stats.Record("a", absl::Milliseconds(1));
+  EXPECT_EQ(stats.Time("b", []() { return 42; }), 42);
+  const auto histograms = stats.Histograms();
+  ASSERT_EQ(histograms.size(), 2);
+  EXPECT_EQ(histograms.at("a").count(), 1);
+  EXPECT_EQ(histograms.at("b").count(), 2);
+
+  std::ostringstream out;
+  stats.Print(&out);
+  EXPECT_TRUE(absl::StrContains(out.str(), "p99"));
+  EXPECT_LT(out.str().find(" a "), out.str().find(" b "));
+}
+
+TEST(LatencyStatsTest, RecordsConcurrently) {
+  LatencyStats stats;
+  std::vector<std::thread> threads;
+  for (int t = 0; t < 4; ++t) {
+    threads.emplace_back([&stats]() {
+      for (int i = 0; i < 1000; ++i) {
+        stats.Record("phase", absl::Microseconds(i));
+      }
+    });
+  }
+  for (auto &thread : threads) thread.join();
+  EXPECT_EQ(stats.Histograms().at("phase").count(), 4000);
+}
+
+}  // namespace
+}  // namespace verible
@@ -0,0 +1,46 @@
+// Copyright 2017-2023 The Verible Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef VERIBLE_COMMON_UTIL_LINE_RANGES_FLAG_H_
+#define VERIBLE_COMMON_UTIL_LINE_RANGES_FLAG_H_
+
+#include <string>
+#include <vector>
+
+#include "absl/strings/string_view.h"
+
+namespace verible {
+
+// Type of the --lines flag of the tools, e.g.
+//   ABSL_FLAG(verible::LineRanges, lines, {}, "...");
+// Pseudo-singleton, so that repeated flag occurrences accumulate values.
+//   --flag x --flag y yields [x, y]
+// The ranges are validated later, e.g. with ParseInclusiveRanges() on
+// LineRanges::values.
+struct LineRanges {
+  // need to copy string, cannot just use string_view
+  using storage_type = std::vector<std::string>;
+  static storage_type values;
+};
+
+// Appends the comma-separated ranges of 'flag_arg' to LineRanges::values.
+bool AbslParseFlag(absl::string_view flag_arg, LineRanges* /* unused */,
+                   std::string* error);
+
+// Returns all of LineRanges::values, comma-separated.
+std::string AbslUnparseFlag(LineRanges /* unused */);
+
+}  // namespace verible
+
+#endif  // VERIBLE_COMMON_UTIL_LINE_RANGES_FLAG_H_
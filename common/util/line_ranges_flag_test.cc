@@ -0,0 +1,44 @@
+// Copyright 2017-2023 The Verible Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "common/util/line_ranges_flag.h"
+
+#include <string>
+
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+
+namespace verible {
+namespace {
+
+using ::testing::ElementsAre;
+
+TEST(LineRangesFlagTest, RepeatedFlagsAccumulate) {
+  LineRanges::values.clear();
+  LineRanges unused;
+  std::string error;
+  EXPECT_TRUE(AbslParseFlag("1-3,5", &unused, &error));
+  EXPECT_TRUE(AbslParseFlag("8", &unused, &error));
+  EXPECT_THAT(LineRanges::values, ElementsAre("1-3", "5", "8"));
+  EXPECT_EQ(AbslUnparseFlag(unused), "1-3,5,8");
+  LineRanges::values.clear();
+}
+
+TEST(LineRangesFlagTest, Empty) {
+  LineRanges::values.clear();
+  EXPECT_EQ(AbslUnparseFlag(LineRanges()), "");
+}
+
+}  // namespace
+}  // namespace verible
@@ -19,13 +19,29 @@
 #include <functional>
 #include <iostream>
 #include <map>
+#include <type_traits>
 #include <utility>
 
+#include "absl/container/flat_hash_map.h"
 #include "common/util/logging.h"
 #include "common/util/spacer.h"
 
 namespace verible {
 
+namespace internal {
+// Hash index of the subtrees of a MapTree node, see MapTree's KeyHash.
+template <typename K, typename Iter, typename KeyHash>
+struct MapTreeIndex {
+  using type = absl::flat_hash_map<K, Iter, KeyHash>;
+};
+
+// Without KeyHash, nodes have no index.
+template <typename K, typename Iter>
+struct MapTreeIndex<K, Iter, void> {
+  struct type {};
+};
+}  // namespace internal
+
 // MapTree is a hierarchical tree representation of values, where branches are
 // associated with keys.
 // This is one implementation of a 'trie' or 'prefix tree' data structure.
@@ -37,6 +53,10 @@ namespace verible {
 //     Copy-ability is only needed when deep-copying the tree.
 //   KeyComp is the comparator for K for ordering.
 //     KeyComp can be a heterogenous lookup comparator (C++14).
+//   KeyHash is an optional hash function for K.
+//     With KeyHash, nodes with many children maintain a hash index of them,
+//     which makes Find() O(1) instead of O(lg N).  Iteration is still in
+//     key-order.
 //
 // Key-value pairs are co-located together, and are iterator-stable, meaning
 // that insertion/deletion operations do not invalidate existing iterators
@@ -71,9 +91,10 @@ namespace verible {
 // * File-system like structures, with string-like K.
 //   * Navigation through parent directories uses upward links.
 //
-template <typename K, typename V, typename KeyComp = std::less<K>>
+template <typename K, typename V, typename KeyComp = std::less<K>,
+          typename KeyHash = void>
 class MapTree {
-  using this_type = MapTree<K, V, KeyComp>;
+  using this_type = MapTree<K, V, KeyComp, KeyHash>;
 
   // Self-recursive type that holds subtrees.
   // A std::map is chosen for key-value co-location and iterator stability.
@@ -81,6 +102,15 @@ class MapTree {
   // remain const.
   using subtrees_type = std::map<K, this_type, KeyComp>;
 
+  static constexpr bool kIndexed = !std::is_void_v<KeyHash>;
+  using index_type =
+      typename internal::MapTreeIndex<K, typename subtrees_type::iterator,
+                                      KeyHash>::type;
+
+  // Nodes with at least this many children are indexed (with KeyHash).
+  // Smaller maps are about as fast to search.
+  static constexpr size_t kMinIndexedSize = 16;
+
  public:
   using key_type = K;
   using node_value_type = V;
@@ -97,12 +127,15 @@ class MapTree {
         // new copy is disconnected from original parent and is a new root
         parent_(nullptr) {
     Relink();
+    Reindex();
   }
 
   // move (with relink)
+  // Moving a std::map keeps its elements, so the index stays valid.
   MapTree(MapTree&& other) noexcept
       : node_value_(std::move(other.node_value_)),
         subtrees_(std::move(other.subtrees_)),
+        index_(std::move(other.index_)),
         // Retain existing parent.
         parent_(other.parent_) {
     Relink();
@@ -144,6 +177,8 @@ class MapTree {
   void swap(this_type& other) {
     std::swap(node_value_, other.node_value_);
     subtrees_.swap(other.subtrees_);
+    // Swapping std::maps keeps their elements, so the indexes stay valid.
+    std::swap(index_, other.index_);
     Relink();
     other.Relink();
   }
@@ -175,10 +210,30 @@ class MapTree {
     if (p.second) {
       // Link child to parent.
       p.first->second.parent_ = this;
+      AddToIndex(p.first);
     }
     return p;
   }
 
+  // Moves the subtree at 'pos' of 'other' into this node under 'key', unless
+  // this node already has a subtree at 'key', in which case nothing is moved.
+  // The moved nodes keep their addresses, so pointers to them remain valid.
+  // Returns (iterator, bool), where iterator points to the element at 'key'
+  // (moved, or already there), and true to indicate that it was moved.
+  std::pair<iterator, bool> TrySplice(const key_type& key, this_type* other,
+                                      iterator pos) {
+    const auto found = Find(key);
+    if (found != subtrees_.end()) return {found, false};
+    other->RemoveFromIndex(pos->first);
+    auto handle = other->subtrees_.extract(pos);
+    handle.key() = key;
+    const auto inserted = subtrees_.insert(std::move(handle));
+    // Link child to its new parent.
+    inserted.position->second.parent_ = this;
+    AddToIndex(inserted.position);
+    return {inserted.position, true};
+  }
+
   // No-op base case for variadic EmplacePairs().
   void EmplacePairs() const {}
 
@@ -193,6 +248,7 @@ class MapTree {
     if (p.second) {
       // Link child to parent.
       p.first->second.parent_ = this;
+      AddToIndex(p.first);
     }
     // Emplace the remaining items.
     EmplacePairs(std::forward<Args>(args)...);
@@ -201,7 +257,17 @@ class MapTree {
   // TODO(fangism): TryEmplaceHint(), like map::emplace_hint.
 
   // Erasure
-  // TODO(fangism): void Erase(key);
+
+  // Removes the subtree at 'pos', and returns the iterator following it.
+  // Unlike erasing by key, this does not compare keys, so it is usable even
+  // if the removed key's referenced memory is no longer valid.
+  // For the same reason, this drops the hash index (without hashing keys),
+  // which is rebuilt by the next insertion.
+  // Iterators to other subtrees remain valid.
+  iterator Erase(const_iterator pos) {
+    if constexpr (kIndexed) index_.clear();
+    return subtrees_.erase(pos);
+  }
 
   // Iteration/Navigation
 
@@ -291,17 +357,29 @@ class MapTree {
   // Search
 
   // Returns an iterator located at 'key' or end() if not found.
-  // O(lg N), same as underlying map type.
+  // O(lg N), same as underlying map type, or O(1) if indexed.
   template <typename AnyKey>
   iterator Find(AnyKey&& key) {
+    if constexpr (kIndexed && std::is_convertible_v<AnyKey&&, const K&>) {
+      if (!index_.empty()) {
+        const auto found = index_.find(key);
+        return found != index_.end() ? found->second : subtrees_.end();
+      }
+    }
     // Forward to underlying map::find, enabling heterogenous lookup.
     return subtrees_.find(std::forward<AnyKey>(key));
   }
 
   // Returns a const_iterator located at 'key' or end() if not found.
-  // O(lg N), same as underlying map type.
+  // O(lg N), same as underlying map type, or O(1) if indexed.
   template <typename AnyKey>
   const_iterator Find(AnyKey&& key) const {
+    if constexpr (kIndexed && std::is_convertible_v<AnyKey&&, const K&>) {
+      if (!index_.empty()) {
+        const auto found = index_.find(key);
+        return found != index_.end() ? found->second : subtrees_.end();
+      }
+    }
     // Forward to underlying map::find, enabling heterogenous lookup.
     return subtrees_.find(std::forward<AnyKey>(key));
   }
@@ -410,6 +488,34 @@ class MapTree {
     }
   }
 
+  // Rebuilds the index, if this node is large enough to be indexed.
+  void Reindex() {
+    if constexpr (kIndexed) {
+      index_.clear();
+      if (subtrees_.size() < kMinIndexedSize) return;
+      index_.reserve(subtrees_.size());
+      for (auto iter = subtrees_.begin(); iter != subtrees_.end(); ++iter) {
+        index_.emplace(iter->first, iter);
+      }
+    }
+  }
+
+  // Maintains the index after inserting the subtree at 'pos'.
+  void AddToIndex(iterator pos) {
+    if constexpr (kIndexed) {
+      if (index_.empty()) {
+        Reindex();
+      } else {
+        index_.emplace(pos->first, pos);
+      }
+    }
+  }
+
+  // Maintains the index before extracting the subtree at 'key'.
+  void RemoveFromIndex(const K& key) {
+    if constexpr (kIndexed) index_.erase(key);
+  }
+
  private:  // data
   // Singular value stored at this node.
   node_value_type node_value_;
@@ -417,6 +523,10 @@ class MapTree {
   // Collection of subtrees
   subtrees_type subtrees_;
 
+  // With KeyHash: the subtrees by key, if there are at least kMinIndexedSize
+  // of them and none was erased since the last insertion, otherwise empty.
+  index_type index_;
+
   // Pointer to parent node, or nullptr if this is a root node.
   this_type* parent_ = nullptr;
 };
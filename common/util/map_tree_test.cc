@@ -14,9 +14,12 @@
 
 #include "common/util/map_tree.h"
 
+#include <functional>
 #include <sstream>
 #include <string>
+#include <utility>
 
+#include "absl/strings/str_cat.h"
 #include "absl/strings/string_view.h"
 #include "common/util/spacer.h"
 #include "gmock/gmock.h"
@@ -191,6 +194,121 @@ TEST(MapTreeTest, EmplaceSecondKey) {
   EXPECT_EQ(m.Find(9), first_iter);  // iterator stability on insert
 }
 
+TEST(MapTreeTest, EraseChild) {
+  MapTreeTestType m("foo",  //
+                    KV{2, MapTreeTestType("bar")},
+                    KV{5, MapTreeTestType("baz", KV{1, MapTreeTestType("x")})},
+                    KV{7, MapTreeTestType("zzr")});
+  const auto last_iter = m.Find(7);
+  const auto next = m.Erase(m.Find(5));
+  EXPECT_EQ(next, last_iter);
+  EXPECT_EQ(m.Children().size(), 2);
+  EXPECT_EQ(m.Find(5), m.end());
+  EXPECT_EQ(m.Find(7), last_iter);  // iterator stability on erase
+  EXPECT_EQ(m.Find(2)->second.Value(), "bar");
+  EXPECT_TRUE(m.CheckIntegrity());
+
+  EXPECT_EQ(m.Erase(last_iter), m.end());
+  EXPECT_EQ(m.Children().size(), 1);
+}
+
+TEST(MapTreeTest, TrySpliceChild) {
+  MapTreeTestType m("foo", KV{2, MapTreeTestType("bar")});
+  MapTreeTestType other(
+      "other",  //
+      KV{2, MapTreeTestType("dup")},
+      KV{5, MapTreeTestType("baz", KV{1, MapTreeTestType("x")})});
+  const MapTreeTestType* baz = &other.Find(5)->second;
+  const MapTreeTestType* x = &baz->Find(1)->second;
+
+  // Moved nodes keep their addresses.
+  const auto moved = m.TrySplice(6, &other, other.Find(5));
+  EXPECT_TRUE(moved.second);
+  EXPECT_EQ(moved.first->first, 6);
+  EXPECT_EQ(&moved.first->second, baz);
+  EXPECT_EQ(baz->Parent(), &m);
+  EXPECT_EQ(&baz->Find(1)->second, x);
+  EXPECT_EQ(x->Root(), &m);
+  EXPECT_EQ(other.Find(5), other.end());
+  EXPECT_EQ(m.Children().size(), 2);
+  EXPECT_TRUE(m.CheckIntegrity());
+
+  // Existing keys are not replaced.
+  const auto existing = m.TrySplice(2, &other, other.Find(2));
+  EXPECT_FALSE(existing.second);
+  EXPECT_EQ(existing.first->second.Value(), "bar");
+  EXPECT_EQ(other.Find(2)->second.Value(), "dup");
+  EXPECT_EQ(m.Children().size(), 2);
+}
+
+using IndexedMapTreeTestType =
+    MapTree<int, std::string, std::less<int>, std::hash<int>>;
+using IndexedKV = IndexedMapTreeTestType::key_value_type;
+
+// Expects that all keys in [0, size) are found, in order, and no others.
+static void ExpectIndexedKeys(const IndexedMapTreeTestType& m, int size) {
+  EXPECT_EQ(m.Children().size(), size);
+  int expected_key = 0;
+  for (const auto& child : m) EXPECT_EQ(child.first, expected_key++);
+  for (int key = 0; key < size; ++key) {
+    const auto found = m.Find(key);
+    ASSERT_NE(found, m.end()) << key;
+    EXPECT_EQ(found->first, key);
+    EXPECT_EQ(found->second.Parent(), &m);
+  }
+  EXPECT_EQ(m.Find(-1), m.end());
+  EXPECT_EQ(m.Find(size), m.end());
+}
+
+TEST(MapTreeTest, IndexedFind) {
+  IndexedMapTreeTestType m("root");
+  // Insert in reverse, so that iteration order differs from insertion order.
+  for (int key = 99; key >= 0; --key) {
+    EXPECT_TRUE(m.TryEmplace(key, absl::StrCat(key)).second);
+    EXPECT_FALSE(m.TryEmplace(key, "dup").second);
+  }
+  ExpectIndexedKeys(m, 100);
+  EXPECT_EQ(m.Find(42)->second.Value(), "42");
+
+  // Erasing drops the index, and the next insertion rebuilds it.
+  m.Erase(m.Find(99));
+  ExpectIndexedKeys(m, 99);
+  EXPECT_TRUE(m.TryEmplace(99, "99").second);
+  ExpectIndexedKeys(m, 100);
+
+  // Copies and moves have indexes of their own.
+  const IndexedMapTreeTestType copy(m);
+  ExpectIndexedKeys(copy, 100);
+  IndexedMapTreeTestType moved(std::move(m));
+  ExpectIndexedKeys(moved, 100);
+  EXPECT_TRUE(moved.TryEmplace(100, "100").second);
+  ExpectIndexedKeys(moved, 101);
+}
+
+TEST(MapTreeTest, IndexedTrySplice) {
+  IndexedMapTreeTestType m("foo");
+  IndexedMapTreeTestType other("other");
+  for (int key = 0; key < 50; ++key) {
+    other.TryEmplace(key, absl::StrCat(key));
+  }
+  while (other.begin() != other.end()) {
+    const int key = other.begin()->first;
+    EXPECT_TRUE(m.TrySplice(key, &other, other.begin()).second);
+    EXPECT_EQ(other.Find(key), other.end());
+  }
+  ExpectIndexedKeys(m, 50);
+  EXPECT_TRUE(m.CheckIntegrity());
+}
+
+TEST(MapTreeTest, IndexedInitialization) {
+  IndexedMapTreeTestType m("foo",  //
+                           IndexedKV{1, IndexedMapTreeTestType("bar")},
+                           IndexedKV{0, IndexedMapTreeTestType("baz")});
+  ExpectIndexedKeys(m, 2);
+  for (int key = 2; key < 20; ++key) m.TryEmplace(key, "more");
+  ExpectIndexedKeys(m, 20);
+}
+
 TEST(MapTreeTest, InitializeMultipleChildrenWithDuplicateKey) {
   const MapTreeTestType m("foo",  //
                           KV{4, MapTreeTestType("bbb")},
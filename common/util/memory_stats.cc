@@ -0,0 +1,139 @@
+// Copyright 2017-2023 The Verible Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+
+#include "common/util/memory_stats.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <mutex>
+#include <ostream>
+#include <string>
+
+#include "absl/strings/ascii.h"
+#include "absl/strings/numbers.h"
+#include "absl/strings/str_format.h"
+#include "absl/strings/string_view.h"
+#include "absl/strings/strip.h"
+
+#ifndef _WIN32
+#include <sys/resource.h>
+#endif
+
+namespace verible {
+
+void MemoryStats::Allocate(absl::string_view name, int64_t bytes) {
+  if (!Enabled()) return;
+  const std::lock_guard<std::mutex> l(lock_);
+  auto found = counters_.find(name);
+  if (found == counters_.end()) {
+    found = counters_.emplace(std::string(name), MemoryCounter()).first;
+  }
+  MemoryCounter &counter = found->second;
+  counter.allocated += bytes;
+  counter.live += bytes;
+  counter.peak = std::max(counter.peak, counter.live);
+}
+
+void MemoryStats::Release(absl::string_view name, int64_t bytes) {
+  if (!Enabled()) return;
+  const std::lock_guard<std::mutex> l(lock_);
+  const auto found = counters_.find(name);
+  if (found != counters_.end()) found->second.live -= bytes;
+}
+
+std::map<std::string, MemoryCounter> MemoryStats::Counters() const {
+  const std::lock_guard<std::mutex> l(lock_);
+  return {counters_.begin(), counters_.end()};
+}
+
+static double MiB(int64_t bytes) { return bytes / (1024.0 * 1024.0); }
+
+void MemoryStats::Print(std::ostream *out) const {
+  *out << absl::StrFormat("%40s %14s %11s %11s\n", "", "allocated MiB",
+                          "peak MiB", "live MiB");
+  for (const auto &[name, counter] : Counters()) {
+    *out << absl::StrFormat("%40s %14.2f %11.2f %11.2f\n", name,
+                            MiB(counter.allocated), MiB(counter.peak),
+                            MiB(counter.live));
+  }
+  *out << absl::StrFormat("%40s %14.2f\n", "peak resident set size",
+                          MiB(PeakResidentSetBytes()));
+}
+
+MemoryStats &SubsystemMemory() {
+  static MemoryStats *const stats = new MemoryStats();
+  return *stats;
+}
+
+void EnableSubsystemMemoryStats() {
+  SubsystemMemory().Enable();
+  std::atexit([]() { SubsystemMemory().Print(&std::cerr); });
+}
+
+#ifdef __linux__
+// Returns the VmHWM of the process, which unlike getrusage() can be reset,
+// or 0 if unknown.
+static int64_t HighWaterMarkBytes() {
+  std::ifstream status("/proc/self/status");
+  std::string line;
+  while (std::getline(status, line)) {
+    absl::string_view value = line;
+    int64_t kib;
+    if (absl::ConsumePrefix(&value, "VmHWM:") &&
+        absl::SimpleAtoi(
+            absl::StripSuffix(absl::StripAsciiWhitespace(value), " kB"),
+            &kib)) {
+      return kib * 1024;
+    }
+  }
+  return 0;
+}
+#endif
+
+int64_t PeakResidentSetBytes() {
+#ifdef _WIN32
+  return 0;
+#else
+#ifdef __linux__
+  if (const int64_t high_water_mark = HighWaterMarkBytes()) {
+    return high_water_mark;
+  }
+#endif
+  struct rusage usage;
+  if (getrusage(RUSAGE_SELF, &usage) != 0) return 0;
+#ifdef __APPLE__
+  return usage.ru_maxrss;  // bytes
+#else
+  return static_cast<int64_t>(usage.ru_maxrss) * 1024;  // KiB
+#endif
+#endif
+}
+
+bool ResetPeakResidentSetBytes() {
+#ifdef __linux__
+  std::ofstream clear_refs("/proc/self/clear_refs");
+  clear_refs << "5";
+  clear_refs.flush();
+  return clear_refs.good();
+#else
+  return false;
+#endif
+}
+
+}  // namespace verible
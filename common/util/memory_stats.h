@@ -0,0 +1,88 @@
+// Copyright 2017-2023 The Verible Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+
+#ifndef VERIBLE_COMMON_UTIL_MEMORY_STATS_H
+#define VERIBLE_COMMON_UTIL_MEMORY_STATS_H
+
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <mutex>
+#include <ostream>
+#include <string>
+
+#include "absl/strings/string_view.h"
+
+namespace verible {
+
+// Bytes used by one subsystem, as counted by the subsystem itself.
+// Subsystems that do not report releases have the same live and allocated
+// bytes.
+struct MemoryCounter {
+  // All bytes ever allocated.
+  int64_t allocated = 0;
+  // Allocated bytes that were not released yet, and their maximum.
+  int64_t live = 0;
+  int64_t peak = 0;
+};
+
+// Memory counters by subsystem, e.g. of syntax tree arenas or lexed tokens.
+// Accounting is opt-in: nothing is counted until Enable() is called, and
+// subsystems check Enabled() before they work out the sizes to count.
+// Thread-safe.
+class MemoryStats {
+ public:
+  void Enable() { enabled_.store(true, std::memory_order_relaxed); }
+  bool Enabled() const { return enabled_.load(std::memory_order_relaxed); }
+
+  // Counts 'bytes' allocated, or released, by subsystem 'name'.
+  // Does nothing unless Enabled().
+  void Allocate(absl::string_view name, int64_t bytes);
+  void Release(absl::string_view name, int64_t bytes);
+
+  // Copy of the counters, by name.
+  std::map<std::string, MemoryCounter> Counters() const;
+
+  // Prints a line per name with allocated, peak and live MiB, followed by
+  // the peak resident set size of the process.
+  void Print(std::ostream *out) const;
+
+ private:
+  std::atomic<bool> enabled_{false};
+  mutable std::mutex lock_;
+  std::map<std::string, MemoryCounter, std::less<>> counters_;
+};
+
+// Memory of the subsystems, like lexing or parsing, which are used all over
+// the place. For all of them to end up in the same statistics of the
+// process, they are counted here.  Tools enable it with --print_memory_stats.
+MemoryStats &SubsystemMemory();
+
+// Enables SubsystemMemory(), and prints it to stderr when the process exits,
+// for --print_memory_stats.
+void EnableSubsystemMemoryStats();
+
+// Returns the peak resident set size of the process in bytes, or 0 where
+// this is not known.
+int64_t PeakResidentSetBytes();
+
+// Resets the peak resident set size to the current one, so that the peak of
+// a stage of processing can be measured. Returns false where this is not
+// supported (only Linux is), and then the peak is that of the process.
+bool ResetPeakResidentSetBytes();
+
+}  // namespace verible
+#endif  // VERIBLE_COMMON_UTIL_MEMORY_STATS_H
@@ -0,0 +1,112 @@
+// Copyright 2017-2023 The Verible Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+
+#include "common/util/memory_stats.h"
+
+#include <cstdint>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "absl/strings/match.h"
+#include "gtest/gtest.h"
+
+namespace verible {
+namespace {
+
+TEST(MemoryStatsTest, NothingCountedUntilEnabled) {
+  MemoryStats stats;
+  EXPECT_FALSE(stats.Enabled());
+  stats.Allocate("tokens", 100);
+  EXPECT_TRUE(stats.Counters().empty());
+  stats.Enable();
+  EXPECT_TRUE(stats.Enabled());
+  stats.Allocate("tokens", 100);
+  EXPECT_EQ(stats.Counters().at("tokens").allocated, 100);
+}
+
+TEST(MemoryStatsTest, LiveAndPeakBytes) {
+  MemoryStats stats;
+  stats.Enable();
+  stats.Allocate("arena", 100);
+  stats.Allocate("arena", 50);
+  stats.Release("arena", 120);
+  stats.Allocate("arena", 10);
+  stats.Allocate("tokens", 7);
+  const auto counters = stats.Counters();
+  ASSERT_EQ(counters.size(), 2u);
+  const MemoryCounter& arena = counters.at("arena");
+  EXPECT_EQ(arena.allocated, 160);
+  EXPECT_EQ(arena.live, 40);
+  EXPECT_EQ(arena.peak, 150);
+  const MemoryCounter& tokens = counters.at("tokens");
+  EXPECT_EQ(tokens.allocated, 7);
+  EXPECT_EQ(tokens.live, 7);
+  EXPECT_EQ(tokens.peak, 7);
+}
+
+TEST(MemoryStatsTest, ConcurrentAllocations) {
+  MemoryStats stats;
+  stats.Enable();
+  std::vector<std::thread> threads;
+  for (int t = 0; t < 4; ++t) {
+    threads.emplace_back([&stats]() {
+      for (int i = 0; i < 1000; ++i) {
+        stats.Allocate("blocks", 2);
+        stats.Release("blocks", 1);
+      }
+    });
+  }
+  for (auto& thread : threads) thread.join();
+  const MemoryCounter counter = stats.Counters().at("blocks");
+  EXPECT_EQ(counter.allocated, 8000);
+  EXPECT_EQ(counter.live, 4000);
+}
+
+TEST(MemoryStatsTest, Print) {
+  MemoryStats stats;
+  stats.Enable();
+  stats.Allocate("syntax tree arena", 3 << 20);
+  std::ostringstream out;
+  stats.Print(&out);
+  EXPECT_TRUE(absl::StrContains(out.str(), "allocated MiB")) << out.str();
+  EXPECT_TRUE(absl::StrContains(out.str(), "syntax tree arena           3.00"))
+      << out.str();
+  EXPECT_TRUE(absl::StrContains(out.str(), "peak resident set size"))
+      << out.str();
+}
+
+TEST(MemoryStatsTest, PeakResidentSetSize) {
+#ifndef _WIN32
+  EXPECT_GT(PeakResidentSetBytes(), 0);
+#endif
+}
+
+TEST(MemoryStatsTest, ResetPeakResidentSetSize) {
+  // Touch memory so that the peak is well above what is resident after.
+  constexpr size_t kSize = 64 << 20;
+  {
+    std::vector<char> touched(kSize, 1);
+    EXPECT_EQ(touched[kSize - 1], 1);
+  }
+  const int64_t peak = PeakResidentSetBytes();
+  if (!ResetPeakResidentSetBytes()) return;  // not supported here
+  EXPECT_LE(PeakResidentSetBytes(), peak);
+  EXPECT_GT(PeakResidentSetBytes(), 0);
+}
+
+}  // namespace
+}  // namespace verible
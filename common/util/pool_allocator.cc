@@ -0,0 +1,138 @@
+// Copyright 2017-2023 The Verible Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "common/util/pool_allocator.h"
+
+#include <array>
+#include <cstddef>
+#include <new>
+
+namespace verible {
+namespace pool_allocator_internal {
+namespace {
+
+// Smallest size class, large enough to hold a free list link.
+constexpr size_t kMinClassShift = 4;
+// Larger allocations bypass the pool.
+constexpr size_t kMaxClassShift = 16;
+constexpr size_t kNumClasses = kMaxClassShift - kMinClassShift + 1;
+// Upper bound of the bytes kept in each free list, so that a burst of freed
+// storage is not held forever.
+constexpr size_t kMaxPooledBytesPerClass = size_t{1} << 20;
+
+// Returns the index of the smallest size class that fits 'bytes', or
+// kNumClasses if there is none.
+size_t SizeClass(size_t bytes) {
+  size_t size_class = 0;
+  while (size_class < kNumClasses &&
+         (size_t{1} << (size_class + kMinClassShift)) < bytes) {
+    ++size_class;
+  }
+  return size_class;
+}
+
+size_t ClassBytes(size_t size_class) {
+  return size_t{1} << (size_class + kMinClassShift);
+}
+
+struct FreeBlock {
+  FreeBlock* next;
+};
+
+// Set once the calling thread's free lists are destroyed.  Storage freed
+// after that (e.g. by other thread-local objects) goes directly to the heap.
+thread_local bool free_lists_destroyed = false;
+
+class FreeLists {
+ public:
+  FreeLists() = default;
+
+  FreeLists(const FreeLists&) = delete;
+  FreeLists& operator=(const FreeLists&) = delete;
+
+  ~FreeLists() {
+    free_lists_destroyed = true;
+    for (size_t size_class = 0; size_class < kNumClasses; ++size_class) {
+      while (heads_[size_class] != nullptr) {
+        ::operator delete(Pop(size_class));
+      }
+    }
+  }
+
+  void* Pop(size_t size_class) {
+    FreeBlock* block = heads_[size_class];
+    if (block == nullptr) return nullptr;
+    heads_[size_class] = block->next;
+    --counts_[size_class];
+    return block;
+  }
+
+  // Returns false if the free list is full.
+  bool Push(size_t size_class, void* storage) {
+    if ((counts_[size_class] + 1) * ClassBytes(size_class) >
+        kMaxPooledBytesPerClass) {
+      return false;
+    }
+    heads_[size_class] = new (storage) FreeBlock{heads_[size_class]};
+    ++counts_[size_class];
+    return true;
+  }
+
+  size_t PooledBytes() const {
+    size_t bytes = 0;
+    for (size_t size_class = 0; size_class < kNumClasses; ++size_class) {
+      bytes += counts_[size_class] * ClassBytes(size_class);
+    }
+    return bytes;
+  }
+
+ private:
+  std::array<FreeBlock*, kNumClasses> heads_ = {};
+  std::array<size_t, kNumClasses> counts_ = {};
+};
+
+// Returns the free lists of the calling thread, or nullptr if they are gone.
+FreeLists* ThreadFreeLists() {
+  if (free_lists_destroyed) return nullptr;
+  static thread_local FreeLists free_lists;
+  return &free_lists;
+}
+
+}  // namespace
+
+void* Allocate(size_t bytes) {
+  const size_t size_class = SizeClass(bytes);
+  if (size_class == kNumClasses) return ::operator new(bytes);
+  FreeLists* free_lists = ThreadFreeLists();
+  void* storage = free_lists ? free_lists->Pop(size_class) : nullptr;
+  if (storage != nullptr) return storage;
+  return ::operator new(ClassBytes(size_class));
+}
+
+void Deallocate(void* storage, size_t bytes) {
+  const size_t size_class = SizeClass(bytes);
+  if (size_class < kNumClasses) {
+    FreeLists* free_lists = ThreadFreeLists();
+    if (free_lists && free_lists->Push(size_class, storage)) return;
+  }
+  ::operator delete(storage);
+}
+
+size_t PooledBytes() {
+  const FreeLists* free_lists = ThreadFreeLists();
+  return free_lists ? free_lists->PooledBytes() : 0;
+}
+
+}  // namespace pool_allocator_internal
+}  // namespace verible
@@ -0,0 +1,78 @@
+// Copyright 2017-2023 The Verible Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef VERIBLE_COMMON_UTIL_POOL_ALLOCATOR_H_
+#define VERIBLE_COMMON_UTIL_POOL_ALLOCATOR_H_
+
+#include <cstddef>
+#include <new>
+
+namespace verible {
+namespace pool_allocator_internal {
+
+// Returns storage of at least 'bytes' bytes, aligned for any fundamental type.
+void* Allocate(size_t bytes);
+
+// Returns storage obtained from Allocate(bytes) to the pool.
+void Deallocate(void* storage, size_t bytes);
+
+// Returns the number of bytes held in free lists of the calling thread.
+size_t PooledBytes();
+
+}  // namespace pool_allocator_internal
+
+// PoolAllocator is a stateless allocator that recycles storage.
+// Storage is handed out in power-of-two size classes, and freed storage is
+// kept in per-thread free lists for reuse by later allocations of the same
+// size class, instead of being returned to the heap.  Storage may be freed by
+// a different thread than the one that allocated it.
+//
+// This is useful for containers that are frequently (re)allocated and freed,
+// e.g. the children of tree nodes that are restructured many times.
+// All PoolAllocators compare equal, so containers using them can be moved
+// and swapped in O(1).
+template <typename T>
+class PoolAllocator {
+ public:
+  using value_type = T;
+
+  PoolAllocator() = default;
+
+  template <typename U>
+  PoolAllocator(const PoolAllocator<U>&) {}  // NOLINT: implicit
+
+  T* allocate(size_t n) {
+    static_assert(alignof(T) <= __STDCPP_DEFAULT_NEW_ALIGNMENT__,
+                  "Over-aligned types are not supported.");
+    return static_cast<T*>(pool_allocator_internal::Allocate(n * sizeof(T)));
+  }
+
+  void deallocate(T* p, size_t n) {
+    pool_allocator_internal::Deallocate(p, n * sizeof(T));
+  }
+
+  template <typename U>
+  bool operator==(const PoolAllocator<U>&) const {
+    return true;
+  }
+
+  template <typename U>
+  bool operator!=(const PoolAllocator<U>&) const {
+    return false;
+  }
+};
+
+}  // namespace verible
+
+#endif  // VERIBLE_COMMON_UTIL_POOL_ALLOCATOR_H_
@@ -0,0 +1,78 @@
+// Copyright 2017-2023 The Verible Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "common/util/pool_allocator.h"
+
+#include <numeric>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "gtest/gtest.h"
+
+namespace verible {
+namespace {
+
+using pool_allocator_internal::PooledBytes;
+
+TEST(PoolAllocatorTest, ReusesFreedStorageOfSameSizeClass) {
+  PoolAllocator<char> allocator;
+  char* first = allocator.allocate(100);
+  allocator.deallocate(first, 100);
+  const size_t pooled = PooledBytes();
+  EXPECT_GE(pooled, 100);
+  char* second = allocator.allocate(90);
+  EXPECT_EQ(second, first);
+  EXPECT_LT(PooledBytes(), pooled);
+  allocator.deallocate(second, 90);
+}
+
+TEST(PoolAllocatorTest, LargeStorageIsNotPooled) {
+  PoolAllocator<char> allocator;
+  const size_t pooled = PooledBytes();
+  char* large = allocator.allocate(1 << 20);
+  allocator.deallocate(large, 1 << 20);
+  EXPECT_EQ(PooledBytes(), pooled);
+}
+
+TEST(PoolAllocatorTest, AllAllocatorsAreEqual) {
+  EXPECT_TRUE(PoolAllocator<int>() == PoolAllocator<std::string>());
+  EXPECT_FALSE(PoolAllocator<int>() != PoolAllocator<int>());
+}
+
+TEST(PoolAllocatorTest, Containers) {
+  std::vector<std::string, PoolAllocator<std::string>> strings;
+  for (int i = 0; i < 1000; ++i) strings.push_back(std::to_string(i));
+  std::vector<std::string, PoolAllocator<std::string>> moved(
+      std::move(strings));
+  ASSERT_EQ(moved.size(), 1000);
+  EXPECT_EQ(moved[999], "999");
+  moved.erase(moved.begin(), moved.begin() + 500);
+  moved.shrink_to_fit();
+  EXPECT_EQ(moved.front(), "500");
+}
+
+TEST(PoolAllocatorTest, FreeOnOtherThread) {
+  std::vector<int, PoolAllocator<int>> numbers(100);
+  std::iota(numbers.begin(), numbers.end(), 0);
+  std::thread other([&numbers] {
+    EXPECT_EQ(numbers[99], 99);
+    decltype(numbers)().swap(numbers);
+  });
+  other.join();
+  EXPECT_TRUE(numbers.empty());
+}
+
+}  // namespace
+}  // namespace verible
@@ -0,0 +1,73 @@
+// Copyright 2017-2023 The Verible Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "common/util/resource_budget_test_util.h"
+
+#include <cstdint>
+#include <cstdlib>
+#include <functional>
+
+#include "absl/strings/numbers.h"
+#include "absl/time/clock.h"
+#include "absl/time/time.h"
+#include "common/util/memory_stats.h"
+#include "gtest/gtest.h"
+
+namespace verible {
+namespace testing {
+
+static double BudgetScale() {
+  const char* scale_env = std::getenv("VERIBLE_TEST_BUDGET_SCALE");
+  double scale;
+  if (scale_env == nullptr || !absl::SimpleAtod(scale_env, &scale) ||
+      scale <= 0) {
+    return 1.0;
+  }
+  return scale;
+}
+
+ResourceUsage MeasureResourceUsage(const std::function<void()>& work) {
+  ResourceUsage usage;
+  const bool measure_memory = ResetPeakResidentSetBytes();
+  const int64_t peak_before = PeakResidentSetBytes();
+  const absl::Time start = absl::Now();
+  work();
+  usage.time = absl::Now() - start;
+  if (measure_memory) {
+    usage.memory_bytes = PeakResidentSetBytes() - peak_before;
+  }
+  return usage;
+}
+
+::testing::AssertionResult WithinBudget(const ResourceUsage& usage,
+                                        const ResourceBudget& budget) {
+  const double margin = kBudgetMargin * BudgetScale();
+  if (usage.time > budget.time * margin) {
+    return ::testing::AssertionFailure()
+           << "took " << usage.time << ", budget " << budget.time << " (x"
+           << margin << ")";
+  }
+  if (budget.memory_bytes > 0 &&
+      usage.memory_bytes > budget.memory_bytes * margin) {
+    return ::testing::AssertionFailure()
+           << "peak memory grew by " << usage.memory_bytes << " bytes, budget "
+           << budget.memory_bytes << " (x" << margin << ")";
+  }
+  return ::testing::AssertionSuccess()
+         << "took " << usage.time << ", peak memory grew by "
+         << usage.memory_bytes << " bytes";
+}
+
+}  // namespace testing
+}  // namespace verible
@@ -0,0 +1,59 @@
+// Copyright 2017-2023 The Verible Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef VERIBLE_COMMON_UTIL_RESOURCE_BUDGET_TEST_UTIL_H_
+#define VERIBLE_COMMON_UTIL_RESOURCE_BUDGET_TEST_UTIL_H_
+
+#include <cstdint>
+#include <functional>
+
+#include "absl/time/time.h"
+#include "gtest/gtest.h"
+
+namespace verible {
+namespace testing {
+
+// Time and memory that a piece of work is expected to take, for tests that
+// run pathological inputs to catch complexity regressions.  Budgets are
+// generous, as they have to hold on slow machines: what they catch is work
+// that grows from linear to quadratic or exponential, not small slowdowns.
+struct ResourceBudget {
+  absl::Duration time;
+  // Growth of the peak resident set size, 0 for none.
+  int64_t memory_bytes = 0;
+};
+
+// What a piece of work took.
+struct ResourceUsage {
+  absl::Duration time;
+  // Growth of the peak resident set size, or -1 where it can't be measured
+  // for a single piece of work (only on Linux it can).
+  int64_t memory_bytes = -1;
+};
+
+// Runs "work" and measures its usage.
+ResourceUsage MeasureResourceUsage(const std::function<void()>& work);
+
+// Usage is over budget when it exceeds it by more than a margin of
+// kBudgetMargin times, scaled by the environment variable
+// VERIBLE_TEST_BUDGET_SCALE, e.g. for builds with sanitizers.
+inline constexpr double kBudgetMargin = 2.0;
+
+::testing::AssertionResult WithinBudget(const ResourceUsage& usage,
+                                        const ResourceBudget& budget);
+
+}  // namespace testing
+}  // namespace verible
+
+#endif  // VERIBLE_COMMON_UTIL_RESOURCE_BUDGET_TEST_UTIL_H_
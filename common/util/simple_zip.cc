@@ -17,10 +17,15 @@
 #include <algorithm>
 #include <cstdint>
 #include <cstdio>
+#include <cstring>
+#include <deque>
+#include <future>
 #include <memory>
 #include <string>
+#include <utility>
 
 #include "absl/strings/string_view.h"
+#include "common/util/thread_pool.h"
 #include "third_party/portable_endian/portable_endian.h"
 #include "zlib.h"  // WORKSPACE imported project header
 
@@ -38,6 +43,18 @@ ByteSource MemoryByteSource(absl::string_view input) {
   };
 }
 
+ByteSource OwnedMemoryByteSource(std::string input) {
+  auto content = std::make_shared<const std::string>(std::move(input));
+  auto is_called = std::make_shared<bool>(false);
+  return [is_called, content]() -> absl::string_view {
+    if (!*is_called) {
+      *is_called = true;
+      return *content;
+    }
+    return {};
+  };
+}
+
 ByteSource FileByteSource(const char *filename) {
   FILE *f = fopen(filename, "rb");
   if (!f) return nullptr;
@@ -99,33 +116,97 @@ struct Encoder::Impl {
     size_t output_size;
   };
 
-  Impl(int compression_level, ByteSink out)
+  // A file compressed on a thread, waiting to be written.
+  struct CompressedFile {
+    CompressResult result;
+    std::string data;
+  };
+  struct PendingFile {
+    std::string filename;
+    std::future<CompressedFile> compressed;
+  };
+
+  Impl(int compression_level, ByteSink out, int compression_threads)
       : compression_level_(std::clamp(compression_level, 0, 9)),
         delegate_write_(std::move(out)),
         out_([this](absl::string_view s) {
           output_file_offset_ += s.size();  // Keep track of offsets.
           return delegate_write_(s);
-        }) {}
+        }),
+        max_pending_files_(4 * std::max(compression_threads, 0)) {
+    if (compression_threads > 0) {
+      thread_pool_ = std::make_unique<ThreadPool>(compression_threads);
+    }
+  }
 
   bool AddFile(absl::string_view filename,
                const ByteSource &content_generator) {
     if (is_finished_) return false;  // Can't add more files.
     if (!content_generator) return false;
 
-    ++file_count_;
+    if (thread_pool_) {
+      const int compression_level = compression_level_;
+      pending_files_.push_back(
+          {std::string(filename),
+           thread_pool_->ExecAsync<CompressedFile>(
+               [compression_level, content_generator]() {
+                 return CompressToString(compression_level, content_generator);
+               })});
+      // Bounds the memory held by compressed files.
+      while (pending_files_.size() > max_pending_files_) {
+        WriteFirstPendingFile();
+      }
+      return write_ok_;
+    }
+
+    const size_t start_offset = output_file_offset_;
+    if (!WriteLocalFileHeader(filename)) return false;
+
+    // Data output
+    const CompressResult compress_result =
+        compression_level_ == 0
+            ? CopyData(content_generator, out_)
+            : CompressData(compression_level_, content_generator,
+                           scratch_space_, sizeof(scratch_space_), out_);
+
+    return WriteFileTrailer(filename, start_offset, compress_result);
+  }
+
+  bool Finish() {
+    if (is_finished_) return false;
+    is_finished_ = true;
+    while (!pending_files_.empty()) WriteFirstPendingFile();
+    if (!write_ok_) return false;
     const size_t start_offset = output_file_offset_;
+    if (!out_({central_dir_data_.data(), central_dir_data_.size()})) {
+      return false;
+    }
 
-    const uint16_t mod_time = 0;  // TODO: accept time_t and convert ?
-    const uint16_t mod_date = 0;
+    // End of central directory record
+    constexpr absl::string_view comment("Created with Verible simple zip");
+    return HeaderWriter(scratch_space_)
+        .AddLiteral("PK\x05\x06")  // End of central directory signature
+        .AddInt16(0)               // our disk number
+        .AddInt16(0)               // disk where it all starts
+        .AddInt16(file_count_)     // Number of directory records on this disk
+        .AddInt16(file_count_)     // ... and overall
+        .AddInt32(central_dir_data_.size())
+        .AddInt32(start_offset)
+        .AddInt16(comment.length())
+        .AddLiteral(comment)
+        .Write(out_);
+  }
 
-    bool success =  // Assemble local file header
+  bool WriteLocalFileHeader(absl::string_view filename) {
+    ++file_count_;
+    return  // Assemble local file header
         HeaderWriter(scratch_space_)
             .AddLiteral("PK\x03\x04")
             .AddInt16(kPkZipVersion)  // Minimum version needed
             .AddInt16(0x08)  // Flags. Sizes and CRC in data descriptor.
             .AddInt16(compression_level_ == 0 ? 0 : 8)
-            .AddInt16(mod_time)
-            .AddInt16(mod_date)
+            .AddInt16(kModTime)
+            .AddInt16(kModDate)
             .AddInt32(0)  // CRC32. Known later.
             .AddInt32(0)  // Compressed size: known later.
             .AddInt32(0)  // Uncompressed size: known later.
@@ -133,14 +214,13 @@ struct Encoder::Impl {
             .AddInt16(0)  // Extra field length
             .AddLiteral(filename)
             .Write(out_);
-    if (!success) return false;
-
-    // Data output
-    const CompressResult compress_result =
-        compression_level_ == 0 ? CopyDataToOutput(content_generator)
-                                : CompressDataToOutput(content_generator);
+  }
 
-    success =  // Assemble Data Descriptor after file with known CRC and size.
+  // Writes the data descriptor of the file starting at "start_offset", and
+  // records its directory entry.
+  bool WriteFileTrailer(absl::string_view filename, size_t start_offset,
+                        const CompressResult &compress_result) {
+    const bool success =  // Assemble Data Descriptor with known CRC and size.
         HeaderWriter(scratch_space_)
             .AddInt32(compress_result.input_crc)
             .AddInt32(compress_result.output_size)
@@ -154,8 +234,8 @@ struct Encoder::Impl {
         .AddInt16(kPkZipVersion)  // Readable by version
         .AddInt16(0x08)           // Flag
         .AddInt16(compression_level_ == 0 ? 0 : 8)
-        .AddInt16(mod_time)
-        .AddInt16(mod_date)
+        .AddInt16(kModTime)
+        .AddInt16(kModDate)
         .AddInt32(compress_result.input_crc)
         .AddInt32(compress_result.output_size)
         .AddInt32(compress_result.input_size)
@@ -172,30 +252,38 @@ struct Encoder::Impl {
     return success;
   }
 
-  bool Finish() {
-    if (is_finished_) return false;
-    is_finished_ = true;
+  // Waits for the oldest file added to be compressed, and writes it.
+  void WriteFirstPendingFile() {
+    PendingFile pending = std::move(pending_files_.front());
+    pending_files_.pop_front();
+    const CompressedFile compressed = pending.compressed.get();
     const size_t start_offset = output_file_offset_;
-    if (!out_({central_dir_data_.data(), central_dir_data_.size()})) {
-      return false;
-    }
+    write_ok_ = write_ok_ && WriteLocalFileHeader(pending.filename) &&
+                out_(compressed.data) &&
+                WriteFileTrailer(pending.filename, start_offset,
+                                 compressed.result);
+  }
 
-    // End of central directory record
-    constexpr absl::string_view comment("Created with Verible simple zip");
-    return HeaderWriter(scratch_space_)
-        .AddLiteral("PK\x05\x06")  // End of central directory signature
-        .AddInt16(0)               // our disk number
-        .AddInt16(0)               // disk where it all starts
-        .AddInt16(file_count_)     // Number of directory records on this disk
-        .AddInt16(file_count_)     // ... and overall
-        .AddInt32(central_dir_data_.size())
-        .AddInt32(start_offset)
-        .AddInt16(comment.length())
-        .AddLiteral(comment)
-        .Write(out_);
+  static CompressedFile CompressToString(int compression_level,
+                                         const ByteSource &generator) {
+    CompressedFile compressed;
+    const ByteSink append = [&compressed](absl::string_view s) {
+      compressed.data.append(s.data(), s.size());
+      return true;
+    };
+    if (compression_level == 0) {
+      compressed.result = CopyData(generator, append);
+    } else {
+      std::unique_ptr<char[]> scratch(new char[kThreadScratchSize]);
+      compressed.result = CompressData(compression_level, generator,
+                                       scratch.get(), kThreadScratchSize,
+                                       append);
+    }
+    return compressed;
   }
 
-  CompressResult CopyDataToOutput(const ByteSource &generator) {
+  static CompressResult CopyData(const ByteSource &generator,
+                                 const ByteSink &out) {
     uint32_t crc = 0;
     size_t processed_size = 0;
     absl::string_view chunk;
@@ -203,22 +291,24 @@ struct Encoder::Impl {
       crc = crc32(crc, reinterpret_cast<const uint8_t *>(chunk.data()),
                   chunk.size());
       processed_size += chunk.size();
-      out_(chunk);
+      out(chunk);
     }
     return {crc, processed_size, processed_size};
   }
 
-  CompressResult CompressDataToOutput(const ByteSource &generator) {
+  static CompressResult CompressData(int compression_level,
+                                     const ByteSource &generator,
+                                     char *scratch, size_t scratch_size,
+                                     const ByteSink &out) {
     uint32_t crc = 0;
     absl::string_view chunk;
     z_stream stream;
     memset(&stream, 0x00, sizeof(stream));
 
     // Need negative window bits to tell zlib not to create a header.
-    deflateInit2(&stream, compression_level_, Z_DEFLATED, -15 /*window bits*/,
+    deflateInit2(&stream, compression_level, Z_DEFLATED, -15 /*window bits*/,
                  9 /* memlevel*/, 0);
 
-    const size_t kScratchSize = sizeof(scratch_space_);
     do {
       chunk = generator();
       const int flush_setting = chunk.empty() ? Z_FINISH : Z_NO_FLUSH;
@@ -231,11 +321,11 @@ struct Encoder::Impl {
       stream.next_in =
           reinterpret_cast<uint8_t *>(const_cast<char *>(chunk.data()));
       do {
-        stream.avail_out = kScratchSize;
-        stream.next_out = reinterpret_cast<uint8_t *>(scratch_space_);
+        stream.avail_out = scratch_size;
+        stream.next_out = reinterpret_cast<uint8_t *>(scratch);
         deflate(&stream, flush_setting);
-        const size_t output_size = kScratchSize - stream.avail_out;
-        if (output_size) out_({scratch_space_, output_size});
+        const size_t output_size = scratch_size - stream.avail_out;
+        if (output_size) out({scratch, output_size});
       } while (stream.avail_out == 0);
     } while (!chunk.empty());
 
@@ -244,6 +334,10 @@ struct Encoder::Impl {
     return result;
   }
 
+  static constexpr uint16_t kModTime = 0;  // TODO: accept time_t and convert ?
+  static constexpr uint16_t kModDate = 0;
+  static constexpr size_t kThreadScratchSize = 1 << 16;
+
   const int compression_level_;
   const ByteSink delegate_write_;
   const ByteSink out_;
@@ -253,10 +347,17 @@ struct Encoder::Impl {
   std::string central_dir_data_;
   bool is_finished_ = false;
   char scratch_space_[1 << 20];  // to assemble headers and compression data
+
+  // Only with compression threads; files in the order they were added.
+  const size_t max_pending_files_;
+  std::deque<PendingFile> pending_files_;
+  bool write_ok_ = true;
+  std::unique_ptr<ThreadPool> thread_pool_;
 };
 
-Encoder::Encoder(int compression_level, ByteSink out)
-    : impl_(new Impl(compression_level, std::move(out))) {}
+Encoder::Encoder(int compression_level, ByteSink out,
+                 int compression_threads)
+    : impl_(new Impl(compression_level, std::move(out), compression_threads)) {}
 
 Encoder::~Encoder() { Finish(); }
 
@@ -18,6 +18,7 @@
 
 #include <functional>
 #include <memory>
+#include <string>
 
 #include "absl/strings/string_view.h"
 
@@ -45,6 +46,10 @@ using ByteSink = std::function<bool(absl::string_view out)>;
 // this if you have an in-memory representation of your content.
 ByteSource MemoryByteSource(absl::string_view input);
 
+// Like MemoryByteSource(), but owning the content; for content that would
+// not outlive a deferred compression (see Encoder).
+ByteSource OwnedMemoryByteSource(std::string input);
+
 // Utility function that reads the content of a file and provides a ByteSource.
 // May return an empty function if file could not be opened
 // (no other errors are reported. If you need error handling, write your own).
@@ -56,12 +61,20 @@ class Encoder {
  public:
   // Create a zip file encoder writing to ByteSink.
   // No compression on "compression_level" zero, otherwise deflate
-  Encoder(int compression_level, ByteSink out);
+  //
+  // With "compression_threads" > 0, files are compressed concurrently on that
+  // many threads, and AddFile() returns before the content generator is
+  // exhausted: whatever it refers to has to stay valid until Finish().
+  // The output is the same as without threads, written in the order of
+  // AddFile() calls; only finished files, a few per thread, wait in memory
+  // (compressed) for their turn.
+  Encoder(int compression_level, ByteSink out, int compression_threads = 0);
 
   // Will also Finish() if not called already.
   ~Encoder();
 
   // Add a file with given filename and content from the generator function.
+  // With compression threads, failures to write surface in a later call.
   bool AddFile(absl::string_view filename, const ByteSource &content_generator);
 
   // Finalize container.
@@ -15,7 +15,9 @@
 #include "common/util/simple_zip.h"
 
 #include <string>
+#include <vector>
 
+#include "absl/strings/str_cat.h"
 #include "absl/strings/string_view.h"
 #include "common/util/file_util.h"
 #include "gtest/gtest.h"
@@ -115,3 +117,49 @@ TEST(SimpleZip, ImplicitFinishOnDestruction) {
   EXPECT_EQ(CountSubstr("PK\x01\x02", result), 1);  // one per file in directory
   EXPECT_EQ(CountSubstr("PK\x05\x06", result), 1);  // directory footer
 }
+
+// Zip file of incompressible-ish and compressible content, some of it from
+// files.
+static std::string ZipOfFiles(int compression_level, int compression_threads,
+                              const std::vector<std::string> &filenames) {
+  std::string result;
+  verible::zip::Encoder zipper(compression_level,
+                               [&result](absl::string_view out) {
+                                 result.append(out.begin(), out.end());
+                                 return true;
+                               },
+                               compression_threads);
+  for (int i = 0; i < 20; ++i) {
+    std::string content;
+    for (int j = 0; j < 1000 * i; ++j) absl::StrAppend(&content, j * i, " ");
+    EXPECT_TRUE(zipper.AddFile(absl::StrCat("file", i, ".txt"),
+                               verible::zip::OwnedMemoryByteSource(content)));
+  }
+  for (const std::string &filename : filenames) {
+    EXPECT_TRUE(zipper.AddFile(
+        filename, verible::zip::FileByteSource(filename.c_str())));
+  }
+  EXPECT_TRUE(zipper.Finish());
+  return result;
+}
+
+TEST(SimpleZip, CompressionThreadsSameAsSerial) {
+  std::string large_content;
+  for (int i = 0; i < 100000; ++i) absl::StrAppend(&large_content, i, "\n");
+  const verible::file::testing::ScopedTestFile large_file(::testing::TempDir(),
+                                                          large_content);
+  const verible::file::testing::ScopedTestFile small_file(::testing::TempDir(),
+                                                          "Text from file");
+  const std::vector<std::string> filenames = {large_file.filename(),
+                                              small_file.filename()};
+  for (int compression_level : {0, 9}) {
+    const std::string serial = ZipOfFiles(compression_level, 0, filenames);
+    for (int compression_threads : {1, 3}) {
+      EXPECT_EQ(ZipOfFiles(compression_level, compression_threads, filenames),
+                serial)
+          << compression_level << " " << compression_threads;
+    }
+    EXPECT_EQ(CountSubstr("PK\x03\x04", serial), 22);
+    EXPECT_EQ(CountSubstr("PK\x01\x02", serial), 22);
+  }
+}
@@ -14,53 +14,132 @@
 
 #include "common/util/thread_pool.h"
 
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <utility>
+
+#include "absl/strings/str_cat.h"
+#include "common/util/trace_events.h"
+
 namespace verible {
+
+namespace {
+// The pool and queue index of the current thread, if it is in a pool.
+struct CurrentWorker {
+  const void *pool = nullptr;
+  size_t index = 0;
+};
+thread_local CurrentWorker current_worker;
+}  // namespace
+
 ThreadPool::ThreadPool(int thread_count) {
   for (int i = 0; i < thread_count; ++i) {
-    threads_.push_back(new std::thread(&ThreadPool::Runner, this));
+    queues_.push_back(std::make_unique<Queue>());
+  }
+  for (int i = 0; i < thread_count; ++i) {
+    threads_.emplace_back(&ThreadPool::Runner, this, i);
   }
 }
 
 ThreadPool::~ThreadPool() {
   CancelAllWork();
-  for (auto *t : threads_) {
-    t->join();
-    delete t;
-  }
+  for (auto &t : threads_) t.join();
 }
 
-void ThreadPool::Runner() {
-  std::function<void()> process_work_item;
-  for (;;) {
-    {
-      std::unique_lock<std::mutex> l(lock_);
-      cv_.wait(l, [this]() { return !work_queue_.empty() || exiting_; });
-      if (exiting_) return;
-      process_work_item = work_queue_.front();
-      work_queue_.pop_front();
-    }
-    process_work_item();
+bool ThreadPool::InPool() const { return current_worker.pool == this; }
+
+void ThreadPool::Runner(size_t index) {
+  current_worker = {this, index};
+  if (PipelineTrace().Enabled()) {
+    PipelineTrace().SetThreadName(absl::StrCat("thread pool worker ", index));
+  }
+  while (!exiting_.load()) {
+    if (RunPendingWork()) continue;
+    std::unique_lock<std::mutex> l(idle_lock_);
+    idle_cv_.wait(l,
+                  [this]() { return pending_.load() > 0 || exiting_.load(); });
   }
 }
 
-void ThreadPool::EnqueueWork(const std::function<void()> &work) {
-  if (threads_.empty()) {
+void ThreadPool::EnqueueWork(Work work) {
+  if (queues_.empty()) {
     work();  // synchronous execution
     return;
   }
 
+  // Counted before it is queued, so that pending_ never under-counts and
+  // idle threads can't miss it.
+  pending_.fetch_add(1);
+  {
+    Queue &queue = InPool() ? *queues_[current_worker.index] : inbound_;
+    std::lock_guard<std::mutex> l(queue.lock);
+    queue.work.push_back(std::move(work));
+  }
   {
-    std::unique_lock<std::mutex> l(lock_);
-    work_queue_.emplace_back(work);
+    // Idle threads check pending_ with this held: they either see it, or are
+    // waiting already, and are notified.
+    std::lock_guard<std::mutex> l(idle_lock_);
   }
-  cv_.notify_one();
+  idle_cv_.notify_one();
+}
+
+ThreadPool::Work ThreadPool::TakeWork() {
+  const bool in_pool = InPool();
+  const size_t first = in_pool ? current_worker.index : 0;
+  if (in_pool) {
+    // Own work: most recent first, which is likely to be related to the work
+    // at hand.
+    Queue &queue = *queues_[first];
+    std::lock_guard<std::mutex> l(queue.lock);
+    if (!queue.work.empty()) {
+      Work work = std::move(queue.work.back());
+      queue.work.pop_back();
+      pending_.fetch_sub(1);
+      return work;
+    }
+  }
+  // Then work from outside the pool, and then stolen work: oldest first.
+  for (size_t i = 0; i <= queues_.size(); ++i) {
+    if (in_pool && i == 1) continue;  // Own queue, empty.
+    Queue &queue =
+        i == 0 ? inbound_ : *queues_[(first + i - 1) % queues_.size()];
+    std::lock_guard<std::mutex> l(queue.lock);
+    if (queue.work.empty()) continue;
+    Work work = std::move(queue.work.front());
+    queue.work.pop_front();
+    pending_.fetch_sub(1);
+    return work;
+  }
+  return Work();
+}
+
+bool ThreadPool::RunPendingWork() {
+  if (pending_.load() <= 0) return false;
+  Work work = TakeWork();
+  if (!work) {
+    // Counted, but not queued yet.
+    std::this_thread::yield();
+    return pending_.load() > 0;
+  }
+  work();
+  return true;
 }
 
 void ThreadPool::CancelAllWork() {
   {
-    std::unique_lock<std::mutex> l(lock_);
+    std::lock_guard<std::mutex> l(idle_lock_);
     exiting_ = true;
   }
-  cv_.notify_all();
+  idle_cv_.notify_all();
 }
+
+int JobsOrAllCores(int jobs) {
+  if (jobs > 0) return jobs;
+  return std::max(1u, std::thread::hardware_concurrency());
+}
+
 }  // namespace verible
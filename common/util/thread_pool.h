@@ -15,10 +15,18 @@
 #ifndef VERIBLE_COMMON_UTIL_THREAD_POOL_H
 #define VERIBLE_COMMON_UTIL_THREAD_POOL_H
 
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
 #include <deque>
-#include <functional>
+#include <exception>
 #include <future>
+#include <memory>
+#include <mutex>
 #include <thread>
+#include <type_traits>
+#include <utility>
 #include <vector>
 
 namespace verible {
@@ -29,47 +37,236 @@ namespace verible {
 // specified that in practice there is no implementation of a policy that
 // provides a thread-pool behavior with a guaranteed upper bound of cores used
 // on all platforms.
+//
+// Work added from outside the pool is started in the order it was added, so
+// that callers waiting on the futures in that order get them as early as
+// possible.  Each thread also has its own queue of work: work added from a
+// thread of the pool goes to the queue of that thread, which runs its most
+// recent work first.  Threads out of work take the oldest work of the others
+// ("work stealing"), so fine-grained work added within the pool does not
+// contend on a single lock.
+//
+// Work added from within the pool is supported, but waiting on its future
+// from within the pool may block a thread that could have run it; use
+// ParallelFor() or ParallelMap() there, which run pending work while they
+// wait.
 class ThreadPool {
  public:
   // Create thread pool with "thread_count" threads.
   // If that count is zero, functions will be executed synchronously.
   explicit ThreadPool(int thread_count);
 
-  // Exit ASAP and leave remaining work in queue unfinished.
+  // Exit ASAP and leave remaining work in queue unfinished.  The futures of
+  // unfinished work have a std::future_error (broken promise).
   ~ThreadPool();
 
+  // Number of threads, 0 if functions are executed synchronously.
+  int NumThreads() const { return queues_.size(); }
+
   // Add a function returning T, that is to be executed asynchronously.
   // Return a std::future<T> with the eventual result.
+  // The function is only moved, so it may be move-only.
   //
   // As a special case: if initialized with no threads, the function is
   // executed synchronously.
-  template <class T>
-  std::future<T> ExecAsync(const std::function<T()> &f) {
-    auto *p = new std::promise<T>();
-    std::future<T> future_result = p->get_future();
-    auto promise_fulfiller = [p, f]() {
+  template <class T, class F>
+  std::future<T> ExecAsync(F &&f) {
+    std::promise<T> promise;
+    std::future<T> future_result = promise.get_future();
+    EnqueueWork(Work([promise = std::move(promise),
+                      f = std::forward<F>(f)]() mutable {
       try {
-        p->set_value(f());
+        if constexpr (std::is_void_v<T>) {
+          f();
+          promise.set_value();
+        } else {
+          promise.set_value(f());
+        }
       } catch (...) {
-        p->set_exception(std::current_exception());
+        promise.set_exception(std::current_exception());
       }
-      delete p;
-    };
-    EnqueueWork(promise_fulfiller);
+    }));
     return future_result;
   }
 
+  // Calls "f(i)" for each i in [0, count), on the threads of the pool and the
+  // calling thread, and returns once all calls have.  Rethrows the first
+  // exception of any call, once all have returned.
+  //
+  // Can be called from work running in the pool: calls are then spread
+  // over the threads that are available, and the caller runs other pending
+  // work while it waits, rather than blocking a thread.
+  template <class F>
+  void ParallelFor(size_t count, const F &f);
+
+  // Returns "f(input)" for each element of "inputs", in order, computed as
+  // with ParallelFor().  Results must be default-constructible.
+  template <class In, class F>
+  auto ParallelMap(const std::vector<In> &inputs, const F &f)
+      -> std::vector<std::decay_t<decltype(f(inputs[0]))>>;
+
+  // Computes "f(i)" for each i in [0, count) on the threads of the pool, and
+  // calls "consume(i, result)" on the calling thread, in order of i, as soon
+  // as each result is ready: e.g. the output of files processed in parallel
+  // is printed in the order of the files.  Without threads, each result is
+  // consumed before the next one is computed.  Not to be called from work
+  // running in the pool.
+  template <class F, class Consume>
+  void ParallelMapInOrder(size_t count, const F &f, const Consume &consume);
+
  private:
-  void Runner();
+  // A move-only function without arguments or result.
+  class Work {
+   public:
+    Work() = default;
+    template <class F>
+    explicit Work(F &&f)
+        : impl_(std::make_unique<Impl<std::decay_t<F>>>(std::forward<F>(f))) {}
+
+    explicit operator bool() const { return impl_ != nullptr; }
+    void operator()() { impl_->Run(); }
+
+   private:
+    struct Base {
+      virtual ~Base() = default;
+      virtual void Run() = 0;
+    };
+    template <class F>
+    struct Impl final : Base {
+      explicit Impl(F &&f) : f(std::move(f)) {}
+      explicit Impl(const F &f) : f(f) {}
+      void Run() final { f(); }
+      F f;
+    };
+    std::unique_ptr<Base> impl_;
+  };
+
+  // The work of one of the threads.
+  struct Queue {
+    std::mutex lock;
+    std::deque<Work> work;
+  };
+
+  void Runner(size_t index);
   void CancelAllWork();
-  void EnqueueWork(const std::function<void()> &work);
+  void EnqueueWork(Work work);
+
+  // Takes the next work of the current thread (if in the pool), or else the
+  // oldest work added from outside the pool, or else that of any other
+  // thread.  Returns an empty Work if there is none.
+  Work TakeWork();
+
+  // Runs one pending work, if there is any.  Returns false if there is none.
+  bool RunPendingWork();
+
+  // Returns true if called from one of the threads of this pool.
+  bool InPool() const;
 
-  std::vector<std::thread *> threads_;
-  std::mutex lock_;
-  std::condition_variable cv_;
-  std::deque<std::function<void()>> work_queue_;
-  bool exiting_ = false;
+  std::vector<std::unique_ptr<Queue>> queues_;
+  std::vector<std::thread> threads_;
+  // Work added from outside the pool, taken oldest first.
+  Queue inbound_;
+
+  // Number of work items queued and not taken yet.
+  std::atomic<int64_t> pending_{0};
+
+  // Idle threads wait on this for work.
+  std::mutex idle_lock_;
+  std::condition_variable idle_cv_;
+  std::atomic<bool> exiting_{false};
 };
 
+template <class F>
+void ThreadPool::ParallelFor(size_t count, const F &f) {
+  if (count == 0) return;
+  if (queues_.empty() || count == 1) {
+    for (size_t i = 0; i < count; ++i) f(i);
+    return;
+  }
+
+  // Calls take the next index; helpers that run once all indices have been
+  // taken find nothing to do, and never touch "f".
+  struct Loop {
+    std::atomic<size_t> next{0};
+    std::atomic<size_t> done{0};
+    size_t count;
+    std::mutex lock;
+    std::condition_variable all_done;
+    std::exception_ptr exception;
+  };
+  auto loop = std::make_shared<Loop>();
+  loop->count = count;
+  const auto run = [&f](Loop *loop) {
+    size_t ran = 0;
+    for (size_t i; (i = loop->next.fetch_add(1)) < loop->count; ++ran) {
+      try {
+        f(i);
+      } catch (...) {
+        std::lock_guard<std::mutex> l(loop->lock);
+        if (!loop->exception) loop->exception = std::current_exception();
+      }
+    }
+    if (ran != 0 && loop->done.fetch_add(ran) + ran == loop->count) {
+      std::lock_guard<std::mutex> l(loop->lock);
+      loop->all_done.notify_all();
+    }
+  };
+
+  const size_t helpers = std::min(count, queues_.size() + 1) - 1;
+  for (size_t h = 0; h < helpers; ++h) {
+    EnqueueWork(Work([loop, run]() { run(loop.get()); }));
+  }
+  run(loop.get());
+  // Within the pool, other work may be needed to complete the calls still
+  // running elsewhere (e.g. their own ParallelFor()), so run it meanwhile.
+  const bool in_pool = InPool();
+  while (loop->done.load() != count) {
+    if (in_pool && RunPendingWork()) continue;
+    std::unique_lock<std::mutex> l(loop->lock);
+    loop->all_done.wait(l, [&loop, count]() {
+      return loop->done.load() == count;
+    });
+  }
+  if (loop->exception) std::rethrow_exception(loop->exception);
+}
+
+template <class In, class F>
+auto ThreadPool::ParallelMap(const std::vector<In> &inputs, const F &f)
+    -> std::vector<std::decay_t<decltype(f(inputs[0]))>> {
+  std::vector<std::decay_t<decltype(f(inputs[0]))>> results(inputs.size());
+  ParallelFor(inputs.size(),
+              [&](size_t i) { results[i] = f(inputs[i]); });
+  return results;
+}
+
+template <class F, class Consume>
+void ThreadPool::ParallelMapInOrder(size_t count, const F &f,
+                                    const Consume &consume) {
+  using Result = std::decay_t<decltype(f(size_t{0}))>;
+  if (queues_.empty()) {
+    for (size_t i = 0; i < count; ++i) consume(i, f(i));
+    return;
+  }
+  std::vector<std::future<Result>> results;
+  results.reserve(count);
+  for (size_t i = 0; i < count; ++i) {
+    results.push_back(ExecAsync<Result>([&f, i]() { return f(i); }));
+  }
+  size_t consumed = 0;
+  try {
+    for (; consumed < count; ++consumed) {
+      consume(consumed, results[consumed].get());
+    }
+  } catch (...) {
+    // The remaining work still refers to "f".
+    for (++consumed; consumed < count; ++consumed) results[consumed].wait();
+    throw;
+  }
+}
+
+// Returns "jobs", or the number of cores if it is not positive, as the
+// --jobs flags of the tools are interpreted.
+int JobsOrAllCores(int jobs);
+
 }  // namespace verible
 #endif  // VERIBLE_COMMON_UTIL_THREAD_POOL_H
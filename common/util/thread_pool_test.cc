@@ -14,7 +14,13 @@
 
 #include "common/util/thread_pool.h"
 
+#include <atomic>
 #include <chrono>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <numeric>
+#include <stdexcept>
 #include <vector>
 
 #include "absl/time/clock.h"
@@ -88,5 +94,144 @@ TEST(ThreadPoolTest, ExceptionsArePropagated) {
   EXPECT_EQ(exception_count, kLoops);
 }
 
+TEST(ThreadPoolTest, MoveOnlyAndVoidFunctions) {
+  for (int threads : {0, 2}) {
+    ThreadPool pool(threads);
+    EXPECT_EQ(pool.NumThreads(), threads);
+    auto value = std::make_unique<int>(42);
+    std::future<int> moved = pool.ExecAsync<int>(
+        [value = std::move(value)]() -> int { return *value; });
+    std::atomic<bool> ran{false};
+    std::future<void> done = pool.ExecAsync<void>([&ran]() { ran = true; });
+    EXPECT_EQ(moved.get(), 42);
+    done.get();
+    EXPECT_TRUE(ran);
+  }
+}
+
+TEST(ThreadPoolTest, UnfinishedWorkIsBroken) {
+  std::future<int> unfinished;
+  {
+    ThreadPool pool(1);
+    std::future<int> running = pool.ExecAsync<int>([]() -> int {
+      PretendWork(100);
+      return 1;
+    });
+    unfinished = pool.ExecAsync<int>([]() -> int { return 2; });
+  }
+  EXPECT_THROW(unfinished.get(), std::future_error);
+}
+
+TEST(ThreadPoolTest, ParallelForCallsEachIndexOnce) {
+  constexpr size_t kCount = 1000;
+  for (int threads : {0, 1, 4}) {
+    ThreadPool pool(threads);
+    std::vector<std::atomic<int>> calls(kCount);
+    pool.ParallelFor(kCount, [&calls](size_t i) { ++calls[i]; });
+    for (size_t i = 0; i < kCount; ++i) {
+      EXPECT_EQ(calls[i].load(), 1) << i;
+    }
+    pool.ParallelFor(0, [](size_t) { FAIL(); });
+  }
+}
+
+TEST(ThreadPoolTest, ParallelForRethrowsOnceAllCallsReturned) {
+  ThreadPool pool(3);
+  std::atomic<int> calls{0};
+  EXPECT_THROW(pool.ParallelFor(100,
+                                [&calls](size_t i) {
+                                  ++calls;
+                                  if (i % 10 == 0) {
+                                    throw std::runtime_error("failed");
+                                  }
+                                }),
+               std::runtime_error);
+  EXPECT_EQ(calls.load(), 100);
+}
+
+TEST(ThreadPoolTest, ParallelMapKeepsOrder) {
+  ThreadPool pool(4);
+  std::vector<int> inputs(500);
+  std::iota(inputs.begin(), inputs.end(), 0);
+  const std::vector<int> squares =
+      pool.ParallelMap(inputs, [](int i) { return i * i; });
+  ASSERT_EQ(squares.size(), inputs.size());
+  for (int i : inputs) {
+    EXPECT_EQ(squares[i], i * i);
+  }
+}
+
+TEST(ThreadPoolTest, OutsideWorkStartsInOrder) {
+  ThreadPool pool(1);
+  // Keep the only thread busy until all work is queued.
+  std::promise<void> queued;
+  std::shared_future<void> all_queued = queued.get_future().share();
+  pool.ExecAsync<void>([all_queued]() { all_queued.wait(); });
+
+  std::mutex lock;
+  std::vector<int> started;
+  std::vector<std::future<void>> results;
+  for (int i = 0; i < 10; ++i) {
+    results.push_back(pool.ExecAsync<void>([i, &lock, &started]() {
+      std::lock_guard<std::mutex> l(lock);
+      started.push_back(i);
+    }));
+  }
+  queued.set_value();
+  for (auto &result : results) result.get();
+
+  std::vector<int> expected(10);
+  std::iota(expected.begin(), expected.end(), 0);
+  EXPECT_EQ(started, expected);
+}
+
+TEST(ThreadPoolTest, ParallelMapInOrderConsumesInOrder) {
+  for (const int threads : {0, 1, 4}) {
+    ThreadPool pool(threads);
+    std::vector<size_t> consumed;
+    pool.ParallelMapInOrder(
+        50,
+        [](size_t i) {
+          PretendWork(i % 3);
+          return i * i;
+        },
+        [&consumed](size_t i, size_t square) {
+          EXPECT_EQ(square, i * i);
+          consumed.push_back(i);
+        });
+    std::vector<size_t> expected(50);
+    std::iota(expected.begin(), expected.end(), 0);
+    EXPECT_EQ(consumed, expected) << threads;
+  }
+}
+
+TEST(ThreadPoolTest, JobsOrAllCores) {
+  EXPECT_EQ(JobsOrAllCores(3), 3);
+  EXPECT_GE(JobsOrAllCores(0), 1);
+  EXPECT_EQ(JobsOrAllCores(-1), JobsOrAllCores(0));
+}
+
+TEST(ThreadPoolTest, NestedWorkDoesNotDeadlock) {
+  // More nested loops than threads, each waiting on its own inner loop.
+  ThreadPool pool(2);
+  std::atomic<int> inner_calls{0};
+  std::vector<std::future<int>> results;
+  for (int i = 0; i < 8; ++i) {
+    results.push_back(pool.ExecAsync<int>([&pool, &inner_calls]() -> int {
+      pool.ParallelFor(8, [&pool, &inner_calls](size_t) {
+        pool.ParallelFor(8, [&inner_calls](size_t) {
+          PretendWork(1);
+          ++inner_calls;
+        });
+      });
+      return 1;
+    }));
+  }
+  int total = 0;
+  for (auto &result : results) total += result.get();
+  EXPECT_EQ(total, 8);
+  EXPECT_EQ(inner_calls.load(), 8 * 8 * 8);
+}
+
 }  // namespace
 }  // namespace verible
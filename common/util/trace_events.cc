@@ -0,0 +1,126 @@
+// Copyright 2017-2023 The Verible Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "common/util/trace_events.h"
+
+#include <atomic>
+#include <cstdint>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <mutex>
+#include <ostream>
+#include <string>
+#include <vector>
+
+#include "absl/strings/string_view.h"
+#include "absl/time/clock.h"
+#include "absl/time/time.h"
+#include "common/util/json_writer.h"
+
+namespace verible {
+
+void TraceRecorder::Enable() {
+  const std::lock_guard<std::mutex> l(lock_);
+  if (Enabled()) return;
+  origin_ = absl::Now();
+  enabled_.store(true, std::memory_order_release);
+}
+
+void TraceRecorder::Record(absl::string_view category, absl::string_view name,
+                           absl::Time start, absl::Time end,
+                           absl::string_view detail) {
+  if (!Enabled()) return;
+  const int thread = TraceThreadId();
+  const std::lock_guard<std::mutex> l(lock_);
+  events_.push_back({std::string(category), std::string(name),
+                     std::string(detail),
+                     absl::ToInt64Microseconds(start - origin_),
+                     absl::ToInt64Microseconds(end - start), thread});
+}
+
+void TraceRecorder::SetThreadName(absl::string_view name) {
+  if (!Enabled()) return;
+  const int thread = TraceThreadId();
+  const std::lock_guard<std::mutex> l(lock_);
+  thread_names_[thread] = std::string(name);
+}
+
+std::vector<TraceEvent> TraceRecorder::Events() const {
+  const std::lock_guard<std::mutex> l(lock_);
+  return events_;
+}
+
+void TraceRecorder::WriteJson(std::ostream *out) const {
+  const std::lock_guard<std::mutex> l(lock_);
+  JsonWriter writer(out, -1);
+  writer.BeginObject();
+  writer.Key("displayTimeUnit").Value("ms");
+  writer.Key("traceEvents").BeginArray();
+  for (const auto &[thread, name] : thread_names_) {
+    writer.BeginObject();
+    writer.Key("name").Value("thread_name");
+    writer.Key("ph").Value("M");
+    writer.Key("pid").Value(1);
+    writer.Key("tid").Value(thread);
+    writer.Key("args").BeginObject().Key("name").Value(name).EndObject();
+    writer.EndObject();
+  }
+  for (const TraceEvent &event : events_) {
+    writer.BeginObject();
+    writer.Key("name").Value(event.name);
+    writer.Key("cat").Value(event.category);
+    writer.Key("ph").Value("X");
+    writer.Key("ts").Value(event.start_us);
+    writer.Key("dur").Value(event.duration_us);
+    writer.Key("pid").Value(1);
+    writer.Key("tid").Value(event.thread);
+    if (!event.detail.empty()) {
+      writer.Key("args").BeginObject();
+      writer.Key("detail").Value(event.detail);
+      writer.EndObject();
+    }
+    writer.EndObject();
+  }
+  writer.EndArray();
+  writer.EndObject();
+  *out << std::endl;
+}
+
+TraceRecorder &PipelineTrace() {
+  static TraceRecorder *const trace = new TraceRecorder();
+  return *trace;
+}
+
+int TraceThreadId() {
+  static std::atomic<int> next_thread{0};
+  thread_local const int thread = next_thread++;
+  return thread;
+}
+
+void EnableTraceOutput(const std::string &path) {
+  static const std::string *const trace_path = new std::string(path);
+  PipelineTrace().Enable();
+  PipelineTrace().SetThreadName("main");
+  std::atexit([]() {
+    std::ofstream out(*trace_path);
+    if (!out) {
+      std::cerr << *trace_path << ": can't write trace." << std::endl;
+      return;
+    }
+    PipelineTrace().WriteJson(&out);
+  });
+}
+
+}  // namespace verible
@@ -0,0 +1,126 @@
+// Copyright 2017-2023 The Verible Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef VERIBLE_COMMON_UTIL_TRACE_EVENTS_H
+#define VERIBLE_COMMON_UTIL_TRACE_EVENTS_H
+
+#include <atomic>
+#include <cstdint>
+#include <map>
+#include <mutex>
+#include <ostream>
+#include <string>
+#include <vector>
+
+#include "absl/strings/string_view.h"
+#include "absl/time/clock.h"
+#include "absl/time/time.h"
+
+namespace verible {
+
+// A span of time on one thread, e.g. the parsing of one file.
+struct TraceEvent {
+  std::string category;  // e.g. "analysis" or "format"
+  std::string name;      // e.g. "parse"
+  std::string detail;    // optional, e.g. the file name
+  int64_t start_us;      // microseconds since tracing was enabled
+  int64_t duration_us;
+  int thread;  // lane of the thread, see TraceThreadId()
+};
+
+// Trace events of the processing pipeline, for chrome://tracing or Perfetto.
+// Tracing is opt-in: nothing is recorded until Enable() is called, and
+// disabled tracing costs one atomic load per traced scope. Thread-safe.
+class TraceRecorder {
+ public:
+  // Starts recording; event times are relative to this call.
+  void Enable();
+  bool Enabled() const { return enabled_.load(std::memory_order_acquire); }
+
+  // Records the span from 'start' to 'end' on the current thread.
+  // Does nothing unless Enabled().
+  void Record(absl::string_view category, absl::string_view name,
+              absl::Time start, absl::Time end, absl::string_view detail = {});
+
+  // Names the lane of the current thread, e.g. "thread pool worker 1".
+  // Does nothing unless Enabled().
+  void SetThreadName(absl::string_view name);
+
+  // Copy of the events, in the order they were recorded.
+  std::vector<TraceEvent> Events() const;
+
+  // Writes the events as JSON of the Chrome trace event format: complete
+  // ("X") events, and thread name metadata for the named lanes.
+  void WriteJson(std::ostream *out) const;
+
+ private:
+  std::atomic<bool> enabled_{false};
+  absl::Time origin_;
+  mutable std::mutex lock_;
+  std::vector<TraceEvent> events_;
+  std::map<int, std::string> thread_names_;
+};
+
+// Trace of all the stages of lexing, parsing, linting, formatting and
+// indexing, wherever they happen.  Tools enable it with --trace_output.
+TraceRecorder &PipelineTrace();
+
+// Small number of the current thread, given out in the order that threads
+// first ask for it, which is used as its lane ("tid") in traces.
+int TraceThreadId();
+
+// Enables PipelineTrace(), and writes it to file 'path' when the process
+// exits, for --trace_output.
+void EnableTraceOutput(const std::string &path);
+
+// Records the lifetime of this object in PipelineTrace(), if enabled when
+// constructed.  'category', 'name' and 'detail' must outlive it.
+class ScopedTrace {
+ public:
+  ScopedTrace(absl::string_view category, absl::string_view name,
+              absl::string_view detail = {})
+      : category_(category),
+        name_(name),
+        detail_(detail),
+        start_(PipelineTrace().Enabled() ? absl::Now()
+                                         : absl::InfinitePast()) {}
+
+  ScopedTrace(const ScopedTrace &) = delete;
+  ScopedTrace &operator=(const ScopedTrace &) = delete;
+
+  ~ScopedTrace() {
+    if (start_ != absl::InfinitePast()) {
+      PipelineTrace().Record(category_, name_, start_, absl::Now(), detail_);
+    }
+  }
+
+ private:
+  const absl::string_view category_;
+  const absl::string_view name_;
+  const absl::string_view detail_;
+  const absl::Time start_;
+};
+
+#define VERIBLE_TRACE_CONCAT_INNER(a, b) a##b
+#define VERIBLE_TRACE_CONCAT(a, b) VERIBLE_TRACE_CONCAT_INNER(a, b)
+
+// Traces the rest of the enclosing scope, e.g.
+//   VERIBLE_TRACE_SCOPE("format", "align");
+//   VERIBLE_TRACE_SCOPE("analysis", "parse", filename);
+#define VERIBLE_TRACE_SCOPE(...)                                    \
+  const ::verible::ScopedTrace VERIBLE_TRACE_CONCAT(verible_trace_, \
+                                                    __LINE__)(__VA_ARGS__)
+
+}  // namespace verible
+#endif  // VERIBLE_COMMON_UTIL_TRACE_EVENTS_H
@@ -0,0 +1,115 @@
+// Copyright 2017-2023 The Verible Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "common/util/trace_events.h"
+
+#include <sstream>
+#include <thread>
+#include <vector>
+
+#include "absl/time/clock.h"
+#include "absl/time/time.h"
+#include "gtest/gtest.h"
+#include "nlohmann/json.hpp"
+
+namespace verible {
+namespace {
+
+TEST(TraceRecorderTest, NothingRecordedUntilEnabled) {
+  TraceRecorder trace;
+  EXPECT_FALSE(trace.Enabled());
+  const absl::Time now = absl::Now();
+  trace.Record("analysis", "parse", now, now);
+  EXPECT_TRUE(trace.Events().empty());
+  trace.Enable();
+  EXPECT_TRUE(trace.Enabled());
+  trace.Record("analysis", "parse", absl::Now(), absl::Now(), "a.sv");
+  ASSERT_EQ(trace.Events().size(), 1u);
+  const TraceEvent event = trace.Events()[0];
+  EXPECT_EQ(event.category, "analysis");
+  EXPECT_EQ(event.name, "parse");
+  EXPECT_EQ(event.detail, "a.sv");
+  EXPECT_GE(event.start_us, 0);
+  EXPECT_GE(event.duration_us, 0);
+  EXPECT_EQ(event.thread, TraceThreadId());
+}
+
+TEST(TraceRecorderTest, EventTimesRelativeToEnable) {
+  TraceRecorder trace;
+  trace.Enable();
+  const absl::Time start = absl::Now() + absl::Milliseconds(5);
+  trace.Record("format", "align", start, start + absl::Milliseconds(2));
+  const TraceEvent event = trace.Events().at(0);
+  EXPECT_GE(event.start_us, 5000);
+  EXPECT_EQ(event.duration_us, 2000);
+}
+
+TEST(TraceRecorderTest, ThreadsHaveTheirOwnLanes) {
+  const int main_thread = TraceThreadId();
+  EXPECT_EQ(TraceThreadId(), main_thread);
+  std::vector<int> threads(3);
+  std::vector<std::thread> workers;
+  for (int& thread : threads) {
+    workers.emplace_back([&thread]() { thread = TraceThreadId(); });
+  }
+  for (auto& worker : workers) worker.join();
+  for (size_t i = 0; i < threads.size(); ++i) {
+    EXPECT_NE(threads[i], main_thread);
+    for (size_t j = 0; j < i; ++j) EXPECT_NE(threads[i], threads[j]);
+  }
+}
+
+TEST(TraceRecorderTest, ScopedTrace) {
+  PipelineTrace().Enable();
+  const size_t before = PipelineTrace().Events().size();
+  {
+    VERIBLE_TRACE_SCOPE("symbol-table", "resolve");
+    EXPECT_EQ(PipelineTrace().Events().size(), before);
+  }
+  const std::vector<TraceEvent> events = PipelineTrace().Events();
+  ASSERT_EQ(events.size(), before + 1);
+  EXPECT_EQ(events.back().category, "symbol-table");
+  EXPECT_EQ(events.back().name, "resolve");
+}
+
+TEST(TraceRecorderTest, WriteJson) {
+  TraceRecorder trace;
+  trace.Enable();
+  trace.SetThreadName("main");
+  const absl::Time start = absl::Now();
+  trace.Record("analysis", "tokenize", start, start + absl::Microseconds(7),
+               "dir/\"quoted\".sv");
+  trace.Record("format", "unwrap", start, start);
+  std::ostringstream out;
+  trace.WriteJson(&out);
+
+  const nlohmann::json json = nlohmann::json::parse(out.str());
+  const nlohmann::json& events = json["traceEvents"];
+  ASSERT_EQ(events.size(), 3u);
+  EXPECT_EQ(events[0]["ph"], "M");
+  EXPECT_EQ(events[0]["name"], "thread_name");
+  EXPECT_EQ(events[0]["args"]["name"], "main");
+  EXPECT_EQ(events[0]["tid"], TraceThreadId());
+  EXPECT_EQ(events[1]["ph"], "X");
+  EXPECT_EQ(events[1]["cat"], "analysis");
+  EXPECT_EQ(events[1]["name"], "tokenize");
+  EXPECT_EQ(events[1]["dur"], 7);
+  EXPECT_EQ(events[1]["tid"], TraceThreadId());
+  EXPECT_EQ(events[1]["args"]["detail"], "dir/\"quoted\".sv");
+  EXPECT_EQ(events[2]["name"], "unwrap");
+  EXPECT_FALSE(events[2].contains("args"));
+}
+
+}  // namespace
+}  // namespace verible
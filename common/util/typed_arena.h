@@ -0,0 +1,118 @@
+// Copyright 2017-2023 The Verible Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef VERIBLE_COMMON_UTIL_TYPED_ARENA_H_
+#define VERIBLE_COMMON_UTIL_TYPED_ARENA_H_
+
+#include <algorithm>
+#include <cstddef>
+#include <memory>
+#include <new>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace verible {
+
+// TypedArena is a bump-allocator for objects of a single type T.
+// Objects are constructed in large blocks of storage, and all of them are
+// destroyed together when the arena is destroyed; there is no way to free
+// individual objects.
+// Addresses of allocated objects are stable for the lifetime of the arena,
+// so they may be referenced by raw pointers.
+//
+// This is useful where many small objects that share a lifetime are
+// allocated, e.g. the nodes of a search, and where the cost of individual
+// heap allocations (and reference-counting) would dominate.
+template <typename T>
+class TypedArena {
+ public:
+  // Blocks of storage grow geometrically, starting with room for
+  // 'initial_block_size' objects, up to 'max_block_size' objects per block.
+  // This keeps small arenas cheap, and the number of blocks of large arenas
+  // low.
+  explicit TypedArena(size_t initial_block_size = 16,
+                      size_t max_block_size = 4096)
+      : next_block_size_(initial_block_size > 0 ? initial_block_size : 1),
+        max_block_size_(std::max(max_block_size, next_block_size_)) {}
+
+  TypedArena(const TypedArena&) = delete;
+  TypedArena& operator=(const TypedArena&) = delete;
+
+  ~TypedArena() { Clear(); }
+
+  // Constructs a new T in the arena with 'args', and returns a pointer to it.
+  // The arena retains ownership.
+  template <typename... Args>
+  T* New(Args&&... args) {
+    if (blocks_.empty() || blocks_.back().used == blocks_.back().capacity) {
+      AddBlock();
+    }
+    Block& block = blocks_.back();
+    void* address = &block.storage[block.used];
+    T* object = new (address) T(std::forward<Args>(args)...);
+    // Only count the object as constructed once the constructor succeeded.
+    ++block.used;
+    ++size_;
+    return object;
+  }
+
+  // Returns the number of objects allocated in this arena.
+  size_t size() const { return size_; }
+
+  bool empty() const { return size_ == 0; }
+
+  // Destroys all objects, and releases all storage.
+  void Clear() {
+    for (Block& block : blocks_) {
+      for (size_t i = 0; i < block.used; ++i) {
+        std::launder(reinterpret_cast<T*>(&block.storage[i]))->~T();
+      }
+    }
+    blocks_.clear();
+    size_ = 0;
+  }
+
+ private:
+  using Storage = typename std::aligned_storage<sizeof(T), alignof(T)>::type;
+
+  struct Block {
+    std::unique_ptr<Storage[]> storage;
+    size_t capacity;
+    size_t used;
+  };
+
+  void AddBlock() {
+    blocks_.push_back(
+        {std::unique_ptr<Storage[]>(new Storage[next_block_size_]),
+         next_block_size_, 0});
+    next_block_size_ = std::min(next_block_size_ * 2, max_block_size_);
+  }
+
+  // Capacity of the next block to allocate.
+  size_t next_block_size_;
+
+  // Upper bound of next_block_size_.
+  const size_t max_block_size_;
+
+  // Blocks of storage, only the last one may have unused capacity.
+  std::vector<Block> blocks_;
+
+  // Total number of constructed objects.
+  size_t size_ = 0;
+};
+
+}  // namespace verible
+
+#endif  // VERIBLE_COMMON_UTIL_TYPED_ARENA_H_
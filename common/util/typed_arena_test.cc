@@ -0,0 +1,82 @@
+// Copyright 2017-2023 The Verible Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "common/util/typed_arena.h"
+
+#include <string>
+#include <vector>
+
+#include "gtest/gtest.h"
+
+namespace verible {
+namespace {
+
+TEST(TypedArenaTest, Empty) {
+  TypedArena<int> arena;
+  EXPECT_TRUE(arena.empty());
+  EXPECT_EQ(arena.size(), 0);
+}
+
+TEST(TypedArenaTest, ConstructsWithArguments) {
+  TypedArena<std::string> arena;
+  const std::string* a = arena.New(3, 'a');
+  const std::string* b = arena.New("bc");
+  EXPECT_EQ(*a, "aaa");
+  EXPECT_EQ(*b, "bc");
+  EXPECT_EQ(arena.size(), 2);
+}
+
+TEST(TypedArenaTest, AddressesAreStableAcrossBlocks) {
+  TypedArena<int> arena(1, 8);
+  std::vector<int*> pointers;
+  for (int i = 0; i < 100; ++i) {
+    pointers.push_back(arena.New(i));
+  }
+  EXPECT_EQ(arena.size(), 100);
+  for (int i = 0; i < 100; ++i) {
+    EXPECT_EQ(*pointers[i], i);
+  }
+}
+
+// Counts live instances.
+struct Tracked {
+  explicit Tracked(int* count) : count(count) { ++*count; }
+  ~Tracked() { --*count; }
+  int* count;
+};
+
+TEST(TypedArenaTest, DestroysAllObjects) {
+  int live = 0;
+  {
+    TypedArena<Tracked> arena(2);
+    for (int i = 0; i < 10; ++i) arena.New(&live);
+    EXPECT_EQ(live, 10);
+  }
+  EXPECT_EQ(live, 0);
+}
+
+TEST(TypedArenaTest, ClearDestroysAndResets) {
+  int live = 0;
+  TypedArena<Tracked> arena(2);
+  for (int i = 0; i < 5; ++i) arena.New(&live);
+  arena.Clear();
+  EXPECT_EQ(live, 0);
+  EXPECT_TRUE(arena.empty());
+  arena.New(&live);
+  EXPECT_EQ(live, 1);
+  EXPECT_EQ(arena.size(), 1);
+}
+
+}  // namespace
+}  // namespace verible
@@ -0,0 +1,61 @@
+// Copyright 2017-2023 The Verible Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+
+#include "common/util/varint_coding.h"
+
+#include <cstdint>
+#include <string>
+
+#include "absl/strings/string_view.h"
+#include "absl/strings/strip.h"
+
+namespace verible {
+
+void PutVarint(uint64_t value, std::string* out) {
+  for (; value >= 0x80; value >>= 7) {
+    out->push_back(static_cast<char>(value | 0x80));
+  }
+  out->push_back(static_cast<char>(value));
+}
+
+void PutString(absl::string_view s, std::string* out) {
+  PutVarint(s.size(), out);
+  out->append(s.data(), s.size());
+}
+
+bool VarintReader::Varint(uint64_t* value) {
+  *value = 0;
+  for (int shift = 0; shift < 64 && !rest_.empty(); shift += 7) {
+    const uint8_t byte = rest_.front();
+    rest_.remove_prefix(1);
+    *value |= static_cast<uint64_t>(byte & 0x7f) << shift;
+    if ((byte & 0x80) == 0) return true;
+  }
+  return false;
+}
+
+bool VarintReader::String(absl::string_view* s) {
+  uint64_t size;
+  if (!Varint(&size) || size > rest_.size()) return false;
+  *s = rest_.substr(0, size);
+  rest_.remove_prefix(size);
+  return true;
+}
+
+bool VarintReader::Prefix(absl::string_view prefix) {
+  return absl::ConsumePrefix(&rest_, prefix);
+}
+
+}  // namespace verible
@@ -0,0 +1,58 @@
+// Copyright 2017-2023 The Verible Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+
+#ifndef VERIBLE_COMMON_UTIL_VARINT_CODING_H_
+#define VERIBLE_COMMON_UTIL_VARINT_CODING_H_
+
+#include <cstdint>
+#include <string>
+
+#include "absl/strings/string_view.h"
+
+namespace verible {
+
+// Compact binary encoding of e.g. cache entries: unsigned varints (7 bits
+// per byte, least significant first) and strings preceded by their size.
+
+// Appends "value" to "out".
+void PutVarint(uint64_t value, std::string* out);
+
+// Appends the size of "s" and "s" to "out".
+void PutString(absl::string_view s, std::string* out);
+
+// Reads what PutVarint() and PutString() wrote, from the front of "bytes".
+// Each method returns false if the rest of the bytes don't start with what
+// it reads.
+class VarintReader {
+ public:
+  explicit VarintReader(absl::string_view bytes) : rest_(bytes) {}
+
+  bool Varint(uint64_t* value);
+
+  // "s" points into the bytes.
+  bool String(absl::string_view* s);
+
+  // Skips "prefix", e.g. the magic of an entry format.
+  bool Prefix(absl::string_view prefix);
+
+  bool AtEnd() const { return rest_.empty(); }
+
+ private:
+  absl::string_view rest_;
+};
+
+}  // namespace verible
+
+#endif  // VERIBLE_COMMON_UTIL_VARINT_CODING_H_
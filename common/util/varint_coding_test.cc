@@ -0,0 +1,73 @@
+// Copyright 2017-2023 The Verible Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+
+#include "common/util/varint_coding.h"
+
+#include <cstdint>
+#include <string>
+
+#include "absl/strings/string_view.h"
+#include "gtest/gtest.h"
+
+namespace verible {
+namespace {
+
+TEST(VarintCodingTest, RoundTrip) {
+  std::string bytes("magic");
+  PutVarint(0, &bytes);
+  PutVarint(127, &bytes);
+  PutVarint(128, &bytes);
+  PutVarint(UINT64_MAX, &bytes);
+  PutString("", &bytes);
+  PutString("text", &bytes);
+  EXPECT_EQ(bytes.size(), 5 + 1 + 1 + 2 + 10 + 1 + 5);
+
+  VarintReader reader(bytes);
+  EXPECT_FALSE(reader.Prefix("other"));
+  EXPECT_TRUE(reader.Prefix("magic"));
+  uint64_t value;
+  EXPECT_TRUE(reader.Varint(&value));
+  EXPECT_EQ(value, 0);
+  EXPECT_TRUE(reader.Varint(&value));
+  EXPECT_EQ(value, 127);
+  EXPECT_TRUE(reader.Varint(&value));
+  EXPECT_EQ(value, 128);
+  EXPECT_TRUE(reader.Varint(&value));
+  EXPECT_EQ(value, UINT64_MAX);
+  absl::string_view s;
+  EXPECT_TRUE(reader.String(&s));
+  EXPECT_EQ(s, "");
+  EXPECT_FALSE(reader.AtEnd());
+  EXPECT_TRUE(reader.String(&s));
+  EXPECT_EQ(s, "text");
+  EXPECT_EQ(s.data(), bytes.data() + bytes.size() - 4);  // Not copied.
+  EXPECT_TRUE(reader.AtEnd());
+  EXPECT_FALSE(reader.Varint(&value));
+}
+
+TEST(VarintCodingTest, TruncatedInput) {
+  std::string bytes;
+  PutVarint(300, &bytes);
+  uint64_t value;
+  EXPECT_FALSE(VarintReader(bytes.substr(0, 1)).Varint(&value));
+
+  bytes.clear();
+  PutString("text", &bytes);
+  absl::string_view s;
+  EXPECT_FALSE(VarintReader(bytes.substr(0, 3)).String(&s));
+}
+
+}  // namespace
+}  // namespace verible
@@ -20,6 +20,7 @@
 #include <functional>
 #include <iosfwd>  // IWYU pragma: keep
 #include <iterator>
+#include <memory>
 #include <numeric>
 #include <set>
 #include <utility>
@@ -63,16 +64,21 @@ namespace verible {
 // that a parent is well-formed before creating its children, whereas a
 // bottom-up construction completes creation of children before the enveloping
 // parent.
-template <typename T>
+//
+// Allocation:
+// Each node with children owns a separately allocated array of its children.
+// 'Allocator' is used for these arrays, e.g. PoolAllocator for trees that are
+// restructured a lot, to recycle the arrays instead of going to the heap.
+template <typename T, template <typename> class Allocator = std::allocator>
 class VectorTree {
-  using this_type = VectorTree<T>;
+  using this_type = VectorTree<T, Allocator>;
 
   // Forward declaration
   class ChildrenList;
 
  public:
   // Self-recursive type that represents children in an expanded view.
-  using subnodes_type = std::vector<this_type>;
+  using subnodes_type = std::vector<this_type, Allocator<this_type>>;
   using value_type = T;
 
   VectorTree() : children_(*this) {}
@@ -283,8 +289,8 @@ class VectorTree {
 };
 
 // Provide ADL-enabled overload for use by swap implementations.
-template <class T>
-void swap(VectorTree<T>& left, VectorTree<T>& right) {
+template <class T, template <typename> class Allocator>
+void swap(VectorTree<T, Allocator>& left, VectorTree<T, Allocator>& right) {
   left.swap(right);
 }
 
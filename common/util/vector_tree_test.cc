@@ -24,6 +24,7 @@
 #include "absl/strings/str_cat.h"
 #include "absl/strings/str_join.h"
 #include "absl/strings/string_view.h"
+#include "common/util/pool_allocator.h"
 #include "common/util/tree_operations.h"
 #include "common/util/vector_tree_test_util.h"
 #include "gmock/gmock.h"
@@ -2157,5 +2158,29 @@ TEST(VectorTreeTest, ChildrenManipulation) {
   EXPECT_TRUE(tree.Children().empty());
 }
 
+TEST(VectorTreeTest, PoolAllocatedRestructuring) {
+  using tree_type = VectorTree<int, PoolAllocator>;
+  tree_type tree(1,            //
+                 tree_type(2,  //
+                           tree_type(6), tree_type(7)),
+                 tree_type(3,  //
+                           tree_type(8), tree_type(9)),
+                 tree_type(4));
+  auto adder = [](int* left, const int& right) { *left += right; };
+  MergeConsecutiveSiblings(tree, 0, adder);
+  EXPECT_THAT(NodeValues(tree), ElementsAre(5, 4));
+  EXPECT_THAT(NodeValues(tree.Children()[0]), ElementsAre(6, 7, 8, 9));
+  FlattenOneChild(tree, 0);
+  EXPECT_THAT(NodeValues(tree), ElementsAre(6, 7, 8, 9, 4));
+  for (const auto& child : tree.Children()) {
+    EXPECT_EQ(child.Parent(), &tree);
+  }
+
+  const tree_type copy(tree);
+  EXPECT_EQ(DeepEqual(tree, copy).left, nullptr);
+  HoistOnlyChild(tree);  // not an only child
+  EXPECT_EQ(tree.Children().size(), 5);
+}
+
 }  // namespace
 }  // namespace verible
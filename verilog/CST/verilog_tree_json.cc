@@ -20,6 +20,7 @@
 #include "common/text/symbol.h"
 #include "common/text/token_info.h"
 #include "common/text/token_info_json.h"
+#include "common/util/json_writer.h"
 #include "common/util/value_saver.h"
 #include "verilog/CST/verilog_nonterminals.h"  // for NodeEnumToString
 #include "verilog/parser/verilog_token.h"
@@ -87,6 +88,49 @@ void VerilogTreeToJsonConverter::Visit(const verible::SyntaxTreeNode& node) {
   }
 }
 
+// Like VerilogTreeToJsonConverter, but writes directly to a JsonWriter.
+// Members are written in the same (sorted) order as nlohmann::json.
+class VerilogTreeJsonWriter : public verible::SymbolVisitor {
+ public:
+  VerilogTreeJsonWriter(absl::string_view base, verible::JsonWriter* writer)
+      : context_(base,
+                 [](std::ostream& stream, int e) {
+                   stream << TokenTypeToString(
+                       static_cast<verilog_tokentype>(e));
+                 }),
+        writer_(*writer) {}
+
+  void Visit(const verible::SyntaxTreeLeaf& leaf) final {
+    const verilog_tokentype tokentype =
+        static_cast<verilog_tokentype>(leaf.Tag().tag);
+    // Same as in VerilogTreeToJsonConverter::Visit().
+    const bool include_text =
+        verilog::IsIdentifierLike(tokentype) ||
+        (leaf.get().text() != TokenTypeToString(tokentype));
+    verible::WriteJson(leaf.get(), context_, include_text, &writer_);
+  }
+
+  void Visit(const verible::SyntaxTreeNode& node) final {
+    writer_.BeginObject();
+    writer_.Key("children").BeginArray();
+    for (const auto& child : node.children()) {
+      if (child) {
+        child->Accept(this);
+      } else {
+        writer_.Null();
+      }
+    }
+    writer_.EndArray();
+    writer_.Key("tag").Value(
+        NodeEnumToString(static_cast<NodeEnum>(node.Tag().tag)));
+    writer_.EndObject();
+  }
+
+ private:
+  const verible::TokenInfo::Context context_;
+  verible::JsonWriter& writer_;
+};
+
 json ConvertVerilogTreeToJson(const verible::Symbol& root,
                               absl::string_view base) {
   VerilogTreeToJsonConverter converter(base);
@@ -94,4 +138,11 @@ json ConvertVerilogTreeToJson(const verible::Symbol& root,
   return converter.TakeJsonValue();
 }
 
+void WriteVerilogTreeAsJson(const verible::Symbol& root,
+                            absl::string_view base,
+                            verible::JsonWriter* writer) {
+  VerilogTreeJsonWriter tree_writer(base, writer);
+  root.Accept(&tree_writer);
+}
+
 }  // namespace verilog
@@ -17,6 +17,7 @@
 
 #include "absl/strings/string_view.h"
 #include "common/text/symbol.h"
+#include "common/util/json_writer.h"
 #include "nlohmann/json.hpp"
 
 namespace verilog {
@@ -25,6 +26,12 @@ namespace verilog {
 nlohmann::json ConvertVerilogTreeToJson(const verible::Symbol& root,
                                         absl::string_view base);
 
+// Writes the same JSON as ConvertVerilogTreeToJson() to 'writer', without
+// building it in memory, which matters for huge trees.
+void WriteVerilogTreeAsJson(const verible::Symbol& root,
+                            absl::string_view base,
+                            verible::JsonWriter* writer);
+
 }  // namespace verilog
 
 #endif  // VERIBLE_VERILOG_CST_VERILOG_TREE_JSON_H_
@@ -15,9 +15,11 @@
 #include "verilog/CST/verilog_tree_json.h"
 
 #include <memory>
+#include <sstream>
 
 #include "absl/strings/string_view.h"
 #include "common/text/symbol.h"
+#include "common/util/json_writer.h"
 #include "common/util/logging.h"
 #include "gtest/gtest.h"
 #include "verilog/analysis/verilog_analyzer.h"
@@ -67,5 +69,24 @@ TEST(VerilogTreeJsonTest, GeneratesGoodJsonTree) {
   EXPECT_EQ(tree_json, expected_json);
 }
 
+TEST(VerilogTreeJsonTest, WriterSameAsConverter) {
+  const auto analyzer_ptr = std::make_unique<VerilogAnalyzer>(
+      "module foo(input a, output b);\n"
+      "  assign b = a ? \"x\\n\" : 1'b0;\n"
+      "endmodule\n",
+      "fake_file.sv");
+  const auto status = ABSL_DIE_IF_NULL(analyzer_ptr)->Analyze();
+  EXPECT_TRUE(status.ok()) << status.message();
+  const verible::SymbolPtr& tree_ptr = analyzer_ptr->SyntaxTree();
+  ASSERT_NE(tree_ptr, nullptr);
+  const absl::string_view base = analyzer_ptr->Data().Contents();
+
+  std::ostringstream stream;
+  verible::JsonWriter writer(&stream);
+  WriteVerilogTreeAsJson(*tree_ptr, base, &writer);
+  EXPECT_TRUE(writer.Done());
+  EXPECT_EQ(stream.str(), ConvertVerilogTreeToJson(*tree_ptr, base).dump(2));
+}
+
 }  // namespace
 }  // namespace verilog
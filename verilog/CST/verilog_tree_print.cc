@@ -16,9 +16,11 @@
 
 #include "verilog/CST/verilog_tree_print.h"
 
+#include <algorithm>
 #include <iostream>
-#include <memory>
 #include <string>
+#include <utility>
+#include <vector>
 
 #include "absl/strings/str_cat.h"
 #include "absl/strings/string_view.h"
@@ -32,41 +34,113 @@
 
 namespace verilog {
 
+// Output is written to the stream once the buffer grows beyond this.
+static constexpr size_t kFlushBytes = 1 << 16;
+
+// Names of all tags, indexed by tag.
+static const std::vector<std::string>& TagNames() {
+  static const auto* const kTagNames = [] {
+    auto* names = new std::vector<std::string>;
+    for (int tag = 0; tag < static_cast<int>(NodeEnum::kInvalidTag); ++tag) {
+      names->push_back(NodeEnumToString(static_cast<NodeEnum>(tag)));
+    }
+    return names;
+  }();
+  return *kTagNames;
+}
+
+static void AppendTagName(int tag, std::string* out) {
+  const auto& names = TagNames();
+  if (tag >= 0 && tag < static_cast<int>(names.size())) {
+    out->append(names[tag]);
+  } else {
+    out->append(NodeEnumToString(static_cast<NodeEnum>(tag)));
+  }
+}
+
 VerilogPrettyPrinter::VerilogPrettyPrinter(std::ostream* output_stream,
-                                           absl::string_view base)
+                                           absl::string_view base,
+                                           VerilogTreePrintOptions options)
     : verible::PrettyPrinter(
           output_stream,
-          verible::TokenInfo::Context(base, [](std::ostream& stream, int e) {
-            stream << verilog_symbol_name(e);
-          })) {}
+          verible::TokenInfo::Context(base,
+                                      [](std::ostream& stream, int e) {
+                                        stream << verilog_symbol_name(e);
+                                      })),
+      base_(base),
+      options_(std::move(options)),
+      printing_(options_.subtree_tags.empty()) {}
+
+VerilogPrettyPrinter::~VerilogPrettyPrinter() { Flush(); }
+
+void VerilogPrettyPrinter::Flush() {
+  stream_->write(buffer_.data(), buffer_.size());
+  buffer_.clear();
+}
+
+void VerilogPrettyPrinter::StartLine(absl::string_view kind) {
+  if (buffer_.size() >= kFlushBytes) Flush();
+  buffer_.append(indent_, ' ');
+  absl::StrAppend(&buffer_, kind, " @", child_rank_, " ");
+}
 
 void VerilogPrettyPrinter::Visit(const verible::SyntaxTreeLeaf& leaf) {
-  auto_indent() << "Leaf @" << child_rank_ << ' '
-                << verible::TokenWithContext{leaf.get(), context_} << std::endl;
+  if (!printing_) return;
+  const verible::TokenInfo& token = leaf.get();
+  const absl::string_view text = token.text();
+  StartLine("Leaf");
+  absl::StrAppend(&buffer_, "(#", verilog_symbol_name(token.token_enum()),
+                  " @", token.left(base_), "-", token.right(base_), ": \"",
+                  text, "\")\n");
 }
 
 void VerilogPrettyPrinter::Visit(const verible::SyntaxTreeNode& node) {
-  std::string tag_info = absl::StrCat(
-      "(tag: ", NodeEnumToString(static_cast<NodeEnum>(node.Tag().tag)), ") ");
-
-  auto_indent() << "Node @" << child_rank_ << ' ' << tag_info << "{"
-                << std::endl;
-
-  {
-    const verible::ValueSaver<int> value_saver(&indent_, indent_ + 2);
-    const verible::ValueSaver<int> rank_saver(&child_rank_, 0);
-    for (const auto& child : node.children()) {
-      // TODO(fangism): display nullptrs or child indices to show position.
-      if (child) child->Accept(this);
-      ++child_rank_;
+  const int tag = node.Tag().tag;
+  const bool subtree_root = !printing_;
+  if (subtree_root) {
+    const auto& tags = options_.subtree_tags;
+    if (std::find(tags.begin(), tags.end(), static_cast<NodeEnum>(tag)) ==
+        tags.end()) {
+      VisitChildren(node);
+      return;
+    }
+    printing_ = true;
+  }
+
+  StartLine("Node");
+  buffer_.append("(tag: ");
+  AppendTagName(tag, &buffer_);
+  buffer_.append(") {");
+  if (options_.max_depth >= 0 && depth_ >= options_.max_depth &&
+      !node.children().empty()) {
+    buffer_.append(" ... }\n");
+  } else {
+    buffer_.push_back('\n');
+    {
+      const verible::ValueSaver<int> value_saver(&indent_, indent_ + 2);
+      const verible::ValueSaver<int> depth_saver(&depth_, depth_ + 1);
+      VisitChildren(node);
     }
+    buffer_.append(indent_, ' ');
+    buffer_.append("}\n");
+  }
+
+  if (subtree_root) printing_ = false;
+}
+
+void VerilogPrettyPrinter::VisitChildren(const verible::SyntaxTreeNode& node) {
+  const verible::ValueSaver<int> rank_saver(&child_rank_, 0);
+  for (const auto& child : node.children()) {
+    // TODO(fangism): display nullptrs or child indices to show position.
+    if (child) child->Accept(this);
+    ++child_rank_;
   }
-  auto_indent() << "}" << std::endl;
 }
 
 void PrettyPrintVerilogTree(const verible::Symbol& root, absl::string_view base,
-                            std::ostream* stream) {
-  VerilogPrettyPrinter printer(stream, base);
+                            std::ostream* stream,
+                            const VerilogTreePrintOptions& options) {
+  VerilogPrettyPrinter printer(stream, base, options);
   root.Accept(&printer);
 }
 
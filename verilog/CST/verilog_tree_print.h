@@ -18,28 +18,61 @@
 #define VERIBLE_VERILOG_CST_VERILOG_TREE_PRINT_H_
 
 #include <iosfwd>
+#include <string>
+#include <vector>
 
+#include "absl/strings/string_view.h"
 #include "common/text/concrete_syntax_leaf.h"
 #include "common/text/concrete_syntax_tree.h"
 #include "common/text/symbol.h"
 #include "common/text/tree_utils.h"
+#include "verilog/CST/verilog_nonterminals.h"
 
 namespace verilog {
 
+// Limits what is printed of a tree.
+struct VerilogTreePrintOptions {
+  // If >= 0, the children of nodes this deep below the root of a printed
+  // (sub)tree are not printed, but elided as "...".
+  int max_depth = -1;
+
+  // If not empty, only the subtrees rooted at nodes with one of these tags
+  // are printed, one after the other, instead of the whole tree.
+  std::vector<NodeEnum> subtree_tags;
+};
+
+// Output is buffered and written to the stream in large blocks, as the trees
+// of large files print to hundreds of MB.
 class VerilogPrettyPrinter : public verible::PrettyPrinter {
  public:
   explicit VerilogPrettyPrinter(std::ostream* output_stream,
-                                absl::string_view base);
+                                absl::string_view base,
+                                VerilogTreePrintOptions options = {});
+  // Writes the rest of the output.
+  ~VerilogPrettyPrinter() override;
 
   void Visit(const verible::SyntaxTreeLeaf&) final;
   void Visit(const verible::SyntaxTreeNode&) final;
 
-  // void Visit(verible::SyntaxTreeNode*) final;
+  // Writes the output so far to the stream.
+  void Flush();
+
+ private:
+  void VisitChildren(const verible::SyntaxTreeNode& node);
+  // Appends the indentation and rank of a line to the buffer.
+  void StartLine(absl::string_view kind);
+
+  const absl::string_view base_;
+  const VerilogTreePrintOptions options_;
+  std::string buffer_;
+  bool printing_;  // Inside a subtree that is printed.
+  int depth_ = 0;  // Below the root of the subtree printed.
 };
 
 // Prints tree contained at root to stream
 void PrettyPrintVerilogTree(const verible::Symbol& root, absl::string_view base,
-                            std::ostream* stream);
+                            std::ostream* stream,
+                            const VerilogTreePrintOptions& options = {});
 
 }  // namespace verilog
 
@@ -56,5 +56,47 @@ TEST(VerilogTreePrintTest, Prints) {
 )");
 }
 
+TEST(VerilogTreePrintTest, PrintsSubtreesToMaxDepth) {
+  const char input[] =
+      "module foo;\nendmodule\nmodule bar;\n  wire w;\nendmodule\n";
+  const auto analyzer =
+      std::make_unique<VerilogAnalyzer>(input, "fake_file.sv");
+  ASSERT_TRUE(analyzer->Analyze().ok());
+  const verible::SymbolPtr& tree_ptr = analyzer->SyntaxTree();
+  ASSERT_NE(tree_ptr, nullptr);
+
+  VerilogTreePrintOptions options;
+  options.subtree_tags = {NodeEnum::kModuleHeader};
+  options.max_depth = 0;
+  std::ostringstream stream;
+  PrettyPrintVerilogTree(*tree_ptr, analyzer->Data().Contents(), &stream,
+                         options);
+  EXPECT_EQ(stream.str(), R"(Node @0 (tag: kModuleHeader) { ... }
+Node @0 (tag: kModuleHeader) { ... }
+)");
+
+  options.subtree_tags = {NodeEnum::kModuleHeader, NodeEnum::kModuleItemList};
+  options.max_depth = 1;
+  stream.str("");
+  PrettyPrintVerilogTree(*tree_ptr, analyzer->Data().Contents(), &stream,
+                         options);
+  EXPECT_EQ(stream.str(), R"(Node @0 (tag: kModuleHeader) {
+  Leaf @0 (#"module" @0-6: "module")
+  Leaf @2 (#SymbolIdentifier @7-10: "foo")
+  Leaf @7 (#';' @10-11: ";")
+}
+Node @1 (tag: kModuleItemList) {
+}
+Node @0 (tag: kModuleHeader) {
+  Leaf @0 (#"module" @22-28: "module")
+  Leaf @2 (#SymbolIdentifier @29-32: "bar")
+  Leaf @7 (#';' @32-33: ";")
+}
+Node @1 (tag: kModuleItemList) {
+  Node @0 (tag: kNetDeclaration) { ... }
+}
+)");
+}
+
 }  // namespace
 }  // namespace verilog
@@ -16,11 +16,13 @@
 
 #include <set>
 #include <string>
+#include <vector>
 
 #include "absl/strings/str_cat.h"
 #include "absl/strings/string_view.h"
 #include "common/analysis/lint_rule_status.h"
 #include "common/analysis/matcher/bound_symbol_manager.h"
+#include "common/analysis/matcher/compiled_matcher.h"
 #include "common/analysis/matcher/matcher.h"
 #include "common/analysis/syntax_tree_search.h"
 #include "common/text/symbol.h"
@@ -38,7 +40,7 @@ using verible::LintRuleStatus;
 using verible::LintViolation;
 using verible::SearchSyntaxTree;
 using verible::SyntaxTreeContext;
-using verible::matcher::Matcher;
+using verible::matcher::CompiledMatcher;
 
 // Register AlwaysCombBlockingRule
 VERILOG_REGISTER_LINT_RULE(AlwaysCombBlockingRule);
@@ -58,11 +60,16 @@ const LintRuleDescriptor& AlwaysCombBlockingRule::GetDescriptor() {
 }
 
 // Matches always_comb blocks.
-static const Matcher& AlwaysCombMatcher() {
-  static const Matcher matcher(NodekAlwaysStatement(AlwaysCombKeyword()));
+static const CompiledMatcher& AlwaysCombMatcher() {
+  static const CompiledMatcher matcher(
+      NodekAlwaysStatement(AlwaysCombKeyword()));
   return matcher;
 }
 
+std::vector<verible::SymbolTag> AlwaysCombBlockingRule::HandledTags() const {
+  return {verible::NodeTag(NodeEnum::kAlwaysStatement)};
+}
+
 void AlwaysCombBlockingRule::HandleSymbol(const verible::Symbol& symbol,
                                           const SyntaxTreeContext& context) {
   verible::matcher::BoundSymbolManager manager;
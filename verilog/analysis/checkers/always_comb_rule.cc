@@ -16,11 +16,13 @@
 
 #include <set>
 #include <string>
+#include <vector>
 
 #include "absl/strings/str_cat.h"
 #include "absl/strings/string_view.h"
 #include "common/analysis/lint_rule_status.h"
 #include "common/analysis/matcher/bound_symbol_manager.h"
+#include "common/analysis/matcher/compiled_matcher.h"
 #include "common/analysis/matcher/matcher.h"
 #include "common/text/symbol.h"
 #include "common/text/syntax_tree_context.h"
@@ -34,7 +36,7 @@ namespace analysis {
 using verible::LintRuleStatus;
 using verible::LintViolation;
 using verible::SyntaxTreeContext;
-using verible::matcher::Matcher;
+using verible::matcher::CompiledMatcher;
 
 // Register AlwaysCombRule
 VERILOG_REGISTER_LINT_RULE(AlwaysCombRule);
@@ -58,18 +60,22 @@ const LintRuleDescriptor& AlwaysCombRule::GetDescriptor() {
 //   always @* begin
 //     f = g + h;
 //   end
-static const Matcher& AlwaysStarMatcher() {
-  static const Matcher matcher(NodekAlwaysStatement(
+static const CompiledMatcher& AlwaysStarMatcher() {
+  static const CompiledMatcher matcher(NodekAlwaysStatement(
       AlwaysKeyword(), AlwaysStatementHasEventControlStar()));
   return matcher;
 }
 
-static const Matcher& AlwaysStarMatcherWithParentheses() {
-  static const Matcher matcher(NodekAlwaysStatement(
+static const CompiledMatcher& AlwaysStarMatcherWithParentheses() {
+  static const CompiledMatcher matcher(NodekAlwaysStatement(
       AlwaysKeyword(), AlwaysStatementHasEventControlStarAndParentheses()));
   return matcher;
 }
 
+std::vector<verible::SymbolTag> AlwaysCombRule::HandledTags() const {
+  return {verible::NodeTag(NodeEnum::kAlwaysStatement)};
+}
+
 void AlwaysCombRule::HandleSymbol(const verible::Symbol& symbol,
                                   const SyntaxTreeContext& context) {
   // Check for offending use of always @*
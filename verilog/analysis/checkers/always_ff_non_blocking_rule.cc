@@ -21,6 +21,7 @@
 #include "absl/strings/string_view.h"
 #include "common/analysis/lint_rule_status.h"
 #include "common/analysis/matcher/bound_symbol_manager.h"
+#include "common/analysis/matcher/compiled_matcher.h"
 #include "common/analysis/matcher/matcher.h"
 #include "common/analysis/syntax_tree_search.h"
 #include "common/text/config_utils.h"
@@ -38,6 +39,7 @@ using verible::LintRuleStatus;
 using verible::LintViolation;
 using verible::SearchSyntaxTree;
 using verible::SyntaxTreeContext;
+using verible::matcher::CompiledMatcher;
 using verible::matcher::Matcher;
 
 //- Info --------------------------------------------------------------------
@@ -92,9 +94,12 @@ void AlwaysFFNonBlockingRule::HandleSymbol(const verible::Symbol& symbol,
   if (context.IsInside(NodeEnum::kLoopHeader)) return;
 
   //- Check for blocking assignments of various kinds -----------------------
-  static const Matcher asgn_blocking_matcher{NodekNetVariableAssignment()};
-  static const Matcher asgn_modify_matcher{NodekAssignModifyStatement()};
-  static const Matcher asgn_incdec_matcher{NodekIncrementDecrementExpression()};
+  static const CompiledMatcher asgn_blocking_matcher{
+      NodekNetVariableAssignment()};
+  static const CompiledMatcher asgn_modify_matcher{
+      NodekAssignModifyStatement()};
+  static const CompiledMatcher asgn_incdec_matcher{
+      NodekIncrementDecrementExpression()};
   static const Matcher ident_matcher{NodekUnqualifiedId()};
 
   // Rule may be waived if complete lhs consists of local variables
@@ -160,9 +165,9 @@ void AlwaysFFNonBlockingRule::HandleSymbol(const verible::Symbol& symbol,
 
 bool AlwaysFFNonBlockingRule::InsideBlock(const verible::Symbol& symbol,
                                           const int depth) {
-  static const Matcher always_ff_matcher{
+  static const CompiledMatcher always_ff_matcher{
       NodekAlwaysStatement(AlwaysFFKeyword())};
-  static const Matcher block_matcher{NodekBlockItemStatementList()};
+  static const CompiledMatcher block_matcher{NodekBlockItemStatementList()};
 
   // Discard state from branches already left
   if (depth <= inside_) inside_ = 0;
@@ -198,7 +203,7 @@ bool AlwaysFFNonBlockingRule::InsideBlock(const verible::Symbol& symbol,
 }  // InsideBlock()
 
 bool AlwaysFFNonBlockingRule::LocalDeclaration(const verible::Symbol& symbol) {
-  static const Matcher decl_matcher{NodekDataDeclaration()};
+  static const CompiledMatcher decl_matcher{NodekDataDeclaration()};
   static const Matcher var_matcher{NodekRegisterVariable()};
 
   verible::matcher::BoundSymbolManager symbol_man;
@@ -15,7 +15,6 @@
 #ifndef VERIBLE_VERILOG_ANALYSIS_CHECKERS_ALWAYS_FF_NON_BLOCKING_RULE_H_
 #define VERIBLE_VERILOG_ANALYSIS_CHECKERS_ALWAYS_FF_NON_BLOCKING_RULE_H_
 
-#include <set>
 #include <stack>
 #include <string>
 
@@ -48,7 +47,7 @@ class AlwaysFFNonBlockingRule : public verible::SyntaxTreeLintRule {
 
  private:
   // Collected violations.
-  std::set<verible::LintViolation> violations_;
+  verible::LintViolationList violations_;
 
   //- Configuration ---------------------
   bool catch_modifying_assignments_ = false;
@@ -16,6 +16,7 @@
 
 #include <set>
 #include <string>
+#include <vector>
 
 #include "absl/strings/match.h"
 #include "absl/strings/str_cat.h"
@@ -51,6 +52,12 @@ const LintRuleDescriptor& BannedDeclaredNamePatternsRule::GetDescriptor() {
   return d;
 }
 
+std::vector<verible::SymbolTag>
+BannedDeclaredNamePatternsRule::HandledTags() const {
+  return {verible::NodeTag(NodeEnum::kModuleDeclaration),
+          verible::NodeTag(NodeEnum::kPackageDeclaration)};
+}
+
 void BannedDeclaredNamePatternsRule::HandleNode(
     const verible::SyntaxTreeNode& node,
     const verible::SyntaxTreeContext& context) {
@@ -15,8 +15,8 @@
 #ifndef VERIBLE_VERILOG_ANALYSIS_CHECKERS_BANNED_DECLARED_NAME_PATTERNS_RULE_H_
 #define VERIBLE_VERILOG_ANALYSIS_CHECKERS_BANNED_DECLARED_NAME_PATTERNS_RULE_H_
 
-#include <set>
 #include <string>
+#include <vector>
 
 #include "common/analysis/lint_rule_status.h"
 #include "common/analysis/matcher/matcher.h"
@@ -40,10 +40,12 @@ class BannedDeclaredNamePatternsRule : public verible::SyntaxTreeLintRule {
   void HandleNode(const verible::SyntaxTreeNode& node,
                   const verible::SyntaxTreeContext& context) final;
 
+  std::vector<verible::SymbolTag> HandledTags() const final;
+
   verible::LintRuleStatus Report() const final;
 
  private:
-  std::set<verible::LintViolation> violations_;
+  verible::LintViolationList violations_;
 };
 
 }  // namespace analysis
@@ -16,10 +16,12 @@
 
 #include <set>
 #include <string>
+#include <vector>
 
 #include "absl/strings/str_cat.h"
 #include "common/analysis/lint_rule_status.h"
 #include "common/analysis/matcher/bound_symbol_manager.h"
+#include "common/analysis/matcher/compiled_matcher.h"
 #include "common/analysis/matcher/core_matchers.h"
 #include "common/analysis/matcher/matcher.h"
 #include "common/analysis/matcher/matcher_builders.h"
@@ -34,7 +36,7 @@ namespace analysis {
 
 using verible::LintRuleStatus;
 using verible::LintViolation;
-using verible::matcher::Matcher;
+using verible::matcher::CompiledMatcher;
 
 // Register CaseMissingDefaultRule
 VERILOG_REGISTER_LINT_RULE(CaseMissingDefaultRule);
@@ -51,12 +53,16 @@ const LintRuleDescriptor& CaseMissingDefaultRule::GetDescriptor() {
   return d;
 }
 
-static const Matcher& CaseMatcher() {
-  static const Matcher matcher(
+static const CompiledMatcher& CaseMatcher() {
+  static const CompiledMatcher matcher(
       NodekCaseItemList(verible::matcher::Unless(HasDefaultCase())));
   return matcher;
 }
 
+std::vector<verible::SymbolTag> CaseMissingDefaultRule::HandledTags() const {
+  return {verible::NodeTag(NodeEnum::kCaseItemList)};
+}
+
 void CaseMissingDefaultRule::HandleSymbol(
     const verible::Symbol& symbol, const verible::SyntaxTreeContext& context) {
   verible::matcher::BoundSymbolManager manager;
@@ -15,8 +15,8 @@
 #ifndef VERIBLE_VERILOG_ANALYSIS_CHECKERS_CASE_MISSING_DEFAULT_RULE_H_
 #define VERIBLE_VERILOG_ANALYSIS_CHECKERS_CASE_MISSING_DEFAULT_RULE_H_
 
-#include <set>
 #include <string>
+#include <vector>
 
 #include "common/analysis/lint_rule_status.h"
 #include "common/analysis/syntax_tree_lint_rule.h"
@@ -38,10 +38,12 @@ class CaseMissingDefaultRule : public verible::SyntaxTreeLintRule {
   void HandleSymbol(const verible::Symbol& symbol,
                     const verible::SyntaxTreeContext& context) final;
 
+  std::vector<verible::SymbolTag> HandledTags() const final;
+
   verible::LintRuleStatus Report() const final;
 
  private:
-  std::set<verible::LintViolation> violations_;
+  verible::LintViolationList violations_;
 };
 
 }  // namespace analysis
@@ -18,11 +18,13 @@
 #include <memory>
 #include <set>
 #include <string>
+#include <vector>
 
 #include "absl/strings/str_cat.h"
 #include "absl/strings/string_view.h"
 #include "common/analysis/lint_rule_status.h"
 #include "common/analysis/matcher/bound_symbol_manager.h"
+#include "common/analysis/matcher/compiled_matcher.h"
 #include "common/text/concrete_syntax_leaf.h"
 #include "common/text/concrete_syntax_tree.h"
 #include "common/text/symbol.h"
@@ -48,7 +50,7 @@ using verible::SyntaxTreeContext;
 using verible::SyntaxTreeLeaf;
 using verible::SyntaxTreeNode;
 using verible::TokenInfo;
-using verible::matcher::Matcher;
+using verible::matcher::CompiledMatcher;
 
 // Register CreateObjectNameMatchRule
 VERILOG_REGISTER_LINT_RULE(CreateObjectNameMatchRule);
@@ -72,9 +74,9 @@ const LintRuleDescriptor& CreateObjectNameMatchRule::GetDescriptor() {
 // Here, the LHS var_h will be bound to "lval" (only for simple references),
 // the qualified function call (mytype::type_id::create) will be bound to
 // "func", and the list of function call arguments will be bound to "args".
-static const Matcher& CreateAssignmentMatcher() {
+static const CompiledMatcher& CreateAssignmentMatcher() {
   // function-local static to avoid initialization-ordering problems
-  static const Matcher matcher(NodekNetVariableAssignment(
+  static const CompiledMatcher matcher(NodekNetVariableAssignment(
       PathkLPValue(PathkReferenceCallBase().Bind("lval_ref")),
       RValueIsFunctionCall(FunctionCallIsQualified().Bind("func"),
                            FunctionCallArguments().Bind("args"))));
@@ -178,6 +180,10 @@ static std::string FormatReason(absl::string_view decl_name,
       decl_name, ", got: ", name_text, ". ");
 }
 
+std::vector<verible::SymbolTag> CreateObjectNameMatchRule::HandledTags() const {
+  return {verible::NodeTag(NodeEnum::kNetVariableAssignment)};
+}
+
 void CreateObjectNameMatchRule::HandleSymbol(const verible::Symbol& symbol,
                                              const SyntaxTreeContext& context) {
   // Check for assignments that match the pattern.
@@ -16,11 +16,13 @@
 
 #include <set>
 #include <string>
+#include <vector>
 
 #include "absl/strings/str_cat.h"
 #include "absl/strings/string_view.h"
 #include "common/analysis/lint_rule_status.h"
 #include "common/analysis/matcher/bound_symbol_manager.h"
+#include "common/analysis/matcher/compiled_matcher.h"
 #include "common/analysis/matcher/core_matchers.h"
 #include "common/analysis/matcher/matcher.h"
 #include "common/text/symbol.h"
@@ -37,7 +39,7 @@ namespace analysis {
 using verible::LintRuleStatus;
 using verible::LintViolation;
 using verible::SyntaxTreeContext;
-using verible::matcher::Matcher;
+using verible::matcher::CompiledMatcher;
 
 VERILOG_REGISTER_LINT_RULE(DisableStatementNoLabelsRule);
 
@@ -60,12 +62,17 @@ const LintRuleDescriptor& DisableStatementNoLabelsRule::GetDescriptor() {
   return d;
 }
 
-static const Matcher& DisableMatcher() {
-  static const Matcher matcher(
+static const CompiledMatcher& DisableMatcher() {
+  static const CompiledMatcher matcher(
       NodekDisableStatement(DisableStatementHasLabel()));
   return matcher;
 }
 
+std::vector<verible::SymbolTag>
+DisableStatementNoLabelsRule::HandledTags() const {
+  return {verible::NodeTag(NodeEnum::kDisableStatement)};
+}
+
 void DisableStatementNoLabelsRule::HandleSymbol(
     const verible::Symbol& symbol, const SyntaxTreeContext& context) {
   verible::matcher::BoundSymbolManager manager;
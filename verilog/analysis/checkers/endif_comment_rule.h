@@ -15,7 +15,6 @@
 #ifndef VERIBLE_VERILOG_ANALYSIS_CHECKERS_ENDIF_COMMENT_RULE_H_
 #define VERIBLE_VERILOG_ANALYSIS_CHECKERS_ENDIF_COMMENT_RULE_H_
 
-#include <set>
 #include <stack>
 #include <string>
 
@@ -74,7 +73,7 @@ class EndifCommentRule : public verible::TokenStreamLintRule {
   std::stack<verible::TokenInfo> conditional_scopes_;
 
   // Collection of found violations.
-  std::set<verible::LintViolation> violations_;
+  verible::LintViolationList violations_;
 };
 
 }  // namespace analysis
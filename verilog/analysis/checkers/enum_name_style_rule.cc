@@ -16,11 +16,13 @@
 
 #include <set>
 #include <string>
+#include <vector>
 
 #include "absl/strings/match.h"
 #include "absl/strings/str_cat.h"
 #include "common/analysis/lint_rule_status.h"
 #include "common/analysis/matcher/bound_symbol_manager.h"
+#include "common/analysis/matcher/compiled_matcher.h"
 #include "common/analysis/matcher/matcher.h"
 #include "common/strings/naming_utils.h"
 #include "common/text/symbol.h"
@@ -37,7 +39,7 @@ VERILOG_REGISTER_LINT_RULE(EnumNameStyleRule);
 using verible::LintRuleStatus;
 using verible::LintViolation;
 using verible::SyntaxTreeContext;
-using verible::matcher::Matcher;
+using verible::matcher::CompiledMatcher;
 
 static constexpr absl::string_view kMessage =
     "Enum names must use lower_snake_case naming convention "
@@ -54,11 +56,15 @@ const LintRuleDescriptor& EnumNameStyleRule::GetDescriptor() {
   return d;
 }
 
-static const Matcher& TypedefMatcher() {
-  static const Matcher matcher(NodekTypeDeclaration());
+static const CompiledMatcher& TypedefMatcher() {
+  static const CompiledMatcher matcher(NodekTypeDeclaration());
   return matcher;
 }
 
+std::vector<verible::SymbolTag> EnumNameStyleRule::HandledTags() const {
+  return {verible::NodeTag(NodeEnum::kTypeDeclaration)};
+}
+
 void EnumNameStyleRule::HandleSymbol(const verible::Symbol& symbol,
                                      const SyntaxTreeContext& context) {
   verible::matcher::BoundSymbolManager manager;
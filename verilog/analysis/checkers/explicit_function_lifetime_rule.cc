@@ -16,10 +16,12 @@
 
 #include <set>
 #include <string>
+#include <vector>
 
 #include "absl/strings/str_cat.h"
 #include "common/analysis/lint_rule_status.h"
 #include "common/analysis/matcher/bound_symbol_manager.h"
+#include "common/analysis/matcher/compiled_matcher.h"
 #include "common/analysis/matcher/matcher.h"
 #include "common/text/symbol.h"
 #include "common/text/syntax_tree_context.h"
@@ -37,7 +39,7 @@ namespace analysis {
 using verible::LintRuleStatus;
 using verible::LintViolation;
 using verible::SyntaxTreeContext;
-using Matcher = verible::matcher::Matcher;
+using verible::matcher::CompiledMatcher;
 
 // Register ExplicitFunctionLifetimeRule
 VERILOG_REGISTER_LINT_RULE(ExplicitFunctionLifetimeRule);
@@ -56,11 +58,16 @@ const LintRuleDescriptor& ExplicitFunctionLifetimeRule::GetDescriptor() {
   return d;
 }
 
-static const Matcher& FunctionMatcher() {
-  static const Matcher matcher(NodekFunctionDeclaration());
+static const CompiledMatcher& FunctionMatcher() {
+  static const CompiledMatcher matcher(NodekFunctionDeclaration());
   return matcher;
 }
 
+std::vector<verible::SymbolTag>
+ExplicitFunctionLifetimeRule::HandledTags() const {
+  return {verible::NodeTag(NodeEnum::kFunctionDeclaration)};
+}
+
 void ExplicitFunctionLifetimeRule::HandleSymbol(
     const verible::Symbol& symbol, const SyntaxTreeContext& context) {
   // Don't need to check for lifetime declaration if context is inside a class
@@ -16,10 +16,12 @@
 
 #include <set>
 #include <string>
+#include <vector>
 
 #include "absl/strings/str_cat.h"
 #include "common/analysis/lint_rule_status.h"
 #include "common/analysis/matcher/bound_symbol_manager.h"
+#include "common/analysis/matcher/compiled_matcher.h"
 #include "common/analysis/matcher/matcher.h"
 #include "common/text/concrete_syntax_leaf.h"
 #include "common/text/symbol.h"
@@ -37,7 +39,7 @@ namespace analysis {
 using verible::LintRuleStatus;
 using verible::LintViolation;
 using verible::SyntaxTreeContext;
-using Matcher = verible::matcher::Matcher;
+using verible::matcher::CompiledMatcher;
 
 // Register ExplicitFunctionTaskParameterTypeRule
 VERILOG_REGISTER_LINT_RULE(ExplicitFunctionTaskParameterTypeRule);
@@ -57,11 +59,16 @@ ExplicitFunctionTaskParameterTypeRule::GetDescriptor() {
   return d;
 }
 
-static const Matcher& PortMatcher() {
-  static const Matcher matcher(NodekPortItem());
+static const CompiledMatcher& PortMatcher() {
+  static const CompiledMatcher matcher(NodekPortItem());
   return matcher;
 }
 
+std::vector<verible::SymbolTag>
+ExplicitFunctionTaskParameterTypeRule::HandledTags() const {
+  return {verible::NodeTag(NodeEnum::kPortItem)};
+}
+
 void ExplicitFunctionTaskParameterTypeRule::HandleSymbol(
     const verible::Symbol& symbol, const SyntaxTreeContext& context) {
   verible::matcher::BoundSymbolManager manager;
@@ -16,11 +16,13 @@
 
 #include <set>
 #include <string>
+#include <vector>
 
 #include "absl/strings/str_cat.h"
 #include "absl/strings/str_split.h"
 #include "common/analysis/lint_rule_status.h"
 #include "common/analysis/matcher/bound_symbol_manager.h"
+#include "common/analysis/matcher/compiled_matcher.h"
 #include "common/analysis/matcher/matcher.h"
 #include "common/text/config_utils.h"
 #include "common/text/symbol.h"
@@ -37,7 +39,7 @@ namespace analysis {
 using verible::LintRuleStatus;
 using verible::LintViolation;
 using verible::SyntaxTreeContext;
-using Matcher = verible::matcher::Matcher;
+using verible::matcher::CompiledMatcher;
 
 // Register ExplicitParameterStorageTypeRule
 VERILOG_REGISTER_LINT_RULE(ExplicitParameterStorageTypeRule);
@@ -57,8 +59,8 @@ const LintRuleDescriptor& ExplicitParameterStorageTypeRule::GetDescriptor() {
   return d;
 }
 
-static const Matcher& ParamMatcher() {
-  static const Matcher matcher(NodekParamDeclaration());
+static const CompiledMatcher& ParamMatcher() {
+  static const CompiledMatcher matcher(NodekParamDeclaration());
   return matcher;
 }
 
@@ -73,6 +75,11 @@ static bool HasStringAssignment(const verible::Symbol& param_decl) {
          verilog_tokentype::TK_StringLiteral;
 }
 
+std::vector<verible::SymbolTag>
+ExplicitParameterStorageTypeRule::HandledTags() const {
+  return {verible::NodeTag(NodeEnum::kParamDeclaration)};
+}
+
 void ExplicitParameterStorageTypeRule::HandleSymbol(
     const verible::Symbol& symbol, const SyntaxTreeContext& context) {
   verible::matcher::BoundSymbolManager manager;
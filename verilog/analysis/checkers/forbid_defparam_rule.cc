@@ -16,10 +16,12 @@
 
 #include <set>
 #include <string>
+#include <vector>
 
 #include "absl/strings/str_cat.h"
 #include "common/analysis/lint_rule_status.h"
 #include "common/analysis/matcher/bound_symbol_manager.h"
+#include "common/analysis/matcher/compiled_matcher.h"
 #include "common/analysis/matcher/matcher.h"
 #include "common/text/symbol.h"
 #include "common/text/syntax_tree_context.h"
@@ -30,7 +32,7 @@
 namespace verilog {
 namespace analysis {
 
-using verible::matcher::Matcher;
+using verible::matcher::CompiledMatcher;
 
 // Register the lint rule
 VERILOG_REGISTER_LINT_RULE(ForbidDefparamRule);
@@ -47,11 +49,15 @@ const LintRuleDescriptor& ForbidDefparamRule::GetDescriptor() {
 }
 
 // Matches the defparam construct.
-static const Matcher& OverrideMatcher() {
-  static const Matcher matcher(NodekParameterOverride());
+static const CompiledMatcher& OverrideMatcher() {
+  static const CompiledMatcher matcher(NodekParameterOverride());
   return matcher;
 }
 
+std::vector<verible::SymbolTag> ForbidDefparamRule::HandledTags() const {
+  return {verible::NodeTag(NodeEnum::kParameterOverride)};
+}
+
 void ForbidDefparamRule::HandleSymbol(
     const verible::Symbol& symbol, const verible::SyntaxTreeContext& context) {
   verible::matcher::BoundSymbolManager manager;
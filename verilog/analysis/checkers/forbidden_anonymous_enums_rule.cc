@@ -16,10 +16,12 @@
 
 #include <set>
 #include <string>
+#include <vector>
 
 #include "absl/strings/str_cat.h"
 #include "common/analysis/lint_rule_status.h"
 #include "common/analysis/matcher/bound_symbol_manager.h"
+#include "common/analysis/matcher/compiled_matcher.h"
 #include "common/analysis/matcher/matcher.h"
 #include "common/text/symbol.h"
 #include "common/text/syntax_tree_context.h"
@@ -32,7 +34,7 @@ namespace analysis {
 
 using verible::LintRuleStatus;
 using verible::LintViolation;
-using Matcher = verible::matcher::Matcher;
+using verible::matcher::CompiledMatcher;
 
 // Register the lint rule
 VERILOG_REGISTER_LINT_RULE(ForbiddenAnonymousEnumsRule);
@@ -51,11 +53,16 @@ const LintRuleDescriptor& ForbiddenAnonymousEnumsRule::GetDescriptor() {
   return d;
 }
 
-static const Matcher& EnumMatcher() {
-  static const Matcher matcher(NodekEnumType());
+static const CompiledMatcher& EnumMatcher() {
+  static const CompiledMatcher matcher(NodekEnumType());
   return matcher;
 }
 
+std::vector<verible::SymbolTag>
+ForbiddenAnonymousEnumsRule::HandledTags() const {
+  return {verible::NodeTag(NodeEnum::kEnumType)};
+}
+
 void ForbiddenAnonymousEnumsRule::HandleSymbol(
     const verible::Symbol& symbol, const verible::SyntaxTreeContext& context) {
   verible::matcher::BoundSymbolManager manager;
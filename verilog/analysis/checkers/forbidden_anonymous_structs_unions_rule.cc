@@ -16,11 +16,13 @@
 
 #include <set>
 #include <string>
+#include <vector>
 
 #include "absl/strings/match.h"
 #include "absl/strings/str_cat.h"
 #include "common/analysis/lint_rule_status.h"
 #include "common/analysis/matcher/bound_symbol_manager.h"
+#include "common/analysis/matcher/compiled_matcher.h"
 #include "common/analysis/matcher/matcher.h"
 #include "common/text/config_utils.h"
 #include "common/text/symbol.h"
@@ -34,7 +36,7 @@ namespace analysis {
 
 using verible::LintRuleStatus;
 using verible::LintViolation;
-using verible::matcher::Matcher;
+using verible::matcher::CompiledMatcher;
 
 // Register the lint rule
 VERILOG_REGISTER_LINT_RULE(ForbiddenAnonymousStructsUnionsRule);
@@ -65,13 +67,13 @@ absl::Status ForbiddenAnonymousStructsUnionsRule::Configure(
       {{"allow_anonymous_nested", SetBool(&allow_anonymous_nested_type_)}});
 }
 
-static const Matcher& StructMatcher() {
-  static const Matcher matcher(NodekStructType());
+static const CompiledMatcher& StructMatcher() {
+  static const CompiledMatcher matcher(NodekStructType());
   return matcher;
 }
 
-static const Matcher& UnionMatcher() {
-  static const Matcher matcher(NodekUnionType());
+static const CompiledMatcher& UnionMatcher() {
+  static const CompiledMatcher matcher(NodekUnionType());
   return matcher;
 }
 
@@ -91,6 +93,12 @@ bool ForbiddenAnonymousStructsUnionsRule::IsRuleMet(
          (allow_anonymous_nested_type_ && NestedInStructOrUnion(context));
 }
 
+std::vector<verible::SymbolTag>
+ForbiddenAnonymousStructsUnionsRule::HandledTags() const {
+  return {verible::NodeTag(NodeEnum::kStructType),
+          verible::NodeTag(NodeEnum::kUnionType)};
+}
+
 void ForbiddenAnonymousStructsUnionsRule::HandleSymbol(
     const verible::Symbol& symbol, const verible::SyntaxTreeContext& context) {
   verible::matcher::BoundSymbolManager manager;
@@ -17,12 +17,14 @@
 #include <map>
 #include <set>
 #include <string>
+#include <vector>
 
 #include "absl/strings/str_cat.h"
 #include "absl/strings/string_view.h"
 #include "common/analysis/citation.h"
 #include "common/analysis/lint_rule_status.h"
 #include "common/analysis/matcher/bound_symbol_manager.h"
+#include "common/analysis/matcher/compiled_matcher.h"
 #include "common/analysis/matcher/matcher.h"
 #include "common/text/concrete_syntax_leaf.h"
 #include "common/text/symbol.h"
@@ -38,7 +40,7 @@ namespace analysis {
 
 using verible::GetStyleGuideCitation;
 using verible::container::FindWithDefault;
-using verible::matcher::Matcher;
+using verible::matcher::CompiledMatcher;
 
 // Register ForbiddenMacroRule
 VERILOG_REGISTER_LINT_RULE(ForbiddenMacroRule);
@@ -54,8 +56,8 @@ const LintRuleDescriptor& ForbiddenMacroRule::GetDescriptor() {
 }
 
 // Matches all macro call ids, like `foo.
-static const Matcher& MacroCallMatcher() {
-  static const Matcher matcher(MacroCallIdLeaf().Bind("name"));
+static const CompiledMatcher& MacroCallMatcher() {
+  static const CompiledMatcher matcher(MacroCallIdLeaf().Bind("name"));
   return matcher;
 }
 
@@ -69,6 +71,10 @@ ForbiddenMacroRule::InvalidMacrosMap() {
   return *invalid_symbols;
 }
 
+std::vector<verible::SymbolTag> ForbiddenMacroRule::HandledTags() const {
+  return {verible::LeafTag(MacroCallId)};
+}
+
 void ForbiddenMacroRule::HandleSymbol(
     const verible::Symbol& symbol, const verible::SyntaxTreeContext& context) {
   verible::matcher::BoundSymbolManager manager;
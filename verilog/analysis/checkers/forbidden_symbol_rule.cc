@@ -17,11 +17,13 @@
 #include <map>
 #include <set>
 #include <string>
+#include <vector>
 
 #include "absl/strings/str_cat.h"
 #include "absl/strings/string_view.h"
 #include "common/analysis/lint_rule_status.h"
 #include "common/analysis/matcher/bound_symbol_manager.h"
+#include "common/analysis/matcher/compiled_matcher.h"
 #include "common/analysis/matcher/matcher.h"
 #include "common/text/concrete_syntax_leaf.h"
 #include "common/text/symbol.h"
@@ -36,7 +38,7 @@ namespace verilog {
 namespace analysis {
 
 using verible::container::FindWithDefault;
-using verible::matcher::Matcher;
+using verible::matcher::CompiledMatcher;
 
 // Register ForbiddenSystemTaskFunctionRule
 VERILOG_REGISTER_LINT_RULE(ForbiddenSystemTaskFunctionRule);
@@ -53,8 +55,8 @@ const LintRuleDescriptor& ForbiddenSystemTaskFunctionRule::GetDescriptor() {
   return d;
 }
 
-static const Matcher& IdMatcher() {
-  static const Matcher matcher(SystemTFIdentifierLeaf().Bind("name"));
+static const CompiledMatcher& IdMatcher() {
+  static const CompiledMatcher matcher(SystemTFIdentifierLeaf().Bind("name"));
   return matcher;
 }
 
@@ -77,6 +79,11 @@ ForbiddenSystemTaskFunctionRule::InvalidSymbolsMap() {
   return *invalid_symbols;
 }
 
+std::vector<verible::SymbolTag>
+ForbiddenSystemTaskFunctionRule::HandledTags() const {
+  return {verible::LeafTag(SystemTFIdentifier)};
+}
+
 void ForbiddenSystemTaskFunctionRule::HandleSymbol(
     const verible::Symbol& symbol, const verible::SyntaxTreeContext& context) {
   verible::matcher::BoundSymbolManager manager;
@@ -21,6 +21,7 @@
 #include "absl/strings/str_cat.h"
 #include "common/analysis/lint_rule_status.h"
 #include "common/analysis/matcher/bound_symbol_manager.h"
+#include "common/analysis/matcher/compiled_matcher.h"
 #include "common/analysis/matcher/matcher.h"
 #include "common/text/symbol.h"
 #include "common/text/syntax_tree_context.h"
@@ -33,7 +34,7 @@
 namespace verilog {
 namespace analysis {
 
-using verible::matcher::Matcher;
+using verible::matcher::CompiledMatcher;
 
 // Register the lint rule
 VERILOG_REGISTER_LINT_RULE(GenerateLabelPrefixRule);
@@ -55,11 +56,15 @@ const LintRuleDescriptor& GenerateLabelPrefixRule::GetDescriptor() {
 }
 
 // Matches begin statements
-static const Matcher& BlockMatcher() {
-  static const Matcher matcher(NodekGenerateBlock());
+static const CompiledMatcher& BlockMatcher() {
+  static const CompiledMatcher matcher(NodekGenerateBlock());
   return matcher;
 }
 
+std::vector<verible::SymbolTag> GenerateLabelPrefixRule::HandledTags() const {
+  return {verible::NodeTag(NodeEnum::kGenerateBlock)};
+}
+
 void GenerateLabelPrefixRule::HandleSymbol(
     const verible::Symbol& symbol, const verible::SyntaxTreeContext& context) {
   verible::matcher::BoundSymbolManager manager;
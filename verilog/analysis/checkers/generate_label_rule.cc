@@ -16,10 +16,12 @@
 
 #include <set>
 #include <string>
+#include <vector>
 
 #include "absl/strings/str_cat.h"
 #include "common/analysis/lint_rule_status.h"
 #include "common/analysis/matcher/bound_symbol_manager.h"
+#include "common/analysis/matcher/compiled_matcher.h"
 #include "common/analysis/matcher/core_matchers.h"
 #include "common/analysis/matcher/matcher.h"
 #include "common/text/symbol.h"
@@ -31,7 +33,7 @@
 namespace verilog {
 namespace analysis {
 
-using verible::matcher::Matcher;
+using verible::matcher::CompiledMatcher;
 
 // Register the lint rule
 VERILOG_REGISTER_LINT_RULE(GenerateLabelRule);
@@ -55,12 +57,16 @@ const LintRuleDescriptor& GenerateLabelRule::GetDescriptor() {
 //      always @(posedge clk) foo <= bar;
 //    end
 //
-static const Matcher& BlockMatcher() {
-  static const Matcher matcher(
+static const CompiledMatcher& BlockMatcher() {
+  static const CompiledMatcher matcher(
       NodekGenerateBlock(verible::matcher::Unless(HasBeginLabel())));
   return matcher;
 }
 
+std::vector<verible::SymbolTag> GenerateLabelRule::HandledTags() const {
+  return {verible::NodeTag(NodeEnum::kGenerateBlock)};
+}
+
 void GenerateLabelRule::HandleSymbol(
     const verible::Symbol& symbol, const verible::SyntaxTreeContext& context) {
   verible::matcher::BoundSymbolManager manager;
@@ -16,11 +16,13 @@
 
 #include <set>
 #include <string>
+#include <vector>
 
 #include "absl/strings/match.h"
 #include "absl/strings/str_cat.h"
 #include "common/analysis/lint_rule_status.h"
 #include "common/analysis/matcher/bound_symbol_manager.h"
+#include "common/analysis/matcher/compiled_matcher.h"
 #include "common/analysis/matcher/matcher.h"
 #include "common/strings/naming_utils.h"
 #include "common/text/symbol.h"
@@ -38,7 +40,7 @@ VERILOG_REGISTER_LINT_RULE(InterfaceNameStyleRule);
 using verible::LintRuleStatus;
 using verible::LintViolation;
 using verible::SyntaxTreeContext;
-using verible::matcher::Matcher;
+using verible::matcher::CompiledMatcher;
 
 static constexpr absl::string_view kMessage =
     "Interface names must use lower_snake_case naming convention "
@@ -55,11 +57,15 @@ const LintRuleDescriptor& InterfaceNameStyleRule::GetDescriptor() {
   return d;
 }
 
-static const Matcher& InterfaceMatcher() {
-  static const Matcher matcher(NodekInterfaceDeclaration());
+static const CompiledMatcher& InterfaceMatcher() {
+  static const CompiledMatcher matcher(NodekInterfaceDeclaration());
   return matcher;
 }
 
+std::vector<verible::SymbolTag> InterfaceNameStyleRule::HandledTags() const {
+  return {verible::NodeTag(NodeEnum::kInterfaceDeclaration)};
+}
+
 void InterfaceNameStyleRule::HandleSymbol(const verible::Symbol& symbol,
                                           const SyntaxTreeContext& context) {
   verible::matcher::BoundSymbolManager manager;
@@ -16,6 +16,7 @@
 
 #include <set>
 #include <string>
+#include <vector>
 
 #include "absl/strings/match.h"
 #include "absl/strings/str_cat.h"
@@ -49,6 +50,10 @@ const LintRuleDescriptor& LegacyGenerateRegionRule::GetDescriptor() {
   return d;
 }
 
+std::vector<verible::SymbolTag> LegacyGenerateRegionRule::HandledTags() const {
+  return {verible::NodeTag(NodeEnum::kGenerateRegion)};
+}
+
 void LegacyGenerateRegionRule::HandleNode(
     const verible::SyntaxTreeNode& node,
     const verible::SyntaxTreeContext& context) {
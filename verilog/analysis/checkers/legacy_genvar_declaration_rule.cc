@@ -16,6 +16,7 @@
 
 #include <set>
 #include <string>
+#include <vector>
 
 #include "absl/strings/match.h"
 #include "absl/strings/str_cat.h"
@@ -49,6 +50,11 @@ const LintRuleDescriptor& LegacyGenvarDeclarationRule::GetDescriptor() {
   return d;
 }
 
+std::vector<verible::SymbolTag>
+LegacyGenvarDeclarationRule::HandledTags() const {
+  return {verible::NodeTag(NodeEnum::kGenvarDeclaration)};
+}
+
 void LegacyGenvarDeclarationRule::HandleNode(
     const verible::SyntaxTreeNode& node,
     const verible::SyntaxTreeContext& context) {
@@ -162,6 +162,11 @@ void LineLengthRule::Lint(const TextStructureView& text_structure,
                           absl::string_view) {
   size_t lineno = 0;
   for (const auto& line : text_structure.Lines()) {
+    // Characters are never more than bytes, so most lines need no counting.
+    if (line.length() <= static_cast<size_t>(line_length_limit_)) {
+      ++lineno;
+      continue;
+    }
     const int observed_line_length = verible::utf8_len(line);
     if (observed_line_length > line_length_limit_) {
       const auto token_range = text_structure.TokenRangeOnLine(lineno);
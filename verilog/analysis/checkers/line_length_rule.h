@@ -15,7 +15,6 @@
 #ifndef VERIBLE_VERILOG_ANALYSIS_CHECKERS_LINE_LENGTH_RULE_H_
 #define VERIBLE_VERILOG_ANALYSIS_CHECKERS_LINE_LENGTH_RULE_H_
 
-#include <set>
 #include <string>
 
 #include "absl/status/status.h"
@@ -51,13 +50,15 @@ class LineLengthRule : public verible::TextStructureLintRule {
 
   void Lint(const verible::TextStructureView&, absl::string_view) final;
 
+  bool UsesSyntaxTree() const final { return false; }
+
   verible::LintRuleStatus Report() const final;
 
  private:
   int line_length_limit_ = kDefaultLineLength;
 
   // Collection of found violations.
-  std::set<verible::LintViolation> violations_;
+  verible::LintViolationList violations_;
 };
 
 }  // namespace analysis
@@ -15,7 +15,6 @@
 #ifndef VERIBLE_VERILOG_ANALYSIS_CHECKERS_MACRO_STRING_CONCATENATION_RULE_H_
 #define VERIBLE_VERILOG_ANALYSIS_CHECKERS_MACRO_STRING_CONCATENATION_RULE_H_
 
-#include <set>
 #include <string>
 
 #include "common/analysis/token_stream_lint_rule.h"
@@ -49,7 +48,7 @@ class MacroStringConcatenationRule : public verible::TokenStreamLintRule {
   // Internal lexical analysis state.
   State state_ = State::kNormal;
 
-  std::set<verible::LintViolation> violations_;
+  verible::LintViolationList violations_;
 };
 
 }  // namespace analysis
@@ -16,10 +16,12 @@
 
 #include <set>
 #include <string>
+#include <vector>
 
 #include "absl/strings/str_cat.h"
 #include "common/analysis/lint_rule_status.h"
 #include "common/analysis/matcher/bound_symbol_manager.h"
+#include "common/analysis/matcher/compiled_matcher.h"
 #include "common/analysis/matcher/matcher.h"
 #include "common/analysis/syntax_tree_search.h"
 #include "common/text/concrete_syntax_tree.h"
@@ -35,7 +37,7 @@
 namespace verilog {
 namespace analysis {
 
-using verible::matcher::Matcher;
+using verible::matcher::CompiledMatcher;
 
 // Register the lint rule
 VERILOG_REGISTER_LINT_RULE(MismatchedLabelsRule);
@@ -55,11 +57,15 @@ const LintRuleDescriptor& MismatchedLabelsRule::GetDescriptor() {
 }
 
 // Matches the begin node.
-static const Matcher& BeginMatcher() {
-  static const Matcher matcher(NodekBegin());
+static const CompiledMatcher& BeginMatcher() {
+  static const CompiledMatcher matcher(NodekBegin());
   return matcher;
 }
 
+std::vector<verible::SymbolTag> MismatchedLabelsRule::HandledTags() const {
+  return {verible::NodeTag(NodeEnum::kBegin)};
+}
+
 void MismatchedLabelsRule::HandleSymbol(
     const verible::Symbol& symbol, const verible::SyntaxTreeContext& context) {
   verible::matcher::BoundSymbolManager manager;
@@ -16,10 +16,12 @@
 
 #include <set>
 #include <string>
+#include <vector>
 
 #include "absl/strings/str_cat.h"
 #include "common/analysis/lint_rule_status.h"
 #include "common/analysis/matcher/bound_symbol_manager.h"
+#include "common/analysis/matcher/compiled_matcher.h"
 #include "common/analysis/matcher/matcher.h"
 #include "common/text/symbol.h"
 #include "common/text/syntax_tree_context.h"
@@ -30,7 +32,7 @@
 namespace verilog {
 namespace analysis {
 
-using verible::matcher::Matcher;
+using verible::matcher::CompiledMatcher;
 
 // Register the lint rule
 VERILOG_REGISTER_LINT_RULE(ModuleBeginBlockRule);
@@ -50,11 +52,15 @@ const LintRuleDescriptor& ModuleBeginBlockRule::GetDescriptor() {
 }
 
 // Matches begin-end blocks at the module-item level.
-static const Matcher& BlockMatcher() {
-  static const Matcher matcher(NodekModuleBlock());
+static const CompiledMatcher& BlockMatcher() {
+  static const CompiledMatcher matcher(NodekModuleBlock());
   return matcher;
 }
 
+std::vector<verible::SymbolTag> ModuleBeginBlockRule::HandledTags() const {
+  return {verible::NodeTag(NodeEnum::kModuleBlock)};
+}
+
 void ModuleBeginBlockRule::HandleSymbol(
     const verible::Symbol& symbol, const verible::SyntaxTreeContext& context) {
   verible::matcher::BoundSymbolManager manager;
@@ -18,10 +18,12 @@
 #include <memory>
 #include <set>
 #include <string>
+#include <vector>
 
 #include "absl/strings/str_cat.h"
 #include "common/analysis/lint_rule_status.h"
 #include "common/analysis/matcher/bound_symbol_manager.h"
+#include "common/analysis/matcher/compiled_matcher.h"
 #include "common/analysis/matcher/matcher.h"
 #include "common/text/concrete_syntax_leaf.h"
 #include "common/text/concrete_syntax_tree.h"
@@ -41,7 +43,7 @@ namespace verilog {
 namespace analysis {
 
 using verible::down_cast;
-using verible::matcher::Matcher;
+using verible::matcher::CompiledMatcher;
 
 // Register the linter rule
 VERILOG_REGISTER_LINT_RULE(ModuleParameterRule);
@@ -75,8 +77,8 @@ const LintRuleDescriptor& ModulePortRule::GetDescriptor() {
 // For example:
 //   foo bar (port1, port2);
 // Here, the node representing "port1, port2" will be bound to "list"
-static const Matcher& InstanceMatcher() {
-  static const Matcher matcher(
+static const CompiledMatcher& InstanceMatcher() {
+  static const CompiledMatcher matcher(
       NodekGateInstance(GateInstanceHasPortList().Bind("list")));
   return matcher;
 }
@@ -85,8 +87,8 @@ static const Matcher& InstanceMatcher() {
 // For examples:
 //   foo #(1, 2) bar;
 // Here, the node representing "1, 2" will be bound to "list".
-static const Matcher& ParamsMatcher() {
-  static const Matcher matcher(NodekActualParameterList(
+static const CompiledMatcher& ParamsMatcher() {
+  static const CompiledMatcher matcher(NodekActualParameterList(
       ActualParameterListHasPositionalParameterList().Bind("list")));
   return matcher;
 }
@@ -112,6 +114,10 @@ static bool IsAnyPort(const verible::Symbol* symbol) {
 // ModuleParameterRule Implementation
 //
 
+std::vector<verible::SymbolTag> ModuleParameterRule::HandledTags() const {
+  return {verible::NodeTag(NodeEnum::kActualParameterList)};
+}
+
 void ModuleParameterRule::HandleSymbol(
     const verible::Symbol& symbol, const verible::SyntaxTreeContext& context) {
   static constexpr absl::string_view kMessage =
@@ -150,6 +156,10 @@ verible::LintRuleStatus ModuleParameterRule::Report() const {
 // ModulePortRule Implementation
 //
 
+std::vector<verible::SymbolTag> ModulePortRule::HandledTags() const {
+  return {verible::NodeTag(NodeEnum::kGateInstance)};
+}
+
 void ModulePortRule::HandleSymbol(const verible::Symbol& symbol,
                                   const verible::SyntaxTreeContext& context) {
   static constexpr absl::string_view kMessage =
@@ -20,6 +20,7 @@
 
 #include "absl/strings/str_cat.h"
 #include "absl/strings/string_view.h"
+#include "common/analysis/line_lint_rule.h"
 #include "common/analysis/lint_rule_status.h"
 #include "common/text/token_info.h"
 #include "verilog/analysis/descriptions.h"
@@ -50,11 +51,15 @@ const LintRuleDescriptor& NoTabsRule::GetDescriptor() {
 }
 
 void NoTabsRule::HandleLine(absl::string_view line) {
-  // Finds first tab in each line, if there is one.
+  HandleScannedLine(line, verible::LineScan(line));
+}
+
+void NoTabsRule::HandleScannedLine(absl::string_view line,
+                                   const verible::LineScan& scan) {
+  // The scan finds the first tab in each line, if there is one.
   // This reports only the first violation on each line.
-  const auto tab_pos = line.find('\t');
-  if (tab_pos != absl::string_view::npos) {
-    TokenInfo token(TK_SPACE, line.substr(tab_pos, 1));
+  if (scan.first_tab != absl::string_view::npos) {
+    TokenInfo token(TK_SPACE, line.substr(scan.first_tab, 1));
     violations_.insert(LintViolation(token, kMessage));
   }
 }
@@ -16,7 +16,6 @@
 #define VERIBLE_VERILOG_ANALYSIS_CHECKERS_NO_TABS_RULE_H_
 
 #include <cstddef>
-#include <set>
 #include <string>
 
 #include "absl/strings/string_view.h"
@@ -37,12 +36,14 @@ class NoTabsRule : public verible::LineLintRule {
   NoTabsRule() = default;
 
   void HandleLine(absl::string_view line) final;
+  void HandleScannedLine(absl::string_view line,
+                         const verible::LineScan& scan) final;
 
   verible::LintRuleStatus Report() const final;
 
  private:
   // Collection of found violations.
-  std::set<verible::LintViolation> violations_;
+  verible::LintViolationList violations_;
 };
 
 }  // namespace analysis
@@ -15,7 +15,6 @@
 #ifndef VERIBLE_VERILOG_ANALYSIS_CHECKERS_NUMERIC_FORMAT_STRING_STYLE_RULE_H
 #define VERIBLE_VERILOG_ANALYSIS_CHECKERS_NUMERIC_FORMAT_STRING_STYLE_RULE_H
 
-#include <set>
 #include <string>
 
 #include "common/analysis/lint_rule_status.h"
@@ -45,7 +44,7 @@ class NumericFormatStringStyleRule : public verible::TokenStreamLintRule {
                                size_t length,
                                std::initializer_list<unsigned char> prefixes);
 
-  std::set<verible::LintViolation> violations_;
+  verible::LintViolationList violations_;
 };
 
 }  // namespace analysis
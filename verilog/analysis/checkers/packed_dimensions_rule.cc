@@ -17,11 +17,13 @@
 #include <algorithm>  // for std::distance
 #include <set>
 #include <string>
+#include <vector>
 
 #include "absl/strings/str_cat.h"
 #include "absl/strings/string_view.h"
 #include "common/analysis/lint_rule_status.h"
 #include "common/analysis/matcher/bound_symbol_manager.h"
+#include "common/analysis/matcher/compiled_matcher.h"
 #include "common/analysis/matcher/matcher.h"
 #include "common/text/symbol.h"
 #include "common/text/syntax_tree_context.h"
@@ -39,7 +41,7 @@ namespace analysis {
 
 using verible::LintRuleStatus;
 using verible::LintViolation;
-using verible::matcher::Matcher;
+using verible::matcher::CompiledMatcher;
 
 VERILOG_REGISTER_LINT_RULE(PackedDimensionsRule);
 
@@ -58,11 +60,15 @@ const LintRuleDescriptor& PackedDimensionsRule::GetDescriptor() {
   return d;
 }
 
-static const Matcher& DimensionRangeMatcher() {
-  static const Matcher matcher(NodekDimensionRange());
+static const CompiledMatcher& DimensionRangeMatcher() {
+  static const CompiledMatcher matcher(NodekDimensionRange());
   return matcher;
 }
 
+std::vector<verible::SymbolTag> PackedDimensionsRule::HandledTags() const {
+  return {verible::NodeTag(NodeEnum::kDimensionRange)};
+}
+
 void PackedDimensionsRule::HandleSymbol(
     const verible::Symbol& symbol, const verible::SyntaxTreeContext& context) {
   if (!ContextIsInsidePackedDimensions(context)) return;
@@ -16,11 +16,13 @@
 
 #include <set>
 #include <string>
+#include <vector>
 
 #include "absl/strings/str_cat.h"
 #include "absl/strings/string_view.h"
 #include "common/analysis/lint_rule_status.h"
 #include "common/analysis/matcher/bound_symbol_manager.h"
+#include "common/analysis/matcher/compiled_matcher.h"
 #include "common/analysis/matcher/matcher.h"
 #include "common/strings/naming_utils.h"
 #include "common/text/config_utils.h"
@@ -39,7 +41,7 @@ namespace analysis {
 using verible::LintRuleStatus;
 using verible::LintViolation;
 using verible::SyntaxTreeContext;
-using Matcher = verible::matcher::Matcher;
+using verible::matcher::CompiledMatcher;
 
 // Register ParameterNameStyleRule.
 VERILOG_REGISTER_LINT_RULE(ParameterNameStyleRule);
@@ -60,8 +62,8 @@ const LintRuleDescriptor& ParameterNameStyleRule::GetDescriptor() {
   return d;
 }
 
-static const Matcher& ParamDeclMatcher() {
-  static const Matcher matcher(NodekParamDeclaration());
+static const CompiledMatcher& ParamDeclMatcher() {
+  static const CompiledMatcher matcher(NodekParamDeclaration());
   return matcher;
 }
 
@@ -82,6 +84,10 @@ std::string ParameterNameStyleRule::ViolationMsg(absl::string_view symbol_type,
                       bit_list);
 }
 
+std::vector<verible::SymbolTag> ParameterNameStyleRule::HandledTags() const {
+  return {verible::NodeTag(NodeEnum::kParamDeclaration)};
+}
+
 void ParameterNameStyleRule::HandleSymbol(const verible::Symbol& symbol,
                                           const SyntaxTreeContext& context) {
   verible::matcher::BoundSymbolManager manager;
@@ -93,12 +99,12 @@ void ParameterNameStyleRule::HandleSymbol(const verible::Symbol& symbol,
     auto identifiers = GetAllParameterNameTokens(symbol);
 
     for (const auto* id : identifiers) {
-      const auto param_name = id->text();
+      const uint32_t conventions = verible::NamingConventions(id->text());
       uint32_t observed_style = 0;
-      if (verible::IsUpperCamelCaseWithDigits(param_name)) {
+      if (conventions & verible::kUpperCamelCaseWithDigits) {
         observed_style |= kUpperCamelCase;
       }
-      if (verible::IsNameAllCapsUnderscoresDigits(param_name)) {
+      if (conventions & verible::kNameAllCapsUnderscoresDigits) {
         observed_style |= kAllCaps;
       }
       if (param_decl_token == TK_localparam && localparam_allowed_style_ &&
@@ -16,12 +16,14 @@
 
 #include <set>
 #include <string>
+#include <vector>
 
 #include "absl/strings/match.h"
 #include "absl/strings/str_cat.h"
 #include "absl/strings/string_view.h"
 #include "common/analysis/lint_rule_status.h"
 #include "common/analysis/matcher/bound_symbol_manager.h"
+#include "common/analysis/matcher/compiled_matcher.h"
 #include "common/analysis/matcher/matcher.h"
 #include "common/strings/naming_utils.h"
 #include "common/text/symbol.h"
@@ -39,7 +41,7 @@ namespace analysis {
 using verible::LintRuleStatus;
 using verible::LintViolation;
 using verible::SyntaxTreeContext;
-using verible::matcher::Matcher;
+using verible::matcher::CompiledMatcher;
 
 // Register ParameterTypeNameStyleRule.
 VERILOG_REGISTER_LINT_RULE(ParameterTypeNameStyleRule);
@@ -59,11 +61,16 @@ const LintRuleDescriptor& ParameterTypeNameStyleRule::GetDescriptor() {
   return d;
 }
 
-static const Matcher& ParamDeclMatcher() {
-  static const Matcher matcher(NodekParamDeclaration());
+static const CompiledMatcher& ParamDeclMatcher() {
+  static const CompiledMatcher matcher(NodekParamDeclaration());
   return matcher;
 }
 
+std::vector<verible::SymbolTag>
+ParameterTypeNameStyleRule::HandledTags() const {
+  return {verible::NodeTag(NodeEnum::kParamDeclaration)};
+}
+
 void ParameterTypeNameStyleRule::HandleSymbol(
     const verible::Symbol& symbol, const SyntaxTreeContext& context) {
   verible::matcher::BoundSymbolManager manager;
@@ -16,11 +16,13 @@
 
 #include <set>
 #include <string>
+#include <vector>
 
 #include "absl/strings/str_cat.h"
 #include "absl/strings/string_view.h"
 #include "common/analysis/lint_rule_status.h"
 #include "common/analysis/matcher/bound_symbol_manager.h"
+#include "common/analysis/matcher/compiled_matcher.h"
 #include "common/analysis/matcher/matcher.h"
 #include "common/text/concrete_syntax_leaf.h"
 #include "common/text/symbol.h"
@@ -33,7 +35,7 @@
 namespace verilog {
 namespace analysis {
 
-using verible::matcher::Matcher;
+using verible::matcher::CompiledMatcher;
 
 VERILOG_REGISTER_LINT_RULE(PlusargAssignmentRule);
 
@@ -52,11 +54,15 @@ const LintRuleDescriptor& PlusargAssignmentRule::GetDescriptor() {
   return d;
 }
 
-static const Matcher& IdMatcher() {
-  static const Matcher matcher(SystemTFIdentifierLeaf().Bind("name"));
+static const CompiledMatcher& IdMatcher() {
+  static const CompiledMatcher matcher(SystemTFIdentifierLeaf().Bind("name"));
   return matcher;
 }
 
+std::vector<verible::SymbolTag> PlusargAssignmentRule::HandledTags() const {
+  return {verible::LeafTag(SystemTFIdentifier)};
+}
+
 void PlusargAssignmentRule::HandleSymbol(
     const verible::Symbol& symbol, const verible::SyntaxTreeContext& context) {
   verible::matcher::BoundSymbolManager manager;
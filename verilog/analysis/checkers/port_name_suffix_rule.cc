@@ -16,6 +16,7 @@
 
 #include <set>
 #include <string>
+#include <vector>
 
 #include "absl/strings/match.h"
 #include "absl/strings/str_cat.h"
@@ -23,6 +24,7 @@
 #include "absl/strings/string_view.h"
 #include "common/analysis/lint_rule_status.h"
 #include "common/analysis/matcher/bound_symbol_manager.h"
+#include "common/analysis/matcher/compiled_matcher.h"
 #include "common/analysis/matcher/matcher.h"
 #include "common/strings/naming_utils.h"
 #include "common/text/symbol.h"
@@ -43,7 +45,7 @@ using verible::LintViolation;
 using verible::Symbol;
 using verible::SyntaxTreeContext;
 using verible::TokenInfo;
-using verible::matcher::Matcher;
+using verible::matcher::CompiledMatcher;
 
 // Register PortNameSuffixRule.
 VERILOG_REGISTER_LINT_RULE(PortNameSuffixRule);
@@ -68,8 +70,8 @@ const LintRuleDescriptor& PortNameSuffixRule::GetDescriptor() {
   return d;
 }
 
-static const Matcher& PortMatcher() {
-  static const Matcher matcher(NodekPortDeclaration());
+static const CompiledMatcher& PortMatcher() {
+  static const CompiledMatcher matcher(NodekPortDeclaration());
   return matcher;
 }
 
@@ -98,6 +100,10 @@ bool PortNameSuffixRule::IsSuffixCorrect(absl::string_view suffix,
   return suffixes.at(direction).count(suffix) == 1;
 }
 
+std::vector<verible::SymbolTag> PortNameSuffixRule::HandledTags() const {
+  return {verible::NodeTag(NodeEnum::kPortDeclaration)};
+}
+
 void PortNameSuffixRule::HandleSymbol(const Symbol& symbol,
                                       const SyntaxTreeContext& context) {
   constexpr absl::string_view implicit_direction = "input";
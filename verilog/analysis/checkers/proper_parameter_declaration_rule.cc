@@ -16,10 +16,12 @@
 
 #include <set>
 #include <string>
+#include <vector>
 
 #include "absl/strings/str_cat.h"
 #include "common/analysis/lint_rule_status.h"
 #include "common/analysis/matcher/bound_symbol_manager.h"
+#include "common/analysis/matcher/compiled_matcher.h"
 #include "common/analysis/matcher/matcher.h"
 #include "common/text/symbol.h"
 #include "common/text/syntax_tree_context.h"
@@ -36,7 +38,7 @@ namespace analysis {
 using verible::LintRuleStatus;
 using verible::LintViolation;
 using verible::SyntaxTreeContext;
-using verible::matcher::Matcher;
+using verible::matcher::CompiledMatcher;
 
 // Register ProperParameterDeclarationRule
 VERILOG_REGISTER_LINT_RULE(ProperParameterDeclarationRule);
@@ -60,12 +62,17 @@ const LintRuleDescriptor& ProperParameterDeclarationRule::GetDescriptor() {
   return d;
 }
 
-static const Matcher& ParamDeclMatcher() {
-  static const Matcher matcher(NodekParamDeclaration());
+static const CompiledMatcher& ParamDeclMatcher() {
+  static const CompiledMatcher matcher(NodekParamDeclaration());
   return matcher;
 }
 
 // TODO(kathuriac): Also check the 'interface' and 'program' constructs.
+std::vector<verible::SymbolTag>
+ProperParameterDeclarationRule::HandledTags() const {
+  return {verible::NodeTag(NodeEnum::kParamDeclaration)};
+}
+
 void ProperParameterDeclarationRule::HandleSymbol(
     const verible::Symbol& symbol, const SyntaxTreeContext& context) {
   verible::matcher::BoundSymbolManager manager;
@@ -16,11 +16,10 @@
 
 #include <set>
 #include <string>
+#include <vector>
 
 #include "absl/strings/str_cat.h"
 #include "common/analysis/lint_rule_status.h"
-#include "common/analysis/matcher/bound_symbol_manager.h"
-#include "common/analysis/matcher/matcher.h"
 #include "common/strings/naming_utils.h"
 #include "common/text/concrete_syntax_leaf.h"
 #include "common/text/symbol.h"
@@ -31,7 +30,7 @@
 #include "verilog/CST/identifier.h"
 #include "verilog/CST/net.h"
 #include "verilog/CST/port.h"
-#include "verilog/CST/verilog_matchers.h"
+#include "verilog/CST/verilog_nonterminals.h"
 #include "verilog/analysis/descriptions.h"
 #include "verilog/analysis/lint_rule_registry.h"
 
@@ -43,7 +42,6 @@ VERILOG_REGISTER_LINT_RULE(SignalNameStyleRule);
 using verible::LintRuleStatus;
 using verible::LintViolation;
 using verible::SyntaxTreeContext;
-using verible::matcher::Matcher;
 
 static constexpr absl::string_view kMessage =
     "Signal names must use lower_snake_case naming convention.";
@@ -60,47 +58,49 @@ const LintRuleDescriptor& SignalNameStyleRule::GetDescriptor() {
   return d;
 }
 
-static const Matcher& PortMatcher() {
-  static const Matcher matcher(NodekPortDeclaration());
-  return matcher;
-}
-
-static const Matcher& NetMatcher() {
-  static const Matcher matcher(NodekNetDeclaration());
-  return matcher;
-}
-
-static const Matcher& DataMatcher() {
-  static const Matcher matcher(NodekDataDeclaration());
-  return matcher;
+std::vector<verible::SymbolTag> SignalNameStyleRule::HandledTags() const {
+  return {verible::NodeTag(NodeEnum::kPortDeclaration),
+          verible::NodeTag(NodeEnum::kNetDeclaration),
+          verible::NodeTag(NodeEnum::kDataDeclaration)};
 }
 
 void SignalNameStyleRule::HandleSymbol(const verible::Symbol& symbol,
                                        const SyntaxTreeContext& context) {
-  verible::matcher::BoundSymbolManager manager;
-  if (PortMatcher().Matches(symbol, &manager)) {
-    const auto* identifier_leaf = GetIdentifierFromPortDeclaration(symbol);
-    const auto name = ABSL_DIE_IF_NULL(identifier_leaf)->get().text();
-    if (!verible::IsLowerSnakeCaseWithDigits(name)) {
-      violations_.insert(
-          LintViolation(identifier_leaf->get(), kMessage, context));
-    }
-  } else if (NetMatcher().Matches(symbol, &manager)) {
-    const auto identifier_leaves = GetIdentifiersFromNetDeclaration(symbol);
-    for (const auto* leaf : identifier_leaves) {
-      const auto name = leaf->text();
+  // Only the handled tags are dispatched here, so the tag tells the kind of
+  // declaration without matching it again.
+  if (symbol.Kind() != verible::SymbolKind::kNode) return;
+  switch (static_cast<NodeEnum>(symbol.Tag().tag)) {
+    case NodeEnum::kPortDeclaration: {
+      const auto* identifier_leaf = GetIdentifierFromPortDeclaration(symbol);
+      const auto name = ABSL_DIE_IF_NULL(identifier_leaf)->get().text();
       if (!verible::IsLowerSnakeCaseWithDigits(name)) {
-        violations_.insert(LintViolation(*leaf, kMessage, context));
+        violations_.insert(
+            LintViolation(identifier_leaf->get(), kMessage, context));
       }
+      break;
     }
-  } else if (DataMatcher().Matches(symbol, &manager)) {
-    const auto identifier_leaves = GetIdentifiersFromDataDeclaration(symbol);
-    for (const auto* leaf : identifier_leaves) {
-      const auto name = leaf->text();
-      if (!verible::IsLowerSnakeCaseWithDigits(name)) {
-        violations_.insert(LintViolation(*leaf, kMessage, context));
+    case NodeEnum::kNetDeclaration: {
+      const auto identifier_leaves = GetIdentifiersFromNetDeclaration(symbol);
+      for (const auto* leaf : identifier_leaves) {
+        const auto name = leaf->text();
+        if (!verible::IsLowerSnakeCaseWithDigits(name)) {
+          violations_.insert(LintViolation(*leaf, kMessage, context));
+        }
+      }
+      break;
+    }
+    case NodeEnum::kDataDeclaration: {
+      const auto identifier_leaves = GetIdentifiersFromDataDeclaration(symbol);
+      for (const auto* leaf : identifier_leaves) {
+        const auto name = leaf->text();
+        if (!verible::IsLowerSnakeCaseWithDigits(name)) {
+          violations_.insert(LintViolation(*leaf, kMessage, context));
+        }
       }
+      break;
     }
+    default:
+      break;
   }
 }
 
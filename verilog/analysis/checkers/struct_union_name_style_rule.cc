@@ -17,12 +17,14 @@
 #include <algorithm>
 #include <set>
 #include <string>
+#include <vector>
 
 #include "absl/strings/match.h"
 #include "absl/strings/str_cat.h"
 #include "absl/strings/str_split.h"
 #include "common/analysis/lint_rule_status.h"
 #include "common/analysis/matcher/bound_symbol_manager.h"
+#include "common/analysis/matcher/compiled_matcher.h"
 #include "common/analysis/matcher/matcher.h"
 #include "common/strings/naming_utils.h"
 #include "common/text/config_utils.h"
@@ -40,7 +42,7 @@ VERILOG_REGISTER_LINT_RULE(StructUnionNameStyleRule);
 using verible::LintRuleStatus;
 using verible::LintViolation;
 using verible::SyntaxTreeContext;
-using verible::matcher::Matcher;
+using verible::matcher::CompiledMatcher;
 
 static constexpr absl::string_view kMessageStruct = "Struct names";
 static constexpr absl::string_view kMessageUnion = "Union names";
@@ -59,11 +61,15 @@ const LintRuleDescriptor& StructUnionNameStyleRule::GetDescriptor() {
   return d;
 }
 
-static const Matcher& TypedefMatcher() {
-  static const Matcher matcher(NodekTypeDeclaration());
+static const CompiledMatcher& TypedefMatcher() {
+  static const CompiledMatcher matcher(NodekTypeDeclaration());
   return matcher;
 }
 
+std::vector<verible::SymbolTag> StructUnionNameStyleRule::HandledTags() const {
+  return {verible::NodeTag(NodeEnum::kTypeDeclaration)};
+}
+
 void StructUnionNameStyleRule::HandleSymbol(const verible::Symbol& symbol,
                                             const SyntaxTreeContext& context) {
   verible::matcher::BoundSymbolManager manager;
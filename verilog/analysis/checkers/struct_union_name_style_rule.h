@@ -17,6 +17,7 @@
 
 #include <set>
 #include <string>
+#include <vector>
 
 #include "absl/strings/string_view.h"
 #include "common/analysis/lint_rule_status.h"
@@ -39,6 +40,8 @@ class StructUnionNameStyleRule : public verible::SyntaxTreeLintRule {
   void HandleSymbol(const verible::Symbol& symbol,
                     const verible::SyntaxTreeContext& context) final;
 
+  std::vector<verible::SymbolTag> HandledTags() const final;
+
   absl::Status Configure(absl::string_view configuration) final;
 
   verible::LintRuleStatus Report() const final;
@@ -46,7 +49,7 @@ class StructUnionNameStyleRule : public verible::SyntaxTreeLintRule {
  private:
   std::set<std::string> exceptions_;
 
-  std::set<verible::LintViolation> violations_;
+  verible::LintViolationList violations_;
 };
 
 }  // namespace analysis
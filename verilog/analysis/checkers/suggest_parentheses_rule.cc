@@ -14,6 +14,8 @@
 
 #include "verilog/analysis/checkers/suggest_parentheses_rule.h"
 
+#include <vector>
+
 #include "absl/strings/str_cat.h"
 #include "verilog/CST/expression.h"
 #include "verilog/CST/verilog_matchers.h"
@@ -43,6 +45,10 @@ const LintRuleDescriptor& SuggestParenthesesRule::GetDescriptor() {
   return d;
 }
 
+std::vector<verible::SymbolTag> SuggestParenthesesRule::HandledTags() const {
+  return {verible::NodeTag(NodeEnum::kConditionExpression)};
+}
+
 void SuggestParenthesesRule::HandleNode(
     const verible::SyntaxTreeNode& node,
     const verible::SyntaxTreeContext& context) {
@@ -15,6 +15,8 @@
 #ifndef VERIBLE_VERILOG_ANALYSIS_CHECKERS_SUGGEST_PARENTHESES_RULE_H_
 #define VERIBLE_VERILOG_ANALYSIS_CHECKERS_SUGGEST_PARENTHESES_RULE_H_
 
+#include <vector>
+
 #include "common/analysis/syntax_tree_lint_rule.h"
 #include "verilog/analysis/descriptions.h"
 
@@ -35,10 +37,12 @@ class SuggestParenthesesRule : public verible::SyntaxTreeLintRule {
   void HandleNode(const verible::SyntaxTreeNode& node,
                   const verible::SyntaxTreeContext& context) final;
 
+  std::vector<verible::SymbolTag> HandledTags() const final;
+
   verible::LintRuleStatus Report() const final;
 
  private:
-  std::set<verible::LintViolation> violations_;
+  verible::LintViolationList violations_;
 };
 
 }  // namespace analysis
@@ -23,6 +23,7 @@
 #include "absl/strings/string_view.h"
 #include "common/analysis/lint_rule_status.h"
 #include "common/analysis/matcher/bound_symbol_manager.h"
+#include "common/analysis/matcher/compiled_matcher.h"
 #include "common/analysis/matcher/matcher.h"
 #include "common/text/symbol.h"
 #include "common/text/syntax_tree_context.h"
@@ -36,7 +37,7 @@ namespace analysis {
 using verible::LintRuleStatus;
 using verible::LintViolation;
 using verible::SyntaxTreeContext;
-using verible::matcher::Matcher;
+using verible::matcher::CompiledMatcher;
 
 // Register TokenStreamLintRule
 VERILOG_REGISTER_LINT_RULE(TokenStreamLintRule);
@@ -57,8 +58,8 @@ const LintRuleDescriptor& TokenStreamLintRule::GetDescriptor() {
   return d;
 }
 
-static const Matcher& StringLiteralMatcher() {
-  static const Matcher matcher(StringLiteralKeyword());
+static const CompiledMatcher& StringLiteralMatcher() {
+  static const CompiledMatcher matcher(StringLiteralKeyword());
   return matcher;
 }
 
@@ -18,6 +18,7 @@
 #include <cstddef>
 #include <set>
 #include <string>
+#include <vector>
 
 #include "absl/numeric/int128.h"
 #include "absl/strings/numbers.h"
@@ -25,6 +26,7 @@
 #include "absl/strings/string_view.h"
 #include "common/analysis/lint_rule_status.h"
 #include "common/analysis/matcher/bound_symbol_manager.h"
+#include "common/analysis/matcher/compiled_matcher.h"
 #include "common/analysis/matcher/matcher.h"
 #include "common/text/concrete_syntax_leaf.h"
 #include "common/text/config_utils.h"
@@ -46,7 +48,7 @@ using verible::LintViolation;
 using verible::SyntaxTreeContext;
 using verible::SyntaxTreeLeaf;
 using verible::SyntaxTreeNode;
-using verible::matcher::Matcher;
+using verible::matcher::CompiledMatcher;
 
 VERILOG_REGISTER_LINT_RULE(TruncatedNumericLiteralRule);
 
@@ -61,8 +63,8 @@ const LintRuleDescriptor& TruncatedNumericLiteralRule::GetDescriptor() {
   return d;
 }
 
-static const Matcher& NumberMatcher() {
-  static const Matcher matcher(
+static const CompiledMatcher& NumberMatcher() {
+  static const CompiledMatcher matcher(
       NodekNumber(NumberHasConstantWidth().Bind("width"),
                   NumberHasBasedLiteral().Bind("literal")));
   return matcher;
@@ -145,6 +147,11 @@ static size_t GetBitWidthOfNumber(const BasedNumber& n, bool* is_lower_bound) {
   return 0;  // not reached.
 }
 
+std::vector<verible::SymbolTag>
+TruncatedNumericLiteralRule::HandledTags() const {
+  return {verible::NodeTag(NodeEnum::kNumber)};
+}
+
 void TruncatedNumericLiteralRule::HandleSymbol(
     const verible::Symbol& symbol, const SyntaxTreeContext& context) {
   verible::matcher::BoundSymbolManager manager;
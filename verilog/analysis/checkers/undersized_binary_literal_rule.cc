@@ -18,12 +18,14 @@
 #include <cstddef>
 #include <set>
 #include <string>
+#include <vector>
 
 #include "absl/strings/numbers.h"
 #include "absl/strings/str_cat.h"
 #include "absl/strings/string_view.h"
 #include "common/analysis/lint_rule_status.h"
 #include "common/analysis/matcher/bound_symbol_manager.h"
+#include "common/analysis/matcher/compiled_matcher.h"
 #include "common/analysis/matcher/matcher.h"
 #include "common/text/concrete_syntax_leaf.h"
 #include "common/text/config_utils.h"
@@ -46,7 +48,7 @@ using verible::LintViolation;
 using verible::SyntaxTreeContext;
 using verible::SyntaxTreeLeaf;
 using verible::SyntaxTreeNode;
-using verible::matcher::Matcher;
+using verible::matcher::CompiledMatcher;
 
 // Register UndersizedBinaryLiteralRule
 VERILOG_REGISTER_LINT_RULE(UndersizedBinaryLiteralRule);
@@ -76,13 +78,18 @@ const LintRuleDescriptor& UndersizedBinaryLiteralRule::GetDescriptor() {
 // Broadly, start by matching all number nodes with a
 // constant width and based literal.
 
-static const Matcher& NumberMatcher() {
-  static const Matcher matcher(
+static const CompiledMatcher& NumberMatcher() {
+  static const CompiledMatcher matcher(
       NodekNumber(NumberHasConstantWidth().Bind("width"),
                   NumberHasBasedLiteral().Bind("literal")));
   return matcher;
 }
 
+std::vector<verible::SymbolTag>
+UndersizedBinaryLiteralRule::HandledTags() const {
+  return {verible::NodeTag(NodeEnum::kNumber)};
+}
+
 void UndersizedBinaryLiteralRule::HandleSymbol(
     const verible::Symbol& symbol, const SyntaxTreeContext& context) {
   verible::matcher::BoundSymbolManager manager;
@@ -16,11 +16,13 @@
 
 #include <set>
 #include <string>
+#include <vector>
 
 #include "absl/strings/str_cat.h"
 #include "absl/strings/string_view.h"
 #include "common/analysis/lint_rule_status.h"
 #include "common/analysis/matcher/bound_symbol_manager.h"
+#include "common/analysis/matcher/compiled_matcher.h"
 #include "common/analysis/matcher/matcher.h"
 #include "common/text/symbol.h"
 #include "common/text/syntax_tree_context.h"
@@ -37,7 +39,7 @@ namespace analysis {
 
 using verible::LintRuleStatus;
 using verible::LintViolation;
-using verible::matcher::Matcher;
+using verible::matcher::CompiledMatcher;
 
 VERILOG_REGISTER_LINT_RULE(UnpackedDimensionsRule);
 
@@ -64,11 +66,15 @@ const LintRuleDescriptor& UnpackedDimensionsRule::GetDescriptor() {
   return d;
 }
 
-static const Matcher& DimensionRangeMatcher() {
-  static const Matcher matcher(NodekDimensionRange());
+static const CompiledMatcher& DimensionRangeMatcher() {
+  static const CompiledMatcher matcher(NodekDimensionRange());
   return matcher;
 }
 
+std::vector<verible::SymbolTag> UnpackedDimensionsRule::HandledTags() const {
+  return {verible::NodeTag(NodeEnum::kDimensionRange)};
+}
+
 void UnpackedDimensionsRule::HandleSymbol(
     const verible::Symbol& symbol, const verible::SyntaxTreeContext& context) {
   if (!ContextIsInsideUnpackedDimensions(context) ||
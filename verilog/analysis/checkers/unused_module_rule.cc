@@ -0,0 +1,133 @@
+// Copyright 2017-2023 The Verible Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "verilog/analysis/checkers/unused_module_rule.h"
+
+#include <mutex>  // NOLINT
+#include <set>
+#include <string>
+#include <vector>
+
+#include "absl/status/status.h"
+#include "absl/strings/str_cat.h"
+#include "absl/strings/str_split.h"
+#include "absl/strings/string_view.h"
+#include "common/analysis/lint_rule_status.h"
+#include "common/text/config_utils.h"
+#include "common/text/token_info.h"
+#include "common/util/tree_operations.h"
+#include "verilog/analysis/descriptions.h"
+#include "verilog/analysis/lint_rule_registry.h"
+#include "verilog/analysis/symbol_table.h"
+#include "verilog/parser/verilog_token_enum.h"
+
+namespace verilog {
+namespace analysis {
+
+using verible::LintRuleStatus;
+using verible::LintViolation;
+using verible::TokenInfo;
+
+// Register the lint rule
+VERILOG_REGISTER_LINT_RULE(UnusedModuleRule);
+
+const LintRuleDescriptor& UnusedModuleRule::GetDescriptor() {
+  static const LintRuleDescriptor d{
+      .name = "unused-module",
+      .topic = "module-instantiation",
+      .desc =
+          "Checks that every module defined in the linted files is "
+          "referenced in one of them, e.g. instantiated, except for the "
+          "configured top modules. Only checked when the files are linted "
+          "together as a project.",
+      .param = {{"top-modules", "",
+                 "Comma-separated names of modules that need not be "
+                 "referenced"}},
+  };
+  return d;
+}
+
+static bool IsRootLevel(const SymbolTableNode* symbol) {
+  return symbol != nullptr && symbol->Parent() != nullptr &&
+         symbol->Parent()->Parent() == nullptr;
+}
+
+// Returns the root-level symbols that references in the scopes of 'symbols'
+// resolve to.
+static std::set<const SymbolTableNode*> ReferencedRootSymbols(
+    const std::vector<const SymbolTableNode*>& symbols) {
+  std::set<const SymbolTableNode*> referenced;
+  for (const SymbolTableNode* symbol : symbols) {
+    symbol->ApplyPreOrder([&referenced](const SymbolTableNode& node) {
+      for (const DependentReferences& ref :
+           node.Value().local_references_to_bind) {
+        if (ref.components == nullptr) continue;
+        ApplyPreOrder(*ref.components,
+                      [&referenced](const ReferenceComponent& component) {
+                        if (IsRootLevel(component.resolved_symbol)) {
+                          referenced.insert(component.resolved_symbol);
+                        }
+                      });
+      }
+    });
+  }
+  return referenced;
+}
+
+void UnusedModuleRule::Lint(const ProjectLintContext& context,
+                            const VerilogSourceFile& file) {
+  const auto found = context.root_symbols_by_file.find(&file);
+  if (found == context.root_symbols_by_file.end()) return;
+  const std::vector<const SymbolTableNode*>& symbols = found->second;
+
+  // Modules can be referenced from the same file, or from others.
+  const std::set<const SymbolTableNode*> referenced =
+      ReferencedRootSymbols(symbols);
+  const auto& index = context.dependencies.root_symbols_index;
+  for (const SymbolTableNode* symbol : symbols) {
+    if (symbol->Value().metatype != SymbolMetaType::kModule) continue;
+    const absl::string_view name = *symbol->Key();
+    if (top_modules_.find(name) != top_modules_.end()) continue;
+    if (referenced.find(symbol) != referenced.end()) continue;
+    const auto references = index.find(name);
+    if (references != index.end() && !references->second.referencers.empty()) {
+      continue;
+    }
+    const std::lock_guard<std::mutex> l(lock_);
+    violations_.insert(LintViolation(
+        TokenInfo(SymbolIdentifier, name),
+        absl::StrCat("Module \"", name,
+                     "\" is not referenced in any of the linted files.")));
+  }
+}
+
+LintRuleStatus UnusedModuleRule::Report() const {
+  return LintRuleStatus(violations_, GetDescriptor());
+}
+
+absl::Status UnusedModuleRule::Configure(absl::string_view configuration) {
+  using verible::config::SetString;
+  std::string top_modules;
+  auto status = verible::ParseNameValues(
+      configuration, {{"top-modules", SetString(&top_modules)}});
+  if (!status.ok()) return status;
+  for (absl::string_view name :
+       absl::StrSplit(top_modules, ',', absl::SkipEmpty())) {
+    top_modules_.emplace(name);
+  }
+  return absl::OkStatus();
+}
+
+}  // namespace analysis
+}  // namespace verilog
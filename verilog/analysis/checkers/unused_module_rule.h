@@ -0,0 +1,61 @@
+// Copyright 2017-2023 The Verible Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef VERIBLE_VERILOG_ANALYSIS_CHECKERS_UNUSED_MODULE_RULE_H_
+#define VERIBLE_VERILOG_ANALYSIS_CHECKERS_UNUSED_MODULE_RULE_H_
+
+#include <mutex>  // NOLINT
+#include <set>
+#include <string>
+
+#include "absl/status/status.h"
+#include "absl/strings/string_view.h"
+#include "common/analysis/lint_rule_status.h"
+#include "verilog/analysis/descriptions.h"
+#include "verilog/analysis/project_lint_rule.h"
+#include "verilog/analysis/verilog_project.h"
+
+namespace verilog {
+namespace analysis {
+
+// UnusedModuleRule checks that every module that is defined in the linted
+// files is referenced in one of them, except for the top modules.
+class UnusedModuleRule : public ProjectLintRule {
+ public:
+  using rule_type = ProjectLintRule;
+
+  static const LintRuleDescriptor& GetDescriptor();
+
+  UnusedModuleRule() = default;
+
+  absl::Status Configure(absl::string_view configuration) final;
+  void Lint(const ProjectLintContext& context,
+            const VerilogSourceFile& file) final;
+
+  verible::LintRuleStatus Report() const final;
+
+ private:
+  // Names of modules that need not be referenced.
+  std::set<std::string, std::less<>> top_modules_;
+
+  std::mutex lock_;  // Guards violations_, for files linted concurrently.
+
+  // Collection of found violations.
+  verible::LintViolationList violations_;
+};
+
+}  // namespace analysis
+}  // namespace verilog
+
+#endif  // VERIBLE_VERILOG_ANALYSIS_CHECKERS_UNUSED_MODULE_RULE_H_
@@ -0,0 +1,116 @@
+// Copyright 2017-2023 The Verible Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "verilog/analysis/checkers/unused_module_rule.h"
+
+#include <map>
+#include <string>
+#include <vector>
+
+#include "absl/status/status.h"
+#include "absl/strings/string_view.h"
+#include "common/analysis/lint_rule_status.h"
+#include "common/util/file_util.h"
+#include "gtest/gtest.h"
+#include "verilog/analysis/dependencies.h"
+#include "verilog/analysis/project_lint_rule.h"
+#include "verilog/analysis/symbol_table.h"
+#include "verilog/analysis/verilog_project.h"
+
+namespace verilog {
+namespace analysis {
+namespace {
+
+using verible::file::Basename;
+using verible::file::CreateDir;
+using verible::file::JoinPath;
+using verible::file::testing::ScopedTestFile;
+
+// Lints the files with 'codes' as one project, and returns the names of the
+// modules reported.
+std::vector<std::string> LintUnusedModules(
+    absl::string_view test_name, const std::vector<absl::string_view>& codes,
+    absl::string_view configuration = "") {
+  const std::string sources_dir = JoinPath(::testing::TempDir(), test_name);
+  EXPECT_TRUE(CreateDir(sources_dir).ok());
+  VerilogProject project(sources_dir, {});
+  std::vector<ScopedTestFile> test_files;
+  test_files.reserve(codes.size());
+  std::vector<std::string> units;
+  for (const absl::string_view code : codes) {
+    test_files.emplace_back(sources_dir, code);
+    units.emplace_back(Basename(test_files.back().filename()));
+  }
+  std::vector<const VerilogSourceFile*> files;
+  for (const auto& file : project.OpenTranslationUnits(units)) {
+    EXPECT_TRUE(file.ok()) << file.status();
+    files.push_back(*file);
+  }
+
+  SymbolTable symbol_table(&project);
+  std::vector<absl::Status> diagnostics;
+  symbol_table.BuildTranslationUnits(units, 1, &diagnostics);
+  symbol_table.Resolve(&diagnostics);
+  const FileDependencies dependencies(symbol_table);
+  std::map<const VerilogSourceFile*, std::vector<const SymbolTableNode*>>
+      root_symbols_by_file;
+  for (const auto& [name, node] : symbol_table.Root().Children()) {
+    root_symbols_by_file[node.Value().file_origin].push_back(&node);
+  }
+  const ProjectLintContext context{project, symbol_table, dependencies,
+                                   root_symbols_by_file};
+
+  UnusedModuleRule rule;
+  EXPECT_TRUE(rule.Configure(configuration).ok());
+  for (const VerilogSourceFile* file : files) rule.Lint(context, *file);
+  std::vector<std::string> modules;
+  for (const verible::LintViolation& violation : rule.Report().violations) {
+    modules.emplace_back(violation.token.text());
+  }
+  return modules;
+}
+
+TEST(UnusedModuleRuleTest, NoModules) {
+  EXPECT_TRUE(LintUnusedModules(__FUNCTION__, {"", "package p;\nendpackage\n"})
+                  .empty());
+}
+
+TEST(UnusedModuleRuleTest, ReferencedFromOtherFile) {
+  EXPECT_EQ(LintUnusedModules(__FUNCTION__,
+                              {"module leaf;\nendmodule\n",
+                               "module top;\n  leaf u_leaf();\nendmodule\n"}),
+            std::vector<std::string>({"top"}));
+}
+
+TEST(UnusedModuleRuleTest, ReferencedFromSameFile) {
+  EXPECT_EQ(LintUnusedModules(__FUNCTION__, {"module leaf;\nendmodule\n"
+                                             "module top;\n"
+                                             "  leaf u_leaf();\n"
+                                             "endmodule\n"
+                                             "module unused;\nendmodule\n"}),
+            std::vector<std::string>({"top", "unused"}));
+}
+
+TEST(UnusedModuleRuleTest, TopModulesAreExempt) {
+  EXPECT_EQ(LintUnusedModules(__FUNCTION__,
+                              {"module leaf;\nendmodule\n",
+                               "module top;\n  leaf u_leaf();\nendmodule\n",
+                               "module tb;\nendmodule\n"},
+                              "top-modules:top,tb"),
+            std::vector<std::string>());
+}
+
+}  // namespace
+}  // namespace analysis
+}  // namespace verilog
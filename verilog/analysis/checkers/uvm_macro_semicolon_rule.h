@@ -66,7 +66,7 @@ class UvmMacroSemicolonRule : public verible::SyntaxTreeLintRule {
   // Save the matching macro and include it in diagnostic message
   verible::TokenInfo macro_id_ = verible::TokenInfo::EOFToken();
 
-  std::set<verible::LintViolation> violations_;
+  verible::LintViolationList violations_;
 };
 
 }  // namespace analysis
@@ -16,10 +16,12 @@
 
 #include <set>
 #include <string>
+#include <vector>
 
 #include "absl/strings/str_cat.h"
 #include "common/analysis/lint_rule_status.h"
 #include "common/analysis/matcher/bound_symbol_manager.h"
+#include "common/analysis/matcher/compiled_matcher.h"
 #include "common/analysis/matcher/matcher.h"
 #include "common/text/concrete_syntax_leaf.h"
 #include "common/text/concrete_syntax_tree.h"
@@ -34,7 +36,7 @@ namespace verilog {
 namespace analysis {
 
 using verible::LintViolation;
-using verible::matcher::Matcher;
+using verible::matcher::CompiledMatcher;
 
 // Register the lint rule
 VERILOG_REGISTER_LINT_RULE(V2001GenerateBeginRule);
@@ -53,12 +55,16 @@ const LintRuleDescriptor& V2001GenerateBeginRule::GetDescriptor() {
   return d;
 }
 
-static const Matcher& GenerateRegionMatcher() {
-  static const Matcher matcher(
+static const CompiledMatcher& GenerateRegionMatcher() {
+  static const CompiledMatcher matcher(
       NodekGenerateRegion(HasGenerateBlock().Bind("block")));
   return matcher;
 }
 
+std::vector<verible::SymbolTag> V2001GenerateBeginRule::HandledTags() const {
+  return {verible::NodeTag(NodeEnum::kGenerateRegion)};
+}
+
 void V2001GenerateBeginRule::HandleSymbol(
     const verible::Symbol& symbol, const verible::SyntaxTreeContext& context) {
   verible::matcher::BoundSymbolManager manager;
@@ -16,11 +16,13 @@
 
 #include <set>
 #include <string>
+#include <vector>
 
 #include "absl/strings/str_cat.h"
 #include "absl/strings/string_view.h"
 #include "common/analysis/lint_rule_status.h"
 #include "common/analysis/matcher/bound_symbol_manager.h"
+#include "common/analysis/matcher/compiled_matcher.h"
 #include "common/analysis/matcher/core_matchers.h"
 #include "common/analysis/matcher/matcher.h"
 #include "common/text/concrete_syntax_leaf.h"
@@ -41,7 +43,7 @@ using verible::LintViolation;
 using verible::SyntaxTreeContext;
 using verible::SyntaxTreeLeaf;
 using verible::SyntaxTreeNode;
-using verible::matcher::Matcher;
+using verible::matcher::CompiledMatcher;
 
 // Register VoidCastRule
 VERILOG_REGISTER_LINT_RULE(VoidCastRule);
@@ -67,8 +69,8 @@ const std::set<std::string>& VoidCastRule::ForbiddenFunctionsSet() {
 // For example:
 //   void'(foo());
 // Here, the leaf representing "foo" will be bound to id
-static const Matcher& FunctionMatcher() {
-  static const Matcher matcher(NodekVoidcast(VoidcastHasExpression(
+static const CompiledMatcher& FunctionMatcher() {
+  static const CompiledMatcher matcher(NodekVoidcast(VoidcastHasExpression(
       ExpressionHasFunctionCall(FunctionCallHasId().Bind("id")))));
   return matcher;
 }
@@ -83,13 +85,17 @@ static const Matcher& FunctionMatcher() {
 //   void'(randomize(obj));
 // Here, the node representing "randomize(obj)" will be bound to "id"
 //
-static const Matcher& RandomizeMatcher() {
-  static const Matcher matcher(NodekVoidcast(VoidcastHasExpression(
+static const CompiledMatcher& RandomizeMatcher() {
+  static const CompiledMatcher matcher(NodekVoidcast(VoidcastHasExpression(
       verible::matcher::AnyOf(ExpressionHasRandomizeCallExtension().Bind("id"),
                               ExpressionHasRandomizeFunction().Bind("id")))));
   return matcher;
 }
 
+std::vector<verible::SymbolTag> VoidCastRule::HandledTags() const {
+  return {verible::NodeTag(NodeEnum::kVoidcast)};
+}
+
 void VoidCastRule::HandleSymbol(const verible::Symbol& symbol,
                                 const SyntaxTreeContext& context) {
   // Check for forbidden function names
@@ -14,13 +14,24 @@
 
 #include "verilog/analysis/dependencies.h"
 
+#include <algorithm>
+#include <cstdint>
+#include <future>
 #include <iostream>
+#include <utility>
+#include <vector>
 
+#include "absl/container/flat_hash_map.h"
+#include "absl/strings/string_view.h"
 #include "common/strings/compare.h"
 #include "common/strings/display_utils.h"
+#include "common/text/token_info.h"
 #include "common/util/logging.h"
+#include "common/util/thread_pool.h"
 #include "verilog/analysis/symbol_table.h"
 #include "verilog/analysis/verilog_project.h"
+#include "verilog/parser/verilog_lexer.h"
+#include "verilog/parser/verilog_token_enum.h"
 
 namespace verilog {
 
@@ -78,6 +89,144 @@ static FileDependencies::symbol_index_type CreateSymbolMapFromSymbolTable(
   return symbols_index;  // move
 }
 
+// Returns the keyword that ends the design elements started by "token_enum",
+// or 0 if it does not start any.
+static int DesignElementEnd(int token_enum) {
+  switch (token_enum) {
+    case TK_module:
+    case TK_macromodule:
+      return TK_endmodule;
+    case TK_interface:
+      return TK_endinterface;
+    case TK_program:
+      return TK_endprogram;
+    case TK_package:
+      return TK_endpackage;
+    case TK_class:
+      return TK_endclass;
+    case TK_primitive:
+      return TK_endprimitive;
+    case TK_checker:
+      return TK_endchecker;
+    case TK_config:
+      return TK_endconfig;
+    default:
+      return 0;
+  }
+}
+
+namespace {
+// Top-level definitions and would-be references of one file, see
+// FileDependencies(const VerilogProject&, int).
+struct LexicalSymbols {
+  std::vector<absl::string_view> definitions;
+  std::vector<absl::string_view> references;
+};
+}  // namespace
+
+static LexicalSymbols CollectLexicalSymbols(absl::string_view text) {
+  std::vector<verible::TokenInfo> tokens;
+  VerilogLexer lexer(text);
+  for (;;) {
+    const verible::TokenInfo& token = lexer.DoNextToken();
+    if (token.isEOF()) break;
+    if (VerilogLexer::KeepSyntaxTreeTokens(token)) tokens.push_back(token);
+  }
+  const auto token_enum_at = [&tokens](size_t i) {
+    return i < tokens.size() ? tokens[i].token_enum() : 0;
+  };
+
+  LexicalSymbols symbols;
+  // The keyword that ends the top-level design element being scanned, or 0
+  // between design elements.  Nested elements of the same kind are rare
+  // enough not to be counted.
+  int element_end = 0;
+  for (size_t i = 0; i < tokens.size(); ++i) {
+    const int token_enum = tokens[i].token_enum();
+    if (element_end == 0) {
+      const int end = DesignElementEnd(token_enum);
+      const int previous = token_enum_at(i - 1);  // 0 before the first token
+      // Skip declarations ("extern module", "typedef class"), and let the
+      // class of an "interface class" start it.
+      if (end != 0 && previous != TK_extern && previous != TK_typedef &&
+          !(token_enum == TK_interface && token_enum_at(i + 1) == TK_class)) {
+        size_t name = i + 1;
+        while (token_enum_at(name) == TK_static ||
+               token_enum_at(name) == TK_automatic) {
+          ++name;
+        }
+        if (token_enum_at(name) == SymbolIdentifier) {
+          symbols.definitions.push_back(tokens[name].text());
+          element_end = end;
+        }
+      }
+    } else if (token_enum == element_end) {
+      element_end = 0;
+    }
+
+    if (token_enum == TK_extends || token_enum == TK_implements) {
+      if (token_enum_at(i + 1) == SymbolIdentifier) {
+        symbols.references.push_back(tokens[i + 1].text());
+      }
+      continue;
+    }
+    if (token_enum != SymbolIdentifier) continue;
+    switch (token_enum_at(i + 1)) {
+      case TK_SCOPE_RES:  // package::item, class::item
+      case '#':           // parameterized type or instance
+      case SymbolIdentifier:  // type of a declaration or instance
+        symbols.references.push_back(tokens[i].text());
+        break;
+      case '.':  // interface.modport port
+        if (token_enum_at(i + 2) == SymbolIdentifier &&
+            token_enum_at(i + 3) == SymbolIdentifier) {
+          symbols.references.push_back(tokens[i].text());
+        }
+        break;
+      default:
+        break;
+    }
+  }
+  return symbols;
+}
+
+static FileDependencies::symbol_index_type CreateSymbolMapFromTokens(
+    const VerilogProject& project, int jobs) {
+  VLOG(1) << __FUNCTION__;
+  std::vector<const VerilogSourceFile*> files;
+  for (const auto& file : project) {
+    if (file.second->Status().ok()) files.push_back(file.second.get());
+  }
+
+  // Files are lexed on the pool, and their symbols merged in order.
+  verible::ThreadPool pool(jobs > 1 ? std::min<int>(jobs, files.size()) : 0);
+  std::vector<std::future<LexicalSymbols>> file_symbols;
+  file_symbols.reserve(files.size());
+  for (const VerilogSourceFile* file : files) {
+    file_symbols.push_back(pool.ExecAsync<LexicalSymbols>(
+        [file]() { return CollectLexicalSymbols(file->GetContent()); }));
+  }
+
+  FileDependencies::symbol_index_type symbols_index;
+  std::vector<LexicalSymbols> symbols;
+  symbols.reserve(files.size());
+  for (size_t i = 0; i < files.size(); ++i) {
+    symbols.push_back(file_symbols[i].get());
+    for (const absl::string_view definition : symbols.back().definitions) {
+      FileDependencies::SymbolData& symbol_data(symbols_index[definition]);
+      // Take the first definition, arbitrarily.
+      if (symbol_data.definer == nullptr) symbol_data.definer = files[i];
+    }
+  }
+  for (size_t i = 0; i < files.size(); ++i) {
+    for (const absl::string_view reference : symbols[i].references) {
+      symbols_index[reference].referencers.insert(files[i]);
+    }
+  }
+  VLOG(1) << "end of " << __FUNCTION__;
+  return symbols_index;  // move
+}
+
 // Struct for printing readable dependency edge.
 struct DepEdge {
   const VerilogSourceFile* const ref;
@@ -121,6 +270,12 @@ FileDependencies::FileDependencies(const SymbolTable& symbol_table)
   // All the work is done by the initializers.
 }
 
+FileDependencies::FileDependencies(const VerilogProject& project, int jobs)
+    : root_symbols_index(CreateSymbolMapFromTokens(project, jobs)),
+      file_deps(CreateFileDependenciesFromSymbolMap(root_symbols_index)) {
+  // All the work is done by the initializers.
+}
+
 bool FileDependencies::Empty() const {
   for (const auto& ref : file_deps) {
     for (const auto& def : ref.second) {
@@ -148,6 +303,93 @@ std::ostream& FileDependencies::PrintGraph(std::ostream& stream) const {
   return stream;
 }
 
+std::vector<std::vector<FileDependencies::node_type>>
+FileDependencies::CompileLevels(const std::vector<node_type>& files) const {
+  std::vector<node_type> nodes;
+  absl::flat_hash_map<node_type, size_t> node_index;
+  for (const node_type file : files) {
+    if (node_index.emplace(file, nodes.size()).second) nodes.push_back(file);
+  }
+  // Dependencies of each node, by index.
+  std::vector<std::vector<size_t>> deps(nodes.size());
+  for (const auto& tail : file_deps) {
+    const auto ref = node_index.find(tail.first);
+    if (ref == node_index.end()) continue;
+    for (const auto& head : tail.second) {
+      const auto def = node_index.find(head.first);
+      if (def != node_index.end()) deps[ref->second].push_back(def->second);
+    }
+  }
+
+  // Strongly connected components, with (an iterative) Tarjan's algorithm,
+  // which finds each component after all of those that it depends on, so its
+  // level follows from theirs.
+  constexpr size_t kNone = SIZE_MAX;
+  std::vector<size_t> order(nodes.size(), kNone);
+  std::vector<size_t> low(nodes.size());
+  std::vector<size_t> component(nodes.size(), kNone);
+  std::vector<size_t> component_levels;
+  std::vector<std::vector<node_type>> levels;
+  std::vector<size_t> stack;  // nodes of components not completed yet
+  std::vector<std::pair<size_t, size_t>> path;  // (node, next dependency)
+  size_t visited = 0;
+  const auto visit = [&](size_t node) {
+    order[node] = low[node] = visited++;
+    stack.push_back(node);
+    path.emplace_back(node, 0);
+  };
+  for (size_t root = 0; root < nodes.size(); ++root) {
+    if (order[root] != kNone) continue;
+    visit(root);
+    while (!path.empty()) {
+      const size_t node = path.back().first;
+      const size_t next_dep = path.back().second++;
+      if (next_dep < deps[node].size()) {
+        const size_t dep = deps[node][next_dep];
+        if (order[dep] == kNone) {
+          visit(dep);
+        } else if (component[dep] == kNone) {  // still on the stack
+          low[node] = std::min(low[node], order[dep]);
+        }
+        continue;
+      }
+      path.pop_back();
+      if (!path.empty()) {
+        const size_t parent = path.back().first;
+        low[parent] = std::min(low[parent], low[node]);
+      }
+      if (low[node] != order[node]) continue;
+
+      // "node" is the first of its component: the rest of the stack.
+      const size_t this_component = component_levels.size();
+      auto members = stack.end();
+      do {
+        --members;
+        component[*members] = this_component;
+      } while (*members != node);
+      size_t level = 0;
+      for (auto member = members; member != stack.end(); ++member) {
+        for (const size_t dep : deps[*member]) {
+          if (component[dep] != this_component) {
+            level = std::max(level, component_levels[component[dep]] + 1);
+          }
+        }
+      }
+      component_levels.push_back(level);
+      if (levels.size() <= level) levels.resize(level + 1);
+      for (auto member = members; member != stack.end(); ++member) {
+        levels[level].push_back(nodes[*member]);
+      }
+      stack.erase(members, stack.end());
+    }
+  }
+
+  for (auto& level : levels) {
+    std::sort(level.begin(), level.end(), FileCompare());
+  }
+  return levels;
+}
+
 std::ostream& operator<<(std::ostream& stream, const FileDependencies& deps) {
   return deps.PrintGraph(stream);
 }
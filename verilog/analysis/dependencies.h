@@ -19,10 +19,12 @@
 #include <iosfwd>
 #include <map>
 #include <set>
+#include <vector>
 
 #include "absl/strings/string_view.h"
 #include "common/strings/compare.h"
 #include "verilog/analysis/symbol_table.h"
+#include "verilog/analysis/verilog_project.h"
 
 namespace verilog {
 
@@ -88,6 +90,18 @@ struct FileDependencies {
   // Once initialized, all data members are const.
   explicit FileDependencies(const SymbolTable& symbol_table);
 
+  // Extract dependency information from the tokens of the files of "project",
+  // lexing up to "jobs" files at once, without parsing them or building a
+  // symbol table.  This is much faster, but approximate:
+  // Definitions are the names of top-level design elements: modules,
+  // interfaces, programs, packages, classes, primitives, checkers and configs
+  // (but not top-level parameters, for instance).
+  // References are identifiers used the way these names are: followed by
+  // "::", "#" or another identifier (as types and instantiations are), or
+  // after "extends" or "implements".  Such uses of local names that other
+  // files define at the top-level count as references too.
+  FileDependencies(const VerilogProject& project, int jobs);
+
   bool Empty() const;
 
   // Visit every edge with a function.
@@ -98,6 +112,14 @@ struct FileDependencies {
 
   std::ostream& PrintGraph(std::ostream&) const;
 
+  // Returns "files" in compile order, in levels: files only depend on those
+  // of earlier levels, so that the files of a level can be compiled in
+  // parallel once the earlier levels are.  Files that depend on each other
+  // (on a cycle) are in the same level.  Dependencies on files that are not
+  // among "files" are ignored.  Files are sorted within levels.
+  std::vector<std::vector<node_type>> CompileLevels(
+      const std::vector<node_type>& files) const;
+
   // TODO: print unresolved references (no definition found)
 };
 
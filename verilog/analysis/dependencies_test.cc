@@ -23,6 +23,7 @@ namespace verilog {
 namespace {
 
 using testing::ElementsAre;
+using testing::UnorderedElementsAre;
 using verible::file::Basename;
 using verible::file::CreateDir;
 using verible::file::JoinPath;
@@ -352,6 +353,114 @@ TEST(FileDependenciesTest, ModuleDiamondDependencies) {
         << rrr_file->GetTextStructure()->Contents();
     EXPECT_THAT(found_def->second, ElementsAre("rrr"));
   }
+
+  // rrr first, then ppp and qqq, then mmm.
+  EXPECT_THAT(
+      file_deps.CompileLevels({mmm_file, ppp_file, qqq_file, rrr_file}),
+      ElementsAre(ElementsAre(rrr_file),
+                  UnorderedElementsAre(ppp_file, qqq_file),
+                  ElementsAre(mmm_file)));
+  // Only the given files are leveled.
+  EXPECT_THAT(file_deps.CompileLevels({mmm_file, ppp_file}),
+              ElementsAre(ElementsAre(ppp_file), ElementsAre(mmm_file)));
+
+  // The lexical approximation finds the same dependencies.
+  const FileDependencies lexical_deps(project, 4);
+  EXPECT_EQ(lexical_deps.file_deps, file_deps.file_deps);
+}
+
+TEST(FileDependenciesTest, LexicalDependencies) {
+  const auto tempdir = ::testing::TempDir();
+  const std::string sources_dir = JoinPath(tempdir, __FUNCTION__);
+  ASSERT_TRUE(CreateDir(sources_dir).ok());
+
+  VerilogProject project(sources_dir, {/* no include paths */});
+
+  ScopedTestFile pkg(sources_dir,
+                     "package pkg;\n"
+                     "  typedef class fwd;\n"
+                     "  localparam int N = 2;\n"
+                     "  class base;\n"
+                     "  endclass\n"
+                     "endpackage\n");
+  const VerilogSourceFile* pkg_file =
+      *project.OpenTranslationUnit(Basename(pkg.filename()));
+
+  ScopedTestFile cls(sources_dir,
+                     "class derived extends base;\n"
+                     "  int x = pkg::N;\n"
+                     "endclass\n");
+  const VerilogSourceFile* cls_file =
+      *project.OpenTranslationUnit(Basename(cls.filename()));
+
+  ScopedTestFile mod(sources_dir,
+                     "module automatic top;\n"
+                     "  derived d;\n"
+                     "  sub #(.W(1)) sub_i();\n"  // undefined
+                     "  top top_i();\n"           // itself
+                     "endmodule\n");
+  const VerilogSourceFile* mod_file =
+      *project.OpenTranslationUnit(Basename(mod.filename()));
+
+  const FileDependencies file_deps(project, 1);
+  EXPECT_EQ(file_deps.file_deps.size(), 2) << file_deps;
+  {
+    // class -> package, only for its top-level name
+    const auto found_ref = file_deps.file_deps.find(cls_file);
+    ASSERT_NE(found_ref, file_deps.file_deps.end()) << file_deps;
+    const auto found_def = found_ref->second.find(pkg_file);
+    ASSERT_NE(found_def, found_ref->second.end()) << file_deps;
+    EXPECT_THAT(found_def->second, ElementsAre("pkg"));
+  }
+  {
+    // module -> class
+    const auto found_ref = file_deps.file_deps.find(mod_file);
+    ASSERT_NE(found_ref, file_deps.file_deps.end()) << file_deps;
+    EXPECT_EQ(found_ref->second.size(), 1) << file_deps;
+    const auto found_def = found_ref->second.find(cls_file);
+    ASSERT_NE(found_def, found_ref->second.end()) << file_deps;
+    EXPECT_THAT(found_def->second, ElementsAre("derived"));
+  }
+  EXPECT_EQ(file_deps.root_symbols_index.at("sub").definer, nullptr);
+
+  // The same on multiple threads.
+  EXPECT_EQ(FileDependencies(project, 4).file_deps, file_deps.file_deps);
+}
+
+TEST(FileDependenciesTest, LevelsOfCyclicDependencies) {
+  const auto tempdir = ::testing::TempDir();
+  const std::string sources_dir = JoinPath(tempdir, __FUNCTION__);
+  ASSERT_TRUE(CreateDir(sources_dir).ok());
+
+  VerilogProject project(sources_dir, {/* no include paths */});
+
+  // aaa and bbb depend on each other, ccc on aaa.
+  ScopedTestFile aaa(sources_dir,
+                     "module aaa;\n"
+                     "  bbb bbb_i();\n"
+                     "endmodule\n");
+  const VerilogSourceFile* aaa_file =
+      *project.OpenTranslationUnit(Basename(aaa.filename()));
+  ScopedTestFile bbb(sources_dir,
+                     "module bbb;\n"
+                     "  aaa aaa_i();\n"
+                     "endmodule\n");
+  const VerilogSourceFile* bbb_file =
+      *project.OpenTranslationUnit(Basename(bbb.filename()));
+  ScopedTestFile ccc(sources_dir,
+                     "module ccc;\n"
+                     "  aaa aaa_i();\n"
+                     "endmodule\n");
+  const VerilogSourceFile* ccc_file =
+      *project.OpenTranslationUnit(Basename(ccc.filename()));
+
+  const FileDependencies file_deps(project, 1);
+  EXPECT_THAT(file_deps.CompileLevels({ccc_file, bbb_file, aaa_file}),
+              ElementsAre(UnorderedElementsAre(aaa_file, bbb_file),
+                          ElementsAre(ccc_file)));
+  EXPECT_THAT(file_deps.CompileLevels({ccc_file}),
+              ElementsAre(ElementsAre(ccc_file)));
+  EXPECT_TRUE(file_deps.CompileLevels({}).empty());
 }
 
 }  // namespace
@@ -14,6 +14,7 @@
 
 #include "verilog/analysis/flow_tree.h"
 
+#include <cstddef>
 #include <map>
 #include <string>
 #include <vector>
@@ -173,7 +174,32 @@ absl::Status FlowTree::GenerateVariants(const VariantReceiver &receiver) {
   if (!status.ok()) {
     return status;
   }
-  return DepthFirstSearch(receiver, source_sequence_.begin());
+  ApplyMacroAssumptions();
+  if (source_sequence_.empty()) {
+    // The only variant is empty.
+    receiver(current_variant_);
+    return absl::OkStatus();
+  }
+  RETURN_IF_ERROR(DepthFirstSearch(receiver, source_sequence_.begin()));
+  if (cancelled_) return absl::CancelledError("Variant generation cancelled.");
+  return absl::OkStatus();
+}
+
+void FlowTree::ApplyMacroAssumptions() {
+  for (const auto &[macro_name, macro_id] : conditional_macro_id_) {
+    bool defined;
+    if (const auto found = assumed_macros_.find(macro_name);
+        found != assumed_macros_.end()) {
+      defined = found->second;
+    } else if (varied_macros_.has_value() &&
+               varied_macros_->find(macro_name) == varied_macros_->end()) {
+      defined = false;
+    } else {
+      continue;  // This macro is varied.
+    }
+    current_variant_.visited.set(macro_id);
+    current_variant_.macros_mask.set(macro_id, defined);
+  }
 }
 
 // Constructs the control flow tree, which determines the edge from each node
@@ -257,36 +283,45 @@ absl::Status FlowTree::GenerateControlFlowTree() {
 absl::Status FlowTree::DepthFirstSearch(
     const VariantReceiver &receiver, TokenSequenceConstIterator current_node) {
   if (!wants_more_) return absl::OkStatus();
-
-  // Skips directives so that current_variant_ doesn't contain any.
-  if (current_node->token_enum() != PP_Identifier &&
-      current_node->token_enum() != PP_ifndef &&
-      current_node->token_enum() != PP_ifdef &&
-      current_node->token_enum() != PP_define &&
-      current_node->token_enum() != PP_define_body &&
-      current_node->token_enum() != PP_elsif &&
-      current_node->token_enum() != PP_else &&
-      current_node->token_enum() != PP_endif) {
-    current_variant_.sequence.push_back(*current_node);
+  if (is_cancelled_ && is_cancelled_()) {
+    cancelled_ = true;
+    wants_more_ = false;
+    return absl::OkStatus();
   }
 
-  // Checks if the current token is a `ifdef/`ifndef/`elsif.
-  if (current_node->token_enum() == PP_ifdef ||
-      current_node->token_enum() == PP_ifndef ||
-      current_node->token_enum() == PP_elsif) {
-    int macro_id = GetMacroIDOfConditional(current_node);
-    bool negated = (current_node->token_enum() == PP_ifndef);
-    // Checks if this macro is already visited (either defined/undefined).
-    if (current_variant_.visited.test(macro_id)) {
-      bool assume_condition_is_true =
-          (negated ^ current_variant_.macros_mask.test(macro_id));
-      if (auto status = DepthFirstSearch(
-              receiver, edges_[current_node][!assume_condition_is_true]);
-          !status.ok()) {
-        LOG(ERROR) << "ERROR: DepthFirstSearch fails. " << status;
-        return status;
+  // Tokens appended from here on are removed before returning, to back track
+  // into other variants.
+  const size_t sequence_size = current_variant_.sequence.size();
+
+  // Nodes with a single child are followed in this loop, so that recursion
+  // only happens at branches, rather than once per token.
+  while (true) {
+    // Skips directives so that current_variant_ doesn't contain any.
+    if (current_node->token_enum() != PP_Identifier &&
+        current_node->token_enum() != PP_ifndef &&
+        current_node->token_enum() != PP_ifdef &&
+        current_node->token_enum() != PP_define &&
+        current_node->token_enum() != PP_define_body &&
+        current_node->token_enum() != PP_elsif &&
+        current_node->token_enum() != PP_else &&
+        current_node->token_enum() != PP_endif) {
+      current_variant_.sequence.push_back(*current_node);
+    }
+
+    // Checks if the current token is a `ifdef/`ifndef/`elsif.
+    if (current_node->token_enum() == PP_ifdef ||
+        current_node->token_enum() == PP_ifndef ||
+        current_node->token_enum() == PP_elsif) {
+      int macro_id = GetMacroIDOfConditional(current_node);
+      bool negated = (current_node->token_enum() == PP_ifndef);
+      const auto &next_nodes = edges_[current_node];
+      // Checks if this macro is already visited (either defined/undefined).
+      if (current_variant_.visited.test(macro_id)) {
+        bool assume_condition_is_true =
+            (negated ^ current_variant_.macros_mask.test(macro_id));
+        current_node = next_nodes[!assume_condition_is_true];
+        continue;
       }
-    } else {
       current_variant_.visited.flip(macro_id);
       // This macro wans't visited before, then we can check both edges.
       // Assume the condition is true.
@@ -295,7 +330,7 @@ absl::Status FlowTree::DepthFirstSearch(
       } else {
         current_variant_.macros_mask.set(macro_id);
       }
-      if (auto status = DepthFirstSearch(receiver, edges_[current_node][0]);
+      if (auto status = DepthFirstSearch(receiver, next_nodes[0]);
           !status.ok()) {
         LOG(ERROR) << "ERROR: DepthFirstSearch fails. " << status;
         return status;
@@ -307,41 +342,42 @@ absl::Status FlowTree::DepthFirstSearch(
       } else {
         current_variant_.macros_mask.set(macro_id);
       }
-      if (auto status = DepthFirstSearch(receiver, edges_[current_node][1]);
+      if (auto status = DepthFirstSearch(receiver, next_nodes[1]);
           !status.ok()) {
         LOG(ERROR) << "ERROR: DepthFirstSearch fails. " << status;
         return status;
       }
       // Undo the change to allow for backtracking.
       current_variant_.visited.flip(macro_id);
+      break;
     }
-  } else {
-    // Do recursive search through every possible edge.
+
     // Expected to be only one edge in this case.
-    for (auto next_node : edges_[current_node]) {
+    const auto &next_nodes = edges_[current_node];
+    if (next_nodes.size() == 1) {
+      current_node = next_nodes.front();
+      continue;
+    }
+    // Do recursive search through every possible edge.
+    for (auto next_node : next_nodes) {
       if (auto status = FlowTree::DepthFirstSearch(receiver, next_node);
           !status.ok()) {
         LOG(ERROR) << "ERROR: DepthFirstSearch fails. " << status;
         return status;
       }
     }
+    // If the current node is the last one, push the completed
+    // current_variant_ then it is ready to be sent.
+    if (current_node == source_sequence_.end() - 1) {
+      wants_more_ &= receiver(current_variant_);
+    }
+    break;
   }
-  // If the current node is the last one, push the completed current_variant_
-  // then it is ready to be sent.
-  if (current_node == source_sequence_.end() - 1) {
-    wants_more_ &= receiver(current_variant_);
-  }
-  if (current_node->token_enum() != PP_Identifier &&
-      current_node->token_enum() != PP_ifndef &&
-      current_node->token_enum() != PP_ifdef &&
-      current_node->token_enum() != PP_define &&
-      current_node->token_enum() != PP_define_body &&
-      current_node->token_enum() != PP_elsif &&
-      current_node->token_enum() != PP_else &&
-      current_node->token_enum() != PP_endif) {
-    // Remove tokens to back track into other variants.
-    current_variant_.sequence.pop_back();
-  }
+
+  // Remove tokens to back track into other variants.
+  current_variant_.sequence.erase(
+      current_variant_.sequence.begin() + sequence_size,
+      current_variant_.sequence.end());
   return absl::OkStatus();
 }
 
@@ -16,11 +16,16 @@
 #define VERIBLE_VERILOG_FLOW_TREE_H_
 
 #include <bitset>
+#include <functional>
 #include <map>
+#include <optional>
+#include <set>
 #include <string>
+#include <utility>
 #include <vector>
 
 #include "absl/status/status.h"
+#include "absl/strings/string_view.h"
 #include "common/text/token_stream_view.h"
 
 namespace verilog {
@@ -77,6 +82,27 @@ class FlowTree {
   explicit FlowTree(verible::TokenSequence source_sequence)
       : source_sequence_(std::move(source_sequence)){};
 
+  // Fixes macro 'name' to be defined (or undefined, if 'defined' is false) in
+  // all generated variants, so that only one side of its conditionals is
+  // explored.  Must be called before GenerateVariants().
+  void AssumeMacro(absl::string_view name, bool defined) {
+    assumed_macros_[std::string(name)] = defined;
+  }
+
+  // Only varies the macros in 'names'.  All other macros are assumed to be
+  // undefined, except for the ones given to AssumeMacro().
+  // Must be called before GenerateVariants().
+  void VaryOnlyMacros(const std::vector<std::string> &names) {
+    varied_macros_.emplace(names.begin(), names.end());
+  }
+
+  // If set, 'is_cancelled' is polled before each branch explored by
+  // GenerateVariants(), which stops with a kCancelled error once it returns
+  // true.  Must be called before GenerateVariants().
+  void SetIsCancelled(std::function<bool()> is_cancelled) {
+    is_cancelled_ = std::move(is_cancelled);
+  }
+
   // Generates all possible variants.
   absl::Status GenerateVariants(const VariantReceiver &receiver);
 
@@ -130,6 +156,10 @@ class FlowTree {
 
   int GetMacroIDOfConditional(TokenSequenceConstIterator conditional_iterator);
 
+  // Marks the macros fixed by AssumeMacro() and VaryOnlyMacros() as visited in
+  // current_variant_, so that DepthFirstSearch() doesn't branch on them.
+  void ApplyMacroAssumptions();
+
   // Holds all of the conditional blocks.
   std::vector<ConditionalBlock> if_blocks_;
 
@@ -143,6 +173,11 @@ class FlowTree {
   // By default: it assumes VariantReceiver wants more variants.
   bool wants_more_ = true;
 
+  // Set by SetIsCancelled().  Once it returned true, cancelled_ is set and
+  // wants_more_ cleared, to unwind the search.
+  std::function<bool()> is_cancelled_;
+  bool cancelled_ = false;
+
   // Mapping each conditional macro to an integer ID,
   // to use it later as a bit offset.
   std::map<absl::string_view, int> conditional_macro_id_;
@@ -152,6 +187,13 @@ class FlowTree {
 
   // Number of macros appeared in `ifdef/`ifndef/`elsif.
   int conditional_macros_counter_ = 0;
+
+  // Macros fixed to be defined (true) or undefined (false).
+  std::map<std::string, bool, std::less<>> assumed_macros_;
+
+  // If set, macros that are not in this set (nor in assumed_macros_) are
+  // assumed to be undefined.
+  std::optional<std::set<std::string, std::less<>>> varied_macros_;
 };
 
 }  // namespace verilog
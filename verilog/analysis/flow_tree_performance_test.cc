@@ -0,0 +1,105 @@
+// Copyright 2017-2023 The Verible Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// Pathological conditionals for FlowTree, whose variants have to be
+// generated within a time and memory budget, to catch complexity
+// regressions.
+
+#include <cstdint>
+#include <string>
+
+#include "absl/status/status.h"
+#include "absl/strings/str_cat.h"
+#include "absl/strings/string_view.h"
+#include "absl/time/time.h"
+#include "common/util/resource_budget_test_util.h"
+#include "gtest/gtest.h"
+#include "verilog/analysis/flow_tree.h"
+#include "verilog/parser/verilog_lexer.h"
+
+namespace verilog {
+namespace {
+
+using verible::testing::MeasureResourceUsage;
+using verible::testing::WithinBudget;
+
+constexpr int64_t kMiB = 1 << 20;
+
+verible::TokenSequence LexToSequence(absl::string_view source_contents) {
+  verible::TokenSequence lexed_sequence;
+  VerilogLexer lexer(source_contents);
+  for (lexer.DoNextToken(); !lexer.GetLastToken().isEOF();
+       lexer.DoNextToken()) {
+    if (verilog::VerilogLexer::KeepSyntaxTreeTokens(lexer.GetLastToken())) {
+      lexed_sequence.push_back(lexer.GetLastToken());
+    }
+  }
+  return lexed_sequence;
+}
+
+// Counts the variants of "code", within the budget.
+int CountVariantsWithinBudget(absl::string_view code,
+                              const verible::testing::ResourceBudget& budget) {
+  const verible::TokenSequence tokens = LexToSequence(code);
+  int variants = 0;
+  absl::Status status;
+  const auto usage = MeasureResourceUsage([&]() {
+    FlowTree flow_tree(tokens);
+    status = flow_tree.GenerateVariants([&](const FlowTree::Variant&) {
+      ++variants;
+      return true;
+    });
+  });
+  EXPECT_TRUE(status.ok()) << status;
+  EXPECT_TRUE(WithinBudget(usage, budget));
+  return variants;
+}
+
+// A fan of 12 independent conditionals, one after the other, has 2^12
+// variants.
+TEST(FlowTreePerformanceTest, IndependentConditionals) {
+  std::string code;
+  for (int i = 0; i < 12; ++i) {
+    absl::StrAppend(&code, "`ifdef M", i, "\n  wire a", i, ";\n`else\n  wire b",
+                    i, ";\n`endif\n");
+  }
+  EXPECT_EQ(CountVariantsWithinBudget(code, {absl::Seconds(5), 256 * kMiB}),
+            1 << 12);
+}
+
+// Conditionals nested 12 deep, each with an `elsif and `else branch.
+TEST(FlowTreePerformanceTest, NestedConditionals) {
+  std::string code;
+  for (int i = 0; i < 12; ++i) {
+    absl::StrAppend(&code, "`ifdef A", i, "\n  wire a", i, ";\n`elsif B", i,
+                    "\n  wire b", i, ";\n`else\n");
+  }
+  for (int i = 0; i < 12; ++i) absl::StrAppend(&code, "`endif\n");
+  EXPECT_EQ(CountVariantsWithinBudget(code, {absl::Seconds(5), 256 * kMiB}),
+            2 * 12 + 1);
+}
+
+// Conditionals on the same macro don't multiply the variants.
+TEST(FlowTreePerformanceTest, ManyConditionalsOnOneMacro) {
+  std::string code;
+  for (int i = 0; i < 2000; ++i) {
+    absl::StrAppend(&code, "`ifndef M\n  wire a", i, ";\n`else\n  wire b", i,
+                    ";\n`endif\n");
+  }
+  EXPECT_EQ(CountVariantsWithinBudget(code, {absl::Seconds(5), 256 * kMiB}),
+            2);
+}
+
+}  // namespace
+}  // namespace verilog
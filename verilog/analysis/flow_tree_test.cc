@@ -14,6 +14,7 @@
 
 #include "verilog/analysis/flow_tree.h"
 
+#include <string>
 #include <vector>
 
 #include "absl/status/status.h"
@@ -356,5 +357,107 @@ TEST(FlowTree, CompleteConditional) {
   EXPECT_THAT(variants[3].sequence[0].text(), "ALL_FALSE");
 }
 
+TEST(FlowTree, AssumedMacros) {
+  const absl::string_view test_case =
+      R"(
+    `ifdef A
+      A_TRUE
+    `elsif B
+      B_TRUE
+    `elsif C
+      C_TRUE
+    `else
+      ALL_FALSE
+    `endif)";
+
+  FlowTree tree_test(LexToSequence(test_case));
+  tree_test.AssumeMacro("B", true);
+  std::vector<FlowTree::Variant> variants;
+  auto status =
+      tree_test.GenerateVariants([&variants](const FlowTree::Variant& variant) {
+        variants.push_back(variant);
+        return true;
+      });
+  EXPECT_TRUE(status.ok());
+  ASSERT_EQ(variants.size(), 2);
+  EXPECT_THAT(variants[0].sequence[0].text(), "A_TRUE");
+  EXPECT_THAT(variants[1].sequence[0].text(), "B_TRUE");
+  for (const auto& variant : variants) {
+    EXPECT_TRUE(variant.visited.test(1));
+    EXPECT_TRUE(variant.macros_mask.test(1));
+  }
+}
+
+TEST(FlowTree, VaryOnlyMacros) {
+  const absl::string_view test_case =
+      R"(
+    `ifdef A
+      A_TRUE
+    `elsif B
+      B_TRUE
+    `elsif C
+      C_TRUE
+    `else
+      ALL_FALSE
+    `endif)";
+
+  FlowTree tree_test(LexToSequence(test_case));
+  tree_test.VaryOnlyMacros({"B"});
+  std::vector<FlowTree::Variant> variants;
+  auto status =
+      tree_test.GenerateVariants([&variants](const FlowTree::Variant& variant) {
+        variants.push_back(variant);
+        return true;
+      });
+  EXPECT_TRUE(status.ok());
+  ASSERT_EQ(variants.size(), 2);
+  EXPECT_THAT(variants[0].sequence[0].text(), "B_TRUE");
+  EXPECT_THAT(variants[1].sequence[0].text(), "ALL_FALSE");
+}
+
+TEST(FlowTree, Cancelled) {
+  const absl::string_view test_case =
+      R"(
+    `ifdef A
+      A_TRUE
+    `endif
+    `ifdef B
+      B_TRUE
+    `endif)";
+
+  FlowTree tree_test(LexToSequence(test_case));
+  int polls = 0;
+  tree_test.SetIsCancelled([&polls]() { return ++polls > 2; });
+  std::vector<FlowTree::Variant> variants;
+  auto status =
+      tree_test.GenerateVariants([&variants](const FlowTree::Variant& variant) {
+        variants.push_back(variant);
+        return true;
+      });
+  EXPECT_EQ(status.code(), absl::StatusCode::kCancelled);
+  // Cancelled before reaching the end of the first variant.
+  EXPECT_TRUE(variants.empty());
+  EXPECT_EQ(polls, 3);
+}
+
+TEST(FlowTree, LongSequences) {
+  // Long runs of tokens are followed without recursing once per token.
+  constexpr int kTokens = 200000;
+  std::string test_case = "`ifdef A\n";
+  for (int i = 0; i < kTokens; ++i) test_case += "x\n";
+  test_case += "`endif\n";
+  for (int i = 0; i < kTokens; ++i) test_case += "y\n";
+
+  FlowTree tree_test(LexToSequence(test_case));
+  std::vector<size_t> variant_sizes;
+  auto status = tree_test.GenerateVariants(
+      [&variant_sizes](const FlowTree::Variant& variant) {
+        variant_sizes.push_back(variant.sequence.size());
+        return true;
+      });
+  EXPECT_TRUE(status.ok());
+  EXPECT_THAT(variant_sizes, testing::ElementsAre(2 * kTokens, kTokens));
+}
+
 }  // namespace
 }  // namespace verilog
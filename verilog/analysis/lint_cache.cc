@@ -0,0 +1,220 @@
+// Copyright 2017-2023 The Verible Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "verilog/analysis/lint_cache.h"
+
+#include <cstdint>
+#include <set>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "absl/flags/flag.h"
+#include "absl/status/status.h"
+#include "absl/status/statusor.h"
+#include "absl/strings/str_cat.h"
+#include "absl/strings/str_split.h"
+#include "absl/strings/string_view.h"
+#include "common/analysis/lint_rule_status.h"
+#include "common/text/token_info.h"
+#include "common/util/file_util.h"
+#include "common/util/range.h"
+#include "common/util/varint_coding.h"
+#include "verilog/analysis/lint_rule_registry.h"
+#include "verilog/analysis/parse_cache.h"
+#include "verilog/analysis/verilog_linter_configuration.h"
+
+ABSL_FLAG(std::string, lint_cache_dir, "",
+          "If set, directory in which lint results are cached, keyed by file "
+          "contents, linter configuration, waiver files and tool version, so "
+          "that unchanged files are not parsed and linted again.  Only "
+          "results of files without syntax errors are cached.  The directory "
+          "must exist.  Builds without a repository version don't notice "
+          "rule changes; clear the directory after upgrading those.");
+
+namespace verilog {
+
+using verible::AutoFix;
+using verible::LintRuleStatus;
+using verible::LintViolation;
+using verible::ReplacementEdit;
+using verible::TokenInfo;
+
+// Changes whenever the format of entries does.
+static constexpr absl::string_view kMagic = "verible-lint-results-1\n";
+
+using verible::PutString;
+using verible::PutVarint;
+using verible::VarintReader;
+
+// Reads the offset and size of a part of 'text'.
+static bool ReadRange(VarintReader* reader, absl::string_view text,
+                      absl::string_view* range) {
+  uint64_t begin, length;
+  if (!reader->Varint(&begin) || !reader->Varint(&length) ||
+      begin > text.size() || length > text.size() - begin) {
+    return false;
+  }
+  *range = text.substr(begin, length);
+  return true;
+}
+
+std::string LintCacheDir() { return absl::GetFlag(FLAGS_lint_cache_dir); }
+
+std::string LintCachePath(absl::string_view dir, absl::string_view filename,
+                          absl::string_view text,
+                          const LinterConfiguration& config,
+                          absl::string_view mode) {
+  // Rules like module-filename look at the path, and external waivers apply
+  // to paths.
+  std::string lint_mode = absl::StrCat(kMagic, "path: ", filename, "\n", mode,
+                                       "\n", config.Fingerprint());
+  for (const auto& waiver_file :
+       absl::StrSplit(config.external_waivers, ',', absl::SkipEmpty())) {
+    const auto content = verible::file::GetContentAsString(waiver_file);
+    absl::StrAppend(&lint_mode, "waiver file: ", waiver_file, "\n",
+                    content.ok() ? *content : "<unreadable>", "\n");
+  }
+  return ParseCachePath(dir, text, lint_mode, ".vlint");
+}
+
+absl::StatusOr<std::string> SerializeLintStatuses(
+    const std::vector<LintRuleStatus>& statuses, absl::string_view text) {
+  const auto not_in_text = []() {
+    return absl::FailedPreconditionError(
+        "Can't cache violations that are not part of the text.");
+  };
+  // The text guards against hash collisions.
+  std::string bytes(kMagic);
+  PutString(text, &bytes);
+  PutVarint(statuses.size(), &bytes);
+  for (const LintRuleStatus& status : statuses) {
+    PutString(status.lint_rule_name, &bytes);
+    PutString(status.url, &bytes);
+    PutVarint(status.violations.size(), &bytes);
+    for (const LintViolation& violation : status.violations) {
+      const TokenInfo& token = violation.token;
+      if (token.token_enum() < 0 || !verible::IsSubRange(token.text(), text)) {
+        return not_in_text();
+      }
+      PutVarint(token.token_enum(), &bytes);
+      PutVarint(token.left(text), &bytes);
+      PutVarint(token.text().size(), &bytes);
+      PutString(violation.reason, &bytes);
+      PutVarint(violation.autofixes.size(), &bytes);
+      for (const AutoFix& autofix : violation.autofixes) {
+        PutString(autofix.Description(), &bytes);
+        PutVarint(autofix.Edits().size(), &bytes);
+        for (const ReplacementEdit& edit : autofix.Edits()) {
+          if (!verible::IsSubRange(edit.fragment, text)) return not_in_text();
+          PutVarint(edit.fragment.data() - text.data(), &bytes);
+          PutVarint(edit.fragment.size(), &bytes);
+          PutString(edit.replacement, &bytes);
+        }
+      }
+    }
+  }
+  return bytes;
+}
+
+absl::StatusOr<std::vector<LintRuleStatus>> DeserializeLintStatuses(
+    absl::string_view bytes, absl::string_view text) {
+  const auto malformed = []() {
+    return absl::DataLossError("Malformed lint cache entry.");
+  };
+  VarintReader reader(bytes);
+  absl::string_view cached_text;
+  if (!reader.Prefix(kMagic) || !reader.String(&cached_text)) {
+    return malformed();
+  }
+  if (cached_text != text) {
+    return absl::NotFoundError("Lint cache entry of a different text.");
+  }
+  // Rule names of statuses refer to the static names of registered rules.
+  const std::set<analysis::LintRuleId> rule_names =
+      analysis::GetAllRegisteredLintRuleNames();
+  uint64_t num_statuses;
+  if (!reader.Varint(&num_statuses)) return malformed();
+  std::vector<LintRuleStatus> statuses;
+  for (uint64_t i = 0; i < num_statuses; ++i) {
+    absl::string_view rule_name, url;
+    uint64_t num_violations;
+    if (!reader.String(&rule_name) || !reader.String(&url) ||
+        !reader.Varint(&num_violations)) {
+      return malformed();
+    }
+    const auto found = rule_names.find(rule_name);
+    if (found == rule_names.end()) {
+      return absl::NotFoundError(
+          absl::StrCat("Lint cache entry of unknown rule ", rule_name, "."));
+    }
+    LintRuleStatus& status = statuses.emplace_back();
+    status.lint_rule_name = *found;
+    status.url = std::string(url);
+    for (uint64_t j = 0; j < num_violations; ++j) {
+      uint64_t token_enum, num_autofixes;
+      absl::string_view token_text, reason;
+      if (!reader.Varint(&token_enum) || !ReadRange(&reader, text, &token_text) ||
+          !reader.String(&reason) || !reader.Varint(&num_autofixes)) {
+        return malformed();
+      }
+      std::vector<AutoFix> autofixes;
+      for (uint64_t k = 0; k < num_autofixes; ++k) {
+        absl::string_view description;
+        uint64_t num_edits;
+        if (!reader.String(&description) || !reader.Varint(&num_edits)) {
+          return malformed();
+        }
+        std::set<ReplacementEdit> edits;
+        for (uint64_t e = 0; e < num_edits; ++e) {
+          absl::string_view fragment, replacement;
+          if (!ReadRange(&reader, text, &fragment) || !reader.String(&replacement)) {
+            return malformed();
+          }
+          edits.emplace(fragment, std::string(replacement));
+        }
+        AutoFix autofix(description, {});
+        if (!autofix.AddEdits(edits)) return malformed();
+        autofixes.push_back(std::move(autofix));
+      }
+      status.violations.emplace_back(
+          TokenInfo(static_cast<int>(token_enum), token_text), reason,
+          autofixes);
+    }
+  }
+  if (!reader.AtEnd()) return malformed();
+  return statuses;
+}
+
+absl::StatusOr<std::vector<LintRuleStatus>> LoadLintCacheEntry(
+    absl::string_view path, absl::string_view text) {
+  if (!verible::file::FileExists(std::string(path)).ok()) {
+    return absl::NotFoundError(absl::StrCat(path, ": not in lint cache."));
+  }
+  const absl::StatusOr<std::string> bytes =
+      verible::file::GetContentAsString(path);
+  if (!bytes.ok()) return bytes.status();
+  return DeserializeLintStatuses(*bytes, text);
+}
+
+absl::Status StoreLintCacheEntry(absl::string_view path,
+                                 absl::string_view text,
+                                 const std::vector<LintRuleStatus>& statuses) {
+  absl::StatusOr<std::string> bytes = SerializeLintStatuses(statuses, text);
+  if (!bytes.ok()) return bytes.status();
+  // Readers only ever see complete entries.
+  return verible::file::SetContentsAtomically(path, *bytes);
+}
+
+}  // namespace verilog
@@ -0,0 +1,79 @@
+// Copyright 2017-2023 The Verible Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// Opt-in on-disk cache of lint results (--lint_cache_dir), so that files that
+// did not change since the last run are neither parsed nor linted again.
+//
+// Entries hold the statuses of all rules for one file, named after a hash of
+// the file's text and of everything else its lint results depend on: its
+// path, the effective linter configuration, the contents of the waiver files
+// and the tool version (see ParseCachePath()).  Only results of files
+// without syntax errors are cached.  Entries are written atomically, so
+// several linters can share a directory.  Stale entries are never removed;
+// just delete the directory to clear the cache.
+
+#ifndef VERIBLE_VERILOG_ANALYSIS_LINT_CACHE_H_
+#define VERIBLE_VERILOG_ANALYSIS_LINT_CACHE_H_
+
+#include <string>
+#include <vector>
+
+#include "absl/flags/declare.h"
+#include "absl/status/status.h"
+#include "absl/status/statusor.h"
+#include "absl/strings/string_view.h"
+#include "common/analysis/lint_rule_status.h"
+#include "verilog/analysis/verilog_linter_configuration.h"
+
+// Flag is declared for testing purposes.
+ABSL_DECLARE_FLAG(std::string, lint_cache_dir);
+
+namespace verilog {
+
+// Returns the directory of the lint cache (--lint_cache_dir), or an empty
+// string if caching is disabled.
+std::string LintCacheDir();
+
+// Returns the path of the entry in cache directory 'dir' for the file at
+// 'filename' with 'text', linted with 'config'.  'mode' describes the rest
+// of what the lint results depend on, like the analysis options.
+std::string LintCachePath(absl::string_view dir, absl::string_view filename,
+                          absl::string_view text,
+                          const LinterConfiguration& config,
+                          absl::string_view mode);
+
+// Serializes the lint results of 'text'.  Fails unless the locations of all
+// violations and their autofixes are part of 'text'.
+absl::StatusOr<std::string> SerializeLintStatuses(
+    const std::vector<verible::LintRuleStatus>& statuses,
+    absl::string_view text);
+
+// Returns the lint results serialized from 'text', whose violations point
+// into 'text', which must outlive them.
+absl::StatusOr<std::vector<verible::LintRuleStatus>> DeserializeLintStatuses(
+    absl::string_view bytes, absl::string_view text);
+
+// Returns the lint results of the cache entry 'path', which must be one of
+// 'text'.  Returns NotFoundError if there is no such entry.
+absl::StatusOr<std::vector<verible::LintRuleStatus>> LoadLintCacheEntry(
+    absl::string_view path, absl::string_view text);
+
+// Writes the lint results of 'text' as cache entry 'path'.
+absl::Status StoreLintCacheEntry(
+    absl::string_view path, absl::string_view text,
+    const std::vector<verible::LintRuleStatus>& statuses);
+
+}  // namespace verilog
+
+#endif  // VERIBLE_VERILOG_ANALYSIS_LINT_CACHE_H_
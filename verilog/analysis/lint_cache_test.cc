@@ -0,0 +1,197 @@
+// Copyright 2017-2023 The Verible Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "verilog/analysis/lint_cache.h"
+
+#include <string>
+#include <vector>
+
+#include "absl/status/status.h"
+#include "absl/strings/string_view.h"
+#include "common/analysis/line_lint_rule.h"
+#include "common/analysis/lint_rule_status.h"
+#include "common/text/token_info.h"
+#include "common/util/file_util.h"
+#include "gtest/gtest.h"
+#include "verilog/analysis/descriptions.h"
+#include "verilog/analysis/lint_rule_registry.h"
+#include "verilog/analysis/verilog_linter_configuration.h"
+
+namespace verilog {
+namespace {
+
+using analysis::LintRuleDescriptor;
+using verible::AutoFix;
+using verible::LintRuleStatus;
+using verible::LintViolation;
+using verible::TokenInfo;
+using verible::file::testing::RandomFileBasename;
+using verible::file::testing::ScopedTestFile;
+
+// Cached statuses refer to registered rules.
+class CacheTestRule : public verible::LineLintRule {
+ public:
+  using rule_type = verible::LineLintRule;
+  static const LintRuleDescriptor& GetDescriptor() {
+    static const LintRuleDescriptor d{
+        .name = "cache-test-rule",
+        .desc = "CacheTestRule",
+    };
+    return d;
+  }
+  void HandleLine(absl::string_view) final {}
+  LintRuleStatus Report() const final { return LintRuleStatus(); }
+};
+
+VERILOG_REGISTER_LINT_RULE(CacheTestRule);
+
+constexpr absl::string_view kText =
+    "module m; \n"
+    "  wire\ta;\n"
+    "endmodule\n";
+
+// Statuses of one violation with two alternative fixes, and one without.
+std::vector<LintRuleStatus> MakeStatuses(absl::string_view text) {
+  LintRuleStatus status;
+  status.lint_rule_name = CacheTestRule::GetDescriptor().name;
+  status.url = "http://style/guide#spaces";
+  const absl::string_view space = text.substr(9, 1);
+  const absl::string_view tab = text.substr(17, 1);
+  status.violations.emplace_back(
+      TokenInfo(1, space), "trailing space",
+      std::vector<AutoFix>{AutoFix("Remove", {space, ""}),
+                           AutoFix("Replace", {{space, ";"}, {tab, " "}})});
+  status.violations.emplace_back(TokenInfo(2, tab), "tab");
+  return {status};
+}
+
+void ExpectSameStatuses(const std::vector<LintRuleStatus>& a,
+                        absl::string_view a_text,
+                        const std::vector<LintRuleStatus>& b,
+                        absl::string_view b_text) {
+  ASSERT_EQ(a.size(), b.size());
+  for (size_t i = 0; i < a.size(); ++i) {
+    EXPECT_EQ(a[i].lint_rule_name, b[i].lint_rule_name);
+    EXPECT_EQ(a[i].url, b[i].url);
+    ASSERT_EQ(a[i].violations.size(), b[i].violations.size());
+    for (size_t j = 0; j < a[i].violations.size(); ++j) {
+      const LintViolation& u = a[i].violations[j];
+      const LintViolation& v = b[i].violations[j];
+      EXPECT_EQ(u.token.token_enum(), v.token.token_enum());
+      EXPECT_EQ(u.token.left(a_text), v.token.left(b_text));
+      EXPECT_EQ(u.token.text(), v.token.text());
+      EXPECT_EQ(u.reason, v.reason);
+      ASSERT_EQ(u.autofixes.size(), v.autofixes.size());
+      for (size_t k = 0; k < u.autofixes.size(); ++k) {
+        EXPECT_EQ(u.autofixes[k].Description(), v.autofixes[k].Description());
+        EXPECT_EQ(u.autofixes[k].Apply(a_text), v.autofixes[k].Apply(b_text));
+      }
+    }
+  }
+}
+
+TEST(LintCacheTest, SerializeRoundTrip) {
+  const std::vector<LintRuleStatus> statuses = MakeStatuses(kText);
+  const auto bytes = SerializeLintStatuses(statuses, kText);
+  ASSERT_TRUE(bytes.ok()) << bytes.status();
+
+  // Restored violations point into the text they are restored for.
+  const std::string text(kText);
+  const auto restored = DeserializeLintStatuses(*bytes, text);
+  ASSERT_TRUE(restored.ok()) << restored.status();
+  ExpectSameStatuses(statuses, kText, *restored, text);
+  EXPECT_EQ((*restored)[0].violations[0].token.text().data(), &text[9]);
+}
+
+TEST(LintCacheTest, NoViolations) {
+  const auto bytes = SerializeLintStatuses({}, kText);
+  ASSERT_TRUE(bytes.ok()) << bytes.status();
+  const auto restored = DeserializeLintStatuses(*bytes, kText);
+  ASSERT_TRUE(restored.ok()) << restored.status();
+  EXPECT_TRUE(restored->empty());
+}
+
+TEST(LintCacheTest, OnlyViolationsInText) {
+  const std::string other_text(kText);
+  EXPECT_FALSE(SerializeLintStatuses(MakeStatuses(other_text), kText).ok());
+}
+
+TEST(LintCacheTest, DifferentTextNotFound) {
+  const auto bytes = SerializeLintStatuses(MakeStatuses(kText), kText);
+  ASSERT_TRUE(bytes.ok()) << bytes.status();
+  const auto restored = DeserializeLintStatuses(*bytes, "module n;\n");
+  EXPECT_EQ(restored.status().code(), absl::StatusCode::kNotFound);
+}
+
+TEST(LintCacheTest, UnknownRuleNotFound) {
+  std::vector<LintRuleStatus> statuses = MakeStatuses(kText);
+  statuses[0].lint_rule_name = "no-longer-a-rule";
+  const auto bytes = SerializeLintStatuses(statuses, kText);
+  ASSERT_TRUE(bytes.ok()) << bytes.status();
+  const auto restored = DeserializeLintStatuses(*bytes, kText);
+  EXPECT_EQ(restored.status().code(), absl::StatusCode::kNotFound);
+}
+
+TEST(LintCacheTest, MalformedEntries) {
+  const auto bytes = SerializeLintStatuses(MakeStatuses(kText), kText);
+  ASSERT_TRUE(bytes.ok()) << bytes.status();
+  for (size_t size = 0; size < bytes->size(); ++size) {
+    EXPECT_FALSE(DeserializeLintStatuses(bytes->substr(0, size), kText).ok())
+        << size;
+  }
+  EXPECT_FALSE(DeserializeLintStatuses(*bytes + "x", kText).ok());
+}
+
+TEST(LintCacheTest, PathDependsOnEverythingLinted) {
+  LinterConfiguration config;
+  config.TurnOn("cache-test-rule");
+  const std::string path = LintCachePath("dir", "a.sv", kText, config, "");
+  EXPECT_EQ(LintCachePath("dir", "a.sv", kText, config, ""), path);
+  EXPECT_NE(LintCachePath("dir", "b.sv", kText, config, ""), path);
+  EXPECT_NE(LintCachePath("dir", "a.sv", "module n;\n", config, ""), path);
+  EXPECT_NE(LintCachePath("dir", "a.sv", kText, config, "mode"), path);
+  EXPECT_NE(LintCachePath("dir", "a.sv", kText, LinterConfiguration(), ""),
+            path);
+
+  // Waiver files count with their contents.
+  LinterConfiguration waived = config;
+  const ScopedTestFile waivers(testing::TempDir(), "waive --rule=foo\n");
+  waived.external_waivers = std::string(waivers.filename());
+  const std::string waived_path =
+      LintCachePath("dir", "a.sv", kText, waived, "");
+  EXPECT_NE(waived_path, path);
+  ASSERT_TRUE(
+      verible::file::SetContents(waivers.filename(), "waive --rule=bar\n")
+          .ok());
+  EXPECT_NE(LintCachePath("dir", "a.sv", kText, waived, ""), waived_path);
+}
+
+TEST(LintCacheTest, StoreAndLoad) {
+  const std::string dir = verible::file::JoinPath(
+      testing::TempDir(), RandomFileBasename("lint_cache"));
+  ASSERT_TRUE(verible::file::CreateDir(dir).ok());
+  const std::string path =
+      LintCachePath(dir, "a.sv", kText, LinterConfiguration(), "");
+  EXPECT_EQ(LoadLintCacheEntry(path, kText).status().code(),
+            absl::StatusCode::kNotFound);
+
+  const std::vector<LintRuleStatus> statuses = MakeStatuses(kText);
+  ASSERT_TRUE(StoreLintCacheEntry(path, kText, statuses).ok());
+  const auto loaded = LoadLintCacheEntry(path, kText);
+  ASSERT_TRUE(loaded.ok()) << loaded.status();
+  ExpectSameStatuses(statuses, kText, *loaded, kText);
+}
+
+}  // namespace
+}  // namespace verilog
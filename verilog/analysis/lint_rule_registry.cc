@@ -27,6 +27,7 @@
 #include "common/util/container_util.h"
 #include "common/util/logging.h"
 #include "verilog/analysis/descriptions.h"
+#include "verilog/analysis/project_lint_rule.h"
 
 namespace verilog {
 namespace analysis {
@@ -119,7 +120,8 @@ bool IsRegisteredLintRule(const LintRuleId& rule_name) {
   return LintRuleRegistry<SyntaxTreeLintRule>::ContainsLintRule(rule_name) ||
          LintRuleRegistry<TokenStreamLintRule>::ContainsLintRule(rule_name) ||
          LintRuleRegistry<LineLintRule>::ContainsLintRule(rule_name) ||
-         LintRuleRegistry<TextStructureLintRule>::ContainsLintRule(rule_name);
+         LintRuleRegistry<TextStructureLintRule>::ContainsLintRule(rule_name) ||
+         LintRuleRegistry<ProjectLintRule>::ContainsLintRule(rule_name);
 }
 
 // The following functions are LintRule-type-specific:
@@ -159,6 +161,15 @@ std::unique_ptr<TextStructureLintRule> CreateTextStructureLintRule(
   return LintRuleRegistry<TextStructureLintRule>::CreateLintRule(rule_name);
 }
 
+std::vector<LintRuleId> RegisteredProjectRulesNames() {
+  return LintRuleRegistry<ProjectLintRule>::GetRegisteredRulesNames();
+}
+
+std::unique_ptr<ProjectLintRule> CreateProjectLintRule(
+    const LintRuleId& rule_name) {
+  return LintRuleRegistry<ProjectLintRule>::CreateLintRule(rule_name);
+}
+
 std::set<LintRuleId> GetAllRegisteredLintRuleNames() {
   std::set<LintRuleId> result;
   for (const auto name : RegisteredSyntaxTreeRulesNames()) {
@@ -173,6 +184,9 @@ std::set<LintRuleId> GetAllRegisteredLintRuleNames() {
   for (const auto name : RegisteredTextStructureRulesNames()) {
     result.insert(name);
   }
+  for (const auto name : RegisteredProjectRulesNames()) {
+    result.insert(name);
+  }
   return result;
 }
 
@@ -183,11 +197,13 @@ LintRuleDescriptionsMap GetAllRuleDescriptions() {
   LintRuleRegistry<TokenStreamLintRule>::GetRegisteredRuleDescriptions(&res);
   LintRuleRegistry<LineLintRule>::GetRegisteredRuleDescriptions(&res);
   LintRuleRegistry<TextStructureLintRule>::GetRegisteredRuleDescriptions(&res);
+  LintRuleRegistry<ProjectLintRule>::GetRegisteredRuleDescriptions(&res);
   return res;
 }
 
 // Explicit template class instantiations
 template class LintRuleRegisterer<LineLintRule>;
+template class LintRuleRegisterer<ProjectLintRule>;
 template class LintRuleRegisterer<SyntaxTreeLintRule>;
 template class LintRuleRegisterer<TextStructureLintRule>;
 template class LintRuleRegisterer<TokenStreamLintRule>;
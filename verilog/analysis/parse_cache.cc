@@ -0,0 +1,153 @@
+// Copyright 2017-2023 The Verible Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "verilog/analysis/parse_cache.h"
+
+#include <cstdint>
+#include <cstdlib>
+#include <memory>
+#include <sstream>
+#include <string>
+
+#include "absl/flags/flag.h"
+#include "absl/status/status.h"
+#include "absl/strings/str_cat.h"
+#include "absl/strings/string_view.h"
+#include "common/analysis/file_analyzer.h"
+#include "common/strings/mem_block.h"
+#include "common/text/syntax_tree_binary.h"
+#include "common/text/text_structure.h"
+#include "common/text/token_info.h"
+#include "common/util/file_util.h"
+#include "common/util/init_command_line.h"
+#include "common/util/range.h"
+#include "verilog/CST/verilog_nonterminals.h"
+#include "verilog/parser/verilog_token.h"
+#include "verilog/parser/verilog_token_enum.h"
+
+ABSL_FLAG(std::string, parse_cache_dir, "",
+          "If set, directory in which lexing and parsing results are cached, "
+          "keyed by file contents, parsing mode and tool version, so that "
+          "unchanged files are not parsed again.  Only results without "
+          "diagnostics are cached.  Several tools running at the same time "
+          "can share the directory.  If not set, the VERIBLE_PARSE_CACHE_DIR "
+          "environment variable is used, which thus enables caching in every "
+          "tool that parses files.  Entries are never evicted, so the "
+          "directory grows with every changed file and tool version; delete "
+          "it to clear the cache.  Builds without a repository version don't "
+          "notice parser changes; clear the directory after upgrading those.");
+
+namespace verilog {
+
+uint64_t StableHash(absl::string_view bytes) {
+  uint64_t hash = 0xcbf29ce484222325;
+  for (const char c : bytes) {
+    hash ^= static_cast<uint8_t>(c);
+    hash *= 0x100000001b3;
+  }
+  return hash;
+}
+
+static std::string ResolveParseCacheDir() {
+  std::string dir = absl::GetFlag(FLAGS_parse_cache_dir);
+  if (dir.empty()) {
+    const char* const env_dir = getenv("VERIBLE_PARSE_CACHE_DIR");
+    if (env_dir != nullptr) dir = env_dir;
+  }
+  return dir;
+}
+
+static std::string& ResolvedParseCacheDir() {
+  static std::string* const dir = new std::string(ResolveParseCacheDir());
+  return *dir;
+}
+
+const std::string& ParseCacheDir() { return ResolvedParseCacheDir(); }
+
+void ResetParseCacheDirForTesting() {
+  ResolvedParseCacheDir() = ResolveParseCacheDir();
+}
+
+std::string ParseCachePath(absl::string_view dir, absl::string_view text,
+                           absl::string_view mode,
+                           absl::string_view extension) {
+  const std::string version =
+      absl::StrCat(verible::GetRepositoryVersion(), "\n",
+                   verible::kSyntaxTreeBinaryVersion, "\n", mode);
+  return verible::file::JoinPath(
+      dir, absl::StrCat(absl::Hex(StableHash(text), absl::kZeroPad16), "-",
+                        absl::Hex(StableHash(version), absl::kZeroPad16),
+                        extension));
+}
+
+absl::Status LoadParseCacheEntry(absl::string_view path,
+                                 verible::FileAnalyzer* analyzer) {
+  if (!verible::file::FileExists(std::string(path)).ok()) {
+    return absl::NotFoundError(absl::StrCat(path, ": not in parse cache."));
+  }
+  // Memory-mapped, so suitably aligned.
+  const auto entry = verible::file::GetContentAsMemBlock(path);
+  if (!entry.ok()) return entry.status();
+  const auto view =
+      verible::SyntaxTreeBinaryView::Create((*entry)->AsStringView());
+  if (!view.ok()) return view.status();
+  // Guards against hash collisions, too.
+  if (view->Text() != analyzer->Data().Contents()) {
+    return absl::NotFoundError(
+        absl::StrCat(path, ": parse cache entry of a different text."));
+  }
+  return analyzer->Restore(*view);
+}
+
+absl::Status StoreParseCacheEntry(absl::string_view path,
+                                  const verible::TextStructureView& data) {
+  const absl::string_view base = data.Contents();
+  const verible::TokenSequence& tokens = data.TokenStream();
+  for (const verible::TokenInfo& token : tokens) {
+    if (!verible::IsSubRange(token.text(), base)) {
+      return absl::FailedPreconditionError(
+          "Can't cache tokens that are not part of the text.");
+    }
+  }
+  const std::less<const verible::TokenInfo*> before;
+  for (const auto& iter : data.GetTokenStreamView()) {
+    if (tokens.empty() || before(&*iter, &tokens.front()) ||
+        before(&tokens.back(), &*iter)) {
+      return absl::FailedPreconditionError(
+          "Can't cache filtered tokens that are not in the token stream.");
+    }
+  }
+
+  std::ostringstream stream;
+  verible::WriteSyntaxTreeBinary(
+      data,
+      [](std::ostream& stream, int e) {
+        stream << TokenTypeToString(static_cast<verilog_tokentype>(e));
+      },
+      [](std::ostream& stream, int e) {
+        stream << NodeEnumToString(static_cast<NodeEnum>(e));
+      },
+      &stream);
+
+  // Readers only ever see complete entries.  Other processes might write the
+  // same entry at the same time.
+  if (verible::file::SetContentsAtomically(path, stream.str()).ok()) {
+    return absl::OkStatus();
+  }
+  // The first entry creates the directory.
+  verible::file::CreateDir(verible::file::Dirname(path)).IgnoreError();
+  return verible::file::SetContentsAtomically(path, stream.str());
+}
+
+}  // namespace verilog
@@ -0,0 +1,84 @@
+// Copyright 2017-2023 The Verible Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// Opt-in on-disk cache of lexing and parsing results (--parse_cache_dir), so
+// that batch tools that run over the same, mostly unchanged, files again and
+// again don't re-parse them every time.
+//
+// Entries are binary exports of the analyzed text structure (see
+// common/text/syntax_tree_binary.h), one file per analyzed text, named after
+// a hash of the text, of the analysis mode and of the tool version.
+// Entries are written atomically (by renaming a temporary file that is unique
+// to the writing process and thread), so several tools, e.g. the language
+// server, lint and format run on the same files, can share a directory
+// without any locking, each reusing what the others parsed.  Setting the
+// VERIBLE_PARSE_CACHE_DIR environment variable enables the cache for all
+// tools that are not given --parse_cache_dir.  Stale entries are never
+// removed, so the directory grows without bound; just delete it to clear the
+// cache.
+
+#ifndef VERIBLE_VERILOG_ANALYSIS_PARSE_CACHE_H_
+#define VERIBLE_VERILOG_ANALYSIS_PARSE_CACHE_H_
+
+#include <cstdint>
+#include <string>
+
+#include "absl/flags/declare.h"
+#include "absl/status/status.h"
+#include "absl/strings/string_view.h"
+#include "common/analysis/file_analyzer.h"
+#include "common/text/text_structure.h"
+
+// Flag is declared for testing purposes.
+ABSL_DECLARE_FLAG(std::string, parse_cache_dir);
+
+namespace verilog {
+
+// Returns the directory of the parse cache (--parse_cache_dir, else the
+// VERIBLE_PARSE_CACHE_DIR environment variable), or an empty string if
+// caching is disabled.  Resolved once, on first use, as flags are parsed by
+// then; later changes of either are not noticed.
+const std::string& ParseCacheDir();
+
+// Resolves ParseCacheDir() again, for tests that change the flag or the
+// environment variable.  Not thread-safe.
+void ResetParseCacheDirForTesting();
+
+// Returns a hash of 'bytes' that, unlike absl::Hash, is the same in every
+// run (FNV-1a).  Cache entries are named after it.
+uint64_t StableHash(absl::string_view bytes);
+
+// Returns the path of the entry in cache directory 'dir' for 'text' analyzed
+// in 'mode', which is a description of everything else that the analysis
+// result depends on, like the preprocessor configuration.  Other results
+// derived from the text can be cached alongside, with their own 'extension'.
+std::string ParseCachePath(absl::string_view dir, absl::string_view text,
+                           absl::string_view mode,
+                           absl::string_view extension = ".vcst");
+
+// Restores the tokens and syntax tree of 'analyzer' from the cache entry
+// 'path', which must be one of the same text as analyzer->Data().Contents().
+// Returns NotFoundError if there is no such entry.
+absl::Status LoadParseCacheEntry(absl::string_view path,
+                                 verible::FileAnalyzer* analyzer);
+
+// Writes 'data' as cache entry 'path', creating its directory if needed.
+// Fails unless all tokens of 'data' are part of its text, and all filtered
+// tokens are from its token stream.
+absl::Status StoreParseCacheEntry(absl::string_view path,
+                                  const verible::TextStructureView& data);
+
+}  // namespace verilog
+
+#endif  // VERIBLE_VERILOG_ANALYSIS_PARSE_CACHE_H_
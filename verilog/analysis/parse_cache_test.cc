@@ -0,0 +1,210 @@
+// Copyright 2017-2023 The Verible Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "verilog/analysis/parse_cache.h"
+
+#include <cstdlib>
+#include <memory>
+#include <string>
+
+#include "absl/flags/flag.h"
+#include "absl/status/status.h"
+#include "absl/strings/string_view.h"
+#include "common/text/text_structure.h"
+#include "common/text/tree_compare.h"
+#include "common/util/file_util.h"
+#include "gtest/gtest.h"
+#include "verilog/analysis/verilog_analyzer.h"
+
+namespace verilog {
+namespace {
+
+using verible::file::testing::RandomFileBasename;
+
+class ParseCacheTest : public testing::Test {
+ protected:
+  void SetUp() override {
+    dir_ = verible::file::JoinPath(testing::TempDir(),
+                                   RandomFileBasename("parse_cache"));
+    ASSERT_TRUE(verible::file::CreateDir(dir_).ok());
+    absl::SetFlag(&FLAGS_parse_cache_dir, dir_);
+    ResetParseCacheDirForTesting();
+  }
+
+  void TearDown() override {
+    absl::SetFlag(&FLAGS_parse_cache_dir, "");
+    ResetParseCacheDirForTesting();
+  }
+
+  // Returns the number of entries in the cache.
+  size_t Entries() const {
+    const auto dir = verible::file::ListDir(dir_);
+    return dir.ok() ? dir->files.size() : 0;
+  }
+
+  std::string dir_;
+};
+
+constexpr absl::string_view kCode =
+    "module m;\n"
+    "  // comment\n"
+    "  initial $display(\"hello\");\n"
+    "  `FOO(a + b)\n"
+    "endmodule\n";
+
+void ExpectSameAnalysis(const VerilogAnalyzer& cached,
+                        const VerilogAnalyzer& parsed) {
+  EXPECT_TRUE(cached.LexStatus().ok());
+  EXPECT_TRUE(cached.ParseStatus().ok());
+  const verible::TextStructureView& a = cached.Data();
+  const verible::TextStructureView& b = parsed.Data();
+  EXPECT_EQ(a.Contents(), b.Contents());
+  ASSERT_EQ(a.TokenStream().size(), b.TokenStream().size());
+  for (size_t i = 0; i < a.TokenStream().size(); ++i) {
+    EXPECT_EQ(a.TokenStream()[i].token_enum(), b.TokenStream()[i].token_enum());
+    EXPECT_EQ(a.TokenStream()[i].left(a.Contents()),
+              b.TokenStream()[i].left(b.Contents()));
+    EXPECT_EQ(a.TokenStream()[i].text(), b.TokenStream()[i].text());
+  }
+  ASSERT_EQ(a.GetTokenStreamView().size(), b.GetTokenStreamView().size());
+  for (size_t i = 0; i < a.GetTokenStreamView().size(); ++i) {
+    EXPECT_EQ(a.GetTokenStreamView()[i] - a.TokenStream().begin(),
+              b.GetTokenStreamView()[i] - b.TokenStream().begin());
+  }
+  EXPECT_TRUE(verible::EqualTreesByEnumString(a.SyntaxTree().get(),
+                                              b.SyntaxTree().get()));
+}
+
+TEST_F(ParseCacheTest, AutomaticModeLoadsStoredResult) {
+  const auto parsed = VerilogAnalyzer::AnalyzeAutomaticMode(
+      kCode, "parsed.sv", VerilogPreprocess::Config());
+  ASSERT_TRUE(parsed->ParseStatus().ok());
+  EXPECT_FALSE(parsed->PreprocessorData().preprocessed_token_stream.empty());
+  EXPECT_EQ(Entries(), 1);
+
+  const auto cached = VerilogAnalyzer::AnalyzeAutomaticMode(
+      kCode, "cached.sv", VerilogPreprocess::Config());
+  // Nothing was preprocessed, so it came from the cache.
+  EXPECT_TRUE(cached->PreprocessorData().preprocessed_token_stream.empty());
+  ExpectSameAnalysis(*cached, *parsed);
+  EXPECT_EQ(Entries(), 1);
+}
+
+TEST_F(ParseCacheTest, KeyedByMode) {
+  VerilogAnalyzer parsed(kCode, "parsed.sv", VerilogPreprocess::Config());
+  ASSERT_TRUE(parsed.AnalyzeWithParseCache().ok());
+  EXPECT_EQ(Entries(), 1);
+
+  // Different analysis and different (cacheable) configuration.
+  const auto automatic = VerilogAnalyzer::AnalyzeAutomaticMode(
+      kCode, "auto.sv", VerilogPreprocess::Config());
+  EXPECT_EQ(Entries(), 2);
+  VerilogAnalyzer filtered(kCode, "filtered.sv", {.filter_branches = true});
+  ASSERT_TRUE(filtered.AnalyzeWithParseCache().ok());
+  EXPECT_EQ(Entries(), 3);
+
+  VerilogAnalyzer cached(kCode, "cached.sv", VerilogPreprocess::Config());
+  ASSERT_TRUE(cached.AnalyzeWithParseCache().ok());
+  EXPECT_TRUE(cached.PreprocessorData().preprocessed_token_stream.empty());
+  ExpectSameAnalysis(cached, parsed);
+  EXPECT_EQ(Entries(), 3);
+}
+
+TEST_F(ParseCacheTest, KeyedByContent) {
+  const auto first = VerilogAnalyzer::AnalyzeAutomaticMode(
+      kCode, "first.sv", VerilogPreprocess::Config());
+  const std::string changed = std::string(kCode) + "module n; endmodule\n";
+  const auto second = VerilogAnalyzer::AnalyzeAutomaticMode(
+      changed, "second.sv", VerilogPreprocess::Config());
+  EXPECT_FALSE(second->PreprocessorData().preprocessed_token_stream.empty());
+  EXPECT_EQ(second->Data().Contents(), changed);
+  EXPECT_EQ(Entries(), 2);
+}
+
+TEST_F(ParseCacheTest, SyntaxErrorsAreNotCached) {
+  constexpr absl::string_view kBadCode = "module m; wire; endmodule\n";
+  for (int i = 0; i < 2; ++i) {
+    const auto analyzer = VerilogAnalyzer::AnalyzeAutomaticMode(
+        kBadCode, "bad.sv", VerilogPreprocess::Config());
+    EXPECT_FALSE(analyzer->ParseStatus().ok());
+    EXPECT_FALSE(analyzer->GetRejectedTokens().empty());
+  }
+  EXPECT_EQ(Entries(), 0);
+}
+
+TEST_F(ParseCacheTest, ExpandedMacrosAreNotCached) {
+  VerilogAnalyzer analyzer(kCode, "expanded.sv", {.expand_macros = true});
+  analyzer.AnalyzeWithParseCache().IgnoreError();
+  EXPECT_EQ(Entries(), 0);
+}
+
+TEST_F(ParseCacheTest, PreprocessFallback) {
+  const auto parsed =
+      VerilogAnalyzer::AnalyzeAutomaticPreprocessFallback(kCode, "parsed.sv");
+  ASSERT_TRUE(parsed->ParseStatus().ok());
+  EXPECT_EQ(Entries(), 1);
+  const auto cached =
+      VerilogAnalyzer::AnalyzeAutomaticPreprocessFallback(kCode, "cached.sv");
+  EXPECT_TRUE(cached->PreprocessorData().preprocessed_token_stream.empty());
+  ExpectSameAnalysis(*cached, *parsed);
+}
+
+TEST_F(ParseCacheTest, IgnoresCorruptEntries) {
+  const std::string path = ParseCachePath(dir_, kCode, "auto");
+  ASSERT_TRUE(verible::file::SetContents(path, "VCST garbage").ok());
+  const auto analyzer = VerilogAnalyzer::AnalyzeAutomaticMode(
+      kCode, "corrupt.sv", VerilogPreprocess::Config());
+  EXPECT_TRUE(analyzer->ParseStatus().ok());
+  EXPECT_FALSE(analyzer->PreprocessorData().preprocessed_token_stream.empty());
+}
+
+TEST_F(ParseCacheTest, CreatesDirectory) {
+  const std::string dir = verible::file::JoinPath(dir_, "new");
+  absl::SetFlag(&FLAGS_parse_cache_dir, dir);
+  ResetParseCacheDirForTesting();
+  const auto parsed = VerilogAnalyzer::AnalyzeAutomaticMode(
+      kCode, "parsed.sv", VerilogPreprocess::Config());
+  ASSERT_TRUE(parsed->ParseStatus().ok());
+  const auto entries = verible::file::ListDir(dir);
+  ASSERT_TRUE(entries.ok()) << entries.status();
+  EXPECT_EQ(entries->files.size(), 1);
+}
+
+#ifndef _WIN32
+TEST(ParseCacheDirTest, FromEnvironmentUnlessFlag) {
+  EXPECT_EQ(ParseCacheDir(), "");
+  ASSERT_EQ(setenv("VERIBLE_PARSE_CACHE_DIR", "/env/cache", 1), 0);
+  EXPECT_EQ(ParseCacheDir(), "");  // Resolved already.
+  ResetParseCacheDirForTesting();
+  EXPECT_EQ(ParseCacheDir(), "/env/cache");
+  absl::SetFlag(&FLAGS_parse_cache_dir, "/flag/cache");
+  ResetParseCacheDirForTesting();
+  EXPECT_EQ(ParseCacheDir(), "/flag/cache");
+  absl::SetFlag(&FLAGS_parse_cache_dir, "");
+  unsetenv("VERIBLE_PARSE_CACHE_DIR");
+  ResetParseCacheDirForTesting();
+  EXPECT_EQ(ParseCacheDir(), "");
+}
+#endif
+
+TEST(ParseCachePathTest, DependsOnTextAndMode) {
+  const std::string path = ParseCachePath("dir", "text", "mode");
+  EXPECT_EQ(path, ParseCachePath("dir", "text", "mode"));
+  EXPECT_NE(path, ParseCachePath("dir", "text2", "mode"));
+  EXPECT_NE(path, ParseCachePath("dir", "text", "mode2"));
+  EXPECT_EQ(verible::file::Dirname(path), "dir");
+}
+
+}  // namespace
+}  // namespace verilog
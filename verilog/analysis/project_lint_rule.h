@@ -0,0 +1,69 @@
+// Copyright 2017-2023 The Verible Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// ProjectLintRule implements a lint rule that needs to know about more than
+// one file, e.g. whether a module is instantiated anywhere in a project, or
+// defined more than once.  Instead of each rule walking the whole project,
+// the files are parsed and the project's symbol table is built and resolved
+// once, and shared read-only by all project rules (ProjectLintContext).
+//
+// Files are visited in dependency levels (FileDependencies::CompileLevels()):
+// Lint() is called for the files that a file depends on before it is called
+// for that file, and concurrently for the files of one level.  Rules that
+// keep state across files must guard it accordingly.
+
+#ifndef VERIBLE_VERILOG_ANALYSIS_PROJECT_LINT_RULE_H_
+#define VERIBLE_VERILOG_ANALYSIS_PROJECT_LINT_RULE_H_
+
+#include <map>
+#include <vector>
+
+#include "common/analysis/lint_rule.h"
+#include "verilog/analysis/dependencies.h"
+#include "verilog/analysis/symbol_table.h"
+#include "verilog/analysis/verilog_project.h"
+
+namespace verilog {
+namespace analysis {
+
+// Read-only view of a linted project, shared by all project rules.
+struct ProjectLintContext {
+  const VerilogProject& project;
+
+  // Built and resolved symbol table of the project.
+  const SymbolTable& symbol_table;
+
+  // Dependencies between the files of the project, from 'symbol_table'.
+  const FileDependencies& dependencies;
+
+  // Root-level symbols of 'symbol_table' by the file that defines them.
+  const std::map<const VerilogSourceFile*, std::vector<const SymbolTableNode*>>&
+      root_symbols_by_file;
+};
+
+class ProjectLintRule : public verible::LintRule {
+ public:
+  ~ProjectLintRule() override = default;
+
+  // Analyzes 'file', one of the files of context.project, for violations.
+  // Violations are reported at tokens in the text of the file in which they
+  // are found, so that they can be told apart by file.
+  virtual void Lint(const ProjectLintContext& context,
+                    const VerilogSourceFile& file) = 0;
+};
+
+}  // namespace analysis
+}  // namespace verilog
+
+#endif  // VERIBLE_VERILOG_ANALYSIS_PROJECT_LINT_RULE_H_
@@ -0,0 +1,268 @@
+// Copyright 2017-2023 The Verible Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "verilog/analysis/structural_search.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "absl/container/flat_hash_set.h"
+#include "absl/status/status.h"
+#include "absl/status/statusor.h"
+#include "absl/strings/numbers.h"
+#include "absl/strings/str_cat.h"
+#include "absl/strings/str_join.h"
+#include "absl/strings/str_split.h"
+#include "absl/strings/string_view.h"
+#include "absl/strings/strip.h"
+#include "common/analysis/matcher/inner_match_handlers.h"
+#include "common/analysis/matcher/matcher.h"
+#include "common/analysis/matcher/matcher_builders.h"
+#include "common/analysis/syntax_tree_search.h"
+#include "common/text/concrete_syntax_leaf.h"
+#include "common/text/flat_syntax_tree.h"
+#include "common/text/symbol.h"
+#include "common/text/text_structure.h"
+#include "common/text/token_info.h"
+#include "common/text/tree_utils.h"
+#include "common/util/init_command_line.h"
+#include "common/util/thread_pool.h"
+#include "verilog/CST/verilog_nonterminals.h"
+#include "verilog/analysis/parse_cache.h"
+#include "verilog/analysis/verilog_project.h"
+#include "verilog/parser/verilog_lexer.h"
+#include "verilog/parser/verilog_token_classifications.h"
+#include "verilog/parser/verilog_token_enum.h"
+
+namespace verilog {
+
+using verible::SymbolKind;
+using verible::SymbolTag;
+
+// Changes whenever the format of serialized indexes does.
+static constexpr absl::string_view kMagic = "verible-structural-search-index-1";
+
+static bool IsIdentifierLeaf(const verible::Symbol& symbol) {
+  return symbol.Kind() == SymbolKind::kLeaf &&
+         IsIdentifierLike(static_cast<verilog_tokentype>(symbol.Tag().tag));
+}
+
+absl::StatusOr<SymbolTag> ParseSearchTag(absl::string_view name) {
+  for (int tag = static_cast<int>(NodeEnum::kUntagged);
+       tag < static_cast<int>(NodeEnum::kInvalidTag); ++tag) {
+    if (NodeEnumToString(static_cast<NodeEnum>(tag)) == name) {
+      return verible::NodeTag(static_cast<NodeEnum>(tag));
+    }
+  }
+  // Leaves are only searched by keywords and operators: identifiers are
+  // searched by their text, see StructuralQuery.
+  VerilogLexer lexer(name);
+  const verible::TokenInfo token = lexer.DoNextToken();
+  if (!token.isEOF() && token.text() == name &&
+      !IsIdentifierLike(static_cast<verilog_tokentype>(token.token_enum())) &&
+      lexer.DoNextToken().isEOF()) {
+    return verible::LeafTag(token.token_enum());
+  }
+  return absl::InvalidArgumentError(
+      absl::StrCat("\"", name,
+                   "\" is neither a syntax tree node tag (kSomething) nor a "
+                   "keyword or operator."));
+}
+
+// Returns true if the subtree of 'symbol' has all of 'identifiers'.
+static bool ContainsIdentifiers(const verible::Symbol& symbol,
+                                const std::vector<std::string>& identifiers) {
+  return std::all_of(
+      identifiers.begin(), identifiers.end(),
+      [&symbol](absl::string_view identifier) {
+        return verible::FindFirstSubtree(
+                   &symbol, [identifier](const verible::Symbol& s) {
+                     return IsIdentifierLeaf(s) &&
+                            verible::SymbolCastToLeaf(s).get().text() ==
+                                identifier;
+                   }) != nullptr;
+      });
+}
+
+std::vector<verible::TreeSearchMatch> SearchStructure(
+    const verible::Symbol& root, const StructuralQuery& query) {
+  const verible::matcher::DynamicTagMatchBuilder tagged(query.tag);
+  if (query.identifiers.empty()) {
+    return verible::SearchSyntaxTree(root, tagged());
+  }
+  const verible::matcher::Matcher contains_identifiers(
+      [&query](const verible::Symbol& symbol) {
+        return ContainsIdentifiers(symbol, query.identifiers);
+      },
+      verible::matcher::InnerMatchAll);
+  return verible::SearchSyntaxTree(root, tagged(contains_identifiers));
+}
+
+StructuralSearchIndex::Entry StructuralSearchIndex::IndexFile(
+    const VerilogSourceFile& file) {
+  Entry entry;
+  entry.content_hash = StableHash(file.GetContent());
+  const verible::TextStructureView* text_structure = file.GetTextStructure();
+  if (text_structure == nullptr || text_structure->SyntaxTree() == nullptr) {
+    return entry;
+  }
+  const verible::FlatSyntaxTree tree(*text_structure->SyntaxTree());
+  for (const verible::FlatSyntaxTree::Entry& symbol : tree.Entries()) {
+    entry.tags.insert(symbol.tag);
+  }
+  for (const verible::SyntaxTreeLeaf* leaf : tree.Leaves()) {
+    if (IsIdentifierLeaf(*leaf)) entry.identifiers.emplace(leaf->get().text());
+  }
+  return entry;
+}
+
+int StructuralSearchIndex::Update(const std::vector<VerilogSourceFile*>& files,
+                                  int num_threads,
+                                  std::vector<absl::Status>* statuses) {
+  // Files must be parsed by one thread only.
+  std::vector<VerilogSourceFile*> distinct;
+  absl::flat_hash_set<const VerilogSourceFile*> seen;
+  for (VerilogSourceFile* file : files) {
+    if (seen.insert(file).second) distinct.push_back(file);
+  }
+
+  // Only the slots of stale files are filled, in parallel.
+  std::vector<Entry> updates(distinct.size());
+  std::vector<char> stale(distinct.size(), false);
+  std::vector<absl::Status> parse_statuses(distinct.size());
+  verible::ThreadPool pool(num_threads > 1 ? num_threads - 1 : 0);
+  pool.ParallelFor(distinct.size(), [&](size_t i) {
+    VerilogSourceFile* file = distinct[i];
+    if (!file->is_parsed() && !file->Open().ok()) return;
+    const auto found = entries_.find(file->ReferencedPath());
+    if (found != entries_.end() &&
+        found->second.content_hash == StableHash(file->GetContent())) {
+      return;
+    }
+    parse_statuses[i] = file->Parse();
+    updates[i] = IndexFile(*file);
+    stale[i] = true;
+  });
+
+  int indexed = 0;
+  for (size_t i = 0; i < distinct.size(); ++i) {
+    if (!stale[i]) continue;
+    if (!parse_statuses[i].ok()) statuses->push_back(parse_statuses[i]);
+    entries_[std::string(distinct[i]->ReferencedPath())] =
+        std::move(updates[i]);
+    ++indexed;
+  }
+  return indexed;
+}
+
+bool StructuralSearchIndex::MayMatch(absl::string_view path,
+                                     const StructuralQuery& query) const {
+  const auto found = entries_.find(path);
+  if (found == entries_.end()) return true;
+  const Entry& entry = found->second;
+  if (!entry.tags.contains(query.tag)) return false;
+  return std::all_of(query.identifiers.begin(), query.identifiers.end(),
+                     [&entry](const std::string& identifier) {
+                       return entry.identifiers.contains(identifier);
+                     });
+}
+
+// Serialized indexes are lines of text: kMagic, the tool version, and three
+// lines per file:
+//   file <content hash> <path>
+//   tags <n|l><tag> ...
+//   identifiers <identifier> ...
+// Identifiers don't contain whitespace.  Tags and identifiers are sorted, so
+// that unchanged indexes serialize the same.
+std::string StructuralSearchIndex::Serialize() const {
+  std::string text = absl::StrCat(kMagic, "\n", "version ",
+                                  verible::GetRepositoryVersion(), "\n");
+  for (const auto& [path, entry] : entries_) {
+    std::vector<std::string> tags;
+    tags.reserve(entry.tags.size());
+    for (const SymbolTag& tag : entry.tags) {
+      tags.push_back(
+          absl::StrCat(tag.kind == SymbolKind::kNode ? "n" : "l", tag.tag));
+    }
+    std::sort(tags.begin(), tags.end());
+    std::vector<absl::string_view> identifiers(entry.identifiers.begin(),
+                                               entry.identifiers.end());
+    std::sort(identifiers.begin(), identifiers.end());
+    absl::StrAppend(&text, "file ", entry.content_hash, " ", path, "\n",
+                    "tags ", absl::StrJoin(tags, " "), "\n", "identifiers ",
+                    absl::StrJoin(identifiers, " "), "\n");
+  }
+  return text;
+}
+
+absl::Status StructuralSearchIndex::Deserialize(absl::string_view text) {
+  entries_.clear();
+  const auto corrupt = [this](absl::string_view why) {
+    entries_.clear();
+    return absl::InvalidArgumentError(
+        absl::StrCat("Corrupt structural search index: ", why));
+  };
+  std::vector<absl::string_view> lines = absl::StrSplit(text, '\n');
+  // The text ends with a newline.
+  if (lines.empty() || !lines.back().empty()) return corrupt("truncated");
+  lines.pop_back();
+  if (lines.size() < 2 || lines[0] != kMagic) return corrupt("bad header");
+  absl::string_view version = lines[1];
+  if (!absl::ConsumePrefix(&version, "version ")) {
+    return corrupt("missing version");
+  }
+  if (version != verible::GetRepositoryVersion()) {
+    return absl::FailedPreconditionError(
+        "Structural search index is from another version.");
+  }
+  if ((lines.size() - 2) % 3 != 0) return corrupt("truncated");
+
+  for (size_t i = 2; i < lines.size(); i += 3) {
+    absl::string_view file = lines[i];
+    absl::string_view tags = lines[i + 1];
+    absl::string_view identifiers = lines[i + 2];
+    Entry entry;
+    if (!absl::ConsumePrefix(&file, "file ") ||
+        !absl::ConsumePrefix(&tags, "tags") ||
+        !absl::ConsumePrefix(&identifiers, "identifiers")) {
+      return corrupt(absl::StrCat("bad entry at line ", i + 1));
+    }
+    const size_t space = file.find(' ');
+    if (space == absl::string_view::npos ||
+        !absl::SimpleAtoi(file.substr(0, space), &entry.content_hash)) {
+      return corrupt(absl::StrCat("bad content hash at line ", i + 1));
+    }
+    const absl::string_view path = file.substr(space + 1);
+    for (absl::string_view tag : absl::StrSplit(tags, ' ', absl::SkipEmpty())) {
+      int value;
+      if (tag.size() < 2 || (tag[0] != 'n' && tag[0] != 'l') ||
+          !absl::SimpleAtoi(tag.substr(1), &value)) {
+        return corrupt(absl::StrCat("bad tag at line ", i + 2));
+      }
+      entry.tags.insert(
+          {tag[0] == 'n' ? SymbolKind::kNode : SymbolKind::kLeaf, value});
+    }
+    for (absl::string_view identifier :
+         absl::StrSplit(identifiers, ' ', absl::SkipEmpty())) {
+      entry.identifiers.emplace(identifier);
+    }
+    entries_[std::string(path)] = std::move(entry);
+  }
+  return absl::OkStatus();
+}
+
+}  // namespace verilog
@@ -0,0 +1,103 @@
+// Copyright 2017-2023 The Verible Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// Structural search over the syntax trees of many files, e.g. all files of a
+// project: finds the symbols of a given tag that contain given identifiers,
+// like SearchSyntaxTree() does within one tree.
+//
+// StructuralSearchIndex records which tags and identifiers occur in each
+// file, so that a query only parses and searches the files that can have
+// matches.  Indexes can be saved and loaded again; only the files whose
+// content changed since are indexed again.
+
+#ifndef VERIBLE_VERILOG_ANALYSIS_STRUCTURAL_SEARCH_H_
+#define VERIBLE_VERILOG_ANALYSIS_STRUCTURAL_SEARCH_H_
+
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <string>
+#include <vector>
+
+#include "absl/container/flat_hash_set.h"
+#include "absl/status/status.h"
+#include "absl/status/statusor.h"
+#include "absl/strings/string_view.h"
+#include "common/analysis/syntax_tree_search.h"
+#include "common/text/symbol.h"
+#include "verilog/analysis/verilog_project.h"
+
+namespace verilog {
+
+// Matches the symbols tagged 'tag' whose subtrees contain all 'identifiers'.
+struct StructuralQuery {
+  verible::SymbolTag tag;
+  std::vector<std::string> identifiers;
+};
+
+// Returns the tag named 'name': either a NodeEnum, like "kAlwaysStatement",
+// or the text of a keyword or operator token, like "always_latch".
+absl::StatusOr<verible::SymbolTag> ParseSearchTag(absl::string_view name);
+
+// Returns the matches of 'query' in the tree 'root', in preorder.
+std::vector<verible::TreeSearchMatch> SearchStructure(
+    const verible::Symbol& root, const StructuralQuery& query);
+
+class StructuralSearchIndex {
+ public:
+  // Indexes the files that are not indexed yet, or whose content changed
+  // since they were, parsing them on up to 'num_threads' threads.  Files are
+  // left parsed, so that searching them does not parse them again.  Files
+  // that can't be read are skipped; syntax errors are appended to
+  // 'statuses', and the partial syntax trees are indexed.
+  // Returns the number of files that were indexed.
+  int Update(const std::vector<VerilogSourceFile*>& files, int num_threads,
+             std::vector<absl::Status>* statuses);
+
+  // Returns true unless the indexed file at 'path' can't have matches of
+  // 'query'.  Files that are not indexed might have matches.
+  bool MayMatch(absl::string_view path, const StructuralQuery& query) const;
+
+  // Number of indexed files.
+  size_t size() const { return entries_.size(); }
+
+  // Returns the index as text, to be read by Deserialize() of the same
+  // version of the tool.
+  std::string Serialize() const;
+
+  // Replaces the index with one that Serialize() returned.  Fails, leaving
+  // the index empty, if 'text' is corrupt or from another version.
+  absl::Status Deserialize(absl::string_view text);
+
+ private:
+  struct Entry {
+    // StableHash() of the indexed content.
+    uint64_t content_hash = 0;
+
+    // Tags of the symbols of the syntax tree.
+    absl::flat_hash_set<verible::SymbolTag> tags;
+
+    // Texts of the identifiers of the syntax tree.
+    absl::flat_hash_set<std::string> identifiers;
+  };
+
+  static Entry IndexFile(const VerilogSourceFile& file);
+
+  // Entries by referenced path of their file.
+  std::map<std::string, Entry, std::less<>> entries_;
+};
+
+}  // namespace verilog
+
+#endif  // VERIBLE_VERILOG_ANALYSIS_STRUCTURAL_SEARCH_H_
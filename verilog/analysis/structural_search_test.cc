@@ -0,0 +1,159 @@
+// Copyright 2017-2023 The Verible Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "verilog/analysis/structural_search.h"
+
+#include <string>
+#include <vector>
+
+#include "absl/status/status.h"
+#include "common/text/symbol.h"
+#include "common/text/text_structure.h"
+#include "common/text/tree_utils.h"
+#include "gtest/gtest.h"
+#include "verilog/CST/verilog_nonterminals.h"
+#include "verilog/analysis/verilog_project.h"
+#include "verilog/parser/verilog_token_enum.h"
+
+namespace verilog {
+namespace {
+
+constexpr absl::string_view kLatchCode =
+    "module latches;\n"
+    "  always_latch if (en) q <= d;\n"
+    "  always_ff @(posedge clk) r <= d;\n"
+    "endmodule\n";
+
+constexpr absl::string_view kInstancesCode =
+    "module top;\n"
+    "  foo u_foo();\n"
+    "  bar u_bar();\n"
+    "endmodule\n";
+
+TEST(ParseSearchTagTest, NodeEnumNames) {
+  const auto tag = ParseSearchTag("kModuleDeclaration");
+  ASSERT_TRUE(tag.ok()) << tag.status();
+  EXPECT_EQ(*tag, verible::NodeTag(NodeEnum::kModuleDeclaration));
+}
+
+TEST(ParseSearchTagTest, Keywords) {
+  const auto tag = ParseSearchTag("always_latch");
+  ASSERT_TRUE(tag.ok()) << tag.status();
+  EXPECT_EQ(*tag, verible::LeafTag(TK_always_latch));
+}
+
+TEST(ParseSearchTagTest, RejectsOtherNames) {
+  for (const absl::string_view name :
+       {"", "kNoSuchNode", "my_signal", "always_latch begin"}) {
+    EXPECT_FALSE(ParseSearchTag(name).ok()) << name;
+  }
+}
+
+TEST(SearchStructureTest, FindsTaggedSymbols) {
+  InMemoryVerilogSourceFile file("latches.sv", kLatchCode);
+  ASSERT_TRUE(file.Parse().ok());
+  const StructuralQuery query{verible::LeafTag(TK_always_latch), {}};
+  const auto matches =
+      SearchStructure(*file.GetTextStructure()->SyntaxTree(), query);
+  ASSERT_EQ(matches.size(), 1);
+  EXPECT_EQ(verible::StringSpanOfSymbol(*matches[0].match), "always_latch");
+}
+
+TEST(SearchStructureTest, FiltersByIdentifiers) {
+  InMemoryVerilogSourceFile file("top.sv", kInstancesCode);
+  ASSERT_TRUE(file.Parse().ok());
+  const StructuralQuery query{verible::NodeTag(NodeEnum::kDataDeclaration),
+                              {"foo"}};
+  const auto matches =
+      SearchStructure(*file.GetTextStructure()->SyntaxTree(), query);
+  ASSERT_EQ(matches.size(), 1);
+  EXPECT_EQ(verible::StringSpanOfSymbol(*matches[0].match), "foo u_foo();");
+}
+
+TEST(StructuralSearchIndexTest, SkipsFilesWithoutMatches) {
+  InMemoryVerilogSourceFile latches("latches.sv", kLatchCode);
+  InMemoryVerilogSourceFile top("top.sv", kInstancesCode);
+  StructuralSearchIndex index;
+  std::vector<absl::Status> statuses;
+  EXPECT_EQ(index.Update({&latches, &top}, 2, &statuses), 2);
+  EXPECT_TRUE(statuses.empty());
+  EXPECT_EQ(index.size(), 2);
+
+  const StructuralQuery latch_query{verible::LeafTag(TK_always_latch), {}};
+  EXPECT_TRUE(index.MayMatch("latches.sv", latch_query));
+  EXPECT_FALSE(index.MayMatch("top.sv", latch_query));
+
+  const StructuralQuery foo_query{
+      verible::NodeTag(NodeEnum::kDataDeclaration), {"foo"}};
+  EXPECT_FALSE(index.MayMatch("latches.sv", foo_query));
+  EXPECT_TRUE(index.MayMatch("top.sv", foo_query));
+  const StructuralQuery baz_query{
+      verible::NodeTag(NodeEnum::kDataDeclaration), {"foo", "baz"}};
+  EXPECT_FALSE(index.MayMatch("top.sv", baz_query));
+
+  // Files that are not indexed might have matches.
+  EXPECT_TRUE(index.MayMatch("other.sv", latch_query));
+}
+
+TEST(StructuralSearchIndexTest, OnlyIndexesChangedFiles) {
+  InMemoryVerilogSourceFile latches("latches.sv", kLatchCode);
+  InMemoryVerilogSourceFile top("top.sv", kInstancesCode);
+  StructuralSearchIndex index;
+  std::vector<absl::Status> statuses;
+  EXPECT_EQ(index.Update({&latches, &top}, 1, &statuses), 2);
+  EXPECT_EQ(index.Update({&latches, &top}, 1, &statuses), 0);
+
+  InMemoryVerilogSourceFile changed_top("top.sv", kLatchCode);
+  EXPECT_EQ(index.Update({&latches, &changed_top}, 1, &statuses), 1);
+  EXPECT_TRUE(
+      index.MayMatch("top.sv", {verible::LeafTag(TK_always_latch), {}}));
+  EXPECT_TRUE(statuses.empty());
+}
+
+TEST(StructuralSearchIndexTest, SerializeRoundTrip) {
+  InMemoryVerilogSourceFile latches("latches.sv", kLatchCode);
+  InMemoryVerilogSourceFile top("dir with spaces/top.sv", kInstancesCode);
+  StructuralSearchIndex index;
+  std::vector<absl::Status> statuses;
+  index.Update({&latches, &top}, 1, &statuses);
+  const std::string text = index.Serialize();
+
+  StructuralSearchIndex loaded;
+  ASSERT_TRUE(loaded.Deserialize(text).ok());
+  EXPECT_EQ(loaded.size(), 2);
+  EXPECT_EQ(loaded.Serialize(), text);
+  const StructuralQuery latch_query{verible::LeafTag(TK_always_latch), {}};
+  EXPECT_TRUE(loaded.MayMatch("latches.sv", latch_query));
+  EXPECT_FALSE(loaded.MayMatch("dir with spaces/top.sv", latch_query));
+
+  // Loaded entries of unchanged files are not indexed again.
+  EXPECT_EQ(loaded.Update({&latches, &top}, 1, &statuses), 0);
+}
+
+TEST(StructuralSearchIndexTest, RejectsCorruptText) {
+  InMemoryVerilogSourceFile latches("latches.sv", kLatchCode);
+  StructuralSearchIndex index;
+  std::vector<absl::Status> statuses;
+  index.Update({&latches}, 1, &statuses);
+  const std::string text = index.Serialize();
+
+  StructuralSearchIndex loaded;
+  EXPECT_FALSE(loaded.Deserialize("").ok());
+  EXPECT_FALSE(loaded.Deserialize(text.substr(0, text.size() - 1)).ok());
+  EXPECT_FALSE(loaded.Deserialize(text + "file 12\n").ok());
+  EXPECT_EQ(loaded.size(), 0);
+}
+
+}  // namespace
+}  // namespace verilog
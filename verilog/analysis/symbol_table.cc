@@ -14,28 +14,53 @@
 
 #include "verilog/analysis/symbol_table.h"
 
+#include <openssl/sha.h>
+
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <functional>
+#include <future>
 #include <iostream>
+#include <iterator>
+#include <map>
 #include <memory>
+#include <mutex>
+#include <set>
 #include <sstream>
 #include <stack>
+#include <string>
+#include <utility>
+#include <vector>
 
+#include "absl/container/flat_hash_map.h"
+#include "absl/container/flat_hash_set.h"
 #include "absl/status/status.h"
+#include "absl/strings/escaping.h"
+#include "absl/strings/str_cat.h"
 #include "absl/strings/str_format.h"
 #include "absl/strings/str_join.h"
 #include "absl/time/clock.h"
 #include "absl/time/time.h"
 #include "common/strings/display_utils.h"
+#include "common/strings/line_column_map.h"
 #include "common/text/concrete_syntax_leaf.h"
 #include "common/text/concrete_syntax_tree.h"
+#include "common/text/syntax_tree_index.h"
 #include "common/text/token_info.h"
 #include "common/text/tree_context_visitor.h"
 #include "common/text/tree_utils.h"
 #include "common/text/visitors.h"
 #include "common/util/enum_flags.h"
+#include "common/util/file_util.h"
 #include "common/util/logging.h"
+#include "common/util/range.h"
 #include "common/util/spacer.h"
+#include "common/util/thread_pool.h"
+#include "common/util/trace_events.h"
 #include "common/util/tree_operations.h"
 #include "common/util/value_saver.h"
+#include "common/util/varint_coding.h"
 #include "verilog/CST/class.h"
 #include "verilog/CST/declaration.h"
 #include "verilog/CST/functions.h"
@@ -170,8 +195,44 @@ static absl::Status DiagnoseMemberSymbolResolutionFailure(
                    context_name, "."));
 }
 
+// Returns the position of 'text' in 'file', which does not have to be parsed,
+// e.g. if its symbols were loaded from the cache.
+static verible::LineColumnRange RangeForText(const VerilogSourceFile& file,
+                                             absl::string_view text) {
+  if (const auto* text_structure = file.GetTextStructure()) {
+    return text_structure->GetRangeForText(text);
+  }
+  const absl::string_view contents = file.GetContent();
+  const verible::LineColumnMap line_column_map(contents);
+  const int offset = std::distance(contents.begin(), text.begin());
+  return {line_column_map.GetLineColAtOffset(contents, offset),
+          line_column_map.GetLineColAtOffset(contents, offset + text.length())};
+}
+
+// Diagnoses the definition of 'name' in 'source' in 'scope', which already
+// contains 'previous_symbol' by that name.
+static absl::Status DiagnoseSymbolAlreadyExists(
+    absl::string_view name, const VerilogSourceFile& source,
+    const SymbolTableNode& scope, const SymbolTableNode& previous_symbol) {
+  std::ostringstream here_print;
+  here_print << RangeForText(source, name);
+
+  std::ostringstream previous_print;
+  previous_print << RangeForText(*previous_symbol.Value().file_origin,
+                                 *previous_symbol.Key());
+
+  // TODO(hzeller): output in some structured form easy to use downstream.
+  return absl::AlreadyExistsError(
+      absl::StrCat(source.ReferencedPath(), ":", here_print.str(), " Symbol \"",
+                   name, "\" is already defined in the ",
+                   ContextFullPath(scope), " scope at ", previous_print.str()));
+}
+
+class ResolutionOrder;  // defined below
+
 static const SymbolTableNode* LookupSymbolUpwards(
-    const SymbolTableNode& context, absl::string_view symbol);
+    const SymbolTableNode& context, absl::string_view symbol,
+    ResolutionOrder* order = nullptr);
 
 class SymbolTable::Builder : public TreeContextVisitor {
  public:
@@ -180,7 +241,15 @@ class SymbolTable::Builder : public TreeContextVisitor {
       : source_(&source),
         token_context_(MakeTokenContext()),
         symbol_table_(symbol_table),
-        current_scope_(&symbol_table_->MutableRoot()) {}
+        current_scope_(&symbol_table_->MutableRoot()) {
+    const auto* text_structure = source.GetTextStructure();
+    const absl::string_view contents =
+        text_structure != nullptr ? text_structure->Contents() : "";
+    if (!symbol_table_->unit_contents_.emplace(&source, contents).second) {
+      // Building the same unit again duplicates all of its definitions.
+      symbol_table_->entangled_files_.insert(&source);
+    }
+  }
 
   std::vector<absl::Status> TakeDiagnostics() {
     return std::move(diagnostics_);
@@ -287,6 +356,9 @@ class SymbolTable::Builder : public TreeContextVisitor {
       case NodeEnum::kLPValue:
         HandlePossibleImplicitDeclaration(node);
         break;
+      case NodeEnum::kPackageImportItem:
+        DescendPackageImportItem(node);
+        break;
       case NodeEnum::kBindDirective:
         // TODO(#1241) Not handled right now.
         // TODO(#1255) Not handled right now.
@@ -379,6 +451,21 @@ class SymbolTable::Builder : public TreeContextVisitor {
     current_declared_class_info.parent_type.user_defined_type = base_type_ref;
   }
 
+  // Captures the package of a wildcard import ("import pkg::*;") as a
+  // reference of the current scope, see IsWildcardImport().  The members of
+  // the package are looked up through the scope's wildcard_imported_symbols.
+  void DescendPackageImportItem(const SyntaxTreeNode& import_item) {
+    if (GeImportedItemNameFromPackageImportItem(import_item) != nullptr ||
+        !Context().DirectParentsAre({NodeEnum::kPackageImportItemList,
+                                     NodeEnum::kPackageImportDeclaration})) {
+      // TODO: explicitly imported items, and exports.
+      Descend(import_item);
+      return;
+    }
+    const CaptureDependentReference capture(this);
+    Descend(import_item);
+  }
+
   // Traverse a subtree for a data type and collects type references
   // originating from the current context.
   // If the context is such that this type is used in a declaration,
@@ -842,8 +929,11 @@ class SymbolTable::Builder : public TreeContextVisitor {
       return ref.Empty() ? SymbolMetaType::kClass : SymbolMetaType::kTask;
     }
 
-    // TODO: import references bases must be resolved as
-    // SymbolMetaType::kPackage.
+    // Only wildcard imports are captured, see DescendPackageImportItem().
+    if (Context().DirectParentsAre(
+            {NodeEnum::kScopePrefix, NodeEnum::kPackageImportItem})) {
+      return SymbolMetaType::kPackage;
+    }
     if (Context().DirectParentIs(NodeEnum::kActualNamedPort)) {
       return SymbolMetaType::kDataNetVariableInstance;
     }
@@ -1207,19 +1297,14 @@ class SymbolTable::Builder : public TreeContextVisitor {
 
   void DiagnoseSymbolAlreadyExists(absl::string_view name,
                                    const SymbolTableNode& previous_symbol) {
-    std::ostringstream here_print;
-    here_print << source_->GetTextStructure()->GetRangeForText(name);
-
-    std::ostringstream previous_print;
-    previous_print << previous_symbol.Value()
-                          .file_origin->GetTextStructure()
-                          ->GetRangeForText(*previous_symbol.Key());
-
-    // TODO(hzeller): output in some structured form easy to use downstream.
-    diagnostics_.push_back(absl::AlreadyExistsError(absl::StrCat(
-        source_->ReferencedPath(), ":", here_print.str(), " Symbol \"", name,
-        "\" is already defined in the ", CurrentScopeFullPath(), " scope at ",
-        previous_print.str())));
+    if (previous_symbol.Value().file_origin != source_) {
+      // The symbols of both files are merged in the previous definition.
+      symbol_table_->entangled_files_.insert(source_);
+      symbol_table_->entangled_files_.insert(
+          previous_symbol.Value().file_origin);
+    }
+    diagnostics_.push_back(verilog::DiagnoseSymbolAlreadyExists(
+        name, *source_, *current_scope_, previous_symbol));
   }
 
   absl::StatusOr<SymbolTableNode*> LookupOrInjectOutOfLineDefinition(
@@ -1240,6 +1325,9 @@ class SymbolTable::Builder : public TreeContextVisitor {
     const auto outer_scope_or_status =
         ref.ResolveOnlyBaseLocally(current_scope_);
     if (!outer_scope_or_status.ok()) {
+      // The outer scope might be defined by a translation unit that is built
+      // into another symbol table.
+      symbol_table_->missing_out_of_line_scope_ = true;
       return outer_scope_or_status.status();
     }
     SymbolTableNode* outer_scope = ABSL_DIE_IF_NULL(*outer_scope_or_status);
@@ -1339,6 +1427,13 @@ class SymbolTable::Builder : public TreeContextVisitor {
     VerilogProject* project = symbol_table_->project_;
     if (project == nullptr) return;  // Without project, ignore.
 
+    // Other translation units might be built concurrently, and open or parse
+    // the same included file.
+    std::unique_lock<std::mutex> include_lock;
+    if (symbol_table_->include_lock_ != nullptr) {
+      include_lock =
+          std::unique_lock<std::mutex>(*symbol_table_->include_lock_);
+    }
     const auto status_or_file = project->OpenIncludedFile(filename_unquoted);
     if (!status_or_file.ok()) {
       diagnostics_.push_back(status_or_file.status());
@@ -1351,6 +1446,7 @@ class SymbolTable::Builder : public TreeContextVisitor {
     VLOG(3) << "opened include file: " << included_file->ResolvedPath();
 
     const auto parse_status = included_file->Parse();
+    if (include_lock.owns_lock()) include_lock.unlock();
     if (!parse_status.ok()) {
       diagnostics_.push_back(parse_status);
       // For now, don't bother attempting to parse a partial syntax tree.
@@ -1361,6 +1457,11 @@ class SymbolTable::Builder : public TreeContextVisitor {
     // Depending on application, one may wish to avoid re-processing the same
     // included file.  If desired, add logic to return early here.
 
+    // Symbols from the included file are added as if they were defined in
+    // the including file.
+    symbol_table_->entangled_files_.insert(source_);
+    symbol_table_->entangled_files_.insert(included_file);
+
     {  // Traverse included file's syntax tree.
       const ValueSaver<const VerilogSourceFile*> includer(&source_,
                                                           included_file);
@@ -1561,9 +1662,88 @@ std::ostream& operator<<(std::ostream& stream,
   return stream << *dep_refs.components;
 }
 
+// Keeps the results of resolving reference trees concurrently the same as
+// those of resolving them one after another, in the order of
+// SymbolTable::Resolve().
+// Resolving a reference tree can depend on what references of other trees
+// resolved to: the declared types of variables, and base classes, for member
+// lookups.  One after another, those are only resolved if their tree comes
+// first.
+class ResolutionOrder {
+ public:
+  // A component that is the declared or parent type of a symbol.
+  struct TypeReference {
+    // Index of the component's reference tree in the order of resolution.
+    size_t tree;
+    // What the component was resolved to, before resolving any tree.
+    const SymbolTableNode* initial;
+  };
+  using TypeReferenceMap =
+      absl::flat_hash_map<const ReferenceComponentNode*, TypeReference>;
+
+  // 'tree' is the index of the tree to resolve.  If 'completed' is given,
+  // it tells which trees were completely resolved, and those which were not
+  // might be resolved concurrently.  Otherwise, all preceding trees were
+  // resolved.
+  ResolutionOrder(const TypeReferenceMap& type_references, size_t tree,
+                  const std::vector<char>* completed)
+      : type_references_(&type_references),
+        tree_(tree),
+        completed_(completed) {}
+
+  // On demand: types that are not bound yet are resolved by 'resolve_type'
+  // when they are needed, regardless of the order of their trees.
+  explicit ResolutionOrder(
+      std::function<void(const ReferenceComponentNode&)> resolve_type)
+      : type_references_(nullptr),
+        tree_(0),
+        completed_(nullptr),
+        resolve_type_(std::move(resolve_type)) {}
+
+  // Returns what 'type' is resolved to, for the tree being resolved.
+  const SymbolTableNode* ResolvedSymbol(const ReferenceComponentNode& type) {
+    if (resolve_type_) {
+      if (type.Value().resolved_symbol == nullptr) resolve_type_(type);
+      return type.Value().resolved_symbol;
+    }
+    const auto found = type_references_->find(&type);
+    // Types that are in no tree, bound already, or in this tree.
+    if (found == type_references_->end() || found->second.initial != nullptr ||
+        found->second.tree == tree_) {
+      return type.Value().resolved_symbol;
+    }
+    // Following trees are resolved later.
+    if (found->second.tree > tree_) return nullptr;
+    // Not read while it might be written concurrently.
+    if (completed_ != nullptr && !(*completed_)[found->second.tree]) {
+      blocked_ = true;
+      return nullptr;
+    }
+    return type.Value().resolved_symbol;
+  }
+
+  // True if a preceding tree was needed, but not completely resolved yet.
+  // Then this tree has to be resolved again, after that one.
+  bool blocked() const { return blocked_; }
+
+ private:
+  const TypeReferenceMap* const type_references_;
+  const size_t tree_;
+  const std::vector<char>* const completed_;
+  const std::function<void(const ReferenceComponentNode&)> resolve_type_;
+  bool blocked_ = false;
+};
+
+// Returns what 'type' is resolved to, as seen in 'order' (if not nullptr).
+static const SymbolTableNode* ResolvedTypeSymbol(
+    const ReferenceComponentNode& type, ResolutionOrder* order) {
+  if (order == nullptr) return type.Value().resolved_symbol;
+  return order->ResolvedSymbol(type);
+}
+
 // Follow type aliases through canonical type.
 static const SymbolTableNode* CanonicalizeTypeForMemberLookup(
-    const SymbolTableNode& context) {
+    const SymbolTableNode& context, ResolutionOrder* order) {
   VLOG(2) << __FUNCTION__;
   const SymbolTableNode* current_context = &context;
   do {
@@ -1575,7 +1755,7 @@ static const SymbolTableNode* CanonicalizeTypeForMemberLookup(
       // Could be a primitive type.
       return nullptr;
     }
-    current_context = ref_type->Value().resolved_symbol;
+    current_context = ResolvedTypeSymbol(*ref_type, order);
     // TODO: We haven't guaranteed that typedefs have been resolved in order,
     // so these will need to be resolved on-demand in the future.
   } while (current_context != nullptr);
@@ -1587,7 +1767,8 @@ static const SymbolTableNode* CanonicalizeTypeForMemberLookup(
 
 // Search through base class's scopes for a symbol.
 static const SymbolTableNode* LookupSymbolThroughInheritedScopes(
-    const SymbolTableNode& context, absl::string_view symbol) {
+    const SymbolTableNode& context, absl::string_view symbol,
+    ResolutionOrder* order) {
   const SymbolTableNode* current_context = &context;
   do {
     // Look directly in current scope.
@@ -1602,26 +1783,35 @@ static const SymbolTableNode* LookupSymbolThroughInheritedScopes(
         current_context->Value().parent_type.user_defined_type;
     if (base_type == nullptr) break;
 
-    const SymbolTableNode* resolved_base = base_type->Value().resolved_symbol;
+    const SymbolTableNode* resolved_base =
+        ResolvedTypeSymbol(*base_type, order);
     // TODO: attempt to resolve on-demand because resolve ordering is not
     // guaranteed.
     if (resolved_base == nullptr) return nullptr;
 
     // base type could be a typedef, so canonicalize
-    current_context = CanonicalizeTypeForMemberLookup(*resolved_base);
+    current_context = CanonicalizeTypeForMemberLookup(*resolved_base, order);
   } while (current_context != nullptr);
   return nullptr;  // resolution failed
 }
 
-// Search up-scope, stopping at the first symbol found in the nearest scope.
+// Search up-scope, stopping at the first symbol found in the nearest scope,
+// or imported into it.
 static const SymbolTableNode* LookupSymbolUpwards(
-    const SymbolTableNode& context, absl::string_view symbol) {
+    const SymbolTableNode& context, absl::string_view symbol,
+    ResolutionOrder* order) {
   const SymbolTableNode* current_context = &context;
   do {
     const SymbolTableNode* found =
-        LookupSymbolThroughInheritedScopes(*current_context, symbol);
+        LookupSymbolThroughInheritedScopes(*current_context, symbol, order);
     if (found != nullptr) return found;
 
+    const auto& imported = current_context->Value().wildcard_imported_symbols;
+    if (!imported.empty()) {
+      const auto found_imported = imported.find(symbol);
+      if (found_imported != imported.end()) return found_imported->second;
+    }
+
     // Point to next enclosing scope.
     current_context = current_context->Parent();
   } while (current_context != nullptr);
@@ -1656,11 +1846,12 @@ static void ResolveReferenceComponentNodeLocal(ReferenceComponentNode* node,
 
 static void ResolveUnqualifiedName(ReferenceComponent* component,
                                    const SymbolTableNode& context,
-                                   std::vector<absl::Status>* diagnostics) {
+                                   std::vector<absl::Status>* diagnostics,
+                                   ResolutionOrder* order) {
   VLOG(2) << __FUNCTION__ << ": " << component;
   const absl::string_view key(component->identifier);
   // Find the first symbol whose name matches, without regard to its metatype.
-  const SymbolTableNode* resolved = LookupSymbolUpwards(context, key);
+  const SymbolTableNode* resolved = LookupSymbolUpwards(context, key, order);
   if (resolved == nullptr) {
     diagnostics->emplace_back(
         DiagnoseUnqualifiedSymbolResolutionFailure(key, context));
@@ -1698,12 +1889,13 @@ static void ResolveImmediateMember(ReferenceComponent* component,
 
 static void ResolveDirectMember(ReferenceComponent* component,
                                 const SymbolTableNode& context,
-                                std::vector<absl::Status>* diagnostics) {
+                                std::vector<absl::Status>* diagnostics,
+                                ResolutionOrder* order) {
   VLOG(2) << __FUNCTION__ << ": " << component;
 
   // Canonicalize context if it an alias.
   const SymbolTableNode* canonical_context =
-      CanonicalizeTypeForMemberLookup(context);
+      CanonicalizeTypeForMemberLookup(context, order);
   if (canonical_context == nullptr) {
     // TODO: diagnostic could be improved by following each typedef indirection.
     diagnostics->push_back(absl::InvalidArgumentError(
@@ -1714,7 +1906,7 @@ static void ResolveDirectMember(ReferenceComponent* component,
 
   const absl::string_view key(component->identifier);
   const auto* found =
-      LookupSymbolThroughInheritedScopes(*canonical_context, key);
+      LookupSymbolThroughInheritedScopes(*canonical_context, key, order);
   if (found == nullptr) {
     diagnostics->emplace_back(
         DiagnoseMemberSymbolResolutionFailure(key, *canonical_context));
@@ -1733,9 +1925,10 @@ static void ResolveDirectMember(ReferenceComponent* component,
 // Dependent (parent) nodes must already be resolved before attempting to
 // resolve children references (guaranteed by calling this in a pre-order
 // traversal).
+// If 'order' is given, it tells what references of other trees resolved to.
 static void ResolveReferenceComponentNode(
     ReferenceComponentNode* node, const SymbolTableNode& context,
-    std::vector<absl::Status>* diagnostics) {
+    std::vector<absl::Status>* diagnostics, ResolutionOrder* order) {
   ReferenceComponent& component(node->Value());
   VLOG(2) << __FUNCTION__ << ": " << component;
   if (component.resolved_symbol != nullptr) return;  // already bound
@@ -1744,7 +1937,7 @@ static void ResolveReferenceComponentNode(
     case ReferenceType::kUnqualified: {
       // root node: lookup this symbol from its context upward
       CHECK(node->Parent() == nullptr);
-      ResolveUnqualifiedName(&component, context, diagnostics);
+      ResolveUnqualifiedName(&component, context, diagnostics, order);
       break;
     }
     case ReferenceType::kImmediate: {
@@ -1758,7 +1951,7 @@ static void ResolveReferenceComponentNode(
       const SymbolTableNode* parent_scope = parent_component.resolved_symbol;
       if (parent_scope == nullptr) return;  // leave this subtree unresolved
 
-      ResolveDirectMember(&component, *parent_scope, diagnostics);
+      ResolveDirectMember(&component, *parent_scope, diagnostics, order);
       break;
     }
     case ReferenceType::kMemberOfTypeOfParent: {
@@ -1792,10 +1985,10 @@ static void ResolveReferenceComponentNode(
       // thus, not guaranteed to have been resolved first.
       // TODO(fangism): resolve on-demand
       const SymbolTableNode* type_scope =
-          type_info.user_defined_type->Value().resolved_symbol;
+          ResolvedTypeSymbol(*type_info.user_defined_type, order);
       if (type_scope == nullptr) return;
 
-      ResolveDirectMember(&component, *type_scope, diagnostics);
+      ResolveDirectMember(&component, *type_scope, diagnostics, order);
       break;
     }
   }
@@ -1821,7 +2014,8 @@ void DependentReferences::Resolve(
   // hence a pre-order traversal.
   ApplyPreOrder(*components,
                 [&context, diagnostics](ReferenceComponentNode& node) {
-                  ResolveReferenceComponentNode(&node, context, diagnostics);
+                  ResolveReferenceComponentNode(&node, context, diagnostics,
+                                                /*order=*/nullptr);
                   // TODO: minor optimization, when resolution for a node fails,
                   // skip checking that node's subtree; early terminate.
                 });
@@ -2009,18 +2203,914 @@ void SymbolTable::CheckIntegrity() const {
       [=](const SymbolInfo& s) { s.VerifySymbolTableRoot(root); });
 }
 
-void SymbolTable::Resolve(std::vector<absl::Status>* diagnostics) {
+// A reference tree, and the scope in which it appeared.
+struct ReferenceTree {
+  const SymbolTableNode* context;
+  const DependentReferences* references;
+};
+
+// Resolves 'tree' like DependentReferences::Resolve(), as seen in 'order'.
+// Returns false if 'order' blocked the resolution, in which case all
+// components that were resolved are unbound again.
+static bool ResolveReferenceTree(const ReferenceTree& tree,
+                                 ResolutionOrder* order,
+                                 std::vector<absl::Status>* diagnostics) {
+  std::vector<ReferenceComponent*> newly_resolved;
+  ApplyPreOrder(*tree.references->components,
+                [&](ReferenceComponentNode& node) {
+                  if (order->blocked()) return;
+                  ReferenceComponent& component = node.Value();
+                  if (component.resolved_symbol != nullptr) return;
+                  ResolveReferenceComponentNode(&node, *tree.context,
+                                                diagnostics, order);
+                  if (component.resolved_symbol != nullptr) {
+                    newly_resolved.push_back(&component);
+                  }
+                });
+  if (!order->blocked()) return true;
+  for (ReferenceComponent* component : newly_resolved) {
+    component->resolved_symbol = nullptr;
+  }
+  return false;
+}
+
+// Diagnostic of construction or resolution stopped by SetIsCancelled().
+static absl::Status SymbolTableCancelled(absl::string_view what) {
+  return absl::CancelledError(absl::StrCat(what, " cancelled."));
+}
+
+// Diagnostics of resolving reference trees, by index of the tree.
+using TreeDiagnostics = std::vector<std::pair<size_t, absl::Status>>;
+
+// Resolves all references below 'root' with the same results as
+// SymbolInfo::Resolve() on every symbol in pre-order, on 'num_threads'
+// threads.
+// References that depend on preceding trees that are not resolved yet are
+// resolved in later rounds.  When a round resolves less than a quarter of
+// its trees (e.g. long chains of typedefs), the rest is resolved one after
+// another.
+// Returns false if 'is_cancelled' stopped resolution early.
+static bool ResolveConcurrently(const SymbolTableNode& root, int num_threads,
+                                const std::function<bool()>& is_cancelled,
+                                std::vector<absl::Status>* diagnostics) {
+  const auto cancelled = [&is_cancelled]() {
+    return is_cancelled && is_cancelled();
+  };
+  std::vector<ReferenceTree> trees;
+  absl::flat_hash_map<const ReferenceComponentNode*, size_t> tree_of_root;
+  root.ApplyPreOrder([&](const SymbolTableNode& node) {
+    for (const auto& ref : node.Value().local_references_to_bind) {
+      if (ref.Empty()) continue;
+      tree_of_root.emplace(ref.components.get(), trees.size());
+      trees.push_back({&node, &ref});
+    }
+  });
+  ResolutionOrder::TypeReferenceMap type_references;
+  const auto add_type_reference = [&](const ReferenceComponentNode* type) {
+    if (type == nullptr) return;
+    const ReferenceComponentNode* tree_root = type;
+    while (tree_root->Parent() != nullptr) tree_root = tree_root->Parent();
+    const auto found = tree_of_root.find(tree_root);
+    if (found == tree_of_root.end()) return;  // never resolved
+    type_references.emplace(type, ResolutionOrder::TypeReference{
+                                      found->second,
+                                      type->Value().resolved_symbol});
+  };
+  root.ApplyPreOrder([&](const SymbolInfo& info) {
+    add_type_reference(info.declared_type.user_defined_type);
+    add_type_reference(info.parent_type.user_defined_type);
+  });
+
+  // What each worker resolved of a range of trees.
+  struct Round {
+    TreeDiagnostics diagnostics;
+    std::vector<size_t> blocked;
+  };
+  TreeDiagnostics tree_diagnostics;
+  std::vector<char> completed(trees.size(), false);
+  std::vector<size_t> remaining(trees.size());
+  for (size_t i = 0; i < trees.size(); ++i) remaining[i] = i;
+  verible::ThreadPool pool(num_threads);
+  size_t rounds = 0;
+  bool was_cancelled = false;
+  while (!remaining.empty() && !was_cancelled) {
+    ++rounds;
+    // More ranges than threads balance the load.
+    const size_t num_ranges =
+        std::min<size_t>(remaining.size(), 4 * num_threads);
+    std::vector<std::future<Round>> results;
+    results.reserve(num_ranges);
+    for (size_t r = 0; r < num_ranges; ++r) {
+      const size_t begin = remaining.size() * r / num_ranges;
+      const size_t end = remaining.size() * (r + 1) / num_ranges;
+      results.push_back(pool.ExecAsync<Round>([&, begin, end] {
+        VERIBLE_TRACE_SCOPE("symbol-table", "resolve-references");
+        Round round;
+        std::vector<absl::Status> statuses;
+        for (size_t i = begin; i < end; ++i) {
+          if (cancelled()) break;
+          const size_t tree = remaining[i];
+          ResolutionOrder order(type_references, tree, &completed);
+          statuses.clear();
+          if (!ResolveReferenceTree(trees[tree], &order, &statuses)) {
+            round.blocked.push_back(tree);
+            continue;
+          }
+          for (auto& status : statuses) {
+            round.diagnostics.emplace_back(tree, std::move(status));
+          }
+        }
+        return round;
+      }));
+    }
+    std::vector<size_t> blocked;
+    for (auto& result : results) {
+      Round round = result.get();
+      std::move(round.diagnostics.begin(), round.diagnostics.end(),
+                std::back_inserter(tree_diagnostics));
+      blocked.insert(blocked.end(), round.blocked.begin(),
+                     round.blocked.end());
+    }
+    // Trees skipped by cancelled workers are left unresolved.
+    was_cancelled = cancelled();
+    // Workers are done, so this is not read concurrently.
+    for (const size_t tree : remaining) completed[tree] = true;
+    for (const size_t tree : blocked) completed[tree] = false;
+
+    const bool little_progress =
+        4 * (remaining.size() - blocked.size()) < remaining.size();
+    remaining.swap(blocked);
+    if (little_progress) break;
+  }
+
+  // The remaining trees are resolved in order, after all preceding ones.
+  std::vector<absl::Status> statuses;
+  for (const size_t tree : remaining) {
+    if (was_cancelled || cancelled()) {
+      was_cancelled = true;
+      break;
+    }
+    ResolutionOrder order(type_references, tree, /*completed=*/nullptr);
+    statuses.clear();
+    ResolveReferenceTree(trees[tree], &order, &statuses);
+    for (auto& status : statuses) {
+      tree_diagnostics.emplace_back(tree, std::move(status));
+    }
+  }
+
+  // Diagnostics of each tree are in order already.
+  std::stable_sort(
+      tree_diagnostics.begin(), tree_diagnostics.end(),
+      [](const TreeDiagnostics::value_type& left,
+         const TreeDiagnostics::value_type& right) {
+        return left.first < right.first;
+      });
+  for (auto& diagnostic : tree_diagnostics) {
+    diagnostics->push_back(std::move(diagnostic.second));
+  }
+  VLOG(1) << "Resolved " << trees.size() << " reference trees on "
+          << num_threads << " threads in " << rounds << " rounds, "
+          << remaining.size() << " of them one after another"
+          << (was_cancelled ? " (cancelled)." : ".");
+  return !was_cancelled;
+}
+
+// Returns true if 'ref' is the package of a wildcard import, see
+// Builder::DescendPackageImportItem().
+static bool IsWildcardImport(const DependentReferences& ref) {
+  const ReferenceComponentNode& base = *ref.components;
+  return is_leaf(base) &&
+         base.Value().required_metatype == SymbolMetaType::kPackage;
+}
+
+void SymbolTable::IndexWildcardImports() {
+  const SymbolTableNode& root = symbol_table_root_;
+  symbol_table_root_.ApplyPreOrder([&root](SymbolInfo& info) {
+    info.wildcard_imported_symbols.clear();
+    for (const auto& ref : info.local_references_to_bind) {
+      if (ref.Empty() || !IsWildcardImport(ref)) continue;
+      // Packages are only declared in the root scope, so this does not
+      // depend on the order in which references are resolved.
+      const auto package = root.Find(ref.components->Value().identifier);
+      if (package == root.end() ||
+          package->second.Value().metatype != SymbolMetaType::kPackage) {
+        continue;  // Diagnosed when resolving 'ref'.
+      }
+      for (const auto& [name, member] : package->second) {
+        info.wildcard_imported_symbols.emplace(name, &member);
+      }
+    }
+  });
+}
+
+void SymbolTable::Resolve(std::vector<absl::Status>* diagnostics,
+                          int num_threads) {
+  VERIBLE_TRACE_SCOPE("symbol-table", "resolve");
   const absl::Time start = absl::Now();
-  symbol_table_root_.ApplyPreOrder(
-      [=](SymbolTableNode& node) { node.Value().Resolve(node, diagnostics); });
+  IndexWildcardImports();
+  bool completed = true;
+  if (num_threads > 1 || !cache_directory_.empty()) {
+    completed = ResolveConcurrently(symbol_table_root_, num_threads,
+                                    is_cancelled_, diagnostics);
+  } else {
+    symbol_table_root_.ApplyPreOrder([&](SymbolTableNode& node) {
+      if (!completed) return;
+      if (Cancelled()) {
+        completed = false;
+        return;
+      }
+      node.Value().Resolve(node, diagnostics);
+    });
+  }
+  if (!completed) {
+    diagnostics->push_back(SymbolTableCancelled("Resolving symbols"));
+  }
   VLOG(1) << "SymbolTable::Resolve took " << (absl::Now() - start);
 }
 
+const ReferenceComponent* SymbolTable::ResolveReferenceAt(
+    const char* position, std::vector<absl::Status>* diagnostics) {
+  static constexpr std::less<const char*> before;
+  // Scope of each reference tree, and the component at 'position'.
+  absl::flat_hash_map<const ReferenceComponentNode*, ReferenceTree> trees;
+  const ReferenceComponentNode* target = nullptr;
+  symbol_table_root_.ApplyPreOrder([&](const SymbolTableNode& node) {
+    for (const auto& ref : node.Value().local_references_to_bind) {
+      if (ref.Empty()) continue;
+      trees.emplace(ref.components.get(), ReferenceTree{&node, &ref});
+      if (target != nullptr) continue;
+      ApplyPreOrder(*ref.components, [&](const ReferenceComponentNode& c) {
+        const absl::string_view identifier = c.Value().identifier;
+        if (!before(position, identifier.data()) &&
+            before(position, identifier.data() + identifier.size())) {
+          target = &c;
+        }
+      });
+    }
+  });
+  if (target == nullptr) return nullptr;
+  IndexWildcardImports();
+
+  // Resolves the components that 'node' depends on in its tree, then 'node',
+  // and the types that lookups go through, recursively.
+  absl::flat_hash_set<const ReferenceComponentNode*> visited;
+  std::function<void(const ReferenceComponentNode&)> resolve_node;
+  ResolutionOrder order(
+      [&resolve_node](const ReferenceComponentNode& type) {
+        resolve_node(type);
+      });
+  resolve_node = [&](const ReferenceComponentNode& node) {
+    if (node.Value().resolved_symbol != nullptr) return;
+    // Cyclic type dependencies stay unresolved.
+    if (!visited.insert(&node).second) return;
+    const auto found = trees.find(&verible::Root(node));
+    if (found == trees.end()) return;  // not a reference of this table
+    const ReferenceTree& tree = found->second;
+    std::vector<size_t> path;
+    verible::Path(node, path);
+    ReferenceComponentNode* current = tree.references->components.get();
+    ResolveReferenceComponentNode(current, *tree.context, diagnostics, &order);
+    for (const size_t child : path) {
+      current = &current->Children()[child];
+      ResolveReferenceComponentNode(current, *tree.context, diagnostics,
+                                    &order);
+    }
+  };
+  resolve_node(*target);
+  return &target->Value();
+}
+
 void SymbolTable::ResolveLocallyOnly() {
   symbol_table_root_.ApplyPreOrder(
       [=](SymbolTableNode& node) { node.Value().ResolveLocally(node); });
 }
 
+// Collects the top-most symbols below 'scope' that are defined in 'file' as
+// (parent, position) pairs into 'top_symbols', and all of them and their
+// nested symbols into 'symbols'.
+// Returns false if any of the nested symbols is defined in another file.
+static bool CollectSymbolsOfFile(
+    SymbolTableNode* scope, const VerilogSourceFile* file,
+    std::vector<std::pair<SymbolTableNode*, SymbolTableNode::iterator>>*
+        top_symbols,
+    absl::flat_hash_set<const SymbolTableNode*>* symbols) {
+  for (auto iter = scope->begin(); iter != scope->end(); ++iter) {
+    SymbolTableNode& symbol = iter->second;
+    if (symbol.Value().file_origin != file) {
+      if (!CollectSymbolsOfFile(&symbol, file, top_symbols, symbols)) {
+        return false;
+      }
+      continue;
+    }
+    bool only_from_file = true;
+    symbol.ApplyPreOrder([=, &only_from_file](SymbolTableNode& node) {
+      only_from_file &= node.Value().file_origin == file;
+      symbols->insert(&node);
+    });
+    if (!only_from_file) return false;
+    top_symbols->emplace_back(scope, iter);
+  }
+  return true;
+}
+
+void SymbolTable::ReleaseSyntaxTrees() {
+  symbol_table_root_.ApplyPreOrder([](SymbolInfo& info) {
+    info.syntax_origin = nullptr;
+    info.declared_type.syntax_origin = nullptr;
+    info.parent_type.syntax_origin = nullptr;
+  });
+  if (project_ == nullptr) return;
+  for (auto& file : *project_) file.second->ReleaseSyntaxTree();
+}
+
+absl::Status SymbolTable::RemoveTranslationUnit(const VerilogSourceFile& file) {
+  const absl::Time start = absl::Now();
+  const auto unit = unit_contents_.find(&file);
+  if (unit == unit_contents_.end()) return absl::OkStatus();  // Nothing added.
+  if (entangled_files_.find(&file) != entangled_files_.end()) {
+    return absl::FailedPreconditionError(absl::StrCat(
+        "Symbols of ", file.ReferencedPath(),
+        " are mixed with those of other files, and cannot be removed."));
+  }
+  const absl::string_view contents = unit->second;
+
+  std::vector<std::pair<SymbolTableNode*, SymbolTableNode::iterator>>
+      top_symbols;
+  absl::flat_hash_set<const SymbolTableNode*> removed_symbols;
+  if (!CollectSymbolsOfFile(&symbol_table_root_, &file, &top_symbols,
+                            &removed_symbols)) {
+    return absl::FailedPreconditionError(
+        absl::StrCat("Definitions in ", file.ReferencedPath(),
+                     " contain definitions from other files."));
+  }
+
+  // References were added by 'file' if they point into its text, or if they
+  // are self-references to removed anonymous types, which use the memory of
+  // the generated name as identifier.
+  const auto added_by_file = [&](const DependentReferences& ref) {
+    const ReferenceComponent& base = ref.components->Value();
+    if (verible::IsSubRange(base.identifier, contents)) return true;
+    const SymbolTableNode* resolved = base.resolved_symbol;
+    return resolved != nullptr && removed_symbols.contains(resolved) &&
+           resolved->Key() != nullptr &&
+           resolved->Key()->data() == base.identifier.data();
+  };
+  size_t removed_references = 0;
+  size_t unbound_references = 0;
+  symbol_table_root_.ApplyPreOrder([&](SymbolTableNode& node) {
+    if (removed_symbols.contains(&node)) return;
+    auto& references = node.Value().local_references_to_bind;
+    if (std::any_of(references.begin(), references.end(), added_by_file)) {
+      // DependentReferences are not assignable, so move the remaining ones.
+      std::vector<DependentReferences> remaining;
+      remaining.reserve(references.size());
+      for (auto& ref : references) {
+        if (added_by_file(ref)) {
+          ++removed_references;
+        } else {
+          remaining.push_back(std::move(ref));
+        }
+      }
+      references.swap(remaining);
+    }
+    // References to removed symbols, and references that depend on those,
+    // are resolved again later.
+    for (auto& ref : references) {
+      ApplyPreOrder(*ref.components, [&](ReferenceComponentNode& component) {
+        if (!removed_symbols.contains(component.Value().resolved_symbol)) {
+          return;
+        }
+        ApplyPreOrder(component, [](ReferenceComponent& dependent) {
+          dependent.resolved_symbol = nullptr;
+        });
+        ++unbound_references;
+      });
+    }
+  });
+
+  // Erasing by position does not access the keys' text.
+  for (const auto& [scope, position] : top_symbols) scope->Erase(position);
+  unit_contents_.erase(unit);
+  VLOG(1) << "SymbolTable::RemoveTranslationUnit(" << file.ReferencedPath()
+          << ") removed " << removed_symbols.size() << " symbols and "
+          << removed_references << " references, unbound "
+          << unbound_references << " references in "
+          << (absl::Now() - start);
+  return absl::OkStatus();
+}
+
+// Returns true if 'from' can be merged into 'into' without renaming any
+// anonymous scopes, whose names are numbered per scope.
+static bool CanMergeScope(const SymbolTableNode& into,
+                          const SymbolTableNode& from) {
+  if (!into.Value().anonymous_scope_names.empty() &&
+      !from.Value().anonymous_scope_names.empty()) {
+    return false;
+  }
+  for (const auto& [name, symbol] : from) {
+    const auto found = into.Find(name);
+    if (found != into.end() && !CanMergeScope(found->second, symbol)) {
+      return false;
+    }
+  }
+  return true;
+}
+
+// Bookkeeping of SymbolTable::MergePartialSymbolTable().
+struct SymbolTableMerge {
+  // Symbols of the partial symbol table that were not moved, because a
+  // symbol by that name already existed, and the symbols that they were
+  // merged into.
+  absl::flat_hash_map<const SymbolTableNode*, const SymbolTableNode*> replaced;
+  std::set<const VerilogSourceFile*>* entangled_files;
+  std::vector<absl::Status>* diagnostics;
+};
+
+// Moves the symbols and references of 'from' into 'into', like the Builder
+// would have added them: duplicate symbols are diagnosed and merged.
+static void MergeScope(SymbolTableNode* into, SymbolTableNode* from,
+                       SymbolTableMerge* merge) {
+  SymbolInfo& into_info = into->Value();
+  SymbolInfo& from_info = from->Value();
+  // CanMergeScope() guarantees that the anonymous scope names stay the same.
+  for (auto& name : from_info.anonymous_scope_names) {
+    into_info.anonymous_scope_names.push_back(std::move(name));
+  }
+  from_info.anonymous_scope_names.clear();
+
+  for (auto iter = from->begin(); iter != from->end();) {
+    const auto next = std::next(iter);
+    const auto [position, inserted] = into->TrySplice(iter->first, from, iter);
+    if (!inserted) {
+      SymbolTableNode& previous_symbol = position->second;
+      SymbolTableNode& symbol = iter->second;
+      const VerilogSourceFile* file = symbol.Value().file_origin;
+      if (previous_symbol.Value().file_origin != file) {
+        merge->entangled_files->insert(file);
+        merge->entangled_files->insert(previous_symbol.Value().file_origin);
+      }
+      merge->diagnostics->push_back(DiagnoseSymbolAlreadyExists(
+          *symbol.Key(), *file, *into, previous_symbol));
+      merge->replaced.emplace(&symbol, &previous_symbol);
+      MergeScope(&previous_symbol, &symbol, merge);
+    }
+    iter = next;
+  }
+
+  for (auto& ref : from_info.local_references_to_bind) {
+    into_info.local_references_to_bind.push_back(std::move(ref));
+  }
+  from_info.local_references_to_bind.clear();
+}
+
+bool SymbolTable::MergePartialSymbolTable(
+    SymbolTable* partial, std::vector<absl::Status>* diagnostics) {
+  SymbolTableNode& partial_root = partial->symbol_table_root_;
+  if (!CanMergeScope(symbol_table_root_, partial_root)) return false;
+
+  // Pre-resolved references point to symbols of the partial symbol table.
+  std::vector<ReferenceComponent*> resolved_components;
+  partial_root.ApplyPreOrder([&](SymbolInfo& info) {
+    for (auto& ref : info.local_references_to_bind) {
+      ApplyPreOrder(*ref.components, [&](ReferenceComponent& component) {
+        if (component.resolved_symbol != nullptr) {
+          resolved_components.push_back(&component);
+        }
+      });
+    }
+  });
+
+  SymbolTableMerge merge{.entangled_files = &entangled_files_,
+                         .diagnostics = diagnostics};
+  merge.replaced.emplace(&partial_root, &symbol_table_root_);
+  MergeScope(&symbol_table_root_, &partial_root, &merge);
+  // Moved symbols keep their addresses, only replaced ones need updates.
+  for (ReferenceComponent* component : resolved_components) {
+    const auto found = merge.replaced.find(component->resolved_symbol);
+    if (found != merge.replaced.end()) {
+      component->resolved_symbol = found->second;
+    }
+  }
+
+  for (const auto& [file, contents] : partial->unit_contents_) {
+    if (!unit_contents_.emplace(file, contents).second) {
+      entangled_files_.insert(file);
+    }
+  }
+  entangled_files_.insert(partial->entangled_files_.begin(),
+                          partial->entangled_files_.end());
+
+  // What remains are the replaced symbols, without references.
+  while (partial_root.begin() != partial_root.end()) {
+    partial_root.Erase(partial_root.begin());
+  }
+  partial->unit_contents_.clear();
+  partial->entangled_files_.clear();
+  return true;
+}
+
+// Format of the entries of the translation unit cache, see
+// SymbolTable::SetCacheDirectory().  Entries start with kCacheFormat, followed
+// by varints and strings (see common/util/varint_coding.h).  Optional indices
+// are written plus one, and zero if there is none.
+static constexpr absl::string_view kCacheFormat = "verible-symbol-table-3\n";
+static constexpr absl::string_view kCacheEntryEnd = "end";
+
+// Writes the symbols of a single translation unit.  Symbols are numbered in
+// pre-order, starting with the root, and so are the components of their
+// references.  Text is written as its position in the unit, or as the index
+// of an anonymous scope name.
+class TranslationUnitCacheWriter {
+ public:
+  explicit TranslationUnitCacheWriter(const VerilogSourceFile& unit)
+      : unit_(&unit), contents_(unit.GetContent()) {}
+
+  bool Write(const SymbolTableNode& root,
+             const std::vector<absl::Status>& diagnostics) {
+    absl::StrAppend(&entry_, kCacheFormat);
+    if (!IndexSymbols(root)) return false;
+    verible::PutVarint(symbols_.size(), &entry_);
+    for (const SymbolTableNode* symbol : symbols_) {
+      const SymbolInfo& info = symbol->Value();
+      if (symbol != &root) {
+        verible::PutVarint(symbol_index_[symbol->Parent()], &entry_);
+        if (!WriteText(*symbol->Key())) return false;
+        verible::PutVarint(static_cast<uint64_t>(info.metatype), &entry_);
+      }
+      verible::PutVarint(info.anonymous_scope_names.size(), &entry_);
+      for (const auto& name : info.anonymous_scope_names) {
+        verible::PutString(*name, &entry_);
+      }
+    }
+    // References can refer to the anonymous scope names of any symbol.
+    for (const SymbolTableNode* symbol : symbols_) {
+      const auto& references = symbol->Value().local_references_to_bind;
+      verible::PutVarint(references.size(), &entry_);
+      for (const auto& ref : references) {
+        if (ref.Empty() || !WriteReferenceComponents(*ref.components)) {
+          return false;
+        }
+      }
+    }
+    // Types can refer to the reference components of any symbol.
+    for (const SymbolTableNode* symbol : symbols_) {
+      if (!WriteType(symbol->Value().declared_type) ||
+          !WriteType(symbol->Value().parent_type)) {
+        return false;
+      }
+    }
+    verible::PutVarint(diagnostics.size(), &entry_);
+    for (const auto& status : diagnostics) {
+      verible::PutVarint(static_cast<uint64_t>(status.code()), &entry_);
+      verible::PutString(status.message(), &entry_);
+    }
+    verible::PutString(kCacheEntryEnd, &entry_);
+    return true;
+  }
+
+  std::string Release() { return std::move(entry_); }
+
+ private:
+  bool IndexSymbols(const SymbolTableNode& symbol) {
+    if (symbol.Parent() != nullptr && symbol.Value().file_origin != unit_) {
+      return false;
+    }
+    const int64_t index = symbols_.size();
+    symbol_index_.emplace(&symbol, index);
+    symbols_.push_back(&symbol);
+    const auto& names = symbol.Value().anonymous_scope_names;
+    for (size_t i = 0; i < names.size(); ++i) {
+      anonymous_names_.emplace(names[i]->data(), AnonymousName{index, i});
+    }
+    for (const auto& child : symbol) {
+      if (!IndexSymbols(child.second)) return false;
+    }
+    return true;
+  }
+
+  bool WriteText(absl::string_view text) {
+    if (verible::IsSubRange(text, contents_)) {
+      verible::PutVarint(0, &entry_);
+      verible::PutVarint(std::distance(contents_.begin(), text.begin()),
+                         &entry_);
+      verible::PutVarint(text.length(), &entry_);
+      return true;
+    }
+    const auto found = anonymous_names_.find(text.data());
+    if (found == anonymous_names_.end()) return false;
+    const AnonymousName& name = found->second;
+    const SymbolInfo& info = symbols_[name.symbol]->Value();
+    if (*info.anonymous_scope_names[name.index] != text) return false;
+    verible::PutVarint(1, &entry_);
+    verible::PutVarint(name.symbol, &entry_);
+    verible::PutVarint(name.index, &entry_);
+    return true;
+  }
+
+  bool WriteReferenceComponents(const ReferenceComponentNode& node) {
+    const ReferenceComponent& component = node.Value();
+    component_index_.emplace(&node, component_index_.size());
+    if (!WriteText(component.identifier)) return false;
+    verible::PutVarint(static_cast<uint64_t>(component.ref_type), &entry_);
+    verible::PutVarint(static_cast<uint64_t>(component.required_metatype),
+                       &entry_);
+    if (component.resolved_symbol == nullptr) {
+      verible::PutVarint(0, &entry_);
+    } else {
+      const auto found = symbol_index_.find(component.resolved_symbol);
+      if (found == symbol_index_.end()) return false;
+      verible::PutVarint(found->second + 1, &entry_);
+    }
+    verible::PutVarint(node.Children().size(), &entry_);
+    for (const auto& child : node.Children()) {
+      if (!WriteReferenceComponents(child)) return false;
+    }
+    return true;
+  }
+
+  bool WriteType(const DeclarationTypeInfo& type) {
+    if (type.user_defined_type == nullptr) {
+      verible::PutVarint(0, &entry_);
+    } else {
+      const auto found = component_index_.find(type.user_defined_type);
+      if (found == component_index_.end()) return false;
+      verible::PutVarint(found->second + 1, &entry_);
+    }
+    verible::PutVarint(type.implicit ? 1 : 0, &entry_);
+    return true;
+  }
+
+  struct AnonymousName {
+    int64_t symbol;
+    size_t index;
+  };
+
+  const VerilogSourceFile* const unit_;
+  const absl::string_view contents_;
+  std::string entry_;
+  std::vector<const SymbolTableNode*> symbols_;
+  absl::flat_hash_map<const SymbolTableNode*, int64_t> symbol_index_;
+  absl::flat_hash_map<const ReferenceComponentNode*, int64_t> component_index_;
+  absl::flat_hash_map<const char*, AnonymousName> anonymous_names_;
+};
+
+// Reads what TranslationUnitCacheWriter wrote.
+class TranslationUnitCacheReader {
+ public:
+  TranslationUnitCacheReader(const VerilogSourceFile& unit,
+                             absl::string_view entry)
+      : unit_(&unit),
+        contents_(unit.GetContent()),
+        reader_(entry),
+        entry_size_(entry.size()) {}
+
+  bool Read(SymbolTableNode* root, std::vector<absl::Status>* diagnostics) {
+    if (!reader_.Prefix(kCacheFormat)) return false;
+    int64_t num_symbols;
+    if (!Count(&num_symbols) || num_symbols == 0) return false;
+    symbols_.push_back(root);
+    if (!ReadAnonymousNames(root)) return false;
+    for (int64_t i = 1; i < num_symbols; ++i) {
+      int64_t parent;
+      absl::string_view key;
+      int64_t metatype;
+      if (!Number(symbols_.size(), &parent) || !ReadText(&key) ||
+          !Number(kNumMetaTypes, &metatype)) {
+        return false;
+      }
+      const auto [iter, inserted] = symbols_[parent]->TryEmplace(
+          key, static_cast<SymbolMetaType>(metatype), unit_);
+      if (!inserted) return false;
+      symbols_.push_back(&iter->second);
+      if (!ReadAnonymousNames(&iter->second)) return false;
+    }
+
+    for (SymbolTableNode* symbol : symbols_) {
+      int64_t num_references;
+      if (!Count(&num_references)) return false;
+      auto& references = symbol->Value().local_references_to_bind;
+      for (int64_t i = 0; i < num_references; ++i) {
+        std::unique_ptr<ReferenceComponentNode> components;
+        if (!ReadReferenceComponents(nullptr, &components)) return false;
+        references.emplace_back(std::move(components));
+      }
+    }
+    for (SymbolTableNode* symbol : symbols_) {
+      if (!ReadType(&symbol->Value().declared_type) ||
+          !ReadType(&symbol->Value().parent_type)) {
+        return false;
+      }
+    }
+
+    int64_t num_diagnostics;
+    if (!Count(&num_diagnostics)) return false;
+    std::vector<absl::Status> statuses;
+    for (int64_t i = 0; i < num_diagnostics; ++i) {
+      int64_t code;
+      absl::string_view message;
+      if (!Number(kNumStatusCodes, &code) || !reader_.String(&message)) {
+        return false;
+      }
+      statuses.emplace_back(static_cast<absl::StatusCode>(code), message);
+    }
+    absl::string_view end;
+    if (!reader_.String(&end) || end != kCacheEntryEnd || !reader_.AtEnd()) {
+      return false;
+    }
+    diagnostics->insert(diagnostics->end(), statuses.begin(), statuses.end());
+    return true;
+  }
+
+ private:
+  static constexpr int64_t kNumMetaTypes =
+      static_cast<int64_t>(SymbolMetaType::kCallable) + 1;
+  static constexpr int64_t kNumReferenceTypes =
+      static_cast<int64_t>(ReferenceType::kMemberOfTypeOfParent) + 1;
+  static constexpr int64_t kNumStatusCodes =
+      static_cast<int64_t>(absl::StatusCode::kUnauthenticated) + 1;
+
+  // Reads a number in [0, end).  Entries might be truncated or corrupt, so
+  // every field is validated.
+  bool Number(int64_t end, int64_t* number) {
+    uint64_t value;
+    if (!reader_.Varint(&value) || value >= static_cast<uint64_t>(end)) {
+      return false;
+    }
+    *number = static_cast<int64_t>(value);
+    return true;
+  }
+
+  // Reads an optional index in [0, end), or -1 if there is none.
+  bool OptionalIndex(int64_t end, int64_t* index) {
+    if (!Number(end + 1, index)) return false;
+    --*index;
+    return true;
+  }
+
+  // Reads the number of elements that follow, which cannot be more than the
+  // bytes of the entry.
+  bool Count(int64_t* count) { return Number(entry_size_ + 1, count); }
+
+  bool ReadAnonymousNames(SymbolTableNode* symbol) {
+    int64_t num_names;
+    if (!Count(&num_names)) return false;
+    auto& names = symbol->Value().anonymous_scope_names;
+    for (int64_t i = 0; i < num_names; ++i) {
+      absl::string_view name;
+      if (!reader_.String(&name)) return false;
+      names.push_back(std::make_unique<const std::string>(name));
+    }
+    return true;
+  }
+
+  bool ReadText(absl::string_view* text) {
+    int64_t kind;
+    if (!Number(2, &kind)) return false;
+    if (kind == 0) {
+      int64_t offset;
+      int64_t length;
+      if (!Number(contents_.length() + 1, &offset) ||
+          !Number(contents_.length() - offset + 1, &length)) {
+        return false;
+      }
+      *text = contents_.substr(offset, length);
+      return true;
+    }
+    int64_t symbol;
+    int64_t index;
+    if (!Number(symbols_.size(), &symbol)) return false;
+    const auto& names = symbols_[symbol]->Value().anonymous_scope_names;
+    if (!Number(names.size(), &index)) return false;
+    *text = *names[index];
+    return true;
+  }
+
+  // Reads a reference component and its subtree, as a new child of 'parent',
+  // or, without parent, into 'tree'.
+  bool ReadReferenceComponents(ReferenceComponentNode* parent,
+                               std::unique_ptr<ReferenceComponentNode>* tree) {
+    absl::string_view identifier;
+    int64_t ref_type;
+    int64_t required_metatype;
+    int64_t resolved_symbol;
+    int64_t num_children;
+    if (!ReadText(&identifier) ||
+        !Number(kNumReferenceTypes, &ref_type) ||
+        !Number(kNumMetaTypes, &required_metatype) ||
+        !OptionalIndex(symbols_.size(), &resolved_symbol) ||
+        !Count(&num_children)) {
+      return false;
+    }
+    const ReferenceComponent component{
+        .identifier = identifier,
+        .ref_type = static_cast<ReferenceType>(ref_type),
+        .required_metatype = static_cast<SymbolMetaType>(required_metatype),
+        .resolved_symbol =
+            resolved_symbol < 0 ? nullptr : symbols_[resolved_symbol]};
+    ReferenceComponentNode* node;
+    if (parent == nullptr) {
+      *tree = std::make_unique<ReferenceComponentNode>(component);
+      node = tree->get();
+    } else {
+      parent->Children().emplace_back(component);
+      node = &parent->Children().back();
+    }
+    components_.push_back(node);
+    // Types point to components, which must not move.
+    node->Children().reserve(num_children);
+    for (int64_t i = 0; i < num_children; ++i) {
+      if (!ReadReferenceComponents(node, nullptr)) return false;
+    }
+    return true;
+  }
+
+  bool ReadType(DeclarationTypeInfo* type) {
+    int64_t user_defined_type;
+    int64_t implicit;
+    if (!OptionalIndex(components_.size(), &user_defined_type) ||
+        !Number(2, &implicit)) {
+      return false;
+    }
+    type->user_defined_type =
+        user_defined_type < 0 ? nullptr : components_[user_defined_type];
+    type->implicit = implicit != 0;
+    return true;
+  }
+
+  const VerilogSourceFile* const unit_;
+  const absl::string_view contents_;
+  verible::VarintReader reader_;
+  const int64_t entry_size_;
+  std::vector<SymbolTableNode*> symbols_;
+  std::vector<const ReferenceComponentNode*> components_;
+};
+
+void SymbolTable::SetCacheDirectory(absl::string_view directory,
+                                    absl::string_view version) {
+  cache_directory_ = std::string(directory);
+  cache_version_ = std::string(version);
+}
+
+std::string SymbolTable::CacheFilePath(const VerilogSourceFile& unit) const {
+  // The path of the unit is part of its diagnostics.  Prefixing the lengths
+  // keeps the parts of the key apart.
+  std::string key;
+  for (const absl::string_view part :
+       {kCacheFormat, absl::string_view(cache_version_), unit.ReferencedPath(),
+        unit.GetContent()}) {
+    absl::StrAppend(&key, part.length(), ":", part);
+  }
+  std::array<unsigned char, SHA256_DIGEST_LENGTH> digest;
+  ::SHA256(reinterpret_cast<const unsigned char*>(key.data()), key.length(),
+           digest.data());
+  return verible::file::JoinPath(
+      cache_directory_,
+      absl::BytesToHexString(absl::string_view(
+          reinterpret_cast<const char*>(digest.data()), digest.size())));
+}
+
+bool SymbolTable::SerializeTranslationUnit(
+    const VerilogSourceFile& unit, const std::vector<absl::Status>& diagnostics,
+    std::string* entry) const {
+  // Syntax errors are reported by parsing, which is skipped for cached units.
+  if (!unit.Status().ok()) return false;
+  // Included files can change independently of the unit.
+  const auto* text_structure = unit.GetTextStructure();
+  if (text_structure == nullptr) return false;
+  const auto& tokens = text_structure->TokenStream();
+  if (std::any_of(tokens.begin(), tokens.end(), [](const TokenInfo& token) {
+        return token.token_enum() == verilog_tokentype::PP_include;
+      })) {
+    return false;
+  }
+  // Out-of-line definitions might belong to scopes of other units.
+  if (missing_out_of_line_scope_ || !entangled_files_.empty()) return false;
+
+  TranslationUnitCacheWriter writer(unit);
+  if (!writer.Write(symbol_table_root_, diagnostics)) return false;
+  *entry = writer.Release();
+  return true;
+}
+
+bool SymbolTable::DeserializeTranslationUnit(
+    const VerilogSourceFile& unit, absl::string_view entry,
+    std::vector<absl::Status>* diagnostics) {
+  TranslationUnitCacheReader reader(unit, entry);
+  if (!reader.Read(&symbol_table_root_, diagnostics)) {
+    // References go with their scopes, whose keys might refer to the
+    // anonymous scope names of the root.
+    while (symbol_table_root_.begin() != symbol_table_root_.end()) {
+      symbol_table_root_.Erase(symbol_table_root_.begin());
+    }
+    SymbolInfo& root_info = symbol_table_root_.Value();
+    root_info.local_references_to_bind.clear();
+    root_info.anonymous_scope_names.clear();
+    return false;
+  }
+  unit_contents_.emplace(&unit, unit.GetContent());
+  return true;
+}
+
 std::ostream& SymbolTable::PrintSymbolDefinitions(std::ostream& stream) const {
   return symbol_table_root_.PrintTree(
       stream,
@@ -2054,15 +3144,225 @@ static void ParseFileAndBuildSymbolTable(
   diagnostics->insert(diagnostics->end(), statuses.begin(), statuses.end());
 }
 
-void SymbolTable::Build(std::vector<absl::Status>* diagnostics) {
+void SymbolTable::Build(std::vector<absl::Status>* diagnostics,
+                        int num_threads) {
+  VERIBLE_TRACE_SCOPE("symbol-table", "build");
   const absl::Time start = absl::Now();
-  for (auto& translation_unit : *project_) {
-    ParseFileAndBuildSymbolTable(translation_unit.second.get(), this, project_,
-                                 diagnostics);
+  if (num_threads > 1) {
+    std::vector<VerilogSourceFile*> units;
+    for (auto& translation_unit : *project_) {
+      units.push_back(translation_unit.second.get());
+    }
+    std::vector<std::vector<absl::Status>> unit_diagnostics(units.size());
+    BuildUnits(units, num_threads, &unit_diagnostics);
+    for (auto& statuses : unit_diagnostics) {
+      diagnostics->insert(diagnostics->end(), statuses.begin(),
+                          statuses.end());
+    }
+  } else {
+    for (auto& translation_unit : *project_) {
+      if (Cancelled()) {
+        diagnostics->push_back(SymbolTableCancelled("Building symbol table"));
+        break;
+      }
+      ParseFileAndBuildSymbolTable(translation_unit.second.get(), this,
+                                   project_, diagnostics);
+    }
   }
   VLOG(1) << "SymbolTable::Build() took " << (absl::Now() - start);
 }
 
+void SymbolTable::BuildTranslationUnits(
+    const std::vector<std::string>& referenced_file_names, int num_threads,
+    std::vector<absl::Status>* diagnostics) {
+  VERIBLE_TRACE_SCOPE("symbol-table", "build");
+  const absl::Time start = absl::Now();
+  // Opening files modifies the project, so it is done up front.
+  std::vector<VerilogSourceFile*> units;
+  std::vector<std::vector<absl::Status>> unit_diagnostics(
+      referenced_file_names.size());
+  const auto opened_units =
+      project_->OpenTranslationUnits(referenced_file_names, num_threads);
+  for (size_t i = 0; i < referenced_file_names.size(); ++i) {
+    const auto& translation_unit_or_status = opened_units[i];
+    if (!translation_unit_or_status.ok()) {
+      unit_diagnostics[i].push_back(translation_unit_or_status.status());
+      units.push_back(nullptr);
+      continue;
+    }
+    units.push_back(*translation_unit_or_status);
+  }
+
+  BuildUnits(units, num_threads, &unit_diagnostics);
+  for (auto& statuses : unit_diagnostics) {
+    diagnostics->insert(diagnostics->end(), statuses.begin(), statuses.end());
+  }
+  VLOG(1) << "SymbolTable::BuildTranslationUnits() of " << units.size()
+          << " files took " << (absl::Now() - start);
+}
+
+void SymbolTable::BuildUnits(
+    const std::vector<VerilogSourceFile*>& units, int num_threads,
+    std::vector<std::vector<absl::Status>>* unit_diagnostics) {
+  num_threads = std::min<int>(num_threads, units.size());
+  const bool use_cache = !cache_directory_.empty();
+  if (num_threads <= 1 && !use_cache) {
+    for (size_t i = 0; i < units.size(); ++i) {
+      if (units[i] == nullptr) continue;
+      if (Cancelled()) {
+        (*unit_diagnostics)[i].push_back(
+            SymbolTableCancelled("Building symbol table"));
+        return;
+      }
+      ParseFileAndBuildSymbolTable(units[i], this, project_,
+                                   &(*unit_diagnostics)[i]);
+    }
+    return;
+  }
+
+  // Without threads, the pool runs everything synchronously.
+  verible::ThreadPool pool(num_threads > 1 ? num_threads : 0);
+  std::map<const VerilogSourceFile*, int> occurrences;
+  for (const VerilogSourceFile* unit : units) {
+    if (unit != nullptr) ++occurrences[unit];
+  }
+  // Files that are listed several times are parsed only once, and all are
+  // parsed before building, because units may include each other.
+  // Units that are listed once are read from the cache instead, if found.
+  std::vector<std::string> cache_paths(units.size());
+  std::vector<std::string> cache_entries(units.size());
+  std::map<VerilogSourceFile*, std::shared_future<absl::Status>> parsed;
+  for (size_t i = 0; i < units.size(); ++i) {
+    VerilogSourceFile* const unit = units[i];
+    if (unit == nullptr || parsed.find(unit) != parsed.end()) continue;
+    const bool cached = use_cache && occurrences[unit] == 1;
+    std::string* const cache_path = &cache_paths[i];
+    std::string* const cache_entry = &cache_entries[i];
+    auto parse = [this, unit, cached, cache_path, cache_entry] {
+      // Cancelled units are not merged, so they need not be parsed.
+      if (Cancelled()) return absl::OkStatus();
+      if (cached && unit->Open().ok()) {
+        *cache_path = CacheFilePath(*unit);
+        auto entry = verible::file::GetContentAsString(*cache_path);
+        if (entry.ok() && !entry->empty()) {
+          *cache_entry = std::move(*entry);
+          return absl::OkStatus();
+        }
+      }
+      return unit->Parse();
+    };
+    parsed.emplace(unit, pool.ExecAsync<absl::Status>(parse).share());
+  }
+  for (const auto& parse : parsed) parse.second.wait();
+
+  std::mutex include_lock;
+  // Units that are built directly into this table also open includes.
+  const ValueSaver<std::mutex*> save_lock(&include_lock_, &include_lock);
+  std::vector<std::unique_ptr<SymbolTable>> partials(units.size());
+  std::vector<std::future<std::vector<absl::Status>>> built(units.size());
+  for (size_t i = 0; i < units.size(); ++i) {
+    if (units[i] == nullptr) continue;
+    partials[i] = std::make_unique<SymbolTable>(project_);
+    partials[i]->include_lock_ = &include_lock;
+    VerilogSourceFile* const unit = units[i];
+    SymbolTable* partial = partials[i].get();
+    VerilogProject* project = project_;
+    const std::string* const cache_path = &cache_paths[i];
+    const std::string* const cache_entry = &cache_entries[i];
+    std::mutex* const lock = &include_lock;
+    auto build = [this, unit, partial, project, cache_path, cache_entry,
+                  lock] {
+      VERIBLE_TRACE_SCOPE("symbol-table", "build-unit", unit->ReferencedPath());
+      std::vector<absl::Status> statuses;
+      if (Cancelled()) return statuses;
+      if (!cache_entry->empty()) {
+        if (partial->DeserializeTranslationUnit(*unit, *cache_entry,
+                                                &statuses)) {
+          return statuses;
+        }
+        LOG(WARNING) << "Ignoring invalid symbol table cache entry "
+                     << *cache_path << " of " << unit->ReferencedPath();
+        // Other units might be parsing this one as an include.
+        const std::lock_guard<std::mutex> l(*lock);
+        const absl::Status parse_status = unit->Parse();
+        if (!parse_status.ok()) statuses.push_back(parse_status);
+      }
+      const std::vector<absl::Status> build_statuses =
+          BuildSymbolTable(*unit, partial, project);
+      statuses.insert(statuses.end(), build_statuses.begin(),
+                      build_statuses.end());
+      std::string entry;
+      if (!cache_path->empty() &&
+          partial->SerializeTranslationUnit(*unit, build_statuses, &entry)) {
+        // Readers only ever see complete entries.  Other processes might
+        // write the same entry at the same time.
+        absl::Status status =
+            verible::file::SetContentsAtomically(*cache_path, entry);
+        if (!status.ok()) {
+          // The first entry creates the directory.
+          verible::file::CreateDir(verible::file::Dirname(*cache_path))
+              .IgnoreError();
+          status = verible::file::SetContentsAtomically(*cache_path, entry);
+        }
+        if (!status.ok()) LOG(WARNING) << status;
+      }
+      return statuses;
+    };
+    built[i] = pool.ExecAsync<std::vector<absl::Status>>(build);
+  }
+
+  // Merging in order keeps the result independent of the threads' timing.
+  size_t rebuilt = 0;
+  for (size_t i = 0; i < units.size(); ++i) {
+    if (units[i] == nullptr) continue;
+    std::vector<absl::Status>& diagnostics = (*unit_diagnostics)[i];
+    if (Cancelled()) {
+      diagnostics.push_back(SymbolTableCancelled("Building symbol table"));
+      // The remaining builds still refer to 'partials', and return early.
+      for (; i < units.size(); ++i) {
+        if (units[i] != nullptr) built[i].wait();
+      }
+      break;
+    }
+    const absl::Status parse_status = parsed[units[i]].get();
+    if (!parse_status.ok()) diagnostics.push_back(parse_status);
+    VERIBLE_TRACE_SCOPE("symbol-table", "merge-unit",
+                        units[i]->ReferencedPath());
+
+    std::vector<absl::Status> statuses = built[i].get();
+    bool merged = false;
+    if (!partials[i]->missing_out_of_line_scope_) {
+      // Diagnostics about duplicates access the syntax trees of units, which
+      // might be parsed meanwhile if they were read from the cache.
+      const std::lock_guard<std::mutex> l(include_lock);
+      merged = MergePartialSymbolTable(partials[i].get(), &statuses);
+    }
+    if (merged) {
+      diagnostics.insert(diagnostics.end(), statuses.begin(), statuses.end());
+    } else {
+      // Build again, with the preceding units' definitions in scope.
+      ++rebuilt;
+      {
+        // Units that were read from the cache are not parsed yet.
+        const std::lock_guard<std::mutex> l(include_lock);
+        const absl::Status status = units[i]->Parse();
+        if (!status.ok() && parse_status.ok()) diagnostics.push_back(status);
+      }
+      statuses = BuildSymbolTable(*units[i], this, project_);
+      diagnostics.insert(diagnostics.end(), statuses.begin(), statuses.end());
+    }
+    partials[i].reset();
+  }
+  VLOG(1) << "Built " << units.size() << " translation units on "
+          << num_threads << " threads, "
+          << std::count_if(cache_entries.begin(), cache_entries.end(),
+                           [](const std::string& entry) {
+                             return !entry.empty();
+                           })
+          << " read from the cache, " << rebuilt
+          << " built again after merging.";
+}
+
 void SymbolTable::BuildSingleTranslationUnit(
     absl::string_view referenced_file_name,
     std::vector<absl::Status>* diagnostics) {
@@ -2086,6 +3386,9 @@ std::vector<absl::Status> BuildSymbolTable(const VerilogSourceFile& source,
   const auto& syntax_tree = text_structure->SyntaxTree();
   if (syntax_tree == nullptr) return std::vector<absl::Status>();
 
+  // The builder searches the tree many times.
+  const verible::SyntaxTreeIndex index(*syntax_tree);
+  const verible::SyntaxTreeIndex::Scope index_scope(&index);
   SymbolTable::Builder builder(source, symbol_table, project);
   syntax_tree->Accept(&builder);
   return builder.TakeDiagnostics();  // move
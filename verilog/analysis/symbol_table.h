@@ -18,12 +18,20 @@
 #include <functional>
 #include <iosfwd>
 #include <map>
-
+#include <mutex>
+#include <set>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "absl/container/flat_hash_map.h"
+#include "absl/hash/hash.h"
 #include "absl/status/status.h"
 #include "absl/strings/string_view.h"
 #include "common/strings/compare.h"
 #include "common/text/symbol.h"
 #include "common/util/map_tree.h"
+#include "common/util/pool_allocator.h"
 #include "common/util/vector_tree.h"
 #include "verilog/analysis/verilog_project.h"
 
@@ -36,8 +44,11 @@ struct SymbolInfo;  // forward declaration, defined below
 // The string_view key carries positional information, it corresponds to a
 // substring owned by a VerilogSourceFile (which must outlive the symbol table),
 // and can be used to look up file origin and position within file.
+// Scopes with many symbols, e.g. large packages, are hash-indexed for lookups,
+// while iteration (and printing) remains ordered by name.
 using SymbolTableNode =
-    verible::MapTree<absl::string_view, SymbolInfo, verible::StringViewCompare>;
+    verible::MapTree<absl::string_view, SymbolInfo, verible::StringViewCompare,
+                     absl::Hash<absl::string_view>>;
 
 std::ostream& SymbolTableNodeFullPath(std::ostream&, const SymbolTableNode&);
 
@@ -154,7 +165,13 @@ std::ostream& operator<<(std::ostream&, const ReferenceComponent&);
 // depends on 'x', and resolving 'z' depends on 'y'. Named ports are manifest as
 // wide nodes: in "f(.a(...), .b(...))", both 'a' and 'b' depend on resolving
 // 'f' (and thus are siblings).
-using ReferenceComponentNode = verible::VectorTree<ReferenceComponent>;
+// There is a reference tree for nearly every identifier of a project, and the
+// children arrays of their nodes are recycled through a PoolAllocator, as
+// symbol tables are rebuilt whenever project files change.  This pays off for
+// the tables of single files, whose arrays fit in the pool; beyond that the
+// arrays come from the heap as before (see BM_ReferenceTrees).
+using ReferenceComponentNode =
+    verible::VectorTree<ReferenceComponent, verible::PoolAllocator>;
 
 // Human-readable representation of a node's path from root.
 std::ostream& ReferenceNodeFullPath(std::ostream&,
@@ -301,9 +318,14 @@ struct SymbolInfo {
   // Is this class-member static or non-static?
   // Is this definition complete or only a forward declaration?
 
-  // TODO(fangism): imported symbols and namespaces
-  // Applicable to packages, classes, modules.
-  // These should be looked up when searching for symbols (without copying).
+  // Members of the packages imported into this scope with wildcards
+  // ("import pkg::*;"), by name, merged into one index: looking up a name,
+  // found or not, takes one hash lookup instead of a search of every
+  // imported package.  Of equal names, the one imported first is kept.
+  // Declarations in this scope take precedence.
+  // Set by SymbolTable::IndexWildcardImports() before resolving.
+  absl::flat_hash_map<absl::string_view, const SymbolTableNode*>
+      wildcard_imported_symbols;
 
   // For elements with inheritance only: this points to a base class.
   // Currently limited to single-inheritance.
@@ -451,16 +473,99 @@ class SymbolTable {
   void BuildSingleTranslationUnit(absl::string_view referenced_file_name,
                                   std::vector<absl::Status>* diagnostics);
 
+  // Constructs the symbol table from the translation units
+  // 'referenced_file_names', with the same result as calling
+  // BuildSingleTranslationUnit() on each of them in order, but parsing and
+  // building the units on up to 'num_threads' threads.
+  // Each unit is built into a symbol table of its own, and those are merged
+  // into this one in order, so that the diagnostics about duplicate
+  // definitions do not depend on the timing of the threads.
+  // Differences to building the units one after another:
+  //   * Implicit declarations do not consider the definitions of other units.
+  //   * The diagnostics about duplicates of definitions of preceding units
+  //     follow the other diagnostics of a unit.
+  // Units with out-of-line definitions whose outer scope is defined by
+  // another unit, and units with anonymous scopes (e.g. structs) that would
+  // have to be renumbered, are built again directly into this symbol table.
+  void BuildTranslationUnits(
+      const std::vector<std::string>& referenced_file_names, int num_threads,
+      std::vector<absl::Status>* diagnostics);
+
   // Construct symbol table definitions and references hierarchically, but do
   // not attempt to resolve the symbols.
   // The ordering of translation units processing is implementation defined,
   // and should not be relied upon, but this only maatters when there are
   // duplicate definitions among translation units.
-  void Build(std::vector<absl::Status>* diagnostics);
+  // With more than one thread, or with a cache directory (see
+  // SetCacheDirectory()), all files of the project are built like
+  // BuildTranslationUnits(), and files that are opened as preprocessor
+  // includes while building are not built as translation units of their own.
+  void Build(std::vector<absl::Status>* diagnostics, int num_threads = 1);
+
+  // Enables caching the definitions, references and build diagnostics of
+  // translation units in 'directory', for BuildTranslationUnits() and Build().
+  // Entries are keyed by the path and contents of a unit, and 'version', which
+  // should identify the program that writes them.  Units found in the cache
+  // are not parsed, unless they have to be built again after merging, so
+  // their symbols have no syntax origins.
+  // Units with preprocessor includes, syntax errors, or out-of-line
+  // definitions of scopes of other units are not cached.
+  // An empty 'directory' disables the cache.
+  void SetCacheDirectory(absl::string_view directory,
+                         absl::string_view version);
+
+  // If set, 'is_cancelled' is polled between translation units in Build() and
+  // BuildTranslationUnits(), and between reference trees in Resolve().  Once
+  // it returns true, these stop and add a kCancelled diagnostic, leaving the
+  // remaining units unbuilt or references unresolved.  A later Resolve()
+  // binds the references left unresolved.  It may be called from several
+  // threads at once.
+  void SetIsCancelled(std::function<bool()> is_cancelled) {
+    is_cancelled_ = std::move(is_cancelled);
+  }
 
   // Lookup all symbol references, and bind references where successful.
   // Only attempt to resolve after merging symbol tables.
-  void Resolve(std::vector<absl::Status>* diagnostics);
+  // References that are already bound are kept, so after
+  // RemoveTranslationUnit() and re-building that unit, this only binds the
+  // new references, and those that were previously unresolved or bound to
+  // removed symbols.
+  // With more than one thread, reference trees are resolved concurrently,
+  // with the same results and diagnostics (in the same order).  Trees that
+  // depend on the resolution of preceding trees, e.g. for member lookups
+  // through the declared type of a variable, are resolved after those.
+  // Names that are not declared in a scope are also looked up in the packages
+  // imported into it with wildcards, before its enclosing scopes.
+  void Resolve(std::vector<absl::Status>* diagnostics, int num_threads = 1);
+
+  // Removes the definitions and references that building the translation
+  // unit 'file' added, e.g. before building it again after its contents
+  // changed.  References from other translation units to removed definitions
+  // become unresolved, to be bound again by the next Resolve().
+  // Neither 'file' nor its text are accessed, so this can be called when the
+  // text has already been released, as long as 'file' has not been destroyed
+  // or replaced by another file yet.
+  // Removing a file that was never built does nothing.
+  // Returns a FailedPreconditionError without changing the symbol table, if
+  // the unit's symbols cannot be told apart from those of other files, i.e.
+  // if it was built more than once, uses or is used as a preprocessor
+  // include, or has definitions that are duplicates of or contain definitions
+  // from other files.  In that case, the whole symbol table should be rebuilt.
+  absl::Status RemoveTranslationUnit(const VerilogSourceFile& file);
+
+  // Resolves only what is needed to bind the reference whose identifier
+  // contains 'position', a character in the text of a project file, e.g. to
+  // answer an interactive query before a complete Resolve(): the components
+  // of its reference tree that it depends on, and the declared and base types
+  // that their lookups go through, recursively.
+  // Results are kept like those of Resolve(), so repeated queries and a later
+  // Resolve() only bind the references that are still unbound.  Unlike
+  // Resolve(), types are resolved regardless of the order of the reference
+  // trees, so this may bind references that Resolve() alone leaves unbound.
+  // Returns the reference component at 'position', or nullptr if there is
+  // none.
+  const ReferenceComponent* ResolveReferenceAt(
+      const char* position, std::vector<absl::Status>* diagnostics);
 
   // A "weaker" version of Resolve() that only attempts to resolve symbol
   // references to definitions belonging to the same scope as the reference
@@ -471,6 +576,15 @@ class SymbolTable {
   // is intended.
   void ResolveLocallyOnly();
 
+  // Releases the token streams and syntax trees of all files of the project,
+  // e.g. after Build() for tools that only need definitions and references,
+  // which then use a fraction of the memory.  The symbols lose their syntax
+  // origins, like those read from the cache; their names and references
+  // still refer to the contents of the files, which are kept.  Translation
+  // units cannot be built again afterwards.
+  // If there is no project, only the syntax origins are cleared.
+  void ReleaseSyntaxTrees();
+
   // Print only the information about symbols defined (no references).
   // This will print the results of Build().
   std::ostream& PrintSymbolDefinitions(std::ostream&) const;
@@ -487,6 +601,47 @@ class SymbolTable {
   // Verify internal structural and pointer consistency.
   void CheckIntegrity() const;
 
+  // See SetIsCancelled().
+  bool Cancelled() const { return is_cancelled_ && is_cancelled_(); }
+
+ private:  // methods
+  // Sets the wildcard_imported_symbols of all scopes with wildcard imports
+  // for the current contents of this symbol table.
+  void IndexWildcardImports();
+
+  // Builds 'units' in order like BuildTranslationUnits(), and appends to the
+  // diagnostics of each unit in 'unit_diagnostics'.  nullptr units are
+  // skipped.
+  void BuildUnits(const std::vector<VerilogSourceFile*>& units,
+                  int num_threads,
+                  std::vector<std::vector<absl::Status>>* unit_diagnostics);
+
+  // Moves the definitions and references of 'partial', which was built from
+  // other translation units than this, into this symbol table.
+  // Returns false without changing either symbol table if anonymous scopes
+  // of 'partial' would have to be renamed, because they are merged into
+  // scopes that already have anonymous scopes.
+  bool MergePartialSymbolTable(SymbolTable* partial,
+                               std::vector<absl::Status>* diagnostics);
+
+  // Returns the name of the cache file of 'unit', see SetCacheDirectory().
+  std::string CacheFilePath(const VerilogSourceFile& unit) const;
+
+  // Returns the cache entry of 'unit', which is the only translation unit
+  // that was built into this (partial) symbol table, with the 'diagnostics'
+  // of building it.  Returns false if the symbols of 'unit' cannot be cached,
+  // e.g. because they do not refer to the text of 'unit'.
+  bool SerializeTranslationUnit(const VerilogSourceFile& unit,
+                                const std::vector<absl::Status>& diagnostics,
+                                std::string* entry) const;
+
+  // Restores the symbols of 'unit' from 'entry' into this empty (partial)
+  // symbol table, and appends the diagnostics of building it.
+  // Returns false, leaving this symbol table empty, if 'entry' is invalid.
+  bool DeserializeTranslationUnit(const VerilogSourceFile& unit,
+                                  absl::string_view entry,
+                                  std::vector<absl::Status>* diagnostics);
+
  private:  // data
   // This owns all files used to construct the symbol table and therefore,
   // owns all string_views inside the symbol table and outlives objects of
@@ -506,6 +661,31 @@ class SymbolTable {
 
   // All macro definitions/references interact through this global namespace.
   MacroSymbolMap macro_symbols_;
+
+  // Text of each translation unit that was built, for telling apart the
+  // references that a unit added in RemoveTranslationUnit().
+  std::map<const VerilogSourceFile*, absl::string_view> unit_contents_;
+
+  // Files whose symbols are mixed with those of other files, by preprocessor
+  // includes or duplicate definitions, so that they cannot be removed on
+  // their own.
+  std::set<const VerilogSourceFile*> entangled_files_;
+
+  // If set, serializes opening and parsing preprocessor includes, while
+  // translation units are built concurrently.
+  std::mutex* include_lock_ = nullptr;
+
+  // Set if the outer scope of an out-of-line definition could not be found,
+  // which might be defined by a translation unit that was not built into this
+  // symbol table.
+  bool missing_out_of_line_scope_ = false;
+
+  // See SetCacheDirectory(), empty if disabled.
+  std::string cache_directory_;
+  std::string cache_version_;
+
+  // See SetIsCancelled().
+  std::function<bool()> is_cancelled_;
 };
 
 // Construct a partial symbol table and bindings locations from a single source
@@ -19,6 +19,7 @@
 #include <iostream>
 #include <memory>
 #include <sstream>
+#include <string>
 #include <vector>
 
 #include "absl/base/attributes.h"
@@ -2105,6 +2106,64 @@ TEST(BuildSymbolTableTest, ReferenceOneParameterFromRootToPackageNoSuchMember) {
   }
 }
 
+TEST(BuildSymbolTableTest, ReferenceParametersImportedWithWildcards) {
+  TestVerilogSourceFile src("foobar.sv",
+                            "package p;\n"
+                            "localparam int mint = 1;\n"
+                            "localparam int tea = 2;\n"
+                            "endpackage\n"
+                            "package q;\n"
+                            "localparam int mint = 3;\n"
+                            "endpackage\n"
+                            "module m;\n"
+                            "import p::*;\n"
+                            "import q::*;\n"
+                            "localparam int tea = 4;\n"
+                            "localparam int x = mint;\n"  // p::mint
+                            "localparam int y = tea;\n"   // m's own
+                            "localparam int z = zzz;\n"   // expect fail
+                            "endmodule\n");
+  const auto status = src.Parse();
+  ASSERT_TRUE(status.ok()) << status.message();
+  SymbolTable symbol_table(nullptr);
+  const SymbolTableNode& root_symbol(symbol_table.Root());
+
+  const auto build_diagnostics = BuildSymbolTable(src, &symbol_table);
+  EXPECT_EMPTY_STATUSES(build_diagnostics);
+
+  MUST_ASSIGN_LOOKUP_SYMBOL(p_pkg, root_symbol, "p");
+  MUST_ASSIGN_LOOKUP_SYMBOL(q_pkg, root_symbol, "q");
+  MUST_ASSIGN_LOOKUP_SYMBOL(p_mint, p_pkg, "mint");
+  MUST_ASSIGN_LOOKUP_SYMBOL(module_node, root_symbol, "m");
+  MUST_ASSIGN_LOOKUP_SYMBOL(m_tea, module_node, "tea");
+
+  const auto ref_map(module_node_info.LocalReferencesMapViewForTesting());
+  ASSIGN_MUST_FIND_EXACTLY_ONE_REF(p_import, ref_map, "p");
+  ASSIGN_MUST_FIND_EXACTLY_ONE_REF(q_import, ref_map, "q");
+  EXPECT_EQ(p_import->components->Value().required_metatype,
+            SymbolMetaType::kPackage);
+  ASSIGN_MUST_FIND_EXACTLY_ONE_REF(mint_ref, ref_map, "mint");
+  ASSIGN_MUST_FIND_EXACTLY_ONE_REF(tea_ref, ref_map, "tea");
+  ASSIGN_MUST_FIND_EXACTLY_ONE_REF(zzz_ref, ref_map, "zzz");
+
+  // resolving twice should not change results
+  for (int i = 0; i < 2; ++i) {
+    std::vector<absl::Status> resolve_diagnostics;
+    symbol_table.Resolve(&resolve_diagnostics);
+
+    ASSIGN_MUST_HAVE_UNIQUE(err_status, resolve_diagnostics);
+    EXPECT_EQ(err_status.code(), absl::StatusCode::kNotFound);
+    EXPECT_EQ(p_import->components->Value().resolved_symbol, &p_pkg);
+    EXPECT_EQ(q_import->components->Value().resolved_symbol, &q_pkg);
+    // The first import of equal names wins.
+    EXPECT_EQ(mint_ref->components->Value().resolved_symbol, &p_mint);
+    // Declarations in the scope take precedence.
+    EXPECT_EQ(tea_ref->components->Value().resolved_symbol, &m_tea);
+    EXPECT_EQ(zzz_ref->components->Value().resolved_symbol, nullptr);
+    EXPECT_EQ(module_node_info.wildcard_imported_symbols.size(), 2);
+  }
+}
+
 TEST(BuildSymbolTableTest, ModuleDeclarationWithParameters) {
   TestVerilogSourceFile src("foobar.sv",
                             "module m #(\n"
@@ -9010,6 +9069,687 @@ TEST(BuildSymbolTableTest, IncludedTwiceFromDifferentFiles) {
   EXPECT_EMPTY_STATUSES(resolve_diagnostics);
 }
 
+TEST(BuildSymbolTableTest, RemoveTranslationUnitAndRebuild) {
+  const auto tempdir = ::testing::TempDir();
+  const std::string sources_dir = JoinPath(tempdir, __FUNCTION__);
+  ASSERT_TRUE(CreateDir(sources_dir).ok());
+
+  ScopedTestFile pp_src(sources_dir,
+                        "module pp;\n"
+                        "endmodule\n",
+                        "pp.sv");
+  ScopedTestFile qq_src(sources_dir,
+                        "module qq;\n"
+                        "  pp pp_inst();\n"
+                        "endmodule\n",
+                        "qq.sv");
+
+  VerilogProject project(sources_dir, {/* no include path */},
+                         /*corpus=*/"", /*populate_string_maps=*/false);
+  for (const auto* file : {&pp_src, &qq_src}) {
+    ASSERT_TRUE(project.OpenTranslationUnit(Basename(file->filename())).ok());
+  }
+  const VerilogSourceFile* pp_file = project.LookupRegisteredFile("pp.sv");
+  ASSERT_NE(pp_file, nullptr);
+
+  SymbolTable symbol_table(&project);
+  const SymbolTableNode& root_symbol(symbol_table.Root());
+
+  std::vector<absl::Status> diagnostics;
+  symbol_table.Build(&diagnostics);
+  symbol_table.Resolve(&diagnostics);
+  EXPECT_EMPTY_STATUSES(diagnostics);
+
+  MUST_ASSIGN_LOOKUP_SYMBOL(qq, root_symbol, "qq");
+  MUST_ASSIGN_LOOKUP_SYMBOL(pp_inst, qq, "pp_inst");
+  ASSERT_NE(pp_inst_info.declared_type.user_defined_type, nullptr);
+  const ReferenceComponent& pp_type(
+      pp_inst_info.declared_type.user_defined_type->Value());
+  {
+    MUST_ASSIGN_LOOKUP_SYMBOL(pp, root_symbol, "pp");
+    EXPECT_EQ(pp_type.resolved_symbol, &pp);
+  }
+
+  // Only the definitions from pp.sv are removed, and references to them are
+  // no longer bound.
+  EXPECT_TRUE(symbol_table.RemoveTranslationUnit(*pp_file).ok());
+  EXPECT_EQ(root_symbol.Find("pp"), root_symbol.end());
+  EXPECT_NE(root_symbol.Find("qq"), root_symbol.end());
+  EXPECT_EQ(qq_info.local_references_to_bind.size(), 2);
+  EXPECT_EQ(pp_type.resolved_symbol, nullptr);
+
+  // Removing it again does nothing.
+  EXPECT_TRUE(symbol_table.RemoveTranslationUnit(*pp_file).ok());
+
+  // Replace the file, and rebuild only that translation unit.
+  ASSERT_TRUE(verible::file::SetContents(pp_src.filename(),
+                                         "module pp;\n"
+                                         "  wire ww;\n"
+                                         "endmodule\n")
+                  .ok());
+  project.UpdateFileContents(pp_src.filename(), nullptr);
+  symbol_table.BuildSingleTranslationUnit("pp.sv", &diagnostics);
+  symbol_table.Resolve(&diagnostics);
+  EXPECT_EMPTY_STATUSES(diagnostics);
+
+  MUST_ASSIGN_LOOKUP_SYMBOL(pp, root_symbol, "pp");
+  MUST_ASSIGN_LOOKUP_SYMBOL(pp_ww, pp, "ww");
+  EXPECT_EQ(pp_info.file_origin, project.LookupRegisteredFile("pp.sv"));
+  EXPECT_EQ(pp_type.resolved_symbol, &pp);
+}
+
+TEST(BuildSymbolTableTest, RemoveTranslationUnitWithAnonymousTypes) {
+  const auto tempdir = ::testing::TempDir();
+  const std::string sources_dir = JoinPath(tempdir, __FUNCTION__);
+  ASSERT_TRUE(CreateDir(sources_dir).ok());
+
+  ScopedTestFile types_src(sources_dir,
+                           "typedef struct { int a; } s_t;\n"
+                           "typedef enum { RED, GREEN } e_t;\n",
+                           "types.sv");
+  ScopedTestFile qq_src(sources_dir,
+                        "module qq;\n"
+                        "  s_t s;\n"
+                        "endmodule\n",
+                        "qq.sv");
+
+  VerilogProject project(sources_dir, {/* no include path */},
+                         /*corpus=*/"", /*populate_string_maps=*/false);
+  SymbolTable symbol_table(&project);
+  const SymbolTableNode& root_symbol(symbol_table.Root());
+
+  std::vector<absl::Status> diagnostics;
+  symbol_table.BuildSingleTranslationUnit("qq.sv", &diagnostics);
+  const size_t qq_root_references =
+      root_symbol.Value().local_references_to_bind.size();
+  symbol_table.BuildSingleTranslationUnit("types.sv", &diagnostics);
+  symbol_table.Resolve(&diagnostics);
+  EXPECT_EMPTY_STATUSES(diagnostics);
+  EXPECT_GT(root_symbol.Value().local_references_to_bind.size(),
+            qq_root_references);
+
+  MUST_ASSIGN_LOOKUP_SYMBOL(qq, root_symbol, "qq");
+  MUST_ASSIGN_LOOKUP_SYMBOL(s, qq, "s");
+  ASSERT_NE(s_info.declared_type.user_defined_type, nullptr);
+  const ReferenceComponent& s_type(
+      s_info.declared_type.user_defined_type->Value());
+  EXPECT_NE(s_type.resolved_symbol, nullptr);
+
+  // The root-level references from types.sv are removed, including the
+  // self-references of the anonymous struct and enum types, whose names are
+  // not part of the text.
+  const VerilogSourceFile* types_file =
+      project.LookupRegisteredFile("types.sv");
+  ASSERT_NE(types_file, nullptr);
+  EXPECT_TRUE(symbol_table.RemoveTranslationUnit(*types_file).ok());
+  EXPECT_EQ(root_symbol.Value().local_references_to_bind.size(),
+            qq_root_references);
+  ASSERT_EQ(root_symbol.Children().size(), 1);
+  EXPECT_EQ(root_symbol.begin()->first, "qq");
+  EXPECT_EQ(s_type.resolved_symbol, nullptr);
+}
+
+TEST(BuildSymbolTableTest, RemoveTranslationUnitWithIncludeFails) {
+  const auto tempdir = ::testing::TempDir();
+  const std::string sources_dir = JoinPath(tempdir, __FUNCTION__);
+  ASSERT_TRUE(CreateDir(sources_dir).ok());
+
+  ScopedTestFile IncludedFile(sources_dir,
+                              "// verilog_syntax: parse-as-module-body\n"
+                              "wire ww;\n",
+                              "wires.sv");
+  ScopedTestFile pp_src(sources_dir,
+                        "module pp;\n"
+                        "`include \"wires.sv\"\n"
+                        "endmodule\n",
+                        "pp.sv");
+
+  VerilogProject project(sources_dir, {sources_dir});
+  const auto file_or_status =
+      project.OpenTranslationUnit(Basename(pp_src.filename()));
+  ASSERT_TRUE(file_or_status.ok()) << file_or_status.status().message();
+  const VerilogSourceFile* pp_file = *file_or_status;
+
+  SymbolTable symbol_table(&project);
+  std::vector<absl::Status> diagnostics;
+  symbol_table.BuildSingleTranslationUnit("pp.sv", &diagnostics);
+  EXPECT_EMPTY_STATUSES(diagnostics);
+
+  const absl::Status status = symbol_table.RemoveTranslationUnit(*pp_file);
+  EXPECT_EQ(status.code(), absl::StatusCode::kFailedPrecondition);
+  // The symbol table is unchanged.
+  MUST_ASSIGN_LOOKUP_SYMBOL(pp, symbol_table.Root(), "pp");
+  MUST_ASSIGN_LOOKUP_SYMBOL(pp_ww, pp, "ww");
+}
+
+TEST(BuildSymbolTableTest, RemoveTranslationUnitWithDuplicateFails) {
+  const auto tempdir = ::testing::TempDir();
+  const std::string sources_dir = JoinPath(tempdir, __FUNCTION__);
+  ASSERT_TRUE(CreateDir(sources_dir).ok());
+
+  ScopedTestFile pp_src(sources_dir,
+                        "module pp;\n"
+                        "endmodule\n",
+                        "pp.sv");
+  ScopedTestFile pp_again_src(sources_dir,
+                              "module pp;\n"
+                              "  wire ww;\n"
+                              "endmodule\n",
+                              "pp_again.sv");
+
+  VerilogProject project(sources_dir, {/* no include path */});
+  SymbolTable symbol_table(&project);
+  std::vector<absl::Status> diagnostics;
+  symbol_table.BuildSingleTranslationUnit("pp.sv", &diagnostics);
+  symbol_table.BuildSingleTranslationUnit("pp_again.sv", &diagnostics);
+  EXPECT_FALSE(diagnostics.empty());  // "pp" is already defined
+
+  // Both files contribute to the definition of "pp".
+  for (absl::string_view name : {"pp.sv", "pp_again.sv"}) {
+    const VerilogSourceFile* file = project.LookupRegisteredFile(name);
+    ASSERT_NE(file, nullptr);
+    EXPECT_EQ(symbol_table.RemoveTranslationUnit(*file).code(),
+              absl::StatusCode::kFailedPrecondition);
+  }
+  MUST_ASSIGN_LOOKUP_SYMBOL(pp, symbol_table.Root(), "pp");
+  MUST_ASSIGN_LOOKUP_SYMBOL(pp_ww, pp, "ww");
+}
+
+// Returns the definitions and references of 'symbol_table' as text.
+static std::string PrintSymbolTable(const SymbolTable& symbol_table) {
+  std::ostringstream stream;
+  symbol_table.PrintSymbolDefinitions(stream);
+  symbol_table.PrintSymbolReferences(stream);
+  return stream.str();
+}
+
+static std::vector<std::string> SortedMessages(
+    const std::vector<absl::Status>& diagnostics) {
+  std::vector<std::string> messages;
+  for (const auto& status : diagnostics) {
+    messages.emplace_back(status.message());
+  }
+  std::sort(messages.begin(), messages.end());
+  return messages;
+}
+
+TEST(BuildSymbolTableTest, BuildTranslationUnitsSameAsOneByOne) {
+  const auto tempdir = ::testing::TempDir();
+  const std::string sources_dir = JoinPath(tempdir, __FUNCTION__);
+  ASSERT_TRUE(CreateDir(sources_dir).ok());
+
+  const ScopedTestFile types_src(sources_dir,
+                                 "typedef struct { int a; } s_t;\n"
+                                 "class cc;\n"
+                                 "  extern function int ff();\n"
+                                 "endclass\n",
+                                 "types.sv");
+  // Has anonymous types at the root, and a duplicate module.
+  const ScopedTestFile enums_src(sources_dir,
+                                 "typedef enum { RED, GREEN } e_t;\n"
+                                 "module mm;\n"
+                                 "  wire ww;\n"
+                                 "endmodule\n",
+                                 "enums.sv");
+  // Defines a member of a class of another file.
+  const ScopedTestFile ff_src(sources_dir,
+                              "function int cc::ff();\n"
+                              "  return 1;\n"
+                              "endfunction\n",
+                              "ff.sv");
+  const ScopedTestFile mm_src(sources_dir,
+                              "module mm;\n"
+                              "  s_t ss;\n"
+                              "endmodule\n",
+                              "mm.sv");
+  const ScopedTestFile top_src(sources_dir,
+                               "module top;\n"
+                               "  mm mm_inst();\n"
+                               "  e_t ee;\n"
+                               "endmodule\n",
+                               "top.sv");
+  const ScopedTestFile top_again_src(sources_dir,
+                                     "module top;\n"
+                                     "  wire xx;\n"
+                                     "  cc cc_inst;\n"
+                                     "endmodule\n",
+                                     "top_again.sv");
+  const ScopedTestFile wires_src(sources_dir,
+                                 "// verilog_syntax: parse-as-module-body\n"
+                                 "wire yy;\n",
+                                 "wires.svh");
+  const ScopedTestFile includer_src(sources_dir,
+                                    "module includer;\n"
+                                    "`include \"wires.svh\"\n"
+                                    "endmodule\n",
+                                    "includer.sv");
+  const std::vector<std::string> file_names = {
+      "mm.sv",  "types.sv",     "enums.sv",    "ff.sv",
+      "top.sv", "top_again.sv", "includer.sv", "missing.sv"};
+
+  VerilogProject expected_project(sources_dir, {sources_dir});
+  SymbolTable expected_symbol_table(&expected_project);
+  std::vector<absl::Status> expected_diagnostics;
+  for (const auto& file_name : file_names) {
+    expected_symbol_table.BuildSingleTranslationUnit(file_name,
+                                                     &expected_diagnostics);
+  }
+  expected_symbol_table.Resolve(&expected_diagnostics);
+  EXPECT_FALSE(expected_diagnostics.empty());  // duplicates, missing file
+
+  for (int num_threads : {1, 2, 8}) {
+    VerilogProject project(sources_dir, {sources_dir});
+    SymbolTable symbol_table(&project);
+    std::vector<absl::Status> diagnostics;
+    symbol_table.BuildTranslationUnits(file_names, num_threads, &diagnostics);
+    symbol_table.Resolve(&diagnostics);
+
+    EXPECT_EQ(PrintSymbolTable(symbol_table),
+              PrintSymbolTable(expected_symbol_table))
+        << "threads: " << num_threads;
+    EXPECT_EQ(SortedMessages(diagnostics),
+              SortedMessages(expected_diagnostics))
+        << "threads: " << num_threads;
+
+    // Units are removable just the same.
+    for (absl::string_view name : {"mm.sv", "top.sv", "includer.sv"}) {
+      const VerilogSourceFile* file = project.LookupRegisteredFile(name);
+      ASSERT_NE(file, nullptr);
+      EXPECT_EQ(symbol_table.RemoveTranslationUnit(*file).code(),
+                absl::StatusCode::kFailedPrecondition)
+          << name;
+    }
+    const VerilogSourceFile* ff_file = project.LookupRegisteredFile("ff.sv");
+    ASSERT_NE(ff_file, nullptr);
+    EXPECT_TRUE(symbol_table.RemoveTranslationUnit(*ff_file).ok());
+  }
+}
+
+// Prints the names and metatypes of all symbols, and the references.
+// Unlike PrintSymbolDefinitions(), this does not show the syntax origins of
+// types, which symbols read from the cache do not have.
+static std::string PrintSymbolNamesAndReferences(
+    const SymbolTable& symbol_table) {
+  std::ostringstream stream;
+  symbol_table.Root().ApplyPreOrder([&](const SymbolTableNode& node) {
+    SymbolTableNodeFullPath(stream, node) << ' ' << node.Value().metatype
+                                          << std::endl;
+  });
+  symbol_table.PrintSymbolReferences(stream);
+  return stream.str();
+}
+
+TEST(BuildSymbolTableTest, CachedTranslationUnitsSameAsBuilt) {
+  const auto tempdir = ::testing::TempDir();
+  const std::string sources_dir = JoinPath(tempdir, __FUNCTION__);
+  // The cache directory is created by the first entry.
+  const std::string cache_dir = JoinPath(sources_dir, "cache");
+  ASSERT_TRUE(CreateDir(sources_dir).ok());
+
+  const ScopedTestFile types_src(sources_dir,
+                                 "typedef struct { int a; } s_t;\n"
+                                 "class cc;\n"
+                                 "  extern function int ff();\n"
+                                 "endclass\n",
+                                 "types.sv");
+  // Anonymous types at the root, which cannot be merged.
+  const ScopedTestFile enums_src(sources_dir,
+                                 "typedef enum { RED, GREEN } e_t;\n"
+                                 "module mm;\n"
+                                 "  wire ww;\n"
+                                 "endmodule\n",
+                                 "enums.sv");
+  const ScopedTestFile ff_src(sources_dir,
+                              "function int cc::ff();\n"
+                              "  return 1;\n"
+                              "endfunction\n",
+                              "ff.sv");
+  const ScopedTestFile mm_src(sources_dir,
+                              "module mm;\n"
+                              "  s_t ss;\n"
+                              "  assign ss.a = 1;\n"
+                              "endmodule\n",
+                              "mm.sv");
+  const ScopedTestFile top_src(sources_dir,
+                               "module top;\n"
+                               "  mm mm_inst();\n"
+                               "  e_t ee;\n"
+                               "endmodule\n",
+                               "top.sv");
+  const ScopedTestFile wires_src(sources_dir,
+                                 "// verilog_syntax: parse-as-module-body\n"
+                                 "wire yy;\n",
+                                 "wires.svh");
+  const ScopedTestFile includer_src(sources_dir,
+                                    "module includer;\n"
+                                    "`include \"wires.svh\"\n"
+                                    "endmodule\n",
+                                    "includer.sv");
+  const std::vector<std::string> file_names = {
+      "mm.sv", "types.sv", "enums.sv", "ff.sv", "top.sv", "includer.sv"};
+
+  VerilogProject expected_project(sources_dir, {sources_dir});
+  SymbolTable expected_symbol_table(&expected_project);
+  std::vector<absl::Status> expected_diagnostics;
+  expected_symbol_table.BuildTranslationUnits(file_names, 1,
+                                              &expected_diagnostics);
+  expected_symbol_table.Resolve(&expected_diagnostics);
+  EXPECT_FALSE(expected_diagnostics.empty());  // duplicate module
+
+  // The first pass fills the cache, the others read from it.
+  for (int pass = 0; pass < 3; ++pass) {
+    const int num_threads = pass == 2 ? 4 : 1;
+    VerilogProject project(sources_dir, {sources_dir});
+    SymbolTable symbol_table(&project);
+    symbol_table.SetCacheDirectory(cache_dir, "test-version");
+    std::vector<absl::Status> diagnostics;
+    symbol_table.BuildTranslationUnits(file_names, num_threads, &diagnostics);
+    symbol_table.Resolve(&diagnostics);
+
+    EXPECT_EQ(PrintSymbolNamesAndReferences(symbol_table),
+              PrintSymbolNamesAndReferences(expected_symbol_table))
+        << "pass: " << pass;
+    EXPECT_EQ(SortedMessages(diagnostics),
+              SortedMessages(expected_diagnostics))
+        << "pass: " << pass;
+
+    // Units with includes, and out-of-line definitions of other units'
+    // scopes are not cached.  Units with anonymous scopes that are merged
+    // into the root after other ones have to be parsed after all.
+    for (absl::string_view name :
+         {"mm.sv", "types.sv", "enums.sv", "ff.sv", "top.sv", "includer.sv"}) {
+      const VerilogSourceFile* file = project.LookupRegisteredFile(name);
+      ASSERT_NE(file, nullptr);
+      const bool cached = name == "mm.sv" || name == "types.sv" ||
+                          name == "top.sv";
+      EXPECT_EQ(file->is_parsed(), pass == 0 || !cached)
+          << name << " pass: " << pass;
+    }
+  }
+
+  // A different version does not use the entries.
+  VerilogProject project(sources_dir, {sources_dir});
+  SymbolTable symbol_table(&project);
+  symbol_table.SetCacheDirectory(cache_dir, "other-version");
+  std::vector<absl::Status> diagnostics;
+  symbol_table.BuildTranslationUnits(file_names, 1, &diagnostics);
+  const VerilogSourceFile* mm_file = project.LookupRegisteredFile("mm.sv");
+  ASSERT_NE(mm_file, nullptr);
+  EXPECT_TRUE(mm_file->is_parsed());
+}
+
+TEST(BuildSymbolTableTest, InvalidCacheEntriesAreIgnored) {
+  const auto tempdir = ::testing::TempDir();
+  const std::string sources_dir = JoinPath(tempdir, __FUNCTION__);
+  const std::string cache_dir = JoinPath(sources_dir, "cache");
+  ASSERT_TRUE(CreateDir(sources_dir).ok());
+  ASSERT_TRUE(CreateDir(cache_dir).ok());
+  const ScopedTestFile pp_src(sources_dir,
+                              "package pp;\n"
+                              "  typedef struct { int a; } s_t;\n"
+                              "  s_t ss;\n"
+                              "endpackage\n",
+                              "pp.sv");
+
+  std::string expected;
+  {
+    VerilogProject project(sources_dir, {sources_dir});
+    SymbolTable symbol_table(&project);
+    symbol_table.SetCacheDirectory(cache_dir, "test-version");
+    std::vector<absl::Status> diagnostics;
+    symbol_table.BuildTranslationUnits({"pp.sv"}, 1, &diagnostics);
+    EXPECT_TRUE(diagnostics.empty());
+    expected = PrintSymbolNamesAndReferences(symbol_table);
+  }
+
+  // Truncates the entry of the only unit.
+  const auto entries = verible::file::ListDir(cache_dir);
+  ASSERT_TRUE(entries.ok());
+  ASSERT_EQ(entries->files.size(), 1u);
+  const std::string& entry_path = entries->files.front();
+  const auto entry = verible::file::GetContentAsString(entry_path);
+  ASSERT_TRUE(entry.ok());
+  for (size_t length : {size_t{0}, entry->length() / 2, entry->length() - 1}) {
+    ASSERT_TRUE(
+        verible::file::SetContents(entry_path, entry->substr(0, length)).ok());
+    VerilogProject project(sources_dir, {sources_dir});
+    SymbolTable symbol_table(&project);
+    symbol_table.SetCacheDirectory(cache_dir, "test-version");
+    std::vector<absl::Status> diagnostics;
+    symbol_table.BuildTranslationUnits({"pp.sv"}, 1, &diagnostics);
+    EXPECT_TRUE(diagnostics.empty());
+    EXPECT_EQ(PrintSymbolNamesAndReferences(symbol_table), expected)
+        << "length: " << length;
+  }
+}
+
+TEST(BuildSymbolTableTest, ReleasedSyntaxTreesKeepSymbols) {
+  const auto tempdir = ::testing::TempDir();
+  const std::string sources_dir = JoinPath(tempdir, __FUNCTION__);
+  ASSERT_TRUE(CreateDir(sources_dir).ok());
+  const ScopedTestFile pp_src(sources_dir,
+                              "package pp;\n"
+                              "  typedef struct { int a; } s_t;\n"
+                              "endpackage\n",
+                              "pp.sv");
+  const ScopedTestFile mm_src(sources_dir,
+                              "module mm;\n"
+                              "  pp::s_t ss;\n"
+                              "  assign ss.a = 1;\n"
+                              "endmodule\n",
+                              "mm.sv");
+  const std::vector<std::string> file_names = {"pp.sv", "mm.sv"};
+
+  VerilogProject expected_project(sources_dir, {});
+  SymbolTable expected_symbol_table(&expected_project);
+  std::vector<absl::Status> expected_diagnostics;
+  expected_symbol_table.BuildTranslationUnits(file_names, 1,
+                                              &expected_diagnostics);
+  expected_symbol_table.Resolve(&expected_diagnostics);
+  EXPECT_TRUE(expected_diagnostics.empty());
+
+  // References are resolved after the syntax trees are gone.
+  VerilogProject project(sources_dir, {});
+  SymbolTable symbol_table(&project);
+  std::vector<absl::Status> diagnostics;
+  symbol_table.BuildTranslationUnits(file_names, 1, &diagnostics);
+  symbol_table.ReleaseSyntaxTrees();
+  symbol_table.Resolve(&diagnostics);
+  EXPECT_TRUE(diagnostics.empty());
+  EXPECT_EQ(PrintSymbolNamesAndReferences(symbol_table),
+            PrintSymbolNamesAndReferences(expected_symbol_table));
+
+  for (const auto& file : project) {
+    EXPECT_EQ(file.second->GetTextStructure(), nullptr) << file.first;
+    EXPECT_FALSE(file.second->GetContent().empty()) << file.first;
+  }
+  symbol_table.Root().ApplyPreOrder([](const SymbolInfo& info) {
+    EXPECT_EQ(info.syntax_origin, nullptr);
+    EXPECT_EQ(info.declared_type.syntax_origin, nullptr);
+  });
+}
+
+TEST(ResolveSymbolTableTest, ConcurrentlySameAsOneByOne) {
+  // Member references depend on the resolution of types, which come before
+  // or after them, with some unresolvable references in between.
+  TestVerilogSourceFile src("foobar.sv",
+                            "typedef struct { int aa; } s_t;\n"
+                            "typedef s_t t_t;\n"
+                            "class base_c;\n"
+                            "  int bb;\n"
+                            "endclass\n"
+                            "class derived_c extends base_c;\n"
+                            "  function int ff();\n"
+                            "    return bb + cc;\n"
+                            "  endfunction\n"
+                            "endclass\n"
+                            "module top;\n"
+                            "  wire ww;\n"
+                            "  t_t tt;\n"
+                            "  assign ww = tt.aa + tt.zz + uu;\n"
+                            "  mm mm_inst(.pp(ww), .qq(ww));\n"
+                            "  nn nn_inst(.pp(ww));\n"
+                            "endmodule\n"
+                            "module mm(input pp);\n"
+                            "  derived_c dd;\n"
+                            "  assign pp = dd.bb;\n"
+                            "endmodule\n");
+  ASSERT_TRUE(src.Parse().ok());
+
+  for (int num_threads : {2, 8}) {
+    SymbolTable expected_symbol_table(nullptr);
+    EXPECT_EMPTY_STATUSES(BuildSymbolTable(src, &expected_symbol_table));
+    SymbolTable symbol_table(nullptr);
+    EXPECT_EMPTY_STATUSES(BuildSymbolTable(src, &symbol_table));
+
+    // Resolving again only binds what is not bound yet.
+    for (int pass = 0; pass < 2; ++pass) {
+      std::vector<absl::Status> expected_diagnostics;
+      expected_symbol_table.Resolve(&expected_diagnostics);
+      std::vector<absl::Status> diagnostics;
+      symbol_table.Resolve(&diagnostics, num_threads);
+      if (pass == 0) {
+        EXPECT_FALSE(expected_diagnostics.empty());
+      }
+
+      std::ostringstream expected_references;
+      expected_symbol_table.PrintSymbolReferences(expected_references);
+      std::ostringstream references;
+      symbol_table.PrintSymbolReferences(references);
+      EXPECT_EQ(references.str(), expected_references.str())
+          << "threads: " << num_threads << ", pass: " << pass;
+      ASSERT_EQ(diagnostics.size(), expected_diagnostics.size())
+          << "threads: " << num_threads << ", pass: " << pass;
+      for (size_t i = 0; i < diagnostics.size(); ++i) {
+        EXPECT_EQ(diagnostics[i], expected_diagnostics[i]) << "#" << i;
+      }
+    }
+  }
+}
+
+TEST(BuildSymbolTableTest, CancelledBuildTranslationUnits) {
+  const auto tempdir = ::testing::TempDir();
+  const std::string sources_dir = JoinPath(tempdir, __FUNCTION__);
+  ASSERT_TRUE(CreateDir(sources_dir).ok());
+  const ScopedTestFile pp_src(sources_dir, "package pp;\nendpackage\n",
+                              "pp.sv");
+  const ScopedTestFile mm_src(sources_dir, "module mm;\nendmodule\n", "mm.sv");
+
+  for (int num_threads : {1, 4}) {
+    VerilogProject project(sources_dir, {sources_dir});
+    SymbolTable symbol_table(&project);
+    symbol_table.SetIsCancelled([]() { return true; });
+    std::vector<absl::Status> diagnostics;
+    symbol_table.BuildTranslationUnits({"pp.sv", "mm.sv"}, num_threads,
+                                       &diagnostics);
+    ASSERT_EQ(diagnostics.size(), 1u) << "threads: " << num_threads;
+    EXPECT_EQ(diagnostics.front().code(), absl::StatusCode::kCancelled);
+    EXPECT_TRUE(is_leaf(symbol_table.Root())) << "threads: " << num_threads;
+  }
+}
+
+TEST(ResolveSymbolTableTest, Cancelled) {
+  TestVerilogSourceFile src("foobar.sv",
+                            "module top;\n"
+                            "  wire ww;\n"
+                            "  assign ww = ww;\n"
+                            "  mm mm_inst(.pp(ww));\n"
+                            "endmodule\n"
+                            "module mm(input pp);\n"
+                            "endmodule\n");
+  ASSERT_TRUE(src.Parse().ok());
+
+  for (int num_threads : {1, 4}) {
+    SymbolTable expected_symbol_table(nullptr);
+    EXPECT_EMPTY_STATUSES(BuildSymbolTable(src, &expected_symbol_table));
+    std::ostringstream unresolved_references;
+    expected_symbol_table.PrintSymbolReferences(unresolved_references);
+    std::vector<absl::Status> expected_diagnostics;
+    expected_symbol_table.Resolve(&expected_diagnostics);
+    EXPECT_TRUE(expected_diagnostics.empty());
+    std::ostringstream expected_references;
+    expected_symbol_table.PrintSymbolReferences(expected_references);
+
+    SymbolTable symbol_table(nullptr);
+    EXPECT_EMPTY_STATUSES(BuildSymbolTable(src, &symbol_table));
+    symbol_table.SetIsCancelled([]() { return true; });
+    std::vector<absl::Status> diagnostics;
+    symbol_table.Resolve(&diagnostics, num_threads);
+    ASSERT_EQ(diagnostics.size(), 1u) << "threads: " << num_threads;
+    EXPECT_EQ(diagnostics.front().code(), absl::StatusCode::kCancelled);
+    std::ostringstream references;
+    symbol_table.PrintSymbolReferences(references);
+    EXPECT_EQ(references.str(), unresolved_references.str());
+
+    // Resolving again binds the references left unresolved.
+    symbol_table.SetIsCancelled(nullptr);
+    diagnostics.clear();
+    symbol_table.Resolve(&diagnostics, num_threads);
+    EXPECT_TRUE(diagnostics.empty());
+    references.str("");
+    symbol_table.PrintSymbolReferences(references);
+    EXPECT_EQ(references.str(), expected_references.str());
+  }
+}
+
+TEST(ResolveSymbolTableTest, ResolveReferenceAtOnDemand) {
+  TestVerilogSourceFile src("foobar.sv",
+                            "typedef struct { int aa; } s_t;\n"
+                            "typedef s_t t_t;\n"
+                            "class base_c;\n"
+                            "  int bb;\n"
+                            "endclass\n"
+                            "class derived_c extends base_c;\n"
+                            "endclass\n"
+                            "module top;\n"
+                            "  wire ww;\n"
+                            "  t_t tt;\n"
+                            "  derived_c dd;\n"
+                            "  assign ww = tt.aa + dd.bb + uu;\n"
+                            "endmodule\n");
+  ASSERT_TRUE(src.Parse().ok());
+  const absl::string_view text = src.GetTextStructure()->Contents();
+
+  SymbolTable expected_symbol_table(nullptr);
+  EXPECT_EMPTY_STATUSES(BuildSymbolTable(src, &expected_symbol_table));
+  std::vector<absl::Status> expected_diagnostics;
+  expected_symbol_table.Resolve(&expected_diagnostics);
+  std::ostringstream expected_references;
+  expected_symbol_table.PrintSymbolReferences(expected_references);
+
+  SymbolTable symbol_table(nullptr);
+  EXPECT_EMPTY_STATUSES(BuildSymbolTable(src, &symbol_table));
+  std::vector<absl::Status> diagnostics;
+  EXPECT_EQ(symbol_table.ResolveReferenceAt(text.data(), &diagnostics),
+            nullptr);
+
+  // Member lookups through a typedef and a base class.
+  for (const absl::string_view member : {"tt.aa", "dd.bb"}) {
+    const char* position = text.data() + text.find(member) + 3;
+    const ReferenceComponent* component =
+        symbol_table.ResolveReferenceAt(position, &diagnostics);
+    ASSERT_NE(component, nullptr) << member;
+    EXPECT_EQ(component->identifier, member.substr(3));
+    ASSERT_NE(component->resolved_symbol, nullptr) << member;
+    EXPECT_EQ(*component->resolved_symbol->Key(), member.substr(3));
+  }
+  EXPECT_TRUE(diagnostics.empty());
+
+  // Unresolvable references are diagnosed.
+  const ReferenceComponent* component = symbol_table.ResolveReferenceAt(
+      text.data() + text.find("uu"), &diagnostics);
+  ASSERT_NE(component, nullptr);
+  EXPECT_EQ(component->resolved_symbol, nullptr);
+  EXPECT_EQ(diagnostics.size(), 1u);
+
+  // A complete resolution binds the rest.
+  diagnostics.clear();
+  symbol_table.Resolve(&diagnostics);
+  std::ostringstream references;
+  symbol_table.PrintSymbolReferences(references);
+  EXPECT_EQ(references.str(), expected_references.str());
+}
+
 struct FileListTestCase {
   absl::string_view contents;
   std::vector<absl::string_view> expected_files;
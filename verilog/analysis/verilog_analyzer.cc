@@ -18,29 +18,47 @@
 #include "verilog/analysis/verilog_analyzer.h"
 
 #include <algorithm>
+#include <array>
 #include <cstddef>
+#include <cstdint>
 #include <iterator>
 #include <memory>
+#include <mutex>
+#include <optional>
+#include <ostream>
 #include <string>
 #include <utility>
 #include <vector>
 
+#include "absl/container/flat_hash_map.h"
+#include "absl/flags/flag.h"
 #include "absl/status/status.h"
+#include "absl/strings/match.h"
+#include "absl/strings/str_cat.h"
 #include "absl/strings/str_split.h"
 #include "absl/strings/string_view.h"
+#include "absl/time/clock.h"
+#include "absl/time/time.h"
 #include "common/analysis/file_analyzer.h"
 #include "common/lexer/token_stream_adapter.h"
+#include "common/strings/mem_block.h"
 #include "common/strings/comment_utils.h"
 #include "common/text/concrete_syntax_leaf.h"
 #include "common/text/concrete_syntax_tree.h"
+#include "common/text/constants.h"
 #include "common/text/symbol.h"
+#include "common/text/syntax_tree_arena.h"
 #include "common/text/text_structure.h"
 #include "common/text/token_info.h"
 #include "common/text/token_stream_view.h"
+#include "common/text/tree_utils.h"
 #include "common/text/visitors.h"
 #include "common/util/container_util.h"
 #include "common/util/logging.h"
 #include "common/util/status_macros.h"
+#include "common/util/thread_pool.h"
+#include "common/util/trace_events.h"
+#include "verilog/analysis/parse_cache.h"
 #include "verilog/analysis/verilog_excerpt_parse.h"
 #include "verilog/parser/verilog_lexer.h"
 #include "verilog/parser/verilog_lexical_context.h"
@@ -49,17 +67,139 @@
 #include "verilog/parser/verilog_token_enum.h"
 #include "verilog/preprocessor/verilog_preprocess.h"
 
+ABSL_FLAG(int, error_recovery_budget, 0,
+          "If positive, bounds the work of the parser on badly broken files: "
+          "once error recovery has discarded this many tokens in a row, it "
+          "skips ahead to the next top-level keyword (module, endmodule, "
+          "package, class, ...), and files that were mostly parsed despite "
+          "syntax errors are not parsed again in fallback modes. Syntax trees "
+          "of broken files may be less complete. 0: unbounded.");
+
+ABSL_FLAG(int, parallel_parse_threads, 0,
+          "If greater than 1, files of at least --parallel_parse_min_tokens "
+          "tokens are split between top-level declarations (after endmodule, "
+          "endinterface, endpackage, ... outside of `ifdef blocks), and the "
+          "parts are parsed in up to this many threads.  Files that can't be "
+          "split, or that have syntax errors, are parsed in one thread.");
+
+ABSL_FLAG(int, parallel_parse_min_tokens, 100000,
+          "Minimum number of tokens of the parts of a file that are parsed "
+          "in parallel with --parallel_parse_threads.");
+
+ABSL_FLAG(int, parallel_lex_threads, 0,
+          "If greater than 1, files of at least twice "
+          "--parallel_lex_min_bytes bytes are split into parts at line "
+          "ends, which are lexed in up to this many threads.  Parts that turn "
+          "out to start inside of a comment, string, macro definition, ... "
+          "are lexed again, so the tokens are the same as lexing in one "
+          "thread.");
+
+ABSL_FLAG(int, parallel_lex_min_bytes, 4 << 20,
+          "Minimum number of bytes of the parts of a file that are lexed "
+          "in parallel with --parallel_lex_threads.");
+
 namespace verilog {
 
 using verible::TokenInfo;
 using verible::TokenSequence;
 using verible::container::InsertKeyOrDie;
 
+namespace {
+// Returns the number of bytes held by the elements of a vector.
+template <typename T>
+size_t VectorBytes(const std::vector<T>& v) {
+  return v.capacity() * sizeof(T);
+}
+
+// Returns the time since 'start' of analysis 'phase' of 'filename', which is
+// also traced.
+absl::Duration TracedPhaseTime(absl::string_view phase, absl::Time start,
+                               absl::string_view filename) {
+  const absl::Time end = absl::Now();
+  verible::PipelineTrace().Record("analysis", phase, start, end, filename);
+  return end - start;
+}
+
+// Counts the nodes and leaves of a syntax tree, and estimates its size.
+class SyntaxTreeCounter : public verible::TreeVisitorRecursive {
+ public:
+  explicit SyntaxTreeCounter(VerilogAnalyzerStats* stats) : stats_(stats) {}
+
+  void Visit(const verible::SyntaxTreeLeaf&) final {
+    ++stats_->syntax_tree_leaves;
+    stats_->parse.bytes += sizeof(verible::SyntaxTreeLeaf);
+  }
+
+  void Visit(const verible::SyntaxTreeNode& node) final {
+    ++stats_->syntax_tree_nodes;
+    stats_->parse.bytes +=
+        sizeof(verible::SyntaxTreeNode) + VectorBytes(node.children());
+  }
+
+ private:
+  VerilogAnalyzerStats* const stats_;
+};
+}  // namespace
+
+std::ostream& operator<<(std::ostream& stream,
+                         const VerilogAnalyzerStats& stats) {
+  return stream << "input: " << stats.input_bytes << " bytes\n"
+                << "tokenize: " << stats.tokenize.time << ", "
+                << stats.raw_tokens << " tokens, " << stats.tokenize.bytes
+                << " bytes\n"
+                << "filter: " << stats.filter.time << ", "
+                << stats.filtered_tokens << " tokens, " << stats.filter.bytes
+                << " bytes\n"
+                << "contextualize: " << stats.contextualize.time << "\n"
+                << "preprocess: " << stats.preprocess.time << ", "
+                << stats.preprocessed_tokens << " tokens, "
+                << stats.preprocess.bytes << " bytes\n"
+                << "parse: " << stats.parse.time << ", "
+                << stats.syntax_tree_nodes << " nodes, "
+                << stats.syntax_tree_leaves << " leaves, "
+                << stats.parse.bytes << " bytes, max stack size "
+                << stats.max_used_stack_size
+                << (stats.dropped_tokens == 0
+                        ? ""
+                        : absl::StrCat(", ", stats.dropped_tokens,
+                                       " tokens dropped by error recovery"))
+                << "\n"
+                << "total: " << stats.TotalTime() << "\n";
+}
+
+VerilogAnalyzerStats VerilogAnalyzer::Stats() const {
+  VerilogAnalyzerStats stats(stats_);
+  if (Data().SyntaxTree() != nullptr) {
+    SyntaxTreeCounter counter(&stats);
+    Data().SyntaxTree()->Accept(&counter);
+  }
+  return stats;
+}
+
 absl::Status VerilogAnalyzer::Tokenize() {
   if (!tokenized_) {
-    VerilogLexer lexer{Data().Contents()};
+    const absl::Time start = absl::Now();
     tokenized_ = true;
-    lex_status_ = FileAnalyzer::Tokenize(&lexer);
+    const int threads = absl::GetFlag(FLAGS_parallel_lex_threads);
+    if (preprocess_config_.filter_branches &&
+        preprocess_config_.skip_filtered_branches) {
+      // The lexer follows the conditionals like the preprocessor of
+      // Analyze() does, from the same defines.
+      VerilogPreprocess preprocessor(preprocess_config_);
+      preprocessor.setPreprocessingInfo(preprocess_info_);
+      lex_status_ = FileAnalyzer::Tokenize(preprocessor.MakeLexer().get());
+    } else if (threads > 1) {
+      lex_status_ = FileAnalyzer::Tokenize(
+          [] { return std::make_unique<VerilogLexer>(""); },
+          std::max(absl::GetFlag(FLAGS_parallel_lex_min_bytes), 1), threads);
+    } else {
+      const BorrowedVerilogLexer lexer(BorrowVerilogLexer(Data().Contents()));
+      lex_status_ = FileAnalyzer::Tokenize(lexer.get());
+    }
+    stats_.tokenize.time = TracedPhaseTime("tokenize", start, filename_);
+    stats_.input_bytes = Data().Contents().size();
+    stats_.raw_tokens = Data().TokenStream().size();
+    stats_.tokenize.bytes = VectorBytes(Data().TokenStream());
   }
   return lex_status_;
 }
@@ -88,6 +228,350 @@ absl::string_view VerilogAnalyzer::ScanParsingModeDirective(
   return "";
 }
 
+// Returns true for keywords that start or end top-level declarations, at
+// which bounded error recovery resynchronizes (see --error_recovery_budget).
+static bool IsTopLevelKeyword(const verible::TokenInfo& token) {
+  switch (token.token_enum()) {
+    case TK_module:
+    case TK_macromodule:
+    case TK_endmodule:
+    case TK_interface:
+    case TK_endinterface:
+    case TK_program:
+    case TK_endprogram:
+    case TK_package:
+    case TK_endpackage:
+    case TK_class:
+    case TK_endclass:
+      return true;
+    default:
+      return false;
+  }
+}
+
+// Returns the indices of 'tokens' at which parsing can be split into parts of
+// at least 'min_part_tokens' tokens: right after the end of a top-level
+// declaration (and its label), outside of preprocessor conditionals and
+// library maps.  Nesting of declarations is only estimated from their
+// keywords; where that is wrong, parts fail to parse on their own.
+static std::vector<size_t> FindTopLevelSplitPoints(
+    const verible::TokenStreamView& tokens, size_t min_part_tokens) {
+  const auto token_enum = [&tokens](size_t i) {
+    return i < tokens.size() ? tokens[i]->token_enum() : verible::TK_EOF;
+  };
+  std::vector<size_t> splits;
+  int conditional_depth = 0;
+  int declaration_depth = 0;
+  bool in_library_map = false;
+  size_t part_begin = 0;
+  for (size_t i = 0; i < tokens.size(); ++i) {
+    switch (token_enum(i)) {
+      case PP_ifdef:
+      case PP_ifndef:
+        ++conditional_depth;
+        continue;
+      case PP_endif:
+        --conditional_depth;
+        continue;
+      case PD_LIBRARY_SYNTAX_BEGIN:
+        in_library_map = true;
+        continue;
+      case PD_LIBRARY_SYNTAX_END:
+        in_library_map = false;
+        continue;
+      case TK_interface:
+        // Not: interface class, virtual interface, interface ports.
+        if (token_enum(i + 1) == TK_class || token_enum(i + 1) == '.' ||
+            (i > 0 && (token_enum(i - 1) == TK_virtual ||
+                       token_enum(i - 1) == '(' || token_enum(i - 1) == ','))) {
+          continue;
+        }
+        [[fallthrough]];
+      case TK_module:
+      case TK_macromodule:
+      case TK_program:
+      case TK_package:
+      case TK_primitive:
+      case TK_config:
+        // extern module declarations have no end.
+        if (i == 0 || token_enum(i - 1) != TK_extern) ++declaration_depth;
+        continue;
+      case TK_endmodule:
+      case TK_endinterface:
+      case TK_endprogram:
+      case TK_endpackage:
+      case TK_endprimitive:
+      case TK_endconfig:
+        declaration_depth = std::max(declaration_depth - 1, 0);
+        break;
+      default:
+        continue;
+    }
+    if (conditional_depth != 0 || in_library_map || declaration_depth != 0) {
+      continue;
+    }
+    size_t split = i + 1;
+    if (split + 1 < tokens.size() && token_enum(split) == ':') {
+      split += 2;  // endmodule : label
+    }
+    if (split - part_begin < min_part_tokens) continue;
+    if (tokens.size() - split < min_part_tokens) break;
+    splits.push_back(split);
+    part_begin = split;
+    i = split - 1;
+  }
+  return splits;
+}
+
+// Returns true if tokens[i] opens a block in the body of a design element,
+// that SkeletonTokens() skips until the matching end keyword.
+static bool OpensSkeletonBlock(const verible::TokenStreamView& tokens,
+                               size_t i) {
+  const auto token_enum = [&tokens](size_t k) {
+    return k < tokens.size() ? tokens[k]->token_enum() : verible::TK_EOF;
+  };
+  const int previous = i > 0 ? token_enum(i - 1) : verible::TK_EOF;
+  switch (token_enum(i)) {
+    case TK_begin:
+    case TK_case:
+    case TK_casex:
+    case TK_casez:
+    case TK_randcase:
+    case TK_randsequence:
+    case TK_generate:
+    case TK_covergroup:
+    case TK_specify:
+    case TK_checker:
+      return true;
+    case TK_fork:  // Not: wait fork, disable fork.
+      return previous != TK_wait && previous != TK_disable;
+    case TK_class:  // Not: typedef class.
+      return previous != TK_typedef;
+    case TK_property:  // Not: assert property (...), etc.
+    case TK_sequence:
+      return previous != TK_assert && previous != TK_assume &&
+             previous != TK_cover && previous != TK_expect &&
+             previous != TK_restrict;
+    case TK_clocking:  // Not: default clocking name;
+      return token_enum(i + 2) != ';';
+    case TK_function:
+    case TK_task:
+      // Not: prototypes, e.g. extern function, pure virtual task.
+      for (size_t k = i; k > 0; --k) {
+        switch (token_enum(k - 1)) {
+          case TK_extern:
+          case TK_pure:
+            return false;
+          case TK_virtual:
+          case TK_static:
+          case TK_protected:
+          case TK_local:
+          case TK_forkjoin:
+            continue;
+          default:
+            return true;
+        }
+      }
+      return true;
+    default:
+      return false;
+  }
+}
+
+static bool ClosesSkeletonBlock(int token_enum) {
+  switch (token_enum) {
+    case TK_end:
+    case TK_endcase:
+    case TK_endsequence:  // also ends randsequence
+    case TK_join:
+    case TK_join_any:
+    case TK_join_none:
+    case TK_endgenerate:
+    case TK_endgroup:
+    case TK_endspecify:
+    case TK_endchecker:
+    case TK_endclass:
+    case TK_endproperty:
+    case TK_endclocking:
+    case TK_endfunction:
+    case TK_endtask:
+      return true;
+    default:
+      return false;
+  }
+}
+
+// Returns true for the keywords of the declarations that SkeletonTokens()
+// keeps in the bodies of design elements.
+static bool IsSkeletonItemKeyword(int token_enum) {
+  switch (token_enum) {
+    case TK_input:
+    case TK_output:
+    case TK_inout:
+    case TK_ref:
+    case TK_parameter:
+    case TK_localparam:
+    case TK_typedef:
+    case TK_import:
+    case TK_export:
+    case TK_modport:
+      return true;
+    default:
+      return false;
+  }
+}
+
+// Returns the tokens of a skeleton of 'tokens', which still parses like the
+// original: modules, interfaces, programs and packages keep their headers
+// (with parameter and port lists), and of their bodies only port, parameter,
+// type, import/export and modport declarations, and conditional compilation
+// around these.  Everything else in their bodies, e.g. statements,
+// instances and nested blocks, is skipped by matching brackets and
+// begin/end-like keywords up to the end of the design element.  Everything
+// outside of these design elements is kept.
+static verible::TokenStreamView SkeletonTokens(
+    const verible::TokenStreamView& tokens) {
+  const auto token_enum = [&tokens](size_t i) {
+    return i < tokens.size() ? tokens[i]->token_enum() : verible::TK_EOF;
+  };
+  verible::TokenStreamView skeleton;
+  skeleton.reserve(tokens.size());
+  // Copies tokens from 'i' up to and including the ';' that ends the
+  // declaration, and returns the index after it.  In headers, the ';' of
+  // package imports does not end the declaration.
+  const auto copy_declaration = [&](size_t i, bool header) {
+    int bracket_depth = 0;
+    bool in_import = false;
+    for (; i < tokens.size(); ++i) {
+      skeleton.push_back(tokens[i]);
+      switch (token_enum(i)) {
+        case '(':
+        case '[':
+        case '{':
+        case TK_LP:
+          ++bracket_depth;
+          break;
+        case ')':
+        case ']':
+        case '}':
+          bracket_depth = std::max(bracket_depth - 1, 0);
+          break;
+        case TK_import:
+          in_import = header && bracket_depth == 0;
+          break;
+        case ';':
+          if (bracket_depth != 0) break;
+          if (!in_import) return i + 1;
+          in_import = false;
+          break;
+        default:
+          break;
+      }
+    }
+    return i;
+  };
+  // Skips an optional ': label' after an end keyword at 'i'.
+  const auto after_label = [&](size_t i) {
+    return token_enum(i + 1) == ':' ? i + 3 : i + 1;
+  };
+
+  int element_depth = 0;  // of nested design elements
+  int block_depth = 0;    // of skipped blocks in the current element's body
+  int bracket_depth = 0;
+  size_t i = 0;
+  while (i < tokens.size()) {
+    const int current = token_enum(i);
+    switch (current) {
+      case TK_interface:
+        // Not: interface class, virtual interface, interface ports.
+        if (token_enum(i + 1) == TK_class || token_enum(i + 1) == '.' ||
+            (i > 0 && (token_enum(i - 1) == TK_virtual ||
+                       token_enum(i - 1) == '(' || token_enum(i - 1) == ','))) {
+          break;
+        }
+        [[fallthrough]];
+      case TK_module:
+      case TK_macromodule:
+      case TK_program:
+      case TK_package:
+        // extern module declarations have no body.
+        if (i > 0 && token_enum(i - 1) == TK_extern) break;
+        if (element_depth++ == 0) {
+          i = copy_declaration(i, /*header=*/true);
+          block_depth = 0;
+          bracket_depth = 0;
+          continue;
+        }
+        break;
+      case TK_endmodule:
+      case TK_endinterface:
+      case TK_endprogram:
+      case TK_endpackage:
+        if (element_depth == 0) break;
+        if (--element_depth == 0) {
+          const size_t end = std::min(after_label(i), tokens.size());
+          skeleton.insert(skeleton.end(), tokens.begin() + i,
+                          tokens.begin() + end);
+          i = end;
+          continue;
+        }
+        break;
+      default:
+        break;
+    }
+    if (element_depth == 0) {
+      skeleton.push_back(tokens[i++]);
+      continue;
+    }
+
+    // In the body of a design element.
+    if (element_depth == 1 && block_depth == 0 && bracket_depth == 0) {
+      if (IsSkeletonItemKeyword(current)) {
+        i = copy_declaration(i, /*header=*/false);
+        continue;
+      }
+      switch (current) {
+        case PP_ifdef:
+        case PP_ifndef:
+        case PP_elsif:
+          skeleton.push_back(tokens[i++]);
+          [[fallthrough]];  // the macro name
+        case PP_else:
+        case PP_endif:
+          if (i < tokens.size()) skeleton.push_back(tokens[i++]);
+          continue;
+        default:
+          break;
+      }
+    }
+    switch (current) {
+      case '(':
+      case '[':
+      case '{':
+      case TK_LP:
+        ++bracket_depth;
+        break;
+      case ')':
+      case ']':
+      case '}':
+        bracket_depth = std::max(bracket_depth - 1, 0);
+        break;
+      default:
+        if (element_depth != 1) break;
+        if (OpensSkeletonBlock(tokens, i)) {
+          ++block_depth;
+        } else if (ClosesSkeletonBlock(current) && block_depth > 0 &&
+                   --block_depth == 0) {
+          i = after_label(i);  // skipped along with the block
+          continue;
+        }
+        break;
+    }
+    ++i;
+  }
+  return skeleton;
+}
+
 // Return a secondary parsing mode to attempt, depending on the token type of
 // the first rejected token from parsing as top-level.
 static absl::string_view FailingTokenKeywordToParsingMode(
@@ -127,9 +611,86 @@ static absl::string_view FailingTokenKeywordToParsingMode(
   return "";
 }
 
+std::string VerilogAnalyzer::ParseCacheMode(absl::string_view analysis) const {
+  if (preprocess_config_.include_files || preprocess_config_.expand_macros) {
+    return "";
+  }
+  std::string mode = std::string(analysis);
+  if (preprocess_config_.filter_branches) {
+    mode.append(" filter_branches");
+    if (preprocess_config_.skip_filtered_branches) {
+      mode.append(" skip_filtered_branches");
+    }
+    for (const auto& define : preprocess_info_.defines) {
+      absl::StrAppend(&mode, " +define+", define.name, "=", define.value);
+    }
+  }
+  return mode;
+}
+
+bool VerilogAnalyzer::LoadFromParseCache(absl::string_view mode) {
+  const std::string& dir = ParseCacheDir();
+  if (dir.empty() || mode.empty() || tokenized_) return false;
+  const absl::Time start = absl::Now();
+  const absl::Status status = LoadParseCacheEntry(
+      ParseCachePath(dir, Data().Contents(), mode), this);
+  if (!status.ok()) {
+    VLOG(1) << "Parse cache miss: " << status.message();
+    return false;
+  }
+  tokenized_ = true;
+  lex_status_ = absl::OkStatus();
+  parse_status_ = absl::OkStatus();
+  stats_.tokenize.time = TracedPhaseTime("load-parse-cache", start, filename_);
+  stats_.input_bytes = Data().Contents().size();
+  stats_.raw_tokens = Data().TokenStream().size();
+  stats_.tokenize.bytes = VectorBytes(Data().TokenStream());
+  stats_.filtered_tokens = Data().GetTokenStreamView().size();
+  stats_.filter.bytes = VectorBytes(Data().GetTokenStreamView());
+  stats_.preprocessed_tokens = stats_.filtered_tokens;
+  return true;
+}
+
+void VerilogAnalyzer::StoreInParseCache(absl::string_view mode) const {
+  const std::string& dir = ParseCacheDir();
+  if (dir.empty() || mode.empty()) return;
+  if (!lex_status_.ok() || !parse_status_.ok() || !rejected_tokens_.empty()) {
+    return;
+  }
+  const absl::Status status =
+      StoreParseCacheEntry(ParseCachePath(dir, Data().Contents(), mode), Data());
+  if (!status.ok()) VLOG(1) << "Not cached: " << status.message();
+}
+
+absl::Status VerilogAnalyzer::AnalyzeWithParseCache() {
+  const std::string mode = ParseCacheMode("analyze");
+  if (LoadFromParseCache(mode)) return parse_status_;
+  const absl::Status status = Analyze();
+  StoreInParseCache(mode);
+  return status;
+}
+
 std::unique_ptr<VerilogAnalyzer> VerilogAnalyzer::AnalyzeAutomaticMode(
     const std::shared_ptr<verible::MemBlock>& text, absl::string_view name,
     const VerilogPreprocess::Config& preprocess_config) {
+  if (ParseCacheDir().empty()) {
+    return AnalyzeAutomaticModeUncached(text, name, preprocess_config);
+  }
+  auto cached =
+      std::make_unique<VerilogAnalyzer>(text, name, preprocess_config);
+  const std::string mode = cached->ParseCacheMode("auto");
+  if (cached->LoadFromParseCache(mode)) return cached;
+  auto analyzer = AnalyzeAutomaticModeUncached(text, name, preprocess_config);
+  // Results of alternate parsing modes are of a modified copy of the text.
+  if (analyzer->Data().Contents().data() == text->AsStringView().data()) {
+    analyzer->StoreInParseCache(mode);
+  }
+  return analyzer;
+}
+
+std::unique_ptr<VerilogAnalyzer> VerilogAnalyzer::AnalyzeAutomaticModeUncached(
+    const std::shared_ptr<verible::MemBlock>& text, absl::string_view name,
+    const VerilogPreprocess::Config& preprocess_config) {
   VLOG(2) << __FUNCTION__;
   auto analyzer =
       std::make_unique<VerilogAnalyzer>(text, name, preprocess_config);
@@ -212,15 +773,33 @@ std::unique_ptr<VerilogAnalyzer> VerilogAnalyzer::AnalyzeAutomaticMode(
 std::unique_ptr<VerilogAnalyzer>
 VerilogAnalyzer::AnalyzeAutomaticPreprocessFallback(absl::string_view text,
                                                     absl::string_view name) {
+  return AnalyzeAutomaticPreprocessFallback(
+      std::make_shared<verible::StringMemBlock>(text), name);
+}
+
+std::unique_ptr<VerilogAnalyzer>
+VerilogAnalyzer::AnalyzeAutomaticPreprocessFallback(
+    const std::shared_ptr<verible::MemBlock>& block, absl::string_view name) {
+  // The cache key does not depend on which of the configurations below
+  // succeeds, so that a hit saves the failed attempts, too.
+  static constexpr absl::string_view kCacheMode = "fallback";
+  const bool use_cache = !ParseCacheDir().empty();
+  if (use_cache) {
+    auto cached = std::make_unique<VerilogAnalyzer>(
+        block, name, VerilogPreprocess::Config());
+    if (cached->LoadFromParseCache(kCacheMode)) return cached;
+  }
+
   std::unique_ptr<verilog::VerilogAnalyzer> parser;
   for (bool preprocess_expand_macros : {false, true}) {
     bool expand_macro_status = false;
     for (bool preprocess_filter_branches : {false, true}) {
-      parser = verilog::VerilogAnalyzer::AnalyzeAutomaticMode(
-          text, name,
+      parser = verilog::VerilogAnalyzer::AnalyzeAutomaticModeUncached(
+          block, name,
           {.filter_branches = preprocess_filter_branches,
            .expand_macros = preprocess_expand_macros});
-      if (parser && parser->LexStatus().ok() && parser->ParseStatus().ok()) {
+      if (parser && parser->LexStatus().ok() &&
+          (parser->ParseStatus().ok() || parser->RecoveredMostOfText())) {
         expand_macro_status = true;
         break;
       }
@@ -229,9 +808,24 @@ VerilogAnalyzer::AnalyzeAutomaticPreprocessFallback(absl::string_view text,
     if (expand_macro_status) break;
     VLOG(1) << "Retry parsing with macro expanding enabled";
   }
+  if (use_cache && parser != nullptr &&
+      parser->Data().Contents().data() == block->AsStringView().data() &&
+      !parser->ParseCacheMode(kCacheMode).empty()) {
+    parser->StoreInParseCache(kCacheMode);
+  }
   return parser;
 }
 
+bool VerilogAnalyzer::RecoveredMostOfText() const {
+  // Parsing in other modes rarely gets through more of the text than this.
+  constexpr size_t kMaxDroppedPercent = 10;
+  if (absl::GetFlag(FLAGS_error_recovery_budget) <= 0) return false;
+  // Not if parsing did not even start, e.g. after preprocessor errors.
+  if (stats_.preprocessed_tokens == 0) return false;
+  return stats_.dropped_tokens * 100 <=
+         stats_.preprocessed_tokens * kMaxDroppedPercent;
+}
+
 void VerilogAnalyzer::FilterTokensForSyntaxTree() {
   MutableData().FilterTokens(&VerilogLexer::KeepSyntaxTreeTokens);
 }
@@ -241,23 +835,39 @@ void VerilogAnalyzer::ContextualizeTokens() {
   context.TransformVerilogSymbols(MutableData().MakeTokenStreamReferenceView());
 }
 
-// Analyzes Verilog code: lexer, filter, parser.
-// Result of parsing is stored in syntax_tree_ (if passed)
-// or rejected_token_ (if failed).
-absl::Status VerilogAnalyzer::Analyze() {
+absl::Status VerilogAnalyzer::AnalyzeTokens() {
   // Lex into tokens.
   RETURN_IF_ERROR(Tokenize());
 
   // Here would be one place to analyze the raw token stream.
+  absl::Time start = absl::Now();
   FilterTokensForSyntaxTree();
+  stats_.filter.time = TracedPhaseTime("filter", start, filename_);
+  stats_.filtered_tokens = Data().GetTokenStreamView().size();
+  stats_.filter.bytes = VectorBytes(Data().GetTokenStreamView());
 
   // Disambiguate tokens using lexical context.
+  start = absl::Now();
   ContextualizeTokens();
+  stats_.contextualize.time =
+      TracedPhaseTime("contextualize", start, filename_);
+  return absl::OkStatus();
+}
+
+// Analyzes Verilog code: lexer, filter, parser.
+// Result of parsing is stored in syntax_tree_ (if passed)
+// or rejected_token_ (if failed).
+absl::Status VerilogAnalyzer::Analyze() {
+  // Lex, filter and contextualize tokens.
+  RETURN_IF_ERROR(AnalyzeTokens());
+  absl::Time start;
 
   // pseudo-preprocess token stream.
   //   Not all analyses will want to preprocess.
   {
+    start = absl::Now();
     VerilogPreprocess preprocessor(preprocess_config_);
+    preprocessor.setPreprocessingInfo(preprocess_info_);
     preprocessor_data_ = preprocessor.ScanStream(Data().GetTokenStreamView());
     if (!preprocessor_data_.errors.empty()) {
       for (const auto& error : preprocessor_data_.errors) {
@@ -286,22 +896,112 @@ absl::Status VerilogAnalyzer::Analyze() {
     MutableData().MutableTokenStreamView() =
         preprocessor_data_.preprocessed_token_stream;  // copy
     // TODO(fangism): could we just move, swap, or directly reference?
+    stats_.preprocess.time = TracedPhaseTime("preprocess", start, filename_);
+    stats_.preprocessed_tokens = Data().GetTokenStreamView().size();
+    stats_.preprocess.bytes =
+        VectorBytes(preprocessor_data_.preprocessed_token_stream) +
+        VectorBytes(Data().GetTokenStreamView());
   }
 
-  auto generator = MakeTokenViewer(Data().GetTokenStreamView());
-  VerilogParser parser(&generator, filename_);
-  parse_status_ = FileAnalyzer::Parse(&parser);
-  // Here would be appropriate for analyzing the syntax tree.
-  max_used_stack_size_ = parser.MaxUsedStackSize();
+  start = absl::Now();
+  if (skeleton_) {
+    MutableData().MutableTokenStreamView() =
+        SkeletonTokens(Data().GetTokenStreamView());
+  }
+  if (!ParseInParallel()) {
+    auto generator = MakeTokenViewer(Data().GetTokenStreamView());
+    VerilogParser parser(&generator, filename_);
+    if (const int budget = absl::GetFlag(FLAGS_error_recovery_budget);
+        budget > 0) {
+      parser.SetErrorRecoveryLimit({budget, IsTopLevelKeyword, ';'});
+    }
+    parse_status_ = FileAnalyzer::Parse(&parser);
+    // Here would be appropriate for analyzing the syntax tree.
+    max_used_stack_size_ = parser.MaxUsedStackSize();
+    stats_.dropped_tokens = parser.DroppedTokens();
+  }
 
   // Expand macro arguments that are parseable as expressions.
   if (parse_status_.ok() && Data().SyntaxTree() != nullptr) {
     ExpandMacroCallArgExpressions();
   }
+  stats_.parse.time = TracedPhaseTime("parse", start, filename_);
+  stats_.max_used_stack_size = max_used_stack_size_;
 
   return parse_status_;
 }
 
+absl::Status VerilogAnalyzer::AnalyzeSkeleton() {
+  skeleton_ = true;
+  return Analyze();
+}
+
+bool VerilogAnalyzer::ParseInParallel() {
+  const int threads = absl::GetFlag(FLAGS_parallel_parse_threads);
+  if (threads <= 1) return false;
+  const verible::TokenStreamView& tokens = Data().GetTokenStreamView();
+  const size_t min_part_tokens = std::max<size_t>(
+      {1, static_cast<size_t>(
+              std::max(absl::GetFlag(FLAGS_parallel_parse_min_tokens), 0)),
+       tokens.size() / (4 * threads)});  // for balancing the threads' work
+  const std::vector<size_t> splits =
+      FindTopLevelSplitPoints(tokens, min_part_tokens);
+  if (splits.empty()) return false;
+
+  struct Part {
+    verible::ConcreteSyntaxTree root;
+    absl::Status status;
+    size_t max_used_stack_size = 0;
+  };
+  std::vector<Part> parts(splits.size() + 1);
+  const int budget = absl::GetFlag(FLAGS_error_recovery_budget);
+  // The calling thread parses, too.
+  verible::ThreadPool pool(std::min<int>(threads, parts.size()) - 1);
+  pool.ParallelFor(parts.size(), [&](size_t p) {
+    const size_t begin = p == 0 ? 0 : splits[p - 1];
+    const size_t end = p == splits.size() ? tokens.size() : splits[p];
+    const verible::TokenStreamView part_tokens(tokens.begin() + begin,
+                                               tokens.begin() + end);
+    auto generator = MakeTokenViewer(part_tokens);
+    VerilogParser parser(&generator, filename_);
+    if (budget > 0) {
+      parser.SetErrorRecoveryLimit({budget, IsTopLevelKeyword, ';'});
+    }
+    // Arenas are not thread-safe, but their nodes outlive them.
+    verible::SyntaxTreeArena arena;
+    {
+      const verible::SyntaxTreeArena::Scope arena_scope(&arena);
+      parts[p].status = parser.Parse();
+    }
+    parts[p].root = parser.TakeRoot();
+    parts[p].max_used_stack_size = parser.MaxUsedStackSize();
+  });
+  for (const Part& part : parts) {
+    if (!part.status.ok() || part.root == nullptr) {
+      VLOG(1) << filename_ << ": parts did not parse, parsing in one thread.";
+      return false;
+    }
+  }
+
+  // Stitch the descriptions of all parts into the tree of the first.
+  verible::SyntaxTreeNode& descriptions =
+      verible::SymbolCastToNode(*parts.front().root);
+  max_used_stack_size_ = 0;
+  for (Part& part : parts) {
+    max_used_stack_size_ =
+        std::max(max_used_stack_size_, part.max_used_stack_size);
+    if (&part == &parts.front()) continue;
+    for (verible::SymbolPtr& description :
+         verible::SymbolCastToNode(*part.root).mutable_children()) {
+      descriptions.AppendChild(std::move(description));
+    }
+  }
+  MutableData().MutableSyntaxTree() = std::move(parts.front().root);
+  parse_status_ = absl::OkStatus();
+  stats_.dropped_tokens = 0;
+  return true;
+}
+
 namespace {
 using verible::MutableTreeVisitorRecursive;
 using verible::SymbolPtr;
@@ -310,6 +1010,86 @@ using verible::SyntaxTreeNode;
 using verible::TextStructureView;
 using verible::TokenInfo;
 
+// Ways to parse the text of a macro call argument, in the order they are
+// tried by default.
+enum class MacroArgParseMode : uint8_t {
+  kExpression,
+  kPropertySpec,
+  kAutomatic,
+  kNone,  // None of the above parses it.
+};
+
+// Orders the parse modes by what the text of a macro argument looks like,
+// so that text that can't be an expression isn't tried as one first.
+// Only looks for what neither of the modes that are skipped accepts, so the
+// first mode that parses is the same as in the default order.
+std::array<MacroArgParseMode, 3> ClassifyMacroArg(absl::string_view text) {
+  bool statement = false;  // A ';' is neither expression nor property.
+  bool property = false;   // Implications and cycle delays aren't expressions.
+  for (size_t i = 0; i < text.size(); ++i) {
+    const char c = text[i];
+    const absl::string_view rest = text.substr(i);
+    if (c == '"') {  // Skip string literals.
+      for (++i; i < text.size() && text[i] != '"'; ++i) {
+        if (text[i] == '\\') ++i;
+      }
+    } else if (absl::StartsWith(rest, "//")) {
+      i = std::min(text.find('\n', i), text.size());
+    } else if (absl::StartsWith(rest, "/*")) {
+      i = std::min(text.find("*/", i + 2), text.size()) + 1;
+    } else if (c == ';') {
+      statement = true;
+    } else if (absl::StartsWith(rest, "|->") || absl::StartsWith(rest, "|=>") ||
+               absl::StartsWith(rest, "##")) {
+      property = true;
+    }
+  }
+  using M = MacroArgParseMode;
+  if (statement) return {M::kAutomatic, M::kExpression, M::kPropertySpec};
+  if (property) return {M::kPropertySpec, M::kExpression, M::kAutomatic};
+  return {M::kExpression, M::kPropertySpec, M::kAutomatic};
+}
+
+// Remembers which mode parsed the text of a macro argument, or that none
+// did, by preprocessor configuration and text.  The same arguments are
+// passed to macros all over a project, e.g. message ids to `uvm_info, and
+// it is mostly the attempts that fail that cost the time.
+class MacroArgParseModeCache {
+ public:
+  static MacroArgParseModeCache& Global() {
+    static auto* const cache = new MacroArgParseModeCache();
+    return *cache;
+  }
+
+  std::optional<MacroArgParseMode> Lookup(absl::string_view key) const {
+    const std::lock_guard<std::mutex> l(lock_);
+    const auto found = modes_.find(key);
+    if (found == modes_.end()) return std::nullopt;
+    return found->second;
+  }
+
+  void Insert(absl::string_view key, MacroArgParseMode mode) {
+    const std::lock_guard<std::mutex> l(lock_);
+    // Bounded; starting over is cheap compared to parsing.
+    if (modes_.size() >= kMaxEntries) modes_.clear();
+    modes_.emplace(key, mode);
+  }
+
+  static std::string Key(const VerilogPreprocess::Config& config,
+                         absl::string_view text) {
+    const char flags = static_cast<char>(
+        '0' + (config.filter_branches << 0) + (config.include_files << 1) +
+        (config.expand_macros << 2) + (config.skip_filtered_branches << 3));
+    return absl::StrCat(absl::string_view(&flags, 1), text);
+  }
+
+ private:
+  static constexpr size_t kMaxEntries = 1 << 16;
+
+  mutable std::mutex lock_;  // Guards modes_.
+  absl::flat_hash_map<std::string, MacroArgParseMode> modes_;
+};
+
 // Helper class to replace macro call argument nodes with expression trees.
 class MacroCallArgExpander : public MutableTreeVisitorRecursive {
  public:
@@ -325,25 +1105,26 @@ class MacroCallArgExpander : public MutableTreeVisitorRecursive {
     const TokenInfo& token(leaf.get());
     if (token.token_enum() == MacroArg) {
       VLOG(3) << "MacroCallArgExpander: examining token: " << token;
-      // Attempt to parse text as an expression.
-      std::unique_ptr<VerilogAnalyzer> expr_analyzer = AnalyzeVerilogExpression(
-          token.text(), absl::StrCat(outer_filename_, ":<macro-arg-expander>"),
-          preprocess_config_);
-      if (!expr_analyzer->ParseStatus().ok()) {
-        // If that failed, try to parse text as a property.
-        expr_analyzer = AnalyzeVerilogPropertySpec(
-            token.text(),
-            absl::StrCat(outer_filename_, ":<macro-arg-expander-property>"),
-            preprocess_config_);
-        if (!expr_analyzer->ParseStatus().ok()) {
-          // If that failed: try to infer parsing mode from comments
-          expr_analyzer = VerilogAnalyzer::AnalyzeAutomaticMode(
-              token.text(),
-              absl::StrCat(outer_filename_, ":<macro-arg-expander-auto>"),
-              preprocess_config_);
+      MacroArgParseModeCache& cache = MacroArgParseModeCache::Global();
+      const std::string cache_key =
+          MacroArgParseModeCache::Key(preprocess_config_, token.text());
+      std::unique_ptr<VerilogAnalyzer> expr_analyzer;
+      if (const auto known = cache.Lookup(cache_key); known.has_value()) {
+        if (*known != MacroArgParseMode::kNone) {
+          expr_analyzer = Analyze(token.text(), *known);
         }
+      } else {
+        MacroArgParseMode parsed_as = MacroArgParseMode::kNone;
+        for (const MacroArgParseMode mode : ClassifyMacroArg(token.text())) {
+          expr_analyzer = Analyze(token.text(), mode);
+          if (expr_analyzer->ParseStatus().ok()) {
+            parsed_as = mode;
+            break;
+          }
+        }
+        cache.Insert(cache_key, parsed_as);
       }
-      if (ABSL_DIE_IF_NULL(expr_analyzer)->LexStatus().ok() &&
+      if (expr_analyzer != nullptr && expr_analyzer->LexStatus().ok() &&
           expr_analyzer->ParseStatus().ok()) {
         VLOG(3) << "  ... content is parse-able, saving for expansion.";
         const auto& token_sequence = expr_analyzer->Data().TokenStream();
@@ -387,6 +1168,27 @@ class MacroCallArgExpander : public MutableTreeVisitorRecursive {
   }
 
  private:
+  std::unique_ptr<VerilogAnalyzer> Analyze(absl::string_view text,
+                                           MacroArgParseMode mode) const {
+    switch (mode) {
+      case MacroArgParseMode::kExpression:
+        return AnalyzeVerilogExpression(
+            text, absl::StrCat(outer_filename_, ":<macro-arg-expander>"),
+            preprocess_config_);
+      case MacroArgParseMode::kPropertySpec:
+        return AnalyzeVerilogPropertySpec(
+            text,
+            absl::StrCat(outer_filename_, ":<macro-arg-expander-property>"),
+            preprocess_config_);
+      default:
+        // Infer parsing mode from comments.
+        return VerilogAnalyzer::AnalyzeAutomaticModeUncached(
+            std::make_shared<verible::StringMemBlock>(text),
+            absl::StrCat(outer_filename_, ":<macro-arg-expander-auto>"),
+            preprocess_config_);
+    }
+  }
+
   // Deferred set of syntax tree nodes to expand.
   // Key: location.
   // Value: substring analysis results.
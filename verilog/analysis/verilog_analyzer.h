@@ -20,15 +20,71 @@
 #include <memory>
 #include <string>
 
+#include "absl/flags/declare.h"
 #include "absl/status/status.h"
 #include "absl/strings/string_view.h"
+#include "absl/time/time.h"
 #include "common/analysis/file_analyzer.h"
 #include "common/strings/mem_block.h"
 #include "common/text/token_stream_view.h"
+#include "verilog/analysis/verilog_filelist.h"
 #include "verilog/preprocessor/verilog_preprocess.h"
 
+// Flags are declared for testing purposes.
+ABSL_DECLARE_FLAG(int, error_recovery_budget);
+ABSL_DECLARE_FLAG(int, parallel_parse_threads);
+ABSL_DECLARE_FLAG(int, parallel_parse_min_tokens);
+ABSL_DECLARE_FLAG(int, parallel_lex_threads);
+ABSL_DECLARE_FLAG(int, parallel_lex_min_bytes);
+
 namespace verilog {
 
+// Statistics about the phases of VerilogAnalyzer::Analyze(), for finding out
+// which phases dominate the cost of analyzing a file.
+// Sizes in bytes are estimates of the memory held by the data structures
+// produced by each phase, not a count of all allocations.
+struct VerilogAnalyzerStats {
+  struct Phase {
+    absl::Duration time;
+    // Bytes held by the result of this phase.
+    size_t bytes = 0;
+  };
+
+  size_t input_bytes = 0;
+
+  // Lexing of the input text into tokens.
+  Phase tokenize;
+  size_t raw_tokens = 0;
+
+  // Filtering of comments and whitespace from the token stream.
+  Phase filter;
+  size_t filtered_tokens = 0;
+
+  // Context-based disambiguation of tokens (in-place).
+  Phase contextualize;
+
+  // Preprocessing of the token stream.
+  Phase preprocess;
+  size_t preprocessed_tokens = 0;
+
+  // Parsing into the syntax tree, including expansion of macro arguments.
+  Phase parse;
+  size_t syntax_tree_nodes = 0;
+  size_t syntax_tree_leaves = 0;
+  size_t max_used_stack_size = 0;
+  // Tokens that error recovery discarded or skipped, which are missing from
+  // the syntax tree.
+  size_t dropped_tokens = 0;
+
+  absl::Duration TotalTime() const {
+    return tokenize.time + filter.time + contextualize.time + preprocess.time +
+           parse.time;
+  }
+};
+
+// Prints one line per phase.
+std::ostream& operator<<(std::ostream&, const VerilogAnalyzerStats&);
+
 // VerilogAnalyzer analyzes Verilog and SystemVerilog code syntax.
 class VerilogAnalyzer : public verible::FileAnalyzer {
  public:
@@ -52,6 +108,13 @@ class VerilogAnalyzer : public verible::FileAnalyzer {
   VerilogAnalyzer(const VerilogAnalyzer&) = delete;
   VerilogAnalyzer(VerilogAnalyzer&&) = delete;
 
+  // Sets the defines and include directories that the preprocessor starts
+  // with, e.g. to filter the `ifdef branches of one configuration.
+  // Must be called before Analyze().
+  void SetPreprocessingInfo(const FileList::PreprocessingInfo& info) {
+    preprocess_info_ = info;
+  }
+
   // Lex-es the input text into tokens.
   absl::Status Tokenize() final;
 
@@ -59,23 +122,57 @@ class VerilogAnalyzer : public verible::FileAnalyzer {
   // The retained tokens will become leaves of a concrete syntax tree.
   void FilterTokensForSyntaxTree();
 
+  // Lexes, filters and contextualizes tokens: the part of Analyze() before
+  // preprocessing and parsing.  This is enough for analyses that only look
+  // at lines and tokens, and leaves the syntax tree empty.
+  absl::Status AnalyzeTokens();
+
   // Analyzes the syntax and structure of a source file (lex and parse).
   // Result of parsing is stored in syntax_tree_, which may contain gaps
   // if there are syntax errors.
   absl::Status Analyze();
 
+  // Like Analyze(), but only parses a skeleton of the design elements:
+  // modules, interfaces, programs and packages keep their headers and their
+  // port, parameter, type, import/export and modport declarations, as normal
+  // syntax tree nodes.  The rest of their bodies, e.g. statements and
+  // instances, is skipped by matching brackets and begin/end-like keywords
+  // in the token stream, and is neither in the token stream view nor in the
+  // syntax tree.  This is much cheaper than Analyze() for large bodies, for
+  // analyses that only need the interfaces of design elements.
+  // Results are not stored in the parse cache.
+  absl::Status AnalyzeSkeleton();
+
+  // Like Analyze(), but first looks for the result in the parse cache
+  // (--parse_cache_dir, see parse_cache.h), and stores it there if it is not
+  // found.  After loading from the cache, PreprocessorData() is empty, and
+  // Stats() only has sizes of the results.
+  absl::Status AnalyzeWithParseCache();
+
   absl::Status LexStatus() const { return lex_status_; }
 
   absl::Status ParseStatus() const { return parse_status_; }
 
   size_t MaxUsedStackSize() const { return max_used_stack_size_; }
 
+  // Returns statistics about the phases of Tokenize() and Analyze() that have
+  // run so far.  The size of the syntax tree is only computed here, so that
+  // Analyze() does not pay for it.
+  VerilogAnalyzerStats Stats() const;
+
   // Automatically analyze with the correct parsing mode, as detected
   // by parser directive comments.
+  // Uses the parse cache, like AnalyzeWithParseCache().
   static std::unique_ptr<VerilogAnalyzer> AnalyzeAutomaticMode(
       const std::shared_ptr<verible::MemBlock>& text, absl::string_view name,
       const VerilogPreprocess::Config& preprocess_config);
 
+  // Like AnalyzeAutomaticMode(), but never uses the parse cache, e.g. for
+  // excerpts and generated text that are not worth caching.
+  static std::unique_ptr<VerilogAnalyzer> AnalyzeAutomaticModeUncached(
+      const std::shared_ptr<verible::MemBlock>& text, absl::string_view name,
+      const VerilogPreprocess::Config& preprocess_config);
+
   static std::unique_ptr<VerilogAnalyzer> AnalyzeAutomaticMode(
       absl::string_view text, absl::string_view name,
       const VerilogPreprocess::Config& preprocess_config);
@@ -84,6 +181,12 @@ class VerilogAnalyzer : public verible::FileAnalyzer {
   // but attempt first with preprocessor disabled to get as complete as
   // possible parse tree; if this yields to syntax errors, fall back to
   // enabling preprocess branches.
+  // With --error_recovery_budget, a first attempt with syntax errors that
+  // still parsed most of the text is not retried.
+  // Uses the parse cache, like AnalyzeWithParseCache().
+  static std::unique_ptr<VerilogAnalyzer> AnalyzeAutomaticPreprocessFallback(
+      const std::shared_ptr<verible::MemBlock>& text, absl::string_view name);
+
   static std::unique_ptr<VerilogAnalyzer> AnalyzeAutomaticPreprocessFallback(
       absl::string_view text, absl::string_view name);
 
@@ -115,16 +218,51 @@ class VerilogAnalyzer : public verible::FileAnalyzer {
   // syntax tree.  If parsing fails, leave the MacroArg token unexpanded.
   void ExpandMacroCallArgExpressions();
 
+  // Returns true if bounded error recovery (--error_recovery_budget) is on,
+  // and Analyze() parsed most of the tokens despite syntax errors, so that
+  // parsing again in other modes is not worth it.
+  bool RecoveredMostOfText() const;
+
+  // With --parallel_parse_threads, parses the preprocessed tokens of a large
+  // file in parts, split between top-level declarations, in several threads,
+  // and joins their descriptions into one syntax tree.  Returns false,
+  // leaving the syntax tree alone, if the tokens can't be split or some part
+  // does not parse on its own; parsing all tokens in one thread then shows
+  // the errors the same way as without this option.
+  bool ParseInParallel();
+
+  // Returns the key of an analysis by entry point 'analysis' with this
+  // analyzer's preprocessing configuration in the parse cache, or an empty
+  // string if results of this configuration can't be cached: included files
+  // and expanded macros bring in tokens from outside the analyzed text.
+  std::string ParseCacheMode(absl::string_view analysis) const;
+
+  // Restores the result of an analysis in 'mode' from the parse cache.
+  // Returns true on success.
+  bool LoadFromParseCache(absl::string_view mode);
+
+  // Stores the result of an analysis in 'mode' in the parse cache, if it is
+  // free of diagnostics.
+  void StoreInParseCache(absl::string_view mode) const;
+
   // Information about parser internals.
 
   // True if input text has already been lexed.
   bool tokenized_ = false;
 
+  // True if only a skeleton is parsed, see AnalyzeSkeleton().
+  bool skeleton_ = false;
+
   // Maximum symbol stack depth.
   size_t max_used_stack_size_ = 0;
 
+  // Statistics collected by Tokenize() and Analyze().
+  VerilogAnalyzerStats stats_;
+
   // Preprocessor.
   const VerilogPreprocess::Config preprocess_config_;
+  // Referenced by the external macro definitions in preprocessor_data_.
+  FileList::PreprocessingInfo preprocess_info_;
   VerilogPreprocessData preprocessor_data_;
 
   // Status of lexing.
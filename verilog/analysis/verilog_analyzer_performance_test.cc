@@ -0,0 +1,75 @@
+// Copyright 2017-2023 The Verible Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// Pathological inputs to the analyzer, which have to be analyzed within a
+// time and memory budget, to catch complexity regressions.
+
+#include <cstdint>
+#include <string>
+
+#include "absl/status/status.h"
+#include "absl/strings/str_cat.h"
+#include "absl/time/time.h"
+#include "common/util/resource_budget_test_util.h"
+#include "gtest/gtest.h"
+#include "verilog/analysis/verilog_analyzer.h"
+
+namespace verilog {
+namespace {
+
+using verible::testing::MeasureResourceUsage;
+using verible::testing::ResourceBudget;
+using verible::testing::WithinBudget;
+
+constexpr int64_t kMiB = 1 << 20;
+
+void ExpectAnalyzedWithinBudget(const std::string& code,
+                                const ResourceBudget& budget) {
+  absl::Status status;
+  const auto usage = MeasureResourceUsage([&]() {
+    VerilogAnalyzer analyzer(code, "<filename>");
+    status = analyzer.Analyze();
+  });
+  EXPECT_TRUE(status.ok()) << status;
+  EXPECT_TRUE(WithinBudget(usage, budget));
+}
+
+// Macro calls with arguments of all kinds, which are expanded by parsing
+// them on their own.
+TEST(VerilogAnalyzerPerformanceTest, ManyMacroArgs) {
+  std::string code = "class c;\n  task run();\n";
+  for (int i = 0; i < 3000; ++i) {
+    absl::StrAppend(&code, "    `uvm_info(\"ID", i % 10,
+                    "\", $sformatf(\"count %0d\", count + ", i,
+                    "), UVM_LOW)\n", "    `MY_ASSERT(req", i % 7,
+                    " |-> ##[1:3] ack, \"no ack\")\n",
+                    "    `MY_STATEMENTS(x = ", i, "; y = x;)\n");
+  }
+  absl::StrAppend(&code, "  endtask\nendclass\n");
+  ExpectAnalyzedWithinBudget(code, {absl::Seconds(10), 512 * kMiB});
+}
+
+// Parsing of an expression nested deeply in parentheses.
+TEST(VerilogAnalyzerPerformanceTest, DeeplyNestedExpression) {
+  std::string expression = "a";
+  for (int i = 0; i < 300; ++i) {
+    expression = absl::StrCat("(", expression, " + b", i, ")");
+  }
+  ExpectAnalyzedWithinBudget(
+      absl::StrCat("module m;\n  assign x = ", expression, ";\nendmodule\n"),
+      {absl::Seconds(5), 256 * kMiB});
+}
+
+}  // namespace
+}  // namespace verilog
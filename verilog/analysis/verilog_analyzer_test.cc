@@ -16,13 +16,16 @@
 
 #include <iostream>
 #include <memory>
+#include <sstream>
 #include <string>
 #include <utility>
 #include <vector>
 
 #include "absl/base/casts.h"
+#include "absl/flags/flag.h"
 #include "absl/status/status.h"
 #include "absl/strings/match.h"
+#include "absl/strings/str_cat.h"
 #include "absl/strings/string_view.h"
 #include "absl/types/span.h"
 #include "common/analysis/file_analyzer.h"
@@ -35,6 +38,7 @@
 #include "common/text/token_info.h"
 #include "common/text/token_info_test_util.h"
 #include "common/text/token_stream_view.h"
+#include "common/text/tree_compare.h"
 #include "common/text/tree_utils.h"
 #include "common/util/casts.h"
 #include "common/util/logging.h"
@@ -92,6 +96,41 @@ TEST(AnalyzeVerilogTest, EmptyText) {
   EXPECT_OK(ABSL_DIE_IF_NULL(analyzer_ptr)->Analyze());
 }
 
+TEST(AnalyzeVerilogTest, StatsOfEmptyText) {
+  VerilogAnalyzer analyzer("", "<noname>");
+  EXPECT_OK(analyzer.Analyze());
+  const VerilogAnalyzerStats stats = analyzer.Stats();
+  EXPECT_EQ(stats.input_bytes, 0);
+  EXPECT_LE(stats.filtered_tokens, stats.raw_tokens);
+  EXPECT_EQ(stats.syntax_tree_leaves, 0);
+}
+
+TEST(AnalyzeVerilogTest, StatsCountTokensAndTree) {
+  constexpr absl::string_view kText =
+      "// comment\n"
+      "module foo;\n"
+      "  wire w;\n"
+      "endmodule\n";
+  VerilogAnalyzer analyzer(kText, "<noname>");
+  EXPECT_OK(analyzer.Analyze());
+  const VerilogAnalyzerStats stats = analyzer.Stats();
+  EXPECT_EQ(stats.input_bytes, kText.size());
+  EXPECT_EQ(stats.raw_tokens, analyzer.Data().TokenStream().size());
+  // Filtering drops the comment, whitespace and newlines.
+  EXPECT_LT(stats.filtered_tokens, stats.raw_tokens);
+  EXPECT_LE(stats.preprocessed_tokens, stats.filtered_tokens);
+  // module foo ; wire w ; endmodule
+  EXPECT_EQ(stats.syntax_tree_leaves, 7);
+  EXPECT_GT(stats.syntax_tree_nodes, 0);
+  EXPECT_GT(stats.parse.bytes, 0);
+  EXPECT_GE(stats.TotalTime(), stats.parse.time);
+  EXPECT_EQ(stats.max_used_stack_size, analyzer.MaxUsedStackSize());
+
+  std::ostringstream stream;
+  stream << stats;
+  EXPECT_TRUE(absl::StrContains(stream.str(), "7 leaves")) << stream.str();
+}
+
 // The following tests check Verilog lexer returns proper diagnostics:
 
 // Tests that invalid symbol identifier is rejected.
@@ -546,6 +585,216 @@ endmodule
   }
 }
 
+// Tests that bounded error recovery resumes at the next top-level keyword,
+// and keeps the rest of the file.
+TEST(VerilogAnalyzerTest, BoundedErrorRecovery) {
+  constexpr absl::string_view kCode =
+      "module m;\n"
+      "  wire w = = = = = = = = = = = = 1;\n"
+      "endmodule\n"
+      "module n;\n"
+      "  wire v;\n"
+      "endmodule\n";
+  for (const int budget : {0, 3}) {
+    absl::SetFlag(&FLAGS_error_recovery_budget, budget);
+    VerilogAnalyzer analyzer(kCode, "<file>");
+    EXPECT_FALSE(analyzer.Analyze().ok()) << budget;
+    ASSERT_THAT(analyzer.GetRejectedTokens(), SizeIs(1)) << budget;
+    EXPECT_GT(analyzer.Stats().dropped_tokens, 2) << budget;
+    const ConcreteSyntaxTree& tree = analyzer.Data().SyntaxTree();
+    ASSERT_NE(tree, nullptr) << budget;
+    const SyntaxTreeLeaf* last_leaf = verible::GetRightmostLeaf(*tree);
+    ASSERT_NE(last_leaf, nullptr) << budget;
+    EXPECT_EQ(last_leaf->get().token_enum(), TK_endmodule) << budget;
+    EXPECT_EQ(last_leaf->get().right(analyzer.Data().Contents()),
+              kCode.size() - 1)
+        << budget;
+  }
+  absl::SetFlag(&FLAGS_error_recovery_budget, 0);
+}
+
+// Tests that a valid file is parsed the same with bounded error recovery.
+TEST(VerilogAnalyzerTest, BoundedErrorRecoveryValidCode) {
+  absl::SetFlag(&FLAGS_error_recovery_budget, 1);
+  VerilogAnalyzer analyzer("module m; wire w = 1; endmodule\n", "<file>");
+  EXPECT_OK(analyzer.Analyze());
+  EXPECT_EQ(analyzer.Stats().dropped_tokens, 0);
+  absl::SetFlag(&FLAGS_error_recovery_budget, 0);
+}
+
+constexpr absl::string_view kTopLevelDeclarations =
+    "module a;\n"
+    "  module nested;\n"
+    "  endmodule\n"
+    "endmodule : a\n"
+    "`ifdef B\n"
+    "package b;\n"
+    "endpackage\n"
+    "`endif\n"
+    "interface c;\n"
+    "endinterface\n"
+    "module d;\n"
+    "  wire w;\n"
+    "endmodule\n";
+
+// Tests that parsing in parallel gives the same tree as parsing in one
+// thread, however small the parts.
+TEST(VerilogAnalyzerTest, ParallelParseSameTree) {
+  VerilogAnalyzer serial(kTopLevelDeclarations, "<file>");
+  ASSERT_OK(serial.Analyze());
+  absl::SetFlag(&FLAGS_parallel_parse_threads, 4);
+  for (const int min_tokens : {1, 5, 10, 1000}) {
+    absl::SetFlag(&FLAGS_parallel_parse_min_tokens, min_tokens);
+    VerilogAnalyzer parallel(kTopLevelDeclarations, "<file>");
+    ASSERT_OK(parallel.Analyze()) << min_tokens;
+    EXPECT_TRUE(verible::EqualTreesByEnumString(
+        serial.Data().SyntaxTree().get(), parallel.Data().SyntaxTree().get()))
+        << min_tokens;
+  }
+  absl::SetFlag(&FLAGS_parallel_parse_threads, 0);
+  absl::SetFlag(&FLAGS_parallel_parse_min_tokens, 100000);
+}
+
+// Tests that syntax errors are reported as without parsing in parallel.
+TEST(VerilogAnalyzerTest, ParallelParseSyntaxError) {
+  const std::string code = absl::StrCat(kTopLevelDeclarations,
+                                        "module e;\n  wire;\nendmodule\n");
+  VerilogAnalyzer serial(code, "<file>");
+  EXPECT_FALSE(serial.Analyze().ok());
+  absl::SetFlag(&FLAGS_parallel_parse_threads, 4);
+  absl::SetFlag(&FLAGS_parallel_parse_min_tokens, 1);
+  VerilogAnalyzer parallel(code, "<file>");
+  EXPECT_FALSE(parallel.Analyze().ok());
+  EXPECT_EQ(parallel.LinterTokenErrorMessages(false),
+            serial.LinterTokenErrorMessages(false));
+  absl::SetFlag(&FLAGS_parallel_parse_threads, 0);
+  absl::SetFlag(&FLAGS_parallel_parse_min_tokens, 100000);
+}
+
+// Tests that a skeleton keeps the headers and interface declarations of
+// design elements, and parses like a text of just these.
+TEST(VerilogAnalyzerTest, SkeletonKeepsHeadersAndDeclarations) {
+  constexpr absl::string_view kCode =
+      "module m import p::*; #(parameter int N = 1) (input a, output b);\n"
+      "  input c;\n"
+      "  localparam int M = {N, 2};\n"
+      "  wire w;\n"
+      "  sub #(.N(N)) u_sub(.a(a), .b(w));\n"
+      "  always @(posedge a) begin : proc\n"
+      "    case (w)\n"
+      "      1'b0: b <= '{default: 0};\n"
+      "    endcase\n"
+      "  end : proc\n"
+      "  function automatic int f(input int x);\n"
+      "    return x;\n"
+      "  endfunction\n"
+      "`ifdef D\n"
+      "  output d;\n"
+      "`endif\n"
+      "endmodule : m\n"
+      "package p;\n"
+      "  class c;\n"
+      "    pure virtual function void g();\n"
+      "  endclass\n"
+      "  typedef int t;\n"
+      "endpackage\n"
+      "interface i;\n"
+      "  logic l;\n"
+      "  modport mp(input l);\n"
+      "endinterface\n";
+  constexpr absl::string_view kSkeleton =
+      "module m import p::*; #(parameter int N = 1) (input a, output b);\n"
+      "  input c;\n"
+      "  localparam int M = {N, 2};\n"
+      "`ifdef D\n"
+      "  output d;\n"
+      "`endif\n"
+      "endmodule : m\n"
+      "package p;\n"
+      "  typedef int t;\n"
+      "endpackage\n"
+      "interface i;\n"
+      "  modport mp(input l);\n"
+      "endinterface\n";
+  VerilogAnalyzer skeleton(kCode, "<file>");
+  ASSERT_OK(skeleton.AnalyzeSkeleton());
+  VerilogAnalyzer expected(kSkeleton, "<file>");
+  ASSERT_OK(expected.Analyze());
+  EXPECT_TRUE(verible::EqualTreesByEnumString(
+      expected.Data().SyntaxTree().get(), skeleton.Data().SyntaxTree().get()));
+  EXPECT_EQ(skeleton.Data().GetTokenStreamView().size(),
+            expected.Data().GetTokenStreamView().size());
+}
+
+// Tests that a skeleton keeps everything outside of design elements.
+TEST(VerilogAnalyzerTest, SkeletonKeepsOtherDeclarations) {
+  constexpr absl::string_view kCode =
+      "class c;\n"
+      "  function void f();\n"
+      "    if (1) begin end\n"
+      "  endfunction\n"
+      "endclass\n"
+      "function automatic int g(int x);\n"
+      "  return x + 1;\n"
+      "endfunction\n"
+      "extern module e(input a);\n";
+  VerilogAnalyzer skeleton(kCode, "<file>");
+  ASSERT_OK(skeleton.AnalyzeSkeleton());
+  VerilogAnalyzer full(kCode, "<file>");
+  ASSERT_OK(full.Analyze());
+  EXPECT_TRUE(verible::EqualTreesByEnumString(
+      full.Data().SyntaxTree().get(), skeleton.Data().SyntaxTree().get()));
+}
+
+// Lines that parts lexed in parallel may start in, but that are not lexed
+// from the initial state.
+constexpr absl::string_view kMultiLineTokens =
+    "/* block\n"
+    "comment */ module m;\n"
+    "`define D(x) \\\n"
+    "  x + \\\n"
+    "  1\n"
+    "  string s = \"line \\\n"
+    "continued\";\n"
+    "  wire \\esc\n"
+    "  ;\n"
+    "  assign `D(\n"
+    "     a) = 1;\n"
+    "endmodule\n";
+
+// Tests that lexing in parallel gives the same tokens as lexing in one
+// thread, however small the parts.
+TEST(VerilogAnalyzerTest, ParallelLexSameTokens) {
+  VerilogAnalyzer serial(kMultiLineTokens, "<file>");
+  ASSERT_OK(serial.Tokenize());
+  absl::SetFlag(&FLAGS_parallel_lex_threads, 4);
+  for (const int min_bytes : {1, 5, 20, 1000}) {
+    absl::SetFlag(&FLAGS_parallel_lex_min_bytes, min_bytes);
+    VerilogAnalyzer parallel(kMultiLineTokens, "<file>");
+    ASSERT_OK(parallel.Tokenize()) << min_bytes;
+    EXPECT_EQ(parallel.Data().TokenStream(), serial.Data().TokenStream())
+        << min_bytes;
+  }
+  absl::SetFlag(&FLAGS_parallel_lex_threads, 0);
+  absl::SetFlag(&FLAGS_parallel_lex_min_bytes, 4 << 20);
+}
+
+// Tests that lexical errors are reported as without lexing in parallel.
+TEST(VerilogAnalyzerTest, ParallelLexError) {
+  const std::string code =
+      absl::StrCat(kMultiLineTokens, "/* unterminated\n\n");
+  VerilogAnalyzer serial(code, "<file>");
+  EXPECT_FALSE(serial.Tokenize().ok());
+  absl::SetFlag(&FLAGS_parallel_lex_threads, 4);
+  absl::SetFlag(&FLAGS_parallel_lex_min_bytes, 1);
+  VerilogAnalyzer parallel(code, "<file>");
+  EXPECT_FALSE(parallel.Tokenize().ok());
+  EXPECT_EQ(parallel.LinterTokenErrorMessages(false),
+            serial.LinterTokenErrorMessages(false));
+  absl::SetFlag(&FLAGS_parallel_lex_threads, 0);
+  absl::SetFlag(&FLAGS_parallel_lex_min_bytes, 4 << 20);
+}
+
 // Tests that automatic mode parsing can detect that some first failing
 // keywords will trigger (successful) re-parsing as a library map.
 TEST(AnalyzeVerilogAutomaticMode, InferredLibraryMapMode) {
@@ -853,6 +1102,47 @@ TEST(VerilogAnalyzerExpandsMacroArgsTest, MultipleMacroCalls) {
   }
 }
 
+// Test that an argument is expanded the same way each time it is seen.
+TEST(VerilogAnalyzerExpandsMacroArgsTest, RepeatedArg) {
+  for (int i = 0; i < 2; ++i) {
+    const TokenInfoTestData test = {
+        "`FOO(", {SymbolIdentifier, "repeated"}, '+', {TK_DecNumber, "1"},
+        ")\n`BAR(", {SymbolIdentifier, "repeated"}, '+', {TK_DecNumber, "1"},
+        ")\n"};
+    const auto analyzer =
+        std::make_unique<VerilogAnalyzer>(test.code, "<<inline>>");
+    EXPECT_OK(analyzer->Analyze());
+    const ConcreteSyntaxTree& tree = analyzer->SyntaxTree();
+    const auto search_tokens =
+        test.FindImportantTokens(analyzer->Data().Contents());
+    ASSERT_EQ(search_tokens.size(), 4);
+    for (const auto search_token : search_tokens) {
+      EXPECT_TRUE(TreeContainsToken(tree, search_token));
+    }
+  }
+}
+
+// Test that a property macro arg expands properly.
+TEST(VerilogAnalyzerExpandsMacroArgsTest, PropertyArg) {
+  const TokenInfoTestData test = {"`ASSERT(",
+                                  {SymbolIdentifier, "req"},
+                                  " ",
+                                  {TK_PIPEARROW, "|->"},
+                                  " ",
+                                  {SymbolIdentifier, "ack"},
+                                  ")\n"};
+  const auto analyzer =
+      std::make_unique<VerilogAnalyzer>(test.code, "<<inline>>");
+  EXPECT_OK(analyzer->Analyze());
+  const ConcreteSyntaxTree& tree = analyzer->SyntaxTree();
+  const auto search_tokens =
+      test.FindImportantTokens(analyzer->Data().Contents());
+  ASSERT_EQ(search_tokens.size(), 3);
+  for (const auto search_token : search_tokens) {
+    EXPECT_TRUE(TreeContainsToken(tree, search_token));
+  }
+}
+
 // Helper class for testing internals.
 class VerilogAnalyzerInternalsTest : public testing::Test,
                                      public VerilogAnalyzer {
@@ -21,7 +21,11 @@
 #include <cstddef>
 #include <iostream>
 #include <iterator>
+#include <optional>
+#include <sstream>
 #include <string>
+#include <utility>
+#include <vector>
 
 #include "absl/strings/string_view.h"
 #include "common/lexer/token_stream_adapter.h"
@@ -56,31 +60,103 @@ std::ostream& operator<<(std::ostream& stream, DiffStatus status) {
   return DiffStatusStringMap().Unparse(status, stream);
 }
 
+static void ReportLexError(absl::string_view text, const TokenInfo& err_tok,
+                           absl::string_view message,
+                           std::ostream* errstream) {
+  VLOG(1) << "lex error on: " << err_tok;
+  if (errstream != nullptr) {
+    (*errstream) << "Error lexing text: " << text << std::endl
+                 << "subtoken: " << err_tok << std::endl
+                 << message << std::endl;
+    // TODO(fangism): print relative offsets
+  }
+}
+
 // Lex a token into smaller substrings/subtokens.
 // Lexical errors are reported to errstream.
 // Returns true if lexing succeeded, false on error.
 static bool LexText(absl::string_view text, TokenSequence* subtokens,
                     std::ostream* errstream) {
   VLOG(1) << __FUNCTION__;
-  VerilogLexer lexer(text);
+  const BorrowedVerilogLexer lexer(BorrowVerilogLexer(text));
   // Reservation slot to capture first error token, if any.
   auto err_tok = TokenInfo::EOFToken(text);
   // Lex token's text into subtokens.
   const auto status = MakeTokenSequence(
-      &lexer, text, subtokens, [&](const TokenInfo& err) { err_tok = err; });
+      lexer.get(), text, subtokens,
+      [&](const TokenInfo& err) { err_tok = err; });
   if (!status.ok()) {
-    VLOG(1) << "lex error on: " << err_tok;
-    if (errstream != nullptr) {
-      (*errstream) << "Error lexing text: " << text << std::endl
-                   << "subtoken: " << err_tok << std::endl
-                   << status.message() << std::endl;
-      // TODO(fangism): print relative offsets
-    }
+    ReportLexError(text, err_tok, status.message(), errstream);
     return false;
   }
   return true;
 }
 
+namespace {
+// The tokens of a text that are not removed, lexed one at a time, so that
+// comparisons need not hold all of them.
+class FilteredTokenStream {
+ public:
+  FilteredTokenStream(
+      absl::string_view text,
+      const std::function<bool(const TokenInfo&)>& remove_predicate)
+      : text_(text),
+        lexer_(BorrowVerilogLexer(text)),
+        remove_predicate_(remove_predicate),
+        token_(TokenInfo::EOFToken(text)) {}
+
+  // Advances to the next token that is not removed, unless done().
+  // Returns false on lexical errors, which are reported to errstream.
+  bool Next(std::ostream* errstream) {
+    while (!done_) {
+      if (at_eof_) {
+        done_ = true;
+        break;
+      }
+      token_ = lexer_->DoNextToken();
+      if (lexer_->TokenIsError(token_)) {
+        ReportLexError(text_, token_, "Lexical error.", errstream);
+        return false;
+      }
+      if (token_.isEOF()) {
+        // Same as in MakeTokenSequence().
+        at_eof_ = true;
+        token_ = TokenInfo::EOFToken(text_);
+      }
+      if (!remove_predicate_(token_)) {
+        ++size_;
+        return true;
+      }
+    }
+    return true;
+  }
+
+  // Lexes the remaining tokens, only to count them and to find errors.
+  bool Drain(std::ostream* errstream) {
+    while (!done_) {
+      if (!Next(errstream)) return false;
+    }
+    return true;
+  }
+
+  // True past the last token; token() is only valid before.
+  bool done() const { return done_; }
+  const TokenInfo& token() const { return token_; }
+
+  // Number of tokens so far.
+  size_t size() const { return size_; }
+
+ private:
+  const absl::string_view text_;
+  const BorrowedVerilogLexer lexer_;
+  const std::function<bool(const TokenInfo&)>& remove_predicate_;
+  TokenInfo token_;
+  size_t size_ = 0;
+  bool at_eof_ = false;
+  bool done_ = false;
+};
+}  // namespace
+
 static void VerilogTokenPrinter(const TokenInfo& token, std::ostream& stream) {
   stream << '(' << verilog_symbol_name(token.token_enum()) << ") " << token;
 }
@@ -89,23 +165,124 @@ static bool ShouldRecursivelyAnalyzeToken(const TokenInfo& token) {
   return IsUnlexed(verilog_tokentype(token.token_enum()));
 }
 
+// Unlike LexicallyEquivalent(), lexes both sides in lockstep.  Past the first
+// mismatch, the rest is still lexed to count tokens and find lexical errors,
+// for the same results and diagnostics.
 DiffStatus VerilogLexicallyEquivalent(
-    absl::string_view left, absl::string_view right,
+    absl::string_view left_text, absl::string_view right_text,
     const std::function<bool(const verible::TokenInfo&)>& remove_predicate,
     const std::function<bool(const verible::TokenInfo&,
                              const verible::TokenInfo&)>& equal_comparator,
     std::ostream* errstream) {
-  // Bind some Verilog-specific parameters.
-  return LexicallyEquivalent(
-      left, right,
-      [=](absl::string_view text, TokenSequence* tokens) {
-        return LexText(text, tokens, errstream);
-      },
-      ShouldRecursivelyAnalyzeToken,  //
-      remove_predicate,               //
-      equal_comparator,               //
-      VerilogTokenPrinter,            //
-      errstream);
+  VLOG(2) << __FUNCTION__;
+  const auto left_error = [errstream]() {
+    if (errstream != nullptr) {
+      *errstream << "Lexical error from left input text." << std::endl;
+    }
+    return DiffStatus::kLeftError;
+  };
+  const auto right_error = [errstream]() {
+    if (errstream != nullptr) {
+      *errstream << "Lexical error from right input text." << std::endl;
+    }
+    return DiffStatus::kRightError;
+  };
+
+  // Diagnostics of the comparison, which are printed after the lengths of the
+  // token sequences, which are only known later.
+  std::ostringstream comparison_messages;
+  std::ostream* const comparison_stream =
+      errstream != nullptr ? &comparison_messages : nullptr;
+  DiffStatus diff_status = DiffStatus::kEquivalent;
+  const auto tokens_equivalent = [&](const TokenInfo& l, const TokenInfo& r) {
+    if (l.token_enum() != r.token_enum()) {
+      if (comparison_stream != nullptr) {
+        *comparison_stream << "Mismatched token enums.  got: ";
+        VerilogTokenPrinter(l, *comparison_stream);
+        *comparison_stream << " vs. ";
+        VerilogTokenPrinter(r, *comparison_stream);
+        *comparison_stream << std::endl;
+      }
+      return false;
+    }
+    if (ShouldRecursivelyAnalyzeToken(l)) {
+      // Recursively lex and compare.
+      VLOG(1) << "recursively lex-ing and comparing";
+      diff_status = VerilogLexicallyEquivalent(
+          l.text(), r.text(), remove_predicate, equal_comparator,
+          comparison_stream);
+      return diff_status == DiffStatus::kEquivalent;
+    }
+    return equal_comparator(l, r);
+  };
+
+  FilteredTokenStream left(left_text, remove_predicate);
+  FilteredTokenStream right(right_text, remove_predicate);
+  std::optional<std::pair<TokenInfo, TokenInfo>> mismatch;
+  while (true) {
+    if (!left.Next(errstream)) return left_error();
+    if (!right.Next(errstream)) {
+      // Errors on the left take precedence.
+      return left.Drain(errstream) ? right_error() : left_error();
+    }
+    if (left.done() || right.done()) break;
+    if (!tokens_equivalent(left.token(), right.token())) {
+      mismatch.emplace(left.token(), right.token());
+      break;
+    }
+  }
+  // The first excess token, if any.
+  const std::optional<TokenInfo> left_excess =
+      !mismatch && !left.done() ? std::make_optional(left.token())
+                                : std::nullopt;
+  const std::optional<TokenInfo> right_excess =
+      !mismatch && !right.done() ? std::make_optional(right.token())
+                                 : std::nullopt;
+  const size_t mismatch_index = left.size() - 1;
+  if (!left.Drain(errstream)) return left_error();
+  if (!right.Drain(errstream)) return right_error();
+
+  const size_t l_size = left.size();
+  const size_t r_size = right.size();
+  if (errstream != nullptr) {
+    if (l_size != r_size) {
+      *errstream << "Mismatch in token sequence lengths: " << l_size << " vs. "
+                 << r_size << std::endl;
+    }
+    *errstream << comparison_messages.str();
+  }
+
+  // Report lexical errors as higher precedence.
+  switch (diff_status) {
+    case DiffStatus::kLeftError:
+    case DiffStatus::kRightError:
+      return diff_status;
+    default:
+      break;
+  }
+
+  // Report differences.
+  if (!mismatch) {
+    if (l_size == r_size) return DiffStatus::kEquivalent;
+    if (errstream != nullptr) {
+      if (right_excess) {
+        *errstream << "First excess token in right sequence: " << *right_excess
+                   << std::endl;
+      } else {
+        *errstream << "First excess token in left sequence: " << *left_excess
+                   << std::endl;
+      }
+    }
+    return DiffStatus::kDifferent;
+  }
+  if (errstream != nullptr) {
+    *errstream << "First mismatched token [" << mismatch_index << "]: ";
+    VerilogTokenPrinter(mismatch->first, *errstream);
+    *errstream << " vs. ";
+    VerilogTokenPrinter(mismatch->second, *errstream);
+    *errstream << std::endl;
+  }
+  return DiffStatus::kDifferent;
 }
 
 DiffStatus LexicallyEquivalent(
@@ -140,13 +317,11 @@ DiffStatus LexicallyEquivalent(
 
   // Filter out ignored tokens from both token sequences.
   verible::TokenStreamView left_filtered, right_filtered;
-  verible::InitTokenStreamView(left_tokens, &left_filtered);
-  verible::InitTokenStreamView(right_tokens, &right_filtered);
   verible::TokenFilterPredicate keep_predicate = [&](const TokenInfo& t) {
     return !remove_predicate(t);
   };
-  verible::FilterTokenStreamViewInPlace(keep_predicate, &left_filtered);
-  verible::FilterTokenStreamViewInPlace(keep_predicate, &right_filtered);
+  verible::InitTokenStreamView(left_tokens, keep_predicate, &left_filtered);
+  verible::InitTokenStreamView(right_tokens, keep_predicate, &right_filtered);
 
   // Compare filtered views, starting with sizes.
   const size_t l_size = left_filtered.size();
@@ -251,6 +426,81 @@ DiffStatus FormatEquivalent(absl::string_view left, absl::string_view right,
       errstream);
 }
 
+// Appends the tokens of 'tokens' that are not whitespace to 'flat', replacing
+// unlexed tokens by their own sub-tokens.
+// Returns false on lexical errors, which are reported to errstream.
+static bool FlattenNonWhitespaceTokens(const TokenSequence& tokens,
+                                       std::vector<TokenInfo>* flat,
+                                       std::ostream* errstream) {
+  for (const TokenInfo& token : tokens) {
+    if (token.isEOF()) continue;
+    const auto token_type = verilog_tokentype(token.token_enum());
+    if (IsWhitespace(token_type)) continue;
+    if (IsUnlexed(token_type)) {
+      TokenSequence subtokens;
+      if (!LexText(token.text(), &subtokens, errstream) ||
+          !FlattenNonWhitespaceTokens(subtokens, flat, errstream)) {
+        return false;
+      }
+      continue;
+    }
+    flat->push_back(token);
+  }
+  return true;
+}
+
+DiffStatus FormatEquivalentTokens(const TokenSequence& left_tokens,
+                                  absl::string_view right,
+                                  std::ostream* errstream) {
+  std::vector<TokenInfo> left_flat, right_flat;
+  if (!FlattenNonWhitespaceTokens(left_tokens, &left_flat, errstream)) {
+    if (errstream != nullptr) {
+      *errstream << "Lexical error from left input text." << std::endl;
+    }
+    return DiffStatus::kLeftError;
+  }
+  TokenSequence right_tokens;
+  if (!LexText(right, &right_tokens, errstream) ||
+      !FlattenNonWhitespaceTokens(right_tokens, &right_flat, errstream)) {
+    if (errstream != nullptr) {
+      *errstream << "Lexical error from right input text." << std::endl;
+    }
+    return DiffStatus::kRightError;
+  }
+
+  const auto mismatch_pair = std::mismatch(
+      left_flat.begin(), left_flat.end(), right_flat.begin(), right_flat.end(),
+      [](const TokenInfo& l, const TokenInfo& r) {
+        return l.EquivalentWithoutLocation(r);
+      });
+  const bool left_end = mismatch_pair.first == left_flat.end();
+  const bool right_end = mismatch_pair.second == right_flat.end();
+  if (left_end && right_end) return DiffStatus::kEquivalent;
+
+  if (errstream != nullptr) {
+    if (left_flat.size() != right_flat.size()) {
+      *errstream << "Mismatch in token sequence lengths: " << left_flat.size()
+                 << " vs. " << right_flat.size() << std::endl;
+    }
+    if (left_end) {
+      *errstream << "First excess token in right sequence: "
+                 << *mismatch_pair.second << std::endl;
+    } else if (right_end) {
+      *errstream << "First excess token in left sequence: "
+                 << *mismatch_pair.first << std::endl;
+    } else {
+      *errstream << "First mismatched token ["
+                 << std::distance(left_flat.begin(), mismatch_pair.first)
+                 << "]: ";
+      VerilogTokenPrinter(*mismatch_pair.first, *errstream);
+      *errstream << " vs. ";
+      VerilogTokenPrinter(*mismatch_pair.second, *errstream);
+      *errstream << std::endl;
+    }
+  }
+  return DiffStatus::kDifferent;
+}
+
 static bool ObfuscationEquivalentTokens(const TokenInfo& l,
                                         const TokenInfo& r) {
   const auto l_vtoken_enum = verilog_tokentype(l.token_enum());
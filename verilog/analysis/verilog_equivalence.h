@@ -59,6 +59,8 @@ DiffStatus LexicallyEquivalent(
 // Returns a DiffStatus that captures 'equivalence' ignoring tokens filtered
 // out by remove_predicate, and using the equal_comparator binary predicate.
 // If errstream is provided, print detailed error message to that stream.
+// Same as LexicallyEquivalent() with the Verilog lexer, except that tokens
+// are compared as they are lexed, without holding all of them.
 DiffStatus VerilogLexicallyEquivalent(
     absl::string_view left, absl::string_view right,
     const std::function<bool(const verible::TokenInfo&)>& remove_predicate,
@@ -71,6 +73,15 @@ DiffStatus VerilogLexicallyEquivalent(
 DiffStatus FormatEquivalent(absl::string_view left, absl::string_view right,
                             std::ostream* errstream = nullptr);
 
+// Same as FormatEquivalent(), but 'left_tokens' are already lexed, e.g. the
+// TokenStream() of an analyzed TextStructure, in which macro arguments may
+// have been expanded into their own tokens.  Only 'right' is lexed.
+// Unlexed tokens (macro arguments and definition bodies) on either side are
+// compared by their sub-tokens, regardless of their boundaries.
+DiffStatus FormatEquivalentTokens(const verible::TokenSequence& left_tokens,
+                                  absl::string_view right,
+                                  std::ostream* errstream = nullptr);
+
 // Similar to FormatEquivalent except that:
 //   1) whitespaces must match
 //   2) identifiers only need to match in length and not string content to be
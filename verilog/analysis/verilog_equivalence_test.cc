@@ -22,10 +22,13 @@
 #include "absl/strings/match.h"
 #include "absl/strings/string_view.h"
 #include "absl/types/span.h"
+#include "common/lexer/token_stream_adapter.h"
 #include "common/text/token_info.h"
 #include "common/util/logging.h"
 #include "gmock/gmock.h"
 #include "gtest/gtest.h"
+#include "verilog/parser/verilog_lexer.h"
+#include "verilog/parser/verilog_token_enum.h"
 
 #undef EXPECT_OK
 #define EXPECT_OK(value) EXPECT_TRUE((value).ok())
@@ -281,6 +284,17 @@ TEST(FormatEquivalentTest, LexErrorOnLeft) {
                                                          << errs.str();
 }
 
+TEST(FormatEquivalentTest, LexErrorOnLeftAfterMismatch) {
+  // Lexical errors take precedence, even after the first difference.
+  std::ostringstream errs;
+  ExpectCompareWithErrstream(FormatEquivalent, DiffStatus::kLeftError,
+                             "module foo; 123badid\n", "module bar;\n",
+                             &errs);
+  EXPECT_TRUE(absl::StrContains(errs.str(), "error from left input"))
+      << "full message:\n"
+      << errs.str();
+}
+
 TEST(FormatEquivalentTest, LexErrorOnLeftInMacroArg) {
   std::ostringstream errs;
   ExpectCompareWithErrstream(FormatEquivalent, DiffStatus::kLeftError,
@@ -345,6 +359,67 @@ struct ObfuscationTestCase {
   DiffStatus expect_match;
 };
 
+// Returns the tokens of 'text', with macro arguments lexed into their own
+// tokens if 'expand_macro_args', like the analyzer does.
+static verible::TokenSequence LexTokens(absl::string_view text,
+                                        bool expand_macro_args) {
+  VerilogLexer lexer(text);
+  verible::TokenSequence tokens;
+  EXPECT_OK(verible::MakeTokenSequence(&lexer, text, &tokens,
+                                       [](const verible::TokenInfo&) {}));
+  if (!expand_macro_args) return tokens;
+  verible::TokenSequence expanded;
+  for (const auto& token : tokens) {
+    if (token.token_enum() == MacroArg) {
+      verible::TokenSequence subtokens = LexTokens(token.text(), false);
+      subtokens.pop_back();  // EOF
+      expanded.insert(expanded.end(), subtokens.begin(), subtokens.end());
+    } else {
+      expanded.push_back(token);
+    }
+  }
+  return expanded;
+}
+
+TEST(FormatEquivalentTest, LexedLeftSameAsText) {
+  const std::pair<const char*, const char*> kTestCases[] = {
+      {"", "\n"},
+      {"1;", "1 ;"},
+      {"1;", "1"},
+      {"a+b", "a + b"},
+      {"a+b", "a - b"},
+      {"// a\n", "  // a\n"},
+      {"// a\n", "/* a */"},
+      {"`f(a+b)", "`f(a + b)"},
+      {"`f(a+b)", "`f(a - b)"},
+      {"`f(a+b)", "`f(a,b)"},
+      {"`define X a+b\n", "`define X   a + b\n"},
+      {"`define X a+b\n", "`define X a + c\n"},
+      {"`define X a+b\n", "`define X a + b\n1"},
+  };
+  for (const auto& test : kTestCases) {
+    for (const bool expand_macro_args : {false, true}) {
+      std::ostringstream errstream;
+      EXPECT_EQ(
+          FormatEquivalentTokens(LexTokens(test.first, expand_macro_args),
+                                 test.second, &errstream),
+          FormatEquivalent(test.first, test.second))
+          << "left: " << test.first << "\nright: " << test.second << "\n"
+          << errstream.str();
+    }
+  }
+}
+
+TEST(FormatEquivalentTest, LexedLeftLexErrorOnRight) {
+  std::ostringstream errs;
+  EXPECT_EQ(FormatEquivalentTokens(LexTokens("`hello(good_id)", true),
+                                   "`hello(234badid)\n", &errs),
+            DiffStatus::kRightError);
+  EXPECT_TRUE(absl::StrContains(errs.str(), "error from right input"))
+      << "full message:\n"
+      << errs.str();
+}
+
 TEST(ObfuscationEquivalentTest, Various) {
   const ObfuscationTestCase kTestCases[] = {
       {"", "", DiffStatus::kEquivalent},
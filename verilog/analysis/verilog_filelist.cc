@@ -16,29 +16,31 @@
 
 #include <iosfwd>
 #include <iostream>
+#include <memory>
 #include <sstream>
 #include <string>
+#include <utility>
 #include <vector>
 
 #include "absl/status/status.h"
 #include "absl/strings/match.h"
 #include "absl/strings/str_split.h"
 #include "absl/strings/strip.h"
+#include "common/strings/mem_block.h"
 #include "common/util/file_util.h"
 #include "common/util/iterator_range.h"
+#include "common/util/status_macros.h"
 
 namespace verilog {
 absl::Status AppendFileListFromContent(absl::string_view file_list_path,
-                                       const std::string& file_list_content,
-                                       FileList* append_to) {
+                                       absl::string_view file_list_content,
+                                       FileListView* append_to) {
   constexpr absl::string_view kIncludeDirPrefix = "+incdir+";
   constexpr absl::string_view kDefineMacroPrefix = "+define+";
   append_to->preprocessing.include_dirs.emplace_back(
       ".");  // Should we do that?
-  std::string file_path;
-  std::istringstream stream(file_list_content);
-  while (std::getline(stream, file_path)) {
-    absl::RemoveExtraAsciiWhitespace(&file_path);
+  for (const absl::string_view line : absl::StrSplit(file_list_content, '\n')) {
+    const absl::string_view file_path = absl::StripAsciiWhitespace(line);
     // Ignore blank lines
     if (file_path.empty()) continue;
     // Ignore "# ..." comments
@@ -58,8 +60,9 @@ absl::Status AppendFileListFromContent(absl::string_view file_list_path,
       // Handle defines
       absl::string_view definition =
           absl::StripPrefix(file_path, kDefineMacroPrefix);
-      std::pair<std::string, std::string> define_value = absl::StrSplit(
-          definition, absl::MaxSplits('=', 1), absl::SkipEmpty());
+      std::pair<absl::string_view, absl::string_view> define_value =
+          absl::StrSplit(definition, absl::MaxSplits('=', 1),
+                         absl::SkipEmpty());
       if (!define_value.second.empty()) {
         append_to->preprocessing.defines.emplace_back(define_value.first,
                                                       define_value.second);
@@ -79,10 +82,45 @@ absl::Status AppendFileListFromContent(absl::string_view file_list_path,
 }
 
 absl::Status AppendFileListFromFile(absl::string_view file_list_file,
-                                    FileList* append_to) {
-  auto content_or = verible::file::GetContentAsString(file_list_file);
+                                    FileListView* append_to) {
+  auto content_or = verible::file::GetContentAsMemBlock(file_list_file);
   if (!content_or.ok()) return content_or.status();
-  return AppendFileListFromContent(file_list_file, *content_or, append_to);
+  const absl::string_view content = (*content_or)->AsStringView();
+  append_to->contents.push_back(std::move(*content_or));
+  return AppendFileListFromContent(file_list_file, content, append_to);
+}
+
+void FileListView::AppendTo(FileList* file_list) const {
+  file_list->file_paths.reserve(file_list->file_paths.size() +
+                                file_paths.size());
+  for (const absl::string_view file_path : file_paths) {
+    file_list->file_paths.emplace_back(file_path);
+  }
+  for (const absl::string_view include_dir : preprocessing.include_dirs) {
+    file_list->preprocessing.include_dirs.emplace_back(include_dir);
+  }
+  for (const auto& define : preprocessing.defines) {
+    file_list->preprocessing.defines.emplace_back(std::string(define.first),
+                                                  std::string(define.second));
+  }
+}
+
+absl::Status AppendFileListFromContent(absl::string_view file_list_path,
+                                       const std::string& file_list_content,
+                                       FileList* append_to) {
+  FileListView file_list;
+  RETURN_IF_ERROR(
+      AppendFileListFromContent(file_list_path, file_list_content, &file_list));
+  file_list.AppendTo(append_to);
+  return absl::OkStatus();
+}
+
+absl::Status AppendFileListFromFile(absl::string_view file_list_file,
+                                    FileList* append_to) {
+  FileListView file_list;
+  RETURN_IF_ERROR(AppendFileListFromFile(file_list_file, &file_list));
+  file_list.AppendTo(append_to);
+  return absl::OkStatus();
 }
 
 absl::Status AppendFileListFromCommandline(
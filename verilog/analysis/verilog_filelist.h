@@ -15,11 +15,14 @@
 #ifndef VERIBLE_VERILOG_ANALYSIS_VERILOG_FILELIST_H_
 #define VERIBLE_VERILOG_ANALYSIS_VERILOG_FILELIST_H_
 
+#include <memory>
 #include <string>
+#include <utility>
 #include <vector>
 
 #include "absl/status/status.h"
 #include "absl/strings/string_view.h"
+#include "common/strings/mem_block.h"
 
 namespace verilog {
 
@@ -64,6 +67,32 @@ struct FileList {
   std::string ToString() const;
 };
 
+// Same as FileList, but with views into the file list contents rather than
+// copies of each entry, which is cheaper for large file lists.
+// The contents must outlive the views: AppendFileListFromFile() keeps the
+// ones it reads in "contents".
+struct FileListView {
+  struct PreprocessingInfo {
+    // Directories where to search for the included files.
+    std::vector<absl::string_view> include_dirs;
+
+    // Defined macros, as (name, value) pairs.
+    std::vector<std::pair<absl::string_view, absl::string_view>> defines;
+  };
+
+  // Ordered list of files to compile.
+  std::vector<absl::string_view> file_paths;
+
+  // Information relevant to the preprocessor.
+  PreprocessingInfo preprocessing;
+
+  // Contents of the file lists read from files, which the views refer to.
+  std::vector<std::unique_ptr<verible::MemBlock>> contents;
+
+  // Appends copies of all entries to "file_list".
+  void AppendTo(FileList* file_list) const;
+};
+
 // Reads in a list of files line-by-line from "file_list_file" and
 // appends it to the given filelist.
 // Sets the "file_list_path" in FileList.
@@ -83,6 +112,17 @@ absl::Status AppendFileListFromContent(absl::string_view file_list_path,
                                        const std::string& file_list_content,
                                        FileList* append_to);
 
+// Same as above, with views into "file_list_content", which must outlive
+// "append_to".
+absl::Status AppendFileListFromContent(absl::string_view file_list_path,
+                                       absl::string_view file_list_content,
+                                       FileListView* append_to);
+
+// Same as above, reading the file list from "file_list_file", whose contents
+// "append_to" keeps.
+absl::Status AppendFileListFromFile(absl::string_view file_list_file,
+                                    FileListView* append_to);
+
 // Parse positional parameters from command line and extract files,
 // +incdir+ and +define+ and appends to FileList.
 // TODO: Also support --file_list_path (and -f), --file_list_root
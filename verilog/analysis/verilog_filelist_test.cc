@@ -14,6 +14,11 @@
 
 #include "verilog/analysis/verilog_filelist.h"
 
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "absl/strings/string_view.h"
 #include "common/util/file_util.h"
 #include "gmock/gmock.h"
 #include "gtest/gtest.h"
@@ -93,6 +98,55 @@ TEST(FileListTest, AppendFileListFromCommandline) {
                           macros[5]));
 }
 
+TEST(FileListTest, AppendFileListViewFromContent) {
+  const absl::string_view file_list_content =
+      "  +incdir+/an/include_dir1\n"
+      "  +define+macro1=a=b\n"
+      "  +define+invalid_macro\n"
+      "  # /not/a/file.sv\n"
+      "  /a/source/file/1.sv  \r\n"
+      "/a/source/file/2.sv";
+  FileListView result;
+  auto status = AppendFileListFromContent("list.f", file_list_content, &result);
+  ASSERT_TRUE(status.ok()) << status;
+
+  EXPECT_THAT(result.file_paths,
+              ElementsAre("/a/source/file/1.sv", "/a/source/file/2.sv"));
+  EXPECT_THAT(result.preprocessing.include_dirs,
+              ElementsAre(".", "/an/include_dir1"));
+  EXPECT_THAT(result.preprocessing.defines,
+              ElementsAre(std::make_pair("macro1", "a=b")));
+  // Entries are views into the content.
+  for (const absl::string_view file_path : result.file_paths) {
+    EXPECT_GE(file_path.begin(), file_list_content.begin());
+    EXPECT_LE(file_path.end(), file_list_content.end());
+  }
+
+  FileList file_list;
+  result.AppendTo(&file_list);
+  EXPECT_THAT(file_list.file_paths,
+              ElementsAre("/a/source/file/1.sv", "/a/source/file/2.sv"));
+  EXPECT_THAT(file_list.preprocessing.include_dirs,
+              ElementsAre(".", "/an/include_dir1"));
+  EXPECT_THAT(file_list.preprocessing.defines,
+              ElementsAre(TextMacroDefinition("macro1", "a=b")));
+}
+
+TEST(FileListTest, AppendFileListViewFromFile) {
+  const auto tempdir = ::testing::TempDir();
+  const ScopedTestFile file_list_file1(tempdir, "+incdir+dir1\nfile1.sv\n");
+  const ScopedTestFile file_list_file2(tempdir, "file2.sv\n");
+  FileListView result;
+  ASSERT_TRUE(AppendFileListFromFile(file_list_file1.filename(), &result).ok());
+  ASSERT_TRUE(AppendFileListFromFile(file_list_file2.filename(), &result).ok());
+  EXPECT_FALSE(AppendFileListFromFile("/no/such/file.f", &result).ok());
+
+  // The views outlive the files.
+  EXPECT_EQ(result.contents.size(), 2);
+  EXPECT_THAT(result.file_paths, ElementsAre("file1.sv", "file2.sv"));
+  EXPECT_THAT(result.preprocessing.include_dirs, ElementsAre(".", "dir1", "."));
+}
+
 TEST(FileListTest, ToString) {
   const auto tempdir = ::testing::TempDir();
   const std::string file_list_content = R"(
@@ -0,0 +1,268 @@
+// Copyright 2017-2023 The Verible Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "verilog/analysis/verilog_incremental_parse.h"
+
+#include <algorithm>
+#include <cstddef>
+#include <iterator>
+#include <memory>
+#include <utility>
+#include <vector>
+
+#include "absl/status/status.h"
+#include "absl/strings/match.h"
+#include "absl/strings/string_view.h"
+#include "common/text/concrete_syntax_leaf.h"
+#include "common/text/concrete_syntax_tree.h"
+#include "common/text/symbol.h"
+#include "common/text/text_structure.h"
+#include "common/text/token_info.h"
+#include "common/text/token_stream_view.h"
+#include "common/text/tree_utils.h"
+#include "common/util/logging.h"
+#include "verilog/CST/verilog_nonterminals.h"
+#include "verilog/analysis/verilog_analyzer.h"
+#include "verilog/parser/verilog_token_enum.h"
+
+namespace verilog {
+
+using verible::LeafMutator;
+using verible::Symbol;
+using verible::SymbolCastToNode;
+using verible::SymbolKind;
+using verible::SymbolPtr;
+using verible::OwnedTokenLeaf;
+using verible::SyntaxTreeNode;
+using verible::TextStructureView;
+using verible::TokenInfo;
+using verible::TokenSequence;
+
+// Preprocessor directives, compiler directives and macro calls all start with
+// a backtick.  Their effects are not confined to the description that contains
+// them, e.g. a `define or `ifdef changes the meaning of all text that follows.
+static bool HasPreprocessorTokens(const TokenSequence& tokens) {
+  return std::any_of(tokens.begin(), tokens.end(), [](const TokenInfo& token) {
+    return absl::StartsWith(token.text(), "`");
+  });
+}
+
+static bool IsDescriptionList(const SymbolPtr& tree) {
+  return tree != nullptr && tree->Kind() == SymbolKind::kNode &&
+         SymbolCastToNode(*tree).MatchesTag(NodeEnum::kDescriptionList);
+}
+
+// Returns a deep copy of 'symbol', with 'mutator' applied to all leaves.
+static SymbolPtr CopyTree(const Symbol* symbol, const LeafMutator& mutator) {
+  if (symbol == nullptr) return nullptr;
+  if (symbol->Kind() == SymbolKind::kLeaf) {
+    auto leaf = std::make_unique<OwnedTokenLeaf>(
+        verible::SymbolCastToLeaf(*symbol).get());
+    mutator(leaf->get_mutable());
+    return leaf;
+  }
+  const SyntaxTreeNode& node = SymbolCastToNode(*symbol);
+  auto copy = std::make_unique<SyntaxTreeNode>(node.Tag().tag);
+  copy->mutable_children().reserve(node.children().size());
+  for (const auto& child : node.children()) {
+    copy->AppendChild(CopyTree(child.get(), mutator));
+  }
+  return copy;
+}
+
+std::unique_ptr<VerilogAnalyzer> AnalyzeVerilogIncrementally(
+    const VerilogAnalyzer& previous, absl::string_view text,
+    absl::string_view filename) {
+  if (!previous.LexStatus().ok() || !previous.ParseStatus().ok()) {
+    return nullptr;
+  }
+  const TextStructureView& previous_data = previous.Data();
+  if (!IsDescriptionList(previous_data.SyntaxTree())) return nullptr;
+  if (HasPreprocessorTokens(previous_data.TokenStream())) return nullptr;
+  const absl::string_view previous_text = previous_data.Contents();
+
+  // The edit replaced [common_prefix, previous_text.size() - common_suffix)
+  // of the previous text with [common_prefix, text.size() - common_suffix).
+  const size_t max_common = std::min(previous_text.size(), text.size());
+  size_t common_prefix = 0;
+  while (common_prefix < max_common &&
+         previous_text[common_prefix] == text[common_prefix]) {
+    ++common_prefix;
+  }
+  size_t common_suffix = 0;
+  while (common_suffix < max_common - common_prefix &&
+         previous_text[previous_text.size() - 1 - common_suffix] ==
+             text[text.size() - 1 - common_suffix]) {
+    ++common_suffix;
+  }
+  const size_t edit_end = previous_text.size() - common_suffix;
+
+  // Descriptions that end strictly before the edit, or start after it are
+  // reused.  A description that ends right where the edit starts is not,
+  // because the edit could extend its last token.
+  // Everything in between (descriptions, comments and whitespace) is
+  // analyzed again: [region_begin, region_end) of the previous text.
+  const auto& descriptions =
+      SymbolCastToNode(*previous_data.SyntaxTree()).children();
+  size_t region_begin = 0;
+  size_t region_end = previous_text.size();
+  size_t first_edited = 0;
+  size_t end_edited = descriptions.size();
+  for (size_t i = 0; i < descriptions.size(); ++i) {
+    if (descriptions[i] == nullptr) continue;
+    const absl::string_view span =
+        verible::StringSpanOfSymbol(*descriptions[i]);
+    if (span.empty()) return nullptr;
+    const size_t begin = std::distance(previous_text.begin(), span.begin());
+    const size_t end = begin + span.length();
+    if (end < common_prefix) {
+      region_begin = end;
+      first_edited = i + 1;
+    } else if (begin >= edit_end) {
+      region_end = begin;
+      end_edited = i;
+      break;
+    }
+  }
+  if (first_edited == 0 && end_edited == descriptions.size()) {
+    VLOG(1) << "No description to reuse, a full analysis is required.";
+    return nullptr;
+  }
+
+  const ptrdiff_t size_delta = static_cast<ptrdiff_t>(text.size()) -
+                               static_cast<ptrdiff_t>(previous_text.size());
+  const size_t new_region_end = region_end + size_delta;
+  const absl::string_view region =
+      text.substr(region_begin, new_region_end - region_begin);
+  // The lexer has to reach the start of the following description in the
+  // same state as if the whole text were lexed, which is guaranteed at the
+  // start of a line: line comments end there, and unterminated block comments
+  // or strings fail to lex, below.
+  if (end_edited < descriptions.size() &&
+      (region.empty() || region.back() != '\n')) {
+    return nullptr;
+  }
+  // Parser directive comments change how the whole text is parsed.
+  if (absl::StrContains(region, "verilog_syntax:")) return nullptr;
+
+  // The region is analyzed standalone, as the contents of a file.  It keeps
+  // its own copy of the text, as required by ExpandSubtrees().
+  VerilogAnalyzer region_analyzer(region, filename);
+  if (!region_analyzer.Analyze().ok()) return nullptr;
+  if (HasPreprocessorTokens(region_analyzer.Data().TokenStream())) {
+    return nullptr;
+  }
+  // A region without descriptions results in an empty, untagged node.
+  const SymbolPtr& region_tree = region_analyzer.Data().SyntaxTree();
+  if (region_tree != nullptr && !IsDescriptionList(region_tree) &&
+      !(region_tree->Kind() == SymbolKind::kNode &&
+        SymbolCastToNode(*region_tree).children().empty())) {
+    return nullptr;
+  }
+
+  auto analyzer = std::make_unique<VerilogAnalyzer>(text, filename);
+  TextStructureView& data = analyzer->MutableData();
+  const absl::string_view new_text = data.Contents();
+  // Points tokens from the previous text outside of the region into new_text.
+  const LeafMutator rebase = [&](TokenInfo* token) {
+    const size_t offset = token->left(previous_text);
+    token->RebaseStringView(new_text.begin() + offset +
+                            (offset >= region_end ? size_delta : 0));
+  };
+  // The region is represented by a single placeholder token and leaf, which
+  // ExpandSubtrees() replaces with the region's analysis.
+  const TokenInfo placeholder(verilog_tokentype::TK_OTHER,
+                              new_text.substr(region_begin, region.length()));
+
+  // Copy the tokens outside of the region, and keep track of which of them
+  // were in the filtered token stream view.
+  const TokenSequence& previous_tokens = previous_data.TokenStream();
+  const auto& previous_view = previous_data.GetTokenStreamView();
+  TokenSequence& tokens = data.MutableTokenStream();
+  tokens.reserve(previous_tokens.size() + 1);
+  std::vector<size_t> view_indices;
+  view_indices.reserve(previous_view.size() + 1);
+  auto view_iter = previous_view.begin();
+  bool placeholder_added = false;
+  for (auto token_iter = previous_tokens.begin();
+       token_iter != previous_tokens.end(); ++token_iter) {
+    const bool in_view =
+        view_iter != previous_view.end() && *view_iter == token_iter;
+    if (in_view) ++view_iter;
+    const size_t left = token_iter->left(previous_text);
+    if (left >= region_end && !placeholder_added) {
+      view_indices.push_back(tokens.size());
+      tokens.push_back(placeholder);
+      placeholder_added = true;
+    }
+    const size_t right = token_iter->right(previous_text);
+    if (right > region_begin && left < region_end) {
+      continue;  // Inside the region.
+    }
+    if (in_view) view_indices.push_back(tokens.size());
+    tokens.push_back(*token_iter);
+    rebase(&tokens.back());
+  }
+  // The EOF token always follows the region.
+  if (!placeholder_added) return nullptr;
+  verible::TokenStreamView& view = data.MutableTokenStreamView();
+  view.reserve(view_indices.size());
+  for (const size_t index : view_indices) {
+    view.push_back(tokens.cbegin() + index);
+  }
+
+  // Copy the reused descriptions around the placeholder.
+  auto root = std::make_unique<SyntaxTreeNode>(
+      static_cast<int>(NodeEnum::kDescriptionList));
+  std::vector<SymbolPtr>& children = root->mutable_children();
+  children.reserve(first_edited + 1 + descriptions.size() - end_edited);
+  for (size_t i = 0; i < first_edited; ++i) {
+    children.push_back(CopyTree(descriptions[i].get(), rebase));
+  }
+  const size_t expansion_index = children.size();
+  children.push_back(std::make_unique<OwnedTokenLeaf>(placeholder));
+  for (size_t i = end_edited; i < descriptions.size(); ++i) {
+    children.push_back(CopyTree(descriptions[i].get(), rebase));
+  }
+  data.MutableSyntaxTree() = std::move(root);
+
+  TextStructureView::NodeExpansionMap expansions;
+  expansions.emplace(region_begin, TextStructureView::DeferredExpansion{
+                                       &children[expansion_index],
+                                       region_analyzer.ReleaseTextStructure()});
+  data.ExpandSubtrees(&expansions);
+
+  // Flatten the region's description list into the top-level list.
+  SymbolPtr region_descriptions = std::move(children[expansion_index]);
+  children.erase(children.begin() + expansion_index);
+  if (region_descriptions != nullptr) {
+    auto& region_children =
+        SymbolCastToNode(*region_descriptions).mutable_children();
+    children.insert(children.begin() + expansion_index,
+                    std::make_move_iterator(region_children.begin()),
+                    std::make_move_iterator(region_children.end()));
+  }
+
+  if (const absl::Status status = data.InternalConsistencyCheck();
+      !status.ok()) {
+    LOG(DFATAL) << "Inconsistent incremental analysis: " << status;
+    return nullptr;
+  }
+  VLOG(1) << "Reused " << descriptions.size() - (end_edited - first_edited)
+          << " of " << descriptions.size() << " descriptions, re-analyzed "
+          << region.length() << " of " << text.size() << " bytes.";
+  return analyzer;
+}
+
+}  // namespace verilog
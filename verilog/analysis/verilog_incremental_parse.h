@@ -0,0 +1,51 @@
+// Copyright 2017-2023 The Verible Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// Incremental re-analysis of edited text, for interactive tools like the
+// language server, where a small edit should not require re-lexing and
+// re-parsing a whole (possibly large) file.
+
+#ifndef VERIBLE_VERILOG_ANALYSIS_VERILOG_INCREMENTAL_PARSE_H_
+#define VERIBLE_VERILOG_ANALYSIS_VERILOG_INCREMENTAL_PARSE_H_
+
+#include <memory>
+
+#include "absl/strings/string_view.h"
+#include "verilog/analysis/verilog_analyzer.h"
+
+namespace verilog {
+
+// Analyzes 'text', which is an edited version of the text of 'previous'.
+// Only the top-level descriptions (modules, packages, classes, ...) touched by
+// the edit are lexed and parsed again; the tokens and syntax trees of the
+// descriptions before and after the edit are copied from 'previous'.
+// The edited region is determined by comparing both texts, so any number of
+// changes within one region are handled at once.
+//
+// Returns nullptr if the result cannot be guaranteed to be the same as that of
+// a full analysis, in which case the caller should analyze the whole text.
+// This is the case if:
+//   * 'previous' did not lex and parse successfully, or was not parsed as a
+//     plain source file (e.g. because of a parser directive comment).
+//   * Either the previous text or the edited region contain preprocessor
+//     directives or macros, which may affect text outside the edited region.
+//   * The edited region does not lex and parse successfully on its own.
+//   * No description could be reused, so there is nothing to gain.
+std::unique_ptr<VerilogAnalyzer> AnalyzeVerilogIncrementally(
+    const VerilogAnalyzer& previous, absl::string_view text,
+    absl::string_view filename);
+
+}  // namespace verilog
+
+#endif  // VERIBLE_VERILOG_ANALYSIS_VERILOG_INCREMENTAL_PARSE_H_
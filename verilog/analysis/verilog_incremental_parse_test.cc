@@ -0,0 +1,251 @@
+// Copyright 2017-2023 The Verible Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "verilog/analysis/verilog_incremental_parse.h"
+
+#include <memory>
+
+#include "absl/strings/str_cat.h"
+#include "absl/strings/string_view.h"
+#include "common/text/symbol.h"
+#include "common/text/text_structure.h"
+#include "common/text/token_info.h"
+#include "gtest/gtest.h"
+#include "verilog/analysis/verilog_analyzer.h"
+
+namespace verilog {
+namespace {
+
+using verible::TextStructureView;
+using verible::TokenInfo;
+
+constexpr absl::string_view kFilename = "incremental.sv";
+
+static bool SameToken(const TokenInfo& left, const TokenInfo& right) {
+  return left.token_enum() == right.token_enum() &&
+         left.text() == right.text();
+}
+
+// Expects that 'actual' (incrementally analyzed) is the same as the full
+// analysis of its text.
+void ExpectSameAsFullAnalysis(const VerilogAnalyzer& actual) {
+  const TextStructureView& data = actual.Data();
+  VerilogAnalyzer expected(data.Contents(), kFilename);
+  ASSERT_TRUE(expected.Analyze().ok());
+  const TextStructureView& expected_data = expected.Data();
+
+  ASSERT_EQ(data.TokenStream().size(), expected_data.TokenStream().size());
+  for (size_t i = 0; i < data.TokenStream().size(); ++i) {
+    const TokenInfo& token = data.TokenStream()[i];
+    const TokenInfo& expected_token = expected_data.TokenStream()[i];
+    EXPECT_TRUE(SameToken(token, expected_token))
+        << "token[" << i << "]: " << token << " vs. " << expected_token;
+    // Tokens must point into the new text.
+    EXPECT_EQ(token.left(data.Contents()),
+              expected_token.left(expected_data.Contents()));
+  }
+
+  ASSERT_EQ(data.GetTokenStreamView().size(),
+            expected_data.GetTokenStreamView().size());
+  for (size_t i = 0; i < data.GetTokenStreamView().size(); ++i) {
+    EXPECT_TRUE(SameToken(*data.GetTokenStreamView()[i],
+                          *expected_data.GetTokenStreamView()[i]));
+  }
+
+  ASSERT_NE(data.SyntaxTree(), nullptr);
+  ASSERT_NE(expected_data.SyntaxTree(), nullptr);
+  EXPECT_TRUE(data.SyntaxTree()->equals(expected_data.SyntaxTree().get(),
+                                        SameToken));
+  EXPECT_TRUE(data.InternalConsistencyCheck().ok());
+}
+
+// Analyzes 'before' fully, and 'after' incrementally.
+std::unique_ptr<VerilogAnalyzer> AnalyzeEdit(absl::string_view before,
+                                             absl::string_view after) {
+  VerilogAnalyzer previous(before, kFilename);
+  EXPECT_TRUE(previous.Analyze().ok());
+  return AnalyzeVerilogIncrementally(previous, after, kFilename);
+}
+
+constexpr absl::string_view kThreeModules =
+    "module a;\n"
+    "  wire x;\n"
+    "endmodule\n"
+    "\n"
+    "// comment about b\n"
+    "module b;\n"
+    "  assign y = 1;\n"
+    "endmodule\n"
+    "\n"
+    "module c;\n"
+    "endmodule\n";
+
+TEST(AnalyzeVerilogIncrementallyTest, EditInMiddleDescription) {
+  const auto analyzer = AnalyzeEdit(kThreeModules,
+                                    "module a;\n"
+                                    "  wire x;\n"
+                                    "endmodule\n"
+                                    "\n"
+                                    "// comment about b\n"
+                                    "module b;\n"
+                                    "  assign y = 1 + z;\n"
+                                    "  wire z;\n"
+                                    "endmodule\n"
+                                    "\n"
+                                    "module c;\n"
+                                    "endmodule\n");
+  ASSERT_NE(analyzer, nullptr);
+  ExpectSameAsFullAnalysis(*analyzer);
+}
+
+TEST(AnalyzeVerilogIncrementallyTest, EditInFirstDescription) {
+  const auto analyzer = AnalyzeEdit(kThreeModules,
+                                    "module aa;\n"
+                                    "  wire x;\n"
+                                    "endmodule\n"
+                                    "\n"
+                                    "// comment about b\n"
+                                    "module b;\n"
+                                    "  assign y = 1;\n"
+                                    "endmodule\n"
+                                    "\n"
+                                    "module c;\n"
+                                    "endmodule\n");
+  ASSERT_NE(analyzer, nullptr);
+  ExpectSameAsFullAnalysis(*analyzer);
+}
+
+TEST(AnalyzeVerilogIncrementallyTest, AppendDescription) {
+  const auto analyzer = AnalyzeEdit(
+      kThreeModules, absl::StrCat(kThreeModules, "package p;\nendpackage\n"));
+  ASSERT_NE(analyzer, nullptr);
+  ExpectSameAsFullAnalysis(*analyzer);
+}
+
+TEST(AnalyzeVerilogIncrementallyTest, RemoveDescription) {
+  const auto analyzer = AnalyzeEdit(kThreeModules,
+                                    "module a;\n"
+                                    "  wire x;\n"
+                                    "endmodule\n"
+                                    "\n"
+                                    "module c;\n"
+                                    "endmodule\n");
+  ASSERT_NE(analyzer, nullptr);
+  ExpectSameAsFullAnalysis(*analyzer);
+}
+
+TEST(AnalyzeVerilogIncrementallyTest, EditComment) {
+  const auto analyzer = AnalyzeEdit(kThreeModules,
+                                    "module a;\n"
+                                    "  wire x;\n"
+                                    "endmodule\n"
+                                    "\n"
+                                    "// another comment about b\n"
+                                    "module b;\n"
+                                    "  assign y = 1;\n"
+                                    "endmodule\n"
+                                    "\n"
+                                    "module c;\n"
+                                    "endmodule\n");
+  ASSERT_NE(analyzer, nullptr);
+  ExpectSameAsFullAnalysis(*analyzer);
+}
+
+TEST(AnalyzeVerilogIncrementallyTest, UnchangedText) {
+  const auto analyzer = AnalyzeEdit(kThreeModules, kThreeModules);
+  ASSERT_NE(analyzer, nullptr);
+  ExpectSameAsFullAnalysis(*analyzer);
+}
+
+TEST(AnalyzeVerilogIncrementallyTest, SyntaxErrorInEditRequiresFullAnalysis) {
+  EXPECT_EQ(AnalyzeEdit(kThreeModules,
+                        "module a;\n"
+                        "  wire x;\n"
+                        "endmodule\n"
+                        "\n"
+                        "// comment about b\n"
+                        "module b;\n"
+                        "  assign y = ;\n"
+                        "endmodule\n"
+                        "\n"
+                        "module c;\n"
+                        "endmodule\n"),
+            nullptr);
+}
+
+TEST(AnalyzeVerilogIncrementallyTest, CommentOutDescription) {
+  const auto analyzer = AnalyzeEdit(kThreeModules,
+                                    "module a;\n"
+                                    "  wire x;\n"
+                                    "endmodule\n"
+                                    "\n"
+                                    "/* comment about b\n"
+                                    "module b;\n"
+                                    "  assign y = 1;\n"
+                                    "endmodule\n"
+                                    "*/\n"
+                                    "module c;\n"
+                                    "endmodule\n");
+  ASSERT_NE(analyzer, nullptr);
+  ExpectSameAsFullAnalysis(*analyzer);
+}
+
+TEST(AnalyzeVerilogIncrementallyTest,
+     UnterminatedCommentRequiresFullAnalysis) {
+  EXPECT_EQ(AnalyzeEdit(kThreeModules,
+                        "module a;\n"
+                        "  wire x;\n"
+                        "endmodule\n"
+                        "\n"
+                        "/* comment about b\n"
+                        "module b;\n"
+                        "  assign y = 1;\n"
+                        "endmodule\n"
+                        "\n"
+                        "module c;\n"
+                        "endmodule\n"),
+            nullptr);
+}
+
+TEST(AnalyzeVerilogIncrementallyTest, EditOnSameLineRequiresFullAnalysis) {
+  // The line comment extends into the line of the following description.
+  EXPECT_EQ(AnalyzeEdit("module a; endmodule module b; endmodule\n",
+                        "module a; endmodule // module b; endmodule\n"),
+            nullptr);
+}
+
+TEST(AnalyzeVerilogIncrementallyTest, PreprocessorRequiresFullAnalysis) {
+  EXPECT_EQ(AnalyzeEdit(kThreeModules, absl::StrCat("`define FOO\n",
+                                                    kThreeModules)),
+            nullptr);
+  EXPECT_EQ(AnalyzeEdit(absl::StrCat("`define FOO\n", kThreeModules),
+                        absl::StrCat("`define FOO\n", kThreeModules, "\n")),
+            nullptr);
+}
+
+TEST(AnalyzeVerilogIncrementallyTest, FailedPreviousRequiresFullAnalysis) {
+  VerilogAnalyzer previous("module a;\n  assign = ;\nendmodule\n",
+                           kFilename);
+  EXPECT_FALSE(previous.Analyze().ok());
+  EXPECT_EQ(AnalyzeVerilogIncrementally(previous, kThreeModules, kFilename),
+            nullptr);
+}
+
+TEST(AnalyzeVerilogIncrementallyTest, NothingToReuseRequiresFullAnalysis) {
+  EXPECT_EQ(AnalyzeEdit("module a;\nendmodule\n", "module b;\nendmodule\n"),
+            nullptr);
+}
+
+}  // namespace
+}  // namespace verilog
@@ -14,11 +14,19 @@
 
 #include "verilog/analysis/verilog_linter.h"
 
+#include <algorithm>
 #include <cstddef>
+#include <cstdint>
+#include <filesystem>
 #include <fstream>
+#include <functional>
+#include <future>
 #include <iomanip>
+#include <iterator>
 #include <map>
 #include <memory>
+#include <mutex>  // NOLINT
+#include <set>
 #include <sstream>
 #include <string>
 #include <utility>
@@ -28,6 +36,8 @@
 #include "absl/status/status.h"
 #include "absl/status/statusor.h"
 #include "absl/strings/str_cat.h"
+#include "absl/strings/str_join.h"
+#include "absl/strings/str_split.h"
 #include "absl/strings/string_view.h"
 #include "common/analysis/line_lint_rule.h"
 #include "common/analysis/line_linter.h"
@@ -40,17 +50,33 @@
 #include "common/analysis/token_stream_lint_rule.h"
 #include "common/analysis/token_stream_linter.h"
 #include "common/strings/line_column_map.h"
+#include "common/strings/mem_block.h"
 #include "common/text/concrete_syntax_tree.h"
+#include "common/text/flat_syntax_tree.h"
 #include "common/text/text_structure.h"
 #include "common/text/token_info.h"
+#include "common/text/token_stream_view.h"
+#include "common/util/deferred_deleter.h"
 #include "common/util/file_util.h"
+#include "common/util/interval_set.h"
 #include "common/util/logging.h"
+#include "common/util/memory_stats.h"
 #include "common/util/status_macros.h"
+#include "common/util/thread_pool.h"
+#include "common/util/trace_events.h"
 #include "verilog/analysis/default_rules.h"
+#include "verilog/analysis/dependencies.h"
+#include "verilog/analysis/flow_tree.h"
+#include "verilog/analysis/lint_cache.h"
 #include "verilog/analysis/lint_rule_registry.h"
+#include "verilog/analysis/project_lint_rule.h"
+#include "verilog/analysis/symbol_table.h"
 #include "verilog/analysis/verilog_analyzer.h"
+#include "verilog/analysis/verilog_filelist.h"
 #include "verilog/analysis/verilog_linter_configuration.h"
 #include "verilog/analysis/verilog_linter_constants.h"
+#include "verilog/analysis/verilog_project.h"
+#include "verilog/parser/verilog_lexer.h"
 #include "verilog/parser/verilog_token_classifications.h"
 #include "verilog/parser/verilog_token_enum.h"
 
@@ -81,33 +107,58 @@ using verible::LintWaiver;
 using verible::TextStructureView;
 using verible::TokenInfo;
 
-std::set<LintViolationWithStatus> GetSortedViolations(
+std::vector<LintViolationWithStatus> GetSortedViolations(
     const std::vector<LintRuleStatus>& statuses) {
-  std::set<LintViolationWithStatus> violations;
+  return verible::MergeSortedViolations(statuses);
+}
 
-  for (const auto& status : statuses) {
-    for (const auto& violation : status.violations) {
-      violations.insert(LintViolationWithStatus(&violation, &status));
-    }
+// Receives the sorted violations found in the text 'base' of a file.
+using ViolationsCallback = std::function<void(
+    const std::vector<LintViolationWithStatus>& violations,
+    absl::string_view base)>;
+
+// Passes the violations of 'statuses' in 'base', if any, to
+// 'handle_violations', and returns the exit status of LintOneFile().
+static int ReportLintStatuses(const std::vector<LintRuleStatus>& statuses,
+                              absl::string_view base,
+                              const ViolationsCallback& handle_violations,
+                              bool lint_fatal) {
+  size_t total_violations = 0;
+  for (const auto& rule_status : statuses) {
+    total_violations += rule_status.violations.size();
   }
 
-  return violations;
+  if (total_violations == 0) {
+    VLOG(1) << "No lint violations found." << std::endl;
+    return 0;
+  }
+  VLOG(1) << "Lint Violations (" << total_violations << "): " << std::endl;
+  handle_violations(GetSortedViolations(statuses), base);
+  return lint_fatal ? 1 : 0;
 }
 
-// Return code useful to be used in main:
-//  0: success
-//  1: linting error (if parse_fatal == true)
-//  2..: other fatal issues such as file not found.
-int LintOneFile(std::ostream* stream, absl::string_view filename,
-                const LinterConfiguration& config,
-                verible::ViolationHandler* violation_handler, bool check_syntax,
-                bool parse_fatal, bool lint_fatal, bool show_context) {
-  const absl::StatusOr<std::string> content_or =
-      verible::file::GetContentAsString(filename);
-  if (!content_or.ok()) {
-    LOG(ERROR) << "Can't read '" << filename
-               << "': " << content_or.status().message();
-    return 2;
+// Lints 'content' of 'filename' like LintOneFile(), which see, and passes
+// the violations, if any, to 'handle_violations'.  With a 'cache_dir', the
+// results of unchanged files are taken from the lint cache (lint_cache.h).
+static int LintContent(std::ostream* stream,
+                       const std::shared_ptr<verible::MemBlock>& content,
+                       absl::string_view filename,
+                       const LinterConfiguration& config,
+                       const ViolationsCallback& handle_violations,
+                       bool check_syntax, bool parse_fatal, bool lint_fatal,
+                       bool show_context, VerilogAnalyzerStats* analyzer_stats,
+                       absl::string_view cache_dir = {}) {
+  std::string cache_path;
+  if (!cache_dir.empty()) {
+    const absl::string_view text = content->AsStringView();
+    cache_path =
+        LintCachePath(cache_dir, filename, text, config,
+                      absl::StrCat("check_syntax: ", check_syntax ? 1 : 0));
+    const auto cached = LoadLintCacheEntry(cache_path, text);
+    if (cached.ok()) {
+      VLOG(1) << "Lint results of " << filename << " from cache.";
+      return ReportLintStatuses(*cached, text, handle_violations, lint_fatal);
+    }
   }
 
   // Lex and parse the contents of the file.
@@ -117,8 +168,18 @@ int LintOneFile(std::ostream* stream, absl::string_view filename,
   // TODO(hzeller): this behavior could be configurable, but then again this
   //   is something the user is expecting to work as best as possible (which
   //   is also why we use automatic mode).
-  const auto analyzer = VerilogAnalyzer::AnalyzeAutomaticPreprocessFallback(
-      *content_or, filename);
+  std::unique_ptr<VerilogAnalyzer> analyzer;
+  if (!check_syntax && !config.NeedsSyntaxTree()) {
+    // Only lines and tokens are linted, and syntax errors are not reported:
+    // skip preprocessing and parsing.
+    analyzer = std::make_unique<VerilogAnalyzer>(content, filename,
+                                                 VerilogPreprocess::Config());
+    analyzer->AnalyzeTokens().IgnoreError();
+  } else {
+    analyzer =
+        VerilogAnalyzer::AnalyzeAutomaticPreprocessFallback(content, filename);
+  }
+  if (analyzer_stats != nullptr) *analyzer_stats = analyzer->Stats();
   if (check_syntax) {
     const auto lex_status = ABSL_DIE_IF_NULL(analyzer)->LexStatus();
     const auto parse_status = analyzer->ParseStatus();
@@ -148,39 +209,321 @@ int LintOneFile(std::ostream* stream, absl::string_view filename,
 
   const std::vector<LintRuleStatus>& linter_statuses = linter_result.value();
 
-  size_t total_violations = 0;
-  for (const auto& rule_status : linter_statuses) {
-    total_violations += rule_status.violations.size();
+  // Only results of files without syntax errors are cached.
+  if (!cache_path.empty() && analyzer->LexStatus().ok() &&
+      analyzer->ParseStatus().ok()) {
+    const absl::Status stored = StoreLintCacheEntry(
+        cache_path, text_structure.Contents(), linter_statuses);
+    if (!stored.ok()) VLOG(1) << stored;
   }
 
-  if (total_violations == 0) {
-    VLOG(1) << "No lint violations found." << std::endl;
-  } else {
-    VLOG(1) << "Lint Violations (" << total_violations << "): " << std::endl;
+  const int result = ReportLintStatuses(
+      linter_statuses, text_structure.Contents(), handle_violations,
+      lint_fatal);
+  // The next file need not wait for the destruction of this syntax tree.
+  verible::DeferredDeleter::Global().Delete(std::move(analyzer));
+  return result;
+}
 
-    absl::string_view text_base = text_structure.Contents();
+// Return code useful to be used in main:
+//  0: success
+//  1: linting error (if parse_fatal == true)
+//  2..: other fatal issues such as file not found.
+int LintOneFile(std::ostream* stream, absl::string_view filename,
+                const LinterConfiguration& config,
+                verible::ViolationHandler* violation_handler, bool check_syntax,
+                bool parse_fatal, bool lint_fatal, bool show_context,
+                VerilogAnalyzerStats* analyzer_stats) {
+  absl::StatusOr<std::unique_ptr<verible::MemBlock>> content_or =
+      verible::file::GetContentAsMemBlock(filename);
+  if (!content_or.ok()) {
+    LOG(ERROR) << "Can't read '" << filename
+               << "': " << content_or.status().message();
+    return 2;
+  }
+  return LintContent(
+      stream, std::move(*content_or), filename, config,
+      [&](const std::vector<LintViolationWithStatus>& violations,
+          absl::string_view base) {
+        violation_handler->HandleViolations(violations, base, filename);
+      },
+      check_syntax, parse_fatal, lint_fatal, show_context, analyzer_stats,
+      LintCacheDir());
+}
+
+// Returns 'base' with the first autofix of each violation applied, except
+// those that conflict with the fixes of earlier violations.
+static std::string ApplyFirstAutoFixes(
+    const std::vector<LintViolationWithStatus>& violations,
+    absl::string_view base) {
+  verible::AutoFix fix;
+  for (const LintViolationWithStatus& violation : violations) {
+    const std::vector<verible::AutoFix>& autofixes =
+        violation.violation->autofixes;
+    if (!autofixes.empty()) fix.AddEdits(autofixes.front().Edits());
+  }
+  return fix.Apply(base);
+}
+
+int LintAndFixOneFile(std::ostream* stream, absl::string_view filename,
+                      const LinterConfiguration& config,
+                      verible::ViolationFixer* violation_fixer, int max_passes,
+                      bool check_syntax, bool parse_fatal, bool lint_fatal,
+                      bool show_context) {
+  absl::StatusOr<std::unique_ptr<verible::MemBlock>> content_or =
+      verible::file::GetContentAsMemBlock(filename);
+  if (!content_or.ok()) {
+    LOG(ERROR) << "Can't read '" << filename
+               << "': " << content_or.status().message();
+    return 2;
+  }
+  const std::shared_ptr<verible::MemBlock> original = std::move(*content_or);
+  std::string fixed_content(original->AsStringView());
+  const int exit_status = LintContent(
+      stream, original, filename, config,
+      [&](const std::vector<LintViolationWithStatus>& violations,
+          absl::string_view base) {
+        fixed_content =
+            violation_fixer->FixViolations(violations, base, filename);
+      },
+      check_syntax, parse_fatal, lint_fatal, show_context, nullptr,
+      LintCacheDir());
+
+  // Fixes can uncover more violations, and fixes that conflicted with others
+  // are left over: lint the fixed text again, until nothing changes.
+  std::shared_ptr<verible::MemBlock> content = original;
+  for (int pass = 1;
+       pass < max_passes && fixed_content != content->AsStringView(); ++pass) {
+    content =
+        std::make_shared<verible::StringMemBlock>(std::move(fixed_content));
+    fixed_content = std::string(content->AsStringView());
+    std::ostringstream ignored_syntax_errors;
+    const int pass_status = LintContent(
+        &ignored_syntax_errors, content, filename, config,
+        [&](const std::vector<LintViolationWithStatus>& violations,
+            absl::string_view base) {
+          fixed_content = ApplyFirstAutoFixes(violations, base);
+        },
+        false, false, false, false, nullptr);
+    if (pass_status > 1) break;
+    VLOG(1) << filename << ": autofix pass " << pass + 1;
+  }
+  violation_fixer->CommitFixedContent(original->AsStringView(), filename,
+                                      fixed_content);
+  return exit_status;
+}
+
+// Analysis and lint results of one `ifdef variant of a file.
+struct VariantLintResult {
+  // Owns the syntax tree that the lint violations refer to.
+  std::unique_ptr<VerilogAnalyzer> analyzer;
+  absl::StatusOr<std::vector<LintRuleStatus>> lint_statuses;
+};
+
+int LintOneFileVariants(std::ostream* stream, absl::string_view filename,
+                        const LinterConfiguration& config,
+                        verible::ViolationHandler* violation_handler,
+                        bool check_syntax, bool parse_fatal, bool lint_fatal,
+                        bool show_context, int max_variants, int jobs) {
+  absl::StatusOr<std::unique_ptr<verible::MemBlock>> content_or =
+      verible::file::GetContentAsMemBlock(filename);
+  if (!content_or.ok()) {
+    LOG(ERROR) << "Can't read '" << filename
+               << "': " << content_or.status().message();
+    return 2;
+  }
+  // All variants are analyzed on the same buffer, so that their tokens can
+  // be compared by location.
+  const std::shared_ptr<verible::MemBlock> content = std::move(*content_or);
+
+  // Enumerate the distinct sets of defined macros.
+  verible::TokenSequence lexed_sequence;
+  VerilogLexer lexer(content->AsStringView());
+  for (lexer.DoNextToken(); !lexer.GetLastToken().isEOF();
+       lexer.DoNextToken()) {
+    if (VerilogLexer::KeepSyntaxTreeTokens(lexer.GetLastToken())) {
+      lexed_sequence.push_back(lexer.GetLastToken());
+    }
+  }
+  FlowTree flow_tree(std::move(lexed_sequence));
+  std::set<std::vector<absl::string_view>> seen_define_sets;
+  std::vector<std::vector<TextMacroDefinition>> variant_defines;
+  const absl::Status variants_status = flow_tree.GenerateVariants(
+      [&](const FlowTree::Variant& variant) {
+        if (static_cast<int>(variant_defines.size()) >= max_variants) {
+          return false;
+        }
+        const auto& macros = flow_tree.GetUsedMacros();
+        std::vector<absl::string_view> defined;
+        for (size_t i = 0; i < macros.size(); ++i) {
+          if (variant.visited.test(i) && variant.macros_mask.test(i)) {
+            defined.push_back(macros[i]->text());
+          }
+        }
+        if (!seen_define_sets.insert(defined).second) return true;
+        std::vector<TextMacroDefinition>& defines =
+            variant_defines.emplace_back();
+        for (const absl::string_view name : defined) {
+          defines.emplace_back(std::string(name), "");
+        }
+        return true;
+      });
+  if (!variants_status.ok() || variant_defines.empty()) {
+    VLOG(1) << "Can't enumerate variants of " << filename << ": "
+            << variants_status;
+    return LintOneFile(stream, filename, config, violation_handler,
+                       check_syntax, parse_fatal, lint_fatal, show_context);
+  }
 
-    const std::set<LintViolationWithStatus> violations =
-        GetSortedViolations(linter_statuses);
-    violation_handler->HandleViolations(violations, text_base, filename);
-    if (lint_fatal) {
-      return 1;
+  std::vector<VariantLintResult> results;
+  {
+    const int threads = std::min<int>(jobs, variant_defines.size());
+    verible::ThreadPool pool(threads > 1 ? threads : 0);
+    std::vector<std::future<VariantLintResult>> futures;
+    futures.reserve(variant_defines.size());
+    for (const auto& defines : variant_defines) {
+      futures.push_back(pool.ExecAsync<VariantLintResult>(
+          [&content, &defines, &config, filename]() {
+            VariantLintResult result;
+            result.analyzer = std::make_unique<VerilogAnalyzer>(
+                content, filename,
+                VerilogPreprocess::Config({.filter_branches = true}));
+            FileList::PreprocessingInfo preprocessing_info;
+            preprocessing_info.defines = defines;
+            result.analyzer->SetPreprocessingInfo(preprocessing_info);
+            // Errors are found in the rejected tokens below.
+            result.analyzer->Analyze().IgnoreError();
+            result.lint_statuses = VerilogLintTextStructure(
+                filename, config, result.analyzer->Data());
+            return result;
+          }));
     }
+    results.reserve(futures.size());
+    for (auto& future : futures) results.push_back(future.get());
   }
 
-  return 0;
+  // Merge the results, in the order of variants.
+  bool syntax_errors = false;
+  std::set<std::string> seen_error_messages;
+  std::map<absl::string_view, LintRuleStatus> merged_statuses;
+  for (auto& result : results) {
+    const VerilogAnalyzer& analyzer = *result.analyzer;
+    if (check_syntax &&
+        (!analyzer.LexStatus().ok() || !analyzer.ParseStatus().ok())) {
+      syntax_errors = true;
+      for (const auto& message :
+           analyzer.LinterTokenErrorMessages(show_context)) {
+        if (seen_error_messages.insert(message).second) {
+          *stream << message << std::endl;
+        }
+      }
+    }
+    if (!result.lint_statuses.ok()) {
+      // Something went wrong with running the lint analysis itself.
+      LOG(ERROR) << "Fatal error: " << result.lint_statuses.status().message();
+      return 2;
+    }
+    for (auto& rule_status : *result.lint_statuses) {
+      LintRuleStatus& merged = merged_statuses[rule_status.lint_rule_name];
+      merged.lint_rule_name = rule_status.lint_rule_name;
+      merged.url = rule_status.url;
+      std::move(rule_status.violations.begin(), rule_status.violations.end(),
+                std::back_inserter(merged.violations));
+    }
+  }
+  if (syntax_errors && parse_fatal) return 1;
+
+  std::vector<LintRuleStatus> linter_statuses;
+  linter_statuses.reserve(merged_statuses.size());
+  for (auto& entry : merged_statuses) {
+    // Violations at the same location are equivalent.
+    entry.second.violations =
+        verible::SortedByLocation(std::move(entry.second.violations));
+    linter_statuses.push_back(std::move(entry.second));
+  }
+  const std::vector<LintViolationWithStatus> violations =
+      GetSortedViolations(linter_statuses);
+  if (violations.empty()) {
+    VLOG(1) << "No lint violations found." << std::endl;
+    return 0;
+  }
+  VLOG(1) << "Lint Violations (" << violations.size() << ") in "
+          << results.size() << " variants." << std::endl;
+  violation_handler->HandleViolations(violations, content->AsStringView(),
+                                      filename);
+  return lint_fatal ? 1 : 0;
 }
 
-VerilogLinter::VerilogLinter()
-    : lint_waiver_(
-          [](const TokenInfo& t) {
-            return IsComment(verilog_tokentype(t.token_enum()));
-          },
-          [](const TokenInfo& t) {
-            return IsWhitespace(verilog_tokentype(t.token_enum()));
-          },
-          kLinterTrigger, kLinterWaiveLineCommand, kLinterWaiveStartCommand,
-          kLinterWaiveStopCommand) {}
+// Returns a builder of the waivers in the comments of Verilog code.
+static verible::LintWaiverBuilder MakeLintWaiverBuilder() {
+  return verible::LintWaiverBuilder(
+      [](const TokenInfo& t) {
+        return IsComment(verilog_tokentype(t.token_enum()));
+      },
+      [](const TokenInfo& t) {
+        return IsWhitespace(verilog_tokentype(t.token_enum()));
+      },
+      kLinterTrigger, kLinterWaiveLineCommand, kLinterWaiveStartCommand,
+      kLinterWaiveStopCommand);
+}
+
+VerilogLinter::VerilogLinter(verible::ThreadPool* pool)
+    : lint_waiver_(MakeLintWaiverBuilder()), pool_(pool) {}
+
+namespace {
+// An external waiver file, parsed for a set of active rules.
+struct ParsedWaiverFile {
+  verible::ExternalLintWaivers waivers;
+  absl::Status status;
+};
+}  // namespace
+
+// Returns 'waiver_file' with 'content' parsed for 'active_rules'.  Waiver
+// files can be large, and are the same for all linted files, so each is only
+// parsed once per run.
+static std::shared_ptr<const ParsedWaiverFile> GetParsedWaiverFile(
+    const std::set<absl::string_view>& active_rules,
+    absl::string_view waiver_file, absl::string_view content) {
+  // Allocated once, never freed.  Rule names are static strings.
+  static auto* const lock = new std::mutex();
+  static auto* const cache =
+      new std::map<std::string, std::shared_ptr<const ParsedWaiverFile>>();
+  // Waiver files can change in long-running processes, e.g. the language
+  // server; don't accumulate old versions.
+  constexpr size_t kMaxCachedWaiverFiles = 16;
+
+  std::string key =
+      absl::StrCat(waiver_file, "\n", absl::StrJoin(active_rules, ","), "\n",
+                   content);
+  const std::lock_guard<std::mutex> l(*lock);
+  auto found = cache->find(key);
+  if (found != cache->end()) return found->second;
+
+  auto parsed = std::make_shared<ParsedWaiverFile>();
+  parsed->status = parsed->waivers.Parse(active_rules, waiver_file, content);
+  if (cache->size() >= kMaxCachedWaiverFiles) cache->clear();
+  cache->emplace(std::move(key), parsed);
+  return parsed;
+}
+
+// Applies the waivers of the external waiver files of 'configuration' to
+// 'lintee_filename'.
+static absl::Status ApplyExternalWaiverFiles(
+    const LinterConfiguration& configuration, absl::string_view lintee_filename,
+    verible::LintWaiverBuilder* lint_waiver) {
+  absl::Status rc = absl::OkStatus();
+  for (const auto& waiver_file :
+       absl::StrSplit(configuration.external_waivers, ',', absl::SkipEmpty())) {
+    auto content_or = verible::file::GetContentAsString(waiver_file);
+    if (!content_or.ok()) continue;  // Couldn't read lint file: ignore
+    const auto parsed = GetParsedWaiverFile(configuration.ActiveRuleIds(),
+                                            waiver_file, *content_or);
+    rc.Update(parsed->status);
+    rc.Update(lint_waiver->ApplyExternalWaivers(parsed->waivers,
+                                                lintee_filename));
+  }
+  return rc;
+}
 
 absl::Status VerilogLinter::Configure(const LinterConfiguration& configuration,
                                       absl::string_view lintee_filename) {
@@ -206,24 +549,30 @@ absl::Status VerilogLinter::Configure(const LinterConfiguration& configuration,
   }
   auto syntax_rules = configuration.CreateSyntaxTreeRules();
   if (!syntax_rules.ok()) return syntax_rules.status();
-  for (auto& rule : *syntax_rules) {
-    syntax_tree_linter_.AddRule(std::move(rule));
+  // Each partition walks the whole tree, so more than a few don't pay off.
+  constexpr size_t kMaxSyntaxTreePartitions = 4;
+  const size_t threads = pool_ ? pool_->NumThreads() + 1 : 1;
+  syntax_tree_linters_ = std::vector<verible::SyntaxTreeLinter>(std::min(
+      {threads, syntax_rules->size(), kMaxSyntaxTreePartitions}));
+  for (size_t i = 0; i < syntax_rules->size(); ++i) {
+    syntax_tree_linters_[i % syntax_tree_linters_.size()].AddRule(
+        std::move((*syntax_rules)[i]));
   }
+  lines_ = configuration.lines;
 
-  absl::Status rc = absl::OkStatus();
-  for (const auto& waiver_file :
-       absl::StrSplit(configuration.external_waivers, ',', absl::SkipEmpty())) {
-    auto content_or = verible::file::GetContentAsString(waiver_file);
-    if (!content_or.ok()) continue;  // Couldn't read lint file: ignore
-    auto status = lint_waiver_.ApplyExternalWaivers(
-        configuration.ActiveRuleIds(), lintee_filename, waiver_file,
-        *content_or);
-    if (!status.ok()) {
-      rc.Update(status);
-    }
-  }
+  return ApplyExternalWaiverFiles(configuration, lintee_filename,
+                                  &lint_waiver_);
+}
 
-  return rc;
+// Returns the byte ranges of the 1-based 'lines'.
+static verible::ByteOffsetSet LinesToByteRanges(
+    const verible::LineNumberSet& lines, const LineColumnMap& line_map) {
+  const int max_line = line_map.GetBeginningOfLineOffsets().size() + 1;
+  return verible::ByteOffsetSet(
+      lines.MonotonicTransform<int>([&](int line_number) {
+        const int n = std::max(std::min(line_number, max_line), 1);
+        return line_map.OffsetAtLine(n - 1);
+      }));
 }
 
 void VerilogLinter::Lint(const TextStructureView& text_structure,
@@ -231,40 +580,99 @@ void VerilogLinter::Lint(const TextStructureView& text_structure,
   // Collect all lint waivers in an initial pass.
   lint_waiver_.ProcessTokenRangesByLine(text_structure);
 
-  // Analyze general text structure.
-  text_structure_linter_.Lint(text_structure, filename);
+  // Fill the lazily computed parts of text_structure, which is shared by the
+  // linters below.
+  text_structure.Lines();
+  text_structure.GetLineTokenMap();
 
-  // Analyze lines of text.
-  line_linter_.Lint(text_structure.Lines());
+  // The syntax tree linters share one flattened tree, for linear walks.
+  const verible::ConcreteSyntaxTree& syntax_tree = text_structure.SyntaxTree();
+  std::unique_ptr<verible::FlatSyntaxTree> flat_tree;
+  if (syntax_tree != nullptr) {
+    flat_tree = std::make_unique<verible::FlatSyntaxTree>(*syntax_tree);
+  }
+  // Only the subtrees in the linted lines are visited.
+  const verible::ByteOffsetSet byte_ranges =
+      LinesToByteRanges(lines_, text_structure.GetLineColumnMap());
 
+  // Each linter only writes to its own rules, so they are independent.
+  std::vector<std::function<void()>> tasks;
+  // Analyze general text structure.
+  if (!text_structure_linter_.empty()) {
+    tasks.emplace_back([&]() {
+      VERIBLE_TRACE_SCOPE("lint", "text-structure-rules", filename);
+      text_structure_linter_.Lint(text_structure, filename);
+    });
+  }
+  // Analyze lines of text.
+  if (!line_linter_.empty()) {
+    tasks.emplace_back([&]() {
+      VERIBLE_TRACE_SCOPE("lint", "line-rules", filename);
+      line_linter_.Lint(text_structure.Lines());
+    });
+  }
   // Analyze token stream.
-  token_stream_linter_.Lint(text_structure.TokenStream());
-
+  if (!token_stream_linter_.empty()) {
+    tasks.emplace_back([&]() {
+      VERIBLE_TRACE_SCOPE("lint", "token-stream-rules", filename);
+      token_stream_linter_.Lint(text_structure.TokenStream());
+    });
+  }
   // Analyze syntax tree.
-  const verible::ConcreteSyntaxTree& syntax_tree = text_structure.SyntaxTree();
-  if (syntax_tree != nullptr) {
-    syntax_tree_linter_.Lint(*syntax_tree);
+  if (flat_tree != nullptr) {
+    for (auto& linter : syntax_tree_linters_) {
+      tasks.emplace_back([&]() {
+        VERIBLE_TRACE_SCOPE("lint", "syntax-tree-rules", filename);
+        if (lines_.empty()) {
+          linter.Lint(*flat_tree);
+        } else {
+          linter.Lint(*flat_tree, text_structure.Contents(), byte_ranges);
+        }
+      });
+    }
   }
+
+  if (pool_ == nullptr) {
+    for (const auto& task : tasks) task();
+    return;
+  }
+  pool_->ParallelFor(tasks.size(), [&tasks](size_t i) { tasks[i](); });
 }
 
+// Appends 'new_statuses' without the violations that are waived or outside
+// of 'lines' (1-based, all lines if empty).
 static void AppendLintRuleStatuses(
-    const std::vector<LintRuleStatus>& new_statuses,
-    const verible::LintWaiver& waivers, const LineColumnMap& line_map,
+    std::vector<LintRuleStatus>&& new_statuses,
+    const verible::LintWaiver& waivers,
+    const verible::FlatIntervalSet<int>& lines, const LineColumnMap& line_map,
     absl::string_view text_base,
     std::vector<LintRuleStatus>* cumulative_statuses) {
-  for (const auto& status : new_statuses) {
-    cumulative_statuses->push_back(status);
+  static const verible::LineNumberSet kNoLines;
+  for (auto& new_status : new_statuses) {
+    cumulative_statuses->push_back(std::move(new_status));
+    const LintRuleStatus& status = cumulative_statuses->back();
     const auto* waived_lines =
         waivers.LookupLineNumberSet(status.lint_rule_name);
-    if (waived_lines) {
+    if ((waived_lines || !lines.empty()) && !status.violations.empty()) {
+      // Violations are visited in order of location, so lines are looked up
+      // with cursors that move forward.
+      verible::LineColumnCursor cursor(line_map);
+      const verible::FlatIntervalSet<int> flat_waived_lines(
+          waived_lines ? *waived_lines : kNoLines);
+      verible::FlatIntervalSet<int>::Cursor waived_cursor(flat_waived_lines);
+      verible::FlatIntervalSet<int>::Cursor lines_cursor(lines);
       cumulative_statuses->back().WaiveViolations(
           [&](const verible::LintViolation& violation) {
             // Lookup the line number on which the offending token resides.
             const size_t offset = violation.token.left(text_base);
-            const size_t line = line_map.LineAtOffset(offset);
+            const size_t line = cursor.LineAtOffset(offset);
+            if (!lines.empty() && !lines_cursor.Contains(line + 1)) {
+              VLOG(2) << "Violation of " << status.lint_rule_name
+                      << " rule on line " << line + 1 << " is not linted.";
+              return true;
+            }
             // Check that line number against the set of waived lines.
-            const bool waived =
-                LintWaiver::LineNumberSetContains(*waived_lines, line);
+            const bool waived = waived_cursor.Contains(line);
             VLOG(2) << "Violation of " << status.lint_rule_name
                     << " rule on line " << line + 1
                     << (waived ? " is waived." : " is not waived.");
@@ -278,17 +686,148 @@ std::vector<LintRuleStatus> VerilogLinter::ReportStatus(
     const LineColumnMap& line_map, absl::string_view text_base) {
   std::vector<LintRuleStatus> statuses;
   const verible::LintWaiver& waivers = lint_waiver_.GetLintWaiver();
-  AppendLintRuleStatuses(line_linter_.ReportStatus(), waivers, line_map,
-                         text_base, &statuses);
+  const verible::FlatIntervalSet<int> lines(lines_);
+  AppendLintRuleStatuses(line_linter_.ReportStatus(), waivers, lines,
+                         line_map, text_base, &statuses);
   AppendLintRuleStatuses(text_structure_linter_.ReportStatus(), waivers,
+                         lines, line_map, text_base, &statuses);
+  AppendLintRuleStatuses(token_stream_linter_.ReportStatus(), waivers, lines,
+                         line_map, text_base, &statuses);
+  // Report the syntax tree rules in the order in which they were configured.
+  std::vector<std::vector<LintRuleStatus>> syntax_tree_statuses;
+  size_t num_syntax_tree_statuses = 0;
+  for (const auto& linter : syntax_tree_linters_) {
+    syntax_tree_statuses.push_back(linter.ReportStatus());
+    num_syntax_tree_statuses += syntax_tree_statuses.back().size();
+  }
+  std::vector<LintRuleStatus> syntax_tree_status;
+  syntax_tree_status.reserve(num_syntax_tree_statuses);
+  for (size_t i = 0; i < num_syntax_tree_statuses; ++i) {
+    syntax_tree_status.push_back(std::move(
+        syntax_tree_statuses[i % syntax_tree_statuses.size()]
+                            [i / syntax_tree_statuses.size()]));
+  }
+  AppendLintRuleStatuses(std::move(syntax_tree_status), waivers, lines,
                          line_map, text_base, &statuses);
-  AppendLintRuleStatuses(token_stream_linter_.ReportStatus(), waivers, line_map,
-                         text_base, &statuses);
-  AppendLintRuleStatuses(syntax_tree_linter_.ReportStatus(), waivers, line_map,
-                         text_base, &statuses);
+  if (verible::SubsystemMemory().Enabled()) {
+    int64_t violations = 0;
+    for (const LintRuleStatus& status : statuses) {
+      violations += status.violations.size();
+    }
+    verible::SubsystemMemory().Allocate(
+        "lint violations", statuses.capacity() * sizeof(LintRuleStatus) +
+                               violations * sizeof(verible::LintViolation));
+  }
   return statuses;
 }
 
+int LintProject(std::ostream* stream,
+                const std::vector<std::string>& filenames,
+                const LinterConfiguration& config,
+                verible::ViolationHandler* violation_handler, bool lint_fatal,
+                int jobs) {
+  auto rules = config.CreateProjectRules();
+  if (!rules.ok()) {
+    *stream << rules.status().message() << std::endl;
+    return 2;
+  }
+  if (rules->empty()) return 0;
+
+  // Files that can't be read are skipped; LintOneFile() reports them.
+  VerilogProject project(".", {});
+  const auto opened = project.OpenTranslationUnits(filenames, jobs);
+  std::vector<std::string> units;
+  std::vector<const VerilogSourceFile*> files;
+  std::set<const VerilogSourceFile*> seen;
+  for (size_t i = 0; i < filenames.size(); ++i) {
+    if (!opened[i].ok() || !seen.insert(*opened[i]).second) continue;
+    units.push_back(filenames[i]);
+    files.push_back(*opened[i]);
+  }
+
+  // Syntax errors are reported by LintOneFile(), and the rules see the
+  // symbols of the partial syntax trees.
+  SymbolTable symbol_table(&project);
+  std::vector<absl::Status> diagnostics;
+  {
+    VERIBLE_TRACE_SCOPE("lint", "project-symbol-table");
+    symbol_table.BuildTranslationUnits(units, jobs, &diagnostics);
+    symbol_table.Resolve(&diagnostics, jobs);
+  }
+  for (const absl::Status& diagnostic : diagnostics) {
+    VLOG(1) << diagnostic;
+  }
+  const FileDependencies dependencies(symbol_table);
+  std::map<const VerilogSourceFile*, std::vector<const SymbolTableNode*>>
+      root_symbols_by_file;
+  for (const auto& [name, node] : symbol_table.Root().Children()) {
+    const VerilogSourceFile* origin = node.Value().file_origin;
+    if (origin != nullptr) root_symbols_by_file[origin].push_back(&node);
+  }
+  const analysis::ProjectLintContext context{
+      project, symbol_table, dependencies, root_symbols_by_file};
+
+  // The files of a level only depend on those of earlier levels.
+  verible::ThreadPool pool(jobs > 1 ? jobs - 1 : 0);
+  for (const auto& level : dependencies.CompileLevels(files)) {
+    VERIBLE_TRACE_SCOPE("lint", "project-rules");
+    pool.ParallelFor(level.size(), [&](size_t i) {
+      for (const auto& rule : *rules) rule->Lint(context, *level[i]);
+    });
+  }
+
+  // Violations are told apart by the file whose text they are in.
+  std::map<const VerilogSourceFile*, std::vector<LintRuleStatus>>
+      statuses_by_file;
+  for (const auto& rule : *rules) {
+    LintRuleStatus status = rule->Report();
+    std::map<const VerilogSourceFile*, LintRuleStatus> file_statuses;
+    for (verible::LintViolation& violation : status.violations) {
+      const VerilogSourceFile* origin =
+          project.LookupFileOrigin(violation.token.text());
+      if (origin == nullptr) continue;
+      auto [entry, inserted] = file_statuses.try_emplace(origin);
+      if (inserted) {
+        entry->second.lint_rule_name = status.lint_rule_name;
+        entry->second.url = status.url;
+      }
+      entry->second.violations.push_back(std::move(violation));
+    }
+    for (auto& [file, file_status] : file_statuses) {
+      statuses_by_file[file].push_back(std::move(file_status));
+    }
+  }
+
+  int exit_status = 0;
+  for (const VerilogSourceFile* file : files) {
+    auto found = statuses_by_file.find(file);
+    if (found == statuses_by_file.end()) continue;
+    const absl::string_view base = file->GetContent();
+    verible::LintWaiverBuilder lint_waiver = MakeLintWaiverBuilder();
+    if (const auto* text_structure = file->GetTextStructure()) {
+      lint_waiver.ProcessTokenRangesByLine(*text_structure);
+    }
+    // Errors in waiver files are reported by LintOneFile().
+    ApplyExternalWaiverFiles(config, file->ReferencedPath(), &lint_waiver)
+        .IgnoreError();
+    std::vector<LintRuleStatus> statuses;
+    AppendLintRuleStatuses(std::move(found->second),
+                           lint_waiver.GetLintWaiver(),
+                           verible::FlatIntervalSet<int>(), LineColumnMap(base),
+                           base, &statuses);
+    const int status = ReportLintStatuses(
+        statuses, base,
+        [&](const std::vector<LintViolationWithStatus>& violations,
+            absl::string_view text) {
+          violation_handler->HandleViolations(violations, text,
+                                              file->ReferencedPath());
+        },
+        lint_fatal);
+    exit_status = std::max(exit_status, status);
+  }
+  return exit_status;
+}
+
 absl::StatusOr<LinterConfiguration> LinterConfigurationFromFlags(
     absl::string_view linting_start_file) {
   LinterConfiguration config;
@@ -307,11 +846,80 @@ absl::StatusOr<LinterConfiguration> LinterConfigurationFromFlags(
   return config;
 }
 
+absl::StatusOr<LinterConfiguration> LinterConfigurationCache::FromFlags(
+    absl::string_view linting_start_file) {
+  return Get({
+      .ruleset = absl::GetFlag(FLAGS_ruleset),
+      .rules = absl::GetFlag(FLAGS_rules),
+      .config_file = absl::GetFlag(FLAGS_rules_config),
+      .rules_config_search = absl::GetFlag(FLAGS_rules_config_search),
+      .linting_start_file = std::string(linting_start_file),
+      .waiver_files = absl::GetFlag(FLAGS_waiver_files),
+  });
+}
+
+absl::StatusOr<LinterConfiguration> LinterConfigurationCache::Get(
+    const LinterOptions& options) {
+  const std::lock_guard<std::mutex> l(lock_);
+  // Everything but the start file, which only matters for the search.
+  std::string key = absl::StrCat(
+      AbslUnparseFlag(options.ruleset), "\n", AbslUnparseFlag(options.rules),
+      "\n", options.waiver_files, "\n", options.config_file);
+  if (options.config_file.empty() && options.rules_config_search) {
+    absl::StrAppend(&key, "\nsearch:",
+                    FindConfigFile(options.linting_start_file));
+  }
+  const auto found = configurations_.find(key);
+  if (found != configurations_.end()) return found->second;
+
+  LinterConfiguration config;
+  const absl::Status status = config.ConfigureFromOptions(options);
+  absl::StatusOr<LinterConfiguration> result =
+      status.ok() ? absl::StatusOr<LinterConfiguration>(std::move(config))
+                  : absl::StatusOr<LinterConfiguration>(status);
+  return configurations_.emplace(std::move(key), std::move(result))
+      .first->second;
+}
+
+std::string LinterConfigurationCache::FindConfigFile(
+    absl::string_view linting_start_file) {
+  static constexpr absl::string_view kConfigFile = ".rules.verible_lint";
+  namespace fs = std::filesystem;
+  std::error_code err;
+  fs::path dir = fs::absolute(std::string(linting_start_file), err);
+  if (err) return "";
+  if (!fs::is_directory(dir, err)) dir = dir.parent_path();
+
+  // Directories visited without a cached result; they all share the result.
+  std::vector<std::string> visited;
+  std::string result;
+  for (;;) {
+    const auto cached = config_file_by_dir_.find(dir.string());
+    if (cached != config_file_by_dir_.end()) {
+      result = cached->second;
+      break;
+    }
+    visited.push_back(dir.string());
+    const std::string probe = (dir / std::string(kConfigFile)).string();
+    if (verible::file::FileExists(probe).ok()) {
+      result = probe;
+      break;
+    }
+    const fs::path up = dir.parent_path();
+    if (up == dir) break;
+    dir = up;
+  }
+  for (std::string& visited_dir : visited) {
+    config_file_by_dir_.emplace(std::move(visited_dir), result);
+  }
+  return result;
+}
+
 absl::StatusOr<std::vector<LintRuleStatus>> VerilogLintTextStructure(
     absl::string_view filename, const LinterConfiguration& config,
-    const TextStructureView& text_structure) {
+    const TextStructureView& text_structure, verible::ThreadPool* pool) {
   // Create the linter, add rules, and run it.
-  VerilogLinter linter;
+  VerilogLinter linter(pool);
   const absl::Status configuration_status = linter.Configure(config, filename);
   if (!configuration_status.ok()) {
     return configuration_status;
@@ -16,6 +16,8 @@
 #define VERIBLE_VERILOG_ANALYSIS_VERILOG_LINTER_H_
 
 #include <iosfwd>
+#include <map>
+#include <mutex>  // NOLINT
 #include <string>
 #include <vector>
 
@@ -31,19 +33,28 @@
 #include "common/analysis/token_stream_linter.h"
 #include "common/analysis/violation_handler.h"
 #include "common/strings/line_column_map.h"
+#include "common/strings/position.h"
 #include "common/text/text_structure.h"
+#include "common/util/thread_pool.h"
 #include "verilog/analysis/lint_rule_registry.h"
+#include "verilog/analysis/verilog_analyzer.h"
 #include "verilog/analysis/verilog_linter_configuration.h"
 
 // Flag is declared for testing purposes (used e.g. in
 // verilog/tools/ls/verilog-language-server_test.cc)
 ABSL_DECLARE_FLAG(bool, rules_config_search);
 
+// Declared for the defaults of requests of verible-verilog-lint --server.
+ABSL_DECLARE_FLAG(verilog::RuleBundle, rules);
+ABSL_DECLARE_FLAG(std::string, rules_config);
+ABSL_DECLARE_FLAG(verilog::RuleSet, ruleset);
+ABSL_DECLARE_FLAG(std::string, waiver_files);
+
 namespace verilog {
 
 // Returns violations from multiple `LintRuleStatus`es sorted by position
 // of their occurrence in source code.
-std::set<verible::LintViolationWithStatus> GetSortedViolations(
+std::vector<verible::LintViolationWithStatus> GetSortedViolations(
     const std::vector<verible::LintRuleStatus>& statuses);
 
 // Checks a single file for Verilog style lint violations.
@@ -57,6 +68,8 @@ std::set<verible::LintViolationWithStatus> GetSortedViolations(
 // If 'parse_fatal' is true, abort after encountering syntax errors, else
 // continue to analyze the salvaged code structure.
 // If 'lint_fatal' is true, exit nonzero on finding lint violations.
+// If 'analyzer_stats' is not nullptr, it receives the statistics of the
+// analysis of the file (if it could be read).
 // Returns an exit_code like status where 0 means success, 1 means some
 // errors were found (syntax, lint), and anything else is a fatal error.
 //
@@ -66,13 +79,61 @@ std::set<verible::LintViolationWithStatus> GetSortedViolations(
 int LintOneFile(std::ostream* stream, absl::string_view filename,
                 const LinterConfiguration& config,
                 verible::ViolationHandler* violation_handler, bool check_syntax,
-                bool parse_fatal, bool lint_fatal, bool show_context = false);
+                bool parse_fatal, bool lint_fatal, bool show_context = false,
+                VerilogAnalyzerStats* analyzer_stats = nullptr);
+
+// Like LintOneFile(), but fixes violations with 'violation_fixer', and then
+// lints the fixed text again, and applies the first autofix of each
+// violation found, in up to 'max_passes' passes in total, until a pass
+// changes nothing.  This finds fixes that only apply after others, and the
+// ones that conflicted with others in an earlier pass.  The edits of a pass
+// are merged and applied in one rewrite of the text, and the final result
+// is committed once, by CommitFixedContent().  Only the violations of the
+// first pass are reported, and determine the return code.
+int LintAndFixOneFile(std::ostream* stream, absl::string_view filename,
+                      const LinterConfiguration& config,
+                      verible::ViolationFixer* violation_fixer, int max_passes,
+                      bool check_syntax, bool parse_fatal, bool lint_fatal,
+                      bool show_context = false);
+
+// Like LintOneFile(), but checks every `ifdef configuration of the file.
+// The variants are enumerated by FlowTree; each distinct set of defined macros
+// is analyzed (with preprocessor branches filtered) and linted on its own, on a
+// pool of 'jobs' threads.  At most 'max_variants' variants are checked.
+// Syntax errors and lint violations of all variants are merged, and the ones
+// found at the same location in several variants are only reported once.
+// Falls back to LintOneFile() if the conditionals can't be enumerated.
+int LintOneFileVariants(std::ostream* stream, absl::string_view filename,
+                        const LinterConfiguration& config,
+                        verible::ViolationHandler* violation_handler,
+                        bool check_syntax, bool parse_fatal, bool lint_fatal,
+                        bool show_context, int max_variants, int jobs);
+
+// Checks 'filenames' together with the project lint rules of 'config' (see
+// ProjectLintRule), which need to know about more than one file.  The files
+// are parsed, and their symbol table is built and resolved, once for all
+// rules, on up to 'jobs' threads.  Files are checked in dependency levels
+// (FileDependencies::CompileLevels()), the files of a level in parallel.
+// Violations are passed to 'violation_handler' by file, in the order of
+// 'filenames', except those waived by comments or waiver files.
+// Syntax errors and unreadable files are left to LintOneFile() to report.
+// Returns an exit code like LintOneFile(); 0 if no project rule is enabled.
+int LintProject(std::ostream* stream,
+                const std::vector<std::string>& filenames,
+                const LinterConfiguration& config,
+                verible::ViolationHandler* violation_handler, bool lint_fatal,
+                int jobs = 1);
 
 // VerilogLinter analyzes a TextStructureView of Verilog source code.
 // This uses syntax-tree based analyses and lexical token-stream analyses.
 class VerilogLinter {
  public:
-  VerilogLinter();
+  // With a 'pool', Lint() runs the line, token-stream, text-structure and
+  // syntax-tree linters concurrently on it and the calling thread, with the
+  // syntax-tree rules split into a few partitions.  Linters without rules
+  // are skipped.  The pool may be shared, and Lint() may be called from work
+  // running in it.
+  explicit VerilogLinter(verible::ThreadPool* pool = nullptr);
 
   // Configures the internal linters, enabling select rules.
   absl::Status Configure(const LinterConfiguration& configuration,
@@ -93,14 +154,20 @@ class VerilogLinter {
   // Token-based linter.
   verible::TokenStreamLinter token_stream_linter_;
 
-  // Syntax-tree based linter.
-  verible::SyntaxTreeLinter syntax_tree_linter_;
+  // Syntax-tree based linters; rule i is in partition i % size().  There are
+  // no more partitions than rules.
+  std::vector<verible::SyntaxTreeLinter> syntax_tree_linters_;
 
   // TextStructure-based linter.
   verible::TextStructureLinter text_structure_linter_;
 
   // Tracks the set of waived lines per rule.
   verible::LintWaiverBuilder lint_waiver_;
+
+  // Lines to lint (1-based), see LinterConfiguration::lines.
+  verible::LineNumberSet lines_;
+
+  verible::ThreadPool* const pool_;
 };
 
 // Creates a linter configuration from global flags.
@@ -109,6 +176,34 @@ class VerilogLinter {
 absl::StatusOr<LinterConfiguration> LinterConfigurationFromFlags(
     absl::string_view linting_start_file = ".");
 
+// Makes linter configurations for linting many files in one run, like
+// LinterConfigurationFromFlags() does for each of them.  Configurations are
+// cached by their options and resolved rules configuration file, and the
+// results of the upward search for configuration files (--rules_config_search)
+// by directory, so that files sharing a configuration neither search nor
+// parse it again.  Configuration files that change after their first use are
+// not re-read; long-running tools should call LinterConfigurationFromFlags().
+// Thread-safe.
+class LinterConfigurationCache {
+ public:
+  // Like LinterConfigurationFromFlags().
+  absl::StatusOr<LinterConfiguration> FromFlags(
+      absl::string_view linting_start_file);
+
+  // Like LinterConfiguration::ConfigureFromOptions().
+  absl::StatusOr<LinterConfiguration> Get(const LinterOptions& options);
+
+ private:
+  // Returns the nearest rules configuration file in the directory of
+  // 'linting_start_file' or above it, or an empty string if there is none.
+  std::string FindConfigFile(absl::string_view linting_start_file);
+
+  std::mutex lock_;  // Guards the following.
+  // Found configuration file (or "") by absolute directory.
+  std::map<std::string, std::string> config_file_by_dir_;
+  std::map<std::string, absl::StatusOr<LinterConfiguration>> configurations_;
+};
+
 // Expands linter configuration from a text file
 absl::Status AppendLinterConfigurationFromFile(
     LinterConfiguration* config, absl::string_view config_filename);
@@ -126,12 +221,14 @@ absl::Status AppendLinterConfigurationFromFile(
 //   filename: (optional) name of input file, that can appear in logs.
 //   text_structure: contains the syntax tree that will be lint-analyzed.
 //   show_context: print additional line with vulnerable code
+//   pool: (optional) threads to lint with (see VerilogLinter).
 //
 // Returns:
 //   Vector of LintRuleStatuses on success, otherwise error code.
 absl::StatusOr<std::vector<verible::LintRuleStatus>> VerilogLintTextStructure(
     absl::string_view filename, const LinterConfiguration& config,
-    const verible::TextStructureView& text_structure);
+    const verible::TextStructureView& text_structure,
+    verible::ThreadPool* pool = nullptr);
 
 // Prints the rule, description and default_enabled.
 absl::Status PrintRuleInfo(std::ostream*,
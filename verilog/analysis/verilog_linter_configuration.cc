@@ -39,6 +39,7 @@
 #include "common/util/status_macros.h"
 #include "verilog/analysis/default_rules.h"
 #include "verilog/analysis/lint_rule_registry.h"
+#include "verilog/analysis/project_lint_rule.h"
 
 namespace verilog {
 
@@ -187,6 +188,9 @@ void LinterConfiguration::UseRuleSet(const RuleSet& rules) {
       for (const auto& rule : analysis::RegisteredLineRulesNames()) {
         TurnOn(rule);
       }
+      for (const auto& rule : analysis::RegisteredProjectRulesNames()) {
+        TurnOn(rule);
+      }
       break;
     }
     case RuleSet::kNone:
@@ -287,6 +291,37 @@ LinterConfiguration::CreateTextStructureRules() const {
       configuration_, analysis::CreateTextStructureLintRule);
 }
 
+absl::StatusOr<std::vector<std::unique_ptr<analysis::ProjectLintRule>>>
+LinterConfiguration::CreateProjectRules() const {
+  return CreateRules<analysis::ProjectLintRule>(
+      configuration_, analysis::CreateProjectLintRule);
+}
+
+bool LinterConfiguration::NeedsSyntaxTree() const {
+  for (const auto& [rule_id, setting] : configuration_) {
+    if (!setting.enabled) continue;
+    if (analysis::CreateSyntaxTreeLintRule(rule_id) != nullptr) return true;
+    const auto text_rule = analysis::CreateTextStructureLintRule(rule_id);
+    if (text_rule != nullptr && text_rule->UsesSyntaxTree()) return true;
+  }
+  return false;
+}
+
+std::string LinterConfiguration::Fingerprint() const {
+  std::string result;
+  for (const auto& [rule_id, setting] : configuration_) {
+    if (!setting.enabled) continue;
+    absl::StrAppend(&result, rule_id, "=", setting.configuration, "\n");
+  }
+  absl::StrAppend(&result, "waivers: ", external_waivers, "\n");
+  if (!lines.empty()) {
+    std::ostringstream stream;
+    lines.FormatInclusive(stream, true);
+    absl::StrAppend(&result, "lines: ", stream.str(), "\n");
+  }
+  return result;
+}
+
 bool LinterConfiguration::operator==(const LinterConfiguration& config) const {
   return ActiveRuleIds() == config.ActiveRuleIds();
 }
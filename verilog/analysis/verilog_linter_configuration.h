@@ -28,7 +28,9 @@
 #include "common/analysis/syntax_tree_lint_rule.h"
 #include "common/analysis/text_structure_lint_rule.h"
 #include "common/analysis/token_stream_lint_rule.h"
+#include "common/strings/position.h"
 #include "verilog/analysis/lint_rule_registry.h"
+#include "verilog/analysis/project_lint_rule.h"
 
 namespace verilog {
 
@@ -219,9 +221,29 @@ class LinterConfiguration {
   absl::StatusOr<std::vector<std::unique_ptr<verible::TextStructureLintRule>>>
   CreateTextStructureRules() const;
 
+  // Creates instances of every enabled project lint rule
+  absl::StatusOr<std::vector<std::unique_ptr<analysis::ProjectLintRule>>>
+  CreateProjectRules() const;
+
+  // Returns true if any enabled rule looks at the syntax tree.  Otherwise,
+  // all enabled rules only need lines and tokens, and files need not be
+  // parsed for them.
+  bool NeedsSyntaxTree() const;
+
+  // Returns a description of the enabled rules with their parameters and of
+  // the waiver files, which is equal for configurations that lint alike,
+  // e.g. to key cached lint results with.  Doesn't include the contents of
+  // the waiver files.
+  std::string Fingerprint() const;
+
   // Path to external lint waivers configuration file
   std::string external_waivers;
 
+  // Lines to report violations on (1-based), e.g. the changed lines of a
+  // file; empty for all lines.  Syntax tree rules skip the subtrees outside
+  // of these lines.
+  verible::LineNumberSet lines;
+
   // Returns true if configurations are equivalent.
   bool operator==(const LinterConfiguration&) const;
 
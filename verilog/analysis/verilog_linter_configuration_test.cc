@@ -330,6 +330,44 @@ TEST(VerilogTextStructureLinterConfigurationTest, AddsExpectedNumber) {
   EXPECT_THAT(status, SizeIs(1));
 }
 
+// Confirms that only syntax tree and text-structure rules need a parse.
+TEST(LinterConfigurationTest, NeedsSyntaxTree) {
+  LinterConfiguration config;
+  EXPECT_FALSE(config.NeedsSyntaxTree());
+  config.TurnOn("test-rule-3");  // token stream rule
+  config.TurnOn("test-rule-4");  // line rule
+  EXPECT_FALSE(config.NeedsSyntaxTree());
+  config.TurnOn("test-rule-5");  // text-structure rule
+  EXPECT_TRUE(config.NeedsSyntaxTree());
+  config.TurnOff("test-rule-5");
+  EXPECT_FALSE(config.NeedsSyntaxTree());
+  config.TurnOn("test-rule-1");  // syntax tree rule
+  EXPECT_TRUE(config.NeedsSyntaxTree());
+}
+
+// Confirms that fingerprints tell apart configurations that lint differently.
+TEST(LinterConfigurationTest, Fingerprint) {
+  LinterConfiguration config;
+  config.TurnOn("test-rule-1");
+  LinterConfiguration same;
+  same.TurnOn("test-rule-1");
+  same.TurnOff("test-rule-2");  // disabled rules don't matter
+  EXPECT_EQ(config.Fingerprint(), same.Fingerprint());
+
+  LinterConfiguration configured;
+  configured.UseRuleBundle({{{"test-rule-1", {true, "param:1"}}}});
+  EXPECT_NE(configured.Fingerprint(), config.Fingerprint());
+  LinterConfiguration more_rules = config;
+  more_rules.TurnOn("test-rule-2");
+  EXPECT_NE(more_rules.Fingerprint(), config.Fingerprint());
+  LinterConfiguration waived = config;
+  waived.external_waivers = "waivers.txt";
+  EXPECT_NE(waived.Fingerprint(), config.Fingerprint());
+  LinterConfiguration some_lines = config;
+  some_lines.lines.Add({3, 5});
+  EXPECT_NE(some_lines.Fingerprint(), config.Fingerprint());
+}
+
 // Verifies that turning on-off rules works.
 TEST(VerilogSyntaxTreeLinterConfigurationTest, TurnOnTurnOff) {
   LinterConfiguration config;
@@ -427,7 +465,8 @@ TEST(VerilogSyntaxTreeLinterConfigurationTest, UseRuleSetAll) {
   auto expected_size = analysis::RegisteredSyntaxTreeRulesNames().size() +
                        analysis::RegisteredTokenStreamRulesNames().size() +
                        analysis::RegisteredTextStructureRulesNames().size() +
-                       analysis::RegisteredLineRulesNames().size();
+                       analysis::RegisteredLineRulesNames().size() +
+                       analysis::RegisteredProjectRulesNames().size();
   EXPECT_THAT(config.ActiveRuleIds(), SizeIs(expected_size));
 
   VerilogLinter linter;
@@ -858,7 +897,8 @@ TEST(ConfigureFromOptionsTest, RulesNumber) {
   auto expected_size = analysis::RegisteredSyntaxTreeRulesNames().size() +
                        analysis::RegisteredTokenStreamRulesNames().size() +
                        analysis::RegisteredTextStructureRulesNames().size() +
-                       analysis::RegisteredLineRulesNames().size();
+                       analysis::RegisteredLineRulesNames().size() +
+                       analysis::RegisteredProjectRulesNames().size();
   EXPECT_THAT(config.ActiveRuleIds(), SizeIs(expected_size));
 }
 
@@ -883,7 +923,8 @@ TEST(ConfigureFromOptionsTest, RulesSelective) {
   auto expected_size = analysis::RegisteredSyntaxTreeRulesNames().size() +
                        analysis::RegisteredTokenStreamRulesNames().size() +
                        analysis::RegisteredTextStructureRulesNames().size() +
-                       analysis::RegisteredLineRulesNames().size() - 1;
+                       analysis::RegisteredLineRulesNames().size() +
+                       analysis::RegisteredProjectRulesNames().size() - 1;
 
   EXPECT_THAT(config.ActiveRuleIds(), SizeIs(expected_size));
 }
@@ -32,12 +32,16 @@
 #include "absl/status/status.h"
 #include "absl/status/statusor.h"
 #include "absl/strings/match.h"
+#include "absl/strings/str_cat.h"
+#include "absl/strings/str_split.h"
 #include "absl/strings/string_view.h"
 #include "common/analysis/violation_handler.h"
 #include "common/util/file_util.h"
 #include "common/util/logging.h"
+#include "common/util/thread_pool.h"
 #include "gmock/gmock.h"
 #include "gtest/gtest.h"
+#include "nlohmann/json.hpp"
 #include "verilog/analysis/default_rules.h"
 #include "verilog/analysis/verilog_analyzer.h"
 #include "verilog/analysis/verilog_linter_configuration.h"
@@ -48,6 +52,7 @@ namespace {
 using ::testing::EndsWith;
 using ::testing::StartsWith;
 using verible::ViolationFixer;
+using verible::ViolationJsonLinesPrinter;
 using verible::ViolationPrinter;
 using verible::file::GetContentAsString;
 using verible::file::testing::ScopedTestFile;
@@ -185,6 +190,218 @@ TEST_F(LintOneFileTest, LintError) {
   }
 }
 
+// Returns the number of (possibly overlapping) occurrences of 'needle'.
+int CountOccurrences(absl::string_view haystack, absl::string_view needle) {
+  int count = 0;
+  for (auto pos = haystack.find(needle); pos != absl::string_view::npos;
+       pos = haystack.find(needle, pos + 1)) {
+    ++count;
+  }
+  return count;
+}
+
+// Tests that files are not parsed for rules on lines and tokens only.
+TEST_F(LintOneFileTest, LexOnlyRules) {
+  constexpr absl::string_view kTestCode =
+      "module m;  \n"  // trailing spaces
+      "  wire;\n"      // syntax error
+      "endmodule\n";
+  const ScopedTestFile temp_file(testing::TempDir(), kTestCode);
+  LinterConfiguration config;
+  config.TurnOn("no-trailing-spaces");
+  config.TurnOn("posix-eof");
+  ASSERT_FALSE(config.NeedsSyntaxTree());
+  std::ostringstream output;
+  ViolationPrinter violation_printer(&output);
+  VerilogAnalyzerStats stats;
+  const int exit_code =
+      LintOneFile(&output, temp_file.filename(), config, &violation_printer,
+                  false, false, true, false, &stats);
+  EXPECT_EQ(exit_code, 1);
+  EXPECT_EQ(CountOccurrences(output.str(), "[no-trailing-spaces]"), 1)
+      << "output:\n"
+      << output.str();
+  EXPECT_GT(stats.filtered_tokens, 0u);
+  EXPECT_EQ(stats.preprocessed_tokens, 0u);  // neither preprocessed nor parsed
+  EXPECT_EQ(stats.syntax_tree_nodes, 0u);
+}
+
+// Tests that violations are written as one JSON object per line.
+TEST_F(LintOneFileTest, JsonLinesViolations) {
+  constexpr absl::string_view kTestCode =
+      "module m; \n"  // trailing space
+      "endmodule\t\n";
+  const ScopedTestFile temp_file(testing::TempDir(), kTestCode);
+  LinterConfiguration config;
+  config.TurnOn("no-trailing-spaces");
+  std::ostringstream syntax_errors;
+  std::ostringstream output;
+  ViolationJsonLinesPrinter violation_printer(&output);
+  const int exit_code =
+      LintOneFile(&syntax_errors, temp_file.filename(), config,
+                  &violation_printer, true, true, true, false);
+  EXPECT_EQ(exit_code, 1);
+  EXPECT_TRUE(syntax_errors.str().empty()) << syntax_errors.str();
+
+  const std::vector<absl::string_view> lines =
+      absl::StrSplit(output.str(), '\n', absl::SkipEmpty());
+  ASSERT_EQ(lines.size(), 2u) << "output:\n" << output.str();
+  const nlohmann::json first = nlohmann::json::parse(lines[0]);
+  EXPECT_EQ(first["file"], std::string(temp_file.filename()));
+  EXPECT_EQ(first["line"], 1);
+  EXPECT_EQ(first["column"], 10);
+  EXPECT_EQ(first["end_line"], 1);
+  EXPECT_EQ(first["end_column"], 11);
+  EXPECT_EQ(first["rule"], "no-trailing-spaces");
+  EXPECT_FALSE(first["reason"].get<std::string>().empty());
+  EXPECT_TRUE(first["autofix"]);
+  const nlohmann::json second = nlohmann::json::parse(lines[1]);
+  EXPECT_EQ(second["line"], 2);
+  EXPECT_EQ(second["column"], 10);
+}
+
+// Tests that violations common to several variants are reported once.
+TEST_F(LintOneFileTest, VariantsLintErrorsMerged) {
+  constexpr absl::string_view kTestCode =
+      "task automatic foo;\n"
+      "  $psprintf(\"blah\");\n"  // forbidden function, in all variants
+      "`ifdef DEBUG\n"
+      "  $psprintf(\"debug\");\n"  // only in the DEBUG variant
+      "`endif\n"
+      "endtask\n";
+  const ScopedTestFile temp_file(testing::TempDir(), kTestCode);
+  for (const int jobs : {1, 4}) {
+    std::ostringstream output;
+    ViolationPrinter violation_printer(&output);
+    const int exit_code = LintOneFileVariants(
+        &output, temp_file.filename(), config_, &violation_printer, true,
+        false, true, false, 64, jobs);
+    EXPECT_EQ(exit_code, 1) << "output:\n" << output.str();
+    EXPECT_EQ(CountOccurrences(output.str(), temp_file.filename()), 2)
+        << "output:\n"
+        << output.str();
+  }
+}
+
+// Tests that syntax errors of one variant are found.
+TEST_F(LintOneFileTest, VariantsSyntaxError) {
+  constexpr absl::string_view kTestCode =
+      "module m;\n"
+      "`ifdef BROKEN\n"
+      "  wire;\n"
+      "`endif\n"
+      "endmodule\n";
+  const ScopedTestFile temp_file(testing::TempDir(), kTestCode);
+  std::ostringstream output;
+  ViolationPrinter violation_printer(&output);
+  const int exit_code =
+      LintOneFileVariants(&output, temp_file.filename(), config_,
+                          &violation_printer, true, true, false, false, 64, 2);
+  EXPECT_EQ(exit_code, 1);
+  EXPECT_FALSE(output.str().empty());
+}
+
+// Tests that project rules see the definitions and references of all files.
+TEST(LintProjectTest, CrossFileViolations) {
+  const ScopedTestFile leaf_file(testing::TempDir(),
+                                 "module leaf;\n"
+                                 "endmodule\n");
+  const ScopedTestFile top_file(testing::TempDir(),
+                                "module top;\n"
+                                "  leaf u_leaf();\n"
+                                "endmodule\n"
+                                "module unused;\n"
+                                "endmodule\n");
+  const ScopedTestFile waived_file(
+      testing::TempDir(),
+      "module waived;  // verilog_lint: waive unused-module\n"
+      "endmodule\n");
+  const std::vector<std::string> filenames = {
+      std::string(leaf_file.filename()), std::string(top_file.filename()),
+      std::string(waived_file.filename())};
+
+  RuleBundle bundle;
+  std::string error;
+  ASSERT_TRUE(bundle.ParseConfiguration("unused-module=top-modules:top", ',',
+                                        &error))
+      << error;
+  LinterConfiguration config;
+  config.UseRuleBundle(bundle);
+  std::ostringstream output;
+  ViolationPrinter violation_printer(&output);
+  EXPECT_EQ(LintProject(&output, filenames, config, &violation_printer, true,
+                        2),
+            1);
+  EXPECT_EQ(CountOccurrences(output.str(), "[unused-module]"), 1)
+      << "output:\n"
+      << output.str();
+  EXPECT_TRUE(absl::StrContains(
+      output.str(), absl::StrCat(top_file.filename(), ":4:8")))
+      << output.str();
+
+  // Without project rules, nothing is checked.
+  std::ostringstream default_output;
+  ViolationPrinter default_printer(&default_output);
+  LinterConfiguration default_config;
+  default_config.UseRuleSet(RuleSet::kDefault);
+  EXPECT_EQ(LintProject(&default_output, filenames, default_config,
+                        &default_printer, true),
+            0);
+  EXPECT_TRUE(default_output.str().empty()) << default_output.str();
+}
+
+TEST(LinterConfigurationCacheTest, SearchesOncePerDirectory) {
+  const std::string top = verible::file::JoinPath(
+      testing::TempDir(), "linter_configuration_cache_test");
+  const std::string sub = verible::file::JoinPath(top, "sub");
+  ASSERT_TRUE(verible::file::CreateDir(top).ok());
+  ASSERT_TRUE(verible::file::CreateDir(sub).ok());
+  ASSERT_TRUE(verible::file::SetContents(
+                  verible::file::JoinPath(top, ".rules.verible_lint"),
+                  "-no-tabs\n")
+                  .ok());
+
+  const RuleBundle rules;
+  auto options_for = [&rules](const std::string& file) {
+    return LinterOptions{.ruleset = RuleSet::kDefault,
+                         .rules = rules,
+                         .config_file = "",
+                         .rules_config_search = true,
+                         .linting_start_file = file,
+                         .waiver_files = ""};
+  };
+  LinterConfiguration expected;
+  ASSERT_TRUE(expected
+                  .ConfigureFromOptions(
+                      options_for(verible::file::JoinPath(sub, "a.sv")))
+                  .ok());
+  EXPECT_FALSE(expected.RuleIsOn(analysis::LintRuleId("no-tabs")));
+
+  LinterConfigurationCache cache;
+  const auto config_or =
+      cache.Get(options_for(verible::file::JoinPath(sub, "a.sv")));
+  ASSERT_TRUE(config_or.ok()) << config_or.status();
+  EXPECT_EQ(*config_or, expected);
+
+  // A configuration file added later is not seen by the cache, which already
+  // searched its directory, but is by a new one.
+  ASSERT_TRUE(verible::file::SetContents(
+                  verible::file::JoinPath(sub, ".rules.verible_lint"),
+                  "-line-length\n")
+                  .ok());
+  const auto cached_or =
+      cache.Get(options_for(verible::file::JoinPath(sub, "b.sv")));
+  ASSERT_TRUE(cached_or.ok()) << cached_or.status();
+  EXPECT_EQ(*cached_or, expected);
+
+  LinterConfigurationCache new_cache;
+  const auto fresh_or =
+      new_cache.Get(options_for(verible::file::JoinPath(sub, "b.sv")));
+  ASSERT_TRUE(fresh_or.ok()) << fresh_or.status();
+  EXPECT_FALSE(fresh_or->RuleIsOn(analysis::LintRuleId("line-length")));
+  EXPECT_TRUE(fresh_or->RuleIsOn(analysis::LintRuleId("no-tabs")));
+}
+
 class VerilogLinterTest : public DefaultLinterConfigTestFixture,
                           public testing::Test {
  public:
@@ -223,7 +440,7 @@ class VerilogLinterTest : public DefaultLinterConfigTestFixture,
     const absl::StatusOr<std::vector<verible::LintRuleStatus>> lint_result =
         VerilogLintTextStructure(filename, config_, text_structure);
     verilog::ViolationPrinter violation_printer(&diagnostics);
-    const std::set<verible::LintViolationWithStatus> violations =
+    const std::vector<verible::LintViolationWithStatus> violations =
         GetSortedViolations(lint_result.value());
     violation_printer.HandleViolations(violations, text_structure.Contents(),
                                        filename);
@@ -414,6 +631,78 @@ TEST_F(VerilogLinterTest, MultiByteUTF8CharactersAreOnlyCountedOnce) {
   EXPECT_EQ(diagnostics.second, "");
 }
 
+// Tests that linting with several threads reports the same as serially.
+TEST_F(VerilogLinterTest, ParallelLintMatchesSerial) {
+  constexpr absl::string_view kTestCode =
+      "module Bad_Name;\n"
+      "\tinitial $psprintf(\"x\");  \n"
+      "  always @* begin end\n"
+      "  wire [0:7] w;\n"
+      "endmodule\n";
+  VerilogAnalyzer analyzer(kTestCode, "parallel.sv");
+  ASSERT_TRUE(analyzer.Analyze().ok());
+  const auto serial =
+      VerilogLintTextStructure("parallel.sv", config_, analyzer.Data());
+  ASSERT_TRUE(serial.ok()) << serial.status();
+  int num_violations = 0;
+  for (const auto& status : *serial) num_violations += status.violations.size();
+  EXPECT_GE(num_violations, 4);
+
+  for (const int threads : {1, 2, 16}) {
+    verible::ThreadPool pool(threads);
+    const auto parallel = VerilogLintTextStructure("parallel.sv", config_,
+                                                   analyzer.Data(), &pool);
+    ASSERT_TRUE(parallel.ok()) << parallel.status();
+    ASSERT_EQ(parallel->size(), serial->size()) << threads;
+    for (size_t i = 0; i < serial->size(); ++i) {
+      EXPECT_EQ((*parallel)[i].lint_rule_name, (*serial)[i].lint_rule_name)
+          << threads;
+      EXPECT_EQ((*parallel)[i].violations.size(),
+                (*serial)[i].violations.size())
+          << threads << ": " << (*serial)[i].lint_rule_name;
+    }
+  }
+}
+
+// Tests that only violations on the linted lines are reported.
+TEST_F(VerilogLinterTest, OnlyLintedLinesReported) {
+  constexpr absl::string_view kTestCode =
+      "module Bad_Name;\n"
+      "\tinitial $psprintf(\"x\");  \n"
+      "  always @* begin end\n"
+      "  initial $psprintf(\"y\");\n"
+      "endmodule\n";
+  VerilogAnalyzer analyzer(kTestCode, "lines.sv");
+  ASSERT_TRUE(analyzer.Analyze().ok());
+  const auto all_lines =
+      VerilogLintTextStructure("lines.sv", config_, analyzer.Data());
+  ASSERT_TRUE(all_lines.ok()) << all_lines.status();
+
+  LinterConfiguration config = config_;
+  config.lines.Add({2, 3});  // [2, 3): only line 2
+  const auto some_lines =
+      VerilogLintTextStructure("lines.sv", config, analyzer.Data());
+  ASSERT_TRUE(some_lines.ok()) << some_lines.status();
+
+  const verible::LineColumnMap& line_map = analyzer.Data().GetLineColumnMap();
+  const auto lines_of = [&](const std::vector<verible::LintRuleStatus>& s) {
+    std::vector<int> lines;  // 1-based
+    for (const auto& violation : GetSortedViolations(s)) {
+      lines.push_back(line_map.LineAtOffset(violation.violation->token.left(
+                          analyzer.Data().Contents())) +
+                      1);
+    }
+    return lines;
+  };
+  const std::vector<int> all = lines_of(*all_lines);
+  std::vector<int> expected;
+  std::copy_if(all.begin(), all.end(), std::back_inserter(expected),
+               [](int line) { return line == 2; });
+  EXPECT_GE(expected.size(), 3);  // tab, task, trailing spaces
+  EXPECT_LT(expected.size(), all.size());
+  EXPECT_EQ(lines_of(*some_lines), expected);
+}
+
 TEST(VerilogLinterDocumentationTest, AllRulesHelpDescriptions) {
   std::ostringstream stream;
   verilog::GetLintRuleDescriptionsHelpFlag(&stream, "all");
@@ -461,7 +750,7 @@ class ViolationFixerTest : public testing::Test {
     const absl::StatusOr<std::vector<verible::LintRuleStatus>> lint_result =
         VerilogLintTextStructure(temp_file.filename(), config_, text_structure);
 
-    const std::set<verible::LintViolationWithStatus> violations =
+    const std::vector<verible::LintViolationWithStatus> violations =
         GetSortedViolations(lint_result.value());
     violation_fixer->HandleViolations(violations, text_structure.Contents(),
                                       temp_file.filename());
@@ -908,5 +1197,53 @@ TEST_F(ViolationFixerTest, PrintAppliedFixes) {
       });
 }
 
+// Tests that fixes left to do after others are found in more passes.
+TEST_F(ViolationFixerTest, FollowOnFixesInMorePasses) {
+  // Removing the second semicolon leaves a trailing space behind.
+  constexpr absl::string_view kInput =
+      "module m;\n"
+      "  wire a; ; \n"
+      "endmodule\n";
+  const ViolationFixer::AnswerChooser apply_all =
+      [](const verible::LintViolation&, absl::string_view) {
+        return ViolationFixer::Answer{ViolationFixer::AnswerChoice::kApplyAll};
+      };
+  const std::pair<int, absl::string_view> kTestCases[] = {
+      {1, "module m;\n  wire a; \nendmodule\n"},
+      {3, "module m;\n  wire a;\nendmodule\n"},
+  };
+  for (const auto& [max_passes, expected] : kTestCases) {
+    {  // In-place fixing
+      const ScopedTestFile temp_file(testing::TempDir(), kInput);
+      std::ostringstream diagnostics;
+      ViolationFixer violation_fixer(&diagnostics, nullptr, apply_all);
+      EXPECT_EQ(LintAndFixOneFile(&diagnostics, temp_file.filename(), config_,
+                                  &violation_fixer, max_passes, true, false,
+                                  false),
+                0);
+      const auto fixed = GetContentAsString(temp_file.filename());
+      ASSERT_TRUE(fixed.ok());
+      EXPECT_EQ(*fixed, expected) << max_passes;
+    }
+    {  // Patch generation
+      const ScopedTestFile temp_file(testing::TempDir(), kInput);
+      std::ostringstream diagnostics;
+      std::ostringstream patch;
+      ViolationFixer violation_fixer(&diagnostics, &patch, apply_all);
+      EXPECT_EQ(LintAndFixOneFile(&diagnostics, temp_file.filename(), config_,
+                                  &violation_fixer, max_passes, true, false,
+                                  false),
+                0);
+      EXPECT_EQ(*GetContentAsString(temp_file.filename()), kInput);
+      // One patch, of the original text.
+      EXPECT_EQ(CountOccurrences(patch.str(), "\n-  wire a; ; \n"), 1)
+          << patch.str();
+      EXPECT_EQ(CountOccurrences(patch.str(), "\n+  wire a;\n"),
+                max_passes > 1 ? 1 : 0)
+          << patch.str();
+    }
+  }
+}
+
 }  // namespace
 }  // namespace verilog
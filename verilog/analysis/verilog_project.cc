@@ -14,12 +14,19 @@
 
 #include "verilog/analysis/verilog_project.h"
 
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
 #include <filesystem>
 #include <iostream>
 #include <memory>
+#include <mutex>
+#include <set>
 #include <string>
+#include <utility>
 #include <vector>
 
+#include "absl/hash/hash.h"
 #include "absl/status/status.h"
 #include "absl/strings/str_cat.h"
 #include "absl/strings/str_join.h"
@@ -30,16 +37,61 @@
 #include "common/util/file_util.h"
 #include "common/util/logging.h"
 #include "verilog/analysis/verilog_analyzer.h"
+#include "verilog/analysis/verilog_filelist.h"
 
 namespace verilog {
 
 // All files we process with the verilog project, essentially applications that
 // build a symbol table (project-tool, kythe-indexer) only benefit from
-// processing the same sequence of tokens a synthesis tool sees.
+// processing the same sequence of tokens a synthesis tool sees.  The text of
+// filtered out branches is only skipped over, not lexed.
 static constexpr verilog::VerilogPreprocess::Config kPreprocessConfig{
     .filter_branches = true,
+    .skip_filtered_branches = true,
 };
 
+std::shared_ptr<SharedParses::Entry> SharedParses::Acquire(
+    int64_t project_id, std::shared_ptr<verible::MemBlock> content) {
+  const absl::string_view text = content->AsStringView();
+  const std::lock_guard<std::mutex> l(lock_);
+  std::vector<Slot>& slots = slots_[absl::Hash<absl::string_view>()(text)];
+  slots.erase(std::remove_if(slots.begin(), slots.end(),
+                             [](const Slot& slot) {
+                               return slot.entry.expired();
+                             }),
+              slots.end());
+  for (Slot& slot : slots) {
+    std::shared_ptr<Entry> entry = slot.entry.lock();
+    if (entry->content->AsStringView() != text) continue;
+    if (!slot.projects.insert(project_id).second) continue;
+    ++reused_count_;
+    return entry;
+  }
+  auto entry = std::make_shared<Entry>();
+  entry->content = std::move(content);
+  slots.push_back({entry, {project_id}});
+  return entry;
+}
+
+int64_t SharedParses::reused_count() const {
+  const std::lock_guard<std::mutex> l(lock_);
+  return reused_count_;
+}
+
+// Lexes and parses with "analyzer", and reports the time that took.
+static absl::Status AnalyzeTimed(VerilogAnalyzer* analyzer,
+                                 absl::string_view path) {
+  const absl::Time start = absl::Now();
+  absl::Status status = analyzer->AnalyzeWithParseCache();
+  const absl::Duration analyze_time = absl::Now() - start;
+  if (analyze_time > absl::Milliseconds(500)) {
+    LOG(WARNING) << "Slow Parse " << path << " took " << analyze_time;
+  } else {
+    VLOG(1) << "Parse " << path << " in " << analyze_time;
+  }
+  return status;
+}
+
 VerilogSourceFile::VerilogSourceFile(absl::string_view referenced_path,
                                      const absl::Status& status)
     : referenced_path_(referenced_path), status_(status) {}
@@ -49,11 +101,19 @@ absl::Status VerilogSourceFile::Open() {
   if (processing_state_ != ProcessingState::kInitialized) return status_;
 
   // Load file contents.
-  auto content_status = verible::file::GetContentAsMemBlock(ResolvedPath());
-  status_ = content_status.status();
+  return SetContent(verible::file::GetContentAsMemBlock(ResolvedPath()));
+}
+
+absl::Status VerilogSourceFile::SetContent(
+    absl::StatusOr<std::unique_ptr<verible::MemBlock>> content) {
+  status_ = content.status();
   if (!status_.ok()) return status_;
 
-  content_ = std::move(*content_status);
+  content_ = std::move(*content);
+  if (shared_parses_) {
+    shared_entry_ = shared_parses_->Acquire(project_id_, std::move(content_));
+    content_ = shared_entry_->content;
+  }
   processing_state_ = ProcessingState::kOpened;
 
   return status_;  // status_ is Ok here.
@@ -72,16 +132,21 @@ absl::Status VerilogSourceFile::Parse() {
   if (!status_.ok()) return status_;
 
   // Lex, parse, populate underlying TextStructureView.
-  analyzed_structure_ = std::make_unique<VerilogAnalyzer>(
-      content_, ResolvedPath(), kPreprocessConfig);
-
-  const absl::Time start = absl::Now();
-  status_ = analyzed_structure_->Analyze();
-  const absl::Duration analyze_time = absl::Now() - start;
-  if (analyze_time > absl::Milliseconds(500)) {
-    LOG(WARNING) << "Slow Parse " << ResolvedPath() << " took " << analyze_time;
+  if (shared_entry_) {
+    // Whichever project parses the contents first does so for all; the
+    // others wait for it.  Diagnostics name the file of that project.
+    SharedParses::Entry& entry = *shared_entry_;
+    std::call_once(entry.parse_once, [&entry, this]() {
+      entry.analyzer = std::make_shared<VerilogAnalyzer>(
+          entry.content, ResolvedPath(), kPreprocessConfig);
+      entry.status = AnalyzeTimed(entry.analyzer.get(), ResolvedPath());
+    });
+    analyzed_structure_ = entry.analyzer;
+    status_ = entry.status;
   } else {
-    VLOG(1) << "Parse " << ResolvedPath() << " in " << analyze_time;
+    analyzed_structure_ = std::make_shared<VerilogAnalyzer>(
+        content_, ResolvedPath(), kPreprocessConfig);
+    status_ = AnalyzeTimed(analyzed_structure_.get(), ResolvedPath());
   }
 
   processing_state_ = ProcessingState::kParsed;
@@ -135,27 +200,35 @@ absl::Status ParsedVerilogSourceFile::Parse() {
 
 const verible::TextStructureView* ParsedVerilogSourceFile::GetTextStructure()
     const {
-  return text_structure_;
+  return text_structure_.get();
 }
 
-absl::StatusOr<VerilogSourceFile*> VerilogProject::OpenFile(
+VerilogProject::iterator VerilogProject::RegisterFile(
     absl::string_view referenced_filename, absl::string_view resolved_filename,
     absl::string_view corpus) {
   const auto inserted = files_.emplace(
       referenced_filename, std::make_unique<VerilogSourceFile>(
                                referenced_filename, resolved_filename, corpus));
   CHECK(inserted.second);  // otherwise, would have already returned above
-  const auto file_iter = inserted.first;
-  VerilogSourceFile& file(*file_iter->second);
+  ShareParsesOf(inserted.first->second.get());
+  return inserted.first;
+}
 
-  // Read the file's contents.
-  const absl::Status status = file.Open();
-  if (!status.ok()) return status;
+int64_t VerilogProject::NextProjectId() {
+  static std::atomic<int64_t> next_id(0);
+  return next_id++;
+}
+
+void VerilogProject::ShareParsesOf(VerilogSourceFile* file) const {
+  file->shared_parses_ = shared_parses_;
+  file->project_id_ = project_id_;
+}
 
+void VerilogProject::RegisterContents(iterator file_iter) {
   // NOTE: string view maps don't support removal operation. The following block
   // is valid only if files won't be removed from the project.
   if (populate_string_maps_) {
-    const absl::string_view contents(file.GetContent());
+    const absl::string_view contents(file_iter->second->GetContent());
 
     // Register the file's contents range in string_view_map_.
     string_view_map_.must_emplace(contents);
@@ -166,7 +239,20 @@ absl::StatusOr<VerilogSourceFile*> VerilogProject::OpenFile(
         buffer_to_analyzer_map_.emplace(contents.begin(), file_iter);
     CHECK(map_inserted.second);
   }
+}
+
+absl::StatusOr<VerilogSourceFile*> VerilogProject::OpenFile(
+    absl::string_view referenced_filename, absl::string_view resolved_filename,
+    absl::string_view corpus) {
+  const auto file_iter =
+      RegisterFile(referenced_filename, resolved_filename, corpus);
+  VerilogSourceFile& file(*file_iter->second);
+
+  // Read the file's contents.
+  const absl::Status status = file.Open();
+  if (!status.ok()) return status;
 
+  RegisterContents(file_iter);
   return &file;
 }
 
@@ -202,7 +288,8 @@ std::string VerilogProject::GetRelativePathToSource(
 }
 
 void VerilogProject::UpdateFileContents(
-    absl::string_view path, const verible::TextStructureView* updatedtext) {
+    absl::string_view path,
+    std::shared_ptr<const verible::TextStructureView> updatedtext) {
   std::string projectpath = GetRelativePathToSource(path);
 
   // If we get a non-null parsed file, use that, otherwise fall back to
@@ -210,9 +297,10 @@ void VerilogProject::UpdateFileContents(
   std::unique_ptr<VerilogSourceFile> contents = nullptr;
   if (updatedtext) {
     contents = std::make_unique<ParsedVerilogSourceFile>(
-        projectpath, path, updatedtext, /*corpus=*/"");
+        projectpath, path, std::move(updatedtext), /*corpus=*/"");
   } else {
     contents = std::make_unique<VerilogSourceFile>(projectpath, path, "");
+    ShareParsesOf(contents.get());
   }
 
   auto fileptr = files_.find(projectpath);
@@ -256,28 +344,72 @@ VerilogProject::FindOpenedFile(absl::string_view filename) const {
   return absl::nullopt;
 }
 
+absl::optional<absl::StatusOr<VerilogSourceFile*>>
+VerilogProject::FindTranslationUnit(
+    absl::string_view referenced_filename) const {
+  // Check for a pre-existing entry to avoid duplicate files.
+  auto opened_file = FindOpenedFile(referenced_filename);
+  if (opened_file) return opened_file;
+
+  // Check if this is already opened file
+  return FindOpenedFile(
+      verible::file::JoinPath(TranslationUnitRoot(), referenced_filename));
+}
+
 absl::StatusOr<VerilogSourceFile*> VerilogProject::OpenTranslationUnit(
     absl::string_view referenced_filename) {
-  // Check for a pre-existing entry to avoid duplicate files.
-  {
-    const auto opened_file = FindOpenedFile(referenced_filename);
-    if (opened_file) {
-      return *opened_file;
-    }
-  }
+  const auto opened_file = FindTranslationUnit(referenced_filename);
+  if (opened_file) return *opened_file;
 
   // Locate the file among the base paths.
   const std::string resolved_filename =
       verible::file::JoinPath(TranslationUnitRoot(), referenced_filename);
-  // Check if this is already opened file
-  {
-    const auto opened_file = FindOpenedFile(resolved_filename);
-    if (opened_file) {
-      return *opened_file;
-    }
+  return OpenFile(referenced_filename, resolved_filename, Corpus());
+}
+
+std::vector<absl::StatusOr<VerilogSourceFile*>>
+VerilogProject::OpenTranslationUnits(
+    const std::vector<std::string>& referenced_filenames, int jobs) {
+  // Files are registered in order, then read concurrently: opening a file only
+  // touches the file itself.
+  std::vector<iterator> new_files;
+  for (const std::string& referenced_filename : referenced_filenames) {
+    if (FindTranslationUnit(referenced_filename)) continue;
+    new_files.push_back(RegisterFile(
+        referenced_filename,
+        verible::file::JoinPath(TranslationUnitRoot(), referenced_filename),
+        Corpus()));
   }
 
-  return OpenFile(referenced_filename, resolved_filename, Corpus());
+  std::vector<std::string> paths;
+  paths.reserve(new_files.size());
+  for (const iterator file_iter : new_files) {
+    paths.emplace_back(file_iter->second->ResolvedPath());
+  }
+  verible::file::GetContentsAsMemBlocks(
+      paths, jobs,
+      [&new_files](size_t i,
+                   absl::StatusOr<std::unique_ptr<verible::MemBlock>> content) {
+        new_files[i]->second->SetContent(std::move(content));
+      });
+  for (const iterator file_iter : new_files) {
+    if (file_iter->second->Status().ok()) RegisterContents(file_iter);
+  }
+
+  std::vector<absl::StatusOr<VerilogSourceFile*>> result;
+  result.reserve(referenced_filenames.size());
+  for (const std::string& referenced_filename : referenced_filenames) {
+    result.push_back(*FindTranslationUnit(referenced_filename));
+  }
+  return result;
+}
+
+std::vector<absl::StatusOr<VerilogSourceFile*>> VerilogProject::OpenFileList(
+    const FileList& file_list, int jobs) {
+  for (const std::string& include_dir : file_list.preprocessing.include_dirs) {
+    AddIncludePath(include_dir);
+  }
+  return OpenTranslationUnits(file_list.file_paths, jobs);
 }
 
 absl::Status VerilogProject::IncludeFileNotFoundError(
@@ -287,6 +419,24 @@ absl::Status VerilogProject::IncludeFileNotFoundError(
       "' among the included paths: ", absl::StrJoin(include_paths_, ", ")));
 }
 
+bool VerilogProject::IncludedFileExists(const std::string& resolved_filename) {
+  const std::filesystem::path path(resolved_filename);
+  const std::string dir = path.parent_path().string();
+  auto found = include_dir_files_.find(dir);
+  if (found == include_dir_files_.end()) {
+    // Directories that can't be listed have no files.
+    std::set<std::string, std::less<>> files;
+    const auto listing = verible::file::ListDir(dir);
+    if (listing.ok()) {
+      for (const std::string& file : listing->files) {
+        files.emplace(std::filesystem::path(file).filename().string());
+      }
+    }
+    found = include_dir_files_.emplace(dir, std::move(files)).first;
+  }
+  return found->second.find(path.filename().string()) != found->second.end();
+}
+
 absl::StatusOr<VerilogSourceFile*> VerilogProject::OpenIncludedFile(
     absl::string_view referenced_filename) {
   VLOG(1) << __FUNCTION__ << ", referenced: " << referenced_filename;
@@ -312,7 +462,7 @@ absl::StatusOr<VerilogSourceFile*> VerilogProject::OpenIncludedFile(
   for (const auto& include_path : include_paths_) {
     const std::string resolved_filename =
         verible::file::JoinPath(include_path, referenced_filename);
-    if (verible::file::FileExists(resolved_filename).ok()) {
+    if (IncludedFileExists(resolved_filename)) {
       VLOG(2) << "File '" << resolved_filename << "' exists. Resolved from '"
               << referenced_filename << "'";
       return OpenFile(referenced_filename, resolved_filename, Corpus());
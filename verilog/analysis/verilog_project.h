@@ -15,11 +15,18 @@
 #ifndef VERIBLE_VERILOG_ANALYSIS_VERILOG_PROJECT_H_
 #define VERIBLE_VERILOG_ANALYSIS_VERILOG_PROJECT_H_
 
+#include <cstdint>
+#include <functional>
 #include <map>
 #include <memory>
+#include <mutex>
+#include <set>
 #include <string>
+#include <utility>
 #include <vector>
 
+#include "absl/container/flat_hash_map.h"
+#include "absl/container/flat_hash_set.h"
 #include "absl/status/status.h"
 #include "absl/status/statusor.h"
 #include "absl/strings/string_view.h"
@@ -28,11 +35,50 @@
 #include "common/strings/string_memory_map.h"
 #include "common/text/text_structure.h"
 #include "verilog/analysis/verilog_analyzer.h"
+#include "verilog/analysis/verilog_filelist.h"
 
 namespace verilog {
 
 class VerilogProject;
 
+// Contents and parses of files that several VerilogProjects share, e.g. the
+// projects of the workspace folders of a language server that have copies of
+// the same libraries: files with equal contents are kept in memory, lexed and
+// parsed once.  A project uses each entry for one of its files at most, as it
+// maps the contents back to their files (see LookupFileOrigin()).
+// Thread-safe.
+class SharedParses {
+ public:
+  // Contents of a file, and the result of parsing them once.
+  struct Entry {
+    std::shared_ptr<verible::MemBlock> content;
+    std::once_flag parse_once;
+    std::shared_ptr<VerilogAnalyzer> analyzer;
+    absl::Status status;
+  };
+
+  // Returns an entry with contents equal to "content" that the project
+  // "project_id" does not use yet, or a new one with "content".
+  // The entry lives while any file holds it.
+  std::shared_ptr<Entry> Acquire(int64_t project_id,
+                                 std::shared_ptr<verible::MemBlock> content);
+
+  // Number of times an entry was returned that another project already
+  // used.
+  int64_t reused_count() const;
+
+ private:
+  struct Slot {
+    std::weak_ptr<Entry> entry;
+    absl::flat_hash_set<int64_t> projects;  // Those that used it.
+  };
+
+  mutable std::mutex lock_;  // Guards the following.
+  // Entries by the hash of their contents.
+  absl::flat_hash_map<size_t, std::vector<Slot>> slots_;
+  int64_t reused_count_ = 0;
+};
+
 // A read-only view of a single Verilog source file.
 class VerilogSourceFile {
  public:
@@ -78,6 +124,13 @@ class VerilogSourceFile {
   // Before successful Parse(), this is not initialized and returns nullptr.
   virtual const verible::TextStructureView* GetTextStructure() const;
 
+  // Releases the token streams and syntax tree of Parse(), e.g. once only
+  // the symbol table built from them is needed; shared ones live on while
+  // files of other projects use them.  The content is kept, as views of the
+  // symbol table refer to it.  Afterwards GetTextStructure() returns nullptr,
+  // and the file is not parsed again.
+  void ReleaseSyntaxTree() { analyzed_structure_.reset(); }
+
   // Returns the first non-Ok status if there is one, else OkStatus().
   absl::Status Status() const { return status_; }
 
@@ -120,6 +173,11 @@ class VerilogSourceFile {
   friend class VerilogProject;
 
  protected:
+  // Completes Open() with the 'content' that was read, or the error reading
+  // it.
+  absl::Status SetContent(
+      absl::StatusOr<std::unique_ptr<verible::MemBlock>> content);
+
   // Tracking state for linear progression of analysis, which allows
   // prerequisite actions to be cached.
   enum class ProcessingState {
@@ -158,7 +216,14 @@ class VerilogSourceFile {
   std::shared_ptr<verible::MemBlock> content_;
 
   // Contains token streams and syntax tree after Parse().
-  std::unique_ptr<VerilogAnalyzer> analyzed_structure_;
+  std::shared_ptr<VerilogAnalyzer> analyzed_structure_;
+
+  // Set by a project that shares parses with others (see
+  // VerilogProject::ShareParses()): the content and parse are those of
+  // "shared_entry_", once opened.
+  std::shared_ptr<SharedParses> shared_parses_;
+  int64_t project_id_ = 0;
+  std::shared_ptr<SharedParses::Entry> shared_entry_;
 };
 
 // Printable representation for debugging.
@@ -194,12 +259,14 @@ class ParsedVerilogSourceFile final : public VerilogSourceFile {
  public:
   // this constructor is used for updating file contents in the language server
   // it sets referenced_path and resolved_path based on URI from language server
-  ParsedVerilogSourceFile(absl::string_view referenced_path,
-                          absl::string_view resolved_path,
-                          const verible::TextStructureView* text_structure,
-                          absl::string_view corpus = "")
+  // text_structure is shared with the language server, which already parsed
+  // it, and is kept alive for the lifetime of this object.
+  ParsedVerilogSourceFile(
+      absl::string_view referenced_path, absl::string_view resolved_path,
+      std::shared_ptr<const verible::TextStructureView> text_structure,
+      absl::string_view corpus = "")
       : VerilogSourceFile(referenced_path, resolved_path, corpus),
-        text_structure_(text_structure) {}
+        text_structure_(std::move(text_structure)) {}
 
   // filename can be fake, it is not used to open any file.
   // text_structure is a pointer to a TextStructureView object of
@@ -210,7 +277,8 @@ class ParsedVerilogSourceFile final : public VerilogSourceFile {
                           const verible::TextStructureView* text_structure,
                           absl::string_view corpus = "")
       : VerilogSourceFile(filename, filename, corpus),
-        text_structure_(text_structure) {}
+        text_structure_(std::shared_ptr<const verible::TextStructureView>(),
+                        text_structure) {}
 
   // Do nothing (file contents already loaded)
   absl::Status Open() final;
@@ -226,7 +294,8 @@ class ParsedVerilogSourceFile final : public VerilogSourceFile {
   }
 
  private:
-  const verible::TextStructureView* const text_structure_;
+  // Not owned if constructed from a plain pointer.
+  const std::shared_ptr<const verible::TextStructureView> text_structure_;
 };
 
 // VerilogProject represents a set of files as a cohesive unit of compilation.
@@ -254,7 +323,8 @@ class VerilogProject {
       : translation_unit_root_(root),
         include_paths_(include_paths),
         corpus_(corpus),
-        populate_string_maps_(populate_string_maps) {}
+        populate_string_maps_(populate_string_maps),
+        project_id_(NextProjectId()) {}
 
   VerilogProject(const VerilogProject&) = delete;
   VerilogProject(VerilogProject&&) = delete;
@@ -266,6 +336,12 @@ class VerilogProject {
   const_iterator end() const { return files_.end(); }
   iterator end() { return files_.end(); }
 
+  // Shares the contents and parses of files with the other projects that
+  // use "shared", for files opened afterwards.
+  void ShareParses(std::shared_ptr<SharedParses> shared) {
+    shared_parses_ = std::move(shared);
+  }
+
   // Returns the directory to which translation units are referenced relatively.
   absl::string_view TranslationUnitRoot() const {
     return translation_unit_root_;
@@ -280,8 +356,21 @@ class VerilogProject {
   absl::StatusOr<VerilogSourceFile*> OpenTranslationUnit(
       absl::string_view referenced_filename);
 
+  // Opens many translation units at once, as OpenTranslationUnit() does each
+  // of them, but reads the files on up to "jobs" threads.  Returns the files
+  // or their errors in the order of "referenced_filenames".
+  std::vector<absl::StatusOr<VerilogSourceFile*>> OpenTranslationUnits(
+      const std::vector<std::string>& referenced_filenames, int jobs = 1);
+
+  // Adds the include directories of "file_list" and opens its files with
+  // OpenTranslationUnits().
+  std::vector<absl::StatusOr<VerilogSourceFile*>> OpenFileList(
+      const FileList& file_list, int jobs = 1);
+
   // Opens a file that was `included.
   // If the file was previously opened, that data is returned.
+  // The include paths are searched through listings of their directories,
+  // read once each, so files added to them afterwards are not found.
   absl::StatusOr<VerilogSourceFile*> OpenIncludedFile(
       absl::string_view referenced_filename);
 
@@ -314,9 +403,12 @@ class VerilogProject {
   // Returns relative path to the VerilogProject
   std::string GetRelativePathToSource(absl::string_view absolute_filepath);
 
-  // Updates file from external source, e.g. Language Server
-  void UpdateFileContents(absl::string_view path,
-                          const verible::TextStructureView* updatedtext);
+  // Updates file from external source, e.g. Language Server, which shares
+  // its parse of the file.  If "updatedtext" is nullptr, the file is opened
+  // from "path" instead.
+  void UpdateFileContents(
+      absl::string_view path,
+      std::shared_ptr<const verible::TextStructureView> updatedtext);
 
   // Adds include directory to the project
   void AddIncludePath(absl::string_view includepath) {
@@ -332,6 +424,19 @@ class VerilogProject {
       absl::string_view referenced_filename,
       absl::string_view resolved_filename, absl::string_view corpus);
 
+  // Adds a file that is not opened yet.
+  iterator RegisterFile(absl::string_view referenced_filename,
+                        absl::string_view resolved_filename,
+                        absl::string_view corpus);
+
+  // Maps the contents of a successfully opened file back to it, if
+  // populate_string_maps_.
+  void RegisterContents(iterator file_iter);
+
+  // Returns whether a would-be included file exists, which is looked up in
+  // include_dir_files_.
+  bool IncludedFileExists(const std::string& resolved_filename);
+
   // Error status factory, when include file is not found.
   absl::Status IncludeFileNotFoundError(
       absl::string_view referenced_filename) const;
@@ -345,6 +450,17 @@ class VerilogProject {
   absl::optional<absl::StatusOr<VerilogSourceFile*>> FindOpenedFile(
       absl::string_view filename) const;
 
+  // Returns a number that is different for each project.
+  static int64_t NextProjectId();
+
+  // Lets "file" share its parse with other projects, if this project does.
+  void ShareParsesOf(VerilogSourceFile* file) const;
+
+  // Same as FindOpenedFile(), for a translation unit that may have been
+  // opened by either its referenced or resolved name.
+  absl::optional<absl::StatusOr<VerilogSourceFile*>> FindTranslationUnit(
+      absl::string_view referenced_filename) const;
+
   // The path from which top-level translation units are referenced relatively
   // (often from a file list).  This path can be relative or absolute.
   // Default: the working directory of the invoking process.
@@ -367,6 +483,16 @@ class VerilogProject {
   // Set of opened files, keyed by referenced (not resolved) filename.
   file_set_type files_;
 
+  // Parses shared with other projects, if any, and the number that tells
+  // this project apart from those.
+  std::shared_ptr<SharedParses> shared_parses_;
+  const int64_t project_id_;
+
+  // Names of the files in the directories looked into for `included files,
+  // keyed by directory path, as listed the first time they are needed.
+  std::map<std::string, std::set<std::string, std::less<>>, std::less<>>
+      include_dir_files_;
+
   // Maps any string_view (substring) to its full source file text
   // (superstring).
   verible::StringViewSuperRangeMap string_view_map_;
@@ -15,8 +15,11 @@
 #include "verilog/analysis/verilog_project.h"
 
 #include <memory>
+#include <string>
+#include <vector>
 
 #include "absl/strings/match.h"
+#include "absl/strings/str_cat.h"
 #include "common/text/text_structure.h"
 #include "common/util/file_util.h"
 #include "common/util/logging.h"
@@ -24,6 +27,7 @@
 #include "gmock/gmock.h"
 #include "gtest/gtest.h"
 #include "verilog/CST/module.h"
+#include "verilog/analysis/verilog_filelist.h"
 
 namespace verilog {
 namespace {
@@ -233,6 +237,24 @@ TEST(ParsedVerilogSourceFileTest, ParseValidFile) {
   EXPECT_EQ(&text_structure->SyntaxTree(), tree);
 }
 
+TEST(VerilogProjectTest, UpdateFileContentsSharesTextStructure) {
+  const auto tempdir = ::testing::TempDir();
+  VerilogProject project(tempdir, {tempdir});
+  constexpr absl::string_view text("localparam int p = 1;\n");
+  auto analyzer = std::make_shared<VerilogAnalyzer>(text, "shared.sv");
+  ASSERT_TRUE(analyzer->Analyze().ok());
+  const TextStructureView* const data = &analyzer->Data();
+  project.UpdateFileContents(
+      JoinPath(tempdir, "shared.sv"),
+      std::shared_ptr<const TextStructureView>(analyzer, data));
+  analyzer.reset();  // The project keeps it alive.
+
+  const VerilogSourceFile* file = project.LookupRegisteredFile("shared.sv");
+  ASSERT_NE(file, nullptr);
+  EXPECT_EQ(file->GetTextStructure(), data);
+  EXPECT_EQ(file->GetContent(), text);
+}
+
 TEST(VerilogProjectTest, NonexistentTranslationUnit) {
   const auto tempdir = ::testing::TempDir();
   VerilogProject project(tempdir, {tempdir});
@@ -338,6 +360,58 @@ TEST(VerilogProjectTest, LookupFileOriginTestMoreFiles) {
   }
 }
 
+TEST(VerilogProjectTest, SharedParsesAcrossProjects) {
+  const auto tempdir = ::testing::TempDir();
+  const std::string dir1 = JoinPath(tempdir, "SharedParses1");
+  const std::string dir2 = JoinPath(tempdir, "SharedParses2");
+  EXPECT_TRUE(CreateDir(dir1).ok());
+  EXPECT_TRUE(CreateDir(dir2).ok());
+  auto shared = std::make_shared<SharedParses>();
+  VerilogProject project1(dir1, {});
+  VerilogProject project2(dir2, {});
+  project1.ShareParses(shared);
+  project2.ShareParses(shared);
+
+  constexpr absl::string_view text("module m;\nendmodule\n");
+  const ScopedTestFile tf1(dir1, text);
+  const ScopedTestFile tf2(dir2, text);
+  const ScopedTestFile tf2_copy(dir2, text);  // Same contents in project2.
+  VerilogSourceFile* file1 =
+      *project1.OpenTranslationUnit(Basename(tf1.filename()));
+  VerilogSourceFile* file2 =
+      *project2.OpenTranslationUnit(Basename(tf2.filename()));
+  VerilogSourceFile* file2_copy =
+      *project2.OpenTranslationUnit(Basename(tf2_copy.filename()));
+  EXPECT_EQ(file1->GetContent().data(), file2->GetContent().data());
+  EXPECT_NE(file2->GetContent().data(), file2_copy->GetContent().data());
+  EXPECT_EQ(shared->reused_count(), 1);
+
+  // Contents still map back to the file of each project.
+  EXPECT_EQ(project1.LookupFileOrigin(file1->GetContent().substr(2, 4)),
+            file1);
+  EXPECT_EQ(project2.LookupFileOrigin(file2->GetContent().substr(2, 4)),
+            file2);
+  EXPECT_EQ(project2.LookupFileOrigin(file2_copy->GetContent().substr(2, 4)),
+            file2_copy);
+
+  // Parsed once for both projects.
+  EXPECT_TRUE(file1->Parse().ok());
+  EXPECT_TRUE(file2->Parse().ok());
+  EXPECT_TRUE(file2_copy->Parse().ok());
+  ASSERT_NE(file1->GetTextStructure(), nullptr);
+  EXPECT_EQ(file1->GetTextStructure(), file2->GetTextStructure());
+  EXPECT_NE(file2->GetTextStructure(), file2_copy->GetTextStructure());
+
+  // Released by one project, the tree is kept for the other.
+  file1->ReleaseSyntaxTree();
+  EXPECT_EQ(file1->GetTextStructure(), nullptr);
+  ASSERT_NE(file2->GetTextStructure(), nullptr);
+  EXPECT_EQ(FindAllModuleDeclarations(
+                *file2->GetTextStructure()->SyntaxTree().get())
+                .size(),
+            1);
+}
+
 TEST(VerilogProjectTest, ValidTranslationUnit) {
   const auto tempdir = ::testing::TempDir();
   const std::string sources_dir = JoinPath(tempdir, "srcs");
@@ -525,6 +599,80 @@ TEST(VerilogProjectTest, IncludeFileNotFound) {
   }
 }
 
+TEST(VerilogProjectTest, OpenTranslationUnits) {
+  const auto tempdir = ::testing::TempDir();
+  const std::string sources_dir = JoinPath(tempdir, "bulk_srcs");
+  EXPECT_TRUE(CreateDir(sources_dir).ok());
+  VerilogProject project(sources_dir, {});
+
+  std::vector<std::unique_ptr<ScopedTestFile>> test_files;
+  std::vector<std::string> names;
+  for (int i = 0; i < 10; ++i) {
+    test_files.push_back(std::make_unique<ScopedTestFile>(
+        sources_dir, absl::StrCat("module m", i, ";\nendmodule\n")));
+    names.emplace_back(Basename(test_files.back()->filename()));
+  }
+  // Opened already, listed twice, and missing files.
+  const auto opened_before = project.OpenTranslationUnit(names[3]);
+  ASSERT_TRUE(opened_before.ok());
+  names.push_back(names[5]);
+  names.push_back("no-such-file.sv");
+
+  const auto files = project.OpenTranslationUnits(names, 4);
+  ASSERT_EQ(files.size(), names.size());
+  for (int i = 0; i < 10; ++i) {
+    ASSERT_TRUE(files[i].ok()) << files[i].status();
+    EXPECT_EQ((*files[i])->ReferencedPath(), names[i]);
+    EXPECT_EQ((*files[i])->ResolvedPath(), test_files[i]->filename());
+    EXPECT_EQ((*files[i])->GetContent(),
+              absl::StrCat("module m", i, ";\nendmodule\n"));
+    // Contents are mapped back to their files.
+    EXPECT_EQ(project.LookupFileOrigin((*files[i])->GetContent()), *files[i]);
+  }
+  EXPECT_EQ(*files[3], *opened_before);
+  EXPECT_EQ(*files[10], *files[5]);
+  EXPECT_FALSE(files[11].ok());
+
+  // Same as opening them one at a time.
+  for (size_t i = 0; i < names.size(); ++i) {
+    const auto file = project.OpenTranslationUnit(names[i]);
+    EXPECT_EQ(file.ok(), files[i].ok());
+    if (file.ok()) EXPECT_EQ(*file, *files[i]);
+  }
+}
+
+TEST(VerilogProjectTest, OpenFileListAddsIncludeDirs) {
+  const auto tempdir = ::testing::TempDir();
+  const std::string sources_dir = JoinPath(tempdir, "list_srcs");
+  const std::string includes_dir = JoinPath(tempdir, "list_includes");
+  const std::string includes_subdir = JoinPath(includes_dir, "sub");
+  EXPECT_TRUE(CreateDir(sources_dir).ok());
+  EXPECT_TRUE(CreateDir(includes_dir).ok());
+  EXPECT_TRUE(CreateDir(includes_subdir).ok());
+  VerilogProject project(sources_dir, {});
+
+  const ScopedTestFile tf(sources_dir, "`include \"sub/a.svh\"\n");
+  const ScopedTestFile include(includes_subdir, "`define A 1\n", "a.svh");
+  FileList file_list;
+  file_list.file_paths.emplace_back(Basename(tf.filename()));
+  file_list.preprocessing.include_dirs.push_back(
+      JoinPath(tempdir, "list_no_such_dir"));
+  file_list.preprocessing.include_dirs.push_back(includes_dir);
+
+  const auto files = project.OpenFileList(file_list, 2);
+  ASSERT_EQ(files.size(), 1);
+  EXPECT_TRUE(files[0].ok()) << files[0].status();
+
+  // Includes are found in the directories of the file list, also in their
+  // subdirectories.
+  const auto included = project.OpenIncludedFile("sub/a.svh");
+  ASSERT_TRUE(included.ok()) << included.status();
+  EXPECT_EQ((*included)->ResolvedPath(), include.filename());
+  EXPECT_EQ((*included)->GetContent(), "`define A 1\n");
+  EXPECT_FALSE(project.OpenIncludedFile("sub/b.svh").ok());
+  EXPECT_FALSE(project.OpenIncludedFile("a.svh").ok());
+}
+
 TEST(VerilogProjectTest, AddVirtualFile) {
   const auto tempdir = ::testing::TempDir();
   const std::string sources_dir = JoinPath(tempdir, "srcs");
@@ -0,0 +1,357 @@
+// Copyright 2017-2023 The Verible Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// corpus_bench runs the stages of the SystemVerilog tools over a corpus of
+// real files, and reports the throughput, per-file latency and peak memory
+// of each stage, e.g. to compare builds on a corpus that matters to you.
+//
+// Example usage:
+//   bazel run -c opt //verilog/benchmark:corpus_bench -- \
+//     --json_output=/tmp/before.json path/to/rtl/
+//
+// Directories are searched recursively for files with one of --extensions.
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "absl/flags/flag.h"
+#include "absl/status/status.h"
+#include "absl/status/statusor.h"
+#include "absl/strings/match.h"
+#include "absl/strings/str_cat.h"
+#include "absl/strings/str_format.h"
+#include "absl/strings/str_split.h"
+#include "absl/strings/string_view.h"
+#include "absl/time/clock.h"
+#include "absl/time/time.h"
+#include "common/util/file_util.h"
+#include "common/util/init_command_line.h"
+#include "common/util/memory_stats.h"
+#include "nlohmann/json.hpp"
+#include "verilog/analysis/symbol_table.h"
+#include "verilog/analysis/verilog_analyzer.h"
+#include "verilog/analysis/verilog_linter.h"
+#include "verilog/analysis/verilog_linter_configuration.h"
+#include "verilog/analysis/verilog_project.h"
+#include "verilog/formatting/format_style.h"
+#include "verilog/formatting/formatter.h"
+#include "verilog/parser/verilog_lexer.h"
+#include "verilog/tools/kythe/indexing_facts_tree_extractor.h"
+
+ABSL_FLAG(std::string, extensions, ".sv,.svh,.v,.vh",
+          "Comma-separated extensions of the files to take from directories.");
+ABSL_FLAG(std::string, stages, "lex,parse,lint,format,symbol-table,kythe",
+          "Comma-separated stages to run, in this order.");
+ABSL_FLAG(std::string, json_output, "",
+          "If not empty, write the results as JSON to this file ('-' for "
+          "stdout), to compare runs.");
+
+namespace verilog {
+namespace {
+
+struct CorpusFile {
+  std::string path;
+  std::string content;
+};
+
+// Measurements of one stage over the whole corpus.
+struct StageResult {
+  std::string stage;
+  int64_t files = 0;
+  int64_t bytes = 0;
+  int64_t errors = 0;
+  std::vector<absl::Duration> latencies;  // one per file
+  absl::Duration total;
+  int64_t peak_rss_bytes = 0;
+};
+
+// Appends the files under 'path' (or 'path' itself if it is not a
+// directory) to 'files', in a deterministic order.
+absl::Status CollectFiles(const std::string& path,
+                          const std::vector<std::string>& extensions,
+                          std::vector<std::string>* files) {
+  const absl::StatusOr<verible::file::Directory> dir =
+      verible::file::ListDir(path);
+  if (!dir.ok()) {
+    if (const absl::Status exists = verible::file::FileExists(path);
+        !exists.ok()) {
+      return exists;
+    }
+    files->push_back(path);
+    return absl::OkStatus();
+  }
+  for (const std::string& file : dir->files) {
+    for (const std::string& extension : extensions) {
+      if (absl::EndsWith(file, extension)) {
+        files->push_back(file);
+        break;
+      }
+    }
+  }
+  for (const std::string& subdir : dir->directories) {
+    if (absl::Status status = CollectFiles(subdir, extensions, files);
+        !status.ok()) {
+      return status;
+    }
+  }
+  return absl::OkStatus();
+}
+
+// Symbol table of all the files, which refers to their syntax trees.
+struct ProjectSymbols {
+  SymbolTable symbol_table{nullptr};
+  std::vector<std::unique_ptr<InMemoryVerilogSourceFile>> sources;
+};
+
+// Runs one file through the stage, returns false if it failed.
+bool RunStage(absl::string_view stage, const CorpusFile& file,
+              ProjectSymbols* symbols, absl::Duration* latency) {
+  if (stage == "lex") {
+    const absl::Time start = absl::Now();
+    VerilogLexer lexer(file.content);
+    bool ok = true;
+    for (;;) {
+      const verible::TokenInfo& token = lexer.DoNextToken();
+      if (token.isEOF()) break;
+      if (lexer.TokenIsError(token)) ok = false;
+    }
+    *latency = absl::Now() - start;
+    return ok;
+  }
+  if (stage == "parse") {
+    const absl::Time start = absl::Now();
+    VerilogAnalyzer analyzer(file.content, file.path);
+    const bool ok = analyzer.Analyze().ok();
+    *latency = absl::Now() - start;
+    return ok;
+  }
+  if (stage == "lint") {
+    // Only the linting itself is measured, not the parsing before it.
+    VerilogAnalyzer analyzer(file.content, file.path);
+    if (!analyzer.Analyze().ok()) return false;
+    static const LinterConfiguration* const config = []() {
+      auto* config = new LinterConfiguration();
+      config->UseRuleSet(RuleSet::kDefault);
+      return config;
+    }();
+    const absl::Time start = absl::Now();
+    const bool ok =
+        VerilogLintTextStructure(file.path, *config, analyzer.Data()).ok();
+    *latency = absl::Now() - start;
+    return ok;
+  }
+  if (stage == "format") {
+    static const formatter::FormatStyle* const style =
+        new formatter::FormatStyle();
+    std::ostringstream formatted;
+    const absl::Time start = absl::Now();
+    const bool ok =
+        formatter::FormatVerilog(file.content, file.path, *style, formatted)
+            .ok();
+    *latency = absl::Now() - start;
+    return ok;
+  }
+  if (stage == "symbol-table") {
+    // Files are built into one symbol table, as the language server and
+    // project tool do; the resolution of it is measured separately.
+    symbols->sources.push_back(
+        std::make_unique<InMemoryVerilogSourceFile>(file.path, file.content));
+    InMemoryVerilogSourceFile& source = *symbols->sources.back();
+    if (!source.Parse().ok()) return false;
+    const absl::Time start = absl::Now();
+    const bool ok = BuildSymbolTable(source, &symbols->symbol_table).empty();
+    *latency = absl::Now() - start;
+    return ok;
+  }
+  if (stage == "kythe") {
+    // Includes reading and parsing the file, as the extractor does.
+    VerilogProject project(".", {});
+    std::vector<absl::Status> errors;
+    const absl::Time start = absl::Now();
+    kythe::ExtractFiles("corpus", &project, {file.path}, &errors);
+    *latency = absl::Now() - start;
+    return errors.empty();
+  }
+  return false;
+}
+
+StageResult MeasureStage(absl::string_view stage,
+                         const std::vector<CorpusFile>& corpus) {
+  StageResult result;
+  result.stage = std::string(stage);
+  verible::ResetPeakResidentSetBytes();
+  ProjectSymbols symbols;
+  for (const CorpusFile& file : corpus) {
+    absl::Duration latency;
+    if (!RunStage(stage, file, &symbols, &latency)) ++result.errors;
+    result.latencies.push_back(latency);
+    result.total += latency;
+    ++result.files;
+    result.bytes += file.content.size();
+  }
+  if (stage == "symbol-table") {
+    std::vector<absl::Status> diagnostics;
+    const absl::Time start = absl::Now();
+    symbols.symbol_table.Resolve(&diagnostics);
+    result.total += absl::Now() - start;
+  }
+  result.peak_rss_bytes = verible::PeakResidentSetBytes();
+  std::sort(result.latencies.begin(), result.latencies.end());
+  return result;
+}
+
+// Nearest-rank percentile of the sorted 'latencies'.
+absl::Duration Percentile(const std::vector<absl::Duration>& latencies,
+                          double percent) {
+  if (latencies.empty()) return absl::ZeroDuration();
+  size_t rank = static_cast<size_t>(percent / 100 * latencies.size() + 0.5);
+  rank = std::clamp<size_t>(rank, 1, latencies.size());
+  return latencies[rank - 1];
+}
+
+double MegabytesPerSecond(const StageResult& result) {
+  const double seconds = absl::ToDoubleSeconds(result.total);
+  return seconds > 0 ? result.bytes / 1e6 / seconds : 0;
+}
+
+double FilesPerSecond(const StageResult& result) {
+  const double seconds = absl::ToDoubleSeconds(result.total);
+  return seconds > 0 ? result.files / seconds : 0;
+}
+
+void PrintTable(const std::vector<StageResult>& results, std::ostream& out) {
+  out << absl::StrFormat("%-14s %8s %7s %10s %9s %9s %9s %9s %9s\n", "stage",
+                         "files", "errors", "total-ms", "MB/s", "files/s",
+                         "p50-ms", "p99-ms", "peak-MB");
+  for (const StageResult& result : results) {
+    out << absl::StrFormat(
+        "%-14s %8d %7d %10.1f %9.2f %9.1f %9.3f %9.3f %9.1f\n", result.stage,
+        result.files, result.errors, absl::ToDoubleMilliseconds(result.total),
+        MegabytesPerSecond(result), FilesPerSecond(result),
+        absl::ToDoubleMilliseconds(Percentile(result.latencies, 50)),
+        absl::ToDoubleMilliseconds(Percentile(result.latencies, 99)),
+        result.peak_rss_bytes / 1e6);
+  }
+}
+
+nlohmann::json ToJson(const std::vector<CorpusFile>& corpus,
+                      const std::vector<StageResult>& results) {
+  nlohmann::json json;
+  int64_t bytes = 0;
+  for (const CorpusFile& file : corpus) bytes += file.content.size();
+  json["files"] = corpus.size();
+  json["bytes"] = bytes;
+  nlohmann::json& stages = json["stages"];
+  stages = nlohmann::json::object();
+  for (const StageResult& result : results) {
+    stages[result.stage] = {
+        {"files", result.files},
+        {"bytes", result.bytes},
+        {"errors", result.errors},
+        {"total_ms", absl::ToDoubleMilliseconds(result.total)},
+        {"mb_per_s", MegabytesPerSecond(result)},
+        {"files_per_s", FilesPerSecond(result)},
+        {"p50_ms",
+         absl::ToDoubleMilliseconds(Percentile(result.latencies, 50))},
+        {"p99_ms",
+         absl::ToDoubleMilliseconds(Percentile(result.latencies, 99))},
+        {"peak_rss_mb", result.peak_rss_bytes / 1e6},
+    };
+  }
+  return json;
+}
+
+constexpr absl::string_view kStages[] = {"lex",    "parse",        "lint",
+                                         "format", "symbol-table", "kythe"};
+
+}  // namespace
+}  // namespace verilog
+
+int main(int argc, char** argv) {
+  const auto usage = absl::StrCat("usage: ", argv[0],
+                                  " [options] <file-or-dir> [...]\n", R"(
+Runs the lexer, parser, linter, formatter, symbol table and kythe extractor
+on the files, and reports throughput, per-file latency and peak memory of
+each of these stages.
+)");
+  const std::vector<absl::string_view> args =
+      verible::InitCommandLine(usage, &argc, &argv);
+  if (args.size() < 2) {
+    std::cerr << usage;
+    return 1;
+  }
+
+  const std::vector<std::string> stages =
+      absl::StrSplit(absl::GetFlag(FLAGS_stages), ',', absl::SkipEmpty());
+  for (const std::string& stage : stages) {
+    if (std::find(std::begin(verilog::kStages), std::end(verilog::kStages),
+                  stage) == std::end(verilog::kStages)) {
+      std::cerr << "Unknown stage '" << stage << "' in --stages." << std::endl;
+      return 1;
+    }
+  }
+  const std::vector<std::string> extensions =
+      absl::StrSplit(absl::GetFlag(FLAGS_extensions), ',', absl::SkipEmpty());
+
+  std::vector<std::string> paths;
+  for (size_t i = 1; i < args.size(); ++i) {
+    if (const absl::Status status =
+            verilog::CollectFiles(std::string(args[i]), extensions, &paths);
+        !status.ok()) {
+      std::cerr << status.message() << std::endl;
+      return 1;
+    }
+  }
+  // Read up front, so that file system time is not measured.
+  std::vector<verilog::CorpusFile> corpus;
+  for (const std::string& path : paths) {
+    absl::StatusOr<std::string> content =
+        verible::file::GetContentAsString(path);
+    if (!content.ok()) {
+      std::cerr << content.status().message() << std::endl;
+      return 1;
+    }
+    corpus.push_back({path, *std::move(content)});
+  }
+
+  std::vector<verilog::StageResult> results;
+  for (const std::string& stage : stages) {
+    results.push_back(verilog::MeasureStage(stage, corpus));
+  }
+  verilog::PrintTable(results, std::cout);
+
+  const std::string json_output = absl::GetFlag(FLAGS_json_output);
+  if (json_output.empty()) return 0;
+  const nlohmann::json json = verilog::ToJson(corpus, results);
+  if (json_output == "-") {
+    std::cout << std::setw(2) << json << std::endl;
+    return 0;
+  }
+  std::ofstream out(json_output);
+  out << std::setw(2) << json << std::endl;
+  if (!out.good()) {
+    std::cerr << json_output << ": can't write results." << std::endl;
+    return 1;
+  }
+  return 0;
+}
@@ -0,0 +1,49 @@
+// Copyright 2017-2023 The Verible Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// generate_synthetic_corpus writes the synthetic SystemVerilog corpus that
+// is used by the benchmarks to stdout, e.g. to reproduce benchmark results
+// with the command line tools.
+//
+// Example usage:
+// generate_synthetic_corpus --size=1048576 > corpus.sv
+
+#include <cstdint>
+#include <iostream>
+#include <string>
+
+#include "absl/flags/flag.h"
+#include "absl/strings/str_cat.h"
+#include "common/util/init_command_line.h"
+#include "verilog/benchmark/synthetic_corpus.h"
+
+ABSL_FLAG(int64_t, size, 1 << 20, "Minimum size of the corpus in bytes.");
+ABSL_FLAG(uint32_t, seed, 1, "Seed of the generator.");
+
+int main(int argc, char** argv) {
+  const auto usage =
+      absl::StrCat("usage: ", argv[0], " [options] > output.sv\n", R"(
+Writes a synthetic SystemVerilog corpus to stdout.
+)");
+  verible::InitCommandLine(usage, &argc, &argv);
+
+  const int64_t size = absl::GetFlag(FLAGS_size);
+  if (size < 0) {
+    std::cerr << "--size must not be negative." << std::endl;
+    return 1;
+  }
+  std::cout << verilog::GenerateSyntheticVerilog(size,
+                                                 absl::GetFlag(FLAGS_seed));
+  return 0;
+}
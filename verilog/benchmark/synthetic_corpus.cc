@@ -0,0 +1,162 @@
+// Copyright 2017-2023 The Verible Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "verilog/benchmark/synthetic_corpus.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "absl/strings/str_cat.h"
+
+namespace verilog {
+namespace {
+
+// Uses its own deterministic random engine, so that the same corpus is
+// generated on every platform.
+class CorpusGenerator {
+ public:
+  explicit CorpusGenerator(uint32_t seed) : engine_(seed) {}
+
+  // Appends one module named after 'index' to 'out'.
+  // If 'index' > 0, the module instantiates the previous module, which has
+  // 'prev_num_inputs' inputs (ignored otherwise).
+  // Returns the number of inputs of the generated module.
+  int AppendModule(int index, int prev_num_inputs, std::string* out);
+
+ private:
+  // Returns a uniformly distributed number in [lo, hi].
+  int Uniform(int lo, int hi) {
+    return std::uniform_int_distribution<int>(lo, hi)(engine_);
+  }
+
+  // Returns one of 'names'.
+  const std::string& Pick(const std::vector<std::string>& names) {
+    return names[Uniform(0, static_cast<int>(names.size()) - 1)];
+  }
+
+  // Returns a binary expression over 'operands' with 'num_terms' terms.
+  std::string Expression(const std::vector<std::string>& operands,
+                         int num_terms);
+
+  std::mt19937 engine_;
+};
+
+std::string CorpusGenerator::Expression(
+    const std::vector<std::string>& operands, int num_terms) {
+  static constexpr const char* kOperators[] = {"+", "-", "&", "|", "^"};
+  std::string expr = Pick(operands);
+  for (int i = 1; i < num_terms; ++i) {
+    const char* op = kOperators[Uniform(0, 4)];
+    if (Uniform(0, 3) == 0) {
+      // Parenthesized sub-expression, to create balanced groups.
+      absl::StrAppend(&expr, " ", op, " (", Pick(operands), " ",
+                      kOperators[Uniform(0, 4)], " ", Pick(operands), ")");
+    } else {
+      absl::StrAppend(&expr, " ", op, " ", Pick(operands));
+    }
+  }
+  return expr;
+}
+
+int CorpusGenerator::AppendModule(int index, int prev_num_inputs,
+                                  std::string* out) {
+  const std::string name = absl::StrCat("bench_module_", index);
+  const int num_inputs = Uniform(2, 8);
+  const int num_signals = Uniform(2, 10);
+
+  std::vector<std::string> inputs;
+  for (int i = 0; i < num_inputs; ++i) {
+    inputs.push_back(absl::StrCat("in_", i, "_data"));
+  }
+  std::vector<std::string> signals;
+  for (int i = 0; i < num_signals; ++i) {
+    signals.push_back(absl::StrCat("sig_", i, "_", Pick({"a", "bb", "ccc"})));
+  }
+
+  absl::StrAppend(out, "// Synthetic module ", index, "\n");
+  absl::StrAppend(out, "module ", name, " #(\n    parameter int WIDTH = ",
+                  Uniform(1, 64), "\n) (\n");
+  absl::StrAppend(out, "    input logic clk,\n    input logic rst_n,\n");
+  for (const auto& input : inputs) {
+    absl::StrAppend(out, "    input logic [WIDTH-1:0] ", input, ",\n");
+  }
+  absl::StrAppend(out, "    output logic [WIDTH-1:0] out_data\n);\n");
+
+  for (const auto& signal : signals) {
+    absl::StrAppend(out, "  logic [WIDTH-1:0] ", signal, ";\n");
+  }
+  absl::StrAppend(out, "  logic [WIDTH-1:0] sub_out;\n");
+
+  // Continuous assignments: each signal depends on the inputs and the
+  // signals before it.  Long expressions are written on one line, so that
+  // the formatter has to search for line wraps.
+  std::vector<std::string> operands(inputs);
+  for (int i = 0; i + 1 < num_signals; ++i) {
+    absl::StrAppend(out, "  assign ", signals[i], " = ",
+                    Expression(operands, Uniform(1, 16)), ";\n");
+    operands.push_back(signals[i]);
+  }
+
+  // Function, called from the last assignment.
+  const std::string function_name = absl::StrCat("combine_", index);
+  absl::StrAppend(out, "  function automatic logic [WIDTH-1:0] ",
+                  function_name,
+                  "(input logic [WIDTH-1:0] a, input logic [WIDTH-1:0] b);\n",
+                  "    return a ^ b;\n  endfunction\n");
+  absl::StrAppend(out, "  assign ", signals.back(), " = ", function_name, "(",
+                  Pick(operands), ", ", Pick(operands), ");\n");
+  operands.push_back(signals.back());
+
+  // Sequential logic.
+  absl::StrAppend(out,
+                  "  always_ff @(posedge clk or negedge rst_n) begin\n"
+                  "    if (!rst_n) begin\n"
+                  "      out_data <= '0;\n"
+                  "    end else begin\n"
+                  "      out_data <= ",
+                  Expression(operands, Uniform(1, 6)), " ^ sub_out;\n",
+                  "    end\n  end\n");
+
+  // Instance of the previous module, otherwise tie off sub_out.
+  if (index > 0) {
+    absl::StrAppend(out, "  bench_module_", index - 1,
+                    " #(.WIDTH(WIDTH)) u_sub (.clk(clk), .rst_n(rst_n)");
+    for (int i = 0; i < prev_num_inputs; ++i) {
+      absl::StrAppend(out, ", .in_", i, "_data(", Pick(operands), ")");
+    }
+    absl::StrAppend(out, ", .out_data(sub_out));\n");
+  } else {
+    absl::StrAppend(out, "  assign sub_out = '0;\n");
+  }
+  absl::StrAppend(out, "endmodule : ", name, "\n\n");
+  return num_inputs;
+}
+
+}  // namespace
+
+std::string GenerateSyntheticVerilog(size_t target_size, uint32_t seed) {
+  CorpusGenerator generator(seed);
+  std::string result;
+  result.reserve(target_size + 4096);
+  int num_inputs = 0;
+  for (int index = 0; result.size() < target_size; ++index) {
+    num_inputs = generator.AppendModule(index, num_inputs, &result);
+  }
+  return result;
+}
+
+}  // namespace verilog
@@ -0,0 +1,36 @@
+// Copyright 2017-2023 The Verible Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef VERIBLE_VERILOG_BENCHMARK_SYNTHETIC_CORPUS_H_
+#define VERIBLE_VERILOG_BENCHMARK_SYNTHETIC_CORPUS_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+namespace verilog {
+
+// Returns syntactically valid SystemVerilog source text of at least
+// 'target_size' bytes (overshooting by at most the size of one module).
+// The text is a chain of modules, where each module instantiates the
+// previous one, with ports, declarations, long continuous assignment
+// expressions, sequential logic, and functions, so that it exercises the
+// lexer, parser, formatter, linter and symbol table alike.
+// The output is fully determined by 'target_size' and 'seed', so that
+// benchmark results are comparable across runs and builds.
+std::string GenerateSyntheticVerilog(size_t target_size, uint32_t seed = 1);
+
+}  // namespace verilog
+
+#endif  // VERIBLE_VERILOG_BENCHMARK_SYNTHETIC_CORPUS_H_
@@ -0,0 +1,56 @@
+// Copyright 2017-2023 The Verible Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "verilog/benchmark/synthetic_corpus.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+#include "gtest/gtest.h"
+#include "verilog/analysis/verilog_analyzer.h"
+
+namespace verilog {
+namespace {
+
+TEST(GenerateSyntheticVerilogTest, Empty) {
+  EXPECT_TRUE(GenerateSyntheticVerilog(0).empty());
+}
+
+TEST(GenerateSyntheticVerilogTest, AtLeastTargetSize) {
+  for (size_t size : {1, 1000, 10000, 100000}) {
+    const std::string text = GenerateSyntheticVerilog(size);
+    EXPECT_GE(text.size(), size);
+    // Overshoot by at most one module.
+    EXPECT_LT(text.size(), size + 10000);
+  }
+}
+
+TEST(GenerateSyntheticVerilogTest, Deterministic) {
+  EXPECT_EQ(GenerateSyntheticVerilog(20000, 7),
+            GenerateSyntheticVerilog(20000, 7));
+  EXPECT_NE(GenerateSyntheticVerilog(20000, 7),
+            GenerateSyntheticVerilog(20000, 8));
+}
+
+TEST(GenerateSyntheticVerilogTest, ParsesWithoutErrors) {
+  for (uint32_t seed : {1, 2, 3}) {
+    const std::string text = GenerateSyntheticVerilog(50000, seed);
+    VerilogAnalyzer analyzer(text, "synthetic.sv");
+    EXPECT_TRUE(analyzer.Analyze().ok()) << "seed: " << seed;
+  }
+}
+
+}  // namespace
+}  // namespace verilog
@@ -0,0 +1,375 @@
+// Copyright 2017-2023 The Verible Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// Benchmarks of the hot paths of the lexer, parser, formatter, linter and
+// symbol table, on synthetic corpora of various sizes.
+//
+// Usage:
+//   bazel run -c opt //verilog/benchmark:verilog_benchmark -- [options]
+// with google-benchmark options, e.g. --benchmark_filter=<regex>.
+//
+// Benchmarks of the formatting algorithms also report the average number of
+// heap allocations per iteration, counted by the global operator new.
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <map>
+#include <memory>
+#include <new>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "absl/status/status.h"
+#include "absl/strings/str_cat.h"
+#include "absl/strings/string_view.h"
+#include "benchmark/benchmark.h"
+#include "common/formatting/basic_format_style.h"
+#include "common/formatting/format_token.h"
+#include "common/formatting/layout_optimizer.h"
+#include "common/formatting/line_wrap_searcher.h"
+#include "common/formatting/token_partition_tree.h"
+#include "common/formatting/unwrapped_line.h"
+#include "common/text/token_info.h"
+#include "common/util/pool_allocator.h"
+#include "common/util/vector_tree.h"
+#include "verilog/analysis/symbol_table.h"
+#include "verilog/analysis/verilog_analyzer.h"
+#include "verilog/analysis/verilog_linter.h"
+#include "verilog/analysis/verilog_linter_configuration.h"
+#include "verilog/analysis/verilog_project.h"
+#include "verilog/benchmark/synthetic_corpus.h"
+#include "verilog/formatting/format_style.h"
+#include "verilog/formatting/formatter.h"
+#include "verilog/parser/verilog_lexer.h"
+
+namespace verilog {
+namespace {
+
+constexpr absl::string_view kFilename = "synthetic.sv";
+
+// Number of calls to the global operator new.
+std::atomic<int64_t> allocation_count{0};
+
+// Counts heap allocations made between construction and Report().
+class AllocationCounter {
+ public:
+  AllocationCounter() : start_(allocation_count.load()) {}
+
+  // Sets the "allocations" counter of 'state' to the average number of
+  // allocations per iteration.
+  void Report(benchmark::State& state) const {
+    state.counters["allocations"] =
+        benchmark::Counter(static_cast<double>(allocation_count - start_),
+                           benchmark::Counter::kAvgIterations);
+  }
+
+ private:
+  const int64_t start_;
+};
+
+// Returns the synthetic corpus of (at least) 'size' bytes.
+// Corpora are generated once, and shared among benchmarks.
+const std::string& Corpus(size_t size) {
+  static auto* corpora = new std::map<size_t, std::string>();
+  auto [iter, inserted] = corpora->try_emplace(size);
+  if (inserted) iter->second = GenerateSyntheticVerilog(size);
+  return iter->second;
+}
+
+// Corpus sizes from 1KB to 50MB.
+void CorpusSizes(benchmark::internal::Benchmark* b) {
+  b->RangeMultiplier(8)->Range(1 << 10, 50 << 20);
+  b->Unit(benchmark::kMillisecond);
+}
+
+void SetBytesProcessed(benchmark::State& state, const std::string& text) {
+  state.SetBytesProcessed(static_cast<int64_t>(state.iterations()) *
+                          static_cast<int64_t>(text.size()));
+}
+
+void BM_VerilogLexer(benchmark::State& state) {
+  const std::string& text = Corpus(state.range(0));
+  for (auto _ : state) {
+    VerilogLexer lexer(text);
+    size_t token_count = 0;
+    while (!lexer.DoNextToken().isEOF()) ++token_count;
+    benchmark::DoNotOptimize(token_count);
+  }
+  SetBytesProcessed(state, text);
+}
+BENCHMARK(BM_VerilogLexer)->Apply(CorpusSizes);
+
+void BM_VerilogAnalyzer(benchmark::State& state) {
+  const std::string& text = Corpus(state.range(0));
+  for (auto _ : state) {
+    VerilogAnalyzer analyzer(text, kFilename);
+    const absl::Status status = analyzer.Analyze();
+    if (!status.ok()) {
+      state.SkipWithError(status.ToString().c_str());
+      break;
+    }
+  }
+  SetBytesProcessed(state, text);
+}
+BENCHMARK(BM_VerilogAnalyzer)->Apply(CorpusSizes);
+
+void BM_FormatVerilog(benchmark::State& state) {
+  const std::string& text = Corpus(state.range(0));
+  const formatter::FormatStyle style;
+  const AllocationCounter allocations;
+  for (auto _ : state) {
+    std::ostringstream formatted;
+    const absl::Status status =
+        formatter::FormatVerilog(text, kFilename, style, formatted);
+    if (!status.ok()) {
+      state.SkipWithError(status.ToString().c_str());
+      break;
+    }
+  }
+  allocations.Report(state);
+  SetBytesProcessed(state, text);
+}
+BENCHMARK(BM_FormatVerilog)->Apply(CorpusSizes);
+
+void BM_VerilogLinter(benchmark::State& state) {
+  const std::string& text = Corpus(state.range(0));
+  VerilogAnalyzer analyzer(text, kFilename);
+  if (const absl::Status status = analyzer.Analyze(); !status.ok()) {
+    state.SkipWithError(status.ToString().c_str());
+    return;
+  }
+  LinterConfiguration config;
+  config.UseRuleSet(RuleSet::kDefault);
+  for (auto _ : state) {
+    const auto statuses =
+        VerilogLintTextStructure(kFilename, config, analyzer.Data());
+    if (!statuses.ok()) {
+      state.SkipWithError(statuses.status().ToString().c_str());
+      break;
+    }
+    benchmark::DoNotOptimize(statuses->size());
+  }
+  SetBytesProcessed(state, text);
+}
+BENCHMARK(BM_VerilogLinter)->Apply(CorpusSizes);
+
+void BM_SymbolTableBuild(benchmark::State& state) {
+  const std::string& text = Corpus(state.range(0));
+  InMemoryVerilogSourceFile source(kFilename, text);
+  if (const absl::Status status = source.Parse(); !status.ok()) {
+    state.SkipWithError(status.ToString().c_str());
+    return;
+  }
+  for (auto _ : state) {
+    SymbolTable symbol_table(nullptr);
+    const auto diagnostics = BuildSymbolTable(source, &symbol_table);
+    benchmark::DoNotOptimize(diagnostics.size());
+  }
+  SetBytesProcessed(state, text);
+}
+BENCHMARK(BM_SymbolTableBuild)->Apply(CorpusSizes);
+
+void BM_SymbolTableBuildAndResolve(benchmark::State& state) {
+  const std::string& text = Corpus(state.range(0));
+  InMemoryVerilogSourceFile source(kFilename, text);
+  if (const absl::Status status = source.Parse(); !status.ok()) {
+    state.SkipWithError(status.ToString().c_str());
+    return;
+  }
+  for (auto _ : state) {
+    SymbolTable symbol_table(nullptr);
+    std::vector<absl::Status> diagnostics =
+        BuildSymbolTable(source, &symbol_table);
+    symbol_table.Resolve(&diagnostics);
+    benchmark::DoNotOptimize(diagnostics.size());
+  }
+  SetBytesProcessed(state, text);
+}
+BENCHMARK(BM_SymbolTableBuildAndResolve)->Apply(CorpusSizes);
+
+// Argument: number of reference trees, shaped like those of a symbol table:
+// mostly lone identifiers, some chains like "a.b.c" and some instances with
+// named ports.  Compares the allocators of the children arrays.
+template <template <typename> class Allocator>
+void BM_ReferenceTrees(benchmark::State& state) {
+  using Node = verible::VectorTree<ReferenceComponent, Allocator>;
+  const int num_trees = state.range(0);
+  const AllocationCounter allocations;
+  for (auto _ : state) {
+    std::vector<std::unique_ptr<Node>> trees;
+    trees.reserve(num_trees);
+    for (int i = 0; i < num_trees; ++i) {
+      trees.push_back(std::make_unique<Node>(ReferenceComponent{
+          .identifier = "base", .ref_type = ReferenceType::kUnqualified}));
+      Node* node = trees.back().get();
+      switch (i % 8) {
+        case 0:
+        case 1:
+          for (int depth = 0; depth < 2; ++depth) {
+            node->Children().emplace_back(ReferenceComponent{
+                .identifier = "member",
+                .ref_type = ReferenceType::kMemberOfTypeOfParent});
+            node = &node->Children().back();
+          }
+          break;
+        case 2:
+          node->Children().reserve(4);
+          for (int port = 0; port < 4; ++port) {
+            node->Children().emplace_back(ReferenceComponent{
+                .identifier = "port",
+                .ref_type = ReferenceType::kMemberOfTypeOfParent});
+          }
+          break;
+        default:
+          break;
+      }
+    }
+    benchmark::DoNotOptimize(trees.data());
+  }
+  allocations.Report(state);
+  state.SetItemsProcessed(state.iterations() * num_trees);
+}
+BENCHMARK_TEMPLATE(BM_ReferenceTrees, std::allocator)
+    ->RangeMultiplier(16)
+    ->Range(1 << 8, 1 << 16);
+BENCHMARK_TEMPLATE(BM_ReferenceTrees, verible::PoolAllocator)
+    ->RangeMultiplier(16)
+    ->Range(1 << 8, 1 << 16);
+
+// Owns the tokens of a synthetic expression of the form:
+//   function_name(arg_0 + arg_1 + ... , arg_2 + ...)
+// for the benchmarks of the line wrap search and layout optimization.
+class SyntheticTokens {
+ public:
+  SyntheticTokens(int num_args, int terms_per_arg) {
+    texts_.push_back("function_name(");
+    for (int arg = 0; arg < num_args; ++arg) {
+      for (int term = 0; term < terms_per_arg; ++term) {
+        texts_.push_back(absl::StrCat("arg_", arg, "_term_", term));
+        if (term + 1 < terms_per_arg) texts_.push_back("+");
+      }
+      texts_.push_back(arg + 1 < num_args ? "," : ");");
+    }
+    // Both the texts and the tokens are fully allocated before taking
+    // references to them.
+    token_infos_.reserve(texts_.size());
+    for (const auto& text : texts_) token_infos_.emplace_back(1, text);
+    format_tokens_.reserve(token_infos_.size());
+    for (const auto& token_info : token_infos_) {
+      format_tokens_.emplace_back(&token_info);
+      auto& before = format_tokens_.back().before;
+      before.spaces_required = 1;
+      before.break_penalty = token_info.text() == "+" ? 1 : 2;
+    }
+    format_tokens_.front().before.spaces_required = 0;
+  }
+
+  SyntheticTokens(const SyntheticTokens&) = delete;
+  SyntheticTokens& operator=(const SyntheticTokens&) = delete;
+
+  // Returns a line that spans all tokens.
+  verible::UnwrappedLine WholeLine() {
+    verible::UnwrappedLine line(0, format_tokens_.begin());
+    line.SpanUpToToken(format_tokens_.end());
+    return line;
+  }
+
+  // Returns a partition tree with the function name as the header, and
+  // one sub-partition per argument, to be wrapped.
+  verible::TokenPartitionTree ArgumentsTree() {
+    using verible::PartitionPolicyEnum;
+    using verible::TokenPartitionTree;
+    using verible::UnwrappedLine;
+    auto iter = format_tokens_.begin();
+    UnwrappedLine header(0, iter, PartitionPolicyEnum::kAlreadyFormatted);
+    header.SpanUpToToken(++iter);
+    UnwrappedLine arguments(0, iter, PartitionPolicyEnum::kWrap);
+    arguments.SpanUpToToken(format_tokens_.end());
+    TokenPartitionTree arguments_tree(arguments);
+    while (iter != format_tokens_.end()) {
+      UnwrappedLine argument(0, iter,
+                             PartitionPolicyEnum::kFitOnLineElseExpand);
+      // Each argument ends with a separator.
+      absl::string_view text;
+      do {
+        text = (iter++)->token->text();
+      } while (text != "," && text != ");");
+      argument.SpanUpToToken(iter);
+      arguments_tree.Children().emplace_back(argument);
+    }
+    UnwrappedLine whole = WholeLine();
+    whole.SetPartitionPolicy(
+        PartitionPolicyEnum::kJuxtapositionOrIndentedStack);
+    return TokenPartitionTree(whole, TokenPartitionTree(header),
+                              std::move(arguments_tree));
+  }
+
+ private:
+  std::vector<std::string> texts_;
+  std::vector<verible::TokenInfo> token_infos_;
+  std::vector<verible::PreFormatToken> format_tokens_;
+};
+
+// Argument: number of function arguments, each with 3 terms.
+void BM_SearchLineWraps(benchmark::State& state) {
+  SyntheticTokens tokens(state.range(0), 3);
+  const verible::UnwrappedLine line = tokens.WholeLine();
+  const verible::BasicFormatStyle style;
+  const formatter::ExecutionControl control;
+  const AllocationCounter allocations;
+  for (auto _ : state) {
+    const auto results =
+        verible::SearchLineWraps(line, style, control.max_search_states);
+    benchmark::DoNotOptimize(results.size());
+  }
+  allocations.Report(state);
+  state.SetItemsProcessed(state.iterations() * line.Size());
+}
+BENCHMARK(BM_SearchLineWraps)->RangeMultiplier(2)->Range(1, 64);
+
+// Argument: number of function arguments, each with 3 terms.
+void BM_OptimizeTokenPartitionTree(benchmark::State& state) {
+  SyntheticTokens tokens(state.range(0), 3);
+  const verible::TokenPartitionTree tree = tokens.ArgumentsTree();
+  const verible::BasicFormatStyle style;
+  const AllocationCounter allocations;
+  for (auto _ : state) {
+    verible::TokenPartitionTree optimized(tree);
+    verible::OptimizeTokenPartitionTree(style, &optimized);
+    benchmark::DoNotOptimize(optimized.Children().size());
+  }
+  allocations.Report(state);
+  state.SetItemsProcessed(state.iterations() * tree.Value().Size());
+}
+BENCHMARK(BM_OptimizeTokenPartitionTree)->RangeMultiplier(2)->Range(1, 64);
+
+}  // namespace
+}  // namespace verilog
+
+// Replacements of the global allocation functions that count allocations.
+// The other forms of operator new and delete are implemented with these.
+void* operator new(std::size_t size) {
+  verilog::allocation_count.fetch_add(1, std::memory_order_relaxed);
+  if (void* ptr = std::malloc(size == 0 ? 1 : size)) return ptr;
+  throw std::bad_alloc();
+}
+
+void operator delete(void* ptr) noexcept { std::free(ptr); }
+
+void operator delete(void* ptr, std::size_t) noexcept { std::free(ptr); }
+
+BENCHMARK_MAIN();
@@ -1519,19 +1519,19 @@ static std::vector<AlignablePartitionGroup> AlignDistItems(
       &IgnoreCommentsAndPreprocessingDirectives, full_range, vstyle);
 }
 
-void TabularAlignTokenPartitions(const FormatStyle& style,
-                                 absl::string_view full_text,
-                                 const ByteOffsetSet& disabled_byte_ranges,
-                                 TokenPartitionTree* partition_ptr) {
+verible::TabularAlignment CalculateTokenPartitionsAlignment(
+    const FormatStyle& style, absl::string_view full_text,
+    const ByteOffsetSet& disabled_byte_ranges,
+    TokenPartitionTree* partition_ptr) {
   VLOG(1) << __FUNCTION__;
   auto& partition = *partition_ptr;
   auto& uwline = partition.Value();
   const auto* origin = uwline.Origin();
   VLOG(2) << "origin is nullptr? " << (origin == nullptr);
-  if (origin == nullptr) return;
+  if (origin == nullptr) return {};
   const auto* node = down_cast<const SyntaxTreeNode*>(origin);
   VLOG(2) << "origin is node? " << (node != nullptr);
-  if (node == nullptr) return;
+  if (node == nullptr) return {};
   // Dispatch aligning function based on syntax tree node type.
 
   static const auto* const kAlignHandlers =
@@ -1557,16 +1557,25 @@ void TabularAlignTokenPartitions(const FormatStyle& style,
           {NodeEnum::kDistributionItemList, &AlignDistItems},
       };
   const auto handler_iter = kAlignHandlers->find(NodeEnum(node->Tag().tag));
-  if (handler_iter == kAlignHandlers->end()) return;
+  if (handler_iter == kAlignHandlers->end()) return {};
 
   const AlignSyntaxGroupsFunction& alignment_partitioner = handler_iter->second;
   const ExtractAlignmentGroupsFunction extract_alignment_groups =
       std::bind(alignment_partitioner, std::placeholders::_1, style);
 
-  verible::TabularAlignTokens(style.column_limit, full_text,
-                              disabled_byte_ranges, extract_alignment_groups,
-                              &partition);
+  return verible::CalculateTabularAlignment(style.column_limit, full_text,
+                                            disabled_byte_ranges,
+                                            extract_alignment_groups,
+                                            &partition);
+}
 
+void TabularAlignTokenPartitions(const FormatStyle& style,
+                                 absl::string_view full_text,
+                                 const ByteOffsetSet& disabled_byte_ranges,
+                                 TokenPartitionTree* partition_ptr) {
+  VLOG(1) << __FUNCTION__;
+  verible::ApplyTabularAlignment(CalculateTokenPartitionsAlignment(
+      style, full_text, disabled_byte_ranges, partition_ptr));
   VLOG(1) << "end of " << __FUNCTION__;
 }
 
@@ -18,6 +18,7 @@
 #include <vector>
 
 #include "absl/strings/string_view.h"
+#include "common/formatting/align.h"
 #include "common/formatting/format_token.h"
 #include "common/formatting/token_partition_tree.h"
 #include "common/strings/position.h"  // for ByteOffsetSet
@@ -34,6 +35,15 @@ void TabularAlignTokenPartitions(
     const verible::ByteOffsetSet& disabled_byte_ranges,
     verible::TokenPartitionTree* partition_ptr);
 
+// Calculates the alignment of 'partition_ptr' done by
+// TabularAlignTokenPartitions(), without modifying the partition, see
+// verible::CalculateTabularAlignment().  Apply the result with
+// verible::ApplyTabularAlignment().
+verible::TabularAlignment CalculateTokenPartitionsAlignment(
+    const FormatStyle& style, absl::string_view full_text,
+    const verible::ByteOffsetSet& disabled_byte_ranges,
+    verible::TokenPartitionTree* partition_ptr);
+
 }  // namespace formatter
 }  // namespace verilog
 
@@ -15,6 +15,7 @@
 #include "verilog/formatting/comment_controls.h"
 
 #include <iostream>
+#include <string>
 #include <vector>
 
 #include "absl/strings/match.h"
@@ -25,7 +26,6 @@
 #include "common/strings/line_column_map.h"
 #include "common/util/logging.h"
 #include "common/util/range.h"
-#include "common/util/spacer.h"
 #include "verilog/parser/verilog_parser.h"
 #include "verilog/parser/verilog_token_classifications.h"
 #include "verilog/parser/verilog_token_enum.h"
@@ -116,10 +116,28 @@ void FormatWhitespaceWithDisabledByteRanges(
     absl::string_view text_base, absl::string_view space_text,
     const ByteOffsetSet& disabled_ranges, bool include_disabled_ranges,
     std::ostream& stream) {
+  std::string output;
+  AppendWhitespaceWithDisabledByteRanges(text_base, space_text,
+                                         disabled_ranges,
+                                         include_disabled_ranges, &output);
+  stream << output;
+}
+
+void AppendWhitespaceWithDisabledByteRanges(
+    absl::string_view text_base, absl::string_view space_text,
+    const ByteOffsetSet& disabled_ranges, bool include_disabled_ranges,
+    std::string* output) {
   VLOG(3) << __FUNCTION__;
   CHECK(verible::IsSubRange(space_text, text_base));
   const int start = std::distance(text_base.begin(), space_text.begin());
   const int end = start + space_text.length();
+  if (disabled_ranges.empty()) {
+    // Common case: only the newlines are kept, at least one after a token.
+    size_t newline_count = NewlineCount(space_text);
+    if (newline_count == 0 && start != 0) newline_count = 1;
+    output->append(newline_count, '\n');
+    return;
+  }
   ByteOffsetSet enabled_ranges{{start, end}};  // initial interval set mask
   enabled_ranges.Difference(disabled_ranges);
   VLOG(3) << "space range: [" << start << ", " << end << ')';
@@ -130,7 +148,7 @@ void FormatWhitespaceWithDisabledByteRanges(
   if (space_text.empty() && start != 0) {
     if (!disabled_ranges.Contains(start)) {
       VLOG(3) << "output: 1*\"\\n\" (empty space text)";
-      stream << '\n';
+      output->push_back('\n');
       return;
     }
   }
@@ -145,7 +163,7 @@ void FormatWhitespaceWithDisabledByteRanges(
       const absl::string_view disabled(
           text_base.substr(next_start, range.first - next_start));
       VLOG(3) << "output: \"" << EscapeString{disabled} << "\" (preserved)";
-      stream << disabled;
+      output->append(disabled.data(), disabled.length());
       total_enabled_newlines += NewlineCount(disabled);
     }
     {  // for enabled intervals, preserve only newlines
@@ -153,7 +171,7 @@ void FormatWhitespaceWithDisabledByteRanges(
           text_base.substr(range.first, range.second - range.first));
       const size_t newline_count = NewlineCount(enabled);
       VLOG(3) << "output: " << newline_count << "*\"\\n\" (formatted)";
-      stream << verible::Spacer(newline_count, '\n');
+      output->append(newline_count, '\n');
       partially_enabled = true;
       total_enabled_newlines += newline_count;
     }
@@ -165,13 +183,13 @@ void FormatWhitespaceWithDisabledByteRanges(
         text_base.substr(next_start, end - next_start));
     VLOG(3) << "output: \"" << EscapeString(final_disabled)
             << "\" (remaining disabled)";
-    stream << final_disabled;
+    output->append(final_disabled.data(), final_disabled.length());
     total_enabled_newlines += NewlineCount(final_disabled);
   }
   // Print at least one newline if some subrange was format-enabled.
   if (partially_enabled && total_enabled_newlines == 0 && start != 0) {
     VLOG(3) << "output: 1*\"\\n\"";
-    stream << '\n';
+    output->push_back('\n');
   }
 }
 
@@ -15,6 +15,9 @@
 #ifndef VERIBLE_VERILOG_FORMATTING_COMMENT_CONTROLS_H_
 #define VERIBLE_VERILOG_FORMATTING_COMMENT_CONTROLS_H_
 
+#include <iosfwd>
+#include <string>
+
 #include "absl/strings/string_view.h"
 #include "common/strings/line_column_map.h"
 #include "common/strings/position.h"  // for ByteOffsetSet, LineNumberSet
@@ -49,6 +52,12 @@ void FormatWhitespaceWithDisabledByteRanges(
     const verible::ByteOffsetSet& disabled_ranges, bool include_disabled_ranges,
     std::ostream& stream);
 
+// Same as above, but appending to 'output'.
+void AppendWhitespaceWithDisabledByteRanges(
+    absl::string_view text_base, absl::string_view space_text,
+    const verible::ByteOffsetSet& disabled_ranges, bool include_disabled_ranges,
+    std::string* output);
+
 }  // namespace formatter
 }  // namespace verilog
 
@@ -15,13 +15,28 @@
 #include "verilog/formatting/formatter.h"
 
 #include <algorithm>
+#include <atomic>
 #include <cstddef>
+#include <cstdint>
+#include <future>
 #include <iostream>
 #include <iterator>
+#include <limits>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <utility>
 #include <vector>
 
+#include "absl/container/flat_hash_map.h"
 #include "absl/status/status.h"
 #include "absl/status/statusor.h"
+#include "absl/strings/str_cat.h"
+#include "absl/strings/string_view.h"
+#include "absl/synchronization/mutex.h"
+#include "absl/time/clock.h"
+#include "absl/time/time.h"
+#include "common/formatting/align.h"
 #include "common/formatting/format_token.h"
 #include "common/formatting/layout_optimizer.h"
 #include "common/formatting/line_wrap_searcher.h"
@@ -30,6 +45,7 @@
 #include "common/formatting/verification.h"
 #include "common/strings/diff.h"
 #include "common/strings/line_column_map.h"
+#include "common/strings/mem_block.h"
 #include "common/strings/position.h"
 #include "common/strings/range.h"
 #include "common/text/text_structure.h"
@@ -37,10 +53,15 @@
 #include "common/text/tree_utils.h"
 #include "common/util/expandable_tree_view.h"
 #include "common/util/interval.h"
+#include "common/util/interval_set.h"
 #include "common/util/iterator_range.h"
+#include "common/util/json_writer.h"
 #include "common/util/logging.h"
+#include "common/util/memory_stats.h"
 #include "common/util/range.h"
 #include "common/util/spacer.h"
+#include "common/util/thread_pool.h"
+#include "common/util/trace_events.h"
 #include "common/util/tree_operations.h"
 #include "common/util/vector_tree.h"
 #include "common/util/vector_tree_iterators.h"
@@ -73,6 +94,11 @@ using verible::VectorTreeLeavesIterator;
 
 using partition_node_type = VectorTree<TreeViewNodeInfo<TokenPartitionTree>>;
 
+// Read-only ByteOffsetSet, for frequent lookups.
+using FlatByteOffsetSet = verible::FlatIntervalSet<int>;
+
+class PartitionCosts;
+
 // Takes a TextStructureView and FormatStyle, and formats UnwrappedLines.
 class Formatter {
  public:
@@ -87,11 +113,49 @@ class Formatter {
 
   void SelectLines(const LineNumberSet& lines);
 
-  // Outputs all of the FormattedExcerpt lines to stream.
+  // Searches optimal line wrappings of each of 'uwlines', using up to
+  // control.line_wrap_search_threads threads.  The result slot of each line
+  // has the same index as the line.  Slots of lines that are not subject to
+  // wrap searching, or that could be continuation comments, are left empty.
+  // If 'costs' is not null, the costs of the searches are stored in the slots
+  // of its searches, which must be as many as 'uwlines'.
+  // No search runs past 'file_deadline', see LineWrapSearchDeadline().
+  std::vector<std::vector<verible::FormattedExcerpt>> SearchLineWrapsForAll(
+      const std::vector<UnwrappedLine>& uwlines,
+      const ExecutionControl& control, absl::Time file_deadline,
+      PartitionCosts* costs = nullptr) const;
+
+  // Appends all of the FormattedExcerpt lines to "output".
   // If "include_disabled" is false, does not contain the disabled ranges.
-  void Emit(bool include_disabled, std::ostream& stream) const;
+  // "output" grows only once, to the exact size that is computed first.
+  void Emit(bool include_disabled, std::string* output) const;
+
+  // Appends to "edits" the changes of whitespace that Emit(true, ...) makes.
+  void EmitWhitespaceEdits(std::vector<WhitespaceEdit>* edits) const;
 
  private:
+  struct CacheableItem;
+
+  // Calls "whitespace(space_text)" with the original whitespace before each
+  // line and after the last one, and "text(line, indent)" with each line, in
+  // output order, see Emit().
+  template <typename WhitespaceFunction, typename TextFunction>
+  void ForEachOutputPart(WhitespaceFunction&& whitespace,
+                         TextFunction&& text) const;
+
+  // Returns the top-level items under 'root' whose formatting can be looked
+  // up in 'cache', and adds the byte ranges of those that are found to
+  // cached_ranges_.
+  std::vector<CacheableItem> LookUpCachedItems(
+      const TokenPartitionTree& root, FormattedItemCache::Entries* cache);
+
+  // Appends the cached formatting of 'item' to formatted_lines_.
+  void EmitCachedItem(const CacheableItem& item);
+
+  // Saves the formatting of items that were not found in 'cache'.
+  void SaveFormattedItems(const std::vector<CacheableItem>& items,
+                          FormattedItemCache::Entries* cache) const;
+
   // Contains structural information about the code to format, such as
   // TokenSequence from lexing, and ConcreteSyntaxTree from parsing
   const verible::TextStructureView& text_structure_;
@@ -102,6 +166,15 @@ class Formatter {
   // Ranges of text where formatter is disabled (by comment directives).
   ByteOffsetSet disabled_ranges_;
 
+  // Byte ranges of top-level items whose formatting was found in the cache.
+  // Partitions within these ranges are not formatted.
+  ByteOffsetSet cached_ranges_;
+
+  // Copies of disabled_ranges_ and cached_ranges_ once they are complete, for
+  // the many lookups of the passes that follow.
+  FlatByteOffsetSet flat_disabled_ranges_;
+  FlatByteOffsetSet flat_cached_ranges_;
+
   // Set of formatted lines, populated by calling Format().
   std::vector<verible::FormattedExcerpt> formatted_lines_;
 };
@@ -109,15 +182,27 @@ class Formatter {
 // TODO(b/148482625): make this public/re-usable for general content comparison.
 Status VerifyFormatting(const verible::TextStructureView& text_structure,
                         absl::string_view formatted_output,
-                        absl::string_view filename) {
+                        absl::string_view filename, bool fast) {
+  if (fast) {
+    // The formatter only changes whitespace, so the output should consist of
+    // the same tokens as the input, which were already lexed.
+    if (verilog::FormatEquivalentTokens(text_structure.TokenStream(),
+                                        formatted_output) ==
+        DiffStatus::kEquivalent) {
+      return absl::OkStatus();
+    }
+    // Otherwise, re-analyze for a full diagnostic.
+  }
+
   // Verify that the formatted output creates the same lexical
   // stream (filtered) as the original.  If any tokens were lost, fall back to
   // printing the original source unformatted.
   // Note: We cannot just Tokenize() and compare because Analyze()
   // performs additional transformations like expanding MacroArgs to
   // expression subtrees.
-  const auto reanalyzer = VerilogAnalyzer::AnalyzeAutomaticMode(
-      formatted_output, filename, verilog::VerilogPreprocess::Config());
+  const auto reanalyzer = VerilogAnalyzer::AnalyzeAutomaticModeUncached(
+      std::make_shared<verible::StringMemBlock>(formatted_output), filename,
+      verilog::VerilogPreprocess::Config());
   const auto relex_status = ABSL_DIE_IF_NULL(reanalyzer)->LexStatus();
   const auto reparse_status = reanalyzer->ParseStatus();
 
@@ -159,7 +244,7 @@ static Status ReformatVerilogIncrementally(absl::string_view original_text,
                                            absl::string_view formatted_text,
                                            absl::string_view filename,
                                            const FormatStyle& style,
-                                           std::ostream& reformat_stream,
+                                           std::string* reformatted_text,
                                            const ExecutionControl& control) {
   // Differences from the first formatting.
   const verible::LineDiffs formatting_diffs(original_text, formatted_text);
@@ -172,7 +257,7 @@ static Status ReformatVerilogIncrementally(absl::string_view original_text,
   // re-formatting on the whole file unless line ranges are specified.
   formatted_lines.Add(formatting_diffs.after_lines.size() + 1);
   VLOG(1) << "formatted changed lines: " << formatted_lines;
-  return FormatVerilog(formatted_text, filename, style, reformat_stream,
+  return FormatVerilog(formatted_text, filename, style, reformatted_text,
                        formatted_lines, control);
 }
 
@@ -180,26 +265,29 @@ static Status ReformatVerilog(absl::string_view original_text,
                               absl::string_view formatted_text,
                               absl::string_view filename,
                               const FormatStyle& style,
-                              std::ostream& reformat_stream,
+                              std::string* reformatted_text,
                               const LineNumberSet& lines,
                               const ExecutionControl& control) {
   // Disable reformat check to terminate recursion.
   ExecutionControl convergence_control(control);
   convergence_control.verify_convergence = false;
 
-  if (lines.empty()) {
+  // Lines that formatting did not change need not be re-formatted in the fast
+  // mode.
+  if (lines.empty() && !control.fast_verification) {
     // format whole file
-    return FormatVerilog(formatted_text, filename, style, reformat_stream,
+    return FormatVerilog(formatted_text, filename, style, reformatted_text,
                          lines, convergence_control);
   }
   // reformat incrementally
   return ReformatVerilogIncrementally(original_text, formatted_text, filename,
-                                      style, reformat_stream,
+                                      style, reformatted_text,
                                       convergence_control);
 }
 
 static absl::StatusOr<std::unique_ptr<VerilogAnalyzer>> ParseWithStatus(
-    absl::string_view text, absl::string_view filename) {
+    const std::shared_ptr<verible::MemBlock>& text,
+    absl::string_view filename) {
   std::unique_ptr<VerilogAnalyzer> analyzer =
       VerilogAnalyzer::AnalyzeAutomaticMode(
           text, filename, verilog::VerilogPreprocess::Config());
@@ -222,11 +310,30 @@ static absl::StatusOr<std::unique_ptr<VerilogAnalyzer>> ParseWithStatus(
   return analyzer;
 }
 
+static absl::StatusOr<std::unique_ptr<VerilogAnalyzer>> ParseWithStatus(
+    absl::string_view text, absl::string_view filename) {
+  return ParseWithStatus(std::make_shared<verible::StringMemBlock>(text),
+                         filename);
+}
+
+static absl::Status FormattingCancelled() {
+  return absl::CancelledError("Formatting cancelled.");
+}
+
+// Returns the deadline of a line wrap search that starts now: the end of the
+// per-line budget, or 'file_deadline' if that is earlier.
+static absl::Time LineWrapSearchDeadline(const ExecutionControl& control,
+                                         absl::Time file_deadline) {
+  return std::min(absl::Now() + control.line_wrap_search_line_budget,
+                  file_deadline);
+}
+
 absl::Status FormatVerilog(const verible::TextStructureView& text_structure,
                            absl::string_view filename, const FormatStyle& style,
                            std::string* formatted_text,
                            const verible::LineNumberSet& lines,
                            const ExecutionControl& control) {
+  VERIBLE_TRACE_SCOPE("format", "format-file", filename);
   Formatter fmt(text_structure, style);
   fmt.SelectLines(lines);
 
@@ -247,13 +354,18 @@ absl::Status FormatVerilog(const verible::TextStructureView& text_structure,
   }
 
   // Render formatted text to the output buffer.
-  std::ostringstream output_buffer;
-  fmt.Emit(true, output_buffer);
-  *formatted_text = output_buffer.str();
+  {
+    VERIBLE_TRACE_SCOPE("format", "emit", filename);
+    formatted_text->clear();
+    fmt.Emit(true, formatted_text);
+  }
+
+  if (control.Cancelled()) return FormattingCancelled();
 
   // For now, unconditionally verify.
-  if (Status verify_status =
-          VerifyFormatting(text_structure, *formatted_text, filename);
+  VERIBLE_TRACE_SCOPE("format", "verify", filename);
+  if (Status verify_status = VerifyFormatting(
+          text_structure, *formatted_text, filename, control.fast_verification);
       !verify_status.ok()) {
     return verify_status;
   }
@@ -261,34 +373,115 @@ absl::Status FormatVerilog(const verible::TextStructureView& text_structure,
   return format_status;
 }
 
+absl::Status FormatVerilogEdits(
+    const verible::TextStructureView& text_structure,
+    absl::string_view filename, const FormatStyle& style,
+    std::vector<WhitespaceEdit>* edits, const verible::LineNumberSet& lines,
+    const ExecutionControl& control) {
+  VERIBLE_TRACE_SCOPE("format", "format-file", filename);
+  edits->clear();
+  Formatter fmt(text_structure, style);
+  fmt.SelectLines(lines);
+
+  // As in FormatVerilog(), partially formatted code is still emitted.
+  Status format_status = fmt.Format(control);
+  if (!format_status.ok() &&
+      format_status.code() != StatusCode::kResourceExhausted) {
+    return format_status;
+  }
+  if (control.AnyStop()) {
+    return absl::CancelledError("Halting for diagnostic operation.");
+  }
+
+  {
+    VERIBLE_TRACE_SCOPE("format", "emit", filename);
+    fmt.EmitWhitespaceEdits(edits);
+  }
+  if (control.Cancelled()) return FormattingCancelled();
+
+  VERIBLE_TRACE_SCOPE("format", "verify", filename);
+  if (Status verify_status = VerifyFormatting(
+          text_structure,
+          ApplyWhitespaceEdits(text_structure.Contents(), *edits), filename,
+          control.fast_verification);
+      !verify_status.ok()) {
+    return verify_status;
+  }
+  return format_status;
+}
+
+std::string ApplyWhitespaceEdits(absl::string_view text,
+                                 const std::vector<WhitespaceEdit>& edits) {
+  std::string result;
+  const char* position = text.begin();
+  for (const WhitespaceEdit& edit : edits) {
+    result.append(position, edit.original.begin());
+    result.append(edit.replacement);
+    position = edit.original.end();
+  }
+  result.append(position, text.end());
+  return result;
+}
+
 Status FormatVerilog(absl::string_view text, absl::string_view filename,
                      const FormatStyle& style, std::ostream& formatted_stream,
                      const LineNumberSet& lines,
                      const ExecutionControl& control) {
-  const auto analyzer = ParseWithStatus(text, filename);
+  std::string formatted_text;
+  Status format_status =
+      FormatVerilog(text, filename, style, &formatted_text, lines, control);
+  // Commit formatted text to the output stream independent of status.
+  formatted_stream << formatted_text;
+  return format_status;
+}
+
+Status FormatVerilog(absl::string_view text, absl::string_view filename,
+                     const FormatStyle& style, std::string* formatted_text,
+                     const LineNumberSet& lines,
+                     const ExecutionControl& control) {
+  return FormatVerilog(std::make_shared<verible::StringMemBlock>(text),
+                       filename, style, formatted_text, lines, control);
+}
+
+Status FormatVerilog(const std::shared_ptr<verible::MemBlock>& content,
+                     absl::string_view filename, const FormatStyle& style,
+                     std::string* formatted_text, const LineNumberSet& lines,
+                     const ExecutionControl& control) {
+  formatted_text->clear();
+  const absl::string_view text = content->AsStringView();
+  const auto analyzer = ParseWithStatus(content, filename);
   if (!analyzer.ok()) return analyzer.status();
 
+  // Top-level items that formatting left unchanged are not formatted again
+  // to verify convergence: their text is that of the input, so they get the
+  // formatting of the first pass from the item cache, which is the same as
+  // formatting them again.  Only the changed ones are formatted twice.
+  FormattedItemCache convergence_cache(std::numeric_limits<size_t>::max());
+  ExecutionControl format_control(control);
+  if (control.verify_convergence && control.formatted_item_cache == nullptr) {
+    format_control.formatted_item_cache = &convergence_cache;
+  }
+
   const verible::TextStructureView& text_structure = analyzer->get()->Data();
-  std::string formatted_text;
   Status format_status = FormatVerilog(text_structure, filename, style,
-                                       &formatted_text, lines, control);
-  // Commit formatted text to the output stream independent of status.
-  formatted_stream << formatted_text;
+                                       formatted_text, lines, format_control);
   if (!format_status.ok()) return format_status;
 
   // When formatting whole-file (no --lines are specified), ensure that
   // the formatting transformation is convergent after one iteration.
   //   format(format(text)) == format(text)
   if (control.verify_convergence) {
-    std::ostringstream reformat_stream;
+    // Costs are only reported for formatting the input.
+    ExecutionControl reformat_control(format_control);
+    reformat_control.show_partition_costs = false;
+    std::string reformatted_text;
     if (auto reformat_status =
-            ReformatVerilog(text, formatted_text, filename, style,
-                            reformat_stream, lines, control);
+            ReformatVerilog(text, *formatted_text, filename, style,
+                            &reformatted_text, lines, reformat_control);
         !reformat_status.ok()) {
       return reformat_status;
     }
-    const std::string& reformatted_text(reformat_stream.str());
-    return verible::ReformatMustMatch(text, lines, formatted_text,
+    return verible::ReformatMustMatch(text, lines, *formatted_text,
                                       reformatted_text);
   }
   return format_status;
@@ -315,9 +508,8 @@ absl::Status FormatVerilogRange(const verible::TextStructureView& structure,
     return absl::CancelledError("Halting for diagnostic operation.");
   }
 
-  std::ostringstream output_buffer;
-  fmt.Emit(false, output_buffer);
-  *formatted_text = output_buffer.str();
+  formatted_text->clear();
+  fmt.Emit(false, formatted_text);
 
   // The range-format can output a spurious newline in the beginning (#1150).
   // Whitespace handling needs some rework in the formatter, and it is not
@@ -362,6 +554,94 @@ static verible::Interval<int> DisableByteOffsetRange(
   return {range.first + 1, range.second};
 }
 
+// Returns true if all tokens of 'uwline' are format-disabled.  The original
+// text of such partitions is emitted, regardless of how they are reshaped,
+// aligned or wrapped, so that formatting only the selected lines does not
+// need to do any of these for the rest of the file.
+static bool IsFormatDisabled(const UnwrappedLine& uwline,
+                             const FlatByteOffsetSet& disabled_ranges,
+                             absl::string_view full_text) {
+  if (disabled_ranges.empty() || uwline.IsEmpty()) return false;
+  const verible::FormatTokenRange range(uwline.TokensRange());
+  return disabled_ranges.Contains(
+      {range.front().token->left(full_text),
+       range.back().token->right(full_text)});
+}
+
+// Collects the partitions with kTabularAlignment policy that the reshaping
+// pass in Formatter::Format() aligns before it modifies them or any of their
+// ancestors.  Their alignment can be calculated before that pass.
+static void CollectIndependentAlignmentPartitions(
+    TokenPartitionTree* node, const FlatByteOffsetSet& disabled_ranges,
+    absl::string_view full_text, std::vector<TokenPartitionTree*>* result) {
+  if (!IsFormatDisabled(node->Value(), disabled_ranges, full_text)) {
+    switch (node->Value().PartitionPolicy()) {
+      case PartitionPolicyEnum::kTabularAlignment:
+        result->push_back(node);
+        return;
+      case PartitionPolicyEnum::kAppendFittingSubPartitions:
+      case PartitionPolicyEnum::kJuxtaposition:
+      case PartitionPolicyEnum::kStack:
+      case PartitionPolicyEnum::kWrap:
+      case PartitionPolicyEnum::kJuxtapositionOrIndentedStack:
+        // The subtree is reshaped.
+        return;
+      default:
+        break;
+    }
+  }
+  for (auto& child : node->Children()) {
+    CollectIndependentAlignmentPartitions(&child, disabled_ranges, full_text,
+                                          result);
+  }
+}
+
+// Calculates alignment of the independent partitions of 'root' (see
+// CollectIndependentAlignmentPartitions()) using 'threads' threads.
+static absl::flat_hash_map<const TokenPartitionTree*, verible::TabularAlignment>
+CalculateIndependentAlignments(const FormatStyle& style,
+                               absl::string_view full_text,
+                               const ByteOffsetSet& disabled_ranges,
+                               int threads, TokenPartitionTree* root) {
+  std::vector<TokenPartitionTree*> partitions;
+  const FlatByteOffsetSet flat_disabled_ranges(disabled_ranges);
+  CollectIndependentAlignmentPartitions(root, flat_disabled_ranges, full_text,
+                                        &partitions);
+  std::vector<verible::TabularAlignment> alignments(partitions.size());
+  std::atomic<size_t> next_partition(0);
+  // Each worker picks the next partition until all are done.
+  const auto align_worker = [&]() -> bool {
+    VERIBLE_TRACE_SCOPE("format", "align-worker");
+    for (size_t i = next_partition++; i < partitions.size();
+         i = next_partition++) {
+      alignments[i] = CalculateTokenPartitionsAlignment(
+          style, full_text, disabled_ranges, partitions[i]);
+    }
+    return true;
+  };
+
+  threads = std::min<int>(threads, partitions.size());
+  if (threads <= 1) {
+    align_worker();
+  } else {
+    verible::ThreadPool pool(threads);
+    std::vector<std::future<bool>> workers;
+    workers.reserve(threads);
+    for (int t = 0; t < threads; ++t) {
+      workers.push_back(pool.ExecAsync<bool>(align_worker));
+    }
+    for (auto& worker : workers) worker.get();
+  }
+
+  absl::flat_hash_map<const TokenPartitionTree*, verible::TabularAlignment>
+      result;
+  result.reserve(partitions.size());
+  for (size_t i = 0; i < partitions.size(); ++i) {
+    result.emplace(partitions[i], std::move(alignments[i]));
+  }
+  return result;
+}
+
 // Decided at each node in UnwrappedLine partition tree whether or not
 // it should be expanded or unexpanded.
 static void DeterminePartitionExpansion(
@@ -720,6 +1000,13 @@ class ContinuationCommentAligner {
     return true;
   }
 
+  // Forgets the current comment group, like HandleLine() does for a line that
+  // is not a continuation comment.
+  void Reset() {
+    original_column_ = kInvalidColumn;
+    formatted_column_ = kInvalidColumn;
+  }
+
  private:
   int GetTokenColumn(const verible::TokenInfo* token) {
     CHECK_NOTNULL(token);
@@ -786,6 +1073,218 @@ class ContinuationCommentAligner {
   int formatted_column_ = kInvalidColumn;
 };
 
+namespace {
+// Formatting decisions of one token of a cached item.
+struct CachedToken {
+  int spaces;
+  verible::SpacingDecision action;
+  // Offset of the preserved spaces from the start of the item's text, or -1
+  // to keep the preserved spaces of the token that gets these decisions.
+  int preserved_space_offset;
+};
+
+// One formatted line of a cached item.
+struct CachedLine {
+  int indentation;
+  int tokens;
+};
+
+struct CachedItem {
+  std::vector<CachedLine> lines;
+  std::vector<CachedToken> tokens;
+  uint64_t last_used = 0;
+};
+}  // namespace
+
+struct FormattedItemCache::Entries {
+  explicit Entries(size_t max_items) : max_items(max_items) {}
+
+  // Drops the least recently used items, if there are too many.
+  void Evict() {
+    if (items.size() <= max_items) return;
+    std::vector<uint64_t> last_used;
+    last_used.reserve(items.size());
+    for (const auto& item : items) last_used.push_back(item.second.last_used);
+    const auto oldest_kept = last_used.end() - max_items;
+    std::nth_element(last_used.begin(), oldest_kept, last_used.end());
+    const uint64_t threshold = *oldest_kept;
+    absl::erase_if(items, [threshold](const auto& item) {
+      return item.second.last_used < threshold;
+    });
+  }
+
+  const size_t max_items;
+  // Items are only valid for the style they were formatted with.
+  std::string style_key;
+  // Keyed by the item's indentation and text.
+  absl::flat_hash_map<std::string, CachedItem> items;
+  // Incremented by each formatting that uses this cache.
+  uint64_t generation = 0;
+  size_t hits = 0;
+};
+
+FormattedItemCache::FormattedItemCache(size_t max_items)
+    : entries_(std::make_unique<Entries>(max_items)) {}
+
+FormattedItemCache::~FormattedItemCache() = default;
+
+size_t FormattedItemCache::size() const { return entries_->items.size(); }
+
+size_t FormattedItemCache::hits() const { return entries_->hits; }
+
+// Returns a string that differs for styles that format differently.
+static std::string FormatStyleKey(const FormatStyle& style) {
+  const auto i = [](auto value) { return static_cast<int>(value); };
+  return absl::StrCat(
+      style.indentation_spaces, ",", style.wrap_spaces, ",", style.column_limit,
+      ",", style.over_column_limit_penalty, ",", style.line_break_penalty, ",",
+      i(style.port_declarations_indentation), ",",
+      i(style.port_declarations_alignment), ",",
+      i(style.struct_union_members_alignment), ",",
+      i(style.named_parameter_indentation), ",",
+      i(style.named_parameter_alignment), ",",
+      i(style.named_port_indentation), ",", i(style.named_port_alignment), ",",
+      i(style.module_net_variable_alignment), ",",
+      i(style.assignment_statement_alignment), ",",
+      i(style.enum_assignment_statement_alignment), ",",
+      i(style.formal_parameters_indentation), ",",
+      i(style.formal_parameters_alignment), ",",
+      i(style.class_member_variable_alignment), ",",
+      i(style.case_items_alignment), ",", i(style.distribution_items_alignment),
+      ",", style.port_declarations_right_align_packed_dimensions, ",",
+      style.port_declarations_right_align_unpacked_dimensions, ",",
+      style.try_wrap_long_lines, ",", style.expand_coverpoints, ",",
+      style.compact_indexing_and_selections);
+}
+
+// A top-level item whose formatting can be looked up in and saved to a
+// FormattedItemCache.
+struct Formatter::CacheableItem {
+  // Range of the item's tokens.
+  verible::FormatTokenRange::const_iterator begin;
+  verible::FormatTokenRange::const_iterator end;
+  // Byte offset of the start of the line with the first token.
+  int text_begin;
+  std::string key;
+  // Formatting found in the cache, or nullptr.
+  const CachedItem* cached = nullptr;
+};
+
+// Collects the time and search effort spent on formatting each partition that
+// is optimized as a tree or searched as a line, for finding the constructs
+// that are the most expensive to format.
+class PartitionCosts {
+ public:
+  struct Cost {
+    // Byte offset of the first token, and the number of tokens.
+    int offset = 0;
+    int tokens = 0;
+    absl::Duration time;
+
+    void SetPartition(const UnwrappedLine& uwline, absl::string_view text) {
+      tokens = uwline.Size();
+      if (tokens > 0) offset = uwline.TokensRange().front().token->left(text);
+    }
+  };
+  struct LayoutCost : Cost {
+    verible::LayoutOptimizerStats stats;
+  };
+  struct SearchCost : Cost {
+    verible::LineWrapSearchStats stats;
+  };
+
+  std::vector<LayoutCost> layouts;
+  // Indexed like the lines of the worklist.  Lines that were not searched
+  // have no tokens.
+  std::vector<SearchCost> searches;
+
+  // Writes the costs as a JSON object, most expensive first.
+  void Write(const verible::TextStructureView& text_structure,
+             std::ostream& stream) const;
+};
+
+// Returns pointers to the 'costs' that have tokens, by decreasing time.
+template <typename T>
+static std::vector<const T*> SortByTime(const std::vector<T>& costs) {
+  std::vector<const T*> sorted;
+  for (const T& cost : costs) {
+    if (cost.tokens > 0) sorted.push_back(&cost);
+  }
+  std::stable_sort(sorted.begin(), sorted.end(),
+                   [](const T* a, const T* b) { return a->time > b->time; });
+  return sorted;
+}
+
+void PartitionCosts::Write(const verible::TextStructureView& text_structure,
+                           std::ostream& stream) const {
+  const absl::string_view text(text_structure.Contents());
+  const verible::LineColumnMap& line_column_map =
+      text_structure.GetLineColumnMap();
+  verible::JsonWriter writer(&stream);
+  // Lines and columns are 1-based, like in diagnostics.
+  const auto write_cost = [&](const Cost& cost) {
+    const verible::LineColumn position =
+        line_column_map.GetLineColAtOffset(text, cost.offset);
+    writer.Key("line").Value(position.line + 1);
+    writer.Key("column").Value(position.column + 1);
+    writer.Key("tokens").Value(cost.tokens);
+    writer.Key("time_us").Value(absl::ToInt64Microseconds(cost.time));
+  };
+
+  writer.BeginObject();
+  writer.Key("layout_optimizer").BeginArray();
+  for (const LayoutCost* cost : SortByTime(layouts)) {
+    writer.BeginObject();
+    write_cost(*cost);
+    writer.Key("calculated_layouts").Value(cost->stats.calculated_layouts);
+    writer.Key("calculated_segments").Value(cost->stats.calculated_segments);
+    writer.Key("cached_layouts").Value(cost->stats.cached_layouts);
+    writer.Key("segments").Value(cost->stats.segments);
+    writer.EndObject();
+  }
+  writer.EndArray();
+  writer.Key("line_wrap_search").BeginArray();
+  for (const SearchCost* cost : SortByTime(searches)) {
+    writer.BeginObject();
+    write_cost(*cost);
+    writer.Key("explored_states").Value(cost->stats.explored_states);
+    writer.Key("pruned_states").Value(cost->stats.pruned_states);
+    writer.Key("search_limit_reached").Value(cost->stats.aborted);
+    writer.Key("out_of_time").Value(cost->stats.out_of_time);
+    writer.EndObject();
+  }
+  writer.EndArray();
+  writer.EndObject();
+  stream << std::endl;
+}
+
+// Collects wall time spent in each formatter stage, for diagnostics.
+// Stages may be recorded from concurrently running threads.
+class StageTimings {
+ public:
+  // Records the time since 'start' of 'stage', which is also traced.
+  void Record(absl::string_view stage, absl::Time start) {
+    const absl::Time end = absl::Now();
+    verible::PipelineTrace().Record("format", stage, start, end);
+    const absl::MutexLock lock(&mutex_);
+    stages_.emplace_back(stage, end - start);
+  }
+
+  friend std::ostream& operator<<(std::ostream& stream,
+                                  const StageTimings& timings) {
+    const absl::MutexLock lock(&timings.mutex_);
+    stream << "Formatter stage timings:" << std::endl;
+    for (const auto& stage : timings.stages_) {
+      stream << "  " << stage.first << ": " << stage.second << std::endl;
+    }
+    return stream;
+  }
+
+ private:
+  mutable absl::Mutex mutex_;
+  std::vector<std::pair<absl::string_view, absl::Duration>> stages_;
+};
+
 Status Formatter::Format(const ExecutionControl& control) {
   const absl::string_view full_text(text_structure_.Contents());
   const auto& token_stream(text_structure_.TokenStream());
@@ -797,32 +1296,71 @@ Status Formatter::Format(const ExecutionControl& control) {
   TreeUnwrapper tree_unwrapper(text_structure_, style_,
                                unwrapper_data.preformatted_tokens);
 
+  StageTimings timings;
   const TokenPartitionTree* format_tokens_partitions = nullptr;
-  // TODO(fangism): The following block could be parallelized because
-  // full-partitioning does not depend on format annotations.
   {
-    // Annotate inter-token information between all adjacent PreFormatTokens.
-    // This must be done before any decisions about ExpandableTreeView
-    // can be made because they depend on minimum-spacing, and must-break.
-    AnnotateFormattingInformation(style_, text_structure_,
-                                  &unwrapper_data.preformatted_tokens);
-
-    // Determine ranges of disabling the formatter, based on comment controls.
-    disabled_ranges_.Union(DisableFormattingRanges(full_text, token_stream));
+    // Annotation of inter-token information and the search for disabled
+    // byte ranges are independent of each other, and can run concurrently.
+    // Token partitioning, however, depends on both: reshaping partitions
+    // looks at annotated must-wrap decisions and preserved spaces of
+    // disabled ranges.
+    const auto annotate = [&]() -> bool {
+      // Annotate inter-token information between all adjacent
+      // PreFormatTokens. This must be done before any decisions about
+      // ExpandableTreeView can be made because they depend on
+      // minimum-spacing, and must-break.
+      const absl::Time start = absl::Now();
+      AnnotateFormattingInformation(style_, text_structure_,
+                                    &unwrapper_data.preformatted_tokens);
+      timings.Record("annotate", start);
+      return true;
+    };
+    const auto find_disabled_ranges = [&]() -> ByteOffsetSet {
+      const absl::Time start = absl::Now();
+      // Determine ranges of disabling the formatter, based on comment
+      // controls.
+      ByteOffsetSet disabled_ranges(
+          DisableFormattingRanges(full_text, token_stream));
+
+      // Find disabled formatting ranges for specific syntax tree node types.
+      // These are typically temporary workarounds for sections that users
+      // habitually prefer to format themselves.
+      if (const auto& root = text_structure_.SyntaxTree()) {
+        DisableSyntaxBasedRanges(&disabled_ranges, *root, style_, full_text);
+      }
+      timings.Record("disable-ranges", start);
+      return disabled_ranges;
+    };
 
-    // Find disabled formatting ranges for specific syntax tree node types.
-    // These are typically temporary workarounds for sections that users
-    // habitually prefer to format themselves.
-    if (const auto& root = text_structure_.SyntaxTree()) {
-      DisableSyntaxBasedRanges(&disabled_ranges_, *root, style_, full_text);
+    if (control.concurrent_annotation) {
+      verible::ThreadPool pool(1);
+      std::future<bool> annotated = pool.ExecAsync<bool>(annotate);
+      disabled_ranges_.Union(find_disabled_ranges());
+      annotated.get();
+    } else {
+      annotate();
+      disabled_ranges_.Union(find_disabled_ranges());
     }
+    flat_disabled_ranges_ = FlatByteOffsetSet(disabled_ranges_);
 
+    const absl::Time start = absl::Now();
     // Disable formatting ranges.
     verible::PreserveSpacesOnDisabledTokenRanges(
         &unwrapper_data.preformatted_tokens, disabled_ranges_, full_text);
 
     // Partition PreFormatTokens into candidate unwrapped lines.
     format_tokens_partitions = tree_unwrapper.Unwrap();
+    timings.Record("unwrap", start);
+  }
+  if (verible::SubsystemMemory().Enabled()) {
+    int64_t partitions = 0;
+    verible::ApplyPreOrder(*format_tokens_partitions,
+                           [&](const TokenPartitionTree&) { ++partitions; });
+    verible::SubsystemMemory().Allocate(
+        "formatter partitions",
+        partitions * sizeof(TokenPartitionTree) +
+            unwrapper_data.preformatted_tokens.capacity() *
+                sizeof(verible::PreFormatToken));
   }
 
   {
@@ -843,11 +1381,50 @@ Status Formatter::Format(const ExecutionControl& control) {
       return absl::OkStatus();
     }
   }
+  if (control.Cancelled()) return FormattingCancelled();
+
+  // Top-level items that were formatted before get their formatting from the
+  // cache, and are skipped by the following passes.
+  FormattedItemCache::Entries* const item_cache =
+      control.formatted_item_cache != nullptr
+          ? control.formatted_item_cache->entries_.get()
+          : nullptr;
+  std::vector<CacheableItem> cacheable_items;
+  if (item_cache != nullptr) {
+    cacheable_items = LookUpCachedItems(*format_tokens_partitions, item_cache);
+    flat_cached_ranges_ = FlatByteOffsetSet(cached_ranges_);
+  }
 
+  PartitionCosts partition_costs;
+  PartitionCosts* const costs =
+      control.show_partition_costs ? &partition_costs : nullptr;
+
+  absl::Time stage_start = absl::Now();
   {  // In this pass, perform additional modifications to the partitions and
      // spacings.
+    // Layouts of repeated partitions are calculated only once.
+    verible::LayoutFunctionCache layout_function_cache;
+    // Children of large partitions are laid out concurrently.
+    std::unique_ptr<verible::ThreadPool> layout_pool;
+    if (control.layout_optimizer_threads > 1) {
+      layout_pool = std::make_unique<verible::ThreadPool>(
+          control.layout_optimizer_threads);
+    }
+    // Alignments of independent partitions are calculated concurrently
+    // beforehand, and applied in order.
+    absl::flat_hash_map<const TokenPartitionTree*, verible::TabularAlignment>
+        alignments;
+    if (control.alignment_threads > 1) {
+      alignments = CalculateIndependentAlignments(
+          style_, full_text, disabled_ranges_, control.alignment_threads,
+          tree_unwrapper.CurrentTokenPartition());
+    }
     tree_unwrapper.ApplyPreOrder([&](TokenPartitionTree& node) {
       const auto& uwline = node.Value();
+      if (IsFormatDisabled(uwline, flat_disabled_ranges_, full_text) ||
+          IsFormatDisabled(uwline, flat_cached_ranges_, full_text)) {
+        return;
+      }
       const auto partition_policy = uwline.PartitionPolicy();
 
       switch (partition_policy) {
@@ -858,24 +1435,50 @@ Status Formatter::Format(const ExecutionControl& control) {
         case PartitionPolicyEnum::kJuxtaposition:
         case PartitionPolicyEnum::kStack:
         case PartitionPolicyEnum::kWrap:
-        case PartitionPolicyEnum::kJuxtapositionOrIndentedStack:
-          verible::OptimizeTokenPartitionTree(style_, &node);
+        case PartitionPolicyEnum::kJuxtapositionOrIndentedStack: {
+          absl::Time start;
+          verible::LayoutOptimizerStats* stats = nullptr;
+          VERIBLE_TRACE_SCOPE("format", "layout-optimizer");
+          if (costs != nullptr) {
+            auto& cost = costs->layouts.emplace_back();
+            cost.SetPartition(uwline, full_text);
+            stats = &cost.stats;
+            start = absl::Now();
+          }
+          verible::OptimizeTokenPartitionTree(style_, &node,
+                                              &layout_function_cache, stats,
+                                              layout_pool.get());
+          if (costs != nullptr) {
+            costs->layouts.back().time = absl::Now() - start;
+          }
           break;
-        case PartitionPolicyEnum::kTabularAlignment:
+        }
+        case PartitionPolicyEnum::kTabularAlignment: {
           // TODO(b/145170750): Adjust inter-token spacing to achieve alignment,
           // but leave partitioning intact.
           // This relies on inter-token spacing having already been annotated.
-          TabularAlignTokenPartitions(style_, full_text, disabled_ranges_,
-                                      &node);
+          VERIBLE_TRACE_SCOPE("format", "align");
+          if (const auto found = alignments.find(&node);
+              found != alignments.end()) {
+            verible::ApplyTabularAlignment(found->second);
+          } else {
+            TabularAlignTokenPartitions(style_, full_text, disabled_ranges_,
+                                        &node);
+          }
           break;
+        }
         default:
           break;
       }
     });
   }
 
+  timings.Record("optimize-partitions", stage_start);
+  if (control.Cancelled()) return FormattingCancelled();
+
   // Apply token spacing from partitions to tokens. This is permanent, so it
   // must be done after all reshaping is done.
+  stage_start = absl::Now();
   {
     auto* root = tree_unwrapper.CurrentTokenPartition();
     auto node_iter = VectorTreeLeavesIterator(&LeftmostDescendant(*root));
@@ -908,27 +1511,74 @@ Status Formatter::Format(const ExecutionControl& control) {
   const auto unwrapped_lines = MakeUnwrappedLinesWorklist(
       style_, full_text, disabled_ranges_, *format_tokens_partitions,
       &unwrapper_data.preformatted_tokens);
+  timings.Record("make-worklist", stage_start);
+  if (control.Cancelled()) return FormattingCancelled();
 
   // For each UnwrappedLine: minimize total penalty of wrap/break decisions.
-  // TODO(fangism): This could be parallelized if results are written
-  // to their own 'slots'.
+  // The searches are independent of each other, so they are done first
+  // (possibly in parallel), each writing to its own slot.
+  stage_start = absl::Now();
+  const absl::Time search_deadline =
+      stage_start + control.line_wrap_search_file_budget;
+  if (costs != nullptr) costs->searches.resize(unwrapped_lines.size());
+  std::vector<std::vector<verible::FormattedExcerpt>> searched_lines =
+      SearchLineWrapsForAll(unwrapped_lines, control, search_deadline, costs);
+  // Lines left unsearched on cancellation are not to be searched below.
+  if (control.Cancelled()) return FormattingCancelled();
+
+  // The remaining steps depend on previously formatted lines, so they are
+  // applied in a serial pass in original order.
   std::vector<const UnwrappedLine*> partially_formatted_lines;
   formatted_lines_.reserve(unwrapped_lines.size());
   ContinuationCommentAligner continuation_comment_aligner(
       text_structure_.GetLineColumnMap(), text_structure_.Contents());
-  for (const auto& uwline : unwrapped_lines) {
+  auto next_cached_item = cacheable_items.cbegin();
+  for (size_t i = 0; i < unwrapped_lines.size(); ++i) {
+    const UnwrappedLine& uwline = unwrapped_lines[i];
     // TODO(fangism): Use different formatting strategies depending on
     // uwline.PartitionPolicy().
-    if (continuation_comment_aligner.HandleLine(uwline, &formatted_lines_)) {
+    if (IsFormatDisabled(uwline, flat_cached_ranges_, full_text)) {
+      // All lines of a cached item are replaced by its cached lines.
+      const auto line_begin = uwline.TokensRange().begin();
+      while (next_cached_item != cacheable_items.cend() &&
+             (next_cached_item->cached == nullptr ||
+              next_cached_item->begin < line_begin)) {
+        ++next_cached_item;
+      }
+      if (next_cached_item != cacheable_items.cend() &&
+          next_cached_item->begin == line_begin) {
+        EmitCachedItem(*next_cached_item);
+        continuation_comment_aligner.Reset();
+      }
+    } else if (continuation_comment_aligner.HandleLine(uwline,
+                                                       &formatted_lines_)) {
     } else if (uwline.PartitionPolicy() ==
-               PartitionPolicyEnum::kAlreadyFormatted) {
+                   PartitionPolicyEnum::kAlreadyFormatted ||
+               IsFormatDisabled(uwline, flat_disabled_ranges_, full_text)) {
       // For partitions that were successfully aligned, do not search
       // line-wrapping, but instead accept the adjusted padded spacing.
+      // Format-disabled partitions keep their original spacing.
       formatted_lines_.emplace_back(uwline);
     } else {
       // In other case, default to searching for optimal line wrapping.
-      const auto optimal_solutions =
-          verible::SearchLineWraps(uwline, style_, control.max_search_states);
+      std::vector<verible::FormattedExcerpt> optimal_solutions(
+          std::move(searched_lines[i]));
+      if (optimal_solutions.empty()) {
+        // Lines that could have been continuation comments were not searched
+        // in advance.
+        PartitionCosts::SearchCost* cost =
+            costs != nullptr ? &costs->searches[i] : nullptr;
+        const absl::Time start = absl::Now();
+        optimal_solutions = verible::SearchLineWraps(
+            uwline, style_, control.max_search_states,
+            cost != nullptr ? &cost->stats : nullptr, control.is_cancelled,
+            LineWrapSearchDeadline(control, search_deadline),
+            control.line_wrap_search_estimate_cost);
+        if (cost != nullptr) {
+          cost->SetPartition(uwline, full_text);
+          cost->time = absl::Now() - start;
+        }
+      }
       if (control.show_equally_optimal_wrappings &&
           optimal_solutions.size() > 1) {
         verible::DisplayEquallyOptimalWrappings(control.Stream(), uwline,
@@ -942,6 +1592,20 @@ Status Formatter::Format(const ExecutionControl& control) {
       }
     }
   }
+  timings.Record("line-wrap-search", stage_start);
+  // Searches cut short by cancellation are not results worth keeping.
+  if (control.Cancelled()) return FormattingCancelled();
+
+  if (item_cache != nullptr) {
+    SaveFormattedItems(cacheable_items, item_cache);
+  }
+
+  if (control.show_stage_timings) {
+    control.Stream() << timings;
+  }
+  if (costs != nullptr) {
+    costs->Write(text_structure_, control.Stream());
+  }
 
   // Report any unwrapped lines that failed to complete wrap searching.
   if (!partially_formatted_lines.empty()) {
@@ -960,17 +1624,210 @@ Status Formatter::Format(const ExecutionControl& control) {
   return absl::OkStatus();
 }
 
-void Formatter::Emit(bool include_disabled, std::ostream& stream) const {
+// Returns true if 'uwline' could be handled by the ContinuationCommentAligner,
+// which depends on previously formatted lines.
+static bool MaybeContinuationCommentLine(const UnwrappedLine& uwline) {
+  return uwline.Size() == 1 && uwline.TokensRange().back().TokenEnum() ==
+                                   verilog_tokentype::TK_EOL_COMMENT;
+}
+
+std::vector<std::vector<verible::FormattedExcerpt>>
+Formatter::SearchLineWrapsForAll(const std::vector<UnwrappedLine>& uwlines,
+                                 const ExecutionControl& control,
+                                 absl::Time file_deadline,
+                                 PartitionCosts* costs) const {
   const absl::string_view full_text(text_structure_.Contents());
-  std::function<bool(const verible::TokenInfo&)> include_token_p;
-  if (include_disabled) {
-    include_token_p = [](const verible::TokenInfo&) { return true; };
-  } else {
-    include_token_p = [this, &full_text](const verible::TokenInfo& tok) {
-      return !disabled_ranges_.Contains(tok.left(full_text));
+  std::vector<std::vector<verible::FormattedExcerpt>> results(uwlines.size());
+  std::atomic<size_t> next_line(0);
+  // Each worker picks the next unsearched line until all are done.
+  const auto search_worker = [&]() -> bool {
+    VERIBLE_TRACE_SCOPE("format", "line-wrap-search-worker");
+    for (size_t i = next_line++; i < uwlines.size(); i = next_line++) {
+      if (control.Cancelled()) break;
+      const UnwrappedLine& uwline = uwlines[i];
+      if (uwline.PartitionPolicy() == PartitionPolicyEnum::kAlreadyFormatted ||
+          MaybeContinuationCommentLine(uwline) ||
+          IsFormatDisabled(uwline, flat_disabled_ranges_, full_text) ||
+          IsFormatDisabled(uwline, flat_cached_ranges_, full_text)) {
+        continue;
+      }
+      const absl::Time deadline =
+          LineWrapSearchDeadline(control, file_deadline);
+      if (costs == nullptr) {
+        results[i] = verible::SearchLineWraps(
+            uwline, style_, control.max_search_states, nullptr,
+            control.is_cancelled, deadline,
+            control.line_wrap_search_estimate_cost);
+        continue;
+      }
+      PartitionCosts::SearchCost& cost = costs->searches[i];
+      cost.SetPartition(uwline, full_text);
+      const absl::Time start = absl::Now();
+      results[i] = verible::SearchLineWraps(
+          uwline, style_, control.max_search_states, &cost.stats,
+          control.is_cancelled, deadline,
+          control.line_wrap_search_estimate_cost);
+      cost.time = absl::Now() - start;
+    }
+    return true;
+  };
+
+  const int threads = std::min<int>(control.line_wrap_search_threads,
+                                    uwlines.size());
+  if (threads <= 1) {
+    search_worker();
+    return results;
+  }
+
+  verible::ThreadPool pool(threads);
+  std::vector<std::future<bool>> workers;
+  workers.reserve(threads);
+  for (int t = 0; t < threads; ++t) {
+    workers.push_back(pool.ExecAsync<bool>(search_worker));
+  }
+  for (auto& worker : workers) worker.get();
+  return results;
+}
+
+std::vector<Formatter::CacheableItem> Formatter::LookUpCachedItems(
+    const TokenPartitionTree& root, FormattedItemCache::Entries* cache) {
+  std::vector<CacheableItem> items;
+  std::string style_key = FormatStyleKey(style_);
+  if (style_key != cache->style_key) {
+    cache->items.clear();
+    cache->style_key = std::move(style_key);
+  }
+  ++cache->generation;
+  // Items that get aligned to each other depend on each other.
+  if (root.Value().PartitionPolicy() != PartitionPolicyEnum::kAlwaysExpand) {
+    return items;
+  }
+
+  const absl::string_view full_text(text_structure_.Contents());
+  const ByteOffsetSet& disabled_ranges = disabled_ranges_;
+  for (const auto& child : root.Children()) {
+    const UnwrappedLine& uwline = child.Value();
+    if (uwline.IsEmpty()) continue;
+    const verible::FormatTokenRange range(uwline.TokensRange());
+    const int begin = range.front().token->left(full_text);
+    const int end = range.back().token->right(full_text);
+    // The formatting of partly disabled items depends on what is disabled.
+    const auto disabled = disabled_ranges.LowerBound(begin);
+    if (disabled != disabled_ranges.end() && disabled->first < end) continue;
+
+    CacheableItem& item = items.emplace_back();
+    item.begin = range.begin();
+    item.end = range.end();
+    const size_t newline = full_text.rfind('\n', begin);
+    item.text_begin = newline == absl::string_view::npos ? 0 : newline + 1;
+    // The spacing before the first token depends on the preceding token.
+    const verible::InterTokenInfo& before = range.front().before;
+    item.key = absl::StrCat(
+        uwline.IndentationSpaces(), ",", before.spaces_required, ",",
+        static_cast<int>(before.break_decision), ",",
+        full_text.substr(item.text_begin, end - item.text_begin));
+
+    const auto found = cache->items.find(item.key);
+    if (found == cache->items.end()) continue;
+    found->second.last_used = cache->generation;
+    item.cached = &found->second;
+    ++cache->hits;
+    cached_ranges_.Add({begin, end});
+  }
+  return items;
+}
+
+void Formatter::EmitCachedItem(const CacheableItem& item) {
+  const char* const text = text_structure_.Contents().data() + item.text_begin;
+  auto token = item.begin;
+  auto cached_token = item.cached->tokens.begin();
+  for (const CachedLine& line : item.cached->lines) {
+    UnwrappedLine uwline(line.indentation, token);
+    token += line.tokens;
+    uwline.SpanUpToToken(token);
+    auto& excerpt = formatted_lines_.emplace_back(uwline);
+    for (verible::FormattedToken& ftoken : excerpt.MutableTokens()) {
+      ftoken.before.spaces = cached_token->spaces;
+      ftoken.before.action = cached_token->action;
+      if (cached_token->preserved_space_offset >= 0) {
+        ftoken.before.preserved_space_start =
+            text + cached_token->preserved_space_offset;
+      }
+      ++cached_token;
+    }
+  }
+}
+
+void Formatter::SaveFormattedItems(const std::vector<CacheableItem>& items,
+                                   FormattedItemCache::Entries* cache) const {
+  const char* const full_text = text_structure_.Contents().data();
+  // Formatted lines and items are both in token order.
+  auto line = formatted_lines_.begin();
+  const auto lines_end = formatted_lines_.end();
+  for (const CacheableItem& item : items) {
+    const verible::TokenInfo* const first_token = item.begin->token;
+    const verible::TokenInfo* const last_token = std::prev(item.end)->token;
+    while (line != lines_end &&
+           (line->Tokens().empty() ||
+            line->Tokens().front().token < first_token)) {
+      ++line;
+    }
+    if (item.cached != nullptr) continue;
+    if (line == lines_end || line->Tokens().front().token != first_token) {
+      continue;
+    }
+
+    // Only items formatted independently of their surroundings are saved.
+    // Continuation comments depend on the previous line, and reset the
+    // alignment of the following ones.
+    const char* const text = full_text + item.text_begin;
+    const char* const text_end = last_token->text().end();
+    CachedItem cached;
+    bool cacheable = true;
+    const verible::FormattedExcerpt* last_line = nullptr;
+    for (auto item_line = line; cacheable && item_line != lines_end;
+         ++item_line) {
+      const auto& tokens = item_line->Tokens();
+      if (tokens.empty()) continue;
+      if (tokens.front().token > last_token) break;
+      last_line = &*item_line;
+      cacheable = item_line->CompletedFormatting();
+      cached.lines.push_back(
+          {item_line->IndentationSpaces(), static_cast<int>(tokens.size())});
+      for (const verible::FormattedToken& ftoken : tokens) {
+        int offset = -1;  // the first token keeps its own preserved spaces
+        if (!cached.tokens.empty()) {
+          const char* const start = ftoken.before.preserved_space_start;
+          if (start == nullptr || start < text || start > text_end) {
+            cacheable = false;
+            break;
+          }
+          offset = start - text;
+        }
+        cached.tokens.push_back({ftoken.before.spaces, ftoken.before.action,
+                                 offset});
+      }
+    }
+    const auto is_comment_line = [](const verible::FormattedExcerpt& excerpt) {
+      return excerpt.Tokens().size() == 1 &&
+             excerpt.Tokens().front().token->token_enum() ==
+                 verilog_tokentype::TK_EOL_COMMENT;
     };
+    if (!cacheable || last_line->Tokens().back().token != last_token ||
+        cached.tokens.size() != static_cast<size_t>(item.end - item.begin) ||
+        is_comment_line(*line) || is_comment_line(*last_line)) {
+      continue;
+    }
+    cached.last_used = cache->generation;
+    cache->items.insert_or_assign(item.key, std::move(cached));
   }
+  cache->Evict();
+}
 
+template <typename WhitespaceFunction, typename TextFunction>
+void Formatter::ForEachOutputPart(WhitespaceFunction&& whitespace,
+                                  TextFunction&& text) const {
+  const absl::string_view full_text(text_structure_.Contents());
   int position = 0;  // tracks with the position in the original full_text
   for (const verible::FormattedExcerpt& line : formatted_lines_) {
     // TODO(fangism): The handling of preserved spaces before tokens is messy:
@@ -979,28 +1836,119 @@ void Formatter::Emit(bool include_disabled, std::ostream& stream) const {
     const auto front_offset =
         line.Tokens().empty() ? position
                               : line.Tokens().front().token->left(full_text);
-    const absl::string_view leading_whitespace(
-        full_text.substr(position, front_offset - position));
-    FormatWhitespaceWithDisabledByteRanges(full_text, leading_whitespace,
-                                           disabled_ranges_, include_disabled,
-                                           stream);
+    whitespace(full_text.substr(position, front_offset - position));
 
     // When front of first token is format-disabled, the previous call will
     // already cover the space up to the front token, in which case,
     // the left-indentation for this line should be suppressed to avoid
     // being printed twice.
     if (!line.Tokens().empty()) {
-      line.FormattedText(stream, !disabled_ranges_.Contains(front_offset),
-                         include_token_p);
+      text(line, !flat_disabled_ranges_.Contains(front_offset));
       position = line.Tokens().back().token->right(full_text);
     }
   }
 
   // Handle trailing spaces after last token.
-  const absl::string_view trailing_whitespace(full_text.substr(position));
-  FormatWhitespaceWithDisabledByteRanges(full_text, trailing_whitespace,
-                                         disabled_ranges_, include_disabled,
-                                         stream);
+  whitespace(full_text.substr(position));
+}
+
+void Formatter::Emit(bool include_disabled, std::string* output) const {
+  const absl::string_view full_text(text_structure_.Contents());
+  std::function<bool(const verible::TokenInfo&)> include_token_p;
+  if (include_disabled) {
+    include_token_p = [](const verible::TokenInfo&) { return true; };
+  } else {
+    include_token_p = [this, &full_text](const verible::TokenInfo& tok) {
+      return !flat_disabled_ranges_.Contains(tok.left(full_text));
+    };
+  }
+  const auto append_whitespace = [&](absl::string_view space_text,
+                                     std::string* whitespace_output) {
+    AppendWhitespaceWithDisabledByteRanges(full_text, space_text,
+                                           disabled_ranges_, include_disabled,
+                                           whitespace_output);
+  };
+
+  // First only add up the size of the output.
+  size_t size = output->size();
+  std::string whitespace;
+  ForEachOutputPart(
+      [&](absl::string_view space_text) {
+        whitespace.clear();
+        append_whitespace(space_text, &whitespace);
+        size += whitespace.size();
+      },
+      [&](const verible::FormattedExcerpt& line, bool indent) {
+        size += line.FormattedTextLength(indent, include_token_p);
+      });
+  output->reserve(size);
+
+  ForEachOutputPart(
+      [&](absl::string_view space_text) {
+        append_whitespace(space_text, output);
+      },
+      [&](const verible::FormattedExcerpt& line, bool indent) {
+        line.AppendFormattedText(output, indent, include_token_p);
+      });
+}
+
+// Appends the edit that turns the whitespace "original" into "formatted", if
+// they differ, without their common prefix and suffix.
+static void AppendWhitespaceEdit(absl::string_view original,
+                                 absl::string_view formatted,
+                                 std::vector<WhitespaceEdit>* edits) {
+  while (!original.empty() && !formatted.empty() &&
+         original.front() == formatted.front()) {
+    original.remove_prefix(1);
+    formatted.remove_prefix(1);
+  }
+  while (!original.empty() && !formatted.empty() &&
+         original.back() == formatted.back()) {
+    original.remove_suffix(1);
+    formatted.remove_suffix(1);
+  }
+  if (original.empty() && formatted.empty()) return;
+  edits->push_back({original, std::string(formatted)});
+}
+
+void Formatter::EmitWhitespaceEdits(std::vector<WhitespaceEdit>* edits) const {
+  const absl::string_view full_text(text_structure_.Contents());
+  // Same decisions as Emit(true, ...), but only the whitespace between
+  // tokens is printed, to "spaces", and compared to the original.
+  std::ostringstream spaces;
+  int position = 0;  // end of the previous token in full_text
+  const auto end_whitespace = [&](int offset) {
+    AppendWhitespaceEdit(full_text.substr(position, offset - position),
+                         spaces.str(), edits);
+    spaces.str("");
+  };
+  for (const verible::FormattedExcerpt& line : formatted_lines_) {
+    if (line.Tokens().empty()) continue;
+    const verible::FormattedToken& front = line.Tokens().front();
+    const int front_offset = front.token->left(full_text);
+    FormatWhitespaceWithDisabledByteRanges(
+        full_text, full_text.substr(position, front_offset - position),
+        disabled_ranges_, true, spaces);
+    // As in FormattedExcerpt::FormattedText().
+    if (!flat_disabled_ranges_.Contains(front_offset) &&
+        front.before.action != verible::SpacingDecision::kPreserve) {
+      spaces << verible::Spacer(line.IndentationSpaces());
+    }
+    if (front.before.action == verible::SpacingDecision::kAlign) {
+      spaces << verible::Spacer(front.before.spaces);
+    }
+    end_whitespace(front_offset);
+    position = front.token->right(full_text);
+    for (const verible::FormattedToken& ftoken :
+         verible::make_range(line.Tokens().begin() + 1, line.Tokens().end())) {
+      ftoken.FormattedLeadingSpaces(spaces);
+      end_whitespace(ftoken.token->left(full_text));
+      position = ftoken.token->right(full_text);
+    }
+  }
+  FormatWhitespaceWithDisabledByteRanges(full_text, full_text.substr(position),
+                                         disabled_ranges_, true, spaces);
+  end_whitespace(full_text.length());
 }
 
 }  // namespace formatter
@@ -15,10 +15,17 @@
 #ifndef VERIBLE_VERILOG_FORMATTING_FORMATTER_H_
 #define VERIBLE_VERILOG_FORMATTING_FORMATTER_H_
 
+#include <cstddef>
+#include <functional>
 #include <iosfwd>
+#include <memory>
+#include <string>
 #include <vector>
 
 #include "absl/status/status.h"
+#include "absl/strings/string_view.h"
+#include "absl/time/time.h"
+#include "common/strings/mem_block.h"
 #include "common/strings/position.h"
 #include "common/text/text_structure.h"
 #include "verilog/formatting/format_style.h"
@@ -26,6 +33,8 @@
 namespace verilog {
 namespace formatter {
 
+class FormattedItemCache;
+
 // Control over formatter's internal execution phases, mostly for debugging
 // and development.
 struct ExecutionControl {
@@ -48,11 +57,75 @@ struct ExecutionControl {
   // If this limit is exceeded, error out with a diagnostic message.
   int max_search_states = 10000;
 
+  // Wall time budgets of line wrap searches, of each line and of all lines of
+  // a file together.  Searches that exceed their budget, and all searches
+  // once the budget of the file is used up, settle for a greedily completed
+  // wrapping instead of an optimal one (see verible::SearchLineWraps()).
+  // Unlike max_search_states, that is not an error.
+  absl::Duration line_wrap_search_line_budget = absl::InfiniteDuration();
+  absl::Duration line_wrap_search_file_budget = absl::InfiniteDuration();
+
+  // If true, line wrap searches explore states in order of their cost plus a
+  // lower bound of the cost still to come, which finds wrappings of the same
+  // cost with fewer states.  Of several equally good wrappings, a different
+  // one may be chosen.
+  bool line_wrap_search_estimate_cost = false;
+
+  // Number of threads used to search line wrappings of independent
+  // UnwrappedLines within one file.  Values <= 1 search serially.
+  // The result does not depend on this setting.
+  int line_wrap_search_threads = 0;
+
+  // Number of threads used to calculate alignment of independent partitions
+  // within one file.  Values <= 1 calculate serially.
+  // The result does not depend on this setting.
+  int alignment_threads = 0;
+
+  // Number of threads used to calculate layouts of the children of large
+  // partitions, e.g. the port connections of a big instance.  Values <= 1
+  // calculate serially.  The result does not depend on this setting.
+  int layout_optimizer_threads = 0;
+
+  // If true, annotate inter-token information on a separate thread while
+  // determining the format-disabled ranges of the file.
+  // The result does not depend on this setting.
+  bool concurrent_annotation = false;
+
+  // If true, print the wall time spent in each formatter stage to Stream().
+  bool show_stage_timings = false;
+
+  // If true, print to Stream() a JSON report of the wall time and search
+  // effort spent on each partition that the layout optimizer formats and each
+  // line that gets its line wrapping searched, most expensive first.
+  bool show_partition_costs = false;
+
   // If true, and not running in incremental format mode with lines specified,
   // format the formatted output one more time to compare and check for
-  // convergence: format(format(text)) == format(text).
+  // convergence: format(format(text)) == format(text).  Top-level items that
+  // the first pass left unchanged are not formatted again, but get their
+  // formatting from a FormattedItemCache (formatted_item_cache, if set).
   bool verify_convergence = true;
 
+  // If true, verify the formatted output by lexing it once and comparing it
+  // to the already lexed input tokens, instead of re-analyzing it.  Only if
+  // that comparison fails, the output is re-analyzed to confirm the error.
+  // The convergence check then only re-formats the lines that formatting
+  // changed.
+  bool fast_verification = false;
+
+  // If set, the formatting of top-level items (e.g. modules, packages,
+  // classes) is looked up in and saved to this cache, so that formatting a
+  // text again after small edits only formats the items that changed.
+  // The result does not depend on this setting.
+  FormattedItemCache* formatted_item_cache = nullptr;
+
+  // If set, it is checked between formatting stages and during line wrap
+  // searches, and formatting stops with a kCancelled error once it returns
+  // true.  Editors use this to abandon formatting that is not needed anymore,
+  // and tools to enforce time budgets.  It may be called from several threads
+  // at once, with line_wrap_search_threads.
+  std::function<bool()> is_cancelled;
+
   // Output stream for diagnostic feedback (not formatting output).
   // This is useful for seeing diagnostics without waiting for a Status
   // to be returned.
@@ -64,6 +137,38 @@ struct ExecutionControl {
   bool AnyStop() const {
     return show_largest_token_partitions != 0 || show_token_partition_tree;
   }
+
+  bool Cancelled() const { return is_cancelled && is_cancelled(); }
+};
+
+// Cache of the formatting of top-level items, for formatting the same text
+// repeatedly after edits, like editors do.  Items are identified by their
+// text, their indentation and the format style.  Items that were formatted
+// before are not formatted again, but get the formatting decisions that were
+// saved for them.
+// A cache must not be used by concurrent FormatVerilog() calls.
+class FormattedItemCache {
+ public:
+  // When more than 'max_items' items are cached, the least recently used ones
+  // are dropped.
+  explicit FormattedItemCache(size_t max_items = 4096);
+
+  FormattedItemCache(const FormattedItemCache&) = delete;
+  FormattedItemCache& operator=(const FormattedItemCache&) = delete;
+
+  ~FormattedItemCache();
+
+  // Returns the number of cached items.
+  size_t size() const;
+
+  // Returns the number of items that were found in this cache so far.
+  size_t hits() const;
+
+ private:
+  friend class Formatter;
+
+  struct Entries;
+  std::unique_ptr<Entries> entries_;
 };
 
 // Formats Verilog/SystemVerilog source code.
@@ -76,6 +181,20 @@ absl::Status FormatVerilog(absl::string_view text, absl::string_view filename,
                            std::ostream& formatted_stream,
                            const verible::LineNumberSet& lines = {},
                            const ExecutionControl& control = {});
+// Ditto, but with the output in "formatted_text", which is allocated once
+// for the whole text, instead of going through a stream.
+absl::Status FormatVerilog(absl::string_view text, absl::string_view filename,
+                           const FormatStyle& style,
+                           std::string* formatted_text,
+                           const verible::LineNumberSet& lines = {},
+                           const ExecutionControl& control = {});
+// Ditto, but parses "content" in place, e.g. a memory-mapped file, instead
+// of a copy of the text.
+absl::Status FormatVerilog(const std::shared_ptr<verible::MemBlock>& content,
+                           absl::string_view filename, const FormatStyle& style,
+                           std::string* formatted_text,
+                           const verible::LineNumberSet& lines = {},
+                           const ExecutionControl& control = {});
 // Ditto, but with TextStructureView as input and std::string as output.
 // This does verification of the resulting format, but _no_ convergence test.
 absl::Status FormatVerilog(const verible::TextStructureView& text_structure,
@@ -84,6 +203,30 @@ absl::Status FormatVerilog(const verible::TextStructureView& text_structure,
                            const verible::LineNumberSet& lines = {},
                            const ExecutionControl& control = {});
 
+// Replacement of "original", whitespace of a formatted text (possibly empty,
+// between two tokens), by "replacement".
+struct WhitespaceEdit {
+  absl::string_view original;
+  std::string replacement;
+};
+
+// Formatting as edits: same as FormatVerilog() with TextStructureView, but
+// instead of the formatted text, returns the "edits" that turn the text of
+// "text_structure" into it, in text order.  Formatting only changes the
+// whitespace between tokens, so the edits are made directly from the
+// spacing decisions, each without the parts of the original whitespace it
+// keeps.  Editors need only apply these instead of replacing the whole text.
+absl::Status FormatVerilogEdits(
+    const verible::TextStructureView& text_structure,
+    absl::string_view filename, const FormatStyle& style,
+    std::vector<WhitespaceEdit>* edits,
+    const verible::LineNumberSet& lines = {},
+    const ExecutionControl& control = {});
+
+// Returns "text" with "edits" in text order applied.
+std::string ApplyWhitespaceEdits(absl::string_view text,
+                                 const std::vector<WhitespaceEdit>& edits);
+
 // Format only lines in line_range interval [min, max) in "full_content"
 // using "style". Emits _only_ the formatted code in the range
 // to "formatted_stream".
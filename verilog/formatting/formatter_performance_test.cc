@@ -0,0 +1,96 @@
+// Copyright 2017-2023 The Verible Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// Pathological inputs to the formatter, which have to be formatted within a
+// time and memory budget, to catch complexity regressions.
+
+#include <cstdint>
+#include <string>
+
+#include "absl/status/status.h"
+#include "absl/strings/str_cat.h"
+#include "absl/time/time.h"
+#include "common/util/resource_budget_test_util.h"
+#include "gtest/gtest.h"
+#include "verilog/formatting/format_style.h"
+#include "verilog/formatting/formatter.h"
+
+namespace verilog {
+namespace formatter {
+namespace {
+
+using verible::testing::MeasureResourceUsage;
+using verible::testing::ResourceBudget;
+using verible::testing::WithinBudget;
+
+constexpr int64_t kMiB = 1 << 20;
+
+void ExpectFormattedWithinBudget(const std::string& code,
+                                 const ResourceBudget& budget) {
+  const FormatStyle style;
+  std::string formatted;
+  absl::Status status;
+  const auto usage = MeasureResourceUsage([&]() {
+    status = FormatVerilog(code, "<filename>", style, &formatted);
+  });
+  EXPECT_TRUE(status.ok()) << status;
+  EXPECT_FALSE(formatted.empty());
+  EXPECT_TRUE(WithinBudget(usage, budget));
+}
+
+// Line wrap search of an expression nested deeply in parentheses.
+TEST(FormatterPerformanceTest, DeeplyNestedExpression) {
+  std::string expression = "a";
+  for (int i = 0; i < 100; ++i) {
+    expression = absl::StrCat("(", expression, " + b", i, ")");
+  }
+  ExpectFormattedWithinBudget(
+      absl::StrCat("module m;\n  assign x = ", expression, ";\nendmodule\n"),
+      {absl::Seconds(5), 256 * kMiB});
+}
+
+// Line wrap search of a long flat expression, wrapped many times.
+TEST(FormatterPerformanceTest, LongExpression) {
+  std::string expression = "a";
+  for (int i = 0; i < 1000; ++i) absl::StrAppend(&expression, " + b", i);
+  ExpectFormattedWithinBudget(
+      absl::StrCat("module m;\n  assign x = ", expression, ";\nendmodule\n"),
+      {absl::Seconds(5), 256 * kMiB});
+}
+
+// Alignment of a group of 5000 rows.
+TEST(FormatterPerformanceTest, LargeAlignmentGroup) {
+  std::string code = "module m;\n";
+  for (int i = 0; i < 5000; ++i) {
+    absl::StrAppend(&code, "logic [", i % 64, ":0] signal_", i, " = ", i,
+                    ";\n");
+  }
+  absl::StrAppend(&code, "endmodule\n");
+  ExpectFormattedWithinBudget(code, {absl::Seconds(10), 512 * kMiB});
+}
+
+// Alignment of 5000 ports of a module.
+TEST(FormatterPerformanceTest, LargePortAlignmentGroup) {
+  std::string code = "module m (\n";
+  for (int i = 0; i < 5000; ++i) {
+    absl::StrAppend(&code, i % 2 ? "input" : "output", " logic [", i % 64,
+                    ":0] port_", i, ",\n");
+  }
+  absl::StrAppend(&code, "input last\n);\nendmodule\n");
+  ExpectFormattedWithinBudget(code, {absl::Seconds(10), 512 * kMiB});
+}
+
+}  // namespace
+}  // namespace formatter
+}  // namespace verilog
@@ -20,12 +20,14 @@
 
 #include "verilog/formatting/formatter.h"
 
+#include <algorithm>
 #include <memory>
 #include <sstream>
 #include <string>
 #include <vector>
 
 #include "absl/status/status.h"
+#include "absl/strings/ascii.h"
 #include "absl/strings/match.h"
 #include "absl/strings/string_view.h"
 #include "common/formatting/align.h"
@@ -35,6 +37,7 @@
 #include "common/util/logging.h"
 #include "gmock/gmock.h"
 #include "gtest/gtest.h"
+#include "nlohmann/json.hpp"
 #include "verilog/analysis/verilog_analyzer.h"
 #include "verilog/formatting/format_style.h"
 
@@ -50,7 +53,7 @@ namespace formatter {
 // private, extern function in formatter.cc, directly tested here.
 absl::Status VerifyFormatting(const verible::TextStructureView& text_structure,
                               absl::string_view formatted_output,
-                              absl::string_view filename);
+                              absl::string_view filename, bool fast);
 
 namespace {
 
@@ -68,8 +71,11 @@ TEST(VerifyFormattingTest, NoError) {
   const std::unique_ptr<VerilogAnalyzer> analyzer =
       VerilogAnalyzer::AnalyzeAutomaticMode(code, "<file>", kDefaultPreprocess);
   const auto& text_structure = ABSL_DIE_IF_NULL(analyzer)->Data();
-  const auto status = VerifyFormatting(text_structure, code, "<filename>");
-  EXPECT_OK(status);
+  for (const bool fast : {false, true}) {
+    const auto status =
+        VerifyFormatting(text_structure, code, "<filename>", fast);
+    EXPECT_OK(status);
+  }
 }
 
 // Tests that un-lexable outputs are caught as errors.
@@ -79,9 +85,12 @@ TEST(VerifyFormattingTest, LexError) {
       VerilogAnalyzer::AnalyzeAutomaticMode(code, "<file>", kDefaultPreprocess);
   const auto& text_structure = ABSL_DIE_IF_NULL(analyzer)->Data();
   const absl::string_view bad_code("1class c;endclass\n");  // lexical error
-  const auto status = VerifyFormatting(text_structure, bad_code, "<filename>");
-  EXPECT_FALSE(status.ok());
-  EXPECT_EQ(status.code(), StatusCode::kDataLoss);
+  for (const bool fast : {false, true}) {
+    const auto status =
+        VerifyFormatting(text_structure, bad_code, "<filename>", fast);
+    EXPECT_FALSE(status.ok());
+    EXPECT_EQ(status.code(), StatusCode::kDataLoss);
+  }
 }
 
 // Tests that un-parseable outputs are caught as errors.
@@ -91,9 +100,12 @@ TEST(VerifyFormattingTest, ParseError) {
       VerilogAnalyzer::AnalyzeAutomaticMode(code, "<file>", kDefaultPreprocess);
   const auto& text_structure = ABSL_DIE_IF_NULL(analyzer)->Data();
   const absl::string_view bad_code("classc;endclass\n");  // syntax error
-  const auto status = VerifyFormatting(text_structure, bad_code, "<filename>");
-  EXPECT_FALSE(status.ok());
-  EXPECT_EQ(status.code(), StatusCode::kDataLoss);
+  for (const bool fast : {false, true}) {
+    const auto status =
+        VerifyFormatting(text_structure, bad_code, "<filename>", fast);
+    EXPECT_FALSE(status.ok());
+    EXPECT_EQ(status.code(), StatusCode::kDataLoss);
+  }
 }
 
 // Tests that lexical differences are caught as errors.
@@ -103,9 +115,12 @@ TEST(VerifyFormattingTest, LexicalDifference) {
       VerilogAnalyzer::AnalyzeAutomaticMode(code, "<file>", kDefaultPreprocess);
   const auto& text_structure = ABSL_DIE_IF_NULL(analyzer)->Data();
   const absl::string_view bad_code("class c;;endclass\n");  // different tokens
-  const auto status = VerifyFormatting(text_structure, bad_code, "<filename>");
-  EXPECT_FALSE(status.ok());
-  EXPECT_EQ(status.code(), StatusCode::kDataLoss);
+  for (const bool fast : {false, true}) {
+    const auto status =
+        VerifyFormatting(text_structure, bad_code, "<filename>", fast);
+    EXPECT_FALSE(status.ok());
+    EXPECT_EQ(status.code(), StatusCode::kDataLoss);
+  }
 }
 
 struct FormatterTestCase {
@@ -15410,6 +15425,214 @@ TEST(FormatterEndToEndTest, VerilogFormatTest) {
   }
 }
 
+// Tests that searching line wraps in parallel yields the same results.
+TEST(FormatterEndToEndTest, VerilogFormatParallelLineWrapSearchTest) {
+  // Use a fixed style.
+  FormatStyle style;
+  style.column_limit = 40;
+  style.indentation_spaces = 2;
+  style.wrap_spaces = 4;
+  ExecutionControl control;
+  control.line_wrap_search_threads = 4;
+  for (const auto& test_case : kFormatterTestCases) {
+    std::ostringstream stream;
+    const auto status = FormatVerilog(test_case.input, "<filename>", style,
+                                      stream, kEnableAllLines, control);
+    EXPECT_OK(status) << status.message();
+    EXPECT_EQ(stream.str(), test_case.expected) << "code:\n" << test_case.input;
+  }
+}
+
+// Tests that calculating alignments in parallel yields the same results.
+TEST(FormatterEndToEndTest, VerilogFormatParallelAlignmentTest) {
+  // Use a fixed style.
+  FormatStyle style;
+  style.column_limit = 40;
+  style.indentation_spaces = 2;
+  style.wrap_spaces = 4;
+  ExecutionControl control;
+  control.alignment_threads = 4;
+  for (const auto& test_case : kFormatterTestCases) {
+    std::ostringstream stream;
+    const auto status = FormatVerilog(test_case.input, "<filename>", style,
+                                      stream, kEnableAllLines, control);
+    EXPECT_OK(status) << status.message();
+    EXPECT_EQ(stream.str(), test_case.expected) << "code:\n" << test_case.input;
+  }
+}
+
+// Tests that fast verification yields the same results.
+TEST(FormatterEndToEndTest, VerilogFormatFastVerificationTest) {
+  // Use a fixed style.
+  FormatStyle style;
+  style.column_limit = 40;
+  style.indentation_spaces = 2;
+  style.wrap_spaces = 4;
+  ExecutionControl control;
+  control.fast_verification = true;
+  for (const auto& test_case : kFormatterTestCases) {
+    std::ostringstream stream;
+    const auto status = FormatVerilog(test_case.input, "<filename>", style,
+                                      stream, kEnableAllLines, control);
+    EXPECT_OK(status) << status.message();
+    EXPECT_EQ(stream.str(), test_case.expected) << "code:\n" << test_case.input;
+  }
+}
+
+// Tests that formatting as edits yields the same results, only changing
+// whitespace.
+TEST(FormatterEndToEndTest, VerilogFormatEditsTest) {
+  // Use a fixed style.
+  FormatStyle style;
+  style.column_limit = 40;
+  style.indentation_spaces = 2;
+  style.wrap_spaces = 4;
+  const auto is_space = [](absl::string_view s) {
+    return std::all_of(s.begin(), s.end(), absl::ascii_isspace);
+  };
+  for (const auto& test_case : kFormatterTestCases) {
+    const std::unique_ptr<VerilogAnalyzer> analyzer =
+        VerilogAnalyzer::AnalyzeAutomaticMode(test_case.input, "<file>",
+                                              kDefaultPreprocess);
+    std::vector<WhitespaceEdit> edits;
+    const auto status = FormatVerilogEdits(ABSL_DIE_IF_NULL(analyzer)->Data(),
+                                           "<filename>", style, &edits);
+    EXPECT_OK(status) << status.message();
+    EXPECT_EQ(ApplyWhitespaceEdits(test_case.input, edits), test_case.expected)
+        << "code:\n"
+        << test_case.input;
+    for (const WhitespaceEdit& edit : edits) {
+      EXPECT_TRUE(is_space(edit.original) && is_space(edit.replacement))
+          << "code:\n"
+          << test_case.input;
+    }
+  }
+}
+
+TEST(FormatterEndToEndTest, EditsOnlyWhereWhitespaceChanges) {
+  const absl::string_view code = "module m;\nwire  w;\nendmodule\n";
+  const std::unique_ptr<VerilogAnalyzer> analyzer =
+      VerilogAnalyzer::AnalyzeAutomaticMode(code, "<file>", kDefaultPreprocess);
+  std::vector<WhitespaceEdit> edits;
+  EXPECT_OK(FormatVerilogEdits(ABSL_DIE_IF_NULL(analyzer)->Data(),
+                               "<filename>", FormatStyle(), &edits));
+  // Indentation is inserted, one of the two spaces removed.
+  ASSERT_EQ(edits.size(), 2);
+  EXPECT_EQ(edits[0].original.data(), code.data() + 10);
+  EXPECT_EQ(edits[0].original, "");
+  EXPECT_EQ(edits[0].replacement, "  ");
+  EXPECT_EQ(edits[1].original, " ");
+  EXPECT_EQ(edits[1].replacement, "");
+  EXPECT_EQ(ApplyWhitespaceEdits(code, edits),
+            "module m;\n  wire w;\nendmodule\n");
+}
+
+// Tests that formatting with cached items yields the same results.
+TEST(FormatterEndToEndTest, VerilogFormatItemCacheTest) {
+  // Use a fixed style.
+  FormatStyle style;
+  style.column_limit = 40;
+  style.indentation_spaces = 2;
+  style.wrap_spaces = 4;
+  FormattedItemCache cache;
+  ExecutionControl control;
+  control.formatted_item_cache = &cache;
+  for (const auto& test_case : kFormatterTestCases) {
+    // The second time, items are found in the cache.
+    for (int i = 0; i < 2; ++i) {
+      std::ostringstream stream;
+      const auto status = FormatVerilog(test_case.input, "<filename>", style,
+                                        stream, kEnableAllLines, control);
+      EXPECT_OK(status) << status.message();
+      EXPECT_EQ(stream.str(), test_case.expected)
+          << "code:\n"
+          << test_case.input;
+    }
+  }
+  EXPECT_GT(cache.hits(), 0);
+}
+
+TEST(FormatterEndToEndTest, ItemCacheFormatsEditedItems) {
+  FormatStyle style;
+  style.column_limit = 40;
+  FormattedItemCache cache;
+  ExecutionControl control;
+  control.verify_convergence = false;
+  control.formatted_item_cache = &cache;
+  const auto format = [&](absl::string_view code, const ExecutionControl& c) {
+    std::ostringstream stream;
+    const auto status = FormatVerilog(code, "<filename>", style, stream,
+                                      kEnableAllLines, c);
+    EXPECT_OK(status) << status.message();
+    return stream.str();
+  };
+
+  EXPECT_EQ(format("module m;wire  w;endmodule\nmodule n;endmodule\n", control),
+            "module m;\n"
+            "  wire w;\n"
+            "endmodule\n"
+            "module n;\n"
+            "endmodule\n");
+  EXPECT_EQ(cache.hits(), 0);
+  EXPECT_EQ(cache.size(), 2);
+
+  // Only the unchanged first module is found in the cache.
+  const absl::string_view edited =
+      "module m;wire  w;endmodule\nmodule n;assign a=b;endmodule\n";
+  EXPECT_EQ(format(edited, control), format(edited, {}));
+  EXPECT_EQ(cache.hits(), 1);
+  EXPECT_EQ(cache.size(), 3);
+
+  // Changing the style drops all cached items.
+  style.indentation_spaces = 4;
+  EXPECT_EQ(format(edited, control), format(edited, {}));
+  EXPECT_EQ(cache.hits(), 1);
+  EXPECT_EQ(cache.size(), 2);
+}
+
+TEST(FormatterEndToEndTest, ConvergenceCheckReusesUnchangedItems) {
+  FormatStyle style;
+  style.column_limit = 40;
+  FormattedItemCache cache;
+  ExecutionControl control;
+  control.formatted_item_cache = &cache;
+  constexpr absl::string_view code =
+      "module m;\n  wire w;\nendmodule\nmodule n;wire  w;endmodule\n";
+  std::ostringstream stream;
+  const auto status = FormatVerilog(code, "<filename>", style, stream,
+                                    kEnableAllLines, control);
+  EXPECT_OK(status) << status.message();
+  EXPECT_EQ(stream.str(),
+            "module m;\n"
+            "  wire w;\n"
+            "endmodule\n"
+            "module n;\n"
+            "  wire w;\n"
+            "endmodule\n");
+  // Only the module that formatting changed is formatted again to verify
+  // convergence; the other one is found in the cache.
+  EXPECT_EQ(cache.hits(), 1);
+  EXPECT_EQ(cache.size(), 3);
+}
+
+// Tests that concurrent annotation yields the same results.
+TEST(FormatterEndToEndTest, VerilogFormatConcurrentAnnotationTest) {
+  // Use a fixed style.
+  FormatStyle style;
+  style.column_limit = 40;
+  style.indentation_spaces = 2;
+  style.wrap_spaces = 4;
+  ExecutionControl control;
+  control.concurrent_annotation = true;
+  for (const auto& test_case : kFormatterTestCases) {
+    std::ostringstream stream;
+    const auto status = FormatVerilog(test_case.input, "<filename>", style,
+                                      stream, kEnableAllLines, control);
+    EXPECT_OK(status) << status.message();
+    EXPECT_EQ(stream.str(), test_case.expected) << "code:\n" << test_case.input;
+  }
+}
+
 TEST(FormatterEndToEndTest, AutoInferAlignment) {
   static constexpr FormatterTestCase kTestCases[] = {
       {"", ""},
@@ -17193,6 +17416,18 @@ TEST(FormatterEndToEndTest, SelectLines) {
     EXPECT_EQ(stream.str(), test_case.expected)
         << "code:\n"
         << test_case.input << "\nlines: " << test_case.lines;
+
+    // Formatting as edits leaves the lines that are not selected alone, too.
+    const std::unique_ptr<VerilogAnalyzer> analyzer =
+        VerilogAnalyzer::AnalyzeAutomaticMode(test_case.input, "<file>",
+                                              kDefaultPreprocess);
+    std::vector<WhitespaceEdit> edits;
+    EXPECT_OK(FormatVerilogEdits(ABSL_DIE_IF_NULL(analyzer)->Data(),
+                                 "<filename>", style, &edits,
+                                 test_case.lines));
+    EXPECT_EQ(ApplyWhitespaceEdits(test_case.input, edits), test_case.expected)
+        << "code:\n"
+        << test_case.input << "\nlines: " << test_case.lines;
   }
 }
 
@@ -17815,6 +18050,81 @@ TEST(FormatterEndToEndTest, DiagnosticEquallyOptimalWrappings) {
   }
 }
 
+TEST(FormatterEndToEndTest, DiagnosticStageTimings) {
+  FormatStyle style;
+  std::ostringstream stream, debug_stream;
+  ExecutionControl control;
+  control.stream = &debug_stream;
+  control.show_stage_timings = true;
+  control.concurrent_annotation = true;
+  const auto status = FormatVerilog("module m;endmodule\n", "<filename>",
+                                    style, stream, kEnableAllLines, control);
+  EXPECT_OK(status) << status.message();
+  EXPECT_EQ(stream.str(), "module m;\nendmodule\n");
+  EXPECT_TRUE(absl::StartsWith(debug_stream.str(), "Formatter stage timings:"))
+      << "got: " << debug_stream.str();
+  for (absl::string_view stage :
+       {"annotate", "disable-ranges", "unwrap", "line-wrap-search"}) {
+    EXPECT_TRUE(absl::StrContains(debug_stream.str(), stage)) << stage;
+  }
+}
+
+TEST(FormatterEndToEndTest, CancelledBetweenStages) {
+  FormatStyle style;
+  for (int stages : {0, 1, 2, 3}) {
+    int checks = 0;
+    ExecutionControl control;
+    control.is_cancelled = [&]() { return checks++ == stages; };
+    std::ostringstream stream;
+    const auto status = FormatVerilog("module m;endmodule\n", "<filename>",
+                                      style, stream, kEnableAllLines, control);
+    EXPECT_EQ(status.code(), StatusCode::kCancelled) << stages;
+    EXPECT_EQ(checks, stages + 1);
+  }
+
+  // Formatting completes, if it is not cancelled.
+  int checks = 0;
+  ExecutionControl control;
+  control.is_cancelled = [&]() { return ++checks > 100; };
+  std::ostringstream stream;
+  const auto status = FormatVerilog("module m;endmodule\n", "<filename>",
+                                    style, stream, kEnableAllLines, control);
+  EXPECT_OK(status) << status.message();
+  EXPECT_EQ(stream.str(), "module m;\nendmodule\n");
+  EXPECT_GT(checks, 0);
+}
+
+TEST(FormatterEndToEndTest, DiagnosticPartitionCosts) {
+  FormatStyle style;
+  style.column_limit = 40;
+  std::ostringstream stream, debug_stream;
+  ExecutionControl control;
+  control.stream = &debug_stream;
+  control.show_partition_costs = true;
+  const auto status =
+      FormatVerilog("module m;\nassign foo = bar + baz;\nendmodule\n",
+                    "<filename>", style, stream, kEnableAllLines, control);
+  EXPECT_OK(status) << status.message();
+  EXPECT_EQ(stream.str(), "module m;\n  assign foo = bar + baz;\nendmodule\n");
+
+  // One report, for the formatting of the input.
+  const auto costs = nlohmann::json::parse(debug_stream.str());
+  ASSERT_TRUE(costs.contains("layout_optimizer")) << costs;
+  const auto& searches = costs["line_wrap_search"];
+  ASSERT_FALSE(searches.empty()) << costs;
+  bool found_assignment = false;
+  for (const auto& search : searches) {
+    EXPECT_GT(search["explored_states"], 0) << search;
+    EXPECT_FALSE(search["search_limit_reached"]) << search;
+    // Locations are in the input.
+    if (search["line"] == 2) {
+      EXPECT_EQ(search["column"], 1) << search;
+      found_assignment = true;
+    }
+  }
+  EXPECT_TRUE(found_assignment) << costs;
+}
+
 // Test that hitting search space limit results in correct error status.
 TEST(FormatterEndToEndTest, UnfinishedLineWrapSearching) {
   FormatStyle style;
@@ -17834,6 +18144,29 @@ TEST(FormatterEndToEndTest, UnfinishedLineWrapSearching) {
   EXPECT_TRUE(absl::StartsWith(status.message(), "***"));
 }
 
+// Test that lines outside of the selected ones are not searched for line
+// wrappings, so they can't exhaust the search space.
+TEST(FormatterEndToEndTest, NoLineWrapSearchingOutsideSelectedLines) {
+  FormatStyle style;
+  style.column_limit = 40;
+  style.indentation_spaces = 2;
+  style.wrap_spaces = 4;
+
+  const absl::string_view code(
+      "parameter int x = 1+1;\n"
+      "\n"
+      "parameter int y = 1+1;\n");
+
+  std::ostringstream stream, debug_stream;
+  ExecutionControl control;
+  control.max_search_states = 2;  // Would abort the search of any line.
+  control.stream = &debug_stream;
+  const auto status =
+      FormatVerilog(code, "<filename>", style, stream, {{2, 3}}, control);
+  EXPECT_OK(status) << status.message();
+  EXPECT_EQ(stream.str(), code);
+}
+
 static constexpr FormatterTestCase kOnelineFormatBaselineTestCases[] = {
     // Reference - following test cases should not be affected by the switch
     {// Minimal useful case
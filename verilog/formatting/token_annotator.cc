@@ -14,6 +14,9 @@
 
 #include "verilog/formatting/token_annotator.h"
 
+#include <array>
+#include <cstddef>
+#include <cstdint>
 #include <iterator>
 #include <vector>
 
@@ -24,6 +27,7 @@
 #include "common/text/syntax_tree_context.h"
 #include "common/text/text_structure.h"
 #include "common/text/token_info.h"
+#include "common/util/iterator_adaptors.h"
 #include "common/util/iterator_range.h"
 #include "common/util/logging.h"
 #include "common/util/with_reason.h"
@@ -47,11 +51,85 @@ using FTT = FormatTokenType;
 // This value must be negative.
 static constexpr int kUnhandledSpacesRequired = -1;
 
+// Questions that the spacing and line-breaking rules ask about the syntax tree
+// context of a token.  Each one is answered by the innermost enclosing node
+// that is relevant to it, like SyntaxTreeContext::IsInsideFirst().
+enum ContextQuery : uint8_t {
+  // Inside [packed] or [unpacked] declared dimensions.
+  kInDeclaredDimensions = 1 << 0,
+  // Inside an index, range, slice or cycle delay range.
+  kInRangeLikeContext = 1 << 1,
+  kInStreamingConcatenation = 1 << 2,
+  kInUnaryPrefixExpression = 1 << 3,
+  // Inside a unary prefix expression, but not in a nested expression.
+  kInUnaryPrefixOperand = 1 << 4,
+  kInUdpEntry = 1 << 5,
+};
+
+constexpr uint8_t kAllContextQueries = (1 << 6) - 1;
+
+// How a node type answers ContextQuery questions.
+struct ContextQueryAnswers {
+  // Questions that are answered by this type of node.
+  uint8_t answered = 0;
+  // Subset of 'answered' where the answer is yes.
+  uint8_t yes = 0;
+};
+
+constexpr size_t kNumNodeEnums = static_cast<size_t>(NodeEnum::kInvalidTag);
+
+static constexpr std::array<ContextQueryAnswers, kNumNodeEnums>
+MakeContextQueryTable() {
+  std::array<ContextQueryAnswers, kNumNodeEnums> table{};
+  const auto answer = [&table](NodeEnum node, uint8_t query, bool yes) {
+    ContextQueryAnswers& answers = table[static_cast<size_t>(node)];
+    answers.answered |= query;
+    if (yes) answers.yes |= query;
+  };
+  answer(NodeEnum::kPackedDimensions, kInDeclaredDimensions, true);
+  answer(NodeEnum::kUnpackedDimensions, kInDeclaredDimensions, true);
+  answer(NodeEnum::kDimensionScalar, kInRangeLikeContext, true);
+  answer(NodeEnum::kDimensionRange, kInRangeLikeContext, true);
+  answer(NodeEnum::kDimensionSlice, kInRangeLikeContext, true);
+  answer(NodeEnum::kCycleDelayRange, kInRangeLikeContext, true);
+  answer(NodeEnum::kStreamingConcatenation, kInStreamingConcatenation, true);
+  answer(NodeEnum::kUnaryPrefixExpression, kInUnaryPrefixExpression, true);
+  answer(NodeEnum::kUnaryPrefixExpression, kInUnaryPrefixOperand, true);
+  answer(NodeEnum::kExpression, kInUnaryPrefixOperand, false);
+  answer(NodeEnum::kUdpCombEntry, kInUdpEntry, true);
+  answer(NodeEnum::kUdpSequenceEntry, kInUdpEntry, true);
+  return table;
+}
+
+static constexpr auto kContextQueryTable = MakeContextQueryTable();
+
+// Answers to all ContextQuery questions about one context, from a single walk
+// up the context, instead of one walk per question.
+class ContextQueries {
+ public:
+  explicit ContextQueries(const SyntaxTreeContext& context) {
+    uint8_t answered = 0;
+    for (const auto* node : verible::reversed_view(context)) {
+      const size_t tag = node->Tag().tag;
+      if (tag >= kNumNodeEnums) continue;
+      const ContextQueryAnswers& answers = kContextQueryTable[tag];
+      const uint8_t new_answers = answers.answered & ~answered;
+      yes_ |= answers.yes & new_answers;
+      answered |= new_answers;
+      if (answered == kAllContextQueries) break;
+    }
+  }
+
+  bool Is(ContextQuery query) const { return (yes_ & query) != 0; }
+
+ private:
+  uint8_t yes_ = 0;
+};
+
 static bool IsUnaryPrefixExpressionOperand(const PreFormatToken& left,
-                                           const SyntaxTreeContext& context) {
+                                           const ContextQueries& context) {
   return (IsUnaryOperator(verilog_tokentype(left.TokenEnum())) &&
-          context.IsInsideFirst({NodeEnum::kUnaryPrefixExpression},
-                                {NodeEnum::kExpression})) ||
+          context.Is(kInUnaryPrefixOperand)) ||
          // Treat '##' like a unary prefix operator.
          left.TokenEnum() == verilog_tokentype::TK_POUNDPOUND;
 }
@@ -106,18 +184,6 @@ static bool PairwiseNonmergeable(const PreFormatToken& ftoken) {
          ftoken.format_token_enum == FormatTokenType::keyword;
 }
 
-static bool InDeclaredDimensions(const SyntaxTreeContext& context) {
-  return context.IsInsideFirst(
-      {NodeEnum::kPackedDimensions, NodeEnum::kUnpackedDimensions}, {});
-}
-
-static bool InRangeLikeContext(const SyntaxTreeContext& context) {
-  return context.IsInsideFirst(
-      {NodeEnum::kDimensionScalar, NodeEnum::kDimensionRange,
-       NodeEnum::kDimensionSlice, NodeEnum::kCycleDelayRange},
-      {});
-}
-
 static bool IsAnySemicolon(const PreFormatToken& ftoken) {
   // These are just syntactically disambiguated versions of ';'.
   return ftoken.TokenEnum() == ';' ||
@@ -131,7 +197,8 @@ static bool IsAnySemicolon(const PreFormatToken& ftoken) {
 static WithReason<int> SpacesRequiredBetween(
     const PreFormatToken& left, const PreFormatToken& right,
     const SyntaxTreeContext& left_context,
-    const SyntaxTreeContext& right_context, const FormatStyle& style) {
+    const SyntaxTreeContext& right_context,
+    const ContextQueries& right_queries, const FormatStyle& style) {
   VLOG(3) << "Spacing between " << verilog_symbol_name(left.TokenEnum())
           << " and " << verilog_symbol_name(right.TokenEnum());
   // Higher precedence rules should be handled earlier in this function.
@@ -161,7 +228,7 @@ static WithReason<int> SpacesRequiredBetween(
   }
 
   // For now, leave everything inside [dimensions] alone.
-  if (InDeclaredDimensions(right_context)) {
+  if (right_queries.Is(kInDeclaredDimensions)) {
     // ... except for the spacing before '[' and around ':',
     // which are covered elsewhere.
     if (right.TokenEnum() != '[' && left.TokenEnum() != ':' &&
@@ -173,7 +240,7 @@ static WithReason<int> SpacesRequiredBetween(
   }
 
   // Unary operators (context-sensitive)
-  if (IsUnaryPrefixExpressionOperand(left, right_context) &&
+  if (IsUnaryPrefixExpressionOperand(left, right_queries) &&
       (left.format_token_enum != FormatTokenType::binary_operator ||
        !IsUnaryOperator(static_cast<verilog_tokentype>(right.TokenEnum())))) {
     // TODO: There are _some_ unary operators on the right that could
@@ -204,7 +271,7 @@ static WithReason<int> SpacesRequiredBetween(
     return {1, "Space between return keyword and return value"};
   }
 
-  if (right_context.IsInsideFirst({NodeEnum::kStreamingConcatenation}, {})) {
+  if (right_queries.Is(kInStreamingConcatenation)) {
     if (left.TokenEnum() == TK_LS || left.TokenEnum() == TK_RS) {
       return {0, "No space around streaming operators"};
     }
@@ -225,7 +292,7 @@ static WithReason<int> SpacesRequiredBetween(
   }
 
   // Do not force space between '^' and '{' operators
-  if (right_context.IsInsideFirst({NodeEnum::kUnaryPrefixExpression}, {})) {
+  if (right_queries.Is(kInUnaryPrefixExpression)) {
     if (IsUnaryOperator(static_cast<verilog_tokentype>(left.TokenEnum())) &&
         right.TokenEnum() == '{') {
       return {0, "No space between unary and concatenation operators"};
@@ -240,9 +307,9 @@ static WithReason<int> SpacesRequiredBetween(
     // Inside [], allows 0 or 1 spaces, and symmetrize.
     // TODO(fangism): make this behavior configurable
     if (right.format_token_enum == FormatTokenType::binary_operator &&
-        InRangeLikeContext(right_context)) {
+        right_queries.Is(kInRangeLikeContext)) {
       if (style.compact_indexing_and_selections &&
-          !InDeclaredDimensions(right_context)) {
+          !right_queries.Is(kInDeclaredDimensions)) {
         return {0,
                 "Compact binary expressions inside indexing / bit selection "
                 "operator []"};
@@ -255,7 +322,7 @@ static WithReason<int> SpacesRequiredBetween(
       return {spaces, "Limit <= 1 space before binary operator inside []."};
     }
     if (left.format_token_enum == FormatTokenType::binary_operator &&
-        InRangeLikeContext(left_context)) {
+        ContextQueries(left_context).Is(kInRangeLikeContext)) {
       return {left.before.spaces_required,
               "Symmetrize spaces before and after binary operator inside []."};
     }
@@ -275,8 +342,7 @@ static WithReason<int> SpacesRequiredBetween(
     return {0, "No space inside based numeric literals"};
   }
 
-  if (right_context.IsInsideFirst(
-          {NodeEnum::kUdpCombEntry, NodeEnum::kUdpSequenceEntry}, {})) {
+  if (right_queries.Is(kInUdpEntry)) {
     // Spacing before ';' is handled above
     return {1, "One space around UDP entries"};
   }
@@ -331,7 +397,7 @@ static WithReason<int> SpacesRequiredBetween(
 
   if (left.TokenEnum() == ':') {
     // Spacing in ranges
-    if (InRangeLikeContext(right_context)) {
+    if (right_queries.Is(kInRangeLikeContext)) {
       // Take advantage here that the left token was already annotated (above)
       return {left.before.spaces_required,
               "Symmetrize spaces before and after ':' in bit slice"};
@@ -363,7 +429,8 @@ static WithReason<int> SpacesRequiredBetween(
     if (left.TokenEnum() == ')') {
       return {1, "Space betwen ')' and '{', e.g. conditional constraint."};
     }
-    if (left.TokenEnum() == ']' && InDeclaredDimensions(left_context)) {
+    if (left.TokenEnum() == ']' &&
+        ContextQueries(left_context).Is(kInDeclaredDimensions)) {
       return {1, "Space between declared array type and '{' (e.g. in typedef)"};
     }
     return {0, "No space before '{' in most other contexts."};
@@ -433,7 +500,7 @@ static WithReason<int> SpacesRequiredBetween(
     }
 
     // Spacing in ranges
-    if (InRangeLikeContext(right_context)) {
+    if (right_queries.Is(kInRangeLikeContext)) {
       int spaces = right.OriginalLeadingSpaces().length();
       if (spaces > 1) {
         spaces = 1;
@@ -567,11 +634,12 @@ struct SpacePolicy {
 static SpacePolicy SpacesRequiredBetween(
     const FormatStyle& style, const PreFormatToken& left,
     const PreFormatToken& right, const SyntaxTreeContext& left_context,
-    const SyntaxTreeContext& right_context) {
+    const SyntaxTreeContext& right_context,
+    const ContextQueries& right_queries) {
   // Default for unhandled cases, 1 space to be conservative.
   constexpr int kUnhandledSpacesDefault = 1;
-  const auto spaces =
-      SpacesRequiredBetween(left, right, left_context, right_context, style);
+  const auto spaces = SpacesRequiredBetween(
+      left, right, left_context, right_context, right_queries, style);
   VLOG(2) << "spaces: " << spaces.value << ", reason: " << spaces.reason;
 
   if (spaces.value == kUnhandledSpacesRequired) {
@@ -738,9 +806,10 @@ static WithReason<int> BreakPenaltyBetween(
 static WithReason<SpacingOptions> BreakDecisionBetween(
     const FormatStyle& style, const PreFormatToken& left,
     const PreFormatToken& right, const SyntaxTreeContext& left_context,
-    const SyntaxTreeContext& right_context) {
+    const SyntaxTreeContext& right_context,
+    const ContextQueries& right_queries) {
   // For now, leave everything inside [dimensions] alone.
-  if (InDeclaredDimensions(right_context)) {
+  if (right_queries.Is(kInDeclaredDimensions)) {
     // ... except for the spacing immediately around '[' and ']',
     // which is covered by other rules.
     if (left.TokenEnum() != '[' && left.TokenEnum() != ']' &&
@@ -824,7 +893,7 @@ static WithReason<SpacingOptions> BreakDecisionBetween(
 
   // Unary operators (context-sensitive)
   // For now, never separate unary prefix operators from their operands.
-  if (IsUnaryPrefixExpressionOperand(left, right_context)) {
+  if (IsUnaryPrefixExpressionOperand(left, right_queries)) {
     return {SpacingOptions::kMustAppend,
             "Never separate unary prefix operator from its operand"};
   }
@@ -928,8 +997,10 @@ void AnnotateFormatToken(const FormatStyle& style,
                          PreFormatToken* curr_token,
                          const SyntaxTreeContext& prev_context,
                          const SyntaxTreeContext& curr_context) {
-  const auto p = SpacesRequiredBetween(style, prev_token, *curr_token,
-                                       prev_context, curr_context);
+  const ContextQueries curr_queries(curr_context);
+  const auto p =
+      SpacesRequiredBetween(style, prev_token, *curr_token, prev_context,
+                            curr_context, curr_queries);
   curr_token->before.spaces_required = p.spaces_required;
   if (p.force_preserve_spaces) {
     // forego all inter-token calculations
@@ -940,8 +1011,9 @@ void AnnotateFormatToken(const FormatStyle& style,
     const auto break_penalty = BreakPenaltyBetween(prev_token, *curr_token,
                                                    prev_context, curr_context);
     curr_token->before.break_penalty = break_penalty.value;
-    const auto breaker = BreakDecisionBetween(style, prev_token, *curr_token,
-                                              prev_context, curr_context);
+    const auto breaker =
+        BreakDecisionBetween(style, prev_token, *curr_token, prev_context,
+                             curr_context, curr_queries);
     curr_token->before.break_decision = breaker.value;
     VLOG(3) << "line break constraint: " << breaker.value << ": "
             << breaker.reason;
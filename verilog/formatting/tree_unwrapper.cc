@@ -121,9 +121,8 @@ static PreFormatToken CreateFormatToken(const TokenInfo& token) {
 UnwrapperData::UnwrapperData(const verible::TokenSequence& tokens) {
   // Create a TokenStreamView that removes spaces, but preserves comments.
   {
-    verible::InitTokenStreamView(tokens, &tokens_view_no_whitespace);
-    verible::FilterTokenStreamViewInPlace(KeepNonWhitespace,
-                                          &tokens_view_no_whitespace);
+    verible::InitTokenStreamView(tokens, KeepNonWhitespace,
+                                 &tokens_view_no_whitespace);
   }
 
   // Create an array of PreFormatTokens.
@@ -296,15 +295,61 @@ void TreeUnwrapper::EatSpaces() {
           << " space tokens";
 }
 
+// Returns, for each token of 'tokens', the position that scanning forward up
+// to the next syntax tree leaf token (or EOF) stops at: the last newline
+// *before* that leaf token if there is one, otherwise the leaf token itself.
+// This allows prefix comments and attributes to stick with their
+// intended token that immediately follows.
+// All positions are found in one backward pass, so that looking ahead from
+// the same position repeatedly, like between the children of nested nodes,
+// does not scan the same comments again.
+static std::vector<verible::TokenSequence::const_iterator>
+StopsAtLastNewlineBeforeTreeLeaf(const verible::TokenSequence& tokens) {
+  std::vector<verible::TokenSequence::const_iterator> stops(tokens.size());
+  auto leaf = tokens.end();
+  auto last_newline = tokens.end();
+  for (auto token_iter = tokens.end(); token_iter != tokens.begin();) {
+    --token_iter;
+    bool is_leaf = token_iter->isEOF();
+    if (!is_leaf) {
+      switch (token_iter->token_enum()) {
+        // TODO(b/144653479): this token-case logic is redundant with other
+        // places; plumb that through to here instead of replicating it.
+        case TK_NEWLINE:
+          if (last_newline == tokens.end()) last_newline = token_iter;
+          break;
+        case TK_SPACE:
+        case TK_EOL_COMMENT:
+        case TK_COMMENT_BLOCK:
+        case TK_ATTRIBUTE:
+          break;
+        default:
+          is_leaf = true;
+          break;
+      }
+    }
+    if (is_leaf) {
+      leaf = token_iter;
+      last_newline = tokens.end();
+    }
+    stops[token_iter - tokens.begin()] =
+        last_newline != tokens.end() ? last_newline : leaf;
+  }
+  return stops;
+}
+
 TreeUnwrapper::TreeUnwrapper(const verible::TextStructureView& view,
                              const FormatStyle& style,
                              const preformatted_tokens_type& ftokens)
     : verible::TreeUnwrapper(view, ftokens),
       style_(style),
       inter_leaf_scanner_(new TokenScanner),
-      token_context_(FullText(), [](std::ostream& stream, int e) {
-        stream << verilog_symbol_name(e);
-      }) {
+      token_context_(FullText(),
+                     [](std::ostream& stream, int e) {
+                       stream << verilog_symbol_name(e);
+                     }),
+      unfiltered_tokens_begin_(view.TokenStream().begin()),
+      look_ahead_stops_(StopsAtLastNewlineBeforeTreeLeaf(view.TokenStream())) {
   // Verify that unfiltered token stream is properly EOF terminated,
   // so that stream scanners (inter_leaf_scanner_) know when to stop.
   const auto& tokens = view.TokenStream();
@@ -483,55 +528,13 @@ void TreeUnwrapper::LookAheadBeyondCurrentLeaf() {
   VLOG(4) << "end of " << __FUNCTION__;
 }
 
-// Scan forward up to a syntax tree leaf token, but return (possibly) the
-// position of the last newline *before* that leaf token.
-// This allows prefix comments and attributes to stick with their
-// intended token that immediately follows.
-static verible::TokenSequence::const_iterator StopAtLastNewlineBeforeTreeLeaf(
-    const verible::TokenSequence::const_iterator token_begin,
-    const TokenInfo::Context& context) {
-  VLOG(4) << __FUNCTION__;
-  auto token_iter = token_begin;
-  auto last_newline = token_begin;
-  bool have_last_newline = false;
-
-  // Find next syntax tree token or EOF.
-  bool break_while = false;
-  while (!token_iter->isEOF() && !break_while) {
-    VLOG(4) << "scan: " << TokenWithContext{*token_iter, context};
-    switch (token_iter->token_enum()) {
-      // TODO(b/144653479): this token-case logic is redundant with other
-      // places; plumb that through to here instead of replicating it.
-      case TK_NEWLINE:
-        have_last_newline = true;
-        last_newline = token_iter;
-        ABSL_FALLTHROUGH_INTENDED;
-      case TK_SPACE:
-      case TK_EOL_COMMENT:
-      case TK_COMMENT_BLOCK:
-      case TK_ATTRIBUTE:
-        ++token_iter;
-        break;
-      default:
-        break_while = true;
-        break;
-    }
-  }
-
-  const auto result = have_last_newline ? last_newline : token_iter;
-  VLOG(4) << "end of " << __FUNCTION__ << ", advanced "
-          << std::distance(token_begin, result) << " tokens";
-  return result;
-}
-
 // Scan forward for comments between leaf tokens, and append them to a partition
 // with the correct amount of indentation.
 void TreeUnwrapper::LookAheadBeyondCurrentNode() {
   VLOG(4) << __FUNCTION__;
   // Scan until token is reached, or the last newline before token is reached.
-  const auto token_begin = NextUnfilteredToken();
   const auto token_end =
-      StopAtLastNewlineBeforeTreeLeaf(token_begin, token_context_);
+      look_ahead_stops_[NextUnfilteredToken() - unfiltered_tokens_begin_];
   VLOG(4) << "stop before: " << VerboseToken(*token_end);
   while (NextUnfilteredToken() != token_end) {
     // Almost like AdvanceLastVisitedLeaf(), except suppress the last
@@ -155,6 +155,13 @@ class TreeUnwrapper final : public verible::TreeUnwrapper {
 
   // For debug printing.
   verible::TokenInfo::Context token_context_;
+
+  // Start of the unfiltered token stream, to index look_ahead_stops_.
+  verible::TokenSequence::const_iterator unfiltered_tokens_begin_;
+
+  // For each unfiltered token, where LookAheadBeyondCurrentNode() stops when
+  // it starts there, precomputed in one pass over the token stream.
+  std::vector<verible::TokenSequence::const_iterator> look_ahead_stops_;
 };
 
 }  // namespace formatter
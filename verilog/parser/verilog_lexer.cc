@@ -14,7 +14,14 @@
 
 #include "verilog/parser/verilog_lexer.h"
 
+#include <cstddef>
+#include <functional>
+#include <memory>
+#include <vector>
+
+#include "absl/strings/match.h"
 #include "absl/strings/string_view.h"
+#include "common/lexer/bulk_scan.h"
 #include "common/text/token_info.h"
 #include "verilog/parser/verilog_token_enum.h"
 
@@ -31,6 +38,37 @@ void VerilogLexer::Restart(absl::string_view code) {
   macro_arg_length_ = 0;
 }
 
+// Character classes of verilog.lex.
+static constexpr absl::string_view kSpaceChars(" \t\f\b");  // {Space}
+// Stops {InputCharacterNoBackslash} in an EOL comment.
+static constexpr absl::string_view kEndOfLineCommentStops("\\\r\n\0", 4);
+
+TokenInfo VerilogLexer::ScanBulkToken(absl::string_view text) {
+  const TokenInfo no_match(TK_OTHER, text.substr(0, 0));
+
+  // {Space}+
+  const size_t spaces = verible::SpanOfBytesIn(text, kSpaceChars);
+  if (spaces > 0) {
+    if (spaces == text.size()) return no_match;  // may continue
+    return TokenInfo(TK_SPACE, text.substr(0, spaces));
+  }
+
+  // {EndOfLineCommentStart} followed by the IN_EOL_COMMENT rules, for the
+  // usual comments that end with '\n'.
+  if (!absl::StartsWith(text, "//")) return no_match;
+  const absl::string_view body = text.substr(2);
+  const absl::string_view pragma =
+      body.substr(verible::SpanOfBytesIn(body, kSpaceChars));
+  if (absl::StartsWith(pragma, "pragma")) return no_match;  // {PragmaComment}
+  const size_t end =
+      2 + verible::SpanOfBytesNotIn(body, kEndOfLineCommentStops);
+  if (end == text.size()) return no_match;  // may continue
+  // Leave line continuations, '\r' (which may be part of "\r\n") and NUL to
+  // the rules.
+  if (text[end] != '\n') return no_match;
+  return TokenInfo(TK_EOL_COMMENT, text.substr(0, end));
+}
+
 bool VerilogLexer::TokenIsError(const TokenInfo& token) const {
   // TODO(fangism): Distinguish different lexical errors by returning different
   // enums.
@@ -52,11 +90,38 @@ bool VerilogLexer::KeepSyntaxTreeTokens(const TokenInfo& t) {
   }
 }
 
+// Maximum number of idle lexers kept per thread.  This bounds the memory held
+// by the pool, while covering the usual depth of nested borrows.
+static constexpr size_t kMaxIdleLexers = 8;
+
+static std::vector<std::unique_ptr<VerilogLexer>>& IdleLexers() {
+  static thread_local std::vector<std::unique_ptr<VerilogLexer>> lexers;
+  return lexers;
+}
+
+void VerilogLexerReturner::operator()(VerilogLexer* lexer) const {
+  auto& idle = IdleLexers();
+  if (idle.size() < kMaxIdleLexers) {
+    idle.emplace_back(lexer);
+  } else {
+    delete lexer;
+  }
+}
+
+BorrowedVerilogLexer BorrowVerilogLexer(absl::string_view code) {
+  auto& idle = IdleLexers();
+  if (idle.empty()) return BorrowedVerilogLexer(new VerilogLexer(code));
+  BorrowedVerilogLexer lexer(idle.back().release());
+  idle.pop_back();
+  lexer->Restart(code);
+  return lexer;
+}
+
 void RecursiveLexText(absl::string_view text,
                       const std::function<void(const TokenInfo&)>& func) {
-  VerilogLexer lexer(text);
+  const BorrowedVerilogLexer lexer(BorrowVerilogLexer(text));
   for (;;) {
-    const TokenInfo& subtoken(lexer.DoNextToken());
+    const TokenInfo& subtoken(lexer->DoNextToken());
     if (subtoken.isEOF()) break;
     func(subtoken);
   }
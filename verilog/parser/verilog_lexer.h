@@ -32,6 +32,9 @@
 #endif
 // clang-format on
 
+#include <functional>
+#include <memory>
+
 #include "absl/strings/string_view.h"
 
 namespace verilog {
@@ -55,6 +58,13 @@ class VerilogLexer : public verible::FlexLexerAdapter<verilogFlexLexer> {
   // Main lexing function. Will be defined by Flex.
   int yylex() final;
 
+  // Returns the token at the start of 'text' if it is a run of spaces or a
+  // plain '//' comment, and ends before the end of 'text'; returns a token
+  // with empty text otherwise.  The token is exactly what the flex rules of
+  // the INITIAL state would produce, but found with a bulk scan, which is much
+  // faster on long runs.  Called by yylex() on the buffered input.
+  static verible::TokenInfo ScanBulkToken(absl::string_view text);
+
   // These variables are controlled by the lexer code (verilog.lex).
 
   // for macro call argument lexing
@@ -69,6 +79,22 @@ class VerilogLexer : public verible::FlexLexerAdapter<verilogFlexLexer> {
   int macro_arg_length_ = 0;
 };
 
+// Deleter of BorrowedVerilogLexer: returns the lexer to the pool it came from.
+struct VerilogLexerReturner {
+  void operator()(VerilogLexer* lexer) const;
+};
+
+// A lexer borrowed from the per-thread pool, returned when this is destroyed.
+using BorrowedVerilogLexer =
+    std::unique_ptr<VerilogLexer, VerilogLexerReturner>;
+
+// Returns a lexer on 'code': an idle one from a per-thread pool, Restart()-ed
+// on 'code', or a new one if the pool is empty.
+// Callers that lex many small pieces of text (macro arguments and definitions,
+// recursively lexed tokens) should borrow instead of constructing a lexer for
+// each piece.  Borrows may nest; each gets its own lexer.
+BorrowedVerilogLexer BorrowVerilogLexer(absl::string_view code);
+
 // Recursively lex the given 'text', and apply 'func' to each subtoken.
 void RecursiveLexText(
     absl::string_view text,
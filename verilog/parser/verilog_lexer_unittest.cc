@@ -16,8 +16,11 @@
 #include "verilog/parser/verilog_lexer.h"
 
 #include <initializer_list>
+#include <string>
 #include <utility>
+#include <vector>
 
+#include "absl/strings/str_cat.h"
 #include "absl/strings/string_view.h"
 #include "common/lexer/lexer_test_util.h"
 #include "common/text/token_info.h"
@@ -74,6 +77,14 @@ static std::initializer_list<LexerTestData> kCommentTests = {
     {{TK_EOL_COMMENT, "// bar"}, {TK_NEWLINE, "\r"}},
     {{TK_EOL_COMMENT, "//"}},     // missing \n, but treat as if it were there
     {{TK_EOL_COMMENT, "//foo"}},  // missing \n, but treat as if it were there
+    {{TK_EOL_COMMENT, "// a comment longer than a few blocks of 16 bytes"},
+     {TK_NEWLINE, "\n"}},
+    {{TK_EOL_COMMENT, "// pragmatic"}, {TK_NEWLINE, "\n"}},
+    {{TK_SPACE, "                                      "},
+     {TK_EOL_COMMENT, "// foo"},
+     {TK_NEWLINE, "\n"},
+     {TK_SPACE, "\t\t\t\t\t\t\t\t\t\t\t\t\t\t\t\t\t\t"},
+     {TK_NEWLINE, "\n"}},
 };
 
 // treating attributes lists as C-style comments,
@@ -2345,6 +2356,36 @@ TEST(VerilogLexerTest, DirectivesUnfiltered) {
 }
 TEST(VerilogLexerTest, Library) { TestLexer(kLibraryTests); }
 
+// Lexes text that is longer than the lexer's input buffer, so that spaces and
+// comments straddle buffer boundaries.
+TEST(VerilogLexerTest, SpacesAndCommentsAcrossInputBuffers) {
+  constexpr int kLines = 2000;
+  std::string text;
+  for (int i = 0; i < kLines; ++i) {
+    absl::StrAppend(&text, std::string(1 + i % 37, ' '), "// comment ", i,
+                    "\nx;\n");
+  }
+  VerilogLexer lexer(text);
+  const char* expected_begin = text.data();
+  const auto expect_next = [&](int token_enum, absl::string_view expected) {
+    const TokenInfo& token = lexer.DoNextToken();
+    EXPECT_EQ(token.token_enum(), token_enum) << expected;
+    EXPECT_EQ(token.text(), expected);
+    EXPECT_EQ(token.text().data(), expected_begin);
+    expected_begin += token.text().length();
+  };
+  for (int i = 0; i < kLines; ++i) {
+    const std::string spaces(1 + i % 37, ' ');
+    expect_next(TK_SPACE, spaces);
+    expect_next(TK_EOL_COMMENT, absl::StrCat("// comment ", i));
+    expect_next(TK_NEWLINE, "\n");
+    expect_next(SymbolIdentifier, "x");
+    expect_next(';', ";");
+    expect_next(TK_NEWLINE, "\n");
+  }
+  EXPECT_TRUE(lexer.DoNextToken().isEOF());
+}
+
 TEST(RecursiveLexTextTest, Basic) {
   constexpr absl::string_view text("hello;");
   std::vector<TokenInfo> tokens;
@@ -2355,5 +2396,43 @@ TEST(RecursiveLexTextTest, Basic) {
                           TokenInfo(';', text.substr(5, 1))));
 }
 
+TEST(RecursiveLexTextTest, Nested) {
+  constexpr absl::string_view text("`FOO(a,b);");
+  std::vector<TokenInfo> tokens;
+  RecursiveLexText(text, [&tokens](const TokenInfo& t) {
+    if (t.token_enum() == MacroArg) {
+      // Lex the argument while the outer lexer is still borrowed.
+      RecursiveLexText(t.text(), [&tokens](const TokenInfo& subtoken) {
+        tokens.push_back(subtoken);
+      });
+    } else {
+      tokens.push_back(t);
+    }
+  });
+  EXPECT_THAT(tokens,
+              ElementsAre(TokenInfo(MacroCallId, text.substr(0, 4)),
+                          TokenInfo('(', text.substr(4, 1)),
+                          TokenInfo(SymbolIdentifier, text.substr(5, 1)),
+                          TokenInfo(',', text.substr(6, 1)),
+                          TokenInfo(SymbolIdentifier, text.substr(7, 1)),
+                          TokenInfo(')', text.substr(8, 1)),
+                          TokenInfo(';', text.substr(9, 1))));
+}
+
+TEST(BorrowVerilogLexerTest, ReusedLexerStartsFresh) {
+  constexpr absl::string_view first("`FOO(a");  // stops inside a macro call
+  {
+    const BorrowedVerilogLexer lexer(BorrowVerilogLexer(first));
+    lexer->DoNextToken();
+    lexer->DoNextToken();
+  }
+  constexpr absl::string_view second("b;");
+  const BorrowedVerilogLexer lexer(BorrowVerilogLexer(second));
+  EXPECT_EQ(lexer->DoNextToken(),
+            TokenInfo(SymbolIdentifier, second.substr(0, 1)));
+  EXPECT_EQ(lexer->DoNextToken(), TokenInfo(';', second.substr(1, 1)));
+  EXPECT_TRUE(lexer->DoNextToken().isEOF());
+}
+
 }  // namespace
 }  // namespace verilog
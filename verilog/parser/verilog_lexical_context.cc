@@ -17,7 +17,6 @@
 #include "verilog/parser/verilog_lexical_context.h"
 
 #include <iostream>
-#include <set>
 #include <stack>
 #include <vector>
 
@@ -33,19 +32,46 @@ using verible::WithReason;
 namespace internal {
 // Returns true for begin/end-like tokens that can be followed with an optional
 // label.
+// This is called on every token, so it is a switch (a jump table) rather than
+// a set lookup.
 // TODO(fangism): move this to verilog_token_classifications.cc
 static bool KeywordAcceptsOptionalLabel(int token_enum) {
-  static const auto* keywords = new std::set<int>(
-      {// begin-like keywords
-       TK_begin, TK_fork, TK_generate,
-       // end-like keywords
-       TK_end, TK_endgenerate, TK_endcase, TK_endconfig, TK_endfunction,
-       TK_endmodule, TK_endprimitive, TK_endspecify, TK_endtable, TK_endtask,
-       TK_endclass, TK_endclocking, TK_endgroup, TK_endinterface, TK_endpackage,
-       TK_endprogram, TK_endproperty, TK_endsequence, TK_endchecker,
-       TK_endconnectrules, TK_enddiscipline, TK_endnature, TK_endparamset,
-       TK_join, TK_join_any, TK_join_none});
-  return keywords->find(token_enum) != keywords->end();
+  switch (token_enum) {
+    // begin-like keywords
+    case TK_begin:
+    case TK_fork:
+    case TK_generate:
+    // end-like keywords
+    case TK_end:
+    case TK_endgenerate:
+    case TK_endcase:
+    case TK_endconfig:
+    case TK_endfunction:
+    case TK_endmodule:
+    case TK_endprimitive:
+    case TK_endspecify:
+    case TK_endtable:
+    case TK_endtask:
+    case TK_endclass:
+    case TK_endclocking:
+    case TK_endgroup:
+    case TK_endinterface:
+    case TK_endpackage:
+    case TK_endprogram:
+    case TK_endproperty:
+    case TK_endsequence:
+    case TK_endchecker:
+    case TK_endconnectrules:
+    case TK_enddiscipline:
+    case TK_endnature:
+    case TK_endparamset:
+    case TK_join:
+    case TK_join_any:
+    case TK_join_none:
+      return true;
+    default:
+      return false;
+  }
 }
 
 void KeywordLabelStateMachine::UpdateState(int token_enum) {
@@ -103,7 +103,8 @@ class ConstraintBlockStateMachine {
   // Constraint sets are nestable, so we need a stack.
   // Each level of this stack represents a level of constraint block or
   // constraint set, both of which are wrapped in { }.
-  std::stack<State> states_;
+  // Vector-based, so that dormant state machines allocate nothing.
+  std::stack<State, std::vector<State>> states_;
 };
 
 inline std::ostream& operator<<(std::ostream& os,
@@ -200,7 +201,8 @@ class LastSemicolonStateMachine {
   // Keeps track of the last semicolons.  Upon de-activation, the last
   // semicolon will be replaced.  Technically, we only need a two-slot queue,
   // but a CircularBuffer is overkill.
-  std::stack<verible::TokenInfo*> semicolons_;
+  std::stack<verible::TokenInfo*, std::vector<verible::TokenInfo*>>
+      semicolons_;
 
   // One token look-back.
   verible::TokenInfo* previous_token_ = nullptr;
@@ -137,6 +137,36 @@ TEST(KeywordLabelStateMachineTest, KeywordsWithoutLabels) {
   }
 }
 
+// Test that every begin/end-like keyword accepts a label, and no other one.
+TEST(KeywordLabelStateMachineTest, LabelableKeywords) {
+  constexpr int kLabelableKeywords[] = {
+      TK_begin,        TK_fork,         TK_generate,       TK_end,
+      TK_endgenerate,  TK_endcase,      TK_endconfig,      TK_endfunction,
+      TK_endmodule,    TK_endprimitive, TK_endspecify,     TK_endtable,
+      TK_endtask,      TK_endclass,     TK_endclocking,    TK_endgroup,
+      TK_endinterface, TK_endpackage,   TK_endprogram,     TK_endproperty,
+      TK_endsequence,  TK_endchecker,   TK_endconnectrules, TK_enddiscipline,
+      TK_endnature,    TK_endparamset,  TK_join,           TK_join_any,
+      TK_join_none,
+  };
+  for (const int keyword : kLabelableKeywords) {
+    internal::KeywordLabelStateMachine b;
+    b.UpdateState(SymbolIdentifier);
+    b.UpdateState(keyword);
+    EXPECT_TRUE(b.ItemMayStart()) << keyword;
+    b.UpdateState(':');
+    EXPECT_FALSE(b.ItemMayStart()) << keyword;
+    b.UpdateState(SymbolIdentifier);
+    EXPECT_TRUE(b.ItemMayStart()) << keyword;
+  }
+  for (const int token_enum : {TK_module, TK_if, TK_case, SymbolIdentifier}) {
+    internal::KeywordLabelStateMachine b;
+    b.UpdateState(SymbolIdentifier);
+    b.UpdateState(token_enum);
+    EXPECT_FALSE(b.ItemMayStart()) << token_enum;
+  }
+}
+
 // Test for state transitions of state machine, with labels.
 TEST(KeywordLabelStateMachineTest, KeywordsWithLabels) {
   VerilogAnalyzer analyzer("1 begin:a end:a begin:b end:b 2", "");
@@ -19,16 +19,21 @@
 #include <functional>
 #include <iterator>
 #include <memory>
+#include <set>
 #include <string>
 #include <utility>
 #include <vector>
 
 #include "absl/status/status.h"
+#include "absl/strings/ascii.h"
+#include "absl/strings/match.h"
 #include "absl/strings/str_cat.h"
 #include "absl/strings/string_view.h"
+#include "common/lexer/lexer.h"
 #include "common/lexer/token_generator.h"
 #include "common/lexer/token_stream_adapter.h"
 #include "common/text/macro_definition.h"
+#include "common/text/text_structure.h"
 #include "common/text/token_info.h"
 #include "common/text/token_stream_view.h"
 #include "common/util/container_util.h"
@@ -49,8 +54,27 @@ using verible::container::InsertOrUpdate;
 VerilogPreprocess::VerilogPreprocess(const Config& config)
     : VerilogPreprocess(config, nullptr) {}
 
+const VerilogIncludeCache::Entry* VerilogIncludeCache::Find(
+    absl::string_view key) const {
+  const auto found = entries_.find(key);
+  return found == entries_.end() ? nullptr : found->second.get();
+}
+
+const VerilogIncludeCache::Entry& VerilogIncludeCache::Insert(
+    absl::string_view key, Entry entry) {
+  auto& slot = entries_[std::string(key)];
+  slot = std::make_unique<Entry>(std::move(entry));
+  return *slot;
+}
+
 VerilogPreprocess::VerilogPreprocess(const Config& config, FileOpener opener)
-    : config_(config), file_opener_(std::move(opener)) {
+    : VerilogPreprocess(config, std::move(opener), nullptr) {}
+
+VerilogPreprocess::VerilogPreprocess(const Config& config, FileOpener opener,
+                                     VerilogIncludeCache* include_cache)
+    : config_(config),
+      file_opener_(std::move(opener)),
+      include_cache_(include_cache) {
   // To avoid having to check at every place if the stack is empty, we always
   // place a toplevel 'conditional' that is always selected.
   // Thus we only need to test in `else and `endif to see if we underrun due
@@ -333,13 +357,13 @@ void VerilogPreprocess::RegisterMacroDefinition(
 // as: preprocess_data_.lexed_macros_backup.back()
 absl::Status VerilogPreprocess::ExpandText(
     const absl::string_view& definition_text) {
-  VerilogLexer lexer(definition_text);
+  const BorrowedVerilogLexer lexer(BorrowVerilogLexer(definition_text));
   verible::TokenSequence lexed_sequence;
   verible::TokenSequence expanded_lexed_sequence;
   // Populating the lexed token sequence.
-  for (lexer.DoNextToken(); !lexer.GetLastToken().isEOF();
-       lexer.DoNextToken()) {
-    lexed_sequence.push_back(lexer.GetLastToken());
+  for (lexer->DoNextToken(); !lexer->GetLastToken().isEOF();
+       lexer->DoNextToken()) {
+    lexed_sequence.push_back(lexer->GetLastToken());
   }
   verible::TokenStreamView lexed_streamview;
   // Initializing the lexed token stream view.
@@ -352,7 +376,7 @@ absl::Status VerilogPreprocess::ExpandText(
   for (auto iter = iter_generator(); iter != end; iter = iter_generator()) {
     auto& last_token = **iter;
     // TODO: handle lexical error
-    if (lexer.GetLastToken().token_enum() == TK_SPACE) {
+    if (lexer->GetLastToken().token_enum() == TK_SPACE) {
       continue;  // don't forward spaces
     }
     // If the expanded token is another macro identifier that needs to be
@@ -374,6 +398,30 @@ absl::Status VerilogPreprocess::ExpandText(
   return absl::OkStatus();
 }
 
+const VerilogPreprocess::LexedMacroBody& VerilogPreprocess::GetLexedMacroBody(
+    const MacroDefinition& definition) {
+  const absl::string_view text = definition.DefinitionText().text();
+  auto& body = lexed_macro_bodies_[text.data()];
+  if (body != nullptr) return *body;
+
+  body = std::make_unique<LexedMacroBody>();
+  const BorrowedVerilogLexer lexer(BorrowVerilogLexer(text));
+  // Populating the lexed token sequence.
+  for (lexer->DoNextToken(); !lexer->GetLastToken().isEOF();
+       lexer->DoNextToken()) {
+    body->tokens.push_back(lexer->GetLastToken());
+  }
+  // Initializing the lexed token stream view.
+  InitTokenStreamView(body->tokens, &body->view);
+
+  body->parameter_positions.reserve(body->view.size());
+  for (const auto& token : body->view) {
+    body->parameter_positions.push_back(
+        definition.ParameterPosition(token->text()));
+  }
+  return *body;
+}
+
 // This method expands a callable macro call, that follows this form:
 // `MACRO([param1],[param2],...)
 absl::Status VerilogPreprocess::ExpandMacro(
@@ -381,23 +429,15 @@ absl::Status VerilogPreprocess::ExpandMacro(
     const verible::MacroDefinition* macro_definition) {
   const auto& actual_parameters = macro_call.positional_arguments;
 
-  std::map<absl::string_view, verible::DefaultTokenInfo> subs_map;
+  verible::MacroDefinition::substitution_array_type substitutions;
   if (macro_definition->IsCallable()) {
-    RETURN_IF_ERROR(macro_definition->PopulateSubstitutionMap(actual_parameters,
-                                                              &subs_map));
+    RETURN_IF_ERROR(macro_definition->PopulateSubstitutionArray(
+        actual_parameters, &substitutions));
   }
 
-  VerilogLexer lexer(macro_definition->DefinitionText().text());
-  verible::TokenSequence lexed_sequence;
+  const LexedMacroBody& body = GetLexedMacroBody(*macro_definition);
+  const TokenStreamView& lexed_streamview = body.view;
   verible::TokenSequence expanded_lexed_sequence;
-  // Populating the lexed token sequence.
-  for (lexer.DoNextToken(); !lexer.GetLastToken().isEOF();
-       lexer.DoNextToken()) {
-    lexed_sequence.push_back(lexer.GetLastToken());
-  }
-  verible::TokenStreamView lexed_streamview;
-  // Initializing the lexed token stream view.
-  InitTokenStreamView(lexed_sequence, &lexed_streamview);
 
   auto iter_generator = verible::MakeConstIteratorStreamer(lexed_streamview);
   const auto end = lexed_streamview.end();
@@ -420,16 +460,16 @@ absl::Status VerilogPreprocess::ExpandMacro(
       for (auto& u : expanded_child) expanded_lexed_sequence.push_back(u);
       continue;
     }
-    if (macro_definition->IsCallable()) {
-      // Check if the last token is a formal parameter
-      const auto* replacement = FindOrNull(subs_map, last_token.text());
-      if (replacement) {
-        RETURN_IF_ERROR(ExpandText(replacement->text()));
-        // merge the expanded macro tokens into 'expanded_lexed_sequence'
-        auto& expanded_child = preprocess_data_.lexed_macros_backup.back();
-        for (auto& u : expanded_child) expanded_lexed_sequence.push_back(u);
-        continue;
-      }
+    const int parameter_position =
+        body.parameter_positions[std::distance(lexed_streamview.begin(), iter)];
+    if (parameter_position >= 0 &&
+        parameter_position < static_cast<int>(substitutions.size())) {
+      // The last token is a formal parameter.
+      RETURN_IF_ERROR(ExpandText(substitutions[parameter_position].text()));
+      // merge the expanded macro tokens into 'expanded_lexed_sequence'
+      auto& expanded_child = preprocess_data_.lexed_macros_backup.back();
+      for (auto& u : expanded_child) expanded_lexed_sequence.push_back(u);
+      continue;
     }
     expanded_lexed_sequence.push_back(last_token);
   }
@@ -601,6 +641,18 @@ absl::Status VerilogPreprocess::HandleInclude(
   std::filesystem::path file_path =
       std::string(token_text.substr(1, token_text.size() - 2));
 
+  std::string cache_key;
+  if (include_cache_ != nullptr) {
+    cache_key = IncludeCacheKey(file_path.string());
+    if (const auto* cached = include_cache_->Find(cache_key)) {
+      // Forwarding the included preprocessed view.
+      for (const auto& u : cached->data.preprocessed_token_stream) {
+        preprocess_data_.preprocessed_token_stream.push_back(u);
+      }
+      return absl::OkStatus();
+    }
+  }
+
   // Use the provided FileOpener to open the included file.
   const auto status_or_file = file_opener_(file_path.string());
   if (!status_or_file.ok()) {
@@ -608,60 +660,103 @@ absl::Status VerilogPreprocess::HandleInclude(
         **token_iter, std::string(status_or_file.status().message()));
     return status_or_file.status();
   }
-  const absl::string_view source_contents = *status_or_file;
 
+  VerilogIncludeCache::Entry included;
+  const absl::Status status =
+      PreprocessIncludedFile(*status_or_file, &included);
+  if (!status.ok()) {
+    // Keep the included text alive for the errors that refer to it.
+    preprocess_data_.included_text_structure.push_back(
+        std::move(included.text_structure));
+    return status;
+  }
+
+  const VerilogPreprocessData* included_data = &included.data;
+  if (include_cache_ != nullptr) {
+    included_data =
+        &include_cache_->Insert(cache_key, std::move(included)).data;
+  } else {
+    // Need to move the text structures and expanded macros of the child
+    // preprocessor to avoid destruction.
+    preprocess_data_.included_text_structure.push_back(
+        std::move(included.text_structure));
+    for (auto& u : included.data.included_text_structure) {
+      preprocess_data_.included_text_structure.push_back(std::move(u));
+    }
+    for (auto& u : included.data.lexed_macros_backup) {
+      preprocess_data_.lexed_macros_backup.push_back(std::move(u));
+    }
+  }
+
+  // Forwarding the included preprocessed view.
+  for (const auto& u : included_data->preprocessed_token_stream) {
+    preprocess_data_.preprocessed_token_stream.push_back(u);
+  }
+
+  return absl::OkStatus();
+}
+
+std::unique_ptr<verible::TextStructure> VerilogPreprocess::LexText(
+    absl::string_view contents) {
+  std::unique_ptr<verible::TextStructure> text_structure(
+      new verible::TextStructure(contents));
+  verible::TokenSequence& tokens =
+      text_structure->MutableData().MutableTokenStream();
+  const BorrowedVerilogLexer lexer(
+      BorrowVerilogLexer(text_structure->Data().Contents()));
+  for (lexer->DoNextToken(); !lexer->GetLastToken().isEOF();
+       lexer->DoNextToken()) {
+    tokens.push_back(lexer->GetLastToken());
+  }
+  return text_structure;
+}
+
+absl::Status VerilogPreprocess::PreprocessIncludedFile(
+    absl::string_view source_contents, VerilogIncludeCache::Entry* entry) {
   // Creating a new "VerilogPreprocess" object for the included file,
   // With the same configuration and preprocessing info (defines, incdirs) as
   // the main one.
   // TODO(karimtera): Ideally modify the FileOpener to return
   // absl::StatusOr<MemBlock> to avoid doing a second copy inside TextStructure.
-  verilog::VerilogPreprocess child_preprocessor(config_, file_opener_);
+  verilog::VerilogPreprocess child_preprocessor(config_, file_opener_,
+                                                include_cache_);
   child_preprocessor.setPreprocessingInfo(preprocess_info_);
 
   // TODO(karimtera): limit number of nested includes, detect cycles? maybe.
-  preprocess_data_.included_text_structure.emplace_back(
-      new verible::TextStructure(source_contents));
-  verible::TextStructure& included_structure =
-      *preprocess_data_.included_text_structure.back();
-
-  // "included_sequence" should contain the lexed token sequence.
-  verible::TokenSequence& included_sequence =
-      included_structure.MutableData().MutableTokenStream();
-
-  // Lexing the included file content, and storing it in "included_sequence".
-  verilog::VerilogLexer lexer(included_structure.Data().Contents());
-  for (lexer.DoNextToken(); !lexer.GetLastToken().isEOF();
-       lexer.DoNextToken()) {
-    included_sequence.push_back(lexer.GetLastToken());
-  }
+  entry->text_structure = LexText(source_contents);
 
   // Preprocessing the included file tokens.
   verible::TokenStreamView lexed_streamview;
-  InitTokenStreamView(included_sequence, &lexed_streamview);
-  verilog::VerilogPreprocessData child_preprocessed_data =
-      child_preprocessor.ScanStream(lexed_streamview);
+  InitTokenStreamView(entry->text_structure->Data().TokenStream(),
+                      &lexed_streamview);
+  entry->data = child_preprocessor.ScanStream(lexed_streamview);
 
   // Check for errors while preprocessing the included file.
-  if (!child_preprocessed_data.errors.empty()) {
+  if (!entry->data.errors.empty()) {
     preprocess_data_.errors.insert(preprocess_data_.errors.end(),
-                                   child_preprocessed_data.errors.begin(),
-                                   child_preprocessed_data.errors.end());
+                                   entry->data.errors.begin(),
+                                   entry->data.errors.end());
     return absl::InvalidArgumentError(
         "Error: the included file preprocessing has failed.");
   }
+  return absl::OkStatus();
+}
 
-  // Need to move the text structures of the child preprocessor to avoid
-  // destruction.
-  for (auto& u : child_preprocessed_data.included_text_structure) {
-    preprocess_data_.included_text_structure.push_back(std::move(u));
+std::string VerilogPreprocess::IncludeCacheKey(
+    absl::string_view file_path) const {
+  // Fields are separated by NUL, which appears in none of them.
+  std::string key = absl::StrCat(file_path, absl::string_view("\0", 1),
+                                 config_.filter_branches, config_.include_files,
+                                 config_.expand_macros);
+  for (const auto& dir : preprocess_info_.include_dirs) {
+    absl::StrAppend(&key, absl::string_view("\0", 1), dir);
   }
-
-  // Forwarding the included preprocessed view.
-  for (const auto& u : child_preprocessed_data.preprocessed_token_stream) {
-    preprocess_data_.preprocessed_token_stream.push_back(u);
+  absl::StrAppend(&key, absl::string_view("\0", 1));
+  for (const auto& define : preprocess_info_.defines) {
+    absl::StrAppend(&key, absl::string_view("\0", 1), define.name, "=",
+                    define.value);
   }
-
-  return absl::OkStatus();
+  return key;
 }
 
 // Interprets preprocessor tokens as directives that act on this preprocessor
@@ -702,12 +797,283 @@ absl::Status VerilogPreprocess::HandleTokenIterator(
   return absl::OkStatus();
 }
 
+// Returns true for the white space of the lexer's {Space}.
+static bool IsPragmaSpace(char c) {
+  return c == ' ' || c == '\t' || c == '\f' || c == '\b';
+}
+
+// Returns the end of a "pragma protect <keyword>" that starts at 'pos' in
+// 'text', or npos if there is none there.  Like the lexer, this accepts
+// "//{Space}*pragma" and "`pragma", followed by "{Space}+protect{Space}+" and
+// 'keyword', which must not go on as an identifier.
+static size_t MatchProtectPragma(absl::string_view text, size_t pos,
+                                 absl::string_view keyword) {
+  const auto skip_spaces = [text](size_t p) {
+    while (p < text.size() && IsPragmaSpace(text[p])) ++p;
+    return p;
+  };
+  const auto consume = [text](size_t p, absl::string_view word) {
+    return absl::StartsWith(text.substr(p), word) ? p + word.size()
+                                                  : absl::string_view::npos;
+  };
+  if (absl::StartsWith(text.substr(pos), "//")) {
+    pos = skip_spaces(pos + 2);
+  } else if (absl::StartsWith(text.substr(pos), "`")) {
+    ++pos;
+  } else {
+    return absl::string_view::npos;
+  }
+  pos = consume(pos, "pragma");
+  if (pos == absl::string_view::npos || skip_spaces(pos) == pos) {
+    return absl::string_view::npos;
+  }
+  pos = consume(skip_spaces(pos), "protect");
+  if (pos == absl::string_view::npos || skip_spaces(pos) == pos) {
+    return absl::string_view::npos;
+  }
+  pos = consume(skip_spaces(pos), keyword);
+  if (pos == absl::string_view::npos) return pos;
+  if (pos < text.size() && (absl::ascii_isalnum(text[pos]) ||
+                            text[pos] == '_' || text[pos] == '$')) {
+    return absl::string_view::npos;
+  }
+  return pos;
+}
+
+// Returns the offset of the next conditional directive or `undef in 'text'
+// at or after 'pos', or the size of 'text' if there is none.  On the way,
+// only comments, strings, escaped identifiers, macro definitions and
+// encrypted sections are told apart, so that no directive is found in them.
+static size_t FindNextConditionalDirective(absl::string_view text,
+                                           size_t pos) {
+  // Skips to the end of an encrypted section, at a "pragma protect
+  // end_protected" like the lexer's; other mentions of end_protected don't
+  // end it.
+  const auto skip_protected_pragma = [text](size_t from) {
+    for (size_t found = text.find("pragma", from);
+         found != absl::string_view::npos;
+         found = text.find("pragma", found + 1)) {
+      size_t start = found;
+      while (start > from && IsPragmaSpace(text[start - 1])) --start;
+      if (start >= from + 2 && text.substr(start - 2, 2) == "//") {
+        start -= 2;
+      } else if (found > from && text[found - 1] == '`') {
+        start = found - 1;
+      } else {
+        continue;
+      }
+      const size_t end = MatchProtectPragma(text, start, "end_protected");
+      if (end != absl::string_view::npos) return end;
+    }
+    return text.size();
+  };
+  while (pos < text.size()) {
+    pos = text.find_first_of("`\"/\\", pos);
+    if (pos == absl::string_view::npos) break;
+    const absl::string_view rest = text.substr(pos);
+    if (absl::StartsWith(rest, "//")) {
+      const size_t eol = std::min(text.find('\n', pos), text.size());
+      if (MatchProtectPragma(text, pos, "begin_protected") !=
+          absl::string_view::npos) {
+        pos = skip_protected_pragma(eol);
+      } else {
+        pos = eol;
+      }
+    } else if (absl::StartsWith(rest, "/*")) {
+      pos = std::min(text.find("*/", pos + 2), text.size() - 2) + 2;
+    } else if (rest[0] == '"') {
+      // Up to the closing quote, or the end of the line.
+      for (++pos; pos < text.size(); ++pos) {
+        if (text[pos] == '\\') {
+          ++pos;
+        } else if (text[pos] == '"' || text[pos] == '\n') {
+          break;
+        }
+      }
+      ++pos;
+    } else if (rest[0] == '\\') {
+      // Escaped identifiers end with white space.
+      pos = std::min(text.find_first_of(" \t\f\r\n", pos), text.size());
+    } else if (rest[0] == '`') {
+      size_t end = pos + 1;
+      while (end < text.size() &&
+             (absl::ascii_isalnum(text[end]) || text[end] == '_')) {
+        ++end;
+      }
+      const absl::string_view directive = text.substr(pos + 1, end - pos - 1);
+      if (directive == "ifdef" || directive == "ifndef" ||
+          directive == "elsif" || directive == "else" ||
+          directive == "endif" || directive == "undef") {
+        return pos;
+      }
+      const size_t directive_begin = pos;
+      pos = end;
+      if (directive == "define") {
+        // Up to the end of the line that is not continued.
+        for (; pos < text.size() && text[pos] != '\n'; ++pos) {
+          if (text[pos] == '\\') ++pos;
+        }
+      } else if (directive == "protected") {
+        const size_t found = text.find("`endprotected", pos);
+        pos = found == absl::string_view::npos ? text.size() : found;
+      } else if (directive == "pragma" &&
+                 MatchProtectPragma(text, directive_begin, "begin_protected") !=
+                     absl::string_view::npos) {
+        pos = skip_protected_pragma(
+            std::min(text.find('\n', pos), text.size()));
+      }
+    } else {
+      ++pos;
+    }
+  }
+  return text.size();
+}
+
+namespace {
+// Lexer of VerilogPreprocess::MakeLexer() that skips filtered out branches.
+class BranchSkippingLexer final : public verible::Lexer {
+ public:
+  BranchSkippingLexer(std::set<std::string, std::less<>> defines,
+                      bool follows_includes)
+      : lexer_(""),
+        initial_defines_(std::move(defines)),
+        follows_includes_(follows_includes) {}
+
+  const verible::TokenInfo& GetLastToken() const final { return last_token_; }
+
+  const verible::TokenInfo& DoNextToken() final {
+    last_token_ = lexer_.DoNextToken();
+    if (!following_) return last_token_;
+    following_ = Follow(last_token_);
+    if (following_ && pending_directive_ == 0 && !branches_.back().selected &&
+        !last_token_.isEOF() && lexer_.InInitialState()) {
+      lexer_.Restart(text_.substr(
+          FindNextConditionalDirective(text_, last_token_.right(text_))));
+    }
+    return last_token_;
+  }
+
+  void Restart(absl::string_view text) final {
+    text_ = text;
+    lexer_.Restart(text);
+    last_token_ = verible::TokenInfo(0, text.substr(0, 0));
+    defines_ = initial_defines_;
+    branches_.assign(1, Branch{true, true, false, true});
+    pending_directive_ = 0;
+    following_ = true;
+  }
+
+  bool TokenIsError(const verible::TokenInfo& token) const final {
+    return lexer_.TokenIsError(token);
+  }
+
+ private:
+  // Like VerilogPreprocess::BranchBlock.
+  struct Branch {
+    bool outer_selected;
+    bool any_matched;
+    bool in_else;
+    bool selected;
+
+    void Update(bool condition) {
+      selected = outer_selected && !any_matched && condition;
+      any_matched |= condition;
+    }
+  };
+
+  // Follows the directives of 'token' like VerilogPreprocess::ScanStream().
+  // Returns false where that would fail, or where it is not known which
+  // macros are defined anymore.
+  bool Follow(const verible::TokenInfo& token) {
+    if (pending_directive_ != 0) {
+      if (!VerilogLexer::KeepSyntaxTreeTokens(token)) return true;
+      const int directive = std::exchange(pending_directive_, 0);
+      if (token.token_enum() != PP_Identifier) return false;
+      const auto found = defines_.find(token.text());
+      switch (directive) {
+        case PP_define:
+          if (branches_.back().selected) defines_.emplace(token.text());
+          return true;
+        case PP_undef:  // also in filtered out branches
+          if (found != defines_.end()) defines_.erase(found);
+          return true;
+        case PP_elsif:
+          if (branches_.size() <= 1 || branches_.back().in_else) return false;
+          branches_.back().Update(found != defines_.end());
+          return true;
+        default: {  // `ifdef, `ifndef
+          Branch branch{branches_.back().selected, false, false, false};
+          branch.Update((found != defines_.end()) ^ (directive == PP_ifndef));
+          branches_.push_back(branch);
+          return true;
+        }
+      }
+    }
+    switch (token.token_enum()) {
+      case PP_define:
+      case PP_undef:
+      case PP_ifdef:
+      case PP_ifndef:
+      case PP_elsif:
+        pending_directive_ = token.token_enum();
+        return true;
+      case PP_else: {
+        Branch& branch = branches_.back();
+        if (branches_.size() <= 1 || branch.in_else) return false;
+        branch.in_else = true;
+        branch.selected = branch.outer_selected && !branch.any_matched;
+        return true;
+      }
+      case PP_endif:
+        if (branches_.size() <= 1) return false;
+        branches_.pop_back();
+        return true;
+      case PP_include:
+        // The included file may define macros.
+        return !(follows_includes_ && branches_.back().selected);
+      default:
+        return true;
+    }
+  }
+
+  VerilogLexer lexer_;
+  absl::string_view text_;
+  verible::TokenInfo last_token_ = verible::TokenInfo::EOFToken();
+
+  const std::set<std::string, std::less<>> initial_defines_;
+  // True if `include-d files are preprocessed, too.
+  const bool follows_includes_;
+
+  std::set<std::string, std::less<>> defines_;
+  // Nested conditionals, the first one stands for the whole text.
+  std::vector<Branch> branches_;
+  // Directive that awaits its macro name, or 0.
+  int pending_directive_ = 0;
+  // False once the directives can't be followed anymore.
+  bool following_ = true;
+};
+}  // namespace
+
+std::unique_ptr<verible::Lexer> VerilogPreprocess::MakeLexer() const {
+  if (!config_.filter_branches || !config_.skip_filtered_branches) {
+    return std::make_unique<VerilogLexer>("");
+  }
+  std::set<std::string, std::less<>> defines;
+  for (const auto& definition : preprocess_data_.macro_definitions) {
+    defines.emplace(definition.first);
+  }
+  return std::make_unique<BranchSkippingLexer>(std::move(defines),
+                                               config_.include_files);
+}
+
 void VerilogPreprocess::setPreprocessingInfo(
     const verilog::FileList::PreprocessingInfo& preprocess_info) {
   preprocess_info_ = preprocess_info;
+  // Definition texts of the previous defines are gone.
+  lexed_macro_bodies_.clear();
 
   // Adding defines.
-  for (const auto& define : preprocess_info_.defines) {
+  for (const auto& define : preprocess_info.defines) {
     // manually create the tokens to save them into a MacroDefinition.
     verible::TokenInfo macro_directive(PP_define, "`define");
     verible::TokenInfo macro_name(PP_Identifier, define.name);
@@ -722,6 +1088,37 @@ void VerilogPreprocess::setPreprocessingInfo(
   // We can directly access "preprocess_info_.include_dirs" whenever needed.
 }
 
+void VerilogPreprocess::RestoreSnapshot(
+    const VerilogPreprocessSnapshot& snapshot) {
+  preprocess_info_ = snapshot.PreprocessingInfo();
+  lexed_macro_bodies_.clear();
+  preprocess_data_.macro_definitions = snapshot.MacroDefinitions();
+}
+
+absl::StatusOr<std::unique_ptr<VerilogPreprocessSnapshot>>
+VerilogPreprocessSnapshot::Create(
+    absl::string_view prelude, const VerilogPreprocess::Config& config,
+    const FileList::PreprocessingInfo& preprocess_info,
+    VerilogPreprocess::FileOpener opener) {
+  std::unique_ptr<VerilogPreprocessSnapshot> snapshot(
+      new VerilogPreprocessSnapshot());
+  snapshot->preprocess_info_ = preprocess_info;
+  snapshot->prelude_ = VerilogPreprocess::LexText(prelude);
+
+  VerilogPreprocess preprocessor(config, std::move(opener));
+  preprocessor.setPreprocessingInfo(snapshot->preprocess_info_);
+  verible::TokenStreamView lexed_streamview;
+  InitTokenStreamView(snapshot->prelude_->Data().TokenStream(),
+                      &lexed_streamview);
+  snapshot->data_ = preprocessor.ScanStream(lexed_streamview);
+  if (!snapshot->data_.errors.empty()) {
+    return absl::InvalidArgumentError(absl::StrCat(
+        "Preprocessing the prelude failed: ",
+        snapshot->data_.errors.front().error_message));
+  }
+  return snapshot;
+}
+
 VerilogPreprocessData VerilogPreprocess::ScanStream(
     const TokenStreamView& token_stream) {
   preprocess_data_.preprocessed_token_stream.reserve(token_stream.size());
@@ -35,6 +35,7 @@
 #ifndef VERIBLE_VERILOG_PREPROCESSOR_VERILOG_PREPROCESS_H_
 #define VERIBLE_VERILOG_PREPROCESSOR_VERILOG_PREPROCESS_H_
 
+#include <cstddef>
 #include <functional>
 #include <map>
 #include <memory>
@@ -42,9 +43,11 @@
 #include <string>
 #include <vector>
 
+#include "absl/container/node_hash_map.h"
 #include "absl/status/status.h"
 #include "absl/status/statusor.h"
 #include "absl/strings/string_view.h"
+#include "common/lexer/lexer.h"
 #include "common/text/macro_definition.h"
 #include "common/text/text_structure.h"
 #include "common/text/token_info.h"
@@ -69,7 +72,10 @@ struct VerilogPreprocessError {
 // Information that results from preprocessing.
 struct VerilogPreprocessData {
   using MacroDefinition = verible::MacroDefinition;
-  using MacroDefinitionRegistry = std::map<absl::string_view, MacroDefinition>;
+  // Node-based, so that definitions keep their addresses while other macros
+  // are defined during the expansion of a macro.
+  using MacroDefinitionRegistry =
+      absl::node_hash_map<absl::string_view, MacroDefinition>;
   using TokenSequence = std::vector<verible::TokenInfo>;
 
   // Resulting token stream after preprocessing
@@ -89,6 +95,45 @@ struct VerilogPreprocessData {
   std::vector<VerilogPreprocessError> warnings;
 };
 
+// VerilogIncludeCache keeps the lexed and preprocessed contents of `include-d
+// files, so that preprocessors of many compilation units that include the
+// same files open, lex and preprocess each of them only once.
+// An included file is preprocessed only with the externally given
+// defines (PreprocessingInfo), independent of the including file, so an
+// entry is reused by every preprocessor with the same Config and
+// PreprocessingInfo.  Preprocessors that resolve paths through FileOpeners
+// that return different contents for the same path must not share a cache.
+//
+// The cache must outlive the VerilogPreprocessData of all preprocessors
+// that use it, because their token streams point into the cached files.
+// This class is not thread-safe.
+class VerilogIncludeCache {
+ public:
+  struct Entry {
+    // The included file, with its lexed tokens.
+    std::unique_ptr<verible::TextStructure> text_structure;
+
+    // Results of preprocessing the file.  The preprocessed token stream
+    // points into text_structure, and into the storage of 'data' itself.
+    VerilogPreprocessData data;
+  };
+
+  // Returns the entry for 'key' or nullptr if there is none.
+  const Entry* Find(absl::string_view key) const;
+
+  // Adds the entry for 'key', and returns it.
+  const Entry& Insert(absl::string_view key, Entry entry);
+
+  // Number of cached files.
+  size_t size() const { return entries_.size(); }
+
+ private:
+  // Entries are allocated separately so that they stay in place.
+  std::map<std::string, std::unique_ptr<Entry>, std::less<>> entries_;
+};
+
+class VerilogPreprocessSnapshot;
+
 // VerilogPreprocess transforms a TokenStreamView.
 // The input stream view is expected to have been stripped of whitespace.
 class VerilogPreprocess {
@@ -115,12 +160,22 @@ class VerilogPreprocess {
 
     // Expand macro definition bodies, this will relexes the macro body.
     bool expand_macros = false;
+
+    // With filter_branches, only scan the text of filtered out branches for
+    // where they end, instead of lexing it, see MakeLexer().  Their tokens
+    // are then missing from the lexed token stream, too.
+    bool skip_filtered_branches = false;
     // TODO(hzeller): Provide a map of command-line provided +define+'s
   };
 
   explicit VerilogPreprocess(const Config& config);
   VerilogPreprocess(const Config& config, FileOpener opener);
 
+  // If 'include_cache' is not nullptr, included files are looked up in and
+  // added to it, see VerilogIncludeCache.
+  VerilogPreprocess(const Config& config, FileOpener opener,
+                    VerilogIncludeCache* include_cache);
+
   // Initialize preprocessing with safe default options
   // TODO(hzeller): remove this constructor once all places using the
   // preprocessor have been updated to pass a config.
@@ -134,11 +189,33 @@ class VerilogPreprocess {
   // TODO(fangism): ExpandMacro, ExpandMacroCall
   // TODO(b/111544845): ExpandEvalStringLiteral
 
+  // Returns a lexer for the text that this preprocessor is going to scan.
+  // With Config::filter_branches and Config::skip_filtered_branches, the
+  // lexer follows the conditional directives the same way ScanStream() does,
+  // knowing the macros defined so far by setPreprocessingInfo() or
+  // RestoreSnapshot(), and skips the text of branches that are filtered out
+  // up to the next conditional directive, only minding comments, strings and
+  // macro definitions on the way.  Where it can't tell which branches are
+  // filtered out, e.g. after an `include with Config::include_files, it lexes
+  // the rest of the text in full.  Otherwise this is a plain VerilogLexer.
+  std::unique_ptr<verible::Lexer> MakeLexer() const;
+
   // Sets the preprocessing information containing defines and incdirs.
+  // The defines are registered as references into 'preprocess_info', which
+  // must outlive the macro definitions of the returned VerilogPreprocessData.
   void setPreprocessingInfo(
       const verilog::FileList::PreprocessingInfo& preprocess_info);
 
+  // Starts preprocessing from the state after the prelude of 'snapshot',
+  // instead of setPreprocessingInfo(): the macros defined by the prelude and
+  // its preprocessing info are taken over.  'snapshot' should have been
+  // created with the same Config, and must outlive the returned
+  // VerilogPreprocessData.
+  void RestoreSnapshot(const VerilogPreprocessSnapshot& snapshot);
+
  private:
+  friend class VerilogPreprocessSnapshot;  // for LexText()
+
   using StreamIteratorGenerator =
       std::function<TokenStreamView::const_iterator()>;
 
@@ -179,6 +256,22 @@ class VerilogPreprocess {
   static std::unique_ptr<VerilogPreprocessError> ParseMacroParameter(
       TokenStreamView::const_iterator*, MacroParameterInfo*);
 
+  // Lexed body of a macro definition, memoized so that every expansion of
+  // the macro after the first one does not need to lex the body again.
+  struct LexedMacroBody {
+    verible::TokenSequence tokens;
+
+    // All of 'tokens'.
+    TokenStreamView view;
+
+    // For each element of 'view': the position of the formal parameter of the
+    // macro that its text names, or -1.
+    std::vector<int> parameter_positions;
+  };
+
+  // Returns the memoized lexed body of 'definition'.
+  const LexedMacroBody& GetLexedMacroBody(const MacroDefinition& definition);
+
   void RegisterMacroDefinition(const MacroDefinition&);
   absl::Status ExpandText(const absl::string_view&);
   absl::Status ExpandMacro(const verible::MacroCall&,
@@ -186,6 +279,19 @@ class VerilogPreprocess {
   absl::Status HandleInclude(TokenStreamView::const_iterator,
                              const StreamIteratorGenerator&);
 
+  // Copies 'contents' into a new TextStructure, with the lexed tokens as its
+  // token stream.
+  static std::unique_ptr<verible::TextStructure> LexText(
+      absl::string_view contents);
+
+  // Lexes and preprocesses the contents of an included file into 'entry'.
+  absl::Status PreprocessIncludedFile(absl::string_view source_contents,
+                                      VerilogIncludeCache::Entry* entry);
+
+  // Returns the key of 'file_path' in the include cache, which also covers
+  // the configuration that the result of preprocessing depends on.
+  std::string IncludeCacheKey(absl::string_view file_path) const;
+
   // Generate a const_iterator to a non-whitespace token.
   static TokenStreamView::const_iterator GenerateBypassWhiteSpaces(
       const StreamIteratorGenerator&);
@@ -247,12 +353,62 @@ class VerilogPreprocess {
   // Results of preprocessing
   VerilogPreprocessData preprocess_data_;
 
+  // Memoized bodies of expanded macros.
+  // Key: start of the definition text, which is distinct for every `define.
+  // Values are allocated separately, so that iterators into them stay valid.
+  std::map<const char*, std::unique_ptr<LexedMacroBody>> lexed_macro_bodies_;
+
   // Defines and incdirs Information passed externally.
   FileList::PreprocessingInfo preprocess_info_;
 
   // A pointer to a file opener function.
   // This is needed for opening new files while handling includes.
   const FileOpener file_opener_ = nullptr;
+
+  // Not owned, may be nullptr.
+  VerilogIncludeCache* const include_cache_ = nullptr;
+};
+
+// VerilogPreprocessSnapshot is the state of a preprocessor after it
+// preprocessed a prelude that many compilation units start with, like the UVM
+// macros or project-wide defines.  Like with precompiled headers, units that
+// start from the snapshot (VerilogPreprocess::RestoreSnapshot()) know the
+// macros of the prelude without lexing and preprocessing it again.
+// Only the macro definitions carry over, the tokens of the prelude are not
+// part of the preprocessed token stream of the units.
+// The snapshot owns the prelude text that its macro definitions refer to.
+class VerilogPreprocessSnapshot {
+ public:
+  // Lexes and preprocesses 'prelude' with the given configuration, and
+  // returns the resulting state, or an error if preprocessing failed.
+  static absl::StatusOr<std::unique_ptr<VerilogPreprocessSnapshot>> Create(
+      absl::string_view prelude, const VerilogPreprocess::Config& config,
+      const FileList::PreprocessingInfo& preprocess_info,
+      VerilogPreprocess::FileOpener opener = nullptr);
+
+  VerilogPreprocessSnapshot(const VerilogPreprocessSnapshot&) = delete;
+  VerilogPreprocessSnapshot& operator=(const VerilogPreprocessSnapshot&) =
+      delete;
+
+  const FileList::PreprocessingInfo& PreprocessingInfo() const {
+    return preprocess_info_;
+  }
+
+  // Macros defined after the prelude.
+  const VerilogPreprocessData::MacroDefinitionRegistry& MacroDefinitions()
+      const {
+    return data_.macro_definitions;
+  }
+
+ private:
+  VerilogPreprocessSnapshot() = default;
+
+  // The defines of the prelude refer to these.
+  FileList::PreprocessingInfo preprocess_info_;
+
+  std::unique_ptr<verible::TextStructure> prelude_;
+
+  VerilogPreprocessData data_;
 };
 
 }  // namespace verilog
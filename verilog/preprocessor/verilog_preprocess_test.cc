@@ -16,9 +16,12 @@
 
 #include <algorithm>
 #include <map>
+#include <memory>
+#include <string>
 #include <vector>
 
 #include "absl/status/status.h"
+#include "absl/strings/str_cat.h"
 #include "absl/strings/string_view.h"
 #include "common/text/macro_definition.h"
 #include "common/text/token_info.h"
@@ -37,6 +40,7 @@ namespace {
 using testing::ElementsAre;
 using testing::Pair;
 using testing::StartsWith;
+using testing::UnorderedElementsAre;
 using verible::container::FindOrNull;
 using verible::file::CreateDir;
 using verible::file::JoinPath;
@@ -240,8 +244,8 @@ TEST(VerilogPreprocessTest, TwoMacroDefinitions) {
   EXPECT_PARSE_OK();
 
   const auto& definitions = tester.PreprocessorData().macro_definitions;
-  EXPECT_THAT(definitions, ElementsAre(Pair("BAAAAR", testing::_),
-                                       Pair("FOOOO", testing::_)));
+  EXPECT_THAT(definitions, UnorderedElementsAre(Pair("BAAAAR", testing::_),
+                                                Pair("FOOOO", testing::_)));
   {
     auto macro = FindOrNull(definitions, "BAAAAR");
     ASSERT_NE(macro, nullptr);
@@ -587,7 +591,85 @@ module baz(); endmodule
       ++filtered_it;
       ++equivalent_it;
     }
+
+    // Skipping filtered out branches in the lexer gives the same result.
+    PreprocessorTester with_skip(
+        test.pp_input, VerilogPreprocess::Config({
+                           .filter_branches = true,
+                           .skip_filtered_branches = true,
+                       }));
+    EXPECT_TRUE(with_skip.Status().ok())
+        << with_skip.Status() << " " << test.description;
+    const auto& skipped_stream = with_skip.Data().GetTokenStreamView();
+    ASSERT_EQ(skipped_stream.size(), filtered_stream.size())
+        << test.description;
+    for (size_t i = 0; i < skipped_stream.size(); ++i) {
+      EXPECT_EQ(skipped_stream[i]->text(), filtered_stream[i]->text())
+          << test.description;
+    }
+  }
+}
+
+// Tests that the text of filtered out branches is not lexed.
+TEST(VerilogPreprocessTest, SkipFilteredBranches) {
+  constexpr absl::string_view kCode =
+      "`define A\n"
+      "`ifdef A\n"
+      "module a; endmodule\n"
+      "`elsif B\n"
+      "  ` \"`endif\" /* `else */ // `endif\n"
+      "  `define C \\\n"
+      "    `endif\n"
+      "  `ifndef A module b; `else module c; `endif\n"
+      "`else\n"
+      "  module d; endmodule\n"
+      "`endif\n"
+      "`ifdef C module e; endmodule `endif\n";
+  PreprocessorTester tester(kCode, VerilogPreprocess::Config({
+                                       .filter_branches = true,
+                                       .skip_filtered_branches = true,
+                                   }));
+  ASSERT_TRUE(tester.Status().ok()) << tester.Status();
+  // Only the module of the selected branch is lexed.
+  std::vector<absl::string_view> identifiers;
+  for (const auto& token : tester.Data().TokenStream()) {
+    if (token.token_enum() == SymbolIdentifier) {
+      identifiers.push_back(token.text());
+    }
+  }
+  EXPECT_THAT(identifiers, ElementsAre("a"));
+}
+
+// Tests that only "pragma protect" comments start encrypted sections in
+// skipped branches, as in the lexer.
+TEST(VerilogPreprocessTest, SkipFilteredBranchesMindsOnlyProtectPragmas) {
+  constexpr absl::string_view kCode =
+      "`ifdef B\n"
+      "  // Not encrypted: begin_protected ... end_protected\n"
+      "  // pragma protect begin_protected\n"
+      "  `else `endif // not the end_protected\n"
+      "  //pragma  protect\tend_protected\n"
+      "  module b; endmodule\n"
+      "`else\n"
+      "  module c; endmodule\n"
+      "`endif\n"
+      "`ifdef B\n"
+      "  // mentions begin_protected\n"
+      "`else\n"
+      "  module d; endmodule\n"
+      "`endif\n";
+  PreprocessorTester tester(kCode, VerilogPreprocess::Config({
+                                       .filter_branches = true,
+                                       .skip_filtered_branches = true,
+                                   }));
+  ASSERT_TRUE(tester.Status().ok()) << tester.Status();
+  std::vector<absl::string_view> identifiers;
+  for (const auto& token : tester.Data().TokenStream()) {
+    if (token.token_enum() == SymbolIdentifier) {
+      identifiers.push_back(token.text());
+    }
   }
+  EXPECT_THAT(identifiers, ElementsAre("c", "d"));
 }
 
 TEST(VerilogPreprocessTest, MacroExpansion) {
@@ -782,7 +864,23 @@ real x=2;
 real y=3; real x=1;
 endmodule
 `undef MACRO1
-`undef MACRO2)"}
+`undef MACRO2)"},
+
+      {"[** Callable macro expanded repeatedly, also inside its own argument "
+       "**]",
+       R"(
+`define PAIR(a, b) {a, b}
+module foo;
+wire [3:0] x = `PAIR(`PAIR(p, q), `PAIR(r, s));
+wire [1:0] y = `PAIR(b, a);
+endmodule)",
+       // ...equivalent to
+       R"(
+`define PAIR(a, b) {a, b}
+module foo;
+wire [3:0] x = {{p, q}, {r, s}};
+wire [1:0] y = {b, a};
+endmodule)"}
 
   };
 
@@ -1029,5 +1127,97 @@ TEST(VerilogPreprocessTest,
   EXPECT_THAT(error.error_message, StartsWith("Unable to find"));
 }
 
+// Preprocessors that share an include cache open and preprocess an included
+// file only once, unless their defines differ.
+TEST(VerilogPreprocessTest, IncludeCacheSharedAcrossPreprocessors) {
+  constexpr absl::string_view included_content(
+      "`ifdef FOO\nmodule foo(); endmodule\n`else\nmodule bar(); endmodule\n"
+      "`endif\n");
+  int open_count = 0;
+  FileOpener file_opener =
+      [&open_count, included_content](
+          absl::string_view filename) -> absl::StatusOr<absl::string_view> {
+    if (filename != "inc.svh") return absl::NotFoundError(filename);
+    ++open_count;
+    return included_content;
+  };
+  const VerilogPreprocess::Config config(
+      {.filter_branches = true, .include_files = true});
+  VerilogIncludeCache cache;
+
+  constexpr absl::string_view src_content("`include \"inc.svh\"\nwire w;\n");
+  std::vector<std::string> outputs;
+  // Keep all preprocessed data alive to check that cached tokens stay valid.
+  std::vector<std::unique_ptr<LexerTester>> lexers;
+  std::vector<VerilogPreprocessData> results;
+  for (const bool define_foo : {false, false, true, true}) {
+    VerilogPreprocess preprocessor(config, file_opener, &cache);
+    FileList::PreprocessingInfo info;
+    if (define_foo) info.defines.emplace_back("FOO", "");
+    preprocessor.setPreprocessingInfo(info);
+    lexers.push_back(std::make_unique<LexerTester>(src_content));
+    results.push_back(
+        preprocessor.ScanStream(lexers.back()->GetTokenStreamView()));
+    EXPECT_TRUE(results.back().errors.empty());
+  }
+  EXPECT_EQ(open_count, 2);
+  EXPECT_EQ(cache.size(), 2);
+
+  for (const auto& result : results) {
+    std::string text;
+    for (const auto& token : result.preprocessed_token_stream) {
+      absl::StrAppend(&text, token->text(), " ");
+    }
+    outputs.push_back(text);
+  }
+  EXPECT_EQ(outputs[0], outputs[1]);
+  EXPECT_EQ(outputs[2], outputs[3]);
+  EXPECT_NE(outputs[0], outputs[2]);
+  EXPECT_THAT(outputs[0], testing::HasSubstr("bar"));
+  EXPECT_THAT(outputs[2], testing::HasSubstr("foo"));
+}
+
+TEST(VerilogPreprocessTest, StartFromSnapshotOfPrelude) {
+  constexpr absl::string_view prelude(
+      "`define WIDTH 8\n"
+      "`define ADD(a, b) a + b\n"
+      "`ifdef FROM_FILELIST\n"
+      "`define SELECTED 1\n"
+      "`endif\n");
+  const VerilogPreprocess::Config config(
+      {.filter_branches = true, .expand_macros = true});
+  FileList::PreprocessingInfo info;
+  info.defines.emplace_back("FROM_FILELIST", "");
+  auto snapshot = VerilogPreprocessSnapshot::Create(prelude, config, info);
+  ASSERT_TRUE(snapshot.ok()) << snapshot.status();
+  EXPECT_THAT((*snapshot)->MacroDefinitions(),
+              UnorderedElementsAre(Pair("FROM_FILELIST", testing::_),
+                                   Pair("WIDTH", testing::_),
+                                   Pair("ADD", testing::_),
+                                   Pair("SELECTED", testing::_)));
+
+  // Every unit starts from the same snapshot.
+  for (int unit = 0; unit < 2; ++unit) {
+    VerilogPreprocess preprocessor(config);
+    preprocessor.RestoreSnapshot(**snapshot);
+    LexerTester lexer("`WIDTH `ADD(1,2) `SELECTED\n");
+    const VerilogPreprocessData data =
+        preprocessor.ScanStream(lexer.GetTokenStreamView());
+    EXPECT_TRUE(data.errors.empty());
+    std::string text;
+    for (const auto& token : data.preprocessed_token_stream) {
+      if (!VerilogLexer::KeepSyntaxTreeTokens(*token)) continue;
+      absl::StrAppend(&text, token->text(), " ");
+    }
+    EXPECT_EQ(text, "8 1 + 2 1 ");
+  }
+}
+
+TEST(VerilogPreprocessTest, SnapshotOfInvalidPrelude) {
+  const auto snapshot = VerilogPreprocessSnapshot::Create(
+      "`ifdef FOO\n", VerilogPreprocess::Config(), {});
+  EXPECT_FALSE(snapshot.ok());
+}
+
 }  // namespace
 }  // namespace verilog
@@ -0,0 +1,88 @@
+#!/usr/bin/env bash
+# Copyright 2017-2023 The Verible Authors.
+#
+# Licensed under the Apache License, Version 2.0 (the "License");
+# you may not use this file except in compliance with the License.
+# You may obtain a copy of the License at
+#
+#      http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing, software
+# distributed under the License is distributed on an "AS IS" BASIS,
+# WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+# See the License for the specific language governing permissions and
+# limitations under the License.
+
+# Tests verible-verilog-diff comparing directories and --file_pairs.
+
+declare -r LEFT_DIR="${TEST_TMPDIR}/left"
+declare -r RIGHT_DIR="${TEST_TMPDIR}/right"
+declare -r MY_OUTPUT_FILE="${TEST_TMPDIR}/myoutput.txt"
+declare -r MANIFEST="${TEST_TMPDIR}/pairs.txt"
+
+# Get tool from argument
+[[ "$#" == 1 ]] || {
+  echo "Expecting 1 positional argument, verible-verilog-diff path."
+  exit 1
+}
+difftool="$(rlocation ${TEST_WORKSPACE}/${1})"
+
+mkdir -p "${LEFT_DIR}/sub" "${RIGHT_DIR}/sub"
+
+cat >"${LEFT_DIR}/a.sv" <<EOF
+  module    m   ;endmodule
+EOF
+cat >"${RIGHT_DIR}/a.sv" <<EOF
+module m;
+endmodule
+EOF
+cat >"${LEFT_DIR}/sub/b.sv" <<EOF
+module b; wire w; endmodule
+EOF
+cat >"${RIGHT_DIR}/sub/b.sv" <<EOF
+module b;
+  wire w;
+endmodule
+EOF
+
+# All files below the directories match.
+"${difftool}" --mode=format --jobs=2 "${LEFT_DIR}" "${RIGHT_DIR}" \
+  > "${MY_OUTPUT_FILE}"
+[[ $? -eq 0 ]] || exit 1
+grep "Compared 2 pairs of files: 2 match" "${MY_OUTPUT_FILE}" > /dev/null || exit 2
+
+# A difference is reported with the names of the files.
+cat >"${RIGHT_DIR}/sub/b.sv" <<EOF
+module b;
+  wire v;
+endmodule
+EOF
+"${difftool}" --mode=format "${LEFT_DIR}" "${RIGHT_DIR}" > "${MY_OUTPUT_FILE}"
+[[ $? -eq 1 ]] || exit 3
+grep "sub/b.sv vs. .*sub/b.sv: Inputs differ" "${MY_OUTPUT_FILE}" > /dev/null \
+  || exit 4
+
+# A file missing on the right is an error.
+cat >"${LEFT_DIR}/c.sv" <<EOF
+module c; endmodule
+EOF
+"${difftool}" --mode=format "${LEFT_DIR}" "${RIGHT_DIR}" > /dev/null
+[[ $? -eq 2 ]] || exit 5
+
+# Pairs listed in a manifest.
+cat >"${MANIFEST}" <<EOF
+# left right
+${LEFT_DIR}/a.sv ${RIGHT_DIR}/a.sv
+
+${LEFT_DIR}/c.sv	${LEFT_DIR}/c.sv
+EOF
+"${difftool}" --mode=format --file_pairs="${MANIFEST}" > "${MY_OUTPUT_FILE}"
+[[ $? -eq 0 ]] || exit 6
+grep "Compared 2 pairs of files: 2 match" "${MY_OUTPUT_FILE}" > /dev/null || exit 7
+
+# No files as arguments with a manifest.
+"${difftool}" --mode=format --file_pairs="${MANIFEST}" "${LEFT_DIR}/a.sv" \
+  "${RIGHT_DIR}/a.sv"
+[[ $? -eq 2 ]] || exit 8
+
+echo "PASS"
@@ -18,21 +18,40 @@
 // Differences are reported to stdout.
 // The program exits 0 if no differences are found, else non-zero.
 //
+// Many pairs of files can be compared at once, in parallel: all files below
+// two directories, or the pairs listed in a --file_pairs manifest.
+//
 // Example usage:
 // verilog_diff [options] file1 file2
+// verilog_diff [options] dir1 dir2
+// verilog_diff [options] --file_pairs=manifest
 
+#include <algorithm>
+#include <functional>
 #include <iostream>
+#include <map>
+#include <memory>
 #include <sstream>  // IWYU pragma: keep  // for ostringstream
 #include <string>   // for string, allocator, etc
+#include <utility>
+#include <vector>
 
 #include "absl/flags/flag.h"
+#include "absl/status/status.h"
+#include "absl/status/statusor.h"
+#include "absl/strings/ascii.h"
+#include "absl/strings/match.h"
 #include "absl/strings/str_cat.h"
+#include "absl/strings/str_split.h"
 #include "absl/strings/string_view.h"
+#include "absl/strings/strip.h"
+#include "common/strings/mem_block.h"
 #include "common/strings/obfuscator.h"
 #include "common/util/enum_flags.h"
 #include "common/util/file_util.h"
 #include "common/util/init_command_line.h"
 #include "common/util/logging.h"
+#include "common/util/thread_pool.h"
 #include "verilog/analysis/verilog_equivalence.h"
 
 // Enumeration type for selecting
@@ -73,6 +92,17 @@ ABSL_FLAG(DiffMode, mode, DiffMode::kFormat,
     This is useful for verifying verilog_obfuscate output.
 )");
 
+ABSL_FLAG(std::string, file_pairs, "",
+          "If not empty, compare the pairs of files listed in this file "
+          "instead of the files given as arguments: one pair per line, the "
+          "two names separated by whitespace. Empty lines and lines starting "
+          "with # are ignored.");
+
+ABSL_FLAG(int, jobs, 0,
+          "Number of pairs of files to compare in parallel, when comparing "
+          "many. 0 uses all available cores. Differences are still printed "
+          "in the order of the pairs.");
+
 using EquivalenceFunctionType = std::function<verilog::DiffStatus(
     absl::string_view, absl::string_view, std::ostream*)>;
 
@@ -81,37 +111,159 @@ static const std::map<DiffMode, EquivalenceFunctionType> diff_func_map({
     {DiffMode::kObfuscate, verilog::ObfuscationEquivalent},
 });
 
-int main(int argc, char** argv) {
-  const auto usage = absl::StrCat("usage: ", argv[0],
-                                  " [options] file1 file2\n"
-                                  "Use - as a file name to read from stdin.");
-  const auto args = verible::InitCommandLine(usage, &argc, &argv);
+enum {
+  // inputs differ or there is some lexical error in one of the inputs
+  kInputDifferenceErrorCode = 1,
 
-  enum {
-    // inputs differ or there is some lexical error in one of the inputs
-    kInputDifferenceErrorCode = 1,
+  // error with flags or opening/reading one of the files
+  kUserErrorCode = 2,
+};
 
-    // error with flags or opening/reading one of the files
-    kUserErrorCode = 2,
-  };
+using FilePair = std::pair<std::string, std::string>;
 
-  if (args.size() != 3) {
-    std::cerr << "Program requires 2 positional arguments for input files."
-              << std::endl;
-    return kUserErrorCode;
+// The outcome of comparing one pair of files.
+struct PairResult {
+  absl::Status read_status;  // Error opening or reading either file.
+  verilog::DiffStatus diff_status = verilog::DiffStatus::kEquivalent;
+  std::string details;  // Where they differ, or the lexical error.
+};
+
+static PairResult ComparePair(const EquivalenceFunctionType& diff_func,
+                              const FilePair& files) {
+  PairResult result;
+  const auto left = verible::file::GetContentAsMemBlock(files.first);
+  if (!left.ok()) {
+    result.read_status = left.status();
+    return result;
   }
+  const auto right = verible::file::GetContentAsMemBlock(files.second);
+  if (!right.ok()) {
+    result.read_status = right.status();
+    return result;
+  }
+  std::ostringstream errstream;
+  result.diff_status = diff_func((*left)->AsStringView(),
+                                 (*right)->AsStringView(), &errstream);
+  result.details = errstream.str();
+  return result;
+}
 
-  // Open both files.
-  const auto content1_or = verible::file::GetContentAsString(args[1]);
-  if (!content1_or.ok()) {
-    std::cerr << args[1] << ": " << content1_or.status() << std::endl;
-    return kUserErrorCode;
+// Prints the result of comparing a pair, with the header printed before
+// differences.  Returns the exit code for the pair.
+static int PrintResult(const PairResult& result, absl::string_view header) {
+  switch (result.diff_status) {
+    case verilog::DiffStatus::kEquivalent:
+      return 0;
+    case verilog::DiffStatus::kDifferent: {
+      std::cout << header << "Inputs differ.\n" << result.details << std::endl;
+      return kInputDifferenceErrorCode;
+    }
+    case verilog::DiffStatus::kLeftError: {
+      std::cout << header << "Lexical error in first file.\n"
+                << result.details << std::endl;
+      return kInputDifferenceErrorCode;
+    }
+    case verilog::DiffStatus::kRightError: {
+      std::cout << header << "Lexical error in second file.\n"
+                << result.details << std::endl;
+      return kInputDifferenceErrorCode;
+    }
   }
-  const auto content2_or = verible::file::GetContentAsString(args[2]);
-  if (!content2_or.ok()) {
-    std::cerr << args[1] << ": " << content1_or.status() << std::endl;
-    return kUserErrorCode;
+  return kInputDifferenceErrorCode;
+}
+
+// Reads the pairs of files listed in "manifest".
+static absl::StatusOr<std::vector<FilePair>> ReadFilePairs(
+    absl::string_view manifest) {
+  const auto content = verible::file::GetContentAsString(manifest);
+  if (!content.ok()) return content.status();
+  std::vector<FilePair> pairs;
+  int line_number = 0;
+  for (const absl::string_view line : absl::StrSplit(*content, '\n')) {
+    ++line_number;
+    const absl::string_view stripped = absl::StripAsciiWhitespace(line);
+    if (stripped.empty() || absl::StartsWith(stripped, "#")) continue;
+    const std::vector<absl::string_view> names =
+        absl::StrSplit(stripped, absl::ByAnyChar(" \t"), absl::SkipEmpty());
+    if (names.size() != 2) {
+      return absl::InvalidArgumentError(
+          absl::StrCat(manifest, ":", line_number,
+                       ": expected two file names, separated by whitespace."));
+    }
+    pairs.emplace_back(names[0], names[1]);
+  }
+  return pairs;
+}
+
+// Appends a pair for each file below "left_dir" (recursively), with the file
+// of the same relative path below "right_dir".
+static absl::Status AppendDirectoryPairs(absl::string_view left_dir,
+                                         absl::string_view right_dir,
+                                         std::vector<FilePair>* pairs) {
+  const auto dir = verible::file::ListDir(left_dir);
+  if (!dir.ok()) return dir.status();
+  for (const std::string& file : dir->files) {
+    const absl::string_view relative =
+        absl::StripPrefix(absl::StripPrefix(file, dir->path), "/");
+    pairs->emplace_back(file, verible::file::JoinPath(right_dir, relative));
   }
+  for (const std::string& subdir : dir->directories) {
+    const absl::string_view relative =
+        absl::StripPrefix(absl::StripPrefix(subdir, dir->path), "/");
+    if (auto status = AppendDirectoryPairs(
+            subdir, verible::file::JoinPath(right_dir, relative), pairs);
+        !status.ok()) {
+      return status;
+    }
+  }
+  return absl::OkStatus();
+}
+
+// Compares all "pairs" on "jobs" threads, printing the differences in order
+// and a summary.  Returns the exit code.
+static int CompareManyPairs(const EquivalenceFunctionType& diff_func,
+                            const std::vector<FilePair>& pairs, int jobs) {
+  verible::ThreadPool pool(jobs > 1 ? jobs : 0);
+  int exit_code = 0;
+  size_t different = 0;
+  size_t unreadable = 0;
+  pool.ParallelMapInOrder(
+      pairs.size(),
+      [&](size_t i) { return ComparePair(diff_func, pairs[i]); },
+      [&](size_t i, const PairResult& result) {
+        const FilePair& pair = pairs[i];
+        if (!result.read_status.ok()) {
+          std::cerr << result.read_status << std::endl;
+          ++unreadable;
+          exit_code = kUserErrorCode;
+          return;
+        }
+        const int pair_exit_code = PrintResult(
+            result, absl::StrCat(pair.first, " vs. ", pair.second, ": "));
+        if (pair_exit_code != 0) {
+          ++different;
+          exit_code = std::max(exit_code, pair_exit_code);
+        }
+      });
+  std::cout << "Compared " << pairs.size() << " pairs of files: "
+            << pairs.size() - different - unreadable << " match, " << different
+            << " differ or have lexical errors, " << unreadable
+            << " could not be read." << std::endl;
+  return exit_code;
+}
+
+int main(int argc, char** argv) {
+  const auto usage =
+      absl::StrCat("usage: ", argv[0],
+                   " [options] file1 file2\n"
+                   "       ", argv[0],
+                   " [options] dir1 dir2\n"
+                   "       ", argv[0],
+                   " [options] --file_pairs=manifest\n"
+                   "Use - as a file name to read from stdin.\n"
+                   "With directories, each file below dir1 is compared with "
+                   "the file of the same relative path below dir2.");
+  const auto args = verible::InitCommandLine(usage, &argc, &argv);
 
   // Selection diff-ing function.
   const auto diff_mode = absl::GetFlag(FLAGS_mode);
@@ -119,30 +271,46 @@ int main(int argc, char** argv) {
   CHECK(iter != diff_func_map.end());
   const auto diff_func = iter->second;
 
-  // Compare.
-  std::ostringstream errstream;
-  const auto diff_status = diff_func(*content1_or, *content2_or, &errstream);
-
-  // Signal result of comparison.
-  switch (diff_status) {
-    case verilog::DiffStatus::kEquivalent: {
-      std::cout << "Inputs match." << std::endl;
-      break;
+  std::vector<FilePair> pairs;
+  if (const std::string manifest = absl::GetFlag(FLAGS_file_pairs);
+      !manifest.empty()) {
+    if (args.size() != 1) {
+      std::cerr << "No positional arguments expected with --file_pairs."
+                << std::endl;
+      return kUserErrorCode;
     }
-    case verilog::DiffStatus::kDifferent: {
-      std::cout << "Inputs differ.\n" << errstream.str() << std::endl;
-      return kInputDifferenceErrorCode;
+    auto read_pairs = ReadFilePairs(manifest);
+    if (!read_pairs.ok()) {
+      std::cerr << read_pairs.status() << std::endl;
+      return kUserErrorCode;
     }
-    case verilog::DiffStatus::kLeftError: {
-      std::cout << "Lexical error in first file.\n"
-                << errstream.str() << std::endl;
-      return kInputDifferenceErrorCode;
+    pairs = std::move(*read_pairs);
+  } else if (args.size() != 3) {
+    std::cerr << "Program requires 2 positional arguments for input files."
+              << std::endl;
+    return kUserErrorCode;
+  } else if (verible::file::ListDir(args[1]).ok() &&
+             verible::file::ListDir(args[2]).ok()) {
+    if (auto status = AppendDirectoryPairs(args[1], args[2], &pairs);
+        !status.ok()) {
+      std::cerr << status << std::endl;
+      return kUserErrorCode;
     }
-    case verilog::DiffStatus::kRightError: {
-      std::cout << "Lexical error in second file.\n"
-                << errstream.str() << std::endl;
-      return kInputDifferenceErrorCode;
+  } else {
+    // A single pair of files.
+    const PairResult result = ComparePair(
+        diff_func, FilePair(std::string(args[1]), std::string(args[2])));
+    if (!result.read_status.ok()) {
+      std::cerr << result.read_status << std::endl;
+      return kUserErrorCode;
     }
+    if (result.diff_status == verilog::DiffStatus::kEquivalent) {
+      std::cout << "Inputs match." << std::endl;
+    }
+    return PrintResult(result, "");
   }
-  return 0;
+
+  const int jobs = std::min<int>(
+      verible::JobsOrAllCores(absl::GetFlag(FLAGS_jobs)), pairs.size());
+  return CompareManyPairs(diff_func, pairs, jobs);
 }
@@ -0,0 +1,93 @@
+#!/usr/bin/env bash
+# Copyright 2017-2023 The Verible Authors.
+#
+# Licensed under the Apache License, Version 2.0 (the "License");
+# you may not use this file except in compliance with the License.
+# You may obtain a copy of the License at
+#
+#      http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing, software
+# distributed under the License is distributed on an "AS IS" BASIS,
+# WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+# See the License for the specific language governing permissions and
+# limitations under the License.
+
+# Tests verible-verilog-format formatting the lines added by a diff, with
+# --changed_lines_diff.
+
+declare -r MY_WORK_DIR="${TEST_TMPDIR}/work"
+declare -r MY_DIFF_FILE="${TEST_TMPDIR}/changes.diff"
+declare -r MY_EXPECT_FILE="${TEST_TMPDIR}/myexpect.txt"
+
+# Get tool from argument
+[[ "$#" == 1 ]] || {
+  echo "Expecting 1 positional argument, verible-verilog-format path."
+  exit 1
+}
+formatter="$(rlocation ${TEST_WORKSPACE}/${1})"
+
+mkdir -p "${MY_WORK_DIR}/rtl"
+cd "${MY_WORK_DIR}"
+
+cat > rtl/changed.sv <<EOF
+   parameter   int  var_line_1  =  1  ;
+   parameter   int  var_line_2  =  2  ;
+   parameter   int  var_line_3  =  3  ;
+   parameter   int  var_line_4  =  4  ;
+EOF
+cat > rtl/new.sv <<EOF
+   parameter   int  var_line_1  =  1  ;
+EOF
+cat > rtl/notes.txt <<EOF
+   parameter   int  var_line_1  =  1  ;
+EOF
+
+cat > "${MY_DIFF_FILE}" <<EOF
+diff --git a/rtl/changed.sv b/rtl/changed.sv
+--- a/rtl/changed.sv
++++ b/rtl/changed.sv
+@@ -1,3 +1,4 @@
+    parameter   int  var_line_1  =  1  ;
++   parameter   int  var_line_2  =  2  ;
+    parameter   int  var_line_3  =  3  ;
+    parameter   int  var_line_4  =  4  ;
+diff --git a/rtl/new.sv b/rtl/new.sv
+new file mode 100644
+--- /dev/null
++++ b/rtl/new.sv
+@@ -0,0 +1 @@
++   parameter   int  var_line_1  =  1  ;
+diff --git a/rtl/notes.txt b/rtl/notes.txt
+new file mode 100644
+--- /dev/null
++++ b/rtl/notes.txt
+@@ -0,0 +1 @@
++   parameter   int  var_line_1  =  1  ;
+EOF
+
+"${formatter}" --changed_lines_diff=- --jobs=2 < "${MY_DIFF_FILE}" || exit 1
+
+# Only the added line is formatted.
+cat > "${MY_EXPECT_FILE}" <<EOF
+   parameter   int  var_line_1  =  1  ;
+parameter int var_line_2 = 2;
+   parameter   int  var_line_3  =  3  ;
+   parameter   int  var_line_4  =  4  ;
+EOF
+diff --strip-trailing-cr rtl/changed.sv "${MY_EXPECT_FILE}" || exit 2
+
+# New files are formatted wholly.
+cat > "${MY_EXPECT_FILE}" <<EOF
+parameter int var_line_1 = 1;
+EOF
+diff --strip-trailing-cr rtl/new.sv "${MY_EXPECT_FILE}" || exit 3
+
+# Files that are not Verilog are left alone.
+grep "   parameter   int  var_line_1  =  1  ;" rtl/notes.txt > /dev/null \
+  || exit 4
+
+# Files and a diff don't go together.
+"${formatter}" --changed_lines_diff="${MY_DIFF_FILE}" rtl/new.sv && exit 5
+
+echo "PASS"
@@ -39,4 +39,16 @@ EOF
 ${formatter} --inplace ${MY_OUTPUT_FILE} || exit 1
 diff --strip-trailing-cr "${MY_OUTPUT_FILE}" "${MY_EXPECT_FILE}" || exit 2
 
+# Run formatter on multiple files in parallel.
+declare -r MY_SECOND_OUTPUT_FILE="${TEST_TMPDIR}/myoutput2.txt"
+cat >${MY_OUTPUT_FILE} <<EOF
+  module    m   ;endmodule
+EOF
+cp ${MY_OUTPUT_FILE} ${MY_SECOND_OUTPUT_FILE}
+
+${formatter} --inplace --jobs=2 ${MY_OUTPUT_FILE} ${MY_SECOND_OUTPUT_FILE} \
+  || exit 3
+diff --strip-trailing-cr "${MY_OUTPUT_FILE}" "${MY_EXPECT_FILE}" || exit 4
+diff --strip-trailing-cr "${MY_SECOND_OUTPUT_FILE}" "${MY_EXPECT_FILE}" || exit 5
+
 echo "PASS"
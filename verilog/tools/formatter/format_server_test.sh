@@ -0,0 +1,47 @@
+#!/usr/bin/env bash
+# Copyright 2017-2023 The Verible Authors.
+#
+# Licensed under the Apache License, Version 2.0 (the "License");
+# you may not use this file except in compliance with the License.
+# You may obtain a copy of the License at
+#
+#      http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing, software
+# distributed under the License is distributed on an "AS IS" BASIS,
+# WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+# See the License for the specific language governing permissions and
+# limitations under the License.
+
+# Tests --server mode of verible-verilog-format.
+
+declare -r MY_OUTPUT_FILE="${TEST_TMPDIR}/myoutput.txt"
+declare -r MY_EXPECT_FILE="${TEST_TMPDIR}/myexpect.txt"
+
+# Get tool from argument
+[[ "$#" == 1 ]] || {
+  echo "Expecting 1 positional argument, verible-verilog-format path."
+  exit 1
+}
+formatter="$(rlocation ${TEST_WORKSPACE}/${1})"
+
+cat >${MY_EXPECT_FILE} <<'EOF'
+{"id":1,"status":"ok","text":"module m;\nendmodule\n"}
+{"edits":[{"length":17,"offset":0,"text":"module m;\n"}],"id":2,"status":"ok"}
+{"id":3,"status":"ok","text":"module m;\n    wire x;\nendmodule\n"}
+{"id":4,"message":"Unknown style option \"nope\".","status":"error"}
+{"id":null,"message":"Invalid JSON request.","status":"error"}
+EOF
+
+# All requests are served by one formatter process.
+${formatter} --server > ${MY_OUTPUT_FILE} <<'EOF' || exit 1
+{"id":1,"content":"  module    m   ;endmodule\n"}
+{"id":2,"content":"  module    m   ;endmodule\n","edits":true}
+{"id":3,"content":"module m;wire x;endmodule\n","style":{"indentation_spaces":4}}
+{"id":4,"content":"module m;endmodule\n","style":{"nope":1}}
+not json
+EOF
+
+diff --strip-trailing-cr "${MY_OUTPUT_FILE}" "${MY_EXPECT_FILE}" || exit 2
+
+echo "PASS"
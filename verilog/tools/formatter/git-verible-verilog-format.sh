@@ -21,9 +21,6 @@ script_dir="$(realpath $(dirname $0))"
 formatter="$(which verible-verilog-format)" || \
   formatter="$script_dir"/verible-verilog-format
 
-patch_tool="$(which verible-patch-tool)" || \
-  patch_tool="$script_dir"/verible-patch-tool
-
 function usage() {
   cat <<EOF
 $0:
@@ -35,7 +32,8 @@ Actions:
      To format new files (wholly), 'git add' those before calling this script.
   2) Runs 'git diff -u --cached' to generate a unified diff.
   3) Diff is scanned to determine added or modified lines in each file.
-  4) Invokes 'verible-verilog-format --inplace' on all touched or new Verilog files,
+  4) Invokes 'verible-verilog-format --changed_lines_diff' on the diff, which
+     formats all touched or new Verilog files in place,
      but does not 'git add' so the changes may be examined and tested.
      Formatting can be easily undone with:
        'git diff | git apply --reverse -'.
@@ -99,10 +97,6 @@ done
   msg "  Please specify formatter with: --formatter TOOL."
   exit 1
 }
-[[ -x "$patch_tool" ]] || {
-  msg "*** Required executable '$patch_tool' is missing."
-  exit 1
-}
 
 # collect remainder after stopping option processing
 args=("${args[@]}" "$@")
@@ -126,32 +120,11 @@ msg "Temporary files in: $tempdir"
 
 # Save current workspace in git index.
 git add -u
-# Examine current differences for changed lines.
-# Strip the 'b/' from git diffs.
-# Format only changed lines for each file, one file at a time.
-git diff -u --cached | \
-  tee "$tempdir"/git-cached.diff | \
-  "$patch_tool" changed-lines - | \
-  sed -e 's|^b/||' | \
-  tee "$tempdir"/file-lines.txt | \
-  while read filename lines
-  do
-    # Check file extension: skip non-Verilog files.
-    case "$filename" in
-      *.v | *.vh | *.sv | *.svh ) ;;
-      * ) continue ;;
-    esac
-
-    # If $lines is blank, that implies a new file (format entire file).
-    # Otherwise it is the argument to --lines.
-    lines_flag=()
-    [[ -z "$lines" ]] || lines_flag=("--lines=$lines")
-
-    # Format one file at a time.
-    format_command=("$formatter" --inplace "$filename" "${lines_flag[@]}" "${args[@]}")
-    verbose_command "${format_command[@]}"
-    # Ignore exit statuses and keep going.
-  done
+git diff -u --cached > "$tempdir"/git-cached.diff
+# Format only the changed lines of all touched Verilog files, in one process.
+format_command=("$formatter" --changed_lines_diff="$tempdir"/git-cached.diff \
+  --jobs=0 "${args[@]}")
+verbose_command "${format_command[@]}"
 
 if [[ "$dry_run" = 0 ]]
 then
@@ -22,66 +22,52 @@
 //   0: stdout output can be used to replace original file
 //   nonzero: stdout output (if any) should be discarded
 
+#include <algorithm>
 #include <fstream>
 #include <iostream>
+#include <map>
 #include <memory>
 #include <sstream>  // IWYU pragma: keep  // for ostringstream
 #include <string>   // for string, allocator, etc
+#include <utility>
 #include <vector>
 
 #include "absl/flags/flag.h"
+#include "absl/flags/marshalling.h"
 #include "absl/flags/usage.h"
 #include "absl/status/status.h"
+#include "absl/status/statusor.h"
+#include "absl/strings/ascii.h"
+#include "absl/strings/match.h"
 #include "absl/strings/str_cat.h"
-#include "absl/strings/str_join.h"
-#include "absl/strings/str_split.h"
 #include "absl/strings/string_view.h"
+#include "absl/time/clock.h"
+#include "absl/time/time.h"
+#include "common/strings/mem_block.h"
+#include "common/strings/patch.h"
 #include "common/strings/position.h"
+#include "common/util/file_shards.h"
 #include "common/util/file_util.h"
 #include "common/util/init_command_line.h"
 #include "common/util/interval_set.h"
+#include "common/util/line_ranges_flag.h"
 #include "common/util/logging.h"  // for operator<<, LOG, LogMessage, etc
+#include "common/util/memory_stats.h"
+#include "common/util/thread_pool.h"
+#include "common/util/trace_events.h"
 #include "verilog/formatting/format_style.h"
 #include "verilog/formatting/format_style_init.h"
+#include "nlohmann/json.hpp"
 #include "verilog/formatting/formatter.h"
 
 using absl::StatusCode;
 using verible::LineNumberSet;
+using verible::LineRanges;
 using verilog::formatter::ExecutionControl;
 using verilog::formatter::FormatStyle;
+using verilog::formatter::FormattedItemCache;
 using verilog::formatter::FormatVerilog;
 
-// Pseudo-singleton, so that repeated flag occurrences accumulate values.
-//   --flag x --flag y yields [x, y]
-struct LineRanges {
-  // need to copy string, cannot just use string_view
-  using storage_type = std::vector<std::string>;
-  static storage_type values;
-};
-
-LineRanges::storage_type LineRanges::values;  // global initializer
-
-bool AbslParseFlag(absl::string_view flag_arg, LineRanges* /* unused */,
-                   std::string* error) {
-  auto& values = LineRanges::values;
-  // Pre-split strings, so that "--flag v1,v2" and "--flag v1 --flag v2" are
-  // equivalent.
-  const std::vector<absl::string_view> tokens = absl::StrSplit(flag_arg, ',');
-  values.reserve(values.size() + tokens.size());
-  for (const absl::string_view& token : tokens) {
-    // need to copy string, cannot just use string_view
-    values.emplace_back(token.begin(), token.end());
-  }
-  // Range validation done later.
-  return true;
-}
-
-std::string AbslUnparseFlag(LineRanges /* unused */) {
-  const auto& values = LineRanges::values;
-  return absl::StrJoin(values.begin(), values.end(), ",",
-                       absl::StreamFormatter());
-}
-
 // TODO(fangism): Provide -i alias, as it is canonical to many formatters
 ABSL_FLAG(bool, inplace, false,
           "If true, overwrite the input file on successful conditions.");
@@ -101,6 +87,10 @@ ABSL_FLAG(bool, verify_convergence, true,
           "If true, and not incrementally formatting with --lines, "
           "verify that re-formatting the formatted output yields "
           "no further changes, i.e. formatting is convergent.");
+ABSL_FLAG(bool, fast_verification, false,
+          "If true, verify the formatted output by comparing its tokens to "
+          "the already lexed input instead of re-analyzing it, and only "
+          "re-format changed lines when verifying convergence.");
 
 ABSL_FLAG(bool, verbose, false, "Be more verbose.");
 
@@ -119,34 +109,137 @@ ABSL_FLAG(bool, show_equally_optimal_wrappings, false,
 ABSL_FLAG(int, max_search_states, 100000,
           "Limits the number of search states explored during "
           "line wrap optimization.");
+ABSL_FLAG(absl::Duration, line_wrap_search_line_budget, absl::ZeroDuration(),
+          "If positive, limits the time spent searching the line wrapping of "
+          "each line, e.g. '50ms'.  Lines that take longer get the best "
+          "greedily completed wrapping found by then, which need not be "
+          "optimal, but is not an error (unlike --max_search_states).");
+ABSL_FLAG(absl::Duration, line_wrap_search_file_budget, absl::ZeroDuration(),
+          "If positive, limits the time spent searching the line wrappings of "
+          "all lines of a file, like --line_wrap_search_line_budget does for "
+          "each line.  Once it is used up, lines are wrapped greedily.");
+ABSL_FLAG(bool, line_wrap_search_estimate_cost, false,
+          "If true, guide line wrap searches with a lower bound of the "
+          "remaining cost (A* search), which explores fewer states.  Of "
+          "equally good wrappings, a different one may be chosen.");
+ABSL_FLAG(int, line_wrap_search_threads, 0,
+          "Number of threads used to search line wrappings of independent "
+          "lines within one file. Values <= 1 search serially.");
+ABSL_FLAG(int, alignment_threads, 0,
+          "Number of threads used to calculate alignment of independent "
+          "partitions within one file. Values <= 1 calculate serially.");
+ABSL_FLAG(int, layout_optimizer_threads, 0,
+          "Number of threads used to calculate layouts of the children of "
+          "large partitions. Values <= 1 calculate serially.");
+ABSL_FLAG(bool, concurrent_annotation, false,
+          "If true, annotate inter-token information concurrently with "
+          "determining format-disabled ranges.");
+ABSL_FLAG(bool, show_stage_timings, false,
+          "If true, print the time spent in each formatter stage (stdout).");
+ABSL_FLAG(bool, show_partition_costs, false,
+          "If true, print a JSON report of the time and search effort spent "
+          "on each optimized partition and line wrap search, most expensive "
+          "first (stdout).");
+ABSL_FLAG(bool, print_memory_stats, false,
+          "If true, print the memory used by lexing, parsing and formatting, "
+          "and the peak resident set size, on exit (stderr).");
+ABSL_FLAG(std::string, trace_output, "",
+          "If not empty, write a trace of the parsing and formatter stages "
+          "to this file on exit, in Chrome trace event format "
+          "(chrome://tracing, ui.perfetto.dev).");
+ABSL_FLAG(absl::Duration, per_file_timeout, absl::ZeroDuration(),
+          "If positive, formatting of a file that takes longer than this is "
+          "abandoned, and reported like other formatting failures, e.g. "
+          "'10s' or '500ms'.");
+ABSL_FLAG(int, jobs, 1,
+          "Number of files to format in parallel. 0 uses all available cores. "
+          "Diagnostics are still printed in input file order.");
+ABSL_FLAG(bool, server, false,
+          "If true, keep running and format the files of requests read from "
+          "stdin, one JSON object per line, until stdin is closed, instead of "
+          "the files on the command line.  Formatting state, like the cache of "
+          "formatted items, is kept between requests.");
+ABSL_FLAG(std::string, changed_lines_diff, "",
+          "Unified diff, e.g. from 'git diff -u', or '-' to read it from "
+          "stdin: format the lines it adds to each Verilog file in place, "
+          "instead of the files on the command line.  New files are formatted "
+          "wholly.  Implies --inplace.");
+ABSL_FLAG(int, changed_lines_diff_strip, 1,
+          "Number of leading directories to strip from the file names in "
+          "--changed_lines_diff, like 'patch -p'. 1 strips git's 'b/'.");
+
+static std::ostream& FileMsg(std::ostream& stream, absl::string_view filename) {
+  stream << filename << ": ";
+  return stream;
+}
 
-static std::ostream& FileMsg(absl::string_view filename) {
-  std::cerr << filename << ": ";
-  return std::cerr;
+// Initializes the formatter execution control flags, except for the
+// diagnostic stream.
+static void InitializeControlFromFlags(ExecutionControl* control) {
+  control->show_largest_token_partitions =
+      absl::GetFlag(FLAGS_show_largest_token_partitions);
+  control->show_token_partition_tree =
+      absl::GetFlag(FLAGS_show_token_partition_tree);
+  control->show_inter_token_info = absl::GetFlag(FLAGS_show_inter_token_info);
+  control->show_equally_optimal_wrappings =
+      absl::GetFlag(FLAGS_show_equally_optimal_wrappings);
+  control->max_search_states = absl::GetFlag(FLAGS_max_search_states);
+  control->verify_convergence = absl::GetFlag(FLAGS_verify_convergence);
+  control->fast_verification = absl::GetFlag(FLAGS_fast_verification);
+  control->line_wrap_search_threads =
+      absl::GetFlag(FLAGS_line_wrap_search_threads);
+  control->line_wrap_search_estimate_cost =
+      absl::GetFlag(FLAGS_line_wrap_search_estimate_cost);
+  control->alignment_threads = absl::GetFlag(FLAGS_alignment_threads);
+  control->layout_optimizer_threads =
+      absl::GetFlag(FLAGS_layout_optimizer_threads);
+  control->concurrent_annotation = absl::GetFlag(FLAGS_concurrent_annotation);
+  control->show_stage_timings = absl::GetFlag(FLAGS_show_stage_timings);
+  control->show_partition_costs = absl::GetFlag(FLAGS_show_partition_costs);
+  if (const absl::Duration budget =
+          absl::GetFlag(FLAGS_line_wrap_search_line_budget);
+      budget > absl::ZeroDuration()) {
+    control->line_wrap_search_line_budget = budget;
+  }
+  if (const absl::Duration budget =
+          absl::GetFlag(FLAGS_line_wrap_search_file_budget);
+      budget > absl::ZeroDuration()) {
+    control->line_wrap_search_file_budget = budget;
+  }
+  if (const absl::Duration timeout = absl::GetFlag(FLAGS_per_file_timeout);
+      timeout > absl::ZeroDuration()) {
+    const absl::Time deadline = absl::Now() + timeout;
+    control->is_cancelled = [deadline]() { return absl::Now() > deadline; };
+  }
 }
 
+// Formats one file. Formatted output and diagnostics of the debugging modes
+// are written to 'out', all other messages go to 'err'.
+// Returns true on success (or failure tolerated by --failsafe_success).
 static bool formatOneFile(absl::string_view filename,
-                          const LineNumberSet& lines_to_format) {
+                          const LineNumberSet& lines_to_format,
+                          std::ostream& out, std::ostream& err) {
   const bool inplace = absl::GetFlag(FLAGS_inplace);
   const bool is_stdin = filename == "-";
   const auto& stdin_name = absl::GetFlag(FLAGS_stdin_name);
 
   if (inplace && is_stdin) {
-    FileMsg(filename)
+    FileMsg(err, filename)
         << "--inplace is incompatible with stdin.  Ignoring --inplace "
         << "and writing to stdout." << std::endl;
   }
 
   const auto diagnostic_filename = is_stdin ? stdin_name : filename;
 
-  // Read contents into memory first.
-  const absl::StatusOr<std::string> content_or =
-      verible::file::GetContentAsString(filename);
+  // Read contents into memory first; files are memory-mapped if possible.
+  absl::StatusOr<std::unique_ptr<verible::MemBlock>> content_or =
+      verible::file::GetContentAsMemBlock(filename);
   if (!content_or.ok()) {
     // Not using FileMsg(): file status already has filename attached.
-    std::cerr << content_or.status().message() << std::endl;
+    err << content_or.status().message() << std::endl;
     return false;
   }
+  const std::shared_ptr<verible::MemBlock> content = std::move(*content_or);
 
   // TODO(fangism): When requesting --inplace, verify that file
   // is write-able, and fail-early if it is not.
@@ -156,47 +249,32 @@ static bool formatOneFile(absl::string_view filename,
 
   // Handle special debugging modes.
   ExecutionControl formatter_control;
-  {
-    // execution control flags
-    formatter_control.stream = &std::cout;  // for diagnostics only
-    formatter_control.show_largest_token_partitions =
-        absl::GetFlag(FLAGS_show_largest_token_partitions);
-    formatter_control.show_token_partition_tree =
-        absl::GetFlag(FLAGS_show_token_partition_tree);
-    formatter_control.show_inter_token_info =
-        absl::GetFlag(FLAGS_show_inter_token_info);
-    formatter_control.show_equally_optimal_wrappings =
-        absl::GetFlag(FLAGS_show_equally_optimal_wrappings);
-    formatter_control.max_search_states =
-        absl::GetFlag(FLAGS_max_search_states);
-    formatter_control.verify_convergence =
-        absl::GetFlag(FLAGS_verify_convergence);
-  }
+  InitializeControlFromFlags(&formatter_control);
+  formatter_control.stream = &out;  // for diagnostics only
 
-  std::ostringstream stream;
+  std::string formatted_output;
   const auto format_status =
-      FormatVerilog(*content_or, diagnostic_filename, format_style, stream,
-                    lines_to_format, formatter_control);
+      FormatVerilog(content, diagnostic_filename, format_style,
+                    &formatted_output, lines_to_format, formatter_control);
 
-  const std::string& formatted_output(stream.str());
   if (!format_status.ok()) {
     if (!inplace) {
       // Fall back to printing original content regardless of error condition.
-      std::cout << *content_or;
+      out << content->AsStringView();
     }
     switch (format_status.code()) {
       case StatusCode::kCancelled:
       case StatusCode::kInvalidArgument:
-        FileMsg(filename) << format_status.message() << std::endl;
+        FileMsg(err, filename) << format_status.message() << std::endl;
         break;
       case StatusCode::kDataLoss:
-        FileMsg(filename) << format_status.message()
-                          << "; problematic formatter output is\n"
-                          << formatted_output << "<<EOF>>" << std::endl;
+        FileMsg(err, filename) << format_status.message()
+                               << "; problematic formatter output is\n"
+                               << formatted_output << "<<EOF>>" << std::endl;
         break;
       default:
-        FileMsg(filename) << format_status.message() << "[other error status]"
-                          << std::endl;
+        FileMsg(err, filename)
+            << format_status.message() << "[other error status]" << std::endl;
         break;
     }
 
@@ -207,29 +285,336 @@ static bool formatOneFile(absl::string_view filename,
   if (inplace && !is_stdin) {
     // Don't write if the output is exactly as the input, so that we don't mess
     // with tools that look for timestamp changes (such as make).
-    if (*content_or != formatted_output) {
+    // A mapped file must not be read after it is overwritten.
+    if (content->AsStringView() != formatted_output) {
       if (auto status = verible::file::SetContents(filename, formatted_output);
           !status.ok()) {
-        FileMsg(filename) << "error writing result " << status << std::endl;
+        FileMsg(err, filename)
+            << "error writing result " << status << std::endl;
         return false;
       }
     } else if (absl::GetFlag(FLAGS_verbose)) {
-      FileMsg(filename) << "Already formatted, no change." << std::endl;
+      FileMsg(err, filename) << "Already formatted, no change." << std::endl;
     }
   } else {
-    std::cout << formatted_output;
+    out << formatted_output;
   }
 
   return true;
 }
 
+// Result slot of one file formatted in parallel.
+struct BufferedFormatResult {
+  bool success = false;
+  absl::Duration time;  // spent formatting the file
+  std::string out_text;
+  std::string err_text;
+};
+
+// Formats all files on a thread pool of 'jobs' threads, each only on its
+// lines of 'lines_to_format', which is parallel to 'filenames'.  Each file
+// writes into its own result slot; slots are flushed to stdout/stderr
+// strictly in the order of 'filenames', so messages are deterministic.
+// Appends the time each file took to 'shard_costs'.
+// Returns true if all files were formatted successfully.
+static bool FormatFilesInParallel(
+    const std::vector<absl::string_view>& filenames,
+    const std::vector<LineNumberSet>& lines_to_format, int jobs,
+    std::string* shard_costs) {
+  verible::ThreadPool pool(jobs);
+  bool all_success = true;
+  pool.ParallelMapInOrder(
+      filenames.size(),
+      [&](size_t i) {
+        const absl::Time start = absl::Now();
+        BufferedFormatResult result;
+        std::ostringstream out;
+        std::ostringstream err;
+        result.success =
+            formatOneFile(filenames[i], lines_to_format[i], out, err);
+        result.time = absl::Now() - start;
+        result.out_text = out.str();
+        result.err_text = err.str();
+        return result;
+      },
+      [&](size_t i, const BufferedFormatResult& result) {
+        absl::StrAppend(shard_costs,
+                        verible::FileCostLine(filenames[i], result.time));
+        std::cout << result.out_text << std::flush;
+        std::cerr << result.err_text << std::flush;
+        all_success &= result.success;
+      });
+  return all_success;
+}
+
+// Sets the fields of 'style' named by the keys of 'overrides' (a JSON object)
+// to its values, which are given like the values of the same-named flags.
+static absl::Status ApplyStyleOverrides(const nlohmann::json& overrides,
+                                        FormatStyle* style) {
+  if (!overrides.is_object()) {
+    return absl::InvalidArgumentError("\"style\" must be an object.");
+  }
+  for (const auto& item : overrides.items()) {
+    const absl::string_view name = item.key();
+    const std::string value = item.value().is_string()
+                                  ? item.value().get<std::string>()
+                                  : item.value().dump();
+    std::string error;
+    bool known = false;
+    bool parsed = false;
+#define STYLE_FROM_JSON(field)                              \
+  if (name == #field) {                                     \
+    known = true;                                           \
+    parsed = absl::ParseFlag(value, &style->field, &error); \
+  }
+    STYLE_FROM_JSON(indentation_spaces);
+    STYLE_FROM_JSON(wrap_spaces);
+    STYLE_FROM_JSON(column_limit);
+    STYLE_FROM_JSON(over_column_limit_penalty);
+    STYLE_FROM_JSON(line_break_penalty);
+    STYLE_FROM_JSON(port_declarations_indentation);
+    STYLE_FROM_JSON(port_declarations_alignment);
+    STYLE_FROM_JSON(struct_union_members_alignment);
+    STYLE_FROM_JSON(named_parameter_indentation);
+    STYLE_FROM_JSON(named_parameter_alignment);
+    STYLE_FROM_JSON(named_port_indentation);
+    STYLE_FROM_JSON(named_port_alignment);
+    STYLE_FROM_JSON(module_net_variable_alignment);
+    STYLE_FROM_JSON(assignment_statement_alignment);
+    STYLE_FROM_JSON(enum_assignment_statement_alignment);
+    STYLE_FROM_JSON(formal_parameters_indentation);
+    STYLE_FROM_JSON(formal_parameters_alignment);
+    STYLE_FROM_JSON(class_member_variable_alignment);
+    STYLE_FROM_JSON(case_items_alignment);
+    STYLE_FROM_JSON(distribution_items_alignment);
+    STYLE_FROM_JSON(port_declarations_right_align_packed_dimensions);
+    STYLE_FROM_JSON(port_declarations_right_align_unpacked_dimensions);
+    STYLE_FROM_JSON(try_wrap_long_lines);
+    STYLE_FROM_JSON(expand_coverpoints);
+    STYLE_FROM_JSON(compact_indexing_and_selections);
+#undef STYLE_FROM_JSON
+    if (!known) {
+      return absl::InvalidArgumentError(
+          absl::StrCat("Unknown style option \"", name, "\"."));
+    }
+    if (!parsed) {
+      return absl::InvalidArgumentError(absl::StrCat(
+          "Invalid value for style option \"", name, "\": ", error));
+    }
+  }
+  return absl::OkStatus();
+}
+
+// Returns the edit that turns 'original' into 'formatted': the replacement
+// of the differing middle part of the texts, as byte offset, byte length in
+// 'original' and replacement text.  Returns an empty list if they are equal.
+static nlohmann::json ReplacementEdits(absl::string_view original,
+                                       absl::string_view formatted) {
+  nlohmann::json edits = nlohmann::json::array();
+  if (original == formatted) return edits;
+  size_t prefix = 0;
+  const size_t max_common = std::min(original.length(), formatted.length());
+  while (prefix < max_common && original[prefix] == formatted[prefix]) {
+    ++prefix;
+  }
+  size_t suffix = 0;
+  while (suffix < max_common - prefix &&
+         original[original.length() - suffix - 1] ==
+             formatted[formatted.length() - suffix - 1]) {
+    ++suffix;
+  }
+  edits.push_back({
+      {"offset", prefix},
+      {"length", original.length() - prefix - suffix},
+      {"text", std::string(formatted.substr(
+                   prefix, formatted.length() - prefix - suffix))},
+  });
+  return edits;
+}
+
+// Formats the file of one server request (see RunFormatServer()), and returns
+// the response.  'cache' is shared by all requests.
+static nlohmann::json FormatServerRequest(const nlohmann::json& request,
+                                          FormattedItemCache* cache) {
+  const auto id = request.find("id");
+  nlohmann::json response = {
+      {"id", id != request.end() ? *id : nlohmann::json()}};
+  const auto fail = [&response](absl::string_view message) {
+    response["status"] = "error";
+    response["message"] = std::string(message);
+    return response;
+  };
+
+  const std::string filename = request.value("filename", "<stdin>");
+  std::string content;
+  if (const auto content_field = request.find("content");
+      content_field != request.end() && content_field->is_string()) {
+    content = content_field->get<std::string>();
+  } else {
+    const absl::StatusOr<std::string> content_or =
+        verible::file::GetContentAsString(filename);
+    if (!content_or.ok()) return fail(content_or.status().message());
+    content = *content_or;
+  }
+
+  LineNumberSet lines_to_format;
+  if (const auto lines = request.find("lines"); lines != request.end()) {
+    std::vector<std::string> ranges;
+    if (lines->is_array()) {
+      for (const auto& range : *lines) {
+        if (!range.is_string()) return fail("\"lines\" must be strings.");
+        ranges.push_back(range.get<std::string>());
+      }
+    }
+    std::ostringstream errstream;
+    if (!lines->is_array() ||
+        !verible::ParseInclusiveRanges(&lines_to_format, ranges.begin(),
+                                       ranges.end(), &errstream, '-')) {
+      return fail(absl::StrCat("Error parsing \"lines\". ", errstream.str()));
+    }
+  }
+
+  FormatStyle format_style;
+  verilog::formatter::InitializeFromFlags(&format_style);
+  if (const auto style = request.find("style"); style != request.end()) {
+    if (auto status = ApplyStyleOverrides(*style, &format_style);
+        !status.ok()) {
+      return fail(status.message());
+    }
+  }
+
+  ExecutionControl formatter_control;
+  InitializeControlFromFlags(&formatter_control);
+  formatter_control.stream = &std::cerr;  // stdout is for responses
+  formatter_control.formatted_item_cache = cache;
+
+  std::string formatted_output;
+  const auto format_status =
+      FormatVerilog(content, filename, format_style, &formatted_output,
+                    lines_to_format, formatter_control);
+  if (!format_status.ok()) return fail(format_status.message());
+
+  response["status"] = "ok";
+  if (request.value("edits", false)) {
+    response["edits"] = ReplacementEdits(content, formatted_output);
+  } else {
+    response["text"] = std::move(formatted_output);
+  }
+  return response;
+}
+
+// Serves formatting requests from stdin until it is closed, so that editor and
+// pre-commit integrations need not start a formatter for every file.  Each
+// line is a JSON object:
+//   {"id": <any, returned in the response>,
+//    "filename": <name; the file is read if there is no "content">,
+//    "content": <text to format>,
+//    "lines": [<"N-M" or "N" ranges, like --lines>],
+//    "style": {<format style flag name>: <value>, ...},
+//    "edits": <if true, respond with edits instead of the formatted text>}
+// and is answered with one line of JSON object:
+//   {"id": <id>, "status": "ok", "text": <formatted text>} or
+//   {"id": <id>, "status": "ok", "edits": [{"offset": <byte offset>,
+//                                           "length": <bytes replaced>,
+//                                           "text": <replacement>}]} or
+//   {"id": <id>, "status": "error", "message": <why the text is unchanged>}
+static int RunFormatServer() {
+  FormattedItemCache cache;
+  std::string line;
+  while (std::getline(std::cin, line)) {
+    const absl::string_view request_text = absl::StripAsciiWhitespace(line);
+    if (request_text.empty()) continue;
+    const auto request = nlohmann::json::parse(request_text, nullptr,
+                                               /*allow_exceptions=*/false);
+    nlohmann::json response;
+    if (request.is_object()) {
+      response = FormatServerRequest(request, &cache);
+    } else {
+      response = {{"id", nullptr},
+                  {"status", "error"},
+                  {"message", "Invalid JSON request."}};
+    }
+    std::cout << response.dump(-1, ' ', false,
+                               nlohmann::json::error_handler_t::replace)
+              << std::endl;
+  }
+  return 0;
+}
+
+// Verilog files of which lines are added by the unified diff read from
+// 'diff_file', with leading directories stripped by 'strip' like
+// 'patch -p'.
+struct ChangedLines {
+  std::vector<std::string> filenames;
+  std::vector<LineNumberSet> lines;  // Parallel to filenames.
+};
+
+static absl::StatusOr<ChangedLines> ChangedLinesFromDiff(
+    absl::string_view diff_file, int strip) {
+  absl::StatusOr<std::unique_ptr<verible::MemBlock>> diff =
+      verible::file::GetContentAsMemBlock(diff_file);
+  if (!diff.ok()) return diff.status();
+  verible::PatchSet patch_set;
+  if (absl::Status status = patch_set.Parse(*std::move(diff)); !status.ok()) {
+    return status;
+  }
+  ChangedLines changed;
+  for (const auto& [path, lines] :
+       patch_set.AddedLinesMap(/*new_file_ranges=*/true)) {
+    if (lines.empty()) continue;  // Only lines removed.
+    absl::string_view filename = path;
+    for (int i = 0; i < strip; ++i) {
+      const size_t slash = filename.find('/');
+      if (slash == absl::string_view::npos) break;
+      filename.remove_prefix(slash + 1);
+    }
+    if (!absl::EndsWith(filename, ".sv") && !absl::EndsWith(filename, ".svh") &&
+        !absl::EndsWith(filename, ".v") && !absl::EndsWith(filename, ".vh")) {
+      continue;
+    }
+    changed.filenames.emplace_back(filename);
+    changed.lines.push_back(lines);
+  }
+  return changed;
+}
+
+// Writes 'shard_costs' to --shard_costs_output, if set.
+// Returns false if the file can't be written.
+static bool WriteShardCosts(absl::string_view shard_costs) {
+  if (const absl::Status status =
+          verible::WriteShardCostsFromFlags(shard_costs);
+      !status.ok()) {
+    std::cerr << status.message() << std::endl;
+    return false;
+  }
+  return true;
+}
+
 int main(int argc, char** argv) {
   const auto usage = absl::StrCat("usage: ", argv[0],
                                   " [options] <file> [<file...>]\n"
                                   "To pipe from stdin, use '-' as <file>.");
   const auto file_args = verible::InitCommandLine(usage, &argc, &argv);
 
-  if (file_args.size() == 1) {
+  if (absl::GetFlag(FLAGS_print_memory_stats)) {
+    verible::EnableSubsystemMemoryStats();
+  }
+  if (const std::string trace_output = absl::GetFlag(FLAGS_trace_output);
+      !trace_output.empty()) {
+    verible::EnableTraceOutput(trace_output);
+  }
+
+  if (absl::GetFlag(FLAGS_server)) {
+    if (file_args.size() > 1) {
+      std::cerr << "Files on the command line are ignored with --server."
+                << std::endl;
+    }
+    return RunFormatServer();
+  }
+
+  const std::string changed_lines_diff =
+      absl::GetFlag(FLAGS_changed_lines_diff);
+  if (file_args.size() == 1 && changed_lines_diff.empty()) {
     std::cerr << absl::ProgramUsageMessage() << std::endl;
     // TODO(hzeller): how can we append the output of --help here ?
     return 1;
@@ -259,12 +644,69 @@ int main(int argc, char** argv) {
     }
   }
 
-  bool all_success = true;
   // All positional arguments are file names.  Exclude program name.
-  for (const absl::string_view filename :
-       verible::make_range(file_args.begin() + 1, file_args.end())) {
-    all_success &= formatOneFile(filename, lines_to_format);
+  std::vector<absl::string_view> all_files(file_args.begin() + 1,
+                                           file_args.end());
+  // With --changed_lines_diff, the files of the diff instead, and the lines
+  // to format in each.
+  ChangedLines changed;
+  std::map<absl::string_view, const LineNumberSet*> changed_lines_of_file;
+  if (!changed_lines_diff.empty()) {
+    if (!all_files.empty() || !lines_to_format.empty()) {
+      std::cerr << "--changed_lines_diff takes neither files nor --lines."
+                << std::endl;
+      return 1;
+    }
+    absl::StatusOr<ChangedLines> changed_or = ChangedLinesFromDiff(
+        changed_lines_diff, absl::GetFlag(FLAGS_changed_lines_diff_strip));
+    if (!changed_or.ok()) {
+      std::cerr << changed_or.status().message() << std::endl;
+      return 1;
+    }
+    changed = *std::move(changed_or);
+    absl::SetFlag(&FLAGS_inplace, true);
+    for (size_t i = 0; i < changed.filenames.size(); ++i) {
+      all_files.push_back(changed.filenames[i]);
+      changed_lines_of_file[changed.filenames[i]] = &changed.lines[i];
+    }
+  }
+
+  const absl::StatusOr<std::vector<absl::string_view>> shard_files =
+      verible::FilesOfShardFromFlags(all_files);
+  if (!shard_files.ok()) {
+    std::cerr << shard_files.status().message() << std::endl;
+    return 1;
+  }
+  const std::vector<absl::string_view>& filenames = *shard_files;
+  std::vector<LineNumberSet> lines_of_files;  // Parallel to filenames.
+  lines_of_files.reserve(filenames.size());
+  for (const absl::string_view filename : filenames) {
+    lines_of_files.push_back(changed_lines_diff.empty()
+                                 ? lines_to_format
+                                 : *changed_lines_of_file[filename]);
+  }
+  // Time each file took to format, for --shard_costs_output.
+  std::string shard_costs;
+
+  const int jobs = std::min<int>(
+      verible::JobsOrAllCores(absl::GetFlag(FLAGS_jobs)), filenames.size());
+  if (jobs > 1) {
+    bool all_success =
+        FormatFilesInParallel(filenames, lines_of_files, jobs, &shard_costs);
+    all_success &= WriteShardCosts(shard_costs);
+    return all_success ? 0 : 1;
+  }
+
+  bool all_success = true;
+  for (size_t i = 0; i < filenames.size(); ++i) {
+    const absl::string_view filename = filenames[i];
+    const absl::Time start = absl::Now();
+    all_success &=
+        formatOneFile(filename, lines_of_files[i], std::cout, std::cerr);
+    absl::StrAppend(&shard_costs,
+                    verible::FileCostLine(filename, absl::Now() - start));
   }
+  all_success &= WriteShardCosts(shard_costs);
 
   return all_success ? 0 : 1;
 }
@@ -0,0 +1,166 @@
+// Copyright 2017-2023 The Verible Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "verilog/tools/kythe/indexing_facts_cache.h"
+
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "absl/status/status.h"
+#include "absl/status/statusor.h"
+#include "absl/strings/str_cat.h"
+#include "absl/strings/string_view.h"
+#include "common/util/file_util.h"
+#include "common/util/varint_coding.h"
+#include "verilog/analysis/parse_cache.h"
+#include "verilog/tools/kythe/indexing_facts_tree.h"
+#include "verilog/tools/kythe/verilog_extractor_indexing_fact_type.h"
+
+namespace verilog {
+namespace kythe {
+
+// Changes whenever the format of entries does.
+static constexpr absl::string_view kMagic = "verible-indexing-facts-1\n";
+
+using verible::PutString;
+using verible::PutVarint;
+using verible::VarintReader;
+
+// Facts trees are written depth-first: a node's type, its anchors, the
+// number of its children and then each of them.
+static void PutTree(const IndexingFactNode& node, std::string* out) {
+  const IndexingNodeData& data = node.Value();
+  PutVarint(static_cast<uint64_t>(data.GetIndexingFactType()), out);
+  PutVarint(data.Anchors().size(), out);
+  for (const Anchor& anchor : data.Anchors()) {
+    PutString(anchor.Text(), out);
+    // Shifted by one, so that 0 stands for anchors without a range.
+    const auto& range = anchor.SourceTextRange();
+    PutVarint(range ? range->begin + 1 : 0, out);
+    if (range) PutVarint(range->length, out);
+  }
+  PutVarint(node.Children().size(), out);
+  for (const IndexingFactNode& child : node.Children()) PutTree(child, out);
+}
+
+// Returns nullopt if the entry is malformed.
+static std::optional<IndexingFactNode> ReadTree(VarintReader* reader) {
+  uint64_t type, anchors;
+  if (!reader->Varint(&type) ||
+      type > static_cast<uint64_t>(IndexingFactType::kMemberReference) ||
+      !reader->Varint(&anchors)) {
+    return std::nullopt;
+  }
+  IndexingNodeData data(static_cast<IndexingFactType>(type));
+  for (uint64_t i = 0; i < anchors; ++i) {
+    absl::string_view text;
+    uint64_t begin, length;
+    if (!reader->String(&text) || !reader->Varint(&begin)) {
+      return std::nullopt;
+    }
+    if (begin == 0) {
+      data.AppendAnchor(Anchor(text));
+      continue;
+    }
+    if (!reader->Varint(&length)) return std::nullopt;
+    data.AppendAnchor(Anchor(text, begin - 1, length));
+  }
+  IndexingFactNode node(std::move(data));
+  uint64_t children;
+  if (!reader->Varint(&children)) return std::nullopt;
+  for (uint64_t i = 0; i < children; ++i) {
+    std::optional<IndexingFactNode> child = ReadTree(reader);
+    if (!child) return std::nullopt;
+    node.Children().push_back(std::move(*child));
+  }
+  return node;
+}
+
+std::string IndexingFactsCachePath(absl::string_view dir,
+                                   absl::string_view resolved_path,
+                                   absl::string_view text) {
+  // The path of the file is part of its facts.
+  return ParseCachePath(dir, text,
+                        absl::StrCat(kMagic, "path: ", resolved_path), ".vkft");
+}
+
+std::string SerializeIndexingFacts(
+    const IndexingFactNode& facts_tree,
+    const std::vector<IncludedFile>& included_files) {
+  std::string bytes(kMagic);
+  PutVarint(included_files.size(), &bytes);
+  for (const IncludedFile& included_file : included_files) {
+    PutString(included_file.referenced_path, &bytes);
+    PutString(included_file.resolved_path, &bytes);
+  }
+  PutTree(facts_tree, &bytes);
+  return bytes;
+}
+
+absl::StatusOr<CachedIndexingFacts> DeserializeIndexingFacts(
+    absl::string_view bytes) {
+  const auto malformed = []() {
+    return absl::DataLossError("Malformed indexing facts cache entry.");
+  };
+  VarintReader reader(bytes);
+  uint64_t included_files;
+  if (!reader.Prefix(kMagic) || !reader.Varint(&included_files)) {
+    return malformed();
+  }
+  std::vector<IncludedFile> included;
+  for (uint64_t i = 0; i < included_files; ++i) {
+    absl::string_view referenced_path, resolved_path;
+    if (!reader.String(&referenced_path) || !reader.String(&resolved_path)) {
+      return malformed();
+    }
+    included.push_back(
+        {std::string(referenced_path), std::string(resolved_path)});
+  }
+  std::optional<IndexingFactNode> facts_tree = ReadTree(&reader);
+  if (!facts_tree || !reader.AtEnd()) return malformed();
+  return CachedIndexingFacts{std::move(*facts_tree), std::move(included)};
+}
+
+absl::StatusOr<CachedIndexingFacts> LoadIndexingFactsCacheEntry(
+    absl::string_view path, absl::string_view text) {
+  if (!verible::file::FileExists(std::string(path)).ok()) {
+    return absl::NotFoundError(absl::StrCat(path, ": not in cache."));
+  }
+  const absl::StatusOr<std::string> bytes =
+      verible::file::GetContentAsString(path);
+  if (!bytes.ok()) return bytes.status();
+  absl::StatusOr<CachedIndexingFacts> facts = DeserializeIndexingFacts(*bytes);
+  if (!facts.ok()) return facts.status();
+  // The file node holds the whole text, which guards against hash collisions.
+  const std::vector<Anchor>& anchors = facts->facts_tree.Value().Anchors();
+  if (anchors.size() < 2 || anchors[1].Text() != text) {
+    return absl::NotFoundError(
+        absl::StrCat(path, ": cache entry of a different text."));
+  }
+  return facts;
+}
+
+absl::Status StoreIndexingFactsCacheEntry(
+    absl::string_view path, const IndexingFactNode& facts_tree,
+    const std::vector<IncludedFile>& included_files) {
+  // Readers only ever see complete entries.
+  return verible::file::SetContentsAtomically(
+      path, SerializeIndexingFacts(facts_tree, included_files));
+}
+
+}  // namespace kythe
+}  // namespace verilog
@@ -0,0 +1,80 @@
+// Copyright 2017-2023 The Verible Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// Cache of the indexing facts trees of files, so that files that did not
+// change since the last extraction are neither parsed nor extracted again.
+// Entries live in the parse cache directory (--parse_cache_dir), next to the
+// parsing results, named after a hash of the file's text, its path and the
+// tool version.  The facts tree of a file only depends on those, and on the
+// paths its `include directives resolve to, which each entry records and
+// which are checked before it is used.
+
+#ifndef VERIBLE_VERILOG_TOOLS_KYTHE_INDEXING_FACTS_CACHE_H_
+#define VERIBLE_VERILOG_TOOLS_KYTHE_INDEXING_FACTS_CACHE_H_
+
+#include <string>
+#include <vector>
+
+#include "absl/status/status.h"
+#include "absl/status/statusor.h"
+#include "absl/strings/string_view.h"
+#include "verilog/tools/kythe/indexing_facts_tree.h"
+
+namespace verilog {
+namespace kythe {
+
+// A file included by another one.
+struct IncludedFile {
+  std::string referenced_path;  // As in the `include directive.
+  std::string resolved_path;    // Found in the include paths.
+
+  bool operator==(const IncludedFile& other) const {
+    return referenced_path == other.referenced_path &&
+           resolved_path == other.resolved_path;
+  }
+};
+
+// The facts tree of a file (with tag kFile), and the files it includes, in
+// the order of the `include directives.
+struct CachedIndexingFacts {
+  IndexingFactNode facts_tree;
+  std::vector<IncludedFile> included_files;
+};
+
+// Returns the path of the entry for the file at "resolved_path" with "text"
+// in cache directory "dir".
+std::string IndexingFactsCachePath(absl::string_view dir,
+                                   absl::string_view resolved_path,
+                                   absl::string_view text);
+
+std::string SerializeIndexingFacts(
+    const IndexingFactNode& facts_tree,
+    const std::vector<IncludedFile>& included_files);
+absl::StatusOr<CachedIndexingFacts> DeserializeIndexingFacts(
+    absl::string_view bytes);
+
+// Returns the facts of the cache entry "path", which must be one of the file
+// with "text".  Returns NotFoundError if there is no such entry.
+absl::StatusOr<CachedIndexingFacts> LoadIndexingFactsCacheEntry(
+    absl::string_view path, absl::string_view text);
+
+// Writes the facts tree and included files of a file as cache entry "path".
+absl::Status StoreIndexingFactsCacheEntry(
+    absl::string_view path, const IndexingFactNode& facts_tree,
+    const std::vector<IncludedFile>& included_files);
+
+}  // namespace kythe
+}  // namespace verilog
+
+#endif  // VERIBLE_VERILOG_TOOLS_KYTHE_INDEXING_FACTS_CACHE_H_
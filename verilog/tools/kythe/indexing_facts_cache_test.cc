@@ -0,0 +1,104 @@
+// Copyright 2017-2023 The Verible Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "verilog/tools/kythe/indexing_facts_cache.h"
+
+#include <cstdio>
+#include <string>
+#include <vector>
+
+#include "absl/status/status.h"
+#include "absl/strings/string_view.h"
+#include "common/util/tree_operations.h"
+#include "gtest/gtest.h"
+#include "verilog/tools/kythe/indexing_facts_tree.h"
+
+namespace verilog {
+namespace kythe {
+namespace {
+
+using T = IndexingFactNode;
+using D = IndexingNodeData;
+
+constexpr absl::string_view kText =
+    "`include \"a.svh\"\nmodule m;\nendmodule\n";
+
+IndexingFactNode FileFactsTree() {
+  return T(D{IndexingFactType::kFile, Anchor("/path/to/m.sv"), Anchor(kText)},
+           T(D{IndexingFactType::kInclude, Anchor("\"a.svh\"", 9, 7),
+               Anchor("/inc/a.svh")}),
+           T(D{IndexingFactType::kModule, Anchor("m", 24, 1)},
+             T(D{IndexingFactType::kAnonymousScope,
+                 Anchor("anonymous-scope-0")})));
+}
+
+void ExpectSameTrees(const IndexingFactNode& left,
+                     const IndexingFactNode& right) {
+  const auto result_pair = DeepEqual(left, right);
+  EXPECT_EQ(result_pair.left, nullptr) << *result_pair.left;
+  EXPECT_EQ(result_pair.right, nullptr) << *result_pair.right;
+}
+
+TEST(IndexingFactsCacheTest, SerializationRoundTrip) {
+  const IndexingFactNode tree = FileFactsTree();
+  const std::vector<IncludedFile> included_files = {{"a.svh", "/inc/a.svh"}};
+  const std::string bytes = SerializeIndexingFacts(tree, included_files);
+
+  const auto facts = DeserializeIndexingFacts(bytes);
+  ASSERT_TRUE(facts.ok()) << facts.status();
+  ExpectSameTrees(facts->facts_tree, tree);
+  EXPECT_EQ(facts->included_files, included_files);
+  // Anchors keep their ranges, or lack thereof.
+  EXPECT_FALSE(facts->facts_tree.Value().Anchors()[0].SourceTextRange());
+  ASSERT_TRUE(facts->facts_tree.Children()[1].Value().Anchors()[0]
+                  .SourceTextRange());
+  EXPECT_EQ(facts->facts_tree.Children()[1]
+                .Value()
+                .Anchors()[0]
+                .SourceTextRange()
+                ->begin,
+            24);
+}
+
+TEST(IndexingFactsCacheTest, RejectsMalformedEntries) {
+  const std::string bytes = SerializeIndexingFacts(FileFactsTree(), {});
+  for (size_t size = 0; size < bytes.size(); ++size) {
+    EXPECT_FALSE(DeserializeIndexingFacts(bytes.substr(0, size)).ok())
+        << size;
+  }
+  EXPECT_FALSE(DeserializeIndexingFacts(bytes + "x").ok());
+}
+
+TEST(IndexingFactsCacheTest, StoreAndLoad) {
+  const std::string dir = ::testing::TempDir();
+  const std::string path =
+      IndexingFactsCachePath(dir, "/path/to/m.sv", kText);
+  EXPECT_NE(path, IndexingFactsCachePath(dir, "/path/to/n.sv", kText));
+  EXPECT_NE(path, IndexingFactsCachePath(dir, "/path/to/m.sv", "module n;"));
+  EXPECT_EQ(LoadIndexingFactsCacheEntry(path, kText).status().code(),
+            absl::StatusCode::kNotFound);
+
+  ASSERT_TRUE(StoreIndexingFactsCacheEntry(path, FileFactsTree(), {}).ok());
+  const auto facts = LoadIndexingFactsCacheEntry(path, kText);
+  ASSERT_TRUE(facts.ok()) << facts.status();
+  ExpectSameTrees(facts->facts_tree, FileFactsTree());
+  // Entries of a different text, e.g. on hash collisions, are not used.
+  EXPECT_EQ(LoadIndexingFactsCacheEntry(path, "module n;").status().code(),
+            absl::StatusCode::kNotFound);
+  std::remove(path.c_str());
+}
+
+}  // namespace
+}  // namespace kythe
+}  // namespace verilog
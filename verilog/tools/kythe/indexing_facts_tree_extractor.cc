@@ -14,17 +14,27 @@
 
 #include "verilog/tools/kythe/indexing_facts_tree_extractor.h"
 
+#include <deque>
+#include <functional>
+#include <future>
 #include <iostream>
+#include <mutex>
+#include <optional>
 #include <string>
+#include <utility>
 #include <vector>
 
 #include "absl/status/status.h"
+#include "absl/status/statusor.h"
 #include "absl/strings/strip.h"
 #include "common/text/concrete_syntax_tree.h"
+#include "common/text/syntax_tree_index.h"
 #include "common/text/tree_context_visitor.h"
 #include "common/text/tree_utils.h"
 #include "common/util/file_util.h"
 #include "common/util/logging.h"
+#include "common/util/thread_pool.h"
+#include "common/util/trace_events.h"
 #include "common/util/tree_operations.h"
 #include "verilog/CST/class.h"
 #include "verilog/CST/declaration.h"
@@ -42,8 +52,10 @@
 #include "verilog/CST/verilog_matchers.h"
 #include "verilog/CST/verilog_nonterminals.h"
 #include "verilog/CST/verilog_tree_print.h"
+#include "verilog/analysis/parse_cache.h"
 #include "verilog/analysis/verilog_analyzer.h"
 #include "verilog/analysis/verilog_project.h"
+#include "verilog/tools/kythe/indexing_facts_cache.h"
 #include "verilog/tools/kythe/indexing_facts_tree.h"
 #include "verilog/tools/kythe/indexing_facts_tree_context.h"
 
@@ -62,6 +74,9 @@ using verible::TreeSearchMatch;
 struct VerilogExtractionState {
   // Multi-file tracker.
   VerilogProject* const project;
+  // Guards the files registered in "project", which are opened while
+  // translation units are extracted concurrently.
+  std::mutex project_lock;
   // Keep track of which files (translation units, includes) have been
   // extracted.
   std::set<const VerilogSourceFile*> extracted_files;
@@ -71,14 +86,14 @@ struct VerilogExtractionState {
 // facts from CST nodes and constructs a tree of indexing facts.
 class IndexingFactsTreeExtractor : public verible::TreeContextVisitor {
  public:
-  IndexingFactsTreeExtractor(IndexingFactNode* file_list_facts_tree,
-                             const VerilogSourceFile& source_file,
+  IndexingFactsTreeExtractor(const VerilogSourceFile& source_file,
                              VerilogExtractionState* extraction_state,
-                             std::vector<absl::Status>* errors)
-      : file_list_facts_tree_(file_list_facts_tree),
-        source_file_(source_file),
+                             std::vector<absl::Status>* errors,
+                             std::vector<IncludedFile>* included_files)
+      : source_file_(source_file),
         extraction_state_(extraction_state),
-        errors_(errors) {
+        errors_(errors),
+        included_files_(included_files) {
     const absl::string_view base = source_file_.GetTextStructure()->Contents();
     root_.Value().AppendAnchor(
         // Create the Anchor for file path node.
@@ -292,12 +307,6 @@ class IndexingFactsTreeExtractor : public verible::TreeContextVisitor {
   // Keeps track of indexing facts tree ancestors as the visitor traverses CST.
   IndexingFactsTreeContext facts_tree_context_;
 
-  // "IndexingFactNode" with tag kFileList which holds the extracted indexing
-  // facts trees of the files in the ordered file list. The extracted files will
-  // be children of this node and ordered as they are given in the ordered file
-  // list.
-  IndexingFactNode* file_list_facts_tree_;
-
   // The current file being extracted.
   const VerilogSourceFile& source_file_;
 
@@ -307,25 +316,35 @@ class IndexingFactsTreeExtractor : public verible::TreeContextVisitor {
   // Processing errors.
   std::vector<absl::Status>* errors_;
 
+  // Included files are not extracted right away, but collected here, to be
+  // extracted later in this order. This is how translation units are
+  // extracted concurrently, and how their facts are cached.
+  std::vector<IncludedFile>* included_files_;
+
   // Counter used as an id for the anonymous scopes.
   int next_anonymous_id = 0;
 };
 
 // Given a root to CST this function traverses the tree, extracts and constructs
 // the indexing facts tree for one file.
+// The files it includes are collected in "included_files", to be extracted
+// after it.
 IndexingFactNode BuildIndexingFactsTree(
-    IndexingFactNode* file_list_facts_tree,
     const VerilogSourceFile& source_file,
     VerilogExtractionState* extraction_state,
-    std::vector<absl::Status>* errors) {
+    std::vector<absl::Status>* errors,
+    std::vector<IncludedFile>* included_files) {
   VLOG(1) << __FUNCTION__ << ": file: " << source_file;
-  IndexingFactsTreeExtractor visitor(file_list_facts_tree, source_file,
-                                     extraction_state, errors);
+  IndexingFactsTreeExtractor visitor(source_file, extraction_state, errors,
+                                     included_files);
 
   if (source_file.Status().ok()) {
     const auto& syntax_tree = source_file.GetTextStructure()->SyntaxTree();
     if (syntax_tree != nullptr) {
       VLOG(2) << "syntax:\n" << verible::RawTreePrinter(*syntax_tree);
+      // The extractor searches the tree many times.
+      const verible::SyntaxTreeIndex index(*syntax_tree);
+      const verible::SyntaxTreeIndex::Scope index_scope(&index);
       syntax_tree->Accept(&visitor);
     }
   }
@@ -335,21 +354,144 @@ IndexingFactNode BuildIndexingFactsTree(
   return visitor.TakeRoot();
 }
 
+// Facts of a file, without those of the files it includes. Those of
+// translation units are extracted concurrently with others.
+struct FileFacts {
+  absl::Status parse_status;
+  // Only if it was parsed (or found in the cache).
+  std::optional<IndexingFactNode> facts_tree;
+  // Files included by this one, which are extracted after it.
+  std::vector<IncludedFile> included_files;
+  // Errors of the extraction.
+  std::vector<absl::Status> errors;
+};
+
+// Returns whether the "included_files" (still) resolve to the same paths.
+bool IncludesResolveTo(const std::vector<IncludedFile>& included_files,
+                       VerilogExtractionState* extraction_state) {
+  const std::lock_guard<std::mutex> l(extraction_state->project_lock);
+  for (const IncludedFile& included : included_files) {
+    const auto status_or_file =
+        extraction_state->project->OpenIncludedFile(included.referenced_path);
+    if (!status_or_file.ok() || *status_or_file == nullptr ||
+        (*status_or_file)->ResolvedPath() != included.resolved_path) {
+      return false;
+    }
+  }
+  return true;
+}
+
+// Parses and extracts the facts of the "source_file", unless they are in the
+// cache (see indexing_facts_cache.h).
+FileFacts ExtractFileFacts(VerilogSourceFile* source_file,
+                           VerilogExtractionState* extraction_state) {
+  VERIBLE_TRACE_SCOPE("kythe", "extract-file", source_file->ReferencedPath());
+  FileFacts facts;
+  const std::string& cache_dir = ParseCacheDir();
+  std::string cache_path;
+  if (!cache_dir.empty() && source_file->Open().ok()) {
+    cache_path = IndexingFactsCachePath(
+        cache_dir, source_file->ResolvedPath(), source_file->GetContent());
+    absl::StatusOr<CachedIndexingFacts> cached =
+        LoadIndexingFactsCacheEntry(cache_path, source_file->GetContent());
+    if (cached.ok() &&
+        IncludesResolveTo(cached->included_files, extraction_state)) {
+      VLOG(1) << "Facts of " << source_file->ResolvedPath() << " from cache.";
+      facts.facts_tree = std::move(cached->facts_tree);
+      facts.included_files = std::move(cached->included_files);
+      return facts;
+    }
+  }
+  // status is also stored in source_file for later retrieval.
+  facts.parse_status = source_file->Parse();
+  if (!facts.parse_status.ok()) return facts;
+  facts.facts_tree = BuildIndexingFactsTree(*source_file, extraction_state,
+                                            &facts.errors,
+                                            &facts.included_files);
+  // Only complete extractions are cached.
+  if (!cache_path.empty() && facts.errors.empty()) {
+    const absl::Status stored = StoreIndexingFactsCacheEntry(
+        cache_path, *facts.facts_tree, facts.included_files);
+    if (!stored.ok()) VLOG(1) << stored;
+  }
+  return facts;
+}
+
+// Appends "file_errors" to "errors", or logs them if there is no "errors".
+void ReportErrors(const std::vector<absl::Status>& file_errors,
+                  std::vector<absl::Status>* errors) {
+  for (const absl::Status& error : file_errors) {
+    if (errors != nullptr) {
+      errors->push_back(error);
+    } else {
+      LOG(ERROR) << error;
+    }
+  }
+}
+
+// Extracts the "included_files" that were not extracted before, and hands
+// their facts trees to "consume", each after those of the files it includes
+// itself.
+void ExtractIncludedFiles(const FileFactsConsumer& consume,
+                          const std::vector<IncludedFile>& included_files,
+                          VerilogExtractionState* extraction_state,
+                          std::vector<absl::Status>* errors) {
+  for (const IncludedFile& included : included_files) {
+    VerilogSourceFile* included_file;
+    {
+      const std::lock_guard<std::mutex> l(extraction_state->project_lock);
+      // Opened before, so this does not fail.
+      const auto status_or_file =
+          extraction_state->project->OpenIncludedFile(included.referenced_path);
+      if (!status_or_file.ok()) continue;
+      included_file = *status_or_file;
+    }
+    if (included_file == nullptr) continue;
+    // Check whether or not this file was already extracted.
+    const auto p = extraction_state->extracted_files.insert(included_file);
+    if (!p.second) {
+      // If already extracted, skip re-extraction.
+      VLOG(1) << "File was previously extracted.";
+      continue;
+    }
+    FileFacts facts = ExtractFileFacts(included_file, extraction_state);
+    {
+      // Included files stay open to resolve further includes, but their
+      // syntax trees are no longer needed.
+      const std::lock_guard<std::mutex> l(extraction_state->project_lock);
+      included_file->ReleaseSyntaxTree();
+    }
+    ReportErrors(facts.errors, errors);
+    ExtractIncludedFiles(consume, facts.included_files, extraction_state,
+                         errors);
+    if (facts.facts_tree) {
+      consume(std::move(*facts.facts_tree));
+    } else if (errors != nullptr) {
+      errors->push_back(facts.parse_status);
+    } else {
+      LOG(WARNING) << "Failed to parse the include file "
+                   << included.referenced_path << ": " << facts.parse_status;
+    }
+  }
+}
+
 }  // namespace
 
-IndexingFactNode ExtractFiles(absl::string_view file_list_path,
-                              VerilogProject* project,
-                              const std::vector<std::string>& file_names,
-                              std::vector<absl::Status>* errors) {
+void ExtractFiles(VerilogProject* project,
+                  const std::vector<std::string>& file_names,
+                  const FileFactsConsumer& consume,
+                  std::vector<absl::Status>* errors, int jobs) {
+  VERIBLE_TRACE_SCOPE("kythe", "extract-files");
   VLOG(1) << __FUNCTION__;
   // Open all of the translation units.
-  for (absl::string_view file_name : file_names) {
-    const auto status_or_file = project->OpenTranslationUnit(file_name);
+  const auto opened_files = project->OpenTranslationUnits(file_names, jobs);
+  for (size_t i = 0; i < file_names.size(); ++i) {
+    const auto& status_or_file = opened_files[i];
     if (!status_or_file.ok()) {
       if (errors != nullptr) {
         errors->push_back(status_or_file.status());
       } else {
-        LOG(ERROR) << "Failed to open file " << file_name << ": "
+        LOG(ERROR) << "Failed to open file " << file_names[i] << ": "
                    << status_or_file.status();
       }
     }
@@ -358,36 +500,76 @@ IndexingFactNode ExtractFiles(absl::string_view file_list_path,
     // or read-permission issues (fail-fast, alert-user).
   }
 
+  VerilogExtractionState project_extraction_state{project};
+
+  // Translation units are parsed and extracted on the pool, a few ahead of
+  // the one that is consumed, so that only those few are kept in memory.
+  // They are consumed in the order of the file list, which
+  // is also when the files they include are extracted, so that the result
+  // does not depend on the number of jobs.
+  // Without threads, the pool extracts synchronously.
+  verible::ThreadPool pool(jobs > 1 ? jobs : 0);
+  const size_t window = jobs > 1 ? 4 * jobs : 1;
+  std::deque<std::pair<absl::string_view, std::future<FileFacts>>> pending;
+  auto next_file = file_names.begin();
+  const auto schedule = [&]() {
+    while (pending.size() < window && next_file != file_names.end()) {
+      const absl::string_view file_name = *next_file++;
+      VerilogSourceFile* translation_unit;
+      {
+        const std::lock_guard<std::mutex> l(
+            project_extraction_state.project_lock);
+        translation_unit = project->LookupRegisteredFile(file_name);
+      }
+      if (translation_unit == nullptr) continue;
+      const std::function<FileFacts()> extract =
+          [translation_unit, &project_extraction_state]() {
+            return ExtractFileFacts(translation_unit,
+                                    &project_extraction_state);
+          };
+      pending.emplace_back(file_name, pool.ExecAsync<FileFacts>(extract));
+    }
+  };
+
+  for (schedule(); !pending.empty(); schedule()) {
+    const absl::string_view file_name = pending.front().first;
+    FileFacts facts = pending.front().second.get();
+    pending.pop_front();
+    ReportErrors(facts.errors, errors);
+    ExtractIncludedFiles(consume, facts.included_files,
+                         &project_extraction_state, errors);
+    if (facts.facts_tree) {
+      consume(std::move(*facts.facts_tree));
+    } else if (errors != nullptr) {
+      errors->push_back(facts.parse_status);
+    } else {
+      LOG(WARNING) << "Failed to parse file " << file_name << ": "
+                   << facts.parse_status;
+    }
+    const std::lock_guard<std::mutex> l(project_extraction_state.project_lock);
+    project->RemoveRegisteredFile(file_name);
+  }
+  VLOG(1) << "end of " << __FUNCTION__;
+}
+
+IndexingFactNode ExtractFiles(absl::string_view file_list_path,
+                              VerilogProject* project,
+                              const std::vector<std::string>& file_names,
+                              std::vector<absl::Status>* errors, int jobs) {
   // Create a node to hold the path and root of the ordered file list, group
   // all the files and acts as a ordered file list of these files.
   IndexingFactNode file_list_facts_tree(
       IndexingNodeData(IndexingFactType::kFileList, Anchor(file_list_path),
                        Anchor(project->TranslationUnitRoot())));
 
-  VerilogExtractionState project_extraction_state{project};
-
   // pre-allocate file nodes with the number of translation units
   file_list_facts_tree.Children().reserve(file_names.size());
-  for (absl::string_view file_name : file_names) {
-    auto* translation_unit = project->LookupRegisteredFile(file_name);
-    if (translation_unit == nullptr) continue;
-    const auto parse_status = translation_unit->Parse();
-    // status is also stored in translation_unit for later retrieval.
-    if (parse_status.ok()) {
-      file_list_facts_tree.Children().push_back(
-          BuildIndexingFactsTree(&file_list_facts_tree, *translation_unit,
-                                 &project_extraction_state, errors));
-    } else {
-      if (errors != nullptr) {
-        errors->push_back(parse_status);
-      } else {
-        LOG(WARNING) << "Failed to parse file " << file_name << ": "
-                     << parse_status;
-      }
-    }
-    project->RemoveRegisteredFile(file_name);
-  }
-  VLOG(1) << "end of " << __FUNCTION__;
+  ExtractFiles(
+      project, file_names,
+      [&file_list_facts_tree](IndexingFactNode file_facts) {
+        file_list_facts_tree.Children().push_back(std::move(file_facts));
+      },
+      errors, jobs);
   return file_list_facts_tree;
 }
 
@@ -1733,7 +1915,11 @@ void IndexingFactsTreeExtractor::ExtractInclude(
   VerilogProject* const project = extraction_state_->project;
 
   // Open this file (could be first time, or previously opened).
-  const auto status_or_file = project->OpenIncludedFile(filename_unquoted);
+  absl::StatusOr<VerilogSourceFile*> status_or_file;
+  {
+    const std::lock_guard<std::mutex> l(extraction_state_->project_lock);
+    status_or_file = project->OpenIncludedFile(filename_unquoted);
+  }
   if (!status_or_file.ok()) {
     if (errors_ != nullptr) {
       errors_->push_back(status_or_file.status());
@@ -1749,28 +1935,8 @@ void IndexingFactsTreeExtractor::ExtractInclude(
   if (included_file == nullptr) return;
   VLOG(1) << "opened include file: " << included_file->ResolvedPath();
 
-  {
-    // Check whether or not this file was already extracted.
-    const auto p = extraction_state_->extracted_files.insert(included_file);
-    if (!p.second) {
-      // If already extracted, skip re-extraction.
-      VLOG(1) << "File was previously extracted.";
-    } else {
-      // Parse included file and extract.
-      const auto parse_status = included_file->Parse();
-      if (parse_status.ok()) {
-        file_list_facts_tree_->Children().push_back(BuildIndexingFactsTree(
-            file_list_facts_tree_, *included_file, extraction_state_, errors_));
-      } else {
-        if (errors_ != nullptr) {
-          errors_->push_back(parse_status);
-        } else {
-          LOG(WARNING) << "Failed to parse the include file "
-                       << filename_unquoted << ": " << parse_status;
-        }
-      }
-    }
-  }
+  included_files_->push_back({std::string(filename_unquoted),
+                              std::string(included_file->ResolvedPath())});
 
   // Create a node for include statement with two Anchors:
   // 1st one holds the actual text in the include statement.
@@ -15,6 +15,7 @@
 #ifndef VERIBLE_VERILOG_TOOLS_KYTHE_INDEXING_FACTS_TREE_EXTRACTOR_H_
 #define VERIBLE_VERILOG_TOOLS_KYTHE_INDEXING_FACTS_TREE_EXTRACTOR_H_
 
+#include <functional>
 #include <string>
 #include <vector>
 
@@ -30,10 +31,26 @@ namespace kythe {
 // IndexingFactsTree for the given files.
 // The returned tree will have the files as children and they will retain their
 // original ordering from the file list.
+// Translation units are parsed and extracted on up to "jobs" threads; the
+// result is the same for any number of them.
 IndexingFactNode ExtractFiles(absl::string_view file_list_path,
                               VerilogProject* project,
                               const std::vector<std::string>& file_names,
-                              std::vector<absl::Status>* errors = nullptr);
+                              std::vector<absl::Status>* errors = nullptr,
+                              int jobs = 1);
+
+// Receives the facts tree of one file, tagged with kFile.
+using FileFactsConsumer = std::function<void(IndexingFactNode file_facts)>;
+
+// Like the above, but hands the facts tree of each file to "consume", in the
+// same order as the children of the returned tree, as soon as it is
+// extracted.  Syntax trees are released once the facts of their file are
+// extracted, so unless "consume" keeps the facts trees, only those of about
+// "jobs" files are in memory at once.
+void ExtractFiles(VerilogProject* project,
+                  const std::vector<std::string>& file_names,
+                  const FileFactsConsumer& consume,
+                  std::vector<absl::Status>* errors = nullptr, int jobs = 1);
 
 }  // namespace kythe
 }  // namespace verilog
@@ -16,8 +16,11 @@
 
 #include <functional>
 #include <string>
+#include <vector>
 
+#include "absl/flags/flag.h"
 #include "absl/status/status.h"
+#include "absl/strings/str_cat.h"
 #include "common/analysis/syntax_tree_search_test_utils.h"
 #include "common/text/concrete_syntax_tree.h"
 #include "common/util/file_util.h"
@@ -25,6 +28,7 @@
 #include "common/util/range.h"
 #include "common/util/tree_operations.h"
 #include "gtest/gtest.h"
+#include "verilog/analysis/parse_cache.h"
 #include "verilog/analysis/verilog_analyzer.h"
 #include "verilog/analysis/verilog_project.h"
 #include "verilog/tools/kythe/indexing_facts_tree.h"
@@ -5379,6 +5383,128 @@ TEST(FactsTreeExtractor, NestedStructFunctionPort) {
   EXPECT_EQ(result_pair.right, nullptr) << P(*result_pair.right);
 }
 
+TEST(FactsTreeExtractor, ParallelExtractionSameAsSerial) {
+  const std::string temp_dir = ::testing::TempDir();
+  const std::string included_file_basename(
+      verible::file::testing::RandomFileBasename("shared"));
+  const ScopedTestFile included_file(temp_dir, "class shared_class;\nendclass",
+                                     included_file_basename);
+  std::vector<ScopedTestFile> files;
+  std::vector<std::string> file_names;
+  for (int i = 0; i < 8; ++i) {
+    files.emplace_back(
+        temp_dir, absl::StrCat("`include \"", included_file_basename,
+                               "\"\nmodule m", i, ";\n  shared_class c;\n",
+                               "endmodule\n"));
+    file_names.emplace_back(verible::file::Basename(files.back().filename()));
+  }
+  // Not found: reported, and does not disturb the order.
+  file_names.insert(file_names.begin() + 3, "missing.sv");
+
+  VerilogProject serial_project(temp_dir, {temp_dir}, /*corpus=*/"unittest",
+                                /*populate_string_maps=*/false);
+  std::vector<absl::Status> serial_errors;
+  const IndexingFactNode serial = ExtractFiles(
+      temp_dir, &serial_project, file_names, &serial_errors, /*jobs=*/1);
+
+  VerilogProject parallel_project(temp_dir, {temp_dir}, /*corpus=*/"unittest",
+                                  /*populate_string_maps=*/false);
+  std::vector<absl::Status> parallel_errors;
+  const IndexingFactNode parallel = ExtractFiles(
+      temp_dir, &parallel_project, file_names, &parallel_errors, /*jobs=*/4);
+
+  // The included file is extracted once, before the first file including it.
+  ASSERT_EQ(serial.Children().size(), files.size() + 1);
+  EXPECT_EQ(serial.Children()[0].Value().GetIndexingFactType(),
+            IndexingFactType::kFile);
+  EXPECT_EQ(serial.Children()[0].Value().Anchors()[0].Text(),
+            serial_project.LookupRegisteredFile(included_file_basename)
+                ->ResolvedPath());
+  const auto result_pair = DeepEqual(serial, parallel);
+  EXPECT_EQ(result_pair.left, nullptr) << *result_pair.left;
+  EXPECT_EQ(result_pair.right, nullptr) << *result_pair.right;
+  EXPECT_EQ(serial_errors.size(), 1);
+  EXPECT_EQ(parallel_errors.size(), 1);
+}
+
+TEST(FactsTreeExtractor, ConsumedFactsSameAsTree) {
+  const std::string temp_dir = ::testing::TempDir();
+  const std::string included_file_basename(
+      verible::file::testing::RandomFileBasename("consumed"));
+  const ScopedTestFile included_file(temp_dir, "class shared_class;\nendclass",
+                                     included_file_basename);
+  const ScopedTestFile file(
+      temp_dir, absl::StrCat("`include \"", included_file_basename,
+                             "\"\nmodule m;\n  shared_class c;\nendmodule\n"));
+  const std::vector<std::string> file_names = {
+      std::string(verible::file::Basename(file.filename()))};
+
+  VerilogProject tree_project(temp_dir, {temp_dir}, /*corpus=*/"unittest",
+                              /*populate_string_maps=*/false);
+  const IndexingFactNode tree =
+      ExtractFiles(temp_dir, &tree_project, file_names);
+
+  VerilogProject project(temp_dir, {temp_dir}, /*corpus=*/"unittest",
+                         /*populate_string_maps=*/false);
+  std::vector<IndexingFactNode> consumed;
+  ExtractFiles(&project, file_names,
+               [&consumed](IndexingFactNode file_facts) {
+                 consumed.push_back(std::move(file_facts));
+               });
+
+  ASSERT_EQ(consumed.size(), tree.Children().size());
+  for (size_t i = 0; i < consumed.size(); ++i) {
+    const auto result_pair = DeepEqual(tree.Children()[i], consumed[i]);
+    EXPECT_EQ(result_pair.left, nullptr) << *result_pair.left;
+    EXPECT_EQ(result_pair.right, nullptr) << *result_pair.right;
+  }
+  // The included file stays open, without its syntax tree.
+  const VerilogSourceFile* included =
+      project.LookupRegisteredFile(included_file_basename);
+  ASSERT_NE(included, nullptr);
+  EXPECT_EQ(included->GetTextStructure(), nullptr);
+}
+
+TEST(FactsTreeExtractor, CachedExtractionSameAsUncached) {
+  const std::string temp_dir = ::testing::TempDir();
+  const std::string cache_dir = verible::file::JoinPath(
+      temp_dir, verible::file::testing::RandomFileBasename("facts_cache"));
+  ASSERT_TRUE(verible::file::CreateDir(cache_dir).ok());
+  const std::string included_file_basename(
+      verible::file::testing::RandomFileBasename("shared"));
+  const ScopedTestFile included_file(temp_dir, "class shared_class;\nendclass",
+                                     included_file_basename);
+  const ScopedTestFile file(
+      temp_dir, absl::StrCat("`include \"", included_file_basename,
+                             "\"\nmodule m;\n  shared_class c;\nendmodule\n"));
+  const std::vector<std::string> file_names = {
+      std::string(verible::file::Basename(file.filename()))};
+
+  const auto extract = [&]() {
+    VerilogProject project(temp_dir, {temp_dir}, /*corpus=*/"unittest",
+                           /*populate_string_maps=*/false);
+    std::vector<absl::Status> errors;
+    IndexingFactNode facts =
+        ExtractFiles(temp_dir, &project, file_names, &errors);
+    EXPECT_TRUE(errors.empty());
+    return facts;
+  };
+  const IndexingFactNode uncached = extract();
+  absl::SetFlag(&FLAGS_parse_cache_dir, cache_dir);
+  ResetParseCacheDirForTesting();
+  const IndexingFactNode stored = extract();  // Fills the cache.
+  const IndexingFactNode cached = extract();  // Only reads it.
+  absl::SetFlag(&FLAGS_parse_cache_dir, "");
+  ResetParseCacheDirForTesting();
+
+  ASSERT_EQ(uncached.Children().size(), 2);
+  for (const IndexingFactNode* facts : {&stored, &cached}) {
+    const auto result_pair = DeepEqual(uncached, *facts);
+    EXPECT_EQ(result_pair.left, nullptr) << *result_pair.left;
+    EXPECT_EQ(result_pair.right, nullptr) << *result_pair.right;
+  }
+}
+
 }  // namespace
 }  // namespace kythe
 }  // namespace verilog
@@ -16,10 +16,12 @@
 
 #include <algorithm>
 #include <iostream>
+#include <memory>
 #include <sstream>
 #include <string>
 #include <tuple>
 #include <utility>
+#include <vector>
 
 #include "absl/hash/hash.h"
 #include "absl/log/check.h"
@@ -37,39 +39,84 @@ size_t CombineHash(size_t existing, size_t addition) {
   return existing ^ (addition + 0x9e3779b9 + (existing << 6) + (existing >> 2));
 }
 
-// Returns a rolling hash (https://en.wikipedia.org/wiki/Rolling_hash) of the
-// signature names. NOTE: the first name (the file) is skipped and replaced with
-// 0.
-//
-// The rolling hash of a vector produces a vector of an equal size where each
-// element is a combined hash of all previous elements.
-// res[0] = 0  // Global scope hash
-// res[1] = hash(0, name[0])
-// res[2] = hash(0, name[0], name[1])
+// The signature of the global scope, which most VNames start with.
+const std::shared_ptr<const SignatureNode>& EmptySignatureNode() {
+  static const auto* const node =
+      new std::shared_ptr<const SignatureNode>(new SignatureNode{
+          .parent = nullptr,
+          .name = "",
+          .depth = 1,
+          .rolling_hash = 0,
+          .hash = absl::HashOf(absl::string_view()),
+      });
+  return *node;
+}
+
+}  // namespace
+
+// The rolling hash (https://en.wikipedia.org/wiki/Rolling_hash) of the
+// signature names is kept in each node, for the digests of all parents.
+// NOTE: the first name (the file) is skipped and replaced with 0.
+// rolling_hash(name[0]) = 0  // Global scope hash
+// rolling_hash(name[0], name[1]) = hash(0, name[1])
 // ...
-// res[N] = hash(0, name[0], name[1], ..., name[N])
-std::vector<size_t> RollingHash(const std::vector<absl::string_view>& names) {
-  if (names.size() <= 1) {
-    return {0};  // Global scope
+// rolling_hash(name[0], ..., name[N]) = hash(0, name[1], ..., name[N])
+size_t SignatureDigest::HashAtDepth(size_t depth) const {
+  const SignatureNode* n = node.get();
+  CHECK(n != nullptr && depth <= n->depth) << "No parent at depth " << depth;
+  while (n->depth > depth) n = n->parent.get();
+  return n->rolling_hash;
+}
+
+Signature::Signature(absl::string_view name) {
+  if (name.empty()) {
+    node_ = EmptySignatureNode();
+    return;
   }
+  node_ = std::make_shared<const SignatureNode>(SignatureNode{
+      .parent = nullptr,
+      .name = name,
+      .depth = 1,
+      .rolling_hash = 0,
+      .hash = absl::HashOf(name),
+  });
+}
 
-  std::vector<size_t> hashes = {0};  // Prefix with the global scope
-  hashes.reserve(names.size());
-  size_t previous = 0;
-  // Start from 2nd element --> skip the filename.
-  for (size_t i = 1; i < names.size(); ++i) {
-    previous = CombineHash(previous, absl::HashOf(names[i]));
-    hashes.push_back(previous);
+Signature::Signature(const Signature& parent, absl::string_view name) {
+  const size_t name_hash = absl::HashOf(name);
+  node_ = std::make_shared<const SignatureNode>(SignatureNode{
+      .parent = parent.node_,
+      .name = name,
+      .depth = parent.node_->depth + 1,
+      .rolling_hash = CombineHash(parent.node_->rolling_hash, name_hash),
+      .hash = CombineHash(parent.node_->hash, name_hash),
+  });
+}
+
+bool Signature::operator==(const Signature& other) const {
+  const SignatureNode* a = node_.get();
+  const SignatureNode* b = other.node_.get();
+  if (a->depth != b->depth || a->hash != b->hash) return false;
+  // Parents are often shared, which ends the comparison early.
+  for (; a != b; a = a->parent.get(), b = b->parent.get()) {
+    if (a->name != b->name) return false;
   }
-  CHECK_EQ(hashes.size(), names.size());
-  return hashes;
+  return true;
 }
 
-}  // namespace
+std::vector<absl::string_view> Signature::Names() const {
+  std::vector<absl::string_view> names(node_->depth);
+  auto name = names.rbegin();
+  for (const SignatureNode* n = node_.get(); n != nullptr;
+       n = n->parent.get()) {
+    *name++ = n->name;
+  }
+  return names;
+}
 
 std::string Signature::ToString() const {
   std::string signature;
-  for (absl::string_view name : names_) {
+  for (absl::string_view name : Names()) {
     if (name.empty()) continue;
     absl::StrAppend(&signature, name, "#");
   }
@@ -80,10 +127,6 @@ std::string Signature::ToBase64() const {
   return absl::Base64Escape(ToString());
 }
 
-SignatureDigest Signature::Digest() const {
-  return SignatureDigest{.rolling_hash = RollingHash(Names())};
-}
-
 bool VName::operator==(const VName& other) const {
   return path == other.path && root == other.root && corpus == other.corpus &&
          signature == other.signature && language == other.language;
@@ -15,7 +15,9 @@
 #ifndef VERIBLE_VERILOG_TOOLS_KYTHE_KYTHE_FACTS_H_
 #define VERIBLE_VERILOG_TOOLS_KYTHE_KYTHE_FACTS_H_
 
+#include <cstddef>
 #include <iostream>
+#include <memory>
 #include <string>
 #include <vector>
 
@@ -27,15 +29,36 @@ namespace kythe {
 inline constexpr absl::string_view kDefaultKytheLanguage = "verilog";
 inline constexpr absl::string_view kEmptyKytheLanguage = "";
 
+// The last name of a signature, with the signature of its parent. Signatures
+// of the members of a scope share the one of the scope, instead of copying all
+// of its names. Immutable.
+struct SignatureNode {
+  std::shared_ptr<const SignatureNode> parent;  // nullptr for the first name.
+  absl::string_view name;
+  // Number of names, including this one.
+  size_t depth;
+  // Combined hash of the names, leaving out the first (the file), which is 0.
+  size_t rolling_hash;
+  // Combined hash of all names.
+  size_t hash;
+};
+
 // Hash-based form of signature for fast and lightweight comparision.
 struct SignatureDigest {
-  std::vector<size_t> rolling_hash;
+  // Holds the rolling hash of the signature and all its parents.
+  std::shared_ptr<const SignatureNode> node;
+
+  size_t Hash() const { return node == nullptr ? 0 : node->rolling_hash; }
+
+  // Number of names of the signature.
+  size_t Depth() const { return node == nullptr ? 0 : node->depth; }
 
-  size_t Hash() const { return rolling_hash.back(); }
+  // Returns the hash of the parent signature with "depth" names, which is at
+  // most that of this one.
+  size_t HashAtDepth(size_t depth) const;
 
   bool operator==(const SignatureDigest& d) const {
-    return rolling_hash.size() == d.rolling_hash.size() &&
-           rolling_hash.back() == d.rolling_hash.back();
+    return Depth() == d.Depth() && Hash() == d.Hash();
   }
 
   friend std::ostream& operator<<(std::ostream& os, const SignatureDigest& d) {
@@ -45,22 +68,19 @@ struct SignatureDigest {
 };
 template <typename H>
 H AbslHashValue(H state, const SignatureDigest& d) {
-  return H::combine(std::move(state), d.rolling_hash);
+  return H::combine(std::move(state), d.Depth(), d.Hash());
 }
 
 // Unique identifier for Kythe facts.
+// Copying a signature, or creating one in the scope of another, does not copy
+// the names; they are only concatenated into a string for the output.
 class Signature {
  public:
-  explicit Signature(absl::string_view name = "") : names_({name}) {}
+  explicit Signature(absl::string_view name = "");
 
-  Signature(const Signature& parent, absl::string_view name)
-      : names_(parent.Names()) {
-    names_.push_back(name);
-  }
+  Signature(const Signature& parent, absl::string_view name);
 
-  bool operator==(const Signature& other) const {
-    return names_ == other.names_;
-  }
+  bool operator==(const Signature& other) const;
   bool operator!=(const Signature& other) const { return !(*this == other); }
 
   // Returns the signature concatenated as a string.
@@ -69,27 +89,31 @@ class Signature {
   // Returns the signature concatenated as a string in base 64.
   std::string ToBase64() const;
 
-  const std::vector<absl::string_view>& Names() const { return names_; }
-
-  // Returns signature's short form for fast and lightweight comparision.
-  SignatureDigest Digest() const;
-
- private:
-  // List that uniquely determines this signature and differentiates it from any
-  // other signature.
-  // This list represents the name of some signature in a scope.
-  // e.g
+  // Returns the names that uniquely determine this signature and
+  // differentiate it from any other signature, i.e. the name of some
+  // signature in a scope. e.g.
   // class m;
   //    int x;
   // endclass
   //
   // for "m" ==> ["m"]
   // for "x" ==> ["m", "x"]
-  std::vector<absl::string_view> names_;
+  std::vector<absl::string_view> Names() const;
+
+  // Returns the last of the Names(), e.g. "x" for ["m", "x"].
+  absl::string_view Name() const { return node_->name; }
+
+  // Returns signature's short form for fast and lightweight comparision.
+  SignatureDigest Digest() const { return SignatureDigest{.node = node_}; }
+
+  size_t Hash() const { return node_->hash; }
+
+ private:
+  std::shared_ptr<const SignatureNode> node_;
 };
 template <typename H>
 H AbslHashValue(H state, const Signature& v) {
-  return H::combine(std::move(state), v.Names());
+  return H::combine(std::move(state), v.Hash());
 }
 
 // Node vector name for kythe facts.
@@ -24,6 +24,7 @@
 #include <vector>
 
 #include "absl/container/btree_map.h"
+#include "absl/container/flat_hash_map.h"
 #include "absl/container/flat_hash_set.h"
 #include "absl/container/node_hash_set.h"
 #include "absl/hash/hash.h"
@@ -58,10 +59,12 @@ class KytheFactsExtractor {
  public:
   KytheFactsExtractor(absl::string_view file_path, absl::string_view corpus,
                       KytheOutput* facts_output,
-                      ScopeResolver* previous_files_scopes)
-      : file_path_(file_path),
+                      ScopeResolver* previous_files_scopes,
+                      absl::flat_hash_set<int64_t>* emitted_kythe_hashes)
+      : file_path_(previous_files_scopes->Intern(file_path)),
         corpus_(corpus),
         facts_output_(facts_output),
+        emitted_kythe_hashes_(emitted_kythe_hashes),
         scope_resolver_(previous_files_scopes) {}
 
  private:
@@ -234,10 +237,11 @@ class KytheFactsExtractor {
   void CreateEdge(const VName& source, absl::string_view name,
                   const VName& target);
 
-  // Holds the hashes of the output Kythe facts and edges (for deduplication).
+  // Holds the hashes of the Kythe facts and edges of this file, to tell when
+  // extraction does not find new ones.
   absl::flat_hash_set<int64_t> seen_kythe_hashes_;
 
-  // The full path of the current source file.
+  // The full path of the current source file, owned by the scope resolver.
   absl::string_view file_path_;
 
   // The corpus to which this file belongs.
@@ -246,6 +250,15 @@ class KytheFactsExtractor {
   // Output for produced Kythe facts. Not owned.
   KytheOutput* const facts_output_;
 
+  // Hashes of the Kythe facts and edges output for all files so far, so that
+  // the same ones (e.g. of included files, or repeated imports) are only
+  // output once. Not owned.
+  // Only the 64-bit hashes are kept, not the entries: those refer to the facts
+  // trees of files that are released once extracted, and would take far more
+  // memory.  Two different entries with the same hash are unlikely enough
+  // that the second one being dropped is accepted.
+  absl::flat_hash_set<int64_t>* const emitted_kythe_hashes_;
+
   // Keeps track of VNames of ancestors as the visitor traverses the facts
   // tree.
   VNameContext vnames_context_;
@@ -262,9 +275,47 @@ class KytheFactsExtractor {
   absl::node_hash_set<std::string> signature_locations_;
 };
 
+KytheProjectExtractor::KytheProjectExtractor(KytheOutput* output,
+                                             const VerilogProject& project)
+    : output_(output), project_(project), scope_resolver_(Signature("")) {}
+
+void KytheProjectExtractor::Extract(
+    const IndexingFactNode& file, KytheOutput* output,
+    absl::flat_hash_set<int64_t>* emitted_kythe_hashes) {
+  scope_resolver_.SetCurrentScope(Signature(""));
+  const absl::Time extraction_start = absl::Now();
+  // 'file' corresponds to the fact tree for a particular file.
+  // 'file_path' is path-resolved.
+  const absl::string_view file_path(GetFilePathFromRoot(file));
+  VLOG(1) << "child file resolved path: " << file_path;
+
+  // Create facts and edges.
+  KytheFactsExtractor kythe_extractor(file_path, project_.Corpus(), output,
+                                      &scope_resolver_, emitted_kythe_hashes);
+
+  // Output facts and edges.
+  kythe_extractor.ExtractFile(file);
+  LOG(INFO) << "Extracted Kythe facts of " << file_path << " in "
+            << (absl::Now() - extraction_start);
+}
+
+void KytheProjectExtractor::ExtractFile(const IndexingFactNode& file) {
+  Extract(file, output_, &emitted_kythe_hashes_);
+}
+
+void KytheProjectExtractor::AddSymbols(const IndexingFactNode& file) {
+  class NullOutput final : public KytheOutput {
+   public:
+    void Emit(const Fact& fact) final {}
+    void Emit(const Edge& edge) final {}
+  } null_output;
+  Extract(file, &null_output, &unused_kythe_hashes_);
+}
+
 void StreamKytheFactsEntries(KytheOutput* kythe_output,
                              const IndexingFactNode& file_list,
-                             const VerilogProject& project) {
+                             const VerilogProject& project,
+                             const IndexingFactNode* scope_summary) {
   VLOG(1) << __FUNCTION__;
   // TODO(fangism): re-implement root-level symbol lookup with a proper
   // project-wide symbol table, for efficient lookup.
@@ -272,24 +323,37 @@ void StreamKytheFactsEntries(KytheOutput* kythe_output,
   // TODO(fangism): infer dependency ordering automatically based on
   // the symbols defined in each file.
 
-  // Process each file in the original listed order.
-  ScopeResolver scope_resolver(Signature(""));
+  KytheProjectExtractor extractor(kythe_output, project);
+  if (scope_summary == nullptr) {
+    // Process each file in the original listed order.
+    for (const IndexingFactNode& root : file_list.Children()) {
+      extractor.ExtractFile(root);
+    }
+    VLOG(1) << "end of " << __FUNCTION__;
+    return;
+  }
+
+  // Process each file of the project in the order of the summary, the
+  // others only to know their symbols.
+  absl::flat_hash_map<absl::string_view, const IndexingFactNode*> files;
   for (const IndexingFactNode& root : file_list.Children()) {
-    scope_resolver.SetCurrentScope(Signature(""));
-    const absl::Time extraction_start = absl::Now();
-    // 'root' corresponds to the fact tree for a particular file.
-    // 'file_path' is path-resolved.
-    const absl::string_view file_path(GetFilePathFromRoot(root));
-    VLOG(1) << "child file resolved path: " << file_path;
-
-    // Create facts and edges.
-    KytheFactsExtractor kythe_extractor(file_path, project.Corpus(),
-                                        kythe_output, &scope_resolver);
-
-    // Output facts and edges.
-    kythe_extractor.ExtractFile(root);
-    LOG(INFO) << "Extracted Kythe facts of " << file_path << " in "
-              << (absl::Now() - extraction_start);
+    files.emplace(GetFilePathFromRoot(root), &root);
+  }
+  for (const IndexingFactNode& summary : scope_summary->Children()) {
+    const auto found = files.find(GetFilePathFromRoot(summary));
+    if (found == files.end()) {
+      extractor.AddSymbols(summary);
+      continue;
+    }
+    extractor.ExtractFile(*found->second);
+    files.erase(found);
+  }
+  // Files new since the summary was made.
+  for (const IndexingFactNode& root : file_list.Children()) {
+    if (files.contains(GetFilePathFromRoot(root))) {
+      LOG(WARNING) << GetFilePathFromRoot(root) << " is not in the summary.";
+      extractor.ExtractFile(root);
+    }
   }
 
   VLOG(1) << "end of " << __FUNCTION__;
@@ -811,7 +875,8 @@ VName KytheFactsExtractor::DeclareMacroDefinition(
   // created here.
   VName macro_vname = {.path = FilePath(),
                        .root = "",
-                       .signature = Signature(macro_name.Text()),
+                       .signature =
+                           Signature(scope_resolver_->Intern(macro_name.Text())),
                        .corpus = Corpus()};
   const VName module_name_anchor = CreateAnchor(macro_name);
 
@@ -1156,18 +1221,20 @@ VName KytheFactsExtractor::CreateAnchor(const Anchor& anchor) {
 
 Signature KytheFactsExtractor::CreateScopeRelativeSignature(
     absl::string_view signature) const {
-  // Append the given signature to the signature of the parent.
-  return Signature(vnames_context_.top().signature, signature);
+  // Append the given signature to the signature of the parent.  Definitions
+  // outlive the facts tree, so the name is owned by the scope resolver.
+  return Signature(vnames_context_.top().signature,
+                   scope_resolver_->Intern(signature));
 }
 
 void KytheFactsExtractor::CreateFact(const VName& vname,
                                      absl::string_view fact_name,
                                      absl::string_view fact_value) {
   Fact fact(vname, fact_name, fact_value);
-  auto hash = absl::HashOf(fact);
-  if (!seen_kythe_hashes_.contains(hash)) {
+  const int64_t hash = absl::HashOf(fact);
+  if (seen_kythe_hashes_.insert(hash).second &&
+      emitted_kythe_hashes_->insert(hash).second) {
     facts_output_->Emit(fact);
-    seen_kythe_hashes_.insert(hash);
   }
 }
 
@@ -1175,57 +1242,40 @@ void KytheFactsExtractor::CreateEdge(const VName& source_node,
                                      absl::string_view edge_name,
                                      const VName& target_node) {
   Edge edge(source_node, edge_name, target_node);
-  auto hash = absl::HashOf(edge);
-  if (!seen_kythe_hashes_.contains(hash)) {
+  const int64_t hash = absl::HashOf(edge);
+  if (seen_kythe_hashes_.insert(hash).second &&
+      emitted_kythe_hashes_->insert(hash).second) {
     facts_output_->Emit(edge);
-    seen_kythe_hashes_.insert(hash);
   }
 }
 
-std::ostream& KytheFactsPrinter::PrintJsonStream(std::ostream& stream) const {
-  // TODO(fangism): Print function should not be doing extraction work.
-  class Printer final : public KytheOutput {
-   public:
-    explicit Printer(std::ostream& stream) : stream_(stream) {}
-    void Emit(const Fact& fact) final {
-      fact.FormatJSON(stream_, /*debug=*/false) << std::endl;
-    }
-    void Emit(const Edge& edge) final {
-      edge.FormatJSON(stream_, /*debug=*/false) << std::endl;
-    }
+void KytheJsonOutput::Emit(const Fact& fact) {
+  if (debug_ && add_comma_) stream_ << "," << std::endl;
+  fact.FormatJSON(stream_, debug_) << std::endl;
+  add_comma_ = true;
+}
 
-   private:
-    std::ostream& stream_;
-  } printer(stream);
+void KytheJsonOutput::Emit(const Edge& edge) {
+  if (debug_ && add_comma_) stream_ << "," << std::endl;
+  edge.FormatJSON(stream_, debug_) << std::endl;
+  add_comma_ = true;
+}
 
-  StreamKytheFactsEntries(&printer, file_list_facts_tree_, *project_);
+std::ostream& KytheFactsPrinter::PrintJsonStream(std::ostream& stream) const {
+  // TODO(fangism): Print function should not be doing extraction work.
+  KytheJsonOutput printer(stream);
+  StreamKytheFactsEntries(&printer, file_list_facts_tree_, *project_,
+                          scope_summary_);
 
   return stream;
 }
 
 std::ostream& KytheFactsPrinter::PrintJson(std::ostream& stream) const {
   // TODO(fangism): Print function should not be doing extraction work.
-  class Printer final : public KytheOutput {
-   public:
-    explicit Printer(std::ostream& stream) : stream_(stream) {}
-    void Emit(const Fact& fact) final {
-      if (add_comma_) stream_ << "," << std::endl;
-      fact.FormatJSON(stream_, /*debug=*/true) << std::endl;
-      add_comma_ = true;
-    }
-    void Emit(const Edge& edge) final {
-      if (add_comma_) stream_ << "," << std::endl;
-      edge.FormatJSON(stream_, /*debug=*/true) << std::endl;
-      add_comma_ = true;
-    }
-
-   private:
-    std::ostream& stream_;
-    bool add_comma_ = false;
-  } printer(stream);
-
+  KytheJsonOutput printer(stream, /*debug=*/true);
   stream << "[";
-  StreamKytheFactsEntries(&printer, file_list_facts_tree_, *project_);
+  StreamKytheFactsEntries(&printer, file_list_facts_tree_, *project_,
+                          scope_summary_);
   stream << "]" << std::endl;
 
   return stream;
@@ -15,12 +15,15 @@
 #ifndef VERIBLE_VERILOG_TOOLS_KYTHE_KYTHE_FACTS_EXTRACTOR_H_
 #define VERIBLE_VERILOG_TOOLS_KYTHE_KYTHE_FACTS_EXTRACTOR_H_
 
+#include <cstdint>
 #include <iosfwd>
 #include <set>
 
+#include "absl/container/flat_hash_set.h"
 #include "verilog/analysis/verilog_project.h"
 #include "verilog/tools/kythe/indexing_facts_tree.h"
 #include "verilog/tools/kythe/kythe_facts.h"
+#include "verilog/tools/kythe/scope_resolver.h"
 
 namespace verilog {
 namespace kythe {
@@ -30,10 +33,12 @@ namespace kythe {
 class KytheFactsPrinter {
  public:
   KytheFactsPrinter(const IndexingFactNode& file_list_facts_tree,
-                    const VerilogProject& project, bool debug = false)
+                    const VerilogProject& project, bool debug = false,
+                    const IndexingFactNode* scope_summary = nullptr)
       : file_list_facts_tree_(file_list_facts_tree),
         project_(&project),
-        debug_(debug) {}
+        debug_(debug),
+        scope_summary_(scope_summary) {}
 
   // Print Kythe facts as a stream of JSON entries (one per line). Note: single
   // facts are well formatted JSON, but the overall output isn't!
@@ -54,6 +59,10 @@ class KytheFactsPrinter {
 
   // When debugging is enabled, print human-readable un-encoded text.
   const bool debug_;
+
+  // If set, the facts tree only has some of the files of the project, and
+  // the others are known from their scope summary.  Not owned.
+  const IndexingFactNode* const scope_summary_;
 };
 
 std::ostream& operator<<(std::ostream&, const KytheFactsPrinter&);
@@ -67,15 +76,75 @@ class KytheOutput {
   virtual ~KytheOutput() = default;
 };
 
+// Prints Kythe facts in JSON format, one per line, or with "debug", as the
+// human readable elements of a JSON array, without its brackets.
+class KytheJsonOutput final : public KytheOutput {
+ public:
+  explicit KytheJsonOutput(std::ostream& stream, bool debug = false)
+      : stream_(stream), debug_(debug) {}
+
+  void Emit(const Fact& fact) final;
+  void Emit(const Edge& edge) final;
+
+ private:
+  std::ostream& stream_;
+  const bool debug_;
+  bool add_comma_ = false;
+};
+
+// Extracts the Kythe facts of the files of a project one after the other, in
+// the order of the file list (see StreamKytheFactsEntries()).  What the later
+// files need of the earlier ones, their symbols and scopes, is kept apart
+// from the facts trees, so that each file's can be released as soon as its
+// facts are extracted.
+class KytheProjectExtractor {
+ public:
+  KytheProjectExtractor(KytheOutput* output, const VerilogProject& project);
+
+  KytheProjectExtractor(const KytheProjectExtractor&) = delete;
+  KytheProjectExtractor& operator=(const KytheProjectExtractor&) = delete;
+
+  // Outputs the facts of the "file" (tagged with kFile) that were not output
+  // for an earlier one.
+  void ExtractFile(const IndexingFactNode& file);
+
+  // Only adds the symbols of the "file" (or of its scope summary) for the
+  // files that follow, without output.
+  void AddSymbols(const IndexingFactNode& file);
+
+ private:
+  void Extract(const IndexingFactNode& file, KytheOutput* output,
+               absl::flat_hash_set<int64_t>* emitted_kythe_hashes);
+
+  KytheOutput* const output_;
+  const VerilogProject& project_;
+
+  // Scopes of the files extracted so far.
+  ScopeResolver scope_resolver_;
+
+  // Hashes of the facts and edges output so far.  Of two different entries
+  // with the same hash, which is unlikely, only the first is output.
+  absl::flat_hash_set<int64_t> emitted_kythe_hashes_;
+  // Those of AddSymbols(), which are not output.
+  absl::flat_hash_set<int64_t> unused_kythe_hashes_;
+};
+
 // Extract facts across an entire project.
 // Extracts node tagged with kFileList where it iterates over every child node
 // tagged with kFile from the begining and extracts the facts for each file.
 // Currently, the file_list must be dependency-ordered for best results, that
 // is, definitions of symbols should be encountered earlier in the file list
 // than references to those symbols.
+//
+// With a "scope_summary" (SummarizeScopes()) of the whole project, the facts
+// tree may only have some of its files, e.g. those of one shard: the symbols
+// of the others are taken from the summary, in its file order, without
+// output.  Facts of the files that the shards share, e.g. of what they
+// reference, are output by each of them.
 void StreamKytheFactsEntries(KytheOutput* kythe_output,
                              const IndexingFactNode& file_list_facts_tree,
-                             const VerilogProject& project);
+                             const VerilogProject& project,
+                             const IndexingFactNode* scope_summary = nullptr);
 
 }  // namespace kythe
 }  // namespace verilog
@@ -0,0 +1,93 @@
+// Copyright 2017-2023 The Verible Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+
+#include "verilog/tools/kythe/kythe_facts_extractor.h"
+
+#include <set>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+#include "verilog/analysis/verilog_project.h"
+#include "verilog/tools/kythe/indexing_facts_tree.h"
+#include "verilog/tools/kythe/kythe_facts.h"
+
+namespace verilog {
+namespace kythe {
+namespace {
+
+using T = IndexingFactNode;
+using D = IndexingNodeData;
+
+// Records the printed entries.
+class RecordingOutput final : public KytheOutput {
+ public:
+  void Emit(const Fact& fact) final { Record(fact); }
+  void Emit(const Edge& edge) final { Record(edge); }
+
+  const std::vector<std::string>& Entries() const { return entries_; }
+
+ private:
+  template <typename Entry>
+  void Record(const Entry& entry) {
+    std::ostringstream stream;
+    stream << entry;
+    entries_.push_back(stream.str());
+  }
+
+  std::vector<std::string> entries_;
+};
+
+IndexingFactNode PackageFile() {
+  return T(D{IndexingFactType::kFile, Anchor("/root/p.svh"),
+             Anchor("package p;\n  int x;\nendpackage\n")},
+           T(D{IndexingFactType::kPackage, Anchor("p", 8, 1)},
+             T(D{IndexingFactType::kVariableDefinition, Anchor("x", 17, 1)})));
+}
+
+IndexingFactNode ModuleFile() {
+  return T(D{IndexingFactType::kFile, Anchor("/root/m.sv"),
+             Anchor("module m;\n  import p::*;\nendmodule\n")},
+           T(D{IndexingFactType::kModule, Anchor("m", 7, 1)},
+             T(D{IndexingFactType::kPackageImport, Anchor("p", 19, 1)})));
+}
+
+std::vector<std::string> ExtractedEntries(const IndexingFactNode& file_list) {
+  const VerilogProject project("/root", {});
+  RecordingOutput output;
+  StreamKytheFactsEntries(&output, file_list, project);
+  return output.Entries();
+}
+
+TEST(StreamKytheFactsEntriesTest, SameFactsOfSeveralFilesOutputOnce) {
+  // The package file is extracted twice, e.g. both as included by the module
+  // file and as listed: its facts and edges are the same both times.
+  const std::vector<std::string> entries = ExtractedEntries(
+      T(D{IndexingFactType::kFileList, Anchor("files"), Anchor("/root")},
+        PackageFile(), ModuleFile(), PackageFile()));
+  EXPECT_EQ(std::set<std::string>(entries.begin(), entries.end()).size(),
+            entries.size());
+
+  const std::vector<std::string> once_entries = ExtractedEntries(
+      T(D{IndexingFactType::kFileList, Anchor("files"), Anchor("/root")},
+        PackageFile(), ModuleFile()));
+  EXPECT_THAT(entries, testing::ElementsAreArray(once_entries));
+}
+
+}  // namespace
+}  // namespace kythe
+}  // namespace verilog
@@ -60,6 +60,29 @@ TEST(SignatureTest, Equality) {
   }
 }
 
+TEST(SignatureTest, EqualityOfSeparatelyBuiltSignatures) {
+  const Signature s1(Signature("foobar"), "baz");
+  const Signature s2(Signature("foobar"), "baz");
+  const Signature s3(Signature("foo"), "barbaz");
+  EXPECT_EQ(s1, s2);
+  EXPECT_NE(s1, s3);
+  EXPECT_EQ(s1.Name(), "baz");
+}
+
+TEST(SignatureTest, DigestOfParents) {
+  const Signature file("file.sv");
+  const Signature module(file, "m");
+  const Signature variable(module, "x");
+  const SignatureDigest digest = variable.Digest();
+  EXPECT_EQ(digest.Depth(), 3);
+  EXPECT_EQ(digest.HashAtDepth(3), digest.Hash());
+  EXPECT_EQ(digest.HashAtDepth(2), module.Digest().Hash());
+  // The first name is left out of digests.
+  EXPECT_EQ(digest.HashAtDepth(1), Signature().Digest().Hash());
+  EXPECT_EQ(module.Digest(), Signature(Signature("other.sv"), "m").Digest());
+  EXPECT_FALSE(module.Digest() == variable.Digest());
+}
+
 TEST(VNameTest, DefaultCtor) {
   const VName vname;
   std::ostringstream stream;
@@ -14,6 +14,13 @@
 
 #include "verilog/tools/kythe/kythe_proto_output.h"
 
+#include <algorithm>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <utility>
+
 #include "google/protobuf/io/coded_stream.h"
 #include "google/protobuf/io/zero_copy_stream_impl.h"
 #include "third_party/proto/kythe/storage.pb.h"
@@ -58,23 +65,89 @@ Entry ConvertFactToEntry(const Fact& fact) {
   return entry;
 }
 
-// Output entry to the stream.
-void OutputProto(const Entry& entry, FileOutputStream* stream) {
-  CodedOutputStream coded_stream(stream);
-  coded_stream.WriteVarint32(entry.ByteSizeLong());
-  entry.SerializeToCodedStream(&coded_stream);
+// Appends the entry, preceded by its size, to "out".
+void AppendDelimited(const Entry& entry, std::string* out) {
+  uint8_t size[5];  // The longest varint32.
+  const uint8_t* const size_end =
+      CodedOutputStream::WriteVarint32ToArray(entry.ByteSizeLong(), size);
+  out->append(reinterpret_cast<const char*>(size), size_end - size);
+  entry.AppendToString(out);
 }
 
 }  // namespace
 
-KytheProtoOutput::KytheProtoOutput(int fd) : out_(fd) {}
-KytheProtoOutput::~KytheProtoOutput() { out_.Close(); }
+KytheProtoOutput::KytheProtoOutput(int fd, size_t buffer_size,
+                                   bool writer_thread)
+    : buffer_size_(buffer_size),
+      // Which writes in blocks of the same size.
+      out_(fd, static_cast<int>(std::clamp<size_t>(buffer_size, 1, 1 << 30))) {
+  batch_.reserve(buffer_size_);
+  if (writer_thread) writer_ = std::thread([this]() { WriterLoop(); });
+}
+
+KytheProtoOutput::~KytheProtoOutput() {
+  WriteBatch();
+  if (writer_.joinable()) {
+    {
+      const std::lock_guard<std::mutex> l(lock_);
+      exiting_ = true;
+    }
+    changed_.notify_all();
+    writer_.join();
+  }
+  out_.Close();
+}
 
 void KytheProtoOutput::Emit(const Fact& fact) {
-  OutputProto(ConvertFactToEntry(fact), &out_);
+  AppendDelimited(ConvertFactToEntry(fact), &batch_);
+  MaybeWriteBatch();
 }
 void KytheProtoOutput::Emit(const Edge& edge) {
-  OutputProto(ConvertEdgeToEntry(edge), &out_);
+  AppendDelimited(ConvertEdgeToEntry(edge), &batch_);
+  MaybeWriteBatch();
+}
+
+void KytheProtoOutput::MaybeWriteBatch() {
+  if (batch_.size() >= buffer_size_) WriteBatch();
+}
+
+void KytheProtoOutput::WriteBatch() {
+  if (batch_.empty()) return;
+  if (!writer_.joinable()) {
+    Write(batch_);
+    batch_.clear();
+    return;
+  }
+  {
+    std::unique_lock<std::mutex> l(lock_);
+    changed_.wait(
+        l, [this]() { return pending_batches_.size() < kMaxPendingBatches; });
+    pending_batches_.push_back(std::move(batch_));
+  }
+  changed_.notify_all();
+  batch_.clear();
+  batch_.reserve(buffer_size_);
+}
+
+void KytheProtoOutput::Write(const std::string& batch) {
+  CodedOutputStream coded_stream(&out_);
+  coded_stream.WriteRaw(batch.data(), batch.size());
+}
+
+void KytheProtoOutput::WriterLoop() {
+  std::unique_lock<std::mutex> l(lock_);
+  for (;;) {
+    changed_.wait(l,
+                  [this]() { return !pending_batches_.empty() || exiting_; });
+    // All batches are written before exiting.
+    if (pending_batches_.empty()) return;
+    const std::string batch = std::move(pending_batches_.front());
+    pending_batches_.pop_front();
+    l.unlock();
+    changed_.notify_all();
+    Write(batch);
+    l.lock();
+  }
 }
 
 }  // namespace kythe
@@ -15,6 +15,13 @@
 #ifndef VERIBLE_VERILOG_TOOLS_KYTHE_KYTHE_PROTO_OUTPUT_H_
 #define VERIBLE_VERILOG_TOOLS_KYTHE_KYTHE_PROTO_OUTPUT_H_
 
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <thread>
+
 #include "google/protobuf/io/zero_copy_stream_impl.h"
 #include "verilog/tools/kythe/kythe_facts.h"
 #include "verilog/tools/kythe/kythe_facts_extractor.h"
@@ -22,9 +29,18 @@
 namespace verilog {
 namespace kythe {
 
+// Writes Kythe entries to a file descriptor, each preceded by its size.
+// Entries are serialized into batches of about "buffer_size" bytes, each of
+// which is written at once. With a "writer_thread", batches are written by a
+// separate thread while the next ones are serialized.
 class KytheProtoOutput final : public KytheOutput {
  public:
-  explicit KytheProtoOutput(int output_fd);
+  static constexpr size_t kDefaultBufferSize = 1 << 20;
+
+  explicit KytheProtoOutput(int output_fd,
+                            size_t buffer_size = kDefaultBufferSize,
+                            bool writer_thread = false);
+  // Writes the remaining entries.
   ~KytheProtoOutput() final;
 
   // Output Kythe facts from the indexing data in proto format.
@@ -32,7 +48,28 @@ class KytheProtoOutput final : public KytheOutput {
   void Emit(const Edge& edge) final;
 
  private:
+  // Batches handed to the writer thread that are not written yet. Beyond
+  // that, serialization waits for the output.
+  static constexpr size_t kMaxPendingBatches = 4;
+
+  // Writes the current batch, or hands it to the writer thread, if full.
+  void MaybeWriteBatch();
+  void WriteBatch();
+
+  void Write(const std::string& batch);
+  void WriterLoop();
+
+  const size_t buffer_size_;
   ::google::protobuf::io::FileOutputStream out_;
+
+  // Serialized entries not written yet.
+  std::string batch_;
+
+  std::mutex lock_;
+  std::condition_variable changed_;
+  std::deque<std::string> pending_batches_;  // Oldest first.
+  bool exiting_ = false;
+  std::thread writer_;  // Only with "writer_thread".
 };
 
 }  // namespace kythe
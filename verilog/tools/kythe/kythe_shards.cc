@@ -0,0 +1,148 @@
+// Copyright 2017-2023 The Verible Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "verilog/tools/kythe/kythe_shards.h"
+
+#include <cstdint>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "absl/container/flat_hash_set.h"
+#include "absl/status/status.h"
+#include "absl/status/statusor.h"
+#include "absl/strings/str_cat.h"
+#include "absl/strings/string_view.h"
+#include "absl/strings/strip.h"
+#include "verilog/tools/kythe/indexing_facts_cache.h"
+#include "verilog/tools/kythe/indexing_facts_tree.h"
+#include "verilog/tools/kythe/verilog_extractor_indexing_fact_type.h"
+
+namespace verilog {
+namespace kythe {
+
+// References whose extraction neither defines symbols nor changes scopes.
+static bool IsPlainReference(IndexingFactType type) {
+  switch (type) {
+    case IndexingFactType::kVariableReference:
+    case IndexingFactType::kMemberReference:
+    case IndexingFactType::kFunctionCall:
+    case IndexingFactType::kMacroCall:
+    case IndexingFactType::kModuleNamedPort:
+    case IndexingFactType::kNamedParam:
+      return true;
+    default:
+      return false;
+  }
+}
+
+// Returns true if nothing in the tree of "node" defines symbols.
+static bool OnlyPlainReferences(const IndexingFactNode& node) {
+  if (!IsPlainReference(node.Value().GetIndexingFactType())) return false;
+  for (const IndexingFactNode& child : node.Children()) {
+    if (!OnlyPlainReferences(child)) return false;
+  }
+  return true;
+}
+
+static IndexingFactNode SummarizeNode(const IndexingFactNode& node) {
+  const IndexingNodeData& data = node.Value();
+  IndexingNodeData summary_data(data.GetIndexingFactType());
+  const bool is_file = data.GetIndexingFactType() == IndexingFactType::kFile;
+  for (size_t i = 0; i < data.Anchors().size(); ++i) {
+    // The second anchor of a file is its whole text.
+    if (is_file && i == 1) {
+      summary_data.AppendAnchor(Anchor(""));
+    } else {
+      summary_data.AppendAnchor(Anchor(data.Anchors()[i]));
+    }
+  }
+  IndexingFactNode summary(std::move(summary_data));
+  for (const IndexingFactNode& child : node.Children()) {
+    if (OnlyPlainReferences(child)) continue;
+    summary.Children().push_back(SummarizeNode(child));
+  }
+  return summary;
+}
+
+IndexingFactNode SummarizeScopes(const IndexingFactNode& file_list) {
+  return SummarizeNode(file_list);
+}
+
+// Summaries are stored like the entries of the indexing facts cache, without
+// included files.
+std::string SerializeScopeSummary(const IndexingFactNode& summary) {
+  return SerializeIndexingFacts(summary, {});
+}
+
+absl::StatusOr<IndexingFactNode> DeserializeScopeSummary(
+    absl::string_view bytes) {
+  absl::StatusOr<CachedIndexingFacts> facts = DeserializeIndexingFacts(bytes);
+  if (!facts.ok() || !facts->included_files.empty() ||
+      facts->facts_tree.Value().GetIndexingFactType() !=
+          IndexingFactType::kFileList) {
+    return absl::DataLossError("Malformed scope summary.");
+  }
+  return std::move(facts->facts_tree);
+}
+
+// Removes the next entry from "rest" into "entry".  Returns false if "rest"
+// ends in the middle of an entry.
+static bool NextEntry(absl::string_view* rest, bool delimited,
+                      absl::string_view* entry) {
+  if (!delimited) {
+    const size_t end = rest->find('\n');
+    *entry = rest->substr(0, end == absl::string_view::npos ? end : end + 1);
+    rest->remove_prefix(entry->size());
+    return true;
+  }
+  // Protos are preceded by their size as a varint32.
+  uint64_t size = 0;
+  size_t size_bytes = 0;
+  for (int shift = 0;; shift += 7) {
+    if (size_bytes >= rest->size() || shift > 28) return false;
+    const uint8_t byte = (*rest)[size_bytes++];
+    size |= static_cast<uint64_t>(byte & 0x7f) << shift;
+    if ((byte & 0x80) == 0) break;
+  }
+  if (size > rest->size() - size_bytes) return false;
+  *entry = rest->substr(0, size_bytes + size);
+  rest->remove_prefix(entry->size());
+  return true;
+}
+
+absl::StatusOr<std::string> MergeShardOutputs(
+    const std::vector<absl::string_view>& outputs, bool delimited) {
+  std::string merged;
+  absl::flat_hash_set<absl::string_view> seen;
+  for (size_t i = 0; i < outputs.size(); ++i) {
+    absl::string_view rest = outputs[i];
+    while (!rest.empty()) {
+      absl::string_view entry;
+      if (!NextEntry(&rest, delimited, &entry)) {
+        return absl::DataLossError(absl::StrCat(
+            "Output of shard ", i, " ends in the middle of an entry."));
+      }
+      // The last line might miss its newline.
+      const absl::string_view key =
+          delimited ? entry : absl::StripSuffix(entry, "\n");
+      if (key.empty() || !seen.insert(key).second) continue;
+      absl::StrAppend(&merged, key, delimited ? "" : "\n");
+    }
+  }
+  return merged;
+}
+
+}  // namespace kythe
+}  // namespace verilog
@@ -0,0 +1,53 @@
+// Copyright 2017-2023 The Verible Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// Extracting the Kythe facts of a project in shards, e.g. on several
+// machines: each shard parses and extracts only its files, and resolves the
+// symbols of the others with a summary of the scopes of the whole project,
+// that is made once beforehand.  The outputs of the shards are then merged,
+// dropping the entries that several of them output.
+
+#ifndef VERIBLE_VERILOG_TOOLS_KYTHE_KYTHE_SHARDS_H_
+#define VERIBLE_VERILOG_TOOLS_KYTHE_KYTHE_SHARDS_H_
+
+#include <string>
+#include <vector>
+
+#include "absl/status/statusor.h"
+#include "absl/strings/string_view.h"
+#include "verilog/tools/kythe/indexing_facts_tree.h"
+
+namespace verilog {
+namespace kythe {
+
+// Returns the facts tree of a project (tagged kFileList) without what does
+// not define any symbols: the text of the files, and references that have
+// no definitions below them.  Kythe facts extracted with the summary resolve
+// to the same symbols as with the whole facts tree.
+IndexingFactNode SummarizeScopes(const IndexingFactNode& file_list);
+
+std::string SerializeScopeSummary(const IndexingFactNode& summary);
+absl::StatusOr<IndexingFactNode> DeserializeScopeSummary(
+    absl::string_view bytes);
+
+// Returns the entries of the "outputs" of all shards, each entry once, in the
+// order they are first found.  Entries are lines of JSON, or with "delimited",
+// protos preceded by their size.
+absl::StatusOr<std::string> MergeShardOutputs(
+    const std::vector<absl::string_view>& outputs, bool delimited);
+
+}  // namespace kythe
+}  // namespace verilog
+
+#endif  // VERIBLE_VERILOG_TOOLS_KYTHE_KYTHE_SHARDS_H_
@@ -0,0 +1,95 @@
+// Copyright 2017-2023 The Verible Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "verilog/tools/kythe/kythe_shards.h"
+
+#include <string>
+
+#include "absl/strings/string_view.h"
+#include "common/util/tree_operations.h"
+#include "gtest/gtest.h"
+#include "verilog/tools/kythe/indexing_facts_tree.h"
+
+namespace verilog {
+namespace kythe {
+namespace {
+
+using T = IndexingFactNode;
+using D = IndexingNodeData;
+
+IndexingFactNode ProjectFactsTree() {
+  return T(D{IndexingFactType::kFileList, Anchor("files"), Anchor("/root")},
+           T(D{IndexingFactType::kFile, Anchor("/root/m.sv"),
+               Anchor("module m;\n  int x = y;\n  f(x);\nendmodule\n")},
+             T(D{IndexingFactType::kModule, Anchor("m", 7, 1)},
+               T(D{IndexingFactType::kVariableDefinition, Anchor("x", 16, 1)},
+                 T(D{IndexingFactType::kVariableReference,
+                     Anchor("y", 20, 1)})),
+               T(D{IndexingFactType::kFunctionCall, Anchor("f", 25, 1)},
+                 T(D{IndexingFactType::kVariableReference,
+                     Anchor("x", 27, 1)})))));
+}
+
+void ExpectSameTrees(const IndexingFactNode& left,
+                     const IndexingFactNode& right) {
+  const auto result_pair = DeepEqual(left, right);
+  EXPECT_EQ(result_pair.left, nullptr) << *result_pair.left;
+  EXPECT_EQ(result_pair.right, nullptr) << *result_pair.right;
+}
+
+TEST(SummarizeScopesTest, KeepsOnlyDefinitions) {
+  const IndexingFactNode expected(
+      D{IndexingFactType::kFileList, Anchor("files"), Anchor("/root")},
+      T(D{IndexingFactType::kFile, Anchor("/root/m.sv"), Anchor("")},
+        T(D{IndexingFactType::kModule, Anchor("m", 7, 1)},
+          T(D{IndexingFactType::kVariableDefinition, Anchor("x", 16, 1)}))));
+  ExpectSameTrees(SummarizeScopes(ProjectFactsTree()), expected);
+}
+
+TEST(SummarizeScopesTest, SerializationRoundTrip) {
+  const IndexingFactNode summary = SummarizeScopes(ProjectFactsTree());
+  const auto read = DeserializeScopeSummary(SerializeScopeSummary(summary));
+  ASSERT_TRUE(read.ok()) << read.status();
+  ExpectSameTrees(*read, summary);
+
+  EXPECT_FALSE(DeserializeScopeSummary("").ok());
+  // Facts of a single file are no summary.
+  EXPECT_FALSE(
+      DeserializeScopeSummary(
+          SerializeScopeSummary(summary.Children().front()))
+          .ok());
+}
+
+TEST(MergeShardOutputsTest, JsonLinesOnce) {
+  const auto merged = MergeShardOutputs({"a\nb\n", "b\nc", "", "a\nd\n"},
+                                        /*delimited=*/false);
+  ASSERT_TRUE(merged.ok()) << merged.status();
+  EXPECT_EQ(*merged, "a\nb\nc\nd\n");
+}
+
+TEST(MergeShardOutputsTest, DelimitedEntriesOnce) {
+  // Entries may contain newlines.
+  const std::string a("\x02" "a\n", 3);
+  const std::string b("\x01" "b", 2);
+  const auto merged =
+      MergeShardOutputs({a + b, b + a, a}, /*delimited=*/true);
+  ASSERT_TRUE(merged.ok()) << merged.status();
+  EXPECT_EQ(*merged, a + b);
+
+  EXPECT_FALSE(MergeShardOutputs({a + "\x03" "b"}, /*delimited=*/true).ok());
+}
+
+}  // namespace
+}  // namespace kythe
+}  // namespace verilog
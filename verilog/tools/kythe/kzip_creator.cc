@@ -18,12 +18,18 @@
 
 #include <array>
 #include <cstdio>
+#include <filesystem>
+#include <memory>
 #include <string>
+#include <system_error>
+#include <utility>
 #include <vector>
 
 #include "absl/status/status.h"
+#include "absl/status/statusor.h"
 #include "absl/strings/escaping.h"
 #include "absl/strings/string_view.h"
+#include "common/strings/mem_block.h"
 #include "common/util/file_util.h"
 #include "common/util/simple_zip.h"
 #include "third_party/proto/kythe/analysis.pb.h"
@@ -43,14 +49,34 @@ std::string SHA256Digest(absl::string_view content) {
       absl::string_view(reinterpret_cast<const char*>(buf.data()), buf.size()));
 }
 
+// Returns the key of "path" in digests_by_path_.
+std::string CanonicalPath(absl::string_view path) {
+  std::error_code error;
+  const std::filesystem::path canonical_path =
+      std::filesystem::canonical(std::string(path), error);
+  return error ? std::string(path) : canonical_path.string();
+}
+
+// Keeps the "block" alive until the archive is done with it.
+verible::zip::ByteSource MemBlockByteSource(
+    std::shared_ptr<const verible::MemBlock> block) {
+  const verible::zip::ByteSource source =
+      verible::zip::MemoryByteSource(block->AsStringView());
+  return [block, source]() { return source(); };
+}
+
 constexpr int kKZipCompressionLevel = 9;
 }  // namespace
 
-KzipCreator::KzipCreator(absl::string_view output_path)
+KzipCreator::KzipCreator(absl::string_view output_path,
+                         int compression_threads)
     : zip_file_(fopen(std::string(output_path).c_str(), "wb"), &fclose),
-      archive_(kKZipCompressionLevel, [this](absl::string_view s) {
-        return fwrite(s.data(), 1, s.size(), zip_file_.get()) == s.size();
-      }) {
+      archive_(
+          kKZipCompressionLevel,
+          [this](absl::string_view s) {
+            return fwrite(s.data(), 1, s.size(), zip_file_.get()) == s.size();
+          },
+          compression_threads) {
   // Create the directory structure.
   archive_.AddFile("root/", verible::zip::MemoryByteSource(""));
   archive_.AddFile(kFileRoot, verible::zip::MemoryByteSource(""));
@@ -60,11 +86,93 @@ KzipCreator::KzipCreator(absl::string_view output_path)
 std::string KzipCreator::AddSourceFile(absl::string_view path,
                                        absl::string_view content) {
   std::string digest = SHA256Digest(content);
+  if (!source_digests_.insert(digest).second) return digest;
+  const std::string archive_path = verible::file::JoinPath(kFileRoot, digest);
+  // The content might only be compressed after it is gone.
+  archive_.AddFile(archive_path,
+                   verible::zip::OwnedMemoryByteSource(std::string(content)));
+  return digest;
+}
+
+std::string KzipCreator::AddSourceFile(
+    absl::string_view path, std::unique_ptr<verible::MemBlock> content) {
+  std::string digest = SHA256Digest(content->AsStringView());
+  AddHashedSourceFile(digest, std::move(content));
+  return digest;
+}
+
+void KzipCreator::AddHashedSourceFile(
+    const std::string& digest, std::unique_ptr<verible::MemBlock> content) {
+  if (!source_digests_.insert(digest).second) return;
   const std::string archive_path = verible::file::JoinPath(kFileRoot, digest);
-  archive_.AddFile(archive_path, verible::zip::MemoryByteSource(content));
+  archive_.AddFile(archive_path, MemBlockByteSource(std::move(content)));
+}
+
+absl::StatusOr<std::string> KzipCreator::AddSourceFileFromPath(
+    absl::string_view path) {
+  const std::string key = CanonicalPath(path);
+  const auto found = digests_by_path_.find(key);
+  if (found != digests_by_path_.end()) return found->second;
+
+  absl::StatusOr<std::unique_ptr<verible::MemBlock>> content =
+      verible::file::GetContentAsMemBlock(key);
+  if (!content.ok()) return content.status();
+  std::string digest = AddSourceFile(path, *std::move(content));
+  digests_by_path_.emplace(key, digest);
   return digest;
 }
 
+std::vector<absl::StatusOr<std::string>> KzipCreator::AddSourceFilesFromPaths(
+    const std::vector<std::string>& paths, int jobs) {
+  // Each file that is not in the archive yet is read once.
+  std::vector<std::string> keys;
+  keys.reserve(paths.size());
+  std::vector<std::string> to_read;
+  absl::flat_hash_map<std::string, size_t> read_index;
+  for (const std::string& path : paths) {
+    keys.push_back(CanonicalPath(path));
+    if (digests_by_path_.contains(keys.back())) continue;
+    if (read_index.emplace(keys.back(), to_read.size()).second) {
+      to_read.push_back(keys.back());
+    }
+  }
+
+  // Hashed by the thread that read it, while others are still read.
+  struct ReadFile {
+    absl::StatusOr<std::unique_ptr<verible::MemBlock>> content;
+    std::string digest;
+  };
+  std::vector<ReadFile> read(to_read.size());
+  verible::file::GetContentsAsMemBlocks(
+      to_read, jobs,
+      [&read](size_t i,
+              absl::StatusOr<std::unique_ptr<verible::MemBlock>> content) {
+        if (content.ok()) {
+          read[i].digest = SHA256Digest((*content)->AsStringView());
+        }
+        read[i].content = std::move(content);
+      });
+
+  std::vector<absl::StatusOr<std::string>> digests;
+  digests.reserve(paths.size());
+  for (const std::string& key : keys) {
+    const auto found = digests_by_path_.find(key);
+    if (found != digests_by_path_.end()) {
+      digests.emplace_back(found->second);
+      continue;
+    }
+    ReadFile& file = read[read_index.at(key)];
+    if (!file.content.ok()) {
+      digests.emplace_back(file.content.status());
+      continue;
+    }
+    AddHashedSourceFile(file.digest, *std::move(file.content));
+    digests_by_path_.emplace(key, file.digest);
+    digests.emplace_back(file.digest);
+  }
+  return digests;
+}
+
 absl::Status KzipCreator::AddCompilationUnit(
     const ::kythe::proto::IndexedCompilation& unit) {
   std::string content;
@@ -74,7 +182,8 @@ absl::Status KzipCreator::AddCompilationUnit(
   const std::string digest = SHA256Digest(content);
   const std::string archive_path =
       verible::file::JoinPath(kProtoUnitRoot, digest);
-  archive_.AddFile(archive_path, verible::zip::MemoryByteSource(content));
+  archive_.AddFile(archive_path,
+                   verible::zip::OwnedMemoryByteSource(std::move(content)));
   return absl::OkStatus();
 }
 
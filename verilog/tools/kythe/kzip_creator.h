@@ -18,9 +18,14 @@
 #include <cstdio>
 #include <memory>
 #include <string>
+#include <vector>
 
+#include "absl/container/flat_hash_map.h"
+#include "absl/container/flat_hash_set.h"
 #include "absl/status/status.h"
+#include "absl/status/statusor.h"
 #include "absl/strings/string_view.h"
+#include "common/strings/mem_block.h"
 #include "common/util/simple_zip.h"
 #include "third_party/proto/kythe/analysis.pb.h"
 
@@ -29,21 +34,51 @@ namespace kythe {
 
 // Creator of Kythe Kzip archives based on the compilation unit
 // (https://kythe.io/docs/kythe-kzip.html).
+// Source files are stored by the digest of their content, each distinct
+// content only once.
 class KzipCreator final {
  public:
   // Initializes the archive. Crashes if initialization fails.
-  explicit KzipCreator(absl::string_view output_path);
+  // Files are compressed on "compression_threads" threads (see
+  // verible::zip::Encoder), if any.
+  explicit KzipCreator(absl::string_view output_path,
+                       int compression_threads = 0);
 
   // Adds source code file to the Kzip. Returns its SHA digest.
   std::string AddSourceFile(absl::string_view path, absl::string_view content);
 
+  // Same, without copying the content, which is released once compressed.
+  std::string AddSourceFile(absl::string_view path,
+                            std::unique_ptr<verible::MemBlock> content);
+
+  // Adds the source code file at "path" to the Kzip, memory mapped. Paths
+  // to the same file (e.g. through symlinks) are only read once. Returns its
+  // SHA digest.
+  absl::StatusOr<std::string> AddSourceFileFromPath(absl::string_view path);
+
+  // Same as AddSourceFileFromPath() for each of "paths", which are read and
+  // hashed on up to "jobs" threads.  They are added in the order of "paths",
+  // so the Kzip does not depend on "jobs".  Returns the digest or error of
+  // each path.
+  std::vector<absl::StatusOr<std::string>> AddSourceFilesFromPaths(
+      const std::vector<std::string>& paths, int jobs);
+
   // Adds compilation unit to the Kzip.
   absl::Status AddCompilationUnit(
       const ::kythe::proto::IndexedCompilation& unit);
 
  private:
+  // Adds "content" with the SHA digest "digest", unless already there.
+  void AddHashedSourceFile(const std::string& digest,
+                           std::unique_ptr<verible::MemBlock> content);
+
   std::unique_ptr<FILE, decltype(&fclose)> zip_file_;
   verible::zip::Encoder archive_;
+
+  // Digests of the source files in the archive.
+  absl::flat_hash_set<std::string> source_digests_;
+  // Digests of files added by path, by canonical path.
+  absl::flat_hash_map<std::string, std::string> digests_by_path_;
 };
 
 }  // namespace kythe
@@ -20,6 +20,7 @@
 #include "absl/container/flat_hash_set.h"
 #include "absl/strings/str_cat.h"
 #include "absl/strings/string_view.h"
+#include "common/strings/string_interner.h"
 #include "common/util/logging.h"
 #include "verilog/tools/kythe/kythe_facts.h"
 
@@ -27,7 +28,7 @@ namespace verilog {
 namespace kythe {
 
 void ScopeResolver::SetCurrentScope(const Signature& scope) {
-  if (current_scope_ == scope && !current_scope_digest_.rolling_hash.empty()) {
+  if (current_scope_ == scope && current_scope_digest_.node != nullptr) {
     return;
   }
   current_scope_digest_ = scope.Digest();
@@ -39,8 +40,10 @@ void ScopeResolver::SetCurrentScope(const Signature& scope) {
 }
 
 void ScopeResolver::RemoveDefinitionFromCurrentScope(const VName& vname) {
-  absl::string_view name = vname.signature.Names().back();
-  auto scopes = variable_to_scoped_vname_.find(name);
+  absl::string_view name = vname.signature.Name();
+  const std::optional<verible::StringInterner::Id> name_id = names_.Find(name);
+  auto scopes = name_id ? variable_to_scoped_vname_.find(*name_id)
+                        : variable_to_scoped_vname_.end();
   if (scopes == variable_to_scoped_vname_.end()) {
     VLOG(1) << "No definition for '" << name << "'. Nothing to remove.";
     return;
@@ -76,24 +79,28 @@ void ScopeResolver::AppendScopeToCurrentScope(
 void ScopeResolver::AppendScopeToScope(
     const SignatureDigest& source_scope,
     const SignatureDigest& destination_scope) {
-  auto scope_vnames = scope_to_vnames_.find(source_scope);
-  if (scope_vnames == scope_to_vnames_.end()) {
-    VLOG(2) << "Can't find scope " << ScopeDebug(source_scope)
-            << " to append it to the current scope";
-    return;
-  }
   if (source_scope == destination_scope) {
     // The source and destination scope are equal. Nothing to add.
     return;
   }
+  // A copy, as adding to the destination scope may move the source's members.
+  const absl::flat_hash_set<VName> source_members =
+      ListScopeMembers(source_scope);
+  if (source_members.empty()) {
+    VLOG(2) << "Can't find scope " << ScopeDebug(source_scope)
+            << " to append it to the current scope";
+    return;
+  }
 
-  for (const auto& vn : scope_vnames->second) {
+  for (const auto& vn : source_members) {
     const std::optional<ScopedVname> vn_type =
-        FindScopeAndDefinition(vn.signature.Names().back(), source_scope);
+        FindScopeAndDefinition(vn.signature.Name(), source_scope);
     if (!vn_type) {
       continue;
     }
-    variable_to_scoped_vname_[vn.signature.Names().back()].insert(
+    const verible::StringInterner::Id name_id =
+        names_.Intern(vn.signature.Name());
+    variable_to_scoped_vname_[name_id].insert(
         ScopedVname{.type_scope = vn_type->type_scope,
                     .instantiation_scope = destination_scope,
                     .vname = vn});
@@ -112,40 +119,50 @@ void ScopeResolver::AddDefinitionToCurrentScope(
   RemoveDefinitionFromCurrentScope(new_member);
 
   auto current_scope_digest = CurrentScopeDigest();
-  variable_to_scoped_vname_[new_member.signature.Names().back()].insert(
+  const verible::StringInterner::Id name_id =
+      names_.Intern(new_member.signature.Name());
+  variable_to_scoped_vname_[name_id].insert(
       ScopedVname{.type_scope = type_scope,
                   .instantiation_scope = current_scope_digest,
                   .vname = new_member});
   scope_to_vnames_[current_scope_digest].insert(new_member);
 }
 
-std::optional<ScopedVname> ScopeResolver::FindScopeAndDefinition(
-    absl::string_view name, const SignatureDigest& scope_focus) {
-  VLOG(2) << "Find definition for '" << name << "' within scope "
-          << ScopeDebug(scope_focus);
-  auto scope = variable_to_scoped_vname_.find(name);
+const ScopedVname* ScopeResolver::FindMatch(
+    absl::string_view name, const SignatureDigest& scope_focus) const {
+  // Own definitions win over the frozen ones of the same depth.
+  const ScopedVname* match =
+      frozen_ != nullptr ? frozen_->FindMatch(name, scope_focus) : nullptr;
+  const std::optional<verible::StringInterner::Id> name_id = names_.Find(name);
+  auto scope = name_id ? variable_to_scoped_vname_.find(*name_id)
+                       : variable_to_scoped_vname_.end();
   if (scope == variable_to_scoped_vname_.end()) {
-    VLOG(2) << "Failed to find definition for '" << name << "' within scope "
+    VLOG(2) << "No definition for '" << name << "' within scope "
             << ScopeDebug(scope_focus) << " (unregistered name)";
-    return {};
+    return match;
   }
-  const ScopedVname* match = nullptr;
   for (auto& scope_member : scope->second) {
-    SignatureDigest digest = scope_member.instantiation_scope;
-    if (scope_focus.rolling_hash.size() < digest.rolling_hash.size() ||
+    const SignatureDigest& digest = scope_member.instantiation_scope;
+    if (scope_focus.Depth() < digest.Depth() ||
         (match != nullptr &&
-         digest.rolling_hash.size() <
-             match->instantiation_scope.rolling_hash.size())) {
+         digest.Depth() < match->instantiation_scope.Depth())) {
       // Mismatch, or not interesting (worse match).
       VLOG(2) << "Scope resolution mismatch for '" << name << "' at scope "
               << ScopeDebug(digest);
       continue;
     }
-    if (scope_focus.rolling_hash[digest.rolling_hash.size() - 1] ==
-        digest.Hash()) {
+    if (scope_focus.HashAtDepth(digest.Depth()) == digest.Hash()) {
       match = &scope_member;
     }
   }
+  return match;
+}
+
+std::optional<ScopedVname> ScopeResolver::FindScopeAndDefinition(
+    absl::string_view name, const SignatureDigest& scope_focus) {
+  VLOG(2) << "Find definition for '" << name << "' within scope "
+          << ScopeDebug(scope_focus);
+  const ScopedVname* match = FindMatch(name, scope_focus);
   if (match != nullptr) {
     VLOG(2) << "Found definition for '" << name << "' within scope "
             << ScopeDebug(scope_focus);
@@ -161,14 +178,22 @@ std::optional<ScopedVname> ScopeResolver::FindScopeAndDefinition(
   return FindScopeAndDefinition(name, CurrentScopeDigest());
 }
 
-const absl::flat_hash_set<VName>& ScopeResolver::ListScopeMembers(
-    const SignatureDigest& scope_digest) const {
-  const static absl::flat_hash_set<VName> kEmptyMemberList;
+void ScopeResolver::CollectScopeMembers(
+    const SignatureDigest& scope_digest,
+    absl::flat_hash_set<VName>* members) const {
+  if (frozen_ != nullptr) frozen_->CollectScopeMembers(scope_digest, members);
   auto scope = scope_to_vnames_.find(scope_digest);
   if (scope == scope_to_vnames_.end()) {
-    return kEmptyMemberList;
+    return;
   }
-  return scope->second;
+  members->insert(scope->second.begin(), scope->second.end());
+}
+
+absl::flat_hash_set<VName> ScopeResolver::ListScopeMembers(
+    const SignatureDigest& scope_digest) const {
+  absl::flat_hash_set<VName> members;
+  CollectScopeMembers(scope_digest, &members);
+  return members;
 }
 
 std::string ScopeResolver::ScopeDebug(const SignatureDigest& scope) const {
@@ -177,6 +202,7 @@ std::string ScopeResolver::ScopeDebug(const SignatureDigest& scope) const {
   }
   const auto s = scope_to_string_debug_.find(scope);
   if (s == scope_to_string_debug_.end()) {
+    if (frozen_ != nullptr) return frozen_->ScopeDebug(scope);
     return absl::StrCat("UNKNOWN ", scope.Hash());
   }
   return absl::StrCat(s->second, " H: ", scope.Hash());
@@ -25,6 +25,7 @@
 #include "absl/container/flat_hash_set.h"
 #include "absl/container/node_hash_map.h"
 #include "absl/strings/string_view.h"
+#include "common/strings/string_interner.h"
 #include "verilog/tools/kythe/kythe_facts.h"
 
 namespace verilog {
@@ -46,8 +47,10 @@ struct ScopedVname {
 };
 template <typename H>
 H AbslHashValue(H state, const ScopedVname& v) {
+  // Hashing the signature directly avoids computing (and allocating) its
+  // digest, which is equivalent for equality.
   return H::combine(std::move(state), v.type_scope, v.instantiation_scope,
-                    v.vname.signature.Digest());
+                    v.vname.signature);
 }
 
 // ScopeResolver enables resolving a symbol to its definition (to make it
@@ -77,9 +80,23 @@ H AbslHashValue(H state, const ScopedVname& v) {
 // Scope resolver marks `my_var` as the member of /my_pkg/my_class and is able
 // to resolve its reference inside `my_function` (by exploring the scopes bottom
 // up and comparing the substrings).
+//
+// To extract files in parallel, the scopes of a whole project can be resolved
+// in two phases: first, one resolver is built from all files (e.g. from their
+// scope summaries) and frozen, then each thread extracts its files with its
+// own resolver layered over the frozen one.  No locking is needed, as the
+// frozen resolver is only read from then on.
 class ScopeResolver {
  public:
-  explicit ScopeResolver(const Signature& top_scope) {
+  explicit ScopeResolver(const Signature& top_scope)
+      : ScopeResolver(top_scope, nullptr) {}
+
+  // Layers a resolver over "frozen": its scopes and definitions are found as
+  // if they had been added to this one first, and what is added or removed
+  // only changes this one.  "frozen" must outlive this resolver, and must not
+  // change anymore; any number of resolvers, in any threads, can share it.
+  ScopeResolver(const Signature& top_scope, const ScopeResolver* frozen)
+      : frozen_(frozen) {
     SetCurrentScope(top_scope);
   }
 
@@ -110,7 +127,9 @@ class ScopeResolver {
   void AppendScopeToScope(const SignatureDigest& source_scope,
                           const SignatureDigest& destination_scope);
 
-  // Removes the given VName from the current scope.
+  // Removes the given VName from the current scope.  Definitions of the
+  // frozen resolver stay, but are hidden by those added again in the same
+  // scope.
   void RemoveDefinitionFromCurrentScope(const VName& vname);
 
   // Adds a definition & its type to the current scope.
@@ -120,7 +139,8 @@ class ScopeResolver {
   // Adds a definition without external type to the current scope.
   void AddDefinitionToCurrentScope(const VName& new_member);
 
-  const absl::flat_hash_set<VName>& ListScopeMembers(
+  // Returns the members of the scope, including those of the frozen resolver.
+  absl::flat_hash_set<VName> ListScopeMembers(
       const SignatureDigest& scope_digest) const;
 
   // Returns human readable description of the scope.
@@ -134,9 +154,34 @@ class ScopeResolver {
   // the scope for easier debugging.
   void EnableDebug() { enable_debug_ = true; }
 
+  // Returns a copy of "text" that lives as long as the resolver, e.g. a name
+  // of the signature of a definition, so that definitions do not refer to the
+  // facts trees they were extracted from.
+  absl::string_view Intern(absl::string_view text) {
+    return names_.Text(names_.Intern(text));
+  }
+
  private:
-  // Mapping from the symbol name to all scopes where it's present.
-  absl::flat_hash_map<std::string, absl::flat_hash_set<ScopedVname>>
+  // Returns the best match for "name" within "scope_focus", of this resolver
+  // or of the frozen ones, or nullptr.
+  const ScopedVname* FindMatch(absl::string_view name,
+                               const SignatureDigest& scope_focus) const;
+
+  // Adds the members of the scope to "members", with those of the frozen
+  // resolvers.
+  void CollectScopeMembers(const SignatureDigest& scope_digest,
+                           absl::flat_hash_set<VName>* members) const;
+
+  // The resolver this one is layered over, if any.  Not owned.
+  const ScopeResolver* const frozen_;
+
+  // Symbol names, interned once, so that they are not copied and hashed as
+  // strings for every definition.
+  verible::StringInterner names_;
+
+  // Mapping from the (interned) symbol name to all scopes where it's present.
+  absl::flat_hash_map<verible::StringInterner::Id,
+                      absl::flat_hash_set<ScopedVname>>
       variable_to_scoped_vname_;
 
   // Mapping from scope to all its members.
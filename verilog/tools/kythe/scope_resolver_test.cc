@@ -14,6 +14,7 @@
 
 #include "verilog/tools/kythe/scope_resolver.h"
 
+#include <thread>
 #include <vector>
 
 #include "absl/strings/string_view.h"
@@ -188,6 +189,74 @@ TEST(ScopeResolverTests, AppendScope) {
   EXPECT_TRUE(def_in_current_scope_post_appending.has_value());
 }
 
+TEST(ScopeResolverTests, LayeredOverFrozen) {
+  ScopeResolver frozen(signatures[5]);
+  frozen.AddDefinitionToCurrentScope(vnames[0]);
+  frozen.AddDefinitionToCurrentScope(vnames[1], signatures[0].Digest());
+
+  ScopeResolver scope_resolver(signatures[5], &frozen);
+  scope_resolver.AddDefinitionToCurrentScope(vnames[2]);
+  // Hides the frozen definition in the same scope.
+  scope_resolver.AddDefinitionToCurrentScope(vnames[1], signatures[1].Digest());
+
+  const auto frozen_def =
+      scope_resolver.FindScopeAndDefinition(vnames[0].signature.Names().back());
+  ASSERT_TRUE(frozen_def.has_value());
+  EXPECT_EQ(frozen_def->vname.signature, vnames[0].signature);
+  const auto own_def =
+      scope_resolver.FindScopeAndDefinition(vnames[2].signature.Names().back());
+  ASSERT_TRUE(own_def.has_value());
+  EXPECT_EQ(own_def->vname.signature, vnames[2].signature);
+  const auto redefined =
+      scope_resolver.FindScopeAndDefinition(vnames[1].signature.Names().back());
+  ASSERT_TRUE(redefined.has_value());
+  EXPECT_EQ(redefined->type_scope, signatures[1].Digest());
+
+  EXPECT_THAT(scope_resolver.ListScopeMembers(signatures[5].Digest()),
+              UnorderedElementsAreArray({vnames[0], vnames[1], vnames[2]}));
+  // The frozen resolver does not change.
+  EXPECT_FALSE(
+      frozen.FindScopeAndDefinition(vnames[2].signature.Names().back())
+          .has_value());
+  EXPECT_EQ(frozen.FindScopeAndDefinition(vnames[1].signature.Names().back())
+                ->type_scope,
+            signatures[0].Digest());
+
+  // Scopes of the frozen resolver can be appended to own ones.
+  scope_resolver.SetCurrentScope(signatures[0]);
+  scope_resolver.AppendScopeToCurrentScope(signatures[5].Digest());
+  EXPECT_TRUE(
+      scope_resolver.FindScopeAndDefinition(vnames[0].signature.Names().back())
+          .has_value());
+}
+
+TEST(ScopeResolverTests, LayeredInManyThreads) {
+  ScopeResolver frozen(signatures[5]);
+  frozen.AddDefinitionToCurrentScope(vnames[0]);
+
+  constexpr int kThreads = 4;
+  std::vector<std::thread> threads;
+  std::vector<int> found(kThreads, 0);
+  for (int t = 0; t < kThreads; ++t) {
+    threads.emplace_back([&frozen, &found, t] {
+      for (int i = 0; i < 1000; ++i) {
+        ScopeResolver scope_resolver(signatures[5], &frozen);
+        scope_resolver.AddDefinitionToCurrentScope(vnames[1 + t]);
+        found[t] += scope_resolver
+                        .FindScopeAndDefinition(
+                            vnames[0].signature.Names().back())
+                        .has_value() &&
+                    scope_resolver
+                        .FindScopeAndDefinition(
+                            vnames[1 + t].signature.Names().back())
+                        .has_value();
+      }
+    });
+  }
+  for (std::thread& thread : threads) thread.join();
+  EXPECT_THAT(found, ::testing::Each(1000));
+}
+
 }  // namespace
 }  // namespace kythe
 }  // namespace verilog
@@ -12,26 +12,37 @@
 // See the License for the specific language governing permissions and
 // limitations under the License.
 
+#include <algorithm>
 #include <deque>
 #include <fstream>
 #include <iostream>
+#include <memory>
+#include <optional>
 #include <string>
+#include <utility>
+#include <vector>
 
 #include "absl/flags/flag.h"
 #include "absl/status/status.h"
+#include "absl/status/statusor.h"
 #include "absl/strings/str_cat.h"
 #include "absl/strings/string_view.h"
 #include "absl/strings/substitute.h"
 #include "common/util/bijective_map.h"
 #include "common/util/enum_flags.h"
+#include "common/util/file_shards.h"
 #include "common/util/file_util.h"
 #include "common/util/init_command_line.h"
+#include "common/util/memory_stats.h"
+#include "common/util/thread_pool.h"
+#include "common/util/trace_events.h"
 #include "common/util/tree_operations.h"
 #include "verilog/analysis/verilog_analyzer.h"
 #include "verilog/analysis/verilog_project.h"
 #include "verilog/tools/kythe/indexing_facts_tree_extractor.h"
 #include "verilog/tools/kythe/kythe_facts_extractor.h"
 #include "verilog/tools/kythe/kythe_proto_output.h"
+#include "verilog/tools/kythe/kythe_shards.h"
 
 #ifndef _WIN32
 #include <unistd.h>  // for STDOUT_FILENO
@@ -109,36 +120,141 @@ if "A.sv" exists in both "directory1" and "directory2" the one in "directory1" i
 ABSL_FLAG(std::string, verilog_project_name, "",
           "Verilog project name to use as Kythe corpus. Optional");
 
+ABSL_FLAG(int, proto_output_buffer_size, 1 << 20,
+          "With --print_kythe_facts=proto: bytes of entries to serialize "
+          "before writing them at once.");
+
+ABSL_FLAG(bool, proto_output_writer_thread, false,
+          "With --print_kythe_facts=proto: write the output on a separate "
+          "thread, while further entries are serialized.");
+
+ABSL_FLAG(bool, print_memory_stats, false,
+          "Print the memory used by lexing and parsing, and the peak "
+          "resident set size, to stderr on exit.");
+
+ABSL_FLAG(std::string, trace_output, "",
+          "If not empty, write a trace of the parsing and extraction stages "
+          "to this file on exit, in Chrome trace event format "
+          "(chrome://tracing, ui.perfetto.dev).");
+
+ABSL_FLAG(int, jobs, 1,
+          "Number of files to parse and extract in parallel. 0 uses all "
+          "available cores. The output does not depend on it.");
+
+ABSL_FLAG(int, shard_count, 1,
+          "Split the files of the file list into this many shards, and only "
+          "extract the facts of those of --shard_index, against the symbols "
+          "of --scope_summary. Merge the outputs with --merge_shard_outputs.");
+ABSL_FLAG(int, shard_index, 0, "Shard to extract, 0 to --shard_count - 1.");
+ABSL_FLAG(std::string, scope_summary, "",
+          "Summary of the scopes of all files of the file list, from "
+          "--scope_summary_output, to resolve the symbols that the files of "
+          "a shard reference. Required with --shard_count.");
+ABSL_FLAG(std::string, scope_summary_output, "",
+          "If not empty, write the summary of the scopes of all files of the "
+          "file list to this file for --scope_summary, instead of extracting "
+          "Kythe facts.");
+ABSL_FLAG(std::vector<std::string>, merge_shard_outputs, {},
+          "Comma-separated outputs of all shards, with the same "
+          "--print_kythe_facts (json or proto). Instead of extracting, print "
+          "their entries, each once.");
+
 namespace verilog {
 namespace kythe {
 
 // Prints Kythe facts in proto format to stdout.
 static void PrintKytheFactsProtoEntries(
     const IndexingFactNode& file_list_facts_tree, const VerilogProject& project,
-    int fd) {
-  KytheProtoOutput proto_output(fd);
-  StreamKytheFactsEntries(&proto_output, file_list_facts_tree, project);
+    const IndexingFactNode* scope_summary, int fd) {
+  KytheProtoOutput proto_output(
+      fd, std::max(1, absl::GetFlag(FLAGS_proto_output_buffer_size)),
+      absl::GetFlag(FLAGS_proto_output_writer_thread));
+  StreamKytheFactsEntries(&proto_output, file_list_facts_tree, project,
+                          scope_summary);
 }
 
 // Just collect the facts, but don't print anything. Mostly useful for
 // debugging error checking or performance.
 static void KytheFactsNullPrinter(const IndexingFactNode& file_list_facts_tree,
-                                  const VerilogProject& project) {
+                                  const VerilogProject& project,
+                                  const IndexingFactNode* scope_summary) {
   class NullPrinter final : public KytheOutput {
    public:
     void Emit(const Fact& fact) final {}
     void Emit(const Edge& edge) final {}
   } printer;
-  StreamKytheFactsEntries(&printer, file_list_facts_tree, project);
+  StreamKytheFactsEntries(&printer, file_list_facts_tree, project,
+                          scope_summary);
+}
+
+static int ExtractionJobs() {
+  return verible::JobsOrAllCores(absl::GetFlag(FLAGS_jobs));
+}
+
+// Extracts the Kythe facts of each file as soon as its facts tree is
+// extracted, and releases it, so that memory does not grow with the number of
+// files.
+static std::vector<absl::Status> StreamTranslationUnits(
+    VerilogProject* project, const std::vector<std::string>& file_names) {
+  std::vector<absl::Status> errors;
+  const PrintMode mode = absl::GetFlag(FLAGS_print_kythe_facts);
+  std::unique_ptr<KytheOutput> output;
+  switch (mode) {
+    case PrintMode::kJSON:
+      output = std::make_unique<KytheJsonOutput>(std::cout);
+      break;
+    case PrintMode::kJSONDebug:
+      std::cout << "[";
+      output = std::make_unique<KytheJsonOutput>(std::cout, /*debug=*/true);
+      break;
+    case PrintMode::kProto:
+      output = std::make_unique<KytheProtoOutput>(
+          STDOUT_FILENO,
+          std::max(1, absl::GetFlag(FLAGS_proto_output_buffer_size)),
+          absl::GetFlag(FLAGS_proto_output_writer_thread));
+      break;
+    case PrintMode::kNone: {
+      class NullPrinter final : public KytheOutput {
+       public:
+        void Emit(const Fact& fact) final {}
+        void Emit(const Edge& edge) final {}
+      };
+      output = std::make_unique<NullPrinter>();
+      break;
+    }
+  }
+  {
+    KytheProjectExtractor extractor(output.get(), *project);
+    ExtractFiles(
+        project, file_names,
+        [&extractor](IndexingFactNode file_facts) {
+          extractor.ExtractFile(file_facts);
+        },
+        &errors, ExtractionJobs());
+  }
+  output.reset();  // Writes the remaining proto entries.
+  // Same as streaming KytheFactsPrinter.
+  if (mode == PrintMode::kJSONDebug) std::cout << "]" << std::endl;
+  if (mode == PrintMode::kJSON || mode == PrintMode::kJSONDebug) {
+    std::cout << std::endl;
+  }
+  return errors;
 }
 
+// With a "scope_summary", "file_names" are the files of one shard.
 static std::vector<absl::Status> ExtractTranslationUnits(
     absl::string_view file_list_path, VerilogProject* project,
-    const std::vector<std::string>& file_names) {
+    const std::vector<std::string>& file_names,
+    const IndexingFactNode* scope_summary) {
+  // The whole facts tree is only needed to print it, or to merge it with the
+  // summary of other shards.
+  if (!absl::GetFlag(FLAGS_printextraction) && scope_summary == nullptr) {
+    return StreamTranslationUnits(project, file_names);
+  }
   std::vector<absl::Status> errors;
   const verilog::kythe::IndexingFactNode file_list_facts_tree(
       verilog::kythe::ExtractFiles(file_list_path, project, file_names,
-                                   &errors));
+                                   &errors, ExtractionJobs()));
 
   // check for printextraction flag, and print extraction if on
   if (absl::GetFlag(FLAGS_printextraction)) {
@@ -149,26 +265,103 @@ static std::vector<absl::Status> ExtractTranslationUnits(
   // check how to output kythe facts.
   switch (absl::GetFlag(FLAGS_print_kythe_facts)) {
     case PrintMode::kJSON:
-      std::cout << KytheFactsPrinter(file_list_facts_tree, *project)
+      std::cout << KytheFactsPrinter(file_list_facts_tree, *project,
+                                     /*debug=*/false, scope_summary)
                 << std::endl;
       break;
     case PrintMode::kJSONDebug:
       std::cout << KytheFactsPrinter(file_list_facts_tree, *project,
-                                     /*debug=*/true)
+                                     /*debug=*/true, scope_summary)
                 << std::endl;
       break;
     case PrintMode::kProto:
       PrintKytheFactsProtoEntries(file_list_facts_tree, *project,
-                                  STDOUT_FILENO);
+                                  scope_summary, STDOUT_FILENO);
       break;
     case PrintMode::kNone:
-      KytheFactsNullPrinter(file_list_facts_tree, *project);
+      KytheFactsNullPrinter(file_list_facts_tree, *project, scope_summary);
       break;
   }
 
   return errors;
 }
 
+// Extracts the facts trees of all "file_names" and writes the summary of
+// their scopes to "summary_path".
+static std::vector<absl::Status> WriteScopeSummary(
+    absl::string_view file_list_path, VerilogProject* project,
+    const std::vector<std::string>& file_names,
+    absl::string_view summary_path) {
+  std::vector<absl::Status> errors;
+  const IndexingFactNode file_list_facts_tree(ExtractFiles(
+      file_list_path, project, file_names, &errors, ExtractionJobs()));
+  if (auto status = verible::file::SetContents(
+          summary_path,
+          SerializeScopeSummary(SummarizeScopes(file_list_facts_tree)));
+      !status.ok()) {
+    errors.push_back(status);
+  }
+  return errors;
+}
+
+// Prints the entries of the shard outputs of --merge_shard_outputs, each
+// once.  Returns the exit status.
+static int MergeShardOutputFiles(const std::vector<std::string>& paths) {
+  const PrintMode mode = absl::GetFlag(FLAGS_print_kythe_facts);
+  if (mode != PrintMode::kJSON && mode != PrintMode::kProto) {
+    LOG(ERROR) << "Only --print_kythe_facts=json or proto outputs can be "
+                  "merged.";
+    return 1;
+  }
+  std::vector<std::string> contents;
+  contents.reserve(paths.size());
+  for (const std::string& path : paths) {
+    absl::StatusOr<std::string> content =
+        verible::file::GetContentAsString(path);
+    if (!content.ok()) {
+      LOG(ERROR) << content.status();
+      return 1;
+    }
+    contents.push_back(*std::move(content));
+  }
+  const absl::StatusOr<std::string> merged = MergeShardOutputs(
+      std::vector<absl::string_view>(contents.begin(), contents.end()),
+      /*delimited=*/mode == PrintMode::kProto);
+  if (!merged.ok()) {
+    LOG(ERROR) << merged.status();
+    return 1;
+  }
+  std::cout << *merged << std::flush;
+  return std::cout.good() ? 0 : 1;
+}
+
+// Returns those of "file_paths", relative to "file_list_root", in the shard
+// selected by --shard_index and --shard_count, balanced by file size.
+static absl::StatusOr<std::vector<std::string>> FilesOfShardFromFlags(
+    absl::string_view file_list_root,
+    const std::vector<std::string>& file_paths) {
+  std::vector<std::string> full_paths;
+  full_paths.reserve(file_paths.size());
+  for (const std::string& path : file_paths) {
+    full_paths.push_back(verible::file::JoinPath(file_list_root, path));
+  }
+  const std::vector<absl::string_view> all_files(full_paths.begin(),
+                                                 full_paths.end());
+  const absl::StatusOr<std::vector<absl::string_view>> shard_files =
+      verible::FilesOfShard(all_files, absl::GetFlag(FLAGS_shard_index),
+                            absl::GetFlag(FLAGS_shard_count), {});
+  if (!shard_files.ok()) return shard_files.status();
+  // Files of the shard are in their original order.
+  std::vector<std::string> result;
+  auto next = shard_files->begin();
+  for (size_t i = 0; i < all_files.size() && next != shard_files->end(); ++i) {
+    if (next->data() != all_files[i].data()) continue;
+    result.push_back(file_paths[i]);
+    ++next;
+  }
+  return result;
+}
+
 }  // namespace kythe
 }  // namespace verilog
 
@@ -184,6 +377,20 @@ Output: Produces Indexing Facts for kythe (http://kythe.io).
 )");
   const auto args = verible::InitCommandLine(usage, &argc, &argv);
 
+  if (absl::GetFlag(FLAGS_print_memory_stats)) {
+    verible::EnableSubsystemMemoryStats();
+  }
+  if (const std::string trace_output = absl::GetFlag(FLAGS_trace_output);
+      !trace_output.empty()) {
+    verible::EnableTraceOutput(trace_output);
+  }
+
+  if (const std::vector<std::string> outputs =
+          absl::GetFlag(FLAGS_merge_shard_outputs);
+      !outputs.empty()) {
+    return verilog::kythe::MergeShardOutputFiles(outputs);
+  }
+
   const std::string file_list_path = absl::GetFlag(FLAGS_file_list_path);
   if (file_list_path.empty()) {
     LOG(ERROR) << "No file list path was specified";
@@ -211,9 +418,47 @@ Output: Produces Indexing Facts for kythe (http://kythe.io).
                                   absl::GetFlag(FLAGS_verilog_project_name),
                                   /*populate_string_maps=*/false);
 
-  const std::vector<absl::Status> errors(
-      verilog::kythe::ExtractTranslationUnits(file_list_path, &project,
-                                              file_paths));
+  const std::string scope_summary_output =
+      absl::GetFlag(FLAGS_scope_summary_output);
+  const std::string scope_summary_path = absl::GetFlag(FLAGS_scope_summary);
+  std::vector<std::string> shard_file_paths;
+  std::optional<verilog::kythe::IndexingFactNode> scope_summary;
+  if (scope_summary_output.empty() && !scope_summary_path.empty()) {
+    const absl::StatusOr<std::vector<std::string>> shard_files =
+        verilog::kythe::FilesOfShardFromFlags(file_list_root, file_paths);
+    if (!shard_files.ok()) {
+      LOG(ERROR) << shard_files.status();
+      return 1;
+    }
+    shard_file_paths = *shard_files;
+    const absl::StatusOr<std::string> summary_bytes =
+        verible::file::GetContentAsString(scope_summary_path);
+    absl::StatusOr<verilog::kythe::IndexingFactNode> summary =
+        summary_bytes.ok()
+            ? verilog::kythe::DeserializeScopeSummary(*summary_bytes)
+            : summary_bytes.status();
+    if (!summary.ok()) {
+      LOG(ERROR) << "Error while reading scope summary: " << summary.status();
+      return 1;
+    }
+    scope_summary = *std::move(summary);
+  } else if (absl::GetFlag(FLAGS_shard_count) != 1 &&
+             scope_summary_output.empty()) {
+    LOG(ERROR) << "--shard_count needs a --scope_summary.";
+    return 1;
+  }
+
+  std::vector<absl::Status> errors;
+  if (!scope_summary_output.empty()) {
+    errors = verilog::kythe::WriteScopeSummary(file_list_path, &project,
+                                               file_paths, scope_summary_output);
+  } else if (scope_summary.has_value()) {
+    errors = verilog::kythe::ExtractTranslationUnits(
+        file_list_path, &project, shard_file_paths, &*scope_summary);
+  } else {
+    errors = verilog::kythe::ExtractTranslationUnits(file_list_path, &project,
+                                                     file_paths, nullptr);
+  }
   if (!errors.empty()) {
     LOG(ERROR) << "Encountered some issues while indexing files (could result "
                   "in missing indexing data):"
@@ -159,5 +159,58 @@ grep -q "barr" "$MY_OUTPUT_FILE" || {
   exit 1
 }
 
+################################################################################
+echo "=== Extract in shards, and merge their outputs."
+
+cat > "${TEST_TMPDIR}/pkg.sv" <<EOF
+package pkg;
+  localparam int fooo = 1;
+endpackage
+EOF
+cat > "${TEST_TMPDIR}/top.sv" <<EOF
+module top;
+  localparam int barr = pkg::fooo;
+endmodule
+EOF
+
+printf "pkg.sv\ntop.sv\n" > "${TEST_TMPDIR}/file_list"
+"$extractor" \
+  --file_list_path "${TEST_TMPDIR}/file_list" \
+  --file_list_root "${TEST_TMPDIR}" \
+  --print_kythe_facts=json \
+  | grep -v '^$' | sort > "${TEST_TMPDIR}/unsharded.txt"
+
+"$extractor" \
+  --file_list_path "${TEST_TMPDIR}/file_list" \
+  --file_list_root "${TEST_TMPDIR}" \
+  --scope_summary_output "${TEST_TMPDIR}/summary.bin" || {
+  echo "Expected the scope summary to be written."
+  exit 1
+}
+
+for shard in 0 1; do
+  "$extractor" \
+    --file_list_path "${TEST_TMPDIR}/file_list" \
+    --file_list_root "${TEST_TMPDIR}" \
+    --scope_summary "${TEST_TMPDIR}/summary.bin" \
+    --shard_count 2 --shard_index "$shard" \
+    --print_kythe_facts=json \
+    > "${TEST_TMPDIR}/shard-${shard}.txt" || {
+    echo "Expected shard $shard to be extracted."
+    exit 1
+  }
+done
+
+"$extractor" \
+  --print_kythe_facts=json \
+  --merge_shard_outputs \
+  "${TEST_TMPDIR}/shard-0.txt,${TEST_TMPDIR}/shard-1.txt" \
+  | sort > "${TEST_TMPDIR}/merged.txt"
+
+diff -u "${TEST_TMPDIR}/unsharded.txt" "${TEST_TMPDIR}/merged.txt" || {
+  echo "Expected the merged shards to have the facts of the whole project."
+  exit 1
+}
+
 ################################################################################
 echo "PASS"
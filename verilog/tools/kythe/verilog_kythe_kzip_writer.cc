@@ -12,17 +12,20 @@
 // See the License for the specific language governing permissions and
 // limitations under the License.
 
+#include <algorithm>
 #include <array>
 #include <string>
 #include <vector>
 
 #include "absl/flags/flag.h"
+#include "absl/status/statusor.h"
 #include "absl/strings/ascii.h"
 #include "absl/strings/escaping.h"
 #include "absl/strings/str_cat.h"
 #include "common/util/file_util.h"
 #include "common/util/init_command_line.h"
 #include "common/util/logging.h"
+#include "common/util/thread_pool.h"
 #include "third_party/proto/kythe/analysis.pb.h"
 #include "verilog/analysis/verilog_filelist.h"
 #include "verilog/tools/kythe/kzip_creator.h"
@@ -39,6 +42,10 @@ ABSL_FLAG(std::string, corpus, "",
 
 ABSL_FLAG(std::string, output_path, "", "Path where to write the kzip.");
 
+ABSL_FLAG(int, jobs, 1,
+          "Number of files to read, hash and compress in parallel. 0 uses all "
+          "available cores. The kzip does not depend on it.");
+
 ABSL_RETIRED_FLAG(
     std::string, filelist_root, ".",
     "The absolute location which we prepend to the files in the file "
@@ -103,20 +110,24 @@ Output: Produces Kythe KZip (https://kythe.io/docs/kythe-kzip.html).
   // Construct Verible project
   const std::vector<std::string>& file_paths(filelist.file_paths);
 
-  verilog::kythe::KzipCreator kzip(output_path);
+  const int jobs = verible::JobsOrAllCores(absl::GetFlag(FLAGS_jobs));
+  // With one job, files are compressed on the main thread as they are added.
+  verilog::kythe::KzipCreator kzip(output_path, jobs > 1 ? jobs : 0);
   const std::string filelist_digest =
       kzip.AddSourceFile("filelist", filelist.ToString());
   auto* filelist_input = unit->add_required_input();
   *filelist_input->mutable_info()->mutable_path() = "filelist";
   *filelist_input->mutable_info()->mutable_digest() = filelist_digest;
-  for (const std::string& file_path : file_paths) {
-    auto content_or = verible::file::GetContentAsString(file_path);
-    if (!content_or.ok()) {
+  const std::vector<absl::StatusOr<std::string>> digests =
+      kzip.AddSourceFilesFromPaths(file_paths, jobs);
+  for (size_t i = 0; i < file_paths.size(); ++i) {
+    const std::string& file_path = file_paths[i];
+    if (!digests[i].ok()) {
       LOG(ERROR) << "Failed to open " << file_path
-                 << ". Error: " << content_or.status();
+                 << ". Error: " << digests[i].status();
       continue;
     }
-    const std::string digest = kzip.AddSourceFile(file_path, *content_or);
+    const std::string& digest = *digests[i];
     auto* file_input = unit->add_required_input();
     *file_input->mutable_info()->mutable_path() = file_path;
     *file_input->mutable_info()->mutable_digest() = digest;
@@ -230,6 +230,115 @@ status="$?"
   exit 1
 }
 
+################################################################################
+echo "=== Test --jobs produces the same output as serial linting"
+
+CLEAN_FILE="${TEST_TMPDIR}/lint-clean.sv"
+cat > "${CLEAN_FILE}" <<EOF
+class c;
+endclass
+EOF
+
+"$lint_tool" --rules=no-tabs "$TEST_FILE" "$CLEAN_FILE" "$TEST_FILE" \
+    > "${MY_OUTPUT_FILE}.serial.out" 2> "${MY_OUTPUT_FILE}.serial.err"
+serial_status="$?"
+
+"$lint_tool" --rules=no-tabs --jobs=3 "$TEST_FILE" "$CLEAN_FILE" "$TEST_FILE" \
+    > "${MY_OUTPUT_FILE}.jobs.out" 2> "${MY_OUTPUT_FILE}.jobs.err"
+status="$?"
+[[ $status == $serial_status ]] || {
+  echo "Expected exit code $serial_status, but got $status"
+  exit 1
+}
+
+diff "${MY_OUTPUT_FILE}.serial.out" "${MY_OUTPUT_FILE}.jobs.out" || {
+  echo "Expected same stdout with --jobs as serially."
+  exit 1
+}
+
+diff "${MY_OUTPUT_FILE}.serial.err" "${MY_OUTPUT_FILE}.jobs.err" || {
+  echo "Expected same stderr with --jobs as serially."
+  exit 1
+}
+
+################################################################################
+echo "=== Test --print_stats"
+
+"$lint_tool" --rules=no-tabs --print_stats "$CLEAN_FILE" \
+    > "${MY_OUTPUT_FILE}.out" 2> "${MY_OUTPUT_FILE}.err"
+status="$?"
+[[ $status == 0 ]] || {
+  echo "Expected exit code 0, but got $status"
+  exit 1
+}
+
+grep -q "${CLEAN_FILE}: analyzer statistics:" "${MY_OUTPUT_FILE}.err" || {
+  echo "Expected analyzer statistics header in stderr."
+  exit 1
+}
+
+grep -q "^parse: .* leaves" "${MY_OUTPUT_FILE}.err" || {
+  echo "Expected parse statistics in stderr."
+  exit 1
+}
+
+################################################################################
+echo "=== Test --server with plain requests"
+
+"$lint_tool" --ruleset=none --rules=no-tabs --server > "${MY_OUTPUT_FILE}.out" \
+    2> "${MY_OUTPUT_FILE}.err" <<EOF
+$TEST_FILE
+$CLEAN_FILE
+
+--ruleset=none --rules=-no-tabs $TEST_FILE
+--no_such_flag $TEST_FILE
+EOF
+status="$?"
+[[ $status == 0 ]] || {
+  echo "Expected exit code 0, but got $status"
+  exit 1
+}
+
+cat > "${MY_OUTPUT_FILE}.expected" <<EOF
+${TEST_FILE}:1:6: Use spaces, not tabs. [Style: tabs] [no-tabs]
+exit: 1
+exit: 0
+exit: 0
+Unsupported argument in request: --no_such_flag
+exit: 2
+EOF
+
+diff "${MY_OUTPUT_FILE}.expected" "${MY_OUTPUT_FILE}.out" || {
+  echo "Unexpected --server output."
+  exit 1
+}
+
+echo "=== Test --persistent_worker with JSON requests"
+
+"$lint_tool" --ruleset=none --persistent_worker > "${MY_OUTPUT_FILE}.out" \
+    2> "${MY_OUTPUT_FILE}.err" <<EOF
+{"arguments": ["--rules=no-tabs", "$TEST_FILE"], "requestId": 7}
+{"arguments": ["$TEST_FILE"], "requestId": 8}
+not json {
+EOF
+status="$?"
+[[ $status == 0 ]] || {
+  echo "Expected exit code 0, but got $status"
+  exit 1
+}
+
+cat > "${MY_OUTPUT_FILE}.expected" <<EOF
+{"exitCode":1,"output":"${TEST_FILE}:1:6: Use spaces, not tabs. [Style: tabs] [no-tabs]\n","requestId":7}
+{"exitCode":0,"output":"","requestId":8}
+exit: 2
+EOF
+
+# The last line is a plain request of two files that don't exist.
+diff "${MY_OUTPUT_FILE}.expected" "${MY_OUTPUT_FILE}.out" || {
+  echo "Unexpected --persistent_worker output."
+  exit 1
+}
+
 ################################################################################
 echo "=== Test module filename rule for stdin"
 
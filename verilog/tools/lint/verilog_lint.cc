@@ -18,22 +18,47 @@
 // Example usage:
 // verilog_lint files...
 
+#include <algorithm>
+#include <cstdlib>
 #include <fstream>
+#include <functional>
 #include <iostream>
+#include <map>
 #include <memory>
+#include <optional>
 #include <sstream>  // IWYU pragma: keep  // for ostringstream
 #include <string>   // for string, allocator, etc
+#include <utility>
 #include <vector>
 
 #include "absl/flags/flag.h"
 #include "absl/status/status.h"
+#include "absl/status/statusor.h"
+#include "absl/strings/ascii.h"
+#include "absl/strings/match.h"
 #include "absl/strings/str_cat.h"
+#include "absl/strings/str_split.h"
 #include "absl/strings/string_view.h"
+#include "absl/time/clock.h"
+#include "absl/time/time.h"
+#include "common/analysis/lint_rule_profile.h"
 #include "common/analysis/violation_handler.h"
+#include "common/strings/patch.h"
+#include "common/strings/position.h"
+#include "common/util/deferred_deleter.h"
 #include "common/util/enum_flags.h"
+#include "common/util/file_shards.h"
 #include "common/util/file_util.h"
 #include "common/util/init_command_line.h"
+#include "common/util/interval_set.h"
+#include "common/util/line_ranges_flag.h"
 #include "common/util/logging.h"  // for operator<<, LOG, LogMessage, etc
+#include "common/util/memory_stats.h"
+#include "common/util/status_macros.h"
+#include "common/util/thread_pool.h"
+#include "common/util/trace_events.h"
+#include "nlohmann/json.hpp"
+#include "verilog/analysis/verilog_analyzer.h"
 #include "verilog/analysis/verilog_linter.h"
 #include "verilog/analysis/verilog_linter_configuration.h"
 
@@ -74,6 +99,72 @@ bool AbslParseFlag(absl::string_view text, AutofixMode* mode,
   return AutofixModeEnumStringMap().Parse(text, mode, error, "--autofix value");
 }
 
+// How lint violations are reported.
+enum class DiagnosticsFormat {
+  kText,       // Messages for humans, on stderr
+  kJsonLines,  // One JSON object per violation and line, on stdout
+};
+
+static const verible::EnumNameMap<DiagnosticsFormat>&
+DiagnosticsFormatEnumStringMap() {
+  static const verible::EnumNameMap<DiagnosticsFormat>
+      kDiagnosticsFormatEnumStringMap({
+          {"text", DiagnosticsFormat::kText},
+          {"jsonl", DiagnosticsFormat::kJsonLines},
+      });
+  return kDiagnosticsFormatEnumStringMap;
+}
+
+std::ostream& operator<<(std::ostream& stream, DiagnosticsFormat format) {
+  return DiagnosticsFormatEnumStringMap().Unparse(format, stream);
+}
+
+std::string AbslUnparseFlag(const DiagnosticsFormat& format) {
+  std::ostringstream stream;
+  DiagnosticsFormatEnumStringMap().Unparse(format, stream);
+  return stream.str();
+}
+
+bool AbslParseFlag(absl::string_view text, DiagnosticsFormat* format,
+                   std::string* error) {
+  return DiagnosticsFormatEnumStringMap().Parse(text, format, error,
+                                                "--diagnostics_format value");
+}
+
+// How the cost of the lint rules is reported, if at all.
+enum class ProfileRulesFormat {
+  kNone,
+  kTable,  // Aligned columns for humans
+  kJson,   // An array of one object per rule
+};
+
+static const verible::EnumNameMap<ProfileRulesFormat>&
+ProfileRulesFormatEnumStringMap() {
+  static const verible::EnumNameMap<ProfileRulesFormat>
+      kProfileRulesFormatEnumStringMap({
+          {"none", ProfileRulesFormat::kNone},
+          {"table", ProfileRulesFormat::kTable},
+          {"json", ProfileRulesFormat::kJson},
+      });
+  return kProfileRulesFormatEnumStringMap;
+}
+
+std::ostream& operator<<(std::ostream& stream, ProfileRulesFormat format) {
+  return ProfileRulesFormatEnumStringMap().Unparse(format, stream);
+}
+
+std::string AbslUnparseFlag(const ProfileRulesFormat& format) {
+  std::ostringstream stream;
+  ProfileRulesFormatEnumStringMap().Unparse(format, stream);
+  return stream.str();
+}
+
+bool AbslParseFlag(absl::string_view text, ProfileRulesFormat* format,
+                   std::string* error) {
+  return ProfileRulesFormatEnumStringMap().Parse(text, format, error,
+                                                 "--profile_rules value");
+}
+
 // LINT.IfChange
 
 ABSL_FLAG(bool, check_syntax, true,
@@ -96,6 +187,24 @@ ABSL_FLAG(bool, show_diagnostic_context, false,
           "line on which the diagnostic was found,"
           "followed by a line with a position marker");
 
+ABSL_FLAG(DiagnosticsFormat, diagnostics_format, DiagnosticsFormat::kText,
+          "[text|jsonl]; with jsonl, lint violations are written to stdout "
+          "as they are found, one JSON object per line, and syntax errors "
+          "go to stderr instead. Only effective with --autofix=no.");
+
+ABSL_FLAG(verible::LineRanges, lines, {},
+          "Specific lines to lint, 1-based, comma-separated, inclusive N-M "
+          "ranges, N is short for N-N.  Only violations on these lines are "
+          "reported, and syntax tree rules skip the code outside of them.  "
+          "By default, all lines are linted.  Only for a single file.  "
+          "(repeatable, cumulative)");
+ABSL_FLAG(std::string, diff, "",
+          "Unified diff (patch) file, or '-' for stdin.  If set, only the "
+          "lines that the patch adds are linted, like with --lines, and "
+          "files without added lines are not linted at all.  Files are "
+          "matched by their path in the patch, so create it with e.g. "
+          "'git diff --no-prefix'.");
+
 ABSL_FLAG(
     AutofixMode, autofix, AutofixMode::kNo,
     "autofix mode; one of "
@@ -104,6 +213,50 @@ ABSL_FLAG(std::string, autofix_output_file, "",
           "File to write a patch with autofixes to if "
           "--autofix=patch or --autofix=patch-interactive "
           "or a waiver file if --autofix=generate-waiver");
+ABSL_FLAG(int, autofix_max_passes, 1,
+          "With --autofix=patch or --autofix=inplace, lint the fixed text "
+          "again and apply the fixes found, up to this many passes in total, "
+          "until a pass changes nothing. Each file is still only written, or "
+          "patched, once. Not with --lint_variants.");
+ABSL_FLAG(int, jobs, 1,
+          "Number of files to lint in parallel. 0 uses all available cores. "
+          "Diagnostics are still printed in input file order. "
+          "Only effective with --autofix=no.");
+
+ABSL_FLAG(bool, lint_variants, false,
+          "If true, check and lint every `ifdef configuration of each file, "
+          "and report the merged diagnostics. Variants of a file are "
+          "analyzed on --jobs threads.");
+ABSL_FLAG(int, max_variants, 64,
+          "Maximum number of `ifdef configurations checked per file with "
+          "--lint_variants.");
+
+ABSL_FLAG(bool, print_stats, false,
+          "If true, print the time, token counts and memory of each analysis "
+          "phase (tokenize, filter, contextualize, preprocess, parse) of "
+          "each file to stderr.");
+
+ABSL_FLAG(bool, print_memory_stats, false,
+          "If true, print the memory used by lexing, parsing and linting, "
+          "and the peak resident set size, to stderr on exit.");
+
+ABSL_FLAG(std::string, trace_output, "",
+          "If not empty, write a trace of the lexing, parsing and linting "
+          "stages to this file on exit, in Chrome trace event format "
+          "(chrome://tracing, ui.perfetto.dev).");
+
+ABSL_FLAG(ProfileRulesFormat, profile_rules, ProfileRulesFormat::kNone,
+          "[none|table|json]; if not none, print the time each lint rule "
+          "took, the number of times the linters called it (per token, line, "
+          "syntax tree node or file that it handles), and the violations it "
+          "found, summed over all files, to stderr on exit.");
+
+ABSL_FLAG(bool, server, false,
+          "If true, keep running and lint the files of requests read from "
+          "stdin, one request per line, reusing rule configurations between "
+          "requests. See README.md for the request format.");
+ABSL_FLAG(bool, persistent_worker, false,
+          "Same as --server; passed by Bazel to persistent workers.");
 
 // LINT.ThenChange(README.md)
 
@@ -112,11 +265,377 @@ using verilog::LinterConfiguration;
 // LintOneFile returns 0, 1, or 2
 static const int kAutofixErrorExitStatus = 3;
 
+// Lines to lint of each file, from --lines or --diff.
+struct LinesToLint {
+  // Lines of the only file (--lines); empty for all lines.
+  verible::LineNumberSet lines;
+  // Added lines by file (--diff).  Unless set, files are linted entirely.
+  std::optional<verible::FileLineNumbersMap> diff_lines;
+
+  // Restricts 'config' to the lines of 'filename' to lint.  Returns false if
+  // there are none, and the file is not to be linted at all.
+  bool Restrict(absl::string_view filename, LinterConfiguration* config) const {
+    if (!diff_lines.has_value()) {
+      config->lines = lines;
+      return true;
+    }
+    const auto found = diff_lines->find(filename);
+    if (found == diff_lines->end() || found->second.empty()) return false;
+    config->lines = found->second;
+    return true;
+  }
+};
+
+// Returns the lines to lint, from --lines and --diff.
+static absl::StatusOr<LinesToLint> LinesToLintFromFlags(size_t num_files) {
+  LinesToLint result;
+  std::ostringstream errors;
+  const verible::LineRanges::storage_type& ranges =
+      verible::LineRanges::values;
+  if (!verible::ParseInclusiveRanges(&result.lines, ranges.begin(),
+                                     ranges.end(), &errors, '-')) {
+    return absl::InvalidArgumentError(
+        absl::StrCat(errors.str(), "Error parsing --lines.\nGot: --lines=",
+                     AbslUnparseFlag(verible::LineRanges())));
+  }
+  const std::string diff = absl::GetFlag(FLAGS_diff);
+  if (!result.lines.empty()) {
+    if (!diff.empty()) {
+      return absl::InvalidArgumentError(
+          "--lines and --diff can't be used together.");
+    }
+    if (num_files > 1) {
+      return absl::InvalidArgumentError(
+          "--lines only works for single files.");
+    }
+  }
+  if (!diff.empty()) {
+    const auto content = verible::file::GetContentAsString(diff);
+    if (!content.ok()) return content.status();
+    verible::PatchSet patch_set;
+    RETURN_IF_ERROR(patch_set.Parse(*content));
+    // All lines of new files are added.
+    result.diff_lines = patch_set.AddedLinesMap(true);
+  }
+  return result;
+}
+
+static void PrintAnalyzerStats(std::ostream& stream, absl::string_view filename,
+                               const verilog::VerilogAnalyzerStats& stats) {
+  stream << filename << ": analyzer statistics:" << std::endl << stats;
+}
+
+// Outcome of linting a single file, with its diagnostics buffered so that
+// results of concurrently linted files can be emitted in input order.
+struct BufferedLintResult {
+  int exit_status = 0;
+  absl::Duration time;      // spent linting the file
+  std::string stdout_text;  // syntax errors, or JSON Lines violations
+  std::string stderr_text;  // configuration errors and lint violations, or
+                            // syntax errors with JSON Lines
+};
+
+// Configures and lints one file, like the serial loop in main() does, but
+// captures all diagnostics instead of writing them to the standard streams.
+static BufferedLintResult LintOneFileBuffered(
+    absl::string_view filename, const LinesToLint& lines_to_lint,
+    verilog::LinterConfigurationCache* configurations) {
+  const absl::Time start = absl::Now();
+  BufferedLintResult result;
+  std::ostringstream out_stream;
+  std::ostringstream err_stream;
+  auto config_status = configurations->FromFlags(filename);
+  if (!config_status.ok()) {
+    err_stream << config_status.status().message() << std::endl;
+    result.exit_status = 1;
+  } else if (lines_to_lint.Restrict(filename, &*config_status)) {
+    const bool json_lines = absl::GetFlag(FLAGS_diagnostics_format) ==
+                            DiagnosticsFormat::kJsonLines;
+    std::unique_ptr<verible::ViolationHandler> violation_handler;
+    if (json_lines) {
+      violation_handler =
+          std::make_unique<verible::ViolationJsonLinesPrinter>(&out_stream);
+    } else {
+      violation_handler =
+          std::make_unique<verible::ViolationPrinter>(&err_stream);
+    }
+    const bool print_stats = absl::GetFlag(FLAGS_print_stats);
+    verilog::VerilogAnalyzerStats stats;
+    result.exit_status = verilog::LintOneFile(
+        json_lines ? &err_stream : &out_stream, filename, *config_status,
+        violation_handler.get(),
+        absl::GetFlag(FLAGS_check_syntax), absl::GetFlag(FLAGS_parse_fatal),
+        absl::GetFlag(FLAGS_lint_fatal),
+        absl::GetFlag(FLAGS_show_diagnostic_context),
+        print_stats ? &stats : nullptr);
+    if (print_stats) PrintAnalyzerStats(err_stream, filename, stats);
+  }
+  result.stdout_text = out_stream.str();
+  result.stderr_text = err_stream.str();
+  result.time = absl::Now() - start;
+  return result;
+}
+
+// Lints all files on a thread pool of 'jobs' threads.  Each file gets its own
+// result slot; slots are printed strictly in the order of 'filenames' to keep
+// the output identical to serial operation.
+// Appends the time each file took to 'shard_costs'.
+// Returns the maximum exit status of all files.
+static int LintFilesInParallel(
+    const std::vector<absl::string_view>& filenames, int jobs,
+    const LinesToLint& lines_to_lint,
+    verilog::LinterConfigurationCache* configurations,
+    std::string* shard_costs) {
+  verible::ThreadPool pool(jobs);
+  int exit_status = 0;
+  pool.ParallelMapInOrder(
+      filenames.size(),
+      [&](size_t i) {
+        return LintOneFileBuffered(filenames[i], lines_to_lint,
+                                   configurations);
+      },
+      [&](size_t i, const BufferedLintResult& result) {
+        absl::StrAppend(shard_costs,
+                        verible::FileCostLine(filenames[i], result.time));
+        std::cout << result.stdout_text << std::flush;
+        std::cerr << result.stderr_text << std::flush;
+        exit_status = std::max(exit_status, result.exit_status);
+      });
+  return exit_status;
+}
+
+// Writes 'shard_costs' to --shard_costs_output, if set.
+// Returns 'exit_status', or 1 if the file can't be written.
+static int WriteShardCosts(absl::string_view shard_costs, int exit_status) {
+  if (const absl::Status status =
+          verible::WriteShardCostsFromFlags(shard_costs);
+      !status.ok()) {
+    std::cerr << status.message() << std::endl;
+    return std::max(exit_status, 1);
+  }
+  return exit_status;
+}
+
+// Checks 'filenames' together with the project lint rules of the rules
+// configuration of the current directory, if any are enabled, after they were
+// linted one by one.  Configuration errors were reported by then.
+static int LintProjectFiles(const std::vector<absl::string_view>& filenames,
+                            verilog::LinterConfigurationCache* configurations,
+                            verible::ViolationHandler* violation_handler,
+                            int jobs) {
+  const auto config_status = configurations->FromFlags(".");
+  if (!config_status.ok()) return 1;
+  return verilog::LintProject(
+      &std::cerr, std::vector<std::string>(filenames.begin(), filenames.end()),
+      *config_status, violation_handler, absl::GetFlag(FLAGS_lint_fatal), jobs);
+}
+
+// Options of one --server request.  Defaults come from the flags.
+struct ServerRequest {
+  std::vector<std::string> files;
+  verilog::RuleSet ruleset = absl::GetFlag(FLAGS_ruleset);
+  verilog::RuleBundle rules = absl::GetFlag(FLAGS_rules);
+  std::string rules_config = absl::GetFlag(FLAGS_rules_config);
+  bool rules_config_search = absl::GetFlag(FLAGS_rules_config_search);
+  std::string waiver_files = absl::GetFlag(FLAGS_waiver_files);
+};
+
+// Parses the arguments of a --server request: file names, and the flags that
+// select rules, as --name=value (or --[no]rules_config_search).
+static absl::Status ParseServerArguments(const std::vector<std::string>& args,
+                                         ServerRequest* request) {
+  for (const std::string& arg : args) {
+    if (!absl::StartsWith(arg, "--")) {
+      request->files.push_back(arg);
+      continue;
+    }
+    const std::pair<absl::string_view, absl::string_view> flag =
+        absl::StrSplit(absl::string_view(arg).substr(2),
+                       absl::MaxSplits('=', 1));
+    std::string error;
+    bool ok = true;
+    if (flag.first == "rules") {
+      ok = AbslParseFlag(flag.second, &request->rules, &error);
+    } else if (flag.first == "ruleset") {
+      ok = AbslParseFlag(flag.second, &request->ruleset, &error);
+    } else if (flag.first == "rules_config") {
+      request->rules_config = std::string(flag.second);
+    } else if (flag.first == "waiver_files") {
+      request->waiver_files = std::string(flag.second);
+    } else if (arg == "--rules_config_search" ||
+               arg == "--rules_config_search=true") {
+      request->rules_config_search = true;
+    } else if (arg == "--norules_config_search" ||
+               arg == "--rules_config_search=false") {
+      request->rules_config_search = false;
+    } else {
+      return absl::InvalidArgumentError(
+          absl::StrCat("Unsupported argument in request: ", arg));
+    }
+    if (!ok) {
+      return absl::InvalidArgumentError(
+          absl::StrCat("Invalid argument ", arg, ": ", error));
+    }
+  }
+  return absl::OkStatus();
+}
+
+// Linter configurations of --server mode, by everything that they are made
+// from (including the contents of the rules configuration file), so that
+// each is only created once.
+class ServerLinterConfigurations {
+ public:
+  absl::StatusOr<LinterConfiguration> Get(const ServerRequest& request,
+                                          absl::string_view filename) {
+    std::string config_file = request.rules_config;
+    if (config_file.empty() && request.rules_config_search) {
+      // Not found is fine, like in LinterConfiguration::ConfigureFromOptions.
+      verible::file::UpwardFileSearch(filename, ".rules.verible_lint",
+                                      &config_file)
+          .IgnoreError();
+    }
+    std::string config_content;
+    if (!config_file.empty()) {
+      auto content = verible::file::GetContentAsString(config_file);
+      if (!content.ok()) return content.status();
+      config_content = *std::move(content);
+    }
+    std::string key = absl::StrCat(
+        AbslUnparseFlag(request.ruleset), "\n",
+        AbslUnparseFlag(request.rules), "\n", config_file, "\n",
+        request.waiver_files, "\n", config_content);
+    const auto found = configurations_.find(key);
+    if (found != configurations_.end()) return found->second;
+
+    const verilog::LinterOptions options = {
+        .ruleset = request.ruleset,
+        .rules = request.rules,
+        .config_file = config_file,
+        .rules_config_search = false,
+        .linting_start_file = std::string(filename),
+        .waiver_files = request.waiver_files,
+    };
+    LinterConfiguration config;
+    RETURN_IF_ERROR(config.ConfigureFromOptions(options));
+    return configurations_.emplace(std::move(key), std::move(config))
+        .first->second;
+  }
+
+ private:
+  std::map<std::string, LinterConfiguration> configurations_;
+};
+
+// Lints the files of one --server request, writing all diagnostics to
+// 'output'.  Returns the exit status, like main() would.
+static int LintServerRequest(const ServerRequest& request,
+                             ServerLinterConfigurations* configurations,
+                             std::ostream* output) {
+  int exit_status = 0;
+  for (const std::string& filename : request.files) {
+    const auto config = configurations->Get(request, filename);
+    if (!config.ok()) {
+      *output << config.status().message() << std::endl;
+      exit_status = 1;
+      continue;
+    }
+    verible::ViolationPrinter violation_printer(output);
+    const int lint_status = verilog::LintOneFile(
+        output, filename, *config, &violation_printer,
+        absl::GetFlag(FLAGS_check_syntax), absl::GetFlag(FLAGS_parse_fatal),
+        absl::GetFlag(FLAGS_lint_fatal),
+        absl::GetFlag(FLAGS_show_diagnostic_context));
+    exit_status = std::max(exit_status, lint_status);
+  }
+  return exit_status;
+}
+
+// Serves lint requests from stdin until it is closed.  A line that starts
+// with '{' is a WorkRequest of Bazel's JSON worker protocol, and is answered
+// with one line of WorkResponse; any other line is a list of arguments
+// separated by whitespace, and is answered with the diagnostics and a line
+// "exit: <status>".
+static int RunLintServer() {
+  ServerLinterConfigurations configurations;
+  std::string line;
+  while (std::getline(std::cin, line)) {
+    const absl::string_view request_text = absl::StripAsciiWhitespace(line);
+    if (request_text.empty()) continue;
+    const bool json_request = absl::StartsWith(request_text, "{");
+
+    std::vector<std::string> args;
+    nlohmann::json request_id = 0;
+    absl::Status status;
+    if (json_request) {
+      const auto work_request = nlohmann::json::parse(request_text, nullptr,
+                                                      /*allow_exceptions=*/false);
+      if (!work_request.is_object()) {
+        status = absl::InvalidArgumentError("Invalid JSON request.");
+      } else {
+        request_id = work_request.value("requestId", request_id);
+        const auto arguments = work_request.find("arguments");
+        if (arguments != work_request.end() && arguments->is_array()) {
+          for (const auto& argument : *arguments) {
+            if (!argument.is_string()) {
+              status = absl::InvalidArgumentError("Non-string argument.");
+              break;
+            }
+            args.push_back(argument.get<std::string>());
+          }
+        }
+      }
+    } else {
+      args = absl::StrSplit(request_text, absl::ByAnyChar(" \t"),
+                            absl::SkipEmpty());
+    }
+
+    std::ostringstream output;
+    int exit_status = 2;
+    ServerRequest request;
+    if (status.ok()) status = ParseServerArguments(args, &request);
+    if (status.ok()) {
+      exit_status = LintServerRequest(request, &configurations, &output);
+    } else {
+      output << status.message() << std::endl;
+    }
+
+    if (json_request) {
+      const nlohmann::json response = {
+          {"exitCode", exit_status},
+          {"output", output.str()},
+          {"requestId", request_id},
+      };
+      std::cout << response.dump(-1, ' ', false,
+                                 nlohmann::json::error_handler_t::replace)
+                << std::endl;
+    } else {
+      std::cout << output.str() << "exit: " << exit_status << std::endl;
+    }
+  }
+  return 0;
+}
+
 int main(int argc, char** argv) {
   const auto usage =
       absl::StrCat("usage: ", argv[0], " [options] <file> [<file>...]");
   const auto args = verible::InitCommandLine(usage, &argc, &argv);
 
+  if (absl::GetFlag(FLAGS_print_memory_stats)) {
+    verible::EnableSubsystemMemoryStats();
+    // Exit handlers run in reverse order: the analyzers still queued for
+    // destruction are gone before the statistics are printed.
+    std::atexit([]() { verible::DeferredDeleter::Global().Flush(); });
+  }
+  if (const std::string trace_output = absl::GetFlag(FLAGS_trace_output);
+      !trace_output.empty()) {
+    verible::EnableTraceOutput(trace_output);
+  }
+  if (const ProfileRulesFormat profile_rules =
+          absl::GetFlag(FLAGS_profile_rules);
+      profile_rules != ProfileRulesFormat::kNone) {
+    verible::EnableLintRuleProfileOutput(profile_rules ==
+                                         ProfileRulesFormat::kJson);
+  }
+
   std::string help_flag = absl::GetFlag(FLAGS_help_rules);
   if (!help_flag.empty()) {
     verilog::GetLintRuleDescriptionsHelpFlag(&std::cout, help_flag);
@@ -130,6 +649,14 @@ int main(int argc, char** argv) {
     return 0;
   }
 
+  if (absl::GetFlag(FLAGS_server) || absl::GetFlag(FLAGS_persistent_worker)) {
+    if (args.size() > 1) {
+      std::cerr << "Files on the command line are ignored with --server."
+                << std::endl;
+    }
+    return RunLintServer();
+  }
+
   int exit_status = 0;
 
   AutofixMode autofix_mode = absl::GetFlag(FLAGS_autofix);
@@ -169,10 +696,28 @@ int main(int argc, char** argv) {
     return {verible::ViolationFixer::AnswerChoice::kApplyAll, 0};
   };
 
+  bool json_lines = absl::GetFlag(FLAGS_diagnostics_format) ==
+                    DiagnosticsFormat::kJsonLines;
+  if (json_lines && autofix_mode != AutofixMode::kNo) {
+    std::cerr << "--diagnostics_format has no effect for --autofix="
+              << autofix_mode << std::endl;
+    json_lines = false;
+  }
+  // With JSON Lines on stdout, syntax errors are moved out of the way.
+  std::ostream* const syntax_error_stream =
+      json_lines ? &std::cerr : &std::cout;
+
   std::unique_ptr<verible::ViolationHandler> violation_handler;
+  // Set if all fixes are applied without asking.
+  verible::ViolationFixer* batch_fixer = nullptr;
   switch (autofix_mode) {
     case AutofixMode::kNo:
-      violation_handler.reset(new verible::ViolationPrinter(&std::cerr));
+      if (json_lines) {
+        violation_handler.reset(
+            new verible::ViolationJsonLinesPrinter(&std::cout));
+      } else {
+        violation_handler.reset(new verible::ViolationPrinter(&std::cerr));
+      }
       break;
     case AutofixMode::kPatchInteractive:
       CHECK(autofix_output_stream);
@@ -181,15 +726,17 @@ int main(int argc, char** argv) {
       break;
     case AutofixMode::kPatch:
       CHECK(autofix_output_stream);
-      violation_handler.reset(new verible::ViolationFixer(
-          &std::cerr, autofix_output_stream, applyAllFixes));
+      batch_fixer = new verible::ViolationFixer(
+          &std::cerr, autofix_output_stream, applyAllFixes);
+      violation_handler.reset(batch_fixer);
       break;
     case AutofixMode::kInplaceInteractive:
       violation_handler.reset(new verible::ViolationFixer(&std::cerr, nullptr));
       break;
     case AutofixMode::kInplace:
-      violation_handler.reset(
-          new verible::ViolationFixer(&std::cerr, nullptr, applyAllFixes));
+      batch_fixer =
+          new verible::ViolationFixer(&std::cerr, nullptr, applyAllFixes);
+      violation_handler.reset(batch_fixer);
       break;
     case AutofixMode::kGenerateWaiver:
       violation_handler.reset(new verible::ViolationWaiverPrinter(
@@ -197,25 +744,122 @@ int main(int argc, char** argv) {
       break;
   }
 
+  const int autofix_max_passes = absl::GetFlag(FLAGS_autofix_max_passes);
+  if (autofix_max_passes > 1 && batch_fixer == nullptr) {
+    std::cerr << "--autofix_max_passes has no effect for --autofix="
+              << autofix_mode << std::endl;
+  }
+
   // All positional arguments are file names.  Exclude program name.
-  for (const absl::string_view filename :
-       verible::make_range(args.begin() + 1, args.end())) {
+  const absl::StatusOr<std::vector<absl::string_view>> shard_files =
+      verible::FilesOfShardFromFlags(
+          std::vector<absl::string_view>(args.begin() + 1, args.end()));
+  if (!shard_files.ok()) {
+    std::cerr << shard_files.status().message() << std::endl;
+    return 1;
+  }
+  const std::vector<absl::string_view>& filenames = *shard_files;
+  // Time each file took to lint, for --shard_costs_output.
+  std::string shard_costs;
+
+  const absl::StatusOr<LinesToLint> lines_to_lint =
+      LinesToLintFromFlags(filenames.size());
+  if (!lines_to_lint.ok()) {
+    std::cerr << lines_to_lint.status().message() << std::endl;
+    return 1;
+  }
+
+  int jobs = verible::JobsOrAllCores(absl::GetFlag(FLAGS_jobs));
+
+  // Files sharing options and rules configuration file share their linter
+  // configuration.
+  verilog::LinterConfigurationCache configurations;
+
+  if (absl::GetFlag(FLAGS_lint_variants)) {
+    // Files are linted one after the other, their variants in parallel.
+    for (const absl::string_view filename : filenames) {
+      const absl::Time start = absl::Now();
+      auto config_status = configurations.FromFlags(filename);
+      if (!config_status.ok()) {
+        std::cerr << config_status.status().message() << std::endl;
+        exit_status = 1;
+        continue;
+      }
+      if (!lines_to_lint->Restrict(filename, &*config_status)) continue;
+      const int lint_status = verilog::LintOneFileVariants(
+          syntax_error_stream, filename, *config_status,
+          violation_handler.get(), absl::GetFlag(FLAGS_check_syntax),
+          absl::GetFlag(FLAGS_parse_fatal), absl::GetFlag(FLAGS_lint_fatal),
+          absl::GetFlag(FLAGS_show_diagnostic_context),
+          absl::GetFlag(FLAGS_max_variants), jobs);
+      exit_status = std::max(lint_status, exit_status);
+      absl::StrAppend(&shard_costs,
+                      verible::FileCostLine(filename, absl::Now() - start));
+    }
+    return WriteShardCosts(
+        shard_costs, std::max(exit_status, LintProjectFiles(
+                                               filenames, &configurations,
+                                               violation_handler.get(), jobs)));
+  }
+
+  jobs = std::min<int>(jobs, filenames.size());
+  if (jobs > 1 && autofix_mode != AutofixMode::kNo) {
+    // Autofix handlers keep state across files and may interact with the
+    // user, so they can only be run serially.
+    std::cerr << "--jobs has no effect for --autofix=" << autofix_mode
+              << std::endl;
+    jobs = 1;
+  }
+  if (jobs > 1) {
+    exit_status = std::max(exit_status,
+                           LintFilesInParallel(filenames, jobs, *lines_to_lint,
+                                               &configurations, &shard_costs));
+    return WriteShardCosts(
+        shard_costs, std::max(exit_status, LintProjectFiles(
+                                               filenames, &configurations,
+                                               violation_handler.get(), jobs)));
+  }
+
+  for (const absl::string_view filename : filenames) {
+    const absl::Time start = absl::Now();
     // Copy configuration, so that it can be locally modified per file.
-    auto config_status = verilog::LinterConfigurationFromFlags(filename);
+    auto config_status = configurations.FromFlags(filename);
     if (!config_status.ok()) {
       std::cerr << config_status.status().message() << std::endl;
       exit_status = 1;
       continue;
     }
-    const LinterConfiguration& config = *config_status;
+    LinterConfiguration& config = *config_status;
+    if (!lines_to_lint->Restrict(filename, &config)) continue;
 
+    if (batch_fixer != nullptr && autofix_max_passes > 1) {
+      const int lint_status = verilog::LintAndFixOneFile(
+          &std::cout, filename, config, batch_fixer, autofix_max_passes,
+          absl::GetFlag(FLAGS_check_syntax), absl::GetFlag(FLAGS_parse_fatal),
+          absl::GetFlag(FLAGS_lint_fatal),
+          absl::GetFlag(FLAGS_show_diagnostic_context));
+      exit_status = std::max(lint_status, exit_status);
+      absl::StrAppend(&shard_costs,
+                      verible::FileCostLine(filename, absl::Now() - start));
+      continue;
+    }
+
+    const bool print_stats = absl::GetFlag(FLAGS_print_stats);
+    verilog::VerilogAnalyzerStats stats;
     const int lint_status = verilog::LintOneFile(
-        &std::cout, filename, config, violation_handler.get(),
+        syntax_error_stream, filename, config, violation_handler.get(),
         absl::GetFlag(FLAGS_check_syntax), absl::GetFlag(FLAGS_parse_fatal),
         absl::GetFlag(FLAGS_lint_fatal),
-        absl::GetFlag(FLAGS_show_diagnostic_context));
+        absl::GetFlag(FLAGS_show_diagnostic_context),
+        print_stats ? &stats : nullptr);
+    if (print_stats) PrintAnalyzerStats(std::cerr, filename, stats);
     exit_status = std::max(lint_status, exit_status);
+    absl::StrAppend(&shard_costs,
+                    verible::FileCostLine(filename, absl::Now() - start));
   }  // for each file
 
-  return exit_status;
+  return WriteShardCosts(
+      shard_costs,
+      std::max(exit_status, LintProjectFiles(filenames, &configurations,
+                                             violation_handler.get(), jobs)));
 }
@@ -17,10 +17,14 @@
 
 #include <algorithm>
 #include <cstdint>
+#include <memory>
+#include <optional>
+#include <vector>
 
 #include "absl/container/flat_hash_map.h"
 #include "absl/container/flat_hash_set.h"
 #include "absl/container/node_hash_map.h"
+#include "common/text/syntax_tree_index.h"
 #include "common/text/text_structure.h"
 #include "re2/re2.h"
 #include "verilog/CST/declaration.h"
@@ -167,6 +171,7 @@ class AutoExpander {
         : symbol_(module), name_(GetModuleName(symbol_)->get().text()) {
       RetrieveModuleHeaderPorts();
       RetrieveModuleBodyPorts();
+      RetrieveAutoTemplates();
     }
 
     // Writes all port names that match the predicate to the output stream,
@@ -217,9 +222,6 @@ class AutoExpander {
     // Sort ports by location in the source
     void SortPortsByLocation();
 
-    // Gets all AUTO_TEMPLATEs from the module
-    void RetrieveAutoTemplates();
-
     // Gets all dependencies of the module (modules instantiated within it)
     void RetrieveDependencies(
         const absl::node_hash_map<absl::string_view, Module> &modules);
@@ -261,6 +263,9 @@ class AutoExpander {
     //  Gets ports from the header of the module
     void RetrieveModuleHeaderPorts();
 
+    // Gets all AUTO_TEMPLATEs from the module
+    void RetrieveAutoTemplates();
+
     // Gets ports from the body of the module
     void RetrieveModuleBodyPorts();
 
@@ -296,17 +301,23 @@ class AutoExpander {
     Template::Map templates_;
   };
 
+  // Modules as found in the source, before any expansion, by their symbol.
+  // What expanders modify are copies of them.
+  using ModuleIndex = absl::node_hash_map<const verible::Symbol *, Module>;
+
   AutoExpander(const TextStructureView &text_structure,
-               SymbolTableHandler *symbol_table_handler)
+               SymbolTableHandler *symbol_table_handler,
+               ModuleIndex *module_index)
       : text_structure_(text_structure),
-        symbol_table_handler_(symbol_table_handler) {
+        symbol_table_handler_(symbol_table_handler),
+        module_index_(module_index) {
     expand_span_ = text_structure_.Contents();
   }
 
   AutoExpander(const TextStructureView &text_structure,
                SymbolTableHandler *symbol_table_handler,
-               Interval<size_t> line_range)
-      : AutoExpander(text_structure, symbol_table_handler) {
+               ModuleIndex *module_index, Interval<size_t> line_range)
+      : AutoExpander(text_structure, symbol_table_handler, module_index) {
     size_t min = line_range.min < text_structure.Lines().size()
                      ? line_range.min
                      : text_structure.Lines().size() - 1;
@@ -321,8 +332,9 @@ class AutoExpander {
 
   AutoExpander(const TextStructureView &text_structure,
                SymbolTableHandler *symbol_table_handler,
+               ModuleIndex *module_index,
                const absl::flat_hash_set<AutoKind> &allowed_autos)
-      : AutoExpander(text_structure, symbol_table_handler) {
+      : AutoExpander(text_structure, symbol_table_handler, module_index) {
     allowed_autos_ = allowed_autos;
   }
 
@@ -368,6 +380,9 @@ class AutoExpander {
   absl::flat_hash_set<AutoKind> FindAutoKinds();
 
  private:
+  // Returns a copy of the module declared by "symbol", as found in the source.
+  Module ModuleFromSource(const Symbol &symbol);
+
   // Matches the given regex and erases ports from the module that are in the
   // match span
   std::optional<Match> FindMatchAndErasePorts(AutoExpander::Module *module,
@@ -396,6 +411,9 @@ class AutoExpander {
   // Symbol table wrapper for the language server
   SymbolTableHandler *symbol_table_handler_;
 
+  // Modules that were looked at already, maybe by other expanders
+  ModuleIndex *module_index_;
+
   // Gathered module information (module name -> module info)
   absl::node_hash_map<absl::string_view, Module> modules_;
 
@@ -1073,7 +1091,7 @@ std::optional<AutoExpander::Expansion> AutoExpander::ExpandAutoinst(
     return std::nullopt;
   }
   if (!modules_.contains(type_id)) {
-    modules_.insert(std::make_pair(type_id, Module(*type_def)));
+    modules_.insert(std::make_pair(type_id, ModuleFromSource(*type_def)));
   }
   const Module &inst_module = modules_.at(type_id);
 
@@ -1294,11 +1312,14 @@ std::vector<AutoExpander::Expansion> AutoExpander::Expand() {
         << "Cannot perform AUTO expansion: failed to retrieve a syntax tree";
     return {};
   }
+  // Modules are searched many times.
+  const verible::SyntaxTreeIndex index(*text_structure_.SyntaxTree());
+  const verible::SyntaxTreeIndex::Scope index_scope(&index);
   std::vector<Module *> buffer_modules;  // Ordered list of all modules
                                          // in the buffer being modified
   for (const auto &mod_decl :
        FindAllModuleDeclarations(*text_structure_.SyntaxTree())) {
-    Module module(*mod_decl.match);
+    Module module = ModuleFromSource(*mod_decl.match);
     buffer_modules.push_back(
         &modules_.insert(std::make_pair(module.Name(), std::move(module)))
              .first->second);
@@ -1323,7 +1344,6 @@ std::vector<AutoExpander::Expansion> AutoExpander::Expand() {
     const auto autooutput_match =
         FindMatchAndErasePorts(module, AutoKind::kAutooutput, *autooutput_re_);
     // Do AUTOINST expansion
-    module->RetrieveAutoTemplates();
     for (const auto &data : FindAllDataDeclarations(module->Symbol())) {
       const Symbol *const type_id_node =
           GetTypeIdentifierFromDataDeclaration(*data.match);
@@ -1381,6 +1401,14 @@ std::vector<AutoExpander::Expansion> AutoExpander::Expand() {
   return expansions;
 }
 
+AutoExpander::Module AutoExpander::ModuleFromSource(const Symbol &symbol) {
+  auto found = module_index_->find(&symbol);
+  if (found == module_index_->end()) {
+    found = module_index_->emplace(&symbol, Module(symbol)).first;
+  }
+  return found->second;
+}
+
 absl::flat_hash_set<AutoKind> AutoExpander::FindAutoKinds() {
   absl::flat_hash_set<AutoKind> kinds;
   absl::string_view search_span = expand_span_;
@@ -1516,7 +1544,7 @@ std::vector<TextEdit> ConvertAutoExpansionsToFormattedTextEdits(
   }
 
   const LineColumn linecol =
-      text_structure.GetRangeForText(text_structure.Contents()).end;
+      text_structure.GetUtf16RangeForText(text_structure.Contents()).end;
   return {{.range =
                {
                    .start = {.line = 0, .character = 0},
@@ -1527,34 +1555,83 @@ std::vector<TextEdit> ConvertAutoExpansionsToFormattedTextEdits(
 
 }  // namespace
 
+struct AutoExpandCache::Entries {
+  // The version of the buffer and of the symbol table this is valid for.
+  std::weak_ptr<const ParsedBuffer> buffer;
+  int64_t symbol_table_generation = -1;
+
+  AutoExpander::ModuleIndex modules;
+
+  // Expansion of all AUTOs in the buffer, once done.
+  struct FullExpansion {
+    size_t expansions;
+    std::vector<TextEdit> edits;
+  };
+  std::optional<FullExpansion> full;
+
+  size_t hits = 0;
+};
+
+AutoExpandCache::AutoExpandCache() : entries_(std::make_unique<Entries>()) {}
+
+AutoExpandCache::~AutoExpandCache() = default;
+
+size_t AutoExpandCache::hits() const { return entries_->hits; }
+
 std::vector<CodeAction> GenerateAutoExpandCodeActions(
     SymbolTableHandler *symbol_table_handler,
-    const BufferTracker *const tracker, const CodeActionParams &p) {
+    const BufferTracker *const tracker, const CodeActionParams &p,
+    AutoExpandCache *cache) {
   Interval<size_t> line_range{static_cast<size_t>(p.range.start.line),
                               static_cast<size_t>(p.range.end.line)};
   if (!tracker) return {};
   const auto current = tracker->current();
   if (!current) return {};  // Can only expand if we have latest version
+  // Without a cache, modules are still shared by the expanders below.
+  AutoExpandCache request_cache;
+  AutoExpandCache::Entries &cached =
+      cache ? *cache->entries_ : *request_cache.entries_;
   const TextStructureView &text_structure = current->parser().Data();
-  AutoExpander range_expander(text_structure, symbol_table_handler, line_range);
+  AutoExpander range_expander(text_structure, symbol_table_handler,
+                              &cached.modules, line_range);
   const auto &auto_kinds = range_expander.FindAutoKinds();
   if (auto_kinds.empty()) return {};
 
-  AutoExpander full_expander(text_structure, symbol_table_handler);
-  const auto &expansions_full = full_expander.Expand();
-  if (expansions_full.empty()) return {};
+  // Definitions found in the symbol table stay valid while it is held.
+  const auto symbols = symbol_table_handler->TakeSnapshot();
+  // Symbols of a different buffer or symbol table might be gone.
+  const int64_t generation = symbols->generation();
+  if (cached.buffer.lock() != current ||
+      cached.symbol_table_generation != generation) {
+    cached.modules.clear();
+    cached.full.reset();
+    cached.buffer = current;
+    cached.symbol_table_generation = generation;
+  }
+
+  if (cached.full) {
+    ++cached.hits;
+  } else {
+    AutoExpander full_expander(text_structure, symbol_table_handler,
+                               &cached.modules);
+    const auto &expansions_full = full_expander.Expand();
+    cached.full = {expansions_full.size(),
+                   expansions_full.empty()
+                       ? std::vector<TextEdit>{}
+                       : ConvertAutoExpansionsToFormattedTextEdits(
+                             text_structure, expansions_full)};
+  }
+  if (cached.full->expansions == 0) return {};
   std::vector<CodeAction> result;
   result.emplace_back(CodeAction{
       .title = "Expand all AUTOs in file",
       .kind = "refactor.rewrite",
-      .edit = {.changes = {{p.textDocument.uri,
-                            ConvertAutoExpansionsToFormattedTextEdits(
-                                text_structure, expansions_full)}}},
+      .edit = {.changes = {{p.textDocument.uri, cached.full->edits}}},
   });
 
   const auto &expansions_range = range_expander.Expand();
   if (expansions_range.empty() ||
-      expansions_range.size() == expansions_full.size()) {
+      expansions_range.size() == cached.full->expansions) {
     return result;
   }
   result.push_back({
@@ -1567,7 +1644,8 @@ std::vector<CodeAction> GenerateAutoExpandCodeActions(
                                 text_structure, expansions_range)}}},
   });
 
-  AutoExpander kind_expander(text_structure, symbol_table_handler, auto_kinds);
+  AutoExpander kind_expander(text_structure, symbol_table_handler,
+                             &cached.modules, auto_kinds);
   const auto &expansions_kind = kind_expander.Expand();
   if (expansions_kind.empty() ||
       expansions_kind.size() == expansions_range.size()) {
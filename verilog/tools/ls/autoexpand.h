@@ -16,6 +16,8 @@
 #ifndef VERILOG_TOOLS_LS_AUTOEXPAND_H
 #define VERILOG_TOOLS_LS_AUTOEXPAND_H
 
+#include <cstddef>
+#include <memory>
 #include <vector>
 
 #include "common/lsp/lsp-protocol.h"
@@ -26,10 +28,41 @@
 // Functions for Emacs' Verilog-Mode-style AUTO expansion.
 
 namespace verilog {
-// Generate AUTO expansion code actions for the given code action params
+class AutoExpandCache;
+
+// Generate AUTO expansion code actions for the given code action params.
+// If a cache is given, what is in it is reused, and what is found is added.
 std::vector<verible::lsp::CodeAction> GenerateAutoExpandCodeActions(
     SymbolTableHandler *symbol_table_handler, const BufferTracker *tracker,
-    const verible::lsp::CodeActionParams &p);
+    const verible::lsp::CodeActionParams &p, AutoExpandCache *cache = nullptr);
+
+// Cache for AUTO expansion, which editors ask for whenever the cursor moves.
+// It keeps the ports and AUTO_TEMPLATEs of the modules looked at, from the
+// buffer and from the project, and the expansion of all AUTOs in the buffer.
+// They are only valid for one version of one buffer, and as long as the
+// symbol table did not change; otherwise the cache starts over.
+// A cache must not be used by concurrent GenerateAutoExpandCodeActions()
+// calls.
+class AutoExpandCache {
+ public:
+  AutoExpandCache();
+
+  AutoExpandCache(const AutoExpandCache &) = delete;
+  AutoExpandCache &operator=(const AutoExpandCache &) = delete;
+
+  ~AutoExpandCache();
+
+  // Returns the number of times the expansion of all AUTOs was reused.
+  size_t hits() const;
+
+ private:
+  friend std::vector<verible::lsp::CodeAction> GenerateAutoExpandCodeActions(
+      SymbolTableHandler *symbol_table_handler, const BufferTracker *tracker,
+      const verible::lsp::CodeActionParams &p, AutoExpandCache *cache);
+
+  struct Entries;
+  std::unique_ptr<Entries> entries_;
+};
 
 }  // namespace verilog
 #endif  // VERILOG_TOOLS_LS_AUTOEXPAND_H
@@ -135,8 +135,8 @@ void TestTextEditsWithProject(
   // expansions. This handler also needs a Verilog project to work properly.
   SymbolTableHandler symbol_table_handler;
   symbol_table_handler.SetProject(proj);
-  symbol_table_handler.UpdateFileContent(TESTED_FILENAME,
-                                         &tracker.current()->parser().Data());
+  symbol_table_handler.UpdateFileContent(
+      TESTED_FILENAME, SharedTextStructure(tracker.current()));
   symbol_table_handler.BuildProjectSymbolTable();
   // Run the tested edit function
   std::vector<TextEdit> edits = run.edit_fn(&symbol_table_handler, &tracker);
@@ -3617,5 +3617,56 @@ endmodule
   );
 }
 
+TEST(Autoexpand, CacheReusesFullExpansion) {
+  static const char* kFilename = "<<cached-file>>";
+  const std::shared_ptr<VerilogProject> proj =
+      std::make_shared<VerilogProject>(".", std::vector<std::string>());
+  SymbolTableHandler symbol_table_handler;
+  symbol_table_handler.SetProject(proj);
+  BufferTracker tracker;
+  const auto update = [&](absl::string_view text, int64_t version) {
+    EditTextBuffer buffer(text);
+    buffer.set_last_global_version(version);
+    tracker.Update(kFilename, buffer);
+    symbol_table_handler.UpdateFileContent(
+        kFilename, SharedTextStructure(tracker.current()));
+  };
+  const auto new_text = [](const std::vector<CodeAction>& actions) {
+    EXPECT_FALSE(actions.empty());
+    if (actions.empty()) return std::string();
+    nlohmann::json changes = actions[0].edit.changes;
+    return std::string(changes[kFilename][0]["newText"]);
+  };
+  const CodeActionParams p = {.textDocument = {kFilename},
+                              .range = {.start = {.line = 0},
+                                        .end = {.line = 0}}};
+
+  update(
+      "module foo (  /*AUTOARG*/);\n"
+      "  input clk;\n"
+      "endmodule\n",
+      1);
+  AutoExpandCache cache;
+  const auto expand = [&]() {
+    return new_text(GenerateAutoExpandCodeActions(&symbol_table_handler,
+                                                  &tracker, p, &cache));
+  };
+  const std::string first = expand();
+  EXPECT_EQ(cache.hits(), 0);
+  EXPECT_EQ(expand(), first);
+  EXPECT_EQ(cache.hits(), 1);
+
+  // A new version of the buffer is expanded again.
+  update(
+      "module foo (  /*AUTOARG*/);\n"
+      "  input rst;\n"
+      "endmodule\n",
+      2);
+  const std::string edited = expand();
+  EXPECT_EQ(cache.hits(), 1);
+  EXPECT_NE(edited.find("rst"), std::string::npos);
+  EXPECT_EQ(edited.find("clk"), std::string::npos);
+}
+
 }  // namespace
 }  // namespace verilog
@@ -23,9 +23,6 @@
 #include "verilog/CST/package.h"
 #include "verilog/CST/seq_block.h"
 
-// Magic value to hint that we have to fill out the start range.
-static constexpr int kUninitializedStartLine = -1;
-
 // verible::lsp::SymbolKind::Module is just shown as {} namespace symbol
 // in vscode. 'Method' looks slightly nicer as little block. So emit a
 // symbol in the document tree that has the nicer look.
@@ -51,14 +48,12 @@ DocumentSymbolFiller::DocumentSymbolFiller(
 }
 
 void DocumentSymbolFiller::Visit(const verible::SyntaxTreeLeaf &leaf) {
-  verible::lsp::Range range = RangeFromLeaf(leaf);
-  if (current_symbol_->range.start.line == kUninitializedStartLine) {
-    // We're the first concrete token with a position within our parent,
-    // set the start position.
-    current_symbol_->range.start = range.start;
+  if (!current_span_.first) {
+    // We're the first concrete token with a position within our parent.
+    current_span_.first = &leaf.get();
   }
-  // Update the end position with every token we see. The last one wins.
-  current_symbol_->range.end = range.end;
+  // Update the end with every token we see. The last one wins.
+  current_span_.last = &leaf.get();
 }
 
 void DocumentSymbolFiller::Visit(const verible::SyntaxTreeNode &node) {
@@ -66,7 +61,6 @@ void DocumentSymbolFiller::Visit(const verible::SyntaxTreeNode &node) {
 
   // These things can probably be done easier with Matchers.
   verible::lsp::DocumentSymbol node_symbol;
-  node_symbol.range.start.line = kUninitializedStartLine;
   bool is_visible_node = false;
   switch (static_cast<verilog::NodeEnum>(node.Tag().tag)) {
     case verilog::NodeEnum::kModuleDeclaration: {
@@ -135,16 +129,23 @@ void DocumentSymbolFiller::Visit(const verible::SyntaxTreeNode &node) {
 
   // Independent of visible or not, we always descend to our children.
   if (is_visible_node) {
-    const verible::ValueSaver<verible::lsp::DocumentSymbol *> value_saver(
-        &current_symbol_, &node_symbol);
-    for (const auto &child : node.children()) {
-      if (child) child->Accept(this);
+    TokenSpan span;
+    {
+      const verible::ValueSaver<verible::lsp::DocumentSymbol *> symbol_saver(
+          &current_symbol_, &node_symbol);
+      const verible::ValueSaver<TokenSpan> span_saver(&current_span_, {});
+      for (const auto &child : node.children()) {
+        if (child) child->Accept(this);
+      }
+      span = current_span_;
     }
+    // A visible node always has a name token.
+    node_symbol.range.start = RangeFromToken(*span.first).start;
+    node_symbol.range.end = RangeFromToken(*span.last).end;
     // Update our parent with what we found
+    if (!current_span_.first) current_span_.first = span.first;
+    current_span_.last = span.last;
     if (parent->children == nullptr) {
-      if (parent->range.start.line == kUninitializedStartLine) {
-        parent->range.start = node_symbol.range.start;
-      }
       parent->children = nlohmann::json::array();
       parent->has_children = true;
     }
@@ -164,7 +165,8 @@ verible::lsp::Range DocumentSymbolFiller::RangeFromLeaf(
 
 verible::lsp::Range DocumentSymbolFiller::RangeFromToken(
     const verible::TokenInfo &token) const {
-  const verible::LineColumnRange range = text_view_.GetRangeForToken(token);
+  const verible::LineColumnRange range =
+      text_view_.GetUtf16RangeForToken(token);
   return {.start = {.line = range.start.line, .character = range.start.column},
           .end = {.line = range.end.line, .character = range.end.column}};
 }
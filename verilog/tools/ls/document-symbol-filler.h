@@ -35,6 +35,13 @@ class DocumentSymbolFiller : public verible::SymbolVisitor {
   void Visit(const verible::SyntaxTreeNode &node) final;
 
  private:
+  // First and last token in the syntax tree of a symbol, which determine its
+  // range.  Ranges are only computed once per symbol, not for every token.
+  struct TokenSpan {
+    const verible::TokenInfo *first = nullptr;
+    const verible::TokenInfo *last = nullptr;
+  };
+
   verible::lsp::Range RangeFromLeaf(const verible::SyntaxTreeLeaf &leaf) const;
   verible::lsp::Range RangeFromToken(const verible::TokenInfo &token) const;
 
@@ -43,6 +50,7 @@ class DocumentSymbolFiller : public verible::SymbolVisitor {
 
   const verible::TextStructureView &text_view_;
   verible::lsp::DocumentSymbol *current_symbol_;
+  TokenSpan current_span_;
 };
 }  // namespace verilog
 #endif  // VERILOG_TOOLS_LS_DOCUMENT_SYMBOL_FILLER_H
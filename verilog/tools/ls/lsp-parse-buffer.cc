@@ -15,13 +15,27 @@
 
 #include "verilog/tools/ls/lsp-parse-buffer.h"
 
+#include <algorithm>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <utility>
+
 #include "absl/status/status.h"
+#include "absl/time/clock.h"
+#include "absl/time/time.h"
 #include "common/lsp/lsp-file-utils.h"
+#include "common/util/deferred_deleter.h"
+#include "common/util/latency_stats.h"
 #include "common/util/logging.h"
+#include "verilog/analysis/verilog_incremental_parse.h"
+#include "verilog/parser/verilog_token_enum.h"
 
 namespace verilog {
 static absl::StatusOr<std::vector<verible::LintRuleStatus>> RunLinter(
-    absl::string_view filename, const verilog::VerilogAnalyzer &parser) {
+    absl::string_view filename, const verilog::VerilogAnalyzer &parser,
+    verible::ThreadPool *pool) {
   const auto &text_structure = parser.Data();
 
   verilog::LinterConfiguration config;
@@ -33,64 +47,326 @@ static absl::StatusOr<std::vector<verible::LintRuleStatus>> RunLinter(
     LOG(ERROR) << from_flags.status().message() << std::endl;
   }
 
-  return VerilogLintTextStructure(filename, config, text_structure);
+  return VerilogLintTextStructure(filename, config, text_structure, pool);
+}
+
+// Threads that lint rules run on, for all buffers.  Lints may overlap, e.g.
+// that of the edited buffer and the diagnostics of the workspace; they share
+// these threads rather than each taking all cores.  The linting thread helps
+// too, and VerilogLinter runs at most a handful of tasks per file.
+static verible::ThreadPool *LintPool() {
+  static auto *const pool = new verible::ThreadPool(
+      std::min(std::max(1u, std::thread::hardware_concurrency()), 8u) - 1);
+  return pool;
+}
+
+// Every edit replaces a version of the buffer: its syntax tree, tokens and
+// lint results are destroyed in the background, not in the way of the next
+// update.
+static std::shared_ptr<const ParsedBuffer> NewParsedBuffer(
+    int64_t version, absl::string_view uri, absl::string_view content,
+    const ParsedBuffer *previous) {
+  return {new ParsedBuffer(version, uri, content, previous),
+          verible::DeferredDelete<const ParsedBuffer>()};
+}
+
+static std::unique_ptr<verilog::VerilogAnalyzer> Analyze(
+    absl::string_view uri, absl::string_view content,
+    const ParsedBuffer *previous) {
+  if (previous) {
+    auto incremental = verilog::AnalyzeVerilogIncrementally(
+        previous->parser(), content, uri);
+    if (incremental) return incremental;
+  }
+  return verilog::VerilogAnalyzer::AnalyzeAutomaticPreprocessFallback(content,
+                                                                      uri);
 }
 
 ParsedBuffer::ParsedBuffer(int64_t version, absl::string_view uri,
-                           absl::string_view content)
+                           absl::string_view content,
+                           const ParsedBuffer *previous)
     : version_(version),
       uri_(uri),
-      parser_(verilog::VerilogAnalyzer::AnalyzeAutomaticPreprocessFallback(
-          content, uri)) {
+      parser_(verible::PhaseLatencies().Time(
+          "parse", [&]() { return Analyze(uri, content, previous); })) {
   VLOG(1) << "Analyzed " << uri << " lex:" << parser_->LexStatus()
           << "; parser:" << parser_->ParseStatus() << std::endl;
-  // TODO(hzeller): we should use a filename not URI; strip prefix.
-  if (auto lint_result = RunLinter(uri, *parser_); lint_result.ok()) {
-    lint_statuses_ = std::move(lint_result.value());
-  }
+  // Buffers are kept around unmodified, possibly several versions of the same
+  // file: their syntax trees share the tokens with the token stream.
+  parser_->CompactSyntaxTree();
+}
+
+const std::vector<verible::LintRuleStatus> &ParsedBuffer::lint_result() const {
+  return lint_result(LintPool());
+}
+
+const std::vector<verible::LintRuleStatus> &ParsedBuffer::lint_result(
+    verible::ThreadPool *pool) const {
+  std::call_once(lint_once_, [this, pool]() {
+    // TODO(hzeller): we should use a filename not URI; strip prefix.
+    auto lint_result = verible::PhaseLatencies().Time(
+        "lint", [&]() { return RunLinter(uri_, *parser_, pool); });
+    if (lint_result.ok()) {
+      lint_statuses_ = std::move(lint_result.value());
+    }
+  });
+  return lint_statuses_;
+}
+
+const ParsedBuffer::IdentifierOccurrences &
+ParsedBuffer::identifier_occurrences() const {
+  std::call_once(identifiers_once_, [this]() {
+    const verible::TextStructureView &text = parser_->Data();
+    for (const verible::TokenInfo &token : text.TokenStream()) {
+      if (token.token_enum() != SymbolIdentifier) continue;
+      identifier_occurrences_[token.text()].push_back(
+          text.GetUtf16RangeForToken(token));
+    }
+  });
+  return identifier_occurrences_;
 }
 
 void BufferTracker::Update(const std::string &filename,
                            const verible::lsp::EditTextBuffer &txt) {
-  if (current_ && current_->version() == txt.last_global_version()) {
+  if (current_version() == txt.last_global_version()) {
     return;  // Nothing to do (we don't really expect this to happen)
   }
-  txt.RequestContent([&txt, &filename, this](absl::string_view content) {
-    current_ = std::make_shared<ParsedBuffer>(txt.last_global_version(),
-                                              filename, content);
+  const std::shared_ptr<const ParsedBuffer> last_good = this->last_good();
+  std::shared_ptr<const ParsedBuffer> parsed;
+  txt.RequestContent([&](absl::string_view content) {
+    // Only the last good version is guaranteed to be worth reusing.
+    parsed = NewParsedBuffer(txt.last_global_version(), filename, content,
+                             last_good.get());
   });
-  if (current_->parsed_successfully()) {
-    last_good_ = current_;
+  Publish(std::move(parsed));
+}
+
+void BufferTracker::Publish(std::shared_ptr<const ParsedBuffer> parsed) {
+  const std::lock_guard<std::mutex> l(lock_);
+  if (parsed->parsed_successfully()) {
+    last_good_ = parsed;
+  }
+  current_ = std::move(parsed);
+  released_.reset();
+}
+
+bool BufferTracker::has_current() const {
+  const std::lock_guard<std::mutex> l(lock_);
+  return current_ || released_;
+}
+
+int64_t BufferTracker::current_version() const {
+  const std::lock_guard<std::mutex> l(lock_);
+  if (released_) return released_->version;
+  return current_ ? current_->version() : -1;
+}
+
+std::shared_ptr<const ParsedBuffer> BufferTracker::current() const {
+  const std::lock_guard<std::mutex> l(lock_);
+  if (released_) {
+    VLOG(1) << "Parsing released " << released_->uri << " version "
+            << released_->version << " again.";
+    current_ = NewParsedBuffer(released_->version, released_->uri,
+                               released_->content, last_good_.get());
+    released_.reset();
+  }
+  return current_;
+}
+
+std::shared_ptr<const BufferTracker> BufferTracker::Snapshot() const {
+  auto snapshot = std::make_shared<BufferTracker>();
+  const std::lock_guard<std::mutex> l(lock_);
+  snapshot->current_ = current_;
+  snapshot->last_good_ = last_good_;
+  snapshot->released_ = released_;  // Parsed again if the snapshot needs it.
+  return snapshot;
+}
+
+bool BufferTracker::ReleaseCurrent() {
+  const std::lock_guard<std::mutex> l(lock_);
+  if (!current_ || current_ == last_good_) return false;
+  released_ = std::make_shared<const Released>(
+      Released{current_->version(), current_->uri(),
+               std::string(current_->parser().Data().Contents())});
+  current_.reset();
+  return true;
+}
+
+void BufferTracker::AddMemoryStats(BufferMemoryStats *stats) const {
+  const std::lock_guard<std::mutex> l(lock_);
+  ++stats->buffers;
+  const auto add_parsed = [stats](const ParsedBuffer &parsed) {
+    const verible::TextStructureView &data = parsed.parser().Data();
+    ++stats->parsed_buffers;
+    stats->parsed_bytes += data.Contents().size();
+    stats->parsed_tokens += data.TokenStream().size();
+  };
+  if (current_) add_parsed(*current_);
+  if (last_good_ && last_good_ != current_) add_parsed(*last_good_);
+  if (released_) {
+    ++stats->released_buffers;
+    stats->released_bytes += released_->content.size();
   }
 }
 
+BufferTrackerContainer::~BufferTrackerContainer() {
+  if (!parse_thread_) return;
+  {
+    const std::lock_guard<std::mutex> l(pending_lock_);
+    exiting_ = true;
+  }
+  pending_changed_.notify_all();
+  parse_thread_->join();
+}
+
+void BufferTrackerContainer::ParseInBackground(absl::Duration debounce,
+                                               const Serializer &serialize) {
+  CHECK(!parse_thread_) << "Background parsing already enabled.";
+  debounce_ = debounce;
+  serialize_ = ABSL_DIE_IF_NULL(serialize);
+  parse_thread_ = std::make_unique<std::thread>([this]() { ParseLoop(); });
+}
+
 verible::lsp::BufferCollection::UriBufferCallback
 BufferTrackerContainer::GetSubscriptionCallback() {
   return
       [this](const std::string &uri, const verible::lsp::EditTextBuffer *txt) {
-        if (txt) {
-          const BufferTracker *tracker = Update(uri, *txt);
-          // Now inform our listeners.
-          for (const auto &change_listener : change_listeners_) {
-            change_listener(uri, tracker);
-          }
-        } else {
+        if (!txt) {
           Remove(uri);
-          for (const auto &change_listener : change_listeners_) {
-            change_listener(uri, nullptr);
-          }
+          NotifyListeners(uri, nullptr);
+          return;
+        }
+        const std::shared_ptr<BufferTracker> tracker =
+            FindOrCreateBufferTracker(uri);
+        // Parse newly opened buffers right away, so that there is something
+        // to work with for requests that follow.
+        if (parse_thread_ && tracker->has_current()) {
+          ScheduleParse(uri, tracker, *txt);  // Listeners informed when done.
+          return;
         }
+        tracker->Update(uri, *txt);
+        NotifyListeners(uri, tracker.get());
       };
 }
 
-BufferTracker *BufferTrackerContainer::Update(
-    const std::string &uri, const verible::lsp::EditTextBuffer &txt) {
+void BufferTrackerContainer::NotifyListeners(const std::string &uri,
+                                             const BufferTracker *tracker) {
+  for (const auto &change_listener : change_listeners_) {
+    change_listener(uri, tracker);
+  }
+  if (tracker) MarkChanged(uri);
+}
+
+void BufferTrackerContainer::LimitRecentlyChangedBuffers(int limit) {
+  recently_changed_limit_ = std::max(limit, 1);
+}
+
+void BufferTrackerContainer::MarkChanged(const std::string &uri) {
+  if (recently_changed_limit_ < 0) return;
+  recently_changed_.remove(uri);
+  recently_changed_.push_front(uri);
+  int position = 0;
+  for (const std::string &changed : recently_changed_) {
+    if (position++ < recently_changed_limit_) continue;
+    const auto found = buffers_.find(changed);
+    if (found != buffers_.end() && found->second->ReleaseCurrent()) {
+      VLOG(1) << "Released parse of " << changed;
+    }
+  }
+}
+
+BufferMemoryStats BufferTrackerContainer::GetMemoryStats() const {
+  BufferMemoryStats stats;
+  for (const auto &buffer : buffers_) buffer.second->AddMemoryStats(&stats);
+  return stats;
+}
+
+std::shared_ptr<BufferTracker>
+BufferTrackerContainer::FindOrCreateBufferTracker(const std::string &uri) {
   auto inserted = buffers_.insert({uri, nullptr});
   if (inserted.second) {
-    inserted.first->second.reset(new BufferTracker());
+    inserted.first->second = std::make_shared<BufferTracker>();
+  }
+  return inserted.first->second;
+}
+
+void BufferTrackerContainer::Remove(const std::string &uri) {
+  buffers_.erase(uri);
+  recently_changed_.remove(uri);
+  if (parse_thread_) {
+    const std::lock_guard<std::mutex> l(pending_lock_);
+    pending_.erase(uri);
+  }
+}
+
+void BufferTrackerContainer::ScheduleParse(
+    const std::string &uri, const std::shared_ptr<BufferTracker> &tracker,
+    const verible::lsp::EditTextBuffer &txt) {
+  PendingParse job{txt.last_global_version(), txt.ContentSnapshot(),
+                   absl::Now() + debounce_, tracker};
+  {
+    const std::lock_guard<std::mutex> l(pending_lock_);
+    // Replaces an older version that did not start parsing yet.
+    pending_[uri] = std::move(job);
+  }
+  pending_changed_.notify_all();
+}
+
+void BufferTrackerContainer::ParseLoop() {
+  std::unique_lock<std::mutex> l(pending_lock_);
+  while (!exiting_) {
+    if (pending_.empty()) {
+      pending_changed_.wait(l);
+      continue;
+    }
+    auto next = std::min_element(
+        pending_.begin(), pending_.end(), [](const auto &a, const auto &b) {
+          return a.second.start_time < b.second.start_time;
+        });
+    const absl::Time now = absl::Now();
+    if (next->second.start_time > now) {
+      pending_changed_.wait_for(
+          l, absl::ToChronoNanoseconds(next->second.start_time - now));
+      continue;
+    }
+    const std::string uri = next->first;
+    const PendingParse job = std::move(next->second);
+    pending_.erase(next);
+    l.unlock();
+
+    auto parsed = NewParsedBuffer(job.version, uri, *job.content,
+                                  job.tracker->last_good().get());
+    // Diagnostics are sent on publishing: lint here rather than while
+    // holding up the dispatch loop, unless the result is stale anyway.
+    bool superseded;
+    {
+      const std::lock_guard<std::mutex> pending(pending_lock_);
+      superseded = pending_.find(uri) != pending_.end();
+    }
+    if (!superseded) parsed->lint_result();
+    serialize_([&]() { PublishParsed(uri, job.tracker, std::move(parsed)); });
+
+    l.lock();
+  }
+}
+
+void BufferTrackerContainer::PublishParsed(
+    const std::string &uri, const std::shared_ptr<BufferTracker> &tracker,
+    std::shared_ptr<const ParsedBuffer> parsed) {
+  auto found = buffers_.find(uri);
+  if (found == buffers_.end() || found->second != tracker) {
+    return;  // Buffer was closed in the meantime.
+  }
+  {
+    const std::lock_guard<std::mutex> l(pending_lock_);
+    if (pending_.find(uri) != pending_.end()) {
+      VLOG(1) << "Dropping stale parse of " << uri << " version "
+              << parsed->version();
+      return;  // A newer version arrived while parsing.
+    }
   }
-  inserted.first->second->Update(uri, txt);
-  return inserted.first->second.get();
+  tracker->Publish(std::move(parsed));
+  NotifyListeners(uri, tracker.get());
 }
 
 const BufferTracker *BufferTrackerContainer::FindBufferTrackerOrNull(
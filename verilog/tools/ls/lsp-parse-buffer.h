@@ -16,9 +16,24 @@
 #ifndef VERILOG_TOOLS_LS_LSP_PARSE_BUFFER_H
 #define VERILOG_TOOLS_LS_LSP_PARSE_BUFFER_H
 
+#include <condition_variable>
 #include <cstdint>
+#include <cstddef>
+#include <functional>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
 
+#include "absl/container/flat_hash_map.h"
+#include "absl/strings/string_view.h"
+#include "absl/time/time.h"
 #include "common/lsp/lsp-text-buffer.h"
+#include "common/strings/line_column_map.h"
+#include "common/util/thread_pool.h"
 #include "verilog/analysis/verilog_analyzer.h"
 #include "verilog/analysis/verilog_linter.h"
 
@@ -31,22 +46,39 @@ namespace verilog {
 // A parsed buffer collects all the artifacts generated from a text buffer
 // from parsing or running the linter.
 //
-// Right now, the ParsedBuffer is synchronously filling its internal structure
-// on construction, but plan is to do that on-demand and possibly with
-// std::future<>s evaluated in separate threads.
+// The ParsedBuffer is synchronously parsing on construction, and is immutable
+// afterwards, so it can be constructed in a separate thread (see
+// BufferTrackerContainer::ParseInBackground()). The linter only runs on the
+// first call of lint_result(), as many versions are never asked for it.
 class ParsedBuffer {
  public:
+  // If "previous" is given, it is the parse of an earlier version of the
+  // same buffer: parts of the content that were not touched by edits since
+  // are not re-parsed, if possible.
   ParsedBuffer(int64_t version, absl::string_view uri,
-               absl::string_view content);
+               absl::string_view content,
+               const ParsedBuffer *previous = nullptr);
 
   bool parsed_successfully() const {
     return parser_->LexStatus().ok() && parser_->ParseStatus().ok();
   }
 
   const verilog::VerilogAnalyzer &parser() const { return *parser_; }
-  const std::vector<verible::LintRuleStatus> &lint_result() const {
-    return lint_statuses_;
-  }
+  // Lint result, computed on first call. Thread-safe.
+  const std::vector<verible::LintRuleStatus> &lint_result() const;
+  // Same, but the first call runs the lint rules on "pool" (serially if
+  // null), instead of on the pool shared by all buffers.
+  const std::vector<verible::LintRuleStatus> &lint_result(
+      verible::ThreadPool *pool) const;
+
+  // Ranges of all occurrences of each identifier (SymbolIdentifier tokens),
+  // keyed by its text, in text order.  Columns count UTF-16 code units, as
+  // in the language server protocol.
+  using IdentifierOccurrences =
+      absl::flat_hash_map<absl::string_view,
+                          std::vector<verible::LineColumnRange>>;
+  // Identifier occurrences, computed on first call. Thread-safe.
+  const IdentifierOccurrences &identifier_occurrences() const;
 
   int64_t version() const { return version_; }
   const std::string &uri() const { return uri_; }
@@ -55,7 +87,29 @@ class ParsedBuffer {
   const int64_t version_;
   const std::string uri_;
   const std::unique_ptr<verilog::VerilogAnalyzer> parser_;
-  std::vector<verible::LintRuleStatus> lint_statuses_;
+  mutable std::once_flag lint_once_;
+  mutable std::vector<verible::LintRuleStatus> lint_statuses_;
+  mutable std::once_flag identifiers_once_;
+  mutable IdentifierOccurrences identifier_occurrences_;
+};
+
+// Returns the text structure of "parsed", which it keeps alive. This is how
+// the parse of a buffer is shared with the VerilogProject, instead of
+// parsing it again there.
+inline std::shared_ptr<const verible::TextStructureView> SharedTextStructure(
+    const std::shared_ptr<const ParsedBuffer> &parsed) {
+  if (!parsed) return nullptr;
+  return {parsed, &parsed->parser().Data()};
+}
+
+// Memory held by BufferTrackers, for statistics.
+struct BufferMemoryStats {
+  int buffers = 0;
+  int parsed_buffers = 0;    // Distinct ParsedBuffers.
+  size_t parsed_bytes = 0;   // Their text.
+  size_t parsed_tokens = 0;  // Their tokens.
+  int released_buffers = 0;  // See BufferTracker::ReleaseCurrent().
+  size_t released_bytes = 0;
 };
 
 // A buffer tracker tracks the EditTextBuffer content and keeps up to
@@ -66,6 +120,10 @@ class BufferTracker {
   void Update(const std::string &filename,
               const verible::lsp::EditTextBuffer &txt);
 
+  // Make "parsed" the current buffer, and the last good one if it parsed
+  // successfully. Both are replaced atomically.
+  void Publish(std::shared_ptr<const ParsedBuffer> parsed);
+
   // ---
   // Thread guarantee for the following functions.
   // As long as the caller (typically some operation) holds on to the returned
@@ -79,7 +137,12 @@ class BufferTracker {
   //
   // Use in operations that only really makes sense on the latest view and
   // only if it was parseable, e.g. suggesting edits.
-  std::shared_ptr<const ParsedBuffer> current() const { return current_; }
+  //
+  // If it was released, it is parsed again.
+  std::shared_ptr<const ParsedBuffer> current() const;
+
+  // Returns true if there is a current() ParsedBuffer, even if released.
+  bool has_current() const;
 
   // Get the ParsedBuffer that represents that last time we were able to
   // parse the document from the editor correctly. This can be the same
@@ -88,9 +151,38 @@ class BufferTracker {
   //
   // Use in operations that focus on returning something even it it is slightly
   // outdated, e.g. finding a particular symbol.
-  std::shared_ptr<const ParsedBuffer> last_good() const { return last_good_; }
+  std::shared_ptr<const ParsedBuffer> last_good() const {
+    const std::lock_guard<std::mutex> l(lock_);
+    return last_good_;
+  }
+
+  // Get a copy of this tracker with the current() and last_good()
+  // ParsedBuffers of this moment, unaffected by later updates. Can be used
+  // by operations running concurrently with updates to this tracker.
+  std::shared_ptr<const BufferTracker> Snapshot() const;
+
+  // Release current() if it is not the last good one, keeping only its
+  // text; it is parsed again when needed. Returns true if it was released.
+  bool ReleaseCurrent();
+
+  // Add the memory held by this tracker to "stats".
+  void AddMemoryStats(BufferMemoryStats *stats) const;
 
  private:
+  // Version of current(), or -1 if there is none.
+  int64_t current_version() const;
+
+  // Text of a released current().
+  struct Released {
+    int64_t version;
+    std::string uri;
+    std::string content;
+  };
+
+  // Guards current_ and last_good_, which might be published from a
+  // background parse thread.
+  mutable std::mutex lock_;
+
   // The same ParsedBuffer can in both, current and last_good, or last_good can
   // be an older version. So the very same object can be in both of them.
   // Use shared_ptr to keep track of the reference count.
@@ -98,8 +190,9 @@ class BufferTracker {
   // Also: We want to be able to replace contents asynchronously which means
   // we need a thread-safe way to hand out a copy that survives while we
   // replace this one.
-  std::shared_ptr<const ParsedBuffer> current_;
+  mutable std::shared_ptr<const ParsedBuffer> current_;
   std::shared_ptr<const ParsedBuffer> last_good_;
+  mutable std::shared_ptr<const Released> released_;  // If current_ released.
 };
 
 // Container holding all buffer trackers keyed by file uri.
@@ -107,6 +200,28 @@ class BufferTracker {
 // internally stores
 class BufferTrackerContainer {
  public:
+  BufferTrackerContainer() = default;
+  BufferTrackerContainer(const BufferTrackerContainer &) = delete;
+  BufferTrackerContainer &operator=(const BufferTrackerContainer &) = delete;
+
+  // Waits for a background parse in progress (if any) to finish.
+  ~BufferTrackerContainer();
+
+  // Functor that runs the given function mutually exclusive with all other
+  // accesses to this container, its BufferTrackers, and whatever the change
+  // listeners access (e.g. by holding the lock of the dispatch loop).
+  using Serializer = std::function<void(const std::function<void()> &)>;
+
+  // Parse buffers in a background thread instead of synchronously on update.
+  // (Only newly opened buffers are still parsed synchronously).
+  // Parsing is debounced: it only starts once a buffer did not change for
+  // "debounce" time, so that rapid edits are only parsed once. Results of a
+  // version that became stale while parsing are dropped.
+  // Results are published, and change listeners called, from within
+  // "serialize". Results that are still current by then are linted in the
+  // background as well.
+  void ParseInBackground(absl::Duration debounce, const Serializer &serialize);
+
   // Return a callback that allows to subscribe to an lsp::BufferCollection
   // to update our internal state whenever the editor state changes.
   // (internally, they exercise Update() and Remove())
@@ -128,20 +243,72 @@ class BufferTrackerContainer {
     change_listeners_.push_back(ABSL_DIE_IF_NULL(cb));
   }
 
+  // Keep the erroneous latest version parsed in addition to the last good
+  // one for only the "limit" most recently changed buffers; the others
+  // release it (see BufferTracker::ReleaseCurrent()). Default: no limit.
+  void LimitRecentlyChangedBuffers(int limit);
+
+  // Memory held by all buffer trackers.
+  BufferMemoryStats GetMemoryStats() const;
+
+  // Returns true after ParseInBackground().
+  bool parses_in_background() const { return parse_thread_ != nullptr; }
+
   // Given the URI, find the associated parse buffer if it exists.
   const BufferTracker *FindBufferTrackerOrNull(const std::string &uri) const;
 
  private:
-  // Update internal state of the given "uri" with the content of the text
-  // buffer. Return the buffer tracker.
-  BufferTracker *Update(const std::string &uri,
-                        const verible::lsp::EditTextBuffer &txt);
+  // Return the buffer tracker for "uri", create a new one if needed.
+  std::shared_ptr<BufferTracker> FindOrCreateBufferTracker(
+      const std::string &uri);
 
   // Remove the buffer tracker for the given "uri".
-  void Remove(const std::string &uri) { buffers_.erase(uri); }
+  void Remove(const std::string &uri);
+
+  // Schedule a background parse of the content of the text buffer.
+  void ScheduleParse(const std::string &uri,
+                     const std::shared_ptr<BufferTracker> &tracker,
+                     const verible::lsp::EditTextBuffer &txt);
+
+  // Publish the result of a background parse into the "tracker" and notify
+  // listeners, unless it became stale.
+  void PublishParsed(const std::string &uri,
+                     const std::shared_ptr<BufferTracker> &tracker,
+                     std::shared_ptr<const ParsedBuffer> parsed);
+
+  void NotifyListeners(const std::string &uri, const BufferTracker *tracker);
+
+  // Make "uri" the most recently changed buffer, and release the current
+  // parse of those beyond the limit.
+  void MarkChanged(const std::string &uri);
+
+  // Main loop of the background parse thread.
+  void ParseLoop();
 
   std::vector<ChangeCallback> change_listeners_;
-  std::unordered_map<std::string, std::unique_ptr<BufferTracker>> buffers_;
+  // Trackers are shared with background parses in progress; they might
+  // outlive their removal.
+  std::unordered_map<std::string, std::shared_ptr<BufferTracker>> buffers_;
+
+  // Uris of buffers, most recently changed first, if there is a limit.
+  int recently_changed_limit_ = -1;
+  std::list<std::string> recently_changed_;
+
+  // -- Background parsing, see ParseInBackground().
+  struct PendingParse {
+    int64_t version;
+    std::shared_ptr<const std::string> content;  // Snapshot of the text.
+    absl::Time start_time;  // Not started before, to debounce updates.
+    std::shared_ptr<BufferTracker> tracker;
+  };
+
+  absl::Duration debounce_;
+  Serializer serialize_;
+  std::unique_ptr<std::thread> parse_thread_;
+  std::mutex pending_lock_;  // Guards the following.
+  std::condition_variable pending_changed_;
+  std::unordered_map<std::string, PendingParse> pending_;  // by uri
+  bool exiting_ = false;
 };
 }  // namespace verilog
 #endif  // VERILOG_TOOLS_LS_LSP_PARSE_BUFFER_H
@@ -0,0 +1,265 @@
+// Copyright 2023 The Verible Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+#include "verilog/tools/ls/lsp-parse-buffer.h"
+
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "absl/strings/str_cat.h"
+#include "absl/time/clock.h"
+#include "absl/time/time.h"
+#include "common/lsp/lsp-text-buffer.h"
+#include "gtest/gtest.h"
+
+namespace verilog {
+namespace {
+
+using verible::lsp::EditTextBuffer;
+
+// Records the versions that change listeners were informed about.
+class ChangeRecorder {
+ public:
+  explicit ChangeRecorder(BufferTrackerContainer *container) {
+    container->AddChangeListener(
+        [this](const std::string &uri, const BufferTracker *tracker) {
+          const std::lock_guard<std::mutex> l(lock_);
+          if (tracker == nullptr) {
+            versions_.push_back(-1);  // closed
+          } else {
+            versions_.push_back(tracker->current()->version());
+          }
+        });
+  }
+
+  // Waits until at least "count" changes were recorded, or timeout.
+  std::vector<int64_t> WaitForChanges(size_t count) {
+    const absl::Time deadline = absl::Now() + absl::Seconds(10);
+    while (absl::Now() < deadline) {
+      {
+        const std::lock_guard<std::mutex> l(lock_);
+        if (versions_.size() >= count) return versions_;
+      }
+      absl::SleepFor(absl::Milliseconds(5));
+    }
+    return Changes();
+  }
+
+  std::vector<int64_t> Changes() {
+    const std::lock_guard<std::mutex> l(lock_);
+    return versions_;
+  }
+
+ private:
+  std::mutex lock_;
+  std::vector<int64_t> versions_;
+};
+
+static std::string ModuleText(int version) {
+  return absl::StrCat("module m", version, ";\nendmodule\n");
+}
+
+TEST(ParsedBufferTest, IdentifierOccurrences) {
+  const ParsedBuffer parsed(1, "file:///m.sv",
+                            "module m;\n"
+                            "  wire /* \xc3\xa4 */ a, b;\n"
+                            "  assign a = b;\n"
+                            "endmodule : m\n");
+  const ParsedBuffer::IdentifierOccurrences &occurrences =
+      parsed.identifier_occurrences();
+  EXPECT_EQ(&occurrences, &parsed.identifier_occurrences());  // Only once.
+  EXPECT_EQ(occurrences.size(), 3);
+  EXPECT_EQ(occurrences.at("m"),
+            (std::vector<verible::LineColumnRange>{{{0, 7}, {0, 8}},
+                                                   {{3, 12}, {3, 13}}}));
+  // Columns count UTF-16 code units.
+  EXPECT_EQ(occurrences.at("a"),
+            (std::vector<verible::LineColumnRange>{{{1, 15}, {1, 16}},
+                                                   {{2, 9}, {2, 10}}}));
+  EXPECT_EQ(occurrences.at("b").size(), 2);
+}
+
+TEST(BufferTrackerContainerTest, ParsesSynchronouslyByDefault) {
+  BufferTrackerContainer container;
+  ChangeRecorder recorder(&container);
+  auto callback = container.GetSubscriptionCallback();
+
+  EditTextBuffer txt(ModuleText(1));
+  txt.set_last_global_version(1);
+  callback("file:///a.sv", &txt);
+  EXPECT_EQ(recorder.Changes(), std::vector<int64_t>({1}));
+
+  const BufferTracker *tracker =
+      container.FindBufferTrackerOrNull("file:///a.sv");
+  ASSERT_NE(tracker, nullptr);
+  ASSERT_NE(tracker->current(), nullptr);
+  EXPECT_TRUE(tracker->current()->parsed_successfully());
+  EXPECT_EQ(tracker->current(), tracker->last_good());
+
+  callback("file:///a.sv", nullptr);
+  EXPECT_EQ(recorder.Changes(), std::vector<int64_t>({1, -1}));
+  EXPECT_EQ(container.FindBufferTrackerOrNull("file:///a.sv"), nullptr);
+}
+
+TEST(BufferTrackerTest, SnapshotIsUnaffectedByUpdates) {
+  BufferTracker tracker;
+  tracker.Publish(
+      std::make_shared<ParsedBuffer>(1, "file:///a.sv", ModuleText(1)));
+  const auto snapshot = tracker.Snapshot();
+  const auto first = tracker.current();
+  EXPECT_EQ(snapshot->current(), first);
+  EXPECT_EQ(snapshot->last_good(), first);
+
+  tracker.Publish(std::make_shared<ParsedBuffer>(2, "file:///a.sv", "bad("));
+  EXPECT_EQ(tracker.current()->version(), 2);
+  EXPECT_EQ(tracker.last_good(), first);
+  EXPECT_EQ(snapshot->current(), first);
+}
+
+TEST(BufferTrackerContainerTest, ReleasesErroneousParsesOfOlderEdits) {
+  BufferTrackerContainer container;
+  container.LimitRecentlyChangedBuffers(1);
+  auto callback = container.GetSubscriptionCallback();
+
+  EditTextBuffer good(ModuleText(1));
+  good.set_last_global_version(1);
+  callback("file:///a.sv", &good);
+  EditTextBuffer bad("module m2;\n");
+  bad.set_last_global_version(2);
+  callback("file:///a.sv", &bad);
+  EditTextBuffer other(ModuleText(3));
+  other.set_last_global_version(3);
+  callback("file:///b.sv", &other);
+
+  // Only the erroneous parse of a.sv is released; last good ones are kept.
+  BufferMemoryStats stats = container.GetMemoryStats();
+  EXPECT_EQ(stats.buffers, 2);
+  EXPECT_EQ(stats.parsed_buffers, 2);
+  EXPECT_EQ(stats.released_buffers, 1);
+  EXPECT_EQ(stats.released_bytes, bad.document_length());
+
+  // Asking for it parses it again.
+  const BufferTracker *tracker =
+      container.FindBufferTrackerOrNull("file:///a.sv");
+  ASSERT_NE(tracker, nullptr);
+  ASSERT_NE(tracker->current(), nullptr);
+  EXPECT_EQ(tracker->current()->version(), 2);
+  EXPECT_FALSE(tracker->current()->parsed_successfully());
+  EXPECT_EQ(tracker->last_good()->version(), 1);
+  stats = container.GetMemoryStats();
+  EXPECT_EQ(stats.parsed_buffers, 3);
+  EXPECT_EQ(stats.released_buffers, 0);
+
+  // The released version is not parsed again when it is updated.
+  callback("file:///b.sv", &other);
+  EXPECT_EQ(container.GetMemoryStats().released_buffers, 1);
+  callback("file:///a.sv", &bad);
+  stats = container.GetMemoryStats();
+  EXPECT_EQ(stats.parsed_buffers, 2);
+  EXPECT_EQ(stats.released_buffers, 1);
+}
+
+// Runs functions one at a time, like the dispatch loop of the language server.
+class SerializingTest : public ::testing::Test {
+ protected:
+  BufferTrackerContainer::Serializer Serializer() {
+    return [this](const std::function<void()> &f) {
+      const std::lock_guard<std::mutex> l(lock_);
+      f();
+    };
+  }
+
+  // Calls the subscription callback, serialized with background parsing.
+  void Update(const std::string &uri, const EditTextBuffer *txt) {
+    const std::lock_guard<std::mutex> l(lock_);
+    callback_(uri, txt);
+  }
+
+  std::mutex lock_;
+  BufferTrackerContainer container_;
+  verible::lsp::BufferCollection::UriBufferCallback callback_ =
+      container_.GetSubscriptionCallback();
+};
+
+TEST_F(SerializingTest, BackgroundParsingDebouncesRapidEdits) {
+  ChangeRecorder recorder(&container_);
+  container_.ParseInBackground(absl::Milliseconds(200), Serializer());
+
+  EditTextBuffer txt(ModuleText(1));
+  txt.set_last_global_version(1);
+  Update("file:///a.sv", &txt);
+  // Newly opened buffers are parsed right away.
+  EXPECT_EQ(recorder.Changes(), std::vector<int64_t>({1}));
+
+  // Only the last of a rapid sequence of edits is parsed.
+  for (int version = 2; version <= 5; ++version) {
+    EditTextBuffer edited(ModuleText(version));
+    edited.set_last_global_version(version);
+    Update("file:///a.sv", &edited);
+  }
+  EXPECT_EQ(recorder.WaitForChanges(2), std::vector<int64_t>({1, 5}));
+
+  const std::lock_guard<std::mutex> l(lock_);
+  const BufferTracker *tracker =
+      container_.FindBufferTrackerOrNull("file:///a.sv");
+  ASSERT_NE(tracker, nullptr);
+  EXPECT_EQ(tracker->current()->version(), 5);
+  EXPECT_EQ(tracker->current(), tracker->last_good());
+}
+
+TEST_F(SerializingTest, BackgroundParsingKeepsLastGood) {
+  ChangeRecorder recorder(&container_);
+  container_.ParseInBackground(absl::Milliseconds(1), Serializer());
+
+  EditTextBuffer txt(ModuleText(1));
+  txt.set_last_global_version(1);
+  Update("file:///a.sv", &txt);
+
+  EditTextBuffer broken("module m2;\n");
+  broken.set_last_global_version(2);
+  Update("file:///a.sv", &broken);
+  EXPECT_EQ(recorder.WaitForChanges(2), std::vector<int64_t>({1, 2}));
+
+  const std::lock_guard<std::mutex> l(lock_);
+  const BufferTracker *tracker =
+      container_.FindBufferTrackerOrNull("file:///a.sv");
+  ASSERT_NE(tracker, nullptr);
+  EXPECT_EQ(tracker->current()->version(), 2);
+  EXPECT_FALSE(tracker->current()->parsed_successfully());
+  EXPECT_EQ(tracker->last_good()->version(), 1);
+}
+
+TEST_F(SerializingTest, BackgroundParseOfClosedBufferIsDropped) {
+  ChangeRecorder recorder(&container_);
+  container_.ParseInBackground(absl::Milliseconds(100), Serializer());
+
+  EditTextBuffer txt(ModuleText(1));
+  txt.set_last_global_version(1);
+  Update("file:///a.sv", &txt);
+  EditTextBuffer edited(ModuleText(2));
+  edited.set_last_global_version(2);
+  Update("file:///a.sv", &edited);
+  Update("file:///a.sv", nullptr);
+
+  absl::SleepFor(absl::Milliseconds(300));
+  EXPECT_EQ(recorder.Changes(), std::vector<int64_t>({1, -1}));
+}
+
+}  // namespace
+}  // namespace verilog
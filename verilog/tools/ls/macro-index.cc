@@ -0,0 +1,153 @@
+// Copyright 2023 The Verible Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+
+#include "verilog/tools/ls/macro-index.h"
+
+#include <algorithm>
+#include <functional>
+#include <memory>
+#include <utility>
+#include <vector>
+
+#include "absl/strings/string_view.h"
+#include "common/text/text_structure.h"
+#include "common/text/token_info.h"
+#include "verilog/parser/verilog_token_enum.h"
+
+namespace verilog {
+
+FileMacros ScanFileMacros(const verible::TextStructureView &text) {
+  FileMacros result;
+  result.contents = text.Contents();
+  // The directive that the next identifier is the macro name of, or 0.
+  int expecting_name = 0;
+  // Set from a `define to the end of its body; the definition is the last.
+  bool defining = false;
+  bool in_formals = false;
+  const char *define_start = nullptr;
+  const auto end_definition = [&](const char *end) {
+    result.definitions.back().text =
+        absl::string_view(define_start, end - define_start);
+    defining = false;
+    in_formals = false;
+  };
+  for (const verible::TokenInfo &token : text.TokenStream()) {
+    switch (token.token_enum()) {
+      case PP_define:
+        expecting_name = PP_define;
+        define_start = token.text().data();
+        break;
+      case PP_ifdef:
+      case PP_ifndef:
+      case PP_elsif:
+      case PP_undef:
+        expecting_name = token.token_enum();
+        break;
+      case PP_Identifier:
+        if (in_formals) {
+          result.definitions.back().parameters.push_back(token.text());
+        } else if (expecting_name == PP_define) {
+          result.definitions.push_back({.name = token.text()});
+          defining = true;
+        } else if (expecting_name != 0) {
+          result.usages.push_back(token.text());
+        }
+        expecting_name = 0;
+        break;
+      case '(':
+      case ')':
+        // Within a `define, parentheses only enclose the formal parameters;
+        // those of default values are part of their text.
+        if (defining) in_formals = token.token_enum() == '(';
+        expecting_name = 0;
+        break;
+      case PP_define_body:
+        if (defining) end_definition(token.text().end());
+        expecting_name = 0;
+        break;
+      case MacroIdentifier:
+      case MacroCallId:
+      case MacroIdItem:
+        result.usages.push_back(token.text().substr(1));  // After the "`".
+        expecting_name = 0;
+        break;
+      case TK_SPACE:
+      case TK_NEWLINE:
+      case TK_COMMENT_BLOCK:
+      case TK_EOL_COMMENT:
+        break;
+      default:
+        expecting_name = 0;
+        break;
+    }
+  }
+  // A `define at the end of the text may lack a body.
+  if (defining) {
+    const absl::string_view name = result.definitions.back().name;
+    end_definition(name.end());
+  }
+  return result;
+}
+
+// Orders names by their position.
+static bool StartsBefore(absl::string_view a, absl::string_view b) {
+  return std::less<const char *>()(a.data(), b.data());
+}
+
+MacroIndex::MacroIndex(std::vector<std::shared_ptr<const FileMacros>> files)
+    : files_(std::move(files)) {
+  for (const auto &file : files_) {
+    for (const FileMacros::Definition &definition : file->definitions) {
+      names_.push_back(definition.name);
+      macros_[definition.name].definitions.push_back(&definition);
+    }
+    for (const absl::string_view usage : file->usages) {
+      names_.push_back(usage);
+      macros_[usage].usages.push_back(usage);
+    }
+  }
+  std::sort(names_.begin(), names_.end(), StartsBefore);
+}
+
+absl::string_view MacroIndex::NameAt(const char *position) const {
+  // The last name that starts at or before "position".
+  auto found = std::upper_bound(
+      names_.begin(), names_.end(), position,
+      [](const char *p, absl::string_view name) {
+        return std::less<const char *>()(p, name.data());
+      });
+  if (found == names_.begin()) return {};
+  --found;
+  if (std::less<const char *>()(found->end(), position)) return {};
+  return *found;
+}
+
+const MacroIndex::Macro &MacroIndex::Find(absl::string_view name) const {
+  static const Macro kUnknown;
+  const auto found = macros_.find(name);
+  return found == macros_.end() ? kUnknown : found->second;
+}
+
+const std::vector<const FileMacros::Definition *> &MacroIndex::DefinitionsOf(
+    absl::string_view name) const {
+  return Find(name).definitions;
+}
+
+const std::vector<absl::string_view> &MacroIndex::UsagesOf(
+    absl::string_view name) const {
+  return Find(name).usages;
+}
+
+}  // namespace verilog
@@ -0,0 +1,100 @@
+// Copyright 2023 The Verible Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+
+#ifndef VERILOG_TOOLS_LS_MACRO_INDEX_H
+#define VERILOG_TOOLS_LS_MACRO_INDEX_H
+
+#include <memory>
+#include <vector>
+
+#include "absl/container/flat_hash_map.h"
+#include "absl/strings/string_view.h"
+#include "common/text/text_structure.h"
+
+// The macros that the project files define and use, found with a scan of
+// their tokens, without preprocessing them.  This serves go-to-definition,
+// references and hover on `MACRO usages.
+
+namespace verilog {
+
+// The macro definitions and usages in the text of one file.
+struct FileMacros {
+  // A `define of a macro.
+  struct Definition {
+    absl::string_view name;
+    // Names of the formal parameters, empty if the macro takes none.
+    std::vector<absl::string_view> parameters;
+    // From the `define to the end of the body.
+    absl::string_view text;
+  };
+
+  // The text that was scanned.
+  absl::string_view contents;
+  // In the order of the text.
+  std::vector<Definition> definitions;
+  // Names of the macros that are used, in the order of the text: those of
+  // macro calls and identifiers without the "`", and those after `ifdef,
+  // `ifndef, `elsif and `undef.
+  std::vector<absl::string_view> usages;
+};
+
+// Scans the lexed tokens of "text" (all of TokenStream()) for macro
+// definitions and usages.  Conditionals are not evaluated: definitions in
+// all branches are found.
+FileMacros ScanFileMacros(const verible::TextStructureView &text);
+
+// The macros of a set of files, by name.  Immutable once built; it refers to
+// the texts of the files, which must outlive it.
+class MacroIndex {
+ public:
+  MacroIndex() = default;
+
+  // Indexes the macros of "files", which are kept, so that unchanged files
+  // don't need to be scanned again for the next version of the index.
+  explicit MacroIndex(std::vector<std::shared_ptr<const FileMacros>> files);
+
+  // Returns the macro name of a definition or usage that contains
+  // "position", or ends right before it; empty if there is none.  O(log n).
+  absl::string_view NameAt(const char *position) const;
+
+  // All definitions of the macro "name", in the order of the files.
+  const std::vector<const FileMacros::Definition *> &DefinitionsOf(
+      absl::string_view name) const;
+
+  // All usages of the macro "name", in the order of the files.
+  const std::vector<absl::string_view> &UsagesOf(absl::string_view name) const;
+
+  // Files that were indexed.
+  const std::vector<std::shared_ptr<const FileMacros>> &Files() const {
+    return files_;
+  }
+
+ private:
+  struct Macro {
+    std::vector<const FileMacros::Definition *> definitions;
+    std::vector<absl::string_view> usages;
+  };
+
+  const Macro &Find(absl::string_view name) const;
+
+  std::vector<std::shared_ptr<const FileMacros>> files_;
+  // Names of all definitions and usages, sorted by their position.
+  std::vector<absl::string_view> names_;
+  absl::flat_hash_map<absl::string_view, Macro> macros_;
+};
+
+}  // namespace verilog
+
+#endif  // VERILOG_TOOLS_LS_MACRO_INDEX_H
@@ -0,0 +1,95 @@
+// Copyright 2023 The Verible Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+
+#include "verilog/tools/ls/macro-index.h"
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "absl/strings/string_view.h"
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+#include "verilog/analysis/verilog_analyzer.h"
+
+namespace verilog {
+namespace {
+
+using ::testing::ElementsAre;
+
+constexpr absl::string_view kDefines(
+    "`define WIDTH 8\n"
+    "`define MAX(a, b = 1) \\\n"
+    "  ((a) > (b) ? (a) : (b))\n"
+    "`ifndef WIDTH\n"
+    "`define WIDTH 16\n"
+    "`endif\n");
+
+constexpr absl::string_view kUses(
+    "module m;\n"
+    "  wire [`WIDTH-1:0] w = `MAX(1, 2);\n"
+    "endmodule\n");
+
+TEST(ScanFileMacrosTest, DefinitionsAndUsages) {
+  VerilogAnalyzer analyzer(kDefines, "defines.svh");
+  ASSERT_TRUE(analyzer.Analyze().ok());
+  const FileMacros macros = ScanFileMacros(analyzer.Data());
+  EXPECT_EQ(macros.contents, analyzer.Data().Contents());
+
+  ASSERT_EQ(macros.definitions.size(), 3);
+  EXPECT_EQ(macros.definitions[0].name, "WIDTH");
+  EXPECT_TRUE(macros.definitions[0].parameters.empty());
+  EXPECT_EQ(macros.definitions[0].text, "`define WIDTH 8");
+  EXPECT_EQ(macros.definitions[1].name, "MAX");
+  EXPECT_THAT(macros.definitions[1].parameters, ElementsAre("a", "b"));
+  EXPECT_EQ(macros.definitions[1].text,
+            "`define MAX(a, b = 1) \\\n  ((a) > (b) ? (a) : (b))");
+  // Both branches of conditionals.
+  EXPECT_EQ(macros.definitions[2].name, "WIDTH");
+  EXPECT_THAT(macros.usages, ElementsAre("WIDTH"));
+}
+
+TEST(MacroIndexTest, FindsDefinitionsAndUsages) {
+  VerilogAnalyzer defines(kDefines, "defines.svh");
+  ASSERT_TRUE(defines.Analyze().ok());
+  VerilogAnalyzer uses(kUses, "m.sv");
+  ASSERT_TRUE(uses.Analyze().ok());
+  const MacroIndex index(
+      {std::make_shared<const FileMacros>(ScanFileMacros(defines.Data())),
+       std::make_shared<const FileMacros>(ScanFileMacros(uses.Data()))});
+
+  const absl::string_view text = uses.Data().Contents();
+  const size_t width = text.find("`WIDTH");
+  // At the "`", within and right after the name.
+  EXPECT_TRUE(index.NameAt(text.data() + width).empty());
+  EXPECT_EQ(index.NameAt(text.data() + width + 3), "WIDTH");
+  EXPECT_EQ(index.NameAt(text.data() + width + 6), "WIDTH");
+  EXPECT_TRUE(index.NameAt(text.data()).empty());
+  const absl::string_view max = index.NameAt(text.data() + text.find("MAX"));
+  ASSERT_EQ(max, "MAX");
+
+  ASSERT_EQ(index.DefinitionsOf(max).size(), 1);
+  EXPECT_EQ(index.DefinitionsOf(max)[0]->name.data(),
+            defines.Data().Contents().data() + kDefines.find("MAX"));
+  EXPECT_EQ(index.UsagesOf(max).size(), 1);
+  EXPECT_EQ(index.DefinitionsOf("WIDTH").size(), 2);
+  // In `ifndef and in the module.
+  EXPECT_EQ(index.UsagesOf("WIDTH").size(), 2);
+  EXPECT_TRUE(index.DefinitionsOf("NONE").empty());
+  EXPECT_TRUE(index.UsagesOf("NONE").empty());
+}
+
+}  // namespace
+}  // namespace verilog
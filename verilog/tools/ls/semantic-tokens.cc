@@ -0,0 +1,271 @@
+// Copyright 2023 The Verible Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "verilog/tools/ls/semantic-tokens.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <functional>
+#include <iterator>
+#include <vector>
+
+#include "absl/strings/string_view.h"
+#include "absl/types/optional.h"
+#include "common/lsp/lsp-protocol.h"
+#include "common/strings/line_column_map.h"
+#include "common/text/text_structure.h"
+#include "common/text/token_info.h"
+#include "nlohmann/json.hpp"
+#include "verilog/analysis/symbol_table.h"
+#include "verilog/formatting/verilog_token.h"
+#include "verilog/parser/verilog_token_classifications.h"
+#include "verilog/parser/verilog_token_enum.h"
+
+namespace verilog {
+
+nlohmann::json SemanticTokensLegend() {
+  return {
+      {"tokenTypes",
+       {"namespace", "class", "interface", "enum", "struct", "type",
+        "parameter", "variable", "enumMember", "function", "macro", "keyword",
+        "comment", "string", "number", "operator"}},
+      {"tokenModifiers", {"declaration", "defaultLibrary"}},
+  };
+}
+
+namespace {
+struct Classification {
+  SemanticTokenType type;
+  uint32_t modifiers;
+};
+}  // namespace
+
+// Returns the classification of a token by its kind alone, if it has one.
+static absl::optional<Classification> ClassifyByKind(verilog_tokentype kind) {
+  switch (kind) {
+    case verilog_tokentype::MacroIdentifier:
+    case verilog_tokentype::MacroCallId:
+    case verilog_tokentype::MacroIdItem:
+    case verilog_tokentype::PP_Identifier:
+      return Classification{SemanticTokenType::kMacro, 0};
+    case verilog_tokentype::SystemTFIdentifier:
+      return Classification{SemanticTokenType::kFunction,
+                            kSemanticDefaultLibrary};
+    default:
+      break;
+  }
+  if (IsPreprocessorKeyword(kind)) {
+    return Classification{SemanticTokenType::kKeyword, 0};
+  }
+  using verilog::formatter::FormatTokenType;
+  switch (verilog::formatter::GetFormatTokenType(kind)) {
+    case FormatTokenType::keyword:
+      return Classification{SemanticTokenType::kKeyword, 0};
+    case FormatTokenType::numeric_base:
+    case FormatTokenType::numeric_literal:
+      return Classification{SemanticTokenType::kNumber, 0};
+    case FormatTokenType::string_literal:
+      return Classification{SemanticTokenType::kString, 0};
+    case FormatTokenType::comment_block:
+    case FormatTokenType::eol_comment:
+      return Classification{SemanticTokenType::kComment, 0};
+    case FormatTokenType::unary_operator:
+    case FormatTokenType::binary_operator:
+      return Classification{SemanticTokenType::kOperator, 0};
+    default:
+      return absl::nullopt;
+  }
+}
+
+// Returns the type of identifiers of definitions of "metatype", if any.
+static absl::optional<SemanticTokenType> TypeOfDefinition(
+    SymbolMetaType metatype) {
+  switch (metatype) {
+    case SymbolMetaType::kModule:
+    case SymbolMetaType::kPackage:
+    case SymbolMetaType::kGenerate:
+      return SemanticTokenType::kNamespace;
+    case SymbolMetaType::kClass:
+      return SemanticTokenType::kClass;
+    case SymbolMetaType::kInterface:
+      return SemanticTokenType::kInterface;
+    case SymbolMetaType::kEnumType:
+      return SemanticTokenType::kEnum;
+    case SymbolMetaType::kStruct:
+      return SemanticTokenType::kStruct;
+    case SymbolMetaType::kTypeAlias:
+      return SemanticTokenType::kType;
+    case SymbolMetaType::kParameter:
+      return SemanticTokenType::kParameter;
+    case SymbolMetaType::kDataNetVariableInstance:
+      return SemanticTokenType::kVariable;
+    case SymbolMetaType::kEnumConstant:
+      return SemanticTokenType::kEnumMember;
+    case SymbolMetaType::kFunction:
+    case SymbolMetaType::kTask:
+      return SemanticTokenType::kFunction;
+    default:
+      return absl::nullopt;
+  }
+}
+
+// Appends the parts of "token" ("contents" is its whole text) on lines
+// [first_line, end_line) to "result", one per line.  Columns and lengths
+// count UTF-16 code units.
+static void AppendToken(absl::string_view contents, absl::string_view token,
+                        const Classification &classification, int first_line,
+                        int end_line, const verible::LineColumnMap &line_map,
+                        const verible::Utf16ColumnMap &utf16_map,
+                        verible::LineColumnCursor *cursor,
+                        std::vector<SemanticToken> *result) {
+  int offset = token.data() - contents.data();
+  for (;;) {
+    const size_t newline = token.find('\n');
+    const absl::string_view part = token.substr(0, newline);
+    if (!part.empty()) {
+      const int line = cursor->LineAtOffset(offset);
+      if (line >= end_line) return;
+      if (line >= first_line) {
+        const int byte_column = offset - line_map.OffsetAtLine(line);
+        const int start = utf16_map.Utf16Column(line, byte_column);
+        const int end = utf16_map.Utf16Column(line, byte_column + part.size());
+        result->push_back({line, start, end - start, classification.type,
+                           classification.modifiers});
+      }
+    }
+    if (newline == absl::string_view::npos) return;
+    token.remove_prefix(newline + 1);
+    offset += newline + 1;
+  }
+}
+
+std::vector<SemanticToken> ClassifySemanticTokens(
+    const verible::TextStructureView &text,
+    const std::vector<ResolvedIdentifier> &resolved, int first_line,
+    int end_line) {
+  std::vector<SemanticToken> result;
+  first_line = std::max(first_line, 0);
+  if (first_line >= end_line) return result;
+  const absl::string_view contents = text.Contents();
+  // Not the lazily created map of "text", which is shared with other threads.
+  const verible::LineColumnMap line_map(contents);
+  const int lines = line_map.GetBeginningOfLineOffsets().size();
+  if (first_line >= lines) return result;
+  const int lower = line_map.OffsetAtLine(first_line);
+  const int upper =
+      end_line < lines ? line_map.OffsetAtLine(end_line) : contents.size();
+
+  const verible::TokenSequence &tokens = text.TokenStream();
+  const verible::TokenRange range =
+      text.TokenRangeSpanningOffsets(lower, upper);
+  verible::TokenSequence::const_iterator begin = range.begin();
+  const verible::TokenSequence::const_iterator end = range.end();
+  // A token that starts before the first line might reach into it.
+  if (begin != tokens.begin() && std::prev(begin)->right(contents) > lower) {
+    --begin;
+  }
+  if (begin == end) return result;
+
+  const auto starts_before = [](const ResolvedIdentifier &r, const char *p) {
+    return std::less<const char *>()(r.identifier.data(), p);
+  };
+  auto next_resolved = std::lower_bound(resolved.begin(), resolved.end(),
+                                        begin->text().data(), starts_before);
+  const verible::Utf16ColumnMap &utf16_map = text.GetUtf16ColumnMap();
+  verible::LineColumnCursor cursor(line_map);
+  for (auto token = begin; token != end; ++token) {
+    const absl::string_view token_text = token->text();
+    if (token_text.empty()) continue;
+    const auto kind = static_cast<verilog_tokentype>(token->token_enum());
+    absl::optional<Classification> classification;
+    if (IsIdentifierLike(kind)) {
+      while (next_resolved != resolved.end() &&
+             starts_before(*next_resolved, token_text.data())) {
+        ++next_resolved;
+      }
+      if (next_resolved != resolved.end() &&
+          next_resolved->identifier.data() == token_text.data()) {
+        const absl::optional<SemanticTokenType> type =
+            TypeOfDefinition(next_resolved->metatype);
+        if (type) {
+          classification = Classification{
+              *type, next_resolved->is_definition ? kSemanticDeclaration : 0};
+        }
+      }
+    }
+    if (!classification) classification = ClassifyByKind(kind);
+    if (!classification) continue;
+    AppendToken(contents, token_text, *classification, first_line, end_line,
+                line_map, utf16_map, &cursor, &result);
+  }
+  return result;
+}
+
+std::vector<SemanticToken> SemanticTokensOnLines(
+    const std::vector<SemanticToken> &tokens, int first_line, int end_line) {
+  const auto begin = std::lower_bound(
+      tokens.begin(), tokens.end(), first_line,
+      [](const SemanticToken &t, int line) { return t.line < line; });
+  const auto end = std::lower_bound(
+      begin, tokens.end(), end_line,
+      [](const SemanticToken &t, int line) { return t.line < line; });
+  return {begin, end};
+}
+
+std::vector<int> EncodeSemanticTokens(
+    const std::vector<SemanticToken> &tokens) {
+  std::vector<int> data;
+  data.reserve(5 * tokens.size());
+  int line = 0;
+  int column = 0;
+  for (const SemanticToken &token : tokens) {
+    const int line_delta = token.line - line;
+    data.push_back(line_delta);
+    data.push_back(line_delta == 0 ? token.column - column : token.column);
+    data.push_back(token.length);
+    data.push_back(static_cast<int>(token.type));
+    data.push_back(static_cast<int>(token.modifiers));
+    line = token.line;
+    column = token.column;
+  }
+  return data;
+}
+
+std::vector<verible::lsp::SemanticTokensEdit> DiffSemanticTokens(
+    const std::vector<int> &previous, const std::vector<int> &current) {
+  // Edits are kept to whole tokens, of five integers each.
+  const size_t common_begin =
+      std::mismatch(previous.begin(), previous.end(), current.begin(),
+                    current.end())
+          .first -
+      previous.begin();
+  const size_t prefix = common_begin / 5 * 5;
+  if (prefix == previous.size() && prefix == current.size()) return {};
+  const size_t max_suffix =
+      std::min(previous.size(), current.size()) - prefix;
+  size_t suffix = 0;
+  while (suffix < max_suffix &&
+         previous[previous.size() - 1 - suffix] ==
+             current[current.size() - 1 - suffix]) {
+    ++suffix;
+  }
+  suffix = suffix / 5 * 5;
+  verible::lsp::SemanticTokensEdit edit;
+  edit.start = prefix;
+  edit.deleteCount = previous.size() - prefix - suffix;
+  edit.data.assign(current.begin() + prefix, current.end() - suffix);
+  return {edit};
+}
+
+}  // namespace verilog
@@ -0,0 +1,104 @@
+// Copyright 2023 The Verible Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef VERILOG_TOOLS_LS_SEMANTIC_TOKENS_H
+#define VERILOG_TOOLS_LS_SEMANTIC_TOKENS_H
+
+#include <cstdint>
+#include <limits>
+#include <vector>
+
+#include "absl/strings/string_view.h"
+#include "common/lsp/lsp-protocol.h"
+#include "common/text/text_structure.h"
+#include "nlohmann/json.hpp"
+#include "verilog/analysis/symbol_table.h"
+
+// Semantic tokens (textDocument/semanticTokens) tell the editor what each
+// token is, e.g. a keyword, a module or a parameter, so that it can highlight
+// them accordingly.
+
+namespace verilog {
+
+// Types of semantic tokens, in the order of SemanticTokensLegend().
+enum class SemanticTokenType {
+  kNamespace,  // Modules, packages and generate blocks.
+  kClass,
+  kInterface,
+  kEnum,
+  kStruct,
+  kType,
+  kParameter,
+  kVariable,  // Data, nets, variables and instances.
+  kEnumMember,
+  kFunction,  // Functions and tasks.
+  kMacro,
+  kKeyword,
+  kComment,
+  kString,
+  kNumber,
+  kOperator,
+};
+
+// Bits of semantic token modifiers, in the order of SemanticTokensLegend().
+inline constexpr uint32_t kSemanticDeclaration = 1 << 0;
+inline constexpr uint32_t kSemanticDefaultLibrary = 1 << 1;  // System tasks.
+
+// Returns the legend of token types and modifiers, to announce in the
+// semanticTokensProvider capability.
+nlohmann::json SemanticTokensLegend();
+
+// A classified token, within a single line. Columns and lengths are in
+// characters, as in other positions sent to the client.
+struct SemanticToken {
+  int line;
+  int column;
+  int length;
+  SemanticTokenType type;
+  uint32_t modifiers;
+};
+
+// An identifier in the text that was resolved in the symbol table.
+struct ResolvedIdentifier {
+  absl::string_view identifier;  // Within the text.
+  SymbolMetaType metatype;       // Of the definition.
+  bool is_definition;            // Names it, instead of referring to it.
+};
+
+// Classifies the tokens of "text" on lines [first_line, end_line), in order.
+// Keywords, literals, comments and macros are classified by their kind.
+// Identifiers are only classified if they are among "resolved", which is
+// sorted by position; others are left to the editor. Tokens that span
+// several lines, like block comments, are split into one per line.
+std::vector<SemanticToken> ClassifySemanticTokens(
+    const verible::TextStructureView &text,
+    const std::vector<ResolvedIdentifier> &resolved, int first_line = 0,
+    int end_line = std::numeric_limits<int>::max());
+
+// Returns the "tokens" that are on lines [first_line, end_line).
+std::vector<SemanticToken> SemanticTokensOnLines(
+    const std::vector<SemanticToken> &tokens, int first_line, int end_line);
+
+// Encodes "tokens" as in the data of the semanticTokens response: five
+// integers per token, with its position relative to the previous one.
+std::vector<int> EncodeSemanticTokens(const std::vector<SemanticToken> &tokens);
+
+// Returns the edits that turn the encoded tokens "previous" into "current",
+// for the semanticTokens/full/delta response: the tokens between their common
+// beginning and end are replaced. No edits if they are the same.
+std::vector<verible::lsp::SemanticTokensEdit> DiffSemanticTokens(
+    const std::vector<int> &previous, const std::vector<int> &current);
+
+}  // namespace verilog
+#endif  // VERILOG_TOOLS_LS_SEMANTIC_TOKENS_H
@@ -0,0 +1,191 @@
+// Copyright 2023 The Verible Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "verilog/tools/ls/semantic-tokens.h"
+
+#include <vector>
+
+#include "absl/strings/string_view.h"
+#include "common/lsp/lsp-protocol.h"
+#include "gtest/gtest.h"
+#include "verilog/analysis/symbol_table.h"
+#include "verilog/analysis/verilog_analyzer.h"
+
+namespace verilog {
+namespace {
+
+// Returns the token that starts at "line" and "column", or nullptr.
+const SemanticToken *TokenAt(const std::vector<SemanticToken> &tokens,
+                             int line, int column) {
+  for (const SemanticToken &token : tokens) {
+    if (token.line == line && token.column == column) return &token;
+  }
+  return nullptr;
+}
+
+TEST(SemanticTokensTest, ClassifiesTokensByKind) {
+  VerilogAnalyzer analyzer(
+      "module m;\n"
+      "  // comment\n"
+      "  initial $display(\"s\", 1 + `FOO);\n"
+      "endmodule\n",
+      "m.sv");
+  ASSERT_TRUE(analyzer.Analyze().ok());
+  const std::vector<SemanticToken> tokens =
+      ClassifySemanticTokens(analyzer.Data(), {});
+
+  const SemanticToken *module = TokenAt(tokens, 0, 0);
+  ASSERT_NE(module, nullptr);
+  EXPECT_EQ(module->type, SemanticTokenType::kKeyword);
+  EXPECT_EQ(module->length, 6);
+  // Identifiers that were not resolved are left to the editor.
+  EXPECT_EQ(TokenAt(tokens, 0, 7), nullptr);
+
+  const SemanticToken *comment = TokenAt(tokens, 1, 2);
+  ASSERT_NE(comment, nullptr);
+  EXPECT_EQ(comment->type, SemanticTokenType::kComment);
+  EXPECT_EQ(comment->length, 10);
+
+  const SemanticToken *display = TokenAt(tokens, 2, 10);
+  ASSERT_NE(display, nullptr);
+  EXPECT_EQ(display->type, SemanticTokenType::kFunction);
+  EXPECT_EQ(display->modifiers, kSemanticDefaultLibrary);
+  const SemanticToken *string = TokenAt(tokens, 2, 19);
+  ASSERT_NE(string, nullptr);
+  EXPECT_EQ(string->type, SemanticTokenType::kString);
+  const SemanticToken *number = TokenAt(tokens, 2, 24);
+  ASSERT_NE(number, nullptr);
+  EXPECT_EQ(number->type, SemanticTokenType::kNumber);
+  const SemanticToken *plus = TokenAt(tokens, 2, 26);
+  ASSERT_NE(plus, nullptr);
+  EXPECT_EQ(plus->type, SemanticTokenType::kOperator);
+  const SemanticToken *macro = TokenAt(tokens, 2, 28);
+  ASSERT_NE(macro, nullptr);
+  EXPECT_EQ(macro->type, SemanticTokenType::kMacro);
+
+  // In order of position.
+  for (size_t i = 1; i < tokens.size(); ++i) {
+    EXPECT_TRUE(tokens[i - 1].line < tokens[i].line ||
+                (tokens[i - 1].line == tokens[i].line &&
+                 tokens[i - 1].column < tokens[i].column));
+  }
+}
+
+TEST(SemanticTokensTest, ClassifiesResolvedIdentifiers) {
+  VerilogAnalyzer analyzer(
+      "module m;\n"
+      "  wire w;\n"
+      "  assign w = 1;\n"
+      "endmodule\n",
+      "m.sv");
+  ASSERT_TRUE(analyzer.Analyze().ok());
+  const absl::string_view text = analyzer.Data().Contents();
+  const absl::string_view module_name = text.substr(text.find('m', 1), 1);
+  const absl::string_view definition = text.substr(text.find("w;"), 1);
+  const absl::string_view reference = text.substr(text.find("w ="), 1);
+  const std::vector<SemanticToken> tokens = ClassifySemanticTokens(
+      analyzer.Data(),
+      {{module_name, SymbolMetaType::kModule, true},
+       {definition, SymbolMetaType::kDataNetVariableInstance, true},
+       {reference, SymbolMetaType::kDataNetVariableInstance, false}});
+
+  const SemanticToken *module = TokenAt(tokens, 0, 7);
+  ASSERT_NE(module, nullptr);
+  EXPECT_EQ(module->type, SemanticTokenType::kNamespace);
+  EXPECT_EQ(module->modifiers, kSemanticDeclaration);
+  const SemanticToken *wire = TokenAt(tokens, 1, 7);
+  ASSERT_NE(wire, nullptr);
+  EXPECT_EQ(wire->type, SemanticTokenType::kVariable);
+  EXPECT_EQ(wire->modifiers, kSemanticDeclaration);
+  const SemanticToken *use = TokenAt(tokens, 2, 9);
+  ASSERT_NE(use, nullptr);
+  EXPECT_EQ(use->type, SemanticTokenType::kVariable);
+  EXPECT_EQ(use->modifiers, 0);
+}
+
+TEST(SemanticTokensTest, SplitsTokensPerLineAndLimitsToLines) {
+  VerilogAnalyzer analyzer(
+      "/* first\n"
+      "   second */ module m;\n"
+      "endmodule\n",
+      "m.sv");
+  ASSERT_TRUE(analyzer.Analyze().ok());
+  const std::vector<SemanticToken> all =
+      ClassifySemanticTokens(analyzer.Data(), {});
+  ASSERT_EQ(all.size(), 4);
+  EXPECT_EQ(all[0].line, 0);
+  EXPECT_EQ(all[0].length, 8);
+  EXPECT_EQ(all[1].line, 1);
+  EXPECT_EQ(all[1].column, 0);
+  EXPECT_EQ(all[1].length, 12);
+  EXPECT_EQ(all[1].type, SemanticTokenType::kComment);
+
+  // The comment reaches into the second line.
+  const std::vector<SemanticToken> second_line =
+      ClassifySemanticTokens(analyzer.Data(), {}, 1, 2);
+  ASSERT_EQ(second_line.size(), 2);
+  EXPECT_EQ(second_line[0].type, SemanticTokenType::kComment);
+  EXPECT_EQ(second_line[1].type, SemanticTokenType::kKeyword);
+  EXPECT_EQ(second_line[1].column, 13);
+
+  const std::vector<SemanticToken> sliced = SemanticTokensOnLines(all, 1, 2);
+  ASSERT_EQ(sliced.size(), 2);
+  EXPECT_EQ(sliced[1].column, 13);
+  EXPECT_TRUE(SemanticTokensOnLines(all, 5, 9).empty());
+}
+
+TEST(SemanticTokensTest, EncodesRelativePositions) {
+  const std::vector<int> data = EncodeSemanticTokens({
+      {2, 5, 3, SemanticTokenType::kKeyword, 0},
+      {2, 10, 4, SemanticTokenType::kVariable, kSemanticDeclaration},
+      {5, 2, 1, SemanticTokenType::kOperator, 0},
+  });
+  const int keyword = static_cast<int>(SemanticTokenType::kKeyword);
+  const int variable = static_cast<int>(SemanticTokenType::kVariable);
+  const int op = static_cast<int>(SemanticTokenType::kOperator);
+  EXPECT_EQ(data, std::vector<int>({2, 5, 3, keyword, 0,   //
+                                    0, 5, 4, variable, 1,  //
+                                    3, 2, 1, op, 0}));
+}
+
+TEST(SemanticTokensTest, DiffReplacesChangedTokens) {
+  const std::vector<int> previous = {0, 0, 6, 11, 0,  //
+                                     1, 2, 4, 11, 0,  //
+                                     1, 0, 9, 11, 0};
+  EXPECT_TRUE(DiffSemanticTokens(previous, previous).empty());
+
+  // Second token changed, and one inserted after it.
+  const std::vector<int> current = {0, 0, 6, 11, 0,  //
+                                    1, 2, 5, 11, 0,  //
+                                    0, 6, 1, 15, 0,  //
+                                    1, 0, 9, 11, 0};
+  const std::vector<verible::lsp::SemanticTokensEdit> edits =
+      DiffSemanticTokens(previous, current);
+  ASSERT_EQ(edits.size(), 1);
+  EXPECT_EQ(edits[0].start, 5);
+  EXPECT_EQ(edits[0].deleteCount, 5);
+  EXPECT_EQ(edits[0].data,
+            std::vector<int>({1, 2, 5, 11, 0, 0, 6, 1, 15, 0}));
+
+  // Everything removed.
+  const std::vector<verible::lsp::SemanticTokensEdit> cleared =
+      DiffSemanticTokens(previous, {});
+  ASSERT_EQ(cleared.size(), 1);
+  EXPECT_EQ(cleared[0].start, 0);
+  EXPECT_EQ(cleared[0].deleteCount, 15);
+  EXPECT_TRUE(cleared[0].data.empty());
+}
+
+}  // namespace
+}  // namespace verilog
@@ -15,14 +15,39 @@
 
 #include "verilog/tools/ls/symbol-table-handler.h"
 
+#include <algorithm>
+#include <atomic>
 #include <filesystem>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <set>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
 
 #include "absl/flags/flag.h"
+#include "absl/status/status.h"
+#include "absl/status/statusor.h"
 #include "absl/time/clock.h"
 #include "absl/time/time.h"
+#include "absl/strings/ascii.h"
+#include "absl/strings/match.h"
+#include "absl/strings/str_cat.h"
 #include "common/lsp/lsp-file-utils.h"
+#include "common/lsp/lsp-protocol-enums.h"
 #include "common/strings/line_column_map.h"
+#include "common/text/tree_utils.h"
 #include "common/util/file_util.h"
+#include "common/util/latency_stats.h"
+#include "common/util/range.h"
+#include "common/util/thread_pool.h"
+#include "common/util/tree_operations.h"
+#include "verilog/CST/declaration.h"
+#include "verilog/CST/identifier.h"
+#include "verilog/CST/package.h"
 #include "verilog/analysis/verilog_filelist.h"
 
 ABSL_FLAG(std::string, file_list_path, "verible.filelist",
@@ -65,15 +90,113 @@ std::string FindFileList(absl::string_view current_dir) {
   return projectpath;
 }
 
+std::vector<absl::string_view> ReferencedDefinitionNames(
+    const verible::Symbol &root) {
+  std::vector<absl::string_view> names;
+  absl::flat_hash_set<absl::string_view> seen;
+  const auto add = [&](const verible::SyntaxTreeLeaf *leaf) {
+    if (leaf == nullptr) return;
+    const absl::string_view name = leaf->get().text();
+    if (seen.insert(name).second) names.push_back(name);
+  };
+  for (const auto &import : FindAllPackageImportItems(root)) {
+    add(GetImportedPackageName(*import.match));
+  }
+  // Includes instantiations of modules and interfaces.
+  for (const auto &data : FindAllDataDeclarations(root)) {
+    const verible::Symbol *const type_id =
+        GetTypeIdentifierFromDataDeclaration(*data.match);
+    if (type_id != nullptr) add(verible::GetLeftmostLeaf(*type_id));
+  }
+  for (const auto &id : FindAllQualifiedIds(root)) {
+    add(verible::GetLeftmostLeaf(*id.match));
+  }
+  return names;
+}
+
+// Parses "files" on as many threads as there are cores, unless "stop" is set.
+static std::vector<absl::Status> ParseFiles(
+    const std::vector<VerilogSourceFile *> &files,
+    const std::atomic<bool> &stop) {
+  // Files are parsed independently of each other, and the project's file
+  // registry is not modified meanwhile.
+  const int threads = std::min<int>(
+      files.size(), std::max(1u, std::thread::hardware_concurrency()));
+  std::vector<absl::Status> results;
+  results.reserve(files.size());
+  // Without threads, the pool parses synchronously.
+  verible::ThreadPool pool(threads > 1 ? threads : 0);
+  std::vector<std::future<absl::Status>> parsed;
+  parsed.reserve(files.size());
+  for (VerilogSourceFile *const verilog_file : files) {
+    parsed.push_back(
+        pool.ExecAsync<absl::Status>([verilog_file, &stop]() {
+          if (stop) return absl::CancelledError("Parsing project files");
+          return verilog_file->Parse();
+        }));
+  }
+  for (auto &status : parsed) results.push_back(status.get());
+  return results;
+}
+
+SymbolTableHandler::~SymbolTableHandler() {
+  stopping_ = true;
+  if (background_build_.joinable()) background_build_.join();
+}
+
+SymbolTableHandler::Snapshot::~Snapshot() {
+  const std::lock_guard<std::mutex> l(handler_->lock_);
+  if (--handler_->snapshots_ == 0) handler_->snapshots_released_.notify_all();
+}
+
+int64_t SymbolTableHandler::Snapshot::generation() const {
+  return index_->generation;
+}
+
+std::shared_ptr<const SymbolTableHandler::Snapshot>
+SymbolTableHandler::TakeSnapshot() {
+  const std::lock_guard<std::mutex> l(lock_);
+  // The symbol table can only change while no snapshots are held.
+  if (snapshots_ == 0 && curr_project_ && !building_in_background_) {
+    LoadProjectFileList(curr_project_->TranslationUnitRoot());
+    UpdateSymbolTableIndex();
+  }
+  ++snapshots_;
+  return std::shared_ptr<const Snapshot>(new Snapshot(this, index_));
+}
+
+std::unique_lock<std::mutex> SymbolTableHandler::LockForUpdate() {
+  std::unique_lock<std::mutex> l(lock_);
+  snapshots_released_.wait(l, [this]() {
+    return snapshots_ == 0 && !building_in_background_;
+  });
+  return l;
+}
+
 void SymbolTableHandler::SetProject(
     const std::shared_ptr<VerilogProject> &project) {
+  const auto l = LockForUpdate();
   curr_project_ = project;
+  file_macros_.clear();
   ResetSymbolTable();
   if (curr_project_) LoadProjectFileList(curr_project_->TranslationUnitRoot());
 }
 
 void SymbolTableHandler::ResetSymbolTable() {
   symbol_table_ = std::make_unique<SymbolTable>(curr_project_.get());
+  updated_files_.clear();
+  index_dirty_ = true;
+}
+
+std::vector<VerilogSourceFile *> SymbolTableHandler::UnparsedProjectFiles() {
+  std::vector<VerilogSourceFile *> unparsed_files;
+  if (!curr_project_) return unparsed_files;
+  for (auto &unit : *curr_project_) {
+    VerilogSourceFile *const verilog_file = unit.second.get();
+    if (verilog_file->is_parsed()) continue;
+    unparsed_files.push_back(verilog_file);
+  }
+  return unparsed_files;
 }
 
 void SymbolTableHandler::ParseProjectFiles() {
@@ -82,34 +205,241 @@ void SymbolTableHandler::ParseProjectFiles() {
   // Parse all files separate from SymbolTable::Build() to report parse duration
   VLOG(1) << "Parsing project files...";
   const absl::Time start = absl::Now();
-  std::vector<absl::Status> results;
-  for (auto &unit : *curr_project_) {
-    VerilogSourceFile *const verilog_file = unit.second.get();
-    if (verilog_file->is_parsed()) continue;
-    results.emplace_back(verilog_file->Parse());
-  }
+  const std::vector<absl::Status> results =
+      ParseFiles(UnparsedProjectFiles(), stopping_);
   LogFullIfVLog(results);
 
+  verible::PhaseLatencies().Record("project parse", absl::Now() - start);
   VLOG(1) << "VerilogSourceFile::Parse() for " << results.size()
           << " files: " << (absl::Now() - start);
 }
 
+std::vector<VerilogSourceFile *> SymbolTableHandler::FilesNamedAfter(
+    const std::vector<absl::string_view> &names) {
+  const absl::flat_hash_set<absl::string_view> wanted(names.begin(),
+                                                      names.end());
+  std::vector<VerilogSourceFile *> files;
+  for (auto &unit : *curr_project_) {
+    VerilogSourceFile *const verilog_file = unit.second.get();
+    const absl::string_view name = verible::file::Stem(
+        verible::file::Basename(verilog_file->ReferencedPath()));
+    if (wanted.contains(name)) files.push_back(verilog_file);
+  }
+  return files;
+}
+
+void SymbolTableHandler::Prefetch(absl::string_view path) {
+  std::unique_lock<std::mutex> l(lock_);
+  const auto built_or_building = [this]() {
+    return !curr_project_ || !files_dirty_ || building_in_background_;
+  };
+  if (built_or_building()) return;
+  snapshots_released_.wait(l, [this]() {
+    return snapshots_ == 0 || building_in_background_;
+  });
+  if (built_or_building()) return;
+
+  const absl::Time start = absl::Now();
+  VerilogSourceFile *const opened = curr_project_->LookupRegisteredFile(
+      curr_project_->GetRelativePathToSource(path));
+  if (opened != nullptr && opened->is_parsed() &&
+      opened->GetTextStructure() != nullptr &&
+      opened->GetTextStructure()->SyntaxTree() != nullptr) {
+    std::vector<VerilogSourceFile *> units = {opened};
+    for (VerilogSourceFile *const file : FilesNamedAfter(
+             ReferencedDefinitionNames(
+                 *opened->GetTextStructure()->SyntaxTree()))) {
+      if (file != opened) units.push_back(file);
+    }
+    std::vector<VerilogSourceFile *> unparsed_units;
+    for (VerilogSourceFile *const file : units) {
+      if (!file->is_parsed()) unparsed_units.push_back(file);
+    }
+    std::vector<absl::Status> statuses = ParseFiles(unparsed_units, stopping_);
+    ResetSymbolTable();
+    for (const VerilogSourceFile *const file : units) {
+      symbol_table_->BuildSingleTranslationUnit(file->ReferencedPath(),
+                                                &statuses);
+    }
+    symbol_table_->Resolve(&statuses);
+    LogFullIfVLog(statuses);
+    IndexSymbolTable();
+    verible::PhaseLatencies().Record("symbol table prefetch",
+                                     absl::Now() - start);
+    VLOG(1) << "Built symbol table of " << path << " and " << units.size() - 1
+            << " files it refers to: " << (absl::Now() - start);
+  }
+
+  // The files of the project cannot be parsed while holding the lock, as
+  // that would hold back lookups.
+  building_in_background_ = true;
+  if (background_build_.joinable()) background_build_.join();  // Done.
+  background_build_ = std::thread(
+      [this, unparsed_files = UnparsedProjectFiles()]() {
+        BuildInBackground(unparsed_files);
+      });
+}
+
+void SymbolTableHandler::BuildInBackground(
+    const std::vector<VerilogSourceFile *> &unparsed_files) {
+  const absl::Time start = absl::Now();
+  LogFullIfVLog(ParseFiles(unparsed_files, stopping_));
+  verible::PhaseLatencies().Record("project parse", absl::Now() - start);
+  VLOG(1) << "VerilogSourceFile::Parse() for " << unparsed_files.size()
+          << " files in the background: " << (absl::Now() - start);
+
+  std::unique_lock<std::mutex> l(lock_);
+  snapshots_released_.wait(l, [this]() { return snapshots_ == 0; });
+  for (auto &[path, content] : pending_contents_) {
+    ReplaceFileContent(path, std::move(content));
+  }
+  pending_contents_.clear();
+  if (!stopping_) BuildSymbolTable();
+  building_in_background_ = false;
+  snapshots_released_.notify_all();
+}
+
+void SymbolTableHandler::WaitForBackgroundBuild() {
+  std::unique_lock<std::mutex> l(lock_);
+  snapshots_released_.wait(l, [this]() { return !building_in_background_; });
+}
+
 std::vector<absl::Status> SymbolTableHandler::BuildProjectSymbolTable() {
+  const auto l = LockForUpdate();
+  return BuildSymbolTable();
+}
+
+std::vector<absl::Status> SymbolTableHandler::BuildSymbolTable() {
   if (!curr_project_) {
     return {absl::UnavailableError("VerilogProject is not set")};
   }
   ResetSymbolTable();
   ParseProjectFiles();
 
+  // Translation units are built concurrently, and merged in a fixed order.
+  const int threads = std::max(1u, std::thread::hardware_concurrency());
   std::vector<absl::Status> buildstatus;
-  symbol_table_->Build(&buildstatus);
-  symbol_table_->Resolve(&buildstatus);
+  verible::LatencyStats &latencies = verible::PhaseLatencies();
+  latencies.Time("symbol table build",
+                 [&]() { symbol_table_->Build(&buildstatus, threads); });
+  latencies.Time("symbol table resolve",
+                 [&]() { symbol_table_->Resolve(&buildstatus, threads); });
   LogFullIfVLog(buildstatus);
 
   files_dirty_ = false;
+  index_dirty_ = true;
   return buildstatus;
 }
 
+void SymbolTableHandler::UpdateSymbolTable() {
+  if (files_dirty_) {
+    BuildSymbolTable();
+    return;
+  }
+  if (updated_files_.empty()) return;
+
+  const absl::Time start = absl::Now();
+  std::vector<absl::Status> buildstatus;
+  verible::LatencyStats &latencies = verible::PhaseLatencies();
+  latencies.Time("symbol table update", [&]() {
+    for (const std::string &path : updated_files_) {
+      symbol_table_->BuildSingleTranslationUnit(path, &buildstatus);
+    }
+  });
+  // Only binds references that are not bound yet.
+  latencies.Time("symbol table resolve",
+                 [&]() { symbol_table_->Resolve(&buildstatus); });
+  LogFullIfVLog(buildstatus);
+
+  VLOG(1) << "Updated symbol table for " << updated_files_.size()
+          << " files: " << (absl::Now() - start);
+  updated_files_.clear();
+  index_dirty_ = true;
+}
+
+void SymbolTableHandler::UpdateSymbolTableIndex() {
+  UpdateSymbolTable();
+  IndexSymbolTable();
+}
+
+void SymbolTableHandler::IndexSymbolTable() {
+  if (!index_dirty_) return;
+  const absl::Time start = absl::Now();
+  // Snapshots of the previous version keep it until they are released.
+  auto index = std::make_shared<Index>();
+  index->generation = index_->generation + 1;
+  const auto index_reference = [&index](const ReferenceComponent &c) {
+    if (!c.resolved_symbol) return;
+    index->references.push_back({c.identifier, c.resolved_symbol});
+    index->references_to[c.resolved_symbol].push_back(c.identifier);
+  };
+  symbol_table_->Root().ApplyPreOrder([&](const SymbolTableNode &node) {
+    const SymbolInfo &info = node.Value();
+    // Anonymous scopes are named by strings that are not in any file.
+    if (node.Parent() && info.file_origin && info.file_origin->is_parsed() &&
+        info.file_origin->GetTextStructure() &&
+        verible::IsSubRange(*node.Key(),
+                            info.file_origin->GetTextStructure()->Contents())) {
+      index->definitions.push_back(&node);
+      index->definition_names.push_back({*node.Key(), &node});
+    }
+    for (const auto &ref : info.local_references_to_bind) {
+      if (ref.Empty()) continue;
+      verible::ApplyPreOrder(*ref.components, index_reference);
+    }
+  });
+  // Of references to the same identifier, keep the first one found by a scan
+  // of the tree.
+  const auto by_start = [](const IndexedReference &a,
+                           const IndexedReference &b) {
+    return std::less<const char *>()(a.identifier.data(), b.identifier.data());
+  };
+  std::vector<IndexedReference> &references = index->references;
+  std::stable_sort(references.begin(), references.end(), by_start);
+  std::sort(index->definition_names.begin(), index->definition_names.end(),
+            by_start);
+  references.erase(
+      std::unique(references.begin(), references.end(),
+                  [](const IndexedReference &a, const IndexedReference &b) {
+                    return a.identifier.data() == b.identifier.data();
+                  }),
+      references.end());
+  IndexMacros(index.get());
+  index_ = std::move(index);
+  index_dirty_ = false;
+  verible::PhaseLatencies().Record("symbol table index", absl::Now() - start);
+  VLOG(1) << "Indexed " << index_->definitions.size() << " definitions and "
+          << index_->references.size()
+          << " references: " << (absl::Now() - start);
+}
+
+void SymbolTableHandler::IndexMacros(Index *index) {
+  if (!curr_project_) return;
+  // Only keeps the scans of files that are still part of the project.
+  absl::flat_hash_map<const VerilogSourceFile *,
+                      std::shared_ptr<const FileMacros>>
+      file_macros;
+  std::vector<std::shared_ptr<const FileMacros>> files;
+  int scanned = 0;
+  for (const auto &unit : *curr_project_) {
+    const VerilogSourceFile *const file = unit.second.get();
+    const verible::TextStructureView *const text = file->GetTextStructure();
+    if (!text) continue;
+    std::shared_ptr<const FileMacros> &macros = file_macros[file];
+    if (const auto found = file_macros_.find(file);
+        found != file_macros_.end()) {
+      macros = found->second;
+    } else {
+      macros = std::make_shared<const FileMacros>(ScanFileMacros(*text));
+      ++scanned;
+    }
+    files.push_back(macros);
+  }
+  file_macros_ = std::move(file_macros);
+  index->macros = MacroIndex(std::move(files));
+  VLOG(1) << "Scanned " << scanned << " files for macros.";
+}
+
 bool SymbolTableHandler::LoadProjectFileList(absl::string_view current_dir) {
   VLOG(1) << __FUNCTION__;
   if (!curr_project_) return false;
@@ -156,16 +486,35 @@ bool SymbolTableHandler::LoadProjectFileList(absl::string_view current_dir) {
   VLOG(1) << "Resolving " << filelist.file_paths.size() << " files.";
   int actually_opened = 0;
   const absl::Time start = absl::Now();
+  std::vector<std::string> canonicalized_paths;
+  std::vector<bool> newly_added;
+  std::set<std::string> listed;
   for (const auto &file_in_project : filelist.file_paths) {
-    const std::string canonicalized =
+    std::string canonicalized =
         std::filesystem::path(file_in_project).lexically_normal().string();
-    auto source = curr_project_->OpenTranslationUnit(canonicalized);
+    if (!listed.insert(canonicalized).second) continue;
+    newly_added.push_back(curr_project_->LookupRegisteredFile(canonicalized) ==
+                          nullptr);
+    canonicalized_paths.push_back(std::move(canonicalized));
+  }
+  // Reading files one after another is slow on network file systems.
+  const int threads = std::max(1u, std::thread::hardware_concurrency());
+  auto sources =
+      curr_project_->OpenTranslationUnits(canonicalized_paths, threads);
+  for (size_t i = 0; i < canonicalized_paths.size(); ++i) {
+    const std::string &canonicalized = canonicalized_paths[i];
+    auto &source = sources[i];
     if (!source.ok()) source = curr_project_->OpenIncludedFile(canonicalized);
     if (!source.ok()) {
       VLOG(1) << "File included in " << filelist_path_
               << " not found:  " << canonicalized << ":  " << source.status();
       continue;
     }
+    // Files added to the list later only need to be built themselves.
+    if (newly_added[i] && !files_dirty_) {
+      updated_files_.emplace((*source)->ReferencedPath());
+      index_dirty_ = true;
+    }
     ++actually_opened;
   }
 
@@ -174,132 +523,767 @@ bool SymbolTableHandler::LoadProjectFileList(absl::string_view current_dir) {
   return true;
 }
 
-bool IsStringViewContained(absl::string_view origin, absl::string_view substr) {
-  const int from = std::distance(origin.begin(), substr.begin());
-  const int to = std::distance(origin.begin(), substr.end());
-  if (from < 0) return false;
-  if (to > static_cast<int>(origin.length())) return false;
-  return true;
+const SymbolTableHandler::IndexedReference *
+SymbolTableHandler::FindIdentifierAt(
+    const std::vector<IndexedReference> &identifiers, const char *position) {
+  // The last identifier that starts at or before "position".
+  auto found = std::upper_bound(
+      identifiers.begin(), identifiers.end(), position,
+      [](const char *p, const IndexedReference &r) {
+        return std::less<const char *>()(p, r.identifier.data());
+      });
+  if (found == identifiers.begin()) return nullptr;
+  --found;
+  const absl::string_view identifier = found->identifier;
+  if (std::less<const char *>()(identifier.data() + identifier.size(),
+                                position)) {
+    return nullptr;
+  }
+  return &*found;
 }
 
-const SymbolTableNode *ScanReferenceComponents(
-    const ReferenceComponentNode *ref, absl::string_view symbol) {
-  if (IsStringViewContained(ref->Value().identifier, symbol)) {
-    return ref->Value().resolved_symbol;
-  }
-  for (const auto &childref : ref->Children()) {
-    const SymbolTableNode *resolved =
-        ScanReferenceComponents(&childref, symbol);
-    if (resolved) return resolved;
-  }
-  return nullptr;
+const SymbolTableNode *SymbolTableHandler::LookupDefinition(
+    const Index &index, absl::string_view symbol) {
+  const IndexedReference *found = FindReferenceAt(index, symbol.data());
+  if (!found || !verible::IsSubRange(symbol, found->identifier)) return nullptr;
+  return found->definition;
 }
 
-const SymbolTableNode *SymbolTableHandler::ScanSymbolTreeForDefinition(
-    const SymbolTableNode *context, absl::string_view symbol) {
-  if (!context) {
-    return nullptr;
+// Returns the location of "text", which is part of the text of "file".
+static absl::optional<verible::lsp::Location> LocationInFile(
+    const VerilogSourceFile *file, absl::string_view text) {
+  if (!file) {
+    LOG(ERROR) << "Origin file not available";
+    return absl::nullopt;
   }
-  // TODO (glatosinski): reduce searched scope by utilizing information from
-  // syntax tree?
-  for (const auto &ref : context->Value().local_references_to_bind) {
-    if (ref.Empty()) continue;
-    const SymbolTableNode *resolved =
-        ScanReferenceComponents(ref.components.get(), symbol);
-    if (resolved) return resolved;
-  }
-  for (const auto &child : context->Children()) {
-    auto res = ScanSymbolTreeForDefinition(&child.second, symbol);
-    if (res) {
-      return res;
-    }
+  const verible::TextStructureView *textstructure = file->GetTextStructure();
+  if (!textstructure) {
+    LOG(ERROR) << "Origin file's text structure is not parsed";
+    return absl::nullopt;
   }
-  return nullptr;
+  verible::lsp::Location location;
+  location.uri = PathToLSPUri(file->ResolvedPath());
+  const verible::LineColumnRange range =
+      textstructure->GetUtf16RangeForText(text);
+  location.range.start = {.line = range.start.line,
+                          .character = range.start.column};
+  location.range.end = {.line = range.end.line, .character = range.end.column};
+  return location;
 }
 
-std::vector<verible::lsp::Location> SymbolTableHandler::FindDefinitionLocation(
-    const verible::lsp::DefinitionParams &params,
-    const verilog::BufferTrackerContainer &parsed_buffers) {
-  LoadProjectFileList(curr_project_->TranslationUnitRoot());
-  if (files_dirty_) {
-    BuildProjectSymbolTable();
-  }
+// Returns the location of the name of "definition".
+static absl::optional<verible::lsp::Location> DefinitionLocation(
+    const SymbolTableNode &definition) {
+  return LocationInFile(definition.Value().file_origin, *definition.Key());
+}
+
+// Returns the character at "position" in "text", or the end of its line if
+// the line is shorter; nullptr if there is no such line.
+static const char *PositionInText(const verible::TextStructureView &text,
+                                  const verible::lsp::Position &position) {
+  if (position.character < 0) return nullptr;
+  const int offset = text.GetUtf16ColumnMap().OffsetAtLineCol(
+      {position.line, position.character});
+  if (offset < 0) return nullptr;
+  return text.Contents().data() + offset;
+}
+
+const char *SymbolTableHandler::CursorInProjectFile(
+    const verible::lsp::TextDocumentPositionParams &params,
+    const verilog::BufferTrackerContainer &parsed_buffers) const {
+  if (!curr_project_) return nullptr;
   const absl::string_view filepath = LSPUriToPath(params.textDocument.uri);
   if (filepath.empty()) {
     LOG(ERROR) << "Could not convert URI " << params.textDocument.uri
                << " to filesystem path." << std::endl;
-    return {};
+    return nullptr;
   }
   std::string relativepath = curr_project_->GetRelativePathToSource(filepath);
   const verilog::BufferTracker *tracker =
       parsed_buffers.FindBufferTrackerOrNull(params.textDocument.uri);
   if (!tracker) {
     LOG(ERROR) << "Could not find buffer with URI " << params.textDocument.uri;
-    return {};
+    return nullptr;
   }
   const auto parsedbuffer = tracker->current();
   if (!parsedbuffer) {
     LOG(ERROR) << "Buffer not found among opened buffers:  "
                << params.textDocument.uri;
-    return {};
+    return nullptr;
   }
-  const verible::LineColumn cursor{params.position.line,
-                                   params.position.character};
-  const verible::TextStructureView &text = parsedbuffer->parser().Data();
-
-  const verible::TokenInfo cursor_token = text.FindTokenAt(cursor);
-  auto symbol = cursor_token.text();
-  VLOG(1) << "Looking for symbol:  " << symbol;
   auto reffile = curr_project_->LookupRegisteredFile(relativepath);
-  if (!reffile) {
+  if (!reffile || !reffile->GetTextStructure()) {
     LOG(ERROR) << "Unable to lookup " << params.textDocument.uri;
-    return {};
+    return nullptr;
+  }
+  // The cursor refers to the latest version of the buffer, which the symbol
+  // table only knows about if it parsed without errors.
+  const verible::TextStructureView &text = *reffile->GetTextStructure();
+  if (text.Contents().data() !=
+      parsedbuffer->parser().Data().Contents().data()) {
+    VLOG(1) << "Symbol table is not up to date with "
+            << params.textDocument.uri;
+    return nullptr;
   }
+  return PositionInText(text, params.position);
+}
+
+absl::string_view SymbolTableHandler::FindMacroAt(
+    const Snapshot &snapshot,
+    const verible::lsp::TextDocumentPositionParams &params,
+    const verilog::BufferTrackerContainer &parsed_buffers) const {
+  const char *const position = CursorInProjectFile(params, parsed_buffers);
+  if (!position) return {};
+  return snapshot.index_->macros.NameAt(position);
+}
 
-  auto &root = symbol_table_->Root();
+const SymbolTableNode *SymbolTableHandler::FindDefinitionAt(
+    const Snapshot &snapshot,
+    const verible::lsp::TextDocumentPositionParams &params,
+    const verilog::BufferTrackerContainer &parsed_buffers) const {
+  const char *const position = CursorInProjectFile(params, parsed_buffers);
+  if (!position) return nullptr;
+  const IndexedReference *reference =
+      FindReferenceAt(*snapshot.index_, position);
+  if (!reference) {
+    VLOG(1) << "No reference at " << params.position.line << ":"
+            << params.position.character << " in " << params.textDocument.uri;
+    return nullptr;
+  }
+  return reference->definition;
+}
 
-  auto node = ScanSymbolTreeForDefinition(&root, symbol);
-  if (!node) {
-    LOG(INFO) << "Symbol " << symbol << " not found in symbol table:  " << node;
-    return {};
+std::vector<verible::lsp::Location> SymbolTableHandler::FindDefinitionLocation(
+    const verible::lsp::DefinitionParams &params,
+    const verilog::BufferTrackerContainer &parsed_buffers) {
+  const auto snapshot = TakeSnapshot();
+  if (const absl::string_view macro =
+          FindMacroAt(*snapshot, params, parsed_buffers);
+      !macro.empty()) {
+    std::vector<verible::lsp::Location> result;
+    for (const FileMacros::Definition *definition :
+         snapshot->index_->macros.DefinitionsOf(macro)) {
+      if (auto location = LocationInFile(
+              curr_project_->LookupFileOrigin(definition->name),
+              definition->name)) {
+        result.push_back(*location);
+      }
+    }
+    return result;
   }
+  const SymbolTableNode *node =
+      FindDefinitionAt(*snapshot, params, parsed_buffers);
+  if (!node) return {};
   // TODO add iterating over multiple definitions?
-  verible::lsp::Location location;
-  const verilog::SymbolInfo &symbolinfo = node->Value();
-  if (!symbolinfo.file_origin) {
-    LOG(ERROR) << "Origin file not available";
-    return {};
+  const auto location = DefinitionLocation(*node);
+  if (!location) return {};
+  return {*location};
+}
+
+// Returns the declaration of "definition" in short, e.g. its type and name,
+// or the first line of a module.
+static std::string DeclarationSummary(const SymbolTableNode &definition) {
+  const SymbolInfo &info = definition.Value();
+  const absl::string_view name = *definition.Key();
+  if (info.declared_type.syntax_origin) {
+    std::string result =
+        info.metatype == SymbolMetaType::kParameter ? "parameter " : "";
+    const absl::string_view type =
+        verible::StringSpanOfSymbol(*info.declared_type.syntax_origin);
+    if (!type.empty()) absl::StrAppend(&result, type, " ");
+    absl::StrAppend(&result, name);
+    return result;
   }
-  location.uri = PathToLSPUri(symbolinfo.file_origin->ResolvedPath());
-  auto *textstructure = symbolinfo.file_origin->GetTextStructure();
-  if (!textstructure) {
-    LOG(ERROR) << "Origin file's text structure is not parsed";
-    return {};
+  if (info.syntax_origin) {
+    const absl::string_view text =
+        verible::StringSpanOfSymbol(*info.syntax_origin);
+    const absl::string_view first_line =
+        absl::StripTrailingAsciiWhitespace(text.substr(0, text.find('\n')));
+    if (absl::StrContains(first_line, name)) return std::string(first_line);
+  }
+  return std::string(name);
+}
+
+absl::optional<verible::lsp::Hover> SymbolTableHandler::FindHover(
+    const verible::lsp::HoverParams &params,
+    const verilog::BufferTrackerContainer &parsed_buffers) {
+  const auto snapshot = TakeSnapshot();
+  const Index &index = *snapshot->index_;
+  const char *const position = CursorInProjectFile(params, parsed_buffers);
+  if (!position) return absl::nullopt;
+  absl::string_view identifier;
+  std::string summary;
+  if (const absl::string_view macro = index.macros.NameAt(position);
+      !macro.empty()) {
+    // The first line of the first `define, e.g. with the parameters.
+    const auto &definitions = index.macros.DefinitionsOf(macro);
+    if (definitions.empty()) return absl::nullopt;
+    const absl::string_view text = definitions.front()->text;
+    identifier = macro;
+    summary = std::string(
+        absl::StripTrailingAsciiWhitespace(text.substr(0, text.find('\n'))));
+  } else {
+    const IndexedReference *symbol = FindReferenceAt(index, position);
+    if (!symbol) symbol = FindIdentifierAt(index.definition_names, position);
+    if (!symbol) return absl::nullopt;
+    identifier = symbol->identifier;
+    summary = DeclarationSummary(*symbol->definition);
+  }
+  verible::lsp::Hover hover;
+  hover.contents.value = absl::StrCat("```systemverilog\n", summary, "\n```");
+  if (const VerilogSourceFile *file =
+          curr_project_->LookupFileOrigin(identifier);
+      file && file->GetTextStructure()) {
+    const verible::LineColumnRange range =
+        file->GetTextStructure()->GetUtf16RangeForText(identifier);
+    hover.range.start = {.line = range.start.line,
+                         .character = range.start.column};
+    hover.range.end = {.line = range.end.line, .character = range.end.column};
+    hover.has_range = true;
+  }
+  return hover;
+}
+
+void SymbolTableHandler::ForEachSymbolIn(const Snapshot &snapshot,
+                                         absl::string_view text,
+                                         const SymbolFun &fun) {
+  const std::vector<IndexedReference> &references =
+      snapshot.index_->references;
+  const std::vector<IndexedReference> &definition_names =
+      snapshot.index_->definition_names;
+  const auto starts_before = [](const IndexedReference &r, const char *p) {
+    return std::less<const char *>()(r.identifier.data(), p);
+  };
+  auto reference = std::lower_bound(references.begin(), references.end(),
+                                    text.begin(), starts_before);
+  auto name = std::lower_bound(definition_names.begin(), definition_names.end(),
+                               text.begin(), starts_before);
+  const auto in_text = [text](const auto &it, const auto &end) {
+    return it != end && verible::IsSubRange(it->identifier, text);
+  };
+  for (;;) {
+    const bool more_references = in_text(reference, references.end());
+    const bool more_names = in_text(name, definition_names.end());
+    if (!more_references && !more_names) break;
+    if (!more_names || (more_references && std::less<const char *>()(
+                                               reference->identifier.data(),
+                                               name->identifier.data()))) {
+      fun(reference->identifier, *reference->definition, false);
+      ++reference;
+      continue;
+    }
+    // A name that is a reference as well is only reported as definition.
+    if (more_references &&
+        reference->identifier.data() == name->identifier.data()) {
+      ++reference;
+    }
+    fun(name->identifier, *name->definition, true);
+    ++name;
+  }
+}
+
+std::vector<verible::lsp::Location> SymbolTableHandler::FindReferencesLocations(
+    const verible::lsp::ReferenceParams &params,
+    const verilog::BufferTrackerContainer &parsed_buffers) {
+  const auto snapshot = TakeSnapshot();
+  if (const absl::string_view macro =
+          FindMacroAt(*snapshot, params, parsed_buffers);
+      !macro.empty()) {
+    const MacroIndex &macros = snapshot->index_->macros;
+    std::vector<absl::string_view> names;
+    if (params.context.includeDeclaration) {
+      for (const FileMacros::Definition *definition :
+           macros.DefinitionsOf(macro)) {
+        names.push_back(definition->name);
+      }
+    }
+    const std::vector<absl::string_view> &usages = macros.UsagesOf(macro);
+    names.insert(names.end(), usages.begin(), usages.end());
+    std::vector<verible::lsp::Location> result;
+    for (const absl::string_view name : names) {
+      if (auto location =
+              LocationInFile(curr_project_->LookupFileOrigin(name), name)) {
+        result.push_back(*location);
+      }
+    }
+    return result;
+  }
+  const SymbolTableNode *node =
+      FindDefinitionAt(*snapshot, params, parsed_buffers);
+  if (!node) return {};
+  std::vector<verible::lsp::Location> result;
+  if (params.context.includeDeclaration) {
+    if (auto location = DefinitionLocation(*node)) result.push_back(*location);
+  }
+  const auto &references_to = snapshot->index_->references_to;
+  const auto found = references_to.find(node);
+  if (found == references_to.end()) return result;
+  for (const absl::string_view identifier : found->second) {
+    if (auto location = LocationInFile(
+            curr_project_->LookupFileOrigin(identifier), identifier)) {
+      result.push_back(*location);
+    }
   }
-  verible::LineColumnRange symbollocation =
-      textstructure->GetRangeForText(*node->Key());
-  location.range.start = {.line = symbollocation.start.line,
-                          .character = symbollocation.start.column};
-  location.range.end = {.line = symbollocation.end.line,
-                        .character = symbollocation.end.column};
-  return {location};
+  return result;
+}
+
+static bool IsIdentifierChar(char c) {
+  return absl::ascii_isalnum(c) || c == '_' || c == '$';
+}
+
+// Returns whether "name" can be used as is as an identifier, without
+// escaping it.
+static bool IsSimpleIdentifier(absl::string_view name) {
+  return !name.empty() && !absl::ascii_isdigit(name[0]) && name[0] != '$' &&
+         std::all_of(name.begin(), name.end(), IsIdentifierChar);
+}
+
+// Returns the edits that replace each of "names", which are parts of the
+// texts of project files, with "new_name", as the changes of a WorkspaceEdit:
+// by the URI of their file.  The edits of each file are computed in parallel.
+static nlohmann::json RenameEdits(const VerilogProject &project,
+                                  const std::vector<absl::string_view> &names,
+                                  absl::string_view new_name) {
+  // Names by file, with the files in the order they were first seen.
+  std::vector<const VerilogSourceFile *> files;
+  absl::flat_hash_map<const VerilogSourceFile *,
+                      std::vector<absl::string_view>>
+      names_in_file;
+  for (const absl::string_view name : names) {
+    const VerilogSourceFile *const file = project.LookupFileOrigin(name);
+    if (!file || !file->GetTextStructure()) continue;
+    std::vector<absl::string_view> &in_file = names_in_file[file];
+    if (in_file.empty()) files.push_back(file);
+    in_file.push_back(name);
+  }
+
+  const int threads = std::min<int>(
+      files.size(), std::max(1u, std::thread::hardware_concurrency()));
+  verible::ThreadPool pool(threads > 1 ? threads : 0);
+  const std::vector<std::vector<verible::lsp::TextEdit>> edits =
+      pool.ParallelMap(files, [&](const VerilogSourceFile *file) {
+        std::vector<absl::string_view> in_file = names_in_file.at(file);
+        // Edits must not overlap: each position once.
+        const auto by_start = [](absl::string_view a, absl::string_view b) {
+          return std::less<const char *>()(a.data(), b.data());
+        };
+        std::sort(in_file.begin(), in_file.end(), by_start);
+        in_file.erase(std::unique(in_file.begin(), in_file.end(),
+                                  [](absl::string_view a, absl::string_view b) {
+                                    return a.data() == b.data();
+                                  }),
+                      in_file.end());
+        const verible::TextStructureView &text = *file->GetTextStructure();
+        std::vector<verible::lsp::TextEdit> result;
+        result.reserve(in_file.size());
+        for (const absl::string_view name : in_file) {
+          const verible::LineColumnRange range =
+              text.GetUtf16RangeForText(name);
+          result.push_back(verible::lsp::TextEdit{
+              .range = {.start = {.line = range.start.line,
+                                  .character = range.start.column},
+                        .end = {.line = range.end.line,
+                                .character = range.end.column}},
+              .newText = std::string(new_name),
+          });
+        }
+        return result;
+      });
+
+  nlohmann::json changes = nlohmann::json::object();
+  for (size_t i = 0; i < files.size(); ++i) {
+    changes[PathToLSPUri(files[i]->ResolvedPath())] = edits[i];
+  }
+  return changes;
+}
+
+absl::StatusOr<verible::lsp::WorkspaceEdit> SymbolTableHandler::FindRenameEdits(
+    const verible::lsp::RenameParams &params,
+    const verilog::BufferTrackerContainer &parsed_buffers) {
+  const auto snapshot = TakeSnapshot();
+  const Index &index = *snapshot->index_;
+  const char *const position = CursorInProjectFile(params, parsed_buffers);
+  if (!position) return absl::NotFoundError("No symbol at the cursor.");
+  const absl::string_view new_name = params.newName;
+  if (!IsSimpleIdentifier(new_name)) {
+    return absl::InvalidArgumentError(
+        absl::StrCat("\"", new_name, "\" is not an identifier."));
+  }
+
+  std::vector<absl::string_view> names;
+  if (const absl::string_view macro = index.macros.NameAt(position);
+      !macro.empty()) {
+    const auto &definitions = index.macros.DefinitionsOf(macro);
+    if (definitions.empty()) {
+      return absl::FailedPreconditionError(absl::StrCat(
+          "Macro `", macro, " is not defined in the project files."));
+    }
+    if (!index.macros.DefinitionsOf(new_name).empty()) {
+      return absl::InvalidArgumentError(
+          absl::StrCat("Macro `", new_name, " is already defined."));
+    }
+    for (const FileMacros::Definition *definition : definitions) {
+      names.push_back(definition->name);
+    }
+    const std::vector<absl::string_view> &usages = index.macros.UsagesOf(macro);
+    names.insert(names.end(), usages.begin(), usages.end());
+  } else {
+    const IndexedReference *symbol = FindReferenceAt(index, position);
+    if (!symbol) symbol = FindIdentifierAt(index.definition_names, position);
+    if (!symbol) return absl::NotFoundError("No symbol at the cursor.");
+    const SymbolTableNode &definition = *symbol->definition;
+    const absl::string_view name = *definition.Key();
+    if (!curr_project_->LookupFileOrigin(name)) {
+      return absl::FailedPreconditionError(absl::StrCat(
+          "\"", name, "\" is not defined in the project files."));
+    }
+    // The members of a scope are indexed by name.
+    if (const SymbolTableNode *scope = definition.Parent();
+        scope && scope->Find(new_name) != scope->end()) {
+      return absl::InvalidArgumentError(absl::StrCat(
+          "\"", new_name, "\" is already defined in the same scope."));
+    }
+    names.push_back(name);
+    const auto found = index.references_to.find(&definition);
+    if (found != index.references_to.end()) {
+      names.insert(names.end(), found->second.begin(), found->second.end());
+    }
+  }
+
+  const absl::Time start = absl::Now();
+  verible::lsp::WorkspaceEdit edit;
+  edit.changes = RenameEdits(*curr_project_, names, new_name);
+  VLOG(1) << "Renamed " << names.size() << " occurrences in "
+          << edit.changes.size() << " files: " << (absl::Now() - start);
+  return edit;
+}
+
+// Returns how to present a symbol of "metatype" to the client.
+static verible::lsp::SymbolKind SymbolKindOf(SymbolMetaType metatype) {
+  switch (metatype) {
+    case SymbolMetaType::kModule:
+      return verible::lsp::SymbolKind::kModule;
+    case SymbolMetaType::kPackage:
+      return verible::lsp::SymbolKind::kPackage;
+    case SymbolMetaType::kClass:
+      return verible::lsp::SymbolKind::kClass;
+    case SymbolMetaType::kInterface:
+      return verible::lsp::SymbolKind::kInterface;
+    case SymbolMetaType::kFunction:
+    case SymbolMetaType::kTask:
+      return verible::lsp::SymbolKind::kFunction;
+    case SymbolMetaType::kParameter:
+      return verible::lsp::SymbolKind::kConstant;
+    case SymbolMetaType::kTypeAlias:
+      return verible::lsp::SymbolKind::kTypeParameter;
+    case SymbolMetaType::kStruct:
+      return verible::lsp::SymbolKind::kStruct;
+    case SymbolMetaType::kEnumType:
+      return verible::lsp::SymbolKind::kEnum;
+    case SymbolMetaType::kEnumConstant:
+      return verible::lsp::SymbolKind::kEnumMember;
+    case SymbolMetaType::kGenerate:
+      return verible::lsp::SymbolKind::kNamespace;
+    default:
+      return verible::lsp::SymbolKind::kVariable;
+  }
+}
+
+std::vector<verible::lsp::SymbolInformation>
+SymbolTableHandler::FindWorkspaceSymbols(absl::string_view query) {
+  const auto snapshot = TakeSnapshot();
+  std::vector<verible::lsp::SymbolInformation> result;
+  for (const SymbolTableNode *definition : snapshot->index_->definitions) {
+    const absl::string_view name = *definition->Key();
+    const bool matches =
+        std::search(name.begin(), name.end(), query.begin(), query.end(),
+                    [](char a, char b) {
+                      return absl::ascii_tolower(a) == absl::ascii_tolower(b);
+                    }) != name.end();
+    if (!matches) continue;
+    const auto location = DefinitionLocation(*definition);
+    if (!location) continue;
+    result.push_back({
+        .name = std::string(name),
+        .kind = SymbolKindOf(definition->Value().metatype),
+        .location = *location,
+    });
+  }
+  return result;
+}
+
+static verible::lsp::CompletionItemKind CompletionKindOf(
+    SymbolMetaType metatype) {
+  switch (metatype) {
+    case SymbolMetaType::kModule:
+    case SymbolMetaType::kPackage:
+      return verible::lsp::CompletionItemKind::kCompletionModule;
+    case SymbolMetaType::kClass:
+      return verible::lsp::CompletionItemKind::kCompletionClass;
+    case SymbolMetaType::kInterface:
+      return verible::lsp::CompletionItemKind::kCompletionInterface;
+    case SymbolMetaType::kFunction:
+    case SymbolMetaType::kTask:
+      return verible::lsp::CompletionItemKind::kCompletionFunction;
+    case SymbolMetaType::kParameter:
+      return verible::lsp::CompletionItemKind::kCompletionConstant;
+    case SymbolMetaType::kTypeAlias:
+      return verible::lsp::CompletionItemKind::kCompletionTypeParameter;
+    case SymbolMetaType::kStruct:
+      return verible::lsp::CompletionItemKind::kCompletionStruct;
+    case SymbolMetaType::kEnumType:
+      return verible::lsp::CompletionItemKind::kCompletionEnum;
+    case SymbolMetaType::kEnumConstant:
+      return verible::lsp::CompletionItemKind::kCompletionEnumMember;
+    default:
+      return verible::lsp::CompletionItemKind::kCompletionVariable;
+  }
+}
+
+// Most completion items returned; editors ask again while typing on.
+static constexpr size_t kMaxCompletionItems = 100;
+
+namespace {
+struct CompletionCandidate {
+  absl::string_view name;
+  const SymbolTableNode *definition;
+  int distance;  // Number of scopes out from the cursor.
+};
+}  // namespace
+
+// Returns the innermost scope of the symbol table defined in "file" that
+// contains "position", or "root".
+static const SymbolTableNode *ScopeAt(const SymbolTableNode &root,
+                                      const VerilogSourceFile *file,
+                                      const char *position) {
+  const SymbolTableNode *scope = &root;
+  for (;;) {
+    const SymbolTableNode *inner = nullptr;
+    for (const auto &member : scope->Children()) {
+      const SymbolInfo &info = member.second.Value();
+      if (info.file_origin != file || !info.syntax_origin ||
+          member.second.is_leaf()) {
+        continue;
+      }
+      if (verible::IsSubRange(
+              absl::string_view(position, 0),
+              verible::StringSpanOfSymbol(*info.syntax_origin))) {
+        inner = &member.second;
+        break;
+      }
+    }
+    if (!inner) return scope;
+    scope = inner;
+  }
+}
+
+// Appends the members of "scope" whose names start with "prefix", including
+// the constants of anonymous enum types, which are visible in it.
+static void AppendMembersWithPrefix(
+    const SymbolTableNode &scope, absl::string_view prefix, int distance,
+    std::vector<CompletionCandidate> *candidates) {
+  const auto &members = scope.Children();
+  // Members are ordered by name, so those with the prefix are adjacent.
+  for (auto it = members.lower_bound(prefix);
+       it != members.end() && absl::StartsWith(it->first, prefix); ++it) {
+    if (absl::StartsWith(it->first, "%")) continue;  // Anonymous.
+    candidates->push_back({it->first, &it->second, distance});
+  }
+  // Names of anonymous scopes start with '%', which sorts before letters.
+  for (auto it = members.begin();
+       it != members.end() && absl::StartsWith(it->first, "%"); ++it) {
+    if (it->second.Value().metatype == SymbolMetaType::kEnumType) {
+      AppendMembersWithPrefix(it->second, prefix, distance, candidates);
+    }
+  }
+}
+
+verible::lsp::CompletionList SymbolTableHandler::FindCompletions(
+    const verible::lsp::CompletionParams &params,
+    const verilog::BufferTrackerContainer &parsed_buffers) {
+  verible::lsp::CompletionList result;
+  const auto snapshot = TakeSnapshot();
+  if (!curr_project_) return result;
+  const verilog::BufferTracker *tracker =
+      parsed_buffers.FindBufferTrackerOrNull(params.textDocument.uri);
+  if (!tracker || !tracker->current()) return result;
+
+  // The text being typed usually does not parse, so the prefix is taken from
+  // the current version of the buffer ...
+  const verible::TextStructureView &current =
+      tracker->current()->parser().Data();
+  const char *const cursor = PositionInText(current, params.position);
+  if (!cursor) return result;
+  const absl::string_view before =
+      current.Contents().substr(0, cursor - current.Contents().data());
+  size_t start = before.size();
+  while (start > 0 && IsIdentifierChar(before[start - 1])) --start;
+  const absl::string_view prefix = before.substr(start);
+  if (!prefix.empty() && absl::ascii_isdigit(prefix[0])) return result;
+  absl::string_view qualifier;
+  if (absl::EndsWith(before.substr(0, start), "::")) {
+    size_t qualifier_start = start - 2;
+    while (qualifier_start > 0 &&
+           IsIdentifierChar(before[qualifier_start - 1])) {
+      --qualifier_start;
+    }
+    qualifier = before.substr(qualifier_start, start - 2 - qualifier_start);
+    if (qualifier.empty()) return result;
+  } else if (prefix.empty() && absl::EndsWith(before, ":")) {
+    return result;  // E.g. a label, or typing the first ':' of "::".
+  }
+
+  // ... and the scope from the version the symbol table was built from, which
+  // is close enough, as lines around the cursor rarely move much.
+  const SymbolTableNode &root = symbol_table_->Root();
+  const SymbolTableNode *scope = &root;
+  const VerilogSourceFile *const file = curr_project_->LookupRegisteredFile(
+      curr_project_->GetRelativePathToSource(
+          LSPUriToPath(params.textDocument.uri)));
+  const verible::TextStructureView *const built_text =
+      file ? file->GetTextStructure() : nullptr;
+  if (built_text) {
+    const char *const position = PositionInText(*built_text, params.position);
+    if (position) scope = ScopeAt(root, file, position);
+  }
+
+  std::vector<CompletionCandidate> candidates;
+  if (!qualifier.empty()) {
+    for (const SymbolTableNode *outer = scope; outer; outer = outer->Parent()) {
+      const auto found = outer->Children().find(qualifier);
+      if (found == outer->Children().end()) continue;
+      AppendMembersWithPrefix(found->second, prefix, 0, &candidates);
+      break;
+    }
+  } else {
+    int distance = 0;
+    for (const SymbolTableNode *outer = scope; outer; outer = outer->Parent()) {
+      AppendMembersWithPrefix(*outer, prefix, distance++, &candidates);
+    }
+    if (built_text && built_text->SyntaxTree()) {
+      for (const auto &import :
+           FindAllPackageImportItems(*built_text->SyntaxTree())) {
+        const verible::SyntaxTreeLeaf *const package =
+            GetImportedPackageName(*import.match);
+        if (!package ||
+            GeImportedItemNameFromPackageImportItem(*import.match)) {
+          continue;  // Not a wildcard import.
+        }
+        const auto found = root.Children().find(package->get().text());
+        if (found == root.Children().end()) continue;
+        AppendMembersWithPrefix(found->second, prefix, distance, &candidates);
+      }
+    }
+  }
+
+  // Inner definitions hide outer ones of the same name.
+  absl::flat_hash_set<absl::string_view> seen;
+  candidates.erase(std::remove_if(candidates.begin(), candidates.end(),
+                                  [&seen](const CompletionCandidate &c) {
+                                    return !seen.insert(c.name).second;
+                                  }),
+                   candidates.end());
+  // Closest scope first, then the shortest names, i.e. an exact match.
+  const auto by_rank = [](const CompletionCandidate &a,
+                          const CompletionCandidate &b) {
+    if (a.distance != b.distance) return a.distance < b.distance;
+    if (a.name.size() != b.name.size()) return a.name.size() < b.name.size();
+    return a.name < b.name;
+  };
+  const size_t count = std::min(candidates.size(), kMaxCompletionItems);
+  std::partial_sort(candidates.begin(), candidates.begin() + count,
+                    candidates.end(), by_rank);
+  result.isIncomplete = candidates.size() > count;
+  for (size_t i = 0; i < count; ++i) {
+    const CompletionCandidate &candidate = candidates[i];
+    result.items.push_back({
+        .label = std::string(candidate.name),
+        .kind = CompletionKindOf(candidate.definition->Value().metatype),
+        .detail = DeclarationSummary(*candidate.definition),
+        .has_detail = true,
+        .sortText = absl::StrCat(absl::Dec(i, absl::kZeroPad4)),
+    });
+  }
+  return result;
+}
+
+std::vector<std::string> SymbolTableHandler::ProjectFilePaths() {
+  const auto l = LockForUpdate();
+  if (!curr_project_) return {};
+  LoadProjectFileList(curr_project_->TranslationUnitRoot());
+  std::vector<std::string> result;
+  for (const auto &file : *curr_project_) {
+    // Files that could not be found are registered without a path.
+    const absl::string_view path = file.second->ResolvedPath();
+    if (!path.empty()) result.emplace_back(path);
+  }
+  return result;
 }
 
 const verible::Symbol *SymbolTableHandler::FindDefinitionSymbol(
     absl::string_view symbol) {
-  if (files_dirty_) {
-    BuildProjectSymbolTable();
-  }
-  auto symbol_table_node =
-      ScanSymbolTreeForDefinition(&symbol_table_->Root(), symbol);
+  const auto snapshot = TakeSnapshot();
+  const SymbolTableNode *symbol_table_node =
+      LookupDefinition(*snapshot->index_, symbol);
   if (symbol_table_node) return symbol_table_node->Value().syntax_origin;
   return nullptr;
 }
 
 void SymbolTableHandler::UpdateFileContent(
-    absl::string_view path, const verible::TextStructureView *content) {
-  files_dirty_ = true;
-  curr_project_->UpdateFileContents(path, content);
+    absl::string_view path,
+    std::shared_ptr<const verible::TextStructureView> content) {
+  std::unique_lock<std::mutex> l(lock_);
+  snapshots_released_.wait(l, [this]() {
+    return snapshots_ == 0 || building_in_background_;
+  });
+  if (building_in_background_) {
+    // Replacing a file might race with parsing it.
+    pending_contents_[std::string(path)] = std::move(content);
+    return;
+  }
+  ReplaceFileContent(path, std::move(content));
+}
+
+void SymbolTableHandler::ReplaceFileContent(
+    absl::string_view path,
+    std::shared_ptr<const verible::TextStructureView> content) {
+  if (!files_dirty_) {
+    const std::string project_path =
+        curr_project_->GetRelativePathToSource(path);
+    // The symbols of the previous content have to be removed before the
+    // file is replaced.  Files that were already removed are not built yet.
+    const VerilogSourceFile *previous =
+        curr_project_->LookupRegisteredFile(project_path);
+    if (previous != nullptr && !updated_files_.count(project_path)) {
+      if (const absl::Status status =
+              symbol_table_->RemoveTranslationUnit(*previous);
+          !status.ok()) {
+        VLOG(1) << "Rebuilding the whole symbol table: " << status;
+        files_dirty_ = true;
+      }
+    }
+    updated_files_.insert(project_path);
+  }
+  index_dirty_ = true;  // Refers to the previous content.
+  file_macros_.erase(curr_project_->LookupRegisteredFile(
+      curr_project_->GetRelativePathToSource(path)));
+  curr_project_->UpdateFileContents(path, std::move(content));
+}
+
+void SymbolTableHandler::UpdateFilesChangedOnDisk(
+    const std::vector<std::string> &paths) {
+  const auto l = LockForUpdate();
+  if (!curr_project_) return;
+  for (const std::string &path : paths) {
+    const std::string project_path =
+        curr_project_->GetRelativePathToSource(path);
+    if (curr_project_->LookupRegisteredFile(project_path) == nullptr) {
+      continue;  // Not part of the project.
+    }
+    VLOG(1) << "File changed on disk: " << path;
+    ReplaceFileContent(path, nullptr);
+  }
+  LoadProjectFileList(curr_project_->TranslationUnitRoot());
 }
 
 };  // namespace verilog
@@ -16,31 +16,91 @@
 #ifndef VERILOG_TOOLS_LS_SYMBOL_TABLE_HANDLER_H
 #define VERILOG_TOOLS_LS_SYMBOL_TABLE_HANDLER_H
 
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
 #include <filesystem>
+#include <functional>
+#include <map>
 #include <memory>
+#include <mutex>
+#include <set>
+#include <string>
+#include <thread>
 #include <vector>
 
+#include "absl/container/flat_hash_map.h"
 #include "absl/container/flat_hash_set.h"
+#include "absl/status/statusor.h"
 #include "absl/strings/string_view.h"
 #include "absl/types/optional.h"
 #include "common/lsp/lsp-protocol.h"
+#include "common/text/symbol.h"
+#include "common/text/text_structure.h"
 #include "verilog/analysis/symbol_table.h"
 #include "verilog/analysis/verilog_project.h"
 #include "verilog/tools/ls/lsp-parse-buffer.h"
+#include "verilog/tools/ls/macro-index.h"
 
 namespace verilog {
 
 // Looks for FileList file for SymbolTableHandler
 std::string FindFileList(absl::string_view current_dir);
 
+// Returns the names of the definitions in other files that the syntax tree
+// "root" most likely refers to: the types of instances and data, imported
+// packages, and the scopes of qualified identifiers, each once.
+std::vector<absl::string_view> ReferencedDefinitionNames(
+    const verible::Symbol &root);
+
 // A class interfacing the SymbolTable with the LSP messages.
 // It manages the SymbolTable and its necessary components,
 // and provides such information as symbol definitions
 // based on LSP requests.
 // The provided information is in LSP-friendly format.
+// Its methods may be called on several threads at once: lookups read a
+// snapshot of the symbol table (see TakeSnapshot()), and changes wait until
+// no snapshots are held.
 class SymbolTableHandler {
+ private:
+  struct Index;
+
  public:
   SymbolTableHandler() = default;
+  SymbolTableHandler(const SymbolTableHandler &) = delete;
+
+  // Stops parsing the project files in the background (see Prefetch()).
+  ~SymbolTableHandler();
+
+  // A consistent version of the symbol table and its index, which requests
+  // share, possibly on several threads at once.  While any snapshot is held,
+  // the symbol table and the project files are not changed: the methods
+  // changing them wait until all snapshots are released.
+  class Snapshot {
+   public:
+    Snapshot(const Snapshot &) = delete;
+    Snapshot &operator=(const Snapshot &) = delete;
+    ~Snapshot();
+
+    // Number that changes whenever the symbol table did change. Results
+    // derived from the symbol table, and from the syntax trees of the project
+    // files, stay valid while it is the same.
+    int64_t generation() const;
+
+   private:
+    friend class SymbolTableHandler;
+
+    Snapshot(SymbolTableHandler *handler, std::shared_ptr<const Index> index)
+        : handler_(handler), index_(std::move(index)) {}
+
+    SymbolTableHandler *const handler_;
+    const std::shared_ptr<const Index> index_;
+  };
+
+  // Brings the symbol table up to date, and returns a snapshot of it.
+  // If other snapshots are held, their version is shared instead, so a thread
+  // holding a snapshot can take more, but must not change the symbol table.
+  std::shared_ptr<const Snapshot> TakeSnapshot();
 
   // Sets the project for the symbol table.
   // VerilogProject requires root, include_paths and corpus to
@@ -50,31 +110,202 @@ class SymbolTableHandler {
 
   // Finds the definition for a symbol provided in the DefinitionParams
   // message delivered i.e. in textDocument/definition message.
-  // Provides a list of locations with symbol's definitions.
+  // Provides a list of locations with symbol's definitions; for a macro
+  // usage, those of all its `define's in the project files.
   std::vector<verible::lsp::Location> FindDefinitionLocation(
       const verible::lsp::DefinitionParams &params,
       const verilog::BufferTrackerContainer &parsed_buffers);
 
-  // Finds the symbol of the definition for the given identifier.
+  // Describes the definition of the symbol under the cursor, or that is
+  // defined there, as requested in the textDocument/hover message.
+  absl::optional<verible::lsp::Hover> FindHover(
+      const verible::lsp::HoverParams &params,
+      const verilog::BufferTrackerContainer &parsed_buffers);
+
+  // Calls "fun" for each identifier within "text" that names a definition
+  // ("is_definition"), or refers to one in "snapshot", in the order of their
+  // position.  "text" is part of the text of a project file, e.g. the last
+  // good parse of an open buffer (see SharedTextStructure()).
+  using SymbolFun = std::function<void(absl::string_view identifier,
+                                       const SymbolTableNode &definition,
+                                       bool is_definition)>;
+  static void ForEachSymbolIn(const Snapshot &snapshot, absl::string_view text,
+                              const SymbolFun &fun);
+
+  // Finds the symbol of the definition for the given identifier; it stays
+  // valid while a snapshot is held.
   const verible::Symbol *FindDefinitionSymbol(absl::string_view symbol);
 
-  // Provide new parsed content for the given path. If "content" is nullptr,
-  // opens the given file instead.
-  void UpdateFileContent(absl::string_view path,
-                         const verible::TextStructureView *content);
+  // Finds the references to the symbol at the position provided in the
+  // ReferenceParams, i.e. in the textDocument/references message, and its
+  // definition if requested.  At a macro name, finds the usages of the macro
+  // in the project files, and its `define's.
+  std::vector<verible::lsp::Location> FindReferencesLocations(
+      const verible::lsp::ReferenceParams &params,
+      const verilog::BufferTrackerContainer &parsed_buffers);
+
+  // Computes the edits that rename the symbol at the cursor to
+  // "params.newName", as requested in the textDocument/rename message: its
+  // definition and all references resolved to it, or the `define's and
+  // usages of a macro, in all project files.  The edits of each file are
+  // computed in parallel.
+  // Returns NotFoundError if there is nothing to rename at the cursor, and
+  // another error if the new name is no simple identifier, or if it is
+  // already defined in the scope of the definition.
+  absl::StatusOr<verible::lsp::WorkspaceEdit> FindRenameEdits(
+      const verible::lsp::RenameParams &params,
+      const verilog::BufferTrackerContainer &parsed_buffers);
+
+  // Finds the named definitions in the project that contain "query" in their
+  // name, as requested in the workspace/symbol message. An empty query
+  // matches all of them.
+  std::vector<verible::lsp::SymbolInformation> FindWorkspaceSymbols(
+      absl::string_view query);
+
+  // Lists the symbols visible at the cursor whose names start with the
+  // identifier before it, as requested in the textDocument/completion
+  // message: those of the enclosing scopes, innermost first, then those of
+  // packages imported with a wildcard; after "scope::", those of that scope.
+  // The scopes of the symbol table keep their members ordered by name, so
+  // that each scope is searched in logarithmic time.
+  verible::lsp::CompletionList FindCompletions(
+      const verible::lsp::CompletionParams &params,
+      const verilog::BufferTrackerContainer &parsed_buffers);
+
+  // Returns the resolved paths of the files in the project, which include
+  // those of the file list, after loading it again if it changed.
+  std::vector<std::string> ProjectFilePaths();
+
+  // Provide new parsed content for the given path, which the project shares
+  // (see SharedTextStructure()). If "content" is nullptr, opens the given file
+  // instead.
+  // The symbols of the previous content are removed from the symbol table
+  // right away, so that only this file needs to be built again on the next
+  // lookup, unless they are mixed with those of other files.
+  void UpdateFileContent(
+      absl::string_view path,
+      std::shared_ptr<const verible::TextStructureView> content);
+
+  // Reads the project files at "paths" again, after they changed on disk,
+  // so that only their symbols are built again on the next lookup, like with
+  // UpdateFileContent().  Paths of files that are not part of the project are
+  // ignored.  Files that were added to a changed file list are built as
+  // well; those removed from it stay part of the project.
+  void UpdateFilesChangedOnDisk(const std::vector<std::string> &paths);
 
   // Creates a symbol table for entire project (public: needed in unit-test)
   std::vector<absl::Status> BuildProjectSymbolTable();
 
+  // Makes the first lookups from the file at "path", which was just opened,
+  // fast, if the symbol table of the project is not built yet: builds one of
+  // only that file and the project files that it refers to right away, which
+  // lookups use meanwhile, and the one of the whole project on a thread of its
+  // own.  Project files are assumed to be named after what they define, e.g.
+  // "pkg.sv" or "pkg.svh" for package "pkg" (see ReferencedDefinitionNames());
+  // included files are opened anyway.
+  // While the other project files are parsed in the background, updates of
+  // file contents are applied after that, and other changes wait.
+  void Prefetch(absl::string_view path);
+
+  // Waits until the symbol table of the whole project started by Prefetch()
+  // is built.
+  void WaitForBackgroundBuild();
+
  private:
+  // Waits until no snapshots are held, and returns the lock to hold while
+  // changing the symbol table or the project.
+  std::unique_lock<std::mutex> LockForUpdate();
+
+  // Same as BuildProjectSymbolTable(), with the lock held.
+  std::vector<absl::Status> BuildSymbolTable();
+
+  // Same as UpdateFileContent(), with the lock held.
+  void ReplaceFileContent(
+      absl::string_view path,
+      std::shared_ptr<const verible::TextStructureView> content);
+
   // Creates a new symbol table given the VerilogProject in setProject
   // method.
   void ResetSymbolTable();
 
-  // Scans the symbol table tree to find a given symbol.
-  // returns pointer to table node with the symbol on success, else nullptr.
-  const SymbolTableNode *ScanSymbolTreeForDefinition(
-      const SymbolTableNode *context, absl::string_view symbol);
+  // Brings the symbol table up to date with the project, by building only
+  // the updated files, or the whole symbol table if needed.
+  void UpdateSymbolTable();
+
+  // Brings the symbol table and its index up to date.
+  void UpdateSymbolTableIndex();
+
+  // Builds the index of the symbol table as it is, if it changed.
+  void IndexSymbolTable();
+
+  // Indexes the macros of the project files into "index", scanning only the
+  // files that changed since the last time.
+  void IndexMacros(Index *index);
+
+  // Resolved reference in the text of a file.
+  struct IndexedReference {
+    absl::string_view identifier;
+    const SymbolTableNode *definition;
+  };
+
+  // Index of the symbol table, built with one walk over it whenever it
+  // changed, instead of walking it on each lookup.  Each version is immutable
+  // once published, and shared by the snapshots that refer to it.
+  struct Index {
+    int64_t generation = 0;  // Number of times it was built.
+    // Resolved references in the text of all files, sorted by the start of
+    // their identifier, which don't overlap.
+    std::vector<IndexedReference> references;
+    // Identifiers of the resolved references to each definition, in the order
+    // of the symbol table.
+    absl::flat_hash_map<const SymbolTableNode *,
+                        std::vector<absl::string_view>>
+        references_to;
+    // Definitions with a name in the text of their file.
+    std::vector<const SymbolTableNode *> definitions;
+    // Names of the definitions, sorted like references.
+    std::vector<IndexedReference> definition_names;
+    // Macro definitions and usages in the text of all files.
+    MacroIndex macros;
+  };
+
+  // Finds the reference whose identifier contains "position", or ends right
+  // before it; returns nullptr if there is none.  O(log n).
+  static const IndexedReference *FindReferenceAt(const Index &index,
+                                                 const char *position) {
+    return FindIdentifierAt(index.references, position);
+  }
+
+  // Same, among "identifiers" sorted like Index::references.
+  static const IndexedReference *FindIdentifierAt(
+      const std::vector<IndexedReference> &identifiers, const char *position);
+
+  // Finds the definition of the reference whose identifier contains the
+  // given symbol; returns nullptr if there is none.
+  static const SymbolTableNode *LookupDefinition(const Index &index,
+                                                 absl::string_view symbol);
+
+  // Finds the definition of the symbol under the cursor, in the text of the
+  // file that the symbol table of "snapshot" was built from.
+  const SymbolTableNode *FindDefinitionAt(
+      const Snapshot &snapshot,
+      const verible::lsp::TextDocumentPositionParams &params,
+      const verilog::BufferTrackerContainer &parsed_buffers) const;
+
+  // Returns the name of the macro defined or used under the cursor, in the
+  // text of the file that the index of "snapshot" was built from; empty if
+  // there is none.
+  absl::string_view FindMacroAt(
+      const Snapshot &snapshot,
+      const verible::lsp::TextDocumentPositionParams &params,
+      const verilog::BufferTrackerContainer &parsed_buffers) const;
+
+  // Returns the character under the cursor in the text of the file that the
+  // symbol table was built from, or nullptr if that is not the current
+  // version of the buffer.  Only valid while a snapshot is held.
+  const char *CursorInProjectFile(
+      const verible::lsp::TextDocumentPositionParams &params,
+      const verilog::BufferTrackerContainer &parsed_buffers) const;
 
   // Looks for verible.filelist file down in directory structure and loads data
   // to project.
@@ -84,6 +315,18 @@ class SymbolTableHandler {
   // Parse all the files in the project.
   void ParseProjectFiles();
 
+  // Returns the project files that are not parsed yet.
+  std::vector<VerilogSourceFile *> UnparsedProjectFiles();
+
+  // Returns the project files named after any of "names" (see Prefetch()).
+  std::vector<VerilogSourceFile *> FilesNamedAfter(
+      const std::vector<absl::string_view> &names);
+
+  // Parses "unparsed_files" without the lock held, then builds the symbol
+  // table of the whole project with it.
+  void BuildInBackground(
+      const std::vector<VerilogSourceFile *> &unparsed_files);
+
   // Path to the filelist file for the project
   std::string filelist_path_;
 
@@ -94,9 +337,38 @@ class SymbolTableHandler {
   // tells that symbol table should be rebuilt due to changes in files
   bool files_dirty_ = true;
 
+  // Files that were removed from the symbol table after their content was
+  // updated, and that need to be built again.
+  std::set<std::string> updated_files_;
+
   // current VerilogProject for which the symbol table is created
   std::shared_ptr<VerilogProject> curr_project_;
   std::unique_ptr<SymbolTable> symbol_table_;
+
+  // Latest version of the index; replaced as a whole when it is built again.
+  bool index_dirty_ = true;
+  std::shared_ptr<const Index> index_ = std::make_shared<Index>();
+  // Macros of each project file, as of its current content: dropped when the
+  // file is replaced.
+  absl::flat_hash_map<const VerilogSourceFile *,
+                      std::shared_ptr<const FileMacros>>
+      file_macros_;
+
+  // Held while changing the symbol table, or taking and releasing snapshots.
+  std::mutex lock_;
+  // Notified when all snapshots are released, or the build in the background
+  // is done.
+  std::condition_variable snapshots_released_;
+  int snapshots_ = 0;  // Number of snapshots held.
+
+  // Set while background_build_ parses the project files, which the project
+  // must not change meanwhile; the symbol table stays that of Prefetch().
+  bool building_in_background_ = false;
+  // Contents passed to UpdateFileContent() meanwhile, by path.
+  std::map<std::string, std::shared_ptr<const verible::TextStructureView>>
+      pending_contents_;
+  std::atomic<bool> stopping_ = false;  // Set on destruction.
+  std::thread background_build_;
 };
 
 };  // namespace verilog
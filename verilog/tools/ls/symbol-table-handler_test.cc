@@ -14,11 +14,24 @@
 
 #include "verilog/tools/ls/symbol-table-handler.h"
 
+#include <algorithm>
+#include <chrono>
+#include <filesystem>
 #include <memory>
+#include <string>
+#include <thread>
+#include <vector>
 
+#include "absl/strings/str_cat.h"
 #include "absl/strings/string_view.h"
+#include "common/lsp/lsp-file-utils.h"
+#include "common/lsp/lsp-protocol-enums.h"
+#include "common/lsp/lsp-text-buffer.h"
+#include "common/text/tree_utils.h"
 #include "common/util/file_util.h"
+#include "common/util/range.h"
 #include "gtest/gtest.h"
+#include "verilog/analysis/verilog_analyzer.h"
 #include "verilog/analysis/verilog_project.h"
 
 namespace verilog {
@@ -210,6 +223,616 @@ TEST(SymbolTableHandlerTest, DefinitionNotTrackedFile) {
   EXPECT_EQ(location.size(), 0);
 }
 
+TEST(SymbolTableHandlerTest, ParsesAllProjectFiles) {
+  const auto tempdir = ::testing::TempDir();
+  const std::string sources_dir =
+      verible::file::JoinPath(tempdir, __FUNCTION__);
+  ASSERT_TRUE(verible::file::CreateDir(sources_dir).ok());
+
+  // Enough files to be parsed on multiple threads.
+  std::vector<std::unique_ptr<verible::file::testing::ScopedTestFile>> files;
+  std::string filelist_content;
+  for (int i = 0; i < 32; ++i) {
+    const std::string name = absl::StrCat("m", i, ".sv");
+    std::string text = absl::StrCat("module m", i, ";\n");
+    if (i > 0) absl::StrAppend(&text, "  m", i - 1, " inst();\n");
+    absl::StrAppend(&text, "endmodule\n");
+    files.push_back(std::make_unique<verible::file::testing::ScopedTestFile>(
+        sources_dir, text, name));
+    absl::StrAppend(&filelist_content, name, "\n");
+  }
+  const verible::file::testing::ScopedTestFile filelist(
+      sources_dir, filelist_content, "verible.filelist");
+
+  std::shared_ptr<VerilogProject> project =
+      std::make_shared<VerilogProject>(sources_dir, std::vector<std::string>{});
+  SymbolTableHandler symbol_table_handler;
+  symbol_table_handler.SetProject(project);
+
+  std::vector<absl::Status> diagnostics =
+      symbol_table_handler.BuildProjectSymbolTable();
+  EXPECT_EQ(diagnostics.size(), 0);
+  int parsed_files = 0;
+  for (const auto &file : *project) {
+    EXPECT_TRUE(file.second->is_parsed()) << file.first;
+    EXPECT_TRUE(file.second->Status().ok()) << file.first;
+    ++parsed_files;
+  }
+  EXPECT_EQ(parsed_files, 32);
+}
+
+TEST(SymbolTableHandlerTest, UpdateFileContentRebuildsOnlyThatFile) {
+  const auto tempdir = ::testing::TempDir();
+  const std::string sources_dir =
+      verible::file::JoinPath(tempdir, __FUNCTION__);
+  ASSERT_TRUE(verible::file::CreateDir(sources_dir).ok());
+
+  const verible::file::testing::ScopedTestFile module_a(sources_dir,
+                                                        kSampleModuleA, "a.sv");
+  const verible::file::testing::ScopedTestFile module_b(sources_dir,
+                                                        kSampleModuleB, "b.sv");
+
+  std::shared_ptr<VerilogProject> project = std::make_shared<VerilogProject>(
+      sources_dir, std::vector<std::string>{}, /*corpus=*/"",
+      /*populate_string_maps=*/false);
+  ASSERT_TRUE(project->OpenTranslationUnit("a.sv").ok());
+  ASSERT_TRUE(project->OpenTranslationUnit("b.sv").ok());
+
+  SymbolTableHandler symbol_table_handler;
+  symbol_table_handler.SetProject(project);
+  ASSERT_EQ(symbol_table_handler.BuildProjectSymbolTable().size(), 0);
+
+  // The type reference "a" in module b.
+  const VerilogSourceFile* b_file = project->LookupRegisteredFile("b.sv");
+  ASSERT_NE(b_file, nullptr);
+  const absl::string_view b_text = b_file->GetTextStructure()->Contents();
+  const absl::string_view a_ref = b_text.substr(b_text.find("a vara"), 1);
+
+  // Edit module a, e.g. in an editor.
+  auto edited = std::make_shared<VerilogAnalyzer>(
+      "module a;\n"
+      "  wire var3;\n"
+      "endmodule\n",
+      module_a.filename());
+  ASSERT_TRUE(edited->Analyze().ok());
+  symbol_table_handler.UpdateFileContent(
+      module_a.filename(),
+      std::shared_ptr<const verible::TextStructureView>(edited,
+                                                        &edited->Data()));
+
+  // The reference is bound to the edited definition.
+  const verible::Symbol* definition =
+      symbol_table_handler.FindDefinitionSymbol(a_ref);
+  ASSERT_NE(definition, nullptr);
+  EXPECT_TRUE(verible::IsSubRange(verible::StringSpanOfSymbol(*definition),
+                                  edited->Data().Contents()));
+}
+
+TEST(SymbolTableHandlerTest, SnapshotHoldsBackUpdates) {
+  const auto tempdir = ::testing::TempDir();
+  const std::string sources_dir =
+      verible::file::JoinPath(tempdir, __FUNCTION__);
+  ASSERT_TRUE(verible::file::CreateDir(sources_dir).ok());
+
+  const verible::file::testing::ScopedTestFile module_a(sources_dir,
+                                                        kSampleModuleA, "a.sv");
+  const verible::file::testing::ScopedTestFile module_b(sources_dir,
+                                                        kSampleModuleB, "b.sv");
+
+  std::shared_ptr<VerilogProject> project = std::make_shared<VerilogProject>(
+      sources_dir, std::vector<std::string>{}, /*corpus=*/"",
+      /*populate_string_maps=*/false);
+  ASSERT_TRUE(project->OpenTranslationUnit("a.sv").ok());
+  ASSERT_TRUE(project->OpenTranslationUnit("b.sv").ok());
+
+  SymbolTableHandler symbol_table_handler;
+  symbol_table_handler.SetProject(project);
+
+  const VerilogSourceFile* b_file = project->LookupRegisteredFile("b.sv");
+  ASSERT_NE(b_file, nullptr);
+  const absl::string_view b_text = b_file->GetTextStructure()->Contents();
+  const absl::string_view a_ref = b_text.substr(b_text.find("a vara"), 1);
+
+  auto snapshot = symbol_table_handler.TakeSnapshot();
+  const int64_t generation = snapshot->generation();
+  const verible::Symbol* definition =
+      symbol_table_handler.FindDefinitionSymbol(a_ref);
+  ASSERT_NE(definition, nullptr);
+
+  auto edited = std::make_shared<VerilogAnalyzer>(
+      "module a;\n"
+      "  wire var3;\n"
+      "endmodule\n",
+      module_a.filename());
+  ASSERT_TRUE(edited->Analyze().ok());
+  // Waits for the snapshot to be released.
+  std::thread update([&]() {
+    symbol_table_handler.UpdateFileContent(
+        module_a.filename(),
+        std::shared_ptr<const verible::TextStructureView>(edited,
+                                                          &edited->Data()));
+  });
+
+  // Lookups meanwhile share the version of the snapshot.
+  EXPECT_EQ(symbol_table_handler.TakeSnapshot()->generation(), generation);
+  EXPECT_EQ(symbol_table_handler.FindDefinitionSymbol(a_ref), definition);
+  EXPECT_FALSE(verible::IsSubRange(verible::StringSpanOfSymbol(*definition),
+                                   edited->Data().Contents()));
+
+  snapshot.reset();
+  update.join();
+  snapshot = symbol_table_handler.TakeSnapshot();
+  EXPECT_NE(snapshot->generation(), generation);
+  definition = symbol_table_handler.FindDefinitionSymbol(a_ref);
+  ASSERT_NE(definition, nullptr);
+  EXPECT_TRUE(verible::IsSubRange(verible::StringSpanOfSymbol(*definition),
+                                  edited->Data().Contents()));
+}
+
+TEST(SymbolTableHandlerTest, UpdateFilesChangedOnDisk) {
+  const auto tempdir = ::testing::TempDir();
+  const std::string sources_dir =
+      verible::file::JoinPath(tempdir, __FUNCTION__);
+  ASSERT_TRUE(verible::file::CreateDir(sources_dir).ok());
+
+  const verible::file::testing::ScopedTestFile filelist(sources_dir, "a.sv\n",
+                                                        "verible.filelist");
+  const verible::file::testing::ScopedTestFile module_a(
+      sources_dir, "module first_module;\nendmodule\n", "a.sv");
+  const verible::file::testing::ScopedTestFile module_b(
+      sources_dir, "module third_module;\nendmodule\n", "b.sv");
+
+  std::shared_ptr<VerilogProject> project =
+      std::make_shared<VerilogProject>(sources_dir, std::vector<std::string>{});
+  SymbolTableHandler symbol_table_handler;
+  symbol_table_handler.SetProject(project);
+  ASSERT_EQ(symbol_table_handler.BuildProjectSymbolTable().size(), 0);
+  EXPECT_EQ(symbol_table_handler.FindWorkspaceSymbols("first_module").size(),
+            1);
+
+  // E.g. checking out another branch.
+  ASSERT_TRUE(verible::file::SetContents(module_a.filename(),
+                                         "module second_module;\nendmodule\n")
+                  .ok());
+  symbol_table_handler.UpdateFilesChangedOnDisk({module_a.filename()});
+  EXPECT_EQ(symbol_table_handler.FindWorkspaceSymbols("first_module").size(),
+            0);
+  EXPECT_EQ(symbol_table_handler.FindWorkspaceSymbols("second_module").size(),
+            1);
+
+  // Files added to the file list are built as well.
+  EXPECT_EQ(symbol_table_handler.FindWorkspaceSymbols("third_module").size(),
+            0);
+  const auto listed_time =
+      std::filesystem::last_write_time(filelist.filename());
+  ASSERT_TRUE(
+      verible::file::SetContents(filelist.filename(), "a.sv\nb.sv\n").ok());
+  std::filesystem::last_write_time(filelist.filename(),
+                                   listed_time + std::chrono::seconds(1));
+  symbol_table_handler.UpdateFilesChangedOnDisk({filelist.filename()});
+  EXPECT_EQ(symbol_table_handler.FindWorkspaceSymbols("third_module").size(),
+            1);
+  EXPECT_EQ(symbol_table_handler.FindWorkspaceSymbols("second_module").size(),
+            1);
+}
+
+TEST(SymbolTableHandlerTest, FindReferencesAndWorkspaceSymbols) {
+  const auto tempdir = ::testing::TempDir();
+  const std::string sources_dir =
+      verible::file::JoinPath(tempdir, __FUNCTION__);
+  ASSERT_TRUE(verible::file::CreateDir(sources_dir).ok());
+
+  const verible::file::testing::ScopedTestFile module_a(sources_dir,
+                                                        kSampleModuleA, "a.sv");
+  const verible::file::testing::ScopedTestFile module_b(sources_dir,
+                                                        kSampleModuleB, "b.sv");
+
+  std::shared_ptr<VerilogProject> project =
+      std::make_shared<VerilogProject>(sources_dir, std::vector<std::string>{});
+  ASSERT_TRUE(project->OpenTranslationUnit("a.sv").ok());
+  ASSERT_TRUE(project->OpenTranslationUnit("b.sv").ok());
+
+  SymbolTableHandler symbol_table_handler;
+  symbol_table_handler.SetProject(project);
+  ASSERT_EQ(symbol_table_handler.BuildProjectSymbolTable().size(), 0);
+
+  // Module b is open in the editor.
+  const std::string b_uri = verible::lsp::PathToLSPUri(module_b.filename());
+  const verible::lsp::EditTextBuffer b_buffer(kSampleModuleB);
+  verilog::BufferTrackerContainer parsed_buffers;
+  parsed_buffers.GetSubscriptionCallback()(b_uri, &b_buffer);
+  const BufferTracker *b_tracker =
+      parsed_buffers.FindBufferTrackerOrNull(b_uri);
+  ASSERT_NE(b_tracker, nullptr);
+  symbol_table_handler.UpdateFileContent(
+      module_b.filename(), SharedTextStructure(b_tracker->current()));
+
+  // References of module a, from its instance in module b.
+  verible::lsp::ReferenceParams references_request;
+  references_request.textDocument.uri = b_uri;
+  references_request.position = {.line = 3, .character = 2};
+  references_request.context.includeDeclaration = true;
+  const std::vector<verible::lsp::Location> references =
+      symbol_table_handler.FindReferencesLocations(references_request,
+                                                   parsed_buffers);
+  ASSERT_EQ(references.size(), 2);
+  EXPECT_EQ(references[0].uri,
+            verible::lsp::PathToLSPUri(module_a.filename()));
+  EXPECT_EQ(references[0].range.start.line, 0);
+  EXPECT_EQ(references[0].range.start.character, 7);
+  EXPECT_EQ(references[1].uri, b_uri);
+  EXPECT_EQ(references[1].range.start.line, 3);
+  EXPECT_EQ(references[1].range.start.character, 2);
+
+  references_request.context.includeDeclaration = false;
+  EXPECT_EQ(symbol_table_handler
+                .FindReferencesLocations(references_request, parsed_buffers)
+                .size(),
+            1);
+
+  const std::vector<verible::lsp::SymbolInformation> symbols =
+      symbol_table_handler.FindWorkspaceSymbols("VARA");
+  ASSERT_EQ(symbols.size(), 1);
+  EXPECT_EQ(symbols[0].name, "vara");
+  EXPECT_EQ(symbols[0].kind, verible::lsp::SymbolKind::kVariable);
+  EXPECT_EQ(symbols[0].location.uri, b_uri);
+  EXPECT_EQ(symbols[0].location.range.start.line, 3);
+
+  // All definitions: modules a and b, and the instance of a.
+  EXPECT_EQ(symbol_table_handler.FindWorkspaceSymbols("").size(), 3);
+}
+
+TEST(SymbolTableHandlerTest, RenameInAllFiles) {
+  const auto tempdir = ::testing::TempDir();
+  const std::string sources_dir =
+      verible::file::JoinPath(tempdir, __FUNCTION__);
+  ASSERT_TRUE(verible::file::CreateDir(sources_dir).ok());
+
+  const verible::file::testing::ScopedTestFile module_a(sources_dir,
+                                                        kSampleModuleA, "a.sv");
+  const verible::file::testing::ScopedTestFile module_b(sources_dir,
+                                                        kSampleModuleB, "b.sv");
+
+  std::shared_ptr<VerilogProject> project =
+      std::make_shared<VerilogProject>(sources_dir, std::vector<std::string>{});
+  ASSERT_TRUE(project->OpenTranslationUnit("a.sv").ok());
+  ASSERT_TRUE(project->OpenTranslationUnit("b.sv").ok());
+
+  SymbolTableHandler symbol_table_handler;
+  symbol_table_handler.SetProject(project);
+  ASSERT_EQ(symbol_table_handler.BuildProjectSymbolTable().size(), 0);
+
+  const std::string b_uri = verible::lsp::PathToLSPUri(module_b.filename());
+  const verible::lsp::EditTextBuffer b_buffer(kSampleModuleB);
+  verilog::BufferTrackerContainer parsed_buffers;
+  parsed_buffers.GetSubscriptionCallback()(b_uri, &b_buffer);
+  const BufferTracker *b_tracker =
+      parsed_buffers.FindBufferTrackerOrNull(b_uri);
+  ASSERT_NE(b_tracker, nullptr);
+  symbol_table_handler.UpdateFileContent(
+      module_b.filename(), SharedTextStructure(b_tracker->current()));
+
+  const auto rename = [&](int line, int character, absl::string_view name) {
+    verible::lsp::RenameParams request;
+    request.textDocument.uri = b_uri;
+    request.position = {.line = line, .character = character};
+    request.newName = std::string(name);
+    return symbol_table_handler.FindRenameEdits(request, parsed_buffers);
+  };
+
+  // Module a: its definition, and its instance in module b.
+  const auto edit = rename(3, 2, "c");
+  ASSERT_TRUE(edit.ok()) << edit.status();
+  const std::string a_uri = verible::lsp::PathToLSPUri(module_a.filename());
+  ASSERT_EQ(edit->changes.size(), 2);
+  ASSERT_EQ(edit->changes.at(a_uri).size(), 1);
+  EXPECT_EQ(edit->changes.at(a_uri)[0]["range"]["start"]["character"], 7);
+  EXPECT_EQ(edit->changes.at(a_uri)[0]["newText"], "c");
+  ASSERT_EQ(edit->changes.at(b_uri).size(), 1);
+  EXPECT_EQ(edit->changes.at(b_uri)[0]["range"]["start"]["line"], 3);
+
+  // Instance vara, at its definition and at a reference.
+  const auto vara = rename(3, 4, "inst");
+  ASSERT_TRUE(vara.ok()) << vara.status();
+  ASSERT_EQ(vara->changes.at(b_uri).size(), 2);
+  EXPECT_TRUE(rename(4, 10, "inst").ok());
+
+  // Taken in the same scope, not an identifier, and no symbol.
+  EXPECT_EQ(rename(3, 2, "b").status().code(),
+            absl::StatusCode::kInvalidArgument);
+  EXPECT_EQ(rename(3, 4, "1x").status().code(),
+            absl::StatusCode::kInvalidArgument);
+  EXPECT_EQ(rename(1, 3, "x").status().code(), absl::StatusCode::kNotFound);
+}
+
+TEST(SymbolTableHandlerTest, DefinitionAtAnyPositionOfReference) {
+  const auto tempdir = ::testing::TempDir();
+  const std::string sources_dir =
+      verible::file::JoinPath(tempdir, __FUNCTION__);
+  ASSERT_TRUE(verible::file::CreateDir(sources_dir).ok());
+
+  const verible::file::testing::ScopedTestFile module_a(sources_dir,
+                                                        kSampleModuleA, "a.sv");
+  const verible::file::testing::ScopedTestFile module_b(sources_dir,
+                                                        kSampleModuleB, "b.sv");
+
+  std::shared_ptr<VerilogProject> project =
+      std::make_shared<VerilogProject>(sources_dir, std::vector<std::string>{});
+  ASSERT_TRUE(project->OpenTranslationUnit("a.sv").ok());
+  ASSERT_TRUE(project->OpenTranslationUnit("b.sv").ok());
+
+  SymbolTableHandler symbol_table_handler;
+  symbol_table_handler.SetProject(project);
+  ASSERT_EQ(symbol_table_handler.BuildProjectSymbolTable().size(), 0);
+
+  const std::string b_uri = verible::lsp::PathToLSPUri(module_b.filename());
+  const verible::lsp::EditTextBuffer b_buffer(kSampleModuleB);
+  verilog::BufferTrackerContainer parsed_buffers;
+  auto callback = parsed_buffers.GetSubscriptionCallback();
+  callback(b_uri, &b_buffer);
+  const BufferTracker *b_tracker =
+      parsed_buffers.FindBufferTrackerOrNull(b_uri);
+  ASSERT_NE(b_tracker, nullptr);
+  symbol_table_handler.UpdateFileContent(
+      module_b.filename(), SharedTextStructure(b_tracker->current()));
+
+  const auto definition_line = [&](int line, int character) {
+    verible::lsp::DefinitionParams request;
+    request.textDocument.uri = b_uri;
+    request.position = {.line = line, .character = character};
+    const std::vector<verible::lsp::Location> locations =
+        symbol_table_handler.FindDefinitionLocation(request, parsed_buffers);
+    return locations.empty() ? -1 : locations[0].range.start.line;
+  };
+  // Start, middle and right after the end of "vara" in "vara.var1".
+  EXPECT_EQ(definition_line(4, 9), 3);
+  EXPECT_EQ(definition_line(4, 11), 3);
+  EXPECT_EQ(definition_line(4, 13), 3);
+  // Module type "a".
+  EXPECT_EQ(definition_line(3, 2), 0);
+  // Keyword, and past the end of the text.
+  EXPECT_EQ(definition_line(4, 3), -1);
+  EXPECT_EQ(definition_line(10, 0), -1);
+
+  // The symbol table does not know about edits with syntax errors.
+  verible::lsp::EditTextBuffer broken(absl::StrCat("(", kSampleModuleB));
+  broken.set_last_global_version(2);
+  callback(b_uri, &broken);
+  EXPECT_EQ(definition_line(4, 9), -1);
+}
+
+TEST(SymbolTableHandlerTest, MacroDefinitionReferencesAndHover) {
+  const auto tempdir = ::testing::TempDir();
+  const std::string sources_dir =
+      verible::file::JoinPath(tempdir, __FUNCTION__);
+  ASSERT_TRUE(verible::file::CreateDir(sources_dir).ok());
+
+  constexpr absl::string_view kDefines(
+      "`define WIDTH 8\n"
+      "`define MAX(a, b) ((a) > (b) ? (a) : (b))\n");
+  constexpr absl::string_view kModule(
+      "module m;\n"
+      "  wire [`WIDTH-1:0] w = `MAX(1, 2);\n"
+      "`ifdef WIDTH\n"
+      "`endif\n"
+      "endmodule\n");
+  const verible::file::testing::ScopedTestFile defines(sources_dir, kDefines,
+                                                       "defines.svh");
+  const verible::file::testing::ScopedTestFile module(sources_dir, kModule,
+                                                      "m.sv");
+
+  std::shared_ptr<VerilogProject> project =
+      std::make_shared<VerilogProject>(sources_dir, std::vector<std::string>{});
+  ASSERT_TRUE(project->OpenTranslationUnit("defines.svh").ok());
+  ASSERT_TRUE(project->OpenTranslationUnit("m.sv").ok());
+
+  SymbolTableHandler symbol_table_handler;
+  symbol_table_handler.SetProject(project);
+  symbol_table_handler.BuildProjectSymbolTable();
+
+  const std::string m_uri = verible::lsp::PathToLSPUri(module.filename());
+  const verible::lsp::EditTextBuffer m_buffer(kModule);
+  verilog::BufferTrackerContainer parsed_buffers;
+  parsed_buffers.GetSubscriptionCallback()(m_uri, &m_buffer);
+  const BufferTracker *m_tracker =
+      parsed_buffers.FindBufferTrackerOrNull(m_uri);
+  ASSERT_NE(m_tracker, nullptr);
+  symbol_table_handler.UpdateFileContent(
+      module.filename(), SharedTextStructure(m_tracker->current()));
+
+  const std::string defines_uri =
+      verible::lsp::PathToLSPUri(defines.filename());
+  verible::lsp::DefinitionParams definition_request;
+  definition_request.textDocument.uri = m_uri;
+  definition_request.position = {.line = 1, .character = 26};  // `MAX
+  std::vector<verible::lsp::Location> locations =
+      symbol_table_handler.FindDefinitionLocation(definition_request,
+                                                  parsed_buffers);
+  ASSERT_EQ(locations.size(), 1);
+  EXPECT_EQ(locations[0].uri, defines_uri);
+  EXPECT_EQ(locations[0].range.start.line, 1);
+  EXPECT_EQ(locations[0].range.start.character, 8);
+
+  // Usages of WIDTH in the wire declaration and after `ifdef.
+  verible::lsp::ReferenceParams references_request;
+  references_request.textDocument.uri = m_uri;
+  references_request.position = {.line = 2, .character = 7};
+  references_request.context.includeDeclaration = true;
+  locations = symbol_table_handler.FindReferencesLocations(references_request,
+                                                           parsed_buffers);
+  ASSERT_EQ(locations.size(), 3);
+  EXPECT_EQ(locations[0].uri, defines_uri);
+  EXPECT_EQ(locations[0].range.start.line, 0);
+  EXPECT_EQ(locations[1].uri, m_uri);
+  EXPECT_EQ(locations[1].range.start.line, 1);
+  EXPECT_EQ(locations[1].range.start.character, 9);
+  EXPECT_EQ(locations[2].range.start.line, 2);
+
+  verible::lsp::HoverParams hover_request;
+  hover_request.textDocument.uri = m_uri;
+  hover_request.position = {.line = 1, .character = 26};
+  const auto hover =
+      symbol_table_handler.FindHover(hover_request, parsed_buffers);
+  ASSERT_TRUE(hover.has_value());
+  EXPECT_EQ(hover->contents.value,
+            "```systemverilog\n"
+            "`define MAX(a, b) ((a) > (b) ? (a) : (b))\n"
+            "```");
+}
+
+TEST(SymbolTableHandlerTest, ReferencedDefinitionNames) {
+  VerilogAnalyzer analyzer(
+      "module top;\n"
+      "  import pkg::*;\n"
+      "  logic x;\n"
+      "  sub #(.W(other_pkg::W)) u_sub();\n"
+      "  sub u_sub2();\n"
+      "  intf bus();\n"
+      "endmodule\n",
+      "top.sv");
+  ASSERT_TRUE(analyzer.Analyze().ok());
+  std::vector<absl::string_view> names =
+      ReferencedDefinitionNames(*analyzer.Data().SyntaxTree());
+  std::sort(names.begin(), names.end());
+  EXPECT_EQ(names, std::vector<absl::string_view>(
+                       {"intf", "other_pkg", "pkg", "sub"}));
+}
+
+TEST(SymbolTableHandlerTest, PrefetchBuildsReferencedFilesFirst) {
+  const auto tempdir = ::testing::TempDir();
+  const std::string sources_dir =
+      verible::file::JoinPath(tempdir, __FUNCTION__);
+  ASSERT_TRUE(verible::file::CreateDir(sources_dir).ok());
+
+  const verible::file::testing::ScopedTestFile filelist(
+      sources_dir, "pkg.sv\nchild.sv\nunrelated.sv\ntop.sv\n",
+      "verible.filelist");
+  const verible::file::testing::ScopedTestFile pkg(
+      sources_dir, "package pkg;\n  parameter int W = 8;\nendpackage\n",
+      "pkg.sv");
+  const verible::file::testing::ScopedTestFile child(
+      sources_dir, "module child;\nendmodule\n", "child.sv");
+  const verible::file::testing::ScopedTestFile unrelated(
+      sources_dir, "module unrelated;\nendmodule\n", "unrelated.sv");
+  constexpr absl::string_view kTop =
+      "module top;\n"
+      "  logic [pkg::W-1:0] data;\n"
+      "  child u_inst();\n"
+      "endmodule\n";
+  const verible::file::testing::ScopedTestFile top(sources_dir, kTop,
+                                                   "top.sv");
+
+  std::shared_ptr<VerilogProject> project =
+      std::make_shared<VerilogProject>(sources_dir, std::vector<std::string>{});
+  SymbolTableHandler symbol_table_handler;
+  symbol_table_handler.SetProject(project);
+
+  // Opened in an editor.
+  auto opened = std::make_shared<VerilogAnalyzer>(kTop, top.filename());
+  ASSERT_TRUE(opened->Analyze().ok());
+  symbol_table_handler.UpdateFileContent(
+      top.filename(), std::shared_ptr<const verible::TextStructureView>(
+                          opened, &opened->Data()));
+  symbol_table_handler.Prefetch(top.filename());
+
+  // The files it refers to are parsed and built right away.
+  for (const absl::string_view referenced : {"pkg.sv", "child.sv"}) {
+    const VerilogSourceFile *file = project->LookupRegisteredFile(referenced);
+    ASSERT_NE(file, nullptr) << referenced;
+    EXPECT_TRUE(file->is_parsed()) << referenced;
+  }
+  EXPECT_EQ(symbol_table_handler.FindWorkspaceSymbols("child").size(), 1);
+  const absl::string_view text = opened->Data().Contents();
+  EXPECT_NE(symbol_table_handler.FindDefinitionSymbol(
+                text.substr(text.find("child u_inst"), 5)),
+            nullptr);
+
+  // The others follow.
+  symbol_table_handler.WaitForBackgroundBuild();
+  EXPECT_TRUE(project->LookupRegisteredFile("unrelated.sv")->is_parsed());
+  EXPECT_EQ(symbol_table_handler.FindWorkspaceSymbols("unrelated").size(), 1);
+  EXPECT_EQ(symbol_table_handler.FindWorkspaceSymbols("child").size(), 1);
+
+  // Nothing to do once the project is built.
+  symbol_table_handler.Prefetch(top.filename());
+  symbol_table_handler.WaitForBackgroundBuild();
+  EXPECT_EQ(symbol_table_handler.FindWorkspaceSymbols("unrelated").size(), 1);
+}
+
+TEST(SymbolTableHandlerTest, CompletesVisibleSymbolsByPrefix) {
+  const auto tempdir = ::testing::TempDir();
+  const std::string sources_dir =
+      verible::file::JoinPath(tempdir, __FUNCTION__);
+  ASSERT_TRUE(verible::file::CreateDir(sources_dir).ok());
+
+  const verible::file::testing::ScopedTestFile package(
+      sources_dir,
+      "package regs_pkg;\n"
+      "  parameter int REG_CTRL = 0;\n"
+      "  parameter int REG_STATUS = 4;\n"
+      "  typedef enum {REG_MODE_OFF, REG_MODE_ON} mode_t;\n"
+      "endpackage\n",
+      "regs_pkg.sv");
+  constexpr absl::string_view kTop =
+      "module top;\n"
+      "  import regs_pkg::*;\n"
+      "  logic REG_LOCAL;\n"
+      "  function automatic int f(int REG_ARG);\n"
+      "    return REG_ARG;\n"
+      "  endfunction\n"
+      "  assign REG_LOCAL = regs_pkg::REG_S;\n"
+      "endmodule\n";
+  const verible::file::testing::ScopedTestFile top(sources_dir, kTop,
+                                                   "top.sv");
+
+  std::shared_ptr<VerilogProject> project =
+      std::make_shared<VerilogProject>(sources_dir, std::vector<std::string>{});
+  ASSERT_TRUE(project->OpenTranslationUnit("regs_pkg.sv").ok());
+  ASSERT_TRUE(project->OpenTranslationUnit("top.sv").ok());
+  SymbolTableHandler symbol_table_handler;
+  symbol_table_handler.SetProject(project);
+
+  const std::string uri = verible::lsp::PathToLSPUri(top.filename());
+  const verible::lsp::EditTextBuffer buffer(kTop);
+  verilog::BufferTrackerContainer parsed_buffers;
+  auto callback = parsed_buffers.GetSubscriptionCallback();
+  callback(uri, &buffer);
+  const BufferTracker *tracker = parsed_buffers.FindBufferTrackerOrNull(uri);
+  ASSERT_NE(tracker, nullptr);
+  symbol_table_handler.UpdateFileContent(
+      top.filename(), SharedTextStructure(tracker->last_good()));
+
+  const auto labels = [&](int line, int character) {
+    verible::lsp::CompletionParams request;
+    request.textDocument.uri = uri;
+    request.position = {.line = line, .character = character};
+    std::vector<std::string> result;
+    for (const auto &item :
+         symbol_table_handler.FindCompletions(request, parsed_buffers).items) {
+      result.push_back(item.label);
+    }
+    return result;
+  };
+  // After "REG_" in the function: its argument first, then the module's
+  // variable, then what the package has, shortest first.
+  const std::vector<std::string> in_function = {
+      "REG_ARG",    "REG_LOCAL",   "REG_CTRL",
+      "REG_STATUS", "REG_MODE_ON", "REG_MODE_OFF"};
+  EXPECT_EQ(labels(4, 15), in_function);
+  // Members of the package.
+  EXPECT_EQ(labels(6, 36), std::vector<std::string>({"REG_STATUS"}));
+
+  // While typing, the text does not parse; the scopes are those of the last
+  // version that did.
+  verible::lsp::EditTextBuffer typing(absl::StrCat(
+      kTop.substr(0, kTop.find("return REG_ARG")), "return REG_\n",
+      kTop.substr(kTop.find("  endfunction"))));
+  typing.set_last_global_version(2);
+  callback(uri, &typing);
+  ASSERT_NE(tracker->current(), tracker->last_good());
+  EXPECT_EQ(labels(4, 15), in_function);
+}
+
 TEST(SymbolTableHandlerTest, MissingVerilogProject) {
   SymbolTableHandler symbol_table_handler;
   std::vector<absl::Status> diagnostics =
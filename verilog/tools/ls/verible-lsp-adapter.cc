@@ -15,9 +15,11 @@
 
 #include "verilog/tools/ls/verible-lsp-adapter.h"
 
+#include "absl/time/time.h"
 #include "common/lsp/lsp-protocol-enums.h"
 #include "common/lsp/lsp-protocol-operators.h"
 #include "common/lsp/lsp-protocol.h"
+#include "common/strings/line_column_map.h"
 #include "common/text/text_structure.h"
 #include "nlohmann/json.hpp"
 #include "verilog/analysis/verilog_analyzer.h"
@@ -35,7 +37,8 @@ static verible::lsp::Diagnostic ViolationToDiagnostic(
     const verible::LintViolationWithStatus &v,
     const verible::TextStructureView &text) {
   const verible::LintViolation &violation = *v.violation;
-  const verible::LineColumnRange range = text.GetRangeForToken(violation.token);
+  const verible::LineColumnRange range =
+      text.GetUtf16RangeForToken(violation.token);
   const char *fix_msg = violation.autofixes.empty() ? "" : " (fix available)";
   return verible::lsp::Diagnostic{
       .range =
@@ -57,9 +60,14 @@ std::vector<verible::lsp::Diagnostic> CreateDiagnostics(
   // syntax errors.
   const auto current = tracker.current();
   if (!current) return {};
-  const auto &rejected_tokens = current->parser().GetRejectedTokens();
+  return CreateDiagnostics(*current, message_limit);
+}
+
+std::vector<verible::lsp::Diagnostic> CreateDiagnostics(
+    const ParsedBuffer &parsed, int message_limit) {
+  const auto &rejected_tokens = parsed.parser().GetRejectedTokens();
   auto const &lint_violations =
-      verilog::GetSortedViolations(current->lint_result());
+      verilog::GetSortedViolations(parsed.lint_result());
   std::vector<verible::lsp::Diagnostic> result;
   int remaining = rejected_tokens.size() + lint_violations.size();
 
@@ -78,13 +86,17 @@ std::vector<verible::lsp::Diagnostic> CreateDiagnostics(
     remaining = message_limit;
   }
 
+  const verible::TextStructureView &text = parsed.parser().Data();
   result.reserve(remaining);
   for (const auto &rejected_token : rejected_tokens) {
     if (remaining-- <= 0) break;
-    current->parser().ExtractLinterTokenErrorDetail(
+    // LSP columns count UTF-16 code units, unlike those of 'range'.
+    const verible::LineColumnRange range =
+        text.GetUtf16RangeForToken(rejected_token.token_info);
+    parsed.parser().ExtractLinterTokenErrorDetail(
         rejected_token,
-        [&result, &rejected_token](
-            const std::string &filename, verible::LineColumnRange range,
+        [&result, &rejected_token, &range](
+            const std::string &filename, verible::LineColumnRange,
             verible::ErrorSeverity severity, verible::AnalysisPhase phase,
             absl::string_view token_text, absl::string_view context_line,
             const std::string &msg) {
@@ -114,7 +126,7 @@ std::vector<verible::lsp::Diagnostic> CreateDiagnostics(
 
   for (const auto &v : lint_violations) {
     if (remaining-- <= 0) break;
-    result.emplace_back(ViolationToDiagnostic(v, current->parser().Data()));
+    result.emplace_back(ViolationToDiagnostic(v, text));
   }
   return result;
 }
@@ -133,12 +145,11 @@ static std::vector<verible::lsp::TextEdit> AutofixToTextEdits(
   std::vector<verible::lsp::TextEdit> result;
   // TODO(hzeller): figure out if edits are stacking or are all based
   // on the same start status.
-  const absl::string_view base = text.Contents();
   for (const verible::ReplacementEdit &edit : fix.Edits()) {
-    verible::LineColumn start =
-        text.GetLineColAtOffset(edit.fragment.begin() - base.begin());
-    verible::LineColumn end =
-        text.GetLineColAtOffset(edit.fragment.end() - base.begin());
+    const verible::LineColumnRange range =
+        text.GetUtf16RangeForText(edit.fragment);
+    const verible::LineColumn &start = range.start;
+    const verible::LineColumn &end = range.end;
     result.emplace_back(verible::lsp::TextEdit{
         .range =
             {
@@ -194,7 +205,9 @@ std::vector<verible::lsp::CodeAction> GenerateLinterCodeActions(
 
 std::vector<verible::lsp::CodeAction> GenerateCodeActions(
     SymbolTableHandler *symbol_table_handler, const BufferTracker *tracker,
-    const verible::lsp::CodeActionParams &p) {
+    const verible::lsp::CodeActionParams &p,
+    const std::function<bool()> &is_cancelled,
+    AutoExpandCache *auto_expand_cache) {
   std::vector<verible::lsp::CodeAction> result;
 
   if (!tracker) return result;
@@ -202,9 +215,10 @@ std::vector<verible::lsp::CodeAction> GenerateCodeActions(
   if (!current) return result;
 
   result = GenerateLinterCodeActions(tracker, p);
+  if (is_cancelled && is_cancelled()) return result;
 
-  auto auto_expand =
-      GenerateAutoExpandCodeActions(symbol_table_handler, tracker, p);
+  auto auto_expand = GenerateAutoExpandCodeActions(
+      symbol_table_handler, tracker, p, auto_expand_cache);
   result.insert(result.end(), std::make_move_iterator(auto_expand.begin()),
                 make_move_iterator(auto_expand.end()));
 
@@ -236,20 +250,24 @@ std::vector<verible::lsp::DocumentHighlight> CreateHighlightRanges(
   if (!tracker) return result;
   const auto current = tracker->current();
   if (!current) return result;
-  const verible::LineColumn cursor{p.position.line, p.position.character};
   const verible::TextStructureView &text = current->parser().Data();
+  const int cursor_offset = text.GetUtf16ColumnMap().OffsetAtLineCol(
+      {p.position.line, p.position.character});
+  if (cursor_offset < 0) return result;
 
-  const verible::TokenInfo cursor_token = text.FindTokenAt(cursor);
+  const verible::TokenInfo cursor_token =
+      text.FindTokenAt(text.GetLineColAtOffset(cursor_offset));
   if (cursor_token.token_enum() != SymbolIdentifier) return result;
 
   // Find all the symbols with the same name in the buffer.
   // Note, this is very simplistic as it does _not_ take scopes into account.
   // For that, we'd need the symbol table, but that implementation is not
   // complete yet.
-  for (const verible::TokenInfo &tok : text.TokenStream()) {
-    if (tok.token_enum() != cursor_token.token_enum()) continue;
-    if (tok.text() != cursor_token.text()) continue;
-    const verible::LineColumnRange range = text.GetRangeForToken(tok);
+  const auto &occurrences = current->identifier_occurrences();
+  const auto found = occurrences.find(cursor_token.text());
+  if (found == occurrences.end()) return result;
+  result.reserve(found->second.size());
+  for (const verible::LineColumnRange &range : found->second) {
     result.push_back(verible::lsp::DocumentHighlight{
         .range = {
             .start = {.line = range.start.line,
@@ -261,9 +279,18 @@ std::vector<verible::lsp::DocumentHighlight> CreateHighlightRanges(
   return result;
 }
 
+// Editors wait for formatting results, so line wrap searches that would
+// take long settle for a greedily completed wrapping.
+static constexpr absl::Duration kFormatLineWrapSearchLineBudget =
+    absl::Milliseconds(100);
+static constexpr absl::Duration kFormatLineWrapSearchFileBudget =
+    absl::Milliseconds(1000);
+
 std::vector<verible::lsp::TextEdit> FormatRange(
     const BufferTracker *tracker,
-    const verible::lsp::DocumentFormattingParams &p) {
+    const verible::lsp::DocumentFormattingParams &p,
+    verilog::formatter::FormattedItemCache *cache,
+    const std::function<bool()> &is_cancelled) {
   std::vector<verible::lsp::TextEdit> result;
   if (!tracker) return result;
   const auto current = tracker->current();
@@ -272,42 +299,43 @@ std::vector<verible::lsp::TextEdit> FormatRange(
 
   verilog::formatter::FormatStyle format_style;
   verilog::formatter::InitializeFromFlags(&format_style);
+  verilog::formatter::ExecutionControl control;
+  control.formatted_item_cache = cache;
+  control.is_cancelled = is_cancelled;
+  control.line_wrap_search_line_budget = kFormatLineWrapSearchLineBudget;
+  control.line_wrap_search_file_budget = kFormatLineWrapSearchFileBudget;
 
+  verible::LineNumberSet format_lines;
   if (p.has_range) {
     // If the cursor is at the very beginning of last line, we don't include
     // it in the formatting.
     const int last_line_include = p.range.end.character > 0 ? 1 : 0;
-    const verible::Interval<int> format_lines{
+    const verible::Interval<int> range{
         p.range.start.line + 1,  // 1 index based
         p.range.end.line + 1 + last_line_include};
-    std::string formatted_range;
-    if (!FormatVerilogRange(text, format_style, &formatted_range, format_lines)
-             .ok()) {
-      return result;
-    }
-    result.push_back(verible::lsp::TextEdit{
-        .range =
-            {
-                .start = {.line = format_lines.min - 1, .character = 0},
-                .end = {.line = format_lines.max - 1, .character = 0},
-            },
-        .newText = formatted_range});
-  } else {
-    std::string newText;
-    if (!FormatVerilog(text, current->uri(), format_style, &newText).ok()) {
-      return result;
-    }
-    // Emit a single edit that replaces the full range the file covers.
-    // TODO(hzeller): Could consider patches maybe.
-    // TODO(hzeller): Also be safe and don't emit anything if text is the same.
-    const auto range = text.GetRangeForText(text.Contents());
+    if (range.min >= range.max) return result;
+    format_lines.Add(range);
+  }
+
+  // Only whitespace changes, so just those parts are sent, not the text.
+  std::vector<verilog::formatter::WhitespaceEdit> edits;
+  if (!FormatVerilogEdits(text, current->uri(), format_style, &edits,
+                          format_lines, control)
+           .ok()) {
+    return result;
+  }
+  result.reserve(edits.size());
+  for (verilog::formatter::WhitespaceEdit &edit : edits) {
+    const verible::LineColumnRange range =
+        text.GetUtf16RangeForText(edit.original);
     result.push_back(verible::lsp::TextEdit{
         .range =
             {
-                .start = {.line = 0, .character = 0},
+                .start = {.line = range.start.line,
+                          .character = range.start.column},
                 .end = {.line = range.end.line, .character = range.end.column},
             },
-        .newText = newText});
+        .newText = std::move(edit.replacement)});
   }
   return result;
 }
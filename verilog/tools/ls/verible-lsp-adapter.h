@@ -16,10 +16,13 @@
 #ifndef VERILOG_TOOLS_LS_VERIBLE_LSP_ADAPTER_H
 #define VERILOG_TOOLS_LS_VERIBLE_LSP_ADAPTER_H
 
+#include <functional>
 #include <vector>
 
 #include "common/lsp/lsp-protocol.h"
 #include "nlohmann/json.hpp"
+#include "verilog/formatting/formatter.h"
+#include "verilog/tools/ls/autoexpand.h"
 #include "verilog/tools/ls/lsp-parse-buffer.h"
 #include "verilog/tools/ls/symbol-table-handler.h"
 
@@ -32,14 +35,25 @@ namespace verilog {
 std::vector<verible::lsp::Diagnostic> CreateDiagnostics(const BufferTracker &,
                                                         int message_limit);
 
+// Same, for a parse that is not tracked in a buffer, e.g. of a file that is
+// not open in the editor.
+std::vector<verible::lsp::Diagnostic> CreateDiagnostics(
+    const ParsedBuffer &parsed, int message_limit);
+
 // Generate code actions from autofixes provided by the linter.
 std::vector<verible::lsp::CodeAction> GenerateLinterCodeActions(
     const BufferTracker *tracker, const verible::lsp::CodeActionParams &p);
 
 // Generate all available code actions.
+// If "is_cancelled" is given and returns true between generating the kinds
+// of code actions, the remaining ones are not generated.
+// If "auto_expand_cache" is given, AUTO expansion reuses what it found in
+// earlier requests.
 std::vector<verible::lsp::CodeAction> GenerateCodeActions(
     SymbolTableHandler *symbol_table_handler, const BufferTracker *tracker,
-    const verible::lsp::CodeActionParams &p);
+    const verible::lsp::CodeActionParams &p,
+    const std::function<bool()> &is_cancelled = nullptr,
+    AutoExpandCache *auto_expand_cache = nullptr);
 
 verible::lsp::FullDocumentDiagnosticReport GenerateDiagnosticReport(
     const BufferTracker *tracker,
@@ -62,10 +76,17 @@ std::vector<verible::lsp::DocumentHighlight> CreateHighlightRanges(
     const BufferTracker *tracker,
     const verible::lsp::DocumentHighlightParams &p);
 
-// Format given range (or whole document) and emit an edit.
+// Format given range (or whole document) and emit the edits of whitespace
+// that formatting changes.
+// If 'cache' is given, items that were formatted before with it are not
+// formatted again.
+// If 'is_cancelled' is given and returns true between formatting stages,
+// formatting stops without emitting edits.
 std::vector<verible::lsp::TextEdit> FormatRange(
     const BufferTracker *tracker,
-    const verible::lsp::DocumentFormattingParams &p);
+    const verible::lsp::DocumentFormattingParams &p,
+    verilog::formatter::FormattedItemCache *cache = nullptr,
+    const std::function<bool()> &is_cancelled = nullptr);
 
 }  // namespace verilog
 #endif  // VERILOG_TOOLS_LS_VERIBLE_LSP_ADAPTER_H
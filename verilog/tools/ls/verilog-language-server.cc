@@ -14,14 +14,30 @@
 
 #include "verilog/tools/ls/verilog-language-server.h"
 
+#include <algorithm>
+#include <cstdint>
+#include <filesystem>
 #include <functional>
 #include <memory>
+#include <mutex>
+#include <sstream>
+#include <string>
+#include <utility>
+#include <vector>
 
+#include "absl/status/status.h"
+#include "absl/status/statusor.h"
+#include "absl/strings/match.h"
+#include "absl/strings/str_cat.h"
 #include "absl/strings/string_view.h"
+#include "absl/time/time.h"
 #include "common/lsp/lsp-file-utils.h"
 #include "common/lsp/lsp-protocol.h"
 #include "common/util/file_util.h"
 #include "common/util/init_command_line.h"
+#include "common/util/json_writer.h"
+#include "common/util/latency_stats.h"
+#include "verilog/tools/ls/semantic-tokens.h"
 #include "verilog/tools/ls/verible-lsp-adapter.h"
 
 namespace verilog {
@@ -31,22 +47,96 @@ VerilogLanguageServer::VerilogLanguageServer(const WriteFun &write_fun)
   // All bodies the stream splitter extracts are pushed to the json dispatcher
   stream_splitter_.SetMessageProcessor(
       [this](absl::string_view header, absl::string_view body) {
+        // Linting the workspace gives way to whatever this message needs.
+        if (workspace_diagnostics_) workspace_diagnostics_->Busy();
+        const std::lock_guard<std::mutex> l(dispatch_lock_);
         return dispatcher_.DispatchMessage(body);
       });
 
   // Whenever the text changes in the editor, reparse affected code.
-  text_buffers_.SetChangeListener(parsed_buffers_.GetSubscriptionCallback());
+  text_buffers_.SetChangeListener(
+      [this, reparse = parsed_buffers_.GetSubscriptionCallback()](
+          const std::string &uri, const verible::lsp::EditTextBuffer *txt) {
+        {
+          const std::lock_guard<std::mutex> l(edit_versions_lock_);
+          if (txt) {
+            edit_versions_[uri] = txt->last_global_version();
+          } else {
+            edit_versions_.erase(uri);
+          }
+        }
+        // Diagnostics of a closed buffer are those of the file on disk again.
+        if (!txt && workspace_diagnostics_) {
+          workspace_diagnostics_->FileChanged(uri);
+        }
+        reparse(uri, txt);
+      });
 
   // Whenever there is a new parse result ready, use that as an opportunity
   // to send diagnostics to the client.
   parsed_buffers_.AddChangeListener(
       [this](const std::string &uri,
              const verilog::BufferTracker *buffer_tracker) {
-        if (buffer_tracker) SendDiagnostics(uri, *buffer_tracker);
+        if (!buffer_tracker) {
+          diagnostics_due_.erase(uri);
+          published_diagnostics_hash_.erase(uri);
+          {
+            const std::lock_guard<std::mutex> l(outline_cache_lock_);
+            outline_cache_.erase(uri);
+          }
+          const std::lock_guard<std::mutex> l(semantic_tokens_lock_);
+          semantic_tokens_cache_.erase(uri);
+        } else if (parsed_buffers_.parses_in_background()) {
+          SendDiagnostics(uri, *buffer_tracker);  // Already debounced.
+        } else {
+          diagnostics_due_.insert(uri);
+        }
       });
   SetRequestHandlers();
 }
 
+VerilogLanguageServer::~VerilogLanguageServer() {
+  // Requests in progress might use any of our members.
+  dispatcher_.WaitForPendingRequests();
+}
+
+void VerilogLanguageServer::LimitRecentlyEditedBuffers(int limit) {
+  parsed_buffers_.LimitRecentlyChangedBuffers(limit);
+}
+
+void VerilogLanguageServer::ProcessRequestsConcurrently(int threads) {
+  dispatcher_.ProcessRequestsConcurrently(threads);
+}
+
+void VerilogLanguageServer::WriteInBackground(std::function<void()> flush) {
+  dispatcher_.WriteInBackground(std::move(flush));
+}
+
+void VerilogLanguageServer::LintWorkspaceInBackground(int threads,
+                                                      absl::Duration quiet) {
+  workspace_diagnostics_ = std::make_unique<verilog::WorkspaceDiagnostics>(
+      threads, quiet, published_diagnostics_limit_,
+      [this](const std::string &uri,
+             const std::vector<verible::lsp::Diagnostic> &diagnostics) {
+        const std::lock_guard<std::mutex> l(dispatch_lock_);
+        // Open buffers get the diagnostics of their edited content.
+        if (EditVersion(uri) >= 0) return;
+        PublishDiagnostics(uri, diagnostics);
+      });
+}
+
+void VerilogLanguageServer::LimitPublishedDiagnostics(int limit) {
+  published_diagnostics_limit_ = limit;
+}
+
+void VerilogLanguageServer::ParseInBackground(absl::Duration debounce) {
+  parsed_buffers_.ParseInBackground(
+      debounce, [this](const std::function<void()> &publish) {
+        const std::lock_guard<std::mutex> l(dispatch_lock_);
+        publish();
+      });
+}
+
 verible::lsp::InitializeResult VerilogLanguageServer::GetCapabilities() {
   // send response with information what we do.
   verible::lsp::InitializeResult result;
@@ -68,16 +158,53 @@ verible::lsp::InitializeResult VerilogLanguageServer::GetCapabilities() {
       {"documentFormattingProvider", true},       // Full file format
       {"documentHighlightProvider", true},        // Highlight same symbol
       {"definitionProvider", true},               // Provide going to definition
+      {"referencesProvider", true},               // Find all references
+      {"renameProvider", true},                   // Rename in the project
+      {"workspaceSymbolProvider", true},          // Find symbols in project
+      {"hoverProvider", true},                    // Describe symbols
+      {"completionProvider",                      // Complete identifiers
+       {
+           {"triggerCharacters", nlohmann::json::array({":"})},
+       }},
+      {"semanticTokensProvider",                  // Highlight by meaning
+       {
+           {"legend", verilog::SemanticTokensLegend()},
+           {"range", true},
+           {"full", {{"delta", true}}},
+       }},
       {"diagnosticProvider",                      // Pull model of diagnostics.
        {
            {"interFileDependencies", false},
            {"workspaceDiagnostics", false},
        }},
+      {"workspace",                               // A project for each folder
+       {
+           {"workspaceFolders",
+            {
+                {"supported", true},
+                {"changeNotifications", true},
+            }},
+       }},
   };
 
   return result;
 }
 
+// Returns count, total and percentiles in milliseconds by name.
+static nlohmann::json LatenciesToJson(const verible::LatencyStats &latencies) {
+  nlohmann::json result = nlohmann::json::object();
+  for (const auto &[name, histogram] : latencies.Histograms()) {
+    result[name] = {
+        {"count", histogram.count()},
+        {"totalMs", absl::ToDoubleMilliseconds(histogram.total())},
+        {"p50Ms", absl::ToDoubleMilliseconds(histogram.Percentile(0.5))},
+        {"p99Ms", absl::ToDoubleMilliseconds(histogram.Percentile(0.99))},
+        {"maxMs", absl::ToDoubleMilliseconds(histogram.max())},
+    };
+  }
+  return result;
+}
+
 void VerilogLanguageServer::SetRequestHandlers() {
   // Exchange of capabilities.
   dispatcher_.AddRequestHandler("initialize",
@@ -85,52 +212,210 @@ void VerilogLanguageServer::SetRequestHandlers() {
                                   return InitializeRequestHandler(params);
                                 });
 
-  dispatcher_.AddRequestHandler(  // Provide diagnostics on request
-      "textDocument/diagnostic",
-      [this](const verible::lsp::DocumentDiagnosticParams &p) {
-        return verilog::GenerateDiagnosticReport(
-            parsed_buffers_.FindBufferTrackerOrNull(p.textDocument.uri), p);
+  AddBufferRequestHandler<verible::lsp::DocumentDiagnosticParams>(
+      "textDocument/diagnostic",  // Provide diagnostics on request
+      [](const BufferTracker *buffer, const auto &p, const IsCancelled &) {
+        return verilog::GenerateDiagnosticReport(buffer, p);
       });
 
-  dispatcher_.AddRequestHandler(  // Provide autofixes
-      "textDocument/codeAction",
-      [this](const verible::lsp::CodeActionParams &p) {
-        return verilog::GenerateCodeActions(
-            &symbol_table_handler_,
-            parsed_buffers_.FindBufferTrackerOrNull(p.textDocument.uri), p);
+  AddBufferRequestHandler<verible::lsp::CodeActionParams>(
+      "textDocument/codeAction",  // Provide autofixes
+      [this](const BufferTracker *buffer, const auto &p,
+             const IsCancelled &cancelled) {
+        // The cache is shared by all code action requests.
+        const std::lock_guard<std::mutex> l(auto_expand_cache_lock_);
+        const auto symbols = SymbolsFor(p.textDocument.uri);
+        return verilog::GenerateCodeActions(symbols.get(), buffer, p,
+                                            cancelled, &auto_expand_cache_);
       });
 
-  dispatcher_.AddRequestHandler(  // Provide document outline/index
-      "textDocument/documentSymbol",
-      [this](const verible::lsp::DocumentSymbolParams &p) {
-        return verilog::CreateDocumentSymbolOutline(
-            parsed_buffers_.FindBufferTrackerOrNull(p.textDocument.uri), p);
+  AddBufferRequestHandler<verible::lsp::DocumentSymbolParams>(
+      "textDocument/documentSymbol",  // Provide document outline/index
+      [this](const BufferTracker *buffer, const auto &p, const IsCancelled &) {
+        return DocumentSymbolOutline(buffer, p);
       });
 
-  dispatcher_.AddRequestHandler(  // Highlight related symbols under cursor
-      "textDocument/documentHighlight",
-      [this](const verible::lsp::DocumentHighlightParams &p) {
-        return verilog::CreateHighlightRanges(
-            parsed_buffers_.FindBufferTrackerOrNull(p.textDocument.uri), p);
+  AddBufferRequestHandler<verible::lsp::DocumentHighlightParams>(
+      "textDocument/documentHighlight",  // Highlight related symbols
+      [](const BufferTracker *buffer, const auto &p, const IsCancelled &) {
+        return verilog::CreateHighlightRanges(buffer, p);
       });
 
-  dispatcher_.AddRequestHandler(  // format range of file
-      "textDocument/rangeFormatting",
-      [this](const verible::lsp::DocumentFormattingParams &p) {
-        return verilog::FormatRange(
-            parsed_buffers_.FindBufferTrackerOrNull(p.textDocument.uri), p);
+  AddBufferRequestHandler<verible::lsp::SemanticTokensParams>(
+      "textDocument/semanticTokens/full",  // Classify all tokens
+      [this](const BufferTracker *buffer, const auto &p, const IsCancelled &) {
+        verible::lsp::SemanticTokens result;
+        const auto tokens =
+            SemanticTokensOf(buffer, p.textDocument.uri, nullptr, nullptr);
+        if (tokens) {
+          result.resultId = tokens->result_id;
+          result.has_resultId = true;
+          result.data = tokens->data;
+        }
+        return result;
       });
-  dispatcher_.AddRequestHandler(  // format entire file
-      "textDocument/formatting",
-      [this](const verible::lsp::DocumentFormattingParams &p) {
-        return verilog::FormatRange(
-            parsed_buffers_.FindBufferTrackerOrNull(p.textDocument.uri), p);
+  AddBufferRequestHandler<verible::lsp::SemanticTokensDeltaParams>(
+      "textDocument/semanticTokens/full/delta",  // Only what changed
+      [this](const BufferTracker *buffer, const auto &p, const IsCancelled &) {
+        std::shared_ptr<const CachedSemanticTokens> previous;
+        const auto tokens =
+            SemanticTokensOf(buffer, p.textDocument.uri, nullptr, &previous);
+        if (!tokens) return Result::Of(verible::lsp::SemanticTokens());
+        if (!previous || previous->result_id != p.previousResultId) {
+          verible::lsp::SemanticTokens full;
+          full.resultId = tokens->result_id;
+          full.has_resultId = true;
+          full.data = tokens->data;
+          return Result::Of(full);
+        }
+        verible::lsp::SemanticTokensDelta delta;
+        delta.resultId = tokens->result_id;
+        delta.has_resultId = true;
+        delta.edits = verilog::DiffSemanticTokens(previous->data, tokens->data);
+        return Result::Of(delta);
       });
+  AddBufferRequestHandler<verible::lsp::SemanticTokensRangeParams>(
+      "textDocument/semanticTokens/range",  // Classify the visible tokens
+      [this](const BufferTracker *buffer, const auto &p, const IsCancelled &) {
+        verible::lsp::SemanticTokens result;
+        const auto tokens =
+            SemanticTokensOf(buffer, p.textDocument.uri, &p.range, nullptr);
+        if (tokens) {
+          result.data = verilog::EncodeSemanticTokens(
+              verilog::SemanticTokensOnLines(tokens->tokens, p.range.start.line,
+                                             p.range.end.line + 1));
+        }
+        return result;
+      });
+
+  const auto format_range = [this](const BufferTracker *buffer,
+                                   const auto &p,
+                                   const IsCancelled &cancelled) {
+    // The cache is shared by all formatting requests.
+    const std::lock_guard<std::mutex> l(formatting_lock_);
+    return verible::PhaseLatencies().Time("format", [&]() {
+      return verilog::FormatRange(buffer, p, &formatted_item_cache_, cancelled);
+    });
+  };
+  AddBufferRequestHandler<verible::lsp::DocumentFormattingParams>(
+      "textDocument/rangeFormatting", format_range);  // format range of file
+  AddBufferRequestHandler<verible::lsp::DocumentFormattingParams>(
+      "textDocument/formatting", format_range);  // format entire file
+
+  // These look up the cursor in the parsed buffers, so they are answered in
+  // order; they read a snapshot of the symbol table, which requests on other
+  // threads might share.
   dispatcher_.AddRequestHandler(  // go-to definition
       "textDocument/definition",
       [this](const verible::lsp::DefinitionParams &p) {
-        return symbol_table_handler_.FindDefinitionLocation(p, parsed_buffers_);
+        return SymbolsFor(p.textDocument.uri)
+            ->FindDefinitionLocation(p, parsed_buffers_);
+      });
+  dispatcher_.AddRequestHandler(  // describe symbol under the cursor
+      "textDocument/hover", [this](const verible::lsp::HoverParams &p) {
+        const auto hover =
+            SymbolsFor(p.textDocument.uri)->FindHover(p, parsed_buffers_);
+        return hover ? nlohmann::json(*hover) : nlohmann::json();
       });
+  dispatcher_.AddRequestHandler(  // find references
+      "textDocument/references",
+      [this](const verible::lsp::ReferenceParams &p) {
+        return SymbolsFor(p.textDocument.uri)
+            ->FindReferencesLocations(p, parsed_buffers_);
+      });
+  dispatcher_.AddRequestHandler(  // rename symbol in the whole project
+      "textDocument/rename", [this](const verible::lsp::RenameParams &p) {
+        const absl::StatusOr<verible::lsp::WorkspaceEdit> edit =
+            SymbolsFor(p.textDocument.uri)->FindRenameEdits(p, parsed_buffers_);
+        if (absl::IsNotFound(edit.status())) return nlohmann::json();
+        if (!edit.ok()) {
+          throw verible::lsp::JsonRpcDispatcher::Error(
+              verible::lsp::JsonRpcDispatcher::kRequestFailed,
+              std::string(edit.status().message()));
+        }
+        return nlohmann::json(*edit);
+      });
+  dispatcher_.AddRequestHandler(  // find symbols in all projects
+      "workspace/symbol",
+      [this](const verible::lsp::WorkspaceSymbolParams &p) {
+        std::vector<verible::lsp::SymbolInformation> result;
+        for (const auto &symbols : AllSymbols()) {
+          std::vector<verible::lsp::SymbolInformation> found =
+              symbols->FindWorkspaceSymbols(p.query);
+          result.insert(result.end(), std::make_move_iterator(found.begin()),
+                        std::make_move_iterator(found.end()));
+        }
+        return result;
+      });
+  dispatcher_.AddRequestHandler(  // complete identifier at the cursor
+      "textDocument/completion",
+      [this](const verible::lsp::CompletionParams &p) {
+        return SymbolsFor(p.textDocument.uri)
+            ->FindCompletions(p, parsed_buffers_);
+      });
+  // Files changed on disk, e.g. on checking out another branch. Only those
+  // are read again, and their symbols updated.
+  dispatcher_.AddNotificationHandler(
+      "workspace/didChangeWatchedFiles",
+      [this](const verible::lsp::DidChangeWatchedFilesParams &p) {
+        std::vector<std::string> paths;
+        for (const verible::lsp::FileEvent &change : p.changes) {
+          // The project has the content of open buffers from the editor.
+          if (EditVersion(change.uri) >= 0) continue;
+          const absl::string_view path = verible::lsp::LSPUriToPath(change.uri);
+          if (!path.empty()) paths.emplace_back(path);
+        }
+        // Each project ignores those that are not its files.
+        for (const auto &symbols : AllSymbols()) {
+          symbols->UpdateFilesChangedOnDisk(paths);
+        }
+        if (!workspace_diagnostics_) return;
+        for (const verible::lsp::FileEvent &change : p.changes) {
+          workspace_diagnostics_->FileChanged(change.uri);
+        }
+        UpdateWorkspaceFiles();  // The file list might have changed as well.
+      });
+  dispatcher_.AddNotificationHandler(
+      "workspace/didChangeWorkspaceFolders",
+      [this](const verible::lsp::DidChangeWorkspaceFoldersParams &p) {
+        for (const verible::lsp::WorkspaceFolder &folder : p.event.removed) {
+          RemoveProject(verible::lsp::LSPUriToPath(folder.uri));
+        }
+        for (const verible::lsp::WorkspaceFolder &folder : p.event.added) {
+          const absl::string_view path = verible::lsp::LSPUriToPath(folder.uri);
+          if (path.empty()) {
+            LOG(ERROR) << "Unsupported workspace folder: " << folder.uri;
+            continue;
+          }
+          ConfigureProject(path);
+        }
+        UpdateWorkspaceFiles();
+      });
+
+  // Memory held by open buffers; not part of the language server protocol.
+  dispatcher_.AddRequestHandler(
+      "verible/memoryStats", [this](const nlohmann::json &) {
+        const BufferMemoryStats stats = parsed_buffers_.GetMemoryStats();
+        return nlohmann::json{
+            {"buffers", stats.buffers},
+            {"parsedBuffers", stats.parsed_buffers},
+            {"parsedBytes", stats.parsed_bytes},
+            {"parsedTokens", stats.parsed_tokens},
+            {"releasedBuffers", stats.released_buffers},
+            {"releasedBytes", stats.released_bytes},
+        };
+      });
+
+  // Where time goes; not part of the language server protocol.
+  dispatcher_.AddRequestHandler(
+      "$/verible/stats", [this](const nlohmann::json &) {
+        return nlohmann::json{
+            {"methods", LatenciesToJson(dispatcher_.latencies())},
+            {"phases", LatenciesToJson(verible::PhaseLatencies())},
+            {"counters", dispatcher_.GetStatCounters()},
+        };
+      });
+
   // The client sends a request to shut down. Use that to exit our loop.
   dispatcher_.AddRequestHandler("shutdown", [this](const nlohmann::json &) {
     shutdown_requested_ = true;
@@ -139,7 +424,14 @@ void VerilogLanguageServer::SetRequestHandlers() {
 }
 
 absl::Status VerilogLanguageServer::Step(const ReadFun &read_fun) {
-  return stream_splitter_.PullFrom(read_fun);
+  const absl::Status status = stream_splitter_.PullFrom(read_fun);
+  const std::lock_guard<std::mutex> l(dispatch_lock_);
+  for (const std::string &uri : diagnostics_due_) {
+    const BufferTracker *tracker = parsed_buffers_.FindBufferTrackerOrNull(uri);
+    if (tracker) SendDiagnostics(uri, *tracker);
+  }
+  diagnostics_due_.clear();
+  return status;
 }
 
 absl::Status VerilogLanguageServer::Run(const ReadFun &read_fun) {
@@ -148,9 +440,123 @@ absl::Status VerilogLanguageServer::Run(const ReadFun &read_fun) {
   while (status.ok() && !shutdown_requested_) {
     status = Step(read_fun);
   }
+  dispatcher_.WaitForPendingRequests();
   return status;
 }
 
+template <typename Params, typename Fun>
+void VerilogLanguageServer::AddBufferRequestHandler(const std::string &method,
+                                                    const Fun &fun) {
+  dispatcher_.AddAsyncRequestHandler(
+      method, [this, fun](const nlohmann::json &params) {
+        const Params p = params;
+        const std::string &uri = p.textDocument.uri;
+        const BufferTracker *tracker =
+            parsed_buffers_.FindBufferTrackerOrNull(uri);
+        std::shared_ptr<const BufferTracker> buffer =
+            tracker ? tracker->Snapshot() : nullptr;
+        const int64_t version = EditVersion(uri);
+        return [this, fun, p, buffer,
+                version](const IsCancelled &cancelled) -> Result {
+          // The response would refer to an outdated version of the text.
+          if (EditVersion(p.textDocument.uri) != version) {
+            throw verible::lsp::JsonRpcDispatcher::Error(
+                verible::lsp::JsonRpcDispatcher::kContentModified,
+                "Document changed since the request.");
+          }
+          if (cancelled()) return nlohmann::json();
+          // Structs like semantic tokens are serialized without a json DOM.
+          return Result::Of(fun(buffer.get(), p, cancelled));
+        };
+      });
+}
+
+int64_t VerilogLanguageServer::EditVersion(const std::string &uri) const {
+  const std::lock_guard<std::mutex> l(edit_versions_lock_);
+  const auto found = edit_versions_.find(uri);
+  return found != edit_versions_.end() ? found->second : -1;
+}
+
+nlohmann::json VerilogLanguageServer::DocumentSymbolOutline(
+    const verilog::BufferTracker *buffer,
+    const verible::lsp::DocumentSymbolParams &p) {
+  const std::shared_ptr<const ParsedBuffer> last_good =
+      buffer ? buffer->last_good() : nullptr;
+  if (!last_good) return verilog::CreateDocumentSymbolOutline(buffer, p);
+  const std::string &uri = p.textDocument.uri;
+  {
+    const std::lock_guard<std::mutex> l(outline_cache_lock_);
+    const auto found = outline_cache_.find(uri);
+    if (found != outline_cache_.end() &&
+        found->second.parsed.lock() == last_good) {
+      return found->second.outline;
+    }
+  }
+  nlohmann::json outline = verilog::CreateDocumentSymbolOutline(buffer, p);
+  const std::lock_guard<std::mutex> l(outline_cache_lock_);
+  // Not if closed meanwhile; requests only see open buffers.
+  if (EditVersion(uri) >= 0) outline_cache_[uri] = {last_good, outline};
+  return outline;
+}
+
+std::shared_ptr<const VerilogLanguageServer::CachedSemanticTokens>
+VerilogLanguageServer::SemanticTokensOf(
+    const verilog::BufferTracker *buffer, const std::string &uri,
+    const verible::lsp::Range *range,
+    std::shared_ptr<const CachedSemanticTokens> *previous) {
+  const std::shared_ptr<const ParsedBuffer> parsed =
+      buffer ? buffer->current() : nullptr;
+  if (!parsed) return nullptr;
+  // Identifiers can only be resolved in the text the project has, which is
+  // that of the last good parse. Others are classified by their kind alone.
+  std::shared_ptr<const SymbolTableHandler::Snapshot> symbols;
+  int64_t generation = -1;
+  if (parsed == buffer->last_good()) {
+    symbols = SymbolsFor(uri)->TakeSnapshot();
+    generation = symbols->generation();
+  }
+  {
+    const std::lock_guard<std::mutex> l(semantic_tokens_lock_);
+    const auto found = semantic_tokens_cache_.find(uri);
+    if (found != semantic_tokens_cache_.end()) {
+      if (previous) *previous = found->second;
+      if (found->second->parsed.lock() == parsed &&
+          found->second->generation == generation) {
+        return found->second;
+      }
+    }
+  }
+
+  const verible::TextStructureView &text = parsed->parser().Data();
+  std::vector<verilog::ResolvedIdentifier> resolved;
+  if (symbols) {
+    SymbolTableHandler::ForEachSymbolIn(
+        *symbols, text.Contents(),
+        [&resolved](absl::string_view identifier,
+                    const SymbolTableNode &definition, bool is_definition) {
+          resolved.push_back(
+              {identifier, definition.Value().metatype, is_definition});
+        });
+    symbols.reset();
+  }
+  auto result = std::make_shared<CachedSemanticTokens>();
+  result->parsed = parsed;
+  result->generation = generation;
+  if (range) {
+    // Not cached, as it might be only a part.
+    result->tokens = verilog::ClassifySemanticTokens(
+        text, resolved, range->start.line, range->end.line + 1);
+    return result;
+  }
+  result->tokens = verilog::ClassifySemanticTokens(text, resolved);
+  result->data = verilog::EncodeSemanticTokens(result->tokens);
+  const std::lock_guard<std::mutex> l(semantic_tokens_lock_);
+  result->result_id = absl::StrCat(++semantic_tokens_results_);
+  // Not for documents that got closed meanwhile.
+  if (EditVersion(uri) >= 0) semantic_tokens_cache_[uri] = result;
+  return result;
+}
+
 void VerilogLanguageServer::PrintStatistics() const {
   if (shutdown_requested_) {
     std::cerr << "Shutting down due to shutdown request." << std::endl;
@@ -163,12 +569,41 @@ void VerilogLanguageServer::PrintStatistics() const {
   for (const auto &stats : dispatcher_.GetStatCounters()) {
     fprintf(stderr, "%30s %9d\n", stats.first.c_str(), stats.second);
   }
+  std::cerr << "Time per method" << std::endl;
+  dispatcher_.latencies().Print(&std::cerr);
+  std::cerr << "Time per phase" << std::endl;
+  verible::PhaseLatencies().Print(&std::cerr);
+  const BufferMemoryStats memory = parsed_buffers_.GetMemoryStats();
+  std::cerr << "Open buffers: " << memory.buffers << ", parsed "
+            << memory.parsed_buffers << " times ("
+            << memory.parsed_bytes / 1024 << " kiB, " << memory.parsed_tokens
+            << " tokens), released " << memory.released_buffers << " ("
+            << memory.released_bytes / 1024 << " kiB)" << std::endl;
 }
 
 verible::lsp::InitializeResult VerilogLanguageServer::InitializeRequestHandler(
     const verible::lsp::InitializeParams &p) {
+  // Edited buffers update the project of their workspace folder.
+  parsed_buffers_.AddChangeListener(
+      [this](const std::string &uri,
+             const verilog::BufferTracker *buffer_tracker) {
+        UpdateEditedFileInProject(uri, buffer_tracker);
+      });
+
   // set VerilogProject for the symbol table, if possible
-  if (!p.rootUri.empty()) {
+  bool configured = false;
+  for (const verible::lsp::WorkspaceFolder &folder : p.workspaceFolders) {
+    const absl::string_view path = verible::lsp::LSPUriToPath(folder.uri);
+    if (path.empty()) {
+      LOG(ERROR) << "Unsupported workspace folder: " << folder.uri;
+      continue;
+    }
+    ConfigureProject(path);
+    configured = true;
+  }
+  if (configured) {
+    UpdateWorkspaceFiles();
+  } else if (!p.rootUri.empty()) {
     absl::string_view path = verible::lsp::LSPUriToPath(p.rootUri);
     if (path.empty()) {
       LOG(ERROR) << "Unsupported rootUri in initialize request:  " << p.rootUri
@@ -183,6 +618,7 @@ verible::lsp::InitializeResult VerilogLanguageServer::InitializeRequestHandler(
               << "from IDE. Assuming root='.'";
     ConfigureProject("");
   }
+  if (!configured) UpdateWorkspaceFiles();
   return GetCapabilities();
 }
 
@@ -194,33 +630,128 @@ void VerilogLanguageServer::ConfigureProject(absl::string_view project_root) {
   if (proj_root.empty()) proj_root = ".";
   proj_root =
       std::filesystem::absolute({proj_root.begin(), proj_root.end()}).string();
+  {
+    const std::lock_guard<std::mutex> l(workspaces_lock_);
+    for (const Workspace &workspace : workspaces_) {
+      if (workspace.root == proj_root) return;
+    }
+  }
   std::shared_ptr<VerilogProject> proj = std::make_shared<VerilogProject>(
       proj_root, std::vector<std::string>(), "");
-  symbol_table_handler_.SetProject(proj);
+  proj->ShareParses(shared_parses_);
+  auto symbols = std::make_shared<verilog::SymbolTableHandler>();
+  symbols->SetProject(proj);
+  {
+    const std::lock_guard<std::mutex> l(workspaces_lock_);
+    workspaces_.push_back({proj_root, symbols});
+  }
 
-  parsed_buffers_.AddChangeListener(
-      [this](const std::string &uri,
-             const verilog::BufferTracker *buffer_tracker) {
-        UpdateEditedFileInProject(uri, buffer_tracker);
-      });
+  // The buffers that were opened before belong to the new project if they
+  // are in its folder.
+  std::vector<std::string> open_uris;
+  {
+    const std::lock_guard<std::mutex> l(edit_versions_lock_);
+    for (const auto &[uri, version] : edit_versions_) open_uris.push_back(uri);
+  }
+  for (const std::string &uri : open_uris) {
+    if (SymbolsFor(uri) != symbols) continue;
+    const BufferTracker *buffer = parsed_buffers_.FindBufferTrackerOrNull(uri);
+    if (buffer) UpdateEditedFileInProject(uri, buffer);
+  }
+}
+
+void VerilogLanguageServer::RemoveProject(absl::string_view project_root) {
+  if (project_root.empty()) return;
+  const std::string proj_root =
+      std::filesystem::absolute({project_root.begin(), project_root.end()})
+          .string();
+  const std::lock_guard<std::mutex> l(workspaces_lock_);
+  workspaces_.erase(std::remove_if(workspaces_.begin(), workspaces_.end(),
+                                   [&proj_root](const Workspace &workspace) {
+                                     return workspace.root == proj_root;
+                                   }),
+                    workspaces_.end());
+}
+
+std::shared_ptr<verilog::SymbolTableHandler> VerilogLanguageServer::SymbolsFor(
+    absl::string_view uri) const {
+  const absl::string_view path = verible::lsp::LSPUriToPath(uri);
+  const std::lock_guard<std::mutex> l(workspaces_lock_);
+  if (workspaces_.empty()) return no_workspace_;
+  const Workspace *innermost = nullptr;
+  for (const Workspace &workspace : workspaces_) {
+    const absl::string_view root = workspace.root;
+    if (!absl::StartsWith(path, root)) continue;
+    if (path.size() > root.size() && path[root.size()] != '/' &&
+        !absl::EndsWith(root, "/")) {
+      continue;  // Only a folder with a longer name.
+    }
+    if (!innermost || innermost->root.size() < root.size()) {
+      innermost = &workspace;
+    }
+  }
+  return innermost ? innermost->symbols : workspaces_.front().symbols;
+}
+
+std::vector<std::shared_ptr<verilog::SymbolTableHandler>>
+VerilogLanguageServer::AllSymbols() const {
+  std::vector<std::shared_ptr<verilog::SymbolTableHandler>> result;
+  const std::lock_guard<std::mutex> l(workspaces_lock_);
+  for (const Workspace &workspace : workspaces_) {
+    result.push_back(workspace.symbols);
+  }
+  return result;
+}
+
+void VerilogLanguageServer::UpdateWorkspaceFiles() {
+  if (!workspace_diagnostics_) return;
+  std::vector<std::string> paths;
+  for (const auto &symbols : AllSymbols()) {
+    const std::vector<std::string> project_paths = symbols->ProjectFilePaths();
+    paths.insert(paths.end(), project_paths.begin(), project_paths.end());
+  }
+  // Nested folders have files in common.
+  std::sort(paths.begin(), paths.end());
+  paths.erase(std::unique(paths.begin(), paths.end()), paths.end());
+  std::vector<std::string> uris;
+  uris.reserve(paths.size());
+  for (const std::string &path : paths) {
+    uris.push_back(verible::lsp::PathToLSPUri(path));
+  }
+  workspace_diagnostics_->SetFiles(uris);
 }
 
 void VerilogLanguageServer::SendDiagnostics(
     const std::string &uri, const verilog::BufferTracker &buffer_tracker) {
-  // TODO(hzeller): Cache result and rate-limit.
-  // This should not send anything if the diagnostics we're about to
-  // send would be exactly the same as last time.
-  verible::lsp::PublishDiagnosticsParams params;
-
+  const auto current = buffer_tracker.current();
+  if (current && current->version() != EditVersion(uri)) {
+    return;  // Not worth linting: a parse of a newer version is underway.
+  }
   // For the diagnostic notification (that we send somewhat unsolicited), we
   // limit the number of diagnostic messages. In the
   // textDocument/diagnostic RPC request, we send all of them.
-  // Arbitrary limit here. Maybe set with flag ?
-  static constexpr int kDiagnosticLimit = 500;
+  PublishDiagnostics(uri, verilog::CreateDiagnostics(
+                              buffer_tracker, published_diagnostics_limit_));
+}
+
+void VerilogLanguageServer::PublishDiagnostics(
+    const std::string &uri,
+    std::vector<verible::lsp::Diagnostic> diagnostics) {
+  verible::lsp::PublishDiagnosticsParams params;
   params.uri = uri;
-  params.diagnostics =
-      verilog::CreateDiagnostics(buffer_tracker, kDiagnosticLimit);
-  dispatcher_.SendNotification("textDocument/publishDiagnostics", params);
+  params.diagnostics = std::move(diagnostics);
+  std::ostringstream serialized;
+  verible::JsonWriter writer(&serialized, -1);
+  params.SerializeTo(&writer);
+  const size_t hash = std::hash<std::string>()(serialized.str());
+  const auto [published, first] =
+      published_diagnostics_hash_.emplace(uri, hash);
+  if (!first) {
+    if (published->second == hash) return;  // Unchanged.
+    published->second = hash;
+  }
+  dispatcher_.SendNotification("textDocument/publishDiagnostics", params,
+                               uri);
 }
 
 void VerilogLanguageServer::UpdateEditedFileInProject(
@@ -230,13 +761,17 @@ void VerilogLanguageServer::UpdateEditedFileInProject(
     LOG(ERROR) << "Could not convert LS URI to path:  " << uri;
     return;
   }
+  const std::shared_ptr<SymbolTableHandler> symbols = SymbolsFor(uri);
   if (!buffer_tracker) {
-    symbol_table_handler_.UpdateFileContent(path, nullptr);
+    symbols->UpdateFileContent(path, nullptr);
     return;
   }
-  if (!buffer_tracker->last_good()) return;
-  symbol_table_handler_.UpdateFileContent(
-      path, &buffer_tracker->last_good()->parser().Data());
+  const std::shared_ptr<const ParsedBuffer> last_good =
+      buffer_tracker->last_good();
+  if (!last_good) return;
+  symbols->UpdateFileContent(path, SharedTextStructure(last_good));
+  // Only does something for the first file opened in each project.
+  symbols->Prefetch(path);
   VLOG(1) << "Updated file:  " << uri << " (" << path << ")";
 }
 
@@ -15,19 +15,31 @@
 #ifndef VERILOG_TOOLS_LS_LS_WRAPPER_H
 #define VERILOG_TOOLS_LS_LS_WRAPPER_H
 
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <set>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
 #include "absl/status/status.h"
+#include "absl/strings/string_view.h"
+#include "absl/time/time.h"
 #include "common/lsp/json-rpc-dispatcher.h"
 #include "common/lsp/lsp-text-buffer.h"
 #include "common/lsp/message-stream-splitter.h"
+#include "verilog/analysis/verilog_project.h"
+#include "verilog/formatting/formatter.h"
 #include "verilog/tools/ls/lsp-parse-buffer.h"
+#include "verilog/tools/ls/semantic-tokens.h"
 #include "verilog/tools/ls/symbol-table-handler.h"
 #include "verilog/tools/ls/verible-lsp-adapter.h"
+#include "verilog/tools/ls/workspace-diagnostics.h"
 
 namespace verilog {
 
-// TODO add support for changing workspace
-// TODO reset symbol table on workspace change?
-
 // Class implementing the Language Server for Verilog
 class VerilogLanguageServer {
  public:
@@ -37,6 +49,9 @@ class VerilogLanguageServer {
   // Constructor preparing the callbacks for Language Server requests
   explicit VerilogLanguageServer(const WriteFun &write_fun);
 
+  // Waits for requests still in progress.
+  ~VerilogLanguageServer();
+
   // Reads single request and responds to it (public to mock in tests).
   absl::Status Step(const ReadFun &read_fun);
 
@@ -46,6 +61,40 @@ class VerilogLanguageServer {
   // Prints statistics of the current Language Server session.
   void PrintStatistics() const;
 
+  // Parse edited buffers in a background thread, once they did not change
+  // for "debounce" time, so that requests are not blocked by parsing.
+  // Without this, buffers are parsed synchronously on each change.
+  void ParseInBackground(absl::Duration debounce);
+
+  // Keep the parse of the latest version of a buffer that has syntax errors,
+  // in addition to its last good version, only for the "limit" most recently
+  // edited buffers. The others keep its text, and parse it again if needed.
+  // Without this, all of them are kept.
+  void LimitRecentlyEditedBuffers(int limit);
+
+  // Answer requests on a buffer, like formatting or highlights, on "threads"
+  // worker threads, so that they don't block later messages.
+  // Without this, all requests are answered in order.
+  void ProcessRequestsConcurrently(int threads);
+
+  // Write messages on a thread of its own, calling "flush" after each batch
+  // of them. Diagnostics of a document that are not written yet are replaced
+  // when newer ones are published.
+  void WriteInBackground(std::function<void()> flush);
+
+  // Publish diagnostics of all files of the project, not just of open
+  // buffers, linting them from disk on "threads" background threads. Each
+  // file is only started once no message came in for "quiet" time. Files are
+  // linted again when the client reports they changed on disk
+  // (workspace/didChangeWatchedFiles). To be called before the project is
+  // configured on initialization.
+  void LintWorkspaceInBackground(int threads, absl::Duration quiet);
+
+  // Publish at most "limit" diagnostics for each document; the
+  // textDocument/diagnostic request still gets all of them. Without this,
+  // up to 500 are published. To be called before LintWorkspaceInBackground().
+  void LimitPublishedDiagnostics(int limit);
+
  private:
   // Creates callbacks for requests from Language Server Client
   void SetRequestHandlers();
@@ -58,16 +107,79 @@ class VerilogLanguageServer {
   // format
   verible::lsp::InitializeResult GetCapabilities();
 
-  // sets up the VerilogProject structure for symbol table, sets listeners for
-  // updating VerilogProject views for edited files
-  // if "project_root" is an empty string, set to either current directory
-  // or directory containing verible.filelist
+  // Sets up a VerilogProject with its symbol table for the workspace folder
+  // "project_root", unless there is one already, and passes it the open
+  // buffers in it.  If "project_root" is an empty string, set to either
+  // current directory or directory containing verible.filelist
   void ConfigureProject(absl::string_view project_root);
 
+  // Drops the project of the workspace folder "project_root", if any.
+  void RemoveProject(absl::string_view project_root);
+
+  // Returns the symbol table of the workspace folder "uri" is in; that of the
+  // innermost one if they nest, of the first one if it is in none, or one
+  // without project before any is configured.
+  std::shared_ptr<verilog::SymbolTableHandler> SymbolsFor(
+      absl::string_view uri) const;
+
+  // Returns the symbol tables of all workspace folders.
+  std::vector<std::shared_ptr<verilog::SymbolTableHandler>> AllSymbols() const;
+
+  // Lint the files of the projects that were not linted yet, if linting the
+  // workspace in the background.
+  void UpdateWorkspaceFiles();
+
   // Publish a diagnostic sent to the server.
   void SendDiagnostics(const std::string &uri,
                        const verilog::BufferTracker &buffer_tracker);
 
+  // Publish "diagnostics" of "uri", unless they are the same as those
+  // published last for it.
+  void PublishDiagnostics(
+      const std::string &uri,
+      std::vector<verible::lsp::Diagnostic> diagnostics);
+
+  using IsCancelled = verible::lsp::JsonRpcDispatcher::IsCancelled;
+  using Result = verible::lsp::JsonRpcDispatcher::Result;
+
+  // Add a handler for requests with "Params" on a single document, that
+  // computes the response with
+  //   fun(const BufferTracker *buffer, const Params &p, const IsCancelled &)
+  // from a snapshot of the buffer, possibly on a worker thread.
+  // Requests that were cancelled or whose document was edited before they
+  // got their turn are dropped.
+  template <typename Params, typename Fun>
+  void AddBufferRequestHandler(const std::string &method, const Fun &fun);
+
+  // Returns the version of the last edit of "uri", or -1 if not open.
+  int64_t EditVersion(const std::string &uri) const;
+
+  // Returns the document symbol outline of the last good parse of "buffer",
+  // which is only created once per parse.
+  nlohmann::json DocumentSymbolOutline(
+      const verilog::BufferTracker *buffer,
+      const verible::lsp::DocumentSymbolParams &p);
+
+  // Semantic tokens of a parse of an open document, with identifiers
+  // resolved in the symbol table "generation", or not resolved if -1.
+  struct CachedSemanticTokens {
+    std::weak_ptr<const verilog::ParsedBuffer> parsed;
+    int64_t generation = -1;
+    std::vector<verilog::SemanticToken> tokens;
+    std::string result_id;  // Only set once cached.
+    std::vector<int> data;  // Encoded tokens.
+  };
+
+  // Returns the semantic tokens of the current parse of "buffer", which are
+  // only classified once per parse and symbol table generation, or nullptr
+  // if there is no parse. If "previous" is given, it is set to those cached
+  // before for "uri", if any. If only the tokens on the lines of "range" are
+  // asked for, and none are cached, only those are classified.
+  std::shared_ptr<const CachedSemanticTokens> SemanticTokensOf(
+      const verilog::BufferTracker *buffer, const std::string &uri,
+      const verible::lsp::Range *range,
+      std::shared_ptr<const CachedSemanticTokens> *previous);
+
   // Updates file contents in the project on change in Language Server Client
   void UpdateEditedFileInProject(const std::string &uri,
                                  const verilog::BufferTracker *buffer_tracker);
@@ -81,14 +193,79 @@ class VerilogLanguageServer {
   // Object for keeping track of updates in opened buffers on client's side
   verible::lsp::BufferCollection text_buffers_;
 
-  // Tracks changes in buffers from BufferCollection and parses their contents
-  verilog::BufferTrackerContainer parsed_buffers_;
+  // Handles requests relying on the symbol table, with a project for each
+  // workspace folder.  The projects share the parses of files with the same
+  // contents, e.g. copies of libraries.
+  struct Workspace {
+    std::string root;  // Absolute path.
+    std::shared_ptr<verilog::SymbolTableHandler> symbols;
+  };
+  mutable std::mutex workspaces_lock_;  // Guards workspaces_.
+  std::vector<Workspace> workspaces_;
+  const std::shared_ptr<verilog::SymbolTableHandler> no_workspace_ =
+      std::make_shared<verilog::SymbolTableHandler>();
+  const std::shared_ptr<verilog::SharedParses> shared_parses_ =
+      std::make_shared<verilog::SharedParses>();
+  // AUTO expansion of the buffer that code actions were last asked for.
+  verilog::AutoExpandCache auto_expand_cache_;
+  // Held while using the AUTO expansion cache, which might happen
+  // concurrently.
+  std::mutex auto_expand_cache_lock_;
+
+  // Formatting of top-level items, reused when formatting buffers again after
+  // edits.
+  verilog::formatter::FormattedItemCache formatted_item_cache_;
+  // Held while formatting, which might happen concurrently.
+  std::mutex formatting_lock_;
+
+  // Documents that got parsed since diagnostics were last sent, if parsing
+  // synchronously. Diagnostics are sent at the end of each Step(), so that a
+  // burst of edits is only linted once.
+  std::set<std::string> diagnostics_due_;
+
+  // See LimitPublishedDiagnostics().
+  int published_diagnostics_limit_ = 500;
 
-  // Handles requests relying on the symbol table
-  verilog::SymbolTableHandler symbol_table_handler_;
+  // Hash of the diagnostics published last for each document, by uri, so
+  // that edits that don't change them (most of them) don't publish them
+  // again. Guarded by dispatch_lock_.
+  std::unordered_map<std::string, size_t> published_diagnostics_hash_;
+
+  // Latest edit version of each open document, by uri.
+  mutable std::mutex edit_versions_lock_;
+  std::unordered_map<std::string, int64_t> edit_versions_;
+
+  // Document symbol outline of each open document, by uri, which editors ask
+  // for after every edit, even if the edit did not parse.
+  struct CachedOutline {
+    std::weak_ptr<const verilog::ParsedBuffer> parsed;
+    nlohmann::json outline;
+  };
+  std::mutex outline_cache_lock_;
+  std::unordered_map<std::string, CachedOutline> outline_cache_;
+
+  // Semantic tokens last sent for each open document, by uri, which the
+  // next semanticTokens/full/delta request is answered relative to.
+  std::mutex semantic_tokens_lock_;
+  std::unordered_map<std::string, std::shared_ptr<const CachedSemanticTokens>>
+      semantic_tokens_cache_;
+  int64_t semantic_tokens_results_ = 0;  // Result ids handed out.
 
   // A flag for indicating "shutdown" request
   bool shutdown_requested_ = false;
+
+  // Held while dispatching a message, and while publishing results of
+  // background parsing, which access the same state.
+  std::mutex dispatch_lock_;
+
+  // Lints all files of the project, see LintWorkspaceInBackground(). Its
+  // threads publish with the above.
+  std::unique_ptr<verilog::WorkspaceDiagnostics> workspace_diagnostics_;
+
+  // Tracks changes in buffers from BufferCollection and parses their contents.
+  // Declared last: its background parse thread uses all of the above, and is
+  // stopped on destruction.
+  verilog::BufferTrackerContainer parsed_buffers_;
 };
 
 };      // namespace verilog
@@ -14,15 +14,21 @@
 
 #include "verilog/tools/ls/verilog-language-server.h"
 
+#include <algorithm>
 #include <filesystem>
+#include <string>
+#include <vector>
 
 #include "absl/flags/flag.h"
+#include "absl/strings/ascii.h"
 #include "absl/strings/match.h"
 #include "common/lsp/lsp-protocol-enums.h"
 #include "common/lsp/lsp-protocol.h"
 #include "common/util/file_util.h"
+#include "common/util/latency_stats.h"
 #include "gtest/gtest.h"
 #include "verilog/analysis/verilog_linter.h"
+#include "verilog/tools/ls/semantic-tokens.h"
 
 #undef ASSERT_OK
 #define ASSERT_OK(value)                             \
@@ -77,6 +83,19 @@ class VerilogLanguageServerTest : public ::testing::Test {
     return ServerStep();
   }
 
+  // Sends several requests at once, so that they are handled in the same
+  // ServerStep().
+  absl::Status SendRequests(const std::vector<std::string> &requests) {
+    std::string stream;
+    for (const std::string &request : requests) {
+      absl::StrAppend(&stream, "Content-Length: ", request.size(), "\r\n\r\n",
+                      request);
+    }
+    request_stream_.clear();
+    request_stream_.str(stream);
+    return ServerStep();
+  }
+
   // Returns the latest responses from the Language Server
   std::string GetResponse() {
     std::string response = response_stream_.str();
@@ -185,6 +204,25 @@ static std::string DidOpenRequest(absl::string_view name,
       .dump();
 }
 
+// Replaces the whole content of the document "name".
+static std::string DidChangeRequest(absl::string_view name,
+                                    absl::string_view content) {
+  return nlohmann::json{
+      {"jsonrpc", "2.0"},
+      {"method", "textDocument/didChange"},
+      {"params",
+       {{"textDocument", {{"uri", name}}},
+        {"contentChanges", {{{"text", content}}}}}}}
+      .dump();
+}
+
+// Number of times a buffer was linted so far, in all tests.
+static int64_t LintCount() {
+  const auto histograms = verible::PhaseLatencies().Histograms();
+  const auto found = histograms.find("lint");
+  return found == histograms.end() ? 0 : found->second.count();
+}
+
 // Checks automatic diagnostics for opened file and textDocument/diagnostic
 // request for file with invalid syntax
 TEST_F(VerilogLanguageServerTest, SyntaxError) {
@@ -266,6 +304,77 @@ TEST_F(VerilogLanguageServerTest, LintErrorDetection) {
   EXPECT_EQ(diagnostic_of_fixed["params"]["diagnostics"].size(), 0);
 }
 
+// Changes that leave the diagnostics as they are don't publish them again.
+TEST_F(VerilogLanguageServerTest, UnchangedDiagnosticsNotPublished) {
+  const std::string open =
+      DidOpenRequest("file://mini.sv", "module mini();\nendmodule");
+  ASSERT_OK(SendRequest(open));
+  const json diagnostics = json::parse(GetResponse());
+  EXPECT_EQ(diagnostics["method"], "textDocument/publishDiagnostics");
+  ASSERT_EQ(diagnostics["params"]["diagnostics"].size(), 1);
+
+  // Replacing a character by itself changes nothing.
+  const absl::string_view same_text =
+      R"({"jsonrpc":"2.0","method":"textDocument/didChange","params":{"textDocument":{"uri":"file://mini.sv"},"contentChanges":[{"range":{"start":{"character":0,"line":0},"end":{"character":1,"line":0}},"text":"m"}]}})";
+  ASSERT_OK(SendRequest(same_text));
+
+  // So the next message is the response to the next request.
+  const absl::string_view symbol_request =
+      R"({"jsonrpc":"2.0", "id":11, "method":"textDocument/documentSymbol","params":{"textDocument":{"uri":"file://mini.sv"}}})";
+  ASSERT_OK(SendRequest(symbol_request));
+  const json response = json::parse(GetResponse());
+  EXPECT_EQ(response["id"], 11);
+}
+
+// A burst of edits handled in the same step only lints and publishes the
+// diagnostics of the last one.
+TEST_F(VerilogLanguageServerTest, BurstOfEditsPublishedOnce) {
+  ASSERT_OK(SendRequest(
+      DidOpenRequest("file://mini.sv", "module mini();\nendmodule\n")));
+  const json diagnostics = json::parse(GetResponse());
+  ASSERT_EQ(diagnostics["params"]["diagnostics"].size(), 0);
+
+  const int64_t lints_before = LintCount();
+  ASSERT_OK(SendRequests({
+      DidChangeRequest("file://mini.sv", "module mini();\nendmodule"),
+      DidChangeRequest("file://mini.sv", "module mini();\tendmodule\n"),
+      DidChangeRequest("file://mini.sv", "module mini(); \nendmodule\n"),
+  }));
+  EXPECT_EQ(LintCount() - lints_before, 1);
+
+  // A single message, with the diagnostics of the last version.
+  const std::string response = GetResponse();
+  ASSERT_TRUE(json::accept(response)) << response;
+  const json published = json::parse(response);
+  EXPECT_EQ(published["method"], "textDocument/publishDiagnostics");
+  EXPECT_EQ(published["params"]["uri"], "file://mini.sv");
+  const json &published_diagnostics = published["params"]["diagnostics"];
+  ASSERT_EQ(published_diagnostics.size(), 1);
+  EXPECT_TRUE(absl::StrContains(
+      published_diagnostics[0]["message"].get<std::string>(),
+      "no-trailing-spaces"));
+}
+
+// Requests that don't need the lint result of a version don't lint it.
+TEST_F(VerilogLanguageServerTest, RequestsWithoutDiagnosticsDontLint) {
+  ASSERT_OK(SendRequest(
+      DidOpenRequest("file://mini.sv", "module mini();\nendmodule\n")));
+  GetResponse();
+
+  const int64_t lints_before = LintCount();
+  ASSERT_OK(SendRequests({
+      DidChangeRequest("file://mini.sv", "module mini();\nendmodule"),
+      R"({"jsonrpc":"2.0", "id":11, "method":"textDocument/documentSymbol","params":{"textDocument":{"uri":"file://mini.sv"}}})",
+      R"({"jsonrpc":"2.0", "id":12, "method":"textDocument/documentHighlight","params":{"textDocument":{"uri":"file://mini.sv"},"position":{"line":0,"character":8}}})",
+      DidChangeRequest("file://mini.sv", "module mini(); \nendmodule\n"),
+  }));
+  // Only the last version is linted, for its diagnostics.
+  EXPECT_EQ(LintCount() - lints_before, 1);
+  const std::string response = GetResponse();
+  EXPECT_TRUE(absl::StrContains(response, R"("id":11)")) << response;
+  EXPECT_TRUE(absl::StrContains(response, R"("id":12)")) << response;
+}
+
 // Tests textDocument/documentSymbol request support; expect document outline.
 TEST_F(VerilogLanguageServerTest, DocumentSymbolRequestTest) {
   // Create file, absorb diagnostics
@@ -334,6 +443,28 @@ endmodule
   EXPECT_EQ(module.size(), 1);
   EXPECT_EQ(module[0].kind, verible::lsp::SymbolKind::kNamespace);
   EXPECT_EQ(module[0].name, "labelled_block");
+
+  // Ranges span from the first to the last token of each symbol.
+  EXPECT_EQ(toplevel[0].range.start.line, 1);
+  EXPECT_EQ(toplevel[0].range.start.character, 0);
+  EXPECT_EQ(toplevel[0].range.end.line, 10);
+  EXPECT_EQ(toplevel[0].range.end.character, 10);
+  EXPECT_EQ(toplevel[1].range.start.line, 12);
+  EXPECT_EQ(toplevel[1].range.end.line, 15);
+  EXPECT_EQ(toplevel[1].selectionRange.start.character, 7);
+  EXPECT_EQ(module[0].range.start.line, 13);
+  EXPECT_EQ(module[0].range.end.line, 14);
+
+  // After an edit that does not parse, the outline of the last good version
+  // is still there.
+  const absl::string_view broken_edit =
+      R"({"jsonrpc":"2.0","method":"textDocument/didChange","params":{"textDocument":{"uri":"file://mini_pkg.sv"},"contentChanges":[{"range":{"start":{"character":0,"line":11},"end":{"character":0,"line":11}},"text":"("}]}})";
+  ASSERT_OK(SendRequest(broken_edit));
+  const json broken_diagnostics = json::parse(GetResponse());
+  EXPECT_EQ(broken_diagnostics["method"], "textDocument/publishDiagnostics");
+  ASSERT_OK(SendRequest(document_symbol_request));
+  const json document_symbol_again = json::parse(GetResponse());
+  EXPECT_EQ(document_symbol_again["result"], document_symbol["result"]);
 }
 
 // Tests closing of the file in the LS context and checks if the LS
@@ -409,35 +540,41 @@ TEST_F(VerilogLanguageServerTest, SymbolHighlightingTest) {
   EXPECT_EQ(highlight_response2["result"].size(), 0);
 }
 
+// Returns the ASCII "text" with the non-overlapping "edits" of a formatting
+// response applied.  Checks that the edits only change whitespace.
+std::string ApplyFormattingEdits(absl::string_view text, const json &edits) {
+  std::vector<size_t> line_starts = {0};
+  for (size_t i = 0; i < text.size(); ++i) {
+    if (text[i] == '\n') line_starts.push_back(i + 1);
+  }
+  const auto offset = [&](const json &position) {
+    return line_starts[position["line"].get<int>()] +
+           position["character"].get<int>();
+  };
+  std::string result(text);
+  // Back to front, so that offsets stay valid.
+  for (auto edit = edits.rbegin(); edit != edits.rend(); ++edit) {
+    const size_t begin = offset((*edit)["range"]["start"]);
+    const size_t end = offset((*edit)["range"]["end"]);
+    const std::string new_text = (*edit)["newText"];
+    EXPECT_TRUE(absl::StripAsciiWhitespace(result.substr(begin, end - begin))
+                    .empty() &&
+                absl::StripAsciiWhitespace(new_text).empty())
+        << (*edit).dump();
+    result.replace(begin, end - begin, new_text);
+  }
+  return result;
+}
+
 // Tests structure holding data for test textDocument/rangeFormatting requests
 struct FormattingRequestParams {
-  FormattingRequestParams(int id, int start_line, int start_character,
-                          int end_line, int end_character,
-                          absl::string_view new_text, int new_text_start_line,
-                          int new_text_start_character, int new_text_end_line,
-                          int new_text_end_character)
-      : id(id),
-        start_line(start_line),
-        start_character(start_character),
-        end_line(end_line),
-        end_character(end_character),
-        new_text(new_text),
-        new_text_start_line(new_text_start_line),
-        new_text_start_character(new_text_start_character),
-        new_text_end_line(new_text_end_line),
-        new_text_end_character(new_text_end_character) {}
-
   int id;
   int start_line;
   int start_character;
   int end_line;
   int end_character;
 
-  absl::string_view new_text;
-  int new_text_start_line;
-  int new_text_start_character;
-  int new_text_end_line;
-  int new_text_end_character;
+  absl::string_view formatted_text;  // whole text with the edits applied
 };
 
 // Creates a textDocument/rangeFormatting request from FormattingRequestParams
@@ -464,8 +601,9 @@ std::string FormattingRequest(absl::string_view file,
 // Runs tests for textDocument/rangeFormatting requests
 TEST_F(VerilogLanguageServerTest, RangeFormattingTest) {
   // Create sample file and make sure diagnostics do not have errors
-  const std::string mini_module = DidOpenRequest(
-      "file://fmt.sv", "module fmt();\nassign a=1;\nassign b=2;endmodule\n");
+  constexpr absl::string_view kText =
+      "module fmt();\nassign a=1;\nassign b=2;endmodule\n";
+  const std::string mini_module = DidOpenRequest("file://fmt.sv", kText);
   ASSERT_OK(SendRequest(mini_module));
 
   const json diagnostics = json::parse(GetResponse());
@@ -477,11 +615,14 @@ TEST_F(VerilogLanguageServerTest, RangeFormattingTest) {
   EXPECT_EQ(diagnostics["params"]["diagnostics"].size(), 0)
       << "The test file has errors";
   const std::vector<FormattingRequestParams> formatting_params{
-      {30, 1, 0, 2, 0, "  assign a=1;\n", 1, 0, 2, 0},
-      {31, 1, 0, 1, 1, "  assign a=1;\n", 1, 0, 2, 0},
-      {32, 2, 0, 2, 1, "  assign b=2;\nendmodule\n", 2, 0, 3, 0},
-      {33, 1, 0, 3, 0, "  assign a = 1;\n  assign b = 2;\nendmodule\n", 1, 0, 3,
-       0}};
+      {30, 1, 0, 2, 0,
+       "module fmt();\n  assign a=1;\nassign b=2;endmodule\n"},
+      {31, 1, 0, 1, 1,
+       "module fmt();\n  assign a=1;\nassign b=2;endmodule\n"},
+      {32, 2, 0, 2, 1,
+       "module fmt();\nassign a=1;\n  assign b=2;\nendmodule\n"},
+      {33, 1, 0, 3, 0,
+       "module fmt();\n  assign a = 1;\n  assign b = 2;\nendmodule\n"}};
 
   for (const auto &params : formatting_params) {
     std::string request = FormattingRequest("file://fmt.sv", params);
@@ -489,30 +630,18 @@ TEST_F(VerilogLanguageServerTest, RangeFormattingTest) {
 
     const json response = json::parse(GetResponse());
     EXPECT_EQ(response["id"], params.id) << "Invalid id";
-    EXPECT_EQ(response["result"].size(), 1)
-        << "Invalid result size for id:  " << params.id;
-    EXPECT_EQ(std::string(response["result"][0]["newText"]), params.new_text)
-        << "Invalid patch for id:  " << params.id;
-    EXPECT_EQ(response["result"][0]["range"]["start"]["line"],
-              params.new_text_start_line)
-        << "Invalid range for id:  " << params.id;
-    EXPECT_EQ(response["result"][0]["range"]["start"]["character"],
-              params.new_text_start_character)
-        << "Invalid range for id:  " << params.id;
-    EXPECT_EQ(response["result"][0]["range"]["end"]["line"],
-              params.new_text_end_line)
-        << "Invalid range for id:  " << params.id;
-    EXPECT_EQ(response["result"][0]["range"]["end"]["character"],
-              params.new_text_end_character)
-        << "Invalid range for id:  " << params.id;
+    EXPECT_EQ(ApplyFormattingEdits(kText, response["result"]),
+              params.formatted_text)
+        << "Invalid edits for id:  " << params.id;
   }
 }
 
 // Runs test of entire document formatting with textDocument/formatting request
 TEST_F(VerilogLanguageServerTest, FormattingTest) {
   // Create sample file and make sure diagnostics do not have errors
-  const std::string mini_module = DidOpenRequest(
-      "file://fmt.sv", "module fmt();\nassign a=1;\nassign b=2;endmodule\n");
+  constexpr absl::string_view kText =
+      "module fmt();\nassign a=1;\nassign b=2;endmodule\n";
+  const std::string mini_module = DidOpenRequest("file://fmt.sv", kText);
   ASSERT_OK(SendRequest(mini_module));
 
   const json diagnostics = json::parse(GetResponse());
@@ -531,19 +660,44 @@ TEST_F(VerilogLanguageServerTest, FormattingTest) {
 
   const json response = json::parse(GetResponse());
   EXPECT_EQ(response["id"], 34);
-  EXPECT_EQ(response["result"].size(), 1);
-  EXPECT_EQ(std::string(response["result"][0]["newText"]),
+  EXPECT_EQ(ApplyFormattingEdits(kText, response["result"]),
             "module fmt ();\n  assign a = 1;\n  assign b = 2;\nendmodule\n");
-  EXPECT_EQ(
-      response["result"][0]["range"],
-      json::parse(
-          R"({"start":{"line":0, "character": 0}, "end":{"line":3, "character": 0}})"));
+  // Only the whitespace that changes is sent, e.g. the space before "(".
+  EXPECT_EQ(response["result"].size(), 8);
+  EXPECT_EQ(response["result"][0], json::parse(R"(
+{"range": {"start":{"line":0, "character": 10},
+           "end":  {"line":0, "character": 10}},
+ "newText": " "})"));
+}
+
+TEST_F(VerilogLanguageServerTest, StatsReportTimePerMethodAndPhase) {
+  ASSERT_OK(SendRequest(DidOpenRequest(
+      "file://fmt.sv", "module fmt();\nassign a=1;\nendmodule\n")));
+  GetResponse();
+  ASSERT_OK(SendRequest(R"(
+{"jsonrpc":"2.0", "id":2,
+ "method": "textDocument/formatting",
+ "params": {"textDocument":{"uri":"file://fmt.sv"}}})"));
+  GetResponse();
+
+  ASSERT_OK(
+      SendRequest(R"({"jsonrpc":"2.0", "id":3, "method":"$/verible/stats"})"));
+  const json stats = json::parse(GetResponse())["result"];
+  const json &formatting = stats["methods"]["textDocument/formatting"];
+  EXPECT_EQ(formatting["count"], 1);
+  EXPECT_GE(formatting["p99Ms"].get<double>(),
+            formatting["p50Ms"].get<double>());
+  EXPECT_GE(stats["methods"]["json decode"]["count"].get<int>(), 3);
+  EXPECT_GE(stats["phases"]["parse"]["count"].get<int>(), 1);
+  EXPECT_GE(stats["phases"]["format"]["count"].get<int>(), 1);
+  EXPECT_EQ(stats["counters"]["textDocument/formatting RPC"], 1);
 }
 
 TEST_F(VerilogLanguageServerTest, FormattingFileWithEmptyNewline_issue1667) {
-  const std::string fmt_module = DidOpenRequest(
-      "file://fmt.sv", "module fmt();\nassign a=1;\nassign b=2;endmodule");
-  // ---------------------------------------------------- no newline ---^
+  constexpr absl::string_view kText =
+      "module fmt();\nassign a=1;\nassign b=2;endmodule";
+  // ------------------------------------------- no newline ---^
+  const std::string fmt_module = DidOpenRequest("file://fmt.sv", kText);
   ASSERT_OK(SendRequest(fmt_module));
 
   GetResponse();  // Ignore diagnostics.
@@ -558,13 +712,14 @@ TEST_F(VerilogLanguageServerTest, FormattingFileWithEmptyNewline_issue1667) {
   const json response = json::parse(GetResponse());
 
   // Formatted output now has a newline at end.
-  EXPECT_EQ(std::string(response["result"][0]["newText"]),
+  EXPECT_EQ(ApplyFormattingEdits(kText, response["result"]),
             "module fmt ();\n  assign a = 1;\n  assign b = 2;\nendmodule\n");
 
-  // Full range of original file, including the characters of the last line.
-  EXPECT_EQ(response["result"][0]["range"], json::parse(R"(
-{"start":{"line":0, "character": 0},
- "end":  {"line":2, "character": 20}})"));
+  // Inserted after the characters of the last line.
+  EXPECT_EQ(response["result"].back(), json::parse(R"(
+{"range": {"start":{"line":2, "character": 20},
+           "end":  {"line":2, "character": 20}},
+ "newText": "\n"})"));
 }
 
 // Creates a textDocument/definition request
@@ -1129,6 +1284,151 @@ endmodule
   ASSERT_EQ(response["result"][0]["uri"], "file://" + module_bar_1.filename());
 }
 
+TEST_F(VerilogLanguageServerSymbolTableTest, HoverShowsDefinition) {
+  static constexpr absl::string_view  //
+      bar(
+          R"(module bar();
+endmodule
+)");
+  static constexpr absl::string_view  //
+      foo(
+          R"(module foo();
+  bar x;
+endmodule
+)");
+  const verible::file::testing::ScopedTestFile filelist(
+      root_dir, "bar.sv\nfoo.sv\n", "verible.filelist");
+  const verible::file::testing::ScopedTestFile module_bar(root_dir, bar,
+                                                          "bar.sv");
+  const verible::file::testing::ScopedTestFile module_foo(root_dir, foo,
+                                                          "foo.sv");
+  const std::string foo_uri = "file://" + module_foo.filename();
+  ASSERT_OK(SendRequest(DidOpenRequest(foo_uri, foo)));
+  GetResponse();
+
+  const json hover_request = {
+      {"jsonrpc", "2.0"},
+      {"id", 2},
+      {"method", "textDocument/hover"},
+      {"params",
+       {{"textDocument", {{"uri", foo_uri}}},
+        {"position", {{"line", 1}, {"character", 3}}}}}};
+  ASSERT_OK(SendRequest(hover_request.dump()));
+  const json response = json::parse(GetResponse());
+  ASSERT_EQ(response["id"], 2);
+  EXPECT_TRUE(absl::StrContains(
+      response["result"]["contents"]["value"].get<std::string>(),
+      "module bar();"));
+  EXPECT_EQ(response["result"]["range"], json::parse(R"(
+{"start":{"line":1, "character": 2},
+ "end":  {"line":1, "character": 5}})"));
+
+  // Nothing to tell about keywords.
+  const json keyword_request = {
+      {"jsonrpc", "2.0"},
+      {"id", 3},
+      {"method", "textDocument/hover"},
+      {"params",
+       {{"textDocument", {{"uri", foo_uri}}},
+        {"position", {{"line", 2}, {"character", 3}}}}}};
+  ASSERT_OK(SendRequest(keyword_request.dump()));
+  EXPECT_TRUE(json::parse(GetResponse())["result"].is_null());
+}
+
+TEST_F(VerilogLanguageServerSymbolTableTest, SemanticTokensFullAndDelta) {
+  static constexpr absl::string_view  //
+      bar(
+          R"(module bar();
+endmodule
+)");
+  static constexpr absl::string_view  //
+      foo(
+          R"(module foo();
+  bar x;
+endmodule
+)");
+  const verible::file::testing::ScopedTestFile filelist(
+      root_dir, "bar.sv\nfoo.sv\n", "verible.filelist");
+  const verible::file::testing::ScopedTestFile module_bar(root_dir, bar,
+                                                          "bar.sv");
+  const verible::file::testing::ScopedTestFile module_foo(root_dir, foo,
+                                                          "foo.sv");
+  const std::string foo_uri = "file://" + module_foo.filename();
+  ASSERT_OK(SendRequest(DidOpenRequest(foo_uri, foo)));
+  GetResponse();
+
+  const json full_request = {
+      {"jsonrpc", "2.0"},
+      {"id", 2},
+      {"method", "textDocument/semanticTokens/full"},
+      {"params", {{"textDocument", {{"uri", foo_uri}}}}}};
+  ASSERT_OK(SendRequest(full_request.dump()));
+  const json full = json::parse(GetResponse())["result"];
+  const std::vector<int> data = full["data"];
+  ASSERT_EQ(data.size() % 5, 0);
+  ASSERT_GE(data.size(), 5);
+  // "module" keyword first.
+  EXPECT_EQ(std::vector<int>(data.begin(), data.begin() + 5),
+            std::vector<int>({0, 0, 6,
+                              static_cast<int>(SemanticTokenType::kKeyword),
+                              0}));
+  // "bar" refers to a module.
+  bool found_bar = false;
+  int line = 0;
+  int column = 0;
+  for (size_t i = 0; i < data.size(); i += 5) {
+    column = data[i] == 0 ? column + data[i + 1] : data[i + 1];
+    line += data[i];
+    if (line == 1 && column == 2) {
+      found_bar = true;
+      EXPECT_EQ(data[i + 2], 3);
+      EXPECT_EQ(data[i + 3], static_cast<int>(SemanticTokenType::kNamespace));
+    }
+  }
+  EXPECT_TRUE(found_bar);
+
+  // Nothing changed since.
+  const json delta_request = {
+      {"jsonrpc", "2.0"},
+      {"id", 3},
+      {"method", "textDocument/semanticTokens/full/delta"},
+      {"params",
+       {{"textDocument", {{"uri", foo_uri}}},
+        {"previousResultId", full["resultId"]}}}};
+  ASSERT_OK(SendRequest(delta_request.dump()));
+  const json delta = json::parse(GetResponse())["result"];
+  EXPECT_EQ(delta["resultId"], full["resultId"]);
+  EXPECT_TRUE(delta["edits"].empty());
+
+  // Unknown result ids get all tokens.
+  const json unknown_request = {
+      {"jsonrpc", "2.0"},
+      {"id", 4},
+      {"method", "textDocument/semanticTokens/full/delta"},
+      {"params",
+       {{"textDocument", {{"uri", foo_uri}}}, {"previousResultId", "none"}}}};
+  ASSERT_OK(SendRequest(unknown_request.dump()));
+  EXPECT_EQ(json::parse(GetResponse())["result"]["data"], full["data"]);
+
+  // Only the tokens of the second line.
+  const json range_request = {
+      {"jsonrpc", "2.0"},
+      {"id", 5},
+      {"method", "textDocument/semanticTokens/range"},
+      {"params",
+       {{"textDocument", {{"uri", foo_uri}}},
+        {"range",
+         {{"start", {{"line", 1}, {"character", 0}}},
+          {"end", {{"line", 1}, {"character", 8}}}}}}}};
+  ASSERT_OK(SendRequest(range_request.dump()));
+  const std::vector<int> range_data =
+      json::parse(GetResponse())["result"]["data"];
+  ASSERT_GE(range_data.size(), 5);
+  EXPECT_EQ(range_data[0], 1);
+  EXPECT_EQ(range_data[1], 2);
+  EXPECT_EQ(range_data[3], static_cast<int>(SemanticTokenType::kNamespace));
+}
+
 // Sample of badly styled modle
 constexpr static absl::string_view badly_styled_module =
     "module my_module(input logic in, output logic out);\n\tassign out = in; "
@@ -1228,6 +1528,96 @@ TEST_F(VerilogLanguageServerSymbolTableTest,
       diagnostics["params"]["diagnostics"], "posix-eof"));
 }
 
+// A workspace with the folders "one" and "two" in root_dir.
+class VerilogLanguageServerWorkspaceFoldersTest
+    : public VerilogLanguageServerSymbolTableTest {
+ public:
+  absl::Status InitializeCommunication() override {
+    dir_one = verible::file::JoinPath(root_dir, "one");
+    dir_two = verible::file::JoinPath(root_dir, "two");
+    for (const std::string &dir : {dir_one, dir_two}) {
+      if (absl::Status status = verible::file::CreateDir(dir); !status.ok()) {
+        return status;
+      }
+    }
+    const json initialize_request = {
+        {"jsonrpc", "2.0"},
+        {"id", 1},
+        {"method", "initialize"},
+        {"params",
+         {{"rootUri", "file://" + root_dir},
+          {"workspaceFolders",
+           {{{"uri", "file://" + dir_one}, {"name", "one"}},
+            {{"uri", "file://" + dir_two}, {"name", "two"}}}}}}};
+    return SendRequest(initialize_request.dump());
+  }
+
+ protected:
+  // Returns the uris of the modules found by workspace/symbol for "query".
+  std::vector<std::string> FindModules(absl::string_view query) {
+    const json request = {{"jsonrpc", "2.0"},
+                          {"id", 10},
+                          {"method", "workspace/symbol"},
+                          {"params", {{"query", query}}}};
+    EXPECT_TRUE(SendRequest(request.dump()).ok());
+    std::vector<std::string> uris;
+    for (const json &symbol : json::parse(GetResponse())["result"]) {
+      if (symbol["name"] != std::string(query)) continue;
+      uris.push_back(symbol["location"]["uri"].get<std::string>());
+    }
+    std::sort(uris.begin(), uris.end());
+    return uris;
+  }
+
+  std::string dir_one;
+  std::string dir_two;
+};
+
+// Each workspace folder is a project of its own, with its own definitions.
+TEST_F(VerilogLanguageServerWorkspaceFoldersTest, ProjectPerFolder) {
+  const json capabilities = json::parse(GetInitializeResponse())["result"];
+  EXPECT_EQ(capabilities.at("capabilities")
+                .at("workspace")
+                .at("workspaceFolders")
+                .at("changeNotifications"),
+            true);
+
+  static constexpr absl::string_view lib("module lib;\nendmodule\n");
+  static constexpr absl::string_view top(
+      "module top;\n  lib l();\nendmodule\n");
+  using verible::file::testing::ScopedTestFile;
+  const ScopedTestFile filelist_one(dir_one, "lib.sv\n", "verible.filelist");
+  const ScopedTestFile lib_one(dir_one, lib, "lib.sv");
+  const ScopedTestFile filelist_two(dir_two, "lib.sv\ntop.sv\n",
+                                    "verible.filelist");
+  const ScopedTestFile lib_two(dir_two, lib, "lib.sv");
+  const ScopedTestFile top_two(dir_two, top, "top.sv");
+
+  EXPECT_EQ(FindModules("lib"),
+            std::vector<std::string>({"file://" + lib_one.filename(),
+                                      "file://" + lib_two.filename()}));
+
+  // A file is looked up in the project of its folder.
+  const std::string top_uri = "file://" + top_two.filename();
+  ASSERT_OK(SendRequest(DidOpenRequest(top_uri, top)));
+  GetResponse();
+  ASSERT_OK(SendRequest(DefinitionRequest(top_uri, 2, 1, 3)));
+  const json definition = json::parse(GetResponse());
+  ASSERT_EQ(definition["result"].size(), 1);
+  EXPECT_EQ(definition["result"][0]["uri"], "file://" + lib_two.filename());
+
+  const json remove_folder = {
+      {"jsonrpc", "2.0"},
+      {"method", "workspace/didChangeWorkspaceFolders"},
+      {"params",
+       {{"event",
+         {{"added", json::array()},
+          {"removed", {{{"uri", "file://" + dir_one}, {"name", "one"}}}}}}}}};
+  ASSERT_OK(SendRequest(remove_folder.dump()));
+  EXPECT_EQ(FindModules("lib"),
+            std::vector<std::string>({"file://" + lib_two.filename()}));
+}
+
 // Tests correctness of Language Server shutdown request
 TEST_F(VerilogLanguageServerTest, ShutdownTest) {
   const absl::string_view shutdown_request =
@@ -15,8 +15,12 @@
 
 #include <functional>
 #include <iostream>
+#include <string>
 
+#include "absl/flags/flag.h"
+#include "absl/time/time.h"
 #include "common/util/init_command_line.h"
+#include "common/util/trace_events.h"
 #include "verilog/tools/ls/verilog-language-server.h"
 
 #ifndef _WIN32
@@ -29,8 +33,44 @@
 #define read(fd, buf, size) _read(fd, buf, size)
 #endif
 
+ABSL_FLAG(int, parse_debounce_ms, 100,
+          "Parse edited files in the background, once they did not change "
+          "for this many milliseconds. If 0, parse synchronously on every "
+          "change.");
+
+ABSL_FLAG(int, request_threads, 2,
+          "Answer requests that only read a buffer, like formatting, on this "
+          "many worker threads so that they don't hold up later requests. "
+          "If 0, answer all requests in order.");
+
+ABSL_FLAG(int, recent_buffers, 16,
+          "Keep the parse of the latest version of a buffer with syntax "
+          "errors, besides that of its last good version, only for this many "
+          "most recently edited buffers; others parse it again when needed. "
+          "If 0, keep all of them.");
+
+ABSL_FLAG(int, workspace_lint_threads, 0,
+          "If > 0, publish diagnostics of all files of the project "
+          "(verible.filelist), not just of open buffers, linting them in the "
+          "background on this many threads whenever the editor is idle.");
+
+ABSL_FLAG(int, diagnostics_limit, 500,
+          "Publish at most this many diagnostics for each document, so that "
+          "files with very many of them don't hold up the editor. Requests "
+          "for the diagnostics of a document still get all of them. If "
+          "negative, all of them are published.");
+
+ABSL_FLAG(std::string, trace_output, "",
+          "If not empty, write a trace of the requests and the parsing, "
+          "linting and symbol table work they cause to this file on exit, in "
+          "Chrome trace event format (chrome://tracing, ui.perfetto.dev).");
+
 int main(int argc, char *argv[]) {
   verible::InitCommandLine(argv[0], &argc, &argv);
+  if (const std::string trace_output = absl::GetFlag(FLAGS_trace_output);
+      !trace_output.empty()) {
+    verible::EnableTraceOutput(trace_output);
+  }
 
 #ifdef _WIN32
   // Windows messes with newlines by default. Fix this here.
@@ -43,12 +83,30 @@ int main(int argc, char *argv[]) {
 
   // -- Input and output is stdin and stdout.
 
-  // Output: provided write-function is called with entire response messages.
+  // Output: provided write-function is called with entire response messages,
+  // on a writer thread that flushes after each batch of them.
   verilog::VerilogLanguageServer server([](absl::string_view reply) {
     // Output formatting as header/body chunk as required by LSP spec to stdout.
     std::cout << "Content-Length: " << reply.size() << "\r\n\r\n";
-    std::cout << reply << std::flush;
+    std::cout << reply;
   });
+  server.WriteInBackground([]() { std::cout << std::flush; });
+
+  if (const int debounce_ms = absl::GetFlag(FLAGS_parse_debounce_ms);
+      debounce_ms > 0) {
+    server.ParseInBackground(absl::Milliseconds(debounce_ms));
+  }
+  server.ProcessRequestsConcurrently(absl::GetFlag(FLAGS_request_threads));
+  server.LimitPublishedDiagnostics(absl::GetFlag(FLAGS_diagnostics_limit));
+  if (const int lint_threads = absl::GetFlag(FLAGS_workspace_lint_threads);
+      lint_threads > 0) {
+    // Only in pauses between messages, to not slow down typing.
+    server.LintWorkspaceInBackground(lint_threads, absl::Milliseconds(500));
+  }
+  if (const int recent_buffers = absl::GetFlag(FLAGS_recent_buffers);
+      recent_buffers > 0) {
+    server.LimitRecentlyEditedBuffers(recent_buffers);
+  }
 
   // Input: Messages received from the read function are dispatched and
   // processed until shutdown message received.
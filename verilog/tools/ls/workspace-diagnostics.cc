@@ -0,0 +1,169 @@
+// Copyright 2023 The Verible Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "verilog/tools/ls/workspace-diagnostics.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <unordered_set>
+#include <vector>
+
+#include "absl/strings/string_view.h"
+#include "absl/time/clock.h"
+#include "absl/time/time.h"
+#include "common/lsp/lsp-file-utils.h"
+#include "common/util/file_util.h"
+#include "common/util/logging.h"
+#include "verilog/tools/ls/lsp-parse-buffer.h"
+#include "verilog/tools/ls/verible-lsp-adapter.h"
+
+namespace verilog {
+
+WorkspaceDiagnostics::WorkspaceDiagnostics(int threads, absl::Duration quiet,
+                                           int message_limit,
+                                           const PublishFun &publish)
+    : quiet_(quiet),
+      message_limit_(message_limit),
+      publish_(ABSL_DIE_IF_NULL(publish)) {
+  for (int i = 0; i < std::max(threads, 1); ++i) {
+    threads_.emplace_back([this]() { LintLoop(); });
+  }
+}
+
+WorkspaceDiagnostics::~WorkspaceDiagnostics() {
+  {
+    const std::lock_guard<std::mutex> l(lock_);
+    exiting_ = true;
+  }
+  changed_.notify_all();
+  for (std::thread &thread : threads_) thread.join();
+}
+
+void WorkspaceDiagnostics::SetFiles(const std::vector<std::string> &uris) {
+  const std::unordered_set<std::string> workspace(uris.begin(), uris.end());
+  const std::lock_guard<std::mutex> l(lock_);
+  for (auto &file : files_) {
+    if (file.second.in_workspace && !workspace.count(file.first)) {
+      file.second.in_workspace = false;  // Clears its diagnostics.
+      Enqueue(file.first, &file.second);
+    }
+  }
+  for (const std::string &uri : uris) {
+    auto inserted = files_.emplace(uri, FileState{.in_workspace = false});
+    FileState &state = inserted.first->second;
+    if (state.in_workspace) continue;  // Already known.
+    state.in_workspace = true;
+    Enqueue(uri, &state);
+  }
+  changed_.notify_all();
+}
+
+void WorkspaceDiagnostics::FileChanged(const std::string &uri) {
+  const std::lock_guard<std::mutex> l(lock_);
+  auto found = files_.find(uri);
+  if (found == files_.end() || !found->second.in_workspace) return;
+  Enqueue(uri, &found->second);
+  changed_.notify_all();
+}
+
+void WorkspaceDiagnostics::Busy() {
+  const std::lock_guard<std::mutex> l(lock_);
+  last_busy_ = absl::Now();
+}
+
+void WorkspaceDiagnostics::WaitUntilDone() {
+  std::unique_lock<std::mutex> l(lock_);
+  changed_.wait(l, [this]() { return queue_.empty() && in_progress_ == 0; });
+}
+
+int64_t WorkspaceDiagnostics::linted_files() const {
+  const std::lock_guard<std::mutex> l(lock_);
+  return linted_files_;
+}
+
+void WorkspaceDiagnostics::Enqueue(const std::string &uri, FileState *state) {
+  // A lint of the previous content in progress is not published.
+  state->generation = ++generations_;
+  if (state->queued) return;
+  state->queued = true;
+  queue_.push_back(uri);
+}
+
+// Returns the diagnostics of the file "uri" on disk, linted on a single
+// thread, or none if it can't be read.
+static std::vector<verible::lsp::Diagnostic> LintFile(const std::string &uri,
+                                                      int message_limit) {
+  const absl::string_view path = verible::lsp::LSPUriToPath(uri);
+  const auto content = verible::file::GetContentAsString(path);
+  if (!content.ok()) {
+    VLOG(1) << "Not linting " << uri << ": " << content.status();
+    return {};
+  }
+  const ParsedBuffer parsed(0, uri, *content);
+  parsed.lint_result(nullptr);
+  return CreateDiagnostics(parsed, message_limit);
+}
+
+void WorkspaceDiagnostics::LintLoop() {
+  std::unique_lock<std::mutex> l(lock_);
+  while (!exiting_) {
+    if (queue_.empty()) {
+      changed_.wait(l);
+      continue;
+    }
+    const absl::Time start_time = last_busy_ + quiet_;
+    const absl::Time now = absl::Now();
+    if (start_time > now) {
+      changed_.wait_for(l, absl::ToChronoNanoseconds(start_time - now));
+      continue;
+    }
+    const std::string uri = std::move(queue_.front());
+    queue_.pop_front();
+    FileState &state = files_[uri];
+    state.queued = false;
+    const int64_t generation = state.generation;
+    const bool in_workspace = state.in_workspace;
+    ++in_progress_;
+    l.unlock();
+
+    std::vector<verible::lsp::Diagnostic> diagnostics;
+    if (in_workspace) diagnostics = LintFile(uri, message_limit_);
+    PublishIfCurrent(uri, generation, diagnostics);
+
+    l.lock();
+    if (in_workspace) ++linted_files_;
+    --in_progress_;
+    changed_.notify_all();
+  }
+}
+
+void WorkspaceDiagnostics::PublishIfCurrent(
+    const std::string &uri, int64_t generation,
+    const std::vector<verible::lsp::Diagnostic> &diagnostics) {
+  const std::lock_guard<std::mutex> publishing(publish_lock_);
+  {
+    const std::lock_guard<std::mutex> l(lock_);
+    auto found = files_.find(uri);
+    if (found == files_.end() || found->second.generation != generation) {
+      return;  // Queued again.
+    }
+    // Files removed from the workspace are forgotten once cleared.
+    if (!found->second.in_workspace) files_.erase(found);
+  }
+  publish_(uri, diagnostics);
+}
+
+}  // namespace verilog
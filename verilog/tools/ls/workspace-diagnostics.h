@@ -0,0 +1,117 @@
+// Copyright 2023 The Verible Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef VERILOG_TOOLS_LS_WORKSPACE_DIAGNOSTICS_H
+#define VERILOG_TOOLS_LS_WORKSPACE_DIAGNOSTICS_H
+
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+#include "absl/time/time.h"
+#include "common/lsp/lsp-protocol.h"
+
+namespace verilog {
+
+// Lints the files of a workspace from disk in background threads, and
+// publishes their diagnostics one file at a time, as soon as they are done.
+//
+// Linting yields to interactive work: a file is only started once there was
+// no Busy() call for a while, so that it does not compete with requests and
+// edits for the CPU. Files are linted again only when told that they changed.
+class WorkspaceDiagnostics {
+ public:
+  // Publishes the diagnostics of the file "uri". Called from lint threads,
+  // but not concurrently.
+  using PublishFun = std::function<void(
+      const std::string &uri,
+      const std::vector<verible::lsp::Diagnostic> &diagnostics)>;
+
+  // Lint on "threads" threads (at least one), and only start on a file once
+  // there was no Busy() call for "quiet" time. Diagnostics per file are
+  // limited to "message_limit" (if >= 0).
+  WorkspaceDiagnostics(int threads, absl::Duration quiet, int message_limit,
+                       const PublishFun &publish);
+  WorkspaceDiagnostics(const WorkspaceDiagnostics &) = delete;
+  WorkspaceDiagnostics &operator=(const WorkspaceDiagnostics &) = delete;
+
+  // Stops linting; waits for files in progress, and drops those queued.
+  ~WorkspaceDiagnostics();
+
+  // Sets the uris of the files in the workspace. Those that were not part of
+  // it before are queued for linting, and those that are no longer part of it
+  // get their diagnostics cleared.
+  void SetFiles(const std::vector<std::string> &uris);
+
+  // Lints "uri" again, e.g. after it changed on disk, if it is part of the
+  // workspace. Files that can't be read any more get their diagnostics
+  // cleared.
+  void FileChanged(const std::string &uri);
+
+  // Tells that interactive work is happening, which linting waits to settle.
+  void Busy();
+
+  // Waits until all queued files are linted and published.
+  void WaitUntilDone();
+
+  // Number of times a file was linted.
+  int64_t linted_files() const;
+
+ private:
+  struct FileState {
+    int64_t generation = 0;  // New one whenever the file is queued.
+    bool in_workspace = true;
+    bool queued = false;
+  };
+
+  // Queues "uri", unless it already is, with a new generation.
+  // Requires lock_.
+  void Enqueue(const std::string &uri, FileState *state);
+
+  // Main loop of each lint thread.
+  void LintLoop();
+
+  // Publishes "diagnostics" of the "generation" of "uri", unless the file
+  // was queued again meanwhile.
+  void PublishIfCurrent(
+      const std::string &uri, int64_t generation,
+      const std::vector<verible::lsp::Diagnostic> &diagnostics);
+
+  const absl::Duration quiet_;
+  const int message_limit_;
+  const PublishFun publish_;
+
+  std::mutex publish_lock_;  // Serializes calls of publish_.
+
+  mutable std::mutex lock_;  // Guards the following.
+  std::condition_variable changed_;
+  std::unordered_map<std::string, FileState> files_;  // By uri.
+  std::deque<std::string> queue_;  // Uris of the queued files_.
+  int64_t generations_ = 0;  // Last one handed out.
+  int in_progress_ = 0;
+  absl::Time last_busy_ = absl::InfinitePast();
+  int64_t linted_files_ = 0;
+  bool exiting_ = false;
+
+  std::vector<std::thread> threads_;
+};
+
+}  // namespace verilog
+#endif  // VERILOG_TOOLS_LS_WORKSPACE_DIAGNOSTICS_H
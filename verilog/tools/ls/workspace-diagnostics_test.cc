@@ -0,0 +1,146 @@
+// Copyright 2023 The Verible Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+#include "verilog/tools/ls/workspace-diagnostics.h"
+
+#include <filesystem>
+#include <map>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "absl/strings/match.h"
+#include "absl/time/clock.h"
+#include "absl/time/time.h"
+#include "common/lsp/lsp-file-utils.h"
+#include "common/lsp/lsp-protocol.h"
+#include "common/util/file_util.h"
+#include "gtest/gtest.h"
+
+namespace verilog {
+namespace {
+
+using verible::file::testing::ScopedTestFile;
+
+// Records the diagnostics published for each uri.
+class PublishRecorder {
+ public:
+  WorkspaceDiagnostics::PublishFun Publisher() {
+    return [this](const std::string &uri,
+                  const std::vector<verible::lsp::Diagnostic> &diagnostics) {
+      const std::lock_guard<std::mutex> l(lock_);
+      ++published_[uri].times;
+      published_[uri].syntax_errors = 0;
+      for (const auto &diagnostic : diagnostics) {
+        if (absl::StrContains(diagnostic.message, "syntax error")) {
+          ++published_[uri].syntax_errors;
+        }
+      }
+    };
+  }
+
+  struct Published {
+    int times = 0;
+    int syntax_errors = 0;
+  };
+
+  Published Get(const std::string &uri) {
+    const std::lock_guard<std::mutex> l(lock_);
+    return published_[uri];
+  }
+
+ private:
+  std::mutex lock_;
+  std::map<std::string, Published> published_;
+};
+
+std::string UriOf(const ScopedTestFile &file) {
+  return verible::lsp::PathToLSPUri(file.filename());
+}
+
+TEST(WorkspaceDiagnosticsTest, LintsAllFilesAndClearsRemovedOnes) {
+  const ScopedTestFile good(::testing::TempDir(), "module good;\nendmodule\n");
+  const ScopedTestFile bad(::testing::TempDir(), "module bad(;\nendmodule\n");
+  PublishRecorder recorder;
+  WorkspaceDiagnostics workspace(2, absl::ZeroDuration(), -1,
+                                 recorder.Publisher());
+  workspace.SetFiles({UriOf(good), UriOf(bad)});
+  workspace.WaitUntilDone();
+  EXPECT_EQ(workspace.linted_files(), 2);
+  EXPECT_EQ(recorder.Get(UriOf(good)).times, 1);
+  EXPECT_EQ(recorder.Get(UriOf(good)).syntax_errors, 0);
+  EXPECT_EQ(recorder.Get(UriOf(bad)).times, 1);
+  EXPECT_GT(recorder.Get(UriOf(bad)).syntax_errors, 0);
+
+  // Files still in the workspace are not linted again.
+  workspace.SetFiles({UriOf(good)});
+  workspace.WaitUntilDone();
+  EXPECT_EQ(workspace.linted_files(), 2);
+  EXPECT_EQ(recorder.Get(UriOf(good)).times, 1);
+  EXPECT_EQ(recorder.Get(UriOf(bad)).times, 2);  // Cleared.
+  EXPECT_EQ(recorder.Get(UriOf(bad)).syntax_errors, 0);
+
+  // Changes of files not in the workspace don't matter.
+  workspace.FileChanged(UriOf(bad));
+  workspace.WaitUntilDone();
+  EXPECT_EQ(recorder.Get(UriOf(bad)).times, 2);
+}
+
+TEST(WorkspaceDiagnosticsTest, LintsChangedFilesAgain) {
+  const std::string dir = ::testing::TempDir();
+  const std::string path = verible::file::JoinPath(
+      dir, verible::file::testing::RandomFileBasename("changed") + ".sv");
+  ASSERT_TRUE(verible::file::SetContents(path, "module m(;\nendmodule\n").ok());
+  const std::string uri = verible::lsp::PathToLSPUri(path);
+  PublishRecorder recorder;
+  WorkspaceDiagnostics workspace(1, absl::ZeroDuration(), -1,
+                                 recorder.Publisher());
+  workspace.SetFiles({uri});
+  workspace.WaitUntilDone();
+  EXPECT_GT(recorder.Get(uri).syntax_errors, 0);
+
+  ASSERT_TRUE(verible::file::SetContents(path, "module m;\nendmodule\n").ok());
+  workspace.FileChanged(uri);
+  workspace.WaitUntilDone();
+  EXPECT_EQ(workspace.linted_files(), 2);
+  EXPECT_EQ(recorder.Get(uri).times, 2);
+  EXPECT_EQ(recorder.Get(uri).syntax_errors, 0);
+
+  // Deleted files get no diagnostics.
+  ASSERT_TRUE(verible::file::SetContents(path, "module m(;\n").ok());
+  workspace.FileChanged(uri);
+  workspace.WaitUntilDone();
+  EXPECT_GT(recorder.Get(uri).syntax_errors, 0);
+  ASSERT_TRUE(std::filesystem::remove(path));
+  workspace.FileChanged(uri);
+  workspace.WaitUntilDone();
+  EXPECT_EQ(recorder.Get(uri).times, 4);
+  EXPECT_EQ(recorder.Get(uri).syntax_errors, 0);
+}
+
+TEST(WorkspaceDiagnosticsTest, WaitsUntilQuiet) {
+  const ScopedTestFile file(::testing::TempDir(), "module m;\nendmodule\n");
+  PublishRecorder recorder;
+  WorkspaceDiagnostics workspace(1, absl::Hours(1), -1, recorder.Publisher());
+  workspace.Busy();
+  workspace.SetFiles({UriOf(file)});
+  absl::SleepFor(absl::Milliseconds(50));
+  EXPECT_EQ(workspace.linted_files(), 0);
+  EXPECT_EQ(recorder.Get(UriOf(file)).times, 0);
+  // Destruction does not wait for queued files.
+}
+
+}  // namespace
+}  // namespace verilog
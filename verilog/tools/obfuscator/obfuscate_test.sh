@@ -271,5 +271,72 @@ for intact_name in ${intact_names[@]}; do
   }
 done
 
+###############################################################################
+echo "Test obfuscate of multiple files in parallel"
+
+declare -r MY_OUTPUT_DIR="${TEST_TMPDIR}/obfuscated"
+declare -r MY_DECODED_DIR="${TEST_TMPDIR}/decoded"
+
+cat >"${MY_INPUT_FILE}" <<EOF
+  module foo_bar(input clk);
+    foo bar(.baz(baz),
+      .clk(clk));
+  endmodule
+EOF
+
+cat >"${MY_INPUT_FILE2}" <<EOF
+  module foo(input baz, input clk);
+  endmodule
+EOF
+
+echo "Run obfuscator on files.  Save substitutions."
+"${obfuscator}" --jobs=2 --output_dir="${MY_OUTPUT_DIR}" \
+  --save_map="${MY_SAVEMAP_FILE}" "${MY_INPUT_FILE}" "${MY_INPUT_FILE2}"
+status="$?"
+[[ $status == 0 ]] || {
+  echo "Expected exit code 0, but got $status"
+  exit 1
+}
+
+echo "Verify that names shared by the files are translated the same."
+foo_encoded=$(grep "^foo " "${MY_SAVEMAP_FILE}" | cut -d" " -f2)
+grep "^  module ${foo_encoded}(" "${MY_OUTPUT_DIR}/${MY_INPUT_FILE2}" > /dev/null
+status="$?"
+[[ $status == 0 ]] || {
+  echo "Expected ${foo_encoded} in obfuscated ${MY_INPUT_FILE2}"
+  exit 1
+}
+grep "^    ${foo_encoded} " "${MY_OUTPUT_DIR}/${MY_INPUT_FILE}" > /dev/null
+status="$?"
+[[ $status == 0 ]] || {
+  echo "Expected ${foo_encoded} in obfuscated ${MY_INPUT_FILE}"
+  exit 1
+}
+
+echo "Decode the obfuscated files using saved substitutions."
+"${obfuscator}" --jobs=2 --decode --load_map="${MY_SAVEMAP_FILE}" \
+  --output_dir="${MY_DECODED_DIR}" \
+  "${MY_OUTPUT_DIR}/${MY_INPUT_FILE}" "${MY_OUTPUT_DIR}/${MY_INPUT_FILE2}"
+status="$?"
+[[ $status == 0 ]] || {
+  echo "Expected exit code 0, but got $status"
+  exit 1
+}
+
+diff --strip-trailing-cr -u \
+  "${MY_DECODED_DIR}/${MY_OUTPUT_DIR}/${MY_INPUT_FILE}" "${MY_INPUT_FILE}" \
+  || exit 1
+diff --strip-trailing-cr -u \
+  "${MY_DECODED_DIR}/${MY_OUTPUT_DIR}/${MY_INPUT_FILE2}" "${MY_INPUT_FILE2}" \
+  || exit 1
+
+echo "Files require --output_dir."
+"${obfuscator}" "${MY_INPUT_FILE}"
+status="$?"
+[[ $status == 1 ]] || {
+  echo "Expected exit code 1, but got $status"
+  exit 1
+}
+
 ###############################################################################
 echo "PASS"
@@ -14,24 +14,31 @@
 
 // verilog_obfuscate mangles verilog code by changing identifiers.
 // All whitespace and identifier lengths are preserved.
-// Output is written to stdout.
+// Output is written to stdout, or with files, under --output_dir.
 //
 // Example usage:
 // verilog_obfuscate [options] < file > output
 // cat files... | verilog_obfuscate [options] > output
+// verilog_obfuscate [options] --output_dir=dir files...
 
+#include <algorithm>
+#include <functional>
 #include <iostream>
 #include <set>
 #include <sstream>  // IWYU pragma: keep  // for ostringstream
 #include <string>   // for string, allocator, etc
 #include <utility>
+#include <vector>
 
 #include "absl/flags/flag.h"
+#include "absl/status/status.h"
 #include "absl/strings/str_cat.h"
 #include "absl/strings/string_view.h"
 #include "common/strings/obfuscator.h"
 #include "common/util/file_util.h"
 #include "common/util/init_command_line.h"
+#include "common/util/status_macros.h"
+#include "common/util/thread_pool.h"
 #include "verilog/analysis/extractors.h"
 #include "verilog/analysis/verilog_analyzer.h"
 #include "verilog/transform/obfuscate.h"
@@ -61,6 +68,14 @@ ABSL_FLAG(                            //
 ABSL_FLAG(                                   //
     bool, preserve_builtin_functions, true,  //
     "If true, preserve built-in function names such as sin(), ceil()..");
+ABSL_FLAG(                        //
+    std::string, output_dir, "",  //
+    "Directory to write the outputs of files given as arguments to, each at "
+    "the same relative path as its input.  Required with files.  All files "
+    "share the same translation, which --save_map saves.");
+ABSL_FLAG(int, jobs, 1,
+          "Number of files to obfuscate in parallel. 0 uses all available "
+          "cores.  Errors are still printed in input file order.");
 
 static constexpr absl::string_view kBuiltinFunctions[] = {
     "abs",  "acos", "acosh", "asin", "asinh", "atan",  "atan2", "atanh",
@@ -68,15 +83,100 @@ static constexpr absl::string_view kBuiltinFunctions[] = {
     "pow",  "sin",  "sinh",  "sqrt", "tan",   "tanh",
 };
 
+// Runs "f" on each of "filenames" on a thread pool of "jobs" threads, and
+// prints errors in the order of "filenames".  Returns true if all succeeded.
+static bool ForEachFile(
+    const std::vector<absl::string_view>& filenames, int jobs,
+    const std::function<absl::Status(absl::string_view)>& f) {
+  verible::ThreadPool pool(jobs > 1 ? jobs : 0);
+  bool all_success = true;
+  pool.ParallelMapInOrder(
+      filenames.size(), [&](size_t i) { return f(filenames[i]); },
+      [&](size_t i, const absl::Status& status) {
+        if (!status.ok()) {
+          std::cerr << filenames[i] << ": " << status.message() << std::endl;
+          all_success = false;
+        }
+      });
+  return all_success;
+}
+
+// Obfuscates all of "filenames" into "output_dir", with the shared "subst".
+static bool ObfuscateFiles(const std::vector<absl::string_view>& filenames,
+                           absl::string_view output_dir, int jobs,
+                           IdentifierObfuscator* subst) {
+  // Preserve the interfaces of all files first, so that instances in other
+  // files refer to them by the same names.
+  if (absl::GetFlag(FLAGS_preserve_interface)) {
+    const bool collected = ForEachFile(
+        filenames, jobs, [subst](absl::string_view filename) {
+          const auto content_or = verible::file::GetContentAsString(filename);
+          if (!content_or.ok()) return content_or.status();
+          std::set<std::string> preserved;
+          RETURN_IF_ERROR(verilog::analysis::CollectInterfaceNames(
+              *content_or, &preserved, verilog::VerilogPreprocess::Config()));
+          for (auto const& preserved_name : preserved) {
+            subst->encode(preserved_name, preserved_name);
+          }
+          return absl::OkStatus();
+        });
+    if (!collected) return false;
+  }
+
+  // Directories are created upfront, rather than racing on the pool.
+  for (const absl::string_view filename : filenames) {
+    if (const absl::Status status = verible::file::CreateDirs(
+            verible::file::Dirname(
+                verible::file::JoinPathUnder(output_dir, filename)));
+        !status.ok()) {
+      std::cerr << status.message() << std::endl;
+      return false;
+    }
+  }
+
+  return ForEachFile(filenames, jobs, [output_dir, subst](
+                                          absl::string_view filename) {
+    const auto content_or = verible::file::GetContentAsString(filename);
+    if (!content_or.ok()) return content_or.status();
+    std::ostringstream output;
+    RETURN_IF_ERROR(verilog::ObfuscateVerilogCode(*content_or, &output, subst));
+    return verible::file::SetContents(
+        verible::file::JoinPathUnder(output_dir, filename), output.str());
+  });
+}
+
+// Saves the translation to "save_map_file", if any.  Returns true on success.
+static bool SaveMap(const IdentifierObfuscator& subst, bool decode,
+                    const std::string& save_map_file) {
+  if (decode || save_map_file.empty()) return true;
+  if (!verible::file::SetContents(save_map_file, subst.save()).ok()) {
+    std::cerr << "Error writing --save_map file: " << save_map_file
+              << std::endl;
+    return false;
+  }
+  return true;
+}
+
 int main(int argc, char** argv) {
   const auto usage = absl::StrCat("usage: ", argv[0],
                                   " [options] < original > output\n"
+                                  "       ",
+                                  argv[0],
+                                  " [options] --output_dir=<dir> <file...>\n"
                                   R"(
 verilog_obfuscate mangles Verilog code by changing identifiers.
 All whitespaces and identifier lengths are preserved.
-Output is written to stdout.
+Output is written to stdout, or for files, to the same relative paths under
+--output_dir.  Files are obfuscated consistently with each other.
 )");
   const auto args = verible::InitCommandLine(usage, &argc, &argv);
+  // All positional arguments are file names.  Exclude program name.
+  const std::vector<absl::string_view> filenames(args.begin() + 1, args.end());
+  const auto& output_dir = absl::GetFlag(FLAGS_output_dir);
+  if (!filenames.empty() && output_dir.empty()) {
+    std::cerr << "--output_dir is required with files." << std::endl;
+    return 1;
+  }
 
   // initially empty identifier map
   IdentifierObfuscator subst(verilog::RandomEqualLengthSymbolIdentifier);
@@ -106,6 +206,19 @@ Output is written to stdout.
     return 1;
   }
 
+  if (absl::GetFlag(FLAGS_preserve_builtin_functions)) {
+    for (const absl::string_view f : kBuiltinFunctions) {
+      subst.encode(f, f);
+    }
+  }
+
+  if (!filenames.empty()) {
+    const int jobs = std::min<int>(
+        verible::JobsOrAllCores(absl::GetFlag(FLAGS_jobs)), filenames.size());
+    if (!ObfuscateFiles(filenames, output_dir, jobs, &subst)) return 1;
+    return SaveMap(subst, decode, save_map_file) ? 0 : 1;
+  }
+
   // Read from stdin.
   auto content_or = verible::file::GetContentAsString("-");
   if (!content_or.ok()) {
@@ -129,12 +242,6 @@ Output is written to stdout.
     }
   }
 
-  if (absl::GetFlag(FLAGS_preserve_builtin_functions)) {
-    for (const absl::string_view f : kBuiltinFunctions) {
-      subst.encode(f, f);
-    }
-  }
-
   // Encode/obfuscate.  Also verifies decode-ability.
   std::ostringstream output;  // result buffer
   const auto status =
@@ -144,13 +251,7 @@ Output is written to stdout.
     return 1;
   }
 
-  if (!decode && !save_map_file.empty()) {
-    if (!verible::file::SetContents(save_map_file, subst.save()).ok()) {
-      std::cerr << "Error writing --save_map file: " << save_map_file
-                << std::endl;
-      return 1;
-    }
-  }
+  if (!SaveMap(subst, decode, save_map_file)) return 1;
 
   // Print obfuscated code.
   std::cout << output.str();
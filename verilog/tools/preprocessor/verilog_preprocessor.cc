@@ -12,9 +12,15 @@
 // See the License for the specific language governing permissions and
 // limitations under the License.
 
+#include <algorithm>
+#include <fstream>
 #include <functional>
+#include <future>
 #include <iostream>
+#include <memory>
+#include <sstream>
 #include <string>
+#include <thread>  // NOLINT
 #include <vector>
 
 #include "absl/flags/flag.h"
@@ -22,10 +28,12 @@
 #include "absl/status/status.h"
 #include "absl/strings/str_cat.h"
 #include "absl/strings/string_view.h"
+#include "common/strings/mem_block.h"
 #include "common/util/file_util.h"
 #include "common/util/init_command_line.h"
 #include "common/util/status_macros.h"
 #include "common/util/subcommand.h"
+#include "common/util/thread_pool.h"
 #include "verilog/analysis/flow_tree.h"
 #include "verilog/analysis/verilog_filelist.h"
 #include "verilog/analysis/verilog_project.h"
@@ -39,10 +47,101 @@ using FileOpener = verilog::VerilogPreprocess::FileOpener;
 
 // TODO(karimtera): Add a boolean flag to configure the macro expansion.
 ABSL_FLAG(int, limit_variants, 20, "Maximum number of variants printed");
+ABSL_FLAG(std::vector<std::string>, variant_macros, {},
+          "Comma-separated macros to vary in generate-variants. If given, "
+          "other macros are assumed to be undefined, unless +define+'d.");
+ABSL_FLAG(std::string, output_dir, "",
+          "If not empty, strip-comments and preprocess accept many files, and "
+          "write the output of each one to the same relative path under this "
+          "directory instead of to stdout. Files are worked on in parallel.");
+ABSL_FLAG(int, jobs, 0,
+          "Number of files to work on in parallel with --output_dir. 0 uses "
+          "all available cores. Errors are still printed in file order.");
+ABSL_FLAG(std::string, replacement_char, " ",
+          "The replacement-char of strip-comments with --output_dir, where all "
+          "arguments are files.");
+
+// Number of threads to work on "file_count" files with, from --jobs.
+static int Jobs(size_t file_count) {
+  return std::max(1, std::min<int>(
+                        verible::JobsOrAllCores(absl::GetFlag(FLAGS_jobs)),
+                        file_count));
+}
+
+// Runs "f" for each of "files" on "jobs" threads, with the output file of
+// each under --output_dir. Worker i works on every jobs'th file, starting
+// with the i'th, one after the other, so "f" may use state of each worker.
+// Outputs are written as they are produced, not held in memory.
+// Errors are printed to "message_stream" in the order of "files".
+static absl::Status ForEachFileToOutputDir(
+    const std::vector<std::string>& files, int jobs,
+    std::ostream& message_stream,
+    const std::function<absl::Status(int worker, absl::string_view filename,
+                                     std::ostream& outs)>& f) {
+  const std::string output_dir = absl::GetFlag(FLAGS_output_dir);
+
+  // Directories are created upfront, rather than racing on the pool.
+  for (const std::string& filename : files) {
+    RETURN_IF_ERROR(verible::file::CreateDirs(verible::file::Dirname(
+        verible::file::JoinPathUnder(output_dir, filename))));
+  }
+
+  std::vector<absl::Status> statuses(files.size());
+  {
+    verible::ThreadPool pool(jobs > 1 ? jobs : 0);
+    std::vector<std::future<void>> workers;
+    for (int worker = 0; worker < jobs; ++worker) {
+      workers.push_back(pool.ExecAsync<void>([&, worker]() {
+        for (size_t i = worker; i < files.size(); i += jobs) {
+          const std::string output_path =
+              verible::file::JoinPathUnder(output_dir, files[i]);
+          std::ofstream outs(output_path, std::ios::binary);
+          if (!outs.good()) {
+            statuses[i] = absl::InvalidArgumentError(
+                absl::StrCat("Can't write ", output_path));
+            continue;
+          }
+          statuses[i] = f(worker, files[i], outs);
+          outs.close();
+          if (statuses[i].ok() && !outs) {
+            statuses[i] = absl::InvalidArgumentError(
+                absl::StrCat("Error writing ", output_path));
+          }
+        }
+      }));
+    }
+    for (auto& worker : workers) worker.get();
+  }
+
+  int failed = 0;
+  for (size_t i = 0; i < files.size(); ++i) {
+    if (statuses[i].ok()) continue;
+    message_stream << files[i] << ": " << statuses[i].message() << std::endl;
+    ++failed;
+  }
+  if (failed > 0) {
+    return absl::InvalidArgumentError(
+        absl::StrCat("Failed on ", failed, " of ", files.size(), " files."));
+  }
+  return absl::OkStatus();
+}
+
+static absl::Status ParseReplacementChar(absl::string_view replace_str,
+                                         char* replace_char) {
+  if (replace_str.empty()) {
+    *replace_char = '\0';
+  } else if (replace_str.length() == 1) {
+    *replace_char = replace_str[0];
+  } else {
+    return absl::InvalidArgumentError(
+        "Replacement must be a single character.");
+  }
+  return absl::OkStatus();
+}
 
 static absl::Status StripComments(const SubcommandArgsRange& args,
                                   std::istream&, std::ostream& outs,
-                                  std::ostream&) {
+                                  std::ostream& message_stream) {
   // Parse the arguments into a FileList.
   std::vector<absl::string_view> cmdline_args(args.begin(), args.end());
   verilog::FileList file_list;
@@ -54,6 +153,25 @@ static absl::Status StripComments(const SubcommandArgsRange& args,
     return absl::InvalidArgumentError(
         "Missing file argument.  Use '-' for stdin.");
   }
+
+  if (!absl::GetFlag(FLAGS_output_dir).empty()) {
+    char replace_char;
+    RETURN_IF_ERROR(ParseReplacementChar(absl::GetFlag(FLAGS_replacement_char),
+                                         &replace_char));
+    return ForEachFileToOutputDir(
+        files, Jobs(files.size()), message_stream,
+        [replace_char](int, absl::string_view filename,
+                       std::ostream& file_outs) -> absl::Status {
+          // Memory-mapped if possible: neither the input nor the output is
+          // copied as a whole.
+          const auto content = verible::file::GetContentAsMemBlock(filename);
+          if (!content.ok()) return content.status();
+          verilog::StripVerilogComments((*content)->AsStringView(),
+                                        &file_outs, replace_char);
+          return absl::OkStatus();
+        });
+  }
+
   const absl::string_view source_file = files[0];
   absl::StatusOr<std::string> source_contents_or =
       verible::file::GetContentAsString(source_file);
@@ -64,15 +182,7 @@ static absl::Status StripComments(const SubcommandArgsRange& args,
   if (args.size() == 1) {
     replace_char = ' ';
   } else if (args.size() == 2) {
-    absl::string_view replace_str(args[1]);
-    if (replace_str.empty()) {
-      replace_char = '\0';
-    } else if (replace_str.length() == 1) {
-      replace_char = replace_str[0];
-    } else {
-      return absl::InvalidArgumentError(
-          "Replacement must be a single character.");
-    }
+    RETURN_IF_ERROR(ParseReplacementChar(args[1], &replace_char));
   } else {
     return absl::InvalidArgumentError("Too many arguments.");
   }
@@ -82,10 +192,14 @@ static absl::Status StripComments(const SubcommandArgsRange& args,
   return absl::OkStatus();
 }
 
+// 'project' and 'include_cache' are shared by all files, so that every
+// included file is opened and preprocessed once.
 static absl::Status PreprocessSingleFile(
     absl::string_view source_file,
     const verilog::FileList::PreprocessingInfo& preprocessing_info,
-    std::ostream& outs, std::ostream& message_stream) {
+    verilog::VerilogProject* project,
+    verilog::VerilogIncludeCache* include_cache, std::ostream& outs,
+    std::ostream& message_stream) {
   absl::StatusOr<std::string> source_contents_or =
       verible::file::GetContentAsString(source_file);
   if (!source_contents_or.ok()) {
@@ -97,16 +211,14 @@ static absl::Status PreprocessSingleFile(
   config.include_files = true;
   config.expand_macros = true;
 
-  verilog::VerilogProject project(".", preprocessing_info.include_dirs);
-
   FileOpener file_opener =
-      [&project](
+      [project](
           absl::string_view filename) -> absl::StatusOr<absl::string_view> {
-    auto result = project.OpenIncludedFile(filename);
+    auto result = project->OpenIncludedFile(filename);
     if (!result.status().ok()) return result.status();
     return (*result)->GetContent();
   };
-  verilog::VerilogPreprocess preprocessor(config, file_opener);
+  verilog::VerilogPreprocess preprocessor(config, file_opener, include_cache);
 
   // Setting the preprocessing info (defines, and incdirs) in the preprocessor.
   preprocessor.setPreprocessingInfo(preprocessing_info);
@@ -152,8 +264,36 @@ static absl::Status MultipleCU(const SubcommandArgsRange& args, std::istream&,
   if (files.empty()) {
     return absl::InvalidArgumentError("ERROR: Missing file argument.");
   }
+
+  if (!absl::GetFlag(FLAGS_output_dir).empty()) {
+    // Included files are opened and preprocessed once for each worker.
+    const int jobs = Jobs(files.size());
+    std::vector<std::unique_ptr<verilog::VerilogProject>> projects;
+    std::vector<std::unique_ptr<verilog::VerilogIncludeCache>> include_caches;
+    for (int i = 0; i < jobs; ++i) {
+      projects.push_back(std::make_unique<verilog::VerilogProject>(
+          ".", preprocessing_info.include_dirs));
+      include_caches.push_back(
+          std::make_unique<verilog::VerilogIncludeCache>());
+    }
+    return ForEachFileToOutputDir(
+        files, jobs, message_stream,
+        [&](int worker, absl::string_view source_file,
+            std::ostream& file_outs) -> absl::Status {
+          // Errors are reported by ForEachFileToOutputDir(), in order.
+          std::ostringstream ignored_messages;
+          return PreprocessSingleFile(source_file, preprocessing_info,
+                                      projects[worker].get(),
+                                      include_caches[worker].get(), file_outs,
+                                      ignored_messages);
+        });
+  }
+
+  verilog::VerilogProject project(".", preprocessing_info.include_dirs);
+  verilog::VerilogIncludeCache include_cache;
   for (const absl::string_view source_file : files) {
-    RETURN_IF_ERROR(PreprocessSingleFile(source_file, preprocessing_info, outs,
+    RETURN_IF_ERROR(PreprocessSingleFile(source_file, preprocessing_info,
+                                         &project, &include_cache, outs,
                                          message_stream));
   }
   return absl::OkStatus();
@@ -168,8 +308,6 @@ static absl::Status GenerateVariants(const SubcommandArgsRange& args,
   RETURN_IF_ERROR(
       verilog::AppendFileListFromCommandline(cmdline_args, &file_list));
   const auto& files = file_list.file_paths;
-  // TODO(karimtera): Pass the +define's to the preprocessor, and only
-  // generate variants with theses defines fixed.
 
   const int limit_variants = absl::GetFlag(FLAGS_limit_variants);
 
@@ -203,6 +341,15 @@ static absl::Status GenerateVariants(const SubcommandArgsRange& args,
 
   // Control flow tree constructing.
   verilog::FlowTree control_flow_tree(lexed_sequence);
+  // Only generate variants with the +define's fixed.
+  for (const auto& define : file_list.preprocessing.defines) {
+    control_flow_tree.AssumeMacro(define.name, true);
+  }
+  const std::vector<std::string> variant_macros =
+      absl::GetFlag(FLAGS_variant_macros);
+  if (!variant_macros.empty()) {
+    control_flow_tree.VaryOnlyMacros(variant_macros);
+  }
   int counter = 0;
   return control_flow_tree.GenerateVariants(
       [limit_variants, &outs, &message_stream,
@@ -232,11 +379,14 @@ Inputs:
 Output: (stdout)
   The preprocessed files content (same contents with directives interpreted)
   will be written to stdout, concatenated.
+  With --output_dir, that of each file is written to the same relative path
+  under it instead, preprocessing --jobs files in parallel.
 )"}},
 
     {"strip-comments",
      {&StripComments,
       R"(strip-comments file [replacement-char]
+strip-comments --output_dir=dir [--replacement_char=char] file [file...]
 Inputs:
   'file' is a Verilog or SystemVerilog source file.
   Use '-' to read from stdin.
@@ -248,21 +398,25 @@ Inputs:
   If a single character, the comment contents are replaced with the character.
 Output: (stdout)
   Contents of original file with // and /**/ comments removed.
+  With --output_dir, all arguments are files, and the contents of each one
+  are written to the same relative path under it instead, stripping --jobs
+  files in parallel. The replacement-char is given with --replacement_char.
 )"}},
 
     {"generate-variants",
      {&GenerateVariants,
-      R"(generate-variants file [-limit_variants number]
+      R"(generate-variants [define-flags] file [-limit_variants number]
+                  [-variant_macros macro[,macro...]]
 Inputs:
   'file' is a Verilog or SystemVerilog source file.
   '-limit_variants' flag limits variants to 'number' (20 by default).
+  Macros given with +define+ are assumed defined in all variants.
+  '-variant_macros' flag limits the varied macros to the listed ones; all
+  others are assumed undefined (unless given with +define+).
 Output: (stdout)
    Generates every possible variant of `ifdef blocks considering the
    conditional directives.
 )"}},
-    // TODO(karimtera): We can add another argument to `generate-variants`,
-    // Which allows us to set some defines, as if we are only interested
-    // in the variants in which these defines are set.
 
     // TODO(karimtera): Another candidate subcommand is `list-defines`,
     // Which would be the output of `GetUsedMacros()`.
@@ -222,6 +222,58 @@ diff --strip-trailing-cr -u "$MY_EXPECT_FILE" "$MY_OUTPUT_FILE" || {
 }
 
 
+################################################################################
+echo "=== Line:${LINENO} Test strip-comments: many files to --output_dir"
+
+readonly MY_OUTPUT_DIR="${TEST_TMPDIR}/stripped"
+readonly MY_SECOND_INPUT_FILE="${TEST_TMPDIR}/sub/myinput2.txt"
+mkdir -p "$(dirname "$MY_SECOND_INPUT_FILE")"
+
+cat > "$MY_SECOND_INPUT_FILE" <<EOF
+module n; /* n */ endmodule
+EOF
+
+"$preprocessor" strip-comments --output_dir="$MY_OUTPUT_DIR" --jobs=2 \
+  --replacement_char=. "$MY_INPUT_FILE" "$MY_SECOND_INPUT_FILE"
+
+status="$?"
+[[ $status == 0 ]] || {
+  "Expected exit code 0, but got $status"
+  exit 1
+}
+
+# Outputs are at the same relative paths under the output directory.
+diff --strip-trailing-cr -u "$MY_EXPECT_FILE" \
+  "${MY_OUTPUT_DIR}/${MY_INPUT_FILE}" || {
+  exit 1
+}
+
+cat > "$MY_EXPECT_FILE" <<EOF
+module n; /*...*/ endmodule
+EOF
+
+diff --strip-trailing-cr -u "$MY_EXPECT_FILE" \
+  "${MY_OUTPUT_DIR}/${MY_SECOND_INPUT_FILE}" || {
+  exit 1
+}
+
+# A missing file fails, but the others are still written.
+rm -rf "$MY_OUTPUT_DIR"
+"$preprocessor" strip-comments --output_dir="$MY_OUTPUT_DIR" \
+  "$MY_INPUT_FILE.does.not.exist" "$MY_SECOND_INPUT_FILE" > /dev/null 2>&1
+
+status="$?"
+[[ $status == 1 ]] || {
+  "Expected exit code 1, but got $status"
+  exit 1
+}
+
+diff --strip-trailing-cr -u "$MY_EXPECT_FILE" \
+  "${MY_OUTPUT_DIR}/${MY_SECOND_INPUT_FILE}" || {
+  exit 1
+}
+
+
 ################################################################################
 echo "=== Line:${LINENO} Test strip-comments: on a lexically invalid source file"
 
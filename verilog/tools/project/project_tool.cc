@@ -12,21 +12,38 @@
 // See the License for the specific language governing permissions and
 // limitations under the License.
 
+#include <algorithm>
+#include <cstdint>
 #include <functional>
 #include <iostream>
 #include <memory>
 #include <string>
+#include <vector>
 
+#include "absl/container/flat_hash_set.h"
 #include "absl/flags/flag.h"
 #include "absl/flags/usage.h"
 #include "absl/status/status.h"
+#include "absl/status/statusor.h"
 #include "absl/strings/str_cat.h"
 #include "absl/strings/string_view.h"
+#include "absl/time/clock.h"
+#include "absl/time/time.h"
+#include "common/analysis/syntax_tree_search.h"
+#include "common/strings/line_column_map.h"
+#include "common/text/symbol.h"
+#include "common/text/text_structure.h"
+#include "common/text/tree_utils.h"
+#include "common/util/file_util.h"
 #include "common/util/init_command_line.h"
 #include "common/util/logging.h"
+#include "common/util/memory_stats.h"
 #include "common/util/status_macros.h"
 #include "common/util/subcommand.h"
+#include "common/util/thread_pool.h"
+#include "common/util/trace_events.h"
 #include "verilog/analysis/dependencies.h"
+#include "verilog/analysis/structural_search.h"
 #include "verilog/analysis/symbol_table.h"
 #include "verilog/analysis/verilog_project.h"
 
@@ -52,9 +69,72 @@ e.g --include_dir_paths directory1,directory2
 if "A.sv" exists in both "directory1" and "directory2" the one in "directory1" is the one we will use.
 )");
 
+ABSL_FLAG(int, jobs, 1,
+          "Number of threads to read files, build the symbol table of the "
+          "translation units and resolve references with. 0 uses all "
+          "available cores. "
+          "Units are still merged in the order of the file list.");
+
+ABSL_FLAG(std::string, symbol_table_cache_dir, "",
+          "Directory to cache the symbols of translation units in, which are "
+          "then not parsed again while unchanged. Symbols read from the cache "
+          "are printed without the source text of their types. Empty disables "
+          "the cache.");
+
+ABSL_FLAG(bool, release_syntax_trees, false,
+          "Release the token streams and syntax trees of the files once the "
+          "symbol table is built, which then takes a fraction of the memory. "
+          "Symbols are printed without the source text of their types, like "
+          "those read from the cache.");
+
+ABSL_FLAG(absl::Duration, timeout, absl::ZeroDuration(),
+          "If positive, building the symbol table and resolving references "
+          "is abandoned after this long, with a diagnostic, e.g. '30s'.");
+
+ABSL_FLAG(bool, print_memory_stats, false,
+          "Print the memory used by lexing, parsing and the symbol table, "
+          "and the peak resident set size, to stderr on exit.");
+
+ABSL_FLAG(std::string, trace_output, "",
+          "If not empty, write a trace of the parsing and symbol table "
+          "stages to this file on exit, in Chrome trace event format "
+          "(chrome://tracing, ui.perfetto.dev).");
+
+ABSL_FLAG(bool, lexical_file_deps, false,
+          "file-deps: find dependencies from the tokens of the files rather "
+          "than from their symbol table: much faster, but only on the names "
+          "of top-level design elements (modules, packages, classes, ...), "
+          "and approximate.");
+
+ABSL_FLAG(bool, file_deps_levels, false,
+          "file-deps: print the files in compile order instead, one level "
+          "per line: files only depend on files of earlier lines (or on "
+          "their own line, if on a cycle).");
+
+ABSL_FLAG(std::string, search_tag, "",
+          "search: tag of the syntax tree symbols to find: the name of a "
+          "node, like kAlwaysStatement, or a keyword or operator, like "
+          "always_latch.");
+
+ABSL_FLAG(std::vector<std::string>, search_identifiers, {},
+          "search: comma separated identifiers that all must occur in the "
+          "found symbols, e.g. the name of a module to find the "
+          "instantiations of.");
+
+ABSL_FLAG(std::string, search_index, "",
+          "search: file to keep the index of the tags and identifiers of "
+          "each file in, so that later searches only parse new and changed "
+          "files, and files that can have matches.  Empty indexes all files "
+          "on every search.");
+
 using verible::SubcommandArgsRange;
 using verible::SubcommandEntry;
 
+// Returns the number of threads to use, see --jobs.
+static int NumThreads() {
+  return verible::JobsOrAllCores(absl::GetFlag(FLAGS_jobs));
+}
+
 // Project configuration information expected to come from command-line
 // invocation.
 // TODO: refactor for re-use in verilog/tools/kythe/verilog_kythe_extractor.cc
@@ -116,13 +196,25 @@ struct ProjectSymbols {
     // Error-out early if any files failed to open.
     project = std::make_unique<verilog::VerilogProject>(
         config.file_list_root, config.file_list.preprocessing.include_dirs);
-    for (const auto& file : config.file_list.file_paths) {
-      const auto open_status = project->OpenTranslationUnit(file);
+    for (const auto& open_status :
+         project->OpenFileList(config.file_list, NumThreads())) {
       if (!open_status.ok()) return open_status.status();
     }
 
     // Initialize symbol table (empty).
     symbol_table = std::make_unique<verilog::SymbolTable>(project.get());
+    const std::string cache_dir = absl::GetFlag(FLAGS_symbol_table_cache_dir);
+    if (!cache_dir.empty()) {
+      RETURN_IF_ERROR(verible::file::CreateDir(cache_dir));
+      symbol_table->SetCacheDirectory(cache_dir,
+                                      verible::GetRepositoryVersion());
+    }
+    if (const absl::Duration timeout = absl::GetFlag(FLAGS_timeout);
+        timeout > absl::ZeroDuration()) {
+      const absl::Time deadline = absl::Now() + timeout;
+      symbol_table->SetIsCancelled(
+          [deadline]() { return absl::Now() > deadline; });
+    }
     return absl::OkStatus();
   }
 
@@ -131,14 +223,23 @@ struct ProjectSymbols {
     VLOG(1) << __FUNCTION__;
     // For now, ingest files in the order they were listed.
     // Without conflicting definitions in files, this order should not matter.
-    for (const auto& file : config.file_list.file_paths) {
-      symbol_table->BuildSingleTranslationUnit(file, build_statuses);
+    symbol_table->BuildTranslationUnits(config.file_list.file_paths,
+                                        NumThreads(), build_statuses);
+    if (absl::GetFlag(FLAGS_release_syntax_trees)) {
+      symbol_table->ReleaseSyntaxTrees();
+    }
+    if (verible::SubsystemMemory().Enabled()) {
+      int64_t nodes = 0;
+      symbol_table->Root().ApplyPreOrder(
+          [&nodes](const verilog::SymbolTableNode&) { ++nodes; });
+      verible::SubsystemMemory().Allocate(
+          "symbol table", nodes * sizeof(verilog::SymbolTableNode));
     }
   }
 
   // Resolves symbols.
   void Resolve(std::vector<absl::Status>* resolve_statuses) const {
-    symbol_table->Resolve(resolve_statuses);
+    symbol_table->Resolve(resolve_statuses, NumThreads());
   }
 };
 
@@ -224,29 +325,137 @@ static absl::Status ShowFileDependencies(const SubcommandArgsRange& args,
   ProjectSymbols project_symbols(config);
   RETURN_IF_ERROR(project_symbols.Load());
 
-  // Build symbol table.
-  std::vector<absl::Status> statuses;
-  project_symbols.Build(&statuses);
+  const bool lexical = absl::GetFlag(FLAGS_lexical_file_deps);
+  if (!lexical) {
+    // Build symbol table.
+    std::vector<absl::Status> statuses;
+    project_symbols.Build(&statuses);
 
-  // Accumulate diagnostics.
-  if (!statuses.empty()) {
-    return absl::InvalidArgumentError(JoinStatusMessages(statuses));
-  }
+    // Accumulate diagnostics.
+    if (!statuses.empty()) {
+      return absl::InvalidArgumentError(JoinStatusMessages(statuses));
+    }
 
-  // Partially resolve symbols.
-  project_symbols.symbol_table->ResolveLocallyOnly();
+    // Partially resolve symbols.
+    project_symbols.symbol_table->ResolveLocallyOnly();
+  }
 
   // Compute dependencies.
-  const verilog::FileDependencies deps(*project_symbols.symbol_table);
+  const verilog::FileDependencies deps =
+      lexical ? verilog::FileDependencies(*project_symbols.project,
+                                          NumThreads())
+              : verilog::FileDependencies(*project_symbols.symbol_table);
 
   // Print.
   // TODO(hzeller): support various output options {human-readable,
   // machine-readable, etc.} using subcommand flags (b/164300992).
-  // One variant should include tsort-consumable 2-column text.
+  if (absl::GetFlag(FLAGS_file_deps_levels)) {
+    std::vector<verilog::FileDependencies::node_type> files;
+    for (const std::string& path : config.file_list.file_paths) {
+      const verilog::VerilogSourceFile* file =
+          project_symbols.project->LookupRegisteredFile(path);
+      if (file != nullptr) files.push_back(file);
+    }
+    for (const auto& level : deps.CompileLevels(files)) {
+      outs << absl::StrJoin(level, " ",
+                            [](std::string* out,
+                               const verilog::VerilogSourceFile* file) {
+                              absl::StrAppend(out, file->ReferencedPath());
+                            })
+           << std::endl;
+    }
+    return absl::OkStatus();
+  }
   deps.PrintGraph(outs);
   return absl::OkStatus();
 }
 
+static absl::Status SearchProjectStructure(const SubcommandArgsRange& args,
+                                           std::istream& ins,
+                                           std::ostream& outs,
+                                           std::ostream& errs) {
+  VLOG(1) << __FUNCTION__;
+  const absl::StatusOr<verible::SymbolTag> tag =
+      verilog::ParseSearchTag(absl::GetFlag(FLAGS_search_tag));
+  if (!tag.ok()) return tag.status();
+  const verilog::StructuralQuery query{
+      *tag, absl::GetFlag(FLAGS_search_identifiers)};
+
+  // Load configuration.
+  VerilogProjectConfig config;
+  RETURN_IF_ERROR(config.LoadFromCommandline(args));
+
+  // Load project and files.
+  ProjectSymbols project_symbols(config);
+  RETURN_IF_ERROR(project_symbols.Load());
+  std::vector<verilog::VerilogSourceFile*> files;
+  absl::flat_hash_set<const verilog::VerilogSourceFile*> listed;
+  for (const std::string& path : config.file_list.file_paths) {
+    verilog::VerilogSourceFile* file =
+        project_symbols.project->LookupRegisteredFile(path);
+    if (file != nullptr && listed.insert(file).second) files.push_back(file);
+  }
+
+  // Bring the index up to date, parsing only new and changed files.
+  verilog::StructuralSearchIndex index;
+  const std::string index_path = absl::GetFlag(FLAGS_search_index);
+  if (!index_path.empty() && verible::file::FileExists(index_path).ok()) {
+    const absl::StatusOr<std::string> text =
+        verible::file::GetContentAsString(index_path);
+    const absl::Status loaded =
+        text.ok() ? index.Deserialize(*text) : text.status();
+    if (!loaded.ok()) {
+      errs << loaded.message() << "; indexing all files." << std::endl;
+    }
+  }
+  std::vector<absl::Status> statuses;
+  const int indexed = index.Update(files, NumThreads(), &statuses);
+  VLOG(1) << "Indexed " << indexed << " of " << files.size() << " files.";
+  // Syntax errors don't stop the search: partial trees are searched, too.
+  for (const absl::Status& status : statuses) {
+    errs << status.message() << std::endl;
+  }
+  if (indexed > 0 && !index_path.empty()) {
+    RETURN_IF_ERROR(verible::file::SetContents(index_path, index.Serialize()));
+  }
+
+  // Search the files that can have matches, in parallel, and print their
+  // matches in the order of the file list.
+  std::vector<verilog::VerilogSourceFile*> candidates;
+  for (verilog::VerilogSourceFile* file : files) {
+    if (index.MayMatch(file->ReferencedPath(), query)) {
+      candidates.push_back(file);
+    } else {
+      file->ReleaseSyntaxTree();
+    }
+  }
+  VLOG(1) << "Searching " << candidates.size() << " files.";
+  std::vector<std::string> results(candidates.size());
+  verible::ThreadPool pool(NumThreads() - 1);
+  pool.ParallelFor(candidates.size(), [&](size_t i) {
+    verilog::VerilogSourceFile* file = candidates[i];
+    file->Parse().IgnoreError();  // Reported when indexed.
+    const verible::TextStructureView* text_structure =
+        file->GetTextStructure();
+    if (text_structure == nullptr || text_structure->SyntaxTree() == nullptr) {
+      return;
+    }
+    for (const verible::TreeSearchMatch& match :
+         verilog::SearchStructure(*text_structure->SyntaxTree(), query)) {
+      const absl::string_view text = verible::StringSpanOfSymbol(*match.match);
+      if (text.empty()) continue;
+      const verible::LineColumn start =
+          text_structure->GetRangeForText(text).start;
+      absl::StrAppend(&results[i], file->ReferencedPath(), ":",
+                      start.line + 1, ":", start.column + 1, ": ",
+                      text.substr(0, text.find('\n')), "\n");
+    }
+    file->ReleaseSyntaxTree();
+  });
+  for (const std::string& result : results) outs << result;
+  return absl::OkStatus();
+}
+
 static const std::pair<absl::string_view, SubcommandEntry> kCommands[] = {
     {"symbol-table-defs",        //
      {&BuildAndShowSymbolTable,  //
@@ -276,6 +485,30 @@ Prints human-readable representation of inter-file dependencies, e.g.
 
   "file1.sv" depends on "file2.sv" for symbols { X, Y, Z... }
 
+or, with --file_deps_levels, the files in compile order, e.g.
+
+  file2.sv file3.sv
+  file1.sv
+
+With --lexical_file_deps, dependencies are found from the tokens of the
+files, without parsing them.
+
+Input:
+Project options, including source file list.
+)"}},
+    {"search",                  //
+     {&SearchProjectStructure,  //
+      R"(search --search_tag=TAG [--search_identifiers=ID,...] [project args]
+
+Prints the location and first line of the syntax tree symbols with the tag
+--search_tag, that contain all --search_identifiers, in all files, e.g.
+
+  design.sv:12:3: always_latch
+
+With --search_index, the tags and identifiers of each file are indexed, so
+that later searches only parse new and changed files, and the files that can
+have matches.
+
 Input:
 Project options, including source file list.
 )"}},
@@ -310,6 +543,14 @@ int main(int argc, char* argv[]) {
   // subcommand args start at [2]
   const SubcommandArgsRange command_args(args.cbegin() + 2, args.cend());
 
+  if (absl::GetFlag(FLAGS_print_memory_stats)) {
+    verible::EnableSubsystemMemoryStats();
+  }
+  if (const std::string trace_output = absl::GetFlag(FLAGS_trace_output);
+      !trace_output.empty()) {
+    verible::EnableTraceOutput(trace_output);
+  }
+
   const auto& sub = commands.GetSubcommandEntry(args[1]);
   // Run the subcommand.
   const auto status = sub.main(command_args, std::cin, std::cout, std::cerr);
@@ -205,6 +205,28 @@ grep -q "(@fooo -> \$root::fooo)" "$MY_OUTPUT_FILE" || {
   exit 1
 }
 
+################################################################################
+echo "=== Same as above, with the syntax trees released after building"
+
+"$project_tool" \
+  symbol-table-refs \
+  --release_syntax_trees \
+  --file_list_path "$FILE_LIST_INPUT" \
+  --file_list_root "$(dirname "$MY_INPUT_FILE")" \
+  > "$MY_OUTPUT_FILE" 2>&1
+
+status="$?"
+[[ $status == 0 ]] || {
+  echo "$LINENO: Expected exit code 0, but got $status"
+  exit 1
+}
+
+grep -q "(@fooo -> \$root::fooo)" "$MY_OUTPUT_FILE" || {
+  echo "$LINENO: Expected \"(@fooo -> \$root::fooo)\" in $MY_OUTPUT_FILE but didn't find it.  Got:"
+  cat "$MY_OUTPUT_FILE"
+  exit 1
+}
+
 ################################################################################
 echo "=== Load one file, printing symbol references for debug. File on cmdline"
 
@@ -348,5 +370,78 @@ EOF
 
 diff --strip-trailing-cr -u "$MY_EXPECT_FILE" "$MY_OUTPUT_FILE" || { exit 1; }
 
+################################################################################
+echo "=== Show compile levels of lexical dependencies (modules)"
+
+"$project_tool" \
+  file-deps \
+  --file_list_path "$FILE_LIST_INPUT" \
+  --file_list_root "$(dirname "$MY_INPUT_FILE".A)" \
+  --lexical_file_deps --file_deps_levels --jobs 2 \
+  > "$MY_OUTPUT_FILE" 2>&1
+
+status="$?"
+[[ $status == 0 ]] || {
+  echo "$LINENO: Expected exit code 0, but got $status"
+  exit 1
+}
+
+cat > "$MY_EXPECT_FILE" <<EOF
+myinput.txt.A
+myinput.txt.B
+EOF
+
+diff --strip-trailing-cr -u "$MY_EXPECT_FILE" "$MY_OUTPUT_FILE" || { exit 1; }
+
+################################################################################
+echo "=== Search instantiations of a module, with and without an index"
+
+SEARCH_INDEX="${TEST_TMPDIR}/search_index.txt"
+cat > "$MY_EXPECT_FILE" <<EOF
+myinput.txt.A:5:3: mm dut();
+myinput.txt.B:2:3: mm mm_inst();
+EOF
+
+# The second search with the index reads the index written by the first.
+for index in "" "$SEARCH_INDEX" "$SEARCH_INDEX"; do
+  "$project_tool" \
+    search \
+    --search_tag kDataDeclaration --search_identifiers mm \
+    --search_index "$index" \
+    --file_list_path "$FILE_LIST_INPUT" \
+    --file_list_root "$(dirname "$MY_INPUT_FILE".A)" \
+    --jobs 2 \
+    > "$MY_OUTPUT_FILE" 2>&1
+
+  status="$?"
+  [[ $status == 0 ]] || {
+    echo "$LINENO: Expected exit code 0, but got $status"
+    exit 1
+  }
+
+  diff --strip-trailing-cr -u "$MY_EXPECT_FILE" "$MY_OUTPUT_FILE" || { exit 1; }
+done
+
+[[ -s "$SEARCH_INDEX" ]] || {
+  echo "$LINENO: Expected search index $SEARCH_INDEX to be written."
+  exit 1
+}
+
+################################################################################
+echo "=== Expect failure on unknown search tag"
+
+"$project_tool" \
+  search \
+  --search_tag kNoSuchNode \
+  --file_list_path "$FILE_LIST_INPUT" \
+  --file_list_root "$(dirname "$MY_INPUT_FILE".A)" \
+  > "$MY_OUTPUT_FILE" 2>&1
+
+status="$?"
+[[ $status == 1 ]] || {
+  echo "$LINENO: Expected exit code 1, but got $status"
+  exit 1
+}
+
 ################################################################################
 echo "PASS"
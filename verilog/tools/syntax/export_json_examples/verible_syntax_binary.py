@@ -0,0 +1,145 @@
+# Copyright 2017-2023 The Verible Authors.
+#
+# Licensed under the Apache License, Version 2.0 (the "License");
+# you may not use this file except in compliance with the License.
+# You may obtain a copy of the License at
+#
+#      http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing, software
+# distributed under the License is distributed on an "AS IS" BASIS,
+# WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+# See the License for the specific language governing permissions and
+# limitations under the License.
+"""Reader for ``verible-verilog-syntax --export_binary_dir`` files
+
+The format is described in ``common/text/syntax_tree_binary.h``. Files are
+memory-mapped, and columns are exposed as ``memoryview`` objects over the
+mapping, so nothing is decoded up front.
+
+Usage: verible_syntax_binary.py FILE.vcst [FILE.vcst [...]]
+
+Prints the syntax tree of each file.
+"""
+
+import mmap
+import struct
+import sys
+from typing import Iterable, List
+
+_MAGIC = b"VCST"
+_VERSION = 1
+
+# Sections, in file order.
+(_TEXT, _TOKEN_TAG, _TOKEN_START, _TOKEN_END, _FILTERED_TOKENS, _TREE_KIND,
+ _TREE_TAG, _TREE_SUBTREE_SIZE, _TREE_START, _TREE_END, _TOKEN_NAMES,
+ _NODE_NAMES, _NUM_SECTIONS) = range(13)
+
+KIND_NULL = 0
+KIND_LEAF = 1
+KIND_NODE = 2
+
+NO_OFFSET = 0xffffffff
+
+
+def _names(table: memoryview) -> List[str]:
+  return [name.decode("utf-8") for name in bytes(table).split(b"\0")[:-1]]
+
+
+class SyntaxTreeBinary:
+  """Memory-mapped view of one exported file.
+
+  Attributes:
+    text: Source text, as bytes.
+    token_tags, token_starts, token_ends: Columns of all lexed tokens.
+    filtered_tokens: Indices of the tokens that remained after filtering.
+    tree_kinds, tree_tags, tree_subtree_sizes, tree_starts, tree_ends:
+      Columns of the syntax tree in preorder. Entry 0 is the root.
+    token_names, node_names: Names of token and node tags, indexed by tag.
+  """
+
+  def __init__(self, path: str):
+    with open(path, "rb") as f:
+      self._mmap = mmap.mmap(f.fileno(), 0, access=mmap.ACCESS_READ)
+    buf = memoryview(self._mmap)
+    magic, version, num_sections, _ = struct.unpack_from("<4sIII", buf)
+    if magic != _MAGIC:
+      raise ValueError(f"{path}: not a syntax tree binary export")
+    if version != _VERSION:
+      raise ValueError(f"{path}: unsupported version {version}")
+    if num_sections < _NUM_SECTIONS:
+      raise ValueError(f"{path}: truncated header")
+    if sys.byteorder != "little":
+      raise ValueError("only little-endian hosts are supported")
+
+    sections = []
+    for i in range(_NUM_SECTIONS):
+      offset, size = struct.unpack_from("<QQ", buf, 16 + 16 * i)
+      if offset + size > len(buf):
+        raise ValueError(f"{path}: invalid section {i}")
+      sections.append(buf[offset:offset + size])
+
+    self.text = sections[_TEXT]
+    self.token_tags = sections[_TOKEN_TAG].cast("i")
+    self.token_starts = sections[_TOKEN_START].cast("I")
+    self.token_ends = sections[_TOKEN_END].cast("I")
+    self.filtered_tokens = sections[_FILTERED_TOKENS].cast("I")
+    self.tree_kinds = sections[_TREE_KIND]
+    self.tree_tags = sections[_TREE_TAG].cast("i")
+    self.tree_subtree_sizes = sections[_TREE_SUBTREE_SIZE].cast("I")
+    self.tree_starts = sections[_TREE_START].cast("I")
+    self.tree_ends = sections[_TREE_END].cast("I")
+    self.token_names = _names(sections[_TOKEN_NAMES])
+    self.node_names = _names(sections[_NODE_NAMES])
+
+  def children(self, index: int) -> Iterable[int]:
+    """Yields the indices of the children (including nulls) of node index."""
+    child = index + 1
+    end = index + self.tree_subtree_sizes[index]
+    while child < end:
+      yield child
+      child += self.tree_subtree_sizes[child]
+
+  def tag_name(self, index: int) -> str:
+    """Returns the tag name of tree entry index."""
+    kind = self.tree_kinds[index]
+    if kind == KIND_NODE:
+      return self.node_names[self.tree_tags[index]]
+    if kind == KIND_LEAF:
+      return self.token_names[self.tree_tags[index]]
+    return "null"
+
+  def span_text(self, index: int) -> str:
+    """Returns the source text spanned by tree entry index."""
+    start = self.tree_starts[index]
+    if start == NO_OFFSET:
+      return ""
+    return bytes(self.text[start:self.tree_ends[index]]).decode("utf-8")
+
+
+def print_tree(tree: SyntaxTreeBinary):
+  if not tree.tree_kinds:
+    return
+  stack = [(0, 0)]
+  while stack:
+    index, depth = stack.pop()
+    line = "  " * depth + tree.tag_name(index)
+    if tree.tree_kinds[index] == KIND_LEAF:
+      line += f" {tree.span_text(index)!r}"
+    print(line)
+    if tree.tree_kinds[index] == KIND_NODE:
+      stack.extend(reversed([(c, depth + 1) for c in tree.children(index)]))
+
+
+def main():
+  if len(sys.argv) < 2:
+    print(f"Usage: {sys.argv[0]} FILE.vcst [FILE.vcst [...]]")
+    return 1
+  for path in sys.argv[1:]:
+    print(f"{path}:")
+    print_tree(SyntaxTreeBinary(path))
+  return 0
+
+
+if __name__ == "__main__":
+  sys.exit(main())
@@ -0,0 +1,68 @@
+# Copyright 2017-2023 The Verible Authors.
+#
+# Licensed under the Apache License, Version 2.0 (the "License");
+# you may not use this file except in compliance with the License.
+# You may obtain a copy of the License at
+#
+#      http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing, software
+# distributed under the License is distributed on an "AS IS" BASIS,
+# WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+# See the License for the specific language governing permissions and
+# limitations under the License.
+"""verible_syntax_binary test"""
+
+
+import os
+import subprocess
+import sys
+import tempfile
+import unittest
+
+import verible_syntax_binary
+
+
+class SyntaxTreeBinaryTest(unittest.TestCase):
+  def setUp(self):
+    self.executable = (sys.argv[1] if len(sys.argv) > 1
+                       else "verible-verilog-syntax")
+    self.tmpdir = tempfile.TemporaryDirectory()
+
+  def tearDown(self):
+    self.tmpdir.cleanup()
+
+  def export(self, content: str) -> verible_syntax_binary.SyntaxTreeBinary:
+    source = os.path.join(self.tmpdir.name, "source.sv")
+    with open(source, "w") as f:
+      f.write(content)
+    subprocess.run([self.executable, "--export_binary_dir", self.tmpdir.name,
+                    source], check=True)
+    name = source.replace("/", "_").replace("\\", "_").replace(":", "_")
+    return verible_syntax_binary.SyntaxTreeBinary(
+        os.path.join(self.tmpdir.name, name + ".vcst"))
+
+  def test_module(self):
+    tree = self.export("module foo;\nendmodule\n")
+    self.assertEqual(bytes(tree.text), b"module foo;\nendmodule\n")
+    self.assertEqual(tree.tag_name(0), "kDescriptionList")
+    self.assertEqual(tree.tree_subtree_sizes[0], len(tree.tree_kinds))
+    module = next(tree.children(0))
+    self.assertEqual(tree.tag_name(module), "kModuleDeclaration")
+    self.assertEqual(tree.span_text(module), "module foo;\nendmodule")
+
+    leaves = [tree.span_text(i) for i in range(len(tree.tree_kinds))
+              if tree.tree_kinds[i] == verible_syntax_binary.KIND_LEAF]
+    self.assertEqual(leaves, ["module", "foo", ";", "endmodule"])
+
+  def test_tokens(self):
+    tree = self.export("module foo;\nendmodule\n")
+    self.assertEqual(len(tree.token_tags), len(tree.token_starts))
+    texts = [bytes(tree.text[tree.token_starts[i]:tree.token_ends[i]])
+             for i in tree.filtered_tokens]
+    self.assertEqual(texts[:4], [b"module", b"foo", b";", b"endmodule"])
+    self.assertEqual(tree.token_names[tree.token_tags[0]], "module")
+
+
+if __name__ == "__main__":
+  unittest.main(argv=sys.argv[:1])
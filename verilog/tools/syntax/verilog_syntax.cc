@@ -19,23 +19,30 @@
 // verilog_syntax --verilog_trace_parser files...
 
 #include <algorithm>
-#include <iomanip>
+#include <fstream>
+#include <functional>
 #include <iostream>
 #include <iterator>
 #include <memory>
 #include <sstream>  // IWYU pragma: keep  // for ostringstream
 #include <string>   // for string, allocator, etc
+#include <utility>
 #include <vector>
 
 #include "absl/flags/flag.h"
 #include "absl/status/status.h"
+#include "absl/status/statusor.h"
+#include "absl/strings/match.h"
 #include "absl/strings/str_cat.h"
 #include "absl/strings/string_view.h"
+#include "absl/time/time.h"
 #include "absl/types/span.h"  // for MakeArraySlice
 #include "common/strings/compare.h"
 #include "common/strings/mem_block.h"
 #include "common/text/concrete_syntax_tree.h"
+#include "common/text/constants.h"
 #include "common/text/parser_verifier.h"
+#include "common/text/syntax_tree_binary.h"
 #include "common/text/text_structure.h"
 #include "common/text/token_info.h"
 #include "common/text/token_info_json.h"
@@ -43,16 +50,23 @@
 #include "common/util/enum_flags.h"
 #include "common/util/file_util.h"
 #include "common/util/init_command_line.h"
+#include "common/util/json_writer.h"
 #include "common/util/logging.h"  // for operator<<, LOG, LogMessage, etc
+#include "common/util/memory_stats.h"
+#include "common/util/thread_pool.h"
+#include "common/util/trace_events.h"
 #include "nlohmann/json.hpp"
+#include "verilog/CST/verilog_nonterminals.h"
 #include "verilog/CST/verilog_tree_json.h"
 #include "verilog/CST/verilog_tree_print.h"
 #include "verilog/analysis/json_diagnostics.h"
 #include "verilog/analysis/verilog_analyzer.h"
 #include "verilog/analysis/verilog_excerpt_parse.h"
+#include "verilog/parser/verilog_lexer.h"
 #include "verilog/parser/verilog_parser.h"
 #include "verilog/parser/verilog_token.h"
 #include "verilog/parser/verilog_token_classifications.h"
+#include "verilog/parser/verilog_token_enum.h"
 
 // Controls parser selection behavior
 enum class LanguageMode {
@@ -98,7 +112,20 @@ ABSL_FLAG(
 ABSL_FLAG(
     bool, export_json, false,
     "Uses JSON for output. Intended to be used as an input for other tools.");
+ABSL_FLAG(std::string, export_binary_dir, "",
+          "If set, also writes the text, tokens and syntax tree of each file "
+          "in the compact binary format of common/text/syntax_tree_binary.h "
+          "to this directory, named after the file path with '/' replaced by "
+          "'_', plus '.vcst'. Readers can use these memory-mapped, without "
+          "decoding.");
 ABSL_FLAG(bool, printtree, false, "Whether or not to print the tree");
+ABSL_FLAG(int, printtree_max_depth, -1,
+          "With --printtree, print nodes at most this deep, eliding their "
+          "children as '...'.  (-1: unlimited)");
+ABSL_FLAG(std::vector<std::string>, printtree_subtrees, {},
+          "With --printtree, print only the subtrees rooted at nodes with one "
+          "of these comma-separated tags (e.g. kModuleDeclaration) instead of "
+          "the whole tree.");
 ABSL_FLAG(bool, printtokens, false, "Prints all lexed and filtered tokens");
 ABSL_FLAG(bool, printrawtokens, false,
           "Prints all lexed tokens, including filtered ones.");
@@ -109,11 +136,68 @@ ABSL_FLAG(
     bool, verifytree, false,
     "Verifies that all tokens are parsed into tree, prints unmatched tokens");
 
+ABSL_FLAG(bool, print_stats, false,
+          "Prints the time, token counts and memory of each analysis phase "
+          "(tokenize, filter, contextualize, preprocess, parse).");
+
+ABSL_FLAG(bool, print_memory_stats, false,
+          "Prints the memory used by lexing and parsing, and the peak "
+          "resident set size, to stderr on exit.");
+
+ABSL_FLAG(std::string, trace_output, "",
+          "If not empty, writes a trace of the lexing and parsing stages to "
+          "this file on exit, in Chrome trace event format "
+          "(chrome://tracing, ui.perfetto.dev).");
+
 ABSL_FLAG(bool, show_diagnostic_context, false,
           "prints an additional "
           "line on which the diagnostic was found,"
           "followed by a line with a position marker");
 
+ABSL_FLAG(bool, streaming, false,
+          "Analyzes each file in chunks of whole top-level descriptions "
+          "(module, package, ...) of about --streaming_chunk_bytes, freeing "
+          "each chunk before the next one, to bound memory use on huge files. "
+          "Files are only split before the first `define or `undef. "
+          "Has no effect with --export_json, --export_binary_dir or "
+          "--print_stats.");
+ABSL_FLAG(int, streaming_chunk_bytes, 1 << 20,
+          "Minimum size of the chunks analyzed with --streaming.");
+
+ABSL_FLAG(int, jobs, 1,
+          "Number of files to analyze in parallel. 0 uses all available "
+          "cores. Output, including --export_json, is still in input file "
+          "order.");
+
+// The options of --printtree, from the flags.  main() reports unknown tags.
+static const absl::StatusOr<verilog::VerilogTreePrintOptions>&
+TreePrintOptions() {
+  static const auto* const kOptions = []() {
+    verilog::VerilogTreePrintOptions options;
+    options.max_depth = absl::GetFlag(FLAGS_printtree_max_depth);
+    for (const std::string& name : absl::GetFlag(FLAGS_printtree_subtrees)) {
+      bool found = false;
+      for (int tag = 0; tag < static_cast<int>(verilog::NodeEnum::kInvalidTag);
+           ++tag) {
+        const auto node_enum = static_cast<verilog::NodeEnum>(tag);
+        if (verilog::NodeEnumToString(node_enum) == name) {
+          options.subtree_tags.push_back(node_enum);
+          found = true;
+          break;
+        }
+      }
+      if (!found) {
+        return new absl::StatusOr<verilog::VerilogTreePrintOptions>(
+            absl::InvalidArgumentError(
+                absl::StrCat("--printtree_subtrees: unknown tag ", name)));
+      }
+    }
+    return new absl::StatusOr<verilog::VerilogTreePrintOptions>(
+        std::move(options));
+  }();
+  return *kOptions;
+}
+
 using nlohmann::json;
 using verible::ConcreteSyntaxTree;
 using verible::ParserVerifier;
@@ -123,7 +207,8 @@ using verilog::VerilogAnalyzer;
 static std::unique_ptr<VerilogAnalyzer> ParseWithLanguageMode(
     const std::shared_ptr<verible::MemBlock>& content,
     absl::string_view filename,
-    const verilog::VerilogPreprocess::Config& preprocess_config) {
+    const verilog::VerilogPreprocess::Config& preprocess_config,
+    std::ostream& err) {
   switch (absl::GetFlag(FLAGS_lang)) {
     case LanguageMode::kAutoDetect:
       return VerilogAnalyzer::AnalyzeAutomaticMode(content, filename,
@@ -132,7 +217,7 @@ static std::unique_ptr<VerilogAnalyzer> ParseWithLanguageMode(
       auto analyzer = std::make_unique<VerilogAnalyzer>(content, filename,
                                                         preprocess_config);
       const auto status = ABSL_DIE_IF_NULL(analyzer)->Analyze();
-      if (!status.ok()) std::cerr << status.message() << std::endl;
+      if (!status.ok()) err << status.message() << std::endl;
       return analyzer;
     }
     case LanguageMode::kVerilogLibraryMap:
@@ -143,7 +228,8 @@ static std::unique_ptr<VerilogAnalyzer> ParseWithLanguageMode(
 }
 
 // Prints all tokens in view that are not matched in root.
-static void VerifyParseTree(const TextStructureView& text_structure) {
+static void VerifyParseTree(const TextStructureView& text_structure,
+                            std::ostream& out) {
   const ConcreteSyntaxTree& root = text_structure.SyntaxTree();
   if (root == nullptr) return;
   // TODO(fangism): this seems like a good method for TextStructureView.
@@ -151,11 +237,11 @@ static void VerifyParseTree(const TextStructureView& text_structure) {
   auto unmatched = verifier.Verify();
 
   if (unmatched.empty()) {
-    std::cout << std::endl << "All tokens matched." << std::endl;
+    out << std::endl << "All tokens matched." << std::endl;
   } else {
-    std::cout << std::endl << "Unmatched Tokens:" << std::endl;
+    out << std::endl << "Unmatched Tokens:" << std::endl;
     for (const auto& token : unmatched) {
-      std::cout << token << std::endl;
+      out << token << std::endl;
     }
   }
 }
@@ -172,42 +258,230 @@ static bool ShouldIncludeTokenText(const verible::TokenInfo& token) {
   return verilog::IsIdentifierLike(tokentype) || (token.text() != type_str);
 }
 
-static int AnalyzeOneFile(
-    const std::shared_ptr<verible::MemBlock>& content,
-    absl::string_view filename,
+// Views a part of another MemBlock, and keeps that alive.
+class SubMemBlock final : public verible::MemBlock {
+ public:
+  SubMemBlock(std::shared_ptr<verible::MemBlock> block,
+              absl::string_view range)
+      : block_(std::move(block)), range_(range) {}
+
+  absl::string_view AsStringView() const final { return range_; }
+
+ private:
+  const std::shared_ptr<verible::MemBlock> block_;
+  const absl::string_view range_;
+};
+
+// Returns the length of the first chunk of 'text' that is at least
+// 'min_length' long, and that ends at the end of a line that closes a
+// top-level description (endmodule, endpackage, ...), so that the rest of
+// 'text' can be analyzed on its own.
+// Chunks don't end inside `ifdef blocks, nor after a `define or `undef,
+// whose macros would be missing from the analysis of the next chunks.
+// Returns text.size() if there is no such chunk.
+static size_t FindChunkLength(absl::string_view text, size_t min_length) {
+  verilog::VerilogLexer lexer(text);
+  int description_depth = 0;
+  int conditional_depth = 0;
+  // Set after the end of a description, until the end of its line.
+  bool after_description_end = false;
+  int previous_token_enum = verible::TK_EOF;
+  for (lexer.DoNextToken(); !lexer.GetLastToken().isEOF();
+       lexer.DoNextToken()) {
+    const verible::TokenInfo& token = lexer.GetLastToken();
+    const auto token_type = static_cast<verilog_tokentype>(token.token_enum());
+    const bool whitespace_or_comment =
+        verilog::IsWhitespace(token_type) || verilog::IsComment(token_type);
+    if (after_description_end) {
+      if (whitespace_or_comment && absl::EndsWith(token.text(), "\n")) {
+        const size_t length = token.text().end() - text.begin();
+        if (description_depth == 0 && conditional_depth == 0 &&
+            length >= min_length) {
+          return length;
+        }
+        after_description_end = false;
+        continue;
+      }
+      // Allow for an end label, e.g. "endmodule : foo".
+      if (!whitespace_or_comment && token_type != ':' &&
+          token_type != SymbolIdentifier) {
+        after_description_end = false;
+      }
+    }
+    switch (token_type) {
+      case TK_module:
+      case TK_macromodule:
+      case TK_package:
+      case TK_program:
+      case TK_primitive:
+      case TK_config:
+        ++description_depth;
+        break;
+      case TK_interface:
+        // Not in "virtual interface" declarations.
+        if (previous_token_enum != TK_virtual) ++description_depth;
+        break;
+      case TK_class:
+        // "interface class" is closed by endclass.
+        if (previous_token_enum == TK_interface) --description_depth;
+        break;
+      case TK_endmodule:
+      case TK_endpackage:
+      case TK_endprogram:
+      case TK_endprimitive:
+      case TK_endconfig:
+      case TK_endinterface:
+        description_depth = std::max(0, description_depth - 1);
+        after_description_end = true;
+        break;
+      case PP_ifdef:
+      case PP_ifndef:
+        ++conditional_depth;
+        break;
+      case PP_endif:
+        --conditional_depth;
+        break;
+      case PP_define:
+      case PP_undef:
+        return text.size();
+      default:
+        break;
+    }
+    if (!whitespace_or_comment) previous_token_enum = token_type;
+  }
+  return text.size();
+}
+
+// Writes the --export_json results of 'analyzer' as members of the current
+// object of 'json_out', in the same (sorted) order as nlohmann::json would.
+static void ExportJson(const VerilogAnalyzer& analyzer, bool has_errors,
+                       const verible::TokenInfo::Context& context,
+                       verible::JsonWriter* json_out) {
+  if (has_errors) {
+    json_out->Key("errors").Value(verilog::GetLinterTokenErrorsAsJson(
+        &analyzer, absl::GetFlag(FLAGS_error_limit)));
+  }
+
+  const auto& text_structure = analyzer.Data();
+  if (absl::GetFlag(FLAGS_printrawtokens)) {
+    json_out->Key("rawtokens").BeginArray();
+    for (const auto& t : text_structure.TokenStream()) {
+      verible::WriteJson(t, context, ShouldIncludeTokenText(t), json_out);
+    }
+    json_out->EndArray();
+  }
+
+  if (absl::GetFlag(FLAGS_print_stats)) {
+    const verilog::VerilogAnalyzerStats stats = analyzer.Stats();
+    json stats_json;
+    stats_json["input_bytes"] = stats.input_bytes;
+    const auto phase_json =
+        [](const verilog::VerilogAnalyzerStats::Phase& phase) {
+          return json{{"time_us", absl::ToInt64Microseconds(phase.time)},
+                      {"bytes", phase.bytes}};
+        };
+    stats_json["tokenize"] = phase_json(stats.tokenize);
+    stats_json["tokenize"]["tokens"] = stats.raw_tokens;
+    stats_json["filter"] = phase_json(stats.filter);
+    stats_json["filter"]["tokens"] = stats.filtered_tokens;
+    stats_json["contextualize"] = phase_json(stats.contextualize);
+    stats_json["preprocess"] = phase_json(stats.preprocess);
+    stats_json["preprocess"]["tokens"] = stats.preprocessed_tokens;
+    stats_json["parse"] = phase_json(stats.parse);
+    stats_json["parse"]["nodes"] = stats.syntax_tree_nodes;
+    stats_json["parse"]["leaves"] = stats.syntax_tree_leaves;
+    stats_json["parse"]["max_stack_size"] = stats.max_used_stack_size;
+    json_out->Key("stats").Value(stats_json);
+  }
+
+  if (absl::GetFlag(FLAGS_printtokens)) {
+    json_out->Key("tokens").BeginArray();
+    for (const auto& t : text_structure.GetTokenStreamView()) {
+      verible::WriteJson(*t, context, ShouldIncludeTokenText(*t), json_out);
+    }
+    json_out->EndArray();
+  }
+
+  const auto& syntax_tree = text_structure.SyntaxTree();
+  if (absl::GetFlag(FLAGS_printtree) && syntax_tree != nullptr) {
+    json_out->Key("tree");
+    verilog::WriteVerilogTreeAsJson(*syntax_tree, context.base, json_out);
+  }
+}
+
+// Returns the --export_binary_dir output path for 'filename'.
+static std::string BinaryExportPath(absl::string_view filename) {
+  std::string name = verible::file::IsStdin(filename) ? std::string("stdin")
+                                                    : std::string(filename);
+  std::replace_if(
+      name.begin(), name.end(),
+      [](char c) { return c == '/' || c == '\\' || c == ':'; }, '_');
+  return verible::file::JoinPath(absl::GetFlag(FLAGS_export_binary_dir),
+                                 name + ".vcst");
+}
+
+// Writes the --export_binary_dir output of 'analyzer'.
+// Returns false on failure.
+static bool ExportBinary(const VerilogAnalyzer& analyzer,
+                         absl::string_view filename, std::ostream& err) {
+  const std::string path = BinaryExportPath(filename);
+  std::ofstream stream(path, std::ios::binary);
+  verible::WriteSyntaxTreeBinary(
+      analyzer.Data(),
+      [](std::ostream& stream, int e) {
+        stream << verilog::TokenTypeToString(static_cast<verilog_tokentype>(e));
+      },
+      [](std::ostream& stream, int e) {
+        stream << verilog::NodeEnumToString(static_cast<verilog::NodeEnum>(e));
+      },
+      &stream);
+  stream.close();
+  if (!stream) {
+    err << path << ": can't write binary export." << std::endl;
+    return false;
+  }
+  return true;
+}
+
+// Analyzes 'content' as part of file 'filename' whose contents are 'base'.
+// 'content' is the whole file, or a chunk of it that starts at line
+// 'line_offset' (0-based).
+// 'error_count' counts the reported syntax errors, across chunks.
+// Output goes to 'out' and messages to 'err'.  With --export_json, results
+// are written as members of the current object of 'json_out'.
+static int AnalyzeText(
+    const std::shared_ptr<verible::MemBlock>& content, absl::string_view base,
+    int line_offset, absl::string_view filename,
     const verilog::VerilogPreprocess::Config& preprocess_config,
-    json* json_out) {
+    std::ostream& out, std::ostream& err, verible::JsonWriter* json_out,
+    int* error_count) {
   int exit_status = 0;
   const auto analyzer =
-      ParseWithLanguageMode(content, filename, preprocess_config);
+      ParseWithLanguageMode(content, filename, preprocess_config, err);
   const auto lex_status = ABSL_DIE_IF_NULL(analyzer)->LexStatus();
   const auto parse_status = analyzer->ParseStatus();
+  analyzer->SetLineOffset(line_offset);
+  const bool export_json = absl::GetFlag(FLAGS_export_json);
 
-  if (!lex_status.ok() || !parse_status.ok()) {
-    const std::vector<std::string> syntax_error_messages(
-        analyzer->LinterTokenErrorMessages(
-            absl::GetFlag(FLAGS_show_diagnostic_context)));
+  const bool has_errors = !lex_status.ok() || !parse_status.ok();
+  if (has_errors) {
     const int error_limit = absl::GetFlag(FLAGS_error_limit);
-    int error_count = 0;
-    if (!absl::GetFlag(FLAGS_export_json)) {
+    if (!export_json) {
       const std::vector<std::string> syntax_error_messages(
           analyzer->LinterTokenErrorMessages(
               absl::GetFlag(FLAGS_show_diagnostic_context)));
       for (const auto& message : syntax_error_messages) {
-        std::cout << message << std::endl;
-        ++error_count;
-        if (error_limit != 0 && error_count >= error_limit) break;
+        if (error_limit != 0 && *error_count >= error_limit) break;
+        out << message << std::endl;
+        ++*error_count;
       }
-    } else {
-      (*json_out)["errors"] =
-          verilog::GetLinterTokenErrorsAsJson(analyzer.get(), error_limit);
     }
     exit_status = 1;
   }
   const bool parse_ok = parse_status.ok();
 
   std::function<void(std::ostream&, int)> token_translator;
-  if (!absl::GetFlag(FLAGS_export_json)) {
+  if (!export_json) {
     token_translator = [](std::ostream& stream, int e) {
       stream << verilog::verilog_symbol_name(e);
     };
@@ -216,39 +490,35 @@ static int AnalyzeOneFile(
       stream << verilog::TokenTypeToString(static_cast<verilog_tokentype>(e));
     };
   }
-  const verible::TokenInfo::Context context(analyzer->Data().Contents(),
-                                            token_translator);
+  // Offsets of tokens are relative to the whole file, unless the analyzer
+  // worked on a copy of the text (e.g. for alternate parsing modes).
+  const absl::string_view contents = analyzer->Data().Contents();
+  const absl::string_view token_base =
+      contents.data() == content->AsStringView().data() ? base : contents;
+  const verible::TokenInfo::Context context(token_base, token_translator);
+
+  if (export_json) {
+    ExportJson(*analyzer, has_errors, context, json_out);
+  }
+
+  if (!absl::GetFlag(FLAGS_export_binary_dir).empty() &&
+      !ExportBinary(*analyzer, filename, err)) {
+    exit_status = 1;
+  }
+
   // Check for printtokens flag, print all filtered tokens if on.
-  if (absl::GetFlag(FLAGS_printtokens)) {
-    if (!absl::GetFlag(FLAGS_export_json)) {
-      std::cout << std::endl << "Lexed and filtered tokens:" << std::endl;
-      for (const auto& t : analyzer->Data().GetTokenStreamView()) {
-        t->ToStream(std::cout, context) << std::endl;
-      }
-    } else {
-      json& tokens = (*json_out)["tokens"] = json::array();
-      const auto& token_stream = analyzer->Data().GetTokenStreamView();
-      for (const auto& t : token_stream) {
-        tokens.push_back(
-            verible::ToJson(*t, context, ShouldIncludeTokenText(*t)));
-      }
+  if (absl::GetFlag(FLAGS_printtokens) && !export_json) {
+    out << std::endl << "Lexed and filtered tokens:" << std::endl;
+    for (const auto& t : analyzer->Data().GetTokenStreamView()) {
+      t->ToStream(out, context) << std::endl;
     }
   }
 
   // Check for printrawtokens flag, print all tokens if on.
-  if (absl::GetFlag(FLAGS_printrawtokens)) {
-    if (!absl::GetFlag(FLAGS_export_json)) {
-      std::cout << std::endl << "All lexed tokens:" << std::endl;
-      for (const auto& t : analyzer->Data().TokenStream()) {
-        t.ToStream(std::cout, context) << std::endl;
-      }
-    } else {
-      json& tokens = (*json_out)["rawtokens"] = json::array();
-      const auto& token_stream = analyzer->Data().TokenStream();
-      for (const auto& t : token_stream) {
-        tokens.push_back(
-            verible::ToJson(t, context, ShouldIncludeTokenText(t)));
-      }
+  if (absl::GetFlag(FLAGS_printrawtokens) && !export_json) {
+    out << std::endl << "All lexed tokens:" << std::endl;
+    for (const auto& t : analyzer->Data().TokenStream()) {
+      t.ToStream(out, context) << std::endl;
     }
   }
 
@@ -256,70 +526,200 @@ static int AnalyzeOneFile(
   const auto& syntax_tree = text_structure.SyntaxTree();
 
   // check for printtree flag, and print tree if on
-  if (absl::GetFlag(FLAGS_printtree) && syntax_tree != nullptr) {
-    if (!absl::GetFlag(FLAGS_export_json)) {
-      std::cout << std::endl
-                << "Parse Tree"
-                << (!parse_ok ? " (incomplete due to syntax errors):" : ":")
-                << std::endl;
-      verilog::PrettyPrintVerilogTree(*syntax_tree, analyzer->Data().Contents(),
-                                      &std::cout);
-    } else {
-      (*json_out)["tree"] = verilog::ConvertVerilogTreeToJson(
-          *syntax_tree, analyzer->Data().Contents());
-    }
+  if (absl::GetFlag(FLAGS_printtree) && syntax_tree != nullptr &&
+      !export_json) {
+    out << std::endl
+        << "Parse Tree"
+        << (!parse_ok ? " (incomplete due to syntax errors):" : ":")
+        << std::endl;
+    verilog::PrettyPrintVerilogTree(*syntax_tree, token_base, &out,
+                                    *TreePrintOptions());
   }
 
   // Check for verifytree, verify tree and print unmatched if on.
   if (absl::GetFlag(FLAGS_verifytree)) {
     if (!parse_ok) {
-      std::cout << std::endl
-                << "Note: verifytree will fail because syntax errors caused "
-                   "sections of text to be dropped during error-recovery."
-                << std::endl;
+      out << std::endl
+          << "Note: verifytree will fail because syntax errors caused "
+             "sections of text to be dropped during error-recovery."
+          << std::endl;
     }
-    VerifyParseTree(text_structure);
+    VerifyParseTree(text_structure, out);
+  }
+
+  // Check for print_stats flag, and print analyzer statistics if on.
+  if (absl::GetFlag(FLAGS_print_stats) && !export_json) {
+    out << std::endl
+        << "Analyzer statistics:" << std::endl
+        << analyzer->Stats();
   }
 
   return exit_status;
 }
 
+static int AnalyzeOneFile(
+    const std::shared_ptr<verible::MemBlock>& content,
+    absl::string_view filename,
+    const verilog::VerilogPreprocess::Config& preprocess_config,
+    std::ostream& out, std::ostream& err, verible::JsonWriter* json_out) {
+  const absl::string_view text = content->AsStringView();
+  int error_count = 0;
+  if (!absl::GetFlag(FLAGS_streaming) || absl::GetFlag(FLAGS_export_json) ||
+      absl::GetFlag(FLAGS_print_stats) ||
+      !absl::GetFlag(FLAGS_export_binary_dir).empty()) {
+    return AnalyzeText(content, text, 0, filename, preprocess_config, out, err,
+                       json_out, &error_count);
+  }
+
+  // Analyze one chunk at a time; each one is freed before the next one.
+  const size_t min_length =
+      std::max(1, absl::GetFlag(FLAGS_streaming_chunk_bytes));
+  int exit_status = 0;
+  int line_offset = 0;
+  for (absl::string_view rest = text; !rest.empty();) {
+    const absl::string_view chunk =
+        rest.substr(0, FindChunkLength(rest, min_length));
+    const int chunk_status = AnalyzeText(
+        std::make_shared<SubMemBlock>(content, chunk), text, line_offset,
+        filename, preprocess_config, out, err, json_out, &error_count);
+    exit_status = std::max(exit_status, chunk_status);
+    line_offset += std::count(chunk.begin(), chunk.end(), '\n');
+    rest.remove_prefix(chunk.size());
+  }
+  return exit_status;
+}
+
+// Analyzes the 'content' of 'filename'.  With --export_json, the results are
+// written to 'json_out' as one object, the value of the current key.
+static int AnalyzeContent(const std::shared_ptr<verible::MemBlock>& content,
+                          absl::string_view filename, std::ostream& out,
+                          std::ostream& err, verible::JsonWriter* json_out) {
+  // TODO(hzeller): is there ever a situation in which we do not want
+  // to use the preprocessor ?
+  const verilog::VerilogPreprocess::Config preprocess_config{
+      .filter_branches = true,
+  };
+  const bool export_json = absl::GetFlag(FLAGS_export_json);
+  if (export_json) json_out->BeginObject();
+  const int exit_status =
+      AnalyzeOneFile(content, filename, preprocess_config, out, err, json_out);
+  if (export_json) json_out->EndObject();
+  return exit_status;
+}
+
+// Result slot of one file analyzed in parallel, so that the results of
+// concurrently analyzed files can be emitted in input order.
+struct BufferedSyntaxResult {
+  int exit_status = 0;
+  bool has_json = false;  // false if the file could not be read
+  std::string out_text;
+  std::string err_text;
+  std::string json_text;  // --export_json object of the file
+};
+
+// Analyzes all files on a thread pool of 'jobs' threads.  Each file writes
+// into its own result slot; slots are flushed strictly in the order of
+// 'filenames', so the output is the same as that of serial operation.
+// Returns the maximum exit status of all files.
+static int AnalyzeFilesInParallel(
+    const std::vector<absl::string_view>& filenames, int jobs,
+    verible::JsonWriter* json_out) {
+  verible::ThreadPool pool(jobs);
+  int exit_status = 0;
+  pool.ParallelMapInOrder(
+      filenames.size(),
+      [&filenames](size_t i) {
+        const absl::string_view filename = filenames[i];
+        BufferedSyntaxResult result;
+        auto content_status = verible::file::GetContentAsMemBlock(filename);
+        if (!content_status.status().ok()) {
+          result.err_text =
+              absl::StrCat(content_status.status().message(), "\n");
+          result.exit_status = 1;
+          return result;
+        }
+        const std::shared_ptr<verible::MemBlock> content =
+            std::move(*content_status);
+        std::ostringstream out;
+        std::ostringstream err;
+        std::ostringstream json;
+        verible::JsonWriter json_writer(&json);
+        result.exit_status =
+            AnalyzeContent(content, filename, out, err, &json_writer);
+        result.has_json = absl::GetFlag(FLAGS_export_json);
+        result.out_text = out.str();
+        result.err_text = err.str();
+        result.json_text = json.str();
+        return result;
+      },
+      [&](size_t i, const BufferedSyntaxResult& result) {
+        std::cout << result.out_text;
+        if (result.has_json) {
+          json_out->Key(filenames[i]).RawValue(result.json_text);
+        }
+        std::cout << std::flush;
+        std::cerr << result.err_text << std::flush;
+        exit_status = std::max(exit_status, result.exit_status);
+      });
+  return exit_status;
+}
+
 int main(int argc, char** argv) {
   const auto usage =
       absl::StrCat("usage: ", argv[0], " [options] <file> [<file>...]");
   const auto args = verible::InitCommandLine(usage, &argc, &argv);
 
-  json json_out;
+  if (!TreePrintOptions().ok()) {
+    std::cerr << TreePrintOptions().status().message() << std::endl;
+    return 1;
+  }
+  if (absl::GetFlag(FLAGS_print_memory_stats)) {
+    verible::EnableSubsystemMemoryStats();
+  }
+  if (const std::string trace_output = absl::GetFlag(FLAGS_trace_output);
+      !trace_output.empty()) {
+    verible::EnableTraceOutput(trace_output);
+  }
 
-  int exit_status = 0;
-  // All positional arguments are file names.  Exclude program name.
-  for (absl::string_view filename :
-       verible::make_range(args.begin() + 1, args.end())) {
-    auto content_status = verible::file::GetContentAsMemBlock(filename);
-    if (!content_status.status().ok()) {
-      std::cerr << content_status.status().message() << std::endl;
-      exit_status = 1;
-      continue;
-    }
-    std::shared_ptr<verible::MemBlock> content = std::move(*content_status);
+  // With --export_json, the output is written while files are being
+  // analyzed, one object member per file.  Files are in the sorted order
+  // that nlohmann::json had used for this object.
+  const bool export_json = absl::GetFlag(FLAGS_export_json);
+  std::vector<absl::string_view> filenames(args.begin() + 1, args.end());
+  if (export_json) {
+    std::sort(filenames.begin(), filenames.end());
+    filenames.erase(std::unique(filenames.begin(), filenames.end()),
+                    filenames.end());
+  }
+  verible::JsonWriter json_out(&std::cout);
+  if (export_json) json_out.BeginObject();
 
-    // TODO(hzeller): is there ever a situation in which we do not want
-    // to use the preprocessor ?
-    const verilog::VerilogPreprocess::Config preprocess_config{
-        .filter_branches = true,
-    };
-    json file_json;
-    int file_status =
-        AnalyzeOneFile(content, filename, preprocess_config, &file_json);
-    exit_status = std::max(exit_status, file_status);
-    if (absl::GetFlag(FLAGS_export_json)) {
-      json_out[std::string{filename.begin(), filename.end()}] =
-          std::move(file_json);
+  const int jobs = std::min<int>(
+      verible::JobsOrAllCores(absl::GetFlag(FLAGS_jobs)), filenames.size());
+
+  int exit_status = 0;
+  if (jobs > 1) {
+    exit_status = AnalyzeFilesInParallel(filenames, jobs, &json_out);
+  } else {
+    // All positional arguments are file names.  Exclude program name.
+    for (absl::string_view filename : filenames) {
+      auto content_status = verible::file::GetContentAsMemBlock(filename);
+      if (!content_status.status().ok()) {
+        std::cerr << content_status.status().message() << std::endl;
+        exit_status = 1;
+        continue;
+      }
+      std::shared_ptr<verible::MemBlock> content = std::move(*content_status);
+      if (export_json) json_out.Key(filename);
+      const int file_status =
+          AnalyzeContent(content, filename, std::cout, std::cerr, &json_out);
+      exit_status = std::max(exit_status, file_status);
     }
   }
 
-  if (absl::GetFlag(FLAGS_export_json)) {
-    std::cout << std::setw(2) << json_out << std::endl;
+  if (export_json) {
+    json_out.EndObject();
+    std::cout << std::endl;
   }
 
   return exit_status;
@@ -232,6 +232,35 @@ tr '\r\n' '\n' < $MY_OUTPUT_FILE | json_canonicalize > "${MY_OUTPUT_FILE}.1"
 diff --strip-trailing-cr -u "$MY_EXPECT_FILE" "${MY_OUTPUT_FILE}.1" || \
   { echo "stderr differs." ; exit 1 ;}
 
+################################################################################
+echo "=== Test reading stdin, with --streaming"
+
+"$syntax_checker" --streaming --streaming_chunk_bytes=1 - > "$MY_OUTPUT_FILE" 2>&1 <<EOF
+module 1;
+endmodule
+module 2;
+endmodule
+EOF
+
+status="$?"
+[[ $status == 1 ]] || {
+  "Expected exit code 1, but got $status"
+  exit 1
+}
+
+strip_error < "$MY_OUTPUT_FILE" > "$MY_OUTPUT_FILE".filtered
+
+# Each module is analyzed on its own, errors are at lines of the whole file.
+cat > "$MY_EXPECT_FILE" <<EOF
+-:1:8: syntax error at token "1"
+-:2:1-9: syntax error at token "endmodule"
+-:3:8: syntax error at token "2"
+-:4:1-9: syntax error at token "endmodule"
+EOF
+
+diff --strip-trailing-cr -u "$MY_EXPECT_FILE" "$MY_OUTPUT_FILE".filtered || \
+  { echo "stderr differs." ; exit 1 ;}
+
 ################################################################################
 echo "=== Test --printtokens"
 
@@ -381,6 +410,42 @@ EOF
 
 diff --strip-trailing-cr -u "$MY_EXPECT_FILE" "$MY_OUTPUT_FILE" || { echo "stdout differs." ; exit 1 ;}
 
+################################################################################
+echo "=== Test --printtree_subtrees --printtree_max_depth"
+
+"$syntax_checker" --printtree --printtree_subtrees=kModuleHeader,kModuleItemList \
+  --printtree_max_depth=0 - > "$MY_OUTPUT_FILE" <<EOF
+module mm;
+endmodule
+EOF
+
+status="$?"
+[[ $status == 0 ]] || {
+  "Expected exit code 0, but got $status"
+  exit 1
+}
+
+cat > "$MY_EXPECT_FILE" <<EOF
+
+Parse Tree:
+Node @0 (tag: kModuleHeader) { ... }
+Node @1 (tag: kModuleItemList) {
+}
+EOF
+
+diff --strip-trailing-cr -u "$MY_EXPECT_FILE" "$MY_OUTPUT_FILE" || { echo "stdout differs." ; exit 1 ;}
+
+"$syntax_checker" --printtree --printtree_subtrees=kNoSuchTag - > /dev/null 2>&1 <<EOF
+module mm;
+endmodule
+EOF
+
+status="$?"
+[[ $status == 1 ]] || {
+  "Expected exit code 1, but got $status"
+  exit 1
+}
+
 ################################################################################
 echo "=== Test --printtree --export_json"
 
@@ -519,5 +584,54 @@ status="$?"
   "Expected exit code 0, but got $status"
   exit 1
 }
+
+# analyzer statistics
+"$syntax_checker" --print_stats - > "$MY_OUTPUT_FILE" <<EOF
+module m; endmodule
+EOF
+
+status="$?"
+[[ $status == 0 ]] || {
+  echo "Expected exit code 0, but got $status"
+  exit 1
+}
+
+grep -q "^Analyzer statistics:" "$MY_OUTPUT_FILE" || {
+  echo "Expected analyzer statistics in output."
+  exit 1
+}
+
+# --jobs produces the same output as serial operation
+JOBS_GOOD_FILE="${TEST_TMPDIR}/jobs-good.sv"
+cat > "$JOBS_GOOD_FILE" <<EOF
+module m; wire w; endmodule
+EOF
+JOBS_BAD_FILE="${TEST_TMPDIR}/jobs-bad.sv"
+cat > "$JOBS_BAD_FILE" <<EOF
+module m; wire w endmodule
+EOF
+
+for flags in "--printtree --printtokens" "--export_json --printtree"; do
+  "$syntax_checker" $flags "$JOBS_BAD_FILE" "$JOBS_GOOD_FILE" \
+      "${TEST_TMPDIR}/jobs-missing.sv" "$JOBS_GOOD_FILE" \
+      > "${MY_OUTPUT_FILE}.serial.out" 2> "${MY_OUTPUT_FILE}.serial.err"
+  serial_status="$?"
+  "$syntax_checker" $flags --jobs=3 "$JOBS_BAD_FILE" "$JOBS_GOOD_FILE" \
+      "${TEST_TMPDIR}/jobs-missing.sv" "$JOBS_GOOD_FILE" \
+      > "${MY_OUTPUT_FILE}.jobs.out" 2> "${MY_OUTPUT_FILE}.jobs.err"
+  status="$?"
+  [[ $status == $serial_status ]] || {
+    echo "Expected exit code $serial_status with --jobs ($flags), got $status"
+    exit 1
+  }
+  diff "${MY_OUTPUT_FILE}.serial.out" "${MY_OUTPUT_FILE}.jobs.out" || {
+    echo "Expected same stdout with --jobs as serially ($flags)."
+    exit 1
+  }
+  diff "${MY_OUTPUT_FILE}.serial.err" "${MY_OUTPUT_FILE}.jobs.err" || {
+    echo "Expected same stderr with --jobs as serially ($flags)."
+    exit 1
+  }
+done
 ################################################################################
 echo "PASS"
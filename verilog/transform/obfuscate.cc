@@ -16,6 +16,7 @@
 
 #include <iostream>
 #include <sstream>
+#include <string>
 
 #include "absl/status/status.h"
 #include "absl/strings/str_cat.h"
@@ -160,13 +161,27 @@ absl::Status ObfuscateVerilogCode(absl::string_view content,
                                   IdentifierObfuscator* subst) {
   VLOG(1) << __FUNCTION__;
   std::ostringstream buffer;
-  ObfuscateVerilogCodeInternal(content, &buffer, subst);
+  if (subst->is_decoding()) {
+    ObfuscateVerilogCodeInternal(content, &buffer, subst);
+    RETURN_IF_ERROR(VerifyEquivalence(content, buffer.str()));
+    *output << buffer.str();
+    return absl::OkStatus();
+  }
+
+  // Translations of this file only, taken from the shared "subst" the first
+  // time each identifier is seen: the shared map is locked once per distinct
+  // identifier rather than once per token, and decoding is verified against
+  // this file's identifiers rather than all of those seen so far.
+  IdentifierObfuscator file_subst([subst](absl::string_view input) {
+    return std::string((*subst)(input));
+  });
+  ObfuscateVerilogCodeInternal(content, &buffer, &file_subst);
 
   // Always verify equivalence.
   RETURN_IF_ERROR(VerifyEquivalence(content, buffer.str()));
 
   // Always verify decoding.
-  RETURN_IF_ERROR(VerifyDecoding(content, buffer.str(), *subst));
+  RETURN_IF_ERROR(VerifyDecoding(content, buffer.str(), file_subst));
 
   *output << buffer.str();
   return absl::OkStatus();
@@ -33,6 +33,8 @@ std::string RandomEqualLengthSymbolIdentifier(absl::string_view in);
 // not necessary syntactically valid.  Transformations apply to macro
 // arguments and macro definition bodies.
 // Returned status signals success or possible an internal error.
+// Different files may be obfuscated concurrently with the same "subst", which
+// then keeps their translations consistent.
 absl::Status ObfuscateVerilogCode(absl::string_view content,
                                   std::ostream* output,
                                   verible::IdentifierObfuscator* subst);